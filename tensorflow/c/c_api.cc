@@ -2309,6 +2309,55 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
                 status);
 }
 
+void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor* const* output_buffers, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_buffers[i]->dtype == TF_STRING) {
+      // The encoded size of string outputs is not known before the run.
+      status->status = InvalidArgument(
+          "Output buffer ", i, " is a TF_STRING tensor, which cannot be ",
+          "written in place.");
+      return;
+    }
+  }
+  std::vector<TF_Tensor*> output_values(noutputs, nullptr);
+  TF_SessionRun(session, run_options, inputs, input_values, ninputs, outputs,
+                output_values.data(), noutputs, target_opers, ntargets,
+                run_metadata, status);
+  if (!status->status.ok()) return;
+
+  for (int i = 0; i < noutputs; ++i) {
+    TF_Tensor* src = output_values[i];
+    TF_Tensor* dst = output_buffers[i];
+    if (!status->status.ok()) {
+      // Keeps going to release the remaining outputs.
+    } else if (src->dtype != dst->dtype) {
+      status->status = InvalidArgument(
+          "Output ", i, " has dtype ",
+          tensorflow::DataTypeString(static_cast<DataType>(src->dtype)),
+          " but its buffer has dtype ",
+          tensorflow::DataTypeString(static_cast<DataType>(dst->dtype)));
+    } else if (TF_TensorByteSize(src) != TF_TensorByteSize(dst)) {
+      status->status = InvalidArgument(
+          "Output ", i, " of shape ", src->shape.DebugString(), " has ",
+          TF_TensorByteSize(src), " bytes but its buffer has ",
+          TF_TensorByteSize(dst), " bytes");
+    } else {
+      // The fetch of a fed buffer may already share it.
+      if (TF_TensorData(src) != TF_TensorData(dst)) {
+        std::memcpy(TF_TensorData(dst), TF_TensorData(src),
+                    TF_TensorByteSize(src));
+      }
+      dst->shape = src->shape;
+    }
+    TF_DeleteTensor(src);
+  }
+}
+
 void TF_SessionPRunSetup(TF_Session* session, const TF_Output* inputs,
                          int ninputs, const TF_Output* outputs, int noutputs,
                          const TF_Operation* const* target_opers, int ntargets,
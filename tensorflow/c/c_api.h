@@ -223,6 +223,23 @@ typedef struct TF_Tensor TF_Tensor;
 //      (*deallocator)(data, len, deallocator_arg)
 // Clients must provide a custom deallocator function so they can pass in
 // memory managed by something like numpy.
+//
+// Tensors are dense and row-major; strided data must be packed by the caller.
+// The copies made when tensors cross the C API are:
+//
+//   Tensor                                          Copies of its contents
+//   ----------------------------------------------  -------------------------
+//   TF_NewTensor() over data aligned to             none: TensorFlow reads
+//     EIGEN_MAX_ALIGN_BYTES (as TF_AllocateTensor()   the buffer in place and
+//     returns)                                        never writes into it
+//   TF_NewTensor() over unaligned data              one, into an aligned
+//                                                     buffer, by TF_NewTensor()
+//   TF_STRING inputs                                one per run, to decode
+//   Outputs of TF_SessionRun()                      none: they share the
+//                                                     buffer the kernel wrote
+//   TF_STRING outputs of TF_SessionRun()            one, to encode
+//   Outputs of TF_SessionRunWithOutputBuffers()     one, into the caller's
+//                                                     buffer
 TF_CAPI_EXPORT extern TF_Tensor* TF_NewTensor(
     TF_DataType, const int64_t* dims, int num_dims, void* data, size_t len,
     void (*deallocator)(void* data, size_t len, void* arg),
@@ -1093,6 +1110,31 @@ TF_CAPI_EXPORT extern void TF_SessionRun(
     // Output status
     TF_Status*);
 
+// Like TF_SessionRun(), but writes the outputs into tensors that the caller
+// created beforehand, e.g. with TF_NewTensor() over buffers of a response
+// the caller is about to send, instead of returning new tensors.
+//
+// `output_buffers[i]` must have the dtype and the byte size of output `i`,
+// and must not be a TF_STRING tensor. On success its contents are replaced
+// by output `i` and its shape is set to the shape of output `i`. The caller
+// keeps ownership of `output_buffers`.
+//
+// On failure, the contents of `output_buffers[]` are undefined.
+TF_CAPI_EXPORT extern void TF_SessionRunWithOutputBuffers(
+    TF_Session* session,
+    // RunOptions
+    const TF_Buffer* run_options,
+    // Input tensors
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    const TF_Output* outputs, TF_Tensor* const* output_buffers, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status*);
+
 // Set up the graph with the intended feeds (inputs) and fetches (outputs) for a
 // sequence of partial run calls.
 //
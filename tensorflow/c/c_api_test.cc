@@ -1044,6 +1044,53 @@ TEST(CAPI, Session) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI, SessionRunWithOutputBuffers) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  // The output is written into the caller's tensor.
+  TF_Output input = {feed, 0};
+  TF_Output output = {add, 0};
+  TF_Tensor* input_value = Int32Tensor(3);
+  TF_Tensor* output_buffer =
+      TF_AllocateTensor(TF_INT32, nullptr, 0, sizeof(int32));
+  void* output_data = TF_TensorData(output_buffer);
+  TF_SessionRunWithOutputBuffers(session, nullptr, &input, &input_value, 1,
+                                 &output, &output_buffer, 1, nullptr, 0,
+                                 nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  EXPECT_EQ(output_data, TF_TensorData(output_buffer));
+  EXPECT_EQ(3 + 2, *static_cast<int32*>(output_data));
+
+  // Buffers of the wrong dtype are rejected.
+  TF_Tensor* float_buffer =
+      TF_AllocateTensor(TF_FLOAT, nullptr, 0, sizeof(float));
+  TF_SessionRunWithOutputBuffers(session, nullptr, &input, &input_value, 1,
+                                 &output, &float_buffer, 1, nullptr, 0,
+                                 nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+
+  TF_DeleteTensor(float_buffer);
+  TF_DeleteTensor(output_buffer);
+  TF_DeleteTensor(input_value);
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 TEST(CAPI, SessionPRun) {
   TF_Status* s = TF_NewStatus();
   TF_Graph* graph = TF_NewGraph();
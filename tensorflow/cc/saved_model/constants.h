@@ -45,6 +45,9 @@ constexpr char kSavedModelVariablesDirectory[] = "variables";
 /// SavedModel variables filename.
 constexpr char kSavedModelVariablesFilename[] = "variables";
 
+/// Filename of the warmup requests in the SavedModel assets.extra directory.
+constexpr char kSavedModelWarmupFilename[] = "saved_model_warmup";
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CC_SAVED_MODEL_CONSTANTS_H_
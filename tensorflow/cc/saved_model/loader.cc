@@ -15,19 +15,28 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -40,9 +49,35 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were successfully loaded.",
     "model_path");
+auto* load_latency_by_stage = monitoring::Counter<2>::New(
+    "/tensorflow/cc/saved_model/load_latency_by_stage",
+    "Latency in microseconds of each stage of loading SavedModels, such as "
+    "restoring the variables.",
+    "model_path", "stage");
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
 
+uint64 GetLatencyMicroseconds(const uint64 start_microseconds) {
+  const uint64 end_microseconds = Env::Default()->NowMicros();
+  // Avoid clock skew.
+  if (end_microseconds < start_microseconds) return 0;
+  return end_microseconds - start_microseconds;
+}
+
+// Records the latency of the "stage" of loading the SavedModel at
+// "export_dir" that started at "start_microseconds", and returns the end
+// time of the stage.
+uint64 RecordStageLatency(const string& export_dir, const string& stage,
+                          const uint64 start_microseconds) {
+  const uint64 latency_microseconds =
+      GetLatencyMicroseconds(start_microseconds);
+  LOG(INFO) << "SavedModel load stage " << stage << " took "
+            << latency_microseconds << " microseconds.";
+  load_latency_by_stage->GetCell(export_dir, stage)
+      ->IncrementBy(latency_microseconds);
+  return start_microseconds + latency_microseconds;
+}
+
 Status ReadSavedModel(const string& export_dir, SavedModel* saved_model_proto) {
   const string saved_model_pb_path =
       io::JoinPath(export_dir, kSavedModelFilenamePb);
@@ -183,6 +218,224 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                       nullptr /* outputs */, &run_metadata);
 }
 
+// An output of a RestoreV2 op, which restores the checkpoint entry "key".
+struct RestoreOutput {
+  string key;
+  string tensor_name;
+  DataType dtype;
+  // The ref variable that the output is assigned to, if any.
+  string ref_variable;
+};
+
+// Finds the outputs of the RestoreV2 ops of "graph_def". Returns false if the
+// graph restores its variables in any other way, e.g. from slices of
+// partitioned variables or with the V1 Restore ops.
+bool FindRestoreOutputs(const GraphDef& graph_def,
+                        std::vector<RestoreOutput>* outputs) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  auto get_const_strings = [&nodes](const string& input,
+                                    std::vector<string>* values) {
+    const auto it = nodes.find(ParseTensorName(input).first.ToString());
+    if (it == nodes.end() || it->second->op() != "Const") return false;
+    const auto value_it = it->second->attr().find("value");
+    Tensor tensor;
+    if (value_it == it->second->attr().end() ||
+        !tensor.FromProto(value_it->second.tensor()) ||
+        tensor.dtype() != DT_STRING) {
+      return false;
+    }
+    const auto flat = tensor.flat<string>();
+    values->assign(flat.data(), flat.data() + flat.size());
+    return true;
+  };
+
+  std::unordered_map<string, size_t> outputs_by_tensor_name;
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() == "Restore" || node.op() == "RestoreSlice") return false;
+    if (node.op() != "RestoreV2") continue;
+    std::vector<string> tensor_names;
+    std::vector<string> shape_and_slices;
+    std::vector<DataType> dtypes;
+    if (node.input_size() != 3 ||
+        !get_const_strings(node.input(1), &tensor_names) ||
+        !get_const_strings(node.input(2), &shape_and_slices) ||
+        !GetNodeAttr(node, "dtypes", &dtypes).ok() ||
+        tensor_names.size() != dtypes.size() ||
+        shape_and_slices.size() != dtypes.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < dtypes.size(); ++i) {
+      if (!shape_and_slices[i].empty()) return false;
+      const string tensor_name = strings::StrCat(node.name(), ":", i);
+      outputs_by_tensor_name[tensor_name] = outputs->size();
+      outputs->push_back({tensor_names[i], tensor_name, dtypes[i], ""});
+    }
+  }
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() != "Assign" || node.input_size() < 2) continue;
+    const auto it =
+        outputs_by_tensor_name.find(ParseTensorName(node.input(1)).ToString());
+    if (it == outputs_by_tensor_name.end()) continue;
+    (*outputs)[it->second].ref_variable =
+        ParseTensorName(node.input(0)).first.ToString();
+  }
+  return !outputs->empty();
+}
+
+// Reads the index entries of the checkpoint with prefix "variables_path".
+Status ReadBundleEntries(
+    const string& variables_path,
+    std::unordered_map<string, BundleEntryProto>* entries) {
+  BundleReader reader(Env::Default(), variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+  for (reader.Seek(kHeaderEntryKey), reader.Next(); reader.Valid();
+       reader.Next()) {
+    BundleEntryProto entry;
+    if (!entry.ParseFromArray(reader.value().data(), reader.value().size())) {
+      return errors::DataLoss("Could not parse the checkpoint entry of ",
+                              reader.key(), " in ", variables_path);
+    }
+    (*entries)[reader.key().ToString()] = entry;
+  }
+  return Status::OK();
+}
+
+bool SameBundleEntry(const BundleEntryProto& a, const BundleEntryProto& b) {
+  return a.slices_size() == 0 && b.slices_size() == 0 &&
+         a.dtype() == b.dtype() && a.size() == b.size() &&
+         a.crc32c() == b.crc32c() &&
+         TensorShape(a.shape()).IsSameSize(TensorShape(b.shape()));
+}
+
+// Restores the variables of "session" like RunRestore(), but copies the
+// variables whose checkpoint entries are the same as in the SavedModel at
+// "previous_export_dir" from "previous_session", and reads only the others
+// from disk. All the outputs of the RestoreV2 ops are fed, so the ops
+// themselves are pruned from the restore step.
+Status RunIncrementalRestore(const RunOptions& run_options,
+                             const string& export_dir,
+                             const MetaGraphDef& meta_graph_def,
+                             const std::vector<AssetFileDef>& asset_file_defs,
+                             const string& previous_export_dir,
+                             const MetaGraphDef& previous_meta_graph_def,
+                             Session* previous_session, Session* session,
+                             SavedModelReloadStats* stats) {
+  const string variables_path = io::JoinPath(
+      export_dir, kSavedModelVariablesDirectory, kSavedModelVariablesFilename);
+  const string previous_variables_path =
+      io::JoinPath(previous_export_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename);
+  const string& restore_op_name = meta_graph_def.saver_def().restore_op_name();
+  const string& filename_tensor_name =
+      meta_graph_def.saver_def().filename_tensor_name();
+  std::vector<RestoreOutput> outputs;
+  std::vector<RestoreOutput> previous_outputs;
+  if (!Env::Default()->FileExists(MetaFilename(variables_path)).ok() ||
+      !Env::Default()->FileExists(MetaFilename(previous_variables_path)).ok() ||
+      !FindRestoreOutputs(meta_graph_def.graph_def(), &outputs) ||
+      !FindRestoreOutputs(previous_meta_graph_def.graph_def(),
+                          &previous_outputs)) {
+    LOG(INFO) << "Cannot match up the variables of the SavedModel with the "
+                 "previous one; restoring all of them.";
+    return RunRestore(run_options, export_dir, restore_op_name,
+                      filename_tensor_name, asset_file_defs, session);
+  }
+  LOG(INFO) << "Restoring SavedModel bundle incrementally from "
+            << previous_export_dir;
+
+  std::unordered_map<string, BundleEntryProto> entries;
+  TF_RETURN_IF_ERROR(ReadBundleEntries(variables_path, &entries));
+  std::unordered_map<string, BundleEntryProto> previous_entries;
+  TF_RETURN_IF_ERROR(
+      ReadBundleEntries(previous_variables_path, &previous_entries));
+  std::unordered_map<string, string> previous_variables;
+  for (const RestoreOutput& output : previous_outputs) {
+    if (!output.ref_variable.empty()) {
+      previous_variables[output.key] = output.ref_variable;
+    }
+  }
+
+  // Splits the outputs into the ones to copy and the ones to read.
+  std::vector<const RestoreOutput*> reused_outputs;
+  std::vector<string> previous_tensor_names;
+  std::vector<const RestoreOutput*> restored_outputs;
+  for (const RestoreOutput& output : outputs) {
+    const auto entry_it = entries.find(output.key);
+    if (entry_it == entries.end()) {
+      return errors::NotFound("Key ", output.key, " not found in checkpoint ",
+                              variables_path);
+    }
+    const auto previous_entry_it = previous_entries.find(output.key);
+    const auto previous_variable_it = previous_variables.find(output.key);
+    if (previous_entry_it != previous_entries.end() &&
+        previous_variable_it != previous_variables.end() &&
+        SameBundleEntry(entry_it->second, previous_entry_it->second)) {
+      reused_outputs.push_back(&output);
+      previous_tensor_names.push_back(
+          strings::StrCat(previous_variable_it->second, ":0"));
+    } else {
+      restored_outputs.push_back(&output);
+    }
+  }
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  if (!reused_outputs.empty()) {
+    std::vector<Tensor> previous_tensors;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(previous_session->Run(run_options, {},
+                                             previous_tensor_names, {},
+                                             &previous_tensors, &run_metadata));
+    for (size_t i = 0; i < reused_outputs.size(); ++i) {
+      if (previous_tensors[i].dtype() != reused_outputs[i]->dtype) {
+        return errors::InvalidArgument(
+            "Variable ", previous_tensor_names[i],
+            " of the previous bundle has type ",
+            DataTypeString(previous_tensors[i].dtype()), " but ",
+            reused_outputs[i]->key, " is restored as ",
+            DataTypeString(reused_outputs[i]->dtype));
+      }
+      inputs.push_back({reused_outputs[i]->tensor_name, previous_tensors[i]});
+    }
+  }
+  if (!restored_outputs.empty()) {
+    BundleReader reader(Env::Default(), variables_path);
+    TF_RETURN_IF_ERROR(reader.status());
+    for (const RestoreOutput* output : restored_outputs) {
+      DataType dtype;
+      TensorShape shape;
+      TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(output->key, &dtype,
+                                                    &shape));
+      if (dtype != output->dtype) {
+        return errors::InvalidArgument(
+            "Checkpoint entry ", output->key, " has type ",
+            DataTypeString(dtype), " but is restored as ",
+            DataTypeString(output->dtype));
+      }
+      Tensor tensor(dtype, shape);
+      TF_RETURN_IF_ERROR(reader.Lookup(output->key, &tensor));
+      inputs.push_back({output->tensor_name, tensor});
+    }
+  }
+  LOG(INFO) << "Reused " << reused_outputs.size() << " and read "
+            << restored_outputs.size() << " variables.";
+  if (stats != nullptr) {
+    stats->num_reused_variables = reused_outputs.size();
+    stats->num_restored_variables = restored_outputs.size();
+  }
+
+  Tensor variables_path_tensor(DT_STRING, TensorShape({}));
+  variables_path_tensor.scalar<string>()() = variables_path;
+  inputs.push_back({filename_tensor_name, variables_path_tensor});
+  AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
+
+  RunMetadata run_metadata;
+  return session->Run(run_options, inputs, {}, {restore_op_name},
+                      nullptr /* outputs */, &run_metadata);
+}
+
 Status RunLegacyInitOp(const RunOptions& run_options, const string& export_dir,
                        const MetaGraphDef& meta_graph_def,
                        const std::vector<AssetFileDef>& asset_file_defs,
@@ -207,6 +460,86 @@ Status RunLegacyInitOp(const RunOptions& run_options, const string& export_dir,
   return Status::OK();
 }
 
+Status RunWarmupRequest(const RunOptions& run_options,
+                        const MetaGraphDef& meta_graph_def,
+                        const SavedModelWarmupRequest& request,
+                        Session* session) {
+  const auto& signature_def_map = meta_graph_def.signature_def();
+  const auto signature_it = signature_def_map.find(request.signature_key());
+  if (signature_it == signature_def_map.end()) {
+    return errors::InvalidArgument("Warmup request for unknown signature: ",
+                                   request.signature_key());
+  }
+  const SignatureDef& signature_def = signature_it->second;
+  std::vector<std::pair<string, Tensor>> inputs;
+  for (const NamedTensorProto& named_tensor : request.inputs()) {
+    const auto input_it = signature_def.inputs().find(named_tensor.name());
+    if (input_it == signature_def.inputs().end()) {
+      return errors::InvalidArgument("Warmup request for signature ",
+                                     request.signature_key(),
+                                     " has an unknown input: ",
+                                     named_tensor.name());
+    }
+    Tensor tensor;
+    if (!tensor.FromProto(named_tensor.tensor())) {
+      return errors::InvalidArgument("Warmup request for signature ",
+                                     request.signature_key(),
+                                     " has an invalid tensor for input ",
+                                     named_tensor.name());
+    }
+    inputs.push_back({input_it->second.name(), tensor});
+  }
+  std::vector<string> output_names;
+  for (const auto& output : signature_def.outputs()) {
+    output_names.push_back(output.second.name());
+  }
+
+  const int num_runs = std::max(request.num_runs(), 1);
+  for (int i = 0; i < num_runs; ++i) {
+    const uint64 start_microseconds = Env::Default()->NowMicros();
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(session->Run(run_options, inputs, output_names, {},
+                                    &outputs, &run_metadata));
+    LOG(INFO) << "Warmup run " << i << " of signature "
+              << request.signature_key() << " took "
+              << GetLatencyMicroseconds(start_microseconds)
+              << " microseconds.";
+  }
+  return Status::OK();
+}
+
+// Replays the warmup requests recorded in the assets.extra directory, if any.
+Status RunWarmup(const RunOptions& run_options, const string& export_dir,
+                 const MetaGraphDef& meta_graph_def, Session* session) {
+  const string warmup_path = io::JoinPath(
+      export_dir, kSavedModelAssetsExtraDirectory, kSavedModelWarmupFilename);
+  if (!Env::Default()->FileExists(warmup_path).ok()) {
+    return Status::OK();
+  }
+  LOG(INFO) << "Running warmup requests on SavedModel bundle.";
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(warmup_path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  for (int num_requests = 0;; ++num_requests) {
+    Status status = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(status)) {
+      LOG(INFO) << "Ran " << num_requests << " warmup requests.";
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(status);
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Could not parse warmup request ", num_requests,
+                              " in ", warmup_path);
+    }
+    TF_RETURN_IF_ERROR(
+        RunWarmupRequest(run_options, meta_graph_def, request, session));
+  }
+}
+
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs) {
   const auto& collection_def_map = meta_graph_def.collection_def();
@@ -224,34 +557,54 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return Status::OK();
 }
 
+// Loads the SavedModel at "export_dir" into "bundle". If "previous_bundle" is
+// not null, reuses its variables as described for ReloadSavedModel().
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
-                              SavedModelBundle* const bundle) {
+                              const string& previous_export_dir,
+                              const SavedModelBundle* previous_bundle,
+                              SavedModelBundle* const bundle,
+                              SavedModelReloadStats* stats) {
   if (!MaybeSavedModelDirectory(export_dir)) {
     return Status(error::Code::NOT_FOUND,
                   "SavedModel not found in export directory: " + export_dir);
   }
   LOG(INFO) << "Loading SavedModel from: " << export_dir;
+  uint64 stage_start_microseconds = Env::Default()->NowMicros();
 
   SavedModel saved_model_proto;
   TF_RETURN_IF_ERROR(ReadSavedModel(export_dir, &saved_model_proto));
 
   TF_RETURN_IF_ERROR(
       FindMetaGraphDefToLoad(saved_model_proto, tags, &bundle->meta_graph_def));
+  stage_start_microseconds = RecordStageLatency(export_dir, "read_meta_graph",
+                                                stage_start_microseconds);
 
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
+  stage_start_microseconds = RecordStageLatency(export_dir, "create_session",
+                                                stage_start_microseconds);
 
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
-  TF_RETURN_IF_ERROR(
-      RunRestore(run_options, export_dir,
-                 bundle->meta_graph_def.saver_def().restore_op_name(),
-                 bundle->meta_graph_def.saver_def().filename_tensor_name(),
-                 asset_file_defs, bundle->session.get()));
+  if (previous_bundle != nullptr) {
+    TF_RETURN_IF_ERROR(RunIncrementalRestore(
+        run_options, export_dir, bundle->meta_graph_def, asset_file_defs,
+        previous_export_dir, previous_bundle->meta_graph_def,
+        previous_bundle->session.get(), bundle->session.get(), stats));
+  } else {
+    TF_RETURN_IF_ERROR(
+        RunRestore(run_options, export_dir,
+                   bundle->meta_graph_def.saver_def().restore_op_name(),
+                   bundle->meta_graph_def.saver_def().filename_tensor_name(),
+                   asset_file_defs, bundle->session.get()));
+  }
+  stage_start_microseconds =
+      RecordStageLatency(export_dir, "restore", stage_start_microseconds);
+
   if (HasMainOp(bundle->meta_graph_def)) {
     TF_RETURN_IF_ERROR(RunMainOp(run_options, export_dir,
                                  bundle->meta_graph_def, asset_file_defs,
@@ -261,25 +614,22 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                        bundle->meta_graph_def, asset_file_defs,
                                        bundle->session.get()));
   }
+  stage_start_microseconds =
+      RecordStageLatency(export_dir, "init", stage_start_microseconds);
+
+  TF_RETURN_IF_ERROR(RunWarmup(run_options, export_dir, bundle->meta_graph_def,
+                               bundle->session.get()));
+  RecordStageLatency(export_dir, "warmup", stage_start_microseconds);
   return Status::OK();
 }
 
-}  // namespace
-
-Status LoadSavedModel(const SessionOptions& session_options,
-                      const RunOptions& run_options, const string& export_dir,
-                      const std::unordered_set<string>& tags,
-                      SavedModelBundle* const bundle) {
-  // TODO(robson): Add tests for the counters.
-  const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
-  const uint64 load_latency_microsecs = [&]() -> uint64 {
-    const uint64 end_microseconds = Env::Default()->NowMicros();
-    // Avoid clock skew.
-    if (end_microseconds < start_microseconds) return 0;
-    return end_microseconds - start_microseconds;
-  }();
+// Counts the attempt to load the SavedModel at "export_dir", which started at
+// "start_microseconds" and finished with "status", and returns "status".
+Status RecordLoadAttempt(const string& export_dir,
+                         const uint64 start_microseconds,
+                         const Status& status) {
+  const uint64 load_latency_microsecs =
+      GetLatencyMicroseconds(start_microseconds);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "Loading SavedModel: " << status_str << ". Took "
               << load_latency_microsecs << " microseconds.";
@@ -294,6 +644,40 @@ Status LoadSavedModel(const SessionOptions& session_options,
   return status;
 }
 
+}  // namespace
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle) {
+  // TODO(robson): Add tests for the counters.
+  const uint64 start_microseconds = Env::Default()->NowMicros();
+  return RecordLoadAttempt(
+      export_dir, start_microseconds,
+      LoadSavedModelInternal(session_options, run_options, export_dir, tags,
+                             "", nullptr, bundle, nullptr));
+}
+
+Status ReloadSavedModel(const SessionOptions& session_options,
+                        const RunOptions& run_options,
+                        const string& export_dir,
+                        const std::unordered_set<string>& tags,
+                        const string& previous_export_dir,
+                        const SavedModelBundle& previous_bundle,
+                        SavedModelBundle* const bundle,
+                        SavedModelReloadStats* stats) {
+  if (bundle == &previous_bundle) {
+    return errors::InvalidArgument(
+        "ReloadSavedModel needs a new bundle to load into");
+  }
+  const uint64 start_microseconds = Env::Default()->NowMicros();
+  return RecordLoadAttempt(
+      export_dir, start_microseconds,
+      LoadSavedModelInternal(session_options, run_options, export_dir, tags,
+                             previous_export_dir, &previous_bundle, bundle,
+                             stats));
+}
+
 bool MaybeSavedModelDirectory(const string& export_dir) {
   const string saved_model_pb_path =
       io::JoinPath(export_dir, kSavedModelFilenamePb);
@@ -47,11 +47,44 @@ struct SavedModelBundle {
 /// to be loaded is identified by the supplied tags, corresponding exactly to
 /// the set of tags used at SavedModel build time. Returns a SavedModel bundle
 /// with a session and the requested meta graph def, if found.
+///
+/// If the SavedModel has warmup requests (SavedModelWarmupRequest records in
+/// assets.extra/saved_model_warmup), they are run through the session before
+/// returning, so that the first real requests do not hit cold paths.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Statistics of the variables restored by ReloadSavedModel().
+struct SavedModelReloadStats {
+  /// The number of variables copied from the previous bundle.
+  int num_reused_variables = 0;
+  /// The number of variables read from the checkpoint of the new SavedModel.
+  int num_restored_variables = 0;
+};
+
+/// Loads the SavedModel at `export_dir` like LoadSavedModel(), but reuses the
+/// variables of `previous_bundle`, which was loaded from `previous_export_dir`
+/// and still serves, where it can. The checkpoint entries of the two
+/// SavedModels are compared by dtype, shape, size and crc32c checksum, and the
+/// variables whose entries match are copied from the previous session in
+/// memory. Only the variables that changed are read from disk, which makes
+/// loading a new version that retrained only a few layers much cheaper.
+///
+/// The previous session must not have modified its variables since it was
+/// loaded. If either graph restores its variables in a way that cannot be
+/// matched up, e.g. with partitioned variables, all the variables are read
+/// from disk. `stats` may be null.
+Status ReloadSavedModel(const SessionOptions& session_options,
+                        const RunOptions& run_options,
+                        const string& export_dir,
+                        const std::unordered_set<string>& tags,
+                        const string& previous_export_dir,
+                        const SavedModelBundle& previous_bundle,
+                        SavedModelBundle* const bundle,
+                        SavedModelReloadStats* stats);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
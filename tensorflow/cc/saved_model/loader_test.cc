@@ -24,7 +24,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -64,8 +68,10 @@ class LoaderTest : public ::testing::Test {
         test::AsTensor<string>({"foo.txt"}, TensorShape({})), path_outputs[0]);
   }
 
-  void CheckSavedModelBundle(const string& export_dir,
-                             const SavedModelBundle& bundle) {
+  // Checks that "bundle" computes "expected_y" for x in {0, 1, 2, 3}.
+  void CheckSavedModelBundle(
+      const string& export_dir, const SavedModelBundle& bundle,
+      const std::vector<float>& expected_y = {2, 2.5, 3, 3.5}) {
     ValidateAssets(export_dir, bundle);
     // Retrieve the regression signature from meta graph def.
     const auto signature_def_map = bundle.meta_graph_def.signature_def();
@@ -88,8 +94,55 @@ class LoaderTest : public ::testing::Test {
                                      &outputs));
     ASSERT_EQ(outputs.size(), 1);
     test::ExpectTensorEqual<float>(
-        outputs[0],
-        test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+        outputs[0], test::AsTensor<float>(expected_y, TensorShape({4, 1})));
+  }
+
+  // Copies the SavedModel at "src_dir" to "dst_dir" and records "requests"
+  // as its warmup requests.
+  void CopySavedModelWithWarmup(
+      const string& src_dir, const string& dst_dir,
+      const std::vector<SavedModelWarmupRequest>& requests) {
+    Env* env = Env::Default();
+    for (const string& dir :
+         {string(), string(kSavedModelAssetsDirectory),
+          string(kSavedModelVariablesDirectory),
+          string(kSavedModelAssetsExtraDirectory)}) {
+      TF_ASSERT_OK(env->RecursivelyCreateDir(io::JoinPath(dst_dir, dir)));
+      if (dir == kSavedModelAssetsExtraDirectory) continue;
+      std::vector<string> children;
+      TF_ASSERT_OK(env->GetChildren(io::JoinPath(src_dir, dir), &children));
+      for (const string& child : children) {
+        const string src_path = io::JoinPath(src_dir, dir, child);
+        if (env->IsDirectory(src_path).ok()) continue;
+        string contents;
+        TF_ASSERT_OK(ReadFileToString(env, src_path, &contents));
+        TF_ASSERT_OK(WriteStringToFile(
+            env, io::JoinPath(dst_dir, dir, child), contents));
+      }
+    }
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(env->NewWritableFile(
+        io::JoinPath(dst_dir, kSavedModelAssetsExtraDirectory,
+                     kSavedModelWarmupFilename),
+        &file));
+    io::RecordWriter writer(file.get());
+    for (const SavedModelWarmupRequest& request : requests) {
+      TF_ASSERT_OK(writer.WriteRecord(request.SerializeAsString()));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  SavedModelWarmupRequest MakeWarmupRequest(const string& signature_key,
+                                            const string& input_key) {
+    SavedModelWarmupRequest request;
+    request.set_signature_key(signature_key);
+    request.set_num_runs(2);
+    NamedTensorProto* input = request.add_inputs();
+    input->set_name(input_key);
+    test::AsTensor<string>({MakeSerializedExample(1)}, TensorShape({1}))
+        .AsProtoTensorContent(input->mutable_tensor());
+    return request;
   }
 };
 
@@ -191,6 +244,95 @@ TEST_F(LoaderTest, InvalidExportPath) {
   EXPECT_FALSE(st.ok());
 }
 
+TEST_F(LoaderTest, WarmupRequests) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string src_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "half_plus_two_warmup");
+  CopySavedModelWithWarmup(
+      src_dir, export_dir,
+      {MakeWarmupRequest("regress_x_to_y", kRegressInputs)});
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
+TEST_F(LoaderTest, InvalidWarmupRequest) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string src_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "half_plus_two_invalid_warmup");
+  CopySavedModelWithWarmup(
+      src_dir, export_dir,
+      {MakeWarmupRequest("missing_signature", kRegressInputs)});
+  Status st = LoadSavedModel(session_options, run_options, export_dir,
+                             {kSavedModelTagServe}, &bundle);
+  EXPECT_FALSE(st.ok());
+  EXPECT_TRUE(StringPiece(st.error_message()).contains("missing_signature"))
+      << st.error_message();
+}
+
+TEST_F(LoaderTest, ReloadUnchangedVariables) {
+  SavedModelBundle previous_bundle;
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &previous_bundle));
+  SavedModelReloadStats stats;
+  TF_ASSERT_OK(ReloadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, export_dir,
+                                previous_bundle, &bundle, &stats));
+  CheckSavedModelBundle(export_dir, bundle);
+  EXPECT_EQ(3, stats.num_reused_variables);
+  EXPECT_EQ(0, stats.num_restored_variables);
+}
+
+TEST_F(LoaderTest, ReloadChangedVariables) {
+  SavedModelBundle previous_bundle;
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  // Copies the SavedModel with "b" changed from 2 to 3.
+  const string previous_export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "half_plus_two_retrained");
+  CopySavedModelWithWarmup(previous_export_dir, export_dir, {});
+  BundleWriter writer(Env::Default(),
+                      io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                                   kSavedModelVariablesFilename));
+  TF_ASSERT_OK(writer.Add("a", test::AsScalar<float>(0.5)));
+  TF_ASSERT_OK(writer.Add("b", test::AsScalar<float>(3.0)));
+  TF_ASSERT_OK(writer.Add("c", test::AsScalar<float>(3.0)));
+  TF_ASSERT_OK(writer.Finish());
+
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options,
+                              previous_export_dir, {kSavedModelTagServe},
+                              &previous_bundle));
+  SavedModelReloadStats stats;
+  TF_ASSERT_OK(ReloadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, previous_export_dir,
+                                previous_bundle, &bundle, &stats));
+  CheckSavedModelBundle(export_dir, bundle, {3, 3.5, 4, 4.5});
+  EXPECT_EQ(2, stats.num_reused_variables);
+  EXPECT_EQ(1, stats.num_restored_variables);
+  // The previous bundle still serves its own variables.
+  CheckSavedModelBundle(previous_export_dir, previous_bundle);
+}
+
 TEST_F(LoaderTest, MaybeSavedModelDirectory) {
   // Valid SavedModel directory.
   const string export_dir =
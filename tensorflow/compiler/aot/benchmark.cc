@@ -109,6 +109,27 @@ void DumpStatsToStdout(const Stats& stats) {
   }
 }
 
+void DumpScalingToStdout(const std::vector<int>& concurrency,
+                         const std::vector<Stats>& stats) {
+  printf("Scaling of concurrent invocations:\n");
+  printf("  %11s %14s %12s %10s\n", "Concurrency", "Mean us/iter",
+         "Invocs/sec", "Speedup");
+  double base_throughput = 0;
+  for (size_t i = 0; i < concurrency.size() && i < stats.size(); ++i) {
+    const size_t iters = stats[i].per_iter_us.size();
+    if (iters == 0 || stats[i].total_us <= 0) {
+      continue;
+    }
+    const double mean_us = static_cast<double>(stats[i].total_us) / iters;
+    const double throughput = concurrency[i] * 1e6 / mean_us;
+    if (base_throughput == 0) {
+      base_throughput = throughput;
+    }
+    printf("  %11d %14.3f %12.1f %9.2fx\n", concurrency[i], mean_us,
+           throughput, throughput / base_throughput);
+  }
+}
+
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
   // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
   const int64 max_us = (options.max_micros <= 0 && options.max_iters <= 0)
@@ -56,6 +56,13 @@ struct Stats {
 // form.
 void DumpStatsToStdout(const Stats& stats);
 
+// DumpScalingToStdout printfs to stdout the throughput of running independent
+// invocations concurrently, and the speedup relative to the first entry,
+// typically a single invocation. `stats[i]` holds the stats of benchmark
+// iterations that each ran `concurrency[i]` invocations.
+void DumpScalingToStdout(const std::vector<int>& concurrency,
+                         const std::vector<Stats>& stats);
+
 // BenchmarkFn is the signature of the function generated by tfcompile.
 typedef std::function<void()> BenchmarkFn;
 
@@ -40,6 +40,20 @@ TEST(Benchmark, Benchmark) {
   EXPECT_EQ(stats5.per_iter_us.size(), 5);
 }
 
+TEST(Benchmark, DumpScaling) {
+  AddComp add;
+
+  Options options;
+  options.max_iters = 3;
+  std::vector<Stats> stats(2);
+  Benchmark(options, [&] { add.Run(); }, &stats[0]);
+  Benchmark(options, [&] { add.Run(); add.Run(); }, &stats[1]);
+  EXPECT_EQ(stats[1].per_iter_us.size(), 3);
+  // Entries without any iterations are skipped.
+  stats.emplace_back();
+  DumpScalingToStdout({1, 2, 4}, stats);
+}
+
 }  // namespace
 }  // namespace benchmark
 }  // namespace tfcompile
@@ -438,7 +438,8 @@ class {{CLASS}} {
     tensorflow::tfcompile::runtime::FreeContiguous(alloc_temps_);
   }
 
-  // Sets the thread pool to use during the Run call.
+  // Sets the thread pool to use during the Run call. Large ops compiled with
+  // tfcompile --target_parallelism > 1 split their work into tasks on it.
   {{CLASS}}& set_thread_pool(const Eigen::ThreadPoolDevice* pool) {
     run_options_.set_intra_op_thread_pool(pool);
 {{CONTEXT_SET_THREAD_POOL}}
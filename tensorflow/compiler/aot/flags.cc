@@ -51,6 +51,11 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "http://clang.llvm.org/docs/CrossCompilation.html#cpu-fpu-abi"},
       {"target_features", &flags->target_features,
        "Target features, e.g. +avx2, +neon, etc."},
+      {"target_parallelism", &flags->target_parallelism,
+       "Maximum number of parallel tasks that large ops are split into.  The "
+       "tasks run on the thread pool passed to set_thread_pool of the "
+       "generated class, or in sequence if there is none.  Values <= 1 "
+       "disable splitting."},
       {"entry_point", &flags->entry_point,
        "Name of the generated function.  If multiple generated object files "
        "will be linked into the same binary, each will need a unique entry "
@@ -33,6 +33,7 @@ struct MainFlags {
   string target_triple;
   string target_cpu;
   string target_features;
+  int32 target_parallelism = 1;
   string entry_point;
   string cpp_class;
   string out_object;
@@ -19,8 +19,19 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_AOT_RUNTIME_H_
 #define TENSORFLOW_COMPILER_AOT_RUNTIME_H_
 
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
+namespace Eigen {
+struct ThreadPoolDevice;
+}  // namespace Eigen
+
 namespace tensorflow {
 namespace tfcompile {
 namespace runtime {
@@ -51,6 +62,96 @@ void* MallocContiguousBuffers(const intptr_t* sizes, size_t n, void** bufs,
 // MallocContiguousBuffers.
 void FreeContiguous(void* contiguous);
 
+// ConcurrentRunner runs independent invocations of a class generated by
+// tfcompile concurrently, e.g. to split a large batch into smaller ones that
+// are processed in parallel. It owns `num_slots` instances of the class, one
+// per slot, each with its own preallocated arg, result and temp buffers.
+// Usage example:
+//
+//   Eigen::ThreadPool inter_op_pool(kNumSlots - 1);
+//   ConcurrentRunner<MyComputation> runner(
+//       kNumSlots, [&inter_op_pool](std::function<void()> fn) {
+//         inter_op_pool.Schedule(std::move(fn));
+//       });
+//   runner.set_thread_pool(&intra_op_device);
+//   // ...set args of each runner.slot(i) using its argN methods
+//   CHECK(runner.Run(kNumSlots));
+//   // ...inspect results of each runner.slot(i) using its resultN methods
+//
+// Each invocation blocks the thread it is scheduled on until it completes, so
+// `schedule` must not run closures on the intra-op thread pool passed to
+// set_thread_pool; otherwise the parallel tasks of an invocation may never get
+// to run.
+//
+// This class is thread-compatible.
+template <typename Computation>
+class ConcurrentRunner {
+ public:
+  // Schedules a closure to run on some thread.
+  typedef std::function<void(std::function<void()>)> ScheduleFn;
+
+  ConcurrentRunner(int num_slots, ScheduleFn schedule,
+                   typename Computation::AllocMode mode =
+                       Computation::AllocMode::ARGS_RESULTS_AND_TEMPS)
+      : schedule_(std::move(schedule)) {
+    CHECK_GT(num_slots, 0);
+    slots_.reserve(num_slots);
+    for (int i = 0; i < num_slots; ++i) {
+      slots_.emplace_back(new Computation(mode));
+    }
+  }
+
+  int num_slots() const { return slots_.size(); }
+
+  // Returns the computation of slot `i`, whose buffers are only used by
+  // invocations of that slot.
+  Computation& slot(int i) { return *slots_[i]; }
+  const Computation& slot(int i) const { return *slots_[i]; }
+
+  // Sets the intra-op thread pool used by the computations of all slots.
+  ConcurrentRunner& set_thread_pool(const Eigen::ThreadPoolDevice* pool) {
+    for (auto& slot : slots_) {
+      slot->set_thread_pool(pool);
+    }
+    return *this;
+  }
+
+  // Runs the computations of the first `n` slots concurrently, the first one
+  // on the calling thread, and waits for all of them to complete. Returns true
+  // if all succeeded; the error_msg of each failed slot describes its failure.
+  bool Run(int n) {
+    CHECK_GT(n, 0);
+    CHECK_LE(n, num_slots());
+    mutex mu;
+    condition_variable done;
+    int pending = n - 1;
+    bool ok = true;
+    for (int i = 1; i < n; ++i) {
+      Computation* computation = slots_[i].get();
+      schedule_([computation, &mu, &done, &pending, &ok]() {
+        const bool slot_ok = computation->Run();
+        mutex_lock lock(mu);
+        ok = ok && slot_ok;
+        if (--pending == 0) {
+          done.notify_all();
+        }
+      });
+    }
+    const bool first_ok = slots_[0]->Run();
+    mutex_lock lock(mu);
+    while (pending > 0) {
+      done.wait(lock);
+    }
+    return ok && first_ok;
+  }
+
+ private:
+  std::vector<std::unique_ptr<Computation>> slots_;
+  const ScheduleFn schedule_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ConcurrentRunner);
+};
+
 }  // namespace runtime
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/runtime.h"
 
+#include <thread>  // NOLINT(build/c++11)
+
 #include "tensorflow/compiler/tf2xla/xla_local_runtime_context.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/test.h"
@@ -119,6 +121,66 @@ TEST(Runtime, MallocFreeContiguousBuffers) {
   FreeContiguous(base);
 }
 
+// Mimics the interface of a class generated by tfcompile.
+class FakeComputation {
+ public:
+  enum class AllocMode { ARGS_RESULTS_AND_TEMPS, RESULTS_AND_TEMPS_ONLY };
+
+  explicit FakeComputation(AllocMode mode) : mode_(mode) {}
+
+  FakeComputation& set_thread_pool(const Eigen::ThreadPoolDevice* pool) {
+    pool_ = pool;
+    return *this;
+  }
+
+  bool Run() {
+    result_ = arg_ + 1;
+    return !fail_;
+  }
+
+  AllocMode mode_;
+  const Eigen::ThreadPoolDevice* pool_ = nullptr;
+  bool fail_ = false;
+  int arg_ = 0;
+  int result_ = -1;
+};
+
+TEST(Runtime, ConcurrentRunner) {
+  std::vector<std::thread> threads;
+  ConcurrentRunner<FakeComputation> runner(
+      4, [&threads](std::function<void()> fn) { threads.emplace_back(fn); },
+      FakeComputation::AllocMode::RESULTS_AND_TEMPS_ONLY);
+  EXPECT_EQ(runner.num_slots(), 4);
+  auto* pool = reinterpret_cast<const Eigen::ThreadPoolDevice*>(&runner);
+  runner.set_thread_pool(pool);
+  for (int i = 0; i < runner.num_slots(); ++i) {
+    EXPECT_EQ(runner.slot(i).mode_,
+              FakeComputation::AllocMode::RESULTS_AND_TEMPS_ONLY);
+    EXPECT_EQ(runner.slot(i).pool_, pool);
+    runner.slot(i).arg_ = 10 * i;
+  }
+
+  // Only the first three slots run, two of them on scheduled threads.
+  EXPECT_TRUE(runner.Run(3));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(threads.size(), 2);
+  EXPECT_EQ(runner.slot(0).result_, 1);
+  EXPECT_EQ(runner.slot(1).result_, 11);
+  EXPECT_EQ(runner.slot(2).result_, 21);
+  EXPECT_EQ(runner.slot(3).result_, -1);
+
+  // A failure in any slot fails the whole run.
+  threads.clear();
+  runner.slot(2).fail_ = true;
+  EXPECT_FALSE(runner.Run(4));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(runner.slot(3).result_, 31);
+}
+
 }  // namespace
 }  // namespace runtime
 }  // namespace tfcompile
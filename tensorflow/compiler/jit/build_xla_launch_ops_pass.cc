@@ -40,7 +40,7 @@ static Status BuildLaunchNode(
     const AttrValueMap& function_attr, const string& device_name,
     const DataTypeVector& constant_dtypes, int num_resources,
     const DataTypeVector& arg_dtypes, const DataTypeVector& result_dtypes,
-    Graph* graph, Node** node) {
+    bool async_compilation, Graph* graph, Node** node) {
   NodeDef def;
   def.set_name(graph->NewName(nodename));
   def.set_op("_XlaLaunch");
@@ -53,13 +53,17 @@ static Status BuildLaunchNode(
   function.set_name(function_name);
   *function.mutable_attr() = function_attr;
   AddNodeAttr("function", function, &def);
+  if (async_compilation) {
+    AddNodeAttr(kXlaAsyncCompilationAttr, true, &def);
+  }
 
   Status status;
   *node = graph->AddNode(def, &status);
   return status;
 }
 
-static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
+static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node,
+                                       bool async_compilation) {
   VLOG(2) << "Replacing " << node->name() << " with XlaLaunch";
 
   int num_constant_args, num_resource_args;
@@ -87,7 +91,7 @@ static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
   TF_RETURN_IF_ERROR(BuildLaunchNode(
       graph->NewName(node->name()), node->type_string(), node->def().attr(),
       node->requested_device(), const_dtypes, num_resource_args, arg_dtypes,
-      node->output_types(), graph, &launch_node));
+      node->output_types(), async_compilation, graph, &launch_node));
   launch_node->set_assigned_device_name(node->assigned_device_name());
 
   // Copy incoming edges to the launch node.
@@ -122,6 +126,11 @@ static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
 
 Status BuildXlaLaunchOpsPass::Run(const GraphOptimizationPassOptions& options) {
   Graph* graph = options.graph->get();
+  const bool async_compilation =
+      options.session_options != nullptr &&
+      options.session_options->config.graph_options()
+          .optimizer_options()
+          .jit_async_compilation();
 
   for (Node* n : graph->op_nodes()) {
     // In all cases, only try to compile computational nodes.
@@ -132,7 +141,8 @@ Status BuildXlaLaunchOpsPass::Run(const GraphOptimizationPassOptions& options) {
     // Only compile nodes that are marked for compilation by the
     // compilation-marking pass (via 'attr_name').
     if (IsXlaCompiledKernel(*n)) {
-      TF_RETURN_IF_ERROR(ReplaceNodeWithXlaLaunch(graph, n));
+      TF_RETURN_IF_ERROR(
+          ReplaceNodeWithXlaLaunch(graph, n, async_compilation));
     }
   }
 
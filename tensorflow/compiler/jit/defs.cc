@@ -19,5 +19,6 @@ namespace tensorflow {
 
 const char* const kXlaCompileAttr = "_XlaCompile";
 const char* const kXlaScopeAttr = "_XlaScope";
+const char* const kXlaAsyncCompilationAttr = "_XlaAsyncCompilation";
 
 }  // namespace tensorflow
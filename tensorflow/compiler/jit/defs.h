@@ -25,6 +25,9 @@ namespace tensorflow {
 extern const char* const kXlaCompileAttr;  // "_XlaCompile"
 extern const char* const kXlaScopeAttr;    // "_XlaScope"
 
+// Name of the attribute of _XlaLaunch nodes that compile in the background.
+extern const char* const kXlaAsyncCompilationAttr;  // "_XlaAsyncCompilation"
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_COMPILER_JIT_DEFS_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/kernels/xla_device_launch_op.h"
 
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/legacy_flags/xla_launch_op_flags.h"
 #include "tensorflow/compiler/jit/xla_device.h"
 #include "tensorflow/compiler/jit/xla_device_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -43,8 +44,9 @@ Status BuildCompilationCache(ResourceMgr* rm, XlaCompilationCache** cache) {
     return s;
   }
   core::ScopedUnref metadata_ref(metadata);
-  *cache =
-      new XlaCompilationCache(metadata->client(), metadata->jit_device_type());
+  *cache = new XlaCompilationCache(
+      metadata->client(), metadata->jit_device_type(),
+      legacy_flags::GetXlaLaunchOpFlags()->tf_xla_compilation_cache_capacity);
   return Status::OK();
 }
 
@@ -111,8 +113,10 @@ void XlaDeviceLaunchOp::Compute(OpKernelContext* ctx) {
   options.local_executable_has_hybrid_result = false;
 
   const XlaCompiler::CompilationResult* kernel;
+  XlaCompilationCache::CompilationRef compilation_ref;
   OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_,
-                                     variables, ctx, &kernel, nullptr));
+                                     variables, ctx, nullptr, &kernel, nullptr,
+                                     &compilation_ref));
 
   VLOG(1) << "XLA compilation complete...";
 
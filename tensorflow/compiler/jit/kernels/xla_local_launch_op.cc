@@ -15,7 +15,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/kernels/xla_local_launch_op.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_set>
+
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/legacy_flags/xla_launch_op_flags.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_local_runtime_context.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
@@ -30,6 +36,8 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/util/stream_executor_util.h"
@@ -38,6 +46,30 @@ namespace gpu = perftools::gputools;
 
 namespace tensorflow {
 
+namespace {
+
+// Operators that compute each row of the leading dimension of their outputs
+// from the same row of their inputs, when those have the same rank.
+const std::unordered_set<string>* PadSafeOps() {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"Abs",        "Add",          "BiasAdd",      "Cast",
+       "Ceil",       "Const",        "Cos",          "Elu",
+       "Equal",      "Exp",          "Expm1",        "Floor",
+       "Greater",    "GreaterEqual", "Identity",     "IsFinite",
+       "Less",       "LessEqual",    "Log",          "Log1p",
+       "LogSoftmax", "LogicalAnd",   "LogicalNot",   "LogicalOr",
+       "MatMul",     "Maximum",      "Minimum",      "Mul",
+       "Neg",        "NotEqual",     "OnesLike",     "Pow",
+       "RealDiv",    "Reciprocal",   "Relu",         "Relu6",
+       "Round",      "Rsqrt",        "Selu",         "Sigmoid",
+       "Sign",       "Sin",          "Softmax",      "Softplus",
+       "Softsign",   "Sqrt",         "Square",       "SquaredDifference",
+       "Sub",        "Tanh",         "ZerosLike"});
+  return ops;
+}
+
+}  // namespace
+
 // Adapter class that wraps a Tensorflow allocator as an XLA allocator.
 // Assumes that the Tensorflow allocator permits asynchronous deallocation:
 // see comment on `AllowsAsynchronousDeallocation()`.
@@ -135,7 +167,7 @@ Status XlaAllocator::MakeTensorFromBuffer(gpu::DeviceMemoryBase buffer,
 }
 
 XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx), device_type_(ctx->device_type()) {
+    : AsyncOpKernel(ctx), device_type_(ctx->device_type()) {
   const NameAttrList* func;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("function", &func));
   function_ = *func;
@@ -148,6 +180,23 @@ XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
   OP_REQUIRES(ctx, num_resource_args == 0,
               errors::Unimplemented(
                   "XlaLocalLaunchOp does not support resource variables"));
+  if (def().attr().count(kXlaAsyncCompilationAttr) > 0) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kXlaAsyncCompilationAttr, &async_compilation_));
+  }
+  const string& buckets =
+      legacy_flags::GetXlaLaunchOpFlags()->tf_xla_batch_buckets;
+  for (const string& bucket : str_util::Split(buckets, ',')) {
+    int64 size;
+    OP_REQUIRES(ctx,
+                strings::safe_strto64(bucket, &size) && size > 0 &&
+                    (batch_buckets_.empty() || size > batch_buckets_.back()),
+                errors::InvalidArgument(
+                    "tf_xla_batch_buckets must be increasing positive sizes, "
+                    "got: ",
+                    buckets));
+    batch_buckets_.push_back(size);
+  }
   if (device_type_ == DeviceType(DEVICE_CPU)) {
     platform_id_ = gpu::host::kHostPlatformId;
   } else if (device_type_ == DeviceType(DEVICE_GPU)) {
@@ -180,27 +229,137 @@ Status XlaLocalLaunchOp::BuildCompilationCache(OpKernelContext* ctx,
                                    device_type_.type());
   }
   *cache = new XlaCompilationCache(
-      client.ValueOrDie(), DeviceType(registration->compilation_device_name));
+      client.ValueOrDie(), DeviceType(registration->compilation_device_name),
+      legacy_flags::GetXlaLaunchOpFlags()->tf_xla_compilation_cache_capacity);
+  return Status::OK();
+}
+
+Status XlaLocalLaunchOp::CompileFunction(
+    OpKernelContext* ctx, XlaCompilationCache* cache,
+    const XlaCompiler::Options& options, const std::vector<Tensor>* inputs,
+    const XlaCompiler::CompilationResult** kernel,
+    xla::LocalExecutable** executable,
+    XlaCompilationCache::CompilationRef* compilation_ref) {
+  // On GPU, the constant arguments are in host memory, where the function
+  // does not expect them, so only the clusters without any may run the
+  // function while they compile.
+  if (async_compilation_ &&
+      (num_constant_args_ == 0 || device_type_ == DeviceType(DEVICE_CPU))) {
+    return cache->CompileAsync(options, function_, num_constant_args_, {}, ctx,
+                               inputs, kernel, executable, compilation_ref);
+  }
+  return cache->Compile(options, function_, num_constant_args_, {}, ctx,
+                        inputs, kernel, executable, compilation_ref);
+}
+
+int64 XlaLocalLaunchOp::PaddedRows(OpKernelContext* ctx,
+                                   const FunctionLibraryDefinition* flib_def,
+                                   int64* rows) {
+  if (batch_buckets_.empty() || ctx->num_inputs() == num_constant_args_) {
+    return -1;
+  }
+  // The non-constant inputs must have the same rank, of at least 2 so that
+  // broadcasting never lines up their leading dimension with another one, and
+  // the same leading dimension.
+  const Tensor& first = ctx->input(num_constant_args_);
+  if (first.dims() < 2 || first.dim_size(0) == 0) {
+    return -1;
+  }
+  for (int i = num_constant_args_; i < ctx->num_inputs(); ++i) {
+    const Tensor& input = ctx->input(i);
+    if (input.dims() != first.dims() ||
+        input.dim_size(0) != first.dim_size(0) ||
+        !DataTypeCanUseMemcpy(input.dtype())) {
+      return -1;
+    }
+  }
+  *rows = first.dim_size(0);
+  auto bucket =
+      std::lower_bound(batch_buckets_.begin(), batch_buckets_.end(), *rows);
+  if (bucket == batch_buckets_.end() || *bucket == *rows) {
+    return -1;
+  }
+  mutex_lock lock(mu_);
+  if (!pad_safety_checked_) {
+    pad_safety_checked_ = true;
+    pad_safe_ = IsPadSafe(flib_def);
+    VLOG(1) << function_.name() << " is "
+            << (pad_safe_ ? "" : "not ") << "safe to pad";
+  }
+  return pad_safe_ ? *bucket : -1;
+}
+
+bool XlaLocalLaunchOp::IsPadSafe(
+    const FunctionLibraryDefinition* flib_def) const {
+  const FunctionDef* fdef = flib_def->Find(function_.name());
+  if (fdef == nullptr) {
+    return false;
+  }
+  for (const NodeDef& node : fdef->node_def()) {
+    if (PadSafeOps()->count(node.op()) == 0) {
+      return false;
+    }
+    // The transposed left operand of a MatMul sums over its rows.
+    bool transpose_a = false;
+    if (node.op() == "MatMul" &&
+        (!GetNodeAttr(node, "transpose_a", &transpose_a).ok() ||
+         transpose_a)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status XlaLocalLaunchOp::PadInputs(OpKernelContext* ctx, int64 padded_rows,
+                                   std::vector<Tensor>* inputs) {
+  gpu::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  inputs->reserve(ctx->num_inputs());
+  for (int i = 0; i < num_constant_args_; ++i) {
+    inputs->push_back(ctx->input(i));
+  }
+  for (int i = num_constant_args_; i < ctx->num_inputs(); ++i) {
+    const Tensor& input = ctx->input(i);
+    TensorShape padded_shape = input.shape();
+    padded_shape.set_dim(0, padded_rows);
+    Tensor padded;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(input.dtype(), padded_shape, &padded));
+    const uint64 size = input.tensor_data().size();
+    const uint64 padding_size = padded.tensor_data().size() - size;
+    char* dst = const_cast<char*>(padded.tensor_data().data());
+    if (stream) {
+      gpu::DeviceMemoryBase src_mem(
+          const_cast<char*>(input.tensor_data().data()), size);
+      gpu::DeviceMemoryBase dst_mem(dst, size);
+      gpu::DeviceMemoryBase padding_mem(dst + size, padding_size);
+      stream->ThenMemcpyD2D(&dst_mem, src_mem, size)
+          .ThenMemZero(&padding_mem, padding_size);
+    } else {
+      memcpy(dst, input.tensor_data().data(), size);
+      memset(dst + size, 0, padding_size);
+    }
+    inputs->push_back(padded);
+  }
   return Status::OK();
 }
 
-void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
+void XlaLocalLaunchOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   VLOG(1) << "XlaLocalLaunchOp::Compute "
           << Canonicalize(function_.name(), AttrSlice(&function_.attr()));
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
-  OP_REQUIRES(ctx, rm, errors::Internal("No resource manager."));
-
-  gpu::Stream* stream =
-      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  OP_REQUIRES_ASYNC(ctx, rm, errors::Internal("No resource manager."), done);
 
   XlaCompilationCache* cache;
-  OP_REQUIRES_OK(ctx, rm->LookupOrCreate<XlaCompilationCache>(
-                          rm->default_container(), "xla_cache", &cache,
-                          [this, ctx](XlaCompilationCache** cache) {
-                            return BuildCompilationCache(ctx, cache);
-                          }));
+  OP_REQUIRES_OK_ASYNC(ctx,
+                       rm->LookupOrCreate<XlaCompilationCache>(
+                           rm->default_container(), "xla_cache", &cache,
+                           [this, ctx](XlaCompilationCache** cache) {
+                             return BuildCompilationCache(ctx, cache);
+                           }),
+                       done);
   // Hold the reference to the JIT during evaluation. (We could probably
   // free it sooner because the ResourceMgr will retain a reference, but
   // this is more obviously correct.)
@@ -216,13 +375,103 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   options.allow_cpu_custom_calls = (platform_id_ == gpu::host::kHostPlatformId);
   options.local_executable_has_hybrid_result = true;
 
+  // Pads the inputs up to their batch bucket, if the function allows it.
+  int64 rows = -1;
+  const int64 padded_rows = PaddedRows(ctx, options.flib_def, &rows);
+  std::vector<Tensor> padded_inputs;
+  if (padded_rows >= 0) {
+    OP_REQUIRES_OK_ASYNC(ctx, PadInputs(ctx, padded_rows, &padded_inputs),
+                         done);
+  }
+  const std::vector<Tensor>* inputs =
+      padded_rows >= 0 ? &padded_inputs : nullptr;
+
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
-  OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_, {},
-                                     ctx, &kernel, &executable));
+  XlaCompilationCache::CompilationRef compilation_ref;
+  Status status = CompileFunction(ctx, cache, options, inputs, &kernel,
+                                  &executable, &compilation_ref);
+  if (inputs != nullptr && status.ok() && kernel != nullptr) {
+    // Every output must be padded like the inputs, to be sliced back.
+    for (const XlaCompiler::OutputDescription& output : kernel->outputs) {
+      if (output.is_constant || output.shape.dims() == 0 ||
+          output.shape.dim_size(0) != padded_rows) {
+        status = errors::InvalidArgument("Output shape ",
+                                         output.shape.DebugString(),
+                                         " is not padded");
+        break;
+      }
+    }
+  }
+  if (inputs != nullptr && !status.ok()) {
+    VLOG(1) << "Not padding the inputs of " << function_.name() << ": "
+            << status;
+    {
+      mutex_lock lock(mu_);
+      pad_safe_ = false;
+    }
+    inputs = nullptr;
+    status = CompileFunction(ctx, cache, options, nullptr, &kernel,
+                             &executable, &compilation_ref);
+  }
+  OP_REQUIRES_OK_ASYNC(ctx, status, done);
+  if (kernel == nullptr) {
+    VLOG(1) << "Running the uncompiled function while it compiles";
+    RunFunction(ctx, done);
+    return;
+  }
+  RunExecutable(ctx, client, kernel, executable, inputs, rows);
+  done();
+}
+
+void XlaLocalLaunchOp::RunFunction(OpKernelContext* ctx, DoneCallback done) {
+  FunctionLibraryRuntime* lib = ctx->function_library();
+  OP_REQUIRES_ASYNC(ctx, lib != nullptr,
+                    errors::Internal("No function library is provided."),
+                    done);
+  FunctionLibraryRuntime::Handle handle;
+  OP_REQUIRES_OK_ASYNC(
+      ctx,
+      lib->Instantiate(function_.name(), AttrSlice(&function_.attr()), &handle),
+      done);
+
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  opts.runner = ctx->runner();
+  std::vector<Tensor> args;
+  args.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    args.push_back(ctx->input(i));
+  }
+  std::vector<Tensor>* rets = new std::vector<Tensor>;
+  lib->Run(opts, handle, args, rets, [ctx, done, rets](const Status& status) {
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+    } else if (rets->size() != ctx->num_outputs()) {
+      ctx->SetStatus(errors::Internal(
+          "The function of _XlaLaunch returned ", rets->size(),
+          " tensor(s) instead of ", ctx->num_outputs()));
+    } else {
+      for (size_t i = 0; i < rets->size(); ++i) {
+        ctx->set_output(i, (*rets)[i]);
+      }
+    }
+    delete rets;
+    done();
+  });
+}
 
+void XlaLocalLaunchOp::RunExecutable(
+    OpKernelContext* ctx, xla::LocalClient* client,
+    const XlaCompiler::CompilationResult* kernel,
+    xla::LocalExecutable* executable, const std::vector<Tensor>* inputs,
+    int64 rows) {
   VLOG(1) << "Executing XLA Computation...";
 
+  gpu::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+
   // Builds an XLA allocator for the device.
   XlaAllocator xla_allocator(client->platform(), ctx);
   XlaLocalRuntimeContext local_runtime_context;
@@ -240,9 +489,9 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
     for (int i = 0; i < kernel->xla_input_shapes.size(); ++i) {
       int arg_num = kernel->input_mapping[i];
       const xla::Shape& shape = kernel->xla_input_shapes[i];
-      gpu::DeviceMemoryBase dmem(
-          const_cast<char*>(ctx->input(arg_num).tensor_data().data()),
-          ctx->input(arg_num).tensor_data().size());
+      const Tensor& input = inputs ? (*inputs)[arg_num] : ctx->input(arg_num);
+      gpu::DeviceMemoryBase dmem(const_cast<char*>(input.tensor_data().data()),
+                                 input.tensor_data().size());
 
       arg_buffers[i] =
           xla::ShapedBuffer::MakeArrayShapedBuffer(
@@ -330,6 +579,10 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
       OP_REQUIRES_OK(ctx, xla_allocator.MakeTensorFromBuffer(
                               buffer, ctx->expected_output_dtype(i), shape,
                               &output_tensor));
+      if (inputs) {
+        // Drops the rows of the padding.
+        output_tensor = output_tensor.Slice(0, rows);
+      }
       ctx->set_output(i, output_tensor);
       ++output_num;
     }
@@ -18,10 +18,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
 namespace tensorflow {
@@ -35,21 +38,78 @@ namespace tensorflow {
 // XlaLocalLaunchOp uses xla::LocalClient::Compile() and
 // xla::LocalExecutable::Run(), and passes arguments into/out of XLA in device
 // memory.
-class XlaLocalLaunchOp : public OpKernel {
+// With the kXlaAsyncCompilationAttr attribute, the op does not wait for the
+// compilation of new input shapes: it runs the function with the regular
+// kernels of the device until the compilation is done.
+// With the tf_xla_batch_buckets flag, the op pads the leading dimension of its
+// inputs with zeros up to the next bucket size, and slices the padding off its
+// outputs, if all the operators of the function treat the rows of the leading
+// dimension independently. Inputs of varying batch sizes then share a few
+// compilations.
+class XlaLocalLaunchOp : public AsyncOpKernel {
  public:
   explicit XlaLocalLaunchOp(OpKernelConstruction* ctx);
   ~XlaLocalLaunchOp() override;
 
-  void Compute(OpKernelContext* ctx) override;
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
   // Builds a XlaCompilationCache class suitable for the current device.
   Status BuildCompilationCache(OpKernelContext* ctx,
                                XlaCompilationCache** compiler);
 
+  // Compiles 'function_' for 'inputs', or the inputs of 'ctx' if null, in the
+  // background if the op compiles asynchronously. See
+  // XlaCompilationCache::Compile().
+  Status CompileFunction(OpKernelContext* ctx, XlaCompilationCache* cache,
+                         const XlaCompiler::Options& options,
+                         const std::vector<Tensor>* inputs,
+                         const XlaCompiler::CompilationResult** kernel,
+                         xla::LocalExecutable** executable,
+                         XlaCompilationCache::CompilationRef* compilation_ref);
+
+  // Returns the bucket size to pad the leading dimension of the inputs of
+  // 'ctx' to, and sets '*rows' to their leading dimension. Returns -1 if the
+  // inputs are not to be padded.
+  int64 PaddedRows(OpKernelContext* ctx,
+                   const FunctionLibraryDefinition* flib_def, int64* rows);
+
+  // Returns true if the operators of 'function_' treat the rows of the
+  // leading dimension of their inputs independently, so that padding rows
+  // does not change the other rows.
+  bool IsPadSafe(const FunctionLibraryDefinition* flib_def) const;
+
+  // Copies the inputs of 'ctx' into '*inputs', with the non-constant ones
+  // padded with zeros to 'padded_rows' rows.
+  Status PadInputs(OpKernelContext* ctx, int64 padded_rows,
+                   std::vector<Tensor>* inputs);
+
+  // Runs the compiled 'kernel' and 'executable', and sets the outputs of
+  // 'ctx'. 'inputs', if non-null, are the arguments to run on instead of the
+  // inputs of 'ctx', padded to the leading dimension of the outputs of
+  // 'kernel', which are then sliced to 'rows' rows.
+  void RunExecutable(OpKernelContext* ctx, xla::LocalClient* client,
+                     const XlaCompiler::CompilationResult* kernel,
+                     xla::LocalExecutable* executable,
+                     const std::vector<Tensor>* inputs, int64 rows);
+
+  // Runs 'function_' through the function library runtime of 'ctx', and
+  // calls 'done' once its outputs are set.
+  void RunFunction(OpKernelContext* ctx, DoneCallback done);
+
   DeviceType device_type_;
   NameAttrList function_;
   int num_constant_args_;
+  bool async_compilation_ = false;
+
+  // The sizes to pad the leading dimension of the inputs to, increasing.
+  std::vector<int64> batch_buckets_;
+
+  mutex mu_;
+  // Has IsPadSafe() been checked, and did it pass? Cleared if the padded
+  // function fails to compile or its outputs are not padded.
+  bool pad_safety_checked_ GUARDED_BY(mu_) = false;
+  bool pad_safe_ GUARDED_BY(mu_) = false;
 
   perftools::gputools::Platform::Id platform_id_;
 
@@ -22,6 +22,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
@@ -31,19 +33,95 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* xla_compilations = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilations",
+    "The number of XLA compilations of each compiled function, one for each "
+    "signature of its inputs.",
+    "function");
+auto* xla_compile_time = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compile_micros",
+    "Time in microseconds spent compiling each compiled function with XLA.",
+    "function");
+auto* xla_cache_hits = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache_hits",
+    "The number of runs of each compiled function that found their "
+    "compilation in the cache.",
+    "function");
+auto* xla_cache_evictions = monitoring::Counter<0>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache_evictions",
+    "The number of compilations evicted from XLA compilation caches.");
+
+// The number of threads of the background compilations.
+constexpr int kNumCompileThreads = 2;
+
+// Estimates the memory held by `executable` as the size of the constants of
+// its HLO module. XLA does not report the size of the code it generates.
+int64 EstimateExecutableBytes(const xla::LocalExecutable& executable) {
+  const xla::Executable* xla_executable = executable.executable();
+  if (!xla_executable->has_module()) {
+    return 0;
+  }
+  int64 bytes = 0;
+  auto add_constant = [&bytes](const xla::HloInstruction& instruction) {
+    if (instruction.opcode() == xla::HloOpcode::kConstant &&
+        !xla::ShapeUtil::IsTuple(instruction.shape())) {
+      bytes += xla::ShapeUtil::ByteSizeOf(instruction.shape());
+    }
+  };
+  for (const auto& computation : xla_executable->module().computations()) {
+    for (const auto& instruction : computation->instructions()) {
+      add_constant(*instruction);
+      if (instruction->opcode() == xla::HloOpcode::kFusion) {
+        for (const auto& fused : instruction->fused_instructions()) {
+          add_constant(*fused);
+        }
+      }
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
 XlaCompilationCache::XlaCompilationCache(xla::Client* client,
-                                         DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
-XlaCompilationCache::~XlaCompilationCache() = default;
+                                         DeviceType device_type,
+                                         int64 capacity)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      capacity_(capacity) {}
+
+XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for the background compilations, which write to the entries.
+  std::unique_ptr<thread::ThreadPool> compile_threads;
+  {
+    mutex_lock lock(mu_);
+    compile_threads = std::move(compile_threads_);
+  }
+}
+
+XlaCompilationCache::Stats XlaCompilationCache::GetStats() {
+  mutex_lock lock(mu_);
+  Stats stats = stats_;
+  stats.entries = cache_.size();
+  return stats;
+}
 
 string XlaCompilationCache::DebugString() {
-  return "XLA JIT compilation cache";
+  const Stats stats = GetStats();
+  return strings::StrCat(
+      "XLA JIT compilation cache: ", stats.entries, " entries (capacity ",
+      capacity_, "), ", stats.hits, " hits, ", stats.misses, " misses, ",
+      stats.evictions, " evictions, ", stats.compile_micros,
+      "us compiling, ", stats.executable_bytes, " executable bytes");
 }
 
 // Compute a string signature which encodes the shapes of the
@@ -94,7 +172,10 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
 Status XlaCompilationCache::BuildSignature(
     const NameAttrList& function, int num_constant_args,
     const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
-    Signature* signature) {
+    const std::vector<Tensor>* inputs, Signature* signature) {
+  auto input = [ctx, inputs](int i) -> const Tensor& {
+    return inputs ? (*inputs)[i] : ctx->input(i);
+  };
   signature->name = Canonicalize(function.name(), AttrSlice(&function.attr()));
   signature->arg_values.resize(num_constant_args);
 
@@ -104,13 +185,13 @@ Status XlaCompilationCache::BuildSignature(
   int input_num = 0;
   // Use the values of compile time constants in the signature->
   while (input_num < num_constant_args) {
-    signature->arg_values[input_num] = ctx->input(input_num);
+    signature->arg_values[input_num] = input(input_num);
     ++input_num;
   }
   // Add the types and shapes of the remaining arguments.
   while (input_num < ctx->num_inputs() - variable_args.size()) {
     signature->arg_types.emplace_back(ctx->input_dtype(input_num),
-                                      ctx->input(input_num).shape());
+                                      input(input_num).shape());
     ++input_num;
   }
   // For variable signatures, use the type and shape of the variable's
@@ -131,11 +212,15 @@ Status XlaCompilationCache::BuildSignature(
 namespace {
 
 // Builds a XlaCompiler::Argument vector from the arguments to the _XlaLaunch
-// op. The first `num_constant_args` arguments must be host-memory Tensors.
+// op, or from `inputs` if non-null. The first `num_constant_args` arguments
+// must be host-memory Tensors.
 Status BuildArguments(int num_constant_args,
                       const std::vector<OptionalTensor>& variable_args,
-                      OpKernelContext* ctx,
+                      OpKernelContext* ctx, const std::vector<Tensor>* inputs,
                       std::vector<XlaCompiler::Argument>* args) {
+  auto input = [ctx, inputs](int i) -> const Tensor& {
+    return inputs ? (*inputs)[i] : ctx->input(i);
+  };
   args->resize(ctx->num_inputs());
 
   int input_num = 0;
@@ -143,13 +228,13 @@ Status BuildArguments(int num_constant_args,
   // Handles compile-time constants.
   TF_RET_CHECK(num_constant_args <= ctx->num_inputs());
   while (input_num < num_constant_args) {
-    const Tensor& input = ctx->input(input_num);
-    TF_RET_CHECK(input.dtype() != DT_RESOURCE);
+    const Tensor& constant = input(input_num);
+    TF_RET_CHECK(constant.dtype() != DT_RESOURCE);
     XlaCompiler::Argument& arg = (*args)[input_num];
     arg.kind = XlaCompiler::Argument::kConstant;
-    arg.type = input.dtype();
-    arg.shape = input.shape();
-    arg.constant_value = input;
+    arg.type = constant.dtype();
+    arg.shape = constant.shape();
+    arg.constant_value = constant;
     ++input_num;
   }
 
@@ -159,25 +244,24 @@ Status BuildArguments(int num_constant_args,
       ctx->num_inputs() - num_variable_args - num_constant_args;
   TF_RET_CHECK(num_nonconst_args >= 0);
   while (input_num < num_constant_args + num_nonconst_args) {
-    const Tensor& input = ctx->input(input_num);
-    TF_RET_CHECK(input.dtype() != DT_RESOURCE);
+    const Tensor& parameter = input(input_num);
+    TF_RET_CHECK(parameter.dtype() != DT_RESOURCE);
     XlaCompiler::Argument& arg = (*args)[input_num];
-    if (input.NumElements() > 0) {
+    if (parameter.NumElements() > 0) {
       arg.kind = XlaCompiler::Argument::kParameter;
     } else {
       arg.kind = XlaCompiler::Argument::kConstant;
-      arg.constant_value = input;
+      arg.constant_value = parameter;
     }
-    arg.type = input.dtype();
-    arg.shape = input.shape();
+    arg.type = parameter.dtype();
+    arg.shape = parameter.shape();
     ++input_num;
   }
 
   // Handles resource variables.
   TF_RET_CHECK(input_num + num_variable_args == ctx->num_inputs());
   for (int variable_id = 0; variable_id < num_variable_args; ++variable_id) {
-    const Tensor& input = ctx->input(input_num);
-    TF_RET_CHECK(input.dtype() == DT_RESOURCE);
+    TF_RET_CHECK(input(input_num).dtype() == DT_RESOURCE);
 
     XlaCompiler::Argument& arg = (*args)[input_num];
 
@@ -208,9 +292,9 @@ Status BuildArguments(int num_constant_args,
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     int num_constant_args, const std::vector<OptionalTensor>& variable_args,
-    OpKernelContext* ctx,
+    OpKernelContext* ctx, const std::vector<Tensor>* inputs,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable, CompilationRef* compilation_ref) {
   VLOG(1) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
@@ -235,49 +319,110 @@ Status XlaCompilationCache::Compile(
   }
 
   TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+  TF_RET_CHECK(inputs == nullptr || inputs->size() == ctx->num_inputs());
 
   Signature signature;
   TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
-                                    ctx, &signature));
+                                    ctx, inputs, &signature));
 
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
+  std::shared_ptr<Entry> entry = LookupEntry(signature, function.name());
+  *compilation_ref = entry;
+  return CompileEntry(options, function, num_constant_args, variable_args, ctx,
+                      inputs, entry.get(), compilation_result, executable);
+}
+
+std::shared_ptr<XlaCompilationCache::Entry> XlaCompilationCache::LookupEntry(
+    const Signature& signature, const string& function_name) {
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
-  Entry* entry;
-  {
-    mutex_lock lock(mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
-    if (!e) {
-      e.reset(new Entry);
+  mutex_lock lock(mu_);
+  auto it = cache_.find(signature);
+  if (it != cache_.end()) {
+    ++stats_.hits;
+    xla_cache_hits->GetCell(function_name)->IncrementBy(1);
+    lru_.splice(lru_.begin(), lru_, it->second->lru_position);
+    return it->second;
+  }
+
+  ++stats_.misses;
+  std::shared_ptr<Entry> entry(new Entry);
+  lru_.push_front(signature);
+  entry->lru_position = lru_.begin();
+  cache_.emplace(signature, entry);
+
+  // Evict the least recently used entries. Their users keep them alive, and
+  // their background compilations still finish.
+  while (capacity_ > 0 && static_cast<int64>(cache_.size()) > capacity_) {
+    auto victim = cache_.find(lru_.back());
+    VLOG(1) << "Evicting " << SignatureDebugString(victim->first);
+    victim->second->evicted = true;
+    stats_.executable_bytes -= victim->second->executable_bytes;
+    ++stats_.evictions;
+    xla_cache_evictions->GetCell()->IncrementBy(1);
+    cache_.erase(victim);
+    lru_.pop_back();
+  }
+  return entry;
+}
+
+void XlaCompilationCache::RecordCompilation(
+    Entry* entry, const string& function_name, int64 micros,
+    const xla::LocalExecutable* executable) {
+  xla_compile_time->GetCell(function_name)->IncrementBy(micros);
+  const int64 executable_bytes =
+      executable ? EstimateExecutableBytes(*executable) : 0;
+  mutex_lock lock(mu_);
+  stats_.compile_micros += micros;
+  if (executable) {
+    entry->executable_bytes = executable_bytes;
+    if (!entry->evicted) {
+      stats_.executable_bytes += executable_bytes;
     }
-    entry = e.get();
   }
+}
 
-  // Acquire the cache entry lock and compile, if necessary.
-  // TODO(phawkins): this locking will need to be restructured when we implement
-  // cache eviction.
+Status XlaCompilationCache::CompileEntry(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    int num_constant_args, const std::vector<OptionalTensor>& variable_args,
+    OpKernelContext* ctx, const std::vector<Tensor>* inputs, Entry* entry,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable) {
+  // Acquire the cache entry lock and compile, if necessary. An evicted entry
+  // is kept alive by its users, so it may be used while evicted.
   mutex_lock entry_lock(entry->mu);
+  // Wait for a background compilation of the entry.
+  while (entry->compiling) {
+    entry->compile_done.wait(entry_lock);
+  }
+  Env* env = Env::Default();
   if (!entry->compiled) {
     // Do the actual JIT compilation without holding the lock (it can take
     // a long time.)
     std::vector<XlaCompiler::Argument> args;
     TF_RETURN_IF_ERROR(
-        BuildArguments(num_constant_args, variable_args, ctx, &args));
+        BuildArguments(num_constant_args, variable_args, ctx, inputs, &args));
 
+    const uint64 start_us = env->NowMicros();
     XlaCompiler compiler(options);
     entry->compiled = true;
     entry->compilation_status =
         compiler.CompileFunction(XlaCompiler::CompileOptions(), function, args,
                                  &entry->compilation_result);
+    xla_compilations->GetCell(function.name())->IncrementBy(1);
+    RecordCompilation(entry, function.name(), env->NowMicros() - start_us,
+                      nullptr);
   }
   *compilation_result = &entry->compilation_result;
   if (entry->compilation_status.ok() && executable) {
     if (entry->executable == nullptr &&
         !entry->compilation_result.computation->IsNull()) {
+      const uint64 start_us = env->NowMicros();
       XlaCompiler compiler(options);
       entry->compilation_status = compiler.BuildExecutable(
           entry->compilation_result, &entry->executable);
+      RecordCompilation(entry, function.name(), env->NowMicros() - start_us,
+                        entry->executable.get());
     }
     *executable = entry->executable.get();
   }
@@ -286,4 +431,85 @@ Status XlaCompilationCache::Compile(
   return status;
 }
 
+Status XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    int num_constant_args, const std::vector<OptionalTensor>& variable_args,
+    OpKernelContext* ctx, const std::vector<Tensor>* inputs,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable, CompilationRef* compilation_ref) {
+  VLOG(1) << "XlaCompilationCache::CompileAsync " << DebugString();
+  TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+  TF_RET_CHECK(inputs == nullptr || inputs->size() == ctx->num_inputs());
+
+  Signature signature;
+  TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
+                                    ctx, inputs, &signature));
+  std::shared_ptr<Entry> entry = LookupEntry(signature, function.name());
+  {
+    mutex_lock entry_lock(entry->mu);
+    if (!entry->compiled) {
+      if (!entry->compiling) {
+        VLOG(1) << "Compiling in the background: "
+                << SignatureDebugString(signature);
+        std::vector<XlaCompiler::Argument> args;
+        TF_RETURN_IF_ERROR(BuildArguments(num_constant_args, variable_args,
+                                          ctx, inputs, &args));
+        // The function library of the caller may be gone by the time the
+        // compilation runs, so compile against a copy of it.
+        std::shared_ptr<FunctionLibraryDefinition> flib_def(
+            new FunctionLibraryDefinition(*options.flib_def));
+        XlaCompiler::Options background_options = options;
+        background_options.flib_def = flib_def.get();
+        entry->compiling = true;
+
+        thread::ThreadPool* compile_threads;
+        {
+          mutex_lock lock(mu_);
+          if (compile_threads_ == nullptr) {
+            compile_threads_.reset(new thread::ThreadPool(
+                Env::Default(), "xla_compile", kNumCompileThreads));
+          }
+          compile_threads = compile_threads_.get();
+        }
+        // The destructor waits for the compilation, so `this` outlives it.
+        compile_threads->Schedule([this, entry, background_options, flib_def,
+                                   function, args]() {
+          Env* env = Env::Default();
+          const uint64 start_us = env->NowMicros();
+          XlaCompiler compiler(background_options);
+          XlaCompiler::CompilationResult result;
+          std::unique_ptr<xla::LocalExecutable> local_executable;
+          Status status = compiler.CompileFunction(
+              XlaCompiler::CompileOptions(), function, args, &result);
+          if (status.ok() && !result.computation->IsNull()) {
+            status = compiler.BuildExecutable(result, &local_executable);
+          }
+          xla_compilations->GetCell(function.name())->IncrementBy(1);
+          VLOG(1) << "Background compilation of " << function.name()
+                  << " done: " << status;
+
+          mutex_lock entry_lock(entry->mu);
+          entry->compiled = true;
+          entry->compiling = false;
+          entry->compilation_status = status;
+          entry->compilation_result = std::move(result);
+          entry->executable = std::move(local_executable);
+          RecordCompilation(entry.get(), function.name(),
+                            env->NowMicros() - start_us,
+                            entry->executable.get());
+          entry->compile_done.notify_all();
+        });
+      }
+      *compilation_result = nullptr;
+      if (executable) {
+        *executable = nullptr;
+      }
+      return Status::OK();
+    }
+  }
+  *compilation_ref = entry;
+  return CompileEntry(options, function, num_constant_args, variable_args, ctx,
+                      inputs, entry.get(), compilation_result, executable);
+}
+
 }  // namespace tensorflow
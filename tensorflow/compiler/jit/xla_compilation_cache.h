@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include <list>
+#include <memory>
+
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -40,15 +43,41 @@ struct OptionalTensor {
 // which converts a Tensorflow graph into a compiled XLA compilation.
 //
 // Since XLA computations must have static shapes, the cache generates a new
-// XLA computation for each new set of input shapes.
+// XLA computation for each new set of input shapes. Callers with inputs of
+// varying shapes can limit the number of computations by padding the inputs
+// to a few shape buckets first (see XlaLocalLaunchOp).
 //
-// Currently no cache eviction policy is implemented and the cache grows without
-// bound.
+// If the cache has a capacity, it evicts the least recently used compilation
+// when it would hold more than `capacity` of them. Otherwise the cache grows
+// without bound.
 class XlaCompilationCache : public ResourceBase {
  public:
-  XlaCompilationCache(xla::Client* client, DeviceType device_type);
+  // `capacity` is the largest number of compilations held, or 0 for no limit.
+  XlaCompilationCache(xla::Client* client, DeviceType device_type,
+                      int64 capacity = 0);
   ~XlaCompilationCache() override;
 
+  // Keeps the results of a compilation alive while they are used, even if the
+  // compilation is evicted from the cache meanwhile.
+  typedef std::shared_ptr<const void> CompilationRef;
+
+  // Statistics of the cache since its creation.
+  struct Stats {
+    // Lookups that found the signature in the cache, and lookups that added
+    // it, i.e. compilations.
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 evictions = 0;
+    // The number of compilations in the cache.
+    int64 entries = 0;
+    // Time spent compiling and building executables.
+    int64 compile_micros = 0;
+    // The memory held by the executables in the cache, estimated as the size
+    // of the constants embedded in them since XLA does not report the size
+    // of their code.
+    int64 executable_bytes = 0;
+  };
+
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
   // to execute an XLA Computation. Compilation results are cached.
   // `function` is the name of a Tensorflow function to compile.
@@ -56,26 +85,48 @@ class XlaCompilationCache : public ResourceBase {
   // `function`. `variable_args` is a snapshot of the current values of the
   // resource variable arguments to `function`; uninitialized variables are
   // represented by an absent OptionalTensor.
+  // `inputs`, if non-null, replaces the inputs of `ctx` as the arguments to
+  // compile for, e.g. with inputs padded to a shape bucket. It must have one
+  // tensor per input of `ctx`.
   // The result of compilation is written to `*compilation_result`, which must
   // be non-null. If `executable` is non-null, also builds an
   // xla::LocalExecutable and sets `executable to point to it. The resulting
   // executable pointer may be null if the computation has no non-constant
-  // outputs.
+  // outputs. Both stay valid as long as `*compilation_ref`, which must be
+  // non-null, is held.
   Status Compile(const XlaCompiler::Options& options,
                  const NameAttrList& function, int num_constant_args,
                  const std::vector<OptionalTensor>& variable_args,
-                 OpKernelContext* ctx,
+                 OpKernelContext* ctx, const std::vector<Tensor>* inputs,
                  const XlaCompiler::CompilationResult** compilation_result,
-                 xla::LocalExecutable** executable);
+                 xla::LocalExecutable** executable,
+                 CompilationRef* compilation_ref);
+
+  // Like Compile(), but if the function is not compiled yet for the signature
+  // of the inputs of `ctx`, starts compiling it and its executable on a
+  // background thread, and returns OK with `*compilation_result` and
+  // `*executable` set to nullptr. The caller is expected to run the function
+  // by other means meanwhile. Once the background compilation is done, calls
+  // return its results as Compile() would.
+  Status CompileAsync(const XlaCompiler::Options& options,
+                      const NameAttrList& function, int num_constant_args,
+                      const std::vector<OptionalTensor>& variable_args,
+                      OpKernelContext* ctx, const std::vector<Tensor>* inputs,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable,
+                      CompilationRef* compilation_ref);
 
   xla::Client* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
+  Stats GetStats();
+
   string DebugString() override;
 
  private:
   xla::Client* const client_;
   const DeviceType device_type_;
+  const int64 capacity_;
 
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
@@ -99,7 +150,9 @@ class XlaCompilationCache : public ResourceBase {
   // Builds the signature for a compilation.
   Status BuildSignature(const NameAttrList& function, int num_constant_args,
                         const std::vector<OptionalTensor>& variable_args,
-                        OpKernelContext* ctx, Signature* signature);
+                        OpKernelContext* ctx,
+                        const std::vector<Tensor>* inputs,
+                        Signature* signature);
 
   // The value associated with a cache entry.
   struct Entry {
@@ -108,6 +161,11 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is this entry being compiled in the background? Notified on
+    // `compile_done` when the compilation is done.
+    bool compiling GUARDED_BY(mu) = false;
+    condition_variable compile_done;
+
     // Did compilation succeed?
     Status compilation_status GUARDED_BY(mu);
 
@@ -117,11 +175,46 @@ class XlaCompilationCache : public ResourceBase {
     // The XLA executable compiled from <computation>. May be null if no
     // executable has been built.
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
+
+    // The following are guarded by the mu_ of the cache.
+    // The position of the entry's signature in lru_.
+    std::list<Signature>::iterator lru_position;
+    // Was the entry evicted from the cache?
+    bool evicted = false;
+    // The estimated size of `executable`, counted in stats_ unless evicted.
+    int64 executable_bytes = 0;
   };
 
+  // Returns the cache entry for `signature`, creating it if needed, and marks
+  // it as the most recently used. May evict the least recently used entry.
+  std::shared_ptr<Entry> LookupEntry(const Signature& signature,
+                                     const string& function_name);
+
+  // Records `micros` spent compiling `entry`, which has built `executable`
+  // unless it is null.
+  void RecordCompilation(Entry* entry, const string& function_name,
+                         int64 micros, const xla::LocalExecutable* executable);
+
+  // The part of Compile() that follows the lookup of `entry`.
+  Status CompileEntry(const XlaCompiler::Options& options,
+                      const NameAttrList& function, int num_constant_args,
+                      const std::vector<OptionalTensor>& variable_args,
+                      OpKernelContext* ctx, const std::vector<Tensor>* inputs,
+                      Entry* entry,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable);
+
+  // Lock order: the mu of an entry, then mu_.
   mutex mu_;
-  std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
+  std::unordered_map<Signature, std::shared_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
+  // The signatures of cache_, from the most to the least recently used.
+  std::list<Signature> lru_ GUARDED_BY(mu_);
+  Stats stats_ GUARDED_BY(mu_);
+
+  // Runs the background compilations of CompileAsync(). Created by its first
+  // call, and destroyed first so that the destructor waits for them.
+  std::unique_ptr<thread::ThreadPool> compile_threads_ GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import time
+
 import numpy as np
 
 from tensorflow.contrib.compiler import jit
@@ -341,6 +343,25 @@ class XlaCompilationTest(test.TestCase):
       self.assert_(MetadataHasXlaLaunch(run_metadata))
       self.assertAllClose(result, np.float32(95), rtol=1e-1)
 
+  def testAsyncCompilation(self):
+    """Tests that clusters run while they compile in the background."""
+
+    cfg = config_pb2.ConfigProto(graph_options=config_pb2.GraphOptions(
+        optimizer_options=config_pb2.OptimizerOptions(
+            jit_async_compilation=True)))
+    with self.test_session(config=cfg) as sess:
+      x = array_ops.placeholder(dtypes.float32)
+      with jit_scope():
+        y = math_ops.tanh(x * 2.0 + 1.0)
+      # Each new shape runs the uncompiled function at first, and the
+      # compiled one once it is ready.
+      for shape in [(3,), (2, 5), (3,)]:
+        value = np.random.rand(*shape).astype(np.float32)
+        for _ in range(20):
+          out = sess.run(y, {x: value})
+          self.assertAllClose(np.tanh(value * 2.0 + 1.0), out)
+          time.sleep(0.05)
+
   def testCond(self):
     """Tests that compilation handles switch operators."""
 
@@ -42,11 +42,13 @@ struct DebugOptionsFlags {
   string xla_dump_ir_to;
   string xla_dump_debug_json_to;
   bool xla_eliminate_hlo_implicit_broadcast;
+  string xla_persistent_cache_dir;
 
   bool xla_cpu_multi_thread_eigen;
 
   string xla_gpu_cuda_data_dir;
   bool xla_gpu_ftz;
+  int64 xla_gpu_memory_limit_bytes;
 
   string xla_backend_extra_options;
 };
@@ -78,9 +80,11 @@ void AllocateFlags() {
   flag_values->xla_dump_ir_to = "";
   flag_values->xla_dump_debug_json_to = "";
   flag_values->xla_eliminate_hlo_implicit_broadcast = false;
+  flag_values->xla_persistent_cache_dir = "";
   flag_values->xla_cpu_multi_thread_eigen = true;
   flag_values->xla_gpu_cuda_data_dir = "./cuda_sdk_lib";
   flag_values->xla_gpu_ftz = false;
+  flag_values->xla_gpu_memory_limit_bytes = 0;
   flag_values->xla_backend_extra_options = "";
 
   flag_objects = new std::vector<tensorflow::Flag>(
@@ -144,6 +148,10 @@ void AllocateFlags() {
                         "Eliminate implicit broadcasts when lowering user "
                         "computations to HLO instructions; use explicit "
                         "broadcast instead."),
+       tensorflow::Flag("xla_persistent_cache_dir",
+                        &flag_values->xla_persistent_cache_dir,
+                        "If non-empty, store compiled object files and PTX in "
+                        "this directory and reuse them across processes."),
        tensorflow::Flag("xla_cpu_multi_thread_eigen",
                         &flag_values->xla_cpu_multi_thread_eigen,
                         "When generating calls to Eigen in the CPU backend, "
@@ -156,6 +164,11 @@ void AllocateFlags() {
        tensorflow::Flag("xla_gpu_ftz", &flag_values->xla_gpu_ftz,
                         "If true, flush-to-zero semantics are enabled in the "
                         "code generated for GPUs."),
+       tensorflow::Flag("xla_gpu_memory_limit_bytes",
+                        &flag_values->xla_gpu_memory_limit_bytes,
+                        "If positive, rematerialize and schedule HLO "
+                        "instructions in the GPU backend to keep peak device "
+                        "memory use below this many bytes."),
        tensorflow::Flag(
            "xla_dump_debug_json_to", &flag_values->xla_dump_debug_json_to,
            "Dump compilation artifacts as JSON into this directory."),
@@ -201,11 +214,14 @@ xla::DebugOptions GetDebugOptionsFromFlags() {
   options.set_xla_dump_ir_to(flag_values->xla_dump_ir_to);
   options.set_xla_eliminate_hlo_implicit_broadcast(
       flag_values->xla_eliminate_hlo_implicit_broadcast);
+  options.set_xla_persistent_cache_dir(flag_values->xla_persistent_cache_dir);
   options.set_xla_dump_debug_json_to(flag_values->xla_dump_debug_json_to);
   options.set_xla_cpu_multi_thread_eigen(
       flag_values->xla_cpu_multi_thread_eigen);
   options.set_xla_gpu_cuda_data_dir(flag_values->xla_gpu_cuda_data_dir);
   options.set_xla_gpu_ftz(flag_values->xla_gpu_ftz);
+  options.set_xla_gpu_memory_limit_bytes(
+      flag_values->xla_gpu_memory_limit_bytes);
   options.set_xla_llvm_enable_alias_scope_metadata(
       flag_values->xla_llvm_enable_alias_scope_metadata);
   options.set_xla_llvm_enable_noalias_metadata(
@@ -377,7 +377,8 @@ Status BufferAssignment::ComputeSummaryStats() {
     stats_.total_allocation_bytes += allocation.size();
   }
 
-  // Only compute total fragmentation if all computations are sequential.
+  // Only compute peak memory and total fragmentation if all computations are
+  // sequential.
   SequentialHloOrdering::HloModuleSequence module_sequence;
   for (const auto& computation : module_->computations()) {
     const std::vector<const HloInstruction*>* sequence =
@@ -390,6 +391,7 @@ Status BufferAssignment::ComputeSummaryStats() {
     TF_ASSIGN_OR_RETURN(
         const int64 min_size,
         MinimumMemoryForSequence(module_sequence, buffer_size_));
+    stats_.peak_memory_bytes = min_size;
     stats_.total_fragmentation_bytes = stats_.total_allocation_bytes - min_size;
   }
 
@@ -421,6 +423,10 @@ string BufferAssignment::Stats::ToString() const {
     Appendf(&s, "              total fragmentation: %10s (%.2f%%)\n",
             HumanReadableNumBytes(total_fragmentation_bytes).c_str(), percent);
   }
+  if (peak_memory_bytes >= 0) {
+    Appendf(&s, "                      peak memory: %10s\n",
+            HumanReadableNumBytes(peak_memory_bytes).c_str());
+  }
   return s;
 }
 
@@ -331,8 +331,8 @@ class BufferAssignment {
   BufferAssignmentProto ToProto() const;
 
   // Statistics for the assignment.  Values initialized to -1 are not always
-  // collected; fragmentation is only collected for instructions that have a
-  // sequential total ordering.
+  // collected; fragmentation and peak memory are only collected for modules
+  // whose computations all have a sequential total ordering.
   struct Stats {
     int64 parameter_allocation_count = 0;
     int64 parameter_allocation_bytes = 0;
@@ -344,6 +344,9 @@ class BufferAssignment {
     int64 total_allocation_count = 0;
     int64 total_allocation_bytes = 0;
     int64 total_fragmentation_bytes = -1;
+    // The most bytes live at once over the whole module, i.e. the total
+    // allocation an assignment without fragmentation would need.
+    int64 peak_memory_bytes = -1;
 
     string ToString() const;
   };
@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/copy_insertion.h"
 
 #include <memory>
+#include <vector>
 
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_ordering.h"
 #include "tensorflow/compiler/xla/service/liveness_util.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
 #include "tensorflow/compiler/xla/service/tuple_points_to_analysis.h"
@@ -105,6 +107,15 @@ class InstructionCopier {
       const BufferLiveness& liveness, const HloInstruction* other_instruction,
       ShapeTree<bool>* read_only_indices_out);
 
+  // Clears recorded indices of a while body root at which the copy can be
+  // elided, because the body updates the loop state in place: the root buffer
+  // at the index can share the buffer of 'parameter' at the same index if all
+  // other readers of the parameter buffer run before the update. Adds control
+  // dependencies from those readers to the update. Returns true if any copy
+  // was elided.
+  StatusOr<bool> ElideCopiesOfInPlaceUpdates(const BufferLiveness& liveness,
+                                             HloInstruction* parameter);
+
   // Records control predecessors to add for inserted copy instructions.
   // 'parameter' must have the same shape as the instruction that will be
   // copied, and must define all buffers in the shape. Control predecessors are
@@ -331,6 +342,147 @@ Status InstructionCopier::RecordIndicesWhichInterfereWithOtherInstruction(
   return Status::OK();
 }
 
+// Returns true if 'target' is 'instruction' or one of its transitive operands
+// or control predecessors.
+bool DependsOn(const HloInstruction* instruction,
+               const HloInstruction* target) {
+  std::vector<const HloInstruction*> worklist = {instruction};
+  FlatSet<const HloInstruction*> visited;
+  while (!worklist.empty()) {
+    const HloInstruction* hlo = worklist.back();
+    worklist.pop_back();
+    if (hlo == target) {
+      return true;
+    }
+    if (!visited.insert(hlo).second) {
+      continue;
+    }
+    for (const HloInstruction* operand : hlo->operands()) {
+      worklist.push_back(operand);
+    }
+    for (const HloInstruction* predecessor : hlo->control_predecessors()) {
+      worklist.push_back(predecessor);
+    }
+  }
+  return false;
+}
+
+// Returns true if 'update' can overwrite the buffer of 'state' once the users
+// of 'state' aliases that are not already ordered before 'update' run first,
+// and appends those users to 'readers'. Returns false if 'state' is live out
+// of the computation, or if 'update' reads 'state' in a way that does not
+// allow sharing its buffer.
+bool FindReadersToOrderBefore(const BufferLiveness& liveness,
+                              const LogicalBuffer& state,
+                              const LogicalBuffer& update,
+                              std::vector<HloInstruction*>* readers) {
+  const HloOrdering& ordering = liveness.hlo_ordering();
+  const auto& points_to_analysis = liveness.points_to_analysis();
+  HloInstruction* update_instruction = update.instruction();
+  if (!ordering.ExecutesBefore(state.instruction(), update_instruction)) {
+    return false;
+  }
+  for (const BufferAlias& alias : points_to_analysis.GetBufferAliases(state)) {
+    HloInstruction* alias_instruction = alias.instruction();
+    if (alias_instruction == update_instruction->parent()->root_instruction()) {
+      return false;
+    }
+    for (HloInstruction* user : alias_instruction->users()) {
+      if (DoesNotUseOperandBuffer(alias_instruction, alias.index(), user,
+                                  points_to_analysis)) {
+        continue;
+      }
+      if (user == update_instruction) {
+        if (!CanShareOperandBufferWithUser(alias_instruction, alias.index(),
+                                           user, update.index(),
+                                           &points_to_analysis)) {
+          return false;
+        }
+        continue;
+      }
+      if (!ordering.ExecutesBefore(user, update_instruction)) {
+        readers->push_back(user);
+      }
+    }
+  }
+  return true;
+}
+
+// This is called when 'instruction_' is a while body root, and 'parameter' is
+// the while body parameter. A copy of the root is only needed to keep the new
+// loop state from overwriting the old one while it is still read. When the
+// new state of an element is an instruction that can write into the old
+// state buffer, ordering the remaining readers of the old state before it
+// makes the copy unnecessary, which saves both the copy and the memory of a
+// second loop state buffer.
+StatusOr<bool> InstructionCopier::ElideCopiesOfInPlaceUpdates(
+    const BufferLiveness& liveness, HloInstruction* parameter) {
+  const auto& points_to_analysis = liveness.points_to_analysis();
+  const PointsToSet& points_to =
+      points_to_analysis.GetPointsToSet(instruction_);
+  // Number of root indices at which each buffer appears.
+  FlatMap<const LogicalBuffer*, int64> buffer_counts;
+  points_to.ForEachElement(
+      [&buffer_counts](const ShapeIndex& /*index*/,
+                       const std::vector<const LogicalBuffer*>& buffers) {
+        for (const LogicalBuffer* buffer : buffers) {
+          ++buffer_counts[buffer];
+        }
+      });
+
+  bool elided = false;
+  TF_RETURN_IF_ERROR(indices_to_copy_.ForEachMutableElementWithStatus(
+      [this, &liveness, &points_to_analysis, &points_to, &buffer_counts,
+       parameter, &elided](const ShapeIndex& index, bool* will_copy) {
+        if (!*will_copy ||
+            ShapeUtil::IsTuple(
+                ShapeUtil::GetSubshape(instruction_->shape(), index))) {
+          return Status::OK();
+        }
+        // The update must be the only buffer at 'index', and must not appear
+        // at any other index of the root.
+        const std::vector<const LogicalBuffer*>& buffers =
+            points_to.element(index);
+        if (buffers.size() != 1 || buffer_counts[buffers[0]] != 1) {
+          return Status::OK();
+        }
+        const LogicalBuffer* update = buffers[0];
+        HloInstruction* update_instruction = update->instruction();
+        if (update_instruction->parent() != parameter->parent() ||
+            update_instruction->opcode() == HloOpcode::kParameter ||
+            update_instruction->opcode() == HloOpcode::kConstant) {
+          return Status::OK();
+        }
+        TF_ASSIGN_OR_RETURN(
+            const LogicalBuffer* state,
+            points_to_analysis.GetBufferDefinedAt(parameter, index));
+        std::vector<HloInstruction*> readers;
+        if (!FindReadersToOrderBefore(liveness, *state, *update, &readers)) {
+          return Status::OK();
+        }
+        // A reader that depends on the update can't run before it.
+        for (const HloInstruction* reader : readers) {
+          if (DependsOn(reader, update_instruction)) {
+            return Status::OK();
+          }
+        }
+        for (HloInstruction* reader : readers) {
+          VLOG(2) << "Adding control dependency from " << reader->name()
+                  << " to in-place update " << update_instruction->name();
+          TF_RETURN_IF_ERROR(
+              reader->AddControlDependencyTo(update_instruction));
+        }
+        VLOG(2) << "Eliding copy of buffer for instruction: "
+                << instruction_->name()
+                << " at index: " << tensorflow::str_util::Join(index, ",")
+                << " updated in place by " << update_instruction->name();
+        *will_copy = false;
+        elided = true;
+        return Status::OK();
+      }));
+  return elided;
+}
+
 // This is called when 'instruction_' is a while body root, and 'parameter' is
 // the while body parameter. We record all users of all aliases of 'parameter'
 // as control predecessors, so that when we add a copy of 'instruction_', we can
@@ -566,6 +718,13 @@ StatusOr<bool> CopyInsertion::Run(HloModule* module) {
           *liveness, while_body_param, &read_only_indices));
       while_body_read_only_indices[computation.get()] = read_only_indices;
 
+      // Elide copies of loop state updated in place, by ordering the readers
+      // of the old state before the update instead.
+      TF_ASSIGN_OR_RETURN(
+          const bool elided,
+          root_copier.ElideCopiesOfInPlaceUpdates(*liveness, while_body_param));
+      changed |= elided;
+
       // Mark control predecessors, based on the body param, for any copies
       // we'll be inserting. This ensures the copy doesn't run too early.
       TF_RETURN_IF_ERROR(root_copier.RecordControlPredecessors(
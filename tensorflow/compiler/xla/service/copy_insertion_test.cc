@@ -396,6 +396,38 @@ class WhileCopyInsertionTest : public CopyInsertionTest {
     return builder.Build();
   }
 
+  // Builds a While body computation which reads input tuple element 0 after
+  // computing its update.
+  // EX:
+  // Body({in0, in1})
+  //   out0 = Add(in0, 1)
+  //   out1 = Add(BCast(Multiply(in0, out0)), in1)
+  //   Tuple(out0, out1)
+  std::unique_ptr<HloComputation>
+  BuildDependentBodyReadAfterUpdateComputation() {
+    auto builder = HloComputation::Builder(TestName() + ".Body");
+    auto loop_state = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, loop_state_shape_, "loop_state"));
+    auto induction_variable =
+        builder.AddInstruction(HloInstruction::CreateGetTupleElement(
+            induction_variable_shape_, loop_state, 0));
+    auto inc = builder.AddInstruction(
+        HloInstruction::CreateConstant(Literal::CreateR0<int32>(1)));
+    auto add0 = builder.AddInstruction(HloInstruction::CreateBinary(
+        induction_variable->shape(), HloOpcode::kAdd, induction_variable, inc));
+    auto data = builder.AddInstruction(
+        HloInstruction::CreateGetTupleElement(data_shape_, loop_state, 1));
+    auto mul = builder.AddInstruction(HloInstruction::CreateBinary(
+        induction_variable->shape(), HloOpcode::kMultiply, induction_variable,
+        add0));
+    auto update = builder.AddInstruction(
+        HloInstruction::CreateBroadcast(data_shape_, mul, {8}));
+    auto add1 = builder.AddInstruction(HloInstruction::CreateBinary(
+        data_shape_, HloOpcode::kAdd, data, update));
+    builder.AddInstruction(HloInstruction::CreateTuple({add0, add1}));
+    return builder.Build();
+  }
+
   // Builds a While body computation with two output tuple elements dependent on
   // both input tuple elements.
   //
@@ -732,9 +764,10 @@ TEST_F(WhileCopyInsertionTest, IndependentTupleElements) {
 //     out1 = Add(BCast(in0), in1)
 //     Tuple(out0, out1)
 //
-// CopyInsertion pass should convert the root instruction to:
+// CopyInsertion pass should not copy out0, which can update in0 in place once
+// BCast(in0) is ordered before it:
 //
-//     Tuple(Copy(out0), out1)
+//     BCast(in0) -> control -> out0
 //
 TEST_F(WhileCopyInsertionTest, DependentTupleElements) {
   auto condition = module_->AddEmbeddedComputation(BuildConditionComputation());
@@ -747,12 +780,39 @@ TEST_F(WhileCopyInsertionTest, DependentTupleElements) {
   HloInstruction* new_root = body->root_instruction();
   const HloInstruction* new_init = while_hlo->operand(0);
 
-  EXPECT_THAT(new_root,
-              op::Tuple(op::Copy(old_root->operand(0)), old_root->operand(1)));
+  EXPECT_EQ(old_root, new_root);
+  HloInstruction* add0 = old_root->mutable_operand(0);
+  HloInstruction* bcast = old_root->mutable_operand(1)->mutable_operand(1);
+  EXPECT_THAT(add0->control_predecessors(), UnorderedElementsAre(bcast));
   EXPECT_THAT(new_init, op::Tuple(op::Copy(old_init->operand(0)),
                                   op::Copy(old_init->operand(1))));
 }
 
+// Tests while body computation where in0 is read after its update:
+//
+//   While.Body({in0, in1})
+//     out0 = Add(in0, 1)
+//     out1 = Add(BCast(Multiply(in0, out0)), in1)
+//     Tuple(out0, out1)
+//
+// The read of in0 depends on out0, so it can't be ordered before it, and
+// CopyInsertion pass should convert the root instruction to:
+//
+//     Tuple(Copy(out0), out1)
+//
+TEST_F(WhileCopyInsertionTest, DependentTupleElements_ReadAfterUpdate) {
+  auto condition = module_->AddEmbeddedComputation(BuildConditionComputation());
+  auto body = module_->AddEmbeddedComputation(
+      BuildDependentBodyReadAfterUpdateComputation());
+  BuildWhileInstruction(condition, body);
+
+  HloInstruction* old_root = body->root_instruction();
+  InsertCopies(module_.get());
+
+  EXPECT_THAT(body->root_instruction(),
+              op::Tuple(op::Copy(old_root->operand(0)), old_root->operand(1)));
+}
+
 // Tests while body computation with read-only tuple element 0:
 //
 //                         PARAMETER
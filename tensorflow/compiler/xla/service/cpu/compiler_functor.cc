@@ -30,6 +30,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/Verifier.h"
 #include "external/llvm/include/llvm/MC/MCContext.h"
 #include "external/llvm/include/llvm/Object/ObjectFile.h"
+#include "external/llvm/include/llvm/Support/MemoryBuffer.h"
 #include "external/llvm/include/llvm/Support/raw_ostream.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "external/llvm/include/llvm/Transforms/IPO.h"
@@ -43,6 +44,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -68,6 +70,25 @@ operator()(llvm::Module& module) const {
     TF_CHECK_OK(pre_optimization_callback_(module));
   }
 
+  string persistent_cache_key;
+  if (persistent_cache_ != nullptr) {
+    persistent_cache_key = PersistentCacheKey(module);
+    string object_code;
+    if (persistent_cache_->Lookup(persistent_cache_key, &object_code)) {
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+          llvm::MemoryBuffer::getMemBufferCopy(object_code);
+      llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>>
+          object_file_or_error = llvm::object::ObjectFile::createObjectFile(
+              memory_buffer->getMemBufferRef());
+      if (object_file_or_error) {
+        return MakeObjectFile(std::move(memory_buffer));
+      }
+      llvm::consumeError(object_file_or_error.takeError());
+      LOG(WARNING) << "Ignoring an invalid object file in the persistent "
+                      "compilation cache.";
+    }
+  }
+
   // Build up optimization pipeline.
   AddOptimizationPasses(&module_passes, &function_passes);
 
@@ -101,9 +122,32 @@ operator()(llvm::Module& module) const {
   target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
+  if (persistent_cache_ != nullptr) {
+    persistent_cache_->Insert(
+        persistent_cache_key,
+        string(stream_buffer.data(), stream_buffer.size()));
+  }
+
   // Construct ObjectFile from machine code buffer.
-  std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
-      new llvm::ObjectMemoryBuffer(std::move(stream_buffer)));
+  return MakeObjectFile(std::unique_ptr<llvm::MemoryBuffer>(
+      new llvm::ObjectMemoryBuffer(std::move(stream_buffer))));
+}
+
+string CompilerFunctor::PersistentCacheKey(const llvm::Module& module) const {
+  return tensorflow::strings::StrCat(
+      persistent_cache_options_key_,
+      ";triple=", target_machine_->getTargetTriple().str(),
+      ";cpu=", target_machine_->getTargetCPU().str(),
+      ";features=", target_machine_->getTargetFeatureString().str(),
+      ";codegen_opt_level=", opt_level_,
+      ";sse=", available_intrinsics_.sse_intrinsics,
+      ";avx=", available_intrinsics_.avx_intrinsics, "\n",
+      llvm_ir::DumpModuleToString(module));
+}
+
+llvm::object::OwningBinary<llvm::object::ObjectFile>
+CompilerFunctor::MakeObjectFile(
+    std::unique_ptr<llvm::MemoryBuffer> memory_buffer) const {
   llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>>
       object_file_or_error = llvm::object::ObjectFile::createObjectFile(
           memory_buffer->getMemBufferRef());
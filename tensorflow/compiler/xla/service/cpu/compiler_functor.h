@@ -16,11 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 
+#include <memory>
+
 #include "external/llvm/include/llvm/IR/LegacyPassManager.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/Object/ObjectFile.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
+#include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -44,17 +48,26 @@ class CompilerFunctor {
   // statistics.
   using OptimizationCallback = std::function<Status(const llvm::Module&)>;
 
+  // If `persistent_cache` is non-null, object files are looked up in and added
+  // to it, keyed by the unoptimized module, the target machine and
+  // `persistent_cache_options_key`. The optimization callbacks are not run for
+  // modules found in the cache.
   explicit CompilerFunctor(
       llvm::TargetMachine* target_machine, const Disassembler* disassembler,
       int opt_level, const VectorIntrinsics& available_intrinsics,
       OptimizationCallback pre_optimization_callback = nullptr,
-      OptimizationCallback post_optimization_callback = nullptr)
+      OptimizationCallback post_optimization_callback = nullptr,
+      std::shared_ptr<const PersistentCompilationCache> persistent_cache =
+          nullptr,
+      const string& persistent_cache_options_key = "")
       : target_machine_(target_machine),
         disassembler_(CHECK_NOTNULL(disassembler)),
         opt_level_(opt_level),
         available_intrinsics_(available_intrinsics),
         pre_optimization_callback_(pre_optimization_callback),
-        post_optimization_callback_(post_optimization_callback) {}
+        post_optimization_callback_(post_optimization_callback),
+        persistent_cache_(std::move(persistent_cache)),
+        persistent_cache_options_key_(persistent_cache_options_key) {}
 
   // Compile a Module to an ObjectFile.
   llvm::object::OwningBinary<llvm::object::ObjectFile> operator()(
@@ -66,12 +79,21 @@ class CompilerFunctor {
       llvm::legacy::PassManagerBase* module_passes,
       llvm::legacy::FunctionPassManager* function_passes) const;
 
+  // Returns the key of `module` in the persistent cache.
+  string PersistentCacheKey(const llvm::Module& module) const;
+
+  // Wraps the machine code in `memory_buffer` in an ObjectFile.
+  llvm::object::OwningBinary<llvm::object::ObjectFile> MakeObjectFile(
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer) const;
+
   llvm::TargetMachine* target_machine_;
   const Disassembler* disassembler_;
   const unsigned opt_level_;
   const VectorIntrinsics available_intrinsics_;
   OptimizationCallback pre_optimization_callback_;
   OptimizationCallback post_optimization_callback_;
+  const std::shared_ptr<const PersistentCompilationCache> persistent_cache_;
+  const string persistent_cache_options_key_;
 };
 
 }  // namespace cpu
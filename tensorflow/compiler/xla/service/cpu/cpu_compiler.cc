@@ -55,6 +55,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
@@ -74,6 +75,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/inliner.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -244,9 +246,18 @@ class CollectProfileCandidates : public DfsHloVisitorWithDefault {
 
   std::unordered_map<const HloInstruction*, size_t>* hlo_to_profile_idx_;
 };
+
+// Returns the maximum parallelism of the intra-op thread pool the module will
+// run with when compiled just in time.
+int64 JitMaxParallelism(const HloModuleConfig& config) {
+  return config.intra_op_parallelism_threads() > 0
+             ? config.intra_op_parallelism_threads()
+             : tensorflow::port::NumSchedulableCPUs();
+}
+
 }  // namespace
 
-Status CpuCompiler::RunHloPasses(HloModule* module) {
+Status CpuCompiler::RunHloPasses(HloModule* module, int64 max_parallel_tasks) {
   // Optimization pipeline.
   HloPassPipeline pipeline("CPU");
   pipeline.AddInvariantChecker<HloVerifier>();
@@ -286,10 +297,7 @@ Status CpuCompiler::RunHloPasses(HloModule* module) {
       /*enable_dot_simplification=*/false);
   pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/true);
   // Outline ops in the entry computation into calls to subcomputations.
-  const int max_parallelism =
-      module->config().intra_op_parallelism_threads() > 0
-          ? module->config().intra_op_parallelism_threads()
-          : tensorflow::port::NumSchedulableCPUs();
+  const int max_parallelism = JitMaxParallelism(module->config());
   if (CpuParallelBackendRequested(module->config())) {
     pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
                                                  ShapeSizeBytesFunction());
@@ -307,6 +315,13 @@ Status CpuCompiler::RunHloPasses(HloModule* module) {
     // computation.
     pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
                                                  ShapeSizeBytesFunction());
+  } else if (module->config().debug_options().xla_cpu_multi_thread_eigen() &&
+             max_parallel_tasks > 1) {
+    // Outline large parallelizable ops into calls whose outer-dimension
+    // partitions are dispatched to the intra-op thread pool by the sequential
+    // backend.
+    pipeline.AddPass<ParallelTaskAssigner>(max_parallel_tasks,
+                                           ShapeSizeBytesFunction());
   }
   pipeline.AddPass<HloDCE>();
   pipeline.AddPass<FlattenCallGraph>();
@@ -377,13 +392,17 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
   auto llvm_context = MakeUnique<llvm::LLVMContext>();
   auto llvm_module =
       MakeUnique<llvm::Module>("__compute_module", *llvm_context);
-  auto jit = MakeUnique<SimpleOrcJIT>(CompilerTargetOptions(module->config()),
-                                      CodeGenOptLevel(module->config()),
-                                      dump_ir_to_disk, dump_ir_to_disk);
+  const DebugOptions& debug_options = module->config().debug_options();
+  auto jit = MakeUnique<SimpleOrcJIT>(
+      CompilerTargetOptions(module->config()),
+      CodeGenOptLevel(module->config()), dump_ir_to_disk, dump_ir_to_disk,
+      PersistentCompilationCache::Create(debug_options),
+      PersistentCompilationCache::OptionsKey(debug_options));
   llvm_module->setDataLayout(jit->data_layout());
   llvm_module->setTargetTriple(jit->target_triple().getTriple());
 
-  TF_RETURN_IF_ERROR(RunHloPasses(module.get()));
+  TF_RETURN_IF_ERROR(
+      RunHloPasses(module.get(), JitMaxParallelism(module->config())));
 
   HloComputation* computation = module->entry_computation();
   std::unordered_map<const HloInstruction*, size_t> hlo_to_profile_idx;
@@ -669,7 +688,7 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
 
-    TF_RETURN_IF_ERROR(RunHloPasses(module));
+    TF_RETURN_IF_ERROR(RunHloPasses(module, options.max_parallelism()));
 
     TF_ASSIGN_OR_RETURN(
         SequentialHloOrdering::HloModuleSequence module_sequence,
@@ -66,12 +66,22 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // The maximum number of parallel tasks that large instructions are split
+  // into. The partitions are dispatched to the intra-op thread pool passed in
+  // the ExecutableRunOptions at run time, or run in sequence if there is none.
+  // Defaults to 1, i.e. no partitioning.
+  int64 max_parallelism() const { return max_parallelism_; }
+  void set_max_parallelism(int64 max_parallelism) {
+    max_parallelism_ = max_parallelism;
+  }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int64 max_parallelism_ = 1;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
@@ -130,8 +140,10 @@ class CpuCompiler : public Compiler {
   static void InitializeLLVMTarget();
 
   // Runs the HLO passes which are necessary for both optimizations and
-  // correctness.
-  Status RunHloPasses(HloModule* module);
+  // correctness. 'max_parallel_tasks' is the maximum number of partitions each
+  // instruction in the entry computation may be split into in the sequential
+  // backend; values <= 1 disable the partitioning.
+  Status RunHloPasses(HloModule* module, int64 max_parallel_tasks);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
@@ -19,9 +19,11 @@ limitations under the License.
 #include <vector>
 
 #include "external/llvm/include/llvm/IR/BasicBlock.h"
+#include "external/llvm/include/llvm/IR/DerivedTypes.h"
 #include "external/llvm/include/llvm/IR/Instructions.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -38,6 +41,26 @@ using llvm_ir::SetToFirstInsertPoint;
 
 namespace cpu {
 
+namespace {
+
+// Size in bytes of the vectors the tiled matrix multiply operates on: the
+// width of an AVX/AVX2 register. LLVM splits the vector operations on targets
+// with narrower registers.
+constexpr int64 kTiledGemmVectorBytes = 32;
+
+// Number of output rows and of output vectors per row in a register tile. The
+// accumulators of a 4 x 2 tile plus the RHS vectors and the broadcasted LHS
+// element fit in the 16 vector registers of x86-64.
+constexpr int64 kTiledGemmTileRows = 4;
+constexpr int64 kTiledGemmTileVectors = 2;
+
+// Largest matrix multiply (in multiply-adds) emitted as tiled loops when the
+// Eigen runtime could be called instead. Beyond this size the packing, cache
+// blocking and multi-threading of Eigen outweigh the cost of the call.
+constexpr int64 kTiledGemmMaxMultiplyAdds = 128 * 128 * 128;
+
+}  // namespace
+
 DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            bool transpose_rhs,
                            const llvm_ir::IrArray& target_array,
@@ -105,6 +128,10 @@ tensorflow::Status DotOpEmitter::Emit() {
     return EmitScalarDot();
   }
 
+  if (ShouldEmitTiledGemm()) {
+    return EmitTiledGemm();
+  }
+
   if (PotentiallyImplementedAsEigenDot(dot_)) {
     return EmitCallToRuntime();
   }
@@ -214,6 +241,239 @@ tensorflow::Status DotOpEmitter::Emit() {
   return tensorflow::Status::OK();
 }
 
+DotOpEmitter::RowMajorGemm DotOpEmitter::GetRowMajorGemm() const {
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const Shape& rhs_shape = rhs_array_.GetShape();
+  RowMajorGemm gemm;
+  gemm.a = &lhs_array_;
+  gemm.b = &rhs_array_;
+  gemm.transpose_a = transpose_lhs_;
+  gemm.transpose_b = transpose_rhs_;
+  gemm.m = lhs_shape.dimensions(transpose_lhs_ ? 1 : 0);
+  gemm.k = lhs_shape.dimensions(transpose_lhs_ ? 0 : 1);
+  gemm.n = rhs_shape.dimensions(transpose_rhs_ ? 0 : 1);
+
+  // Column-major storage of C is row-major storage of C^T = B^T x A^T.
+  bool is_column_major = lhs_shape.layout().minor_to_major(0) == 0;
+  if (is_column_major) {
+    std::swap(gemm.m, gemm.n);
+    std::swap(gemm.a, gemm.b);
+    std::swap(gemm.transpose_a, gemm.transpose_b);
+  }
+  return gemm;
+}
+
+bool DotOpEmitter::ShouldEmitTiledGemm() const {
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const Shape& rhs_shape = rhs_array_.GetShape();
+  const Shape& target_shape = target_array_.GetShape();
+  // The tiled emitter handles unpadded matrices which all have the same
+  // layout.
+  for (const Shape* shape : {&lhs_shape, &rhs_shape, &target_shape}) {
+    if (ShapeUtil::Rank(*shape) != 2 || LayoutUtil::IsPadded(*shape) ||
+        ShapeUtil::HasZeroElements(*shape) ||
+        !LayoutUtil::Equal(shape->layout(), target_shape.layout())) {
+      return false;
+    }
+  }
+
+  // Rows of B and C are loaded and stored as vectors, so B must not be
+  // transposed in the row-major frame, and rows must span a whole tile.
+  const RowMajorGemm gemm = GetRowMajorGemm();
+  const int64 vector_size =
+      kTiledGemmVectorBytes /
+      ShapeUtil::ByteSizeOfPrimitiveType(target_shape.element_type());
+  if (gemm.transpose_b || gemm.n < vector_size * kTiledGemmTileVectors) {
+    return false;
+  }
+
+  // Leave large matrix multiplies to Eigen, when it can handle them.
+  return !PotentiallyImplementedAsEigenDot(dot_) ||
+         gemm.m * gemm.n * gemm.k <= kTiledGemmMaxMultiplyAdds;
+}
+
+llvm::Value* DotOpEmitter::EmitMatrixElementAddress(
+    const llvm_ir::IrArray& array, bool transposed, int64 num_rows,
+    int64 num_cols, llvm::Value* row, llvm::Value* col) {
+  llvm::Value* linear_index =
+      transposed ? ir_builder_->CreateAdd(
+                       ir_builder_->CreateMul(col,
+                                              ir_builder_->getInt64(num_rows)),
+                       row)
+                 : ir_builder_->CreateAdd(
+                       ir_builder_->CreateMul(row,
+                                              ir_builder_->getInt64(num_cols)),
+                       col);
+  llvm::Value* base_pointer = ir_builder_->CreateBitCast(
+      array.GetBasePointer(), array.GetElementLlvmType()->getPointerTo());
+  return ir_builder_->CreateInBoundsGEP(base_pointer, {linear_index});
+}
+
+tensorflow::Status DotOpEmitter::EmitTiledGemm() {
+  const RowMajorGemm gemm = GetRowMajorGemm();
+  llvm::Type* element_type = target_array_.GetElementLlvmType();
+  const int64 element_bytes = ShapeUtil::ByteSizeOfPrimitiveType(
+      target_array_.GetShape().element_type());
+  const int64 vector_size = kTiledGemmVectorBytes / element_bytes;
+  llvm::Type* vector_type = llvm::VectorType::get(element_type, vector_size);
+  llvm::Type* vector_pointer_type = vector_type->getPointerTo();
+
+  // Output rows and columns covered by whole tiles.
+  const int64 tile_cols = vector_size * kTiledGemmTileVectors;
+  const int64 tiled_rows = gemm.m - gemm.m % kTiledGemmTileRows;
+  const int64 tiled_cols = gemm.n - gemm.n % tile_cols;
+  VLOG(2) << "Emitting tiled gemm with m=" << gemm.m << " n=" << gemm.n
+          << " k=" << gemm.k << " for " << dot_.ToString();
+
+  // One accumulator per vector of the tile, promoted to registers by SROA.
+  std::vector<llvm::Value*> accumulators;
+  for (int64 i = 0; i < kTiledGemmTileRows * kTiledGemmTileVectors; ++i) {
+    accumulators.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        vector_type, tensorflow::strings::StrCat("tile_accum_", i),
+        ir_builder_, kTiledGemmVectorBytes));
+  }
+
+  if (tiled_rows > 0) {
+    // Column panels of the output, of width 'tile_cols'.
+    std::unique_ptr<llvm_ir::ForLoop> col_loop = llvm_ir::ForLoop::EmitForLoop(
+        "tile_col", ir_builder_->getInt64(0), ir_builder_->getInt64(tiled_cols),
+        ir_builder_->getInt64(tile_cols), ir_builder_);
+    SetToFirstInsertPoint(col_loop->GetBodyBasicBlock(), ir_builder_);
+    llvm::Value* col = col_loop->GetIndVarValue();
+
+    // Tiles of 'kTiledGemmTileRows' rows within the panel.
+    std::unique_ptr<llvm_ir::ForLoop> row_loop = llvm_ir::ForLoop::EmitForLoop(
+        "tile_row", ir_builder_->getInt64(0), ir_builder_->getInt64(tiled_rows),
+        ir_builder_->getInt64(kTiledGemmTileRows), ir_builder_);
+    SetToFirstInsertPoint(row_loop->GetBodyBasicBlock(), ir_builder_);
+    llvm::Value* row = row_loop->GetIndVarValue();
+
+    for (llvm::Value* accumulator : accumulators) {
+      ir_builder_->CreateStore(llvm::ConstantFP::get(vector_type, 0.0),
+                               accumulator);
+    }
+
+    // Accumulate the tile over the whole reduction dimension: load a row of
+    // vectors of B and multiply it with each broadcasted element of A.
+    std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+        llvm_ir::ForLoop::EmitForLoop(
+            "tile_reduction", ir_builder_->getInt64(0),
+            ir_builder_->getInt64(gemm.k), ir_builder_->getInt64(1),
+            ir_builder_);
+    SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+    llvm::Value* reduction_index = reduction_loop->GetIndVarValue();
+
+    std::vector<llvm::Value*> b_vectors;
+    for (int64 v = 0; v < kTiledGemmTileVectors; ++v) {
+      llvm::Value* b_address = EmitMatrixElementAddress(
+          *gemm.b, /*transposed=*/false, gemm.k, gemm.n, reduction_index,
+          ir_builder_->CreateAdd(col, ir_builder_->getInt64(v * vector_size)));
+      llvm::LoadInst* b_vector = ir_builder_->CreateAlignedLoad(
+          ir_builder_->CreateBitCast(b_address, vector_pointer_type),
+          element_bytes);
+      gemm.b->AnnotateLoadStoreInstructionWithMetadata(b_vector);
+      b_vectors.push_back(b_vector);
+    }
+    for (int64 r = 0; r < kTiledGemmTileRows; ++r) {
+      llvm::LoadInst* a_element = ir_builder_->CreateLoad(
+          EmitMatrixElementAddress(
+              *gemm.a, gemm.transpose_a, gemm.m, gemm.k,
+              ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+              reduction_index));
+      gemm.a->AnnotateLoadStoreInstructionWithMetadata(a_element);
+      llvm::Value* a_vector =
+          ir_builder_->CreateVectorSplat(vector_size, a_element);
+      for (int64 v = 0; v < kTiledGemmTileVectors; ++v) {
+        llvm::Value* accumulator =
+            accumulators[r * kTiledGemmTileVectors + v];
+        llvm::Value* product = ir_builder_->CreateFMul(a_vector, b_vectors[v]);
+        ir_builder_->CreateStore(
+            ir_builder_->CreateFAdd(ir_builder_->CreateLoad(accumulator),
+                                    product),
+            accumulator);
+      }
+    }
+
+    // Store the tile into the output.
+    SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+    for (int64 r = 0; r < kTiledGemmTileRows; ++r) {
+      for (int64 v = 0; v < kTiledGemmTileVectors; ++v) {
+        llvm::Value* target_address = EmitMatrixElementAddress(
+            target_array_, /*transposed=*/false, gemm.m, gemm.n,
+            ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+            ir_builder_->CreateAdd(col,
+                                   ir_builder_->getInt64(v * vector_size)));
+        llvm::StoreInst* store = ir_builder_->CreateAlignedStore(
+            ir_builder_->CreateLoad(
+                accumulators[r * kTiledGemmTileVectors + v]),
+            ir_builder_->CreateBitCast(target_address, vector_pointer_type),
+            element_bytes);
+        target_array_.AnnotateLoadStoreInstructionWithMetadata(store);
+      }
+    }
+
+    SetToFirstInsertPoint(col_loop->GetExitBasicBlock(), ir_builder_);
+  }
+
+  // The columns right of the last whole panel, for the tiled rows, and all
+  // columns of the rows below the last whole tile.
+  if (tiled_cols < gemm.n) {
+    EmitScalarGemmRegion(gemm, 0, tiled_rows, tiled_cols, gemm.n);
+  }
+  if (tiled_rows < gemm.m) {
+    EmitScalarGemmRegion(gemm, tiled_rows, gemm.m, 0, gemm.n);
+  }
+  return tensorflow::Status::OK();
+}
+
+void DotOpEmitter::EmitScalarGemmRegion(const RowMajorGemm& gemm,
+                                        int64 row_start, int64 row_end,
+                                        int64 col_start, int64 col_end) {
+  if (row_start >= row_end || col_start >= col_end) {
+    return;
+  }
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> row_loop =
+      loop_nest.AddLoop(row_start, row_end, "gemm_row");
+  std::unique_ptr<llvm_ir::ForLoop> col_loop =
+      loop_nest.AddLoop(col_start, col_end, "gemm_col");
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+      loop_nest.AddLoop(0, gemm.k, "gemm_reduction");
+  llvm::Value* row = row_loop->GetIndVarValue();
+  llvm::Value* col = col_loop->GetIndVarValue();
+  llvm::Value* reduction_index = reduction_loop->GetIndVarValue();
+
+  llvm::Type* accum_type = target_array_.GetElementLlvmType();
+  llvm::Value* accum_address = llvm_ir::EmitAllocaAtFunctionEntry(
+      accum_type, "gemm_accum_address", ir_builder_);
+
+  ir_builder_->SetInsertPoint(
+      reduction_loop->GetPreheaderBasicBlock()->getTerminator());
+  ir_builder_->CreateStore(llvm::ConstantFP::get(accum_type, 0.0),
+                           accum_address);
+
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::LoadInst* a_element = ir_builder_->CreateLoad(EmitMatrixElementAddress(
+      *gemm.a, gemm.transpose_a, gemm.m, gemm.k, row, reduction_index));
+  gemm.a->AnnotateLoadStoreInstructionWithMetadata(a_element);
+  llvm::LoadInst* b_element = ir_builder_->CreateLoad(EmitMatrixElementAddress(
+      *gemm.b, gemm.transpose_b, gemm.k, gemm.n, reduction_index, col));
+  gemm.b->AnnotateLoadStoreInstructionWithMetadata(b_element);
+  llvm::Value* product = ir_builder_->CreateFMul(a_element, b_element);
+  ir_builder_->CreateStore(
+      ir_builder_->CreateFAdd(ir_builder_->CreateLoad(accum_address), product),
+      accum_address);
+
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  llvm::StoreInst* store = ir_builder_->CreateStore(
+      ir_builder_->CreateLoad(accum_address),
+      EmitMatrixElementAddress(target_array_, /*transposed=*/false, gemm.m,
+                               gemm.n, row, col));
+  target_array_.AnnotateLoadStoreInstructionWithMetadata(store);
+
+  ir_builder_->SetInsertPoint(loop_nest.GetOuterLoopExitBasicBlock());
+}
+
 tensorflow::Status DotOpEmitter::EmitScalarDot() {
   // A scalar dot is just a scalar multiply.
   llvm::Value* lhs_value =
@@ -62,6 +62,48 @@ class DotOpEmitter {
   // Emits a call to the CPU runtime to perform the matrix multiply.
   tensorflow::Status EmitCallToRuntime();
 
+  // The operands of the dot as a matrix multiply C = A x B of an M x K matrix
+  // A and a K x N matrix B, where the memory of A, B and C is read in
+  // row-major order. Column-major operands are handled with the identity
+  // (A x B)^T = B^T x A^T, i.e. by swapping the roles of the two operands.
+  struct RowMajorGemm {
+    const llvm_ir::IrArray* a;
+    const llvm_ir::IrArray* b;
+    bool transpose_a;
+    bool transpose_b;
+    int64 m;
+    int64 n;
+    int64 k;
+  };
+
+  // Returns the operands of the dot in their row-major frame. The operands
+  // and the target must be matrices with the same layout.
+  RowMajorGemm GetRowMajorGemm() const;
+
+  // Returns true if the dot should be emitted with EmitTiledGemm rather than
+  // with a call to the runtime or with naive loops.
+  bool ShouldEmitTiledGemm() const;
+
+  // Emits register-tiled, vectorized loops performing the matrix multiply.
+  // Each tile of the output is accumulated in vector registers over the whole
+  // reduction dimension, and tiles are visited column panel by column panel
+  // so that the panel of the RHS stays in the cache while it is reused.
+  tensorflow::Status EmitTiledGemm();
+
+  // Emits scalar loops computing the elements of the output in rows
+  // [row_start, row_end) and columns [col_start, col_end) of 'gemm', for the
+  // parts of the output not covered by whole tiles.
+  void EmitScalarGemmRegion(const RowMajorGemm& gemm, int64 row_start,
+                            int64 row_end, int64 col_start, int64 col_end);
+
+  // Emits the address of element ('row', 'col') of 'array', a matrix stored
+  // in row-major order with 'num_cols' columns, or in column-major order with
+  // 'num_rows' rows if 'transposed'.
+  llvm::Value* EmitMatrixElementAddress(const llvm_ir::IrArray& array,
+                                        bool transposed, int64 num_rows,
+                                        int64 num_cols, llvm::Value* row,
+                                        llvm::Value* col);
+
   // Emits a series of nested loops for iterating over an operand array in the
   // dot operation. Loops are constructed in major to minor dimension layout
   // order. No loop is emitted for the given reduction_dimension. The function
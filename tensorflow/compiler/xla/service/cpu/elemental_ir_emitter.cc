@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <string>
 
+#include "external/llvm/include/llvm/IR/Constants.h"
 #include "external/llvm/include/llvm/IR/Instructions.h"
+#include "external/llvm/include/llvm/IR/Intrinsics.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
@@ -30,14 +32,25 @@ namespace cpu {
 
 StatusOr<llvm::Value*> CpuElementalIrEmitter::EmitFloatUnaryOp(
     const HloInstruction* op, llvm::Value* operand_value) const {
+  const bool is_f32 = op->shape().element_type() == F32;
   switch (op->opcode()) {
+    case HloOpcode::kExp:
+      if (is_f32) {
+        return EmitExpF32(operand_value);
+      }
+      return ElementalIrEmitter::EmitFloatUnaryOp(op, operand_value);
+    case HloOpcode::kLog:
+      if (is_f32) {
+        return EmitLogF32(operand_value);
+      }
+      return ElementalIrEmitter::EmitFloatUnaryOp(op, operand_value);
     case HloOpcode::kTanh: {
+      if (is_f32) {
+        return EmitTanhF32(operand_value);
+      }
       PrimitiveType element_type = op->shape().element_type();
       string function_name;
       switch (element_type) {
-        case F32:
-          function_name = "tanhf";
-          break;
         case F64:
           function_name = "tanh";
           break;
@@ -64,5 +77,152 @@ StatusOr<llvm::Value*> CpuElementalIrEmitter::EmitFloatUnaryOp(
   }
 }
 
+// The approximations below are those of Eigen's pexp, plog and ptanh for
+// float packets, which come from the Cephes library.
+
+llvm::Value* CpuElementalIrEmitter::EmitExpF32(llvm::Value* input) const {
+  llvm::IRBuilder<>* b = ir_builder_;
+  llvm::Type* type = input->getType();
+  auto constant = [type](double value) {
+    return llvm::ConstantFP::get(type, value);
+  };
+
+  // exp underflows to 0 below -104 and overflows to infinity above 89, which
+  // the clamped values still do.
+  llvm::Value* x =
+      EmitFloatMin(EmitFloatMax(input, constant(-104.0)), constant(89.0));
+
+  // Write exp(x) as exp(r) * 2^n, with n = round(x / log(2)) and
+  // r = x - n * log(2), whose subtraction is split in two for accuracy.
+  llvm::Value* n = llvm_ir::EmitCallToIntrinsic(
+      llvm::Intrinsic::floor,
+      {b->CreateFAdd(b->CreateFMul(x, constant(1.44269504088896341)),
+                     constant(0.5))},
+      {type}, b);
+  x = b->CreateFSub(x, b->CreateFMul(n, constant(0.693359375)));
+  x = b->CreateFSub(x, b->CreateFMul(n, constant(-2.12194440e-4)));
+
+  // exp(r) for r in [-log(2) / 2, log(2) / 2].
+  llvm::Value* z = b->CreateFMul(x, x);
+  llvm::Value* y = constant(1.9875691500e-4);
+  for (double coefficient : {1.3981999507e-3, 8.3334519073e-3, 4.1665795894e-2,
+                             1.6666665459e-1, 5.0000001201e-1}) {
+    y = b->CreateFAdd(b->CreateFMul(y, x), constant(coefficient));
+  }
+  y = b->CreateFAdd(b->CreateFAdd(b->CreateFMul(y, z), x), constant(1.0));
+
+  // Multiply by 2^n, in two factors 2^n1 and 2^n2 with n = n1 + n2 that are
+  // normal floats for all the n of the clamped range, so that the product
+  // underflows to denormals and overflows to infinity correctly. A float
+  // 2^k is the biased exponent k + 127 shifted to the exponent bits.
+  llvm::Type* i32_type = b->getInt32Ty();
+  llvm::Value* n_int = b->CreateFPToSI(n, i32_type);
+  llvm::Value* n1 = b->CreateAShr(n_int, 1);
+  llvm::Value* n2 = b->CreateSub(n_int, n1);
+  auto pow2 = [b, type](llvm::Value* k) {
+    return b->CreateBitCast(b->CreateShl(b->CreateAdd(k, b->getInt32(127)), 23),
+                            type);
+  };
+  llvm::Value* result = b->CreateFMul(b->CreateFMul(y, pow2(n1)), pow2(n2));
+
+  // The clamping turned NaNs into numbers.
+  return b->CreateSelect(b->CreateFCmpUNO(input, input), input, result);
+}
+
+llvm::Value* CpuElementalIrEmitter::EmitLogF32(llvm::Value* input) const {
+  llvm::IRBuilder<>* b = ir_builder_;
+  llvm::Type* type = input->getType();
+  auto constant = [type](double value) {
+    return llvm::ConstantFP::get(type, value);
+  };
+  llvm::Type* i32_type = b->getInt32Ty();
+
+  // Denormals are treated as the smallest normal float.
+  llvm::Value* x = EmitFloatMax(input, constant(1.17549435e-38));
+
+  // Write x as m * 2^e, with m in [0.5, 1), from the bits of the float.
+  llvm::Value* bits = b->CreateBitCast(x, i32_type);
+  llvm::Value* e = b->CreateSIToFP(
+      b->CreateSub(b->CreateLShr(bits, 23), b->getInt32(126)), type);
+  llvm::Value* m = b->CreateBitCast(
+      b->CreateOr(b->CreateAnd(bits, b->getInt32(0x007fffff)),
+                  b->getInt32(0x3f000000)),
+      type);
+
+  // Move m to [sqrt(0.5), sqrt(2)) and take x = m - 1, so that log(1 + x)
+  // is well approximated around 0.
+  llvm::Value* small = b->CreateFCmpOLT(m, constant(0.707106781186547524));
+  e = b->CreateFSub(e, b->CreateSelect(small, constant(1.0), constant(0.0)));
+  x = b->CreateFAdd(b->CreateFSub(m, constant(1.0)),
+                    b->CreateSelect(small, m, constant(0.0)));
+
+  // log(1 + x) = x - x^2 / 2 + x^3 * P(x).
+  llvm::Value* x2 = b->CreateFMul(x, x);
+  llvm::Value* x3 = b->CreateFMul(x2, x);
+  auto horner = [b, x, &constant](double c0, double c1, double c2) {
+    llvm::Value* y = b->CreateFAdd(b->CreateFMul(constant(c0), x), constant(c1));
+    return b->CreateFAdd(b->CreateFMul(y, x), constant(c2));
+  };
+  llvm::Value* y = horner(7.0376836292e-2, -1.1514610310e-1, 1.1676998740e-1);
+  llvm::Value* y1 =
+      horner(-1.2420140846e-1, 1.4249322787e-1, -1.6668057665e-1);
+  llvm::Value* y2 = horner(2.0000714765e-1, -2.4999993993e-1, 3.3333331174e-1);
+  y = b->CreateFAdd(b->CreateFMul(y, x3), y1);
+  y = b->CreateFAdd(b->CreateFMul(y, x3), y2);
+  y = b->CreateFMul(y, x3);
+
+  // Add e * log(2), split in two for accuracy.
+  y = b->CreateFAdd(y, b->CreateFMul(e, constant(-2.12194440e-4)));
+  x = b->CreateFSub(x, b->CreateFMul(x2, constant(0.5)));
+  x = b->CreateFAdd(x, y);
+  llvm::Value* result =
+      b->CreateFAdd(x, b->CreateFMul(e, constant(0.693359375)));
+
+  // log(inf) = inf, log(0) = -inf, and log(x) = NaN for x < 0 or NaN.
+  llvm::Value* infinity = llvm::ConstantFP::getInfinity(type);
+  result = b->CreateSelect(b->CreateFCmpOEQ(input, infinity), infinity, result);
+  result = b->CreateSelect(b->CreateFCmpULT(input, constant(0.0)),
+                           llvm::ConstantFP::getNaN(type), result);
+  return b->CreateSelect(b->CreateFCmpOEQ(input, constant(0.0)),
+                         llvm::ConstantFP::getInfinity(type, /*Negative=*/true),
+                         result);
+}
+
+llvm::Value* CpuElementalIrEmitter::EmitTanhF32(llvm::Value* input) const {
+  llvm::IRBuilder<>* b = ir_builder_;
+  llvm::Type* type = input->getType();
+  auto constant = [type](double value) {
+    return llvm::ConstantFP::get(type, value);
+  };
+
+  // tanh(x) rounds to +/-1 outside of [-9, 9].
+  llvm::Value* x =
+      EmitFloatMin(EmitFloatMax(input, constant(-9.0)), constant(9.0));
+  llvm::Value* x2 = b->CreateFMul(x, x);
+
+  // A 13/6 rational approximation: tanh(x) = x * P(x^2) / Q(x^2).
+  llvm::Value* p = constant(-2.76076847742355e-16);
+  for (double coefficient :
+       {2.00018790482477e-13, -8.60467152213735e-11, 5.12229709037114e-08,
+        1.48572235717979e-05, 6.37261928875436e-04, 4.89352455891786e-03}) {
+    p = b->CreateFAdd(b->CreateFMul(p, x2), constant(coefficient));
+  }
+  p = b->CreateFMul(p, x);
+  llvm::Value* q = constant(1.19825839466702e-06);
+  for (double coefficient :
+       {1.18534705686654e-04, 2.26843463243900e-03, 4.89352518554385e-03}) {
+    q = b->CreateFAdd(b->CreateFMul(q, x2), constant(coefficient));
+  }
+  llvm::Value* result = b->CreateFDiv(p, q);
+
+  // tanh(x) rounds to x for tiny x, which keeps the sign of zeros, and the
+  // clamping turned NaNs into numbers.
+  llvm::Value* abs_input = llvm_ir::EmitCallToIntrinsic(
+      llvm::Intrinsic::fabs, {input}, {type}, b);
+  result = b->CreateSelect(b->CreateFCmpOLT(abs_input, constant(0.0004)),
+                           input, result);
+  return b->CreateSelect(b->CreateFCmpUNO(input, input), input, result);
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -35,6 +35,15 @@ class CpuElementalIrEmitter : public ElementalIrEmitter {
  protected:
   StatusOr<llvm::Value*> EmitFloatUnaryOp(
       const HloInstruction* op, llvm::Value* operand_value) const override;
+
+ private:
+  // Emit polynomial approximations of exp, log and tanh of an F32 value, with
+  // Eigen's accuracy. Unlike calls to libm or to the LLVM intrinsics, which
+  // LLVM can't vectorize without a vector math library, they are plain
+  // arithmetic, so the loop vectorizer can vectorize the loops that use them.
+  llvm::Value* EmitExpF32(llvm::Value* input) const;
+  llvm::Value* EmitLogF32(llvm::Value* input) const;
+  llvm::Value* EmitTanhF32(llvm::Value* input) const;
 };
 
 }  // namespace cpu
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
@@ -1558,8 +1559,16 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
   TF_ASSIGN_OR_RETURN(llvm::Value * output_address,
                       EmitTargetAddressForOp(call));
 
-  EmitArrayFunctionCallInto(call_ir_function, parameter_addresses,
-                            output_address, computation->name());
+  if (!computation->root_instruction()->outer_dimension_partitions().empty()) {
+    // ParallelTaskAssigner assigned partitions to the callee, so dispatch its
+    // partitions to the intra-op thread pool.
+    TF_RETURN_IF_ERROR(EmitParallelForkJoin(parameter_addresses,
+                                            output_address, computation,
+                                            call_ir_function));
+  } else {
+    EmitArrayFunctionCallInto(call_ir_function, parameter_addresses,
+                              output_address, computation->name());
+  }
 
   emitted_value_[call] = output_address;
   return Status::OK();
@@ -1945,10 +1954,9 @@ llvm::Value* IrEmitter::EmitElementFunctionCall(
 //                 parameter_addresses_buffer,
 //                 temps)
 //   return return_value_buffer  -- address of the return value.
-void IrEmitter::EmitArrayFunctionCallInto(
-    llvm::Function* function,
+llvm::Value* IrEmitter::EmitParameterAddressesBuffer(
     tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
-    llvm::Value* return_value_buffer, tensorflow::StringPiece name) {
+    tensorflow::StringPiece name) {
   llvm::Value* parameter_addresses_buffer =
       llvm_ir::EmitAllocaAtFunctionEntryWithCount(
           ir_builder_.getInt8PtrTy(),
@@ -1964,6 +1972,15 @@ void IrEmitter::EmitArrayFunctionCallInto(
         parameter_addresses_buffer, {ir_builder_.getInt64(i)});
     ir_builder_.CreateStore(parameter_as_i8ptr, slot_in_param_adresses);
   }
+  return parameter_addresses_buffer;
+}
+
+void IrEmitter::EmitArrayFunctionCallInto(
+    llvm::Function* function,
+    tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+    llvm::Value* return_value_buffer, tensorflow::StringPiece name) {
+  llvm::Value* parameter_addresses_buffer =
+      EmitParameterAddressesBuffer(parameter_addresses, name);
 
   const auto to_int8_ptr = [this](llvm::Value* ptr) {
     return ir_builder_.CreatePointerCast(ptr, ir_builder_.getInt8PtrTy());
@@ -1978,6 +1995,80 @@ void IrEmitter::EmitArrayFunctionCallInto(
   ir_builder_.CreateCall(function, arguments);
 }
 
+Status IrEmitter::EmitParallelForkJoin(
+    tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+    llvm::Value* output_address, HloComputation* computation,
+    llvm::Function* parallel_function) {
+  HloInstruction* root = computation->root_instruction();
+  TF_RET_CHECK(!ShapeUtil::IsTuple(root->shape()));
+  TF_RET_CHECK(!ShapeUtil::IsScalar(root->shape()));
+
+  // Compute the [start, limit) bounds of each partitioned dimension, for each
+  // partition of 'root'. Partitions are fixed at compile time, so they are
+  // emitted as a constant array.
+  ShapePartitionIterator partition_iterator(
+      root->shape(), root->outer_dimension_partitions());
+  const int64 num_partitions = partition_iterator.GetTotalPartitionCount();
+  const int64 num_partitioned_dims =
+      root->outer_dimension_partitions().size();
+  TF_RET_CHECK(num_partitions > 1);
+  std::vector<uint64_t> partitions;
+  partitions.reserve(num_partitions * num_partitioned_dims * 2);
+  for (int64 i = 0; i < num_partitions; ++i) {
+    for (const auto& dim_partition : partition_iterator.GetPartition(i)) {
+      // Store partition [start, limit) for each dimension.
+      partitions.push_back(dim_partition.first);
+      partitions.push_back(dim_partition.first + dim_partition.second);
+    }
+  }
+  llvm::Constant* partitions_array =
+      llvm::ConstantDataArray::get(module_->getContext(), partitions);
+  llvm::GlobalVariable* partitions_global = new llvm::GlobalVariable(
+      /*Module=*/*module_,
+      /*Type=*/partitions_array->getType(),
+      /*isConstant=*/true,
+      /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+      /*Initializer=*/partitions_array,
+      /*Name=*/llvm_ir::AsStringRef(tensorflow::strings::StrCat(
+          computation->name(), "_partitions")));
+
+  // The signature of ParallelForkJoin is the signature of the compute
+  // functions (with mandatory profile counters) followed by the number of
+  // partitions, the partitions array, the number of partitioned dimensions and
+  // the compute function to dispatch.
+  llvm::Type* i8_ptr_type = ir_builder_.getInt8PtrTy();
+  llvm::Type* i64_ptr_type = ir_builder_.getInt64Ty()->getPointerTo();
+  llvm::FunctionType* fork_join_type = llvm::FunctionType::get(
+      /*Result=*/ir_builder_.getVoidTy(),
+      /*Params=*/{i8_ptr_type, i8_ptr_type, i8_ptr_type->getPointerTo(),
+                  i8_ptr_type->getPointerTo(), i64_ptr_type,
+                  ir_builder_.getInt32Ty(), i64_ptr_type,
+                  ir_builder_.getInt32Ty(), i8_ptr_type},
+      /*isVarArg=*/false);
+  llvm::Function* fork_join_func =
+      llvm::cast<llvm::Function>(module_->getOrInsertFunction(
+          runtime::kParallelForkJoinSymbolName, fork_join_type));
+  fork_join_func->setCallingConv(llvm::CallingConv::C);
+  fork_join_func->setDoesNotThrow();
+
+  llvm::Value* profile_counters = GetProfileCountersArgument();
+  if (profile_counters == nullptr) {
+    profile_counters = llvm::Constant::getNullValue(i64_ptr_type);
+  }
+  ir_builder_.CreateCall(
+      fork_join_func,
+      {ir_builder_.CreatePointerCast(output_address, i8_ptr_type),
+       ir_builder_.CreatePointerCast(GetExecutableRunOptionsArgument(),
+                                     i8_ptr_type),
+       EmitParameterAddressesBuffer(parameter_addresses, computation->name()),
+       GetTempBuffersArgument(), profile_counters,
+       ir_builder_.getInt32(num_partitions),
+       ir_builder_.CreatePointerCast(partitions_global, i64_ptr_type),
+       ir_builder_.getInt32(num_partitioned_dims),
+       ir_builder_.CreatePointerCast(parallel_function, i8_ptr_type)});
+  return Status::OK();
+}
+
 llvm::Value* IrEmitter::EmitArrayFunctionCall(
     llvm::Function* function, const Shape& return_shape, int64 element_count,
     tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
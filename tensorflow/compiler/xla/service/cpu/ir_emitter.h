@@ -243,6 +243,22 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
       llvm::Value* return_value, tensorflow::StringPiece name);
 
+  // Emits an alloca'ed array holding 'parameter_addresses', in the layout the
+  // emitted compute functions expect for their 'params' argument.
+  llvm::Value* EmitParameterAddressesBuffer(
+      tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+      tensorflow::StringPiece name);
+
+  // Emits a call to the runtime function __xla_cpu_runtime_ParallelForkJoin,
+  // which runs 'parallel_function' once for each outer-dimension partition
+  // assigned to the root instruction of 'computation', on the intra-op thread
+  // pool. 'parallel_function' is the function emitted for 'computation', with
+  // dynamic loop bounds.
+  Status EmitParallelForkJoin(
+      tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+      llvm::Value* output_address, HloComputation* computation,
+      llvm::Function* parallel_function);
+
   // Array function call emitter.  Returns a Value for the function's return
   // value buffer address. The return value buffer is alloca'ed by this
   // function.
@@ -0,0 +1,225 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/ptr_util.h"
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Returns true if the IrEmitter emits 'instruction' with a single loop nest
+// over its output shape (EmitTargetElementLoop), so that the outer dimensions
+// of that loop nest can be split into independent partitions.
+bool IsPartitionable(const HloInstruction& instruction) {
+  // Currently, we do not assign parallel tasks to instructions with at least
+  // one of the following properties:
+  // *) No code of their own (parameters, constants, bitcasts, tuple accesses).
+  // *) Internal threading (library calls to kConv, kDot, and kCustomCall).
+  // *) Emit custom loops (kSelectAndScatter, kPad, FusionKind::kTransposeDot).
+  // *) Side effects or state which must be observed in order (kRng, kInfeed,
+  //    kOutfeed, kSend, kRecv).
+  // *) Tuple-shaped.
+  // TODO(b/27458679) Parallelize instructions which are skipped here.
+  switch (instruction.opcode()) {
+    case HloOpcode::kParameter:
+    case HloOpcode::kConstant:
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kCall:
+    case HloOpcode::kWhile:
+    case HloOpcode::kCustomCall:
+    case HloOpcode::kSelectAndScatter:
+    case HloOpcode::kPad:
+    case HloOpcode::kRng:
+    case HloOpcode::kInfeed:
+    case HloOpcode::kOutfeed:
+    case HloOpcode::kSend:
+    case HloOpcode::kRecv:
+    case HloOpcode::kCrossReplicaSum:
+    case HloOpcode::kBatchNormTraining:
+    case HloOpcode::kSort:
+      return false;
+    default:
+      break;
+  }
+  if ((instruction.opcode() == HloOpcode::kConvolution &&
+       PotentiallyImplementedAsEigenConvolution(instruction)) ||
+      PotentiallyImplementedAsEigenDot(instruction) ||
+      (instruction.opcode() == HloOpcode::kFusion &&
+       instruction.fusion_kind() != HloInstruction::FusionKind::kLoop) ||
+      ShapeUtil::IsTuple(instruction.shape())) {
+    return false;
+  }
+  return true;
+}
+
+// Parallel cost model used when HloCostAnalysis fails on the module (likely
+// because HLOs like CustomCall are not yet implemented in HloCostAnalysis).
+// Uses a simple cost model based on hlo size and typical L2 cache size.
+class SimpleCostModel : public ParallelCostModel {
+ public:
+  SimpleCostModel(const int64 max_parallelism,
+                  const HloCostAnalysis::ShapeSizeFunction& shape_size)
+      : max_parallelism_(max_parallelism), shape_size_(shape_size) {}
+  ~SimpleCostModel() override {}
+
+  int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    const int64 instruction_cost = shape_size_(instruction->shape());
+    const int64 min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
+    // Return target parallel task count in [1, max_parallelism_].
+    return std::min(max_parallelism_,
+                    std::max(1LL, instruction_cost / min_cost_per_thread));
+  }
+
+ private:
+  const int64 max_parallelism_;
+  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+};
+
+// Parallel cost model based on the flop, transcendental and memory traffic
+// estimates of HloCostAnalysis.
+class DefaultCostModel : public ParallelCostModel {
+ public:
+  DefaultCostModel(const int64 max_parallelism,
+                   std::unique_ptr<HloCostAnalysis> cost_analysis)
+      : max_parallelism_(max_parallelism),
+        cost_analysis_(std::move(cost_analysis)) {}
+  ~DefaultCostModel() override {}
+
+  int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    // Calculate the instruction cost in cycles.
+    // TODO(29630486) Improve on this linear cost model.
+    // Consider making 'min_cost_per_thread' be a function of the target
+    // bandwidth limit for instructions with low arithmetic complexity.
+    const int64 instruction_cost =
+        1 * cost_analysis_->flop_count(*instruction) +
+        2 * cost_analysis_->transcendental_count(*instruction) +
+        10 * cost_analysis_->bytes_accessed(*instruction);
+    // Minimum per-thread cost is 100us of work on a 2GHz core.
+    const int64 min_cost_per_thread = 100000;
+    // Return target parallel task count in [1, max_parallelism_].
+    return std::min(max_parallelism_,
+                    std::max(1LL, instruction_cost / min_cost_per_thread));
+  }
+
+ private:
+  const int64 max_parallelism_;
+  const std::unique_ptr<HloCostAnalysis> cost_analysis_;
+};
+
+}  // namespace
+
+ParallelTaskAssignment::ParallelTaskAssignment(
+    const int64 max_parallelism,
+    const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module) {
+  VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
+  // Run cost analysis on 'module'.
+  auto cost_analysis = MakeUnique<HloCostAnalysis>(shape_size);
+  HloComputation* computation = module->entry_computation();
+  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  if (status.ok()) {
+    // Set default cost model based on 'cost_analysis'.
+    cost_model_.reset(new DefaultCostModel(max_parallelism,
+                                           std::move(cost_analysis)));
+  } else {
+    // Fall back to a simple cost model based on hlo size and L2 cache size.
+    // Note that HloCostAnalysis can return an error status (likely because
+    // HLOs like CustomCall are not yet implemented in the HloCostAnalysis).
+    cost_model_.reset(new SimpleCostModel(max_parallelism, shape_size));
+  }
+}
+
+int64 ParallelTaskAssignment::GetTargetParallelTaskCount(
+    HloInstruction* instruction) {
+  if (!IsPartitionable(*instruction)) {
+    return 1;
+  }
+  // Consult 'cost_model_' to compute target parallel task count.
+  return cost_model_->GetParallelTaskCount(instruction);
+}
+
+StatusOr<bool> ParallelTaskAssigner::Run(HloModule* module) {
+  XLA_VLOG_LINES(2, "ParallelTaskAssigner ENTRY");
+  XLA_VLOG_LINES(3, module->ToString());
+
+  ParallelTaskAssignment parallel_task_assignment(
+      max_parallelism_, shape_size_function_, module);
+
+  // Compute the outer-dimension partitions of each instruction in the entry
+  // computation before outlining, since outlining replaces instructions (and
+  // the cost analysis is keyed by instruction).
+  HloComputation* computation = module->entry_computation();
+  std::vector<std::pair<HloInstruction*, std::vector<int64>>>
+      instructions_to_outline;
+  for (HloInstruction* instruction : computation->MakeInstructionPostOrder()) {
+    // Calculate target parallel task count in [1, max_parallelism_].
+    const int64 target_parallel_task_count =
+        parallel_task_assignment.GetTargetParallelTaskCount(instruction);
+    if (target_parallel_task_count <= 1) {
+      continue;
+    }
+
+    // Assign feasible dimension partitions (based on actual dimension sizes).
+    auto dim_partition_counts = ShapePartitionAssigner(instruction->shape())
+                                    .Run(target_parallel_task_count);
+    const int64 total_partition_count =
+        ShapePartitionAssigner::GetTotalPartitionCount(dim_partition_counts);
+    if (total_partition_count <= 1) {
+      // Feasible partition calculation resulting in no partitioning, so skip.
+      continue;
+    }
+    VLOG(2) << "Assigning parallel task count: " << total_partition_count
+            << " to instruction: " << instruction->name();
+    instructions_to_outline.emplace_back(instruction,
+                                         std::move(dim_partition_counts));
+  }
+
+  // Outline each partitioned instruction in its own sub-computation, and map
+  // the assigned partitions to the cloned root instruction of the callee.
+  for (auto& instruction_and_partitions : instructions_to_outline) {
+    HloInstruction* instruction = instruction_and_partitions.first;
+    const string instruction_name = instruction->name();
+    HloInstruction* call = module->OutlineExpressionFromComputation(
+        {instruction}, tensorflow::strings::StrCat("pt_", instruction_name),
+        computation);
+    call->to_apply()->root_instruction()->set_outer_dimension_partitions(
+        instruction_and_partitions.second);
+    VLOG(1) << "Outlining parallel task"
+            << " caller: " << call->name()
+            << " callee: " << call->to_apply()->root_instruction()->name();
+  }
+
+  XLA_VLOG_LINES(2, "ParallelTaskAssigner EXIT");
+  XLA_VLOG_LINES(3, module->ToString());
+  return !instructions_to_outline.empty();
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,142 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/util.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using ::testing::ElementsAre;
+
+class ParallelTaskAssignmentTest : public HloTestBase {
+ protected:
+  static constexpr int64 kMaxParallelism = 8;
+
+  static int64 ShapeSize(const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  }
+
+  StatusOr<bool> RunAssigner(HloModule* module) {
+    return ParallelTaskAssigner(kMaxParallelism, ShapeSize).Run(module);
+  }
+};
+
+TEST_F(ParallelTaskAssignmentTest, LargeElementwiseOpIsOutlined) {
+  auto builder = HloComputation::Builder(TestName());
+  const Shape shape = ShapeUtil::MakeShape(F32, {1024, 1024});
+  auto param0 = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, shape, "param0"));
+  auto param1 = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, shape, "param1"));
+  auto add = builder.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, param0, param1));
+  builder.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kNegate, add));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_TRUE(RunAssigner(module.get()).ValueOrDie());
+
+  // Both the add and the negate are outlined into calls of their own, with
+  // the most-major dimension split into 'kMaxParallelism' partitions.
+  HloInstruction* root = computation->root_instruction();
+  ASSERT_EQ(HloOpcode::kCall, root->opcode());
+  EXPECT_EQ(HloOpcode::kNegate, root->to_apply()->root_instruction()->opcode());
+  EXPECT_THAT(
+      root->to_apply()->root_instruction()->outer_dimension_partitions(),
+      ElementsAre(kMaxParallelism));
+
+  HloInstruction* operand = root->mutable_operand(0);
+  ASSERT_EQ(HloOpcode::kCall, operand->opcode());
+  EXPECT_EQ(HloOpcode::kAdd, operand->to_apply()->root_instruction()->opcode());
+  EXPECT_THAT(
+      operand->to_apply()->root_instruction()->outer_dimension_partitions(),
+      ElementsAre(kMaxParallelism));
+}
+
+TEST_F(ParallelTaskAssignmentTest, SmallOpIsNotOutlined) {
+  auto builder = HloComputation::Builder(TestName());
+  const Shape shape = ShapeUtil::MakeShape(F32, {4, 4});
+  auto param0 = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, shape, "param0"));
+  auto param1 = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, shape, "param1"));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, param0, param1));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(RunAssigner(module.get()).ValueOrDie());
+  EXPECT_EQ(HloOpcode::kAdd, computation->root_instruction()->opcode());
+}
+
+TEST_F(ParallelTaskAssignmentTest, RankOneOpIsNotOutlined) {
+  // The minor-most dimension is never partitioned, so that the inner loop can
+  // be vectorized.
+  auto builder = HloComputation::Builder(TestName());
+  const Shape shape = ShapeUtil::MakeShape(F32, {1 << 20});
+  auto param0 = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, shape, "param0"));
+  builder.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kExp, param0));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(RunAssigner(module.get()).ValueOrDie());
+  EXPECT_EQ(HloOpcode::kExp, computation->root_instruction()->opcode());
+}
+
+TEST_F(ParallelTaskAssignmentTest, PadIsNotOutlined) {
+  // kPad writes its operand elements outside of the output loop nest, so it
+  // cannot be partitioned.
+  auto builder = HloComputation::Builder(TestName());
+  auto param0 = builder.AddInstruction(HloInstruction::CreateParameter(
+      0, ShapeUtil::MakeShape(F32, {1024, 1024}), "param0"));
+  auto padding_value = builder.AddInstruction(
+      HloInstruction::CreateConstant(Literal::CreateR0<float>(0.0f)));
+  PaddingConfig padding_config;
+  for (int i = 0; i < 2; ++i) {
+    auto dimension = padding_config.add_dimensions();
+    dimension->set_edge_padding_low(1);
+    dimension->set_edge_padding_high(1);
+    dimension->set_interior_padding(0);
+  }
+  builder.AddInstruction(HloInstruction::CreatePad(
+      ShapeUtil::MakeShape(F32, {1026, 1026}), param0, padding_value,
+      padding_config));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(RunAssigner(module.get()).ValueOrDie());
+  EXPECT_EQ(HloOpcode::kPad, computation->root_instruction()->opcode());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
+
+int main(int argc, char** argv) {
+  return xla::ParseDebugOptionsFlagsAndRunTests(argc, argv);
+}
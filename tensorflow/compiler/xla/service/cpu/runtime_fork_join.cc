@@ -0,0 +1,107 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+using tensorflow::int32;
+using tensorflow::int64;
+using tensorflow::uint64;
+
+namespace {
+
+// Signatures of the compute functions emitted by the IrEmitter for
+// computations with dynamic outer loop bounds, without and with profile
+// counters respectively.
+using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
+                                     int64*);
+using ProfiledComputeFunctionType = void (*)(void*, const void*, const void**,
+                                             void**, int64*, uint64*);
+
+void RunPartition(void* result_ptr, const void* run_options_ptr,
+                  const void** params, void** temps, uint64* prof_counters,
+                  int64* dynamic_loop_bounds, void* function_ptr) {
+  if (prof_counters == nullptr) {
+    reinterpret_cast<ComputeFunctionType>(function_ptr)(
+        result_ptr, run_options_ptr, params, temps, dynamic_loop_bounds);
+  } else {
+    reinterpret_cast<ProfiledComputeFunctionType>(function_ptr)(
+        result_ptr, run_options_ptr, params, temps, dynamic_loop_bounds,
+        prof_counters);
+  }
+}
+
+}  // namespace
+
+void __xla_cpu_runtime_ParallelForkJoin(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** temps, uint64* prof_counters, int32 num_partitions,
+    int64* partitions, int32 num_partitioned_dims, void* function_ptr) {
+  VLOG(2) << "ParallelForkJoin ENTRY"
+          << " num_partitions: " << num_partitions
+          << " num_partitioned_dims: " << num_partitioned_dims;
+  CHECK_GT(num_partitions, 1);
+  CHECK_GT(num_partitioned_dims, 0);
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  const Eigen::ThreadPoolDevice* device = run_options->intra_op_thread_pool();
+
+  // Compute partition stride in 'partitions' array.
+  const int64 stride = 2 * num_partitioned_dims;
+
+  if (device == nullptr) {
+    // Without an intra-op thread pool, run all partitions on this thread.
+    for (int32 i = 0; i < num_partitions; ++i) {
+      RunPartition(result_ptr, run_options_ptr, params, temps, prof_counters,
+                   &partitions[i * stride], function_ptr);
+    }
+    return;
+  }
+
+  // Dispatch 'num_partitions - 1' compute functions to run in parallel. Only
+  // framework_lite primitives are used, since tfcompile'd binaries link this.
+  tensorflow::mutex mu;
+  tensorflow::condition_variable done;
+  int32 pending = num_partitions - 1;
+  for (int32 i = 1; i < num_partitions; ++i) {
+    int64* dynamic_loop_bounds = &partitions[i * stride];
+    device->enqueueNoNotification([=, &mu, &done, &pending]() {
+      RunPartition(result_ptr, run_options_ptr, params, temps, prof_counters,
+                   dynamic_loop_bounds, function_ptr);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+      tensorflow::mutex_lock lock(mu);
+      if (--pending == 0) {
+        done.notify_all();
+      }
+    });
+  }
+
+  // Run first compute function inline.
+  RunPartition(result_ptr, run_options_ptr, params, temps, prof_counters,
+               &partitions[0], function_ptr);
+  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  tensorflow::mutex_lock lock(mu);
+  while (pending > 0) {
+    done.wait(lock);
+  }
+  VLOG(2) << "ParallelForkJoin EXIT";
+}
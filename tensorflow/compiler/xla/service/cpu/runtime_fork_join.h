@@ -0,0 +1,38 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FORK_JOIN_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FORK_JOIN_H_
+
+#include "tensorflow/core/platform/types.h"
+
+extern "C" {
+
+// Dispatches 'num_partitions' calls to the compute function 'function_ptr' on
+// the intra-op thread pool of 'run_options_ptr', and blocks until all of them
+// have completed. Partition 'i' is passed the dynamic loop bounds
+// 'partitions[i * 2 * num_partitioned_dims]' onwards, i.e. a [start, limit)
+// pair for each of the 'num_partitioned_dims' outer-most dimensions of the
+// result. 'prof_counters' is forwarded to the compute function if non-null;
+// the compute function must take it as its last argument in that case.
+extern void __xla_cpu_runtime_ParallelForkJoin(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** temps, tensorflow::uint64* prof_counters,
+    tensorflow::int32 num_partitions, tensorflow::int64* partitions,
+    tensorflow::int32 num_partitioned_dims, void* function_ptr);
+
+}  // extern "C"
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FORK_JOIN_H_
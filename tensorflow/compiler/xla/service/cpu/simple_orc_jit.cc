@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_avx.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_sse4_1.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_conv2d.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_conv2d.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
@@ -79,6 +80,8 @@ struct SimpleResolver : public llvm::JITSymbolResolver {
                runtime::kReleaseInfeedBufferAfterDequeueSymbolName) {
       func_addr = reinterpret_cast<void *>(
           __xla_cpu_runtime_ReleaseInfeedBufferAfterDequeue);
+    } else if (canonical_name == runtime::kParallelForkJoinSymbolName) {
+      func_addr = reinterpret_cast<void *>(__xla_cpu_runtime_ParallelForkJoin);
     } else if (canonical_name == runtime::kExpV4F32) {
       func_addr = reinterpret_cast<void *>(runtime::ExpV4F32);
     } else if (canonical_name == runtime::kExpV8F32) {
@@ -144,7 +147,10 @@ CompilerFunctor::VectorIntrinsics GetAvailableIntrinsics() {
 SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions &target_options,
                            llvm::CodeGenOpt::Level opt_level,
                            OptimizationCallback pre_optimization_callback,
-                           OptimizationCallback post_optimization_callback)
+                           OptimizationCallback post_optimization_callback,
+                           std::shared_ptr<const PersistentCompilationCache>
+                               persistent_cache,
+                           const string &persistent_cache_options_key)
     : target_machine_(
           CHECK_NOTNULL(llvm::EngineBuilder()
                             .setTargetOptions(target_options)
@@ -159,7 +165,9 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions &target_options,
                      CompilerFunctor(target_machine_.get(), &disassembler_,
                                      opt_level, GetAvailableIntrinsics(),
                                      std::move(pre_optimization_callback),
-                                     std::move(post_optimization_callback))) {
+                                     std::move(post_optimization_callback),
+                                     std::move(persistent_cache),
+                                     persistent_cache_options_key)) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
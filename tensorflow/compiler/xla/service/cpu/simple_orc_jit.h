@@ -60,10 +60,17 @@ class SimpleOrcJIT {
   // level optimizations are applied.
   // The |post_optimization_callback| is invoked on the module after all IR
   // level optimizations are applied.
+  // If |persistent_cache| is non-null, object files are reused from and added
+  // to it; |persistent_cache_options_key| must describe the compilation
+  // options that affect the generated code (see
+  // PersistentCompilationCache::OptionsKey).
   SimpleOrcJIT(const llvm::TargetOptions& target_options,
                llvm::CodeGenOpt::Level opt_level,
                OptimizationCallback pre_optimization_callback,
-               OptimizationCallback post_optimization_callback);
+               OptimizationCallback post_optimization_callback,
+               std::shared_ptr<const PersistentCompilationCache>
+                   persistent_cache = nullptr,
+               const string& persistent_cache_options_key = "");
 
   // Data layout this JIT was created with.
   const llvm::DataLayout& data_layout() const { return data_layout_; }
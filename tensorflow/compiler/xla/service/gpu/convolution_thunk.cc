@@ -15,12 +15,17 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 
+#include <algorithm>
+#include <map>
 #include <string>
 
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 
 namespace se = ::perftools::gputools;
@@ -34,6 +39,20 @@ using se::dnn::DataLayout;
 using se::dnn::FilterDescriptor;
 using se::dnn::FilterLayout;
 
+namespace {
+
+// Autotuning results shared by all ConvolutionThunks in the process, keyed by
+// the name of the device and ConvolutionThunk::autotune_key_, so that each
+// distinct convolution is profiled once per type of device.
+tensorflow::mutex autotune_cache_mu(tensorflow::LINKER_INITIALIZED);
+
+std::map<string, se::dnn::AlgorithmConfig>& AutotuneCache() {
+  static auto* cache = new std::map<string, se::dnn::AlgorithmConfig>();
+  return *cache;
+}
+
+}  // namespace
+
 ConvolveScratchAllocator::ConvolveScratchAllocator(
     int device_ordinal, DeviceMemoryAllocator* memory_allocator)
     : device_ordinal_(device_ordinal), memory_allocator_(memory_allocator) {}
@@ -109,24 +128,20 @@ ConvolutionThunk::ConvolutionThunk(
       filter_shape_(filter_shape),
       output_shape_(output_shape),
       window_(window),
-      dim_nums_(dim_nums) {}
-
-tensorflow::Status ConvolutionThunk::ExecuteOnStream(
-    const BufferAllocations& buffer_allocations, se::Stream* stream) {
-  VLOG(3) << "Convolution kind: " << ConvolutionKindToString(convolution_kind_);
-  VLOG(3) << "input shape: { " << input_shape_.ShortDebugString() << " }";
-  VLOG(3) << "filter shape: { " << filter_shape_.ShortDebugString() << " }";
-  VLOG(3) << "Output shape: { " << output_shape_.ShortDebugString() << " }";
-  VLOG(3) << "Dim nums: { " << dim_nums_.ShortDebugString() << " }";
-  VLOG(3) << "Window: { " << window_.ShortDebugString() << " }";
-
+      dim_nums_(dim_nums),
+      autotune_key_(tensorflow::strings::StrCat(
+          ConvolutionKindToString(convolution_kind), ";",
+          input_shape.ShortDebugString(), ";", filter_shape.ShortDebugString(),
+          ";", output_shape.ShortDebugString(), ";", window.ShortDebugString(),
+          ";", dim_nums.ShortDebugString())) {}
+
+void ConvolutionThunk::MakeDescriptors(
+    BatchDescriptor* input_descriptor, FilterDescriptor* filter_descriptor,
+    BatchDescriptor* output_descriptor,
+    ConvolutionDescriptor* convolution_descriptor) const {
   const int num_dimensions = window_.dimensions_size();
   CHECK_LE(num_dimensions, 3);
-  // cuDNN does not support 1D convolutions. We therefore express 1D
-  // convolutions as 2D convolutions where the first spatial dimension is 1.
-  // This matches the behavior of TF (see definition of conv1d in
-  // tensorflow/python/ops/nn_ops.py).
-  const int effective_num_dimensions = std::max(2, num_dimensions);
+  const int effective_num_dimensions = EffectiveNumDimensions();
 
   CHECK_EQ(F32, output_shape_.element_type());
   CHECK_EQ(num_dimensions, dim_nums_.spatial_dimensions_size());
@@ -137,34 +152,31 @@ tensorflow::Status ConvolutionThunk::ExecuteOnStream(
 
   // cuDNN's convolution APIs support the BDYX layout for activations/output and
   // the OIYX layout for weights.
-  BatchDescriptor input_descriptor(effective_num_dimensions);
-  input_descriptor.set_layout(DataLayout::kBatchDepthYX)
+  input_descriptor->set_layout(DataLayout::kBatchDepthYX)
       .set_feature_map_count(
           input_shape_.dimensions(dim_nums_.feature_dimension()))
       .set_count(input_shape_.dimensions(dim_nums_.batch_dimension()));
   for (int dim = 0; dim < num_dimensions; ++dim) {
     // Note that the dimensions are reversed. The same holds below.
-    input_descriptor.set_spatial_dim(
+    input_descriptor->set_spatial_dim(
         static_cast<se::dnn::DimIndex>(effective_num_dimensions - dim - 1),
         input_shape_.dimensions(dim_nums_.spatial_dimensions(dim)));
   }
 
-  FilterDescriptor filter_descriptor(effective_num_dimensions);
-  filter_descriptor.set_layout(FilterLayout::kOutputInputYX)
+  filter_descriptor->set_layout(FilterLayout::kOutputInputYX)
       .set_input_feature_map_count(
           filter_shape_.dimensions(dim_nums_.kernel_input_feature_dimension()))
       .set_output_feature_map_count(filter_shape_.dimensions(
           dim_nums_.kernel_output_feature_dimension()));
   for (int dim = 0; dim < num_dimensions; ++dim) {
-    filter_descriptor.set_spatial_dim(
+    filter_descriptor->set_spatial_dim(
         static_cast<se::dnn::DimIndex>(effective_num_dimensions - dim - 1),
         filter_shape_.dimensions(dim_nums_.kernel_spatial_dimensions(dim)));
   }
 
-  ConvolutionDescriptor convolution_descriptor(effective_num_dimensions);
   for (int dim = 0; dim < num_dimensions; ++dim) {
     convolution_descriptor
-        .set_zero_padding(
+        ->set_zero_padding(
             static_cast<se::dnn::DimIndex>(effective_num_dimensions - dim - 1),
             window_.dimensions(dim).padding_low())
         .set_filter_stride(
@@ -172,26 +184,51 @@ tensorflow::Status ConvolutionThunk::ExecuteOnStream(
             window_.dimensions(dim).stride());
   }
 
-  BatchDescriptor output_descriptor(effective_num_dimensions);
-  output_descriptor.set_layout(DataLayout::kBatchDepthYX)
+  output_descriptor->set_layout(DataLayout::kBatchDepthYX)
       .set_feature_map_count(
           output_shape_.dimensions(dim_nums_.feature_dimension()))
       .set_count(output_shape_.dimensions(dim_nums_.batch_dimension()));
   for (int dim = 0; dim < num_dimensions; ++dim) {
-    output_descriptor.set_spatial_dim(
+    output_descriptor->set_spatial_dim(
         static_cast<se::dnn::DimIndex>(effective_num_dimensions - dim - 1),
         output_shape_.dimensions(dim_nums_.spatial_dimensions(dim)));
   }
 
   // Add a singleton dimension in the 1D convolution case.
   if (num_dimensions == 1) {
-    input_descriptor.set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
-    output_descriptor.set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
-    filter_descriptor.set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
+    input_descriptor->set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
+    output_descriptor->set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
+    filter_descriptor->set_spatial_dim(static_cast<se::dnn::DimIndex>(0), 1);
     convolution_descriptor
-        .set_zero_padding(static_cast<se::dnn::DimIndex>(0), 0)
+        ->set_zero_padding(static_cast<se::dnn::DimIndex>(0), 0)
         .set_filter_stride(static_cast<se::dnn::DimIndex>(0), 1);
   }
+}
+
+int ConvolutionThunk::EffectiveNumDimensions() const {
+  // cuDNN does not support 1D convolutions. We therefore express 1D
+  // convolutions as 2D convolutions where the first spatial dimension is 1.
+  // This matches the behavior of TF (see definition of conv1d in
+  // tensorflow/python/ops/nn_ops.py).
+  return std::max(2, window_.dimensions_size());
+}
+
+tensorflow::Status ConvolutionThunk::ExecuteOnStream(
+    const BufferAllocations& buffer_allocations, se::Stream* stream) {
+  VLOG(3) << "Convolution kind: " << ConvolutionKindToString(convolution_kind_);
+  VLOG(3) << "input shape: { " << input_shape_.ShortDebugString() << " }";
+  VLOG(3) << "filter shape: { " << filter_shape_.ShortDebugString() << " }";
+  VLOG(3) << "Output shape: { " << output_shape_.ShortDebugString() << " }";
+  VLOG(3) << "Dim nums: { " << dim_nums_.ShortDebugString() << " }";
+  VLOG(3) << "Window: { " << window_.ShortDebugString() << " }";
+
+  const int effective_num_dimensions = EffectiveNumDimensions();
+  BatchDescriptor input_descriptor(effective_num_dimensions);
+  FilterDescriptor filter_descriptor(effective_num_dimensions);
+  BatchDescriptor output_descriptor(effective_num_dimensions);
+  ConvolutionDescriptor convolution_descriptor(effective_num_dimensions);
+  MakeDescriptors(&input_descriptor, &filter_descriptor, &output_descriptor,
+                  &convolution_descriptor);
 
   se::DeviceMemory<float> input_data(
       buffer_allocations.GetDeviceAddress(input_buffer_));
@@ -199,9 +236,65 @@ tensorflow::Status ConvolutionThunk::ExecuteOnStream(
       buffer_allocations.GetDeviceAddress(filter_buffer_));
   se::DeviceMemory<float> output_data(
       buffer_allocations.GetDeviceAddress(output_buffer_));
-  return ConvolveWithTune(input_descriptor, input_data, filter_descriptor,
-                          filter_data, output_descriptor, output_data,
-                          convolution_descriptor, buffer_allocations, stream);
+  const se::dnn::AlgorithmConfig algorithm_config = GetBestAlgorithm(
+      input_descriptor, input_data, filter_descriptor, filter_data,
+      output_descriptor, output_data, convolution_descriptor,
+      buffer_allocations.device_ordinal(),
+      buffer_allocations.memory_allocator(), stream);
+
+  VLOG(2) << "Using convolution algorithm (" << algorithm_config.algorithm()
+          << ", " << algorithm_config.algorithm_no_scratch()
+          << ") for ConvolutionThunk: " << this;
+  ConvolveScratchAllocator scratch_allocator(
+      buffer_allocations.device_ordinal(),
+      buffer_allocations.memory_allocator());
+  return Convolve(input_descriptor, input_data, filter_descriptor, filter_data,
+                  output_descriptor, output_data, convolution_descriptor,
+                  algorithm_config, stream, &scratch_allocator, nullptr);
+}
+
+tensorflow::Status ConvolutionThunk::Autotune(
+    se::Stream* stream, DeviceMemoryAllocator* memory_allocator) {
+  const int device_ordinal = stream->parent()->device_ordinal();
+  // Profile the candidate algorithms on zero-initialized operands of the
+  // right shapes; the values do not affect the running time.
+  std::vector<se::DeviceMemoryBase> operands;
+  tensorflow::Status status;
+  for (const Shape* shape : {&input_shape_, &filter_shape_, &output_shape_}) {
+    const int64 size = ShapeUtil::ByteSizeOf(*shape);
+    StatusOr<se::DeviceMemoryBase> operand = memory_allocator->Allocate(
+        device_ordinal, size, /*retry_on_failure=*/false);
+    if (!operand.ok()) {
+      status = operand.status();
+      break;
+    }
+    operands.push_back(operand.ValueOrDie());
+    stream->ThenMemZero(&operands.back(), size);
+  }
+
+  if (status.ok()) {
+    const int effective_num_dimensions = EffectiveNumDimensions();
+    BatchDescriptor input_descriptor(effective_num_dimensions);
+    FilterDescriptor filter_descriptor(effective_num_dimensions);
+    BatchDescriptor output_descriptor(effective_num_dimensions);
+    ConvolutionDescriptor convolution_descriptor(effective_num_dimensions);
+    MakeDescriptors(&input_descriptor, &filter_descriptor, &output_descriptor,
+                    &convolution_descriptor);
+    GetBestAlgorithm(input_descriptor, se::DeviceMemory<float>(operands[0]),
+                     filter_descriptor, se::DeviceMemory<float>(operands[1]),
+                     output_descriptor, se::DeviceMemory<float>(operands[2]),
+                     convolution_descriptor, device_ordinal, memory_allocator,
+                     stream);
+    if (!stream->BlockHostUntilDone()) {
+      status = InternalError("Failed to complete autotuning of thunk %p",
+                             this);
+    }
+  }
+
+  for (se::DeviceMemoryBase& operand : operands) {
+    status.Update(memory_allocator->Deallocate(device_ordinal, &operand));
+  }
+  return status;
 }
 
 tensorflow::Status ConvolutionThunk::Convolve(
@@ -277,79 +370,75 @@ std::vector<se::dnn::AlgorithmType> ConvolutionThunk::GetAlgorithms(
   return algorithms;
 }
 
-tensorflow::Status ConvolutionThunk::ConvolveWithTune(
+se::dnn::AlgorithmConfig ConvolutionThunk::GetBestAlgorithm(
     const BatchDescriptor& input_descriptor, se::DeviceMemory<float> input_data,
     const FilterDescriptor& filter_descriptor,
     se::DeviceMemory<float> filter_data,
     const BatchDescriptor& output_descriptor,
     se::DeviceMemory<float> output_data,
-    const ConvolutionDescriptor& convolution_descriptor,
-    const BufferAllocations& buffer_allocations, se::Stream* stream) {
-  // TODO(b/29126320): Try cudnn v5's new auto-tuner when it's rolled out.
-  if (best_algorithm_.algorithm() == se::dnn::kDefaultAlgorithm) {
-    // Auto-tuning either is disabled or only happens in the first run of this
-    // function.
-    VLOG(2) << "Profiling for best convolution algorithm used for "
-               "ConvolutionThunk: "
-            << this;
-
-    se::dnn::ProfileResult best_result;
-    se::dnn::ProfileResult best_result_without_scratch;
-    for (se::dnn::AlgorithmType algorithm : GetAlgorithms(stream->parent())) {
-      ConvolveScratchAllocator scratch_allocator(
-          buffer_allocations.device_ordinal(),
-          buffer_allocations.memory_allocator());
-      se::dnn::ProfileResult profile_result;
-      bool launch_ok =
-          Convolve(input_descriptor, input_data, filter_descriptor, filter_data,
-                   output_descriptor, output_data, convolution_descriptor,
-                   se::dnn::AlgorithmConfig(algorithm, algorithm), stream,
-                   &scratch_allocator, &profile_result)
-              .ok();
-      if (launch_ok && profile_result.is_valid()) {
-        if (profile_result.elapsed_time_in_ms() <
-            best_result.elapsed_time_in_ms()) {
-          best_result = profile_result;
-        }
-        if (scratch_allocator.TotalAllocatedBytes() == 0 &&
-            profile_result.elapsed_time_in_ms() <
-                best_result_without_scratch.elapsed_time_in_ms()) {
-          best_result_without_scratch = profile_result;
-        }
-      }
+    const ConvolutionDescriptor& convolution_descriptor, int device_ordinal,
+    DeviceMemoryAllocator* memory_allocator, se::Stream* stream) {
+  const string cache_key = tensorflow::strings::StrCat(
+      stream->parent()->GetDeviceDescription().name(), ";", autotune_key_);
+  {
+    tensorflow::mutex_lock lock(autotune_cache_mu);
+    auto it = AutotuneCache().find(cache_key);
+    if (it != AutotuneCache().end()) {
+      return it->second;
     }
+  }
 
-    if (best_result.is_valid()) {
-      best_algorithm_.set_algorithm(best_result.algorithm());
-    } else {
-      LOG(ERROR) << "No convolution algorithm works with profiling. Fall back "
-                    "to the default algorithm.";
-      best_algorithm_.set_algorithm(se::dnn::kDefaultAlgorithm);
+  // TODO(b/29126320): Try cudnn v5's new auto-tuner when it's rolled out.
+  VLOG(2) << "Profiling for best convolution algorithm used for "
+             "ConvolutionThunk: "
+          << this;
+
+  se::dnn::ProfileResult best_result;
+  se::dnn::ProfileResult best_result_without_scratch;
+  for (se::dnn::AlgorithmType algorithm : GetAlgorithms(stream->parent())) {
+    ConvolveScratchAllocator scratch_allocator(device_ordinal,
+                                               memory_allocator);
+    se::dnn::ProfileResult profile_result;
+    bool launch_ok =
+        Convolve(input_descriptor, input_data, filter_descriptor, filter_data,
+                 output_descriptor, output_data, convolution_descriptor,
+                 se::dnn::AlgorithmConfig(algorithm, algorithm), stream,
+                 &scratch_allocator, &profile_result)
+            .ok();
+    if (launch_ok && profile_result.is_valid()) {
+      if (profile_result.elapsed_time_in_ms() <
+          best_result.elapsed_time_in_ms()) {
+        best_result = profile_result;
+      }
+      if (scratch_allocator.TotalAllocatedBytes() == 0 &&
+          profile_result.elapsed_time_in_ms() <
+              best_result_without_scratch.elapsed_time_in_ms()) {
+        best_result_without_scratch = profile_result;
+      }
     }
+  }
 
-    if (best_result_without_scratch.is_valid()) {
-      best_algorithm_.set_algorithm_no_scratch(
-          best_result_without_scratch.algorithm());
-    } else {
-      LOG(ERROR) << "No convolution algorithm without scratch works with "
-                    "profiling. Fall back "
-                    "to the default algorithm.";
-      best_algorithm_.set_algorithm_no_scratch(se::dnn::kDefaultAlgorithm);
-    }
+  se::dnn::AlgorithmConfig best_algorithm;
+  if (best_result.is_valid()) {
+    best_algorithm.set_algorithm(best_result.algorithm());
+  } else {
+    LOG(ERROR) << "No convolution algorithm works with profiling. Fall back "
+                  "to the default algorithm.";
+    best_algorithm.set_algorithm(se::dnn::kDefaultAlgorithm);
   }
 
-  {
-    VLOG(2) << "Using convolution algorithm (" << best_algorithm_.algorithm()
-            << ", " << best_algorithm_.algorithm_no_scratch()
-            << ") for ConvolutionThunk: " << this;
-    ConvolveScratchAllocator scratch_allocator(
-        buffer_allocations.device_ordinal(),
-        buffer_allocations.memory_allocator());
-    return Convolve(input_descriptor, input_data, filter_descriptor,
-                    filter_data, output_descriptor, output_data,
-                    convolution_descriptor, best_algorithm_, stream,
-                    &scratch_allocator, nullptr);
+  if (best_result_without_scratch.is_valid()) {
+    best_algorithm.set_algorithm_no_scratch(
+        best_result_without_scratch.algorithm());
+  } else {
+    LOG(ERROR) << "No convolution algorithm without scratch works with "
+                  "profiling. Fall back "
+                  "to the default algorithm.";
+    best_algorithm.set_algorithm_no_scratch(se::dnn::kDefaultAlgorithm);
   }
+
+  tensorflow::mutex_lock lock(autotune_cache_mu);
+  return AutotuneCache().emplace(cache_key, best_algorithm).first->second;
 }
 
 }  // namespace gpu
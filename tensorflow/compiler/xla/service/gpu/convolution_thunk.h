@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CONVOLUTION_THUNK_H_
 
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/device_memory_allocator.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
@@ -82,13 +83,37 @@ class ConvolutionThunk : public Thunk {
   ConvolutionThunk& operator=(const ConvolutionThunk&) = delete;
 
   // Does the convolution for the thunk on "stream". Auto-tuning happens on the
-  // first run of this function.
+  // first run of this function, unless Autotune() already found the best
+  // algorithm for this convolution on the same kind of device.
   tensorflow::Status ExecuteOnStream(
       const BufferAllocations& buffer_allocations,
       perftools::gputools::Stream* stream) override;
 
+  // Finds the fastest convolution algorithm on the device of "stream" ahead of
+  // the first run, by profiling the candidate algorithms on scratch operands
+  // allocated from "memory_allocator". Blocks until profiling is done.
+  tensorflow::Status Autotune(perftools::gputools::Stream* stream,
+                              DeviceMemoryAllocator* memory_allocator);
+
  private:
-  tensorflow::Status ConvolveWithTune(
+  // Returns the number of spatial dimensions of the convolution as seen by
+  // cuDNN.
+  int EffectiveNumDimensions() const;
+
+  // Fills in the cuDNN descriptors of this convolution. The descriptors must
+  // have been constructed with EffectiveNumDimensions() dimensions.
+  void MakeDescriptors(
+      perftools::gputools::dnn::BatchDescriptor* input_descriptor,
+      perftools::gputools::dnn::FilterDescriptor* filter_descriptor,
+      perftools::gputools::dnn::BatchDescriptor* output_descriptor,
+      perftools::gputools::dnn::ConvolutionDescriptor* convolution_descriptor)
+      const;
+
+  // Returns the fastest algorithm for this convolution on the device of
+  // "stream". The result is looked up in a process-wide cache keyed by the
+  // device name and autotune_key_; on a miss, the candidate algorithms are
+  // profiled on the given operands and the winner is added to the cache.
+  perftools::gputools::dnn::AlgorithmConfig GetBestAlgorithm(
       const perftools::gputools::dnn::BatchDescriptor& input_descriptor,
       perftools::gputools::DeviceMemory<float> input_data,
       const perftools::gputools::dnn::FilterDescriptor& filter_descriptor,
@@ -97,7 +122,7 @@ class ConvolutionThunk : public Thunk {
       perftools::gputools::DeviceMemory<float> output_data,
       const perftools::gputools::dnn::ConvolutionDescriptor&
           convolution_descriptor,
-      const BufferAllocations& buffer_allocations,
+      int device_ordinal, DeviceMemoryAllocator* memory_allocator,
       perftools::gputools::Stream* stream);
 
   tensorflow::Status Convolve(
@@ -118,12 +143,6 @@ class ConvolutionThunk : public Thunk {
   std::vector<perftools::gputools::dnn::AlgorithmType> GetAlgorithms(
       perftools::gputools::StreamExecutor* stream_exec) const;
 
-  // Fastest cuDNN convolution algorithm for this thunk learned from
-  // auto-tuning. If auto-tuning is disabled or failed, best_algorithm_ is set
-  // to the default value indicating cuDNN's convolution will choose
-  // the best algorithm from some heuristics based on its parameters.
-  perftools::gputools::dnn::AlgorithmConfig best_algorithm_;
-
   const ConvolutionKind convolution_kind_;
 
   const BufferAllocation::Slice input_buffer_;
@@ -137,6 +156,10 @@ class ConvolutionThunk : public Thunk {
   const Window window_;
 
   const ConvolutionDimensionNumbers dim_nums_;
+
+  // Describes everything about this convolution that determines the best
+  // algorithm for it on a given device, i.e. everything but the buffers.
+  const string autotune_key_;
 };
 
 string ConvolutionKindToString(
@@ -16,9 +16,14 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
 
 #include <functional>
+#include <map>
+#include <vector>
 
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -29,6 +34,19 @@ namespace gpu {
 
 namespace {
 
+// Autotuning results shared by all GemmThunks in the process, keyed by the name
+// of the device and GemmThunk::autotune_key_. The value is the best algorithm
+// for gemms with these parameters on this kind of device, or an error if none
+// of the algorithms worked and we should use the regular gemm without an
+// algorithm.
+tensorflow::mutex autotune_cache_mu(tensorflow::LINKER_INITIALIZED);
+
+std::map<string, StatusOr<se::blas::AlgorithmType>>& AutotuneCache() {
+  static auto* cache =
+      new std::map<string, StatusOr<se::blas::AlgorithmType>>();
+  return *cache;
+}
+
 // This struct contains the metadata of a matrix, e.g., its base address and
 // dimensions.
 struct MatrixDescriptor {
@@ -221,19 +239,58 @@ GemmThunk::GemmThunk(const BufferAllocation::Slice& lhs_buffer,
       rhs_shape_(rhs_shape),
       output_shape_(output_shape),
       transpose_lhs_(transpose_lhs),
-      transpose_rhs_(transpose_rhs) {}
+      transpose_rhs_(transpose_rhs),
+      autotune_key_(tensorflow::strings::StrCat(
+          lhs_shape.ShortDebugString(), ";", rhs_shape.ShortDebugString(), ";",
+          output_shape.ShortDebugString(), ";", transpose_lhs, ";",
+          transpose_rhs)) {}
 
 tensorflow::Status GemmThunk::ExecuteOnStream(
     const BufferAllocations& buffer_allocations, se::Stream* stream) {
   VLOG(2) << "Executing a GemmThunk";
 
-  se::DeviceMemoryBase lhs_data =
-      buffer_allocations.GetDeviceAddress(lhs_buffer_);
-  se::DeviceMemoryBase rhs_data =
-      buffer_allocations.GetDeviceAddress(rhs_buffer_);
-  se::DeviceMemoryBase output_data =
-      buffer_allocations.GetDeviceAddress(output_buffer_);
+  return RunGemm(buffer_allocations.GetDeviceAddress(lhs_buffer_),
+                 buffer_allocations.GetDeviceAddress(rhs_buffer_),
+                 buffer_allocations.GetDeviceAddress(output_buffer_), stream);
+}
+
+tensorflow::Status GemmThunk::Autotune(
+    se::Stream* stream, DeviceMemoryAllocator* memory_allocator) {
+  const int device_ordinal = stream->parent()->device_ordinal();
+  // Autotuning happens on the first gemm on zero-initialized operands of the
+  // right shapes; the values do not affect the running time.
+  std::vector<se::DeviceMemoryBase> operands;
+  tensorflow::Status status;
+  for (const Shape* shape : {&lhs_shape_, &rhs_shape_, &output_shape_}) {
+    const int64 size = ShapeUtil::ByteSizeOf(*shape);
+    StatusOr<se::DeviceMemoryBase> operand = memory_allocator->Allocate(
+        device_ordinal, size, /*retry_on_failure=*/false);
+    if (!operand.ok()) {
+      status = operand.status();
+      break;
+    }
+    operands.push_back(operand.ValueOrDie());
+    stream->ThenMemZero(&operands.back(), size);
+  }
 
+  if (status.ok()) {
+    status = RunGemm(operands[0], operands[1], operands[2], stream);
+    if (status.ok() && !stream->BlockHostUntilDone()) {
+      status = InternalError("Failed to complete autotuning of thunk %p",
+                             this);
+    }
+  }
+
+  for (se::DeviceMemoryBase& operand : operands) {
+    status.Update(memory_allocator->Deallocate(device_ordinal, &operand));
+  }
+  return status;
+}
+
+tensorflow::Status GemmThunk::RunGemm(se::DeviceMemoryBase lhs_data,
+                                      se::DeviceMemoryBase rhs_data,
+                                      se::DeviceMemoryBase output_data,
+                                      se::Stream* stream) {
   // BLAS gemm reduces rows of LHS and columns of RHS. The Dot operator between
   // matrices reduces dimension 1 of LHS and dimension 0 of RHS regardless of
   // their layout. Therefore, we should treat dimension 0 as row and dimension 1
@@ -285,16 +342,29 @@ tensorflow::Status GemmThunk::ExecuteOnStream(
     se::blas::ComputationType computation_type =
         GetBlasComputationType(element_type);
 
-    const string& device_name = stream->parent()->GetDeviceDescription().name();
-    auto autotune_it = autotune_results_.find(device_name);
-    if (autotune_it == autotune_results_.end()) {
-      StatusOr<se::blas::AlgorithmType> best_algorithm =
+    const string cache_key = tensorflow::strings::StrCat(
+        stream->parent()->GetDeviceDescription().name(), ";", autotune_key_);
+    bool found_in_cache;
+    StatusOr<se::blas::AlgorithmType> best_algorithm =
+        Unimplemented("not autotuned");
+    {
+      tensorflow::mutex_lock lock(autotune_cache_mu);
+      auto autotune_it = AutotuneCache().find(cache_key);
+      found_in_cache = autotune_it != AutotuneCache().end();
+      if (found_in_cache) {
+        best_algorithm = autotune_it->second;
+      }
+    }
+    if (!found_in_cache) {
+      best_algorithm =
           GetGemmAutotuneFn(element_type)(lhs_matrix, rhs_matrix, output_matrix,
                                           computation_type, stream);
-      autotune_it =
-          autotune_results_.insert({device_name, best_algorithm}).first;
+      {
+        tensorflow::mutex_lock lock(autotune_cache_mu);
+        AutotuneCache().emplace(cache_key, best_algorithm);
+      }
 
-      if (autotune_it->second.ok()) {
+      if (best_algorithm.ok()) {
         VLOG(2) << "Autotune on GemmThunk " << this
                 << " successful; best algorithm is "
                 << best_algorithm.ValueOrDie();
@@ -304,8 +374,6 @@ tensorflow::Status GemmThunk::ExecuteOnStream(
       }
     }
 
-    const StatusOr<se::blas::AlgorithmType>& best_algorithm =
-        autotune_it->second;
     if (best_algorithm.ok()) {
       auto algorithm = best_algorithm.ValueOrDie();
       VLOG(2) << "Using algorithm " << algorithm
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GEMM_THUNK_H_
 
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/device_memory_allocator.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
@@ -48,11 +49,26 @@ class GemmThunk : public Thunk {
   GemmThunk& operator=(const GemmThunk&) = delete;
 
   // Does the gemm operation for the thunk on "stream", which must be non-null.
+  // Auto-tuning happens on the first run of this function, unless Autotune()
+  // already found the best algorithm for this gemm on the same kind of device.
   tensorflow::Status ExecuteOnStream(
       const BufferAllocations& buffer_allocations,
       perftools::gputools::Stream* stream) override;
 
+  // Finds the fastest gemm algorithm on the device of "stream" ahead of the
+  // first run, by profiling the candidate algorithms on scratch operands
+  // allocated from "memory_allocator". Blocks until profiling is done.
+  tensorflow::Status Autotune(perftools::gputools::Stream* stream,
+                              DeviceMemoryAllocator* memory_allocator);
+
  private:
+  // Computes "output = lhs <dot> rhs" on the given buffers, autotuning first
+  // if the process-wide cache has no result for this gemm on this device.
+  tensorflow::Status RunGemm(perftools::gputools::DeviceMemoryBase lhs_data,
+                             perftools::gputools::DeviceMemoryBase rhs_data,
+                             perftools::gputools::DeviceMemoryBase output_data,
+                             perftools::gputools::Stream* stream);
+
   const BufferAllocation::Slice lhs_buffer_;
   const BufferAllocation::Slice rhs_buffer_;
   const BufferAllocation::Slice output_buffer_;
@@ -64,13 +80,9 @@ class GemmThunk : public Thunk {
   const bool transpose_lhs_;
   const bool transpose_rhs_;
 
-  // Maps device names (StreamExecutor::DeviceDescription::name()) to autotune
-  // results.  The map's value is the best algorithm we've found for this thunk
-  // on this device, or an error if none of the algorithms worked and we should
-  // use the regular gemm without an algorithm.
-  std::unordered_map<string,
-                     StatusOr<::perftools::gputools::blas::AlgorithmType>>
-      autotune_results_;
+  // Describes everything about this gemm that determines the best algorithm
+  // for it on a given device, i.e. everything but the buffers.
+  const string autotune_key_;
 };
 
 }  // namespace gpu
@@ -18,6 +18,7 @@ limitations under the License.
 #include <stdlib.h>
 #include <functional>
 #include <utility>
+#include <vector>
 
 #include "external/llvm/include/llvm/IR/DiagnosticInfo.h"
 #include "external/llvm/include/llvm/IR/DiagnosticPrinter.h"
@@ -28,10 +29,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/buffer_liveness.h"
+#include "tensorflow/compiler/xla/service/device_memory_allocator.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_folding.h"
+#include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/copy_insertion.h"
 #include "tensorflow/compiler/xla/service/gpu/fusion_merger.h"
+#include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
@@ -40,6 +44,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
 #include "tensorflow/compiler/xla/service/gpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/llvm_gpu_backend/gpu_backend_lib.h"
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/pad_insertion.h"
 #include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
@@ -53,9 +58,12 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
+#include "tensorflow/compiler/xla/service/hlo_scheduling.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -63,6 +71,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -149,7 +159,15 @@ tensorflow::Status OptimizeHloModule(HloModule* hlo_module,
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false);
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true);
     fusion.AddPass<FusionMerger>();
-    return fusion.Run(hlo_module).status();
+    TF_RETURN_IF_ERROR(fusion.Run(hlo_module).status());
+  }
+  {
+    // Multi-output fusion runs once, after producer-consumer fusion has
+    // reached a fixed point, so that the passes above never see fusion
+    // instructions with multiple outputs.
+    HloPassPipeline pipeline("multi-output fusion");
+    pipeline.AddPass<GpuMultiOutputFusion>();
+    return pipeline.Run(hlo_module).status();
   }
 }
 
@@ -222,6 +240,112 @@ void DumpPtxasInfo(const string& ptx) {
   }
 }
 
+// Autotunes the convolution and gemm thunks in "thunk_schedule" on the device
+// of "stream_exec", so that the first run of the executable does not spend
+// its time profiling cuDNN and cuBLAS algorithms. Autotuning is best effort:
+// e.g. if there is no device memory left for the scratch operands, the thunks
+// are autotuned on their first run instead.
+void AutotuneThunks(const ThunkSchedule& thunk_schedule,
+                    se::StreamExecutor* stream_exec) {
+  auto platform_status = se::MultiPlatformManager::PlatformWithId(
+      se::cuda::kCudaPlatformId);
+  if (!platform_status.ok()) {
+    LOG(WARNING) << "Skipping autotuning: " << platform_status.status();
+    return;
+  }
+  // StreamExecutorMemoryAllocator looks up stream executors by device ordinal.
+  std::vector<se::StreamExecutor*> stream_executors(
+      stream_exec->device_ordinal() + 1, nullptr);
+  stream_executors.back() = stream_exec;
+  StreamExecutorMemoryAllocator memory_allocator(platform_status.ValueOrDie(),
+                                                 stream_executors);
+  se::Stream stream(stream_exec);
+  stream.Init();
+
+  for (Thunk* thunk : thunk_schedule.TotalOrder()) {
+    tensorflow::Status status;
+    switch (thunk->kind()) {
+      case Thunk::Kind::kConvolution:
+        status = static_cast<ConvolutionThunk*>(thunk)->Autotune(
+            &stream, &memory_allocator);
+        break;
+      case Thunk::Kind::kGemm:
+        status = static_cast<GemmThunk*>(thunk)->Autotune(&stream,
+                                                          &memory_allocator);
+        break;
+      default:
+        break;
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to autotune thunk " << thunk
+                   << ", it will be autotuned on its first run: " << status;
+    }
+  }
+}
+
+// Rematerializes instructions in `module` to bring its peak memory use below
+// `memory_limit_bytes`, and builds an HLO schedule for the result. The
+// multi-stream schedule is kept when its launch order also fits in the limit;
+// otherwise all kernels are assigned to a single stream and launched in the
+// memory-minimizing order computed during rematerialization.
+StatusOr<std::unique_ptr<HloSchedule>> BuildMemoryLimitedSchedule(
+    HloModule* module, int64 memory_limit_bytes,
+    const HloCostAnalysis::ShapeSizeFunction& shape_size_function,
+    const LogicalBuffer::SizeFunction& buffer_size_function,
+    int64 pointer_size, std::unique_ptr<StreamAssignment>* stream_assignment) {
+  TF_ASSIGN_OR_RETURN(
+      const SequentialHloOrdering::HloModuleSequence initial_sequence,
+      CreateMemoryMinimizingSequence(*module, buffer_size_function));
+  TF_ASSIGN_OR_RETURN(
+      const int64 peak_memory_before,
+      MinimumMemoryForSequence(initial_sequence, buffer_size_function));
+
+  SequentialHloOrdering::HloModuleSequence sequence;
+  TF_ASSIGN_OR_RETURN(const bool changed,
+                      HloRematerialization::RematerializeAndSchedule(
+                          shape_size_function, memory_limit_bytes, module,
+                          &sequence));
+  TF_ASSIGN_OR_RETURN(const int64 peak_memory_after,
+                      MinimumMemoryForSequence(sequence, buffer_size_function));
+  LOG(INFO) << "Peak memory of module " << module->name() << " is "
+            << tensorflow::strings::HumanReadableNumBytes(peak_memory_after)
+            << (changed ? " after" : " without") << " rematerialization ("
+            << tensorflow::strings::HumanReadableNumBytes(peak_memory_before)
+            << " before), memory limit is "
+            << tensorflow::strings::HumanReadableNumBytes(memory_limit_bytes);
+  if (peak_memory_after > memory_limit_bytes) {
+    LOG(WARNING) << "Unable to reduce peak memory of module " << module->name()
+                 << " below the memory limit of "
+                 << tensorflow::strings::HumanReadableNumBytes(
+                        memory_limit_bytes);
+  }
+
+  const HloComputation* entry_computation = module->entry_computation();
+  *stream_assignment = AssignStreams(*module);
+  if ((*stream_assignment)->StreamCount() > 1) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<HloSchedule> schedule,
+        HloSchedule::Build(*module, **stream_assignment, pointer_size));
+    // Concurrent kernels can only extend buffer live ranges, so the memory
+    // needed by the launch order executed sequentially is a lower bound on
+    // the memory used by the multi-stream schedule.
+    SequentialHloOrdering::HloModuleSequence launch_sequence = sequence;
+    launch_sequence[entry_computation] = schedule->ThunkLaunchOrder();
+    TF_ASSIGN_OR_RETURN(
+        const int64 launch_order_memory,
+        MinimumMemoryForSequence(launch_sequence, buffer_size_function));
+    if (launch_order_memory <= memory_limit_bytes) {
+      return std::move(schedule);
+    }
+    VLOG(1) << "Multi-stream launch order needs at least "
+            << tensorflow::strings::HumanReadableNumBytes(launch_order_memory)
+            << "; launching all kernels on a single stream instead.";
+    *stream_assignment = AssignSingleStream(*module);
+  }
+  return HloSchedule::BuildFromSequence(*module, **stream_assignment,
+                                        sequence.at(entry_computation));
+}
+
 }  // namespace
 
 GpuCompiler::GpuCompiler()
@@ -253,11 +377,26 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
 
   // Determine the HLO schedule, which is an ordering of HLO instructions.  This
   // is used by buffer assignment to enable buffer reuse, and the same ordering
-  // must also be used to determine the thunk launch schedule.
-  std::unique_ptr<StreamAssignment> stream_assignment = AssignStreams(*module);
-  TF_ASSIGN_OR_RETURN(
-      std::unique_ptr<HloSchedule> hlo_schedule,
-      HloSchedule::Build(*module, *stream_assignment, pointer_size_));
+  // must also be used to determine the thunk launch schedule. Under a memory
+  // limit, rematerialization runs here since it must run after all passes
+  // that could undo it, and the schedule must follow its sequence.
+  std::unique_ptr<StreamAssignment> stream_assignment;
+  std::unique_ptr<HloSchedule> hlo_schedule;
+  const int64 memory_limit_bytes =
+      module->config().debug_options().xla_gpu_memory_limit_bytes();
+  if (memory_limit_bytes > 0) {
+    TF_ASSIGN_OR_RETURN(
+        hlo_schedule,
+        BuildMemoryLimitedSchedule(module.get(), memory_limit_bytes,
+                                   ShapeSizeBytesFunction(),
+                                   BufferSizeBytesFunction(), pointer_size_,
+                                   &stream_assignment));
+  } else {
+    stream_assignment = AssignStreams(*module);
+    TF_ASSIGN_OR_RETURN(
+        hlo_schedule,
+        HloSchedule::Build(*module, *stream_assignment, pointer_size_));
+  }
 
   // Run buffer analysis on the HLO graph. This analysis figures out which
   // temporary buffers are required to run the computation.
@@ -313,8 +452,31 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
     // Compute libdevice_dir_ just once and cache it in this member.
     libdevice_dir_ = GetLibdeviceDir(module->config());
   }
-  TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
-                                         module->config(), libdevice_dir_));
+
+  // The PTX is keyed by the unoptimized module, so look it up before
+  // CompileToPtx optimizes the module in place.
+  std::unique_ptr<PersistentCompilationCache> persistent_cache =
+      PersistentCompilationCache::Create(module->config().debug_options());
+  string persistent_cache_key;
+  bool found_in_persistent_cache = false;
+  if (persistent_cache != nullptr) {
+    persistent_cache_key = tensorflow::strings::StrCat(
+        PersistentCompilationCache::OptionsKey(
+            module->config().debug_options()),
+        ";triple=", kTargetTriple, ";sm_", cc_major, cc_minor,
+        ";libdevice_dir=", libdevice_dir_, "\n",
+        llvm_ir::DumpModuleToString(llvm_module));
+    found_in_persistent_cache =
+        persistent_cache->Lookup(persistent_cache_key, ptx);
+  }
+  if (!found_in_persistent_cache) {
+    TF_ASSIGN_OR_RETURN(*ptx,
+                        CompileToPtx(&llvm_module, {cc_major, cc_minor},
+                                     module->config(), libdevice_dir_));
+    if (persistent_cache != nullptr) {
+      persistent_cache->Insert(persistent_cache_key, *ptx);
+    }
+  }
 
   VLOG(2) << "LLVM module after optimizations:";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(llvm_module));
@@ -329,6 +491,7 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
       hlo_schedule->ThunkLaunchOrder());
   VLOG(2) << "Printing the thunk schedule...";
   XLA_VLOG_LINES(2, thunk_schedule->ToString());
+  AutotuneThunks(*thunk_schedule, stream_exec);
 
   auto* gpu_executable =
       new GpuExecutable(*ptx, std::move(thunk_schedule), std::move(module),
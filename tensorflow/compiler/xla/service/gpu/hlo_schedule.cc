@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/hlo_scheduling.h"
+#include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -214,5 +215,23 @@ StatusOr<std::unique_ptr<HloSchedule>> HloSchedule::Build(
   return std::move(schedule);
 }
 
+/* static */
+StatusOr<std::unique_ptr<HloSchedule>> HloSchedule::BuildFromSequence(
+    const HloModule& module, const StreamAssignment& stream_assignment,
+    const std::vector<const HloInstruction*>& entry_sequence) {
+  // With concurrent streams the launch order alone does not determine the
+  // liveness of buffers, so a given sequence is only honored on one stream.
+  TF_RET_CHECK(stream_assignment.StreamCount() == 1);
+  TF_RET_CHECK(entry_sequence.size() ==
+               module.entry_computation()->instruction_count());
+
+  std::unique_ptr<HloSchedule> schedule(new HloSchedule);
+  schedule->thunk_launch_order_ = entry_sequence;
+  schedule->hlo_ordering_ = MakeUnique<GpuHloOrdering>(
+      &module, stream_assignment, schedule->thunk_launch_order_);
+
+  return std::move(schedule);
+}
+
 }  // namespace gpu
 }  // namespace xla
@@ -42,6 +42,14 @@ class HloSchedule {
       const HloModule& module, const StreamAssignment& stream_assignment,
       int64 pointer_size);
 
+  // Constructs an HloSchedule for the given module whose instructions are all
+  // assigned to a single stream, launching thunks in the order of
+  // `entry_sequence`. `entry_sequence` must contain every instruction of the
+  // entry computation, e.g. the sequence computed by HloRematerialization.
+  static StatusOr<std::unique_ptr<HloSchedule>> BuildFromSequence(
+      const HloModule& module, const StreamAssignment& stream_assignment,
+      const std::vector<const HloInstruction*>& entry_sequence);
+
   // Returns the total order of thunk launches, represented in terms of HLO
   // instructions.
   const std::vector<const HloInstruction*>& ThunkLaunchOrder() const {
@@ -241,6 +241,47 @@ TEST_F(HloScheduleTest, ConcurrentMatMul) {
   EXPECT_FALSE(order->ExecutesBefore(add, add));
 }
 
+// Test of concurrent GEMMs forced onto a single stream, launched in a given
+// sequence.
+TEST_F(HloScheduleTest, SingleStreamFromSequence) {
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"y"));
+  HloInstruction* dot1 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kDot, x, y));
+  HloInstruction* dot2 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kDot, y, x));
+  HloInstruction* add = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kAdd, dot1, dot2));
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build(add));
+
+  // Multiple streams do not honor a given sequence.
+  std::unique_ptr<StreamAssignment> multi_streams = AssignStreams(*module);
+  const HloVec sequence({x, y, dot2, dot1, add});
+  EXPECT_FALSE(
+      HloSchedule::BuildFromSequence(*module, *multi_streams, sequence).ok());
+
+  std::unique_ptr<StreamAssignment> streams = AssignSingleStream(*module);
+  EXPECT_EQ(1, streams->StreamCount());
+  EXPECT_FALSE(streams->HasStreamAssigned(*x));
+  EXPECT_EQ(0, streams->StreamNumberForHlo(*dot1));
+  EXPECT_EQ(0, streams->StreamNumberForHlo(*dot2));
+
+  auto schedule = HloSchedule::BuildFromSequence(*module, *streams, sequence)
+                      .ConsumeValueOrDie();
+  EXPECT_EQ(sequence, schedule->ThunkLaunchOrder());
+
+  // On a single stream, the given sequence orders the concurrent GEMMs.
+  auto order = schedule->ConsumeHloOrdering();
+  EXPECT_TRUE(order->ExecutesBefore(dot2, dot1));
+  EXPECT_TRUE(order->ExecutesBefore(dot1, add));
+  EXPECT_FALSE(order->ExecutesBefore(dot1, dot2));
+}
+
 // Test of multiple streams.
 TEST_F(HloScheduleTest, LatticeMatMul) {
   //      d00      -- layer 0
@@ -24,6 +24,14 @@ namespace se = ::perftools::gputools;
 namespace xla {
 namespace gpu {
 
+namespace {
+
+// The most buffers kept for reuse, which bounds the memory held by the
+// infeed manager when the lengths of the transfers vary.
+constexpr int kMaxFreeBuffers = 8;
+
+}  // namespace
+
 InfeedManager::InfeedManager() : host_to_device_executor_(nullptr) {}
 
 void InfeedManager::Reset() {
@@ -33,6 +41,14 @@ void InfeedManager::Reset() {
     buffer->Done();
   }
   enqueued_buffer_.clear();
+  for (auto buffer : released_buffer_) {
+    buffer->Done();
+  }
+  released_buffer_.clear();
+  for (auto buffer : free_buffer_) {
+    buffer->Done();
+  }
+  free_buffer_.clear();
 }
 
 void InfeedManager::EnqueueBuffers(std::vector<InfeedBuffer*> buffers) {
@@ -50,6 +66,40 @@ void InfeedManager::EnqueueBuffers(std::vector<InfeedBuffer*> buffers) {
   }
 }
 
+InfeedBuffer* InfeedManager::AcquireBuffer(se::StreamExecutor* executor,
+                                           int64 length) {
+  InfeedBuffer* buffer = nullptr;
+  std::vector<InfeedBuffer*> evicted;
+  {
+    tensorflow::mutex_lock l(mu_);
+    // The runtime consumes the buffers in the order it releases them.
+    while (!released_buffer_.empty() &&
+           released_buffer_.front()->consumed()->PollForStatus() !=
+               se::Event::Status::kPending) {
+      free_buffer_.push_back(released_buffer_.front());
+      released_buffer_.pop_front();
+    }
+    for (auto it = free_buffer_.begin(); it != free_buffer_.end(); ++it) {
+      if ((*it)->executor() == executor && (*it)->length() == length) {
+        buffer = *it;
+        free_buffer_.erase(it);
+        break;
+      }
+    }
+    while (free_buffer_.size() > kMaxFreeBuffers) {
+      evicted.push_back(free_buffer_.front());
+      free_buffer_.pop_front();
+    }
+  }
+  for (InfeedBuffer* b : evicted) {
+    b->Done();
+  }
+  if (buffer == nullptr) {
+    buffer = new InfeedBuffer(executor, length);
+  }
+  return buffer;
+}
+
 InfeedBuffer* InfeedManager::BlockingDequeueBuffer() {
   tensorflow::mutex_lock l(mu_);
   while (enqueued_buffer_.empty()) {
@@ -62,15 +112,11 @@ InfeedBuffer* InfeedManager::BlockingDequeueBuffer() {
 }
 
 void InfeedManager::ReleaseBuffers(std::vector<InfeedBuffer*> buffers) {
-  {
-    tensorflow::mutex_lock l(mu_);
-    for (gpu::InfeedBuffer* b : buffers) {
-      CHECK(ContainsKey(dequeued_buffer_, b));
-      dequeued_buffer_.erase(b);
-    }
-  }
+  tensorflow::mutex_lock l(mu_);
   for (gpu::InfeedBuffer* b : buffers) {
-    b->Done();
+    CHECK(ContainsKey(dequeued_buffer_, b));
+    dequeued_buffer_.erase(b);
+    released_buffer_.push_back(b);
   }
 }
 
@@ -37,23 +37,33 @@ namespace gpu {
 // Current limitations:
 // * Does not handle multiple devices/replicas.
 //
-// * Buffer space on GPU is allocated on every infeed enqueue request,
-// and it does not handle the case when it runs out of
-// memory. Potential solution is to pre-allocate a fixed amount of
-// memory and block when that memory is full.
+// * It does not handle the case when the GPU runs out of memory for
+// infeed buffers. Potential solution is to pre-allocate a fixed amount
+// of memory and block when that memory is full.
+//
+// Transfers are pipelined: the client does not wait for the transfer of
+// a buffer to the GPU, and the runtime does not wait for its copy out of
+// the buffer. Events order them on the GPU instead, and the buffers whose
+// data was consumed are reused for later transfers of the same length.
 
 // Defines an infeed buffer that is passed to the runtime by
 // the client. The client manages the memory of the buffer.
 class InfeedBuffer {
  public:
   InfeedBuffer(perftools::gputools::StreamExecutor* executor, int64 length)
-      : executor_(executor), length_(length) {
+      : executor_(executor),
+        length_(length),
+        transferred_(executor),
+        consumed_(executor) {
     device_memory_ = executor_->AllocateArray<uint8>(length);
     CHECK(!device_memory_.is_null());
+    CHECK(transferred_.Init());
+    CHECK(consumed_.Init());
   }
 
   ~InfeedBuffer() { executor_->Deallocate(&device_memory_); }
 
+  perftools::gputools::StreamExecutor* executor() const { return executor_; }
   int64 length() const { return length_; }
 
   // Callback to signal that this buffer is consumed. This helps the
@@ -64,10 +74,20 @@ class InfeedBuffer {
     return &device_memory_;
   }
 
+  // Recorded on the infeed stream once the data is transferred to the
+  // buffer. The runtime waits for it before reading the buffer.
+  perftools::gputools::Event* transferred() { return &transferred_; }
+
+  // Recorded by the runtime once it has read the buffer, after which the
+  // buffer may be reused.
+  perftools::gputools::Event* consumed() { return &consumed_; }
+
  private:
   perftools::gputools::StreamExecutor* executor_;  // Not owned.
   const int64 length_;
   perftools::gputools::DeviceMemoryBase device_memory_;
+  perftools::gputools::Event transferred_;
+  perftools::gputools::Event consumed_;
 };
 
 // Client-side class used to enqueue infeed buffers.
@@ -76,8 +96,8 @@ class InfeedManager {
   InfeedManager();
 
   // Calls the completion callback for any enqueued buffers that have
-  // not been dequeued by the runtime, and empties the infeed
-  // queue. Reset may not be called while a runtime computation is
+  // not been dequeued by the runtime, and for the released buffers, and
+  // empties the infeed queue. Reset may not be called while a runtime computation is
   // processing a dequeued buffer. The only safe way to ensure this
   // condition is to call Reset when no computation is taking place.
   void Reset();
@@ -88,12 +108,20 @@ class InfeedManager {
   // runtime has dequeued and used the buffer.
   void EnqueueBuffers(std::vector<InfeedBuffer*> buffers);
 
+  // Returns a buffer of 'length' bytes on 'executor' to transfer data
+  // to. Reuses a released buffer whose data the runtime has consumed if
+  // there is one, and allocates a new buffer otherwise.
+  InfeedBuffer* AcquireBuffer(perftools::gputools::StreamExecutor* executor,
+                              int64 length);
+
   // Blocks until the infeed queue is non-empty, then returns the
   // buffer at the head of the queue. Adds the current buffer to the
   // to-be released set.
   InfeedBuffer* BlockingDequeueBuffer();
 
-  // Releases a set of buffers from the to-be released set.
+  // Releases a set of buffers from the to-be released set. The runtime
+  // must have recorded their consumed() events, after which they may be
+  // returned by AcquireBuffer.
   void ReleaseBuffers(std::vector<InfeedBuffer*> buffers);
 
   // Returns a cached stream associated with an executor. Allocates a
@@ -120,6 +148,13 @@ class InfeedManager {
   // runtime. Not owned.
   tensorflow::gtl::FlatSet<const InfeedBuffer*> dequeued_buffer_;
 
+  // Buffers released by the runtime, in release order, whose consumed()
+  // events may still be pending. Owned.
+  std::deque<InfeedBuffer*> released_buffer_;
+
+  // Released buffers that are ready to be reused, oldest first. Owned.
+  std::deque<InfeedBuffer*> free_buffer_;
+
   // Cached host to device stream for queuing infeed data.
   std::unique_ptr<perftools::gputools::Stream> host_to_device_stream_;
 
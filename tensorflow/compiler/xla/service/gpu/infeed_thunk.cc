@@ -51,23 +51,30 @@ tensorflow::Status InfeedThunk::ExecuteOnStream(
 
       InfeedBuffer* buffer = infeed_manager->BlockingDequeueBuffer();
       infeed_buffers.push_back(buffer);
+      stream->ThenWaitFor(buffer->transferred());
       stream->ThenMemcpy(&tuple_element_address, *(buffer->device_memory()),
                          buffer->length());
       tuple_element_addresses.push_back(tuple_element_address.opaque());
     }
-    // Transfer the tuple outer buffer.
+    // Transfer the tuple outer buffer. The copy from pageable host memory
+    // is staged before ThenMemcpy returns, so the addresses may go away.
     auto host_size = tuple_element_addresses.size() * sizeof(void*);
     stream->ThenMemcpy(&destination_address, tuple_element_addresses.data(),
                        host_size);
   } else {
     InfeedBuffer* buffer = infeed_manager->BlockingDequeueBuffer();
     infeed_buffers.push_back(buffer);
+    stream->ThenWaitFor(buffer->transferred());
     stream->ThenMemcpy(&destination_address, *(buffer->device_memory()),
                        buffer->length());
   }
 
-  if (!stream->BlockHostUntilDone()) {
-    return InternalError("Failed to complete data transfer on stream %p",
+  // Don't wait for the copies: the buffers are reused once they are done.
+  for (InfeedBuffer* buffer : infeed_buffers) {
+    stream->ThenRecordEvent(buffer->consumed());
+  }
+  if (!stream->ok()) {
+    return InternalError("Failed to enqueue data transfer on stream %p",
                          stream);
   }
 
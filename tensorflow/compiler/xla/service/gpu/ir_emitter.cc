@@ -537,6 +537,9 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
   // kFusion for library calls should be handled by
   // IrEmitterUnnested::HandleFusion.
   CHECK(HloInstruction::FusionKind::kLoop == fusion->fusion_kind());
+  // Multi-output fusion needs a thunk writing its output tuple, and is handled
+  // by IrEmitterUnnested::HandleFusion as well.
+  TF_RET_CHECK(!fusion->IsMultiOutputFusion()) << fusion->ToString();
 
   std::vector<llvm_ir::IrArray> parameter_arrays;
   for (HloInstruction* operand : fusion->operands()) {
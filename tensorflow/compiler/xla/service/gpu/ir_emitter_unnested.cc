@@ -450,6 +450,77 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
     return ParallelLoopEmitter(loop_body_emitter, update_shape,
                                launch_dimensions, &ir_builder_)
         .EmitLoop();
+  } else if (fusion->IsMultiOutputFusion()) {
+    // Loop fusion instruction with a tuple of outputs as fused root (see
+    // GpuMultiOutputFusion). All outputs have the same dimensions, so a single
+    // loop computes an element of every output per iteration, and reads
+    // shared by the outputs are emitted once.
+    CHECK(HloInstruction::FusionKind::kLoop == fusion->fusion_kind());
+    const int64 num_outputs = ShapeUtil::TupleElementCount(fusion->shape());
+
+    // The kernel writes the output arrays through the addresses stored in the
+    // fusion's tuple buffer, so a TupleThunk fills in that buffer first.
+    std::vector<BufferAllocation::Slice> output_buffers;
+    for (int64 i = 0; i < num_outputs; ++i) {
+      output_buffers.push_back(ir_emitter_context_->buffer_assignment()
+                                   .GetUniqueSlice(fusion, {i})
+                                   .ConsumeValueOrDie());
+    }
+    std::vector<std::unique_ptr<Thunk>> thunks;
+    thunks.emplace_back(MakeUnique<TupleThunk>(
+        output_buffers, GetAllocationSlice(*fusion), fusion));
+    thunks.emplace_back(BuildKernelThunk(fusion));
+    auto* kernel_thunk = static_cast<KernelThunk*>(thunks.back().get());
+    thunk_sequence_->emplace_back(
+        MakeUnique<SequentialThunk>(std::move(thunks), fusion));
+
+    std::vector<llvm_ir::IrArray> parameter_arrays;
+    for (HloInstruction* operand : fusion->operands()) {
+      parameter_arrays.push_back(GetIrArray(*operand));
+    }
+    GpuElementalIrEmitter elemental_emitter(hlo_module_config_,
+                                            ir_emitter_context_->llvm_module(),
+                                            &ir_builder_, GetNestedComputer());
+    FusedIrEmitter fused_emitter(parameter_arrays, &elemental_emitter);
+    TF_RETURN_IF_ERROR(root->Accept(&fused_emitter));
+
+    std::vector<llvm_ir::ElementGenerator> output_generators;
+    std::vector<llvm_ir::IrArray> output_arrays;
+    for (int64 i = 0; i < num_outputs; ++i) {
+      output_generators.push_back(fused_emitter.GetGenerator(root->operand(i)));
+      const Shape& output_shape =
+          ShapeUtil::GetTupleElementShape(fusion->shape(), i);
+      output_arrays.push_back(llvm_ir::IrArray(
+          llvm_ir::EmitGetTupleElement(output_shape, i, /*alignment=*/1,
+                                       GetBasePointer(*fusion), &ir_builder_),
+          output_shape));
+    }
+
+    // Generate the values of all outputs at 'index' before storing any, so
+    // that subexpressions shared by the outputs are emitted once.
+    auto loop_body_emitter =
+        [=](const llvm_ir::IrArray::Index& index) -> Status {
+      std::vector<llvm::Value*> output_values;
+      for (const auto& output_generator : output_generators) {
+        TF_ASSIGN_OR_RETURN(llvm::Value * output_value,
+                            output_generator(index));
+        output_values.push_back(output_value);
+      }
+      for (int64 i = 0; i < num_outputs; ++i) {
+        output_arrays[i].EmitWriteArrayElement(index, output_values[i],
+                                               &ir_builder_);
+      }
+      return Status::OK();
+    };
+
+    const Shape& loop_shape = output_arrays.front().GetShape();
+    LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
+        loop_shape, ir_emitter_context_->device_description());
+    UpdateLaunchDimensions(launch_dimensions, kernel_thunk,
+                           ir_emitter_context_->llvm_module());
+    return ParallelLoopEmitter(loop_body_emitter, loop_shape,
+                               launch_dimensions, &ir_builder_)
+        .EmitLoop();
   }
   if (ImplementedAsGemm(*fusion)) {
     thunk_sequence_->emplace_back(BuildGemmThunk(fusion));
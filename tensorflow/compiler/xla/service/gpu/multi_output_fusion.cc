@@ -0,0 +1,192 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Partitions the users of 'operand' which are sibling fusion candidates into
+// groups of instructions that can be fused together, and returns the first
+// group with at least two instructions, or an empty vector if there is none.
+std::vector<HloInstruction*> FindSiblingGroup(
+    const HloInstruction& operand,
+    const HloComputation::ReachabilityMap& reachability) {
+  std::vector<std::vector<HloInstruction*>> groups;
+  for (HloInstruction* user : operand.users()) {
+    if (!GpuMultiOutputFusion::IsSiblingFusionCandidate(*user)) {
+      continue;
+    }
+    bool grouped = false;
+    for (auto& group : groups) {
+      if (!ShapeUtil::SameDimensions(group.front()->shape(), user->shape())) {
+        continue;
+      }
+      if (std::any_of(group.begin(), group.end(),
+                      [&](const HloInstruction* member) {
+                        return reachability.IsConnected(member, user);
+                      })) {
+        continue;
+      }
+      group.push_back(user);
+      grouped = true;
+      break;
+    }
+    if (!grouped) {
+      groups.push_back({user});
+    }
+  }
+  for (auto& group : groups) {
+    if (group.size() > 1) {
+      return group;
+    }
+  }
+  return {};
+}
+
+// Fuses 'siblings' into a new loop fusion instruction whose fused root is a
+// tuple of the siblings, and redirects all users of each sibling to the
+// respective element of the fusion's output.
+void FuseSiblings(tensorflow::gtl::ArraySlice<HloInstruction*> siblings,
+                  HloComputation* computation) {
+  HloInstruction* tuple =
+      computation->AddInstruction(HloInstruction::CreateTuple(siblings));
+  HloInstruction* fusion =
+      computation->AddInstruction(HloInstruction::CreateFusion(
+          tuple->shape(), HloInstruction::FusionKind::kLoop, tuple));
+  fusion->set_metadata(siblings.front()->metadata());
+
+  for (int64 i = 0; i < siblings.size(); ++i) {
+    HloInstruction* sibling = siblings[i];
+    HloInstruction* gte =
+        computation->AddInstruction(HloInstruction::CreateGetTupleElement(
+            sibling->shape(), fusion, i));
+    // Copy the user list, it is modified by ReplaceUseWith.
+    std::vector<HloInstruction*> users = sibling->users();
+    for (HloInstruction* user : users) {
+      if (user != tuple && user != fusion) {
+        TF_CHECK_OK(sibling->ReplaceUseWith(user, gte));
+      }
+    }
+    if (computation->root_instruction() == sibling) {
+      computation->set_root_instruction(gte);
+    }
+  }
+
+  for (HloInstruction* sibling : siblings) {
+    if (sibling->opcode() == HloOpcode::kFusion) {
+      fusion->MergeFusionInstruction(sibling);
+    } else {
+      fusion->FuseInstruction(sibling);
+    }
+  }
+  // The siblings are now only used by 'tuple', so this removes them too.
+  TF_CHECK_OK(computation->RemoveInstructionAndUnusedOperands(tuple));
+}
+
+// Fuses the first group of fusable siblings found in 'computation'. Returns
+// whether a group was fused.
+bool FuseOneSiblingGroup(HloComputation* computation) {
+  // Reachability changes with every fusion, so it is recomputed per group.
+  std::unique_ptr<HloComputation::ReachabilityMap> reachability =
+      computation->ComputeReachability();
+  for (HloInstruction* instruction : computation->MakeInstructionPostOrder()) {
+    // Reading a shared scalar once instead of several times saves nothing, so
+    // only siblings sharing an array are fused.
+    if (!ShapeUtil::IsArray(instruction->shape()) ||
+        ShapeUtil::IsScalar(instruction->shape())) {
+      continue;
+    }
+    std::vector<HloInstruction*> siblings =
+        FindSiblingGroup(*instruction, *reachability);
+    if (siblings.empty()) {
+      continue;
+    }
+    VLOG(2) << "Fusing siblings using " << instruction->name() << " { "
+            << tensorflow::str_util::Join(
+                   siblings, ", ",
+                   [](string* out, HloInstruction* sibling) {
+                     tensorflow::strings::StrAppend(out, sibling->name());
+                   })
+            << " }";
+    FuseSiblings(siblings, computation);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+/* static */ bool GpuMultiOutputFusion::IsSiblingFusionCandidate(
+    const HloInstruction& instruction) {
+  // Each output is computed in the same loop, so outputs must be arrays.
+  // Instructions producing scalars are left alone; they are cheap, and are
+  // also found in nested computations, which are emitted without kernels.
+  if (!ShapeUtil::IsArray(instruction.shape()) ||
+      ShapeUtil::IsScalar(instruction.shape())) {
+    return false;
+  }
+  if (!instruction.control_predecessors().empty() ||
+      !instruction.control_successors().empty()) {
+    return false;
+  }
+  if (instruction.opcode() == HloOpcode::kFusion) {
+    // Input fusions and library calls are emitted with specialized kernels.
+    // A DynamicUpdateSlice fusion may update its operand in place, which does
+    // not map to an element loop over its output shape.
+    return instruction.fusion_kind() == HloInstruction::FusionKind::kLoop &&
+           instruction.fused_expression_root()->opcode() !=
+               HloOpcode::kDynamicUpdateSlice;
+  }
+  // Rng may only be fused into its single user, so that all users observe the
+  // same random numbers.
+  return instruction.IsElementwise() && instruction.IsFusable() &&
+         instruction.opcode() != HloOpcode::kRng;
+}
+
+StatusOr<bool> GpuMultiOutputFusion::Run(HloModule* module) {
+  bool changed = false;
+  for (auto& computation : module->computations()) {
+    bool computation_changed = false;
+    while (FuseOneSiblingGroup(computation.get())) {
+      computation_changed = true;
+    }
+    if (computation_changed) {
+      VLOG(1) << "After running GpuMultiOutputFusion for computation: "
+              << computation->name();
+      XLA_VLOG_LINES(3, computation->ToString());
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
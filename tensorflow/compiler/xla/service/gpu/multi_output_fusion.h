@@ -0,0 +1,62 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// An HLO pass that fuses sibling instructions, i.e. instructions which share
+// an operand, into a single loop fusion instruction with multiple outputs.
+//
+// Without this pass each sibling is emitted as its own kernel, and the shared
+// operand is read from memory once per sibling. The multi-output fusion is
+// emitted as one kernel which computes one element of every output per loop
+// iteration, so the shared operand is read once and one kernel launch is
+// saved per fused sibling.
+//
+// The root of the resulting fusion instruction is a kTuple of the fused
+// siblings, and the former users of each sibling read its value through a
+// GetTupleElement of the fusion instruction. Siblings are fused if
+//
+// 1) they are loop fusion instructions or unfused elementwise instructions
+//    with a non-scalar array shape,
+// 2) they all have the same dimensions, so that they can share a loop, and
+// 3) none of them is reachable from another, so that fusing them does not
+//    introduce a cycle.
+//
+// This pass should run after GpuInstructionFusion and FusionMerger, which
+// handle producer-consumer fusion.
+class GpuMultiOutputFusion : public HloPassInterface {
+ public:
+  tensorflow::StringPiece name() const override {
+    return "multi-output fusion";
+  }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // Returns whether 'instruction' may be fused with its siblings.
+  static bool IsSiblingFusionCandidate(const HloInstruction& instruction);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
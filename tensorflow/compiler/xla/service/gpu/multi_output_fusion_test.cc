@@ -0,0 +1,157 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class MultiOutputFusionTest : public HloTestBase {
+ protected:
+  MultiOutputFusionTest() : module_(CreateNewModule()) {}
+
+  Shape data_shape_ = ShapeUtil::MakeShape(F32, {4, 4});
+  std::unique_ptr<HloModule> module_;
+};
+
+// Checks that 'instruction' is element 'index' of a multi-output fusion and
+// returns the fusion.
+const HloInstruction* GetMultiOutputFusion(const HloInstruction* instruction,
+                                           int64 index) {
+  EXPECT_EQ(HloOpcode::kGetTupleElement, instruction->opcode());
+  EXPECT_EQ(index, instruction->tuple_index());
+  const HloInstruction* fusion = instruction->operand(0);
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_EQ(HloInstruction::FusionKind::kLoop, fusion->fusion_kind());
+  return fusion;
+}
+
+//           Param
+//           /   \
+//         Exp   Negate
+//           \   /
+//           Tuple
+//
+TEST_F(MultiOutputFusionTest, FuseSiblingElementwiseInstructions) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  auto negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kNegate, param));
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, negate}));
+  auto computation = module_->AddEntryComputation(builder.Build());
+
+  EXPECT_TRUE(GpuMultiOutputFusion().Run(module_.get()).ValueOrDie());
+
+  auto* root = computation->root_instruction();
+  EXPECT_EQ(HloOpcode::kTuple, root->opcode());
+  const HloInstruction* fusion = GetMultiOutputFusion(root->operand(0), 0);
+  EXPECT_EQ(fusion, GetMultiOutputFusion(root->operand(1), 1));
+  // The shared parameter is read once.
+  ASSERT_EQ(1, fusion->operand_count());
+  EXPECT_EQ(param, fusion->operand(0));
+  const HloInstruction* fused_root = fusion->fused_expression_root();
+  EXPECT_EQ(HloOpcode::kExp, fused_root->operand(0)->opcode());
+  EXPECT_EQ(HloOpcode::kNegate, fused_root->operand(1)->opcode());
+  // Param, the tuple, and the new fusion with its two GetTupleElements.
+  EXPECT_EQ(5, computation->instruction_count());
+}
+
+//               Param
+//               /    \
+//           Add        Subtract
+//            |            |
+//         Multiply     Multiply
+//               \     /
+//                Tuple
+//
+TEST_F(MultiOutputFusionTest, FuseSiblingLoopFusions) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto add = builder.AddInstruction(HloInstruction::CreateBinary(
+      data_shape_, HloOpcode::kAdd, param, param));
+  auto mul0 = builder.AddInstruction(HloInstruction::CreateBinary(
+      data_shape_, HloOpcode::kMultiply, add, add));
+  auto sub = builder.AddInstruction(HloInstruction::CreateBinary(
+      data_shape_, HloOpcode::kSubtract, param, param));
+  auto mul1 = builder.AddInstruction(HloInstruction::CreateBinary(
+      data_shape_, HloOpcode::kMultiply, sub, sub));
+  builder.AddInstruction(HloInstruction::CreateTuple({mul0, mul1}));
+  auto computation = module_->AddEntryComputation(builder.Build());
+
+  EXPECT_TRUE(GpuInstructionFusion(/*may_duplicate=*/false)
+                  .Run(module_.get())
+                  .ValueOrDie());
+  EXPECT_TRUE(GpuMultiOutputFusion().Run(module_.get()).ValueOrDie());
+
+  auto* root = computation->root_instruction();
+  EXPECT_EQ(HloOpcode::kTuple, root->opcode());
+  const HloInstruction* fusion = GetMultiOutputFusion(root->operand(0), 0);
+  EXPECT_EQ(fusion, GetMultiOutputFusion(root->operand(1), 1));
+  ASSERT_EQ(1, fusion->operand_count());
+  EXPECT_EQ(param, fusion->operand(0));
+  // One parameter, both fused expressions and the tuple.
+  EXPECT_EQ(6, fusion->fused_instructions().size());
+}
+
+//           Param
+//           /   |
+//         Exp   |
+//           \   |
+//            Add
+//
+TEST_F(MultiOutputFusionTest, DoNotFuseDependentSiblings) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(data_shape_, HloOpcode::kAdd, exp, param));
+  module_->AddEntryComputation(builder.Build());
+
+  EXPECT_FALSE(GpuMultiOutputFusion().Run(module_.get()).ValueOrDie());
+}
+
+TEST_F(MultiOutputFusionTest, DoNotFuseSiblingsOfScalar) {
+  auto builder = HloComputation::Builder(TestName());
+  Shape scalar_shape = ShapeUtil::MakeShape(F32, {});
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, scalar_shape, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(scalar_shape, HloOpcode::kExp, param));
+  auto negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(scalar_shape, HloOpcode::kNegate, param));
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, negate}));
+  module_->AddEntryComputation(builder.Build());
+
+  EXPECT_FALSE(GpuMultiOutputFusion().Run(module_.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
+
+int main(int argc, char** argv) {
+  return xla::ParseDebugOptionsFlagsAndRunTests(argc, argv);
+}
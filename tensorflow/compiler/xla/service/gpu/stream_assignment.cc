@@ -130,5 +130,16 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   return stream_assignment;
 }
 
+std::unique_ptr<StreamAssignment> AssignSingleStream(const HloModule& module) {
+  auto stream_assignment = MakeUnique<StreamAssignment>();
+  for (const auto& hlo : module.entry_computation()->instructions()) {
+    if (hlo->opcode() != HloOpcode::kParameter &&
+        hlo->opcode() != HloOpcode::kConstant) {
+      stream_assignment->AssignStreamToHlo(hlo.get(), /*stream_no=*/0);
+    }
+  }
+  return stream_assignment;
+}
+
 }  // namespace gpu
 }  // namespace xla
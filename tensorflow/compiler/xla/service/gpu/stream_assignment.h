@@ -40,6 +40,11 @@ class StreamAssignment {
 // Assigns GPU streams to instructions in `module`.
 std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module);
 
+// Assigns all instructions in `module` which need a thunk to the main stream.
+// Kernels then run strictly in thunk launch order, which may be chosen to
+// minimize memory usage.
+std::unique_ptr<StreamAssignment> AssignSingleStream(const HloModule& module);
+
 }  // namespace gpu
 }  // namespace xla
 
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/while_transformer.h"
 
+#include <limits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/compiler/xla/literal_util.h"
@@ -86,6 +88,12 @@ class ExprTree {
       : opcode_(opcode), tag_(tag) {
     SetOperand(0, operand0);
   }
+  ExprTree(HloOpcode opcode, const string& tag, int64 index0,
+           const ExprTree& operand0, int64 index1, const ExprTree& operand1)
+      : opcode_(opcode), tag_(tag) {
+    SetOperand(index0, operand0);
+    SetOperand(index1, operand1);
+  }
   ExprTree(HloOpcode opcode, const ExprTree& operand0, const ExprTree& operand1)
       : opcode_(opcode) {
     SetOperand(0, operand0);
@@ -235,20 +243,37 @@ class MatcherBase {
 //
 // *) 'loop_limit':
 //    *) The integral value from Constant root operand in matched computation.
-//    *) Used as the constant for the loop limit.
+//    *) Used as the constant for the (exclusive) loop limit.
+//
+// The induction variable may be compared on either side of the comparison,
+// with either a strict (i < limit, limit > i) or an inclusive (i <= limit,
+// limit >= i) bound, and the comparison may or may not have been fused.
 //
 class WhileConditionComputationMatcher : public MatcherBase {
  public:
   explicit WhileConditionComputationMatcher(const HloComputation* computation)
       : computation_(computation) {
-    expr_trees_.emplace_back(BuildCondExprTree());
+    // The comparisons with the induction variable as their lhs, and the
+    // equivalent ones with the induction variable as their rhs.
+    const std::pair<HloOpcode, HloOpcode> kComparisons[] = {
+        {HloOpcode::kLt, HloOpcode::kGt}, {HloOpcode::kLe, HloOpcode::kGe}};
+    for (const auto& comparison : kComparisons) {
+      expr_trees_.emplace_back(BuildCondExprTree(comparison.first, 0, 0));
+      expr_trees_.emplace_back(BuildCondExprTree(comparison.first, 0, 1));
+      expr_trees_.emplace_back(BuildCondExprTree(comparison.second, 1, 0));
+      expr_trees_.emplace_back(BuildCondExprTree(comparison.second, 1, 1));
+      expr_trees_.emplace_back(BuildUnfusedCondExprTree(comparison.first, 0));
+      expr_trees_.emplace_back(BuildUnfusedCondExprTree(comparison.second, 1));
+    }
   }
 
   int64 loop_limit() const { return loop_limit_; }
   int64 tuple_index() const { return tuple_index_; }
 
  private:
-  // Builds expression tree for the following condition computation:
+  // Builds expression tree for the following condition computation, where
+  // 'gte_index' is the operand index of GTE in the fused comparison, and
+  // 'param_index' the operand index of Parameter in the fusion:
   //
   //     Const  Parameter
   //        \     /
@@ -256,25 +281,44 @@ class WhileConditionComputationMatcher : public MatcherBase {
   //                                  \          /
   //                                  GTE       /
   //                                    \      /
-  //                                    LessThan (fused root)
+  //                                    Compare (fused root)
   //
-  ExprTree BuildCondExprTree() {
+  ExprTree BuildCondExprTree(const HloOpcode compare, const int64 gte_index,
+                             const int64 param_index) {
     // Build ExprTree for fused instructions.
     ExprTree fused_root(
-        HloOpcode::kLt,
+        compare, "compare", gte_index,
         ExprTree(HloOpcode::kGetTupleElement, "gte",
                  ExprTree(HloOpcode::kParameter, "gte.fusion_param.param0")),
-        ExprTree(HloOpcode::kParameter));
+        1 - gte_index, ExprTree(HloOpcode::kParameter));
 
     // Build top-level computation.
-    ExprTree root(HloOpcode::kFusion,
-                  ExprTree(HloOpcode::kConstant, "loop_limit"),
+    ExprTree root(HloOpcode::kFusion, 1 - param_index,
+                  ExprTree(HloOpcode::kConstant, "loop_limit"), param_index,
                   ExprTree(HloOpcode::kParameter, "param0"));
 
     root.SetFusedRoot(fused_root);
     return root;
   }
 
+  // Builds expression tree for the following unfused condition computation,
+  // where 'gte_index' is the operand index of GTE in the comparison:
+  //
+  //     Parameter
+  //         |
+  //        GTE   Const
+  //          \    /
+  //          Compare
+  //
+  ExprTree BuildUnfusedCondExprTree(const HloOpcode compare,
+                                    const int64 gte_index) {
+    return ExprTree(compare, "compare", gte_index,
+                    ExprTree(HloOpcode::kGetTupleElement, "gte",
+                             ExprTree(HloOpcode::kParameter, "param0")),
+                    1 - gte_index,
+                    ExprTree(HloOpcode::kConstant, "loop_limit"));
+  }
+
   Status MatchExprTree(const ExprTree& expr_tree) override {
     VLOG(2) << "MATCHING while condition";
     ExprTree::TaggedInstructionMap tagged_instructions;
@@ -292,6 +336,17 @@ class WhileConditionComputationMatcher : public MatcherBase {
         GetTaggedInstruction("loop_limit", tagged_instructions));
     TF_RETURN_IF_ERROR(ParseConstInteger(const_hlo, &loop_limit_));
 
+    // Make an inclusive limit exclusive.
+    TF_ASSIGN_OR_RETURN(const HloInstruction* compare,
+                        GetTaggedInstruction("compare", tagged_instructions));
+    if (compare->opcode() == HloOpcode::kLe ||
+        compare->opcode() == HloOpcode::kGe) {
+      if (loop_limit_ == std::numeric_limits<int64>::max()) {
+        return InvalidArgument("Loop limit is too large.");
+      }
+      ++loop_limit_;
+    }
+
     // Get tagged "param0" instruction, and check that it matches
     // 'computation_' parameter 0.
     TF_ASSIGN_OR_RETURN(const HloInstruction* param0,
@@ -302,10 +357,13 @@ class WhileConditionComputationMatcher : public MatcherBase {
     }
 
     // Get tagged 'gte.fusion_param.param0', find its associated fusion operand,
-    // and compare it to 'computation_' parameter0.
-    TF_ASSIGN_OR_RETURN(
-        const HloInstruction* gte_fusion_param0,
-        GetTaggedInstruction("gte.fusion_param.param0", tagged_instructions));
+    // and compare it to 'computation_' parameter0. The unfused comparison has
+    // no fusion parameter.
+    auto it = tagged_instructions.find("gte.fusion_param.param0");
+    if (it == tagged_instructions.end()) {
+      return tensorflow::Status::OK();
+    }
+    const HloInstruction* gte_fusion_param0 = it->second;
     CHECK_EQ(HloOpcode::kParameter, gte_fusion_param0->opcode());
     CHECK(gte_fusion_param0->IsFused());
     if (gte_fusion_param0->fusion_instruction()->operand(
@@ -336,13 +394,15 @@ class WhileInitOperandMatcher : public MatcherBase {
   WhileInitOperandMatcher(const HloInstruction* while_hlo,
                           const int64 tuple_index)
       : while_hlo_(while_hlo), tuple_index_(tuple_index) {
-    expr_trees_.emplace_back(BuildInitExprTree());
+    expr_trees_.emplace_back(BuildInitExprTree(/*with_copy=*/true));
+    expr_trees_.emplace_back(BuildInitExprTree(/*with_copy=*/false));
   }
 
   int64 loop_start() const { return loop_start_; }
 
  private:
-  // Builds expression tree for the following while init operand subcomputation:
+  // Builds expression tree for the following while init operand subcomputation,
+  // whose Copy is optional:
   //
   //             Const
   //               |
@@ -352,12 +412,13 @@ class WhileInitOperandMatcher : public MatcherBase {
   //               |
   //             While
   //
-  ExprTree BuildInitExprTree() {
+  ExprTree BuildInitExprTree(const bool with_copy) {
+    ExprTree loop_start(HloOpcode::kConstant, "loop_start");
     return ExprTree(
         HloOpcode::kWhile, "while",
         ExprTree(HloOpcode::kTuple, tuple_index_,
-                 ExprTree(HloOpcode::kCopy,
-                          ExprTree(HloOpcode::kConstant, "loop_start"))));
+                 with_copy ? ExprTree(HloOpcode::kCopy, loop_start)
+                           : loop_start));
   }
 
   Status MatchExprTree(const ExprTree& expr_tree) override {
@@ -401,14 +462,19 @@ class WhileBodyComputationMatcher : public MatcherBase {
   WhileBodyComputationMatcher(const HloComputation* computation,
                               const int64 tuple_index)
       : computation_(computation), tuple_index_(tuple_index) {
-    expr_trees_.emplace_back(BuildBodyExprTree(0, 1));
-    expr_trees_.emplace_back(BuildBodyExprTree(1, 0));
+    for (const bool with_copy : {true, false}) {
+      expr_trees_.emplace_back(BuildBodyExprTree(0, 1, with_copy));
+      expr_trees_.emplace_back(BuildBodyExprTree(1, 0, with_copy));
+      expr_trees_.emplace_back(BuildUnfusedBodyExprTree(0, 1, with_copy));
+      expr_trees_.emplace_back(BuildUnfusedBodyExprTree(1, 0, with_copy));
+    }
   }
 
   int64 loop_increment() const { return loop_increment_; }
 
  private:
-  // Builds expression tree for the following while body computation:
+  // Builds expression tree for the following while body computation, whose
+  // Copy is optional:
   //
   //
   //                               FusionParam FusionParam
@@ -421,7 +487,8 @@ class WhileBodyComputationMatcher : public MatcherBase {
   //                      |
   //                     Tuple0
   //
-  ExprTree BuildBodyExprTree(const int64 const_index, const int64 gte_index) {
+  ExprTree BuildBodyExprTree(const int64 const_index, const int64 gte_index,
+                             const bool with_copy) {
     // Build ExprTree for fused instructions.
     ExprTree gte1 =
         ExprTree(HloOpcode::kGetTupleElement, "gte",
@@ -437,10 +504,34 @@ class WhileBodyComputationMatcher : public MatcherBase {
 
     // Build top-level computation.
     ExprTree tuple0(HloOpcode::kTuple, tuple_index_,
-                    ExprTree(HloOpcode::kCopy, fusion));
+                    with_copy ? ExprTree(HloOpcode::kCopy, fusion) : fusion);
     return tuple0;
   }
 
+  // Builds expression tree for the following unfused while body computation,
+  // whose Copy is optional:
+  //
+  //                   Param
+  //                     |
+  //             Const  GTE1
+  //                \   /
+  //                 Add
+  //                  |
+  //                 Copy
+  //                  |
+  //                Tuple0
+  //
+  ExprTree BuildUnfusedBodyExprTree(const int64 const_index,
+                                    const int64 gte_index,
+                                    const bool with_copy) {
+    ExprTree add(HloOpcode::kAdd, const_index,
+                 ExprTree(HloOpcode::kConstant, "loop_increment"), gte_index,
+                 ExprTree(HloOpcode::kGetTupleElement, "gte",
+                          ExprTree(HloOpcode::kParameter, "param0")));
+    return ExprTree(HloOpcode::kTuple, tuple_index_,
+                    with_copy ? ExprTree(HloOpcode::kCopy, add) : add);
+  }
+
   Status MatchExprTree(const ExprTree& expr_tree) override {
     VLOG(2) << "MATCHING while body";
     ExprTree::TaggedInstructionMap tagged_instructions;
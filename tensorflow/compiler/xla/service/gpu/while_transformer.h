@@ -30,6 +30,10 @@ namespace gpu {
 // *) 'loop_limit': loop induction variable limit value.
 // *) 'loop_increment': loop induction variable per-iteration increment value.
 //
+// The loop condition may compare the induction variable with a constant limit
+// on either side, with a strict or an inclusive bound, and may have been fused.
+// The returned 'loop_limit' is always exclusive.
+//
 // Returns an std::tuple = (loop_start, loop_limit, loop_increment) on success.
 // The values in the returned tuple are values extracted from the 'while_hlo'
 // operand (and its sub-computations) during analysis.
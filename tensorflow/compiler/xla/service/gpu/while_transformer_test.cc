@@ -37,8 +37,12 @@ class WhileTransformerTest : public HloTestBase {
             {induction_variable_shape_, data_shape_})),
         condition_result_shape_(ShapeUtil::MakeShape(PRED, {})) {}
 
+  // Builds 'induction_variable compare limit', or 'limit compare
+  // induction_variable' if 'limit_on_lhs'.
   std::unique_ptr<HloComputation> BuildConditionComputation(
-      const int64 tuple_index, const int64 limit) {
+      const int64 tuple_index, const int64 limit,
+      const HloOpcode compare = HloOpcode::kLt,
+      const bool limit_on_lhs = false) {
     auto builder = HloComputation::Builder(TestName() + ".Condition");
     auto limit_const = builder.AddInstruction(
         HloInstruction::CreateConstant(Literal::CreateR0<int32>(limit)));
@@ -47,9 +51,10 @@ class WhileTransformerTest : public HloTestBase {
     auto induction_variable =
         builder.AddInstruction(HloInstruction::CreateGetTupleElement(
             limit_const->shape(), loop_state, tuple_index));
-    builder.AddInstruction(
-        HloInstruction::CreateBinary(condition_result_shape_, HloOpcode::kLt,
-                                     induction_variable, limit_const));
+    builder.AddInstruction(HloInstruction::CreateBinary(
+        condition_result_shape_, compare,
+        limit_on_lhs ? limit_const : induction_variable,
+        limit_on_lhs ? induction_variable : limit_const));
     return builder.Build();
   }
 
@@ -160,6 +165,56 @@ TEST_F(WhileTransformerTest, InductionVariableAtTupleElement1) {
               Eq(std::tuple<int64, int64, int64>(0, 10, 1)));
 }
 
+TEST_F(WhileTransformerTest, LoopLimitOnLhs) {
+  // Build computation with condition 'limit > induction_variable'.
+  auto condition = module_->AddEmbeddedComputation(
+      BuildConditionComputation(0, 10, HloOpcode::kGt, true));
+  auto body = module_->AddEmbeddedComputation(BuildBodyComputation(0, 1, 2));
+  auto while_hlo = BuildWhileInstruction(condition, body, 0, 0);
+  // Run HLO Optimization passes.
+  RunFusionPasses();
+  RunCopyInsertionPass();
+  // Run WhileTransformer.
+  auto result = gpu::CanTransformWhileToFor(while_hlo);
+  ASSERT_TRUE(result.ok()) << result.status();
+  // Check results.
+  EXPECT_THAT(result.ConsumeValueOrDie(),
+              Eq(std::tuple<int64, int64, int64>(0, 10, 2)));
+}
+
+TEST_F(WhileTransformerTest, InclusiveLoopLimit) {
+  // Build computation with condition 'induction_variable <= 9'.
+  auto condition = module_->AddEmbeddedComputation(
+      BuildConditionComputation(1, 9, HloOpcode::kLe));
+  auto body = module_->AddEmbeddedComputation(BuildBodyComputation(1, 0, 1));
+  auto while_hlo = BuildWhileInstruction(condition, body, 1, 3);
+  // Run HLO Optimization passes.
+  RunFusionPasses();
+  RunCopyInsertionPass();
+  // Run WhileTransformer.
+  auto result = gpu::CanTransformWhileToFor(while_hlo);
+  ASSERT_TRUE(result.ok()) << result.status();
+  // Check results: the limit is made exclusive.
+  EXPECT_THAT(result.ConsumeValueOrDie(),
+              Eq(std::tuple<int64, int64, int64>(3, 10, 1)));
+}
+
+TEST_F(WhileTransformerTest, UnfusedLoop) {
+  // Build computation whose condition and body are not fused.
+  auto condition = module_->AddEmbeddedComputation(
+      BuildConditionComputation(0, 10, HloOpcode::kGe, true));
+  auto body = module_->AddEmbeddedComputation(BuildBodyComputation(0, 1, 1));
+  auto while_hlo = BuildWhileInstruction(condition, body, 0, 0);
+  // Run only copy insertion.
+  RunCopyInsertionPass();
+  // Run WhileTransformer.
+  auto result = gpu::CanTransformWhileToFor(while_hlo);
+  ASSERT_TRUE(result.ok()) << result.status();
+  // Check results.
+  EXPECT_THAT(result.ConsumeValueOrDie(),
+              Eq(std::tuple<int64, int64, int64>(0, 11, 1)));
+}
+
 TEST_F(WhileTransformerTest, InvalidLoopLimit) {
   // Build computation with invalid loop limit.
   auto condition =
@@ -67,34 +67,40 @@ Status GpuTransferManager::TransferLiteralToInfeed(se::StreamExecutor* executor,
     buffers.push_back(buffer);
   }
 
+  return EnqueueInfeedBuffers(executor, buffers);
+}
+
+Status GpuTransferManager::TransferBufferToInfeed(se::StreamExecutor* executor,
+                                                  int64 size,
+                                                  const void* source) {
+  TF_ASSIGN_OR_RETURN(gpu::InfeedBuffer * buffer,
+                      TransferBufferToInfeedInternal(executor, size, source));
+  return EnqueueInfeedBuffers(executor, {buffer});
+}
+
+Status GpuTransferManager::EnqueueInfeedBuffers(
+    se::StreamExecutor* executor, std::vector<gpu::InfeedBuffer*> buffers) {
   gpu::InfeedManager* infeed_manager = gpu::GetOrCreateInfeedManager();
   se::Stream* stream = infeed_manager->GetStream(executor);
 
-  // TODO(b/30467474): Since this stream is shared across different
-  // infeed requests, blocking on the stream might be
-  // heavy-handed. Figure out if finer-grained acknowledgement is
-  // possible.
-  if (!stream->BlockHostUntilDone()) {
+  // The transfers are not waited for: the runtime waits for the
+  // transferred() event of each buffer on its own stream, so the host can
+  // transfer the next data while the computation runs.
+  if (!stream->ok()) {
     for (gpu::InfeedBuffer* b : buffers) {
       b->Done();
     }
-    return InternalError("Failed to complete data transfer on stream %p",
+    return InternalError("Failed to enqueue data transfer on stream %p",
                          stream);
   }
 
   infeed_manager->EnqueueBuffers(buffers);
 
-  VLOG(2) << "Infeed data transferred";
+  VLOG(2) << "Infeed data transfer enqueued";
 
   return Status::OK();
 }
 
-Status GpuTransferManager::TransferBufferToInfeed(se::StreamExecutor* executor,
-                                                  int64 size,
-                                                  const void* source) {
-  return TransferBufferToInfeedInternal(executor, size, source).status();
-}
-
 StatusOr<gpu::InfeedBuffer*>
 GpuTransferManager::TransferLiteralToInfeedInternal(
     se::StreamExecutor* executor, const Literal& literal) {
@@ -124,8 +130,11 @@ StatusOr<gpu::InfeedBuffer*> GpuTransferManager::TransferBufferToInfeedInternal(
     return InternalError("Failed to obtain a stream");
   }
 
-  gpu::InfeedBuffer* buffer = new gpu::InfeedBuffer(executor, size);
+  // The copy from pageable host memory is staged before ThenMemcpy
+  // returns, so the caller may free 'source' without waiting for it.
+  gpu::InfeedBuffer* buffer = infeed_manager->AcquireBuffer(executor, size);
   stream->ThenMemcpy(buffer->device_memory(), source, size);
+  stream->ThenRecordEvent(buffer->transferred());
 
   VLOG(2) << "Queued infeed data on stream " << stream;
 
@@ -52,6 +52,10 @@ class GpuTransferManager : public GenericTransferManager {
       perftools::gputools::StreamExecutor* executor, int64 size,
       const void* source);
 
+  // Hands the 'buffers', whose transfers are enqueued, to the runtime.
+  Status EnqueueInfeedBuffers(perftools::gputools::StreamExecutor* executor,
+                              std::vector<gpu::InfeedBuffer*> buffers);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuTransferManager);
 };
 
@@ -211,6 +211,21 @@ bool CanShareOperandBufferWithUser(
     std::vector<int64> operand_indices = user->OperandIndices(operand);
     return operand_indices.size() == 1 && operand_indices[0] == 0;
   }
+  if (user->IsMultiOutputFusion() &&
+      user->fusion_kind() == HloInstruction::FusionKind::kLoop) {
+    // Loop fusion with a tuple of outputs as fused root. If all fused
+    // instructions are element-wise, each output element is computed from the
+    // operand elements at the same index, and all outputs at an index are
+    // computed before any of them is stored, so any output may reuse the
+    // buffer of an operand.
+    return std::all_of(
+        user->fused_instructions().begin(), user->fused_instructions().end(),
+        [user](const std::unique_ptr<HloInstruction>& fused_instruction) {
+          return fused_instruction->opcode() == HloOpcode::kParameter ||
+                 fused_instruction.get() == user->fused_expression_root() ||
+                 fused_instruction->IsElementwise();
+        });
+  }
   // Check if 'user' is element-wise.
   return user->IsElementwise();
 }
@@ -323,6 +323,55 @@ TEST_F(CanShareOperandBufferWithUserTest, OutputFusionCantAliasOperandBuffer) {
                                              points_to_analysis_.get()));
 }
 
+TEST_F(CanShareOperandBufferWithUserTest, ElementWiseMultiOutputFusion) {
+  auto builder = HloComputation::Builder(TestName());
+  Shape data_shape = ShapeUtil::MakeShape(F32, {8});
+
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape, HloOpcode::kExp, param));
+  auto negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape, HloOpcode::kNegate, param));
+  auto tuple =
+      builder.AddInstruction(HloInstruction::CreateTuple({exp, negate}));
+
+  BuildModule(builder.Build());
+  auto fusion = computation_->CreateFusionInstruction(
+      {tuple, negate, exp}, HloInstruction::FusionKind::kLoop);
+  RunAnalysis();
+
+  // Either output of the fusion can share the buffer of 'param'.
+  EXPECT_TRUE(CanShareOperandBufferWithUser(param, {}, fusion, {0},
+                                            points_to_analysis_.get()));
+  EXPECT_TRUE(CanShareOperandBufferWithUser(param, {}, fusion, {1},
+                                            points_to_analysis_.get()));
+}
+
+TEST_F(CanShareOperandBufferWithUserTest, MultiOutputFusionWithReverse) {
+  auto builder = HloComputation::Builder(TestName());
+  Shape data_shape = ShapeUtil::MakeShape(F32, {8});
+
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape, HloOpcode::kExp, param));
+  auto reverse = builder.AddInstruction(
+      HloInstruction::CreateReverse(data_shape, param, {0}));
+  auto tuple =
+      builder.AddInstruction(HloInstruction::CreateTuple({exp, reverse}));
+
+  BuildModule(builder.Build());
+  auto fusion = computation_->CreateFusionInstruction(
+      {tuple, reverse, exp}, HloInstruction::FusionKind::kLoop);
+  RunAnalysis();
+
+  // The reverse reads elements of 'param' that another thread may already
+  // have overwritten with output 0.
+  EXPECT_FALSE(CanShareOperandBufferWithUser(param, {}, fusion, {0},
+                                             points_to_analysis_.get()));
+}
+
 TEST_F(CanShareOperandBufferWithUserTest, WhileCanShare) {
   Shape data_shape = ShapeUtil::MakeShape(F32, {8});
 
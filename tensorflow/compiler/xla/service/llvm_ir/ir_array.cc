@@ -234,11 +234,7 @@ llvm::Value* IrArray::EmitReadArrayElement(const Index& index,
   llvm::Value* element_address =
       EmitArrayElementAddress(index, ir_builder, name);
   llvm::LoadInst* load = ir_builder->CreateLoad(element_address);
-  llvm_ir::SetTbaaForInstruction(load, GetShape(),
-                                 /*is_pointer_to=*/false);
-  for (const auto& kind_md_pair : metadata_) {
-    load->setMetadata(kind_md_pair.first, kind_md_pair.second);
-  }
+  AnnotateLoadStoreInstructionWithMetadata(load);
   return load;
 }
 
@@ -246,11 +242,19 @@ void IrArray::EmitWriteArrayElement(const Index& index, llvm::Value* value,
                                     llvm::IRBuilder<>* ir_builder) const {
   llvm::Value* element_address = EmitArrayElementAddress(index, ir_builder);
   llvm::StoreInst* store = ir_builder->CreateStore(value, element_address);
-  llvm_ir::SetTbaaForInstruction(store, GetShape(),
+  AnnotateLoadStoreInstructionWithMetadata(store);
+}
+
+void IrArray::AnnotateLoadStoreInstructionWithMetadata(
+    llvm::Instruction* instruction) const {
+  CHECK(llvm::isa<llvm::LoadInst>(instruction) ||
+        llvm::isa<llvm::StoreInst>(instruction));
+  llvm_ir::SetTbaaForInstruction(instruction, GetShape(),
                                  /*is_pointer_to=*/false);
   for (const auto& kind_md_pair : metadata_) {
-    CHECK_NE(kind_md_pair.first, llvm::LLVMContext::MD_invariant_load);
-    store->setMetadata(kind_md_pair.first, kind_md_pair.second);
+    CHECK(kind_md_pair.first != llvm::LLVMContext::MD_invariant_load ||
+          llvm::isa<llvm::LoadInst>(instruction));
+    instruction->setMetadata(kind_md_pair.first, kind_md_pair.second);
   }
 }
 
@@ -215,6 +215,13 @@ class IrArray {
     AddMetadata(llvm::LLVMContext::MD_invariant_load, invariant_load);
   }
 
+  // Attaches the metadata of this IrArray (TBAA, alias scopes) to
+  // 'instruction', a load from or a store to an element of this array which
+  // was not emitted by EmitReadArrayElement or EmitWriteArrayElement, e.g. a
+  // vector load.
+  void AnnotateLoadStoreInstructionWithMetadata(
+      llvm::Instruction* instruction) const;
+
   // Bumps the "which_dimension" value within the provided index by the provided
   // addend.
   static Index BumpIndex(const Index& index, int64 which_dimension,
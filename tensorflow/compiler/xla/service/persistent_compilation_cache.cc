@@ -0,0 +1,118 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/ptr_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
+
+namespace xla {
+
+PersistentCompilationCache::PersistentCompilationCache(const string& directory)
+    : directory_(directory) {}
+
+/* static */ std::unique_ptr<PersistentCompilationCache>
+PersistentCompilationCache::Create(const DebugOptions& debug_options) {
+  if (debug_options.xla_persistent_cache_dir().empty()) {
+    return nullptr;
+  }
+  return MakeUnique<PersistentCompilationCache>(
+      debug_options.xla_persistent_cache_dir());
+}
+
+/* static */ string PersistentCompilationCache::OptionsKey(
+    const DebugOptions& debug_options) {
+  string key = tensorflow::strings::StrCat(
+      "tf_git_version=", tf_git_version(),
+      ";opt_level=", debug_options.xla_backend_optimization_level(),
+      ";fast_math=", debug_options.xla_enable_fast_math(),
+      ";multi_thread_eigen=", debug_options.xla_cpu_multi_thread_eigen(),
+      ";gpu_ftz=", debug_options.xla_gpu_ftz(),
+      ";gpu_cuda_data_dir=", debug_options.xla_gpu_cuda_data_dir());
+  // Iteration order of a proto map is unspecified, so sort the extra options.
+  std::vector<std::pair<string, string>> extra_options(
+      debug_options.xla_backend_extra_options().begin(),
+      debug_options.xla_backend_extra_options().end());
+  std::sort(extra_options.begin(), extra_options.end());
+  for (const auto& option : extra_options) {
+    tensorflow::strings::StrAppend(&key, ";", option.first, "=",
+                                   option.second);
+  }
+  return key;
+}
+
+string PersistentCompilationCache::EntryPath(const string& key) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      directory_,
+      tensorflow::strings::Printf("%016llx%016llx",
+                                  static_cast<unsigned long long>(  // NOLINT
+                                      fingerprint.high64),
+                                  static_cast<unsigned long long>(  // NOLINT
+                                      fingerprint.low64)));
+}
+
+bool PersistentCompilationCache::Lookup(const string& key,
+                                        string* artifact) const {
+  const string path = EntryPath(key);
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path).ok()) {
+    VLOG(1) << "Persistent compilation cache miss: " << path;
+    return false;
+  }
+  tensorflow::Status status = tensorflow::ReadFileToString(env, path, artifact);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read persistent compilation cache entry "
+                 << path << ": " << status;
+    return false;
+  }
+  VLOG(1) << "Persistent compilation cache hit: " << path;
+  return true;
+}
+
+void PersistentCompilationCache::Insert(const string& key,
+                                        const string& artifact) const {
+  const string path = EntryPath(key);
+  const string temp_path = tensorflow::strings::StrCat(
+      path, ".tmp.", tensorflow::strings::Hex(tensorflow::random::New64()));
+  tensorflow::Env* env = tensorflow::Env::Default();
+  tensorflow::Status status = env->RecursivelyCreateDir(directory_);
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(env, temp_path, artifact);
+  }
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write persistent compilation cache entry "
+                 << path << ": " << status;
+    env->DeleteFile(temp_path).IgnoreError();
+    return;
+  }
+  VLOG(1) << "Wrote persistent compilation cache entry: " << path;
+}
+
+}  // namespace xla
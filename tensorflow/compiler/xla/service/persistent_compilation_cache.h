@@ -0,0 +1,75 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+
+// A directory of compiled artifacts (object files, PTX) that outlives the
+// process, so that a backend can skip LLVM optimization and code generation
+// for modules it has compiled before, e.g. in a previous run of the same
+// program.
+//
+// Entries are keyed by a string that the backend builds from everything that
+// determines the artifact: the unoptimized LLVM IR of the module, the target
+// and the options returned by OptionsKey(). Keys are fingerprinted into file
+// names. Entries are written to a temporary file and then renamed into place,
+// so processes sharing a directory never observe partially written entries.
+//
+// The cache is best effort: I/O errors are logged and treated as misses.
+class PersistentCompilationCache {
+ public:
+  explicit PersistentCompilationCache(const string& directory);
+
+  // Returns a cache rooted at `debug_options.xla_persistent_cache_dir()`, or
+  // nullptr if that option is empty.
+  static std::unique_ptr<PersistentCompilationCache> Create(
+      const DebugOptions& debug_options);
+
+  // Returns a string describing the options in `debug_options` that affect
+  // the code generated for a module, and the version of the compiler, for use
+  // as part of a cache key.
+  static string OptionsKey(const DebugOptions& debug_options);
+
+  // Looks up the artifact stored under `key`. Returns true and fills in
+  // `artifact` on a hit.
+  bool Lookup(const string& key, string* artifact) const;
+
+  // Stores `artifact` under `key`, replacing any existing entry.
+  void Insert(const string& key, const string& artifact) const;
+
+  const string& directory() const { return directory_; }
+
+ private:
+  // Returns the path of the file holding the entry for `key`.
+  string EntryPath(const string& key) const;
+
+  const string directory_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PersistentCompilationCache);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+string CacheDirectory(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(PersistentCompilationCacheTest, DisabledByDefault) {
+  DebugOptions debug_options;
+  EXPECT_EQ(nullptr, PersistentCompilationCache::Create(debug_options));
+
+  debug_options.set_xla_persistent_cache_dir(CacheDirectory("enabled"));
+  auto cache = PersistentCompilationCache::Create(debug_options);
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(CacheDirectory("enabled"), cache->directory());
+}
+
+TEST(PersistentCompilationCacheTest, InsertAndLookup) {
+  // The directory does not exist until the first insertion.
+  PersistentCompilationCache cache(
+      tensorflow::io::JoinPath(CacheDirectory("insert"), "nested"));
+  string artifact;
+  EXPECT_FALSE(cache.Lookup("key1", &artifact));
+
+  const string object_code("\x7f" "ELF\0\1\2", 7);
+  cache.Insert("key1", object_code);
+  ASSERT_TRUE(cache.Lookup("key1", &artifact));
+  EXPECT_EQ(object_code, artifact);
+  EXPECT_FALSE(cache.Lookup("key2", &artifact));
+
+  cache.Insert("key1", "replaced");
+  ASSERT_TRUE(cache.Lookup("key1", &artifact));
+  EXPECT_EQ("replaced", artifact);
+
+  // Only the entry itself is left behind, no temporary files.
+  std::vector<string> children;
+  TF_ASSERT_OK(
+      tensorflow::Env::Default()->GetChildren(cache.directory(), &children));
+  EXPECT_EQ(1, children.size());
+}
+
+TEST(PersistentCompilationCacheTest, EntriesAreSharedThroughTheDirectory) {
+  PersistentCompilationCache writer(CacheDirectory("shared"));
+  writer.Insert("module", "ptx");
+
+  PersistentCompilationCache reader(CacheDirectory("shared"));
+  string artifact;
+  ASSERT_TRUE(reader.Lookup("module", &artifact));
+  EXPECT_EQ("ptx", artifact);
+}
+
+TEST(PersistentCompilationCacheTest, OptionsKey) {
+  DebugOptions debug_options;
+  debug_options.set_xla_backend_optimization_level(3);
+  (*debug_options.mutable_xla_backend_extra_options())["b"] = "2";
+  (*debug_options.mutable_xla_backend_extra_options())["a"] = "1";
+  const string key = PersistentCompilationCache::OptionsKey(debug_options);
+  EXPECT_NE(string::npos, key.find("opt_level=3"));
+  EXPECT_NE(string::npos, key.find(";a=1;b=2"));
+
+  // Options that only control debug output do not change the key.
+  DebugOptions dumping_options = debug_options;
+  dumping_options.set_xla_dump_ir_to("/tmp/ir");
+  EXPECT_EQ(key, PersistentCompilationCache::OptionsKey(dumping_options));
+
+  DebugOptions other_options = debug_options;
+  other_options.set_xla_enable_fast_math(!debug_options.xla_enable_fast_math());
+  EXPECT_NE(key, PersistentCompilationCache::OptionsKey(other_options));
+}
+
+}  // namespace
+}  // namespace xla
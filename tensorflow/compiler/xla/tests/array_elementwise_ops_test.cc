@@ -1313,6 +1313,71 @@ TEST_F(ArrayElementwiseOpTest, TanhF32s) {
                              error_spec_);
 }
 
+XLA_TEST_F(ArrayElementwiseOpTest, ExpF32sVector) {
+  // Long enough to run the vectorized loops of the backends, and spanning
+  // the underflow and overflow of the result.
+  std::vector<float> input;
+  for (float x = -110.0f; x < 95.0f; x += 0.37f) {
+    input.push_back(x);
+  }
+  std::vector<float> expected;
+  for (float x : input) {
+    expected.push_back(std::exp(x));
+  }
+
+  ComputationBuilder builder(client_, TestName());
+  std::unique_ptr<Literal> input_literal = Literal::CreateR1<float>(input);
+  std::unique_ptr<GlobalData> input_data =
+      client_->TransferToServer(*input_literal).ConsumeValueOrDie();
+  auto param = builder.Parameter(0, input_literal->shape(), "input");
+  builder.Exp(param);
+
+  ComputeAndCompareR1<float>(&builder, expected, {input_data.get()},
+                             ErrorSpec(0.0001, 0.0001));
+}
+
+XLA_TEST_F(ArrayElementwiseOpTest, LogF32sVector) {
+  std::vector<float> input = {0.0f, std::numeric_limits<float>::infinity()};
+  for (float x = -80.0f; x < 80.0f; x += 0.29f) {
+    input.push_back(std::exp(x));
+  }
+  std::vector<float> expected;
+  for (float x : input) {
+    expected.push_back(std::log(x));
+  }
+
+  ComputationBuilder builder(client_, TestName());
+  std::unique_ptr<Literal> input_literal = Literal::CreateR1<float>(input);
+  std::unique_ptr<GlobalData> input_data =
+      client_->TransferToServer(*input_literal).ConsumeValueOrDie();
+  auto param = builder.Parameter(0, input_literal->shape(), "input");
+  builder.Log(param);
+
+  ComputeAndCompareR1<float>(&builder, expected, {input_data.get()},
+                             error_spec_);
+}
+
+XLA_TEST_F(ArrayElementwiseOpTest, TanhF32sVector) {
+  std::vector<float> input;
+  for (float x = -12.0f; x < 12.0f; x += 0.13f) {
+    input.push_back(x);
+  }
+  std::vector<float> expected;
+  for (float x : input) {
+    expected.push_back(std::tanh(x));
+  }
+
+  ComputationBuilder builder(client_, TestName());
+  std::unique_ptr<Literal> input_literal = Literal::CreateR1<float>(input);
+  std::unique_ptr<GlobalData> input_data =
+      client_->TransferToServer(*input_literal).ConsumeValueOrDie();
+  auto param = builder.Parameter(0, input_literal->shape(), "input");
+  builder.Tanh(param);
+
+  ComputeAndCompareR1<float>(&builder, expected, {input_data.get()},
+                             error_spec_);
+}
+
 TEST_F(ArrayElementwiseOpTest, AddChainFoldLeft) {
   // a ------ (add) --------- (add)
   //         /               /
@@ -258,6 +258,24 @@ XLA_TEST_F(DotOperationTest, MatrixDotF32_260_3_520_MinorToMajorFF) {
   TestMatrixDot(260, 3, 520, false, false);
 }
 
+// Sizes which are not multiples of the register tiles of backends which emit
+// small matrix multiplies as tiled loops.
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_53_41_MinorToMajorTT) {
+  TestMatrixDot(37, 53, 41, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_53_41_MinorToMajorTF) {
+  TestMatrixDot(37, 53, 41, true, false);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_53_41_MinorToMajorFT) {
+  TestMatrixDot(37, 53, 41, false, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_53_41_MinorToMajorFF) {
+  TestMatrixDot(37, 53, 41, false, false);
+}
+
 XLA_TEST_F(DotOperationTest, SquareMatrixDotF32MinorToMajorFF) {
   constexpr bool kLhsRowMajor = false;
   constexpr bool kRhsRowMajor = false;
@@ -0,0 +1,297 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""All-reduce across devices and workers, built from ordinary graph ops.
+
+The all-reduce is expressed as a graph of split, reduce and concat ops placed
+on the devices of the input tensors. Graph partitioning turns the edges
+between devices into Send/Recv pairs, so the data moves over whatever
+transport the cluster uses (gRPC, verbs or MPI) without any new kernels.
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from tensorflow.python.framework import device as pydev
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+
+def _flatten_tensors(tensors):
+  """Checks that `tensors` have the same shape and flattens them to vectors.
+
+  Args:
+    tensors: list of `Tensor`s of the same dtype and shape.
+
+  Returns:
+    A pair of the list of flattened `Tensor`s, each on the device of its input,
+    and the list of shapes to restore the results to, or None if `tensors` are
+    vectors already.
+
+  Raises:
+    ValueError: if `tensors` is empty, or the tensors have different dtypes or
+      shapes.
+  """
+  if not tensors:
+    raise ValueError("tensors cannot be empty")
+  shape = tensors[0].shape
+  dtype = tensors[0].dtype
+  for t in tensors:
+    if t.dtype != dtype:
+      raise ValueError("Tensors must have the same dtype, got %s and %s" %
+                       (dtype, t.dtype))
+    if not t.shape.is_compatible_with(shape):
+      raise ValueError("Tensors must have the same shape, got %s and %s" %
+                       (shape, t.shape))
+  if shape.ndims == 1:
+    return list(tensors), None
+  flat = []
+  shapes = []
+  for t in tensors:
+    with ops.colocate_with(t):
+      flat.append(array_ops.reshape(t, [-1]))
+      if t.shape.is_fully_defined():
+        shapes.append(t.shape.as_list())
+      else:
+        shapes.append(array_ops.shape(t))
+  return flat, shapes
+
+
+def _restore_shapes(flat, shapes):
+  """Reshapes the vectors `flat` to `shapes` from _flatten_tensors."""
+  if shapes is None:
+    return flat
+  reshaped = []
+  for t, shape in zip(flat, shapes):
+    with ops.colocate_with(t):
+      reshaped.append(array_ops.reshape(t, shape))
+  return reshaped
+
+
+def _padded_split(tensor, pieces):
+  """Splits the vector `tensor` into `pieces` chunks of the same size.
+
+  Args:
+    tensor: a vector `Tensor`.
+    pieces: the number of chunks.
+
+  Returns:
+    A pair of the list of chunks, each on the device of `tensor`, and the
+    length of `tensor`. The last chunks are padded with zeros if the length of
+    `tensor` is not a multiple of `pieces`.
+  """
+  with ops.colocate_with(tensor):
+    length = array_ops.shape(tensor)[0]
+    pad_len = math_ops.mod(pieces - math_ops.mod(length, pieces), pieces)
+    padded = array_ops.pad(tensor, [[0, pad_len]])
+    return array_ops.split(padded, pieces), length
+
+
+def _strip_padding(tensor, length):
+  """Returns the first `length` elements of the vector `tensor`."""
+  with ops.colocate_with(tensor):
+    return array_ops.slice(tensor, [0], [length])
+
+
+def _ring_all_reduce_flat(flat_tensors, num_subchunks, red_op):
+  """Ring all-reduce of vectors, each on a different device.
+
+  Each vector is split into `len(flat_tensors) * num_subchunks` chunks. The
+  chunks go round the ring of devices twice: the first time every device adds
+  in its own contribution to the chunks it forwards, until each device holds
+  the full reduction of `num_subchunks` of the chunks, and the second time the
+  reduced chunks are copied to every device. Every device sends and receives
+  the same amount of data, about twice the size of one input in total.
+
+  The subchunks of a chunk are reduced and forwarded independently of each
+  other, so a device can work on one subchunk while the next one is still in
+  flight.
+
+  Args:
+    flat_tensors: list of vectors, one per device in ring order.
+    num_subchunks: the number of subchunks to split each chunk into.
+    red_op: binary reduction op, e.g. `math_ops.add`.
+
+  Returns:
+    The list of reduced vectors, on the devices of `flat_tensors`.
+  """
+  num_devices = len(flat_tensors)
+  devices = [t.device for t in flat_tensors]
+  num_chunks = num_devices * num_subchunks
+  chunks = []
+  lengths = []
+  for t in flat_tensors:
+    split, length = _padded_split(t, num_chunks)
+    chunks.append(split)
+    lengths.append(length)
+
+  # Reduce-scatter: in step `s`, device `i` forwards its partial reduction of
+  # chunk group `(i - s) % num_devices` to the next device, which reduces it
+  # with its own contribution. Device `i` ends up with the full reduction of
+  # chunk group `(i + 1) % num_devices`.
+  partial = [list(c) for c in chunks]
+  for step in range(num_devices - 1):
+    new_partial = [list(p) for p in partial]
+    for i in range(num_devices):
+      dst = (i + 1) % num_devices
+      group = (i - step) % num_devices
+      with ops.device(devices[dst]):
+        for sub in range(num_subchunks):
+          c = group * num_subchunks + sub
+          new_partial[dst][c] = red_op(partial[i][c], chunks[dst][c])
+    partial = new_partial
+
+  # All-gather: in step `s`, device `i` forwards the reduced chunk group
+  # `(i + 1 - s) % num_devices` to the next device.
+  reduced = [[None] * num_chunks for _ in range(num_devices)]
+  for i in range(num_devices):
+    group = (i + 1) % num_devices
+    for sub in range(num_subchunks):
+      c = group * num_subchunks + sub
+      reduced[i][c] = partial[i][c]
+  for step in range(num_devices - 1):
+    for i in range(num_devices):
+      dst = (i + 1) % num_devices
+      group = (i + 1 - step) % num_devices
+      with ops.device(devices[dst]):
+        for sub in range(num_subchunks):
+          c = group * num_subchunks + sub
+          reduced[dst][c] = array_ops.identity(reduced[i][c])
+
+  outputs = []
+  for i in range(num_devices):
+    with ops.device(devices[i]):
+      outputs.append(
+          _strip_padding(array_ops.concat(reduced[i], 0), lengths[i]))
+  return outputs
+
+
+def _apply_un_op(tensors, un_op):
+  """Applies `un_op`, if any, to each of `tensors` on its own device."""
+  if un_op is None:
+    return tensors
+  outputs = []
+  for t in tensors:
+    with ops.colocate_with(t):
+      outputs.append(un_op(t))
+  return outputs
+
+
+def build_ring_all_reduce(input_tensors, num_subchunks=1, red_op=math_ops.add,
+                          un_op=None):
+  """Builds a ring all-reduce of `input_tensors`.
+
+  The devices form a ring in the order of `input_tensors`. To keep the number
+  of transfers between hosts low, list the tensors of each host next to each
+  other.
+
+  Like any all-reduce, the computation hangs if only some of the returned
+  tensors are evaluated.
+
+  Args:
+    input_tensors: list of `Tensor`s of the same dtype and shape, each assigned
+      to a different device.
+    num_subchunks: the number of pieces each device's share of the data is
+      split into, so that sending one piece overlaps with reducing the
+      previous one.
+    red_op: binary reduction op, e.g. `math_ops.add`.
+    un_op: optional unary op applied to each result on its device, e.g. to
+      divide by the number of inputs.
+
+  Returns:
+    A list of `Tensor`s with the reduction of `input_tensors`, where tensor `i`
+    is on the device of `input_tensors[i]`.
+
+  Raises:
+    ValueError: if `input_tensors` is empty or the tensors do not match, or
+      `num_subchunks` is not positive.
+  """
+  if num_subchunks < 1:
+    raise ValueError("num_subchunks must be positive, got %d" % num_subchunks)
+  flat, shapes = _flatten_tensors(input_tensors)
+  if len(flat) > 1:
+    flat = _ring_all_reduce_flat(flat, num_subchunks, red_op)
+  return _apply_un_op(_restore_shapes(flat, shapes), un_op)
+
+
+def _task_of(tensor):
+  """Returns the job, replica and task of the device of `tensor`."""
+  spec = pydev.DeviceSpec.from_string(tensor.device)
+  return (spec.job, spec.replica, spec.task)
+
+
+def build_hierarchical_all_reduce(input_tensors, groups=None, num_subchunks=1,
+                                  red_op=math_ops.add, un_op=None):
+  """Builds a two-level all-reduce of `input_tensors`.
+
+  The tensors in each group are first reduced onto the device of the first
+  tensor of the group. Those reductions then go through a ring all-reduce
+  across groups, and each result is copied to the other devices of its group.
+  Only one device per group sends data between groups, which suits groups
+  that are hosts with fast links between their devices.
+
+  Like any all-reduce, the computation hangs if only some of the returned
+  tensors are evaluated.
+
+  Args:
+    input_tensors: list of `Tensor`s of the same dtype and shape, each assigned
+      to a different device.
+    groups: optional list of lists of indices into `input_tensors`, covering
+      each index once. Defaults to grouping the tensors by the task of their
+      device.
+    num_subchunks: the number of pieces each group's share of the data is
+      split into in the ring across groups.
+    red_op: binary reduction op, e.g. `math_ops.add`.
+    un_op: optional unary op applied to each result on its device.
+
+  Returns:
+    A list of `Tensor`s with the reduction of `input_tensors`, where tensor `i`
+    is on the device of `input_tensors[i]`.
+
+  Raises:
+    ValueError: if `input_tensors` is empty or the tensors do not match, or
+      `groups` does not cover each index exactly once.
+  """
+  if num_subchunks < 1:
+    raise ValueError("num_subchunks must be positive, got %d" % num_subchunks)
+  flat, shapes = _flatten_tensors(input_tensors)
+  if groups is None:
+    by_task = collections.OrderedDict()
+    for i, t in enumerate(input_tensors):
+      by_task.setdefault(_task_of(t), []).append(i)
+    groups = list(by_task.values())
+  if sorted(i for g in groups for i in g) != list(range(len(flat))):
+    raise ValueError("groups must cover each input index exactly once, got %s"
+                     % groups)
+
+  leader_sums = []
+  for group in groups:
+    with ops.device(flat[group[0]].device):
+      total = flat[group[0]]
+      for i in group[1:]:
+        total = red_op(total, flat[i])
+      leader_sums.append(total)
+  if len(leader_sums) > 1:
+    leader_sums = _ring_all_reduce_flat(leader_sums, num_subchunks, red_op)
+
+  outputs = [None] * len(flat)
+  for group, reduced in zip(groups, leader_sums):
+    outputs[group[0]] = reduced
+    for i in group[1:]:
+      with ops.device(flat[i].device):
+        outputs[i] = array_ops.identity(reduced)
+  return _apply_un_op(_restore_shapes(outputs, shapes), un_op)
@@ -0,0 +1,108 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for all_reduce."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.contrib.all_reduce.python import all_reduce
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+class AllReduceTest(test.TestCase):
+
+  def _inputs(self, num_devices, shape):
+    values = [np.random.rand(*shape).astype(np.float32)
+              for _ in range(num_devices)]
+    tensors = []
+    for i, value in enumerate(values):
+      with ops.device("/cpu:%d" % i):
+        tensors.append(constant_op.constant(value))
+    return values, tensors
+
+  def _run(self, num_devices, outputs):
+    config = config_pb2.ConfigProto(device_count={"CPU": num_devices})
+    with self.test_session(graph=ops.get_default_graph(),
+                           config=config) as sess:
+      return sess.run(outputs)
+
+  def testRingAllReduce(self):
+    for num_devices in [1, 2, 3, 4]:
+      for num_subchunks in [1, 2, 3]:
+        for shape in [[7], [3, 5], [2, 0]]:
+          with ops.Graph().as_default():
+            values, tensors = self._inputs(num_devices, shape)
+            outputs = all_reduce.build_ring_all_reduce(
+                tensors, num_subchunks=num_subchunks)
+            self.assertEqual(num_devices, len(outputs))
+            for t, out in zip(tensors, outputs):
+              self.assertEqual(t.device, out.device)
+            expected = np.sum(values, axis=0)
+            for result in self._run(num_devices, outputs):
+              self.assertAllClose(expected, result)
+
+  def testRingAllReduceUnOp(self):
+    with ops.Graph().as_default():
+      values, tensors = self._inputs(3, [10])
+      outputs = all_reduce.build_ring_all_reduce(
+          tensors, red_op=math_ops.maximum, un_op=lambda x: x * 2.0)
+      expected = 2.0 * np.max(values, axis=0)
+      for result in self._run(3, outputs):
+        self.assertAllClose(expected, result)
+
+  def testHierarchicalAllReduce(self):
+    with ops.Graph().as_default():
+      values, tensors = self._inputs(5, [4, 3])
+      outputs = all_reduce.build_hierarchical_all_reduce(
+          tensors, groups=[[0, 1], [2], [3, 4]], num_subchunks=2)
+      for t, out in zip(tensors, outputs):
+        self.assertEqual(t.device, out.device)
+      expected = np.sum(values, axis=0)
+      for result in self._run(5, outputs):
+        self.assertAllClose(expected, result)
+
+  def testHierarchicalAllReduceGroupsByTask(self):
+    with ops.Graph().as_default():
+      values, tensors = self._inputs(3, [6])
+      # All devices are in the same task, so there is a single group.
+      outputs = all_reduce.build_hierarchical_all_reduce(tensors)
+      expected = np.sum(values, axis=0)
+      for result in self._run(3, outputs):
+        self.assertAllClose(expected, result)
+
+  def testInvalidInputs(self):
+    with ops.Graph().as_default():
+      with self.assertRaisesRegexp(ValueError, "cannot be empty"):
+        all_reduce.build_ring_all_reduce([])
+      a = array_ops.zeros([3])
+      b = array_ops.zeros([4])
+      with self.assertRaisesRegexp(ValueError, "same shape"):
+        all_reduce.build_ring_all_reduce([a, b])
+      with self.assertRaisesRegexp(ValueError, "num_subchunks"):
+        all_reduce.build_ring_all_reduce([a, a], num_subchunks=0)
+      with self.assertRaisesRegexp(ValueError, "groups"):
+        all_reduce.build_hierarchical_all_reduce([a, a], groups=[[0]])
+
+
+if __name__ == "__main__":
+  test.main()
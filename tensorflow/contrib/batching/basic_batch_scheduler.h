@@ -176,6 +176,13 @@ class BasicBatchScheduler : public BatchScheduler<TaskType> {
     // parameter.
     int max_enqueued_batches = 10;
 
+    // Adaptive choice of the batch timeout and a target batch size. See the
+    // corresponding options in SharedBatchScheduler::QueueOptions.
+    bool enable_adaptive_batching = false;
+    AdaptiveBatchingPolicy::Options adaptive_batching_options;
+    std::function<void(const AdaptiveBatchingPolicy::Decision&)>
+        adaptive_batching_decision_callback;
+
     // The following options are typically only overridden by test code.
 
     // The environment to use.
@@ -227,6 +234,12 @@ Status BasicBatchScheduler<TaskType>::Create(
       options.batch_timeout_micros;
   shared_scheduler_queue_options.max_enqueued_batches =
       options.max_enqueued_batches;
+  shared_scheduler_queue_options.enable_adaptive_batching =
+      options.enable_adaptive_batching;
+  shared_scheduler_queue_options.adaptive_batching_options =
+      options.adaptive_batching_options;
+  shared_scheduler_queue_options.adaptive_batching_decision_callback =
+      options.adaptive_batching_decision_callback;
   std::unique_ptr<BatchScheduler<TaskType>> shared_scheduler_queue;
   TF_RETURN_IF_ERROR(shared_scheduler->AddQueue(shared_scheduler_queue_options,
                                                 process_batch_callback,
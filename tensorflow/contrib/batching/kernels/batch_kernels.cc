@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/contrib/batching/shared_batch_scheduler.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -93,6 +96,40 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor>& inputs,
   return Status::OK();
 }
 
+// Pads 'input' with element type T, which must have at least two dimensions,
+// with default-constructed values (e.g. zeros) at the end of dimension 1, so
+// that that dimension has size 'size'. Allocates the result using 'context'.
+template <typename T>
+Status PadDim1(OpKernelContext* context, const Tensor& input, int64 size,
+               Tensor* output) {
+  const int64 dim0 = input.dim_size(0);
+  const int64 dim1 = input.dim_size(1);
+  if (size < dim1) {
+    return errors::InvalidArgument("Cannot pad dimension 1 of size ", dim1,
+                                   " down to ", size);
+  }
+  TensorShape output_shape(input.shape());
+  output_shape.set_dim(1, size);
+  TF_RETURN_IF_ERROR(
+      context->allocate_temp(input.dtype(), output_shape, output));
+  if (output->NumElements() == 0) {
+    return Status::OK();
+  }
+  int64 suffix_dim_size = 1;
+  for (int i = 2; i < output_shape.dims(); ++i) {
+    suffix_dim_size *= output_shape.dim_size(i);
+  }
+  auto output_shaped = output->shaped<T, 3>({dim0, size, suffix_dim_size});
+  output_shaped.setConstant(T());
+  if (input.NumElements() > 0) {
+    Eigen::DSizes<Eigen::DenseIndex, 3> offsets{0, 0, 0};
+    Eigen::DSizes<Eigen::DenseIndex, 3> extents{dim0, dim1, suffix_dim_size};
+    output_shaped.slice(offsets, extents) =
+        input.shaped<T, 3>({dim0, dim1, suffix_dim_size});
+  }
+  return Status::OK();
+}
+
 // The Split*() functions split 'input' with element type T into 'sizes.size()'
 // tensors along the zeroth dimension, with the ith split having zeroth-
 // dimension size 'sizes[i]'. They allocate the output tensors using 'context',
@@ -209,6 +246,7 @@ class BatchResource : public ResourceBase {
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
                        int32 batch_timeout_micros,
                        const std::vector<int32>& allowed_batch_sizes,
+                       const std::vector<int32>& bucket_boundaries,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
 
@@ -222,6 +260,7 @@ class BatchResource : public ResourceBase {
         batch_timeout_micros;
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
+    new_resource->bucket_boundaries_ = bucket_boundaries;
 
     *resource = std::move(new_resource);
     return Status::OK();
@@ -255,9 +294,18 @@ class BatchResource : public ResourceBase {
     batch_components->context = context;
     batch_components->done_callback = std::move(done_callback);
 
+    string queue_name = batcher_queue_name;
+    if (!bucket_boundaries_.empty()) {
+      int64 bucket_size;
+      TF_RETURN_IF_ERROR(PadToBucket(context, &batch_components->inputs,
+                                     &bucket_size));
+      if (bucket_size >= 0) {
+        strings::StrAppend(&queue_name, "/bucket_", bucket_size);
+      }
+    }
+
     BatcherQueue* batcher_queue;
-    TF_RETURN_IF_ERROR(
-        LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+    TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(queue_name, &batcher_queue));
     return batcher_queue->Schedule(&batch_components);
   }
 
@@ -312,6 +360,56 @@ class BatchResource : public ResourceBase {
     return batch_size;
   }
 
+  // Rounds the largest dimension 1 size among the 'inputs' of rank 2 or more up
+  // to the smallest entry in 'bucket_boundaries_' that is at least as large,
+  // pads all those inputs along dimension 1 to it, and sets '*bucket_size' to
+  // it. If no input has rank 2 or more, sets '*bucket_size' to -1.
+  Status PadToBucket(OpKernelContext* context, std::vector<Tensor>* inputs,
+                     int64* bucket_size) const {
+    int64 max_dim1 = -1;
+    for (const Tensor& input : *inputs) {
+      if (input.dims() >= 2) {
+        max_dim1 = std::max(max_dim1, input.dim_size(1));
+      }
+    }
+    *bucket_size = -1;
+    if (max_dim1 < 0) {
+      return Status::OK();
+    }
+    for (int32 boundary : bucket_boundaries_) {
+      if (boundary >= max_dim1) {
+        *bucket_size = boundary;
+        break;
+      }
+    }
+    if (*bucket_size < 0) {
+      return errors::InvalidArgument(
+          "Batching input tensors have dimension 1 of size ", max_dim1,
+          ", which is larger than the last entry in bucket_boundaries (",
+          bucket_boundaries_.back(), ")");
+    }
+    for (Tensor& input : *inputs) {
+      if (input.dims() < 2 || input.dim_size(1) == *bucket_size) {
+        continue;
+      }
+      Tensor padded;
+      const DataType type = input.dtype();
+      switch (type) {
+#define CASE(type)                                                    \
+  case DataTypeToEnum<type>::value:                                   \
+    TF_RETURN_IF_ERROR(                                               \
+        PadDim1<type>(context, input, *bucket_size, &padded));        \
+    break;
+        TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+        default:
+          return errors::InvalidArgument("Unsupported data type: ", type);
+      }
+      input = padded;
+    }
+    return Status::OK();
+  }
+
   // Processes a batch of one or more BatchTask entries.
   void ProcessBatch(std::unique_ptr<Batch> batch) const {
     if (batch->empty()) {
@@ -496,6 +594,10 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  // Sizes to which dimension 1 of the inputs is padded; see the Batch op.
+  // Tasks padded to different sizes go to different batcher queues.
+  std::vector<int32> bucket_boundaries_;
 };
 
 class BatchKernel : public AsyncOpKernel {
@@ -515,6 +617,8 @@ class BatchKernel : public AsyncOpKernel {
                    c->GetAttr("batch_timeout_micros", &batch_timeout_micros_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(c, c->GetAttr("bucket_boundaries", &bucket_boundaries_));
+    OP_REQUIRES_OK(c, ValidateBucketBoundaries());
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) final {
@@ -524,7 +628,7 @@ class BatchKernel : public AsyncOpKernel {
           std::unique_ptr<BatchResource> new_resource;
           TF_RETURN_IF_ERROR(BatchResource::Create(
               num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-              allowed_batch_sizes_, &new_resource));
+              allowed_batch_sizes_, bucket_boundaries_, &new_resource));
           *r = new_resource.release();
           return Status::OK();
         };
@@ -563,6 +667,22 @@ class BatchKernel : public AsyncOpKernel {
     return Status::OK();
   }
 
+  // Validates 'bucket_boundaries_'. The entries must be positive and increase
+  // monotonically.
+  Status ValidateBucketBoundaries() const {
+    for (size_t i = 0; i < bucket_boundaries_.size(); ++i) {
+      if (bucket_boundaries_[i] <= 0) {
+        return errors::InvalidArgument(
+            "bucket_boundaries entries must be positive");
+      }
+      if (i > 0 && bucket_boundaries_[i] <= bucket_boundaries_[i - 1]) {
+        return errors::InvalidArgument(
+            "bucket_boundaries entries must be monotonically increasing");
+      }
+    }
+    return Status::OK();
+  }
+
  private:
   string container_;
   string shared_name_;
@@ -571,6 +691,7 @@ class BatchKernel : public AsyncOpKernel {
   int32 max_batch_size_;
   int32 batch_timeout_micros_;
   std::vector<int32> allowed_batch_sizes_;
+  std::vector<int32> bucket_boundaries_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("Batch").Device(DEVICE_CPU), BatchKernel);
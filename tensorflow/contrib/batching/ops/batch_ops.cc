@@ -28,6 +28,7 @@ REGISTER_OP("Batch")
     .Attr("max_batch_size: int")
     .Attr("batch_timeout_micros: int")
     .Attr("allowed_batch_sizes: list(int) = []")
+    .Attr("bucket_boundaries: list(int) = []")
     .Attr("grad_timeout_micros: int")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
@@ -79,6 +80,16 @@ allowed_batch_sizes: Optional list of allowed batch sizes. If left empty, does
  nothing. Otherwise, supplies a list of batch sizes, causing the op to pad
  batches up to one of those sizes. The entries must increase monotonically, and
  the final entry must equal max_batch_size.
+bucket_boundaries: Optional list of sizes for dimension 1 of in_tensors, e.g.
+ sequence lengths. If left empty, does nothing. Otherwise, in_tensors of rank 2
+ or more are padded with zeros along dimension 1 up to the smallest entry that
+ is no smaller than the largest of their dimension 1 sizes, and invocations are
+ only batched with invocations padded to the same size. This keeps the shapes
+ seen by the batched computation within a small set. The entries must be
+ positive and increase monotonically; invocations with a dimension 1 larger
+ than the final entry fail. Unbatch returns the padded rows. Choosing entries
+ which make each padded row a multiple of 64 bytes lets Unbatch return slices
+ of the batched tensor without copying.
 grad_timeout_micros: The timeout to use for the gradient. See Unbatch.
 batched_tensors: Either empty tensors or a batch of concatenated Tensors.
 batch_index: If out_tensors is non-empty, has information to invert it.
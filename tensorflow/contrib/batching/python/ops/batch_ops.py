@@ -25,6 +25,7 @@ from tensorflow.contrib.batching.ops.gen_batch_ops import *
 # pylint: enable=wildcard-import
 from tensorflow.contrib.util import loader
 from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import resource_loader
 
 
@@ -37,13 +38,18 @@ def _BatchGrad(op, *out_grads):  # pylint: disable=invalid-name
   """Gradient for batch op."""
   gradients = []
   for i in range(len(op.inputs)):
-    gradients.append(
-        gen_batch_ops.unbatch(
-            out_grads[i],
-            op.outputs[-2],
-            op.outputs[-1],
-            timeout_micros=op.get_attr("grad_timeout_micros"),
-            shared_name="batch_gradient_{}_{}".format(op.name, i)))
+    gradient = gen_batch_ops.unbatch(
+        out_grads[i],
+        op.outputs[-2],
+        op.outputs[-1],
+        timeout_micros=op.get_attr("grad_timeout_micros"),
+        shared_name="batch_gradient_{}_{}".format(op.name, i))
+    if op.get_attr("bucket_boundaries"):
+      # Drop the gradient with respect to the padding added for bucketing.
+      input_shape = array_ops.shape(op.inputs[i])
+      gradient = array_ops.slice(
+          gradient, array_ops.zeros_like(input_shape), input_shape)
+    gradients.append(gradient)
   return gradients
 
 
@@ -61,6 +67,7 @@ def _UnbatchGrad(op, grad):   # pylint: disable=invalid-name
 
 def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
                    allowed_batch_sizes=None,
+                   bucket_boundaries=None,
                    grad_timeout_micros=60 * 1000 * 1000,
                    unbatch_timeout_micros=60 * 1000 * 1000):
   """Batches the computation done by the decorated function.
@@ -96,6 +103,11 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
      does nothing. Otherwise, supplies a list of batch sizes, causing the op
      to pad batches up to one of those sizes. The entries must increase
      monotonically, and the final entry must equal max_batch_size.
+    bucket_boundaries: Optional list of sizes for the second dimension of the
+     arguments, e.g. sequence lengths. If set, arguments of rank 2 or more are
+     zero-padded along their second dimension to the smallest entry that fits,
+     and only arguments padded to the same size are batched together. See the
+     documentation of the `Batch` op for more details.
     grad_timeout_micros: The timeout to use for the gradient. See the
      documentation of the unbatch op for more details. Defaults to 60s.
     unbatch_timeout_micros: The timeout to use for unbatching. See the
@@ -118,6 +130,7 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
             max_batch_size=max_batch_size,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
+            bucket_boundaries=bucket_boundaries,
             grad_timeout_micros=grad_timeout_micros,
             shared_name=name)
         outputs = f(*batched_tensors)
@@ -108,6 +108,53 @@ class BatchOpsTest(test.TestCase):
       # Check that the batch tensor incorporates the padding.
       self.assertEqual(len(batch_t), 5)
 
+  def testBatchWithBucketing(self):
+    """Test that tasks padded to the same bucket are batched together."""
+    with self.test_session() as sess:
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+      batched, index, _ = batch_ops.batch(
+          [inp], num_batch_threads=1, max_batch_size=2,
+          batch_timeout_micros=36000000,
+          bucket_boundaries=[4, 8],
+          grad_timeout_micros=0, batching_queue="")
+      thread_results = []
+
+      def worker():
+        thread_results.extend(
+            sess.run([batched, index], feed_dict={inp: [[1, 2]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run([batched, index], feed_dict={inp: [[3, 4, 5]]})
+      worker_thread.join()
+
+      # At this point either the thread or the main did the batch and the other
+      # should have empty results.
+      if list(thread_results[0][0]):
+        batch_t = thread_results[0][0]
+        empty_t = main_results[0][0]
+      else:
+        batch_t = main_results[0][0]
+        empty_t = thread_results[0][0]
+
+      # Both inputs were padded to the first bucket and batched together.
+      self.assertAllEqual(
+          sorted(batch_t.tolist()), [[1, 2, 0, 0], [3, 4, 5, 0]])
+      self.assertEqual(len(empty_t), 0)
+
+  def testIllegalBatchLargerThanLastBucket(self):
+    """Tests feeding a tensor that does not fit in any bucket."""
+    with self.test_session() as sess:
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+      batched, index, _ = batch_ops.batch(
+          [inp], num_batch_threads=1, max_batch_size=2,
+          batch_timeout_micros=0, bucket_boundaries=[2],
+          grad_timeout_micros=0, batching_queue="")
+      with self.assertRaises(Exception) as raised:
+        _ = sess.run([batched, index], feed_dict={inp: [[1, 2, 3]]})
+      self.assertGreater(
+          raised.exception.message.find("larger than the last entry"), 0)
+
   def testMultipleBatch(self):
     """Tests that multiple batched tensors execute together."""
     with self.test_session() as sess:
@@ -26,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/contrib/batching/batch_scheduler.h"
+#include "tensorflow/contrib/batching/util/adaptive_batching_policy.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -157,6 +158,20 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     int max_enqueued_batches = 10;
+
+    // If true, the queue chooses its batch timeout and a target batch size
+    // (at most 'max_batch_size') online, from the observed arrival rate and
+    // batch processing times, aiming at the latency target given in
+    // 'adaptive_batching_options'. 'batch_timeout_micros' only serves as the
+    // initial timeout. An open batch becomes schedulable once it reaches the
+    // target size or the current timeout. See AdaptiveBatchingPolicy.
+    bool enable_adaptive_batching = false;
+    AdaptiveBatchingPolicy::Options adaptive_batching_options;
+
+    // If set and adaptive batching is enabled, invoked from a batch thread
+    // with every new decision of the policy, e.g. to export it as metrics.
+    std::function<void(const AdaptiveBatchingPolicy::Decision&)>
+        adaptive_batching_decision_callback;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -223,6 +238,11 @@ namespace internal {
 // closed. If the front-most batch is open (i.e. the queue contains only one
 // batch) and has reached the timeout, it is immediately closed and returned;
 // otherwise no batch is returned for the request.
+//
+// With adaptive batching, the timeout and the size at which the open batch
+// becomes schedulable are set by an AdaptiveBatchingPolicy, which is fed the
+// size of every submitted task and the processing time and latency of every
+// processed batch.
 template <typename TaskType>
 class Queue {
  public:
@@ -230,7 +250,8 @@ class Queue {
       std::function<void(std::unique_ptr<Batch<TaskType>>)>;
   using SchedulableBatchCallback = std::function<void()>;
   Queue(const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
-        Env* env, ProcessBatchCallback process_batch_callback,
+        Env* env, int num_batch_threads,
+        ProcessBatchCallback process_batch_callback,
         SchedulableBatchCallback schdulable_batch_callback);
 
   // Illegal to destruct unless the queue is empty.
@@ -251,11 +272,15 @@ class Queue {
   // Called by a thread that is ready to process a batch, to request one from
   // this queue. Either returns a batch that is ready to be processed, or
   // nullptr if the queue declines to schedule a batch at this time. If it
-  // returns a batch, the batch is guaranteed to be closed.
-  std::unique_ptr<Batch<TaskType>> ScheduleBatch();
+  // returns a batch, the batch is guaranteed to be closed, and
+  // '*batch_start_time_micros' is set to the time its first task was enqueued.
+  std::unique_ptr<Batch<TaskType>> ScheduleBatch(
+      uint64* batch_start_time_micros);
 
-  // Processes a batch that has been returned earlier by ScheduleBatch().
-  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
+  // Processes a batch that has been returned earlier by ScheduleBatch(),
+  // along with the start time returned with it.
+  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                    uint64 batch_start_time_micros);
 
   // Determines whether the queue is empty, i.e. has no tasks waiting or being
   // processed.
@@ -308,6 +333,21 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ GUARDED_BY(mu_);
 
+  // The times at which the first task was added to each closed batch in
+  // 'batches_', front to back.
+  std::deque<uint64> closed_batch_start_times_micros_ GUARDED_BY(mu_);
+
+  // Chooses 'batch_timeout_micros_' and 'target_batch_size_' if adaptive
+  // batching is enabled; null otherwise.
+  std::unique_ptr<AdaptiveBatchingPolicy> adaptive_batching_policy_
+      GUARDED_BY(mu_);
+
+  // The open batch becomes schedulable once it has been open for this long,
+  // or contains at least 'target_batch_size_' units. Fixed to the
+  // corresponding options unless adaptive batching is enabled.
+  int64 batch_timeout_micros_ GUARDED_BY(mu_);
+  int target_batch_size_ GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled. Used
   // to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ GUARDED_BY(mu_) = false;
@@ -402,6 +442,35 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.enable_adaptive_batching) {
+    const AdaptiveBatchingPolicy::Options& adaptive_options =
+        options.adaptive_batching_options;
+    if (adaptive_options.p99_latency_target_micros <= 0) {
+      return errors::InvalidArgument(
+          "p99_latency_target_micros must be positive; was ",
+          adaptive_options.p99_latency_target_micros);
+    }
+    if (adaptive_options.max_batch_timeout_micros < 0) {
+      return errors::InvalidArgument(
+          "max_batch_timeout_micros must be non-negative; was ",
+          adaptive_options.max_batch_timeout_micros);
+    }
+    if (adaptive_options.adjustment_interval_batches <= 0) {
+      return errors::InvalidArgument(
+          "adjustment_interval_batches must be positive; was ",
+          adaptive_options.adjustment_interval_batches);
+    }
+    if (adaptive_options.cost_model_decay < 0 ||
+        adaptive_options.cost_model_decay >= 1) {
+      return errors::InvalidArgument("cost_model_decay must be in [0, 1); was ",
+                                     adaptive_options.cost_model_decay);
+    }
+    if (adaptive_options.arrival_rate_headroom < 1) {
+      return errors::InvalidArgument(
+          "arrival_rate_headroom must be at least 1; was ",
+          adaptive_options.arrival_rate_headroom);
+    }
+  }
 
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
@@ -409,8 +478,8 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
   };
   auto internal_queue =
       std::unique_ptr<internal::Queue<TaskType>>(new internal::Queue<TaskType>(
-          options, options_.env, process_batch_callback,
-          schedulable_batch_callback));
+          options, options_.env, options_.num_batch_threads,
+          process_batch_callback, schedulable_batch_callback));
   auto handle = std::unique_ptr<BatchScheduler<TaskType>>(
       new internal::QueueHandle<TaskType>(this->shared_from_this(),
                                           internal_queue.get()));
@@ -446,6 +515,8 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
   std::unique_ptr<Batch<TaskType>> batch_to_process;
   // The queue with which 'batch_to_process' is associated.
   internal::Queue<TaskType>* queue_for_batch = nullptr;
+  // The time at which the first task of 'batch_to_process' was enqueued.
+  uint64 batch_start_time_micros = 0;
   {
     mutex_lock l(mu_);
 
@@ -462,7 +533,8 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
       const bool queue_closed = (*next_queue_to_schedule_)->closed();
 
       // Ask '*next_queue_to_schedule_' if it wants us to process a batch.
-      batch_to_process = (*next_queue_to_schedule_)->ScheduleBatch();
+      batch_to_process =
+          (*next_queue_to_schedule_)->ScheduleBatch(&batch_start_time_micros);
       if (batch_to_process != nullptr) {
         queue_for_batch = next_queue_to_schedule_->get();
       }
@@ -491,7 +563,8 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
     }
   }
 
-  queue_for_batch->ProcessBatch(std::move(batch_to_process));
+  queue_for_batch->ProcessBatch(std::move(batch_to_process),
+                                batch_start_time_micros);
 }
 
 namespace internal {
@@ -499,12 +572,23 @@ namespace internal {
 template <typename TaskType>
 Queue<TaskType>::Queue(
     const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
-    Env* env, ProcessBatchCallback process_batch_callback,
+    Env* env, int num_batch_threads,
+    ProcessBatchCallback process_batch_callback,
     SchedulableBatchCallback schedulable_batch_callback)
     : options_(options),
       env_(env),
       process_batch_callback_(process_batch_callback),
-      schedulable_batch_callback_(schedulable_batch_callback) {
+      schedulable_batch_callback_(schedulable_batch_callback),
+      batch_timeout_micros_(options.batch_timeout_micros),
+      target_batch_size_(options.max_batch_size) {
+  if (options_.enable_adaptive_batching) {
+    adaptive_batching_policy_.reset(new AdaptiveBatchingPolicy(
+        options_.adaptive_batching_options, options_.max_batch_size,
+        options_.batch_timeout_micros, num_batch_threads, env_->NowMicros()));
+    batch_timeout_micros_ = adaptive_batching_policy_->batch_timeout_micros();
+    target_batch_size_ = adaptive_batching_policy_->target_batch_size();
+  }
+
   // Create an initial, open batch.
   batches_.emplace_back(new Batch<TaskType>);
 }
@@ -543,6 +627,9 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
     if (batches_.back()->empty()) {
       open_batch_start_time_micros_ = env_->NowMicros();
     }
+    if (adaptive_batching_policy_ != nullptr) {
+      adaptive_batching_policy_->RecordArrival((*task)->size());
+    }
     batches_.back()->AddTask(std::move(*task));
 
     if (!schedulable_batch_) {
@@ -582,7 +669,8 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
 }
 
 template <typename TaskType>
-std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch(
+    uint64* batch_start_time_micros) {
   // The batch to schedule, which we may populate below. (If left as nullptr,
   // that means we are electing not to schedule a batch at this time.)
   std::unique_ptr<Batch<TaskType>> batch_to_schedule;
@@ -600,6 +688,8 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
       ++num_batches_being_processed_;
       batch_to_schedule = std::move(batches_.front());
       batches_.pop_front();
+      *batch_start_time_micros = closed_batch_start_times_micros_.front();
+      closed_batch_start_times_micros_.pop_front();
     } else {
       schedulable_batch_ = false;
     }
@@ -609,8 +699,33 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 }
 
 template <typename TaskType>
-void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
+void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                                   uint64 batch_start_time_micros) {
+  const int64 batch_size = batch->size();
+  const uint64 processing_start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  const uint64 now_micros = env_->NowMicros();
+
+  // A copy of the policy's decision, if it made a new one, to report outside
+  // of 'mu_'.
+  std::unique_ptr<AdaptiveBatchingPolicy::Decision> new_decision;
+  {
+    mutex_lock l(mu_);
+    if (adaptive_batching_policy_ != nullptr &&
+        adaptive_batching_policy_->RecordBatch(
+            batch_size, now_micros - processing_start_time_micros,
+            now_micros - batch_start_time_micros, now_micros)) {
+      batch_timeout_micros_ = adaptive_batching_policy_->batch_timeout_micros();
+      target_batch_size_ = adaptive_batching_policy_->target_batch_size();
+      if (options_.adaptive_batching_decision_callback) {
+        new_decision.reset(new AdaptiveBatchingPolicy::Decision(
+            adaptive_batching_policy_->decision()));
+      }
+    }
+  }
+  if (new_decision != nullptr) {
+    options_.adaptive_batching_decision_callback(*new_decision);
+  }
 
   {
     mutex_lock l(mu_);
@@ -652,6 +767,7 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
   batches_.back()->Close();
+  closed_batch_start_times_micros_.push_back(open_batch_start_time_micros_);
   batches_.emplace_back(new Batch<TaskType>);
 }
 
@@ -661,9 +777,9 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
+  return closed_ || open_batch->size() >= target_batch_size_ ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros_;
 }
 
 template <typename TaskType>
@@ -591,6 +591,80 @@ TEST(SharedBatchSchedulerTest, QueueDestructorBlocksUntilAllTasksProcessed) {
   stop_teardown.Notify();
 }
 
+
+TEST(SharedBatchSchedulerTest, AdaptiveBatchingStopsWaitingUnderLightLoad) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    int num_batches_processed = 0;
+    Notification first_batch_processed, third_batch_processed;
+    auto callback = [&mu, &num_batches_processed, &first_batch_processed,
+                     &third_batch_processed](
+                        std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      EXPECT_EQ(1, batch->size());
+      mutex_lock l(mu);
+      ++num_batches_processed;
+      if (num_batches_processed == 1) {
+        first_batch_processed.Notify();
+      } else if (num_batches_processed == 3) {
+        third_batch_processed.Notify();
+      }
+    };
+
+    Notification decision_made;
+    AdaptiveBatchingPolicy::Decision decision;
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 1000;
+    queue_options.enable_adaptive_batching = true;
+    queue_options.adaptive_batching_options.p99_latency_target_micros = 2000;
+    queue_options.adaptive_batching_options.max_batch_timeout_micros = 1000;
+    queue_options.adaptive_batching_options.adjustment_interval_batches = 2;
+    queue_options.adaptive_batching_decision_callback =
+        [&decision, &decision_made](
+            const AdaptiveBatchingPolicy::Decision& new_decision) {
+          if (!decision_made.HasBeenNotified()) {
+            decision = new_decision;
+            decision_made.Notify();
+          }
+        };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Until the policy has seen any batches, underfull batches wait for the
+    // initial timeout.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(first_batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(1000);
+    first_batch_processed.WaitForNotification();
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(1000);
+
+    // Two tasks per two milliseconds do not call for batching, so once the
+    // policy has adjusted, batches are scheduled without waiting.
+    decision_made.WaitForNotification();
+    EXPECT_EQ(1, decision.target_batch_size);
+    EXPECT_EQ(2, decision.num_batches);
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    third_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
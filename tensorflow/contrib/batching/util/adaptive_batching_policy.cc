@@ -0,0 +1,126 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/util/adaptive_batching_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tensorflow {
+namespace serving {
+
+AdaptiveBatchingPolicy::AdaptiveBatchingPolicy(
+    const Options& options, int max_batch_size,
+    int64 initial_batch_timeout_micros, int num_batch_threads,
+    uint64 now_micros)
+    : options_(options),
+      max_batch_size_(max_batch_size),
+      num_batch_threads_(std::max(1, num_batch_threads)),
+      last_adjustment_micros_(now_micros) {
+  decision_.batch_timeout_micros =
+      std::min(initial_batch_timeout_micros, options_.max_batch_timeout_micros);
+  decision_.target_batch_size = max_batch_size_;
+}
+
+void AdaptiveBatchingPolicy::RecordArrival(int64 size) {
+  arrived_units_ += size;
+}
+
+bool AdaptiveBatchingPolicy::RecordBatch(int64 size, int64 processing_micros,
+                                         int64 latency_micros,
+                                         uint64 now_micros) {
+  const double d = options_.cost_model_decay;
+  const double x = size;
+  const double y = processing_micros;
+  sum_w_ = d * sum_w_ + 1;
+  sum_x_ = d * sum_x_ + x;
+  sum_y_ = d * sum_y_ + y;
+  sum_xx_ = d * sum_xx_ + x * x;
+  sum_xy_ = d * sum_xy_ + x * y;
+
+  latencies_micros_.push_back(latency_micros);
+  if (latencies_micros_.size() <
+      static_cast<size_t>(options_.adjustment_interval_batches)) {
+    return false;
+  }
+  Adjust(now_micros);
+  return true;
+}
+
+void AdaptiveBatchingPolicy::Adjust(uint64 now_micros) {
+  // Fit the cost model. If the batch sizes seen hardly vary, the fixed and
+  // per-unit costs cannot be told apart; attribute everything to the fixed
+  // cost, which favors batching.
+  const double mean_x = sum_x_ / sum_w_;
+  const double mean_y = sum_y_ / sum_w_;
+  const double var_x = sum_xx_ / sum_w_ - mean_x * mean_x;
+  double fixed = mean_y;
+  double per_unit = 0;
+  if (var_x > 1e-6 * std::max(1.0, mean_x * mean_x)) {
+    per_unit = std::max(0.0, (sum_xy_ / sum_w_ - mean_x * mean_y) / var_x);
+    fixed = std::max(0.0, mean_y - per_unit * mean_x);
+  }
+
+  // Arrival rate, in units per microsecond.
+  const double elapsed_micros =
+      std::max<double>(1, now_micros - last_adjustment_micros_);
+  const double rate = arrived_units_ / elapsed_micros;
+  const double provisioned_rate = rate * options_.arrival_rate_headroom;
+
+  // num_batch_threads * n / (fixed + per_unit * n) >= provisioned_rate
+  // <=> n >= provisioned_rate * fixed / (num_batch_threads -
+  //                                        provisioned_rate * per_unit).
+  int target_batch_size = max_batch_size_;
+  const double spare_threads =
+      num_batch_threads_ - provisioned_rate * per_unit;
+  if (spare_threads > 0) {
+    const double n = std::ceil(provisioned_rate * fixed / spare_threads);
+    target_batch_size =
+        static_cast<int>(std::min<double>(max_batch_size_, std::max(1.0, n)));
+  }
+
+  // Allow twice the expected time to accumulate a target batch, within the
+  // latency left over after processing it.
+  const double cost = fixed + per_unit * target_batch_size;
+  double timeout = options_.max_batch_timeout_micros;
+  if (rate > 0) {
+    timeout = std::min(timeout, 2 * target_batch_size / rate);
+  }
+  timeout = std::min(timeout, options_.p99_latency_target_micros - cost);
+
+  const size_t p99_index = (latencies_micros_.size() * 99) / 100;
+  std::nth_element(latencies_micros_.begin(),
+                   latencies_micros_.begin() + p99_index,
+                   latencies_micros_.end());
+  const int64 p99 = latencies_micros_[p99_index];
+  if (p99 > options_.p99_latency_target_micros) {
+    timeout = std::min<double>(timeout, decision_.batch_timeout_micros / 2);
+  }
+
+  decision_.batch_timeout_micros = static_cast<int64>(std::max(0.0, timeout));
+  decision_.target_batch_size = target_batch_size;
+  decision_.arrival_rate_per_second = rate * 1e6;
+  decision_.batch_cost_fixed_micros = fixed;
+  decision_.batch_cost_per_unit_micros = per_unit;
+  decision_.observed_p99_latency_micros = p99;
+  decision_.num_batches = latencies_micros_.size();
+
+  arrived_units_ = 0;
+  latencies_micros_.clear();
+  last_adjustment_micros_ = now_micros;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,133 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// AdaptiveBatchingPolicy chooses the batch timeout and the target batch size
+// of a batching queue online, so that batches are as small as the offered load
+// allows and tasks meet a 99th-percentile latency target.
+//
+// The policy keeps:
+//  - a cost model of batch processing time, cost(n) = fixed + per_unit * n,
+//    fitted by exponentially-weighted least squares to the processed batches;
+//  - the arrival rate of work (in task-size units per second), measured
+//    between adjustments;
+//  - the latencies of the oldest task of each batch processed since the last
+//    adjustment, i.e. the time from its Schedule() call until its batch was
+//    processed.
+//
+// Every 'adjustment_interval_batches' batches it picks the smallest target
+// batch size n for which 'num_batch_threads' threads can keep up with the
+// arrival rate (plus headroom), i.e. num_batch_threads * n / cost(n) exceeds
+// it, and a timeout long enough to accumulate such a batch but no longer than
+// the latency target minus cost(n) allows. If the observed p99 latency exceeds
+// the target anyway, the timeout is at least halved. Under light load this
+// yields a target size of 1, at which point batches are scheduled as soon as
+// they hold a task and the timeout adds no latency.
+//
+// This class is thread-compatible.
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCHING_POLICY_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCHING_POLICY_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+class AdaptiveBatchingPolicy {
+ public:
+  struct Options {
+    // The latency target for the 99th percentile of task latency, in
+    // microseconds. Must be positive.
+    int64 p99_latency_target_micros = 100 * 1000;
+
+    // Upper bound for the batch timeout, in microseconds.
+    int64 max_batch_timeout_micros = 100 * 1000;
+
+    // The number of processed batches between adjustments. Must be positive.
+    int adjustment_interval_batches = 16;
+
+    // The weight of past batches in the cost model is multiplied by this
+    // factor for every new batch. Must be in [0, 1).
+    double cost_model_decay = 0.98;
+
+    // The arrival rate is provisioned with this factor of headroom. Must be
+    // at least 1.
+    double arrival_rate_headroom = 1.25;
+  };
+
+  // A decision of the policy, with the measurements it was based on.
+  struct Decision {
+    int64 batch_timeout_micros = 0;
+    int target_batch_size = 0;
+    double arrival_rate_per_second = 0;
+    double batch_cost_fixed_micros = 0;
+    double batch_cost_per_unit_micros = 0;
+    int64 observed_p99_latency_micros = 0;
+    int num_batches = 0;
+  };
+
+  // 'initial_batch_timeout_micros' is the timeout to use until the first
+  // adjustment. The target batch size starts out at 'max_batch_size'.
+  AdaptiveBatchingPolicy(const Options& options, int max_batch_size,
+                         int64 initial_batch_timeout_micros,
+                         int num_batch_threads, uint64 now_micros);
+
+  // Records that a task of 'size' units was enqueued.
+  void RecordArrival(int64 size);
+
+  // Records that a batch of 'size' units took 'processing_micros' to process,
+  // and that its oldest task was enqueued 'latency_micros' before processing
+  // finished at 'now_micros'. Returns true if this made the policy adjust
+  // its decision.
+  bool RecordBatch(int64 size, int64 processing_micros, int64 latency_micros,
+                   uint64 now_micros);
+
+  int64 batch_timeout_micros() const { return decision_.batch_timeout_micros; }
+  int target_batch_size() const { return decision_.target_batch_size; }
+  const Decision& decision() const { return decision_; }
+
+ private:
+  void Adjust(uint64 now_micros);
+
+  const Options options_;
+  const int max_batch_size_;
+  const int num_batch_threads_;
+
+  // Exponentially-weighted sums over processed batches, of the weights, the
+  // sizes x, the costs y, x^2 and x*y.
+  double sum_w_ = 0;
+  double sum_x_ = 0;
+  double sum_y_ = 0;
+  double sum_xx_ = 0;
+  double sum_xy_ = 0;
+
+  // Work that arrived, and latencies of batches processed, since the last
+  // adjustment, which happened at 'last_adjustment_micros_'.
+  int64 arrived_units_ = 0;
+  std::vector<int64> latencies_micros_;
+  uint64 last_adjustment_micros_;
+
+  Decision decision_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveBatchingPolicy);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCHING_POLICY_H_
@@ -0,0 +1,109 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/util/adaptive_batching_policy.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+AdaptiveBatchingPolicy::Options TestOptions() {
+  AdaptiveBatchingPolicy::Options options;
+  options.p99_latency_target_micros = 10 * 1000;
+  options.max_batch_timeout_micros = 10 * 1000;
+  options.adjustment_interval_batches = 8;
+  options.arrival_rate_headroom = 1;
+  return options;
+}
+
+// Feeds 'policy' 'arrived_units' units of work, and batches of sizes 1..8 whose
+// processing time is 128 + 8 * size microseconds and whose latency is
+// 'latency_micros', and makes it adjust at 'now_micros'.
+void RunInterval(int64 arrived_units, int64 latency_micros, uint64 now_micros,
+                 AdaptiveBatchingPolicy* policy) {
+  policy->RecordArrival(arrived_units);
+  for (int size = 1; size <= 8; ++size) {
+    const bool adjusted =
+        policy->RecordBatch(size, 128 + 8 * size, latency_micros, now_micros);
+    EXPECT_EQ(size == 8, adjusted);
+  }
+}
+
+TEST(AdaptiveBatchingPolicyTest, InitialDecision) {
+  AdaptiveBatchingPolicy policy(TestOptions(), 100, 20 * 1000, 2, 0);
+  EXPECT_EQ(100, policy.target_batch_size());
+  // Clamped to 'max_batch_timeout_micros'.
+  EXPECT_EQ(10 * 1000, policy.batch_timeout_micros());
+}
+
+TEST(AdaptiveBatchingPolicyTest, FitsCostModelAndArrivalRate) {
+  AdaptiveBatchingPolicy policy(TestOptions(), 100, 1000, 1, 0);
+  // 1/16 units per microsecond.
+  RunInterval(62500, 300, 1000 * 1000, &policy);
+
+  const AdaptiveBatchingPolicy::Decision& decision = policy.decision();
+  EXPECT_NEAR(128, decision.batch_cost_fixed_micros, 1e-3);
+  EXPECT_NEAR(8, decision.batch_cost_per_unit_micros, 1e-3);
+  EXPECT_NEAR(62500, decision.arrival_rate_per_second, 1e-3);
+  EXPECT_EQ(300, decision.observed_p99_latency_micros);
+  EXPECT_EQ(8, decision.num_batches);
+
+  // One thread keeps up with 1/16 units per microsecond once
+  // n / (128 + 8n) >= 1/16, i.e. n >= 16. Accumulating 16 units takes 256
+  // microseconds; the timeout allows twice that.
+  EXPECT_NEAR(16, policy.target_batch_size(), 1);
+  EXPECT_NEAR(512, policy.batch_timeout_micros(), 40);
+}
+
+TEST(AdaptiveBatchingPolicyTest, LightLoadDisablesBatching) {
+  AdaptiveBatchingPolicy policy(TestOptions(), 100, 1000, 4, 0);
+  RunInterval(100, 300, 1000 * 1000, &policy);
+  EXPECT_EQ(1, policy.target_batch_size());
+}
+
+TEST(AdaptiveBatchingPolicyTest, OverloadUsesMaxBatchSize) {
+  AdaptiveBatchingPolicy policy(TestOptions(), 100, 1000, 1, 0);
+  // More than the 1/8 units per microsecond one thread can ever process.
+  RunInterval(200 * 1000, 300, 1000 * 1000, &policy);
+  EXPECT_EQ(100, policy.target_batch_size());
+}
+
+TEST(AdaptiveBatchingPolicyTest, TimeoutLeavesRoomForProcessing) {
+  AdaptiveBatchingPolicy::Options options = TestOptions();
+  options.p99_latency_target_micros = 1000;
+  AdaptiveBatchingPolicy policy(options, 100, 1000, 1, 0);
+  RunInterval(100, 300, 1000 * 1000, &policy);
+  // The expected time to accumulate a batch far exceeds the latency target,
+  // so the timeout is what remains after processing a batch of one.
+  EXPECT_EQ(1, policy.target_batch_size());
+  EXPECT_NEAR(1000 - 136, policy.batch_timeout_micros(), 1);
+}
+
+TEST(AdaptiveBatchingPolicyTest, LatencyViolationShrinksTimeout) {
+  AdaptiveBatchingPolicy policy(TestOptions(), 100, 1000, 1, 0);
+  RunInterval(62500, 300, 1000 * 1000, &policy);
+  const int64 timeout = policy.batch_timeout_micros();
+  ASSERT_GT(timeout, 0);
+
+  RunInterval(62500, 20 * 1000, 2 * 1000 * 1000, &policy);
+  EXPECT_EQ(20 * 1000, policy.decision().observed_p99_latency_micros);
+  EXPECT_LE(policy.batch_timeout_micros(), timeout / 2);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
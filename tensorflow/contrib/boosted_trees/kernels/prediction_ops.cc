@@ -260,6 +260,8 @@ class GradientTreesPredictionOp : public OpKernel {
     // Run predictor.
     thread::ThreadPool* const worker_threads =
         context->device()->tensorflow_cpu_worker_threads()->workers;
+    const auto compiled_trees =
+        decision_tree_ensemble_resource->compiled_trees();
 
     if (apply_averaging_) {
       DecisionTreeEnsembleConfig adjusted =
@@ -280,13 +282,15 @@ class GradientTreesPredictionOp : public OpKernel {
             i, weight * (num_ensembles - i + start_averaging) / num_ensembles);
       }
       MultipleAdditiveTrees::Predict(
-          adjusted, only_finalized_trees_, dropped_trees, batch_features,
-          worker_threads, output_predictions, output_no_dropout_predictions);
+          adjusted, *compiled_trees, only_finalized_trees_, dropped_trees,
+          batch_features, worker_threads, output_predictions,
+          output_no_dropout_predictions);
     } else {
       MultipleAdditiveTrees::Predict(
           decision_tree_ensemble_resource->decision_tree_ensemble(),
-          only_finalized_trees_, dropped_trees, batch_features, worker_threads,
-          output_predictions, output_no_dropout_predictions);
+          *compiled_trees, only_finalized_trees_, dropped_trees,
+          batch_features, worker_threads, output_predictions,
+          output_no_dropout_predictions);
     }
 
     // Output dropped trees and original weights.
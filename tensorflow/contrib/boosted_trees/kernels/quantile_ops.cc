@@ -13,6 +13,7 @@
 // limitations under the License.
 // =============================================================================
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -69,6 +70,12 @@ const char* const kBucketsName = "buckets";
 const char* const kStreamStateName = "stream_state";
 const char* const kSummariesName = "summaries";
 
+// Features with more entries than this are summarized in chunks of at least
+// this many entries in parallel, and the chunk summaries are then merged.
+const int64 kMinChunkEntries = 64 * 1024;
+// The estimated cost of pushing an entry to a quantile stream.
+const int64 kCostPerEntry = 500;
+
 using QuantileStream =
     boosted_trees::quantiles::WeightedQuantilesStream<float, float>;
 using QuantileSummary =
@@ -77,14 +84,6 @@ using QuantileSummaryEntry =
     boosted_trees::quantiles::WeightedQuantilesSummary<float,
                                                        float>::SummaryEntry;
 
-std::vector<float> GetBuckets(const int32 feature,
-                              const OpInputList& buckets_list) {
-  const auto& buckets = buckets_list[feature].flat<float>();
-  std::vector<float> buckets_vector(buckets.data(),
-                                    buckets.data() + buckets.size());
-  return buckets_vector;
-}
-
 void QuantizeFeatures(const string& output_name, const OpInputList& values_list,
                       const OpInputList& buckets_list,
                       OpKernelContext* const context) {
@@ -94,31 +93,116 @@ void QuantizeFeatures(const string& output_name, const OpInputList& values_list,
   OpOutputList output_list;
   OP_REQUIRES_OK(context, context->output_list(output_name, &output_list));
 
+  std::vector<Tensor*> outputs(values_list.size(), nullptr);
+  int64 num_values = 0;
   for (int32 feature_index = 0; feature_index < values_list.size();
        ++feature_index) {
-    const Tensor& values_tensor = values_list[feature_index];
-    const int64 num_values = values_tensor.dim_size(0);
+    const int64 num_feature_values = values_list[feature_index].dim_size(0);
+    OP_REQUIRES_OK(context,
+                   output_list.allocate(feature_index,
+                                        TensorShape({num_feature_values}),
+                                        &outputs[feature_index]));
+    num_values += num_feature_values;
+  }
 
-    Tensor* output_t = nullptr;
-    OP_REQUIRES_OK(
-        context, output_list.allocate(feature_index, TensorShape({num_values}),
-                                      &output_t));
-    TTypes<int32>::Vec output = output_t->vec<int32>();
-    const std::vector<float>& buckets_vector =
-        GetBuckets(feature_index, buckets_list);
-    auto flat_values = values_tensor.flat<float>();
-    for (int64 instance = 0; instance < num_values; ++instance) {
-      const float value = flat_values(instance);
-      auto bucket_iter =
-          std::lower_bound(buckets_vector.begin(), buckets_vector.end(), value);
-      if (bucket_iter == buckets_vector.end()) {
-        --bucket_iter;
+  auto do_quantize = [&](const int64 begin, const int64 end) {
+    for (int64 feature_index = begin; feature_index < end; ++feature_index) {
+      TTypes<int32>::Vec output = outputs[feature_index]->vec<int32>();
+      const auto buckets = buckets_list[feature_index].flat<float>();
+      const float* const buckets_begin = buckets.data();
+      const float* const buckets_end = buckets.data() + buckets.size();
+      auto flat_values = values_list[feature_index].flat<float>();
+      for (int64 instance = 0; instance < output.size(); ++instance) {
+        const float* bucket_iter =
+            std::lower_bound(buckets_begin, buckets_end, flat_values(instance));
+        if (bucket_iter == buckets_end) {
+          --bucket_iter;
+        }
+        output(instance) = static_cast<int32>(bucket_iter - buckets_begin);
       }
-      const int32 bucket =
-          static_cast<int32>(bucket_iter - buckets_vector.begin());
-      output(instance) = bucket;
     }
+  };
+  // Each value costs a binary search over the buckets.
+  const int64 kCostPerUnit = 50 * (num_values / values_list.size() + 1);
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, values_list.size(),
+        kCostPerUnit, do_quantize);
+}
+
+// Summarizes the entries of "num_features" features, in parallel over the
+// features and over chunks of the entries of large features. The entries
+// [begin, end) of feature "feature" are pushed to a stream by
+// "push_entries(feature, begin, end, stream)", and "num_entries(feature)"
+// and "epsilon(feature)" give their number and the desired approximation
+// error. The chunk summaries of each feature are merged pairwise, like a
+// tree, and "done(feature, summary)" is then called in parallel with the
+// merged summary.
+void SummarizeFeatures(
+    OpKernelContext* const context, const int64 num_features,
+    const std::function<int64(int64)>& num_entries,
+    const std::function<float(int64)>& epsilon,
+    const std::function<void(int64, int64, int64, QuantileStream*)>&
+        push_entries,
+    const std::function<void(int64, QuantileSummary*)>& done) {
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+
+  // The chunks of feature i are [chunk_offsets[i], chunk_offsets[i + 1]),
+  // and chunk j holds the entries [chunk_begins[j], chunk_ends[j]).
+  std::vector<int64> chunk_offsets = {0};
+  std::vector<int64> chunk_features;
+  std::vector<int64> chunk_begins;
+  std::vector<int64> chunk_ends;
+  int64 total_entries = 0;
+  for (int64 i = 0; i < num_features; ++i) {
+    const int64 size = num_entries(i);
+    const int64 num_chunks =
+        std::max(int64{1}, std::min<int64>(size / kMinChunkEntries,
+                                           worker_threads.num_threads));
+    for (int64 j = 0; j < num_chunks; ++j) {
+      chunk_features.push_back(i);
+      chunk_begins.push_back(size * j / num_chunks);
+      chunk_ends.push_back(size * (j + 1) / num_chunks);
+    }
+    chunk_offsets.push_back(chunk_features.size());
+    total_entries += size;
+  }
+  const int64 num_chunks = chunk_features.size();
+  if (num_chunks == 0) {
+    return;
   }
+
+  std::vector<QuantileSummary> summaries(num_chunks);
+  auto do_summarize_chunks = [&](const int64 begin, const int64 end) {
+    for (int64 j = begin; j < end; ++j) {
+      QuantileStream stream(epsilon(chunk_features[j]),
+                            chunk_ends[j] - chunk_begins[j] + 1);
+      push_entries(chunk_features[j], chunk_begins[j], chunk_ends[j], &stream);
+      stream.Finalize();
+      summaries[j] = stream.GetFinalSummary();
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+        kCostPerEntry * (total_entries / num_chunks + 1), do_summarize_chunks);
+
+  auto do_merge_chunks = [&](const int64 begin, const int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      // Merging the summaries pairwise merges every entry a logarithmic
+      // rather than linear number of times in the number of chunks.
+      const int64 first = chunk_offsets[i];
+      const int64 size = chunk_offsets[i + 1] - first;
+      for (int64 stride = 1; stride < size; stride *= 2) {
+        for (int64 j = 0; j + stride < size; j += 2 * stride) {
+          summaries[first + j].Merge(summaries[first + j + stride]);
+          summaries[first + j + stride].Clear();
+        }
+      }
+      done(i, &summaries[first]);
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_features,
+        kCostPerEntry * (total_entries / num_features + 1), do_merge_chunks);
 }
 
 // Validates attributes for the quantile ops.
@@ -149,10 +233,10 @@ void ParseConfig(OpKernelConstruction* const context, const string& name,
   }
 }
 
-// Generates quantiles on a finalized QuantileStream.
-std::vector<float> GenerateBoundaries(const QuantileStream& stream,
+// Generates quantiles on the summary of a finalized QuantileStream.
+std::vector<float> GenerateBoundaries(const QuantileSummary& summary,
                                       int num_boundaries) {
-  std::vector<float> boundaries = stream.GenerateBoundaries(num_boundaries);
+  std::vector<float> boundaries = summary.GenerateBoundaries(num_boundaries);
 
   // Uniquify elements as we may get dupes.
   auto end_it = std::unique(boundaries.begin(), boundaries.end());
@@ -344,65 +428,60 @@ class MakeQuantileSummariesOp : public OpKernel {
     OP_REQUIRES_OK(context, context->output_list(kDenseSummariesName,
                                                  &dense_summaries_output_list));
 
-    auto do_quantile_summary_gen = [&](const int64 begin, const int64 end) {
-      auto copy_over_summaries = [&](const QuantileStream& stream,
-                                     const int64 index,
-                                     OpOutputList* output_list) {
-        protobuf::Arena arena;
-        ::boosted_trees::QuantileSummaryState* summary_proto =
-            protobuf::Arena::CreateMessage<
-            ::boosted_trees::QuantileSummaryState>(&arena);
-        const auto& summary = stream.GetFinalSummary();
-        CopySummaryToProto(summary, summary_proto);
-        // Output to tensor.
-        Tensor* output_t = nullptr;
-        OP_REQUIRES_OK(context, output_list->allocate(index, {}, &output_t));
-        summary_proto->SerializeToString(&output_t->scalar<string>()());
-      };
-
-      // These are blocks of ranges. We are iterating over both sparse and
-      // dense features i.e. [0, sparse_features.size() + dense_features.size()]
-      for (int64 i = begin; i < end; ++i) {
-        if (i < num_dense_features_) {
-          const int64 dense_index = i;
-          const auto dense_values =
-              dense_float_features_list[dense_index].flat<float>();
-          QuantileStream stream(epsilon_, batch_size + 1);
-          // Run quantile summary generation.
-          for (int64 j = 0; j < batch_size; ++j) {
-            stream.PushEntry(dense_values(j), example_weights(j));
-          }
-          stream.Finalize();
-          // Copy summaries to output.
-          copy_over_summaries(stream, dense_index,
-                              &dense_summaries_output_list);
-        } else {
-          const int64 sparse_index = i - num_dense_features_;
-          const auto sparse_values =
-              sparse_float_feature_values_list[sparse_index].flat<float>();
-          const auto sparse_indices =
-              sparse_float_feature_indices_list[sparse_index].matrix<int64>();
-          QuantileStream stream(epsilon_, batch_size + 1);
-          // Run quantile summary generation.
-          const int64 num_sparse_rows =
-              sparse_float_feature_indices_list[sparse_index].dim_size(0);
-          for (int64 j = 0; j < num_sparse_rows; ++j) {
-            const int64 example_id = sparse_indices(j, 0);
-            stream.PushEntry(sparse_values(j), example_weights(example_id));
-          }
-          stream.Finalize();
-          // Copy summaries to output.
-          copy_over_summaries(stream, sparse_index,
-                              &sparse_summaries_output_list);
+    // We are iterating over both dense and sparse features i.e.
+    // [0, dense_features.size() + sparse_features.size()]
+    auto num_entries = [&](const int64 i) {
+      if (i < num_dense_features_) {
+        return batch_size;
+      }
+      return sparse_float_feature_indices_list[i - num_dense_features_]
+          .dim_size(0);
+    };
+    auto epsilon = [this](const int64 i) { return epsilon_; };
+    auto push_entries = [&](const int64 i, const int64 begin, const int64 end,
+                            QuantileStream* stream) {
+      if (i < num_dense_features_) {
+        const auto dense_values = dense_float_features_list[i].flat<float>();
+        for (int64 j = begin; j < end; ++j) {
+          stream->PushEntry(dense_values(j), example_weights(j));
         }
+      } else {
+        const int64 sparse_index = i - num_dense_features_;
+        const auto sparse_values =
+            sparse_float_feature_values_list[sparse_index].flat<float>();
+        const auto sparse_indices =
+            sparse_float_feature_indices_list[sparse_index].matrix<int64>();
+        for (int64 j = begin; j < end; ++j) {
+          const int64 example_id = sparse_indices(j, 0);
+          stream->PushEntry(sparse_values(j), example_weights(example_id));
+        }
+      }
+    };
+    // The summaries are compressed to the block size of a stream over the
+    // whole batch before they are sent to the accumulator, which only adds
+    // about epsilon / log(epsilon * batch_size) to their error.
+    const int64 block_size =
+        std::get<1>(QuantileStream::GetQuantileSpecs(epsilon_, batch_size + 1));
+    auto copy_over_summary = [&](const int64 i, QuantileSummary* summary) {
+      summary->Compress(block_size);
+      protobuf::Arena arena;
+      ::boosted_trees::QuantileSummaryState* summary_proto =
+          protobuf::Arena::CreateMessage<
+          ::boosted_trees::QuantileSummaryState>(&arena);
+      CopySummaryToProto(*summary, summary_proto);
+      // Output to tensor.
+      Tensor* output_t = nullptr;
+      if (i < num_dense_features_) {
+        OP_REQUIRES_OK(context,
+                       dense_summaries_output_list.allocate(i, {}, &output_t));
+      } else {
+        OP_REQUIRES_OK(context, sparse_summaries_output_list.allocate(
+                                    i - num_dense_features_, {}, &output_t));
       }
+      summary_proto->SerializeToString(&output_t->scalar<string>()());
     };
-    const int64 kCostPerUnit = 500 * batch_size;
-    const int64 num_features = num_sparse_features_ + num_dense_features_;
-    const DeviceBase::CpuWorkerThreads& worker_threads =
-        *context->device()->tensorflow_cpu_worker_threads();
-    Shard(worker_threads.num_threads, worker_threads.workers, num_features,
-          kCostPerUnit, do_quantile_summary_gen);
+    SummarizeFeatures(context, num_sparse_features_ + num_dense_features_,
+                      num_entries, epsilon, push_entries, copy_over_summary);
   }
 
  private:
@@ -573,7 +652,8 @@ class QuantileAccumulatorFlushOp : public OpKernel {
     stream->Finalize();
     streams_resource->set_boundaries(
         stamp_token,
-        GenerateBoundaries(*stream, streams_resource->num_quantiles()));
+        GenerateBoundaries(stream->GetFinalSummary(),
+                           streams_resource->num_quantiles()));
     streams_resource->Reset(next_stamp_token);
   }
 };
@@ -696,57 +776,54 @@ class QuantileBucketsOp : public OpKernel {
     OP_REQUIRES_OK(context, context->output_list(kDenseBucketsName,
                                                  &dense_buckets_output_list));
 
-    auto do_quantile_bucket_gen = [&](const int64 begin, const int64 end) {
-      // These are blocks of ranges. We are iterating over both sparse and
-      // dense features i.e. [0, sparse_features.size() + dense_features.size()]
-      for (int64 i = begin; i < end; ++i) {
-        if (i < sparse_configs_.size()) {
-          const int64 sparse_index = i;
-          const auto sparse_values =
-              sparse_float_feature_values_list[sparse_index].flat<float>();
-          const auto sparse_indices =
-              sparse_float_feature_indices_list[sparse_index].matrix<int64>();
-          QuantileStream stream(sparse_configs_[sparse_index].eps(),
-                                batch_size);
-          // Run quantile summary generation.
-          const int64 num_sparse_rows =
-              sparse_float_feature_indices_list[sparse_index].dim_size(0);
-          for (int64 j = 0; j < num_sparse_rows; ++j) {
-            const int64 example_id = sparse_indices(j, 0);
-            stream.PushEntry(sparse_values(j), example_weights(example_id));
-          }
-          stream.Finalize();
-          // Create buckets.
-          const auto boundaries = GenerateBoundaries(
-              stream, sparse_configs_[sparse_index].num_quantiles());
-          CopyBoundaries(context, boundaries, sparse_index,
-                         &sparse_buckets_output_list);
-
-        } else {
-          const int64 dense_index = i - sparse_configs_.size();
-          const auto dense_values =
-              dense_float_features_list[dense_index].flat<float>();
-          QuantileStream stream(dense_configs_[dense_index].eps(), batch_size);
-          // Run quantile summary generation.
-          for (int64 j = 0; j < batch_size; ++j) {
-            stream.PushEntry(dense_values(j), example_weights(j));
-          }
-          stream.Finalize();
-          // Create buckets.
-          const auto boundaries = GenerateBoundaries(
-              stream, dense_configs_[dense_index].num_quantiles());
-          CopyBoundaries(context, boundaries, dense_index,
-                         &dense_buckets_output_list);
+    // We are iterating over both sparse and dense features i.e.
+    // [0, sparse_features.size() + dense_features.size()]
+    const int64 num_sparse = sparse_configs_.size();
+    auto num_entries = [&](const int64 i) {
+      if (i < num_sparse) {
+        return sparse_float_feature_indices_list[i].dim_size(0);
+      }
+      return batch_size;
+    };
+    auto epsilon = [&](const int64 i) {
+      return i < num_sparse ? sparse_configs_[i].eps()
+                            : dense_configs_[i - num_sparse].eps();
+    };
+    auto push_entries = [&](const int64 i, const int64 begin, const int64 end,
+                            QuantileStream* stream) {
+      if (i < num_sparse) {
+        const auto sparse_values =
+            sparse_float_feature_values_list[i].flat<float>();
+        const auto sparse_indices =
+            sparse_float_feature_indices_list[i].matrix<int64>();
+        for (int64 j = begin; j < end; ++j) {
+          const int64 example_id = sparse_indices(j, 0);
+          stream->PushEntry(sparse_values(j), example_weights(example_id));
+        }
+      } else {
+        const auto dense_values =
+            dense_float_features_list[i - num_sparse].flat<float>();
+        for (int64 j = begin; j < end; ++j) {
+          stream->PushEntry(dense_values(j), example_weights(j));
         }
       }
     };
-
-    const int64 kCostPerUnit = 500 * batch_size;
-    const int64 num_features = sparse_configs_.size() + dense_configs_.size();
-    const DeviceBase::CpuWorkerThreads& worker_threads =
-        *context->device()->tensorflow_cpu_worker_threads();
-    Shard(worker_threads.num_threads, worker_threads.workers, num_features,
-          kCostPerUnit, do_quantile_bucket_gen);
+    // Create buckets.
+    auto copy_over_buckets = [&](const int64 i, QuantileSummary* summary) {
+      if (i < num_sparse) {
+        const auto boundaries =
+            GenerateBoundaries(*summary, sparse_configs_[i].num_quantiles());
+        CopyBoundaries(context, boundaries, i, &sparse_buckets_output_list);
+      } else {
+        const int64 dense_index = i - num_sparse;
+        const auto boundaries = GenerateBoundaries(
+            *summary, dense_configs_[dense_index].num_quantiles());
+        CopyBoundaries(context, boundaries, dense_index,
+                       &dense_buckets_output_list);
+      }
+    };
+    SummarizeFeatures(context, sparse_configs_.size() + dense_configs_.size(),
+                      num_entries, epsilon, push_entries, copy_over_buckets);
   }
 
  private:
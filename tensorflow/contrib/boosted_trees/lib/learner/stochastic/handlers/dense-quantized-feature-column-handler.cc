@@ -51,12 +51,58 @@ void DenseQuantizedFeatureColumnHandler::AggregateGradientStats(
   }
 }
 
+void DenseQuantizedFeatureColumnHandler::AggregateGradientHistogram(
+    const std::vector<int32>& example_partition_ids,
+    const Tensor& example_first_order_gradients,
+    const Tensor& example_second_order_gradients,
+    GradientHistogram* gradient_histogram) const {
+  for (int64 example_idx = 0; example_idx < batch_size_; ++example_idx) {
+    const int32 partition_id = example_partition_ids[example_idx];
+    if (partition_id < 0) {
+      continue;
+    }
+    gradient_histogram->AddExample(
+        partition_id, dense_quantized_values_(example_idx),
+        example_first_order_gradients, example_second_order_gradients,
+        example_idx);
+  }
+}
+
 void DenseQuantizedFeatureColumnHandler::GenerateFeatureSplitCandidates(
     const LearnerConfig& learner_config, const std::vector<int32>& roots,
     const std::vector<NodeStats>& root_stats,
     const FeatureStatsAccumulator<GradientStats, GradientStatsAccumulator>&
         gradient_stats_accumulator,
     std::vector<FeatureSplitCandidate>* split_candidates) const {
+  GenerateFeatureSplitCandidates(
+      learner_config, roots, root_stats,
+      [this, &gradient_stats_accumulator](int32 partition_id,
+                                          int32 bucket_id) {
+        return gradient_stats_accumulator.GetStats(slot_id_, class_id_,
+                                                   partition_id, bucket_id);
+      },
+      split_candidates);
+}
+
+void DenseQuantizedFeatureColumnHandler::
+    GenerateFeatureSplitCandidatesFromHistogram(
+        const LearnerConfig& learner_config, const std::vector<int32>& roots,
+        const std::vector<NodeStats>& root_stats,
+        const GradientHistogram& gradient_histogram,
+        std::vector<FeatureSplitCandidate>* split_candidates) const {
+  GenerateFeatureSplitCandidates(
+      learner_config, roots, root_stats,
+      [&gradient_histogram](int32 partition_id, int32 bucket_id) {
+        return gradient_histogram.GetStats(partition_id, bucket_id);
+      },
+      split_candidates);
+}
+
+void DenseQuantizedFeatureColumnHandler::GenerateFeatureSplitCandidates(
+    const LearnerConfig& learner_config, const std::vector<int32>& roots,
+    const std::vector<NodeStats>& root_stats,
+    const std::function<GradientStats(int32, int32)>& get_stats,
+    std::vector<FeatureSplitCandidate>* split_candidates) const {
   // Evaluate split candidates for every root as each is a separate
   // logical partition over the examples.
   // Then for each root, we do a forward-only pass over the quantized
@@ -78,8 +124,7 @@ void DenseQuantizedFeatureColumnHandler::GenerateFeatureSplitCandidates(
         std::numeric_limits<float>::lowest();
     for (int bucket_id = 0; bucket_id < dense_quantiles_.size(); ++bucket_id) {
       // Get gradient stats.
-      auto gradient_stats = gradient_stats_accumulator.GetStats(
-          slot_id_, class_id_, partition_id, bucket_id);
+      auto gradient_stats = get_stats(partition_id, bucket_id);
       if (gradient_stats.IsZero()) {
         continue;
       }
@@ -15,6 +15,8 @@
 #ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_HANDLERS_DENSE_QUANTIZED_FEATURE_COLUMN_HANDLER_H_
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_HANDLERS_DENSE_QUANTIZED_FEATURE_COLUMN_HANDLER_H_
 
+#include <functional>
+
 #include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/feature-column-handler.h"
 
 namespace tensorflow {
@@ -48,7 +50,31 @@ class DenseQuantizedFeatureColumnHandler : public FeatureColumnHandler {
           gradient_stats_accumulator,
       std::vector<FeatureSplitCandidate>* split_candidates) const override;
 
+  int32 num_histogram_buckets() const override {
+    return dense_quantiles_.size();
+  }
+
+  void AggregateGradientHistogram(
+      const std::vector<int32>& example_partition_ids,
+      const Tensor& example_first_order_gradients,
+      const Tensor& example_second_order_gradients,
+      GradientHistogram* gradient_histogram) const override;
+
+  void GenerateFeatureSplitCandidatesFromHistogram(
+      const LearnerConfig& learner_config, const std::vector<int32>& roots,
+      const std::vector<NodeStats>& root_stats,
+      const GradientHistogram& gradient_histogram,
+      std::vector<FeatureSplitCandidate>* split_candidates) const override;
+
  protected:
+  // Generates split candidates from the stats of each (partition, bucket)
+  // pair returned by "get_stats".
+  void GenerateFeatureSplitCandidates(
+      const LearnerConfig& learner_config, const std::vector<int32>& roots,
+      const std::vector<NodeStats>& root_stats,
+      const std::function<GradientStats(int32, int32)>& get_stats,
+      std::vector<FeatureSplitCandidate>* split_candidates) const;
+
   const int32 dense_feature_column_;
   TTypes<float>::ConstVec dense_quantiles_;
   TTypes<int32>::ConstVec dense_quantized_values_;
@@ -19,6 +19,7 @@
 #include <vector>
 #include "tensorflow/contrib/boosted_trees/lib/learner/common/accumulators/feature-stats-accumulator.h"
 #include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/stats/feature-split-candidate.h"
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/stats/gradient-histogram.h"
 #include "tensorflow/contrib/boosted_trees/proto/learner.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
@@ -58,6 +59,33 @@ class FeatureColumnHandler {
           gradient_stats_accumulator,
       std::vector<FeatureSplitCandidate>* split_candidates) const = 0;
 
+  // Returns the number of buckets of the feature column's gradient histogram,
+  // or 0 if its stats can't be accumulated in a dense histogram, in which
+  // case the histogram methods below must not be called.
+  virtual int32 num_histogram_buckets() const { return 0; }
+
+  // Aggregates example gradient stats for the feature column into a dense
+  // histogram, skipping examples with a negative partition id.
+  virtual void AggregateGradientHistogram(
+      const std::vector<int32>& example_partition_ids,
+      const Tensor& example_first_order_gradients,
+      const Tensor& example_second_order_gradients,
+      GradientHistogram* gradient_histogram) const {
+    LOG(FATAL) << "Feature column " << slot_id_
+               << " does not support gradient histograms.";
+  }
+
+  // Generates feature column split candidates for the specified roots from
+  // a dense histogram.
+  virtual void GenerateFeatureSplitCandidatesFromHistogram(
+      const LearnerConfig& learner_config, const std::vector<int32>& roots,
+      const std::vector<NodeStats>& root_stats,
+      const GradientHistogram& gradient_histogram,
+      std::vector<FeatureSplitCandidate>* split_candidates) const {
+    LOG(FATAL) << "Feature column " << slot_id_
+               << " does not support gradient histograms.";
+  }
+
   // Accessors.
   int32 class_id() const { return class_id_; }
   int32 slot_id() const { return slot_id_; }
@@ -0,0 +1,88 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/feature-column-histograms.h"
+
+#include <utility>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace stochastic {
+
+void AggregateGradientHistograms(
+    const std::vector<const FeatureColumnHandler*>& handlers,
+    const std::vector<int32>& example_partition_ids,
+    const Tensor& example_first_order_gradients,
+    const Tensor& example_second_order_gradients, int32 num_partitions,
+    const std::vector<DerivedPartition>& derived_partitions,
+    const std::vector<std::unique_ptr<GradientHistogram>>* parent_histograms,
+    thread::ThreadPool* thread_pool,
+    std::vector<std::unique_ptr<GradientHistogram>>* histograms) {
+  QCHECK(derived_partitions.empty() || parent_histograms != nullptr)
+      << "Derived partitions need parent histograms.";
+  QCHECK(parent_histograms == nullptr ||
+         parent_histograms->size() == handlers.size())
+      << "Expected one parent histogram per handler.";
+
+  // Skip the examples of the derived partitions.
+  std::vector<int32> partition_ids = example_partition_ids;
+  if (!derived_partitions.empty()) {
+    std::vector<bool> is_derived(num_partitions, false);
+    for (const DerivedPartition& derived : derived_partitions) {
+      QCHECK(derived.partition_id >= 0 && derived.partition_id < num_partitions)
+          << "Invalid derived partition " << derived.partition_id;
+      is_derived[derived.partition_id] = true;
+    }
+    for (int32& partition_id : partition_ids) {
+      if (partition_id >= 0 && partition_id < num_partitions &&
+          is_derived[partition_id]) {
+        partition_id = -1;
+      }
+    }
+  }
+
+  histograms->clear();
+  histograms->resize(handlers.size());
+  auto do_work = [&](int64 start, int64 end) {
+    for (int64 handler_idx = start; handler_idx < end; ++handler_idx) {
+      const FeatureColumnHandler* handler = handlers[handler_idx];
+      const int32 num_buckets = handler->num_histogram_buckets();
+      QCHECK_GT(num_buckets, 0) << "Handler " << handler_idx
+                                << " does not support histograms.";
+      std::unique_ptr<GradientHistogram> histogram(new GradientHistogram(
+          num_partitions, num_buckets, example_first_order_gradients,
+          example_second_order_gradients));
+      handler->AggregateGradientHistogram(
+          partition_ids, example_first_order_gradients,
+          example_second_order_gradients, histogram.get());
+      for (const DerivedPartition& derived : derived_partitions) {
+        histogram->SetToDifference(*(*parent_histograms)[handler_idx],
+                                   derived.parent_id, derived.sibling_id,
+                                   derived.partition_id);
+      }
+      (*histograms)[handler_idx] = std::move(histogram);
+    }
+  };
+  utils::ParallelFor(handlers.size(), thread_pool->NumThreads(), thread_pool,
+                     do_work);
+}
+
+}  // namespace stochastic
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
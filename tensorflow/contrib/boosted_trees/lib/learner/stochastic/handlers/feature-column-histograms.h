@@ -0,0 +1,64 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_HANDLERS_FEATURE_COLUMN_HISTOGRAMS_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_HANDLERS_FEATURE_COLUMN_HISTOGRAMS_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/feature-column-handler.h"
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/stats/gradient-histogram.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace stochastic {
+
+// A partition whose histograms are derived from those of its parent and its
+// sibling instead of being accumulated from its examples.
+struct DerivedPartition {
+  int32 partition_id;
+  int32 sibling_id;
+  // The partition id of the parent in the parent histograms.
+  int32 parent_id;
+};
+
+// Accumulates the gradient histograms of each of "handlers", with one
+// histogram per handler, over the partitions [0, num_partitions).
+// The handlers are processed in parallel on "thread_pool", so that each
+// histogram is only ever written by one thread. The histograms of each of
+// "derived_partitions" are set to the difference between the histograms of
+// its parent in "parent_histograms" and of its sibling, and the examples of
+// derived partitions are not accumulated. The parent histograms must have
+// been accumulated from the same examples, and may only be null when there
+// are no derived partitions.
+void AggregateGradientHistograms(
+    const std::vector<const FeatureColumnHandler*>& handlers,
+    const std::vector<int32>& example_partition_ids,
+    const Tensor& example_first_order_gradients,
+    const Tensor& example_second_order_gradients, int32 num_partitions,
+    const std::vector<DerivedPartition>& derived_partitions,
+    const std::vector<std::unique_ptr<GradientHistogram>>* parent_histograms,
+    thread::ThreadPool* thread_pool,
+    std::vector<std::unique_ptr<GradientHistogram>>* histograms);
+
+}  // namespace stochastic
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_HANDLERS_FEATURE_COLUMN_HISTOGRAMS_H_
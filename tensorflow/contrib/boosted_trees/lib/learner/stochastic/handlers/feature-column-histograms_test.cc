@@ -0,0 +1,127 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/feature-column-histograms.h"
+
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/dense-quantized-feature-column-handler.h"
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/handlers/sparse-quantized-feature-column-handler.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace stochastic {
+namespace {
+
+const auto kClassId = 1;
+const auto kBatchSize = 4;
+
+class FeatureColumnHistogramsTest : public ::testing::Test {
+ protected:
+  // The data looks like the following:
+  // Example |  Gradients    | Dense Quantile | Sparse Quantile |
+  // i0      |  (0.2, 0.12)  | 1              | 1               |
+  // i1      |  (-0.5, 0.07) | 1              | N/A             |
+  // i2      |  (1.2, 0.2)   | 0              | 0               |
+  // i3      |  (4.0, 0.13)  | 1              | 1               |
+  FeatureColumnHistogramsTest()
+      : example_first_order_gradients_(
+            test::AsTensor<float>({0.2f, -0.5f, 1.2f, 4.0f}, {4})),
+        example_second_order_gradients_(
+            test::AsTensor<float>({0.12f, 0.07f, 0.2f, 0.13f}, {4})),
+        quantiles_(test::AsTensor<float>({0.3f, 0.52f}, {2})),
+        dense_quantized_values_(test::AsTensor<int32>({1, 1, 0, 1}, {4})),
+        sparse_indices_(test::AsTensor<int64>({0, 0, 2, 0, 3, 0}, {3, 2})),
+        sparse_quantized_values_(test::AsTensor<int32>({1, 0, 1}, {3})),
+        dense_handler_(kClassId, 0, kBatchSize, 0, quantiles_.vec<float>(),
+                       dense_quantized_values_.vec<int32>()),
+        sparse_handler_(kClassId, 1, kBatchSize, 0, quantiles_.vec<float>(),
+                        sparse_indices_.matrix<int64>(),
+                        sparse_quantized_values_.vec<int32>()),
+        thread_pool_(Env::Default(), "histograms", 2) {}
+
+  const Tensor example_first_order_gradients_;
+  const Tensor example_second_order_gradients_;
+  const Tensor quantiles_;
+  const Tensor dense_quantized_values_;
+  const Tensor sparse_indices_;
+  const Tensor sparse_quantized_values_;
+  DenseQuantizedFeatureColumnHandler dense_handler_;
+  SparseQuantizedFeatureColumnHandler sparse_handler_;
+  thread::ThreadPool thread_pool_;
+};
+
+TEST_F(FeatureColumnHistogramsTest, Aggregate) {
+  std::vector<std::unique_ptr<GradientHistogram>> histograms;
+  AggregateGradientHistograms({&dense_handler_, &sparse_handler_},
+                              {0, 0, 0, 1}, example_first_order_gradients_,
+                              example_second_order_gradients_, 2, {}, nullptr,
+                              &thread_pool_, &histograms);
+  ASSERT_EQ(2, histograms.size());
+  const GradientHistogram& dense = *histograms[0];
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(1.2f, 0.2f), dense.GetStats(0, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(-0.3f, 0.19f), dense.GetStats(0, 1));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f), dense.GetStats(1, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(4.0f, 0.13f), dense.GetStats(1, 1));
+  const GradientHistogram& sparse = *histograms[1];
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(1.2f, 0.2f), sparse.GetStats(0, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.2f, 0.12f), sparse.GetStats(0, 1));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f), sparse.GetStats(1, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(4.0f, 0.13f), sparse.GetStats(1, 1));
+}
+
+TEST_F(FeatureColumnHistogramsTest, DerivePartitionFromParent) {
+  // All examples start in one partition, which is then split into partition
+  // 0 with examples i0 and i2 and partition 1 with examples i1 and i3.
+  const std::vector<const FeatureColumnHandler*> handlers = {&dense_handler_,
+                                                             &sparse_handler_};
+  std::vector<std::unique_ptr<GradientHistogram>> parent_histograms;
+  AggregateGradientHistograms(handlers, {0, 0, 0, 0},
+                              example_first_order_gradients_,
+                              example_second_order_gradients_, 1, {}, nullptr,
+                              &thread_pool_, &parent_histograms);
+
+  // Partition 1 is derived from its parent and partition 0.
+  const std::vector<int32> example_partitions = {0, 1, 0, 1};
+  std::vector<std::unique_ptr<GradientHistogram>> histograms;
+  AggregateGradientHistograms(
+      handlers, example_partitions, example_first_order_gradients_,
+      example_second_order_gradients_, 2, {{1, 0, 0}}, &parent_histograms,
+      &thread_pool_, &histograms);
+  std::vector<std::unique_ptr<GradientHistogram>> expected_histograms;
+  AggregateGradientHistograms(handlers, example_partitions,
+                              example_first_order_gradients_,
+                              example_second_order_gradients_, 2, {}, nullptr,
+                              &thread_pool_, &expected_histograms);
+  ASSERT_EQ(2, histograms.size());
+  for (int handler_idx = 0; handler_idx < 2; ++handler_idx) {
+    for (int32 partition_id = 0; partition_id < 2; ++partition_id) {
+      for (int32 bucket_id = 0; bucket_id < 2; ++bucket_id) {
+        EXPECT_GRADIENT_STATS_EQ(
+            expected_histograms[handler_idx]->GetStats(partition_id,
+                                                       bucket_id),
+            histograms[handler_idx]->GetStats(partition_id, bucket_id));
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace stochastic
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
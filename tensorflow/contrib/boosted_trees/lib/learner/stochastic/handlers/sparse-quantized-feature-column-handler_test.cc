@@ -155,6 +155,57 @@ TEST_F(SparseQuantizedFeatureColumnHandlerTest,
             tree_node2.node_case());
 }
 
+TEST_F(SparseQuantizedFeatureColumnHandlerTest, AggregateGradientHistogram) {
+  EXPECT_EQ(2, handler_->num_histogram_buckets());
+  GradientHistogram histogram(2, handler_->num_histogram_buckets(),
+                              example_first_order_gradients_,
+                              example_second_order_gradients_);
+  handler_->AggregateGradientHistogram(
+      example_partitions_, example_first_order_gradients_,
+      example_second_order_gradients_, &histogram);
+
+  // The buckets hold the same stats as the accumulator.
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(1.2f, 0.2f), histogram.GetStats(0, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.2f, 0.12f),
+                           histogram.GetStats(0, 1));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f), histogram.GetStats(1, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(4.0f, 0.13f),
+                           histogram.GetStats(1, 1));
+}
+
+TEST_F(SparseQuantizedFeatureColumnHandlerTest,
+       GenerateFeatureSplitCandidatesFromHistogram) {
+  FeatureStatsAccumulator accumulator(1);
+  handler_->AggregateGradientStats(
+      example_partitions_, example_first_order_gradients_,
+      example_second_order_gradients_, &accumulator);
+  GradientHistogram histogram(2, handler_->num_histogram_buckets(),
+                              example_first_order_gradients_,
+                              example_second_order_gradients_);
+  handler_->AggregateGradientHistogram(
+      example_partitions_, example_first_order_gradients_,
+      example_second_order_gradients_, &histogram);
+
+  // The histogram gives the same candidates as the accumulator.
+  const std::vector<int32> roots = {0, 1};
+  const std::vector<NodeStats>& root_stats = {
+      NodeStats(learner_config_, GradientStats(0.9f, 0.39f)),
+      NodeStats(learner_config_, GradientStats(4.0f, 0.13f))};
+  std::vector<FeatureSplitCandidate> expected_candidates;
+  handler_->GenerateFeatureSplitCandidates(learner_config_, roots, root_stats,
+                                           accumulator, &expected_candidates);
+  std::vector<FeatureSplitCandidate> split_candidates;
+  handler_->GenerateFeatureSplitCandidatesFromHistogram(
+      learner_config_, roots, root_stats, histogram, &split_candidates);
+  ASSERT_EQ(expected_candidates.size(), split_candidates.size());
+  for (size_t i = 0; i < split_candidates.size(); ++i) {
+    EXPECT_SPLIT_STATS_EQ(expected_candidates[i].split_stats,
+                          split_candidates[i].split_stats);
+    EXPECT_EQ(expected_candidates[i].tree_node.DebugString(),
+              split_candidates[i].tree_node.DebugString());
+  }
+}
+
 }  // namespace
 }  // namespace stochastic
 }  // namespace learner
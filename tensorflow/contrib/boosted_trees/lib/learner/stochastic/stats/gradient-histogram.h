@@ -0,0 +1,149 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_STATS_GRADIENT_HISTOGRAM_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_STATS_GRADIENT_HISTOGRAM_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/stats/gradient-stats.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace stochastic {
+
+// Dense histograms of the gradient stats of one quantized feature column,
+// with one bucket per (partition, quantile bucket) pair. The gradients and
+// hessians of all buckets are stored in one contiguous array, so adding the
+// stats of an example is a few float additions instead of a hash map update.
+// This class is thread compatible.
+class GradientHistogram {
+ public:
+  // Creates zeroed histograms with "num_buckets" buckets for the partitions
+  // [0, num_partitions), for the examples of the given gradient tensors.
+  GradientHistogram(int32 num_partitions, int32 num_buckets,
+                    const Tensor& example_first_order_gradients,
+                    const Tensor& example_second_order_gradients)
+      : num_partitions_(num_partitions),
+        num_buckets_(num_buckets),
+        gradient_shape_(example_first_order_gradients.shape()),
+        hessian_shape_(example_second_order_gradients.shape()) {
+    // The stats of a bucket have the shape of the stats of one example.
+    gradient_shape_.set_dim(0, 1);
+    hessian_shape_.set_dim(0, 1);
+    num_gradient_elements_ = gradient_shape_.num_elements();
+    num_hessian_elements_ = hessian_shape_.num_elements();
+    values_.resize(static_cast<int64>(num_partitions_) * num_buckets_ *
+                       (num_gradient_elements_ + num_hessian_elements_),
+                   0.0f);
+  }
+
+  GradientHistogram(const GradientHistogram& other) = delete;
+  GradientHistogram& operator=(const GradientHistogram& other) = delete;
+
+  int32 num_partitions() const { return num_partitions_; }
+  int32 num_buckets() const { return num_buckets_; }
+
+  // Adds the stats of example "example_idx" of the gradient tensors that the
+  // histograms were created for to the specified bucket.
+  void AddExample(int32 partition_id, int32 bucket_id,
+                  const Tensor& example_first_order_gradients,
+                  const Tensor& example_second_order_gradients,
+                  int64 example_idx) {
+    float* stats = mutable_bucket(partition_id, bucket_id);
+    const float* gradients =
+        example_first_order_gradients.flat<float>().data() +
+        example_idx * num_gradient_elements_;
+    for (int64 i = 0; i < num_gradient_elements_; ++i) {
+      stats[i] += gradients[i];
+    }
+    stats += num_gradient_elements_;
+    const float* hessians =
+        example_second_order_gradients.flat<float>().data() +
+        example_idx * num_hessian_elements_;
+    for (int64 i = 0; i < num_hessian_elements_; ++i) {
+      stats[i] += hessians[i];
+    }
+  }
+
+  // Retrieves the stats of the specified bucket.
+  GradientStats GetStats(int32 partition_id, int32 bucket_id) const {
+    const float* stats = bucket(partition_id, bucket_id);
+    Tensor gradients(DT_FLOAT, gradient_shape_);
+    std::copy(stats, stats + num_gradient_elements_,
+              gradients.flat<float>().data());
+    stats += num_gradient_elements_;
+    Tensor hessians(DT_FLOAT, hessian_shape_);
+    std::copy(stats, stats + num_hessian_elements_,
+              hessians.flat<float>().data());
+    return GradientStats(gradients, hessians);
+  }
+
+  // Sets the histogram of partition "sibling_id" to the histogram of
+  // partition "parent_id" in "parent" minus that of partition "child_id",
+  // when the examples of the parent partition were split between the child
+  // and its sibling. This saves accumulating the examples of the sibling, but
+  // is only exact if "parent" was accumulated from the same examples.
+  void SetToDifference(const GradientHistogram& parent, int32 parent_id,
+                       int32 child_id, int32 sibling_id) {
+    CHECK_EQ(num_buckets_, parent.num_buckets_);
+    CHECK(gradient_shape_ == parent.gradient_shape_);
+    CHECK(hessian_shape_ == parent.hessian_shape_);
+    const int64 partition_size =
+        num_buckets_ * (num_gradient_elements_ + num_hessian_elements_);
+    if (partition_size == 0) {
+      return;
+    }
+    const float* parent_stats = parent.bucket(parent_id, 0);
+    const float* child_stats = bucket(child_id, 0);
+    float* sibling_stats = mutable_bucket(sibling_id, 0);
+    for (int64 i = 0; i < partition_size; ++i) {
+      sibling_stats[i] = parent_stats[i] - child_stats[i];
+    }
+  }
+
+ private:
+  const float* bucket(int32 partition_id, int32 bucket_id) const {
+    DCHECK(partition_id >= 0 && partition_id < num_partitions_);
+    DCHECK(bucket_id >= 0 && bucket_id < num_buckets_);
+    return &values_[(static_cast<int64>(partition_id) * num_buckets_ +
+                     bucket_id) *
+                    (num_gradient_elements_ + num_hessian_elements_)];
+  }
+
+  float* mutable_bucket(int32 partition_id, int32 bucket_id) {
+    return const_cast<float*>(bucket(partition_id, bucket_id));
+  }
+
+  const int32 num_partitions_;
+  const int32 num_buckets_;
+  TensorShape gradient_shape_;
+  TensorShape hessian_shape_;
+  int64 num_gradient_elements_;
+  int64 num_hessian_elements_;
+
+  // The gradients followed by the hessians of each bucket, by partition.
+  std::vector<float> values_;
+};
+
+}  // namespace stochastic
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_STOCHASTIC_STATS_GRADIENT_HISTOGRAM_H_
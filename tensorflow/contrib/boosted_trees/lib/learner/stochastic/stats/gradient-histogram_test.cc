@@ -0,0 +1,95 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/stochastic/stats/gradient-histogram.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace stochastic {
+namespace {
+
+TEST(GradientHistogramTest, Empty) {
+  const Tensor gradients = test::AsTensor<float>({0.2f, -0.5f}, {2});
+  const Tensor hessians = test::AsTensor<float>({0.12f, 0.07f}, {2});
+  GradientHistogram histogram(2, 3, gradients, hessians);
+  EXPECT_EQ(2, histogram.num_partitions());
+  EXPECT_EQ(3, histogram.num_buckets());
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f),
+                           histogram.GetStats(1, 2));
+}
+
+TEST(GradientHistogramTest, AddExample) {
+  const Tensor gradients = test::AsTensor<float>({0.2f, -0.5f, 1.2f}, {3});
+  const Tensor hessians = test::AsTensor<float>({0.12f, 0.07f, 0.2f}, {3});
+  GradientHistogram histogram(2, 2, gradients, hessians);
+  histogram.AddExample(0, 1, gradients, hessians, 0);
+  histogram.AddExample(0, 1, gradients, hessians, 1);
+  histogram.AddExample(1, 0, gradients, hessians, 2);
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f),
+                           histogram.GetStats(0, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(-0.3f, 0.19f),
+                           histogram.GetStats(0, 1));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(1.2f, 0.2f),
+                           histogram.GetStats(1, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f),
+                           histogram.GetStats(1, 1));
+}
+
+TEST(GradientHistogramTest, AddExampleMulticlass) {
+  // Two examples with two-class gradients and full hessians.
+  const Tensor gradients =
+      test::AsTensor<float>({0.1f, 0.2f, 0.3f, 0.4f}, {2, 2});
+  const Tensor hessians = test::AsTensor<float>(
+      {1.0f, 0.0f, 0.0f, 2.0f, 3.0f, 0.5f, 0.5f, 4.0f}, {2, 2, 2});
+  GradientHistogram histogram(1, 1, gradients, hessians);
+  histogram.AddExample(0, 0, gradients, hessians, 0);
+  histogram.AddExample(0, 0, gradients, hessians, 1);
+  const GradientStats expected(
+      test::AsTensor<float>({0.4f, 0.6f}, {1, 2}),
+      test::AsTensor<float>({4.0f, 0.5f, 0.5f, 6.0f}, {1, 2, 2}));
+  EXPECT_GRADIENT_STATS_EQ(expected, histogram.GetStats(0, 0));
+}
+
+TEST(GradientHistogramTest, SetToDifference) {
+  // Examples 0 and 1 were in parent partition 1, and were then split into
+  // partition 0 and partition 1.
+  const Tensor gradients = test::AsTensor<float>({0.2f, -0.5f, 1.2f}, {3});
+  const Tensor hessians = test::AsTensor<float>({0.12f, 0.07f, 0.2f}, {3});
+  GradientHistogram parent(2, 2, gradients, hessians);
+  parent.AddExample(1, 0, gradients, hessians, 0);
+  parent.AddExample(1, 1, gradients, hessians, 1);
+  parent.AddExample(0, 1, gradients, hessians, 2);
+
+  GradientHistogram histogram(2, 2, gradients, hessians);
+  histogram.AddExample(0, 1, gradients, hessians, 1);
+  histogram.SetToDifference(parent, 1, 0, 1);
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f),
+                           histogram.GetStats(0, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(-0.5f, 0.07f),
+                           histogram.GetStats(0, 1));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.2f, 0.12f),
+                           histogram.GetStats(1, 0));
+  EXPECT_GRADIENT_STATS_EQ(GradientStats(0.0f, 0.0f),
+                           histogram.GetStats(1, 1));
+}
+
+}  // namespace
+}  // namespace stochastic
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
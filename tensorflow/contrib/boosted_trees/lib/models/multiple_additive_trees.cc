@@ -22,6 +22,10 @@ namespace boosted_trees {
 namespace models {
 
 namespace {
+
+// The number of examples that traverse a compiled tree together.
+constexpr int32 kExampleBlockSize = 16;
+
 void CalculateTreesToKeep(
     const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
     const std::vector<int32>& trees_to_drop, const int32 num_trees,
@@ -85,6 +89,25 @@ void UpdatePredictionsBasedOnTree(
   }
 }
 
+void UpdatePredictionsBasedOnCompiledTree(
+    const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+    const boosted_trees::trees::CompiledTreeEnsemble& compiled_trees,
+    const int32 tree_idx, const boosted_trees::utils::Example* examples,
+    const int32 num_examples, int32* leaf_ids,
+    tensorflow::TTypes<float>::Matrix* output_predictions,
+    tensorflow::TTypes<float>::Matrix* additional_output_predictions) {
+  const float tree_weight = config.tree_weights(tree_idx);
+  compiled_trees.Traverse(tree_idx, examples, num_examples, leaf_ids);
+  for (int32 i = 0; i < num_examples; ++i) {
+    const int32 leaf_end = compiled_trees.leaf_end(leaf_ids[i]);
+    for (int32 j = compiled_trees.leaf_begin(leaf_ids[i]); j < leaf_end; ++j) {
+      UpdatePredictions(examples[i].example_idx, compiled_trees.leaf_class(j),
+                        tree_weight * compiled_trees.leaf_value(j),
+                        output_predictions, additional_output_predictions);
+    }
+  }
+}
+
 }  // namespace
 
 void MultipleAdditiveTrees::Predict(
@@ -135,6 +158,71 @@ void MultipleAdditiveTrees::Predict(
                                     worker_threads, update_predictions);
 }
 
+void MultipleAdditiveTrees::Predict(
+    const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+    const boosted_trees::trees::CompiledTreeEnsemble& compiled_trees,
+    const bool only_finalized_trees, const std::vector<int32>& trees_to_drop,
+    const boosted_trees::utils::BatchFeatures& features,
+    tensorflow::thread::ThreadPool* worker_threads,
+    tensorflow::TTypes<float>::Matrix output_predictions,
+    tensorflow::TTypes<float>::Matrix no_dropout_predictions) {
+  QCHECK_EQ(config.trees_size(), compiled_trees.num_trees());
+
+  // Zero out predictions as the model is additive.
+  output_predictions.setZero();
+  no_dropout_predictions.setZero();
+
+  // Get batch size.
+  const int64 batch_size = features.batch_size();
+  if (batch_size <= 0) {
+    return;
+  }
+
+  // Prepare the list of trees to keep.
+  std::vector<int32> trees_to_keep;
+  CalculateTreesToKeep(config, trees_to_drop, config.trees_size(),
+                       only_finalized_trees, &trees_to_keep);
+
+  // Lambda for doing a block of work. The examples are copied into blocks,
+  // and each block traverses all trees before the next one is read.
+  auto update_predictions = [&config, &compiled_trees, &features,
+                             &trees_to_keep, &trees_to_drop,
+                             &output_predictions,
+                             &no_dropout_predictions](int64 start, int64 end) {
+    std::vector<boosted_trees::utils::Example> block(kExampleBlockSize);
+    int32 leaf_ids[kExampleBlockSize];
+    int32 block_size = 0;
+    auto predict_block = [&]() {
+      for (const int32 tree_idx : trees_to_keep) {
+        UpdatePredictionsBasedOnCompiledTree(
+            config, compiled_trees, tree_idx, block.data(), block_size,
+            leaf_ids, &output_predictions, &no_dropout_predictions);
+      }
+
+      // Now do predictions for dropped trees
+      for (const int32 tree_idx : trees_to_drop) {
+        UpdatePredictionsBasedOnCompiledTree(
+            config, compiled_trees, tree_idx, block.data(), block_size,
+            leaf_ids, &no_dropout_predictions, nullptr);
+      }
+      block_size = 0;
+    };
+    auto examples_iterable = features.examples_iterable(start, end);
+    for (const auto& example : examples_iterable) {
+      block[block_size++] = example;
+      if (block_size == kExampleBlockSize) {
+        predict_block();
+      }
+    }
+    if (block_size > 0) {
+      predict_block();
+    }
+  };
+
+  boosted_trees::utils::ParallelFor(batch_size, worker_threads->NumThreads(),
+                                    worker_threads, update_predictions);
+}
+
 }  // namespace models
 }  // namespace boosted_trees
 }  // namespace tensorflow
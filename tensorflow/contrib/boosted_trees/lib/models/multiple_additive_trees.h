@@ -17,6 +17,7 @@
 
 #include <vector>
 
+#include "tensorflow/contrib/boosted_trees/lib/trees/compiled_tree_ensemble.h"
 #include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
 #include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_types.h"
@@ -41,6 +42,19 @@ class MultipleAdditiveTrees {
       thread::ThreadPool* const thread_pool,
       TTypes<float>::Matrix output_predictions,
       TTypes<float>::Matrix no_dropout_predictions);
+
+  // Same as above, but traverses the trees compiled from "config" in
+  // "compiled_trees", a block of examples at a time. The tree weights and
+  // metadata are still read from "config", so they can be adjusted without
+  // recompiling the trees.
+  static void Predict(
+      const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+      const boosted_trees::trees::CompiledTreeEnsemble& compiled_trees,
+      const bool only_finalized_trees, const std::vector<int32>& trees_to_drop,
+      const boosted_trees::utils::BatchFeatures& features,
+      thread::ThreadPool* const thread_pool,
+      TTypes<float>::Matrix output_predictions,
+      TTypes<float>::Matrix no_dropout_predictions);
 };
 
 }  // namespace models
@@ -375,6 +375,108 @@ TEST_F(MultipleAdditiveTreesTest, DenseLeaves) {
   }
 }
 
+TEST_F(MultipleAdditiveTreesTest, CompiledTrees) {
+  // Compare the predictions of the compiled trees with those of the protos
+  // for a random ensemble, on a batch that spans several example blocks.
+  const int32 kBatchSize = 37;
+  random::PhiloxRandom philox(1, 1);
+  random::SimplePhilox rng(&philox);
+  testutil::RandomTreeGen tree_gen(&rng, 5, 5);
+  const DecisionTreeEnsembleConfig tree_ensemble_config =
+      tree_gen.GenerateEnsemble(4, 20);
+  const trees::CompiledTreeEnsemble compiled_trees(tree_ensemble_config);
+  boosted_trees::utils::BatchFeatures batch_features(kBatchSize);
+  testutil::RandomlyInitializeBatchFeatures(&rng, 5, 5, 0.2, 0.8,
+                                            &batch_features);
+
+  Tensor output_tensor(DT_FLOAT, {kBatchSize, 1});
+  Tensor no_dropout_output_tensor(DT_FLOAT, {kBatchSize, 1});
+  Tensor compiled_output_tensor(DT_FLOAT, {kBatchSize, 1});
+  Tensor compiled_no_dropout_output_tensor(DT_FLOAT, {kBatchSize, 1});
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsMultiThreaded);
+  MultipleAdditiveTrees::Predict(tree_ensemble_config,
+                                 false,  // include non-finalized trees
+                                 {3, 7}, batch_features, &threads,
+                                 output_tensor.matrix<float>(),
+                                 no_dropout_output_tensor.matrix<float>());
+  MultipleAdditiveTrees::Predict(
+      tree_ensemble_config, compiled_trees,
+      false,  // include non-finalized trees
+      {3, 7}, batch_features, &threads, compiled_output_tensor.matrix<float>(),
+      compiled_no_dropout_output_tensor.matrix<float>());
+  test::ExpectTensorNear<float>(output_tensor, compiled_output_tensor, 1e-6);
+  test::ExpectTensorNear<float>(no_dropout_output_tensor,
+                                compiled_no_dropout_output_tensor, 1e-6);
+}
+
+TEST_F(MultipleAdditiveTreesTest, ResourceRecompilesTreesAfterMutation) {
+  DecisionTreeEnsembleResource resource;
+  auto* bias_leaf = resource.mutable_decision_tree_ensemble()
+                        ->add_trees()
+                        ->add_nodes()
+                        ->mutable_leaf()
+                        ->mutable_sparse_vector();
+  bias_leaf->add_index(0);
+  bias_leaf->add_value(-0.4f);
+  resource.mutable_decision_tree_ensemble()->add_tree_weights(1.0);
+
+  // The compiled trees are shared until the ensemble is mutated.
+  auto compiled_trees = resource.compiled_trees();
+  EXPECT_EQ(1, compiled_trees->num_trees());
+  EXPECT_EQ(compiled_trees, resource.compiled_trees());
+  *resource.mutable_decision_tree_ensemble()->add_trees() =
+      resource.decision_tree_ensemble().trees(0);
+  resource.mutable_decision_tree_ensemble()->add_tree_weights(1.0);
+  EXPECT_EQ(2, resource.compiled_trees()->num_trees());
+  resource.Reset();
+  EXPECT_EQ(0, resource.compiled_trees()->num_trees());
+}
+
+// Benchmarks the prediction of a batch of examples by 1000 trees of depth 6,
+// traversing either the tree protos or the compiled trees. The trees split
+// either only on dense features or mostly on sparse ones.
+static void BM_Predict(int iters, int dense_only, int use_compiled_trees) {
+  testing::StopTiming();
+  const int32 kBatchSize = 128;
+  const int32 kNumDenseFeatures = 20;
+  const int32 kNumSparseFeatures = dense_only ? 0 : 20;
+  random::PhiloxRandom philox(1, 1);
+  random::SimplePhilox rng(&philox);
+  testutil::RandomTreeGen tree_gen(&rng, kNumDenseFeatures,
+                                   kNumSparseFeatures);
+  const DecisionTreeEnsembleConfig tree_ensemble_config =
+      tree_gen.GenerateEnsemble(6, 1000);
+  const trees::CompiledTreeEnsemble compiled_trees(tree_ensemble_config);
+  boosted_trees::utils::BatchFeatures batch_features(kBatchSize);
+  testutil::RandomlyInitializeBatchFeatures(
+      &rng, kNumDenseFeatures, kNumSparseFeatures, 0.2, 0.8, &batch_features);
+  Tensor output_tensor(DT_FLOAT, {kBatchSize, 1});
+  Tensor no_dropout_output_tensor(DT_FLOAT, {kBatchSize, 1});
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsSingleThreaded);
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (use_compiled_trees) {
+      MultipleAdditiveTrees::Predict(
+          tree_ensemble_config, compiled_trees, false, {}, batch_features,
+          &threads, output_tensor.matrix<float>(),
+          no_dropout_output_tensor.matrix<float>());
+    } else {
+      MultipleAdditiveTrees::Predict(tree_ensemble_config, false, {},
+                                     batch_features, &threads,
+                                     output_tensor.matrix<float>(),
+                                     no_dropout_output_tensor.matrix<float>());
+    }
+  }
+}
+BENCHMARK(BM_Predict)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(0, 0)
+    ->ArgPair(0, 1);
+
 }  // namespace
 }  // namespace models
 }  // namespace boosted_trees
@@ -0,0 +1,246 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/trees/compiled_tree_ensemble.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+CompiledTreeEnsemble::CompiledTreeEnsemble(
+    const DecisionTreeEnsembleConfig& config) {
+  for (const DecisionTreeConfig& tree : config.trees()) {
+    AddTree(tree);
+  }
+  leaf_offsets_.push_back(leaf_values_.size());
+}
+
+void CompiledTreeEnsemble::AddTree(const DecisionTreeConfig& tree) {
+  if (tree.nodes_size() == 0) {
+    tree_roots_.push_back(-1);
+    tree_depths_.push_back(0);
+    tree_dense_only_.push_back(true);
+    return;
+  }
+  const int32 root = node_types_.size();
+  int32 depth = 0;
+  bool dense_only = true;
+  // The proto ids and depths of the nodes in breadth-first order; the
+  // compiled id of a node is its position plus the id of the root.
+  std::vector<int32> order = {0};
+  std::vector<int32> depths = {0};
+  std::vector<bool> visited(tree.nodes_size(), false);
+  visited[0] = true;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const TreeNode& node = tree.nodes(order[i]);
+    const int32 node_id = root + i;
+    leaf_offsets_.push_back(leaf_values_.size());
+    NodeType type = kLeaf;
+    int32 feature_column = 0;
+    float threshold = std::numeric_limits<float>::quiet_NaN();
+    int32 left_id = -1;
+    int32 right_id = -1;
+    switch (node.node_case()) {
+      case TreeNode::kLeaf: {
+        const Leaf& leaf = node.leaf();
+        if (leaf.has_sparse_vector()) {
+          const auto& sparse = leaf.sparse_vector();
+          QCHECK_EQ(sparse.index_size(), sparse.value_size());
+          leaf_classes_.insert(leaf_classes_.end(), sparse.index().begin(),
+                               sparse.index().end());
+          leaf_values_.insert(leaf_values_.end(), sparse.value().begin(),
+                              sparse.value().end());
+        } else {
+          QCHECK(leaf.has_vector()) << "Unknown leaf type";
+          for (int32 j = 0; j < leaf.vector().value_size(); ++j) {
+            leaf_classes_.push_back(j);
+            leaf_values_.push_back(leaf.vector().value(j));
+          }
+        }
+        depth = std::max(depth, depths[i]);
+        break;
+      }
+      case TreeNode::kDenseFloatBinarySplit: {
+        const auto& split = node.dense_float_binary_split();
+        type = kDenseFloatSplit;
+        feature_column = split.feature_column();
+        threshold = split.threshold();
+        left_id = split.left_id();
+        right_id = split.right_id();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultLeft: {
+        const auto& split =
+            node.sparse_float_binary_split_default_left().split();
+        type = kSparseFloatSplitDefaultLeft;
+        feature_column = split.feature_column();
+        threshold = split.threshold();
+        left_id = split.left_id();
+        right_id = split.right_id();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultRight: {
+        const auto& split =
+            node.sparse_float_binary_split_default_right().split();
+        type = kSparseFloatSplitDefaultRight;
+        feature_column = split.feature_column();
+        threshold = split.threshold();
+        left_id = split.left_id();
+        right_id = split.right_id();
+        break;
+      }
+      case TreeNode::kCategoricalIdBinarySplit: {
+        const auto& split = node.categorical_id_binary_split();
+        type = kCategoricalIdSplit;
+        feature_column = categorical_splits_.size();
+        const int32 begin = categorical_feature_ids_.size();
+        categorical_feature_ids_.push_back(split.feature_id());
+        categorical_splits_.push_back(
+            {split.feature_column(), begin, begin + 1});
+        left_id = split.left_id();
+        right_id = split.right_id();
+        break;
+      }
+      case TreeNode::kCategoricalIdSetMembershipBinarySplit: {
+        const auto& split = node.categorical_id_set_membership_binary_split();
+        type = kCategoricalIdSetMembershipSplit;
+        feature_column = categorical_splits_.size();
+        const int32 begin = categorical_feature_ids_.size();
+        categorical_feature_ids_.insert(categorical_feature_ids_.end(),
+                                        split.feature_ids().begin(),
+                                        split.feature_ids().end());
+        categorical_splits_.push_back(
+            {split.feature_column(), begin,
+             static_cast<int32>(categorical_feature_ids_.size())});
+        left_id = split.left_id();
+        right_id = split.right_id();
+        break;
+      }
+      case TreeNode::NODE_NOT_SET: {
+        QCHECK(false) << "Invalid node in tree: " << node.DebugString();
+        break;
+      }
+    }
+    node_types_.push_back(type);
+    feature_columns_.push_back(feature_column);
+    thresholds_.push_back(threshold);
+    if (type == kLeaf) {
+      left_ids_.push_back(node_id - 1);
+      continue;
+    }
+    dense_only = dense_only && type == kDenseFloatSplit;
+    for (const int32 child_id : {left_id, right_id}) {
+      QCHECK(child_id >= 0 && child_id < tree.nodes_size() &&
+             !visited[child_id])
+          << "Malformed tree, invalid child " << child_id << " of node "
+          << node.DebugString();
+      visited[child_id] = true;
+      order.push_back(child_id);
+      depths.push_back(depths[i] + 1);
+    }
+    left_ids_.push_back(root + order.size() - 2);
+  }
+  tree_roots_.push_back(root);
+  tree_depths_.push_back(depth);
+  tree_dense_only_.push_back(dense_only);
+}
+
+bool CompiledTreeEnsemble::GoesLeft(int32 node_id,
+                                    const utils::Example& example) const {
+  const CategoricalSplit& split =
+      categorical_splits_[feature_columns_[node_id]];
+  const auto& values = example.sparse_int_features[split.feature_column];
+  if (node_types_[node_id] == kCategoricalIdSplit) {
+    return values.count(categorical_feature_ids_[split.feature_ids_begin]) > 0;
+  }
+  const auto begin = categorical_feature_ids_.begin() + split.feature_ids_begin;
+  const auto end = categorical_feature_ids_.begin() + split.feature_ids_end;
+  for (const int64 feature_id : values) {
+    if (std::binary_search(begin, end, feature_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CompiledTreeEnsemble::Traverse(int32 tree_idx,
+                                    const utils::Example* examples,
+                                    int32 num_examples,
+                                    int32* leaf_ids) const {
+  const int32 root = tree_roots_[tree_idx];
+  QCHECK_GE(root, 0) << "Invalid tree: tree " << tree_idx << " is empty";
+  std::fill(leaf_ids, leaf_ids + num_examples, root);
+  const int32 depth = tree_depths_[tree_idx];
+  if (tree_dense_only_[tree_idx]) {
+    // Every step is a branch-free comparison, and leaves step onto
+    // themselves. Comparing with <= sends NaN values right, like
+    // DecisionTree::Traverse.
+    for (int32 level = 0; level < depth; ++level) {
+      for (int32 i = 0; i < num_examples; ++i) {
+        const int32 node_id = leaf_ids[i];
+        const float value =
+            examples[i].dense_float_features[feature_columns_[node_id]];
+        leaf_ids[i] = left_ids_[node_id] + !(value <= thresholds_[node_id]);
+      }
+    }
+    return;
+  }
+  for (int32 level = 0; level < depth; ++level) {
+    for (int32 i = 0; i < num_examples; ++i) {
+      const int32 node_id = leaf_ids[i];
+      const utils::Example& example = examples[i];
+      switch (node_types_[node_id]) {
+        case kLeaf: {
+          break;
+        }
+        case kDenseFloatSplit: {
+          const float value =
+              example.dense_float_features[feature_columns_[node_id]];
+          leaf_ids[i] = left_ids_[node_id] + !(value <= thresholds_[node_id]);
+          break;
+        }
+        case kSparseFloatSplitDefaultLeft: {
+          const auto& value =
+              example.sparse_float_features[feature_columns_[node_id]];
+          const bool goes_right = value.has_value() &&
+                                  !(value.get_value() <= thresholds_[node_id]);
+          leaf_ids[i] = left_ids_[node_id] + goes_right;
+          break;
+        }
+        case kSparseFloatSplitDefaultRight: {
+          const auto& value =
+              example.sparse_float_features[feature_columns_[node_id]];
+          const bool goes_left = value.has_value() &&
+                                 value.get_value() <= thresholds_[node_id];
+          leaf_ids[i] = left_ids_[node_id] + !goes_left;
+          break;
+        }
+        case kCategoricalIdSplit:
+        case kCategoricalIdSetMembershipSplit: {
+          leaf_ids[i] = left_ids_[node_id] + !GoesLeft(node_id, example);
+          break;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,108 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_COMPILED_TREE_ENSEMBLE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_COMPILED_TREE_ENSEMBLE_H_
+
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/example.h"
+#include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+// The trees of an ensemble compiled into flat arrays for fast traversal.
+// The nodes of all trees are stored as a struct of arrays, each tree in
+// breadth-first order, so that the right child of a split always directly
+// follows its left child and the top levels of a tree share cache lines.
+// Only the tree structure and leaf values are compiled; the tree weights and
+// metadata are still read from the ensemble proto.
+// This class is immutable and thread safe.
+class CompiledTreeEnsemble {
+ public:
+  explicit CompiledTreeEnsemble(const DecisionTreeEnsembleConfig& config);
+
+  int32 num_trees() const { return tree_roots_.size(); }
+
+  // Traverses tree "tree_idx" for each of the "num_examples" examples, and
+  // sets the corresponding entry of "leaf_ids" to the id of the leaf that
+  // the example ends up in. The examples advance through the tree one level
+  // at a time, so that the levels of a tree are only loaded once per block.
+  void Traverse(int32 tree_idx, const utils::Example* examples,
+                int32 num_examples, int32* leaf_ids) const;
+
+  // The values of leaf "leaf_id" are the entries [leaf_begin, leaf_end), each
+  // with its class in leaf_class() and its value in leaf_value().
+  int32 leaf_begin(int32 leaf_id) const { return leaf_offsets_[leaf_id]; }
+  int32 leaf_end(int32 leaf_id) const { return leaf_offsets_[leaf_id + 1]; }
+  int32 leaf_class(int32 i) const { return leaf_classes_[i]; }
+  float leaf_value(int32 i) const { return leaf_values_[i]; }
+
+ private:
+  enum NodeType : uint8 {
+    kLeaf,
+    kDenseFloatSplit,
+    kSparseFloatSplitDefaultLeft,
+    kSparseFloatSplitDefaultRight,
+    kCategoricalIdSplit,
+    kCategoricalIdSetMembershipSplit,
+  };
+
+  // The feature column and the sorted feature ids of a categorical split.
+  struct CategoricalSplit {
+    int32 feature_column;
+    int32 feature_ids_begin;
+    int32 feature_ids_end;
+  };
+
+  // Appends the nodes of "tree" reachable from its root.
+  void AddTree(const DecisionTreeConfig& tree);
+
+  // Returns true if "example" goes to the left child of categorical split
+  // node "node_id".
+  bool GoesLeft(int32 node_id, const utils::Example& example) const;
+
+  // Per tree: the id of the root, which is -1 for an empty tree, the number of
+  // split levels, and whether all splits are on dense float features.
+  std::vector<int32> tree_roots_;
+  std::vector<int32> tree_depths_;
+  std::vector<bool> tree_dense_only_;
+
+  // Per node. For a categorical split, the feature column is an index into
+  // categorical_splits_ instead. A leaf has a NaN threshold and a left id one
+  // before its own id, so that every dense split step from a leaf stays in
+  // it. Leaf values are indexed by node id, with an empty range for splits.
+  std::vector<NodeType> node_types_;
+  std::vector<int32> feature_columns_;
+  std::vector<float> thresholds_;
+  std::vector<int32> left_ids_;
+  std::vector<int32> leaf_offsets_;
+
+  std::vector<CategoricalSplit> categorical_splits_;
+  std::vector<int64> categorical_feature_ids_;
+  std::vector<int32> leaf_classes_;
+  std::vector<float> leaf_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompiledTreeEnsemble);
+};
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_COMPILED_TREE_ENSEMBLE_H_
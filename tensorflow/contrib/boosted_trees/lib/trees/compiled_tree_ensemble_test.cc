@@ -0,0 +1,192 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/trees/compiled_tree_ensemble.h"
+
+#include <limits>
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+namespace {
+
+class CompiledTreeEnsembleTest : public ::testing::Test {
+ protected:
+  CompiledTreeEnsembleTest() : batch_features_(2) {
+    // Create a batch of two examples having one dense float, two sparse float
+    // and one sparse int features.
+    // Instance | DenseF1 | SparseF1 | SparseF2 | SparseI1 |
+    // 0        |   7     |   -3     |          |    3     |
+    // 1        |  -2     |          |   4      |          |
+    auto dense_float_matrix = test::AsTensor<float>({7.0f, -2.0f}, {2, 1});
+    auto sparse_float_indices1 = test::AsTensor<int64>({0, 0}, {1, 2});
+    auto sparse_float_values1 = test::AsTensor<float>({-3.0f});
+    auto sparse_float_shape1 = test::AsTensor<int64>({2, 1});
+    auto sparse_float_indices2 = test::AsTensor<int64>({1, 0}, {1, 2});
+    auto sparse_float_values2 = test::AsTensor<float>({4.0f});
+    auto sparse_float_shape2 = test::AsTensor<int64>({2, 1});
+    auto sparse_int_indices1 = test::AsTensor<int64>({0, 0}, {1, 2});
+    auto sparse_int_values1 = test::AsTensor<int64>({3});
+    auto sparse_int_shape1 = test::AsTensor<int64>({2, 1});
+    TF_EXPECT_OK(batch_features_.Initialize(
+        {dense_float_matrix}, {sparse_float_indices1, sparse_float_indices2},
+        {sparse_float_values1, sparse_float_values2},
+        {sparse_float_shape1, sparse_float_shape2}, {sparse_int_indices1},
+        {sparse_int_values1}, {sparse_int_shape1}));
+    for (const auto& example : batch_features_.examples_iterable(0, 2)) {
+      examples_.push_back(example);
+    }
+  }
+
+  // Adds a leaf with a single value to "tree".
+  static void AddLeaf(float value, DecisionTreeConfig* tree) {
+    auto* leaf = tree->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+    leaf->add_index(0);
+    leaf->add_value(value);
+  }
+
+  // Returns the single value of leaf "leaf_id".
+  static float LeafValue(const CompiledTreeEnsemble& compiled, int32 leaf_id) {
+    EXPECT_EQ(1, compiled.leaf_end(leaf_id) - compiled.leaf_begin(leaf_id));
+    return compiled.leaf_value(compiled.leaf_begin(leaf_id));
+  }
+
+  utils::BatchFeatures batch_features_;
+  std::vector<utils::Example> examples_;
+};
+
+TEST_F(CompiledTreeEnsembleTest, TraverseBias) {
+  DecisionTreeEnsembleConfig config;
+  AddLeaf(0.5f, config.add_trees());
+  CompiledTreeEnsemble compiled(config);
+  ASSERT_EQ(1, compiled.num_trees());
+  int32 leaf_ids[2];
+  compiled.Traverse(0, examples_.data(), 2, leaf_ids);
+  EXPECT_FLOAT_EQ(0.5f, LeafValue(compiled, leaf_ids[0]));
+  EXPECT_FLOAT_EQ(0.5f, LeafValue(compiled, leaf_ids[1]));
+}
+
+TEST_F(CompiledTreeEnsembleTest, TraverseMixedSplits) {
+  // The nodes are not in breadth-first order, and each leaf has its proto id
+  // as its value.
+  DecisionTreeEnsembleConfig config;
+  AddLeaf(-1.0f, config.add_trees());
+  DecisionTreeConfig* tree = config.add_trees();
+  auto* set_split = tree->add_nodes()
+                        ->mutable_categorical_id_set_membership_binary_split();
+  set_split->set_feature_column(0);
+  set_split->add_feature_ids(1);
+  set_split->add_feature_ids(3);
+  set_split->set_left_id(4);
+  set_split->set_right_id(1);
+  auto* default_left_split =
+      tree->add_nodes()
+          ->mutable_sparse_float_binary_split_default_left()
+          ->mutable_split();
+  default_left_split->set_feature_column(1);
+  default_left_split->set_threshold(3.0f);
+  default_left_split->set_left_id(2);
+  default_left_split->set_right_id(3);
+  AddLeaf(2.0f, tree);
+  auto* id_split = tree->add_nodes()->mutable_categorical_id_binary_split();
+  id_split->set_feature_column(0);
+  id_split->set_feature_id(3);
+  id_split->set_left_id(9);
+  id_split->set_right_id(10);
+  auto* dense_split = tree->add_nodes()->mutable_dense_float_binary_split();
+  dense_split->set_feature_column(0);
+  dense_split->set_threshold(5.0f);
+  dense_split->set_left_id(5);
+  dense_split->set_right_id(6);
+  AddLeaf(5.0f, tree);
+  auto* default_right_split =
+      tree->add_nodes()
+          ->mutable_sparse_float_binary_split_default_right()
+          ->mutable_split();
+  default_right_split->set_feature_column(0);
+  default_right_split->set_threshold(0.0f);
+  default_right_split->set_left_id(7);
+  default_right_split->set_right_id(8);
+  AddLeaf(7.0f, tree);
+  AddLeaf(8.0f, tree);
+  AddLeaf(9.0f, tree);
+  AddLeaf(10.0f, tree);
+
+  CompiledTreeEnsemble compiled(config);
+  ASSERT_EQ(2, compiled.num_trees());
+  int32 leaf_ids[2];
+  compiled.Traverse(1, examples_.data(), 2, leaf_ids);
+  EXPECT_FLOAT_EQ(7.0f, LeafValue(compiled, leaf_ids[0]));
+  EXPECT_FLOAT_EQ(10.0f, LeafValue(compiled, leaf_ids[1]));
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(DecisionTree::Traverse(*tree, 0, examples_[i]),
+              static_cast<int>(LeafValue(compiled, leaf_ids[i])));
+  }
+}
+
+TEST_F(CompiledTreeEnsembleTest, TraverseDenseSplits) {
+  // An unbalanced tree with vector leaves.
+  DecisionTreeEnsembleConfig config;
+  DecisionTreeConfig* tree = config.add_trees();
+  auto* root_split = tree->add_nodes()->mutable_dense_float_binary_split();
+  root_split->set_feature_column(0);
+  root_split->set_threshold(0.0f);
+  root_split->set_left_id(1);
+  root_split->set_right_id(2);
+  auto* leaf1 = tree->add_nodes()->mutable_leaf()->mutable_vector();
+  leaf1->add_value(1.0f);
+  leaf1->add_value(-1.0f);
+  auto* split = tree->add_nodes()->mutable_dense_float_binary_split();
+  split->set_feature_column(0);
+  split->set_threshold(5.0f);
+  split->set_left_id(3);
+  split->set_right_id(4);
+  auto* leaf3 = tree->add_nodes()->mutable_leaf()->mutable_vector();
+  leaf3->add_value(3.0f);
+  leaf3->add_value(-3.0f);
+  auto* leaf4 = tree->add_nodes()->mutable_leaf()->mutable_vector();
+  leaf4->add_value(4.0f);
+  leaf4->add_value(-4.0f);
+
+  // A NaN dense value goes right, like in DecisionTree::Traverse.
+  utils::Example nan_example;
+  nan_example.dense_float_features.push_back(
+      std::numeric_limits<float>::quiet_NaN());
+  examples_.push_back(nan_example);
+
+  CompiledTreeEnsemble compiled(config);
+  int32 leaf_ids[3];
+  compiled.Traverse(0, examples_.data(), 3, leaf_ids);
+  const std::vector<float> expected_values = {4.0f, 1.0f, 4.0f};
+  for (int i = 0; i < 3; ++i) {
+    const int32 begin = compiled.leaf_begin(leaf_ids[i]);
+    ASSERT_EQ(2, compiled.leaf_end(leaf_ids[i]) - begin);
+    EXPECT_EQ(0, compiled.leaf_class(begin));
+    EXPECT_FLOAT_EQ(expected_values[i], compiled.leaf_value(begin));
+    EXPECT_EQ(1, compiled.leaf_class(begin + 1));
+    EXPECT_FLOAT_EQ(-expected_values[i], compiled.leaf_value(begin + 1));
+  }
+}
+
+}  // namespace
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
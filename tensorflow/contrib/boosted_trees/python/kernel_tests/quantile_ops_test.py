@@ -246,6 +246,53 @@ class QuantileBucketsOpTest(test_util.TensorFlowTestCase):
           dense_buckets[0].eval(),
           atol=0.1)
 
+  def testLargeBatchShuffled(self):
+    """Sets up the quantile summary op test as follows.
+
+    Creates a shuffled array dividing range [0, 1] to 1<<18 elements equally
+    spaced with weight of 1.0, which is summarized in several chunks.
+    """
+    num_elements = 1 << 18
+    dense_float_tensor_0 = np.random.permutation(num_elements) / float(
+        num_elements)
+    example_weights = np.ones(num_elements)
+    config = self._gen_config(0.01, 10)
+
+    with self.test_session():
+      dense_buckets, _ = quantile_ops.quantile_buckets(
+          [dense_float_tensor_0], [], [], [],
+          example_weights=example_weights,
+          dense_config=[config],
+          sparse_config=[])
+      self.assertAllClose(
+          [0] + [(i + 1.0) / 10 for i in range(0, 9)] + [1 - 1. / num_elements],
+          dense_buckets[0].eval(),
+          atol=0.02)
+
+  def testStreamingLargeBatchShuffled(self):
+    """Same as testLargeBatchShuffled, but through an accumulator."""
+    num_elements = 1 << 18
+    dense_float_tensor_0 = np.random.permutation(num_elements) / float(
+        num_elements)
+    example_weights = np.ones(num_elements)
+
+    with self.test_session() as sess:
+      accumulator = quantile_ops.QuantileAccumulator(
+          init_stamp_token=0, num_quantiles=10, epsilon=0.01, name="q_large")
+      resources.initialize_resources(resources.shared_resources()).run()
+      update = accumulator.add_summary(
+          stamp_token=0,
+          column=dense_float_tensor_0,
+          example_weights=example_weights)
+      with ops.control_dependencies([update]):
+        reset = accumulator.flush(stamp_token=0, next_stamp_token=1)
+      with ops.control_dependencies([reset]):
+        _, buckets = accumulator.get_buckets(stamp_token=1)
+      self.assertAllClose(
+          [0] + [(i + 1.0) / 10 for i in range(0, 9)] + [1 - 1. / num_elements],
+          sess.run(buckets),
+          atol=0.02)
+
 
 class QuantilesOpTest(test_util.TensorFlowTestCase):
 
@@ -15,6 +15,9 @@
 #ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_RESOURCES_DECISION_TREE_ENSEMBLE_RESOURCE_H_
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_RESOURCES_DECISION_TREE_ENSEMBLE_RESOURCE_H_
 
+#include <memory>
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/compiled_tree_ensemble.h"
 #include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
 #include "tensorflow/contrib/boosted_trees/resources/stamped_resource.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -44,16 +47,32 @@ class DecisionTreeEnsembleResource : public StampedResource {
     return *decision_tree_ensemble_;
   }
 
+  // Returns the ensemble for mutation, which discards its compiled trees.
   boosted_trees::trees::DecisionTreeEnsembleConfig*
   mutable_decision_tree_ensemble() {
+    ClearCompiledTrees();
     return decision_tree_ensemble_;
   }
 
+  // Returns the trees of the ensemble compiled for prediction. They are
+  // compiled on the first call after the ensemble was mutated, and shared by
+  // the predictions until the next mutation.
+  std::shared_ptr<const boosted_trees::trees::CompiledTreeEnsemble>
+  compiled_trees() {
+    mutex_lock l(compiled_trees_mu_);
+    if (compiled_trees_ == nullptr) {
+      compiled_trees_.reset(new boosted_trees::trees::CompiledTreeEnsemble(
+          *decision_tree_ensemble_));
+    }
+    return compiled_trees_;
+  }
+
   // Resets the resource and frees the protos in arena.
   // Caller needs to hold the mutex lock while calling this.
   void Reset() {
     // Reset stamp.
     set_stamp(-1);
+    ClearCompiledTrees();
 
     // Clear tree ensemle.
     arena_.Reset();
@@ -65,9 +84,20 @@ class DecisionTreeEnsembleResource : public StampedResource {
   mutex* get_mutex() { return &mu_; }
 
  private:
+  void ClearCompiledTrees() {
+    mutex_lock l(compiled_trees_mu_);
+    compiled_trees_.reset();
+  }
+
   protobuf::Arena arena_;
   mutex mu_;
   boosted_trees::trees::DecisionTreeEnsembleConfig* decision_tree_ensemble_;
+
+  // Guards only the compiled trees, which are also used by predictions that
+  // do not hold mu_.
+  mutex compiled_trees_mu_;
+  std::shared_ptr<const boosted_trees::trees::CompiledTreeEnsemble>
+      compiled_trees_ GUARDED_BY(compiled_trees_mu_);
 };
 
 }  // namespace models
@@ -23,6 +23,7 @@ See the @{$python/contrib.crf} guide.
 @@crf_binary_score
 @@CrfForwardRnnCell
 @@viterbi_decode
+@@crf_decode
 """
 
 from __future__ import absolute_import
@@ -31,6 +32,7 @@ from __future__ import print_function
 
 from tensorflow.contrib.crf.python.ops.crf import _lengths_to_masks
 from tensorflow.contrib.crf.python.ops.crf import crf_binary_score
+from tensorflow.contrib.crf.python.ops.crf import crf_decode
 from tensorflow.contrib.crf.python.ops.crf import crf_log_likelihood
 from tensorflow.contrib.crf.python.ops.crf import crf_log_norm
 from tensorflow.contrib.crf.python.ops.crf import crf_sequence_score
@@ -0,0 +1,357 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns log(sum(exp(values[0, n)))), computed stably.
+template <typename T>
+T LogSumExp(const T* values, const int64 n) {
+  const T max_value = *std::max_element(values, values + n);
+  if (!std::isfinite(max_value)) {
+    return max_value;
+  }
+  T sum = 0;
+  for (int64 i = 0; i < n; ++i) {
+    sum += std::exp(values[i] - max_value);
+  }
+  return max_value + std::log(sum);
+}
+
+// Validates the inputs shared by the CRF ops, and returns the length of each
+// sequence clamped to [1, max_seq_len].
+Status ValidateCrfInputs(const Tensor& inputs, const Tensor& sequence_lengths,
+                         const Tensor& transition_params,
+                         std::vector<int64>* lengths) {
+  if (inputs.dims() != 3) {
+    return errors::InvalidArgument("inputs must be a 3-tensor, saw shape: ",
+                                   inputs.shape().DebugString());
+  }
+  if (!TensorShapeUtils::IsVector(sequence_lengths.shape()) ||
+      sequence_lengths.dim_size(0) != inputs.dim_size(0)) {
+    return errors::InvalidArgument(
+        "sequence_lengths must be a vector of length batch_size (",
+        inputs.dim_size(0), "), saw shape: ",
+        sequence_lengths.shape().DebugString());
+  }
+  const int64 num_tags = inputs.dim_size(2);
+  if (!TensorShapeUtils::IsSquareMatrix(transition_params.shape()) ||
+      transition_params.dim_size(0) != num_tags) {
+    return errors::InvalidArgument(
+        "transition_params must be a [num_tags, num_tags] matrix with "
+        "num_tags = ",
+        num_tags, ", saw shape: ", transition_params.shape().DebugString());
+  }
+  const int64 max_seq_len = inputs.dim_size(1);
+  if (max_seq_len == 0 || num_tags == 0) {
+    return errors::InvalidArgument(
+        "inputs must have at least one time step and one tag, saw shape: ",
+        inputs.shape().DebugString());
+  }
+  const auto sequence_lengths_t = sequence_lengths.vec<int32>();
+  lengths->resize(sequence_lengths_t.size());
+  for (int64 b = 0; b < sequence_lengths_t.size(); ++b) {
+    const int32 length = sequence_lengths_t(b);
+    if (length < 0 || length > max_seq_len) {
+      return errors::InvalidArgument("sequence_lengths[", b, "] = ", length,
+                                     " is not in [0, ", max_seq_len, "]");
+    }
+    (*lengths)[b] = std::max(length, 1);
+  }
+  return Status::OK();
+}
+
+// Computes the forward variables alphas[t * num_tags + j] of one sequence
+// for t < length, where alpha_0 = x_0 and
+//   alpha_t[j] = x_t[j] + logsumexp_i(alpha_{t-1}[i] + A[i, j]).
+// If "all_steps" is false, only the last step is kept, in alphas[0, num_tags).
+template <typename T>
+void CrfForward(const T* x, const T* transitions, const int64 length,
+                const int64 num_tags, const bool all_steps,
+                std::vector<T>* alphas, std::vector<T>* scratch) {
+  alphas->resize((all_steps ? length : 2) * num_tags);
+  scratch->resize(num_tags);
+  T* previous = alphas->data();
+  std::copy(x, x + num_tags, previous);
+  for (int64 t = 1; t < length; ++t) {
+    T* current = all_steps ? previous + num_tags
+                           : alphas->data() + (t % 2) * num_tags;
+    const T* x_t = x + t * num_tags;
+    for (int64 j = 0; j < num_tags; ++j) {
+      for (int64 i = 0; i < num_tags; ++i) {
+        (*scratch)[i] = previous[i] + transitions[i * num_tags + j];
+      }
+      current[j] = x_t[j] + LogSumExp(scratch->data(), num_tags);
+    }
+    previous = current;
+  }
+  if (!all_steps && previous != alphas->data()) {
+    std::copy(previous, previous + num_tags, alphas->data());
+  }
+}
+
+// The cost of one time step of the forward algorithm over "num_tags" tags.
+int64 CostPerStep(const int64 num_tags) { return 30 * num_tags * num_tags; }
+
+}  // namespace
+
+template <typename T>
+class CrfLogNormOp : public OpKernel {
+ public:
+  explicit CrfLogNormOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& inputs = ctx->input(0);
+    const Tensor& sequence_lengths = ctx->input(1);
+    const Tensor& transition_params = ctx->input(2);
+    std::vector<int64> lengths;
+    OP_REQUIRES_OK(ctx, ValidateCrfInputs(inputs, sequence_lengths,
+                                          transition_params, &lengths));
+    const int64 batch_size = inputs.dim_size(0);
+    const int64 max_seq_len = inputs.dim_size(1);
+    const int64 num_tags = inputs.dim_size(2);
+
+    Tensor* log_norm = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({batch_size}),
+                                             &log_norm));
+    const T* inputs_data = inputs.flat<T>().data();
+    const T* transitions = transition_params.flat<T>().data();
+    auto log_norm_t = log_norm->vec<T>();
+
+    auto work = [&](int64 start, int64 limit) {
+      std::vector<T> alphas;
+      std::vector<T> scratch;
+      for (int64 b = start; b < limit; ++b) {
+        CrfForward(inputs_data + b * max_seq_len * num_tags, transitions,
+                   lengths[b], num_tags, false, &alphas, &scratch);
+        log_norm_t(b) = LogSumExp(alphas.data(), num_tags);
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          max_seq_len * CostPerStep(num_tags), work);
+  }
+};
+
+template <typename T>
+class CrfLogNormGradOp : public OpKernel {
+ public:
+  explicit CrfLogNormGradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& inputs = ctx->input(0);
+    const Tensor& sequence_lengths = ctx->input(1);
+    const Tensor& transition_params = ctx->input(2);
+    const Tensor& grad_log_norm = ctx->input(3);
+    std::vector<int64> lengths;
+    OP_REQUIRES_OK(ctx, ValidateCrfInputs(inputs, sequence_lengths,
+                                          transition_params, &lengths));
+    const int64 batch_size = inputs.dim_size(0);
+    const int64 max_seq_len = inputs.dim_size(1);
+    const int64 num_tags = inputs.dim_size(2);
+    OP_REQUIRES(ctx, grad_log_norm.shape() == TensorShape({batch_size}),
+                errors::InvalidArgument(
+                    "grad_log_norm must be a vector of length batch_size (",
+                    batch_size, "), saw shape: ",
+                    grad_log_norm.shape().DebugString()));
+
+    Tensor* grad_inputs = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, inputs.shape(), &grad_inputs));
+    Tensor* grad_transitions = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, transition_params.shape(),
+                                             &grad_transitions));
+    const T* inputs_data = inputs.flat<T>().data();
+    const T* transitions = transition_params.flat<T>().data();
+    const auto grad_log_norm_t = grad_log_norm.vec<T>();
+    T* grad_inputs_data = grad_inputs->flat<T>().data();
+    T* grad_transitions_data = grad_transitions->flat<T>().data();
+    std::fill(grad_transitions_data,
+              grad_transitions_data + num_tags * num_tags, T(0));
+
+    mutex mu;
+    auto work = [&](int64 start, int64 limit) {
+      std::vector<T> alphas;
+      std::vector<T> betas;
+      std::vector<T> scratch;
+      std::vector<T> local_grad_transitions(num_tags * num_tags, T(0));
+      for (int64 b = start; b < limit; ++b) {
+        const T* x = inputs_data + b * max_seq_len * num_tags;
+        T* grad_x = grad_inputs_data + b * max_seq_len * num_tags;
+        const int64 length = lengths[b];
+        const T grad = grad_log_norm_t(b);
+        CrfForward(x, transitions, length, num_tags, true, &alphas, &scratch);
+        const T log_norm =
+            LogSumExp(alphas.data() + (length - 1) * num_tags, num_tags);
+
+        // The backward variables, where beta_{length - 1} = 0 and
+        //   beta_t[i] = logsumexp_j(A[i, j] + x_{t+1}[j] + beta_{t+1}[j]).
+        betas.assign(length * num_tags, T(0));
+        for (int64 t = length - 2; t >= 0; --t) {
+          const T* x_next = x + (t + 1) * num_tags;
+          const T* beta_next = betas.data() + (t + 1) * num_tags;
+          for (int64 i = 0; i < num_tags; ++i) {
+            for (int64 j = 0; j < num_tags; ++j) {
+              scratch[j] = transitions[i * num_tags + j] + x_next[j] +
+                           beta_next[j];
+            }
+            betas[t * num_tags + i] = LogSumExp(scratch.data(), num_tags);
+          }
+        }
+
+        // The marginals of the tags, and of the transitions into step t.
+        for (int64 t = 0; t < length; ++t) {
+          const T* alpha = alphas.data() + t * num_tags;
+          const T* beta = betas.data() + t * num_tags;
+          for (int64 j = 0; j < num_tags; ++j) {
+            grad_x[t * num_tags + j] =
+                grad * std::exp(alpha[j] + beta[j] - log_norm);
+          }
+          if (t == 0) {
+            continue;
+          }
+          const T* alpha_previous = alpha - num_tags;
+          const T* x_t = x + t * num_tags;
+          for (int64 i = 0; i < num_tags; ++i) {
+            for (int64 j = 0; j < num_tags; ++j) {
+              local_grad_transitions[i * num_tags + j] +=
+                  grad * std::exp(alpha_previous[i] +
+                                  transitions[i * num_tags + j] + x_t[j] +
+                                  beta[j] - log_norm);
+            }
+          }
+        }
+        std::fill(grad_x + length * num_tags, grad_x + max_seq_len * num_tags,
+                  T(0));
+      }
+      mutex_lock l(mu);
+      for (int64 k = 0; k < num_tags * num_tags; ++k) {
+        grad_transitions_data[k] += local_grad_transitions[k];
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          3 * max_seq_len * CostPerStep(num_tags), work);
+  }
+};
+
+template <typename T>
+class CrfViterbiDecodeOp : public OpKernel {
+ public:
+  explicit CrfViterbiDecodeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& inputs = ctx->input(0);
+    const Tensor& sequence_lengths = ctx->input(1);
+    const Tensor& transition_params = ctx->input(2);
+    std::vector<int64> lengths;
+    OP_REQUIRES_OK(ctx, ValidateCrfInputs(inputs, sequence_lengths,
+                                          transition_params, &lengths));
+    const int64 batch_size = inputs.dim_size(0);
+    const int64 max_seq_len = inputs.dim_size(1);
+    const int64 num_tags = inputs.dim_size(2);
+
+    Tensor* decode_tags = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            0, TensorShape({batch_size, max_seq_len}),
+                            &decode_tags));
+    Tensor* best_score = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({batch_size}),
+                                             &best_score));
+    const T* inputs_data = inputs.flat<T>().data();
+    const T* transitions = transition_params.flat<T>().data();
+    auto decode_tags_t = decode_tags->matrix<int32>();
+    auto best_score_t = best_score->vec<T>();
+
+    auto work = [&](int64 start, int64 limit) {
+      std::vector<T> trellis(2 * num_tags);
+      std::vector<int32> backpointers;
+      for (int64 b = start; b < limit; ++b) {
+        const T* x = inputs_data + b * max_seq_len * num_tags;
+        const int64 length = lengths[b];
+        backpointers.resize(length * num_tags);
+        T* previous = trellis.data();
+        T* current = trellis.data() + num_tags;
+        std::copy(x, x + num_tags, previous);
+        for (int64 t = 1; t < length; ++t) {
+          const T* x_t = x + t * num_tags;
+          for (int64 j = 0; j < num_tags; ++j) {
+            int32 best_i = 0;
+            T best = previous[0] + transitions[j];
+            for (int64 i = 1; i < num_tags; ++i) {
+              const T score = previous[i] + transitions[i * num_tags + j];
+              if (score > best) {
+                best = score;
+                best_i = i;
+              }
+            }
+            current[j] = x_t[j] + best;
+            backpointers[t * num_tags + j] = best_i;
+          }
+          std::swap(previous, current);
+        }
+        int32 tag = std::max_element(previous, previous + num_tags) - previous;
+        best_score_t(b) = previous[tag];
+        for (int64 t = length - 1; t >= 0; --t) {
+          decode_tags_t(b, t) = tag;
+          tag = backpointers[t * num_tags + tag];
+        }
+        for (int64 t = length; t < max_seq_len; ++t) {
+          decode_tags_t(b, t) = 0;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          max_seq_len * CostPerStep(num_tags), work);
+  }
+};
+
+#define REGISTER_CPU(T)                                                 \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("CrfLogNorm").Device(DEVICE_CPU).TypeConstraint<T>("T"),     \
+      CrfLogNormOp<T>);                                                 \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("CrfLogNormGrad").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      CrfLogNormGradOp<T>);                                             \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("CrfViterbiDecode").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      CrfViterbiDecodeOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
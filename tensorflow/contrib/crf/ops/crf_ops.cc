@@ -0,0 +1,140 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+
+using shape_inference::DimensionHandle;
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+namespace {
+
+// Validates the shapes of the inputs, sequence_lengths and transition_params
+// inputs of the CRF ops, and returns the batch size, the maximum sequence
+// length and the number of tags.
+Status CrfInputShapes(InferenceContext* c, DimensionHandle* batch_size,
+                      DimensionHandle* max_seq_len, DimensionHandle* num_tags) {
+  ShapeHandle inputs;
+  ShapeHandle sequence_lengths;
+  ShapeHandle transition_params;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &inputs));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &sequence_lengths));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &transition_params));
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(inputs, 0), c->Dim(sequence_lengths, 0), batch_size));
+  *max_seq_len = c->Dim(inputs, 1);
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(inputs, 2), c->Dim(transition_params, 0), num_tags));
+  TF_RETURN_IF_ERROR(
+      c->Merge(*num_tags, c->Dim(transition_params, 1), num_tags));
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("CrfLogNorm")
+    .Input("inputs: T")
+    .Input("sequence_lengths: int32")
+    .Input("transition_params: T")
+    .Output("log_norm: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      DimensionHandle batch_size, max_seq_len, num_tags;
+      TF_RETURN_IF_ERROR(
+          CrfInputShapes(c, &batch_size, &max_seq_len, &num_tags));
+      c->set_output(0, c->Vector(batch_size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the normalization of a linear-chain CRF with the forward algorithm.
+
+The log-sum-exp over the tag transitions of every time step is computed in one
+kernel, rather than by a loop of small ops. A sequence of length 0 is treated
+as having length 1, like a sequence whose forward recursion never starts.
+
+inputs: A `[batch_size, max_seq_len, num_tags]` tensor of unary potentials.
+sequence_lengths: A `[batch_size]` vector of sequence lengths, each in
+  `[0, max_seq_len]`.
+transition_params: A `[num_tags, num_tags]` matrix of binary potentials.
+log_norm: A `[batch_size]` vector of the log partition functions.
+)doc");
+
+REGISTER_OP("CrfLogNormGrad")
+    .Input("inputs: T")
+    .Input("sequence_lengths: int32")
+    .Input("transition_params: T")
+    .Input("grad_log_norm: T")
+    .Output("grad_inputs: T")
+    .Output("grad_transition_params: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      DimensionHandle batch_size, max_seq_len, num_tags;
+      TF_RETURN_IF_ERROR(
+          CrfInputShapes(c, &batch_size, &max_seq_len, &num_tags));
+      ShapeHandle grad_log_norm;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &grad_log_norm));
+      TF_RETURN_IF_ERROR(
+          c->Merge(batch_size, c->Dim(grad_log_norm, 0), &batch_size));
+      c->set_output(0, c->MakeShape({batch_size, max_seq_len, num_tags}));
+      c->set_output(1, c->Matrix(num_tags, num_tags));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the gradients of CrfLogNorm with the forward-backward algorithm.
+
+The gradient with respect to the inputs is the marginal probability of each
+tag at each time step of a sequence, and zero past its end. The gradient with
+respect to the transitions sums the marginal probabilities of each transition
+over the time steps and the batch. Both are scaled by `grad_log_norm`.
+
+inputs: A `[batch_size, max_seq_len, num_tags]` tensor of unary potentials.
+sequence_lengths: A `[batch_size]` vector of sequence lengths.
+transition_params: A `[num_tags, num_tags]` matrix of binary potentials.
+grad_log_norm: A `[batch_size]` vector, the gradient of the log norms.
+grad_inputs: The gradient with respect to `inputs`.
+grad_transition_params: The gradient with respect to `transition_params`.
+)doc");
+
+REGISTER_OP("CrfViterbiDecode")
+    .Input("inputs: T")
+    .Input("sequence_lengths: int32")
+    .Input("transition_params: T")
+    .Output("decode_tags: int32")
+    .Output("best_score: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      DimensionHandle batch_size, max_seq_len, num_tags;
+      TF_RETURN_IF_ERROR(
+          CrfInputShapes(c, &batch_size, &max_seq_len, &num_tags));
+      c->set_output(0, c->Matrix(batch_size, max_seq_len));
+      c->set_output(1, c->Vector(batch_size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Decodes the highest scoring tag sequences of a batch with the Viterbi
+algorithm.
+
+inputs: A `[batch_size, max_seq_len, num_tags]` tensor of unary potentials.
+sequence_lengths: A `[batch_size]` vector of sequence lengths.
+transition_params: A `[num_tags, num_tags]` matrix of binary potentials.
+decode_tags: A `[batch_size, max_seq_len]` matrix of the highest scoring tag
+  indices, which are 0 past the end of each sequence.
+best_score: A `[batch_size]` vector of the scores of `decode_tags`.
+)doc");
+
+}  // namespace tensorflow
@@ -25,6 +25,7 @@ import numpy as np
 from tensorflow.contrib.crf.python.ops import crf
 from tensorflow.python.framework import constant_op
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
@@ -121,6 +122,41 @@ class CrfTest(test.TestCase):
 
       self.assertAllClose(tf_log_norm, tf_brute_force_log_norm)
 
+  def testCrfLogNormBatch(self):
+    np.random.seed(3)
+    inputs = np.random.randn(4, 5, 3).astype(np.float32)
+    transition_params = np.random.randn(3, 3).astype(np.float32)
+    sequence_lengths = np.array([5, 1, 3, 0], dtype=np.int32)
+    with self.test_session() as sess:
+      log_norm = crf.crf_log_norm(
+          inputs=constant_op.constant(inputs),
+          sequence_lengths=constant_op.constant(sequence_lengths),
+          transition_params=constant_op.constant(transition_params))
+      tf_log_norm = sess.run(log_norm)
+
+    # A sequence of length 0 is normalized like a sequence of length 1.
+    for b, length in enumerate(np.maximum(sequence_lengths, 1)):
+      alphas = inputs[b, 0]
+      for t in range(1, length):
+        scores = np.expand_dims(alphas, 1) + transition_params
+        alphas = inputs[b, t] + np.log(np.sum(np.exp(scores), 0))
+      self.assertAllClose(tf_log_norm[b], np.log(np.sum(np.exp(alphas))))
+
+  def testCrfLogNormGradient(self):
+    np.random.seed(7)
+    inputs = np.random.randn(3, 4, 3)
+    transition_params = np.random.randn(3, 3)
+    sequence_lengths = np.array([4, 2, 1], dtype=np.int32)
+    with self.test_session():
+      inputs_t = constant_op.constant(inputs)
+      transition_params_t = constant_op.constant(transition_params)
+      log_norm = crf.crf_log_norm(inputs_t, sequence_lengths,
+                                  transition_params_t)
+      error = gradient_checker.compute_gradient_error(
+          [inputs_t, transition_params_t], [inputs.shape, (3, 3)], log_norm,
+          [3])
+      self.assertLess(error, 1e-6)
+
   def testCrfLogLikelihood(self):
     inputs = np.array(
         [[4, 5, -3], [3, -1, 3], [-1, 2, 1], [0, 0, 0]], dtype=np.float32)
@@ -199,6 +235,25 @@ class CrfTest(test.TestCase):
       self.assertEqual(actual_max_sequence,
                        expected_max_sequence[:sequence_lengths])
 
+  def testCrfDecode(self):
+    np.random.seed(11)
+    inputs = np.random.randn(4, 6, 5).astype(np.float32)
+    transition_params = np.random.randn(5, 5).astype(np.float32)
+    sequence_lengths = np.array([6, 1, 4, 0], dtype=np.int32)
+    with self.test_session() as sess:
+      decode_tags, best_score = crf.crf_decode(
+          constant_op.constant(inputs), constant_op.constant(transition_params),
+          constant_op.constant(sequence_lengths))
+      tf_decode_tags, tf_best_score = sess.run([decode_tags, best_score])
+
+    self.assertEqual(tf_decode_tags.shape, (4, 6))
+    for b, length in enumerate(np.maximum(sequence_lengths, 1)):
+      expected_tags, expected_score = crf.viterbi_decode(
+          inputs[b, :length], transition_params)
+      self.assertAllEqual(tf_decode_tags[b, :length], expected_tags)
+      self.assertAllEqual(tf_decode_tags[b, length:], [0] * (6 - length))
+      self.assertAllClose(tf_best_score[b], expected_score)
+
 
 if __name__ == "__main__":
   test.main()
@@ -102,6 +102,7 @@ namespace {
 using perftools::gputools::dnn::RnnMode;
 using perftools::gputools::dnn::RnnInputMode;
 using perftools::gputools::dnn::RnnDirectionMode;
+using perftools::gputools::dnn::RnnAlgorithm;
 using perftools::gputools::dnn::ToDataType;
 using perftools::gputools::DeviceMemory;
 using perftools::gputools::DeviceMemoryBase;
@@ -523,8 +524,8 @@ class CudnnRNNKernelCommon : public OpKernel {
     // random number generator, therefore set state_allocator to nullptr.
     auto rnn_desc_s = stream->parent()->createRnnDescriptor(
         num_layers, num_units, input_size, input_mode, rnn_direction_mode(),
-        rnn_mode(), ToDataType<T>::value, dropout(), seed(),
-        nullptr /* state_allocator */);
+        rnn_mode(), ToDataType<T>::value, RnnAlgorithm::kRnnStandard,
+        0 /* batch_size */, dropout(), seed(), nullptr /* state_allocator */);
     if (!rnn_desc_s.ok()) {
       return FromExecutorStatus(rnn_desc_s);
     }
@@ -741,6 +742,9 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
   explicit CudnnRNNForwardOp(OpKernelConstruction* context)
       : CudnnRNNKernelCommon(context) {
     OP_REQUIRES_OK(context, context->GetAttr("is_training", &is_training_));
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar("TF_CUDNN_USE_PERSISTENT_RNN", true,
+                                      &use_persistent_rnn_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -791,16 +795,40 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                         model_shapes_->RnnDescDebugString(), ", getting ",
                         model_shapes.RnnDescDebugString(), "."));
       }
-      if (rnn_desc_ == nullptr || ResetRndGenState()) {
+      const RnnAlgorithm algorithm =
+          ChooseAlgorithm(executor, model_shapes.batch_size);
+      // A persistent plan only runs the batch size it was built for.
+      const bool plan_changed =
+          algorithm != rnn_algorithm_ ||
+          (algorithm == RnnAlgorithm::kRnnPersistStatic &&
+           model_shapes.batch_size != rnn_batch_size_);
+      if (rnn_desc_ == nullptr || plan_changed || ResetRndGenState()) {
         dropout_state_allocator_.reset(
             new CudnnRNNPersistentSpaceAllocator(context));
         auto rnn_desc_s = executor->createRnnDescriptor(
             model_shapes_->num_layers, model_shapes_->num_units,
             model_shapes_->input_size, input_mode, rnn_direction_mode(),
-            rnn_mode(), data_type, dropout(), seed(),
-            dropout_state_allocator_.get());
+            rnn_mode(), data_type, algorithm, model_shapes.batch_size,
+            dropout(), seed(), dropout_state_allocator_.get());
+        if (!rnn_desc_s.ok() &&
+            algorithm == RnnAlgorithm::kRnnPersistStatic) {
+          // The persistent kernels are not supported for every model and
+          // device; remember that and run the standard algorithm instead.
+          LOG(WARNING) << "Falling back to the standard cuDNN RNN algorithm: "
+                       << rnn_desc_s.status().error_message();
+          persistent_rnn_failed_ = true;
+          rnn_desc_s = executor->createRnnDescriptor(
+              model_shapes_->num_layers, model_shapes_->num_units,
+              model_shapes_->input_size, input_mode, rnn_direction_mode(),
+              rnn_mode(), data_type, RnnAlgorithm::kRnnStandard,
+              model_shapes.batch_size, dropout(), seed(),
+              dropout_state_allocator_.get());
+        }
         OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
         rnn_desc_ = std::move(rnn_desc_s.ConsumeValueOrDie());
+        rnn_algorithm_ = persistent_rnn_failed_ ? RnnAlgorithm::kRnnStandard
+                                                : algorithm;
+        rnn_batch_size_ = model_shapes.batch_size;
       }
     }
 
@@ -866,10 +894,40 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
   }
 
  private:
+  // Returns the algorithm for a forward pass over 'batch_size' sequences.
+  // The persistent kernels keep the recurrent weights on chip across time
+  // steps, which pays off for inference with small batches and hidden sizes
+  // on devices of compute capability 6.0 and above. Training keeps the
+  // standard algorithm, whose reserve space the backward op expects.
+  RnnAlgorithm ChooseAlgorithm(perftools::gputools::StreamExecutor* executor,
+                               int batch_size)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (is_training_ || !use_persistent_rnn_ || persistent_rnn_failed_ ||
+        batch_size > kMaxPersistentBatchSize ||
+        model_shapes_->num_units > kMaxPersistentNumUnits) {
+      return RnnAlgorithm::kRnnStandard;
+    }
+    int cc_major = 0;
+    int cc_minor = 0;
+    if (!executor->GetDeviceDescription().cuda_compute_capability(
+            &cc_major, &cc_minor) ||
+        cc_major < 6) {
+      return RnnAlgorithm::kRnnStandard;
+    }
+    return RnnAlgorithm::kRnnPersistStatic;
+  }
+
+  static constexpr int kMaxPersistentBatchSize = 32;
+  static constexpr int kMaxPersistentNumUnits = 512;
+
   mutex mu_;
   bool is_training_;
+  bool use_persistent_rnn_;
   std::unique_ptr<CudnnModelShapes> model_shapes_ GUARDED_BY(mu_);
   std::unique_ptr<RnnDescriptor> rnn_desc_ GUARDED_BY(mu_);
+  RnnAlgorithm rnn_algorithm_ GUARDED_BY(mu_) = RnnAlgorithm::kRnnStandard;
+  int rnn_batch_size_ GUARDED_BY(mu_) = 0;
+  bool persistent_rnn_failed_ GUARDED_BY(mu_) = false;
   std::unique_ptr<CudnnRNNPersistentSpaceAllocator> dropout_state_allocator_
       GUARDED_BY(mu_);
 };
@@ -1005,7 +1063,8 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
         auto rnn_desc_s = executor->createRnnDescriptor(
             model_shapes.num_layers, model_shapes.num_units,
             model_shapes.input_size, input_mode, rnn_direction_mode(),
-            rnn_mode(), data_type, dropout(), seed(),
+            rnn_mode(), data_type, RnnAlgorithm::kRnnStandard,
+            0 /* batch_size */, dropout(), seed(),
             dropout_state_allocator_.get());
         OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
         rnn_desc_ = std::move(rnn_desc_s.ConsumeValueOrDie());
@@ -18,6 +18,7 @@
 @@Iterator
 @@TFRecordDataset
 @@FixedLengthRecordDataset
+@@ColumnarDataset
 @@TextLineDataset
 
 @@read_batch_features
@@ -29,6 +30,7 @@ from __future__ import division
 from __future__ import print_function
 
 # pylint: disable=unused-import
+from tensorflow.contrib.data.python.ops.dataset_ops import ColumnarDataset
 from tensorflow.contrib.data.python.ops.dataset_ops import Dataset
 from tensorflow.contrib.data.python.ops.dataset_ops import FixedLengthRecordDataset
 from tensorflow.contrib.data.python.ops.dataset_ops import Iterator
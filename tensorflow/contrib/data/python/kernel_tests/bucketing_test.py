@@ -288,5 +288,82 @@ class BucketTest(test.TestCase):
           np.arange(64, 128, 2, dtype=np.int64), bucketed_values_even1[0])
 
 
+class BucketByTokenBudgetTest(test.TestCase):
+
+  def _lengthsDataset(self, lengths):
+    return dataset_ops.Dataset.from_tensor_slices(
+        np.array(lengths, dtype=np.int64)).map(lambda n: array_ops.fill([n], n))
+
+  def _sequenceLength(self, x):
+    return array_ops.shape(x, out_type=dtypes.int64)[0]
+
+  def testBucketByTokenBudget(self):
+    dataset = self._lengthsDataset([2, 3, 9, 2, 8, 1, 10, 3])
+    bucketed = dataset.bucket_by_token_budget(
+        self._sequenceLength, token_budget=12, bucket_boundaries=[5])
+    self.assertEqual((dtypes.int64, (dtypes.int64, dtypes.int64)),
+                     bucketed.output_types)
+    self.assertEqual([None, None], bucketed.output_shapes[0].as_list())
+    get_next = bucketed.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      # The long sequences fill their bucket first.
+      batch, stats = sess.run(get_next)
+      self.assertAllEqual([[9] * 9], batch)
+      self.assertEqual((9, 9), stats)
+
+      # The short bucket is emitted when it reaches the budget.
+      batch, stats = sess.run(get_next)
+      self.assertAllEqual(
+          [[2, 2, 0], [3, 3, 3], [2, 2, 0], [1, 0, 0]], batch)
+      self.assertEqual((8, 12), stats)
+
+      batch, stats = sess.run(get_next)
+      self.assertAllEqual([[8] * 8], batch)
+      self.assertEqual((8, 8), stats)
+
+      # The remaining buckets are flushed at the end of the input.
+      batch, stats = sess.run(get_next)
+      self.assertAllEqual([[3, 3, 3]], batch)
+      self.assertEqual((3, 3), stats)
+      batch, stats = sess.run(get_next)
+      self.assertAllEqual([[10] * 10], batch)
+      self.assertEqual((10, 10), stats)
+
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testBatchesStayWithinBudget(self):
+    lengths = np.random.randint(1, 50, size=(500,))
+    dataset = self._lengthsDataset(lengths)
+    bucketed = dataset.bucket_by_token_budget(
+        self._sequenceLength, token_budget=100,
+        bucket_boundaries=[10, 20, 30, 40], padding_values=-1)
+    get_next = bucketed.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      seen_lengths = []
+      while True:
+        try:
+          batch, (num_tokens, num_padded_tokens) = sess.run(get_next)
+        except errors.OutOfRangeError:
+          break
+        self.assertLessEqual(batch.size, 100)
+        self.assertEqual(batch.size, num_padded_tokens)
+        self.assertEqual(np.sum(batch != -1), num_tokens)
+        seen_lengths.extend(np.sum(batch != -1, axis=1))
+      self.assertAllEqual(sorted(lengths), sorted(seen_lengths))
+
+  def testInvalidLength(self):
+    dataset = self._lengthsDataset([1, 2]).bucket_by_token_budget(
+        lambda x: -self._sequenceLength(x), token_budget=10,
+        bucket_boundaries=[])
+    get_next = dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      with self.assertRaisesOpError("non-negative"):
+        sess.run(get_next)
+
+
 if __name__ == "__main__":
   test.main()
@@ -17,6 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
 from os import path
 import shutil
 import tempfile
@@ -28,6 +29,7 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import random_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 
@@ -295,5 +297,58 @@ class MemoryCacheDatasetTest(test.TestCase):
         sess.run(i2.get_next())
 
 
+class CachedMapDatasetTest(test.TestCase):
+
+  def setUp(self):
+    self.tmp_dir = tempfile.mkdtemp()
+    self.cache_dir = path.join(self.tmp_dir, "cache")
+
+  def tearDown(self):
+    if self.tmp_dir:
+      shutil.rmtree(self.tmp_dir, ignore_errors=True)
+
+  def _noisyDataset(self, capacity_bytes):
+    # The results of the function differ between calls, which reveals whether
+    # they came from the cache.
+    return dataset_ops.Dataset.range(4).repeat(2).cached_map(
+        lambda x: x * 1000 + random_ops.random_uniform(
+            [], maxval=1000, dtype=dtypes.int64),
+        self.cache_dir, capacity_bytes)
+
+  def _readAll(self, dataset):
+    get_next = dataset.make_one_shot_iterator().get_next()
+    elements = []
+    with self.test_session() as sess:
+      while True:
+        try:
+          elements.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          return elements
+
+  def testCachedMap(self):
+    elements = self._readAll(self._noisyDataset(1 << 20))
+    self.assertEqual(8, len(elements))
+    self.assertAllEqual([0, 1, 2, 3, 0, 1, 2, 3],
+                        [e // 1000 for e in elements])
+    # The repeated input elements were read from the cache.
+    self.assertAllEqual(elements[:4], elements[4:])
+    self.assertEqual(4, len(os.listdir(self.cache_dir)))
+
+    # A second pipeline, e.g. in another process, shares the results.
+    self.assertAllEqual(elements, self._readAll(self._noisyDataset(1 << 20)))
+
+  def testCachedMapCapacity(self):
+    # The cache has room for a single result.
+    elements = self._readAll(self._noisyDataset(40))
+    self.assertAllEqual([0, 1, 2, 3, 0, 1, 2, 3],
+                        [e // 1000 for e in elements])
+    self.assertEqual(1, len(os.listdir(self.cache_dir)))
+
+  def testCachedMapInvalidCapacity(self):
+    with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                 "greater than zero"):
+      self._readAll(self._noisyDataset(0))
+
+
 if __name__ == "__main__":
   test.main()
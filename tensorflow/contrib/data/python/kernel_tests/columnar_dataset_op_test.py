@@ -0,0 +1,141 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import subprocess
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.core.example import example_pb2
+from tensorflow.core.example import feature_pb2
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.lib.io import python_io
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import parsing_ops
+from tensorflow.python.platform import resource_loader
+from tensorflow.python.platform import test
+from tensorflow.python.util import compat
+
+
+class ColumnarDatasetTest(test.TestCase):
+
+  def _record(self, f, r):
+    return example_pb2.Example(features=feature_pb2.Features(feature={
+        "id": feature_pb2.Feature(int64_list=feature_pb2.Int64List(
+            value=[f, r])),
+        "words": feature_pb2.Feature(bytes_list=feature_pb2.BytesList(
+            value=[compat.as_bytes("w%d" % i) for i in range(r)])),
+        "weight": feature_pb2.Feature(float_list=feature_pb2.FloatList(
+            value=[float(r)])),
+    })).SerializeToString()
+
+  def _createFiles(self, num_files, num_records, rows_per_chunk):
+    converter = os.path.join(
+        resource_loader.get_root_dir_with_all_resources(),
+        "tensorflow/core/util/columnar/columnar_converter")
+    filenames = []
+    for i in range(num_files):
+      record_fn = os.path.join(self.get_temp_dir(), "columnar.%d.tfrecord" % i)
+      writer = python_io.TFRecordWriter(record_fn)
+      for j in range(num_records):
+        writer.write(self._record(i, j))
+      writer.close()
+      fn = os.path.join(self.get_temp_dir(), "columnar.%d" % i)
+      subprocess.check_call([converter, "--input=" + record_fn,
+                             "--output=" + fn,
+                             "--rows_per_chunk=%d" % rows_per_chunk])
+      filenames.append(fn)
+    return filenames
+
+  def testColumnarDataset(self):
+    num_files = 2
+    num_records = 7
+    test_filenames = self._createFiles(num_files, num_records,
+                                       rows_per_chunk=3)
+    filenames = array_ops.placeholder(dtypes.string, shape=[None])
+    batch_size = array_ops.placeholder(dtypes.int64, shape=[])
+
+    dataset = dataset_ops.ColumnarDataset(
+        filenames, {
+            "id": parsing_ops.FixedLenFeature([2], dtypes.int64),
+            "words": parsing_ops.VarLenFeature(dtypes.string),
+        }, batch_size)
+    self.assertEqual([None, 2], dataset.output_shapes["id"].as_list())
+    self.assertEqual((dtypes.string, dtypes.int64),
+                     dataset.output_types["words"])
+
+    iterator = dataset.make_initializable_iterator()
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      # Batches of 2 rows, which sometimes span two chunks or two files.
+      sess.run(init_op, feed_dict={filenames: test_filenames, batch_size: 2})
+      all_rows = [(i, j) for i in range(num_files) for j in range(num_records)]
+      for b in range(0, len(all_rows), 2):
+        rows = all_rows[b:b + 2]
+        batch = sess.run(get_next)
+        self.assertAllEqual([[i, j] for i, j in rows], batch["id"])
+        values, row_splits = batch["words"]
+        self.assertEqual(len(rows) + 1, len(row_splits))
+        self.assertEqual(0, row_splits[0])
+        for k, (_, j) in enumerate(rows):
+          self.assertAllEqual(
+              [compat.as_bytes("w%d" % w) for w in range(j)],
+              values[row_splits[k]:row_splits[k + 1]])
+        self.assertEqual(len(values), row_splits[-1])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # The last batch holds the remaining rows.
+      sess.run(init_op, feed_dict={filenames: test_filenames[:1],
+                                   batch_size: 10})
+      self.assertAllEqual([[0, r] for r in range(num_records)],
+                          sess.run(get_next)["id"])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testColumnarDatasetShapeMismatch(self):
+    test_filenames = self._createFiles(1, 3, rows_per_chunk=3)
+    dataset = dataset_ops.ColumnarDataset(
+        test_filenames, {
+            "id": parsing_ops.FixedLenFeature([3], dtypes.int64),
+        }, 2)
+    get_next = dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+
+  def testUnsupportedFeature(self):
+    with self.assertRaises(ValueError):
+      dataset_ops.ColumnarDataset(
+          ["file"], {"id": parsing_ops.FixedLenFeature([None], dtypes.int64)},
+          1)
+    with self.assertRaises(ValueError):
+      dataset_ops.ColumnarDataset(
+          ["file"], {"id": parsing_ops.FixedLenFeature([], dtypes.int64, 0)},
+          1)
+    with self.assertRaises(ValueError):
+      dataset_ops.ColumnarDataset(
+          ["file"], {"id": parsing_ops.VarLenFeature(dtypes.int32)}, 1)
+
+
+if __name__ == "__main__":
+  test.main()
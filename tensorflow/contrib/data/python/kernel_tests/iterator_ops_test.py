@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import dataset_ops
@@ -26,11 +28,13 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
+from tensorflow.python.lib.io import python_io
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 from tensorflow.python.training import server_lib
+from tensorflow.python.util import compat
 
 
 class IteratorTest(test.TestCase):
@@ -328,6 +332,88 @@ class IteratorTest(test.TestCase):
               [1, 2, 3], dtype=dtypes.int64), constant_op.constant(
                   [4., 5., 6., 7.], dtype=dtypes.float64))))
 
+  def _testSaveRestore(self, make_dataset, num_outputs, num_before_save):
+    path = array_ops.placeholder(dtypes.string, shape=[])
+    iterator = make_dataset().make_initializable_iterator()
+    get_next = iterator.get_next()
+    save_op = iterator.save_op(path)
+    restore_op = iterator.restore_op(path)
+    prefix = os.path.join(self.get_temp_dir(), "iterator_%d" % num_before_save)
+
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for _ in range(num_before_save):
+        sess.run(get_next)
+      sess.run(save_op, feed_dict={path: prefix})
+      expected = [sess.run(get_next)
+                  for _ in range(num_outputs - num_before_save)]
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+    # Restore in a new session, as a restarted trainer would.
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      sess.run(restore_op, feed_dict={path: prefix})
+      for expected_element in expected:
+        self.assertAllEqual(expected_element, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testSaveRestoreRangeMapShuffleBatch(self):
+
+    def make_dataset():
+      return (dataset_ops.Dataset.range(100)
+              .map(lambda x: x * 3)
+              .shuffle(buffer_size=10, seed=37)
+              .batch(7))
+
+    for num_before_save in [0, 1, 5, 14, 15]:
+      self._testSaveRestore(make_dataset, 15, num_before_save)
+
+  def testSaveRestoreShuffleWithRandomSeed(self):
+
+    def make_dataset():
+      return dataset_ops.Dataset.range(20).shuffle(buffer_size=5)
+
+    for num_before_save in [0, 3, 17, 20]:
+      self._testSaveRestore(make_dataset, 20, num_before_save)
+
+  def testSaveRestoreTFRecord(self):
+    filenames = []
+    for i in range(3):
+      filename = os.path.join(self.get_temp_dir(), "save_restore.%d.txt" % i)
+      filenames.append(filename)
+      writer = python_io.TFRecordWriter(filename)
+      for j in range(100):
+        writer.write(compat.as_bytes("Record %d of file %d" % (j, i)))
+      writer.close()
+
+    def make_dataset():
+      return dataset_ops.TFRecordDataset(filenames).shuffle(50, seed=11)
+
+    for num_before_save in [0, 63, 64, 99, 100, 230, 300]:
+      self._testSaveRestore(make_dataset, 300, num_before_save)
+
+  def testSaveUnsupportedDataset(self):
+    iterator = (dataset_ops.Dataset.from_tensors(0).repeat()
+                .make_initializable_iterator())
+    save_op = iterator.save_op(os.path.join(self.get_temp_dir(), "iterator"))
+
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      with self.assertRaisesRegexp(errors.UnimplementedError,
+                                   "Saving the state of this iterator"):
+        sess.run(save_op)
+
+  def testRestoreUninitializedIterator(self):
+    iterator = dataset_ops.Dataset.range(10).make_initializable_iterator()
+    restore_op = iterator.restore_op(
+        os.path.join(self.get_temp_dir(), "iterator"))
+
+    with self.test_session() as sess:
+      with self.assertRaises(errors.FailedPreconditionError):
+        sess.run(restore_op)
+
 
 if __name__ == "__main__":
   test.main()
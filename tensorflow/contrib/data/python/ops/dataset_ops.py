@@ -261,6 +261,45 @@ class Iterator(object):
     """
     return gen_dataset_ops.iterator_dispose(self._iterator_resource, name=name)
 
+  def save_op(self, path, name=None):
+    """Returns a `tf.Operation` that saves the position of this iterator.
+
+    The position is written as a tensor bundle with the path prefix `path`,
+    and can be restored with `Iterator.restore_op()` on an iterator that has
+    been initialized on a dataset with the same definition. Saving is
+    supported for iterators over datasets built from `Dataset.range()`,
+    `TFRecordDataset`, `Dataset.map()`, `Dataset.shuffle()` and
+    `Dataset.batch()`.
+
+    Args:
+      path: A `tf.string` scalar `tf.Tensor`, the path prefix of the saved
+        state.
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A `tf.Operation`.
+    """
+    path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
+    return gen_dataset_ops.save_iterator(self._iterator_resource, path,
+                                         name=name)
+
+  def restore_op(self, path, name=None):
+    """Returns a `tf.Operation` that restores the position of this iterator.
+
+    The iterator must be initialized before the returned operation runs.
+
+    Args:
+      path: A `tf.string` scalar `tf.Tensor`, the path prefix of state saved
+        by `Iterator.save_op()`.
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A `tf.Operation`.
+    """
+    path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
+    return gen_dataset_ops.restore_iterator(self._iterator_resource, path,
+                                            name=name)
+
   @property
   def output_shapes(self):
     """Returns the shape of each component of an element of this iterator.
@@ -694,6 +733,22 @@ class Dataset(object):
     """
     return CacheDataset(self, filename)
 
+  def prefetch(self, buffer_size):
+    """Creates a `Dataset` that prefetches elements from this dataset.
+
+    A background thread reads elements from this dataset into a buffer of at
+    most `buffer_size` elements, so that producing the next element overlaps
+    with the consumer's processing of the current one.
+
+    Args:
+      buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
+        maximum number of elements that will be buffered when prefetching.
+
+    Returns:
+      A `Dataset`.
+    """
+    return PrefetchDataset(self, buffer_size)
+
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
 
@@ -830,6 +885,52 @@ class Dataset(object):
     """
     return GroupByWindowDataset(self, key_func, reduce_func, window_size)
 
+  def bucket_by_token_budget(self, length_func, token_budget,
+                             bucket_boundaries, padded_shapes=None,
+                             padding_values=None):
+    """Batches elements of similar length so that each batch fits a budget.
+
+    This method assigns each element of this dataset to a bucket by its
+    length, as computed by `length_func`, so that the elements of a batch
+    need little padding. Instead of having a fixed size, a batch is emitted
+    when `batch_size * max_length`, its number of tokens after padding, would
+    otherwise exceed `token_budget`. This keeps the memory used by each batch
+    about constant: batches of short elements are large, and batches of long
+    elements are small. An element that is longer than `token_budget` is
+    emitted in a batch of its own.
+
+    Each element of the resulting dataset is a pair `(batch, (num_tokens,
+    num_padded_tokens))`, where `batch` is padded as by
+    `Dataset.padded_batch()`, `num_tokens` is the sum of the lengths of its
+    elements and `num_padded_tokens` is `batch_size * max_length`, so that
+    `num_tokens / num_padded_tokens` is the padding efficiency of the batch.
+
+    Args:
+      length_func: A function mapping a nested structure of tensors (having
+        shapes and types defined by `self.output_shapes` and
+        `self.output_types`) to a non-negative scalar `tf.int64` tensor,
+        typically the number of tokens in the element.
+      token_budget: A `tf.int64` scalar `tf.Tensor`, representing the maximum
+        number of tokens, including padding, in a batch.
+      bucket_boundaries: A `tf.int64` vector `tf.Tensor` of increasing
+        lengths. Bucket `i` holds the elements whose length is at least
+        `bucket_boundaries[i - 1]` and less than `bucket_boundaries[i]`.
+      padded_shapes: (Optional.) A nested structure of `tf.TensorShape` or
+        `tf.int64` vector tensor-like objects, as for `Dataset.padded_batch()`.
+        Defaults to `self.output_shapes`, which pads every unknown dimension to
+        the maximum size of that dimension in each batch.
+      padding_values: (Optional.) A nested structure of scalar-shaped
+        `tf.Tensor`, representing the padding values to use for the
+        respective components.  Defaults are `0` for numeric types and
+        the empty string for string types.
+
+    Returns:
+      A `Dataset`.
+    """
+    return BucketByTokenBudgetDataset(self, length_func, token_budget,
+                                      bucket_boundaries, padded_shapes,
+                                      padding_values)
+
   def map(self, map_func, num_threads=None, output_buffer_size=None):
     """Maps `map_func` across this datset.
 
@@ -850,6 +951,36 @@ class Dataset(object):
     """
     return MapDataset(self, map_func, num_threads, output_buffer_size)
 
+  def cached_map(self, map_func, cache_directory, cache_capacity_bytes):
+    """Maps `map_func` across this dataset, caching the results on disk.
+
+    The results are keyed by a fingerprint of `map_func` and of each input
+    element, so an input element that is seen again, e.g. in a later epoch, is
+    read from the cache instead of being recomputed. When the cache grows
+    beyond `cache_capacity_bytes`, the least recently used results are
+    deleted.
+
+    Several processes may share `cache_directory` and read it concurrently.
+    Putting it on a local SSD or on a tmpfs such as `/dev/shm` lets the
+    training processes on a host share e.g. decoded and resized images, so
+    that only the first of them pays for decoding each image.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having
+        shapes and types defined by `self.output_shapes` and
+        `self.output_types`) to another nested structure of tensors. Its
+        results must depend only on its arguments.
+      cache_directory: A `tf.string` scalar `tf.Tensor`, representing the name
+        of the directory in which to cache the results of `map_func`.
+      cache_capacity_bytes: A `tf.int64` scalar `tf.Tensor`, representing the
+        approximate maximum total size of the cached results.
+
+    Returns:
+      A `Dataset`.
+    """
+    return CachedMapDataset(self, map_func, cache_directory,
+                            cache_capacity_bytes)
+
   def flat_map(self, map_func):
     """Maps `map_func` across this dataset and flattens the result.
 
@@ -863,6 +994,39 @@ class Dataset(object):
     """
     return FlatMapDataset(self, map_func)
 
+  def parallel_interleave(self, map_func, cycle_length, block_length=1,
+                          buffer_output_elements=None):
+    """Maps `map_func` across this dataset, and interleaves the results.
+
+    Like `flat_map()`, but keeps `cycle_length` of the datasets returned by
+    `map_func` open at once, and takes `block_length` consecutive elements
+    from each of them in turn. Each open dataset is read by a background
+    thread, which buffers up to `buffer_output_elements` elements ahead of
+    the consumer. The order of the produced elements is deterministic.
+
+    For example, if `cycle_length` is 2 and `block_length` is 1, and the
+    input elements are mapped to datasets `[a0, a1, a2]` and `[b0, b1]`, the
+    result is `[a0, b0, a1, b1, a2]`.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having shapes
+        and types defined by `self.output_shapes` and `self.output_types`) to a
+        `Dataset`.
+      cycle_length: A `tf.int64` scalar `tf.Tensor`, representing the number of
+        input elements that will be processed concurrently.
+      block_length: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing
+        the number of consecutive elements to take from each input element
+        before moving on to the next one.
+      buffer_output_elements: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+        representing the number of elements that each background thread will
+        buffer. Defaults to `block_length`.
+
+    Returns:
+      A `Dataset`.
+    """
+    return ParallelInterleaveDataset(self, map_func, cycle_length, block_length,
+                                     buffer_output_elements)
+
   def unbatch(self):
     """Splits elements of this dataset into sequences of consecutive elements.
 
@@ -1116,6 +1280,32 @@ class CacheDataset(Dataset):
     return self._input_dataset.output_types
 
 
+class PrefetchDataset(Dataset):
+  """A `Dataset` that asynchronously prefetches its input."""
+
+  def __init__(self, input_dataset, buffer_size):
+    """See `Dataset.prefetch()` for details."""
+    super(PrefetchDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.prefetch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        buffer_size=self._buffer_size,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
 class ShuffleDataset(Dataset):
   """A `Dataset` that randomly shuffles the elements of its input."""
 
@@ -1323,6 +1513,68 @@ class PaddedBatchDataset(Dataset):
     return self._input_dataset.output_types
 
 
+class BucketByTokenBudgetDataset(PaddedBatchDataset):
+  """A `Dataset` that batches elements of similar length up to a budget."""
+
+  def __init__(self, input_dataset, length_func, token_budget,
+               bucket_boundaries, padded_shapes, padding_values):
+    """See `Dataset.bucket_by_token_budget()` for details."""
+    if padded_shapes is None:
+      padded_shapes = input_dataset.output_shapes
+      for shape in nest.flatten(padded_shapes):
+        if shape.ndims is None:
+          raise ValueError("`padded_shapes` must be given when the input has "
+                           "components of unknown rank.")
+    super(BucketByTokenBudgetDataset, self).__init__(
+        input_dataset, None, padded_shapes, padding_values)
+    self._token_budget = ops.convert_to_tensor(
+        token_budget, dtype=dtypes.int64, name="token_budget")
+    self._bucket_boundaries = ops.convert_to_tensor(
+        bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries")
+
+    @function.Defun(*nest.flatten(input_dataset.output_types))
+    def tf_length_func(*args):
+      """A wrapper for Defun that facilitates shape inference."""
+      # Pass in shape information from the input_dataset.
+      for arg, shape in zip(args, nest.flatten(input_dataset.output_shapes)):
+        arg.set_shape(shape)
+      nested_args = nest.pack_sequence_as(input_dataset.output_types, args)
+      if nest.is_sequence(nested_args):
+        ret = length_func(*nested_args)
+      else:
+        ret = length_func(nested_args)
+      ret = ops.convert_to_tensor(ret, dtype=dtypes.int64)
+      if ret.dtype != dtypes.int64:
+        raise ValueError("`length_func` must return a single tf.int64 tensor.")
+      return ret
+
+    self._length_func = tf_length_func
+    self._length_func.add_to_graph(ops.get_default_graph())
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.bucket_by_token_budget_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._length_func.captured_inputs,
+        self._token_budget,
+        self._bucket_boundaries,
+        padded_shapes=[
+            ops.convert_to_tensor(s, dtype=dtypes.int64)
+            for s in nest.flatten(self._padded_shapes)
+        ],
+        padding_values=nest.flatten(self._padding_values),
+        length_func=self._length_func,
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    return (super(BucketByTokenBudgetDataset, self).output_shapes,
+            (tensor_shape.scalar(), tensor_shape.scalar()))
+
+  @property
+  def output_types(self):
+    return (self._input_dataset.output_types, (dtypes.int64, dtypes.int64))
+
+
 class DenseToSparseBatchDataset(Dataset):
   """A `Dataset` that batches ragged dense elements into `tf.SparseTensor`s."""
 
@@ -1540,6 +1792,29 @@ class MapDataset(Dataset):
     return self._output_types
 
 
+class CachedMapDataset(MapDataset):
+  """A `Dataset` that maps a function over its input and caches the results."""
+
+  def __init__(self, input_dataset, map_func, cache_directory,
+               cache_capacity_bytes):
+    """See `Dataset.cached_map()` for details."""
+    super(CachedMapDataset, self).__init__(input_dataset, map_func)
+    self._cache_directory = ops.convert_to_tensor(
+        cache_directory, dtype=dtypes.string, name="cache_directory")
+    self._cache_capacity_bytes = ops.convert_to_tensor(
+        cache_capacity_bytes, dtype=dtypes.int64, name="cache_capacity_bytes")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.cached_map_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        cache_directory=self._cache_directory,
+        cache_capacity_bytes=self._cache_capacity_bytes,
+        f=self._map_func,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+
 class FlatMapDataset(Dataset):
   """A `Dataset` that maps a function over its input and flattens the result."""
 
@@ -1592,6 +1867,37 @@ class FlatMapDataset(Dataset):
     return self._output_types
 
 
+class ParallelInterleaveDataset(FlatMapDataset):
+  """A `Dataset` that maps a function over its input and interleaves the result.
+  """
+
+  def __init__(self, input_dataset, map_func, cycle_length, block_length,
+               buffer_output_elements):
+    """See `Dataset.parallel_interleave()` for details."""
+    super(ParallelInterleaveDataset, self).__init__(input_dataset, map_func)
+    self._cycle_length = ops.convert_to_tensor(
+        cycle_length, dtype=dtypes.int64, name="cycle_length")
+    self._block_length = ops.convert_to_tensor(
+        block_length, dtype=dtypes.int64, name="block_length")
+    if buffer_output_elements is None:
+      self._buffer_output_elements = self._block_length
+    else:
+      self._buffer_output_elements = ops.convert_to_tensor(
+          buffer_output_elements, dtype=dtypes.int64,
+          name="buffer_output_elements")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.parallel_interleave_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        self._cycle_length,
+        self._block_length,
+        self._buffer_output_elements,
+        f=self._map_func,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+
 class FilterDataset(Dataset):
   """A `Dataset` that filters its input according to a predicate function."""
 
@@ -1675,7 +1981,7 @@ class TFRecordDataset(Dataset):
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: A `tf.string` scalar evaluating to one of `""` (no
-        compression), `"ZLIB"`, or `"GZIP"`.
+        compression), `"ZLIB"`, `"GZIP"`, or `"BLOCK_ZLIB"`.
     """
     super(TFRecordDataset, self).__init__()
     self._filenames = ops.convert_to_tensor(filenames, name="filenames")
@@ -1698,6 +2004,91 @@ class TFRecordDataset(Dataset):
     return dtypes.string
 
 
+class ColumnarDataset(Dataset):
+  """A `Dataset` of batches of rows from one or more columnar files.
+
+  Columnar files store each feature of a set of `tf.Example`s as a separate
+  memory-mapped column, so reading a batch of features needs neither parsing
+  nor, within a chunk of the file, a copy. Only the features named in
+  `features` are read. TFRecord files are converted with the
+  `//tensorflow/core/util/columnar:columnar_converter` tool.
+  """
+
+  def __init__(self, filenames, features, batch_size):
+    """Creates a `ColumnarDataset`.
+
+    Each element is a `dict` mapping the keys of `features` to the batch of
+    that feature, which holds at most `batch_size` rows. The batch of a
+    `FixedLenFeature` with shape `S` is a `Tensor` of shape `[B] + S`. The
+    batch of a `VarLenFeature` is a `(values, row_splits)` tuple of vectors,
+    where the values of row `r` are `values[row_splits[r]:row_splits[r + 1]]`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      features: A `dict` mapping feature keys to `FixedLenFeature` or
+        `VarLenFeature` values. Every row of a `FixedLenFeature` must have
+        exactly as many values as its fully defined shape; default values are
+        not supported.
+      batch_size: A `tf.int64` scalar representing the maximum number of rows
+        per batch.
+
+    Raises:
+      ValueError: If `features` contains an unsupported feature.
+    """
+    super(ColumnarDataset, self).__init__()
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._dense_keys = []
+    self._dense_shapes = []
+    self._ragged_keys = []
+    self._output_types = {}
+    self._output_shapes = {}
+    batch_dim = tensor_shape.TensorShape([None])
+    for key, feature in sorted(features.items()):
+      if feature.dtype not in (dtypes.float32, dtypes.int64, dtypes.string):
+        raise ValueError("Unsupported dtype %s of feature %s." %
+                         (feature.dtype, key))
+      if isinstance(feature, parsing_ops.FixedLenFeature):
+        shape = tensor_shape.as_shape(feature.shape)
+        if not shape.is_fully_defined():
+          raise ValueError("The shape of feature %s must be fully defined, "
+                           "got %s." % (key, shape))
+        if feature.default_value is not None:
+          raise ValueError("Feature %s has a default value, which is not "
+                           "supported." % key)
+        self._dense_keys.append(key)
+        self._dense_shapes.append(shape)
+        self._output_types[key] = feature.dtype
+        self._output_shapes[key] = batch_dim.concatenate(shape)
+      elif isinstance(feature, parsing_ops.VarLenFeature):
+        self._ragged_keys.append(key)
+        self._output_types[key] = (feature.dtype, dtypes.int64)
+        self._output_shapes[key] = (batch_dim, batch_dim)
+      else:
+        raise ValueError("Unsupported feature %s of type %s." %
+                         (key, type(feature).__name__))
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.columnar_dataset(
+        self._filenames,
+        self._batch_size,
+        dense_keys=self._dense_keys,
+        dense_shapes=self._dense_shapes,
+        ragged_keys=self._ragged_keys,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    return self._output_types
+
+
 class FixedLengthRecordDataset(Dataset):
   """A `Dataset` of fixed-length records from one or more binary files."""
 
@@ -34,6 +34,8 @@
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -56,6 +58,11 @@ const int64 kDefaultL3CachePerCpu = 1 << 20;
 const int64 kNearestNeighborsCentersMaxBlockSize = 1024;
 const int64 kNearestNeighborsPointsMinBlockSize = 16;
 
+// The approximate search of NearestNeighborsOp is only used if there are at
+// least this many centers per coarse center. With fewer centers, searching
+// the lists of the nearest coarse centers saves little over an exact search.
+const int64 kNearestNeighborsMinCentersPerCoarseCenter = 8;
+
 // Returns the smallest multiple of a that is not smaller than b.
 int64 NextMultiple(int64 a, int64 b) {
   const int64 remainder = b % a;
@@ -232,6 +239,9 @@ class NearestNeighborsOp : public OpKernel {
     OP_REQUIRES_OK(context,
                    context->MatchSignature({DT_FLOAT, DT_FLOAT, DT_INT64},
                                            {DT_INT64, DT_FLOAT}));
+    OP_REQUIRES_OK(
+        context, context->GetAttr("num_coarse_centers", &num_coarse_centers_));
+    OP_REQUIRES_OK(context, context->GetAttr("num_probes", &num_probes_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -282,8 +292,24 @@ class NearestNeighborsOp : public OpKernel {
         output_nearest_center_distances_tensor->matrix<float>().data(),
         num_points, k);
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 num_threads = worker_threads.num_threads;
+
+    // With many centers, only the centers in the lists of the coarse centers
+    // nearest to a point are searched. The lists are kept in index_, which is
+    // updated with the centers that changed since the previous step.
+    const bool approximate =
+        num_coarse_centers_ > 0 &&
+        num_centers >=
+            num_coarse_centers_ * kNearestNeighborsMinCentersPerCoarseCenter;
+    std::unique_ptr<mutex_lock> index_lock;
+    if (approximate) {
+      index_lock.reset(new mutex_lock(mu_));
+      UpdateCenterIndex(context, centers);
+    }
     const Eigen::VectorXf centers_half_squared_norm =
-        0.5 * centers.rowwise().squaredNorm();
+        approximate ? Eigen::VectorXf()
+                    : Eigen::VectorXf(0.5 * centers.rowwise().squaredNorm());
 
     // The distance computation is sharded to take advantage of multiple cores
     // and to allow intermediate values to reside in L3 cache. This is done by
@@ -298,8 +324,6 @@ class NearestNeighborsOp : public OpKernel {
     // 3. After performing each block-block distance computation, the results
     //    are reduced to a set of k nearest centers as soon as possible. This
     //    decreases total memory I/O.
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    const int64 num_threads = worker_threads.num_threads;
     // This kernel might be configured to use fewer than the total number of
     // available CPUs on the host machine. To avoid descructive interference
     // with other jobs running on the host machine, we must only use a fraction
@@ -348,10 +372,17 @@ class NearestNeighborsOp : public OpKernel {
             nearest_center_indices.middleRows(start_row, num_rows);
         auto nearest_center_distances_shard =
             nearest_center_distances.middleRows(start_row, num_rows);
-        FindKNearestCenters(k, points_shard, points_half_squared_norm, centers,
-                            centers_half_squared_norm,
-                            nearest_center_indices_shard,
-                            nearest_center_distances_shard);
+        if (approximate) {
+          FindApproximateKNearestCenters(k, points_shard,
+                                         points_half_squared_norm,
+                                         nearest_center_indices_shard,
+                                         nearest_center_distances_shard);
+        } else {
+          FindKNearestCenters(k, points_shard, points_half_squared_norm,
+                              centers, centers_half_squared_norm,
+                              nearest_center_indices_shard,
+                              nearest_center_distances_shard);
+        }
       }
     };
 
@@ -370,6 +401,157 @@ class NearestNeighborsOp : public OpKernel {
   }
 
  private:
+  // An inverted file index over the centers. Each center is in the list of
+  // its nearest coarse center, and the coarse centers are a strided sample of
+  // the centers that the index was built for.
+  struct CenterIndex {
+    // A copy of the indexed centers, used to find the changed centers.
+    MatrixXfRowMajor centers;
+    Eigen::VectorXf centers_half_squared_norm;
+    MatrixXfRowMajor coarse_centers;
+    Eigen::VectorXf coarse_centers_half_squared_norm;
+    // The centers in the list of each coarse center.
+    std::vector<std::vector<int64>> lists;
+    // The list of each center and its position in that list.
+    std::vector<int64> list_ids;
+    std::vector<int64> list_positions;
+  };
+
+  // Updates index_ to index "centers". Only the centers that changed since
+  // the previous update are reassigned to lists, which for mini-batch k-means
+  // are the centers of the points of the previous mini-batch. The index is
+  // rebuilt when the shape of the centers changes. Caller must hold mu_.
+  void UpdateCenterIndex(OpKernelContext* context,
+                         const Eigen::Ref<const MatrixXfRowMajor>& centers) {
+    const int64 num_centers = centers.rows();
+    const int64 center_dimensions = centers.cols();
+    std::vector<int64> changed;
+    if (index_.centers.rows() != num_centers ||
+        index_.centers.cols() != center_dimensions) {
+      const int64 num_coarse_centers = num_coarse_centers_;
+      index_.coarse_centers.resize(num_coarse_centers, center_dimensions);
+      for (int64 i = 0; i < num_coarse_centers; ++i) {
+        index_.coarse_centers.row(i) =
+            centers.row(i * num_centers / num_coarse_centers);
+      }
+      index_.coarse_centers_half_squared_norm =
+          0.5 * index_.coarse_centers.rowwise().squaredNorm();
+      index_.centers = centers;
+      index_.centers_half_squared_norm = 0.5 * centers.rowwise().squaredNorm();
+      index_.lists.assign(num_coarse_centers, std::vector<int64>());
+      index_.list_ids.assign(num_centers, -1);
+      index_.list_positions.assign(num_centers, -1);
+      changed.resize(num_centers);
+      std::iota(changed.begin(), changed.end(), 0);
+    } else {
+      for (int64 i = 0; i < num_centers; ++i) {
+        if (index_.centers.row(i) != centers.row(i)) {
+          index_.centers.row(i) = centers.row(i);
+          index_.centers_half_squared_norm(i) =
+              0.5 * centers.row(i).squaredNorm();
+          changed.push_back(i);
+        }
+      }
+    }
+    if (changed.empty()) return;
+
+    // Find the nearest coarse center of each changed center.
+    const int64 num_changed = changed.size();
+    MatrixXi64RowMajor list_ids(num_changed, 1);
+    MatrixXfRowMajor list_distances(num_changed, 1);
+    auto assign = [&](int64 start, int64 limit) {
+      MatrixXfRowMajor changed_centers(limit - start, center_dimensions);
+      for (int64 i = start; i < limit; ++i) {
+        changed_centers.row(i - start) = index_.centers.row(changed[i]);
+      }
+      const Eigen::VectorXf changed_centers_half_squared_norm =
+          0.5 * changed_centers.rowwise().squaredNorm();
+      auto list_ids_shard = list_ids.middleRows(start, limit - start);
+      auto list_distances_shard =
+          list_distances.middleRows(start, limit - start);
+      FindKNearestCenters(1, changed_centers,
+                          changed_centers_half_squared_norm,
+                          index_.coarse_centers,
+                          index_.coarse_centers_half_squared_norm,
+                          list_ids_shard, list_distances_shard);
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_changed,
+          index_.coarse_centers.size(), assign);
+
+    for (int64 i = 0; i < num_changed; ++i) {
+      const int64 center = changed[i];
+      const int64 new_list_id = list_ids(i, 0);
+      const int64 old_list_id = index_.list_ids[center];
+      if (old_list_id == new_list_id) continue;
+      if (old_list_id >= 0) {
+        std::vector<int64>& old_list = index_.lists[old_list_id];
+        const int64 position = index_.list_positions[center];
+        old_list[position] = old_list.back();
+        index_.list_positions[old_list[position]] = position;
+        old_list.pop_back();
+      }
+      std::vector<int64>& new_list = index_.lists[new_list_id];
+      index_.list_ids[center] = new_list_id;
+      index_.list_positions[center] = new_list.size();
+      new_list.push_back(center);
+    }
+  }
+
+  // Finds the k nearest centers in the lists of the num_probes_ coarse
+  // centers nearest to each point. Points with fewer than k centers in those
+  // lists are searched exactly. Caller must hold mu_.
+  void FindApproximateKNearestCenters(
+      int64 k, const Eigen::Ref<const MatrixXfRowMajor>& points,
+      const Eigen::Ref<const Eigen::VectorXf>& points_half_squared_norm,
+      Eigen::Ref<MatrixXi64RowMajor> nearest_center_indices,
+      Eigen::Ref<MatrixXfRowMajor> nearest_center_distances) const {
+    const int64 num_points = points.rows();
+    const int64 num_probes =
+        std::min<int64>(num_probes_, index_.coarse_centers.rows());
+    MatrixXi64RowMajor probes(num_points, num_probes);
+    MatrixXfRowMajor probe_distances(num_points, num_probes);
+    FindKNearestCenters(num_probes, points, points_half_squared_norm,
+                        index_.coarse_centers,
+                        index_.coarse_centers_half_squared_norm, probes,
+                        probe_distances);
+    using Center = std::pair<float, int64>;
+    gtl::TopN<Center, std::less<Center>> selector(k);
+    std::unique_ptr<std::vector<Center>> nearest_centers;
+    for (int64 i = 0; i < num_points; ++i) {
+      for (int64 j = 0; j < num_probes; ++j) {
+        for (const int64 center : index_.lists[probes(i, j)]) {
+          const float partial_distance =
+              index_.centers_half_squared_norm(center) -
+              points.row(i).dot(index_.centers.row(center));
+          selector.push(Center(partial_distance, center));
+        }
+      }
+      if (selector.size() < k) {
+        selector.Reset();
+        auto point_nearest_center_indices =
+            nearest_center_indices.middleRows(i, 1);
+        auto point_nearest_center_distances =
+            nearest_center_distances.middleRows(i, 1);
+        FindKNearestCenters(k, points.middleRows(i, 1),
+                            points_half_squared_norm.segment(i, 1),
+                            index_.centers, index_.centers_half_squared_norm,
+                            point_nearest_center_indices,
+                            point_nearest_center_distances);
+        continue;
+      }
+      nearest_centers.reset(selector.Extract());
+      selector.Reset();
+      const float point_half_squared_norm = points_half_squared_norm(i);
+      for (int64 j = 0; j < k; ++j) {
+        const Center& center = (*nearest_centers)[j];
+        nearest_center_distances(i, j) =
+            2.0 * (point_half_squared_norm + center.first);
+        nearest_center_indices(i, j) = center.second;
+      }
+    }
+  }
+
   static void FindKNearestCenters(
       int64 k, const Eigen::Ref<const MatrixXfRowMajor>& points,
       const Eigen::Ref<const Eigen::VectorXf>& points_half_squared_norm,
@@ -515,6 +697,13 @@ class NearestNeighborsOp : public OpKernel {
       }
     }
   }
+
+  int64 num_coarse_centers_;
+  int64 num_probes_;
+  // The approximate search holds mu_ for the whole step, including while
+  // the worker threads read index_.
+  mutex mu_;
+  CenterIndex index_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("NearestNeighbors").Device(DEVICE_CPU),
@@ -117,7 +117,8 @@ RUN_BM_KmeansPlusPlusInitialization(k3RetriesPerSample);
 #undef BENCHMARK_KMEANS_PLUS_PLUS
 
 Graph* SetUpNearestNeighbors(int num_dims, int num_points, int num_centers,
-                             int k) {
+                             int k, int num_coarse_centers = 0,
+                             int num_probes = 1) {
   Graph* g = new Graph(OpRegistry::Global());
   Tensor points(DT_FLOAT, TensorShape({num_points, num_dims}));
   Tensor centers(DT_FLOAT, TensorShape({num_centers, num_dims}));
@@ -130,6 +131,8 @@ Graph* SetUpNearestNeighbors(int num_dims, int num_points, int num_centers,
                   .Input(test::graph::Constant(g, points))
                   .Input(test::graph::Constant(g, centers))
                   .Input(test::graph::Constant(g, top))
+                  .Attr("num_coarse_centers", num_coarse_centers)
+                  .Attr("num_probes", num_probes)
                   .Finalize(g, nullptr /* node */));
   return g;
 }
@@ -171,6 +174,43 @@ RUN_BM_NearestNeighbors(kTop5);
 RUN_BM_NearestNeighbors(kTop10);
 
 #undef RUN_BM_NearestNeighbors
+
+// The approximate search. The index is built in the first iteration, and the
+// centers don't change after that.
+template <int num_dims, int num_points, int num_centers, int k,
+          int num_coarse_centers, int num_probes>
+void BM_ApproximateNearestNeighbors(int iters) {
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_points);
+  testing::UseRealTime();
+  Graph* g = SetUpNearestNeighbors(num_dims, num_points, num_centers, k,
+                                   num_coarse_centers, num_probes);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+constexpr int k100kCenters = 100000;
+constexpr int k300CoarseCenters = 300;
+constexpr int k1kCoarseCenters = 1000;
+constexpr int k4Probes = 4;
+constexpr int k16Probes = 16;
+
+#define BENCHMARK_APPROXIMATE_NEAREST_NEIGHBORS(d, p, c, k, l, n)          \
+  void BM_ApproximateNearestNeighbors##d##_##p##_##c##_##k##_##l##_##n(    \
+      int iters) {                                                         \
+    BM_ApproximateNearestNeighbors<d, p, c, k, l, n>(iters);               \
+  }                                                                        \
+  BENCHMARK(BM_ApproximateNearestNeighbors##d##_##p##_##c##_##k##_##l##_##n);
+
+BENCHMARK_NEAREST_NEIGHBORS(k100Dim, k1kPoints, k100kCenters, kTop1);
+BENCHMARK_APPROXIMATE_NEAREST_NEIGHBORS(k100Dim, k1kPoints, k100kCenters,
+                                        kTop1, k300CoarseCenters, k4Probes);
+BENCHMARK_APPROXIMATE_NEAREST_NEIGHBORS(k100Dim, k1kPoints, k100kCenters,
+                                        kTop1, k300CoarseCenters, k16Probes);
+BENCHMARK_APPROXIMATE_NEAREST_NEIGHBORS(k100Dim, k1kPoints, k100kCenters,
+                                        kTop10, k1kCoarseCenters, k16Probes);
+
+#undef BENCHMARK_APPROXIMATE_NEAREST_NEIGHBORS
 #undef BENCHMARK_NEAREST_NEIGHBORS
 }  // namespace
 }  // namespace tensorflow
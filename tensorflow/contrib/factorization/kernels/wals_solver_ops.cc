@@ -20,9 +20,6 @@
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,7 +28,6 @@
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -58,6 +54,16 @@ typedef Eigen::Map<
     const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>>
     ConstEigenMatrixFloatMap;
 
+// The maximum number of rank-one updates that are batched into one rank-k
+// update.
+const int kMaxBatchSize = 128;
+
+// The minimum number of entries in a unit of work of
+// WALSComputePartialLhsAndRhsOp, and the number of units of work per thread
+// for large inputs.
+const int64 kMinEntriesPerBlock = 1024;
+const int64 kBlocksPerThread = 4;
+
 class WALSComputePartialLhsAndRhsOp : public OpKernel {
  public:
   explicit WALSComputePartialLhsAndRhsOp(OpKernelConstruction* context)
@@ -134,128 +140,110 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
       return is_transpose ? indices_mat(0, i) : indices_mat(1, i);
     };
 
-    // TODO(rmlarsen): In principle, we should be using the SparseTensor class
-    // and machinery for iterating over groups, but the fact that class
-    // SparseTensor makes a complete copy of the matrix makes me reluctant to
-    // use it.
+    // Group the entries by input index with a counting sort. The sort is
+    // stable, which preserves spatial locality within each group, and linear
+    // in the number of entries.
+    std::vector<int64> group_starts(block_size + 1, 0);
+    for (int64 i = 0; i < num_nonzero_elements; ++i) {
+      const int64 input_index = get_input_index(i);
+      OP_REQUIRES(context, input_index >= 0 && input_index < block_size,
+                  InvalidArgument("Input index ", input_index,
+                                  " out of range [0, ", block_size, ")."));
+      const int64 factor_index = get_factor_index(i);
+      OP_REQUIRES(context, factor_index >= 0 && factor_index < factors_size,
+                  InvalidArgument("Factor index ", factor_index,
+                                  " out of range [0, ", factors_size, ")."));
+      ++group_starts[input_index + 1];
+    }
+    std::partial_sum(group_starts.begin(), group_starts.end(),
+                     group_starts.begin());
     std::vector<int64> perm(num_nonzero_elements);
-    std::iota(perm.begin(), perm.end(), 0);
-
-    typedef std::pair<int64, int64> Shard;
-    std::vector<Shard> shards;
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    int64 shard_total = 0;
-    // Compute a permutation such that get_input_index(perm[i]) is sorted, use
-    // stable_sort to preserve spatial locality.
-    std::stable_sort(perm.begin(), perm.end(),
-                     [&get_input_index](int64 i, int64 j) {
-                       return get_input_index(i) < get_input_index(j);
-                     });
-
-    // Compute the start and end of runs with identical input_index.
-    // These are the shards of work that can be processed in parallel
-    // without locking.
-    int64 start = 0;
-    int64 end = 0;
-    while (end < num_nonzero_elements) {
-      start = end;
-      while (end < num_nonzero_elements &&
-             get_input_index(perm[start]) == get_input_index(perm[end])) {
-        ++end;
+    {
+      std::vector<int64> next(group_starts.begin(), group_starts.end() - 1);
+      for (int64 i = 0; i < num_nonzero_elements; ++i) {
+        perm[next[get_input_index(i)]++] = i;
       }
-      shards.emplace_back(start, end);
-      shard_total += end - start;
     }
-    CHECK_EQ(shard_total, num_nonzero_elements);
-    CHECK_LE(shards.size(), num_nonzero_elements);
-    CHECK_GT(shards.size(), 0);
-
-    // Batch the rank-one updates into a rank-k update to lower memory traffic
-    const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
-
-    BlockingCounter counter(shards.size());
-    // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
+    // Split the groups into contiguous blocks with roughly the same number of
+    // entries, a few blocks per thread. The blocks are the units of work that
+    // are processed in parallel without locking; scheduling one closure per
+    // group is too costly when most groups only have a few entries.
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 num_threads = worker_threads.num_threads;
+    const int64 min_block_entries = std::max<int64>(
+        kMinEntriesPerBlock,
+        (num_nonzero_elements + kBlocksPerThread * num_threads - 1) /
+            (kBlocksPerThread * num_threads));
+    typedef std::pair<int64, int64> Block;
+    std::vector<Block> blocks;
+    int64 block_start = 0;
+    for (int64 input_index = 0; input_index < block_size; ++input_index) {
+      if (group_starts[input_index + 1] - group_starts[block_start] >=
+              min_block_entries ||
+          input_index + 1 == block_size) {
+        blocks.emplace_back(block_start, input_index + 1);
+        block_start = input_index + 1;
       }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
-
-      CHECK_GE(shard.first, 0);
-      CHECK_LE(shard.second, perm.size());
-      CHECK_LE(shard.first, shard.second);
-      const int64 input_index = get_input_index(perm[shard.first]);
-      // Acccumulate the rhs and lhs terms in the normal equations
-      // for the non-zero elements in the row or column of the sparse matrix
-      // corresponding to input_index.
-      int num_batched = 0;
-      EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
-                                      input_index * factor_dim * factor_dim,
-                                  factor_dim, factor_dim);
-      auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
-      for (int64 p = shard.first; p < shard.second; ++p) {
-        const int64 i = perm[p];
-        // Check that all entries in the shard have the same input index.
-        CHECK_EQ(input_index, get_input_index(i));
-        const int64 factor_index = get_factor_index(i);
-        const float input_value = input_values_vec(i);
-        const float weight =
-            input_weights_vec(input_index) * factor_weights_vec(factor_index);
-        CHECK_GE(weight, 0);
-        factor_batch.col(num_batched) =
-            factors_mat.col(factor_index) * std::sqrt(weight);
-        ++num_batched;
-        if (num_batched == kMaxBatchSize) {
-          lhs_symm.rankUpdate(factor_batch);
-          num_batched = 0;
+    }
+    if (blocks.empty()) return;
+
+    // Lambda encapsulating the computation for the groups
+    // [block.first, block.second).
+    auto work = [&](const Block& block) {
+      // Batch the rank-one updates into a rank-k update to lower memory
+      // traffic.
+      Eigen::MatrixXf factor_batch(factor_dim, kMaxBatchSize);
+      for (int64 input_index = block.first; input_index < block.second;
+           ++input_index) {
+        const int64 group_start = group_starts[input_index];
+        const int64 group_end = group_starts[input_index + 1];
+        if (group_start == group_end) continue;
+        // Acccumulate the rhs and lhs terms in the normal equations
+        // for the non-zero elements in the row or column of the sparse matrix
+        // corresponding to input_index.
+        int num_batched = 0;
+        EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
+                                        input_index * factor_dim * factor_dim,
+                                    factor_dim, factor_dim);
+        auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
+        for (int64 p = group_start; p < group_end; ++p) {
+          const int64 i = perm[p];
+          const int64 factor_index = get_factor_index(i);
+          const float input_value = input_values_vec(i);
+          const float weight =
+              input_weights_vec(input_index) * factor_weights_vec(factor_index);
+          CHECK_GE(weight, 0);
+          factor_batch.col(num_batched) =
+              factors_mat.col(factor_index) * std::sqrt(weight);
+          ++num_batched;
+          if (num_batched == kMaxBatchSize) {
+            lhs_symm.rankUpdate(factor_batch);
+            num_batched = 0;
+          }
+
+          rhs_mat.col(input_index) +=
+              input_value * (w_0 + weight) * factors_mat.col(factor_index);
         }
-
-        rhs_mat.col(input_index) +=
-            input_value * (w_0 + weight) * factors_mat.col(factor_index);
-      }
-      if (num_batched != 0) {
-        auto factor_block =
-            factor_batch.block(0, 0, factors_mat.rows(), num_batched);
-        lhs_symm.rankUpdate(factor_block);
+        if (num_batched != 0) {
+          auto factor_block = factor_batch.block(0, 0, factor_dim, num_batched);
+          lhs_symm.rankUpdate(factor_block);
+        }
+        // Copy lower triangular to upper triangular part of normal equation
+        // matrix.
+        lhs_mat = lhs_symm;
       }
-      // Copy lower triangular to upper triangular part of normal equation
-      // matrix.
-      lhs_mat = lhs_symm;
-      counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
+    BlockingCounter counter(blocks.size() - 1);
+    for (size_t i = 1; i < blocks.size(); ++i) {
+      const Block block = blocks[i];
+      worker_threads.workers->Schedule([&work, &counter, block]() {
+        work(block);
+        counter.DecrementCount();
+      });
     }
-    // Inline execute the 1st shard.
-    work(shards[0]);
+    // Inline execute the 1st block.
+    work(blocks[0]);
     counter.Wait();
   }
 };
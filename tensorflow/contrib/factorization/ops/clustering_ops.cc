@@ -50,6 +50,8 @@ REGISTER_OP("NearestNeighbors")
     .Input("k: int64")
     .Output("nearest_center_indices: int64")
     .Output("nearest_center_distances: float32")
+    .Attr("num_coarse_centers: int >= 0 = 0")
+    .Attr("num_probes: int >= 1 = 1")
     .SetShapeFn(shape_inference::UnknownShape)
     .Doc(R"(
 Selects the k nearest centers for each point.
@@ -58,6 +60,15 @@ Rows of points are assumed to be input points. Rows of centers are assumed to be
 the list of candidate centers. For each point, the k centers that have least L2
 distance to it are computed.
 
+If num_coarse_centers is positive and there are at least 8 centers per coarse
+center, the search is approximate: the centers are put in an inverted file
+index, with each center in the list of its nearest coarse center, and only the
+lists of the num_probes coarse centers nearest to a point are searched. The
+coarse centers are sampled from the centers when the index is built. The index
+is kept between steps and only the centers that changed since the previous
+step are reassigned, as is the case for mini-batch k-means. Points with fewer
+than k centers in their lists are searched exactly.
+
 points: Matrix of shape (n, d). Rows are assumed to be input points.
 centers: Matrix of shape (m, d). Rows are assumed to be centers.
 k: Scalar. Number of nearest centers to return for each point. If k is larger
@@ -67,6 +78,10 @@ nearest_center_indices: Matrix of shape (n, min(m, k)). Each row contains the
   increasing distance.
 nearest_center_distances: Matrix of shape (n, min(m, k)). Each row contains the
   squared L2 distance to the corresponding center in nearest_center_indices.
+num_coarse_centers: The number of lists of the approximate search, or 0 for an
+  exact search.
+num_probes: The number of lists that are searched for each point by the
+  approximate search. More lists give a higher recall at a higher cost.
 )");
 
 }  // namespace tensorflow
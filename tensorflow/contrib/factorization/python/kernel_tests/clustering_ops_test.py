@@ -18,9 +18,15 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import time
+
 import numpy as np
 
 from tensorflow.contrib.factorization.python.ops import clustering_ops
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import test
 
 
@@ -143,6 +149,103 @@ class NearestCentersLargeTest(test.TestCase):
           self._expected_nearest_neighbor_squared_distances[:, 0:5])
 
 
+class NearestCentersApproximateTest(test.TestCase):
+
+  def setUp(self):
+    num_points = 100
+    num_centers = 1000
+    num_dim = 10
+    self._points = np.random.standard_normal(
+        [num_points, num_dim]).astype(np.float32)
+    self._centers = np.random.standard_normal(
+        [num_centers, num_dim]).astype(np.float32)
+
+  def _exact_nearest_neighbors(self, centers, k):
+    distances = np.sum(
+        (self._points[:, np.newaxis, :] - centers[np.newaxis, :, :])**2,
+        axis=2)
+    indices = np.argsort(distances, axis=1)[:, :k]
+    return indices, np.take(distances, indices + np.arange(
+        len(self._points))[:, np.newaxis] * len(centers))
+
+  def testAllListsProbedIsExact(self):
+    with self.test_session():
+      [indices, distances] = clustering_ops.nearest_neighbors(
+          self._points, self._centers, 3, num_coarse_centers=10,
+          num_probes=10)
+      expected_indices, expected_distances = self._exact_nearest_neighbors(
+          self._centers, 3)
+      self.assertAllEqual(indices.eval(), expected_indices)
+      self.assertAllClose(distances.eval(), expected_distances, rtol=1e-4)
+
+  def testRecall(self):
+    with self.test_session():
+      [indices, distances] = clustering_ops.nearest_neighbors(
+          self._points, self._centers, 1, num_coarse_centers=10,
+          num_probes=3)
+      expected_indices, _ = self._exact_nearest_neighbors(self._centers, 1)
+      indices = indices.eval()
+      distances = distances.eval()
+      self.assertGreater(np.mean(indices == expected_indices), 0.5)
+      # The distances are exact for the centers that were found.
+      self.assertAllClose(
+          distances[:, 0],
+          np.sum((self._points - self._centers[indices[:, 0]])**2, axis=1),
+          rtol=1e-4)
+
+  def testChangedCenters(self):
+    with self.test_session() as sess:
+      centers = array_ops.placeholder(dtypes.float32, shape=[None, None])
+      [indices, _] = clustering_ops.nearest_neighbors(
+          self._points, centers, 1, num_coarse_centers=10, num_probes=10)
+      sess.run(indices, feed_dict={centers: self._centers})
+      # Move some centers onto points, as a mini-batch update would.
+      new_centers = self._centers.copy()
+      new_centers[:20] = self._points[:20]
+      expected_indices, _ = self._exact_nearest_neighbors(new_centers, 1)
+      self.assertAllEqual(
+          sess.run(indices, feed_dict={centers: new_centers}),
+          expected_indices)
+
+
+class NearestNeighborsBenchmark(test.Benchmark):
+  """Compares the speed and recall of exact and approximate search."""
+
+  def _run(self, num_points, num_centers, num_dim, num_coarse_centers,
+           num_probes, num_iters=5):
+    points = np.random.standard_normal(
+        [num_points, num_dim]).astype(np.float32)
+    centers = np.random.standard_normal(
+        [num_centers, num_dim]).astype(np.float32)
+    with ops.Graph().as_default(), session_lib.Session() as session:
+      points_ph = array_ops.placeholder(dtypes.float32)
+      centers_ph = array_ops.placeholder(dtypes.float32)
+      exact_indices, _ = clustering_ops.nearest_neighbors(
+          points_ph, centers_ph, 1)
+      indices, _ = clustering_ops.nearest_neighbors(
+          points_ph, centers_ph, 1, num_coarse_centers=num_coarse_centers,
+          num_probes=num_probes)
+      feed_dict = {points_ph: points, centers_ph: centers}
+      expected = session.run(exact_indices, feed_dict=feed_dict)
+      # The first step builds the index.
+      session.run(indices, feed_dict=feed_dict)
+      start_time = time.time()
+      for _ in range(num_iters):
+        found = session.run(indices, feed_dict=feed_dict)
+      wall_time = (time.time() - start_time) / num_iters
+      recall = np.mean(found == expected)
+    name = "nearest_neighbors_%d_%d_%d_coarse_%d_probes_%d" % (
+        num_points, num_centers, num_dim, num_coarse_centers, num_probes)
+    self.report_benchmark(
+        name=name, iters=num_iters, wall_time=wall_time,
+        extras={"recall": recall})
+
+  def benchmarkNearestNeighbors(self):
+    for num_coarse_centers, num_probes in [(0, 1), (300, 4), (300, 16),
+                                           (1000, 8), (1000, 32)]:
+      self._run(1000, 100000, 32, num_coarse_centers, num_probes)
+
+
 if __name__ == "__main__":
   np.random.seed(0)
   test.main()
@@ -0,0 +1,114 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Benchmark for wals_solver_ops."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import time
+
+import numpy as np
+
+from tensorflow.contrib.factorization.python.ops import gen_factorization_ops
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+
+class WalsSolverBenchmark(test.Benchmark):
+  """Benchmark wals_compute_partial_lhs_and_rhs."""
+
+  def _make_sparse_input(self, num_rows, num_cols, avg_row_length):
+    """Creates the indices and values of a sparse input block.
+
+    Args:
+      num_rows: int, the number of rows of the block.
+      num_cols: int, the number of columns of the block.
+      avg_row_length: int, the average number of entries in a row.
+    Returns:
+      The indices and values of the entries. The row lengths follow a
+      power-law distribution, as is typical for ratings and interactions, and
+      the columns are drawn uniformly at random.
+    """
+    row_lengths = np.random.zipf(1.7, size=num_rows).astype(np.float64)
+    row_lengths *= avg_row_length / np.mean(row_lengths)
+    row_lengths = np.minimum(np.maximum(row_lengths.astype(np.int64), 1),
+                             num_cols)
+    rows = np.repeat(np.arange(num_rows, dtype=np.int64), row_lengths)
+    cols = np.random.randint(0, num_cols, size=len(rows)).astype(np.int64)
+    indices = np.stack([rows, cols], axis=1)
+    np.random.shuffle(indices)
+    values = np.random.uniform(size=len(rows)).astype(np.float32)
+    return indices, values
+
+  def _run_graph(self, num_rows, num_cols, avg_row_length, factor_dim,
+                 num_iters):
+    """Run the graph and return its average execution time.
+
+    Args:
+      num_rows: int, the number of rows of the input block.
+      num_cols: int, the number of columns of the input, and of factors.
+      avg_row_length: int, the average number of entries in a row.
+      factor_dim: int, the dimension of the factors.
+      num_iters: int, the number of iterations to run (the output is the average
+        execution time, over num_iters).
+
+    Returns:
+      The average duration of the op in seconds.
+    """
+    indices, values = self._make_sparse_input(num_rows, num_cols,
+                                              avg_row_length)
+    graph = ops.Graph()
+    with graph.as_default(), session_lib.Session(graph=graph) as session:
+      factors_ph = array_ops.placeholder(dtypes.float32)
+      indices_ph = array_ops.placeholder(dtypes.int64)
+      values_ph = array_ops.placeholder(dtypes.float32)
+      lhs, rhs = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+          factors_ph, np.ones(num_cols, dtype=np.float32), 0.1,
+          np.ones(num_rows, dtype=np.float32), indices_ph, values_ph,
+          num_rows, False)
+      feed_dict = {
+          factors_ph: np.random.normal(
+              size=[num_cols, factor_dim]).astype(np.float32),
+          indices_ph: indices,
+          values_ph: values
+      }
+      # Warm up.
+      session.run([lhs.op, rhs.op], feed_dict=feed_dict)
+      start_time = time.time()
+      for _ in range(num_iters):
+        session.run([lhs.op, rhs.op], feed_dict=feed_dict)
+      avg_wall_time = (time.time() - start_time) / num_iters
+
+    name = "wals_rows_%d_cols_%d_avg_row_length_%d_dim_%d" % (
+        num_rows, num_cols, avg_row_length, factor_dim)
+    print(name + " - %f secs" % avg_wall_time)
+    self.report_benchmark(name=name, iters=num_iters, wall_time=avg_wall_time)
+    return avg_wall_time
+
+  def benchmark_wals_solver(self):
+    num_iters = 5
+    for num_rows, avg_row_length in [(100000, 10), (100000, 100),
+                                     (1000000, 10)]:
+      for factor_dim in [16, 64]:
+        self._run_graph(num_rows, 100000, avg_row_length, factor_dim,
+                        num_iters)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -78,6 +78,59 @@ class WalsSolverOpsTest(test.TestCase):
                                               [0.160400, 0.220000, 0.279600],
                                               [0.492800, 0.563200, 0.633600]])
 
+  def testWalsSolverLargeBlock(self):
+    # Enough entries to be split into several units of work, with power-law
+    # distributed row lengths and some empty rows.
+    num_rows = 500
+    num_cols = 200
+    factor_dim = 4
+    np.random.seed(1)
+    row_lengths = np.minimum(np.random.zipf(1.5, size=num_rows), num_cols)
+    row_lengths[::7] = 0
+    indices = np.array(
+        [[i, j] for i in range(num_rows)
+         for j in np.random.choice(num_cols, row_lengths[i], replace=False)],
+        dtype=np.int64)
+    np.random.shuffle(indices)
+    values = np.random.uniform(size=len(indices)).astype(np.float32)
+    factors = np.random.uniform(size=[num_cols, factor_dim]).astype(np.float32)
+    factor_weights = np.random.uniform(size=num_cols).astype(np.float32)
+    row_weights = np.random.uniform(size=num_rows).astype(np.float32)
+    unobserved_weight = 0.1
+
+    expected_lhs = np.zeros([num_rows, factor_dim, factor_dim])
+    expected_rhs = np.zeros([num_rows, factor_dim])
+    for (i, j), value in zip(indices, values):
+      weight = row_weights[i] * factor_weights[j]
+      expected_lhs[i] += weight * np.outer(factors[j], factors[j])
+      expected_rhs[i] += value * (unobserved_weight + weight) * factors[j]
+
+    with self.test_session():
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           factors, factor_weights, unobserved_weight, row_weights, indices,
+           values, num_rows, False)
+      self.assertAllClose(lhs_tensor.eval(), expected_lhs, rtol=1e-4)
+      self.assertAllClose(rhs_matrix.eval(), expected_rhs, rtol=1e-4)
+
+      # The same entries with the input transposed.
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           factors, factor_weights, unobserved_weight, row_weights,
+           indices[:, ::-1], values, num_rows, True)
+      self.assertAllClose(lhs_tensor.eval(), expected_lhs, rtol=1e-4)
+      self.assertAllClose(rhs_matrix.eval(), expected_rhs, rtol=1e-4)
+
+  def testWalsSolverInvalidIndex(self):
+    sparse_block = SparseBlock3x3()
+    with self.test_session():
+      [lhs_tensor, _] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+          self._column_factors, self._column_weights, self._unobserved_weights,
+          self._row_weights, sparse_block.indices, sparse_block.values, 3,
+          False)
+      with self.assertRaisesOpError("out of range"):
+        lhs_tensor.eval()
+
 
 if __name__ == "__main__":
   test.main()
@@ -184,6 +184,7 @@ class SdcaModelTest(TensorFlowTestCase):
     return self.test_session(use_gpu=False, config=config)
 
 
+
 class SdcaWithLogisticLossTest(SdcaModelTest):
   """SDCA optimizer test class for logistic loss."""
 
@@ -297,6 +298,46 @@ class SdcaWithLogisticLossTest(SdcaModelTest):
           self.assertAllEqual([0, 1], predicted_labels.eval())
           self.assertTrue(lr.approximate_duality_gap().eval() < 0.02)
 
+  def testMultiThreadedConvergence(self):
+    # The examples are trained on by several threads that update the shared
+    # weights without locking, which should converge to the same loss as
+    # training on them with one thread.
+    example_protos = []
+    for i in range(400):
+      age = i % 10
+      label = 1 if age >= 5 else 0
+      if i % 7 == 0:
+        label = 1 - label
+      example_protos.append(
+          make_example_proto({
+              'age': [age],
+              'gender': [(i // 10) % 2]
+          }, label))
+    example_weights = [1.0] * len(example_protos)
+    losses = []
+    for num_threads in [1, 4]:
+      config = config_pb2.ConfigProto(
+          inter_op_parallelism_threads=1,
+          intra_op_parallelism_threads=num_threads)
+      with self.test_session(graph=ops.Graph(), use_gpu=False, config=config):
+        examples = make_example_dict(example_protos, example_weights)
+        variables = make_variable_dict(9, 1)
+        options = dict(
+            symmetric_l2_regularization=1,
+            symmetric_l1_regularization=0,
+            loss_type='logistic_loss')
+
+        lr = SdcaModel(examples, variables, options)
+        variables_lib.global_variables_initializer().run()
+        loss = lr.regularized_loss(examples)
+        train_op = lr.minimize()
+        for _ in range(_MAX_ITERATIONS):
+          train_op.run()
+        lr.update_weights(train_op).run()
+        losses.append(loss.eval())
+        self.assertTrue(lr.approximate_duality_gap().eval() < 0.02)
+    self.assertAllClose(losses[0], losses[1], atol=0.01)
+
   def testSimpleNoL2(self):
     # Same as test above (so comments from above apply) but without an L2.
     # The algorithm should behave as if we have an L2 of 1 in optimization but
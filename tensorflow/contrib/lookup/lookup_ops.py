@@ -516,7 +516,8 @@ class MutableDenseHashTable(LookupInterface):
                initial_num_buckets=None,
                shared_name=None,
                name="MutableDenseHashTable",
-               checkpoint=True):
+               checkpoint=True,
+               num_shards=1):
     """Creates an empty `MutableDenseHashTable` object.
 
     Creates a table, the type of its keys and values are specified by key_dtype
@@ -535,6 +536,10 @@ class MutableDenseHashTable(LookupInterface):
       checkpoint: if True, the contents of the table are saved to and restored
         from checkpoints. If `shared_name` is empty for a checkpointed table, it
         is shared using the table node name.
+      num_shards: the number of independently locked shards the buckets are
+        split into. With more than one shard, inserts that grow one shard do
+        not block lookups in the others, and lookups and inserts are processed
+        in parallel across shards.
 
     Returns:
       A `MutableHashTable` object.
@@ -559,6 +564,7 @@ class MutableDenseHashTable(LookupInterface):
         value_dtype=value_dtype,
         value_shape=self._value_shape,
         initial_num_buckets=initial_num_buckets,
+        num_shards=num_shards,
         name=name)
     # pylint: enable=protected-access
     super(MutableDenseHashTable, self).__init__(
@@ -1087,6 +1087,76 @@ class MutableDenseHashTableOpTest(test.TestCase):
       output = table.lookup(input_string)
       self.assertAllEqual([0, 1, -1, 2, -1], output.eval())
 
+  def testSharded(self):
+    with self.test_session():
+      keys = constant_op.constant(np.arange(1, 1001), dtypes.int64)
+      values = constant_op.constant(np.arange(1, 1001) * 10, dtypes.int64)
+      table = lookup.MutableDenseHashTable(
+          dtypes.int64,
+          dtypes.int64,
+          default_value=-1,
+          empty_key=0,
+          initial_num_buckets=16,
+          num_shards=4)
+      self.assertAllEqual(0, table.size().eval())
+      # Each of the 4 shards starts with 4 buckets.
+      self.assertAllEqual(16, len(table.export()[0].eval()))
+
+      table.insert(keys, values).run()
+      self.assertAllEqual(1000, table.size().eval())
+      self.assertLess(1000, len(table.export()[0].eval()))
+
+      table.insert(
+          constant_op.constant([5, 2000], dtypes.int64),
+          constant_op.constant([-5, 20000], dtypes.int64)).run()
+      self.assertAllEqual(1001, table.size().eval())
+
+      output = table.lookup(
+          constant_op.constant([1, 5, 1000, 1001, 2000], dtypes.int64))
+      self.assertAllEqual([10, -5, 10000, -1, 20000], output.eval())
+
+  def testShardedSaveRestore(self):
+    save_dir = os.path.join(self.get_temp_dir(), "save_restore")
+    save_path = os.path.join(tempfile.mkdtemp(prefix=save_dir), "hash")
+
+    keys = np.arange(1, 101)
+    with self.test_session(graph=ops.Graph()) as sess:
+      table = lookup.MutableDenseHashTable(
+          dtypes.int64,
+          dtypes.int64,
+          default_value=-1,
+          empty_key=0,
+          name="t1",
+          checkpoint=True,
+          initial_num_buckets=32,
+          num_shards=3)
+      save = saver.Saver()
+      table.insert(
+          constant_op.constant(keys, dtypes.int64),
+          constant_op.constant(keys * 2, dtypes.int64)).run()
+      self.assertAllEqual(100, table.size().eval())
+      save.save(sess, save_path)
+
+    # Restore into a table with a different number of shards.
+    for num_shards in [1, 5]:
+      with self.test_session(graph=ops.Graph()) as sess:
+        table = lookup.MutableDenseHashTable(
+            dtypes.int64,
+            dtypes.int64,
+            default_value=-1,
+            empty_key=0,
+            name="t1",
+            checkpoint=True,
+            initial_num_buckets=32,
+            num_shards=num_shards)
+        save = saver.Saver()
+        save.restore(sess, save_path)
+        self.assertAllEqual(100, table.size().eval())
+
+        output = table.lookup(
+            constant_op.constant([1, 50, 100, 101], dtypes.int64))
+        self.assertAllEqual([2, 100, 200, -1], output.eval())
+
   def testReprobe(self):
     with self.test_session():
       # Insert 6 keys into a table with 8 buckets.
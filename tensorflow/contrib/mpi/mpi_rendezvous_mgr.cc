@@ -100,7 +100,7 @@ void MPIRemoteRendezvous::RecvFromRemoteAsync(
   // Create the function which is called when the Tensor is send by remote
   const int64 temp1 = step_id_;
   rendezvous_call->recv_call_ =
-      [this, parsed, recv_args, done, dst, temp1, rendezvous_call](
+      [this, parsed, recv_args, done, dst, temp1](
           MPIRecvTensorResponse mpi_response) {
     Status s;
     Device* dst_device;
@@ -113,23 +113,40 @@ void MPIRemoteRendezvous::RecvFromRemoteAsync(
             << " @ step: " << temp1
             << " single-send: " << mpi_response.singlesend();
 
-    Tensor val;
+    const bool is_dead = mpi_response.response().is_dead();
     if (mpi_response.singlesend()) {
-      dst_device->MakeTensorFromProto(mpi_response.response().tensor(),
-                                      recv_args.alloc_attrs, &val);
+      // Decode on a compute thread, so that the MPI thread can get on with
+      // the other transfers.
+      auto response = std::make_shared<MPIRecvTensorResponse>();
+      response->Swap(&mpi_response);
+      env_->compute_pool->Schedule(
+          [dst_device, recv_args, done, response, is_dead]() {
+            Tensor val;
+            Status s = dst_device->MakeTensorFromProto(
+                response->response().tensor(), recv_args.alloc_attrs, &val);
+            done(s, Args(), recv_args, val, is_dead);
+          });
     } else {
       TensorResponse tr;
       tr.InitAlloc(dst_device, recv_args.alloc_attrs);
       tr.InitPartial(mpi_response.response());
-      const size_t nBytes = tr.tensor().TotalBytes();
-      void* data = const_cast<void*>(DMAHelper::base(&tr.tensor()));
-      MPI_Status status;
-      MPI_CHECK(MPI_Recv(data, static_cast<int>(nBytes), MPI_BYTE, dst,
-                         TAG_SENDTENSOR2, MPI_COMM_WORLD, &status));
-      val = std::move(tr.tensor());
+      Tensor val = tr.tensor();
+      const size_t nBytes = val.TotalBytes();
+      void* data = const_cast<void*>(DMAHelper::base(&val));
+      // The data of each sender arrives in the order of the descriptions,
+      // so the receive must be posted before the next description is
+      // handled.
+      MPI_Request request;
+      MPI_CHECK(MPI_Irecv(data, static_cast<int>(nBytes), MPI_BYTE, dst,
+                          TAG_SENDTENSOR2, MPI_COMM_WORLD, &request));
+      MPIRendezvousMgr* mgr =
+          reinterpret_cast<MPIRendezvousMgr*>(this->rendezvous_mgr_);
+      mgr->AddPendingRecv(request, [this, recv_args, done, val, is_dead]() {
+        env_->compute_pool->Schedule([recv_args, done, val, is_dead]() {
+          done(Status::OK(), Args(), recv_args, val, is_dead);
+        });
+      });
     }
-
-    done(s, Args(), recv_args, val, mpi_response.response().is_dead());
   };
 
   MPIRendezvousMgr* mgr =
@@ -177,6 +194,7 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
                        MPI_STATUS_IGNORE));
 
     if (!mpi_send_call->mRes_.singlesend()) {
+      mpi_send_call->tensor_ = val;
       const int tensor_size = static_cast<int>(val.TotalBytes());
       void* temp = const_cast<void*>(DMAHelper::base(&val));
 
@@ -255,11 +273,6 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
     SendQueueEntry req(parsed.FullKey().ToString().c_str(), std::move(res));
 
     this->QueueSendRequest(req);
-
-    // Wait for the notification that indicates the tensor has been
-    // successfully transmitted to the remote process. Only needed if we
-    // have not parsed the tensor to proto
-    if (doOptimalTransfer) mpi_send_call->n_.WaitForNotification();
   };  // done_cb
 
   worker_env_2->compute_pool->Schedule([this, step_id, parsed, done_cb]() {
@@ -275,13 +288,13 @@ void MPIRendezvousMgr::MPIBackgroundThread() {
 
     // Check for incoming Tensor requests
     RecvTensorRequest request;
-    if (ProbeForData(TAG_REQTENSOR, &status, &request)) {
+    while (ProbeForData(TAG_REQTENSOR, &status, &request)) {
       this->AddRequest(request, status.MPI_SOURCE);
     }
 
-    // Check for incoming Tensor reply
+    // Check for incoming Tensor replies
     MPIRecvTensorResponse mRes;
-    if (ProbeForData(TAG_SENDTENSOR, &status, &mRes)) {
+    while (ProbeForData(TAG_SENDTENSOR, &status, &mRes)) {
       const int64 step_id = mRes.step_id();
       std::string key = mRes.key();
 
@@ -291,18 +304,30 @@ void MPIRendezvousMgr::MPIBackgroundThread() {
       RemoveRecvCall(step_id, key);
     }
 
+    // Finish receives whose data has arrived
+    for (auto it = pending_recvs_.begin(); it != pending_recvs_.end();) {
+      int done = 0;
+      MPI_CHECK(MPI_Test(&it->first, &done, MPI_STATUS_IGNORE));
+      if (done) {
+        it->second();
+        it = pending_recvs_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
     // Remove sends that have been completed
     active_sends.remove_if([](std::unique_ptr<MPISendTensorCall>& i) {
       return i->IsFinished();
     });
 
-    // send a Tensor request
+    // Send all queued Tensor requests
     RequestQueueEntry req;
-    if (GetRequest(&req)) req.second();
+    while (GetRequest(&req)) req.second();
 
-    // Send a Tensor response
+    // Send all queued Tensor responses
     SendQueueEntry send;
-    if (GetResponse(&send)) {
+    while (GetResponse(&send)) {
       std::unique_ptr<MPISendTensorCall> p(send.second());
       active_sends.push_back(std::move(p));
     }
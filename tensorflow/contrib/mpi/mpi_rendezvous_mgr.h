@@ -52,14 +52,14 @@ class MPISendTensorCall {
   int done1_;  // Int instead of bool for simpler IsFinished logic
   int done2_;
   MPIRecvTensorResponse mRes_;
-  Notification n_;
+  // Keeps the data sent by a two-part transfer alive until it is sent.
+  Tensor tensor_;
 
   MPISendTensorCall()
       : send_buffer_(nullptr), send_buffer2_(nullptr), done1_(1), done2_(1) {}
 
   ~MPISendTensorCall() {
     MPI_CHECK(MPI_Wait(&msg1_, MPI_STATUS_IGNORE));
-    n_.Notify();
     MPI_CHECK(MPI_Free_mem(send_buffer_));
     //    delete[] send_buffer_;
     delete[] send_buffer2_;
@@ -151,6 +151,12 @@ class MPIRendezvousMgr : public BaseRendezvousMgr {
         std::shared_ptr<MPIRequestTensorCall>(rCall);
   }
 
+  // Runs "done" once the receive "request" has finished. Must be called
+  // from the MPI thread.
+  void AddPendingRecv(MPI_Request request, std::function<void()> done) {
+    pending_recvs_.emplace_back(request, std::move(done));
+  }
+
   void RemoveStepID(const int64 step_id) {
     mutex_lock l(mrq_);
     CHECK(recv_tensor_map_[step_id].size() == 0) << "Removing unfinished step";
@@ -184,6 +190,9 @@ class MPIRendezvousMgr : public BaseRendezvousMgr {
   std::map<int64, std::unordered_map<std::string,
                                      std::shared_ptr<MPIRequestTensorCall>>>
       recv_tensor_map_ GUARDED_BY(mrq_);
+  // Receives of the data of two-part transfers that are still in flight.
+  // Only accessed by background_thread_.
+  std::list<std::pair<MPI_Request, std::function<void()>>> pending_recvs_;
 
   void AddRequest(RecvTensorRequest, const int);
   void MPIBackgroundThread();
@@ -18,6 +18,7 @@
 @@all_min
 @@all_prod
 @@all_sum
+@@bucketed_all_sum
 @@broadcast
 
 """
@@ -30,6 +31,7 @@ from tensorflow.contrib.nccl.python.ops.nccl_ops import all_max
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_min
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_prod
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_sum
+from tensorflow.contrib.nccl.python.ops.nccl_ops import bucketed_all_sum
 from tensorflow.contrib.nccl.python.ops.nccl_ops import broadcast
 
 from tensorflow.python.util.all_util import remove_undocumented
@@ -99,6 +99,65 @@ def all_max(tensors):
   return _apply_all_reduce('max', tensors)
 
 
+def bucketed_all_sum(tensors_per_device, bucket_size_bytes=4 << 20):
+  """Returns the all-reduce sums of several tensors, fused into buckets.
+
+  Consecutive tensors of the same dtype are flattened and concatenated into
+  buckets of at most `bucket_size_bytes` bytes (a tensor larger than that
+  gets a bucket of its own), and each bucket is summed with a single nccl
+  all-reduce. A bucket's all-reduce only depends on the tensors in it, so
+  when the tensors are gradients listed in the order the backward pass
+  computes them (e.g. in the reverse order of the layers), the first
+  buckets are reduced while the rest of the backward pass is running.
+
+  The computation is done with all-reduce operations, so if only some of the
+  returned tensors are evaluated then the computation will hang.
+
+  Args:
+    tensors_per_device: A list with, for each device, a list of the tensors to
+      sum on that device. The i-th tensors of all the devices must have the
+      same dtype and shape, and each device's tensors must be assigned to a
+      GPU device.
+    bucket_size_bytes: The maximum size of a bucket, in bytes.
+
+  Returns:
+    A list with, for each device, the list of summed tensors, where tensor i
+    has the same device, dtype and shape as `tensors_per_device[d][i]`.
+
+  Raises:
+    ValueError: If the devices do not have the same number of tensors, or a
+      tensor does not have a fully defined shape.
+  """
+  if not tensors_per_device:
+    raise ValueError('Must pass >0 tensors to all reduce operations')
+  num_tensors = len(tensors_per_device[0])
+  if any(len(tensors) != num_tensors for tensors in tensors_per_device):
+    raise ValueError('Each device must have the same number of tensors')
+
+  results = [[None] * num_tensors for _ in tensors_per_device]
+  for bucket in _make_buckets(tensors_per_device[0], bucket_size_bytes):
+    if len(bucket) == 1:
+      summed = all_sum([tensors[bucket[0]] for tensors in tensors_per_device])
+      for d, t in enumerate(summed):
+        results[d][bucket[0]] = t
+      continue
+
+    fused = []
+    for tensors in tensors_per_device:
+      with ops.device(tensors[bucket[0]].device):
+        fused.append(array_ops.concat(
+            [array_ops.reshape(tensors[i], [-1]) for i in bucket], 0))
+    sizes = [tensors_per_device[0][i].get_shape().num_elements()
+             for i in bucket]
+    for d, t in enumerate(all_sum(fused)):
+      with ops.device(t.device):
+        parts = array_ops.split(t, sizes)
+        for i, part in zip(bucket, parts):
+          results[d][i] = array_ops.reshape(
+              part, tensors_per_device[d][i].get_shape())
+  return results
+
+
 def broadcast(src_tensor, dst_devices):
   """Returns a list of tensors on `dst_devices`, each with value `tensor`.
 
@@ -155,6 +214,26 @@ def _apply_all_reduce(reduction_op, tensors):
   return res
 
 
+def _make_buckets(tensors, bucket_size_bytes):
+  """Returns lists of the indices of `tensors` to fuse with each other."""
+  buckets = []
+  bucket_bytes = 0
+  for i, t in enumerate(tensors):
+    shape = t.get_shape()
+    if not shape.is_fully_defined():
+      raise ValueError('Tensor %s must have a fully defined shape to be '
+                       'fused, but has shape %s' % (t.name, shape))
+    size = shape.num_elements() * t.dtype.size
+    if (buckets and t.dtype == tensors[buckets[-1][0]].dtype and
+        bucket_bytes + size <= bucket_size_bytes):
+      buckets[-1].append(i)
+      bucket_bytes += size
+    else:
+      buckets.append([i])
+      bucket_bytes = size
+  return buckets
+
+
 _lock = threading.Lock()
 _shared_name_counter = 0
 
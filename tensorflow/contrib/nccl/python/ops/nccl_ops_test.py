@@ -21,6 +21,8 @@ from __future__ import print_function
 import numpy as np
 
 from tensorflow.contrib import nccl
+from tensorflow.contrib.nccl.python.ops import nccl_ops
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import test
@@ -74,6 +76,57 @@ class AllReduceTest(test.TestCase):
       nccl.all_sum([])
 
 
+class BucketedAllSumTest(test.TestCase):
+
+  def testBucketedAllSum(self):
+    if not test.is_gpu_available():
+      return  # Test requires access to a GPU
+
+    shapes = [(3, 4), (5,), (2, 2, 2), (7,)]
+    devices = ['/gpu:0', '/gpu:0']
+    with self.test_session(use_gpu=True) as sess:
+      # A bucket holds two of the small tensors at most.
+      for bucket_size_bytes in [0, 24 * 4, 1 << 20]:
+        np_ans = [np.zeros(shape, dtype=np.float32) for shape in shapes]
+        tensors_per_device = []
+        for d in devices:
+          tensors = []
+          with ops.device(d):
+            for i, shape in enumerate(shapes):
+              t = np.random.random_sample(shape).astype(np.float32)
+              np_ans[i] += t
+              tensors.append(array_ops.identity(t))
+          tensors_per_device.append(tensors)
+
+        results = nccl.bucketed_all_sum(tensors_per_device, bucket_size_bytes)
+
+        for tensors in results:
+          for shape, r in zip(shapes, tensors):
+            self.assertEqual(shape, r.get_shape())
+        for tensors in sess.run(results):
+          for ans, r in zip(np_ans, tensors):
+            self.assertAllClose(r, ans)
+
+  def testMakeBuckets(self):
+    tensors = [
+        array_ops.zeros([4]),
+        array_ops.zeros([2, 2]),
+        array_ops.zeros([8]),
+        array_ops.zeros([2], dtype=dtypes.int32),
+        array_ops.zeros([1], dtype=dtypes.int32),
+    ]
+    self.assertEqual([[0, 1], [2], [3, 4]], nccl_ops._make_buckets(tensors, 32))
+    self.assertEqual([[0], [1], [2], [3], [4]],
+                     nccl_ops._make_buckets(tensors, 0))
+
+  def testErrors(self):
+    with self.assertRaisesRegexp(ValueError, 'same number of tensors'):
+      nccl.bucketed_all_sum([[array_ops.zeros([1])], []])
+    with self.assertRaisesRegexp(ValueError, 'fully defined shape'):
+      nccl.bucketed_all_sum(
+          [[array_ops.placeholder(dtypes.float32, shape=[None])]])
+
+
 class BroadcastTest(test.TestCase):
 
   def testBroadcast(self):
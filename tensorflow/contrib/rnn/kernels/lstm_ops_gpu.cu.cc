@@ -18,12 +18,112 @@ limitations under the License.
 #define EIGEN_USE_GPU
 
 #include "tensorflow/contrib/rnn/kernels/lstm_ops.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 namespace functor {
 
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace {
+
+template <typename T>
+__device__ EIGEN_STRONG_INLINE T sigmoid(const T x) {
+  return T(1) / (T(1) + exp(-x));
+}
+
+// Computes the gates, the cell state and the output of a batch of LSTM
+// cells from icfo = [x, h_prev] * w, adding the bias on the way. Each thread
+// handles one cell of one batch entry, so the four gate pre-activations are
+// read once and the intermediate values never round-trip through memory.
+template <typename T, bool use_peephole>
+__global__ void LSTMBlockCellFpropKernel(
+    const T* icfo, const T* b, const T* cs_prev, const T* wci, const T* wcf,
+    const T* wco, T* i, T* cs, T* f, T* o, T* ci, T* co, T* h,
+    const T forget_bias, const T cell_clip, const int batch_size,
+    const int cell_size) {
+  CUDA_1D_KERNEL_LOOP(idx, batch_size * cell_size) {
+    const int batch = idx / cell_size;
+    const int cell = idx % cell_size;
+    const T* gates = icfo + batch * cell_size * 4;
+    const T cs_prev_value = cs_prev[idx];
+
+    T i_value = gates[cell] + b[cell];
+    T f_value = gates[cell + cell_size * 2] + b[cell + cell_size * 2] +
+                forget_bias;
+    if (use_peephole) {
+      i_value += cs_prev_value * wci[cell];
+      f_value += cs_prev_value * wcf[cell];
+    }
+    i_value = sigmoid(i_value);
+    f_value = sigmoid(f_value);
+    const T ci_value = tanh(gates[cell + cell_size] + b[cell + cell_size]);
+
+    T cs_value = i_value * ci_value + f_value * cs_prev_value;
+    if (cell_clip > T(0)) {
+      cs_value = min(max(cs_value, -cell_clip), cell_clip);
+    }
+    const T co_value = tanh(cs_value);
+
+    T o_value = gates[cell + cell_size * 3] + b[cell + cell_size * 3];
+    if (use_peephole) {
+      o_value += cs_value * wco[cell];
+    }
+    o_value = sigmoid(o_value);
+
+    i[idx] = i_value;
+    cs[idx] = cs_value;
+    f[idx] = f_value;
+    o[idx] = o_value;
+    ci[idx] = ci_value;
+    co[idx] = co_value;
+    h[idx] = o_value * co_value;
+  }
+}
+
+}  // namespace
+
+// The GPU forward pass runs the gate GEMM and then a single fused kernel for
+// the elementwise updates, instead of one Eigen kernel per expression.
+#define DEFINE_GPU_FPROP(T)                                                   \
+  template <>                                                                 \
+  void LSTMBlockCellFprop<GPUDevice, T, true>::operator()(                    \
+      OpKernelContext* ctx, const GPUDevice& d, const T forget_bias,          \
+      const T cell_clip, bool use_peephole, typename TTypes<T>::ConstMatrix x, \
+      typename TTypes<T>::ConstMatrix cs_prev,                                \
+      typename TTypes<T>::ConstMatrix h_prev,                                 \
+      typename TTypes<T>::ConstMatrix w, typename TTypes<T>::ConstVec wci,    \
+      typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,     \
+      typename TTypes<T>::ConstVec b, typename TTypes<T>::Matrix xh,          \
+      typename TTypes<T>::Matrix i, typename TTypes<T>::Matrix cs,            \
+      typename TTypes<T>::Matrix f, typename TTypes<T>::Matrix o,             \
+      typename TTypes<T>::Matrix ci, typename TTypes<T>::Matrix co,           \
+      typename TTypes<T>::Matrix icfo, typename TTypes<T>::Matrix h) {        \
+    /* Concat xh = [x, h]. */                                                 \
+    xh.slice(xh_x_offsets(), xh_x_extents()).device(d) = x;                   \
+    xh.slice(xh_h_offsets(), xh_h_extents()).device(d) = h_prev;              \
+                                                                              \
+    /* icfo = xh * w; the bias is added by the fused kernel. */               \
+    typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());     \
+    TensorBlasGemm<GPUDevice, T, true>::compute(                              \
+        ctx, d, false, false, T(1), const_xh, w, T(0), icfo);                 \
+                                                                              \
+    const int num_elements = batch_size_ * cell_size_;                        \
+    if (num_elements == 0) return;                                            \
+    CudaLaunchConfig config = GetCudaLaunchConfig(num_elements, d);           \
+    auto kernel = use_peephole ? LSTMBlockCellFpropKernel<T, true>            \
+                               : LSTMBlockCellFpropKernel<T, false>;          \
+    kernel<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(   \
+        icfo.data(), b.data(), cs_prev.data(), wci.data(), wcf.data(),        \
+        wco.data(), i.data(), cs.data(), f.data(), o.data(), ci.data(),       \
+        co.data(), h.data(), forget_bias, cell_clip, batch_size_,             \
+        cell_size_);                                                          \
+  }
+
+DEFINE_GPU_FPROP(float);
+// DEFINE_GPU_FPROP(double);
+#undef DEFINE_GPU_FPROP
+
 #define DEFINE_GPU_SPECS(T)                               \
   template struct TensorZero<GPUDevice, T>;               \
   template struct TensorUnalignedZero<GPUDevice, T>;      \
@@ -184,11 +184,13 @@ class TreePredictionsV4Op : public OpKernel {
                                                      &output_predictions));
 
     auto out = output_predictions->tensor<float, 2>();
-    for (int i = 0; i < data_set_->NumItems(); ++i) {
-      const int32 leaf_id =
-          decision_tree_resource->TraverseTree(data_set_, i, nullptr);
+    const int32 num_data = data_set_->NumItems();
+    std::vector<int32> leaf_ids(num_data);
+    decision_tree_resource->compiled_tree().Traverse(
+        data_set_, 0, num_data, leaf_ids.data(), nullptr);
+    for (int i = 0; i < num_data; ++i) {
       const decision_trees::Leaf& leaf =
-          decision_tree_resource->get_leaf(leaf_id);
+          decision_tree_resource->get_leaf(leaf_ids[i]);
       for (int j = 0; j < param_proto_.num_outputs(); ++j) {
         const float count = model_op_->GetOutputValue(leaf, j);
         out(i, j) = count;
@@ -0,0 +1,178 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/tensor_forest/kernels/v4/compiled_decision_tree.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model_extensions.pb.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace tensorforest {
+
+namespace {
+
+// The number of examples that advance through the tree together.
+const int32 kBlockSize = 64;
+
+int32 FeatureNum(const decision_trees::FeatureId& feature_id) {
+  int32 feature_num = 0;
+  safe_strto32(feature_id.id().value(), &feature_num);
+  return feature_num;
+}
+
+}  // namespace
+
+CompiledDecisionTree::CompiledDecisionTree(
+    const decision_trees::DecisionTree& tree) {
+  if (tree.nodes_size() == 0) {
+    return;
+  }
+  // The proto ids and depths of the nodes in breadth-first order.
+  std::vector<int32> order = {0};
+  std::vector<int32> depths = {0};
+  for (size_t i = 0; i < order.size(); ++i) {
+    const decision_trees::TreeNode& node = tree.nodes(order[i]);
+    if (node.has_leaf()) {
+      node_types_.push_back(kLeaf);
+      features_.push_back(0);
+      thresholds_.push_back(0);
+      left_ids_.push_back(order[i]);
+      depth_ = std::max(depth_, depths[i]);
+      continue;
+    }
+    const decision_trees::BinaryNode& bnode = node.binary_node();
+    NodeType type;
+    int32 feature = 0;
+    float threshold = 0;
+    if (bnode.has_inequality_left_child_test()) {
+      const auto& test = bnode.inequality_left_child_test();
+      threshold = test.threshold().float_value();
+      if (test.has_oblique()) {
+        type = kOblique;
+        feature = oblique_ranges_.size();
+        const int32 begin = oblique_features_.size();
+        for (int j = 0; j < test.oblique().features_size(); ++j) {
+          oblique_features_.push_back(FeatureNum(test.oblique().features(j)));
+          oblique_weights_.push_back(test.oblique().weights(j));
+        }
+        oblique_ranges_.emplace_back(begin, oblique_features_.size());
+      } else {
+        type = test.type() == decision_trees::InequalityTest::LESS_OR_EQUAL
+                   ? kLessOrEqual
+                   : kLessThan;
+        feature = FeatureNum(test.feature_id());
+      }
+    } else {
+      decision_trees::MatchingValuesTest test;
+      if (!bnode.custom_left_child_test().UnpackTo(&test)) {
+        LOG(FATAL) << "Unknown split test: " << bnode.DebugString();
+      }
+      type = test.inverse() ? kNotMatchingValues : kMatchingValues;
+      feature = matching_values_.size();
+      MatchingValues matching;
+      matching.feature = FeatureNum(test.feature_id());
+      for (const auto& value : test.value()) {
+        matching.values.push_back(value.float_value());
+      }
+      matching_values_.push_back(std::move(matching));
+    }
+    node_types_.push_back(type);
+    features_.push_back(feature);
+    thresholds_.push_back(threshold);
+    left_ids_.push_back(order.size());
+    for (const int32 child_id : {bnode.left_child_id().value(),
+                                 bnode.right_child_id().value()}) {
+      CHECK(child_id >= 0 && child_id < tree.nodes_size())
+          << "Invalid child " << child_id << " of node " << order[i];
+      order.push_back(tree.nodes(child_id).node_id().value());
+      depths.push_back(depths[i] + 1);
+    }
+  }
+}
+
+bool CompiledDecisionTree::GoesLeft(
+    int32 node_id, const std::unique_ptr<TensorDataSet>& input_data,
+    int example) const {
+  switch (node_types_[node_id]) {
+    case kLessOrEqual:
+      return input_data->GetExampleValue(example, features_[node_id]) <=
+             thresholds_[node_id];
+    case kLessThan:
+      return input_data->GetExampleValue(example, features_[node_id]) <
+             thresholds_[node_id];
+    case kOblique: {
+      const auto& range = oblique_ranges_[features_[node_id]];
+      float value = 0;
+      for (int32 i = range.first; i < range.second; ++i) {
+        value += oblique_weights_[i] *
+                 input_data->GetExampleValue(example, oblique_features_[i]);
+      }
+      return value <= thresholds_[node_id];
+    }
+    case kMatchingValues:
+    case kNotMatchingValues: {
+      const MatchingValues& matching = matching_values_[features_[node_id]];
+      const float value =
+          input_data->GetExampleValue(example, matching.feature);
+      const bool matches =
+          std::find(matching.values.begin(), matching.values.end(), value) !=
+          matching.values.end();
+      return matches == (node_types_[node_id] == kMatchingValues);
+    }
+    case kLeaf:
+      break;
+  }
+  return false;
+}
+
+void CompiledDecisionTree::Traverse(
+    const std::unique_ptr<TensorDataSet>& input_data, int32 start, int32 end,
+    int32* leaf_ids, int32* leaf_depths) const {
+  if (node_types_.empty()) {
+    return;
+  }
+  int32 node_ids[kBlockSize];
+  int32 depths[kBlockSize];
+  for (int32 block_start = start; block_start < end;
+       block_start += kBlockSize) {
+    const int32 block_size = std::min(kBlockSize, end - block_start);
+    std::fill(node_ids, node_ids + block_size, 0);
+    std::fill(depths, depths + block_size, 0);
+    for (int32 level = 0; level < depth_; ++level) {
+      for (int32 i = 0; i < block_size; ++i) {
+        const int32 node_id = node_ids[i];
+        if (node_types_[node_id] == kLeaf) {
+          continue;
+        }
+        node_ids[i] = left_ids_[node_id] +
+                      !GoesLeft(node_id, input_data, block_start + i);
+        ++depths[i];
+      }
+    }
+    for (int32 i = 0; i < block_size; ++i) {
+      leaf_ids[block_start - start + i] = left_ids_[node_ids[i]];
+    }
+    if (leaf_depths != nullptr) {
+      std::copy(depths, depths + block_size,
+                leaf_depths + block_start - start);
+    }
+  }
+}
+
+}  // namespace tensorforest
+}  // namespace tensorflow
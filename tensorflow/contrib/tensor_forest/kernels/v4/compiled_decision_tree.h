@@ -0,0 +1,93 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_TENSOR_FOREST_KERNELS_V4_COMPILED_DECISION_TREE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_TENSOR_FOREST_KERNELS_V4_COMPILED_DECISION_TREE_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model.pb.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/input_data.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace tensorforest {
+
+// A decision tree compiled into flat arrays for fast batch inference.
+// The nodes are stored as a struct of arrays in breadth-first order, so that
+// the right child of a split always directly follows its left child, and the
+// kind of each inequality test is resolved when the tree is compiled instead
+// of through a DecisionNodeEvaluator per node visit.
+// This class is immutable and thread safe.
+class CompiledDecisionTree {
+ public:
+  explicit CompiledDecisionTree(const decision_trees::DecisionTree& tree);
+
+  // Traverses the tree for the examples [start, end) of "input_data", and
+  // sets leaf_ids[i - start] to the node id of the leaf that example i ends
+  // up at, like DecisionTreeResource::TraverseTree. Also sets the depths of
+  // the leaves if "leaf_depths" isn't nullptr. The examples are processed in
+  // blocks that advance through the tree one level at a time, so that each
+  // level of the tree is only loaded once per block.
+  void Traverse(const std::unique_ptr<TensorDataSet>& input_data, int32 start,
+                int32 end, int32* leaf_ids, int32* leaf_depths) const;
+
+ private:
+  enum NodeType : uint8 {
+    kLeaf,
+    kLessOrEqual,
+    kLessThan,
+    kOblique,
+    kMatchingValues,
+    kNotMatchingValues,
+  };
+
+  // Returns true if example "example" goes to the left child of split node
+  // "node_id".
+  bool GoesLeft(int32 node_id, const std::unique_ptr<TensorDataSet>& input_data,
+                int example) const;
+
+  // The number of split levels in the tree.
+  int32 depth_ = 0;
+
+  // Per node. For an oblique or matching values split, the feature is an
+  // index into the corresponding side table instead. For a leaf, the left id
+  // is the node id of the leaf in the tree proto.
+  std::vector<NodeType> node_types_;
+  std::vector<int32> features_;
+  std::vector<float> thresholds_;
+  std::vector<int32> left_ids_;
+
+  // The features and weights of oblique splits, in [begin, end) ranges.
+  std::vector<std::pair<int32, int32>> oblique_ranges_;
+  std::vector<int32> oblique_features_;
+  std::vector<float> oblique_weights_;
+
+  // The feature and the values of matching values splits.
+  struct MatchingValues {
+    int32 feature;
+    std::vector<float> values;
+  };
+  std::vector<MatchingValues> matching_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompiledDecisionTree);
+};
+
+}  // namespace tensorforest
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_TENSOR_FOREST_KERNELS_V4_COMPILED_DECISION_TREE_H_
@@ -0,0 +1,170 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/tensor_forest/kernels/v4/compiled_decision_tree.h"
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model.pb.h"
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model_extensions.pb.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/decision-tree-resource.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/test_utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using tensorflow::decision_trees::BinaryNode;
+using tensorflow::decision_trees::DecisionTree;
+using tensorflow::decision_trees::InequalityTest;
+using tensorflow::decision_trees::MatchingValuesTest;
+using tensorflow::tensorforest::CompiledDecisionTree;
+using tensorflow::tensorforest::DecisionTreeResource;
+using tensorflow::tensorforest::TensorDataSet;
+using tensorflow::tensorforest::TestableDataSet;
+
+// Turns leaf "node_id" of "tree" into a split with two new leaf children,
+// and returns the split.
+BinaryNode* SplitLeaf(int32 node_id, DecisionTree* tree) {
+  const int32 left_id = tree->nodes_size();
+  for (int32 id : {left_id, left_id + 1}) {
+    auto* child = tree->add_nodes();
+    child->mutable_node_id()->set_value(id);
+    child->mutable_leaf();
+  }
+  auto* node = tree->mutable_nodes(node_id);
+  node->clear_leaf();
+  BinaryNode* split = node->mutable_binary_node();
+  split->mutable_left_child_id()->set_value(left_id);
+  split->mutable_right_child_id()->set_value(left_id + 1);
+  return split;
+}
+
+void SetInequality(int32 feature, float threshold, InequalityTest::Type type,
+                   BinaryNode* split) {
+  auto* test = split->mutable_inequality_left_child_test();
+  test->mutable_feature_id()->mutable_id()->set_value(
+      strings::StrCat(feature));
+  test->mutable_threshold()->set_float_value(threshold);
+  test->set_type(type);
+}
+
+class CompiledDecisionTreeTest : public ::testing::Test {
+ protected:
+  CompiledDecisionTreeTest() {
+    // An unbalanced tree over two features:
+    //   0: f0 <= 2      -> 1, 2
+    //   2: f1 < 5       -> 3, 4
+    //   3: f0 in {3, 5} -> 5, 6
+    //   4: 0.5 * f0 + f1 <= 7 -> 7, 8
+    auto* root = tree_.add_nodes();
+    root->mutable_node_id()->set_value(0);
+    root->mutable_leaf();
+    SetInequality(0, 2.0, InequalityTest::LESS_OR_EQUAL, SplitLeaf(0, &tree_));
+    SetInequality(1, 5.0, InequalityTest::LESS_THAN, SplitLeaf(2, &tree_));
+    MatchingValuesTest matching;
+    matching.mutable_feature_id()->mutable_id()->set_value("0");
+    matching.add_value()->set_float_value(3.0);
+    matching.add_value()->set_float_value(5.0);
+    SplitLeaf(3, &tree_)->mutable_custom_left_child_test()->PackFrom(matching);
+    auto* oblique = SplitLeaf(4, &tree_)->mutable_inequality_left_child_test();
+    oblique->mutable_threshold()->set_float_value(7.0);
+    auto* features = oblique->mutable_oblique();
+    features->add_features()->mutable_id()->set_value("0");
+    features->add_weights(0.5);
+    features->add_features()->mutable_id()->set_value("1");
+    features->add_weights(1.0);
+  }
+
+  DecisionTree tree_;
+};
+
+TEST_F(CompiledDecisionTreeTest, MatchesTraverseTree) {
+  // Pairs of (f0, f1).
+  std::unique_ptr<TensorDataSet> dataset(new TestableDataSet(
+      {1.0, 9.0, 2.0, 0.0, 3.0, 4.0, 4.0, 4.0, 5.0, 5.0, 4.0, 5.0, 8.0, 4.0,
+       6.0, 2.0},
+      2));
+  const int32 num_examples = 8;
+
+  DecisionTreeResource resource;
+  *resource.mutable_decision_tree()->mutable_decision_tree() = tree_;
+  resource.MaybeInitialize();
+
+  std::vector<int32> leaf_ids(num_examples);
+  std::vector<int32> leaf_depths(num_examples);
+  resource.compiled_tree().Traverse(dataset, 0, num_examples,
+                                    leaf_ids.data(), leaf_depths.data());
+  const std::vector<int32> expected_leaf_ids = {1, 1, 5, 6, 8, 7, 6, 6};
+  for (int i = 0; i < num_examples; ++i) {
+    int32 depth;
+    EXPECT_EQ(expected_leaf_ids[i], leaf_ids[i]) << "example " << i;
+    EXPECT_EQ(resource.TraverseTree(dataset, i, &depth), leaf_ids[i]);
+    EXPECT_EQ(depth, leaf_depths[i]);
+  }
+}
+
+TEST_F(CompiledDecisionTreeTest, TraverseRange) {
+  // More examples than fit in one block.
+  std::vector<float> data;
+  for (int i = 0; i < 200; ++i) {
+    data.push_back(i % 7);
+    data.push_back(i % 11);
+  }
+  std::unique_ptr<TensorDataSet> dataset(new TestableDataSet(data, 2));
+  CompiledDecisionTree compiled(tree_);
+  DecisionTreeResource resource;
+  *resource.mutable_decision_tree()->mutable_decision_tree() = tree_;
+  resource.MaybeInitialize();
+
+  std::vector<int32> leaf_ids(150);
+  compiled.Traverse(dataset, 30, 180, leaf_ids.data(), nullptr);
+  for (int i = 30; i < 180; ++i) {
+    EXPECT_EQ(resource.TraverseTree(dataset, i, nullptr), leaf_ids[i - 30]);
+  }
+}
+
+TEST_F(CompiledDecisionTreeTest, SingleLeaf) {
+  DecisionTree tree;
+  tree.add_nodes()->mutable_leaf();
+  std::unique_ptr<TensorDataSet> dataset(
+      new TestableDataSet({1.0, 2.0}, 1));
+  CompiledDecisionTree compiled(tree);
+  int32 leaf_ids[2] = {-1, -1};
+  int32 leaf_depths[2] = {-1, -1};
+  compiled.Traverse(dataset, 0, 2, leaf_ids, leaf_depths);
+  EXPECT_EQ(0, leaf_ids[0]);
+  EXPECT_EQ(0, leaf_ids[1]);
+  EXPECT_EQ(0, leaf_depths[0]);
+  EXPECT_EQ(0, leaf_depths[1]);
+}
+
+TEST_F(CompiledDecisionTreeTest, RecompilesAfterSplit) {
+  std::unique_ptr<TensorDataSet> dataset(new TestableDataSet({1.0, 3.0}, 1));
+  DecisionTreeResource resource;
+  resource.MaybeInitialize();
+  int32 leaf_ids[2];
+  resource.compiled_tree().Traverse(dataset, 0, 2, leaf_ids, nullptr);
+  EXPECT_EQ(0, leaf_ids[0]);
+  EXPECT_EQ(0, leaf_ids[1]);
+
+  tensorforest::SplitCandidate best;
+  SetInequality(0, 2.0, InequalityTest::LESS_OR_EQUAL, best.mutable_split());
+  std::vector<int32> new_children;
+  resource.SplitNode(0, &best, &new_children);
+  resource.compiled_tree().Traverse(dataset, 0, 2, leaf_ids, nullptr);
+  EXPECT_EQ(1, leaf_ids[0]);
+  EXPECT_EQ(2, leaf_ids[1]);
+}
+
+}  // namespace
+}  // namespace tensorflow
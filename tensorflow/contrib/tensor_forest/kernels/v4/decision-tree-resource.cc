@@ -41,8 +41,17 @@ int32 DecisionTreeResource::TraverseTree(
   }
 }
 
+const CompiledDecisionTree& DecisionTreeResource::compiled_tree() {
+  if (compiled_tree_ == nullptr) {
+    compiled_tree_.reset(
+        new CompiledDecisionTree(decision_tree_->decision_tree()));
+  }
+  return *compiled_tree_;
+}
+
 void DecisionTreeResource::SplitNode(int32 node_id, SplitCandidate* best,
                                      std::vector<int32>* new_children) {
+  compiled_tree_.reset();
   DecisionTree* tree = decision_tree_->mutable_decision_tree();
   TreeNode* node = tree->mutable_nodes(node_id);
   int32 newid = tree->nodes_size();
@@ -16,6 +16,7 @@
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_TENSOR_FOREST_KERNELS_V4_DECISION_TREE_RESOURCE_H_
 
 #include "tensorflow/contrib/decision_trees/proto/generic_tree_model.pb.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/compiled_decision_tree.h"
 #include "tensorflow/contrib/tensor_forest/kernels/v4/decision_node_evaluator.h"
 #include "tensorflow/contrib/tensor_forest/kernels/v4/input_data.h"
 #include "tensorflow/contrib/tensor_forest/kernels/v4/leaf_model_operators.h"
@@ -47,6 +48,7 @@ class DecisionTreeResource : public ResourceBase {
   }
 
   decision_trees::Model* mutable_decision_tree() {
+    compiled_tree_.reset();
     return decision_tree_.get();
   }
 
@@ -62,6 +64,7 @@ class DecisionTreeResource : public ResourceBase {
   // Caller needs to hold the mutex lock while calling this.
   void Reset() {
     decision_tree_.reset(new decision_trees::Model());
+    compiled_tree_.reset();
   }
 
   mutex* get_mutex() { return &mu_; }
@@ -71,6 +74,11 @@ class DecisionTreeResource : public ResourceBase {
   int32 TraverseTree(const std::unique_ptr<TensorDataSet>& input_data,
                      int example, int32* depth) const;
 
+  // Returns decision_tree_ compiled for batch inference, compiling it if it
+  // changed since the last call.
+  // Caller needs to hold the mutex lock while calling this.
+  const CompiledDecisionTree& compiled_tree();
+
   // Split the given node_id, turning it from a Leaf to a BinaryNode and
   // setting it's split to the given best.  Add new children ids to
   // new_children.
@@ -81,6 +89,7 @@ class DecisionTreeResource : public ResourceBase {
   mutex mu_;
   std::unique_ptr<decision_trees::Model> decision_tree_;
   std::vector<std::unique_ptr<DecisionNodeEvaluator>> node_evaluators_;
+  std::unique_ptr<CompiledDecisionTree> compiled_tree_;
 };
 
 
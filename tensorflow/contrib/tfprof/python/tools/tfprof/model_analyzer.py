@@ -117,6 +117,7 @@ ALL_ADVICE = {
     'AcceleratorUtilizationChecker': {},
     'JobChecker': {},  # Only available internally.
     'OperationChecker': {},
+    'MemoryChecker': {},
 }
 
 # pylint: enable=bad-whitespace
@@ -290,6 +291,23 @@ class Profiler(object):
         print_mdl.Profile('op'.encode('utf-8'), opts.SerializeToString()))
     return tfprof_node
 
+  def profile_device_kernels(self, options):
+    """Profile the device kernels and memory copies of the added steps.
+
+      Requires steps traced with RunOptions.HARDWARE_TRACE. Kernels are
+      aggregated by name over all the ops that launched them.
+
+    Args:
+      options: A dict of profiler options.
+    Returns:
+      a TFMultiGraphNodeProto that records the results.
+    """
+    opts = _build_options(options)
+    tfprof_node = tfprof_output_pb2.TFMultiGraphNodeProto()
+    tfprof_node.ParseFromString(
+        print_mdl.Profile('kernel'.encode('utf-8'), opts.SerializeToString()))
+    return tfprof_node
+
   def profile_name_scope(self, options):
     """Profile the statistics of graph nodes, organized by name scope.
 
@@ -351,15 +369,17 @@ def print_model_analysis(graph,
               'micros' and 'bytes'.
     op_log: tensorflow::tfprof::OpLog proto. users can use this proto to
             group together ops and use a op_type to select the group.
-    tfprof_cmd: string. Either 'op', 'scope', 'graph', 'code'.
+    tfprof_cmd: string. Either 'op', 'scope', 'graph', 'code', 'kernel'.
                 'op' view organize outputs using operation type. (e.g. MatMul)
                 'scope' view organize outputs using graph node name scope.
                 'graph' view organize outputs using graph node inputs/outputs.
                 'code' view organize outputs using Python call stack.
+                'kernel' view organize outputs using device kernel name.
     tfprof_options: See 'tfprof help' for details.
   Returns:
     If tfprof_cmd is 'scope' or 'graph', returns TFGraphNodeProto proto.
-    If tfprof_cmd is 'op' or 'code', returns TFMultiGraphNodeProto proto.
+    If tfprof_cmd is 'op', 'code' or 'kernel', returns TFMultiGraphNodeProto
+    proto.
     Side effect: stdout/file/timeline.json depending on tfprof_options['output']
   """
   # pylint: disable=protected-access
@@ -371,7 +391,7 @@ def print_model_analysis(graph,
 
   run_meta_str = run_meta.SerializeToString() if run_meta else b''
 
-  if tfprof_cmd == 'code' or tfprof_cmd == 'op':
+  if tfprof_cmd == 'code' or tfprof_cmd == 'op' or tfprof_cmd == 'kernel':
     tfprof_node = tfprof_output_pb2.TFMultiGraphNodeProto()
     tfprof_node.ParseFromString(
         print_mdl.PrintModelAnalysis(
@@ -131,6 +131,25 @@ class NodeConverter {
 
 }  // namespace
 
+Status ConvertConstantsToImmutable(GraphDef* graph_def,
+                                   MemmappedFileSystemWriter* writer,
+                                   int min_conversion_size_bytes,
+                                   int* convert_counter) {
+  NodeConverter node_converter;
+  // Iterate over graph nodes, looking for Const and replacing it with
+  // ImmutableConst.
+  for (int i = 0; i < graph_def->node_size(); ++i) {
+    const NodeDef& node = graph_def->node(i);
+    if (node.op() == "Const") {
+      // Try to convert to ImmutableConst
+      TF_RETURN_IF_ERROR(node_converter.ConvertConstantsToImmutable(
+          graph_def->mutable_node(i), writer, convert_counter,
+          min_conversion_size_bytes));
+    }
+  }
+  return Status::OK();
+}
+
 // Loads the graph, replaces operators, and writes it out.
 Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
@@ -145,24 +164,13 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                         load_graph_status.error_message());
   }
 
-  NodeConverter node_converter;
-
   // Create output writer.
   MemmappedFileSystemWriter writer;
   TF_RETURN_IF_ERROR(writer.InitializeToFile(default_env, out_graph_filename));
 
-  // Iterate over graph nodes, looking for Const and replacing it with
-  // ImmutableConst.
   int convert_counter = 0;
-  for (int i = 0; i < graph_def.node_size(); ++i) {
-    const NodeDef& node = graph_def.node(i);
-    if (node.op() == "Const") {
-      // Try to convert to ImmutableConst
-      TF_RETURN_IF_ERROR(node_converter.ConvertConstantsToImmutable(
-          graph_def.mutable_node(i), &writer, &convert_counter,
-          min_conversion_size_bytes));
-    }
-  }
+  TF_RETURN_IF_ERROR(ConvertConstantsToImmutable(
+      &graph_def, &writer, min_conversion_size_bytes, &convert_counter));
   TF_RETURN_IF_ERROR(writer.SaveProtobuf(
       graph_def, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef));
   TF_RETURN_IF_ERROR(writer.FlushAndClose());
@@ -18,7 +18,9 @@ limitations under the License.
 
 #include <string>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 namespace tensorflow {
 
@@ -29,6 +31,15 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes);
 
+// Converts the Const ops of "graph_def" whose POD tensors have at least
+// "min_conversion_size_bytes" bytes to ImmutableConst ops, and saves their
+// tensors with "writer". Increments "*convert_counter" for each converted op.
+// The caller saves the converted graph and closes "writer".
+Status ConvertConstantsToImmutable(GraphDef* graph_def,
+                                   MemmappedFileSystemWriter* writer,
+                                   int min_conversion_size_bytes,
+                                   int* convert_counter);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #ifdef TENSORFLOW_USE_VERBS
 
 #include "tensorflow/contrib/verbs/rdma.h"
+#include <algorithm>
 #include <cstdlib>
 #include "tensorflow/contrib/verbs/verbs_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -30,6 +31,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 
@@ -60,6 +64,9 @@ string MessageTypeToString(RdmaMessageType rmt) {
     case RDMA_MESSAGE_TENSOR_WRITE:
       return "RDMA_MESSAGE_TENSOR_WRITE";
       break;
+    case RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE:
+      return "RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE";
+      break;
     default:
       return "UNKNOWN MESSAGE";
   }
@@ -101,6 +108,9 @@ RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
 
 RdmaAdapter::~RdmaAdapter() {
   polling_thread_.reset();
+  for (ibv_mr* mr : gpu_mrs_) {
+    CHECK(!ibv_dereg_mr(mr)) << "ibv_dereg_mr failed";
+  }
   CHECK(!ibv_destroy_cq(cq_)) << "Failed to destroy CQ";
   CHECK(!ibv_destroy_comp_channel(event_channel_))
       << "Failed to destroy channel";
@@ -110,6 +120,74 @@ RdmaAdapter::~RdmaAdapter() {
 
 string RdmaAdapter::name() const { return string(context_->device->name); }
 
+void RdmaAdapter::RegisterGPUMemory() {
+#if GOOGLE_CUDA
+  // The nv_peer_mem module lets ibverbs register GPU memory.
+  if (!Env::Default()
+           ->FileExists("/sys/kernel/mm/memory_peers/nv_mem/version")
+           .ok()) {
+    LOG(INFO) << "GPUDirect RDMA is not available; GPU tensors will be "
+              << "staged in host memory";
+    return;
+  }
+  // ProcessState numbers PCIe buses by NUMA node + 1, with 0 for GPUs
+  // whose NUMA node is unknown.
+  int numa_node = -1;
+  string contents;
+  if (ReadFileToString(Env::Default(),
+                       strings::StrCat(context_->device->ibdev_path,
+                                       "/device/numa_node"),
+                       &contents)
+          .ok()) {
+    if (!strings::safe_strto32(str_util::StripSuffix(contents, "\n"),
+                               &numa_node)) {
+      numa_node = -1;
+    }
+  }
+  // The BFC allocators never free their regions, so there is no need for
+  // a matching free visitor.
+  ProcessState::singleton()->AddGPUAllocVisitor(
+      numa_node + 1, [this](void* ptr, size_t num_bytes) {
+        InsertMemoryRegion(ptr, num_bytes);
+      });
+  LOG(INFO) << "GPUDirect RDMA enabled for GPUs on bus " << numa_node + 1;
+#endif  // GOOGLE_CUDA
+}
+
+void RdmaAdapter::InsertMemoryRegion(void* addr, size_t length) {
+  ibv_mr* mr = ibv_reg_mr(pd_, addr, length,
+                          IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+  if (mr == nullptr) {
+    LOG(WARNING) << "Failed to register " << length << " bytes of GPU memory "
+                 << "with " << name() << "; tensors in it will be staged in "
+                 << "host memory";
+    return;
+  }
+  mutex_lock l(mr_mu_);
+  auto it = std::upper_bound(
+      gpu_mrs_.begin(), gpu_mrs_.end(), addr,
+      [](const void* a, const ibv_mr* region) { return a < region->addr; });
+  gpu_mrs_.insert(it, mr);
+}
+
+ibv_mr* RdmaAdapter::FindMemoryRegion(const void* addr, size_t length) const {
+  mutex_lock l(mr_mu_);
+  // Find the last region that starts at or before "addr".
+  auto it = std::upper_bound(
+      gpu_mrs_.begin(), gpu_mrs_.end(), addr,
+      [](const void* a, const ibv_mr* region) { return a < region->addr; });
+  if (it == gpu_mrs_.begin()) {
+    return nullptr;
+  }
+  --it;
+  const char* region_end =
+      static_cast<const char*>((*it)->addr) + (*it)->length;
+  if (static_cast<const char*>(addr) + length > region_end) {
+    return nullptr;
+  }
+  return *it;
+}
+
 // Function to process incoming messages
 // There are two types of messages:
 // 1. IBV_WC_RECV_RDMA_WITH_IMM (receive)
@@ -147,13 +225,18 @@ void RdmaAdapter::Process_CQ() {
           rb = rc->tx_message_buffer_;
           rb->SetBufferStatus(remote, idle);
           rb->SendNextItem();
-        } else if (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST) {
+        } else if (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST ||
+                   rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE) {
           // received a request-for-tensor message
           // send ack to release remote tx message buffer
           RdmaBuffer* ab = rc->tx_ack_buffer_;
           ab->SendNextItem();
           // find or create buffer
           RdmaBuffer* tb = rc->FindOrCreateBuffer(rm.name_);
+          if (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE) {
+            // the remote has consumed the previous tensor of this name
+            tb->SetBufferStatus(remote, idle);
+          }
           string key_with_step_id =
               VerbsUtil::AppendStepidToKey(rm.name_, rm.step_id_);
           tb->EnqueueItem(key_with_step_id);
@@ -219,6 +302,7 @@ void RdmaAdapter::Process_CQ() {
         }
       } else if (wc_[i].opcode == IBV_WC_RDMA_WRITE) {
         RdmaBuffer* rb = reinterpret_cast<RdmaBuffer*>(wc_[i].wr_id);
+        rb->OnWriteComplete();
         rb->SetBufferStatus(local, idle);
         RdmaMessage rm;
         RdmaMessage::ParseMessage(rm, rb->buffer_);
@@ -242,7 +326,8 @@ RdmaChannel::RdmaChannel(const RdmaAdapter* adapter, const string local_name,
     attr.recv_cq = adapter_->cq_;
     attr.cap.max_send_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
     attr.cap.max_recv_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
-    attr.cap.max_send_sge = 1;
+    // tensors sent from GPU memory need a second entry.
+    attr.cap.max_send_sge = 2;
     attr.cap.max_recv_sge = 1;
     attr.qp_type = IBV_QPT_RC;
 
@@ -458,6 +543,30 @@ void RdmaChannel::RunRecvCallback(const string& key) {
   recv_done();
 }
 
+bool RdmaChannel::StartTensorRequest(const string& key) {
+  mutex_lock lock{rs_mu_};
+  RecvBufferState& state = recv_buffer_states_[key];
+  ++state.num_outstanding;
+  bool report_idle = state.idle_unreported;
+  state.idle_unreported = false;
+  return report_idle;
+}
+
+bool RdmaChannel::FinishTensorRequest(const string& key) {
+  mutex_lock lock{rs_mu_};
+  RecvBufferState& state = recv_buffer_states_[key];
+  --state.num_outstanding;
+  if (state.num_outstanding > 0) {
+    // The sender is waiting for the buffer to send the next tensor.
+    return true;
+  }
+  // Nothing else is pending, so let the next request report the buffer
+  // idle.
+  state.num_outstanding = 0;
+  state.idle_unreported = true;
+  return false;
+}
+
 void RdmaChannel::Connect() {
   {
     mutex_lock lock{mu_};
@@ -599,12 +708,27 @@ void RdmaBuffer::Write(uint32_t imm_data, size_t buffer_size) {
   list.addr = (uint64_t)buffer_;
   list.length = buffer_size;
   list.lkey = self_->lkey;
+  PostWrite(imm_data, &list, 1);
+}
+
+void RdmaBuffer::Write(uint32_t imm_data, size_t header_size, const void* data,
+                       size_t data_size, uint32_t data_lkey) {
+  struct ibv_sge list[2];
+  list[0].addr = (uint64_t)buffer_;
+  list[0].length = header_size;
+  list[0].lkey = self_->lkey;
+  list[1].addr = (uint64_t)data;
+  list[1].length = data_size;
+  list[1].lkey = data_lkey;
+  PostWrite(imm_data, list, 2);
+}
 
+void RdmaBuffer::PostWrite(uint32_t imm_data, ibv_sge* sg_list, int num_sge) {
   struct ibv_send_wr wr;
   memset(&wr, 0, sizeof(wr));
   wr.wr_id = (uint64_t)this;
-  wr.sg_list = &list;
-  wr.num_sge = 1;
+  wr.sg_list = sg_list;
+  wr.num_sge = num_sge;
   wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
   wr.send_flags = IBV_SEND_SIGNALED;
   wr.imm_data = imm_data;
@@ -624,6 +748,11 @@ RdmaMessageBuffer::RdmaMessageBuffer(RdmaChannel* channel, string name)
 RdmaTensorBuffer::RdmaTensorBuffer(RdmaChannel* channel, string name)
     : RdmaBuffer(channel, name) {}
 
+void RdmaTensorBuffer::OnWriteComplete() {
+  mutex_lock lock{mu_};
+  in_flight_tensor_ = Tensor();
+}
+
 // Send the next ack from the buffer's job queue.
 void RdmaAckBuffer::SendNextItem() {
   uint32_t imm_data = LookupBufferIndex("rx_ack_buffer");
@@ -709,13 +838,27 @@ void RdmaTensorBuffer::SendNextItem() {
       Tensor copy;
       StringPiece copy_buf;
       TensorProto proto;
+      // Set if the NIC can read the tensor from GPU memory directly.
+      ibv_mr* gpu_mr = nullptr;
       if (src_dev->tensorflow_gpu_device_info() &&
           (!send_args.alloc_attrs.on_host())) {
         CHECK(send_args.device_context)
           << "send dev name: " << src_dev->name()
           << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
 
-        if (can_memcpy) {
+        if (can_memcpy && !is_dead && in.TotalBytes() > 0) {
+          gpu_mr = channel_->adapter_->FindMemoryRegion(DMAHelper::base(&in),
+                                                        in.TotalBytes());
+        }
+        if (gpu_mr != nullptr) {
+#if GOOGLE_CUDA
+          // Wait for the kernels that produce the tensor, since the NIC
+          // reads it without going through the send stream.
+          CHECK(send_args.device_context->stream()->BlockHostUntilDone())
+              << "wait for tensor on gpu";
+#endif  // GOOGLE_CUDA
+          copy_buf = in.tensor_data();
+        } else if (can_memcpy) {
           AllocatorAttributes host_alloc_attrs;
           host_alloc_attrs.set_gpu_compatible(true);
           host_alloc_attrs.set_on_host(true);
@@ -799,7 +942,9 @@ void RdmaTensorBuffer::SendNextItem() {
               static_cast<void*>(static_cast<char*>(buffer_) +
                                  RdmaMessage::kTensorBufferStartIndex);
           CHECK(tensor_bytes + RdmaMessage::kTensorBufferStartIndex <= size_);
-          if (can_memcpy) {
+          if (gpu_mr != nullptr) {
+            // the tensor is sent from GPU memory below.
+          } else if (can_memcpy) {
             CHECK(copy_buf.size() == tensor_bytes)
                << "unexpected tensor size: "
                << copy_buf.size()
@@ -812,7 +957,17 @@ void RdmaTensorBuffer::SendNextItem() {
         } else {
           buffer_size = RdmaMessage::kMessageTotalBytes;
         }
-        Write(imm_data, buffer_size);
+        if (gpu_mr != nullptr) {
+          {
+            mutex_lock lock{mu_};
+            // keep the tensor alive until the write completes.
+            in_flight_tensor_ = in;
+          }
+          Write(imm_data, RdmaMessage::kTensorBufferStartIndex,
+                copy_buf.data(), tensor_bytes, gpu_mr->lkey);
+        } else {
+          Write(imm_data, buffer_size);
+        }
       } else {
         mu_.unlock();
         // put back the key since it is not sent;
@@ -863,7 +1018,8 @@ string RdmaMessage::CreateMessage(const RdmaMessage& rm) {
   }
   // step_id
   if ((rm.type_ == RDMA_MESSAGE_TENSOR_WRITE) ||
-      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST)) {
+      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST) ||
+      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE)) {
     memcpy(&message[kStepIdStartIndex], &rm.step_id_, sizeof(rm.step_id_));
   }
   // is_dead, data_type, tensor_shape, tensor_bytes
@@ -905,7 +1061,8 @@ void RdmaMessage::ParseMessage(RdmaMessage& rm, void* buffer) {
   }
   // step_id
   if ((rm.type_ == RDMA_MESSAGE_TENSOR_WRITE) ||
-      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST)) {
+      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST) ||
+      (rm.type_ == RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE)) {
     memcpy(&rm.step_id_, &message[kStepIdStartIndex], sizeof(rm.step_id_));
   }
   // data_type, tensor_bytes, tensor_shape, is_dead
@@ -28,6 +28,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/env.h"
@@ -57,7 +58,10 @@ enum RdmaMessageType {
   RDMA_MESSAGE_BUFFER_REQUEST,
   RDMA_MESSAGE_BUFFER_RESPONSE,
   RDMA_MESSAGE_TENSOR_REQUEST,
-  RDMA_MESSAGE_TENSOR_WRITE
+  RDMA_MESSAGE_TENSOR_WRITE,
+  // A TENSOR_REQUEST that also marks the tensor buffer of the same name
+  // idle, saving a separate BUFFER_IDLE message.
+  RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE
 };
 class RdmaBuffer;
 // Class that represents the Rdma Adapter.
@@ -78,8 +82,18 @@ class RdmaAdapter {
   // Adapter name, e.g. mlx5_0.
   string name() const;
   void Process_CQ();
+  // Registers the memory regions of the GPU allocators on the adapter's
+  // PCIe bus with the adapter, so that tensors in GPU memory can be sent
+  // without staging them in host memory (GPUDirect RDMA). Does nothing
+  // unless the nv_peer_mem kernel module is loaded.
+  void RegisterGPUMemory();
+  // Returns the registered GPU memory region that holds the "length" bytes
+  // at "addr", or nullptr if there is none.
+  ibv_mr* FindMemoryRegion(const void* addr, size_t length) const;
 
  protected:
+  void InsertMemoryRegion(void* addr, size_t length);
+
   static const int MAX_CONCURRENT_WRITES = 1000;
   ibv_context* context_;
   // ibverbs protection domain
@@ -94,6 +108,9 @@ class RdmaAdapter {
   const WorkerEnv* worker_env_;
   // thread for cq.
   std::unique_ptr<Thread> polling_thread_;
+  mutable mutex mr_mu_;
+  // Registered GPU memory regions, sorted by address.
+  std::vector<ibv_mr*> gpu_mrs_ GUARDED_BY(mr_mu_);
 };
 
 // Class that represents a connection to a remote Rdma peer.
@@ -128,6 +145,14 @@ class RdmaChannel {
   void InsertRecvCallback(const string& key, std::function<void()> recv_done);
   void RemoveRecvCallback(const string& key);
   void RunRecvCallback(const string& key);
+  // Receiver-side bookkeeping of the remote tensor buffer for "key".
+  // StartTensorRequest() is called before requesting the tensor, and
+  // returns true if the request must also mark the buffer idle.
+  // FinishTensorRequest() is called once the tensor has been copied out of
+  // the local buffer, and returns true if a BUFFER_IDLE message must be
+  // sent now rather than with the next request.
+  bool StartTensorRequest(const string& key);
+  bool FinishTensorRequest(const string& key);
   static const int kNumMessageBuffers = 4;
 
  protected:
@@ -150,6 +175,15 @@ class RdmaChannel {
   BufferIndexNameTable buffer_index_name_table_ GUARDED_BY(bt_mu_);
   typedef std::unordered_map<string, uint32_t> BufferNameIndexTable;
   BufferNameIndexTable buffer_name_index_table_ GUARDED_BY(bt_mu_);
+  struct RecvBufferState {
+    // Requests sent whose tensors have not been consumed yet.
+    int num_outstanding = 0;
+    // Whether the buffer was consumed but the sender not yet told so.
+    bool idle_unreported = false;
+  };
+  mutex rs_mu_;
+  std::unordered_map<string, RecvBufferState> recv_buffer_states_
+      GUARDED_BY(rs_mu_);
   RdmaBuffer* tx_message_buffer_;
   RdmaBuffer* rx_message_buffer_;
   RdmaBuffer* tx_ack_buffer_;
@@ -182,14 +216,23 @@ class RdmaBuffer {
   void FreeBuffer();
   void EnqueueItem(string Item);
   virtual void SendNextItem(){};
+  // Called when an RDMA write from this buffer has completed.
+  virtual void OnWriteComplete() {}
   void CreateCPUBuffer(size_t size, bool lock = true);
   void SetRemoteMR(RemoteMR rmi, bool override);
   uint32_t LookupBufferIndex(const string& buffer_name) {
     return const_cast<RdmaChannel*>(channel_)->LookupBufferIndex(buffer_name);
   }
   void Write(uint32_t imm_data, size_t buffer_size);
+  // Rdma-Write the first "header_size" bytes of the buffer followed by the
+  // "data_size" bytes at "data", which belong to the memory region with
+  // local key "data_lkey".
+  void Write(uint32_t imm_data, size_t header_size, const void* data,
+             size_t data_size, uint32_t data_lkey);
 
  protected:
+  void PostWrite(uint32_t imm_data, ibv_sge* sg_list, int num_sge);
+
   const RdmaChannel* channel_;
   void* buffer_ = nullptr;
   bool buffer_on_host_ = true;
@@ -225,6 +268,11 @@ class RdmaTensorBuffer : public RdmaBuffer {
   explicit RdmaTensorBuffer(RdmaChannel* channel, string name);
   virtual ~RdmaTensorBuffer() override {}
   void SendNextItem() override;
+  void OnWriteComplete() override;
+
+ private:
+  // A GPU tensor that is being written to the remote directly.
+  Tensor in_flight_tensor_ GUARDED_BY(mu_);
 };
 
 struct RdmaMessage {
@@ -137,21 +137,27 @@ void RdmaRemoteRendezvous::RecvFromRemoteAsync(
     }
 
     rc->RemoveRecvCallback(key_with_step_id);
-    // create message
-    RdmaMessage br;
-    br.type_ = RDMA_MESSAGE_BUFFER_IDLE;
-    br.name_size_ = key.size();
-    br.name_ = key;
-    string message = RdmaMessage::CreateMessage(br);
-    RdmaBuffer* tb = rc->tx_message_buffer_;
-    tb->EnqueueItem(message);
-    tb->SendNextItem();
+    // Release the remote buffer right away only if another request for the
+    // same tensor is pending; otherwise the next request carries it.
+    if (rc->FinishTensorRequest(key)) {
+      // create message
+      RdmaMessage br;
+      br.type_ = RDMA_MESSAGE_BUFFER_IDLE;
+      br.name_size_ = key.size();
+      br.name_ = key;
+      string message = RdmaMessage::CreateMessage(br);
+      RdmaBuffer* tb = rc->tx_message_buffer_;
+      tb->EnqueueItem(message);
+      tb->SendNextItem();
+    }
     done(s, Args(), recv_args, val, rm.is_dead_);
   });
   // append key to message queue
   RdmaBuffer* rb = rc->tx_message_buffer_;
   RdmaMessage rm;
-  rm.type_ = RDMA_MESSAGE_TENSOR_REQUEST;
+  rm.type_ = rc->StartTensorRequest(key)
+                 ? RDMA_MESSAGE_TENSOR_REQUEST_WITH_IDLE
+                 : RDMA_MESSAGE_TENSOR_REQUEST;
   rm.name_size_ = key.size();
   rm.name_ = key;
   rm.step_id_ = step_id_;
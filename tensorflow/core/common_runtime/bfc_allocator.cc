@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -27,12 +30,36 @@ limitations under the License.
 
 namespace tensorflow {
 
+// A cache of recently freed chunks shared by the threads that hash to it.
+struct BFCAllocator::ThreadCache {
+  struct CachedChunk {
+    void* ptr;
+    size_t size;
+  };
+
+  mutex mu;
+  // Deallocated pointers whose chunks have not been looked up yet.
+  std::vector<void*> pending_frees GUARDED_BY(mu);
+  // Free chunks owned by this cache, by bin.
+  std::vector<CachedChunk> bins[kNumBins] GUARDED_BY(mu);
+};
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name)
+    : BFCAllocator(sub_allocator, total_memory, allow_growth, name,
+                   ThreadCacheOptions()) {}
+
+BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
+                           bool allow_growth, const string& name,
+                           const ThreadCacheOptions& cache_options)
     : suballocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      cache_options_(cache_options) {
+  if (cache_options_.num_caches > 0) {
+    thread_caches_.reset(new ThreadCache[cache_options_.num_caches]);
+  }
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -150,6 +177,7 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
   c->allocation_id = -1;
   c->prev = kInvalidChunkHandle;
   c->next = kInvalidChunkHandle;
+  c->stream = -1;
 
   region_manager_.set_handle(c->ptr, h);
 
@@ -187,15 +215,16 @@ void BFCAllocator::DeallocateChunk(ChunkHandle h) {
 }
 
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes) {
+  const int stream = CurrentStream();
   // Fast path: Try once to allocate without getting the retry_helper_ involved
-  void* r = AllocateRawInternal(unused_alignment, num_bytes, false);
+  void* r = AllocateRawInternal(unused_alignment, num_bytes, false, stream);
   if (r != nullptr) {
     return r;
   } else {
     static const int64 kMaxMillisToWait = 10000;  // 10 seconds
     return retry_helper_.AllocateRaw(
-        [this](size_t a, size_t nb, bool v) {
-          return AllocateRawInternal(a, nb, v);
+        [this, stream](size_t a, size_t nb, bool v) {
+          return AllocateRawInternal(a, nb, v, stream);
         },
         kMaxMillisToWait, unused_alignment, num_bytes);
   }
@@ -206,7 +235,8 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
-    void* result = AllocateRawInternal(unused_alignment, num_bytes, false);
+    void* result = AllocateRawInternal(unused_alignment, num_bytes, false,
+                                       CurrentStream());
     if (result == nullptr) {
       // The counter incrementing is not thread-safe. But we don't really care.
       // TODO(zhengxq): we should implement a LOG_FIRST_N and LOG_EVERY_N for
@@ -239,7 +269,7 @@ size_t BFCAllocator::RoundedBytes(size_t bytes) {
 
 void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
                                         size_t num_bytes,
-                                        bool dump_log_on_failure) {
+                                        bool dump_log_on_failure, int stream) {
   if (num_bytes == 0) {
     LOG(ERROR) << "tried to allocate 0 bytes";
     return nullptr;
@@ -249,18 +279,38 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (thread_caches_ != nullptr && stream < 0 &&
+      rounded_bytes <= cache_options_.max_chunk_bytes) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
-  mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-  if (ptr != nullptr) {
-    return ptr;
+  {
+    mutex_lock l(lock_);
+    void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, stream);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+
+    // Try to extend
+    if (Extend(rounded_bytes)) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, stream);
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
   }
 
-  // Try to extend
-  if (Extend(rounded_bytes)) {
-    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  // The chunks held by the thread caches may be enough to satisfy the
+  // request once they are coalesced.
+  if (thread_caches_ != nullptr && FlushThreadCaches() > 0) {
+    mutex_lock l(lock_);
+    void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, stream);
     if (ptr != nullptr) {
       return ptr;
     }
@@ -270,6 +320,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
   if (dump_log_on_failure) {
+    mutex_lock l(lock_);
     LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
                  << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
                  << ".  Current allocation summary follows.";
@@ -280,54 +331,76 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
 }
 
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
-                                 size_t num_bytes) {
+                                 size_t num_bytes, int stream) {
+  if (stream >= static_cast<int>(stream_frees_.size())) {
+    stream_frees_.resize(stream + 1);
+  }
   // First identify the first bin that could satisfy rounded_bytes.
   for (; bin_num < kNumBins; bin_num++) {
     // Start searching from the first bin for the smallest chunk that fits
-    // rounded_bytes.
+    // rounded_bytes.  Chunks that are still used by work queued on another
+    // stream are only taken by stream-ordered allocations, and only if the
+    // bin has no other chunk that fits.
     Bin* b = BinFromIndex(bin_num);
+    auto found = b->free_chunks.end();
     for (auto citer = b->free_chunks.begin(); citer != b->free_chunks.end();
          ++citer) {
-      const BFCAllocator::ChunkHandle h = (*citer);
-      BFCAllocator::Chunk* chunk = ChunkFromHandle(h);
+      BFCAllocator::Chunk* chunk = ChunkFromHandle(*citer);
       DCHECK(!chunk->in_use());
-      if (chunk->size >= rounded_bytes) {
-        // We found an existing chunk that fits us that wasn't in use, so remove
-        // it from the free bin structure prior to using.
-        RemoveFreeChunkIterFromBin(&b->free_chunks, citer);
-
-        // If we can break the size of the chunk into two reasonably
-        // large pieces, do so.
-        //
-        // TODO(vrv): What should be the criteria when deciding when
-        // to split?
-        if (chunk->size >= rounded_bytes * 2) {
-          SplitChunk(h, rounded_bytes);
-          chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
-        }
-
-        // The requested size of the returned chunk is what the user
-        // has allocated.
-        chunk->requested_size = num_bytes;
-        // Assign a unique id and increment the id counter, marking the
-        // chunk as being in use.
-        chunk->allocation_id = next_allocation_id_++;
-
-        // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.max_bytes_in_use =
-            std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
-        stats_.max_alloc_size =
-            std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
-
-        VLOG(4) << "Returning: " << chunk->ptr;
-        if (VLOG_IS_ON(4)) {
-          LOG(INFO) << "A: " << RenderOccupancy();
-        }
-        return chunk->ptr;
+      if (chunk->size < rounded_bytes) continue;
+      const int pending_stream = PendingStream(chunk);
+      if (pending_stream < 0 || pending_stream == stream) {
+        found = citer;
+        break;
+      }
+      if (stream >= 0 && found == b->free_chunks.end()) {
+        found = citer;
       }
     }
+    if (found == b->free_chunks.end()) continue;
+
+    const BFCAllocator::ChunkHandle h = (*found);
+    BFCAllocator::Chunk* chunk = ChunkFromHandle(h);
+    const int pending_stream = PendingStream(chunk);
+    if (pending_stream >= 0 && pending_stream != stream) {
+      WaitForStream(stream, pending_stream);
+    }
+
+    // We found an existing chunk that fits us that wasn't in use, so remove
+    // it from the free bin structure prior to using.
+    RemoveFreeChunkIterFromBin(&b->free_chunks, found);
+
+    // If we can break the size of the chunk into two reasonably
+    // large pieces, do so.
+    //
+    // TODO(vrv): What should be the criteria when deciding when
+    // to split?
+    if (chunk->size >= rounded_bytes * 2) {
+      SplitChunk(h, rounded_bytes);
+      chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
+    }
+
+    // The requested size of the returned chunk is what the user
+    // has allocated.
+    chunk->requested_size = num_bytes;
+    chunk->stream = stream;
+    // Assign a unique id and increment the id counter, marking the
+    // chunk as being in use.
+    chunk->allocation_id = next_allocation_id_++;
+
+    // Update stats.
+    ++stats_.num_allocs;
+    stats_.bytes_in_use += chunk->size;
+    stats_.max_bytes_in_use =
+        std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+    stats_.max_alloc_size =
+        std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
+
+    VLOG(4) << "Returning: " << chunk->ptr;
+    if (VLOG_IS_ON(4)) {
+      LOG(INFO) << "A: " << RenderOccupancy();
+    }
+    return chunk->ptr;
   }
 
   return nullptr;
@@ -352,6 +425,10 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
   // The new chunk is not in use.
   new_chunk->allocation_id = -1;
 
+  // Work queued on the stream of c may still be using the new chunk.
+  new_chunk->stream = c->stream;
+  new_chunk->stream_free = c->stream_free;
+
   // Maintain the pointers.
   // c <-> c_neighbor becomes
   // c <-> new_chunk <-> c_neighbor
@@ -373,11 +450,127 @@ void BFCAllocator::DeallocateRaw(void* ptr) {
   retry_helper_.NotifyDealloc();
 }
 
+BFCAllocator::ThreadCache* BFCAllocator::CacheForCurrentThread() {
+  const size_t h = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return &thread_caches_[h % cache_options_.num_caches];
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes) {
+  ThreadCache* cache = CacheForCurrentThread();
+  const BinNum bin_num = BinNumForSize(rounded_bytes);
+  mutex_lock cache_lock(cache->mu);
+  std::vector<ThreadCache::CachedChunk>* cached = &cache->bins[bin_num];
+  // Every chunk in the bin is smaller than 2 * rounded_bytes, so any chunk
+  // that is large enough is one FindChunkPtr() would not split either.
+  auto take_cached = [cached, rounded_bytes]() -> void* {
+    // Most recently freed chunks first.
+    for (size_t i = cached->size(); i > 0; --i) {
+      if ((*cached)[i - 1].size >= rounded_bytes) {
+        void* ptr = (*cached)[i - 1].ptr;
+        (*cached)[i - 1] = cached->back();
+        cached->pop_back();
+        return ptr;
+      }
+    }
+    return nullptr;
+  };
+  void* ptr = take_cached();
+  if (ptr != nullptr) {
+    num_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  // Refill under the allocator lock. The buffered deallocations go first,
+  // since they may well contain a chunk of the right size.
+  mutex_lock l(lock_);
+  DrainThreadCacheLocked(cache, true);
+  ptr = take_cached();
+  if (ptr != nullptr) {
+    num_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+  num_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+  ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, -1);
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  for (int i = 1; i < cache_options_.refill_chunks &&
+                  cached->size() < cache_options_.max_chunks_per_bin;
+       ++i) {
+    void* extra = FindChunkPtr(bin_num, rounded_bytes, rounded_bytes, -1);
+    if (extra == nullptr) break;
+    // Chunks parked in a cache do not count as allocations.
+    --stats_.num_allocs;
+    const size_t size = ChunkFromHandle(region_manager_.get_handle(extra))->size;
+    cached->push_back({extra, size});
+  }
+  return ptr;
+}
+
+int64 BFCAllocator::DrainThreadCacheLocked(ThreadCache* cache, bool keep) {
+  int64 num_freed = 0;
+  for (void* ptr : cache->pending_frees) {
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+    CHECK(h != kInvalidChunkHandle);
+    // Chunks of stream-ordered allocations are never cached, since the
+    // caches do not know about streams.
+    if (keep && ChunkFromHandle(h)->stream < 0) {
+      const size_t size = ChunkFromHandle(h)->size;
+      if (size <= cache_options_.max_chunk_bytes) {
+        std::vector<ThreadCache::CachedChunk>* cached =
+            &cache->bins[BinNumForSize(size)];
+        if (cached->size() < cache_options_.max_chunks_per_bin) {
+          cached->push_back({ptr, size});
+          continue;
+        }
+      }
+    }
+    FreeAndMaybeCoalesce(h);
+    ++num_freed;
+  }
+  cache->pending_frees.clear();
+  if (!keep) {
+    for (BinNum b = 0; b < kNumBins; b++) {
+      for (const ThreadCache::CachedChunk& chunk : cache->bins[b]) {
+        FreeAndMaybeCoalesce(region_manager_.get_handle(chunk.ptr));
+        ++num_freed;
+      }
+      cache->bins[b].clear();
+    }
+  }
+  return num_freed;
+}
+
+int64 BFCAllocator::FlushThreadCaches() {
+  if (thread_caches_ == nullptr) return 0;
+  int64 num_freed = 0;
+  for (int i = 0; i < cache_options_.num_caches; ++i) {
+    ThreadCache* cache = &thread_caches_[i];
+    mutex_lock cache_lock(cache->mu);
+    mutex_lock l(lock_);
+    num_freed += DrainThreadCacheLocked(cache, false);
+  }
+  return num_freed;
+}
+
 void BFCAllocator::DeallocateRawInternal(void* ptr) {
   if (ptr == nullptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (thread_caches_ != nullptr) {
+    // Defer the chunk lookup, which needs the allocator lock, until a batch
+    // of deallocations has accumulated.
+    ThreadCache* cache = CacheForCurrentThread();
+    mutex_lock cache_lock(cache->mu);
+    cache->pending_frees.push_back(ptr);
+    if (cache->pending_frees.size() >= cache_options_.free_batch_size) {
+      mutex_lock l(lock_);
+      DrainThreadCacheLocked(cache, true);
+    }
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
@@ -420,6 +613,12 @@ void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
   // Set the new size
   c1->size += c2->size;
 
+  // TryToCoalesce() only merges chunks that wait for the same stream, if
+  // any.
+  if (PendingStream(c1) >= 0) {
+    c1->stream_free = std::max(c1->stream_free, c2->stream_free);
+  }
+
   DeleteChunk(h2);
 }
 
@@ -468,22 +667,40 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
 
+  // Work queued on the stream of a stream-ordered allocation may still be
+  // using the chunk.
+  if (c->stream >= 0) {
+    c->stream_free = ++stream_frees_[c->stream].num_frees;
+  }
+
   // This chunk is no longer in-use, consider coalescing the chunk
   // with adjacent chunks.
+  InsertFreeChunkIntoBin(TryToCoalesce(h));
+}
+
+BFCAllocator::ChunkHandle BFCAllocator::TryToCoalesce(ChunkHandle h) {
+  Chunk* c = ChunkFromHandle(h);
+  // Only free chunks that wait for the same stream, or for none, are
+  // merged, so that a chunk still used on one stream does not make a large
+  // free chunk wait for that stream.
+  auto can_merge = [this](const Chunk* c1, const Chunk* c2) {
+    return PendingStream(c1) == PendingStream(c2);
+  };
+  bool uncoalesced = false;
+
   ChunkHandle chunk_to_reassign = h;
 
   // If the next chunk is free, coalesce the two
   if (c->next != kInvalidChunkHandle) {
     Chunk* cnext = ChunkFromHandle(c->next);
     if (!cnext->in_use()) {
-      //      VLOG(8) << "Chunk at " << cnext->ptr << " merging with c " <<
-      //      c->ptr;
-
-      chunk_to_reassign = h;
-
-      // Deletes c->next
-      RemoveFreeChunkFromBin(c->next);
-      Merge(h, ChunkFromHandle(h)->next);
+      if (can_merge(c, cnext)) {
+        // Deletes c->next
+        RemoveFreeChunkFromBin(c->next);
+        Merge(h, ChunkFromHandle(h)->next);
+      } else {
+        uncoalesced = true;
+      }
     }
   }
 
@@ -492,19 +709,78 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   if (c->prev != kInvalidChunkHandle) {
     Chunk* cprev = ChunkFromHandle(c->prev);
     if (!cprev->in_use()) {
-      //      VLOG(8) << "Chunk at " << c->ptr << " merging into c->prev "
-      //       << cprev->ptr;
+      if (can_merge(cprev, c)) {
+        chunk_to_reassign = c->prev;
+
+        // Deletes c
+        RemoveFreeChunkFromBin(c->prev);
+        Merge(ChunkFromHandle(h)->prev, h);
+      } else {
+        uncoalesced = true;
+      }
+    }
+  }
 
-      chunk_to_reassign = c->prev;
+  if (uncoalesced) {
+    uncoalesced_chunks_.push_back(ChunkFromHandle(chunk_to_reassign)->ptr);
+  }
+  return chunk_to_reassign;
+}
 
-      // Deletes c
-      RemoveFreeChunkFromBin(c->prev);
-      Merge(ChunkFromHandle(h)->prev, h);
-      c = ChunkFromHandle(h);
-    }
+int BFCAllocator::PendingStream(const Chunk* c) {
+  if (c->stream >= 0 &&
+      c->stream_free > stream_frees_[c->stream].num_retired) {
+    return c->stream;
   }
+  return -1;
+}
 
-  InsertFreeChunkIntoBin(chunk_to_reassign);
+int BFCAllocator::AllocationStream(const void* ptr) {
+  mutex_lock l(lock_);
+  if (!region_manager_.Contains(ptr)) return -1;
+  BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+  if (h == kInvalidChunkHandle) return -1;
+  const Chunk* c = ChunkFromHandle(h);
+  return c->in_use() ? c->stream : -1;
+}
+
+bool BFCAllocator::TakeStreamFrees(int stream, int64* num_frees) {
+  mutex_lock l(lock_);
+  if (stream < 0 || stream >= static_cast<int>(stream_frees_.size())) {
+    return false;
+  }
+  StreamFrees* frees = &stream_frees_[stream];
+  if (frees->num_taken == frees->num_frees) return false;
+  frees->num_taken = frees->num_frees;
+  *num_frees = frees->num_frees;
+  return true;
+}
+
+void BFCAllocator::RetireStreamFrees(int stream, int64 num_frees) {
+  {
+    mutex_lock l(lock_);
+    DCHECK_LT(stream, static_cast<int>(stream_frees_.size()));
+    StreamFrees* frees = &stream_frees_[stream];
+    if (num_frees <= frees->num_retired) return;
+    frees->num_retired = num_frees;
+
+    // Chunks that now wait for fewer streams may merge with their
+    // neighbors.
+    std::vector<void*> uncoalesced;
+    uncoalesced.swap(uncoalesced_chunks_);
+    std::sort(uncoalesced.begin(), uncoalesced.end());
+    uncoalesced.erase(std::unique(uncoalesced.begin(), uncoalesced.end()),
+                      uncoalesced.end());
+    for (void* ptr : uncoalesced) {
+      BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+      if (h == kInvalidChunkHandle) continue;
+      const Chunk* c = ChunkFromHandle(h);
+      if (c->in_use() || c->bin_num == kInvalidBinNum) continue;
+      RemoveFreeChunkFromBin(h);
+      InsertFreeChunkIntoBin(TryToCoalesce(h));
+    }
+  }
+  retry_helper_.NotifyDealloc();
 }
 
 void BFCAllocator::AddAllocVisitor(Visitor visitor) {
@@ -545,6 +821,11 @@ int64 BFCAllocator::AllocationId(void* ptr) {
   return c->allocation_id;
 }
 
+bool BFCAllocator::Owns(const void* ptr) {
+  mutex_lock l(lock_);
+  return region_manager_.Contains(ptr);
+}
+
 namespace {
 
 void RenderRegion(char* rendered, const size_t resolution,
@@ -703,8 +984,25 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
 }
 
 void BFCAllocator::GetStats(AllocatorStats* stats) {
-  mutex_lock l(lock_);
-  *stats = stats_;
+  {
+    mutex_lock l(lock_);
+    *stats = stats_;
+    stats->bytes_reserved = total_region_allocated_bytes_;
+    // Bins hold increasing sizes and sort their chunks by size, so the
+    // largest free chunk is the last one of the last non-empty bin.
+    for (BinNum b = kNumBins - 1; b >= 0; --b) {
+      const Bin* bin = BinFromIndex(b);
+      if (!bin->free_chunks.empty()) {
+        stats->largest_free_block_bytes =
+            ChunkFromHandle(*bin->free_chunks.rbegin())->size;
+        break;
+      }
+    }
+  }
+  const int64 hits = num_cache_hits_.load(std::memory_order_relaxed);
+  stats->num_allocs += hits;
+  stats->num_cache_hits = hits;
+  stats->num_cache_misses = num_cache_misses_.load(std::memory_order_relaxed);
 }
 
 }  // namespace tensorflow
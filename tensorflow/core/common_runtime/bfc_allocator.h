@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -43,9 +44,37 @@ namespace tensorflow {
 // all requests to allocate memory go through this interface.
 class BFCAllocator : public VisitableAllocator {
  public:
+  // Options for the optional caches of recently freed small chunks that sit
+  // in front of the allocator lock. Threads are mapped onto 'num_caches'
+  // caches by hashing their id. Deallocations are buffered in the cache of
+  // the calling thread and handed to the allocator in batches; freed chunks
+  // of at most 'max_chunk_bytes' bytes are kept in the cache, by bin, and
+  // reused by later allocations from threads mapped to the same cache
+  // without taking the allocator lock. On a cache miss the cache is
+  // refilled with up to 'refill_chunks' chunks of the requested size.
+  //
+  // A cached chunk stays in use from the point of view of the allocator:
+  // it is neither coalesced nor counted as free in AllocatorStats, and
+  // RequestedSize() and AllocationId() of a reused chunk report the values
+  // of the allocation that took it out of the bins. All caches are flushed
+  // before an allocation is allowed to fail.
+  struct ThreadCacheOptions {
+    // 0 disables the caches.
+    int num_caches = 0;
+    size_t max_chunk_bytes = 64 << 10;
+    // Maximum number of chunks a cache holds per bin.
+    int max_chunks_per_bin = 64;
+    int refill_chunks = 8;
+    // Number of deallocations buffered before they are processed.
+    int free_batch_size = 32;
+  };
+
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name);
+  BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
+               bool allow_growth, const string& name,
+               const ThreadCacheOptions& cache_options);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -69,11 +98,59 @@ class BFCAllocator : public VisitableAllocator {
 
   void GetStats(AllocatorStats* stats) override;
 
+  // Returns true if 'ptr' points into memory obtained by this allocator
+  // from its sub-allocator, whether or not that memory is currently
+  // allocated.
+  bool Owns(const void* ptr);
+
+  // Returns every chunk held by the thread caches to the allocator. Returns
+  // the number of chunks that were returned.
+  int64 FlushThreadCaches();
+
+  // Stream-ordered allocation.
+  //
+  // A subclass whose memory is used by work queued on streams can tag an
+  // allocation with the stream the caller queues its work on, by returning
+  // a small non-negative stream id from CurrentStream(). When such a chunk
+  // is freed, work queued on its stream earlier may still be using it. Until
+  // the stream is known to have passed that point, the chunk is only handed
+  // out to allocations on the same stream, which run after that work, or to
+  // allocations on other streams after WaitForStream() has made them wait
+  // for its stream. Untagged allocations skip it, and it is only coalesced
+  // with free chunks that wait for the same stream.
+  //
+  // Stream-ordered allocations bypass the thread caches.
+
+  // Returns the stream the in-use allocation 'ptr' was made on, or -1 if it
+  // is not a stream-ordered allocation of this allocator.
+  int AllocationStream(const void* ptr);
+
+  // Returns true if chunks allocated on 'stream' have been freed since the
+  // last call, and sets '*num_frees' to the number of such frees so far. The
+  // caller should then pass '*num_frees' to RetireStreamFrees() once the
+  // work currently queued on 'stream' has completed.
+  bool TakeStreamFrees(int stream, int64* num_frees);
+
+  // Tells the allocator that the work queued on 'stream' before its first
+  // 'num_frees' frees has completed, so their chunks can be used by any
+  // allocation.
+  void RetireStreamFrees(int stream, int64 num_frees);
+
+ protected:
+  // Returns the stream the calling thread allocates on, or -1 to make its
+  // allocations untagged.
+  virtual int CurrentStream() { return -1; }
+
+  // Makes 'stream' wait for the work queued on 'other' so far. Called with
+  // the allocator lock held.
+  virtual void WaitForStream(int stream, int other) {}
+
  private:
   struct Bin;
+  struct ThreadCache;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
-                            bool dump_log_on_failure);
+                            bool dump_log_on_failure, int stream);
   void DeallocateRawInternal(void* ptr);
 
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
@@ -119,6 +196,12 @@ class BFCAllocator : public VisitableAllocator {
     // What bin are we in?
     BinNum bin_num = kInvalidBinNum;
 
+    // The stream of the stream-ordered allocation the chunk belongs to, or
+    // -1.  A free chunk with a stream may still be used by work queued on
+    // the stream until the stream's free number 'stream_free' is retired.
+    int stream = -1;
+    int64 stream_free = 0;
+
     bool in_use() const { return allocation_id != -1; }
 
     string DebugString(BFCAllocator* a,
@@ -271,6 +354,12 @@ class BFCAllocator : public VisitableAllocator {
 
     const std::vector<AllocationRegion>& regions() const { return regions_; }
 
+    bool Contains(const void* p) const {
+      auto entry =
+          std::upper_bound(regions_.begin(), regions_.end(), p, &Comparator);
+      return entry != regions_.end() && entry->ptr() <= p;
+    }
+
    private:
     static bool Comparator(const void* ptr, const AllocationRegion& other) {
       return ptr < other.end_ptr();
@@ -305,9 +394,9 @@ class BFCAllocator : public VisitableAllocator {
   bool Extend(size_t rounded_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Returns a pointer to an underlying allocated chunk of size
-  // 'rounded_bytes'.
-  void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes)
-      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // 'rounded_bytes', allocated on 'stream' (-1 for an untagged allocation).
+  void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
+                     int stream) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
@@ -322,6 +411,14 @@ class BFCAllocator : public VisitableAllocator {
   // possible.
   void FreeAndMaybeCoalesce(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Coalesces the free chunk 'h', which is in no bin, with its free
+  // neighbors where their streams allow it, and returns the handle of the
+  // resulting chunk.
+  ChunkHandle TryToCoalesce(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the stream whose work may still use the free chunk 'c', or -1.
+  int PendingStream(const Chunk* c) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Adds the chunk 'h' to the proper free bin.
   void InsertFreeChunkIntoBin(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -344,6 +441,20 @@ class BFCAllocator : public VisitableAllocator {
 
   Chunk* ChunkFromHandle(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns the thread cache of the calling thread.
+  ThreadCache* CacheForCurrentThread();
+
+  // Tries to satisfy an allocation of 'rounded_bytes' from the cache of the
+  // calling thread, refilling the cache from the bins on a miss.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes);
+
+  // Processes the buffered deallocations of 'cache': chunks small enough to
+  // cache go into its bins while there is room, the others are freed. If
+  // 'keep' is false all of them are freed, together with the cached chunks.
+  // Returns the number of chunks freed.
+  int64 DrainThreadCacheLocked(ThreadCache* cache, bool keep)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -411,6 +522,24 @@ class BFCAllocator : public VisitableAllocator {
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // The frees of the chunks allocated on each stream, by stream id.
+  struct StreamFrees {
+    int64 num_frees = 0;
+    // Frees returned by TakeStreamFrees().
+    int64 num_taken = 0;
+    int64 num_retired = 0;
+  };
+  std::vector<StreamFrees> stream_frees_ GUARDED_BY(lock_);
+
+  // The addresses of free chunks that could not be coalesced with a free
+  // neighbor because of their streams. Retried when frees are retired.
+  std::vector<void*> uncoalesced_chunks_ GUARDED_BY(lock_);
+
+  const ThreadCacheOptions cache_options_;
+  std::unique_ptr<ThreadCache[]> thread_caches_;
+  std::atomic<int64> num_cache_hits_{0};
+  std::atomic<int64> num_cache_misses_{0};
+
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
 
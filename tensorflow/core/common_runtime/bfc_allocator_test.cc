@@ -0,0 +1,265 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, static_cast<int>(alignment));
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+BFCAllocator::ThreadCacheOptions CacheOptions(int num_caches) {
+  BFCAllocator::ThreadCacheOptions options;
+  options.num_caches = num_caches;
+  return options;
+}
+
+TEST(BFCAllocatorTest, Owns) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "test");
+  void* ptr = a.AllocateRaw(64, 1024);
+  EXPECT_TRUE(a.Owns(ptr));
+  EXPECT_TRUE(a.Owns(static_cast<char*>(ptr) + 1023));
+  a.DeallocateRaw(ptr);
+  // Freed memory still belongs to the allocator's regions.
+  EXPECT_TRUE(a.Owns(ptr));
+
+  char on_stack[16];
+  EXPECT_FALSE(a.Owns(on_stack));
+  EXPECT_FALSE(a.Owns(nullptr));
+}
+
+TEST(BFCAllocatorTest, NoDupsWithThreadCache) {
+  BFCAllocator a(new HostSubAllocator, 1 << 26, false, "test",
+                 CacheOptions(1));
+  std::vector<void*> ptrs;
+  for (int s = 1; s < 1024; s++) {
+    ptrs.push_back(a.AllocateRaw(1, s));
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < ptrs.size(); i++) {
+    ASSERT_NE(ptrs[i], ptrs[i - 1]);  // No dups
+    size_t req_size = a.RequestedSize(ptrs[i - 1]);
+    ASSERT_GT(req_size, 0);
+    ASSERT_GE(static_cast<char*>(ptrs[i]) - static_cast<char*>(ptrs[i - 1]),
+              req_size);
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  a.FlushThreadCaches();
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1023, stats.num_allocs);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesFreedChunks) {
+  BFCAllocator::ThreadCacheOptions options = CacheOptions(1);
+  options.free_batch_size = 1;
+  BFCAllocator a(new HostSubAllocator, 1 << 26, false, "test", options);
+
+  void* first = a.AllocateRaw(64, 1024);
+  a.DeallocateRaw(first);
+  for (int i = 0; i < 10; ++i) {
+    void* ptr = a.AllocateRaw(64, 1024);
+    EXPECT_EQ(first, ptr);
+    a.DeallocateRaw(ptr);
+  }
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(11, stats.num_allocs);
+  EXPECT_EQ(1, stats.num_cache_misses);
+  EXPECT_EQ(10, stats.num_cache_hits);
+  // Chunks parked in the cache stay in use until the cache is flushed.
+  EXPECT_GT(stats.bytes_in_use, 0);
+
+  EXPECT_GT(a.FlushThreadCaches(), 0);
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, LargeAllocationsBypassThreadCache) {
+  BFCAllocator a(new HostSubAllocator, 1 << 26, false, "test",
+                 CacheOptions(4));
+  void* ptr = a.AllocateRaw(64, 1 << 20);
+  EXPECT_NE(nullptr, ptr);
+  a.DeallocateRaw(ptr);
+  a.FlushThreadCaches();
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1, stats.num_allocs);
+  EXPECT_EQ(0, stats.num_cache_hits);
+  EXPECT_EQ(0, stats.num_cache_misses);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheFlushedWhenOutOfMemory) {
+  BFCAllocator::ThreadCacheOptions options = CacheOptions(1);
+  options.free_batch_size = 1;
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false, "test", options);
+
+  // Fill the cache with small chunks, then ask for all of the memory.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(64, 1024));
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  void* big = a.AllocateRaw(64, 1 << 20);
+  EXPECT_NE(nullptr, big);
+  a.DeallocateRaw(big);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheConcurrentAllocations) {
+  BFCAllocator a(new HostSubAllocator, 1 << 28, false, "test",
+                 CacheOptions(4));
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> live;
+        for (int i = 0; i < 2000; ++i) {
+          if (live.empty() || rand.Uniform(3) != 0) {
+            size_t bytes = 1 + rand.Uniform(8192);
+            void* ptr = a.AllocateRaw(1, bytes);
+            CHECK(ptr != nullptr);
+            // Catch two threads holding the same chunk.
+            memset(ptr, t, bytes);
+            live.push_back(ptr);
+          } else {
+            size_t j = rand.Uniform(live.size());
+            a.DeallocateRaw(live[j]);
+            live[j] = live.back();
+            live.pop_back();
+          }
+        }
+        for (void* ptr : live) {
+          a.DeallocateRaw(ptr);
+        }
+      });
+    }
+  }
+  a.FlushThreadCaches();
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_GT(stats.num_cache_hits, 0);
+}
+
+// Allocates on the stream set by the test, and records the waits between
+// streams the allocator asks for.
+class StreamOrderedTestAllocator : public BFCAllocator {
+ public:
+  StreamOrderedTestAllocator()
+      : BFCAllocator(new HostSubAllocator, 1 << 20, false, "test") {}
+
+  int stream = -1;
+  std::vector<std::pair<int, int>> waits;
+
+ protected:
+  int CurrentStream() override { return stream; }
+  void WaitForStream(int waiter, int other) override {
+    waits.emplace_back(waiter, other);
+  }
+};
+
+TEST(BFCAllocatorTest, StreamOrderedReuse) {
+  StreamOrderedTestAllocator a;
+  a.stream = 0;
+  void* p = a.AllocateRaw(64, 1024);
+  EXPECT_EQ(0, a.AllocationStream(p));
+  a.DeallocateRaw(p);
+
+  // The same stream reuses the chunk right away.
+  void* q = a.AllocateRaw(64, 1024);
+  EXPECT_EQ(p, q);
+  EXPECT_TRUE(a.waits.empty());
+  a.DeallocateRaw(q);
+
+  // An untagged allocation does not take a chunk stream 0 may still use.
+  a.stream = -1;
+  void* r = a.AllocateRaw(64, 1024);
+  EXPECT_NE(p, r);
+  EXPECT_EQ(-1, a.AllocationStream(r));
+  a.DeallocateRaw(r);
+
+  // Another stream takes it after waiting for stream 0.
+  a.stream = 1;
+  void* s = a.AllocateRaw(64, 1024);
+  EXPECT_EQ(p, s);
+  ASSERT_EQ(1, a.waits.size());
+  EXPECT_EQ(std::make_pair(1, 0), a.waits[0]);
+  a.DeallocateRaw(s);
+
+  int64 num_frees = 0;
+  EXPECT_TRUE(a.TakeStreamFrees(0, &num_frees));
+  EXPECT_EQ(2, num_frees);
+  EXPECT_FALSE(a.TakeStreamFrees(0, &num_frees));
+  EXPECT_TRUE(a.TakeStreamFrees(1, &num_frees));
+  EXPECT_EQ(1, num_frees);
+
+  // Once stream 1 has passed the free, the chunk is coalesced with the rest
+  // of the memory and any allocation can use it.
+  a.RetireStreamFrees(1, num_frees);
+  a.stream = -1;
+  void* all = a.AllocateRaw(64, 1 << 20);
+  EXPECT_EQ(p, all);
+  a.DeallocateRaw(all);
+
+  char on_stack[16];
+  EXPECT_EQ(-1, a.AllocationStream(on_stack));
+}
+
+void BM_Allocation(int iters, int num_caches) {
+  BFCAllocator a(new HostSubAllocator, 1 << 28, false, "test",
+                 CacheOptions(num_caches));
+  std::vector<size_t> sizes = {256, 4096, 512, 1024, 16384, 2048, 768};
+  int size_index = 0;
+  while (--iters > 0) {
+    size_t bytes = sizes[size_index++ % sizes.size()];
+    void* p = a.AllocateRaw(1, bytes);
+    a.DeallocateRaw(p);
+  }
+}
+BENCHMARK(BM_Allocation)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
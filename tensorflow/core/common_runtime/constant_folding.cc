@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -41,6 +42,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+const char* const kDoNotConstantFoldAttr = "_do_not_constant_fold";
+
 namespace {
 
 bool IsConstantFoldable(const Node* n,
@@ -54,6 +57,11 @@ bool IsConstantFoldable(const Node* n,
   if (consider && !consider(n)) {
     return false;
   }
+  bool do_not_fold = false;
+  if (GetNodeAttr(n->attrs(), kDoNotConstantFoldAttr, &do_not_fold).ok() &&
+      do_not_fold) {
+    return false;
+  }
   if (n->IsControlFlow() || n->IsSend() || n->IsRecv()) {
     return false;
   }
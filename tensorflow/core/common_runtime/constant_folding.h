@@ -31,6 +31,12 @@ struct ConstantFoldingOptions {
   std::function<bool(const Node*)> consider = nullptr;
 };
 
+// Boolean node attribute that, when true, keeps the node from being constant
+// folded. Graph transforms set it on the ops that expand compact constants,
+// such as float16 or eight-bit weights, so that only the compact constants
+// stay in memory and the expansion runs on every step.
+extern const char* const kDoNotConstantFoldAttr;
+
 // Perform constant folding optimization on "graph".
 // Looks for nodes in "graph" that can be completely evaluated statically, i.e.,
 // that are only dependent on constants. Evaluates those nodes on a CPU device
@@ -149,6 +149,31 @@ TEST_F(ConstantFoldingTest, ConsiderFunction) {
   EXPECT_EQ(*(s2->in_nodes().begin()), m2);
 }
 
+TEST_F(ConstantFoldingTest, DoNotConstantFoldAttr) {
+  Scope s = Scope::NewRootScope();
+  BuildSimpleGraph(&s);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+  std::unordered_map<string, Node*> index = NodeNameIndex(g);
+  Node* m2 = index.at("m2");
+  m2->AddAttr(kDoNotConstantFoldAttr, true);
+
+  bool was_mutated;
+  TF_ASSERT_OK(ConstantFold(ConstantFoldingOptions{}, nullptr, Env::Default(),
+                            nullptr, &g, &was_mutated));
+  EXPECT_TRUE(was_mutated);
+
+  index = NodeNameIndex(g);
+  Node* s1 = index.at("s1");
+  Node* s2 = index.at("s2");
+  // s1's input is folded, but s2's input should still be m2.
+  EXPECT_EQ(1, s1->num_inputs());
+  ExpectNodeClose<float>(*(s1->in_nodes().begin()), {1.0, 2.0, 3.0, 4.0},
+                         {2, 2});
+  EXPECT_EQ(1, s2->num_inputs());
+  EXPECT_EQ(*(s2->in_nodes().begin()), m2);
+}
+
 TEST_F(ConstantFoldingTest, TestNoReplaceAnotherConstant) {
   Graph g(OpRegistry::Global());
   {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <algorithm>
 #include <atomic>
 #include <string>
 #include <vector>
@@ -48,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -240,6 +242,12 @@ std::atomic_int_fast64_t DirectSession::step_id_counter_(1);
 // revisit this decision.
 void DirectSession::SchedClosure(thread::ThreadPool* pool,
                                  std::function<void()> c) {
+  // Sessions with inline_execution have no pool, and run everything on the
+  // calling thread.
+  if (pool == nullptr) {
+    c();
+    return;
+  }
 // TODO(sanjay): Get rid of __ANDROID__ path
 #ifdef __ANDROID__
   // On Android, there is no implementation of ThreadPool that takes
@@ -261,7 +269,27 @@ DirectSession::DirectSession(const SessionOptions& options,
       factory_(factory),
       cancellation_manager_(new CancellationManager()),
       operation_timeout_in_ms_(options_.config.operation_timeout_in_ms()) {
-  if (options_.config.session_inter_op_thread_pool_size() > 0) {
+  SessionGroup* session_group = nullptr;
+  if (!options_.config.session_group().name().empty()) {
+    if (options_.config.inline_execution()) {
+      init_error_.Update(errors::InvalidArgument(
+          "session_group and inline_execution cannot both be configured"));
+    } else if (options_.config.session_inter_op_thread_pool_size() > 0) {
+      init_error_.Update(errors::InvalidArgument(
+          "session_group and session_inter_op_thread_pool cannot both be "
+          "configured"));
+    } else {
+      init_error_.Update(SessionGroup::Get(options_.config.session_group(),
+                                           options_.env, &session_group));
+    }
+  }
+  if (options_.config.inline_execution()) {
+    // A single null pool, see SchedClosure().
+    thread_pools_.emplace_back(nullptr, false /* owned */);
+  } else if (session_group != nullptr) {
+    thread_pools_.emplace_back(session_group->thread_pool(),
+                               false /* owned */);
+  } else if (options_.config.session_inter_op_thread_pool_size() > 0) {
     for (int i = 0; i < options_.config.session_inter_op_thread_pool_size();
          ++i) {
       thread::ThreadPool* pool = nullptr;
@@ -310,6 +338,10 @@ DirectSession::DirectSession(const SessionOptions& options,
     }
     ++devices_added;
   }
+  if (session_group != nullptr) {
+    session_group_member_ = session_group->AddMember(
+        options_.config.session_group().member_name(), devices_);
+  }
 }
 
 DirectSession::~DirectSession() {
@@ -430,84 +462,34 @@ Status DirectSession::DecorateAndPublishGraphForDebug(
   return Status::OK();
 }
 
-Status DirectSession::Run(const RunOptions& run_options,
-                          const NamedTensorList& inputs,
-                          const std::vector<string>& output_names,
-                          const std::vector<string>& target_nodes,
-                          std::vector<Tensor>* outputs,
-                          RunMetadata* run_metadata) {
-  TF_RETURN_IF_ERROR(CheckNotClosed());
-  direct_session_runs->GetCell()->IncrementBy(1);
-  {
-    mutex_lock l(graph_def_lock_);
-    if (!graph_created_) {
-      return errors::InvalidArgument(
-          "Session was not created with a graph before Run()!");
-    }
-  }
-
-  // Extract the inputs names for this run of the session.
-  std::vector<string> input_tensor_names;
-  input_tensor_names.reserve(inputs.size());
-  for (const auto& it : inputs) {
-    input_tensor_names.push_back(it.first);
-  }
-
-  if (run_options.inter_op_thread_pool() < 0 ||
-      run_options.inter_op_thread_pool() >= thread_pools_.size()) {
-    return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
-                                   run_options.inter_op_thread_pool());
-  }
-  thread::ThreadPool* pool =
-      thread_pools_[run_options.inter_op_thread_pool()].first;
-
-  // Check if we already have an executor for these arguments.
-  ExecutorsAndKeys* executors_and_keys;
-  RunStateArgs run_state_args(run_options.debug_options());
+Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
+                                  thread::ThreadPool* pool,
+                                  FunctionCallFrame* call_frame,
+                                  ExecutorsAndKeys* executors_and_keys,
+                                  int64 executor_step_count,
+                                  const string& run_handle,
+                                  const std::vector<string>& output_names,
+                                  RunMetadata* run_metadata) {
+  // Wait for the session group, if any, to admit the step.
+  const int64 timeout_in_ms = run_options.timeout_in_ms() > 0
+                                  ? run_options.timeout_in_ms()
+                                  : operation_timeout_in_ms_;
+  SessionGroup::Member* const group_member = session_group_member_.get();
+  if (group_member != nullptr) {
+    TF_RETURN_IF_ERROR(group_member->StartStep(timeout_in_ms));
+  }
+  auto end_group_step = gtl::MakeCleanup([group_member] {
+    if (group_member != nullptr) group_member->EndStep();
+  });
 
   Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
-
-  TF_RETURN_IF_ERROR(
-      GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
-                           &executors_and_keys, &run_state_args));
-  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
-
-  std::unique_ptr<DebuggerStateInterface> debugger_state;
-  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
-    TF_RETURN_IF_ERROR(CreateDebuggerState(
-        run_options.debug_options(), args.step_id, executor_step_count,
-        input_tensor_names, output_names, target_nodes, &debugger_state));
-  }
-
-  // Configure a call frame for the step, which we use to feed and
-  // fetch values to and from the executors.
-  FunctionCallFrame call_frame(executors_and_keys->input_types,
-                               executors_and_keys->output_types);
-  gtl::InlinedVector<Tensor, 4> feed_args(inputs.size());
-  for (const auto& it : inputs) {
-    if (it.second.dtype() == DT_RESOURCE) {
-      Tensor tensor_from_handle;
-      TF_RETURN_IF_ERROR(
-          ResourceHandleToInputTensor(it.second, &tensor_from_handle));
-      feed_args[executors_and_keys->input_name_to_index[it.first]] =
-          tensor_from_handle;
-    } else {
-      feed_args[executors_and_keys->input_name_to_index[it.first]] = it.second;
-    }
-  }
-  Status s = call_frame.SetArgs(feed_args);
-  if (errors::IsInternal(s)) {
-    return errors::InvalidArgument(s.error_message());
-  } else if (!s.ok()) {
-    return s;
-  }
+  args.step_id = step_id;
 
   // Create a run state and start execution.
   RunState run_state(args.step_id, &devices_);
   run_state.rendez = new IntraProcessRendezvous(device_mgr_.get());
   CancellationManager step_cancellation_manager;
-  args.call_frame = &call_frame;
+  args.call_frame = call_frame;
 
   // Start parallel Executors.
   const size_t num_executors = executors_and_keys->items.size();
@@ -522,16 +504,24 @@ Status DirectSession::Run(const RunOptions& run_options,
 
   args.rendezvous = run_state.rendez;
   args.cancellation_manager = &step_cancellation_manager;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  if (group_member != nullptr) {
+    args.runner = [this, pool, group_member](Executor::Args::Closure c) {
+      SchedClosure(pool, group_member->WrapClosure(std::move(c)));
+    };
+  } else {
+    args.runner = [this, pool](Executor::Args::Closure c) {
+      SchedClosure(pool, std::move(c));
+    };
+  }
+  args.run_inline = options_.config.inline_execution();
   args.session_state = &session_state_;
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
   if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
+    LogMemory::RecordStep(args.step_id, run_handle);
   }
   args.sync_on_finish = sync_on_finish_;
+  args.collect_hardware_counters = run_options.collect_hardware_counters();
 
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
 
@@ -547,7 +537,22 @@ Status DirectSession::Run(const RunOptions& run_options,
           ((measure_step_count + 1) % build_cost_model_every == 0);
     }
   }
-  if (do_trace || update_cost_model) {
+  const bool sampled_trace =
+      do_trace && !update_cost_model &&
+      (run_options.trace_step_sampling_period() > 1 ||
+       run_options.trace_node_sampling_rate() > 0);
+  if (sampled_trace) {
+    const int64 period =
+        std::max<int64>(1, run_options.trace_step_sampling_period());
+    if (executor_step_count % period == 0) {
+      const double rate = run_options.trace_node_sampling_rate() > 0
+                              ? run_options.trace_node_sampling_rate()
+                              : 1.0;
+      run_state.collector.reset(
+          new StepStatsCollector(run_metadata->mutable_step_stats(), rate));
+      args.stats_collector = run_state.collector.get();
+    }
+  } else if (do_trace || update_cost_model) {
     run_state.collector.reset(
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
@@ -555,7 +560,8 @@ Status DirectSession::Run(const RunOptions& run_options,
 
 #if GOOGLE_CUDA
   std::unique_ptr<GPUTracer> tracer;
-  if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
+  if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE &&
+      args.stats_collector != nullptr) {
     tracer.reset(CreateGPUTracer());
     // tracer will be NULL on non-GPU platforms.
     // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
@@ -584,10 +590,7 @@ Status DirectSession::Run(const RunOptions& run_options,
     item.executor->RunAsync(args, barrier->Get());
   }
 
-  WaitForNotification(&run_state, &step_cancellation_manager,
-                      run_options.timeout_in_ms() > 0
-                          ? run_options.timeout_in_ms()
-                          : operation_timeout_in_ms_);
+  WaitForNotification(&run_state, &step_cancellation_manager, timeout_in_ms);
 
   if (!cancellation_manager_->DeregisterCallback(cancellation_token)) {
     // The step has been cancelled: make sure we don't attempt to receive the
@@ -604,44 +607,35 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 #endif  // GOOGLE_CUDA
 
+  if (run_state.collector) {
+    run_state.collector->Finalize();
+  }
+
   {
     mutex_lock l(run_state.mu_);
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
-  // Receive outputs.
-  if (outputs) {
-    std::vector<Tensor> sorted_outputs;
-    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
-    if (errors::IsInternal(s)) {
-      return errors::InvalidArgument(s.error_message());
-    } else if (!s.ok()) {
-      return s;
-    }
-    outputs->clear();
-    outputs->reserve(sorted_outputs.size());
-    for (const string& output_name : output_names) {
-      outputs->emplace_back(
-          std::move(sorted_outputs[executors_and_keys
-                                       ->output_name_to_index[output_name]]));
-    }
-  }
-
   // Save the output tensors of this run we choose to keep.
   TF_RETURN_IF_ERROR(
       run_state.tensor_store.SaveTensors(output_names, &session_state_));
 
-  // Build and return the cost model as instructed.
-  mutex_lock l(executor_lock_);
-  if (update_cost_model) {
-    // Build the cost model
-    std::unordered_map<string, const Graph*> device_to_graph;
+  std::unordered_map<string, const Graph*> device_to_graph;
+  if (run_state.collector) {
     for (const PerPartitionExecutorsAndLib& partition :
          executors_and_keys->items) {
       const Graph* graph = partition.graph;
       const string device = partition.flib->device()->name();
       device_to_graph[device] = graph;
     }
+    online_cost_model_.AddStepStats(run_metadata->step_stats(),
+                                    device_to_graph);
+  }
+
+  // Build and return the cost model as instructed.
+  mutex_lock l(executor_lock_);
+  if (update_cost_model) {
+    // Build the cost model
     args.stats_collector->BuildCostModel(&cost_model_manager_, device_to_graph);
 
     // annotate stats onto cost graph.
@@ -652,6 +646,15 @@ Status DirectSession::Run(const RunOptions& run_options,
     }
   }
 
+  if (options_.config.graph_options().mobile_inference()) {
+    int64 preallocated_bytes = 0;
+    for (const PerPartitionExecutorsAndLib& partition :
+         executors_and_keys->items) {
+      preallocated_bytes += partition.executor->PreallocatedBytes();
+    }
+    run_metadata->set_preallocated_memory_bytes(preallocated_bytes);
+  }
+
   // If requested via RunOptions, output the partition graphs.
   if (run_options.output_partition_graphs()) {
     protobuf::RepeatedPtrField<GraphDef>* partition_graph_defs =
@@ -666,6 +669,241 @@ Status DirectSession::Run(const RunOptions& run_options,
   return Status::OK();
 }
 
+Status DirectSession::Run(const RunOptions& run_options,
+                          const NamedTensorList& inputs,
+                          const std::vector<string>& output_names,
+                          const std::vector<string>& target_nodes,
+                          std::vector<Tensor>* outputs,
+                          RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before Run()!");
+    }
+  }
+
+  // Extract the inputs names for this run of the session.
+  std::vector<string> input_tensor_names;
+  input_tensor_names.reserve(inputs.size());
+  for (const auto& it : inputs) {
+    input_tensor_names.push_back(it.first);
+  }
+
+  if (run_options.inter_op_thread_pool() < 0 ||
+      run_options.inter_op_thread_pool() >= thread_pools_.size()) {
+    return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
+                                   run_options.inter_op_thread_pool());
+  }
+  thread::ThreadPool* pool =
+      thread_pools_[run_options.inter_op_thread_pool()].first;
+
+  // Check if we already have an executor for these arguments.
+  ExecutorsAndKeys* executors_and_keys;
+  RunStateArgs run_state_args(run_options.debug_options());
+
+  const int64 step_id = step_id_counter_.fetch_add(1);
+
+  TF_RETURN_IF_ERROR(
+      GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
+                           &executors_and_keys, &run_state_args));
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  std::unique_ptr<DebuggerStateInterface> debugger_state;
+  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
+    TF_RETURN_IF_ERROR(CreateDebuggerState(
+        run_options.debug_options(), step_id, executor_step_count,
+        input_tensor_names, output_names, target_nodes, &debugger_state));
+  }
+
+  // Configure a call frame for the step, which we use to feed and
+  // fetch values to and from the executors.
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(inputs.size());
+  for (const auto& it : inputs) {
+    if (it.second.dtype() == DT_RESOURCE) {
+      Tensor tensor_from_handle;
+      TF_RETURN_IF_ERROR(
+          ResourceHandleToInputTensor(it.second, &tensor_from_handle));
+      feed_args[executors_and_keys->input_name_to_index[it.first]] =
+          tensor_from_handle;
+    } else {
+      feed_args[executors_and_keys->input_name_to_index[it.first]] = it.second;
+    }
+  }
+  Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, pool, &call_frame,
+                                 executors_and_keys, executor_step_count,
+                                 run_state_args.handle, output_names,
+                                 run_metadata));
+
+  // Receive outputs.
+  if (outputs) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    outputs->clear();
+    outputs->reserve(sorted_outputs.size());
+    for (const string& output_name : output_names) {
+      outputs->emplace_back(
+          std::move(sorted_outputs[executors_and_keys
+                                       ->output_name_to_index[output_name]]));
+    }
+  }
+
+  return Status::OK();
+}
+
+Status DirectSession::MakeCallable(const CallableOptions& callable_options,
+                                   CallableHandle* out_handle) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
+  }
+  const RunOptions& run_options = callable_options.run_options();
+  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
+    return errors::Unimplemented(
+        "Debug tensor watches are not supported for callables.");
+  }
+  if (run_options.inter_op_thread_pool() < 0 ||
+      run_options.inter_op_thread_pool() >= thread_pools_.size()) {
+    return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
+                                   run_options.inter_op_thread_pool());
+  }
+
+  std::shared_ptr<Callable> callable(new Callable);
+  callable->options = callable_options;
+  callable->pool = thread_pools_[run_options.inter_op_thread_pool()].first;
+  const std::vector<string> feed_names(callable_options.feed().begin(),
+                                       callable_options.feed().end());
+  callable->fetch_names.assign(callable_options.fetch().begin(),
+                               callable_options.fetch().end());
+  const std::vector<string> target_names(callable_options.target().begin(),
+                                         callable_options.target().end());
+
+  RunStateArgs run_state_args(run_options.debug_options());
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(
+      callable->pool, feed_names, callable->fetch_names, target_names,
+      &callable->executors_and_keys, &run_state_args));
+
+  // Resolve the positions of the feeds and fetches in the call frame once,
+  // so that RunCallable() does not need any name lookups.
+  const ExecutorsAndKeys* ek = callable->executors_and_keys;
+  callable->feed_arg_index.reserve(feed_names.size());
+  for (const string& feed : feed_names) {
+    auto it = ek->input_name_to_index.find(feed);
+    if (it == ek->input_name_to_index.end()) {
+      return errors::Internal("No call frame argument for feed ", feed);
+    }
+    callable->feed_arg_index.push_back(it->second);
+  }
+  callable->fetch_retval_index.reserve(callable->fetch_names.size());
+  for (const string& fetch : callable->fetch_names) {
+    auto it = ek->output_name_to_index.find(fetch);
+    if (it == ek->output_name_to_index.end()) {
+      return errors::Internal("No call frame return value for fetch ", fetch);
+    }
+    callable->fetch_retval_index.push_back(it->second);
+  }
+
+  mutex_lock l(callables_lock_);
+  *out_handle = next_callable_handle_++;
+  callables_[*out_handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors,
+                                  RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+  std::shared_ptr<Callable> callable;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    callable = it->second;
+  }
+  if (feed_tensors.size() != callable->feed_arg_index.size()) {
+    return errors::InvalidArgument(
+        "Invalid number of feed tensors specified: ", feed_tensors.size(),
+        ", expected ", callable->feed_arg_index.size());
+  }
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+  const int64 step_id = step_id_counter_.fetch_add(1);
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(feed_tensors.size());
+  for (size_t i = 0; i < feed_tensors.size(); ++i) {
+    const Tensor& feed = feed_tensors[i];
+    if (feed.dtype() == DT_RESOURCE) {
+      TF_RETURN_IF_ERROR(ResourceHandleToInputTensor(
+          feed, &feed_args[callable->feed_arg_index[i]]));
+    } else {
+      feed_args[callable->feed_arg_index[i]] = feed;
+    }
+  }
+  Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  RunMetadata unused_run_metadata;
+  TF_RETURN_IF_ERROR(RunInternal(
+      step_id, callable->options.run_options(), callable->pool, &call_frame,
+      executors_and_keys, executor_step_count, string(), callable->fetch_names,
+      run_metadata != nullptr ? run_metadata : &unused_run_metadata));
+
+  if (fetch_tensors != nullptr) {
+    std::vector<Tensor> retvals;
+    Status s = call_frame.ConsumeRetvals(&retvals);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    fetch_tensors->clear();
+    fetch_tensors->reserve(callable->fetch_retval_index.size());
+    for (int index : callable->fetch_retval_index) {
+      // Copy rather than move: the same tensor may be fetched twice.
+      fetch_tensors->push_back(retvals[index]);
+    }
+  }
+  return Status::OK();
+}
+
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (callables_.erase(handle) == 0) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  return Status::OK();
+}
+
 Status DirectSession::PRunSetup(const std::vector<string>& input_names,
                                 const std::vector<string>& output_names,
                                 const std::vector<string>& target_nodes,
@@ -725,6 +963,7 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   args.runner = [this, pool](Executor::Args::Closure c) {
     SchedClosure(pool, std::move(c));
   };
+  args.run_inline = options_.config.inline_execution();
   args.session_state = &session_state_;
   args.tensor_store = &run_state->tensor_store;
   args.step_container = &run_state->step_container;
@@ -954,23 +1193,26 @@ Status DirectSession::RecvPRunOutputs(
 
 Status DirectSession::CheckFetch(const NamedTensorList& feeds,
                                  const std::vector<string>& fetches,
-                                 const ExecutorsAndKeys* executors_and_keys,
+                                 ExecutorsAndKeys* executors_and_keys,
                                  const RunState* run_state) {
   const Graph* graph = executors_and_keys->graph.get();
   const NameNodeMap* name_to_node = &executors_and_keys->name_to_node;
 
-  // Build the set of pending feeds that we haven't seen.
+  // Build the set of all the feeds of the partial run, and of the pending
+  // feeds that we haven't seen.
+  std::unordered_set<TensorId, TensorId::Hasher> all_feeds;
   std::unordered_set<TensorId, TensorId::Hasher> pending_feeds;
   {
     mutex_lock l(executor_lock_);
     for (const auto& input : run_state->pending_inputs) {
-      // Skip if the feed has already been fed.
-      if (input.second) continue;
       TensorId id(ParseTensorName(input.first));
       auto it = name_to_node->find(id.first);
       if (it == name_to_node->end()) {
         return errors::NotFound("Feed ", input.first, ": not found");
       }
+      all_feeds.insert(id);
+      // Skip if the feed has already been fed.
+      if (input.second) continue;
       pending_feeds.insert(id);
     }
   }
@@ -979,35 +1221,49 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
     pending_feeds.erase(id);
   }
 
-  // Initialize the stack with the fetch nodes.
-  std::vector<const Node*> stack;
+  // Any feed needed for fetches can't be in pending_feeds. The feeds that
+  // a fetch depends on are found by walking the graph back from the fetch
+  // node only the first time, since the graph and the feeds are the same
+  // for every partial run that uses "executors_and_keys".
+  mutex_lock l(executors_and_keys->fetch_deps_mu);
   for (const string& fetch : fetches) {
-    TensorId id(ParseTensorName(fetch));
-    auto it = name_to_node->find(id.first);
-    if (it == name_to_node->end()) {
-      return errors::NotFound("Fetch ", fetch, ": not found");
+    auto deps_it = executors_and_keys->fetch_feed_deps.find(fetch);
+    if (deps_it == executors_and_keys->fetch_feed_deps.end()) {
+      TensorId id(ParseTensorName(fetch));
+      auto it = name_to_node->find(id.first);
+      if (it == name_to_node->end()) {
+        return errors::NotFound("Fetch ", fetch, ": not found");
+      }
+      std::vector<std::pair<string, int>> deps;
+      std::vector<const Node*> stack = {it->second};
+      std::vector<bool> visited(graph->num_node_ids(), false);
+      while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+
+        for (const Edge* in_edge : n->in_edges()) {
+          const Node* in_node = in_edge->src();
+          if (all_feeds.count({in_node->name(), in_edge->src_output()}) > 0) {
+            deps.emplace_back(in_node->name(), in_edge->src_output());
+          }
+          if (!visited[in_node->id()]) {
+            visited[in_node->id()] = true;
+            stack.push_back(in_node);
+          }
+        }
+      }
+      std::sort(deps.begin(), deps.end());
+      deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+      deps_it = executors_and_keys->fetch_feed_deps
+                    .emplace(fetch, std::move(deps))
+                    .first;
     }
-    stack.push_back(it->second);
-  }
-
-  // Any tensor needed for fetches can't be in pending_feeds.
-  std::vector<bool> visited(graph->num_node_ids(), false);
-  while (!stack.empty()) {
-    const Node* n = stack.back();
-    stack.pop_back();
-
-    for (const Edge* in_edge : n->in_edges()) {
-      const Node* in_node = in_edge->src();
-      if (pending_feeds.count({in_node->name(), in_edge->src_output()}) > 0) {
-        return errors::InvalidArgument("Fetch ", in_node->name(), ":",
-                                       in_edge->src_output(),
+    for (const auto& dep : deps_it->second) {
+      if (pending_feeds.count({dep.first, dep.second}) > 0) {
+        return errors::InvalidArgument("Fetch ", dep.first, ":", dep.second,
                                        " can't be computed from the feeds"
                                        " that have been fed so far.");
       }
-      if (!visited[in_node->id()]) {
-        visited[in_node->id()] = true;
-        stack.push_back(in_node);
-      }
     }
   }
   return Status::OK();
@@ -1165,6 +1421,12 @@ Status DirectSession::GetOrCreateExecutors(
       }
     };
     params.node_outputs_cb = node_outputs_callback_;
+    params.cost_model = &online_cost_model_;
+    params.replay_steps = options_.config.graph_options().replay_static_steps();
+    if (options_.config.graph_options().mobile_inference()) {
+      params.plan_memory = true;
+      params.preallocate_memory_plan = true;
+    }
 
     optimizer.Optimize(lib, options_.env, device, &iter->second);
 
@@ -28,8 +28,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/online_cost_model.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/session_group.h"
 #include "tensorflow/core/common_runtime/simple_graph_execution_state.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -91,6 +93,15 @@ class DirectSession : public Session {
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
 
+  // NOTE: Experimental and subject to change.
+  ::tensorflow::Status MakeCallable(const CallableOptions& callable_options,
+                                    CallableHandle* out_handle) override;
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors,
+                                   RunMetadata* run_metadata) override;
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+
   // Reset clears 'containers' from the device_mgr of the DirectSession.
   // If 'containers' is empty, then Reset clears the default container.
   ::tensorflow::Status Reset(const std::vector<string>& containers);
@@ -103,6 +114,12 @@ class DirectSession : public Session {
     cost_model_manager_.ExportCostModels(cost_models);
   }
 
+  // Exports the current costs of the online cost model, which is updated
+  // with the stats of every traced step.
+  void ExportOnlineCosts(grappler::OpPerformanceList* costs) {
+    online_cost_model_.ExportOpPerformance(costs);
+  }
+
  private:
   typedef DirectSession ME;
 
@@ -141,6 +158,13 @@ class DirectSession : public Session {
 
     DataTypeVector input_types;
     DataTypeVector output_types;
+
+    // For partial runs: the feeds that each fetch depends on, found by
+    // CheckFetch() the first time the fetch is requested and reused by all
+    // the partial runs with the same signature.
+    mutex fetch_deps_mu;
+    std::unordered_map<string, std::vector<std::pair<string, int>>>
+        fetch_feed_deps GUARDED_BY(fetch_deps_mu);
   };
 
   // For each live partial execution, the session maintains a RunState.
@@ -170,6 +194,21 @@ class DirectSession : public Session {
     ~RunState();
   };
 
+  // A callable binds a fixed feed/fetch/target signature to the executors
+  // that compute it. 'feed_arg_index[i]' is the call frame argument that
+  // receives the i-th feed tensor and 'fetch_retval_index[j]' the call frame
+  // return value that is returned as the j-th fetch tensor.
+  // 'executors_and_keys' is owned by 'executors_', which outlives every
+  // callable.
+  struct Callable {
+    CallableOptions options;
+    thread::ThreadPool* pool = nullptr;
+    ExecutorsAndKeys* executors_and_keys = nullptr;
+    std::vector<int> feed_arg_index;
+    std::vector<int> fetch_retval_index;
+    std::vector<string> fetch_names;
+  };
+
   struct RunStateArgs {
     RunStateArgs(const DebugOptions& options) : debug_options(options) {}
 
@@ -202,6 +241,17 @@ class DirectSession : public Session {
       RunStateArgs* run_state_args, DataTypeVector* input_types,
       DataTypeVector* output_types);
 
+  // Runs the executors in 'executors_and_keys' for one step, feeding and
+  // fetching through 'call_frame'. Shared by Run() and RunCallable().
+  ::tensorflow::Status RunInternal(int64 step_id, const RunOptions& run_options,
+                                   thread::ThreadPool* pool,
+                                   FunctionCallFrame* call_frame,
+                                   ExecutorsAndKeys* executors_and_keys,
+                                   int64 executor_step_count,
+                                   const string& run_handle,
+                                   const std::vector<string>& output_names,
+                                   RunMetadata* run_metadata);
+
   ::tensorflow::Status ExtendLocked(const GraphDef& graph)
       EXCLUSIVE_LOCKS_REQUIRED(graph_def_lock_);
 
@@ -225,8 +275,8 @@ class DirectSession : public Session {
   // that we have already provided.
   ::tensorflow::Status CheckFetch(
       const std::vector<std::pair<string, Tensor>>& feeds,
-      const std::vector<string>& fetches,
-      const ExecutorsAndKeys* executors_and_keys, const RunState* run_state);
+      const std::vector<string>& fetches, ExecutorsAndKeys* executors_and_keys,
+      const RunState* run_state);
 
   // Use the appropriate WaitForNotification function based on whether
   // operation_timeout_in_ms is greater than 0.
@@ -267,9 +317,13 @@ class DirectSession : public Session {
   GraphDef graph_def_ GUARDED_BY(graph_def_lock_);
 
   // The thread-pools to use for running ops, with a bool indicating if the pool
-  // is owned.
+  // is owned. Holds a single nullptr if the session uses inline_execution.
   std::vector<std::pair<thread::ThreadPool*, bool>> thread_pools_;
 
+  // Set if the session is a member of a SessionGroup, whose pool is then the
+  // only entry of thread_pools_.
+  std::unique_ptr<SessionGroup::Member> session_group_member_;
+
   Status init_error_;  // Set to an error if construction failed.
 
   // If true, blocks until device has finished all queued operations in a step.
@@ -290,6 +344,12 @@ class DirectSession : public Session {
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
       GUARDED_BY(executor_lock_);
 
+  // Holds the callables created by MakeCallable(), keyed by handle.
+  mutex callables_lock_;
+  int64 next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+  std::unordered_map<int64, std::shared_ptr<Callable>> callables_
+      GUARDED_BY(callables_lock_);
+
   // This holds all the tensors that are currently alive in the session.
   SessionState session_state_;
 
@@ -329,6 +389,10 @@ class DirectSession : public Session {
   // Manages all the cost models for the graphs executed in this session.
   CostModelManager cost_model_manager_;
 
+  // Aggregates the stats of the traced steps of this session. New executors
+  // use it to classify expensive nodes.
+  OnlineCostModel online_cost_model_;
+
   Executor::Args::NodeOutputsCallback node_outputs_callback_ = nullptr;
 
   TF_DISALLOW_COPY_AND_ASSIGN(DirectSession);
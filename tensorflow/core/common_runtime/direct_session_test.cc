@@ -17,11 +17,14 @@ limitations under the License.
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/session_group.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -137,6 +140,70 @@ TEST_F(DirectSessionMinusAXTest, TestFeed) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunCallable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Fetch y twice and y_neg once, in an order that does not match the sorted
+  // order used by the call frame.
+  CallableOptions callable_options;
+  callable_options.add_feed(x_);
+  callable_options.add_fetch(y_neg_ + ":0");
+  callable_options.add_fetch(y_ + ":0");
+  callable_options.add_fetch(y_ + ":0");
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  for (int i = 0; i < 3; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = 5 + i;
+    t.matrix<float>()(1, 0) = 6;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs, nullptr));
+    ASSERT_EQ(3, outputs.size());
+    const float y0 = 1 * (5 + i) + 2 * 6;
+    const float y1 = 3 * (5 + i) + 4 * 6;
+    EXPECT_FLOAT_EQ(-y0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-y1, outputs[0].matrix<float>()(1, 0));
+    EXPECT_FLOAT_EQ(y0, outputs[1].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(y1, outputs[1].matrix<float>()(1, 0));
+    EXPECT_FLOAT_EQ(y0, outputs[2].matrix<float>()(0, 0));
+  }
+
+  // Wrong number of feeds.
+  std::vector<Tensor> outputs;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(session->RunCallable(handle, {}, &outputs,
+                                                     nullptr)));
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->RunCallable(handle, {Tensor()}, &outputs, nullptr)));
+  EXPECT_TRUE(errors::IsInvalidArgument(session->ReleaseCallable(handle)));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunCallableWithTargetsOnly) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options;
+  callable_options.add_target(y_neg_);
+  callable_options.mutable_run_options()->set_trace_level(
+      RunOptions::FULL_TRACE);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+  RunMetadata run_metadata;
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, &run_metadata));
+  EXPECT_TRUE(outputs.empty());
+  EXPECT_GT(run_metadata.step_stats().dev_stats_size(), 0);
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -294,6 +361,42 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithSampledTrace) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  // Trace every other step, and all the nodes of the traced steps.
+  RunOptions run_options;
+  run_options.set_trace_level(RunOptions::FULL_TRACE);
+  run_options.set_trace_step_sampling_period(2);
+  run_options.set_trace_node_sampling_rate(1.0);
+
+  int traced_steps = 0;
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(run_options, inputs, output_names, target_nodes,
+                              &outputs, &run_metadata));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    if (run_metadata.step_stats().dev_stats_size() == 0) continue;
+    ++traced_steps;
+    for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        EXPECT_FALSE(node_stats.node_name().empty());
+        EXPECT_FALSE(node_stats.timeline_label().empty());
+        EXPECT_EQ(0, node_stats.output_size());
+      }
+    }
+  }
+  EXPECT_EQ(2, traced_steps);
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -333,6 +436,141 @@ TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   EXPECT_EQ(20.0, outputs[0].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, ReplayStaticSteps) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+  Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({2}));
+  Tensor init_value(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&init_value, {10, 20});
+  Node* init =
+      test::graph::Assign(&g, var, test::graph::Constant(&g, init_value));
+  Tensor x_value(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&x_value, {0, 0});
+  Node* x = test::graph::Constant(&g, x_value);
+  // y = (var + x) * (var + x), where the sum has two uses.
+  Node* sum = test::graph::Binary(&g, "Add", var, x);
+  Node* y = test::graph::Binary(&g, "Mul", sum, sum);
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_replay_static_steps(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {}, {init->name()}, &outputs));
+
+  for (int step = 0; step < 3; ++step) {
+    test::FillValues<float>(&x_value, {1.0f * step, 2.0f * step});
+    TF_ASSERT_OK(session->Run({{x->name(), x_value}}, {y->name() + ":0"}, {},
+                              &outputs));
+    ASSERT_EQ(1, outputs.size());
+    const float a = 10 + step, b = 20 + 2 * step;
+    test::ExpectTensorEqual<float>(
+        outputs[0], test::AsTensor<float>({a * a, b * b}, TensorShape({2})));
+  }
+}
+
+TEST(DirectSessionTest, MobileInferencePreallocatesPlannedMemory) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+  Tensor x_value(DT_FLOAT, TensorShape({256}));
+  x_value.flat<float>().setZero();
+  Node* x = test::graph::Constant(&g, x_value);
+  // z = (x * x + x) * 2, whose two intermediates are planned.
+  Node* square = test::graph::Binary(&g, "Mul", x, x);
+  Node* sum = test::graph::Binary(&g, "Add", square, x);
+  Node* z = test::graph::Binary(&g, "Add", sum, sum);
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_mobile_inference(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  for (int step = 0; step < 3; ++step) {
+    x_value.flat<float>().setConstant(step);
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(RunOptions(), {{x->name(), x_value}},
+                              {z->name() + ":0"}, {}, &outputs,
+                              &run_metadata));
+    ASSERT_EQ(1, outputs.size());
+    const float expected = 2.0f * (step * step + step);
+    for (int i = 0; i < 256; ++i) {
+      ASSERT_EQ(expected, outputs[0].flat<float>()(i));
+    }
+    // The plan is made by the first step, and holds both intermediates.
+    EXPECT_GE(run_metadata.preallocated_memory_bytes(), 2 * 256 * 4);
+  }
+}
+
+// Records the threads that it runs on. Expensive, so that the executor
+// would normally hand it to the inter-op thread pool.
+mutex recorded_threads_mu(LINKER_INITIALIZED);
+std::set<std::thread::id>* recorded_threads = nullptr;
+
+class RecordThreadOp : public OpKernel {
+ public:
+  explicit RecordThreadOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  void Compute(OpKernelContext* ctx) override {
+    {
+      mutex_lock l(recorded_threads_mu);
+      recorded_threads->insert(std::this_thread::get_id());
+    }
+    ctx->set_output(0, ctx->input(0));
+  }
+  bool IsExpensive() override { return true; }
+};
+REGISTER_KERNEL_BUILDER(Name("RecordThread").Device(DEVICE_CPU),
+                        RecordThreadOp);
+REGISTER_OP("RecordThread").Input("x: float").Output("y: float").Doc("");
+
+TEST(DirectSessionTest, InlineExecutionRunsOnCallingThread) {
+  Graph g(OpRegistry::Global());
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = 1.5f;
+  Node* x = test::graph::Constant(&g, t);
+  // Four parallel chains of two nodes, joined by an AddN.
+  std::vector<NodeBuilder::NodeOut> chains;
+  for (int i = 0; i < 4; ++i) {
+    Node* a = test::graph::Unary(&g, "RecordThread", x);
+    chains.emplace_back(test::graph::Unary(&g, "RecordThread", a));
+  }
+  Node* sum;
+  TF_ASSERT_OK(NodeBuilder(g.NewName("sum"), "AddN")
+                   .Input(chains)
+                   .Finalize(&g, &sum));
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.set_inline_execution(true);
+  // Ignored in favor of the calling thread.
+  options.config.set_inter_op_parallelism_threads(4);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  std::set<std::thread::id> threads;
+  recorded_threads = &threads;
+  for (int step = 0; step < 3; ++step) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {sum->name() + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(6.0f, outputs[0].scalar<float>()());
+  }
+  recorded_threads = nullptr;
+  ASSERT_EQ(1, threads.size());
+  EXPECT_EQ(std::this_thread::get_id(), *threads.begin());
+
+  // Session groups schedule steps on their own pool.
+  options.config.mutable_session_group()->set_name("inline_group");
+  session.reset(NewSession(options));
+  EXPECT_FALSE(session->Create(def).ok());
+}
+
 TEST(DirectSessionTest, MultipleFeedTest) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -577,6 +815,61 @@ TEST(DirectSessionTest, PartialRunMissingFeed) {
                   .contains("can't be computed from the feeds"));
 }
 
+TEST(DirectSessionTest, PartialRunSameSignature) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+
+  Tensor first_value(DT_FLOAT, TensorShape({}));
+  first_value.scalar<float>()() = 1.0;
+  Node* first_const = test::graph::Constant(&g, first_value);
+  Node* first_identity = test::graph::Identity(&g, first_const);
+
+  Tensor second_value(DT_FLOAT, TensorShape({}));
+  second_value.scalar<float>()() = 2.0;
+  Node* second_const = test::graph::Constant(&g, second_value);
+  Node* second_identity = test::graph::Identity(&g, second_const);
+
+  Node* third = test::graph::Add(&g, first_identity, second_identity);
+  Node* third_identity = test::graph::Identity(&g, third);
+
+  test::graph::ToGraphDef(&g, &def);
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  const std::vector<string> feeds = {first_const->name(),
+                                     second_const->name()};
+  const std::vector<string> fetches = {third_identity->name() + ":0"};
+  Tensor value_11(DT_FLOAT, TensorShape({}));
+  value_11.scalar<float>()() = 11.0;
+  Tensor value_22(DT_FLOAT, TensorShape({}));
+  value_22.scalar<float>()() = 22.0;
+  std::vector<Tensor> outputs;
+
+  // The partial runs share their executors, and the feeds that the fetch
+  // depends on, but each checks them against its own pending feeds.
+  string handle1;
+  TF_ASSERT_OK(session->PRunSetup(feeds, fetches, {}, &handle1));
+  string handle2;
+  TF_ASSERT_OK(session->PRunSetup(feeds, fetches, {}, &handle2));
+  EXPECT_NE(handle1, handle2);
+
+  Status s =
+      session->PRun(handle1, {{first_const->name(), value_11}}, fetches,
+                    &outputs);
+  ASSERT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(StringPiece(s.error_message())
+                  .contains("can't be computed from the feeds"));
+
+  TF_ASSERT_OK(session->PRun(handle2,
+                             {{first_const->name(), value_11},
+                              {second_const->name(), value_22}},
+                             fetches, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(33.0, outputs[0].flat<float>()(0));
+}
+
 TEST(DirectSessionTest, PartialRunMultiOutputFeed) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -1096,6 +1389,63 @@ TEST(DirectSessionTest, TestSessionInterOpThreadsInvalidOptions) {
   }
 }
 
+TEST(DirectSessionTest, SessionGroup) {
+  Graph g(OpRegistry::Global());
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = {1.2f};
+  Node* x = test::graph::Constant(&g, t);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  SessionGroupOptions* group_options = options.config.mutable_session_group();
+  group_options->set_name("test_group");
+  group_options->set_num_threads(2);
+  group_options->set_max_concurrent_steps(1);
+
+  std::vector<std::unique_ptr<Session>> sessions;
+  for (const string& member_name : {"a", "b"}) {
+    group_options->set_member_name(member_name);
+    sessions.emplace_back(NewSession(options));
+    TF_ASSERT_OK(sessions.back()->Create(def));
+  }
+
+  // Run steps of both sessions concurrently.
+  {
+    thread::ThreadPool tp(Env::Default(), "test", 4);
+    for (int i = 0; i < 8; ++i) {
+      Session* session = sessions[i % 2].get();
+      tp.Schedule([session, x]() {
+        std::vector<Tensor> outputs;
+        TF_ASSERT_OK(session->Run({}, {x->name() + ":0"}, {}, &outputs));
+        ASSERT_EQ(1, outputs.size());
+        EXPECT_FLOAT_EQ(1.2, outputs[0].flat<float>()(0));
+      });
+    }
+  }
+
+  SessionGroup* group = SessionGroup::Find("test_group");
+  ASSERT_NE(nullptr, group);
+  std::vector<SessionGroup::MemberStats> stats = group->GetStats();
+  ASSERT_EQ(2, stats.size());
+  EXPECT_EQ("a", stats[0].member_name);
+  EXPECT_EQ("b", stats[1].member_name);
+  for (const SessionGroup::MemberStats& member_stats : stats) {
+    EXPECT_EQ(4, member_stats.num_steps);
+    EXPECT_EQ(0, member_stats.num_running_steps);
+  }
+
+  // The group cannot be re-configured.
+  group_options->set_num_threads(3);
+  std::unique_ptr<Session> session(NewSession(options));
+  EXPECT_FALSE(session->Create(def).ok());
+
+  // Sessions leave the group when they are destroyed.
+  sessions.clear();
+  EXPECT_TRUE(group->GetStats().empty());
+}
+
 TEST(DirectSessionTest, TestDirectSessionRunClose) {
   // Construct a graph with a variable and a single assign.
   Graph g(OpRegistry::Global());
@@ -1222,7 +1572,9 @@ TEST(DirectSessionTest, TestDirectSessionReset) {
 
 // A simple benchmark for the overhead of `DirectSession::Run()` calls
 // with varying numbers of feeds/fetches.
-void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
+void FeedFetchBenchmarkHelper(int num_feeds, int iters,
+                              bool use_make_callable,
+                              bool inline_execution = false) {
   testing::StopTiming();
 
   Tensor value(DT_FLOAT, TensorShape());
@@ -1256,6 +1608,7 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
   GraphDef gd;
   g.ToGraphDef(&gd);
   SessionOptions opts;
+  opts.config.set_inline_execution(inline_execution);
   std::unique_ptr<Session> session(NewSession(opts));
   TF_CHECK_OK(session->Create(gd));
   {
@@ -1268,6 +1621,28 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
     std::vector<Tensor> output_values;
     TF_CHECK_OK(session->Run(inputs, outputs, {}, &output_values));
   }
+  if (use_make_callable) {
+    CallableOptions callable_options;
+    std::vector<Tensor> input_tensors;
+    for (const auto& input : inputs) {
+      callable_options.add_feed(input.first);
+      input_tensors.push_back(input.second);
+    }
+    for (const string& output : outputs) {
+      callable_options.add_fetch(output);
+    }
+    Session::CallableHandle handle;
+    TF_CHECK_OK(session->MakeCallable(callable_options, &handle));
+    testing::StartTiming();
+    for (int i = 0; i < iters; ++i) {
+      std::vector<Tensor> output_values;
+      TF_CHECK_OK(
+          session->RunCallable(handle, input_tensors, &output_values, nullptr));
+    }
+    testing::StopTiming();
+    TF_CHECK_OK(session->ReleaseCallable(handle));
+    return;
+  }
   testing::StartTiming();
   for (int i = 0; i < iters; ++i) {
     std::vector<Tensor> output_values;
@@ -1277,10 +1652,24 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
 }
 
 void BM_FeedFetch(int iters, int num_feeds) {
-  FeedFetchBenchmarkHelper(iters, num_feeds);
+  FeedFetchBenchmarkHelper(iters, num_feeds, /* use_make_callable */ false);
+}
+void BM_FeedFetchCallable(int iters, int num_feeds) {
+  FeedFetchBenchmarkHelper(iters, num_feeds, /* use_make_callable */ true);
+}
+void BM_FeedFetchInline(int iters, int num_feeds) {
+  FeedFetchBenchmarkHelper(iters, num_feeds, /* use_make_callable */ false,
+                           /* inline_execution */ true);
+}
+void BM_FeedFetchCallableInline(int iters, int num_feeds) {
+  FeedFetchBenchmarkHelper(iters, num_feeds, /* use_make_callable */ true,
+                           /* inline_execution */ true);
 }
 
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_FeedFetchCallable)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_FeedFetchInline)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_FeedFetchCallableInline)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
 }  // namespace
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -23,6 +24,8 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
+#include "tensorflow/core/common_runtime/online_cost_model.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
@@ -40,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -55,6 +59,8 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
@@ -66,6 +72,23 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Nodes whose measured compute time is at least this many microseconds are
+// dispatched to the thread pool instead of run inline, once the online cost
+// model has this many samples of them.
+const int64 kExpensiveNodeMicros = 10;
+const int kMinCostModelSamples = 8;
+
+// The executor keeps a moving average of the compute time, in CPU cycles, of
+// every synchronous kernel that IsExpensive(), and runs the kernel inline
+// once the average drops below kOpIsExpensiveThresholdCycles. The estimates
+// start high, so that such kernels are dispatched until they are measured.
+const uint64 kInitialCostEstimateCycles = 100 * 1000 * 1000;
+const uint64 kOpIsExpensiveThresholdCycles = 5000;
+const uint64 kCostDecay = 10;
+
+// The maximum number of inexpensive ready nodes run by one closure.
+const int kMaxInlineBatchSize = 8;
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -142,6 +165,15 @@ void SetAllEnd(NodeExecStats* nt) {
   nt->set_all_end_rel_micros(NowInUsec() - nt->all_start_micros());
 }
 
+void SetHardwareCounters(NodeExecStats* nt,
+                         const profile_utils::PerfCounterValues& start,
+                         const profile_utils::PerfCounterValues& end) {
+  HardwareCounters* counters = nt->mutable_hardware_counters();
+  counters->set_cycles(end.cycles - start.cycles);
+  counters->set_instructions(end.instructions - start.instructions);
+  counters->set_cache_misses(end.cache_misses - start.cache_misses);
+}
+
 void SetOutput(NodeExecStats* nt, int slot, const Tensor* v) {
   DCHECK(v);
   NodeOutput* no = nt->add_output();
@@ -165,6 +197,9 @@ void SetMemory(NodeExecStats* nt, OpKernelContext* ctx) {
     AllocatorStats stats;
     allocator_pair.first->GetStats(&stats);
     memory->set_allocator_bytes_in_use(stats.bytes_in_use);
+    memory->set_allocator_bytes_reserved(stats.bytes_reserved);
+    memory->set_allocator_largest_free_block_bytes(
+        stats.largest_free_block_bytes);
   }
   auto* ms = nt->mutable_memory_stats();
   ms->set_host_temp_memory_size(ctx->host_temp_memory_size());
@@ -194,6 +229,7 @@ void SetReferencedTensors(NodeExecStats* nt,
 
 class ExecutorImpl;
 class GraphView;
+class IterationStatePool;
 
 struct EdgeInfo {
   int dst_id;
@@ -212,7 +248,9 @@ struct NodeItem {
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
-  bool kernel_is_expensive : 1;  // True iff kernel->IsExpensive()
+  // True iff kernel->IsExpensive(), unless the online cost model says
+  // otherwise. See ExecutorImpl::IsExpensive().
+  bool kernel_is_expensive : 1;
   bool kernel_is_async : 1;      // True iff kernel->AsAsync() != nullptr
   bool is_merge : 1;             // True iff IsMerge(node)
   bool is_enter : 1;             // True iff IsEnter(node)
@@ -347,6 +385,12 @@ class ExecutorImpl : public Executor {
     for (auto fiter : frame_info_) {
       delete fiter.second;
     }
+    for (auto ctx : replay_device_contexts_) {
+      if (ctx != nullptr) ctx->Unref();
+    }
+    if (memory_arena_ != nullptr) {
+      memory_arena_->Unref();
+    }
     delete graph_;
   }
 
@@ -359,9 +403,51 @@ class ExecutorImpl : public Executor {
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
+  int64 PreallocatedBytes() override {
+    mutex_lock l(memory_plan_mu_);
+    return memory_arena_ != nullptr ? memory_arena_->bytes() : 0;
+  }
+
  private:
   friend class ExecutorState;
 
+  // Returns the allocators for the planned outputs of a new step, or
+  // nullptr if the step doesn't use them. The caller owns a reference.
+  PlannedAllocators* NewPlannedAllocators();
+
+  // Builds the memory plan from the output sizes recorded by a step, if it
+  // succeeded, so that later steps can use it.
+  void FinishRecording(const PlannedAllocators& allocators,
+                       const Status& status);
+
+  // Fills in replay_nodes_ if the graph can be replayed, i.e. it has no
+  // control flow and all its kernels are synchronous.
+  void InitializeReplay();
+
+  // Fills in replay_device_contexts_ once for all replayed steps.
+  Status FillReplayContexts();
+
+  // Runs a step by replaying the kernels in the order of replay_nodes_.
+  void RunReplay(const Args& args, DoneCallback done);
+
+  // Whether the node should be dispatched to the thread pool rather than run
+  // inline: its kernel is marked expensive and its measured compute time,
+  // if any, is not below kOpIsExpensiveThresholdCycles.
+  bool IsExpensive(const NodeItem& item) const {
+    return item.kernel_is_expensive &&
+           cost_estimates_[item.node->id()].load(std::memory_order_relaxed) >=
+               kOpIsExpensiveThresholdCycles;
+  }
+
+  // Folds a measured compute time into the moving average of the node.
+  // Concurrent updates may lose samples, which is fine for an estimate.
+  void UpdateCostEstimate(const NodeItem& item, uint64 elapsed_cycles) {
+    std::atomic<uint64>& estimate = cost_estimates_[item.node->id()];
+    const uint64 old = estimate.load(std::memory_order_relaxed);
+    estimate.store(old - old / kCostDecay + elapsed_cycles / kCostDecay,
+                   std::memory_order_relaxed);
+  }
+
   struct ControlFlowInfo {
     gtl::FlatSet<string, HashStr> unique_frame_names;
     std::vector<string> frame_names;
@@ -372,7 +458,8 @@ class ExecutorImpl : public Executor {
         : input_count(0),
           total_inputs(0),
           pending_counts(nullptr),
-          nodes(nullptr) {}
+          nodes(nullptr),
+          iteration_pool(nullptr) {}
 
     // The total number of inputs to a frame.
     int input_count;
@@ -391,10 +478,11 @@ class ExecutorImpl : public Executor {
     // The nodes in a frame. Used only for debugging.
     std::vector<const Node*>* nodes;  // Owned
 
-    ~FrameInfo() {
-      delete pending_counts;
-      delete nodes;
-    }
+    // Iteration states of this frame released by earlier steps and
+    // iterations, ready to be reused.
+    IterationStatePool* iteration_pool;  // Owned
+
+    ~FrameInfo();
   };
 
   static Status BuildControlFlowInfo(const Graph* graph,
@@ -420,11 +508,50 @@ class ExecutorImpl : public Executor {
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
+  // The moving average of the compute time of each node, in CPU cycles.
+  std::unique_ptr<std::atomic<uint64>[]> cost_estimates_;
+
   // Mapping from frame name to static information about the frame.
   // TODO(yuanbyu): We could cache it along with the graph so to avoid
   // the overhead of constructing it for each executor instance.
   gtl::FlatMap<string, FrameInfo*, HashStr> frame_info_;
 
+  // The static memory plan, if params_.plan_memory is set and the graph can
+  // be planned. It is immutable once planned.
+  std::unique_ptr<MemoryPlan> memory_plan_;
+  mutex memory_plan_mu_;
+  // True while a step is recording the output sizes for memory_plan_.
+  bool memory_plan_recording_ GUARDED_BY(memory_plan_mu_) = false;
+  // The slab of memory_plan_, if params_.preallocate_memory_plan is set and
+  // the plan has been made. Owns a reference.
+  MemoryArena* memory_arena_ GUARDED_BY(memory_plan_mu_) = nullptr;
+
+  // The input of a replayed node: the output slot of the step that holds
+  // it, and whether this is the last use of the slot in the step, after
+  // which the step releases it.
+  struct ReplayInput {
+    int slot = -1;
+    bool last_use = false;
+  };
+
+  struct ReplayNode {
+    const NodeItem* item = nullptr;
+    // The slot of the node's first output. Outputs take consecutive slots.
+    int output_start = 0;
+    gtl::InlinedVector<ReplayInput, 4> inputs;
+  };
+
+  // The nodes in the order steps replay them, if params_.replay_steps is
+  // set and the graph can be replayed; empty otherwise. Immutable after
+  // Initialize().
+  std::vector<ReplayNode> replay_nodes_;
+  // Whether any node reads each output slot; unread outputs are dropped.
+  std::vector<bool> replay_slot_used_;
+  // The device contexts of the nodes, shared by the replayed steps.
+  mutex replay_mu_;
+  bool replay_contexts_filled_ GUARDED_BY(replay_mu_) = false;
+  DeviceContextMap replay_device_contexts_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -605,6 +732,11 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
 
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_);
+  cost_estimates_.reset(new std::atomic<uint64>[graph_->num_node_ids()]);
+  for (int i = 0; i < graph_->num_node_ids(); ++i) {
+    cost_estimates_[i].store(kInitialCostEstimateCycles,
+                             std::memory_order_relaxed);
+  }
 
   // Build the information about frames in this subgraph.
   ControlFlowInfo cf_info;
@@ -619,6 +751,11 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
+  if (params_.plan_memory && params_.device->device_type() == DEVICE_CPU) {
+    memory_plan_.reset(new MemoryPlan(graph_));
+    if (!memory_plan_->supported()) memory_plan_.reset();
+  }
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
   for (const Node* n : graph_->nodes()) {
@@ -646,6 +783,12 @@ Status ExecutorImpl::Initialize() {
     }
     CHECK(item->kernel);
     item->kernel_is_expensive = item->kernel->IsExpensive();
+    Microseconds measured;
+    if (params_.cost_model != nullptr &&
+        params_.cost_model->ComputeTime(n->name(), kMinCostModelSamples,
+                                        &measured)) {
+      item->kernel_is_expensive = measured.value() >= kExpensiveNodeMicros;
+    }
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
     item->is_merge = IsMerge(n);
     item->is_enter = IsEnter(n);
@@ -677,6 +820,11 @@ Status ExecutorImpl::Initialize() {
   // all nodes.
   InitializePending(graph_, cf_info);
 
+  if (params_.replay_steps && params_.node_outputs_cb == nullptr &&
+      cf_info.unique_frame_names.size() == 1) {
+    InitializeReplay();
+  }
+
   return gview_.SetAllocAttrs(graph_, params_.device);
 }
 
@@ -787,6 +935,8 @@ class ExecutorState {
   void RunAsync(Executor::DoneCallback done);
 
  private:
+  friend class IterationStatePool;
+
   // Either a tensor pointer (pass-by-reference) or a tensor (pass-by-value).
   // TODO(yuanbyu): A better way to do "has_value"?
   struct Entry {
@@ -878,6 +1028,7 @@ class ExecutorState {
     explicit IterationState(const PendingCounts* pending_counts,
                             int total_input_tensors)
         : input_tensors(new Entry[total_input_tensors]),
+          num_input_tensors(total_input_tensors),
           outstanding_ops(0),
           outstanding_frame_count(0),
           counts_(*pending_counts) {  // Initialize with copy of *pending_counts
@@ -895,6 +1046,9 @@ class ExecutorState {
     // edge. The latter node is never run concurrently with the former node.
     Entry* input_tensors;
 
+    // The number of entries in input_tensors.
+    const int num_input_tensors;
+
     // The number of outstanding ops for each iteration.
     size_t outstanding_ops;
 
@@ -925,6 +1079,18 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Returns the iteration to the state it was constructed in, so that
+    // another step or iteration of the same frame can reuse it. This also
+    // drops any input tensors left behind by an aborted step.
+    void Reset(const PendingCounts* pending_counts) {
+      for (int i = 0; i < num_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.CopyFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -1000,6 +1166,12 @@ class ExecutorState {
     // The active iteration states of this frame.
     gtl::InlinedVector<IterationState*, 12> iterations;
 
+    // The states of the iterations this frame has finished, which its next
+    // iterations reuse without going through the iteration_pool, whose lock
+    // all the frames of the loop share. They are reset when reused, and
+    // returned to the iteration_pool with the frame.
+    std::vector<IterationState*> free_iterations GUARDED_BY(mu);
+
     // The NextIteration nodes to enter a new iteration. If the number of
     // outstanding iterations reaches the limit, we will defer the start of
     // the next iteration until the number of outstanding iterations falls
@@ -1021,6 +1193,7 @@ class ExecutorState {
     PendingCounts* pending_counts = nullptr;
     int total_input_tensors = 0;
     std::vector<const Node*>* nodes = nullptr;
+    IterationStatePool* iteration_pool = nullptr;
 
     // Lock ordering: ExecutorState.mu_ < mu.
     mutex mu;
@@ -1033,6 +1206,7 @@ class ExecutorState {
       total_input_tensors = finfo->total_inputs;
       num_pending_inputs = finfo->input_count;
       nodes = finfo->nodes;
+      iteration_pool = finfo->iteration_pool;
     }
 
     inline IterationState* GetIteration(int64 iter)
@@ -1104,12 +1278,7 @@ class ExecutorState {
     bool CleanupIterations(const GraphView* gview, int64 iter,
                            TaggedNodeSeq* ready) EXCLUSIVE_LOCKS_REQUIRED(mu);
 
-    ~FrameState() {
-      for (size_t i = 0; i < iterations.size(); ++i) {
-        delete iterations[i];
-        iterations[i] = nullptr;
-      }
-    }
+    ~FrameState();
   };
 
   // A tagged node: <frame*, iter, node*>.
@@ -1181,11 +1350,42 @@ class ExecutorState {
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
+  // The allocators of planned outputs for this step, or nullptr. Owns a
+  // reference.
+  PlannedAllocators* planned_allocators_;
   FunctionCallFrame* call_frame_;
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
+  const bool collect_hardware_counters_;
+  // True iff every node runs on the thread that makes it ready. See
+  // Executor::Args::run_inline.
+  const bool run_inline_;
+
+  // A ready node waiting in a work-stealing deque.
+  struct ReadyEntry {
+    TaggedNode node;
+    int64 scheduled_usec;
+  };
+
+  // The deque of one work-stealing worker. The owner pushes and pops at the
+  // back; thieves take from the front.
+  struct WorkerQueue {
+    mutex mu;
+    std::deque<ReadyEntry> ready GUARDED_BY(mu);
+    // True while a closure is running WorkerLoop() for this deque.
+    std::atomic<bool> active{false};
+  };
+
+  // Number of work-stealing workers; 0 if work stealing is disabled.
+  const int num_workers_;
+  std::unique_ptr<WorkerQueue[]> worker_queues_;
+  // Total number of entries across all of the worker deques.
+  std::atomic<int64> num_queued_{0};
+  // Round-robin cursor for nodes made ready outside of any worker.
+  std::atomic<uint32> next_queue_{0};
+  WorkStealingStats* work_stealing_stats_;
 
   // Owned.
 
@@ -1231,8 +1431,9 @@ class ExecutorState {
   void CleanupFramesIterations(FrameState* frame, int64 iter,
                                TaggedNodeSeq* ready);
 
-  // Process a ready node in current thread.
-  void Process(TaggedNode node, int64 scheduled_usec);
+  // Process a ready node in current thread. "worker_id" is the
+  // work-stealing worker running this call, or -1 if there is none.
+  void Process(TaggedNode node, int64 scheduled_usec, int worker_id);
 
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -1254,12 +1455,34 @@ class ExecutorState {
   // "node" just finishes. Takes ownership of "stats". Returns true if
   // execution has completed.
   bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
-                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready);
+                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready,
+                int worker_id);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
   // nodes in 'ready' into 'inline_ready'.
   void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+                     TaggedNodeReadyQueue* inline_ready, int worker_id);
+
+  // Work-stealing variant of ScheduleReady(). Expensive nodes that the
+  // current thread does not run itself go to the deque of 'worker_id', or
+  // round-robin to all deques if 'worker_id' is -1.
+  void ScheduleReadyWorkStealing(const TaggedNodeSeq& ready,
+                                 TaggedNodeReadyQueue* inline_ready,
+                                 int worker_id, int64 scheduled_usec);
+
+  // Appends a ready node to a work-stealing deque.
+  void PushReady(int worker_id, const TaggedNode& node, int64 scheduled_usec);
+
+  // Takes the newest entry of the deque of 'worker_id', or else the oldest
+  // entry of another deque. Returns false if all deques are empty.
+  bool PopReady(int worker_id, ReadyEntry* entry, int64* local_hits,
+                int64* steals);
+
+  // Starts up to 'num_new' workers on idle deques.
+  void MaybeStartWorkers(int num_new);
+
+  // Body of a work-stealing worker closure.
+  void WorkerLoop(int worker_id);
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1290,6 +1513,82 @@ class ExecutorState {
   }
 };
 
+// Keeps the IterationStates released by finished steps and loop iterations
+// of one frame, so that later ones can reuse their input tensors and pending
+// counts instead of reallocating them. Thread-safe.
+class IterationStatePool {
+ public:
+  typedef ExecutorState::IterationState IterationState;
+
+  IterationStatePool(const PendingCounts* pending_counts,
+                     int total_input_tensors)
+      : pending_counts_(pending_counts),
+        total_input_tensors_(total_input_tensors) {}
+
+  ~IterationStatePool() {
+    for (IterationState* state : free_) {
+      delete state;
+    }
+  }
+
+  // Returns an iteration state with the initial pending counts of the frame
+  // and no input tensors.
+  IterationState* Get() {
+    {
+      mutex_lock l(mu_);
+      if (!free_.empty()) {
+        IterationState* state = free_.back();
+        free_.pop_back();
+        return state;
+      }
+    }
+    return new IterationState(pending_counts_, total_input_tensors_);
+  }
+
+  // Resets "state" and keeps it for a later Get(), or deletes it if the
+  // pool is already full. "state" may be nullptr.
+  void Release(IterationState* state) {
+    if (state == nullptr) return;
+    state->Reset(pending_counts_);
+    {
+      mutex_lock l(mu_);
+      if (free_.size() < kMaxFreeStates) {
+        free_.push_back(state);
+        return;
+      }
+    }
+    delete state;
+  }
+
+ private:
+  // Bounds the memory held by the pool when many steps run concurrently.
+  static const size_t kMaxFreeStates = 16;
+
+  const PendingCounts* const pending_counts_;
+  const int total_input_tensors_;
+
+  mutex mu_;
+  std::vector<IterationState*> free_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IterationStatePool);
+};
+
+ExecutorImpl::FrameInfo::~FrameInfo() {
+  delete pending_counts;
+  delete nodes;
+  delete iteration_pool;
+}
+
+ExecutorState::FrameState::~FrameState() {
+  for (size_t i = 0; i < iterations.size(); ++i) {
+    iteration_pool->Release(iterations[i]);
+    iterations[i] = nullptr;
+  }
+  for (IterationState* state : free_iterations) {
+    iteration_pool->Release(state);
+  }
+}
+
 ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
@@ -1300,11 +1599,22 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       step_container_(args.step_container),
       stats_collector_(args.stats_collector),
       slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
+      // Steps that collect stats track their own allocations.
+      planned_allocators_(args.stats_collector == nullptr
+                              ? impl->NewPlannedAllocators()
+                              : nullptr),
       call_frame_(args.call_frame),
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
+      collect_hardware_counters_(args.collect_hardware_counters),
+      run_inline_(args.run_inline),
+      num_workers_(args.run_inline ? 0
+                                   : std::max(args.work_stealing_workers, 0)),
+      worker_queues_(num_workers_ > 0 ? new WorkerQueue[num_workers_]
+                                      : nullptr),
+      work_stealing_stats_(args.work_stealing_stats),
       num_outstanding_ops_(0) {
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
@@ -1315,8 +1625,7 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
 
   // Initialize iteration 0.
   root_frame_->iterations.resize(root_frame_->max_parallel_iterations);
-  root_frame_->iterations[0] = new IterationState(
-      root_frame_->pending_counts, root_frame_->total_input_tensors);
+  root_frame_->iterations[0] = root_frame_->iteration_pool->Get();
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
 }
@@ -1329,6 +1638,253 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  if (planned_allocators_ != nullptr) {
+    if (planned_allocators_->recording()) {
+      impl_->FinishRecording(*planned_allocators_, status_);
+    }
+    planned_allocators_->Unref();
+  }
+}
+
+PlannedAllocators* ExecutorImpl::NewPlannedAllocators() {
+  if (memory_plan_ == nullptr) return nullptr;
+  MemoryArena* arena = nullptr;
+  {
+    mutex_lock l(memory_plan_mu_);
+    if (!memory_plan_->planned()) {
+      // Only one step records the output sizes at a time.
+      if (memory_plan_recording_) return nullptr;
+      memory_plan_recording_ = true;
+    } else if (memory_arena_ != nullptr && memory_arena_->TryAcquire()) {
+      arena = memory_arena_;
+    }
+  }
+  return new PlannedAllocators(memory_plan_.get(),
+                               params_.device->GetAllocator({}), arena);
+}
+
+void ExecutorImpl::FinishRecording(const PlannedAllocators& allocators,
+                                   const Status& status) {
+  mutex_lock l(memory_plan_mu_);
+  if (status.ok()) {
+    memory_plan_->Plan(allocators.recorded_bytes());
+    if (params_.preallocate_memory_plan && memory_plan_->slab_bytes() > 0) {
+      memory_arena_ = new MemoryArena(params_.device->GetAllocator({}),
+                                      memory_plan_->slab_bytes());
+      VLOG(1) << "Preallocated " << memory_plan_->slab_bytes()
+              << " bytes for the planned outputs";
+    }
+  }
+  memory_plan_recording_ = false;
+}
+
+void ExecutorImpl::InitializeReplay() {
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph_, &order);
+  std::vector<int> output_start(graph_->num_node_ids(), -1);
+  std::vector<ReplayNode> nodes(order.size());
+  int num_slots = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const Node* n = order[i];
+    const NodeItem* item = gview_.node(n->id());
+    if (item->kernel_is_async || item->is_merge || IsSwitch(n) ||
+        item->is_control_trigger || item->is_enter_exit_or_next_iter) {
+      VLOG(1) << "Not replaying steps because of " << SummarizeNode(*n);
+      return;
+    }
+    ReplayNode* rn = &nodes[i];
+    rn->item = item;
+    rn->output_start = num_slots;
+    output_start[n->id()] = num_slots;
+    num_slots += item->num_outputs;
+    rn->inputs.resize(item->num_inputs);
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      rn->inputs[e->dst_input()].slot =
+          output_start[e->src()->id()] + e->src_output();
+    }
+  }
+  // Walk the uses backwards to find the last use of each slot.
+  std::vector<bool> used(num_slots, false);
+  for (auto rn = nodes.rbegin(); rn != nodes.rend(); ++rn) {
+    for (auto in = rn->inputs.rbegin(); in != rn->inputs.rend(); ++in) {
+      DCHECK_GE(in->slot, 0);
+      if (!used[in->slot]) {
+        used[in->slot] = true;
+        in->last_use = true;
+      }
+    }
+  }
+  replay_nodes_ = std::move(nodes);
+  replay_slot_used_ = std::move(used);
+}
+
+Status ExecutorImpl::FillReplayContexts() {
+  mutex_lock l(replay_mu_);
+  if (!replay_contexts_filled_) {
+    TF_RETURN_IF_ERROR(
+        params_.device->FillContextMap(graph_, &replay_device_contexts_));
+    replay_contexts_filled_ = true;
+  }
+  return Status::OK();
+}
+
+void ExecutorImpl::RunReplay(const Args& args, DoneCallback done) {
+  Status s = FillReplayContexts();
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  Device* device = params_.device;
+
+  // The outputs of the step, released at their last use.
+  struct Slot {
+    Tensor val;
+    Tensor* ref = nullptr;
+    mutex* ref_mu = nullptr;
+    DeviceContext* device_context = nullptr;
+    AllocatorAttributes alloc_attr;
+  };
+  std::unique_ptr<Slot[]> slots(new Slot[replay_slot_used_.size()]);
+  PlannedAllocators* planned_allocators = NewPlannedAllocators();
+  checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache;
+  Executor::Args::Runner runner = args.runner;
+
+  // Parameters passed to OpKernel::Compute.
+  gtl::InlinedVector<Tensor, 4> input_tensors;
+  TensorValueVec inputs;
+  DeviceContextVec input_device_contexts;
+  AllocatorAttributeVec input_alloc_attrs;
+
+  OpKernelContext::Params params;
+  params.step_id = args.step_id;
+  params.device = device;
+  params.record_tensor_accesses = device_record_tensor_accesses_;
+  params.rendezvous = args.rendezvous;
+  params.session_state = args.session_state;
+  params.tensor_store = args.tensor_store;
+  params.cancellation_manager = args.cancellation_manager;
+  params.call_frame = args.call_frame;
+  params.function_library = params_.function_library;
+  params.resource_manager = device->resource_manager();
+  params.step_container = args.step_container;
+  params.slice_reader_cache = &slice_reader_cache;
+  params.inputs = &inputs;
+  params.input_device_contexts = &input_device_contexts;
+  params.input_alloc_attrs = &input_alloc_attrs;
+  params.runner = &runner;
+  params.frame_iter = FrameAndIter(0, 0);
+
+  for (const ReplayNode& rn : replay_nodes_) {
+    const NodeItem& item = *rn.item;
+    const int id = item.node->id();
+
+    // Prepares inputs. Each input gets its own reference to the tensor,
+    // which is the only one left at the last use of a slot, so that the
+    // kernel can forward the buffer to an output.
+    input_tensors.clear();
+    input_tensors.resize(item.num_inputs);
+    inputs.clear();
+    inputs.resize(item.num_inputs);
+    input_device_contexts.clear();
+    input_device_contexts.resize(item.num_inputs);
+    input_alloc_attrs.clear();
+    input_alloc_attrs.resize(item.num_inputs);
+    for (int i = 0; i < item.num_inputs && s.ok(); ++i) {
+      const ReplayInput& in = rn.inputs[i];
+      Slot* slot = &slots[in.slot];
+      input_device_contexts[i] = slot->device_context;
+      input_alloc_attrs[i] = slot->alloc_attr;
+      const bool expect_ref = IsRefType(item.input_type(i));
+      if (slot->ref == nullptr) {
+        if (expect_ref) {
+          s = AttachDef(
+              errors::InvalidArgument(i, "-th input expects a ref type"),
+              item.kernel->def());
+        } else if (in.last_use) {
+          input_tensors[i] = std::move(slot->val);
+        } else {
+          input_tensors[i] = slot->val;
+        }
+        inputs[i].tensor = &input_tensors[i];
+        continue;
+      }
+      mutex_lock l(*slot->ref_mu);
+      if (!slot->ref->IsInitialized() && !IsInitializationOp(item.node)) {
+        s = AttachDef(errors::FailedPrecondition(
+                          "Attempting to use uninitialized value ",
+                          item.kernel->requested_input(i)),
+                      item.kernel->def());
+      } else if (expect_ref) {
+        inputs[i].mutex_if_ref = slot->ref_mu;
+        inputs[i].tensor = slot->ref;
+      } else {
+        input_tensors[i] = *slot->ref;
+        inputs[i].tensor = &input_tensors[i];
+      }
+    }
+    if (!s.ok()) break;
+
+    params.op_kernel = item.kernel;
+    params.op_device_context = id < replay_device_contexts_.size()
+                                   ? replay_device_contexts_[id]
+                                   : nullptr;
+    params.output_allocators = planned_allocators != nullptr
+                                   ? planned_allocators->node_allocators(id)
+                                   : nullptr;
+    params.output_attr_array = item.output_attrs();
+    OpKernelContext ctx(&params, item.num_outputs);
+    device->Compute(item.kernel, &ctx);
+    s = ctx.status();
+    if (!s.ok()) {
+      s = AttachDef(s, item.kernel->def());
+      break;
+    }
+
+    // Processes outputs.
+    for (int i = 0; i < item.num_outputs; ++i) {
+      TensorValue val = ctx.release_output(i);
+      if (val.tensor == nullptr) {
+        s.Update(errors::Internal("Missing ", i, "-th output from ",
+                                  SummarizeNode(*item.node)));
+        continue;
+      }
+      if (replay_slot_used_[rn.output_start + i]) {
+        Slot* out = &slots[rn.output_start + i];
+        out->device_context = params.op_device_context;
+        out->alloc_attr = ctx.output_alloc_attr(i);
+        if (val.is_ref()) {
+          out->ref = val.tensor;
+          out->ref_mu = val.mutex_if_ref;
+        } else {
+          out->val = std::move(*val.tensor);
+        }
+      }
+      if (!val.is_ref()) delete val.tensor;
+    }
+    if (!s.ok()) break;
+    if (device_record_tensor_accesses_) {
+      TensorReferenceVector accessed_tensors;
+      ctx.retrieve_accessed_tensors(&accessed_tensors);
+      device->ConsumeListOfAccessedTensors(ctx.op_device_context(),
+                                           accessed_tensors);
+    }
+  }
+  input_tensors.clear();
+  slots.reset();
+
+  if (planned_allocators != nullptr) {
+    if (planned_allocators->recording()) {
+      FinishRecording(*planned_allocators, s);
+    }
+    planned_allocators->Unref();
+  }
+  if (args.sync_on_finish && s.ok()) {
+    // Block until the device has finished all queued operations, as
+    // ExecutorState::Finish() does.
+    s = device->Sync();
+  }
+  done(s);
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1401,6 +1957,7 @@ void ExecutorImpl::InitializePending(const Graph* graph,
     PendingCounts* counts = new PendingCounts(finfo->pending_counts_layout);
     DCHECK_EQ(finfo->pending_counts, nullptr);
     finfo->pending_counts = counts;
+    finfo->iteration_pool = new IterationStatePool(counts, finfo->total_inputs);
   }
   for (const Node* n : graph->nodes()) {
     const int id = n->id();
@@ -1437,7 +1994,7 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(ready, nullptr, -1);
   }
 }
 
@@ -1486,7 +2043,8 @@ struct ExecutorState::AsyncState {
   }
 };
 
-void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
+void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec,
+                            int worker_id) {
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -1542,13 +2100,25 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.op_device_context = device_context_map_[id];
     }
 
+    if (planned_allocators_ != nullptr) {
+      params.output_allocators = planned_allocators_->node_allocators(id);
+    }
+
     params.track_allocations = false;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.is_dead) {
-      // track allocations if and only if we are collecting statistics
-      params.track_allocations = true;
-      stats = new NodeExecStats;
-      stats->set_node_name(node->name());
+      if (!stats_collector_->sampled()) {
+        // track allocations if and only if we are collecting statistics
+        params.track_allocations = true;
+        stats = new NodeExecStats;
+        stats->set_node_name(node->name());
+      } else if (stats_collector_->ShouldTrace(step_id_, id)) {
+        // Sampled traces don't track allocations or outputs, and the
+        // collector fills in the node name when the trace is read.
+        stats = new NodeExecStats;
+      }
+    }
+    if (stats) {
       nodestats::SetScheduled(stats, scheduled_usec);
       nodestats::SetAllStart(stats);
     }
@@ -1583,7 +2153,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed =
+            NodeDone(s, item.node, ready, stats, &inline_ready, worker_id);
         continue;
       }
 
@@ -1639,7 +2210,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                                                  accessed);
           }
           bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, ready, stats, nullptr, -1);
           delete state;
           if (completed) Finish();
         };
@@ -1649,7 +2220,30 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         if (stats) nodestats::SetOpStart(stats);
+        profile_utils::PerfCounters* perf_counters =
+            stats && collect_hardware_counters_
+                ? profile_utils::PerfCounters::ForCurrentThread()
+                : nullptr;
+        profile_utils::PerfCounterValues start_counts;
+        if (perf_counters && !perf_counters->Read(&start_counts)) {
+          perf_counters = nullptr;
+        }
+        // Only kernels marked expensive can become cheaper to run inline.
+        const uint64 start_cycles =
+            item.kernel_is_expensive
+                ? profile_utils::CpuUtils::GetCurrentClockCycle()
+                : 0;
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        if (item.kernel_is_expensive &&
+            start_cycles != profile_utils::CpuUtils::DUMMY_CYCLE_CLOCK) {
+          impl_->UpdateCostEstimate(
+              item, profile_utils::CpuUtils::GetCurrentClockCycle() -
+                        start_cycles);
+        }
+        profile_utils::PerfCounterValues end_counts;
+        if (perf_counters && perf_counters->Read(&end_counts)) {
+          nodestats::SetHardwareCounters(stats, start_counts, end_counts);
+        }
         if (stats) nodestats::SetOpEnd(stats);
 
         s = ProcessOutputs(item, &ctx, &outputs, stats);
@@ -1683,7 +2277,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed =
+          NodeDone(s, item.node, ready, stats, &inline_ready, worker_id);
     }
   }  // while !inline_ready.empty()
 
@@ -1830,7 +2425,8 @@ Status ExecutorState::ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
         dtype = val->dtype();
       }
       if (dtype == item.output_type(i)) {
-        if (stats && val.tensor->IsInitialized()) {
+        if (stats && !stats_collector_->sampled() &&
+            val.tensor->IsInitialized()) {
           nodestats::SetOutput(stats, i, val.tensor);
         }
         if (val.is_ref()) {
@@ -1996,10 +2592,18 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
 
 bool ExecutorState::NodeDone(const Status& s, const Node* node,
                              const TaggedNodeSeq& ready, NodeExecStats* stats,
-                             TaggedNodeReadyQueue* inline_ready) {
+                             TaggedNodeReadyQueue* inline_ready,
+                             int worker_id) {
   if (stats) {
     nodestats::SetAllEnd(stats);
-    if (!SetTimelineLabel(node, stats)) {
+    if (stats_collector_->sampled()) {
+      if (!IsSend(node) && !IsRecv(node)) {
+        stats_collector_->SaveSampled(&impl_->params_.device->name(), node,
+                                      stats);
+      } else {
+        delete stats;
+      }
+    } else if (!SetTimelineLabel(node, stats)) {
       // Only record non-transfer nodes.
       stats_collector_->Save(impl_->params_.device->name(), stats);
     } else {
@@ -2036,31 +2640,77 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
 
   // Schedule the ready nodes in 'ready'.
   if (s.ok()) {
-    ScheduleReady(ready, inline_ready);
+    ScheduleReady(ready, inline_ready, worker_id);
   }
   return completed;
 }
 
 void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
-                                  TaggedNodeReadyQueue* inline_ready) {
+                                  TaggedNodeReadyQueue* inline_ready,
+                                  int worker_id) {
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
   if (stats_collector_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  if (run_inline_) {
+    if (inline_ready == nullptr) {
+      // Each Process() call runs the node and, in turn, all the nodes it
+      // makes ready. The nodes not yet processed are outstanding, so "this"
+      // outlives all but the last call.
+      for (const TaggedNode& tagged_node : ready) {
+        Process(tagged_node, scheduled_usec, -1);
+      }
+    } else {
+      for (const TaggedNode& tagged_node : ready) {
+        inline_ready->push_back(tagged_node);
+      }
+    }
+    return;
+  }
+  if (num_workers_ > 0) {
+    ScheduleReadyWorkStealing(ready, inline_ready, worker_id, scheduled_usec);
+    return;
+  }
+  const GraphView& gview = impl_->gview_;
   if (inline_ready == nullptr) {
-    // Schedule to run all the ready ops in thread pool.
+    // Schedule to run all the ready ops in thread pool. The inexpensive ones
+    // are batched, so that they share one hand-off to another thread.
+    TaggedNodeSeq batch;
+    auto run_batch = [this, &batch, scheduled_usec]() {
+      if (batch.size() == 1) {
+        const TaggedNode tagged_node = batch[0];
+        runner_([=]() { Process(tagged_node, scheduled_usec, -1); });
+      } else {
+        // The nodes not yet processed are outstanding, so "this" outlives
+        // all but the last Process() call.
+        runner_([this, batch, scheduled_usec]() {
+          for (const TaggedNode& tagged_node : batch) {
+            Process(tagged_node, scheduled_usec, -1);
+          }
+        });
+      }
+      batch.clear();
+    };
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_usec); });
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !impl_->IsExpensive(item)) {
+        batch.push_back(tagged_node);
+        if (static_cast<int>(batch.size()) == kMaxInlineBatchSize) {
+          run_batch();
+        }
+      } else {
+        runner_([=]() { Process(tagged_node, scheduled_usec, -1); });
+      }
     }
+    if (!batch.empty()) run_batch();
     return;
   }
-  const GraphView& gview = impl_->gview_;
   const TaggedNode* curr_expensive_node = nullptr;
   for (auto& tagged_node : ready) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
-    if (tagged_node.is_dead || !item.kernel_is_expensive) {
+    if (tagged_node.is_dead || !impl_->IsExpensive(item)) {
       // Inline this inexpensive node.
       inline_ready->push_back(tagged_node);
     } else {
@@ -2068,7 +2718,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
         runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
+                          scheduled_usec, -1));
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2081,11 +2731,144 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
       runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
+                        scheduled_usec, -1));
     }
   }
 }
 
+void ExecutorState::ScheduleReadyWorkStealing(
+    const TaggedNodeSeq& ready, TaggedNodeReadyQueue* inline_ready,
+    int worker_id, int64 scheduled_usec) {
+  int num_pushed = 0;
+  if (inline_ready == nullptr) {
+    for (auto& tagged_node : ready) {
+      PushReady(worker_id, tagged_node, scheduled_usec);
+      ++num_pushed;
+    }
+  } else {
+    // Same policy as ScheduleReady(), except that the expensive nodes this
+    // thread does not run stay in its own deque, where they are likely to
+    // be picked up again by this worker while their inputs are still warm.
+    const GraphView& gview = impl_->gview_;
+    const TaggedNode* curr_expensive_node = nullptr;
+    for (auto& tagged_node : ready) {
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !impl_->IsExpensive(item)) {
+        inline_ready->push_back(tagged_node);
+      } else {
+        if (curr_expensive_node) {
+          PushReady(worker_id, *curr_expensive_node, scheduled_usec);
+          ++num_pushed;
+        }
+        curr_expensive_node = &tagged_node;
+      }
+    }
+    if (curr_expensive_node) {
+      if (inline_ready->empty()) {
+        inline_ready->push_back(*curr_expensive_node);
+      } else {
+        PushReady(worker_id, *curr_expensive_node, scheduled_usec);
+        ++num_pushed;
+      }
+    }
+  }
+  if (num_pushed > 0) {
+    MaybeStartWorkers(num_pushed);
+  }
+}
+
+void ExecutorState::PushReady(int worker_id, const TaggedNode& node,
+                              int64 scheduled_usec) {
+  if (worker_id < 0) {
+    worker_id = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                num_workers_;
+  }
+  WorkerQueue* queue = &worker_queues_[worker_id];
+  {
+    mutex_lock l(queue->mu);
+    queue->ready.push_back(ReadyEntry{node, scheduled_usec});
+  }
+  // Must be visible before the caller inspects the 'active' flags in
+  // MaybeStartWorkers(); see WorkerLoop().
+  num_queued_.fetch_add(1);
+}
+
+bool ExecutorState::PopReady(int worker_id, ReadyEntry* entry,
+                             int64* local_hits, int64* steals) {
+  if (num_queued_.load() == 0) return false;
+  {
+    WorkerQueue* queue = &worker_queues_[worker_id];
+    mutex_lock l(queue->mu);
+    if (!queue->ready.empty()) {
+      *entry = queue->ready.back();
+      queue->ready.pop_back();
+      num_queued_.fetch_sub(1);
+      ++*local_hits;
+      return true;
+    }
+  }
+  for (int i = 1; i < num_workers_; ++i) {
+    WorkerQueue* victim = &worker_queues_[(worker_id + i) % num_workers_];
+    mutex_lock l(victim->mu);
+    if (!victim->ready.empty()) {
+      *entry = victim->ready.front();
+      victim->ready.pop_front();
+      num_queued_.fetch_sub(1);
+      ++*steals;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExecutorState::MaybeStartWorkers(int num_new) {
+  for (int i = 0; i < num_workers_ && num_new > 0; ++i) {
+    WorkerQueue* queue = &worker_queues_[i];
+    bool expected = false;
+    if (queue->active.load() ||
+        !queue->active.compare_exchange_strong(expected, true)) {
+      continue;
+    }
+    // Each running worker holds one count on num_outstanding_ops_ so that
+    // the step cannot finish (and delete this) while the worker still
+    // touches the deques.
+    num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+    if (work_stealing_stats_ != nullptr) {
+      work_stealing_stats_->workers_started.fetch_add(
+          1, std::memory_order_relaxed);
+    }
+    runner_([this, i]() { WorkerLoop(i); });
+    --num_new;
+  }
+}
+
+void ExecutorState::WorkerLoop(int worker_id) {
+  WorkerQueue* queue = &worker_queues_[worker_id];
+  int64 local_hits = 0;
+  int64 steals = 0;
+  ReadyEntry entry{TaggedNode(nullptr, nullptr, -1, false), 0};
+  while (true) {
+    while (PopReady(worker_id, &entry, &local_hits, &steals)) {
+      Process(entry.node, entry.scheduled_usec, worker_id);
+    }
+    // Go idle, then look once more. A thread that pushed a node after our
+    // last PopReady() but still saw this worker as active did not start a
+    // new worker, so the node would otherwise be stranded. Pairs with the
+    // increment of num_queued_ in PushReady().
+    queue->active.store(false);
+    if (num_queued_.load() == 0) break;
+    bool expected = false;
+    if (!queue->active.compare_exchange_strong(expected, true)) break;
+  }
+  if (work_stealing_stats_ != nullptr) {
+    work_stealing_stats_->local_hits.fetch_add(local_hits,
+                                               std::memory_order_relaxed);
+    work_stealing_stats_->steals.fetch_add(steals, std::memory_order_relaxed);
+  }
+  // Drop the count taken in MaybeStartWorkers().
+  if (num_outstanding_ops_.fetch_sub(1) == 1) Finish();
+}
+
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
                                               int64 node_id) {
   // TODO(misard) Replace with a finer-grain enabling flag once we
@@ -2270,8 +3053,7 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
   // 'iterations' is a fixed-length circular buffer.
   temp->iterations.resize(temp->max_parallel_iterations + 1);
   // Initialize iteration 0.
-  temp->iterations[0] =
-      new IterationState(temp->pending_counts, temp->total_input_tensors);
+  temp->iterations[0] = temp->iteration_pool->Get();
 
   {
     mutex_lock executor_lock(mu_);
@@ -2526,8 +3308,14 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
+  IterationState* iter_state;
+  if (free_iterations.empty()) {
+    iter_state = iteration_pool->Get();
+  } else {
+    iter_state = free_iterations.back();
+    free_iterations.pop_back();
+    iter_state->Reset(pending_counts);
+  }
   SetIteration(next_iter, iter_state);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -2544,8 +3332,8 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Delete the iteration curr_iter, keeping its state for a later one.
+    free_iterations.push_back(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2560,6 +3348,11 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
 }
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  if (!replay_nodes_.empty() && args.stats_collector == nullptr &&
+      !LogMemory::IsEnabled()) {
+    RunReplay(args, std::move(done));
+    return;
+  }
   (new ExecutorState(args, this))->RunAsync(std::move(done));
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 
+#include <atomic>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/session_state.h"
@@ -28,8 +30,21 @@ limitations under the License.
 
 namespace tensorflow {
 
+class OnlineCostModel;
 class StepStatsCollector;
 
+// Scheduling counters reported by an executor that runs with
+// Executor::Args::work_stealing_workers > 0. The counters accumulate over
+// every step that is given the same WorkStealingStats.
+struct WorkStealingStats {
+  // Number of ready nodes a worker took from its own deque.
+  std::atomic<int64> local_hits{0};
+  // Number of ready nodes a worker took from another worker's deque.
+  std::atomic<int64> steals{0};
+  // Number of worker closures handed to Executor::Args::runner.
+  std::atomic<int64> workers_started{0};
+};
+
 // Executor runs a graph computation.
 // Example:
 //   Graph* graph = ...;
@@ -93,10 +108,35 @@ class Executor {
     // If true, calls Sync() on the device.
     bool sync_on_finish = false;
 
+    // If true and "stats_collector" is not null, the stats of synchronous
+    // kernels include their hardware event counts, where the platform
+    // supports it. See RunOptions.collect_hardware_counters.
+    bool collect_hardware_counters = false;
+
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
 
+    // If true, the executor runs the nodes of the step on the thread that
+    // calls RunAsync(), one at a time in the order in which they become
+    // ready, and never hands them to "runner", which is only passed on to
+    // the kernels. This order is the same on every step. The nodes made
+    // ready by an asynchronous kernel that completes later run on the thread
+    // that completes it. "work_stealing_workers" is ignored.
+    bool run_inline = false;
+
+    // If > 0, the executor keeps ready expensive nodes in per-worker
+    // deques instead of dispatching each of them to "runner" as a separate
+    // closure. At most "work_stealing_workers" closures execute the step
+    // concurrently. A worker runs the nodes it makes ready itself, most
+    // recently produced first, and steals the oldest nodes of other
+    // workers when its own deque is empty.
+    int work_stealing_workers = 0;
+
+    // If not null and work stealing is enabled, the executor adds the
+    // scheduling counters of the step to "*work_stealing_stats".
+    WorkStealingStats* work_stealing_stats = nullptr;
+
     // A callback that is invoked each time a node has finished executing.
     typedef std::function<Status(const string& node_name, const int output_slot,
                                  const Tensor* tensor, const bool is_ref,
@@ -118,6 +158,11 @@ class Executor {
     n.WaitForNotification();
     return ret;
   }
+
+  // Returns the size in bytes of the memory that the executor keeps
+  // allocated for the outputs of its steps, or 0 if it keeps none. See
+  // LocalExecutorParams::preallocate_memory_plan.
+  virtual int64 PreallocatedBytes() { return 0; }
 };
 
 // Creates an Executor that computes the given "graph".
@@ -141,6 +186,35 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // If true and "device" is a CPU, the executor records the sizes of the
+  // outputs that kernels allocate in the first successful step, and then
+  // places them at planned offsets in one slab allocated per step. This
+  // pays off for inference graphs whose shapes are the same in every step;
+  // graphs with loops are not planned. See common_runtime/memory_planner.h.
+  bool plan_memory = false;
+
+  // If true along with "plan_memory", the slab of the plan is allocated
+  // once, as soon as the plan is made, and reused by every later step, so
+  // that steady-state steps allocate no memory for planned outputs. A step
+  // that starts while another one still holds the slab gets a slab of its
+  // own, as without this option.
+  bool preallocate_memory_plan = false;
+
+  // If true and the graph has no control flow and no asynchronous kernels,
+  // steps replay the kernels in a fixed topological order on the calling
+  // thread instead of going through the ready queue, pending counts and
+  // thread pool of the dataflow executor. This pays off for static
+  // inference graphs made of many small kernels, such as GPU graphs at
+  // small batch sizes, whose steps are dominated by scheduling overhead.
+  // Steps that collect stats fall back to the dataflow executor.
+  bool replay_steps = false;
+
+  // If set, nodes with enough samples in the cost model are classified as
+  // expensive, i.e. not run inline by the executor, by their measured
+  // compute time rather than by OpKernel::IsExpensive(). Must outlive the
+  // executor's initialization.
+  const OnlineCostModel* cost_model = nullptr;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
@@ -0,0 +1,316 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the scheduling overhead of the executor, on graphs of
+// trivial nodes. Besides the time per node, every benchmark reports in its
+// label how many closures the executor handed to the inter-op thread pool
+// and how many allocations it made through the CPU allocator per step.
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// Runs one graph on a CPU device, with an inter-op thread pool of a given
+// size, and counts the closures scheduled on the pool.
+class ExecutorBenchmark {
+ public:
+  // Takes ownership of "graph".
+  ExecutorBenchmark(Graph* graph, int num_threads) {
+    SessionOptions options;
+    device_.reset(DeviceFactory::NewDevice("CPU", options,
+                                           "/job:localhost/replica:0/task:0"));
+    CHECK(device_);
+    pool_.reset(
+        new thread::ThreadPool(Env::Default(), "executor_bench", num_threads));
+
+    const int graph_def_version = graph->versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel = [this, graph_def_version](const NodeDef& ndef,
+                                                     OpKernel** kernel) {
+      return CreateNonCachedKernel(device_.get(), nullptr, ndef,
+                                   graph_def_version, kernel);
+    };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    Executor* executor;
+    TF_CHECK_OK(NewLocalExecutor(params, graph, &executor));
+    executor_.reset(executor);
+  }
+
+  // Runs one step.
+  Status RunOnce() {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Status s = executor_->Run(MakeArgs(rendez));
+    rendez->Unref();
+    return s;
+  }
+
+  // Runs "iters" timed steps, each of which executes "nodes_per_step"
+  // nodes, and reports the overheads per node and per step.
+  void Run(int iters, int64 nodes_per_step) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    const Executor::Args args = MakeArgs(rendez);
+    static const int kWarmupRuns = 3;
+    for (int i = 0; i < kWarmupRuns; ++i) {
+      TF_CHECK_OK(executor_->Run(args));
+    }
+
+    EnableCPUAllocatorStats(true);
+    AllocatorStats before;
+    cpu_allocator()->GetStats(&before);
+    num_schedules_ = 0;
+    const uint64 start_nanos = Env::Default()->NowNanos();
+    testing::StartTiming();
+    for (int i = 0; i < iters; ++i) {
+      TF_CHECK_OK(executor_->Run(args));
+    }
+    testing::StopTiming();
+    const uint64 elapsed_nanos = Env::Default()->NowNanos() - start_nanos;
+    AllocatorStats after;
+    cpu_allocator()->GetStats(&after);
+    EnableCPUAllocatorStats(false);
+    rendez->Unref();
+
+    const int64 nodes = nodes_per_step * iters;
+    testing::ItemsProcessed(nodes);
+    testing::SetLabel(strings::Printf(
+        "%.1f ns/node, %.1f schedules/step, %.1f allocs/step",
+        static_cast<double>(elapsed_nanos) / nodes,
+        static_cast<double>(num_schedules_.load()) / iters,
+        static_cast<double>(after.num_allocs - before.num_allocs) / iters));
+  }
+
+ private:
+  Executor::Args MakeArgs(Rendezvous* rendez) {
+    Executor::Args args;
+    args.rendezvous = rendez;
+    args.runner = [this](Executor::Args::Closure c) {
+      num_schedules_.fetch_add(1, std::memory_order_relaxed);
+      pool_->Schedule(std::move(c));
+    };
+    return args;
+  }
+
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<thread::ThreadPool> pool_;
+  std::unique_ptr<Executor> executor_;
+  std::atomic<int64> num_schedules_{0};
+};
+
+Node* ScalarConstant(Graph* g) {
+  return test::graph::Constant(g, test::AsScalar<float>(1.0));
+}
+
+// A chain of "length" Identity nodes.
+Graph* Chain(int length, int64* nodes_per_step) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node = ScalarConstant(g);
+  for (int i = 0; i < length; ++i) {
+    node = test::graph::Identity(g, node);
+  }
+  *nodes_per_step = length + 1;
+  return g;
+}
+
+// One node that feeds "width" Identity nodes.
+Graph* FanOut(int width, int64* nodes_per_step) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* source = ScalarConstant(g);
+  for (int i = 0; i < width; ++i) {
+    test::graph::Identity(g, source);
+  }
+  *nodes_per_step = width + 1;
+  return g;
+}
+
+// "depth" layers of "width" NoOps, each with control inputs from two nodes
+// of the previous layer.
+Graph* Layers(int width, int depth, int64* nodes_per_step) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<Node*> layer;
+  for (int i = 0; i < width; ++i) {
+    layer.push_back(test::graph::NoOp(g, {}));
+  }
+  for (int d = 1; d < depth; ++d) {
+    std::vector<Node*> next;
+    for (int i = 0; i < width; ++i) {
+      next.push_back(
+          test::graph::NoOp(g, {layer[i], layer[(i + 1) % width]}));
+    }
+    layer.swap(next);
+  }
+  *nodes_per_step = static_cast<int64>(width) * depth;
+  return g;
+}
+
+Node* ConstantEnter(Graph* g, Node* input, const string& frame_name) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Enter")
+                  .Input(input)
+                  .Attr("frame_name", frame_name)
+                  .Attr("is_constant", true)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+// Adds a while loop that counts from "start" to "iterations" in frame
+// "frame" and returns its Exit node. If "depth" > 1, every iteration also
+// runs a loop of "depth" - 1 levels nested in a frame of its own.
+Node* CountingLoop(Graph* g, Node* start, const string& frame, int iterations,
+                   int depth) {
+  Node* limit = test::graph::Constant(g, test::AsScalar<int32>(iterations));
+  g->AddControlEdge(start, limit);
+  Node* limit_enter = ConstantEnter(g, limit, frame);
+  Node* enter = test::graph::Enter(g, start, frame);
+  const string next_name = g->NewName("next");
+  Node* merge = test::graph::Merge(g, enter, {next_name});
+  Node* less = test::graph::Less(g, merge, limit_enter);
+  Node* cond = test::graph::LoopCond(g, less);
+  Node* switch_node = test::graph::Switch(g, merge, cond);
+  Node* exit = test::graph::Exit(g, switch_node);
+  Node* body = test::graph::Identity(g, switch_node, 1);
+  Node* one = test::graph::Constant(g, test::AsScalar<int32>(1));
+  g->AddControlEdge(body, one);
+  Node* add = test::graph::Add(g, body, one);
+  if (depth > 1) {
+    Node* zero = test::graph::Constant(g, test::AsScalar<int32>(0));
+    g->AddControlEdge(body, zero);
+    Node* inner = CountingLoop(g, zero, strings::StrCat(frame, "/inner"),
+                               iterations, depth - 1);
+    g->AddControlEdge(inner, add);
+  }
+  Node* next = test::graph::Next(g, next_name, add);
+  g->AddEdge(next, 0, merge, 1);
+  return exit;
+}
+
+// The number of live nodes that one run of a CountingLoop executes: the
+// limit, the enters and the exit run once, the merge, the condition and the
+// switch once more than the body.
+int64 CountingLoopNodes(int iterations, int depth) {
+  int64 nodes = 4 + 4 * (iterations + 1) + 4 * iterations;
+  if (depth > 1) {
+    nodes += iterations * (1 + CountingLoopNodes(iterations, depth - 1));
+  }
+  return nodes;
+}
+
+// A while loop of "iterations" iterations, nested "depth" levels deep.
+Graph* WhileLoop(int iterations, int depth, int64* nodes_per_step) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* start = test::graph::Constant(g, test::AsScalar<int32>(0));
+  CountingLoop(g, start, "loop", iterations, depth);
+  *nodes_per_step = 1 + CountingLoopNodes(iterations, depth);
+  return g;
+}
+
+void RunBenchmark(int iters, Graph* g, int64 nodes_per_step,
+                  int num_threads) {
+  testing::StopTiming();
+  ExecutorBenchmark bench(g, num_threads);
+  bench.Run(iters, nodes_per_step);
+}
+
+TEST(ExecutorBenchmarkTest, GraphsRun) {
+  int64 nodes_per_step;
+  for (Graph* g :
+       {Chain(10, &nodes_per_step), FanOut(10, &nodes_per_step),
+        Layers(10, 10, &nodes_per_step), WhileLoop(10, 1, &nodes_per_step),
+        WhileLoop(3, 3, &nodes_per_step)}) {
+    for (int num_threads : {1, 4}) {
+      Graph* copy = new Graph(OpRegistry::Global());
+      CopyGraph(*g, copy);
+      ExecutorBenchmark bench(copy, num_threads);
+      TF_EXPECT_OK(bench.RunOnce());
+    }
+    delete g;
+  }
+}
+
+void BM_Chain(int iters, int length, int num_threads) {
+  int64 nodes_per_step;
+  Graph* g = Chain(length, &nodes_per_step);
+  RunBenchmark(iters, g, nodes_per_step, num_threads);
+}
+BENCHMARK(BM_Chain)->ArgPair(1000, 1)->ArgPair(1000, 4)->ArgPair(1000, 16);
+
+void BM_FanOut(int iters, int width, int num_threads) {
+  int64 nodes_per_step;
+  Graph* g = FanOut(width, &nodes_per_step);
+  RunBenchmark(iters, g, nodes_per_step, num_threads);
+}
+BENCHMARK(BM_FanOut)->ArgPair(1000, 1)->ArgPair(1000, 4)->ArgPair(1000, 16);
+
+// 100k trivial nodes.
+void BM_LargeGraph(int iters, int width, int num_threads) {
+  int64 nodes_per_step;
+  Graph* g = Layers(width, 100000 / width, &nodes_per_step);
+  RunBenchmark(iters, g, nodes_per_step, num_threads);
+}
+BENCHMARK(BM_LargeGraph)
+    ->ArgPair(10, 1)
+    ->ArgPair(10, 4)
+    ->ArgPair(10, 16)
+    ->ArgPair(1000, 1)
+    ->ArgPair(1000, 4)
+    ->ArgPair(1000, 16);
+
+void BM_WhileLoop(int iters, int iterations, int num_threads) {
+  int64 nodes_per_step;
+  Graph* g = WhileLoop(iterations, 1, &nodes_per_step);
+  RunBenchmark(iters, g, nodes_per_step, num_threads);
+}
+BENCHMARK(BM_WhileLoop)
+    ->ArgPair(10000, 1)
+    ->ArgPair(10000, 4)
+    ->ArgPair(10000, 16);
+
+void BM_NestedLoops(int iters, int depth, int num_threads) {
+  int64 nodes_per_step;
+  Graph* g = WhileLoop(4, depth, &nodes_per_step);
+  RunBenchmark(iters, g, nodes_per_step, num_threads);
+}
+BENCHMARK(BM_NestedLoops)
+    ->ArgPair(2, 1)
+    ->ArgPair(2, 4)
+    ->ArgPair(6, 1)
+    ->ArgPair(6, 4);
+
+}  // namespace
+}  // namespace tensorflow
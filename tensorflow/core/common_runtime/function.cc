@@ -51,6 +51,10 @@ static constexpr const char* const kNodeLabel = "Func";
 static constexpr const char* const kFuncAttr =
     FunctionLibraryDefinition::kFuncAttr;
 
+// Function bodies with at most this many op nodes may run on the calling
+// thread (see FunctionLibraryRuntime::Options::run_small_functions_inline).
+static constexpr int kMaxInlineRunNodes = 32;
+
 // Represents the index-th output of a node.
 struct Endpoint {
   Node* node;
@@ -202,6 +206,10 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
   struct Item : public core::RefCounted {
     const Graph* graph = nullptr;  // Owned by exec.
     Executor* exec = nullptr;
+    // True if the graph has send/recv nodes and so needs a rendezvous.
+    bool has_send_recv = false;
+    // True if the graph is small enough to run on the calling thread.
+    bool small = false;
 
     ~Item() override { delete this->exec; }
   };
@@ -486,6 +494,13 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
   *item = new Item;
   (*item)->graph = graph;
   (*item)->exec = exec;
+  for (const Node* n : graph->op_nodes()) {
+    if (n->IsSend() || n->IsRecv()) {
+      (*item)->has_send_recv = true;
+      break;
+    }
+  }
+  (*item)->small = graph->num_op_nodes() <= kMaxInlineRunNodes;
   return Status::OK();
 }
 
@@ -546,10 +561,17 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
   exec_args.step_container = opts.step_container;
   exec_args.call_frame = frame;
   exec_args.cancellation_manager = opts.cancellation_manager;
-  exec_args.runner = *opts.runner;
-  // TODO(zhifengc): we can avoid creating rendez here if we know
-  // there is no send/recv nodes in the graph.
-  auto* rendez = new IntraProcessRendezvous(device_mgr_);
+  if (opts.run_small_functions_inline && item->small &&
+      !item->has_send_recv) {
+    exec_args.runner = [](Executor::Args::Closure c) { c(); };
+  } else {
+    exec_args.runner = *opts.runner;
+  }
+  // Only create a rendezvous if there are send/recv nodes in the graph.
+  IntraProcessRendezvous* rendez = nullptr;
+  if (item->has_send_recv) {
+    rendez = new IntraProcessRendezvous(device_mgr_);
+  }
   exec_args.rendezvous = rendez;
   item->exec->RunAsync(
       // Executor args
@@ -557,7 +579,7 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
       // Done callback.
       [item, frame, rets, rendez, done](const Status& status) {
         item->Unref();
-        rendez->Unref();
+        if (rendez != nullptr) rendez->Unref();
         Status s = status;
         if (s.ok()) {
           s = frame->GetRetvals(rets);
@@ -968,7 +990,26 @@ void InlineFunctionBody(const FunctionLibraryDefinition& flib_def, Graph* g,
   g->RemoveNode(caller);  // 'caller' is replaced with inlined nodes.
 }
 
-bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
+namespace {
+
+// Returns true if "fbody" has at most "max_body_nodes" op nodes and none of
+// them is a function call.
+bool IsSmallLeafFunction(const FunctionLibraryDefinition& fld,
+                         const FunctionBody& fbody, int max_body_nodes) {
+  if (fbody.graph->num_op_nodes() > max_body_nodes) return false;
+  for (const Node* n : fbody.graph->op_nodes()) {
+    if (n->type_string() == kGradientOp ||
+        fld.Find(n->type_string()) != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Inlines the function calls in "graph". If "max_body_nodes" is
+// non-negative, only inlines calls to small leaf functions.
+bool ExpandInlineFunctionsImpl(FunctionLibraryRuntime* lib, Graph* graph,
+                               int max_body_nodes) {
   std::vector<std::pair<Node*, const FunctionBody*>> candidates;
   const FunctionLibraryDefinition* fld = lib->GetFunctionLibraryDefinition();
   for (Node* node : graph->nodes()) {
@@ -991,6 +1032,11 @@ bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
     }
     const FunctionBody* fbody = lib->GetFunctionBody(handle);
     CHECK_NOTNULL(fbody);
+    if (max_body_nodes >= 0 &&
+        !IsSmallLeafFunction(*fld, *fbody, max_body_nodes)) {
+      VLOG(3) << "Not a small function: " << node->DebugString();
+      continue;
+    }
     candidates.push_back({node, fbody});
   }
   for (const auto& p : candidates) {
@@ -999,6 +1045,17 @@ bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
   return !candidates.empty();
 }
 
+}  // namespace
+
+bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
+  return ExpandInlineFunctionsImpl(lib, graph, -1);
+}
+
+bool ExpandSmallInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph,
+                                int max_body_nodes) {
+  return ExpandInlineFunctionsImpl(lib, graph, max_body_nodes);
+}
+
 string NewName(const Node* n, bool pretty) {
   if (pretty) {
     return strings::StrCat(n->type_string(), n->id());
@@ -118,6 +118,13 @@ bool RemoveListArrayConverter(Graph* g);
 // multiple times by calling ExpandInlineFunctions a few times.
 bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph);
 
+// Like ExpandInlineFunctions, but only inlines calls to functions whose
+// bodies have at most "max_body_nodes" op nodes and call no other
+// functions. Such calls are never recursive, and inlining them saves the
+// per-call overhead of running a separate executor.
+bool ExpandSmallInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph,
+                                int max_body_nodes);
+
 // Dump the contents of the "graph" to log files if the logging level is
 // sufficiently high.
 void DumpGraph(StringPiece label, const Graph* g);
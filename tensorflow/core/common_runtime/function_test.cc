@@ -406,6 +406,51 @@ TEST_F(FunctionLibraryRuntimeTest, ExpandInlineFunctions) {
   }
 }
 
+TEST_F(FunctionLibraryRuntimeTest, ExpandSmallInlineFunctions) {
+  Init({test::function::XTimesTwo(), test::function::XTimesFour(),
+        test::function::XTimes16()});
+  std::unique_ptr<Graph> g = GetFuncBody("XTimes16", {{"T", DT_FLOAT}});
+  ASSERT_TRUE(g != nullptr);
+
+  // XTimesFour calls XTimesTwo, so it is not inlined.
+  EXPECT_FALSE(ExpandSmallInlineFunctions(lib_.get(), g.get(), 16));
+
+  // XTimesTwo calls no other function.
+  ExpandInlineFunctions(lib_.get(), g.get());
+  EXPECT_FALSE(ExpandSmallInlineFunctions(lib_.get(), g.get(), 1));
+  EXPECT_TRUE(ExpandSmallInlineFunctions(lib_.get(), g.get(), 16));
+  for (const Node* n : g->op_nodes()) {
+    EXPECT_NE("XTimesTwo", n->type_string());
+  }
+  EXPECT_FALSE(ExpandSmallInlineFunctions(lib_.get(), g.get(), 16));
+}
+
+TEST_F(FunctionLibraryRuntimeTest, RunSmallFunctionInline) {
+  Init({test::function::XTimesTwo(), test::function::XTimesFour()});
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(lib_->Instantiate("XTimesFour", {{"T", DT_FLOAT}}, &handle));
+
+  int call_count = 0;
+  std::function<void(std::function<void()>)> runner =
+      [&call_count](std::function<void()> fn) {
+        ++call_count;
+        fn();
+      };
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = &runner;
+  opts.run_small_functions_inline = true;
+  std::vector<Tensor> out;
+  Status status = errors::Unknown("not done");
+  lib_->Run(opts, handle, {test::AsTensor<float>({1, 2, 3, 4})}, &out,
+            [&status](const Status& s) { status = s; });
+  // All the nodes ran on this thread.
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(0, call_count);
+  ASSERT_EQ(1, out.size());
+  test::ExpectTensorEqual<float>(out[0],
+                                 test::AsTensor<float>({4, 8, 12, 16}));
+}
+
 // Verifies that control dependencies on the caller are added as control
 // dependencies on any function calls created by inlining.
 TEST_F(FunctionLibraryRuntimeTest, ExpandInlineFunctionsWithControlDeps) {
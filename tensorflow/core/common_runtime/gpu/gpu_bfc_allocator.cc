@@ -15,11 +15,22 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
+#ifdef _MSC_VER
+#define __thread __declspec(thread)
+#endif
+
 namespace tensorflow {
 
+// The allocator and stream id of the innermost ScopedStream of the calling
+// thread.
+static __thread GPUBFCAllocator* tls_allocator = nullptr;
+static __thread int tls_stream_id = -1;
+
 GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory)
     : GPUBFCAllocator(device_id, total_memory, GPUOptions()) {}
 
@@ -31,4 +42,33 @@ GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory,
           total_memory, gpu_options.allow_growth(),
           strings::StrCat("GPU_", device_id, "_bfc")) {}
 
+int GPUBFCAllocator::StreamId(gpu::Stream* stream) {
+  mutex_lock l(mu_);
+  auto it = std::find(streams_.begin(), streams_.end(), stream);
+  if (it != streams_.end()) return it - streams_.begin();
+  streams_.push_back(stream);
+  return streams_.size() - 1;
+}
+
+int GPUBFCAllocator::CurrentStream() {
+  return tls_allocator == this ? tls_stream_id : -1;
+}
+
+void GPUBFCAllocator::WaitForStream(int stream, int other) {
+  mutex_lock l(mu_);
+  streams_[stream]->ThenWaitFor(streams_[other]);
+}
+
+GPUBFCAllocator::ScopedStream::ScopedStream(GPUBFCAllocator* allocator,
+                                            int stream_id)
+    : saved_allocator_(tls_allocator), saved_stream_id_(tls_stream_id) {
+  tls_allocator = allocator;
+  tls_stream_id = stream_id;
+}
+
+GPUBFCAllocator::ScopedStream::~ScopedStream() {
+  tls_allocator = saved_allocator_;
+  tls_stream_id = saved_stream_id_;
+}
+
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
@@ -34,6 +35,11 @@ namespace tensorflow {
 
 // A GPU memory allocator that implements a 'best-fit with coalescing'
 // algorithm.
+//
+// Allocations made inside a ScopedStream are stream-ordered (see
+// BFCAllocator): their memory can be reused by later work on the same
+// stream as soon as it is freed, and by work on other streams after they
+// have been made to wait for the stream.
 class GPUBFCAllocator : public BFCAllocator {
  public:
   // 'device_id' refers to the StreamExecutor ID of the device within
@@ -43,6 +49,33 @@ class GPUBFCAllocator : public BFCAllocator {
                   const GPUOptions& gpu_options);
   virtual ~GPUBFCAllocator() {}
 
+  // Returns the id the allocator knows 'stream' by, registering the stream
+  // on first use.  'stream' must outlive the allocator.
+  int StreamId(gpu::Stream* stream);
+
+  // Makes the allocations of the calling thread from 'allocator'
+  // stream-ordered on the stream with id 'stream_id' while the object is
+  // alive.
+  class ScopedStream {
+   public:
+    ScopedStream(GPUBFCAllocator* allocator, int stream_id);
+    ~ScopedStream();
+
+   private:
+    GPUBFCAllocator* const saved_allocator_;
+    const int saved_stream_id_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(ScopedStream);
+  };
+
+ protected:
+  int CurrentStream() override;
+  void WaitForStream(int stream, int other) override;
+
+ private:
+  mutex mu_;
+  std::vector<gpu::Stream*> streams_ GUARDED_BY(mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GPUBFCAllocator);
 };
 
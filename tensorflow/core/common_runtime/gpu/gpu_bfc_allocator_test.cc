@@ -158,6 +158,13 @@ TEST(GPUBFCAllocatorTest, ExerciseCoalescing) {
   float* first_ptr_after = a.Allocate<float>(1024);
   EXPECT_EQ(first_ptr, first_ptr_after);
   a.DeallocateRaw(first_ptr_after);
+
+  // The coalesced free memory holds the largest allocation made above.
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_GE(stats.largest_free_block_bytes,
+            static_cast<int64>(10485760 * sizeof(float)));
+  EXPECT_LE(stats.largest_free_block_bytes, stats.bytes_reserved);
 }
 
 TEST(GPUBFCAllocatorTest, AllocateZeroBufSize) {
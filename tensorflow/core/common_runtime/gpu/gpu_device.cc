@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_peer_copy.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
@@ -295,6 +296,23 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
         i, streams_.back()->compute, streams_.back()->host_to_device,
         streams_.back()->device_to_host, streams_.back()->device_to_device));
   }
+  if (max_streams_ > 1 &&
+      options.config.gpu_options().stream_ordered_allocation()) {
+    stream_ordered_allocator_ =
+        ProcessState::singleton()->GetGPUBFCAllocator(gpu_id_);
+    if (stream_ordered_allocator_ != nullptr) {
+      for (StreamGroup* group : streams_) {
+        allocator_stream_ids_.push_back(
+            stream_ordered_allocator_->StreamId(group->compute));
+      }
+    }
+  }
+
+  if (options.config.gpu_options().unified_memory_oversubscription()) {
+    managed_allocator_ =
+        ProcessState::singleton()->GetGPUManagedMemoryAllocator(gpu_id_);
+  }
+
   gpu_device_info_ = new GpuDeviceInfo;
   gpu_device_info_->stream = streams_[0]->compute;
   gpu_device_info_->default_context = device_contexts_[0];
@@ -340,8 +358,31 @@ Status BaseGPUDevice::FillContextMap(const Graph* graph,
     VLOG(3) << "Assigned stream " << node_to_stream_id[n->id()]
             << " ==> stream[" << ctx->stream_id() << "] for node id " << n->id()
             << " " << n->type_string() << " " << n->name();
-    ctx->Ref();
-    (*device_context_map)[n->id()] = ctx;
+    bool has_cross_stream_output = false;
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() &&
+          node_to_stream_id[e->dst()->id()] != mapped_stream) {
+        has_cross_stream_output = true;
+        break;
+      }
+    }
+    std::unique_ptr<gpu::Event> event;
+    if (has_cross_stream_output) {
+      event.reset(new gpu::Event(executor_));
+      if (!event->Init()) event.reset();
+    }
+    if (event != nullptr) {
+      // Give the node a context of its own on the same streams, whose event
+      // its consumers on other streams wait for.
+      auto node_ctx = new GPUDeviceContext(
+          ctx->stream_id(), ctx->stream(), ctx->host_to_device_stream(),
+          ctx->device_to_host_stream(), ctx->device_to_device_stream());
+      node_ctx->set_output_event(event.release());
+      (*device_context_map)[n->id()] = node_ctx;
+    } else {
+      ctx->Ref();
+      (*device_context_map)[n->id()] = ctx;
+    }
   }
 
   return Status::OK();
@@ -376,6 +417,23 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
   }
 }
 
+void BaseGPUDevice::PrefetchInputs(OpKernelContext* context,
+                                   gpu::Stream* stream) {
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (!context->has_input(i)) continue;
+    if (IsRefType(context->input_dtype(i))) {
+      Tensor tensor = context->mutable_input(i, false);
+      managed_allocator_->PreferDevice(DMAHelper::base(&tensor));
+      managed_allocator_->Prefetch(DMAHelper::base(&tensor),
+                                   tensor.TotalBytes(), stream);
+    } else {
+      const Tensor& tensor = context->input(i);
+      managed_allocator_->Prefetch(DMAHelper::base(&tensor),
+                                   tensor.TotalBytes(), stream);
+    }
+  }
+}
+
 void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
                                   OpKernelContext* context) {
   GPUDeviceContext* gpu_device_context = device_contexts_[0];
@@ -397,8 +455,10 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
 
   const auto num_streams = streams_.size();
   if (num_streams > 1) {
-    // If this op's device context is different from the other contexts,
-    // we must wait on the stream.
+    // If an input was produced on a different stream, we must wait for its
+    // producer: for the event recorded after its kernel if it has one, or
+    // else for everything queued on its stream so far.
+    gtl::InlinedVector<const GPUDeviceContext*, 4> waited_for;
     for (int i = 0; i < context->num_inputs(); ++i) {
       const GPUDeviceContext* idc =
           static_cast<GPUDeviceContext*>(context->input_device_context(i));
@@ -424,12 +484,33 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
                     << ((idc->stream() == stream) ? " not needed" : "");
         }
       }
-      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
+      if (idc->stream() == stream ||
+          std::find(waited_for.begin(), waited_for.end(), idc) !=
+              waited_for.end()) {
+        continue;
+      }
+      waited_for.push_back(idc);
+      gpu::Event* event = idc->output_event();
+      if (event != nullptr) {
+        stream->ThenWaitFor(event);
+      } else {
+        stream->ThenWaitFor(idc->stream());
+      }
     }
   }
   gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
-  op_kernel->Compute(context);
+  if (managed_allocator_ != nullptr) {
+    PrefetchInputs(context, stream);
+  }
+  {
+    GPUBFCAllocator::ScopedStream scoped_stream(
+        stream_ordered_allocator_, stream_ordered_allocator_ != nullptr
+                                       ? allocator_stream_ids_[stream_id]
+                                       : -1);
+    op_kernel->Compute(context);
+  }
   if (context->status().ok()) {
+    gpu_device_context->RecordOutputEvent();
     if (sync_every_op_) {
       // Note: GPUUtil::Sync() only syncs the default stream.
       // We need to either sync the stream used by this op, or
@@ -447,7 +528,40 @@ void BaseGPUDevice::ConsumeListOfAccessedTensors(
     gpu_device_context = static_cast<GPUDeviceContext*>(device_context);
   }
   gpu::Stream* stream = gpu_device_context->stream();
-  em_->ThenDeleteTensors(stream, tensor_refs);
+  if (stream_ordered_allocator_ == nullptr) {
+    em_->ThenDeleteTensors(stream, tensor_refs);
+    return;
+  }
+
+  // Memory allocated on this stream can be freed as soon as the kernel is
+  // launched, since the allocator only lets later work on the stream reuse
+  // it without waiting for the stream.  Anything else waits for the kernel
+  // to complete.
+  const int allocator_stream =
+      allocator_stream_ids_[gpu_device_context->stream_id()];
+  TensorReferenceVector deferred;
+  for (const TensorReference& ref : tensor_refs) {
+    if (stream_ordered_allocator_->AllocationStream(ref.data()) ==
+        allocator_stream) {
+      ref.Unref();
+    } else {
+      deferred.push_back(ref);
+    }
+  }
+  if (!deferred.empty()) {
+    em_->ThenDeleteTensors(stream, deferred);
+  }
+
+  // Once the work queued so far completes, the memory freed on the stream
+  // can be reused by any allocation.
+  int64 num_frees;
+  if (stream_ordered_allocator_->TakeStreamFrees(allocator_stream,
+                                                 &num_frees)) {
+    GPUBFCAllocator* allocator = stream_ordered_allocator_;
+    em_->ThenExecute(stream, [allocator, allocator_stream, num_frees]() {
+      allocator->RetireStreamFrees(allocator_stream, num_frees);
+    });
+  }
 }
 
 // Based on the semantics of Device::Sync this call should wait for
@@ -472,6 +586,8 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   // following TraceMe constructor is simply a conditional test of
   // false value. Measurements show that its overhead is negligible.
   port::Tracing::TraceMe activity(op_kernel->name(), op_kernel->type_string());
+  // Allocations of async kernels are not stream-ordered, since 'done' may
+  // run other work on this thread before ComputeAsync() returns.
   op_kernel->ComputeAsync(context, done);
 }
 
@@ -801,8 +917,11 @@ std::unique_ptr<std::map<std::pair<int, int>, bool>> GetPeerAccessMap(
   return map;
 }
 
+// Enables peer access between the GPUs of 'visible_gpu_order' wherever the
+// driver allows it, and records the outcome by gpu id in 'enabled'.
 Status EnablePeerAccess(gpu::Platform* platform,
-                        const std::vector<int>& visible_gpu_order) {
+                        const std::vector<int>& visible_gpu_order,
+                        PeerAccessMap* enabled) {
   int possible_peer_count = 0;
   int enabled_peer_count = 0;
   for (int i = 0; i < visible_gpu_order.size(); ++i) {
@@ -816,6 +935,7 @@ Status EnablePeerAccess(gpu::Platform* platform,
       gpu::StreamExecutor* to =
           platform->ExecutorForDevice(j_gpu_id).ValueOrDie();
 
+      (*enabled)[{i_gpu_id, j_gpu_id}] = false;
       if (from->CanEnablePeerAccessTo(to)) {
         ++possible_peer_count;
         auto status = from->EnablePeerAccessTo(to);
@@ -825,6 +945,7 @@ Status EnablePeerAccess(gpu::Platform* platform,
               << i_gpu_id << " and " << j_gpu_id;
         } else {
           ++enabled_peer_count;
+          (*enabled)[{i_gpu_id, j_gpu_id}] = true;
         }
       } else {
         LOG(INFO) << "Peer access not supported between device ordinals "
@@ -946,8 +1067,13 @@ Status BaseGPUDeviceFactory::GetValidDeviceIds(
   }
 
   if (new_gpu_found) {
-    // Enable peer access
-    TF_RETURN_IF_ERROR(EnablePeerAccess(gpu_manager, visible_gpu_order));
+    // Enable peer access, and set up the routes of the copies between GPUs
+    // over the peer links.
+    PeerAccessMap enabled;
+    TF_RETURN_IF_ERROR(
+        EnablePeerAccess(gpu_manager, visible_gpu_order, &enabled));
+    TF_RETURN_IF_ERROR(GPUPeerCopyEngine::Global()->AddGPUs(
+        gpu_manager, visible_gpu_order, enabled));
 
     // Print out a matrix showing which devices can DMA to one
     // another.
@@ -27,7 +27,9 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_memory_allocator.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -117,10 +119,25 @@ class BaseGPUDevice : public LocalDevice {
   const int32 max_streams_;
   std::unique_ptr<EventMgr> em_;
 
+  // If GPUOptions.stream_ordered_allocation is set and there are several
+  // streams, the allocator whose allocations are stream-ordered on the
+  // compute streams, and the ids it knows the compute streams by.
+  GPUBFCAllocator* stream_ordered_allocator_ = nullptr;  // not owned
+  gtl::InlinedVector<int, 4> allocator_stream_ids_;
+
+  // If GPUOptions.unified_memory_oversubscription is set, the allocator that
+  // backs the tensors that do not fit in GPU memory with unified memory.
+  GPUManagedMemoryAllocator* managed_allocator_ = nullptr;  // not owned
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
+
+  // Enqueues on "stream" the migration of the inputs of the kernel of
+  // "context" that are in unified memory to the device, and advises the
+  // driver to keep the variables among them on the device.
+  void PrefetchInputs(OpKernelContext* context, gpu::Stream* stream);
 };
 
 class BaseGPUDeviceFactory : public DeviceFactory {
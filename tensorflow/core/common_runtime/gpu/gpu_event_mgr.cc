@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
@@ -34,6 +35,7 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
           gpu_options.polling_inactive_delay_msecs()
               ? gpu_options.polling_inactive_delay_msecs()
               : 1),
+      use_stream_callbacks_(gpu_options.use_stream_callbacks_for_events()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
@@ -44,7 +46,15 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
 }
 
 EventMgr::~EventMgr() {
+  if (use_stream_callbacks_) {
+    // The callbacks still to run refer to this object.
+    mutex_lock l(mu_);
+    while (num_pending_callbacks_ > 0) callbacks_done_.wait(l);
+  }
   StopPollingLoop();
+  VLOG(1) << "EventMgr completion latency in microseconds:\n"
+          << completion_latency_usecs_.ToString();
+  FreeMemory(completed_);
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -80,7 +90,13 @@ void EventMgr::StartPollingLoop() {
   CHECK(polling_stopped_ == nullptr);
   stop_polling_.reset(new Notification);
   polling_stopped_.reset(new Notification);
-  threadpool_.Schedule([this]() { PollLoop(); });
+  threadpool_.Schedule([this]() {
+    if (use_stream_callbacks_) {
+      CallbackLoop();
+    } else {
+      PollLoop();
+    }
+  });
 }
 
 void EventMgr::StopPollingLoop() {
@@ -147,9 +163,49 @@ void EventMgr::PollLoop() {
   polling_stopped_->Notify();
 }
 
+void EventMgr::CallbackDone(const InUse& iu) {
+  // This runs on a driver thread that must not be held up, so the memory is
+  // freed by CallbackLoop().
+  mutex_lock l(mu_);
+  completion_latency_usecs_.Add(Env::Default()->NowMicros() -
+                                iu.queued_micros);
+  completed_.push_back(iu);
+  events_pending_.notify_all();
+  if (--num_pending_callbacks_ == 0) callbacks_done_.notify_all();
+}
+
+void EventMgr::CallbackLoop() {
+  while (!stop_polling_->HasBeenNotified()) {
+    ToFreeVector to_free;
+    {
+      mutex_lock l(mu_);
+      if (completed_.empty()) {
+        // Woken up by CallbackDone(); the timeout only bounds how long
+        // StopPollingLoop() waits.
+        WaitForMilliseconds(&l, &events_pending_,
+                            polling_inactive_delay_msecs_);
+      }
+      to_free.swap(completed_);
+    }
+    FreeMemory(to_free);
+  }
+  polling_stopped_->Notify();
+}
+
+void EventMgr::GetCompletionLatency(HistogramProto* proto) {
+  mutex_lock l(mu_);
+  completion_latency_usecs_.EncodeToProto(proto, false);
+}
+
 void EventMgr::QueueInUse(gpu::Stream* stream, InUse iu) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  iu.queued_micros = Env::Default()->NowMicros();
+  if (use_stream_callbacks_) {
+    ++num_pending_callbacks_;
+    stream->ThenDoHostCallback([this, iu]() { CallbackDone(iu); });
+    return;
+  }
   // Events are created on demand, and repeatedly reused.  There is no
   // limit placed here on the number of allocated Events.
   if (free_events_.empty()) {
@@ -192,6 +248,7 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
+  int64 now_micros = 0;
   for (auto& iu : used_events_) {
     if (iu.event == nullptr) continue;
     gpu::Event::Status s = iu.event->PollForStatus();
@@ -206,6 +263,8 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
         if (!is_dedicated_poller) return;  // quit processing queue
         break;
       case gpu::Event::Status::kComplete:
+        if (now_micros == 0) now_micros = Env::Default()->NowMicros();
+        completion_latency_usecs_.Add(now_micros - iu.queued_micros);
         // Make a copy of the InUse record so we can free it after releasing
         // the lock
         to_free->push_back(iu);
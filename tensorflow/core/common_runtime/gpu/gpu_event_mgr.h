@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -40,6 +41,7 @@ class StreamExecutor;
 namespace tensorflow {
 
 class GPUOptions;
+class HistogramProto;
 
 // An object to keep track of pending Events in the StreamExecutor streams
 // and associated Tensors that cannot safely be deleted until the associated
@@ -89,12 +91,19 @@ class EventMgr {
     FreeMemory(to_free);
   }
 
+  // Fills in the histogram of the microseconds from queueing a deferred
+  // deallocation or callback to noticing that the work queued before it
+  // has completed, to compare event polling with stream callbacks.
+  void GetCompletionLatency(HistogramProto* proto);
+
  private:
   friend class TEST_EventMgrHelper;
   perftools::gputools::StreamExecutor* const exec_;
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
   const int32 polling_inactive_delay_msecs_;
+  // GPUOptions.use_stream_callbacks_for_events.
+  const bool use_stream_callbacks_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -105,6 +114,8 @@ class EventMgr {
     TensorReferenceVector* mem;
     BufRec bufrec;
     std::function<void()> func;
+    // When the record was queued, for completion_latency_usecs_.
+    int64 queued_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
@@ -164,6 +175,14 @@ class EventMgr {
   // straggler Events.
   void PollLoop();
 
+  // With stream callbacks, called by the stream once the work queued
+  // before "iu" has completed.
+  void CallbackDone(const InUse& iu);
+
+  // The loop that replaces PollLoop() with stream callbacks: frees the
+  // records in completed_ as soon as the callbacks add them.
+  void CallbackLoop();
+
   // Setup/Teardown functions for the polling loop.
   void StartPollingLoop();
   void StopPollingLoop();
@@ -180,6 +199,15 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // With stream callbacks, the records whose callbacks have run but that
+  // CallbackLoop() has not freed yet, and the number of callbacks that
+  // have not run yet.
+  ToFreeVector completed_ GUARDED_BY(mu_);
+  int64 num_pending_callbacks_ GUARDED_BY(mu_) = 0;
+  condition_variable callbacks_done_;
+
+  histogram::Histogram completion_latency_usecs_ GUARDED_BY(mu_);
+
   std::unique_ptr<Notification> stop_polling_;
   std::unique_ptr<Notification> polling_stopped_;
 
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <atomic>
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -226,6 +228,30 @@ TEST(EventMgr, ManySmallTensorsSeparateCallsFlushed) {
   }
 }
 
+// With stream callbacks, deferred deletions and callbacks complete without
+// any polling.
+TEST(EventMgr, StreamCallbacks) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions options;
+  options.set_use_stream_callbacks_for_events(true);
+  EventMgr em(stream_exec, options);
+  std::unique_ptr<gpu::Stream> stream(new gpu::Stream(stream_exec));
+  CHECK(stream.get());
+  stream->Init();
+  TensorReferenceVector v;
+  AddTensorReference(&v, 100 * 1048576);
+  em.ThenDeleteTensors(stream.get(), v);
+  Notification n;
+  em.ThenExecute(stream.get(), [&n]() { n.Notify(); });
+  n.WaitForNotification();
+  // The tensors were deleted once the stream reached them, before the
+  // function that was queued after them ran.
+  EXPECT_EQ(0, live_tensor_bytes);
+  HistogramProto latency;
+  em.GetCompletionLatency(&latency);
+  EXPECT_EQ(2, latency.num());
+}
+
 // Deleting the EventMgr when events are still pending should shut
 // down gracefully.
 TEST(EventMgr, NonEmptyShutdown) {
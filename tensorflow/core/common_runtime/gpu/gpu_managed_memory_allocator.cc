@@ -0,0 +1,193 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_memory_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace gpu = ::perftools::gputools;
+
+namespace tensorflow {
+
+constexpr size_t GPUManagedMemoryAllocator::kMinUnifiedMemoryBytes;
+
+GPUManagedMemoryAllocator::GPUManagedMemoryAllocator(
+    VisitableAllocator* allocator, int device_id)
+    : base_allocator_(allocator) {
+  stream_exec_ = GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie();
+}
+
+GPUManagedMemoryAllocator::~GPUManagedMemoryAllocator() {
+  delete base_allocator_;
+}
+
+void* GPUManagedMemoryAllocator::AllocateRaw(size_t alignment,
+                                             size_t num_bytes) {
+  return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+}
+
+void* GPUManagedMemoryAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  // Callers that can do without the memory get no unified memory, since
+  // paging it in would cost more than doing without.
+  if (num_bytes < kMinUnifiedMemoryBytes ||
+      allocation_attr.no_retry_on_failure) {
+    return base_allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+  AllocationAttributes no_retry_attr = allocation_attr;
+  no_retry_attr.no_retry_on_failure = true;
+  void* ptr = base_allocator_->AllocateRaw(alignment, num_bytes, no_retry_attr);
+  if (ptr != nullptr) return ptr;
+
+  // Unified memory allocations are aligned to at least 256 bytes.
+  ptr = alignment <= 256 ? stream_exec_->UnifiedMemoryAllocate(num_bytes)
+                         : nullptr;
+  if (ptr == nullptr) {
+    // Retry in the wrapped allocator, which reports the out-of-memory error.
+    return base_allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+  mutex_lock l(mu_);
+  if (num_unified_allocs_ == 0) {
+    LOG(WARNING) << "GPU memory is exhausted; allocating "
+                 << strings::HumanReadableNumBytes(num_bytes)
+                 << " of unified memory, which is paged between host and "
+                 << "device and slows the computation down.";
+  }
+  unified_[ptr] = {num_bytes, false};
+  ++num_unified_;
+  ++num_unified_allocs_;
+  unified_bytes_in_use_ += num_bytes;
+  max_unified_bytes_in_use_ =
+      std::max(max_unified_bytes_in_use_, unified_bytes_in_use_);
+  return ptr;
+}
+
+void GPUManagedMemoryAllocator::DeallocateRaw(void* ptr) {
+  if (num_unified_ > 0) {
+    mutex_lock l(mu_);
+    auto it = unified_.find(ptr);
+    if (it != unified_.end()) {
+      unified_bytes_in_use_ -= it->second.num_bytes;
+      unified_.erase(it);
+      --num_unified_;
+      // Freeing waits for the device to finish using the memory.
+      stream_exec_->UnifiedMemoryDeallocate(ptr);
+      return;
+    }
+  }
+  base_allocator_->DeallocateRaw(ptr);
+}
+
+void GPUManagedMemoryAllocator::AddAllocVisitor(Visitor visitor) {
+  return base_allocator_->AddAllocVisitor(visitor);
+}
+
+void GPUManagedMemoryAllocator::AddFreeVisitor(Visitor visitor) {
+  return base_allocator_->AddFreeVisitor(visitor);
+}
+
+bool GPUManagedMemoryAllocator::TracksAllocationSizes() {
+  return base_allocator_->TracksAllocationSizes();
+}
+
+size_t GPUManagedMemoryAllocator::RequestedSize(void* ptr) {
+  if (num_unified_ > 0) {
+    mutex_lock l(mu_);
+    auto it = unified_.find(ptr);
+    if (it != unified_.end()) return it->second.num_bytes;
+  }
+  return base_allocator_->RequestedSize(ptr);
+}
+
+size_t GPUManagedMemoryAllocator::AllocatedSize(void* ptr) {
+  if (num_unified_ > 0) {
+    mutex_lock l(mu_);
+    auto it = unified_.find(ptr);
+    if (it != unified_.end()) return it->second.num_bytes;
+  }
+  return base_allocator_->AllocatedSize(ptr);
+}
+
+int64 GPUManagedMemoryAllocator::AllocationId(void* ptr) {
+  if (num_unified_ > 0) {
+    mutex_lock l(mu_);
+    if (unified_.count(ptr) > 0) return 0;
+  }
+  return base_allocator_->AllocationId(ptr);
+}
+
+void GPUManagedMemoryAllocator::GetStats(AllocatorStats* stats) {
+  base_allocator_->GetStats(stats);
+  mutex_lock l(mu_);
+  stats->num_unified_allocs = num_unified_allocs_;
+  stats->unified_bytes_in_use = unified_bytes_in_use_;
+  stats->max_unified_bytes_in_use = max_unified_bytes_in_use_;
+  stats->unified_bytes_prefetched = unified_bytes_prefetched_;
+}
+
+std::pair<const void* const, GPUManagedMemoryAllocator::UnifiedAllocation>*
+GPUManagedMemoryAllocator::FindUnified(const void* ptr) {
+  auto it = unified_.upper_bound(ptr);
+  if (it == unified_.begin()) return nullptr;
+  --it;
+  const char* base = static_cast<const char*>(it->first);
+  if (static_cast<const char*>(ptr) >= base + it->second.num_bytes) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+void GPUManagedMemoryAllocator::Prefetch(const void* ptr, size_t num_bytes,
+                                         gpu::Stream* stream) {
+  if (num_unified_ == 0 || num_bytes == 0) return;
+  {
+    mutex_lock l(mu_);
+    auto* allocation = FindUnified(ptr);
+    if (allocation == nullptr) return;
+    const char* end = static_cast<const char*>(allocation->first) +
+                      allocation->second.num_bytes;
+    num_bytes =
+        std::min<size_t>(num_bytes, end - static_cast<const char*>(ptr));
+    unified_bytes_prefetched_ += num_bytes;
+  }
+  if (!stream_exec_->UnifiedMemoryPrefetch(stream, ptr, num_bytes)) {
+    VLOG(1) << "Could not prefetch unified memory at " << ptr;
+  }
+}
+
+void GPUManagedMemoryAllocator::PreferDevice(const void* ptr) {
+  if (num_unified_ == 0) return;
+  const void* base;
+  size_t num_bytes;
+  {
+    mutex_lock l(mu_);
+    auto* allocation = FindUnified(ptr);
+    if (allocation == nullptr || allocation->second.prefers_device) return;
+    allocation->second.prefers_device = true;
+    base = allocation->first;
+    num_bytes = allocation->second.num_bytes;
+  }
+  if (!stream_exec_->UnifiedMemoryPreferDevice(base, num_bytes)) {
+    VLOG(1) << "Could not set the preferred location of unified memory at "
+            << base;
+  }
+}
+
+}  // namespace tensorflow
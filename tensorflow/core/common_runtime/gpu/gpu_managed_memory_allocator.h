@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_GPU_GPU_MANAGED_MEMORY_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_MANAGED_MEMORY_ALLOCATOR_H_
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include "tensorflow/core/common_runtime/visitable_allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that wraps a GPU allocator and backs the large allocations
+// that do not fit in the wrapped allocator's memory with CUDA unified
+// (managed) memory, which the driver pages between host and device on
+// demand. A model that slightly exceeds the GPU memory then runs slower
+// instead of running out of memory.
+//
+// The GPU device calls Prefetch() on the inputs of each kernel, so that
+// their pages migrate to the device in bulk ahead of the kernel rather than
+// fault by fault, and PreferDevice() on variables, so that the driver evicts
+// activations before weights.
+class GPUManagedMemoryAllocator : public VisitableAllocator {
+ public:
+  // Allocations smaller than this always come from the wrapped allocator.
+  static constexpr size_t kMinUnifiedMemoryBytes = 1 << 20;
+
+  GPUManagedMemoryAllocator(VisitableAllocator* allocator, int device_id);
+  ~GPUManagedMemoryAllocator() override;
+
+  // Keeps the name of the wrapped allocator, which memory statistics are
+  // reported under.
+  string Name() override { return base_allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  void AddAllocVisitor(Visitor visitor) override;
+  void AddFreeVisitor(Visitor visitor) override;
+  bool TracksAllocationSizes() override;
+  size_t RequestedSize(void* ptr) override;
+  size_t AllocatedSize(void* ptr) override;
+  int64 AllocationId(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+
+  // If "num_bytes" bytes at "ptr" are in unified memory, enqueues their
+  // migration to the device on "stream".
+  void Prefetch(const void* ptr, size_t num_bytes,
+                perftools::gputools::Stream* stream);
+
+  // If "ptr" is in unified memory, advises the driver to keep the whole
+  // allocation on the device and to evict other pages first.
+  void PreferDevice(const void* ptr);
+
+ private:
+  struct UnifiedAllocation {
+    size_t num_bytes;
+    bool prefers_device;
+  };
+
+  // Returns the unified memory allocation containing "ptr", or nullptr.
+  std::pair<const void* const, UnifiedAllocation>* FindUnified(
+      const void* ptr) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  VisitableAllocator* base_allocator_ = nullptr;  // owned
+
+  perftools::gputools::StreamExecutor* stream_exec_;  // Not owned.
+
+  // The number of live unified memory allocations, so that Prefetch() and
+  // PreferDevice() return without locking while there are none.
+  std::atomic<int64> num_unified_{0};
+
+  mutex mu_;
+  std::map<const void*, UnifiedAllocation> unified_ GUARDED_BY(mu_);
+  int64 unified_bytes_in_use_ GUARDED_BY(mu_) = 0;
+  int64 max_unified_bytes_in_use_ GUARDED_BY(mu_) = 0;
+  int64 num_unified_allocs_ GUARDED_BY(mu_) = 0;
+  int64 unified_bytes_prefetched_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUManagedMemoryAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_GPU_GPU_MANAGED_MEMORY_ALLOCATOR_H_
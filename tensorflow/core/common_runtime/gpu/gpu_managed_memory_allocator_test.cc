@@ -0,0 +1,120 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_memory_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace gpu = ::perftools::gputools;
+
+namespace tensorflow {
+namespace {
+
+const int kDeviceId = 0;
+const size_t kMB = 1 << 20;
+
+TEST(GPUManagedMemoryAllocatorTest, FallsBackToUnifiedMemory) {
+  GPUManagedMemoryAllocator a(new GPUBFCAllocator(kDeviceId, 4 * kMB),
+                              kDeviceId);
+  void* small = a.AllocateRaw(256, 1024);
+  void* fits = a.AllocateRaw(256, 3 * kMB);
+  ASSERT_NE(nullptr, small);
+  ASSERT_NE(nullptr, fits);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.num_unified_allocs);
+
+  void* unified = a.AllocateRaw(256, 3 * kMB);
+  ASSERT_NE(nullptr, unified);
+  EXPECT_EQ(3 * kMB, a.RequestedSize(unified));
+  a.GetStats(&stats);
+  EXPECT_EQ(1, stats.num_unified_allocs);
+  EXPECT_EQ(3 * kMB, stats.unified_bytes_in_use);
+
+  // The unified memory is usable from the device.
+  auto stream_exec =
+      GPUMachineManager()->ExecutorForDevice(kDeviceId).ValueOrDie();
+  std::vector<int64> values(3 * kMB / sizeof(int64), 42);
+  std::vector<int64> copied(values.size());
+  gpu::DeviceMemoryBase unified_mem(unified, 3 * kMB);
+  ASSERT_TRUE(
+      stream_exec->SynchronousMemcpy(&unified_mem, values.data(), 3 * kMB));
+  ASSERT_TRUE(
+      stream_exec->SynchronousMemcpy(copied.data(), unified_mem, 3 * kMB));
+  EXPECT_EQ(values, copied);
+
+  a.DeallocateRaw(unified);
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.unified_bytes_in_use);
+  EXPECT_EQ(3 * kMB, stats.max_unified_bytes_in_use);
+  a.DeallocateRaw(fits);
+  a.DeallocateRaw(small);
+}
+
+TEST(GPUManagedMemoryAllocatorTest, OptionalAllocationsStayInDeviceMemory) {
+  GPUManagedMemoryAllocator a(new GPUBFCAllocator(kDeviceId, 4 * kMB),
+                              kDeviceId);
+  void* fits = a.AllocateRaw(256, 3 * kMB);
+  ASSERT_NE(nullptr, fits);
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  EXPECT_EQ(nullptr, a.AllocateRaw(256, 3 * kMB, no_retry));
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.num_unified_allocs);
+  a.DeallocateRaw(fits);
+}
+
+TEST(GPUManagedMemoryAllocatorTest, PrefetchCountsBytesInUnifiedMemory) {
+  GPUManagedMemoryAllocator a(new GPUBFCAllocator(kDeviceId, 4 * kMB),
+                              kDeviceId);
+  void* fits = a.AllocateRaw(256, 3 * kMB);
+  void* unified = a.AllocateRaw(256, 3 * kMB);
+  ASSERT_NE(nullptr, fits);
+  ASSERT_NE(nullptr, unified);
+  auto stream_exec =
+      GPUMachineManager()->ExecutorForDevice(kDeviceId).ValueOrDie();
+  gpu::Stream stream(stream_exec);
+  stream.Init();
+
+  // Device memory is not prefetched.
+  a.Prefetch(fits, 3 * kMB, &stream);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.unified_bytes_prefetched);
+
+  // Prefetches are clipped to the end of the allocation.
+  a.Prefetch(static_cast<char*>(unified) + kMB, 4 * kMB, &stream);
+  a.GetStats(&stats);
+  EXPECT_EQ(2 * kMB, stats.unified_bytes_prefetched);
+  a.PreferDevice(static_cast<char*>(unified) + kMB);
+  ASSERT_TRUE(stream.BlockHostUntilDone());
+
+  a.DeallocateRaw(unified);
+  a.DeallocateRaw(fits);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -0,0 +1,252 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_peer_copy.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/stream_executor_util.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Size of each staging buffer on the intermediate GPUs of a route. Routed
+// copies are pipelined in chunks of this size.
+const uint64 kStagingChunkBytes = 4 << 20;
+
+bool RoutingEnabled() {
+  static const bool routing_enabled = [] {
+    bool enabled = true;
+    Status status =
+        ReadBoolFromEnvVar("TF_GPU_ROUTE_PEER_COPIES", true, &enabled);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    return enabled;
+  }();
+  return routing_enabled;
+}
+
+gpu::DeviceMemoryBase Slice(const gpu::DeviceMemoryBase& mem, uint64 offset,
+                            uint64 bytes) {
+  return gpu::DeviceMemoryBase(
+      static_cast<char*>(const_cast<void*>(mem.opaque())) + offset, bytes);
+}
+
+}  // namespace
+
+// static
+GPUPeerCopyEngine* GPUPeerCopyEngine::Global() {
+  static GPUPeerCopyEngine* engine = new GPUPeerCopyEngine;
+  return engine;
+}
+
+// static
+std::vector<int> GPUPeerCopyEngine::ShortestRoute(
+    const PeerAccessMap& peer_access, const std::vector<int>& gpu_ids,
+    int src_id, int dst_id) {
+  auto has_link = [&peer_access](int from, int to) {
+    auto it = peer_access.find({from, to});
+    return it != peer_access.end() && it->second;
+  };
+  std::vector<int> direct = {src_id, dst_id};
+  if (has_link(src_id, dst_id)) return direct;
+
+  std::vector<int> sorted_ids = gpu_ids;
+  std::sort(sorted_ids.begin(), sorted_ids.end());
+  // Breadth-first search from 'src_id', visiting the neighbors of each GPU in
+  // increasing order of gpu id.
+  std::map<int, int> parent;
+  parent[src_id] = src_id;
+  std::deque<int> queue = {src_id};
+  while (!queue.empty() && parent.count(dst_id) == 0) {
+    const int from = queue.front();
+    queue.pop_front();
+    for (int to : sorted_ids) {
+      if (parent.count(to) == 0 && has_link(from, to)) {
+        parent[to] = from;
+        queue.push_back(to);
+      }
+    }
+  }
+  if (parent.count(dst_id) == 0) return direct;
+
+  std::vector<int> route = {dst_id};
+  while (route.back() != src_id) {
+    route.push_back(parent[route.back()]);
+  }
+  std::reverse(route.begin(), route.end());
+  return route;
+}
+
+Status GPUPeerCopyEngine::AddGPUs(gpu::Platform* platform,
+                                  const std::vector<int>& gpu_ids,
+                                  const PeerAccessMap& peer_access) {
+  mutex_lock l(mu_);
+  for (int gpu_id : gpu_ids) {
+    if (std::find(gpu_ids_.begin(), gpu_ids_.end(), gpu_id) ==
+        gpu_ids_.end()) {
+      gpu_ids_.push_back(gpu_id);
+    }
+  }
+  for (const auto& link : peer_access) {
+    peer_access_[link.first] = link.second;
+  }
+  for (int src_id : gpu_ids_) {
+    for (int dst_id : gpu_ids_) {
+      if (src_id == dst_id || pairs_.count({src_id, dst_id}) > 0) continue;
+      TF_RETURN_IF_ERROR(AddPair(platform, src_id, dst_id));
+    }
+  }
+  return Status::OK();
+}
+
+Status GPUPeerCopyEngine::AddPair(gpu::Platform* platform, int src_id,
+                                  int dst_id) {
+  std::unique_ptr<Pair> pair(new Pair);
+  if (RoutingEnabled()) {
+    pair->route = ShortestRoute(peer_access_, gpu_ids_, src_id, dst_id);
+  } else {
+    pair->route = {src_id, dst_id};
+  }
+  const std::vector<int>& route = pair->route;
+  if (route.size() > 2) {
+    LOG(INFO) << "Copies from GPU " << src_id << " to GPU " << dst_id
+              << " are routed through GPUs "
+              << str_util::Join(route, " -> ");
+  }
+
+  std::vector<gpu::StreamExecutor*> execs;
+  for (int gpu_id : route) {
+    auto exec = platform->ExecutorForDevice(gpu_id);
+    if (!exec.ok()) {
+      return StreamExecutorUtil::ConvertStatus(exec.status());
+    }
+    execs.push_back(exec.ValueOrDie());
+  }
+  for (int i = 0; i + 1 < route.size(); ++i) {
+    pair->streams.emplace_back(new gpu::Stream(execs[i]));
+    if (!pair->streams.back()->Init().ok()) {
+      return errors::Internal("Failed to create a copy stream from GPU ",
+                              route[i], " to GPU ", route[i + 1]);
+    }
+  }
+
+  mutex_lock l(pair->mu);
+  pair->stages.resize(route.size() - 2);
+  for (int i = 0; i < pair->stages.size(); ++i) {
+    Stage* stage = &pair->stages[i];
+    stage->exec = execs[i + 1];
+    for (int b = 0; b < 2; ++b) {
+      gpu::DeviceMemory<uint8> buffer =
+          stage->exec->AllocateArray<uint8>(kStagingChunkBytes);
+      if (buffer.is_null()) {
+        return errors::ResourceExhausted(
+            "Failed to allocate a staging buffer on GPU ", route[i + 1],
+            " for copies from GPU ", src_id, " to GPU ", dst_id);
+      }
+      stage->buffers[b] = buffer;
+      stage->filled[b].reset(new gpu::Event(execs[i]));
+      stage->drained[b].reset(new gpu::Event(execs[i + 1]));
+      if (!stage->filled[b]->Init() || !stage->drained[b]->Init()) {
+        return errors::Internal("Failed to create the events of GPU ",
+                                route[i + 1], " for copies from GPU ", src_id,
+                                " to GPU ", dst_id);
+      }
+    }
+  }
+  pairs_[{src_id, dst_id}] = std::move(pair);
+  return Status::OK();
+}
+
+std::vector<int> GPUPeerCopyEngine::Route(int src_id, int dst_id) {
+  mutex_lock l(mu_);
+  auto it = pairs_.find({src_id, dst_id});
+  if (it == pairs_.end()) return {};
+  return it->second->route;
+}
+
+gpu::Stream* GPUPeerCopyEngine::Copy(
+    gpu::StreamExecutor* src_exec, gpu::StreamExecutor* dst_exec,
+    const gpu::DeviceMemoryBase& src, gpu::DeviceMemoryBase* dst, uint64 bytes,
+    gtl::ArraySlice<gpu::Stream*> wait_streams) {
+  Pair* pair = nullptr;
+  {
+    mutex_lock l(mu_);
+    auto it =
+        pairs_.find({src_exec->device_ordinal(), dst_exec->device_ordinal()});
+    if (it == pairs_.end()) return nullptr;
+    pair = it->second.get();
+  }
+
+  // The staging buffers and their events are shared by all the copies of the
+  // pair, so the copies are enqueued one at a time.
+  mutex_lock l(pair->mu);
+  gpu::Stream* first = pair->streams.front().get();
+  for (gpu::Stream* stream : wait_streams) {
+    first->ThenWaitFor(stream);
+  }
+  if (pair->stages.empty()) {
+    first->ThenMemcpy(dst, src, bytes);
+    return first;
+  }
+
+  // Chunk 'c' goes through buffer 'c % 2' of every stage. A hop waits for
+  // the previous hop to fill the buffer it reads, and for the next hop to
+  // drain the buffer it writes, so consecutive chunks are in flight on
+  // different hops at the same time. The later hops depend on the first one
+  // through the events, so only the first hop waits for 'wait_streams'.
+  const int num_hops = pair->streams.size();
+  for (uint64 offset = 0, chunk = 0; offset < bytes;
+       offset += kStagingChunkBytes, ++chunk) {
+    const uint64 chunk_bytes = std::min(kStagingChunkBytes, bytes - offset);
+    const int b = chunk % 2;
+    for (int h = 0; h < num_hops; ++h) {
+      gpu::Stream* stream = pair->streams[h].get();
+      Stage* in = h > 0 ? &pair->stages[h - 1] : nullptr;
+      Stage* out = h + 1 < num_hops ? &pair->stages[h] : nullptr;
+      gpu::DeviceMemoryBase from = in == nullptr
+                                       ? Slice(src, offset, chunk_bytes)
+                                       : Slice(in->buffers[b], 0, chunk_bytes);
+      gpu::DeviceMemoryBase to = out == nullptr
+                                     ? Slice(*dst, offset, chunk_bytes)
+                                     : Slice(out->buffers[b], 0, chunk_bytes);
+      if (in != nullptr) {
+        stream->ThenWaitFor(in->filled[b].get());
+      }
+      if (out != nullptr && out->drained_recorded[b]) {
+        stream->ThenWaitFor(out->drained[b].get());
+      }
+      stream->ThenMemcpy(&to, from, chunk_bytes);
+      if (out != nullptr) {
+        stream->ThenRecordEvent(out->filled[b].get());
+      }
+      if (in != nullptr) {
+        stream->ThenRecordEvent(in->drained[b].get());
+        in->drained_recorded[b] = true;
+      }
+    }
+  }
+  first->ThenWaitFor(pair->streams.back().get());
+  return first;
+}
+
+}  // namespace tensorflow
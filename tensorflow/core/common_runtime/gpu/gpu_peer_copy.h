@@ -0,0 +1,119 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_GPU_GPU_PEER_COPY_H_
+#define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_PEER_COPY_H_
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace gpu = ::perftools::gputools;
+
+// Maps an ordered pair of gpu ids to whether the first GPU can access the
+// memory of the second one directly.
+typedef std::map<std::pair<int, int>, bool> PeerAccessMap;
+
+// Copies memory between the GPUs of this process.
+//
+// Every ordered pair of GPUs gets its own copy streams, so that copies to
+// different peers do not queue up behind each other. A copy between GPUs
+// with peer access goes straight over the peer link. A copy between GPUs
+// without it is routed over the fewest peer links through other GPUs,
+// pipelined in chunks through staging buffers on those GPUs, instead of
+// being left to the driver, which stages it through host memory. Setting
+// TF_GPU_ROUTE_PEER_COPIES=0 turns the routing off.
+class GPUPeerCopyEngine {
+ public:
+  static GPUPeerCopyEngine* Global();
+
+  // Adds the GPUs 'gpu_ids' of 'platform', whose peer access has been
+  // enabled as recorded in 'peer_access', and sets up the routes and streams
+  // between them and the GPUs added before.
+  Status AddGPUs(gpu::Platform* platform, const std::vector<int>& gpu_ids,
+                 const PeerAccessMap& peer_access);
+
+  // Enqueues a copy of 'bytes' bytes from 'src' on 'src_exec' to 'dst' on
+  // 'dst_exec', to start after the work enqueued on 'wait_streams' so far.
+  // Returns a stream of 'src_exec' on which the work enqueued from now on
+  // runs after the copy, or nullptr if the GPUs were never added, in which
+  // case nothing is enqueued.
+  gpu::Stream* Copy(gpu::StreamExecutor* src_exec,
+                    gpu::StreamExecutor* dst_exec,
+                    const gpu::DeviceMemoryBase& src,
+                    gpu::DeviceMemoryBase* dst, uint64 bytes,
+                    gtl::ArraySlice<gpu::Stream*> wait_streams);
+
+  // Returns the gpu ids a copy from 'src_id' to 'dst_id' passes through,
+  // starting with 'src_id' and ending with 'dst_id'. Empty if the GPUs were
+  // never added.
+  std::vector<int> Route(int src_id, int dst_id);
+
+  // Returns the shortest path from 'src_id' to 'dst_id' over the peer links
+  // in 'peer_access' between 'gpu_ids', preferring lower gpu ids between
+  // paths of the same length. Returns just the two ends if there is a direct
+  // link or no path at all. Exposed for testing.
+  static std::vector<int> ShortestRoute(const PeerAccessMap& peer_access,
+                                        const std::vector<int>& gpu_ids,
+                                        int src_id, int dst_id);
+
+ private:
+  GPUPeerCopyEngine() {}
+
+  // Staging buffers on an intermediate GPU of a route.
+  struct Stage {
+    gpu::StreamExecutor* exec = nullptr;
+    gpu::DeviceMemoryBase buffers[2];
+    // Recorded by the hop into the stage once it has filled a buffer.
+    std::unique_ptr<gpu::Event> filled[2];
+    // Recorded by the hop out of the stage once it has drained a buffer.
+    std::unique_ptr<gpu::Event> drained[2];
+    bool drained_recorded[2] = {false, false};
+  };
+
+  struct Pair {
+    mutex mu;
+    std::vector<int> route;
+    // streams[i] copies from route[i] to route[i + 1] and belongs to the
+    // executor of route[i].
+    std::vector<std::unique_ptr<gpu::Stream>> streams;
+    // stages[i] is on route[i + 1].
+    std::vector<Stage> stages GUARDED_BY(mu);
+  };
+
+  Status AddPair(gpu::Platform* platform, int src_id, int dst_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  std::vector<int> gpu_ids_ GUARDED_BY(mu_);
+  PeerAccessMap peer_access_ GUARDED_BY(mu_);
+  std::map<std::pair<int, int>, std::unique_ptr<Pair>> pairs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUPeerCopyEngine);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_GPU_GPU_PEER_COPY_H_
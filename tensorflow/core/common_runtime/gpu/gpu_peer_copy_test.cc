@@ -0,0 +1,164 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_peer_copy.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace gpu = ::perftools::gputools;
+
+namespace tensorflow {
+namespace {
+
+// Returns the peer access map of 'num_gpus' GPUs with links between the
+// pairs in 'links', in both directions.
+PeerAccessMap MakePeerAccess(int num_gpus,
+                             const std::vector<std::pair<int, int>>& links) {
+  PeerAccessMap peer_access;
+  for (int i = 0; i < num_gpus; ++i) {
+    for (int j = 0; j < num_gpus; ++j) {
+      peer_access[{i, j}] = false;
+    }
+  }
+  for (const auto& link : links) {
+    peer_access[{link.first, link.second}] = true;
+    peer_access[{link.second, link.first}] = true;
+  }
+  return peer_access;
+}
+
+TEST(GPUPeerCopyEngineTest, DirectLink) {
+  PeerAccessMap peer_access = MakePeerAccess(2, {{0, 1}});
+  EXPECT_EQ(std::vector<int>({0, 1}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, {0, 1}, 0, 1));
+  EXPECT_EQ(std::vector<int>({1, 0}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, {0, 1}, 1, 0));
+}
+
+TEST(GPUPeerCopyEngineTest, NoPath) {
+  PeerAccessMap peer_access = MakePeerAccess(4, {{0, 1}, {2, 3}});
+  EXPECT_EQ(std::vector<int>({0, 3}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, {0, 1, 2, 3}, 0, 3));
+}
+
+TEST(GPUPeerCopyEngineTest, RoutesThroughFewestGPUs) {
+  // A ring 0 - 1 - 2 - 3 - 4 - 5 - 0 with a chord 1 - 4.
+  PeerAccessMap peer_access = MakePeerAccess(
+      6, {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}, {1, 4}});
+  const std::vector<int> gpu_ids = {0, 1, 2, 3, 4, 5};
+  EXPECT_EQ(std::vector<int>({0, 1, 2}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, gpu_ids, 0, 2));
+  // Both 0 -> 1 -> 4 and 0 -> 5 -> 4 have two hops, so lower gpu ids win.
+  EXPECT_EQ(std::vector<int>({0, 1, 4}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, gpu_ids, 0, 4));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, gpu_ids, 0, 3));
+  EXPECT_EQ(std::vector<int>({4, 3}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, gpu_ids, 4, 3));
+  EXPECT_EQ(std::vector<int>({2, 1, 0}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, gpu_ids, 2, 0));
+}
+
+TEST(GPUPeerCopyEngineTest, IgnoresGPUsNotListed) {
+  PeerAccessMap peer_access = MakePeerAccess(3, {{0, 1}, {1, 2}});
+  EXPECT_EQ(std::vector<int>({0, 1, 2}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, {0, 1, 2}, 0, 2));
+  EXPECT_EQ(std::vector<int>({0, 2}),
+            GPUPeerCopyEngine::ShortestRoute(peer_access, {0, 2}, 0, 2));
+}
+
+// Enables peer access between all the GPUs and adds them to the engine.
+int AddAllGPUs() {
+  static const int num_gpus = [] {
+    gpu::Platform* platform = GPUMachineManager();
+    const int count = platform->VisibleDeviceCount();
+    std::vector<int> gpu_ids;
+    PeerAccessMap peer_access;
+    for (int i = 0; i < count; ++i) {
+      gpu_ids.push_back(i);
+      for (int j = 0; j < count; ++j) {
+        gpu::StreamExecutor* from =
+            platform->ExecutorForDevice(i).ValueOrDie();
+        gpu::StreamExecutor* to = platform->ExecutorForDevice(j).ValueOrDie();
+        peer_access[{i, j}] = i != j && from->CanEnablePeerAccessTo(to) &&
+                              from->EnablePeerAccessTo(to).ok();
+      }
+    }
+    TF_CHECK_OK(
+        GPUPeerCopyEngine::Global()->AddGPUs(platform, gpu_ids, peer_access));
+    return count;
+  }();
+  return num_gpus;
+}
+
+// Measures the bandwidth of 64MB copies from GPU 'src_id' to GPU 'dst_id'.
+static void BM_PeerCopy(int iters, int src_id, int dst_id) {
+  testing::StopTiming();
+  if (std::max(src_id, dst_id) >= AddAllGPUs()) {
+    testing::SetLabel("not enough GPUs");
+    return;
+  }
+  const uint64 bytes = 64 << 20;
+  gpu::Platform* platform = GPUMachineManager();
+  gpu::StreamExecutor* src_exec =
+      platform->ExecutorForDevice(src_id).ValueOrDie();
+  gpu::StreamExecutor* dst_exec =
+      platform->ExecutorForDevice(dst_id).ValueOrDie();
+  gpu::DeviceMemory<uint8> src = src_exec->AllocateArray<uint8>(bytes);
+  gpu::DeviceMemory<uint8> dst = dst_exec->AllocateArray<uint8>(bytes);
+  CHECK(!src.is_null() && !dst.is_null());
+  GPUPeerCopyEngine* engine = GPUPeerCopyEngine::Global();
+  testing::SetLabel(strings::StrCat(
+      "route ", str_util::Join(engine->Route(src_id, dst_id), "->")));
+
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    gpu::Stream* stream =
+        engine->Copy(src_exec, dst_exec, src, &dst, bytes, {});
+    CHECK(stream->BlockHostUntilDone());
+  }
+  testing::StopTiming();
+  testing::BytesProcessed(static_cast<int64>(iters) * bytes);
+  src_exec->Deallocate(&src);
+  dst_exec->Deallocate(&dst);
+}
+
+// Benchmarks every ordered pair of the first 8 GPUs.
+testing::Benchmark* PeerCopyPairs(testing::Benchmark* b) {
+  for (int src_id = 0; src_id < 8; ++src_id) {
+    for (int dst_id = 0; dst_id < 8; ++dst_id) {
+      if (src_id != dst_id) b->ArgPair(src_id, dst_id);
+    }
+  }
+  return b;
+}
+static testing::Benchmark* bm_peer_copy TF_ATTRIBUTE_UNUSED =
+    PeerCopyPairs(new testing::Benchmark("BM_PeerCopy", BM_PeerCopy));
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
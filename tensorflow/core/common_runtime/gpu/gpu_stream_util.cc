@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -61,33 +62,39 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
       }
     }
   }
-  // We perform stream assignment assuming a large number of
-  // stream IDs and then map these down to the required number of streams
-  // using simple round-robin.
-  // Stream Assignment strategy:
-  // 1. Nodes with zero inputs are always be executed on a
-  // fresh stream.
-  // 2. Try to execute a node on the same stream as one of its
-  // inputs to avoid inter-stream dependencies.
-  // 3. If any input comes from a node with a large fanout then
-  // perhaps an indication that it is shared between parallel
-  // streams of work. We choose a new stream here so that all consumers
-  // of the tensor are likely to run in parallel.
-  int highest_stream_id = -1;
+  // Stream Assignment strategy, following the data dependencies of the
+  // graph:
+  // 1. The first consumer of a node that is visited continues on the
+  // node's stream, so that chains of ops need no inter-stream
+  // dependencies.
+  // 2. The other consumers of a node with a large fanout start a new
+  // chain, as do nodes with no data inputs.  A node with a large fanout is
+  // perhaps shared between parallel branches of work, such as the towers
+  // of an Inception module, and the new chains let those run concurrently.
+  // 3. A new chain goes on the stream with the fewest nodes assigned so
+  // far, to spread the independent branches over all the streams.
+  std::vector<int> stream_size(opts.max_streams, 0);
+  std::unordered_set<int> continued;
+  int num_chains = 0;
   for (Node* n : order) {
     VLOG(3) << "Inspecting node " << n->DebugString();
     const int node_id = n->id();
     const string& op = n->type_string();
 
     // Determine a suitable stream to use.
-    int stream_id = highest_stream_id + 1;
+    int stream_id = -1;
     for (const Edge* e : n->in_edges()) {
-      const size_t fanout = e->src()->out_edges().size();
-      if (fanout == 1) {
+      if (e->IsControlEdge()) continue;
+      if (continued.insert(e->src()->id()).second) {
         stream_id = (*node_to_stream_id)[e->src()->id()];
         break;
       }
     }
+    if (stream_id < 0) {
+      stream_id = std::min_element(stream_size.begin(), stream_size.end()) -
+                  stream_size.begin();
+      ++num_chains;
+    }
     // Override stream for specific op types.
     if (op == "_Send") {
       if (opts.send_stream >= 0) stream_id = opts.send_stream;
@@ -99,10 +106,10 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
       if (opts.compute_stream >= 0) stream_id = opts.compute_stream;
     }
 
-    (*node_to_stream_id)[node_id] = stream_id % opts.max_streams;
-    highest_stream_id = std::max(stream_id, highest_stream_id);
+    (*node_to_stream_id)[node_id] = stream_id;
+    ++stream_size[stream_id];
   }
-  VLOG(1) << "Identified " << highest_stream_id << " candidate streams for "
+  VLOG(1) << "Identified " << num_chains << " chains of ops for "
           << order.size() << " nodes.";
 
   return Status::OK();
@@ -103,6 +103,30 @@ TEST_F(GpuStreamUtilTest, SimpleGraphManyStreams) {
   }
 }
 
+TEST_F(GpuStreamUtilTest, IndependentBranches) {
+  auto root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), {{1.0f}});
+  auto a = ops::Square(root.WithOpName("a"), x);
+  ops::Square(root.WithOpName("a2"), a);
+  auto b = ops::Sqrt(root.WithOpName("b"), x);
+  ops::Sqrt(root.WithOpName("b2"), b);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<int, int> node_to_stream_id;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = 2;
+  TF_ASSERT_OK(gpu_stream_util::AssignStreams(&g, opts, &node_to_stream_id));
+
+  std::unordered_map<string, int> stream;
+  for (Node* n : g.nodes()) stream[n->name()] = node_to_stream_id[n->id()];
+  // Each branch is a chain on one stream, and the two branches run on
+  // different streams.
+  EXPECT_EQ(stream["a"], stream["a2"]);
+  EXPECT_EQ(stream["b"], stream["b2"]);
+  EXPECT_NE(stream["a"], stream["b"]);
+}
+
 TEST_F(GpuStreamUtilTest, StreamOverrides) {
   auto root = Scope::NewRootScope().ExitOnError();
   ops::_Recv(root.WithOpName("input"), DT_FLOAT, "input", "/cpu:0", 0,
@@ -18,6 +18,7 @@ limitations under the License.
 #if GOOGLE_CUDA
 
 #include <stdlib.h>
+#include <algorithm>
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace {
@@ -330,6 +332,12 @@ class GPUTracerImpl : public GPUTracer,
     uint32 device_id;
     uint32 stream_id;
     uint32 correlation_id;
+    // Owned by CUPTI and shared by all the records of the kernel.
+    const char *name;
+    int32 grid_x, grid_y, grid_z;
+    int32 block_x, block_y, block_z;
+    uint16 registers_per_thread;
+    int32 shared_memory_per_block;
   };
   // Internal struct to record memcpy operations.
   struct MemcpyRecord {
@@ -547,9 +555,12 @@ void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
     case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
       if (kernel_records_.size() >= kMaxRecords) return;
       auto *kernel = reinterpret_cast<const CUpti_ActivityKernel3 *>(&record);
-      kernel_records_.push_back(KernelRecord{kernel->start, kernel->end,
-                                             kernel->deviceId, kernel->streamId,
-                                             kernel->correlationId});
+      kernel_records_.push_back(KernelRecord{
+          kernel->start, kernel->end, kernel->deviceId, kernel->streamId,
+          kernel->correlationId, kernel->name, kernel->gridX, kernel->gridY,
+          kernel->gridZ, kernel->blockX, kernel->blockY, kernel->blockZ,
+          kernel->registersPerThread,
+          kernel->staticSharedMemory + kernel->dynamicSharedMemory});
       break;
     }
     default:
@@ -557,6 +568,40 @@ void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
   }
 }
 
+namespace {
+
+// Returns the fraction of the warp slots of a multiprocessor that a kernel
+// launch keeps busy, as limited by the registers, shared memory and size of
+// its blocks and by the number of blocks in its grid. This is an estimate
+// from the launch configuration; measuring the achieved occupancy needs the
+// CUPTI metric API, which replays kernels. Returns 0 if the device does not
+// report the limits it needs.
+double EstimateOccupancy(const perftools::gputools::DeviceDescription &desc,
+                         uint64 registers_per_thread,
+                         uint64 shared_memory_per_block,
+                         const perftools::gputools::ThreadDim &block,
+                         uint64 num_blocks) {
+  uint64 blocks_per_core = perftools::gputools::CalculateOccupancy(
+      desc, registers_per_thread, shared_memory_per_block, block);
+  const uint64 core_count = desc.core_count();
+  const uint64 threads_per_warp = desc.threads_per_warp();
+  if (blocks_per_core == 0 || core_count == 0 || threads_per_warp == 0) {
+    return 0.0;
+  }
+  // A small grid leaves some of the block slots of each core empty.
+  blocks_per_core =
+      std::min(blocks_per_core, (num_blocks + core_count - 1) / core_count);
+  const uint64 warps_per_block =
+      (block.x * block.y * block.z + threads_per_warp - 1) / threads_per_warp;
+  const uint64 warps_per_core =
+      desc.threads_per_core_limit() / threads_per_warp;
+  if (warps_per_core == 0) return 0.0;
+  return std::min(1.0, static_cast<double>(blocks_per_core * warps_per_block) /
+                           warps_per_core);
+}
+
+}  // namespace
+
 Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
   mutex_lock l(mu_);
   if (enabled_) {
@@ -569,6 +614,11 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
   const string stream_device = strings::StrCat(prefix, "/gpu:", id, "/stream:");
   const string memcpy_device = strings::StrCat(prefix, "/gpu:", id, "/memcpy");
 
+  // Device descriptions by CUPTI device id, to estimate kernel occupancy.
+  std::map<uint32, const perftools::gputools::DeviceDescription *> devices;
+  auto platform =
+      perftools::gputools::MultiPlatformManager::PlatformWithName("cuda");
+
   mutex_lock l2(trace_mu_);
   for (const auto &rec : kernel_records_) {
     auto it = correlations_.find(rec.correlation_id);
@@ -582,8 +632,34 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
     ns->set_op_end_rel_micros(elapsed_us);
     ns->set_all_end_rel_micros(elapsed_us);
     ns->set_node_name(name);
-    // TODO(pbar) Generate details based on the kernel activity record.
-    // ns->set_timeline_label(details);
+    auto device = devices.find(rec.device_id);
+    if (device == devices.end()) {
+      const perftools::gputools::DeviceDescription *desc = nullptr;
+      if (platform.ok()) {
+        auto executor =
+            platform.ValueOrDie()->ExecutorForDevice(rec.device_id);
+        if (executor.ok()) {
+          desc = &executor.ValueOrDie()->GetDeviceDescription();
+        }
+      }
+      device = devices.emplace(rec.device_id, desc).first;
+    }
+    double occupancy = 0.0;
+    if (device->second) {
+      occupancy = EstimateOccupancy(
+          *device->second, rec.registers_per_thread,
+          rec.shared_memory_per_block,
+          perftools::gputools::ThreadDim(rec.block_x, rec.block_y,
+                                         rec.block_z),
+          static_cast<uint64>(rec.grid_x) * rec.grid_y * rec.grid_z);
+    }
+    // tfprof parses the kernel name and the occupancy out of this label.
+    const string details = strings::Printf(
+        "%s grid:%d,%d,%d block:%d,%d,%d regs:%u smem:%d occupancy:%.2f",
+        rec.name ? rec.name : "unknown", rec.grid_x, rec.grid_y, rec.grid_z,
+        rec.block_x, rec.block_y, rec.block_z, rec.registers_per_thread,
+        rec.shared_memory_per_block, occupancy);
+    ns->set_timeline_label(details);
     auto nscopy = new NodeExecStats;
     *nscopy = *ns;
     collector->Save(strings::StrCat(stream_device, "all"), ns);
@@ -19,8 +19,12 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_peer_copy.h"
+#include "tensorflow/core/common_runtime/gpu/pool_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
@@ -31,10 +35,13 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 // IMPLEMENTATION NOTE:
@@ -48,6 +55,10 @@ limitations under the License.
 //    ensure the causal ordering by arranging the copy done callback
 //    happens-after all activities scheduled on the given stream being
 //    finished.
+//
+// 3. Copies between a GPU and pageable host memory are staged through
+//    pinned buffers (see StagedCopy below), since the CUDA driver would
+//    otherwise perform a synchronous, internally staged copy.
 
 // If this need to be runtime configurable, consider adding options to
 // ConfigProto.
@@ -112,6 +123,191 @@ void* GetBase(const Tensor* src) {
 
 void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+namespace {
+
+// Host buffers smaller than this are handed to the driver as they are.
+const int64 kMinStagedCopyBytes = 64 << 10;
+// Size of each pinned staging buffer.  Staged copies are pipelined in
+// chunks of this size.
+const int64 kStagingChunkBytes = 4 << 20;
+// Maximum number of staging buffers used by a single copy.
+const int kMaxStagingChunksInFlight = 4;
+
+// Returns the staging pool to use for a copy of "total_bytes" bytes
+// to or from "host_ptr", or nullptr if the copy should not be staged.
+PoolAllocator* StagingPoolFor(const void* host_ptr, int64 total_bytes) {
+  static const bool staging_enabled = [] {
+    bool enabled = true;
+    Status status =
+        ReadBoolFromEnvVar("TF_GPU_STAGE_PAGEABLE_COPIES", true, &enabled);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    return enabled;
+  }();
+  if (!staging_enabled || total_bytes < kMinStagedCopyBytes) {
+    return nullptr;
+  }
+  ProcessState* ps = ProcessState::singleton();
+  if (ps->IsCUDAHostMemory(host_ptr)) {
+    return nullptr;
+  }
+  return ps->GetCUDAHostStagingPool(0);
+}
+
+// Records a host<->GPU transfer of "bytes" bytes that was enqueued at
+// "start_micros" and has just completed, together with the achieved
+// bandwidth, in "stats_collector".
+void RecordTransfer(StepStatsCollector* stats_collector, const Device* device,
+                    bool host_to_device, bool staged, int64 start_micros,
+                    int64 bytes) {
+  if (stats_collector == nullptr) return;
+  const int64 elapsed =
+      std::max<int64>(1, Env::Default()->NowMicros() - start_micros);
+  NodeExecStats* ns = new NodeExecStats;
+  ns->set_node_name(host_to_device ? "MEMCPYHtoD" : "MEMCPYDtoH");
+  ns->set_timeline_label(strings::Printf(
+      "%s %lld bytes, %.1f MB/s%s", ns->node_name().c_str(),
+      static_cast<long long>(bytes), bytes / static_cast<double>(elapsed),
+      staged ? " (staged)" : ""));
+  ns->set_all_start_micros(start_micros);
+  ns->set_op_start_rel_micros(0);
+  ns->set_op_end_rel_micros(elapsed);
+  ns->set_all_end_rel_micros(elapsed);
+  NodeOutput* no = ns->add_output();
+  no->set_slot(0);
+  no->mutable_tensor_description()
+      ->mutable_allocation_description()
+      ->set_requested_bytes(bytes);
+  stats_collector->Save(strings::StrCat(device->name(), "/memcpy"), ns);
+}
+
+// Copies "total_bytes" bytes between pageable host memory and GPU memory
+// through pinned buffers from "pool". The transfer is split into chunks
+// of kStagingChunkBytes, of which up to kMaxStagingChunksInFlight are
+// outstanding on "stream" at a time: the host-side memcpy of one chunk
+// overlaps with the DMA of the others.  Each buffer is refilled from the
+// EventMgr callback that signals its previous chunk is done, so no thread
+// ever blocks waiting for a buffer.
+//
+// Deletes itself after calling "done".
+class StagedCopy {
+ public:
+  StagedCopy(bool host_to_device, char* host_ptr, char* device_ptr,
+             int64 total_bytes, gpu::Stream* stream, EventMgr* event_mgr,
+             PoolAllocator* pool, TensorReference ref,
+             std::function<void()> done)
+      : host_to_device_(host_to_device),
+        host_ptr_(host_ptr),
+        device_ptr_(device_ptr),
+        total_bytes_(total_bytes),
+        stream_(stream),
+        event_mgr_(event_mgr),
+        pool_(pool),
+        ref_(ref),
+        done_(std::move(done)) {}
+
+  // Returns false, without enqueuing anything, if no staging buffer could
+  // be allocated.  The caller then still owns "this".
+  bool Start() {
+    const int64 num_chunks =
+        (total_bytes_ + kStagingChunkBytes - 1) / kStagingChunkBytes;
+    const int64 num_bufs =
+        std::min<int64>(num_chunks, kMaxStagingChunksInFlight);
+    std::vector<void*> bufs;
+    for (int64 i = 0; i < num_bufs; ++i) {
+      void* buf = pool_->Get(kStagingChunkBytes);
+      if (buf == nullptr) break;
+      bufs.push_back(buf);
+    }
+    if (bufs.empty()) return false;
+    std::vector<std::pair<int64, int64>> chunks(bufs.size());
+    {
+      mutex_lock l(mu_);
+      for (auto& chunk : chunks) {
+        CHECK(ReserveChunk(&chunk.first, &chunk.second));
+      }
+    }
+    // "this" may be deleted as soon as the last chunk has been enqueued.
+    for (size_t i = 0; i < bufs.size(); ++i) {
+      CopyChunk(bufs[i], chunks[i].first, chunks[i].second);
+    }
+    return true;
+  }
+
+ private:
+  bool ReserveChunk(int64* offset, int64* bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (next_offset_ == total_bytes_) return false;
+    *offset = next_offset_;
+    *bytes = std::min(kStagingChunkBytes, total_bytes_ - next_offset_);
+    next_offset_ += *bytes;
+    ++chunks_in_flight_;
+    return true;
+  }
+
+  void CopyChunk(void* buf, int64 offset, int64 bytes) {
+    if (host_to_device_) {
+      memcpy(buf, host_ptr_ + offset, bytes);
+      DeviceMemoryBase gpu_dst_ptr(device_ptr_ + offset, bytes);
+      stream_->ThenMemcpy(&gpu_dst_ptr, buf, bytes);
+    } else {
+      DeviceMemoryBase gpu_src_ptr(device_ptr_ + offset, bytes);
+      stream_->ThenMemcpy(buf, gpu_src_ptr, bytes);
+    }
+    event_mgr_->ThenExecute(stream_, [this, buf, offset, bytes]() {
+      ChunkDone(buf, offset, bytes);
+    });
+  }
+
+  void ChunkDone(void* buf, int64 offset, int64 bytes) {
+    if (!stream_->ok()) {
+      LOG(FATAL) << "Staged GPU Memcpy failed";
+    }
+    if (!host_to_device_) {
+      memcpy(host_ptr_ + offset, buf, bytes);
+    }
+    int64 next_offset;
+    int64 next_bytes;
+    bool reused;
+    bool finished;
+    {
+      mutex_lock l(mu_);
+      --chunks_in_flight_;
+      reused = ReserveChunk(&next_offset, &next_bytes);
+      finished = chunks_in_flight_ == 0;
+    }
+    if (reused) {
+      CopyChunk(buf, next_offset, next_bytes);
+      return;
+    }
+    pool_->Put(buf, kStagingChunkBytes);
+    if (finished) {
+      ref_.Unref();
+      done_();
+      delete this;
+    }
+  }
+
+  const bool host_to_device_;
+  char* const host_ptr_;
+  char* const device_ptr_;
+  const int64 total_bytes_;
+  gpu::Stream* const stream_;
+  EventMgr* const event_mgr_;
+  PoolAllocator* const pool_;
+  TensorReference ref_;
+  const std::function<void()> done_;
+
+  mutex mu_;
+  int64 next_offset_ GUARDED_BY(mu_) = 0;
+  int chunks_in_flight_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StagedCopy);
+};
+
+}  // namespace
+
 /*static*/
 void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
                               const DeviceContext* device_context,
@@ -208,9 +404,6 @@ void GPUUtil::DeviceToDeviceCopy(DeviceContext* send_dev_context,
     done(errors::Internal("No send gpu copy-out-stream is available."));
     return;
   }
-  // Wait for the main stream on the sender to make sure the result is
-  // available.
-  send_device_to_device_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = input->TotalBytes();
   if (total_bytes > 0) {
@@ -224,16 +417,27 @@ void GPUUtil::DeviceToDeviceCopy(DeviceContext* send_dev_context,
       done(errors::Internal("No recv gpu stream is available."));
       return;
     }
-    // Since we want to use the memory from recv_stream in the
-    // send_device_to_device_stream, add a dependency to make sure the memory is
-    // truly free.
+    VLOG(2) << "src_ptr " << src_ptr << " dst_ptr " << dst_ptr;
+    // Wait for the main stream on the sender to make sure the result is
+    // available. Since we want to use the memory from recv_stream in the
+    // copy, also add a dependency to make sure the memory is truly free.
     // TODO(zhengxq): remove this dependency when we switch to a better way
     // to make sure the memory is free.
-    send_device_to_device_stream->ThenWaitFor(recv_stream);
-
-    VLOG(2) << "src_ptr " << src_ptr << " dst_ptr " << dst_ptr;
-    send_device_to_device_stream->ThenMemcpy(&gpu_dst_ptr, gpu_src_ptr,
-                                             total_bytes);
+    gpu::Stream* copy_stream = GPUPeerCopyEngine::Global()->Copy(
+        send_stream->parent(), recv_stream->parent(), gpu_src_ptr,
+        &gpu_dst_ptr, total_bytes, {send_stream, recv_stream});
+    if (copy_stream != nullptr) {
+      send_device_to_device_stream = copy_stream;
+    } else {
+      send_device_to_device_stream->ThenWaitFor(send_stream);
+      send_device_to_device_stream->ThenWaitFor(recv_stream);
+      send_device_to_device_stream->ThenMemcpy(&gpu_dst_ptr, gpu_src_ptr,
+                                               total_bytes);
+    }
+  } else {
+    // Wait for the main stream on the sender to make sure the result is
+    // available.
+    send_device_to_device_stream->ThenWaitFor(send_stream);
   }
 
   // Use of input may outlive stack scope, so keep a ref.
@@ -258,7 +462,8 @@ static CopyTensor::Registration register_gpu_gpu_copy(
 void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
                                  const DeviceContext* device_context,
                                  const Tensor* gpu_tensor, Tensor* cpu_tensor,
-                                 StatusCallback done) {
+                                 StatusCallback done,
+                                 StepStatsCollector* stats_collector) {
   VLOG(1) << "CopyGPUTensorToCPU";
   const DeviceBase::GpuDeviceInfo* dev_info = nullptr;
   gpu::Stream* send_stream = nullptr;
@@ -280,21 +485,40 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = gpu_tensor->TotalBytes();
+  const int64 start_micros = Env::Default()->NowMicros();
+  // Use of the input may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*gpu_tensor);
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
-    DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     void* dst_ptr = GetBase(cpu_tensor);
+    PoolAllocator* pool = StagingPoolFor(dst_ptr, total_bytes);
+    if (pool != nullptr) {
+      StagedCopy* copy = new StagedCopy(
+          false /*host_to_device*/, static_cast<char*>(dst_ptr),
+          static_cast<char*>(src_ptr), total_bytes, send_device_to_host_stream,
+          dev_info->event_mgr, pool, input_ref,
+          [done, stats_collector, gpu_device, start_micros, total_bytes]() {
+            RecordTransfer(stats_collector, gpu_device,
+                           false /*host_to_device*/, true /*staged*/,
+                           start_micros, total_bytes);
+            done(Status::OK());
+          });
+      if (copy->Start()) return;
+      delete copy;
+    }
+    DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
   }
-  // Use of the input may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*gpu_tensor);
   dev_info->event_mgr->ThenExecute(
       send_device_to_host_stream,
-      [send_device_to_host_stream, done, input_ref]() {
+      [send_device_to_host_stream, done, input_ref, stats_collector, gpu_device,
+       start_micros, total_bytes]() {
         if (!send_device_to_host_stream->ok()) {
           LOG(FATAL) << "GPU->CPU Memcpy failed";
         }
         input_ref.Unref();
+        RecordTransfer(stats_collector, gpu_device, false /*host_to_device*/,
+                       false /*staged*/, start_micros, total_bytes);
         done(Status::OK());
       });
 }
@@ -303,7 +527,8 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
 void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
                                  const DeviceContext* device_context,
                                  Device* gpu_device, Tensor* gpu_tensor,
-                                 StatusCallback done) {
+                                 StatusCallback done,
+                                 StepStatsCollector* stats_collector) {
   VLOG(1) << "CopyCPUTensorToGPU";
   const DeviceBase::GpuDeviceInfo* dev_info = nullptr;
   gpu::Stream* recv_stream = nullptr;
@@ -325,22 +550,41 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   recv_host_to_device_stream->ThenWaitFor(recv_stream);
 
   const int64 total_bytes = cpu_tensor->TotalBytes();
+  const int64 start_micros = Env::Default()->NowMicros();
+  // Use of cpu_tensor may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*cpu_tensor);
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
+    PoolAllocator* pool = StagingPoolFor(src_ptr, total_bytes);
+    if (pool != nullptr) {
+      StagedCopy* copy = new StagedCopy(
+          true /*host_to_device*/, static_cast<char*>(src_ptr),
+          static_cast<char*>(dst_ptr), total_bytes, recv_host_to_device_stream,
+          dev_info->event_mgr, pool, input_ref,
+          [done, stats_collector, gpu_device, start_micros, total_bytes]() {
+            RecordTransfer(stats_collector, gpu_device,
+                           true /*host_to_device*/, true /*staged*/,
+                           start_micros, total_bytes);
+            done(Status::OK());
+          });
+      if (copy->Start()) return;
+      delete copy;
+    }
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
     recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
   }
-  // Use of cpu_tensor may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*cpu_tensor);
   dev_info->event_mgr->ThenExecute(
       recv_host_to_device_stream,
-      [recv_host_to_device_stream, done, input_ref]() {
+      [recv_host_to_device_stream, done, input_ref, stats_collector,
+       gpu_device, start_micros, total_bytes]() {
         input_ref.Unref();
         if (!recv_host_to_device_stream->ok()) {
           LOG(FATAL) << "CPU->GPU Memcpy failed";
         }
+        RecordTransfer(stats_collector, gpu_device, true /*host_to_device*/,
+                       false /*staged*/, start_micros, total_bytes);
         done(Status::OK());
       });
 }
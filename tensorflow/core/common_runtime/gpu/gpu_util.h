@@ -25,6 +25,7 @@ limitations under the License.
 namespace tensorflow {
 
 class RecvTensorResponse;
+class StepStatsCollector;
 class TensorProto;
 
 namespace gpu = ::perftools::gputools;
@@ -46,10 +47,16 @@ class GPUUtil {
   // 'gpu_tensor''s backing memory must be on 'gpu_device' and
   // 'cpu_tensor' must be allocated to be of the same size as
   // 'gpu_tensor'. Synchronous: may block.
+  //
+  // Large copies into pageable memory are staged through pinned
+  // buffers. If 'stats_collector' is not null, the transfer and its
+  // achieved bandwidth are recorded in it under
+  // "<gpu_device name>/memcpy".
   static void CopyGPUTensorToCPU(Device* gpu_device,
                                  const DeviceContext* device_context,
                                  const Tensor* gpu_tensor, Tensor* cpu_tensor,
-                                 StatusCallback done);
+                                 StatusCallback done,
+                                 StepStatsCollector* stats_collector = nullptr);
 
   // Blocks until all operations queued on the stream associated with
   // "gpu_device" at the time of the call have completed.  Returns any
@@ -88,10 +95,14 @@ class GPUUtil {
   // in local CPU RAM.
   static uint64 Checksum(const Tensor& tensor);
 
+  // Copies the data in 'cpu_tensor' into 'gpu_tensor'. Large copies
+  // from pageable memory are staged through pinned buffers.
+  // 'stats_collector' is as for CopyGPUTensorToCPU().
   static void CopyCPUTensorToGPU(const Tensor* cpu_tensor,
                                  const DeviceContext* device_context,
                                  Device* gpu_device, Tensor* gpu_tensor,
-                                 StatusCallback done);
+                                 StatusCallback done,
+                                 StepStatsCollector* stats_collector = nullptr);
 
   static void DeviceToDeviceCopy(DeviceContext* send_dev_context,
                                  DeviceContext* recv_dev_context, Device* src,
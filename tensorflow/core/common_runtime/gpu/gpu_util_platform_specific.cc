@@ -22,6 +22,14 @@ limitations under the License.
 
 namespace tensorflow {
 
+GPUDeviceContext::~GPUDeviceContext() {}
+
+void GPUDeviceContext::RecordOutputEvent() {
+  if (output_event_ == nullptr) return;
+  stream_->ThenRecordEvent(output_event_.get());
+  output_event_recorded_ = true;
+}
+
 void GPUDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
                                              Device* device,
                                              Tensor* device_tensor,
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_debug_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_memory_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -48,6 +49,27 @@ namespace gpu = ::perftools::gputools;
 
 namespace tensorflow {
 
+namespace {
+
+// Returns the first valid StreamExecutor, through which CUDA host
+// memory can be requested, since any will work.
+//
+// This search isn't super clean, and it would be nice to use a
+// better source of information about which executor to use.  For
+// example, process_state could maybe save the first stream executor
+// it knows is valid.
+gpu::StreamExecutor* AnyGPUExecutor(
+    const std::vector<VisitableAllocator*>& gpu_allocators) {
+  for (int i = 0; i < static_cast<int>(gpu_allocators.size()); ++i) {
+    if (gpu_allocators[i] != nullptr) {
+      return GPUMachineManager()->ExecutorForDevice(i).ValueOrDie();
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 ProcessState* ProcessState::instance_ = nullptr;
 
 /*static*/ ProcessState* ProcessState::singleton() {
@@ -98,6 +120,8 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
 
   if (gpu_id >= static_cast<int64>(gpu_allocators_.size())) {
     gpu_allocators_.resize(gpu_id + 1);
+    gpu_bfc_allocators_.resize(gpu_id + 1);
+    gpu_managed_allocators_.resize(gpu_id + 1);
     if (FLAGS_brain_gpu_record_mem_types) gpu_al_.resize(gpu_id + 1);
   }
 
@@ -110,7 +134,19 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
       return nullptr;
     }
 
-    gpu_allocator = new GPUBFCAllocator(gpu_id, total_bytes, options);
+    GPUBFCAllocator* bfc_allocator =
+        new GPUBFCAllocator(gpu_id, total_bytes, options);
+    gpu_bfc_allocators_[gpu_id] = bfc_allocator;
+    gpu_allocator = bfc_allocator;
+
+    // If requested, back large allocations that do not fit with unified
+    // memory.
+    if (options.unified_memory_oversubscription()) {
+      GPUManagedMemoryAllocator* managed_allocator =
+          new GPUManagedMemoryAllocator(gpu_allocator, gpu_id);
+      gpu_managed_allocators_[gpu_id] = managed_allocator;
+      gpu_allocator = managed_allocator;
+    }
 
     // If true, checks for memory overwrites by writing
     // distinctive patterns on both ends of allocated memory.
@@ -151,6 +187,23 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
 #endif  // GOOGLE_CUDA
 }
 
+GPUBFCAllocator* ProcessState::GetGPUBFCAllocator(int gpu_id) {
+  mutex_lock lock(mu_);
+  if (gpu_id >= static_cast<int64>(gpu_bfc_allocators_.size())) {
+    return nullptr;
+  }
+  return gpu_bfc_allocators_[gpu_id];
+}
+
+GPUManagedMemoryAllocator* ProcessState::GetGPUManagedMemoryAllocator(
+    int gpu_id) {
+  mutex_lock lock(mu_);
+  if (gpu_id >= static_cast<int64>(gpu_managed_allocators_.size())) {
+    return nullptr;
+  }
+  return gpu_managed_allocators_[gpu_id];
+}
+
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   // Although we're temporarily ignoring numa_node, check for legality.
   CHECK_GE(numa_node, 0);
@@ -210,21 +263,7 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
   numa_node = 0;
   mutex_lock lock(mu_);
 
-  // Find the first valid StreamExecutor to request CUDA host memory
-  // through, since any will work.
-  //
-  // This search isn't super clean, and it would be nice to use a
-  // better source of information about which executor to use.  For
-  // example, process_state could maybe save the first stream executor
-  // it knows is valid.
-  gpu::StreamExecutor* se = nullptr;
-  for (int i = 0; i < static_cast<int>(gpu_allocators_.size()); ++i) {
-    if (gpu_allocators_[i] != nullptr) {
-      se = GPUMachineManager()->ExecutorForDevice(i).ValueOrDie();
-      break;
-    }
-  }
-
+  gpu::StreamExecutor* se = AnyGPUExecutor(gpu_allocators_);
   CHECK_NE(nullptr, se);
 
   while (static_cast<int>(cuda_host_allocators_.size()) <= numa_node) {
@@ -237,9 +276,11 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
       LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
     }
     int64 cuda_host_mem_limit = cuda_host_mem_limit_in_mb * (1LL << 20);
-    Allocator* allocator =
+    BFCAllocator* bfc_allocator =
         new BFCAllocator(new CUDAHostAllocator(se), cuda_host_mem_limit,
                          true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    cuda_host_bfc_allocators_.push_back(bfc_allocator);
+    Allocator* allocator = bfc_allocator;
 
     if (LogMemory::IsEnabled()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -261,6 +302,32 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
   return cuda_host_allocators_[0];
 }
 
+bool ProcessState::IsCUDAHostMemory(const void* ptr) {
+  mutex_lock lock(mu_);
+  for (BFCAllocator* a : cuda_host_bfc_allocators_) {
+    if (a->Owns(ptr)) return true;
+  }
+  return false;
+}
+
+PoolAllocator* ProcessState::GetCUDAHostStagingPool(int numa_node) {
+  if (!HasGPUDevice() || !FLAGS_brain_mem_reg_cuda_dma) {
+    return nullptr;
+  }
+  CHECK_GE(numa_node, 0);
+  mutex_lock lock(mu_);
+  if (cuda_host_staging_pool_ == nullptr) {
+    gpu::StreamExecutor* se = AnyGPUExecutor(gpu_allocators_);
+    if (se == nullptr) return nullptr;
+    // Auto-resize so that buffers are rarely handed back to the driver:
+    // freeing pinned memory synchronizes the device.
+    cuda_host_staging_pool_ = new PoolAllocator(
+        8 /*pool_size_limit*/, true /*auto_resize*/, new CUDAHostAllocator(se),
+        new NoopRounder, "cuda_host_staging");
+  }
+  return cuda_host_staging_pool_;
+}
+
 void ProcessState::AddGPUAllocVisitor(int bus_id, AllocVisitor visitor) {
 #if GOOGLE_CUDA
   mutex_lock lock(mu_);
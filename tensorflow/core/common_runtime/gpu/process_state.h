@@ -29,6 +29,9 @@ limitations under the License.
 namespace tensorflow {
 
 class Allocator;
+class BFCAllocator;
+class GPUBFCAllocator;
+class GPUManagedMemoryAllocator;
 class VisitableAllocator;
 class PoolAllocator;
 
@@ -92,8 +95,28 @@ class ProcessState {
   virtual Allocator* GetGPUAllocator(const GPUOptions& options, int gpu_id,
                                      size_t total_bytes);
 
+  // Returns the GPUBFCAllocator underneath the allocator returned by
+  // GetGPUAllocator() for 'gpu_id', or nullptr if that has not been created.
+  GPUBFCAllocator* GetGPUBFCAllocator(int gpu_id);
+
+  // Returns the GPUManagedMemoryAllocator in the allocator returned by
+  // GetGPUAllocator() for 'gpu_id', or nullptr if that has not been created
+  // or GPUOptions.unified_memory_oversubscription was not set.
+  GPUManagedMemoryAllocator* GetGPUManagedMemoryAllocator(int gpu_id);
+
   virtual Allocator* GetCUDAHostAllocator(int numa_node);
 
+  // Returns true if 'ptr' points into pinned memory managed by the
+  // allocator returned by GetCUDAHostAllocator().
+  bool IsCUDAHostMemory(const void* ptr);
+
+  // Returns a pool of reusable pinned buffers for staging copies between
+  // pageable host memory and GPU memory, or nullptr if host memory is not
+  // registered with the CUDA driver.  Buffers must be obtained with
+  // PoolAllocator::Get() and returned with PoolAllocator::Put().
+  // TEMPORARY: ignores numa_node.
+  virtual PoolAllocator* GetCUDAHostStagingPool(int numa_node);
+
   // Registers a function to be called once on every new Region
   // allocated by every GPURegionAllocator proximate to the specified
   // bus.  The AllocVisitor is provided with a memory pointer and the
@@ -119,8 +142,16 @@ class ProcessState {
 
   std::vector<Allocator*> cpu_allocators_ GUARDED_BY(mu_);
   std::vector<VisitableAllocator*> gpu_allocators_ GUARDED_BY(mu_);
+  // The GPUBFCAllocators underneath gpu_allocators_, which own them.
+  std::vector<GPUBFCAllocator*> gpu_bfc_allocators_ GUARDED_BY(mu_);
+  // The GPUManagedMemoryAllocators in gpu_allocators_, if any.
+  std::vector<GPUManagedMemoryAllocator*> gpu_managed_allocators_
+      GUARDED_BY(mu_);
   std::vector<std::vector<AllocVisitor>> gpu_visitors_ GUARDED_BY(mu_);
   std::vector<Allocator*> cuda_host_allocators_ GUARDED_BY(mu_);
+  // The BFCAllocators underneath cuda_host_allocators_, which own them.
+  std::vector<BFCAllocator*> cuda_host_bfc_allocators_ GUARDED_BY(mu_);
+  PoolAllocator* cuda_host_staging_pool_ GUARDED_BY(mu_) = nullptr;
 
   virtual ~ProcessState();
 
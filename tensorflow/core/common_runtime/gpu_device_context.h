@@ -16,11 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <atomic>
+#include <memory>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 
 namespace perftools {
 namespace gputools {
+class Event;
 class Stream;
 }  // namespace gputools
 }  // namespace perftools
@@ -42,7 +46,7 @@ class GPUDeviceContext : public DeviceContext {
         device_to_host_stream_(device_to_host_stream),
         device_to_device_stream_(device_to_device_stream) {}
 
-  ~GPUDeviceContext() override {}
+  ~GPUDeviceContext() override;
 
   gpu::Stream* stream() const override { return stream_; }
   gpu::Stream* host_to_device_stream() const { return host_to_device_stream_; }
@@ -52,6 +56,23 @@ class GPUDeviceContext : public DeviceContext {
   }
   int stream_id() const { return stream_id_; }
 
+  // Gives this context an event, which RecordOutputEvent() records on
+  // stream().  Only a context owned by a single node has one, so that the
+  // consumers of the node on other streams can wait for the node's kernel
+  // rather than for everything queued on its stream.  Takes ownership of
+  // 'event'.
+  void set_output_event(gpu::Event* event) { output_event_.reset(event); }
+
+  // Records the output event, if any, on stream().  Called after the kernel
+  // of the node owning this context has been launched.
+  void RecordOutputEvent();
+
+  // Returns the output event, or nullptr if this context has none or it has
+  // not been recorded yet.
+  gpu::Event* output_event() const {
+    return output_event_recorded_ ? output_event_.get() : nullptr;
+  }
+
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor,
                              StatusCallback done) const override;
@@ -74,6 +95,8 @@ class GPUDeviceContext : public DeviceContext {
   gpu::Stream* device_to_host_stream_;
   // The stream to use for copy data between GPU.
   gpu::Stream* device_to_device_stream_;
+  std::unique_ptr<gpu::Event> output_event_;
+  std::atomic<bool> output_event_recorded_{false};
 };
 
 }  // namespace tensorflow
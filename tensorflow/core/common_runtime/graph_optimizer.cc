@@ -24,6 +24,14 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// At L1, calls to functions with at most this many op nodes that call no
+// other functions are inlined even if do_function_inlining is off.
+const int kMaxSmallFunctionNodes = 16;
+
+}  // namespace
+
 GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts) : opts_(opts) {
   if (opts_.opt_level() >= OptimizerOptions::L1) {
     opts_.set_do_common_subexpression_elimination(true);
@@ -79,6 +87,13 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
     if (opts_.do_function_inlining() && ExpandInlineFunctions(runtime, g)) {
       DumpGraph("ExpandInlineFunctions", g);
       changed = true;
+    } else if (!opts_.do_function_inlining() &&
+               opts_.opt_level() >= OptimizerOptions::L1 &&
+               runtime != nullptr &&
+               ExpandSmallInlineFunctions(runtime, g,
+                                          kMaxSmallFunctionNodes)) {
+      DumpGraph("ExpandSmallInlineFunctions", g);
+      changed = true;
     }
     if (!changed) break;
   }
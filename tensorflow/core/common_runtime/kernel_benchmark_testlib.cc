@@ -13,22 +13,35 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 
+#include <algorithm>
+#include <map>
 #include <vector>
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_segment.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
@@ -38,6 +51,155 @@ limitations under the License.
 namespace tensorflow {
 namespace test {
 
+namespace {
+
+// Counts the operations and bytes of an op with the formulas of grappler's
+// OpLevelCostEstimator: on a device of 1 GFLOP/s and 1 GB/s, the compute and
+// memory times in nanoseconds are the operations and bytes themselves.
+class OpCostCounter : public grappler::OpLevelCostEstimator {
+ protected:
+  std::pair<double, double> GetDeviceInfo(
+      const DeviceProperties& device) const override {
+    return std::make_pair(1.0, 1.0);
+  }
+};
+
+// Exposes the peak GFLOP/s and GB/s that grappler assumes for a device.
+class DevicePeakEstimator : public grappler::OpLevelCostEstimator {
+ public:
+  using grappler::OpLevelCostEstimator::GetDeviceInfo;
+};
+
+void SetTensorProperties(shape_inference::InferenceContext* c, DataType dtype,
+                         shape_inference::ShapeHandle shape,
+                         OpInfo::TensorProperties* properties) {
+  properties->set_dtype(dtype);
+  for (int i = 0; i < c->Rank(shape); ++i) {
+    properties->mutable_shape()->add_dim()->set_size(
+        c->Value(c->Dim(shape, i)));
+  }
+}
+
+// Estimates the operations and bytes of one execution of "g". Ops whose input
+// shapes can't be inferred, e.g. of tensors fed through the rendezvous, are
+// left out.
+void EstimateGraphCost(const Graph& g, const string& device_type, int64* flops,
+                       int64* bytes) {
+  *flops = 0;
+  *bytes = 0;
+  ShapeRefiner refiner(g.versions().producer(), g.op_registry());
+  std::vector<Node*> order;
+  GetReversePostOrder(g, &order);
+  OpCostCounter counter;
+  for (const Node* node : order) {
+    if (!refiner.AddNode(node).ok() || !node->IsOp() || node->IsConstant() ||
+        node->IsSend() || node->IsRecv() || node->IsVariable()) {
+      continue;
+    }
+    shape_inference::InferenceContext* c = refiner.GetContext(node);
+    bool fully_defined = true;
+    for (int i = 0; i < c->num_inputs(); ++i) {
+      fully_defined &= c->FullyDefined(c->input(i));
+    }
+    for (int i = 0; i < c->num_outputs(); ++i) {
+      fully_defined &= c->FullyDefined(c->output(i));
+    }
+    if (!fully_defined) {
+      VLOG(1) << "Unknown shapes, leaving " << node->name() << " out of the "
+              << "roofline";
+      continue;
+    }
+    OpInfo op_info;
+    op_info.set_op(node->type_string());
+    *op_info.mutable_attr() = node->def().attr();
+    op_info.mutable_device()->set_type(device_type);
+    for (int i = 0; i < c->num_inputs(); ++i) {
+      SetTensorProperties(c, node->input_type(i), c->input(i),
+                          op_info.add_inputs());
+    }
+    for (int i = 0; i < c->num_outputs(); ++i) {
+      SetTensorProperties(c, node->output_type(i), c->output(i),
+                          op_info.add_outputs());
+    }
+    const grappler::Costs costs = counter.PredictCosts(op_info);
+    *flops += costs.compute_time.count();
+    *bytes += costs.memory_time.count();
+  }
+}
+
+// Peak FLOP/s and bytes/s of a device.
+struct PeakPerformance {
+  double flops = 0;
+  double bytes = 0;
+};
+
+// Measures the peak FLOP/s of the CPU with a matrix multiplication, and its
+// peak bandwidth with a STREAM triad on arrays larger than the caches, on all
+// the schedulable cores. The best of a few runs is kept.
+PeakPerformance MeasureCpuPeak() {
+  const int num_threads = port::NumSchedulableCPUs();
+  Eigen::ThreadPool pool(num_threads);
+  Eigen::ThreadPoolDevice device(&pool, num_threads);
+  Env* env = Env::Default();
+  static const int kRuns = 3;
+  PeakPerformance peak;
+
+  const int n = 1024;
+  Eigen::Tensor<float, 2, Eigen::RowMajor> a(n, n), b(n, n), c(n, n);
+  a.setConstant(1.0f);
+  b.setConstant(1.0f);
+  const Eigen::array<Eigen::IndexPair<int>, 1> contract_dims = {
+      Eigen::IndexPair<int>(1, 0)};
+  for (int run = 0; run < kRuns; ++run) {
+    const uint64 start = env->NowMicros();
+    c.device(device) = a.contract(b, contract_dims);
+    const double seconds =
+        std::max<uint64>(env->NowMicros() - start, 1) * 1e-6;
+    peak.flops = std::max(peak.flops, 2.0 * n * n * n / seconds);
+  }
+
+  const int64 size = 4 << 20;
+  Eigen::Tensor<float, 1, Eigen::RowMajor> x(size), y(size), z(size);
+  y.setConstant(1.0f);
+  z.setConstant(2.0f);
+  for (int run = 0; run < kRuns; ++run) {
+    const uint64 start = env->NowMicros();
+    x.device(device) = y + z * 3.0f;
+    const double seconds =
+        std::max<uint64>(env->NowMicros() - start, 1) * 1e-6;
+    peak.bytes = std::max(peak.bytes, 3.0 * size * sizeof(float) / seconds);
+  }
+  return peak;
+}
+
+// Returns the peaks of "device_type", which are zero for devices other than
+// CPUs and GPUs.
+PeakPerformance GetPeakPerformance(const string& device_type) {
+  static mutex mu(LINKER_INITIALIZED);
+  static std::map<string, PeakPerformance>* peaks =
+      new std::map<string, PeakPerformance>;
+  mutex_lock l(mu);
+  auto it = peaks->find(device_type);
+  if (it != peaks->end()) {
+    return it->second;
+  }
+  PeakPerformance peak;
+  if (device_type == "CPU") {
+    peak = MeasureCpuPeak();
+  } else if (device_type == "GPU") {
+    const std::pair<double, double> info =
+        DevicePeakEstimator().GetDeviceInfo(grappler::GetLocalGPUInfo(0));
+    peak.flops = info.first * 1e9;
+    peak.bytes = info.second * 1e9;
+  }
+  LOG(INFO) << device_type << " peak: " << peak.flops * 1e-9 << " GFLOP/s, "
+            << peak.bytes * 1e-9 << " GB/s";
+  (*peaks)[device_type] = peak;
+  return peak;
+}
+
+}  // namespace
+
 Benchmark::Benchmark(const string& device, Graph* g,
                      const SessionOptions* options, Graph* init,
                      Rendezvous* rendez) {
@@ -48,6 +210,8 @@ Benchmark::Benchmark(const string& device, Graph* g,
 
   testing::StopTiming();
   string t = str_util::Uppercase(device);
+  device_type_ = t;
+  EstimateGraphCost(*g, device_type_, &flops_, &bytes_);
   // Allow NewDevice to allocate a new threadpool with different number of
   // threads for each new benchmark.
   LocalDevice::set_use_global_threadpool(false);
@@ -106,6 +270,39 @@ Benchmark::~Benchmark() {
 
 void Benchmark::Run(int iters) { RunWithArgs({}, {}, iters); }
 
+void Benchmark::SetCost(int64 flops, int64 bytes) {
+  flops_ = flops;
+  bytes_ = bytes;
+}
+
+void Benchmark::ReportRoofline(int iters, double seconds) const {
+  const PeakPerformance peak = GetPeakPerformance(device_type_);
+  const double flops_per_second = flops_ * (iters / seconds);
+  const double bytes_per_second = bytes_ * (iters / seconds);
+  // Graphs that only move data are bound by the bandwidth alone.
+  double fraction = 0;
+  if (flops_ > 0 && peak.flops > 0) {
+    double attainable = peak.flops;
+    if (bytes_ > 0) {
+      attainable = std::min(attainable, peak.bytes * flops_ / bytes_);
+    }
+    fraction = flops_per_second / attainable;
+  } else if (bytes_ > 0 && peak.bytes > 0) {
+    fraction = bytes_per_second / peak.bytes;
+  }
+  const bool memory_bound = flops_ * peak.bytes < bytes_ * peak.flops;
+  VLOG(1) << strings::Printf(
+      "%.2f GFLOP/s, %.2f GB/s: %.1f%% of the %s-bound roofline",
+      flops_per_second * 1e-9, bytes_per_second * 1e-9, fraction * 100,
+      memory_bound ? "memory" : "compute");
+#if !defined(PLATFORM_GOOGLE)
+  testing::SetExtra("gflops_per_second", flops_per_second * 1e-9);
+  testing::SetExtra("gbytes_per_second", bytes_per_second * 1e-9);
+  testing::SetExtra("roofline_percent", fraction * 100);
+  testing::SetExtra("memory_bound", memory_bound ? 1 : 0);
+#endif  // !defined(PLATFORM_GOOGLE)
+}
+
 string GetRendezvousKey(const Node* node) {
   string send_device;
   TF_CHECK_OK(GetNodeAttr(node->attrs(), "send_device", &send_device));
@@ -163,7 +360,10 @@ void Benchmark::RunWithArgs(
   TF_CHECK_OK(device_->Sync());
   VLOG(3) << kWarmupRuns << " warmup runs done.";
 
+  const int timed_iters = iters;
+  Env* env = Env::Default();
   testing::StartTiming();
+  const uint64 start_micros = env->NowMicros();
   while (iters-- > 0) {
     for (const auto& p : in) {
       Rendezvous::ParsedKey parsed;
@@ -180,6 +380,11 @@ void Benchmark::RunWithArgs(
 
   TF_CHECK_OK(device_->Sync());
   testing::StopTiming();
+  const uint64 elapsed_micros = env->NowMicros() - start_micros;
+
+  if ((flops_ > 0 || bytes_ > 0) && elapsed_micros > 0) {
+    ReportRoofline(timed_iters, elapsed_micros * 1e-6);
+  }
 }
 
 }  // end namespace test
@@ -53,7 +53,22 @@ class Benchmark {
   void RunWithArgs(const std::vector<std::pair<const Node*, Tensor>>& inputs,
                    const std::vector<const Node*>& outputs, int iters);
 
+  // Sets the floating point operations and the bytes of memory traffic of
+  // one execution of the graph. By default they are estimated from the graph
+  // with grappler's OpLevelCostEstimator.
+  //
+  // Run() reports the achieved FLOP/s and bytes/s, and their fraction of the
+  // roofline of the device, i.e. of min(peak FLOP/s, intensity * peak
+  // bandwidth) where the intensity is the FLOPs per byte. The peaks of the
+  // CPU are measured once per process, those of GPUs come from grappler.
+  void SetCost(int64 flops, int64 bytes);
+
  private:
+  void ReportRoofline(int iters, double seconds) const;
+
+  string device_type_;
+  int64 flops_ = 0;
+  int64 bytes_ = 0;
   thread::ThreadPool* pool_ = nullptr;
   Device* device_ = nullptr;
   Rendezvous* rendez_ = nullptr;
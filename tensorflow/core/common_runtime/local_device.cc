@@ -16,12 +16,17 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/common_runtime/local_device.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -31,17 +36,26 @@ namespace tensorflow {
 bool LocalDevice::use_global_threadpool_ = true;
 
 struct LocalDevice::EigenThreadPoolInfo {
-  explicit EigenThreadPoolInfo(const SessionOptions& options) {
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
     if (intra_op_parallelism_threads == 0) {
       intra_op_parallelism_threads = port::NumSchedulableCPUs();
     }
+    ThreadOptions thread_options;
+    if (numa_node != port::kNUMANoAffinity) {
+      // Split the threads evenly over the nodes so that the per-node pools
+      // together do not oversubscribe the host.
+      intra_op_parallelism_threads = std::max(
+          1, intra_op_parallelism_threads / port::NUMANumNodes());
+      thread_options.numa_node = numa_node;
+    }
     VLOG(1) << "Local device intra op parallelism threads: "
-            << intra_op_parallelism_threads;
+            << intra_op_parallelism_threads << " numa node: " << numa_node;
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
-    eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+    eigen_worker_threads_.workers =
+        new thread::ThreadPool(options.env, thread_options, "Eigen",
+                               intra_op_parallelism_threads);
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -61,21 +75,41 @@ struct LocalDevice::EigenThreadPoolInfo {
 
 LocalDevice::LocalDevice(const SessionOptions& options,
                          const DeviceAttributes& attributes)
+    : LocalDevice(options, attributes, port::kNUMANoAffinity) {}
+
+LocalDevice::LocalDevice(const SessionOptions& options,
+                         const DeviceAttributes& attributes, int numa_node)
     : Device(options.env, attributes), owned_tp_info_(nullptr) {
   // If we're running on the CPU, log warnings if we're not compiled using the
   // best flags for performance.
   port::WarnAboutUnusedCPUFeatures();
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  if (use_global_threadpool_ && numa_node != port::kNUMANoAffinity) {
+    // The devices of a NUMA node share one threadpool pinned to that node.
+    static mutex mu(LINKER_INITIALIZED);
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_infos =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>;
+    mutex_lock l(mu);
+    if (numa_node >= static_cast<int>(numa_tp_infos->size())) {
+      numa_tp_infos->resize(numa_node + 1, nullptr);
+    }
+    LocalDevice::EigenThreadPoolInfo*& numa_tp_info =
+        (*numa_tp_infos)[numa_node];
+    if (numa_tp_info == nullptr) {
+      numa_tp_info = new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+    }
+    tp_info = numa_tp_info;
+  } else if (use_global_threadpool_) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options, port::kNUMANoAffinity);
     tp_info = global_tp_info;
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
@@ -35,6 +35,11 @@ class LocalDevice : public Device {
  public:
   LocalDevice(const SessionOptions& options,
               const DeviceAttributes& attributes);
+
+  // Like above, but the Eigen compute threads are pinned to NUMA node
+  // "numa_node" and shared only with the other devices of that node.
+  LocalDevice(const SessionOptions& options, const DeviceAttributes& attributes,
+              int numa_node);
   ~LocalDevice() override;
 
  private:
@@ -0,0 +1,237 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// A planned output and its lifetime, as positions in a topological order.
+struct PlannedBuffer {
+  int output;
+  int64 size;
+  int start;
+  int end;
+  int64 offset;
+};
+
+bool IsStepOutput(const Node* node) {
+  return node->IsSend() || node->type_string() == "_Retval";
+}
+
+}  // namespace
+
+MemoryPlan::MemoryPlan(const Graph* graph) : graph_(graph) {
+  output_start_.resize(graph->num_node_ids() + 1);
+  int num_outputs = 0;
+  for (int id = 0; id < graph->num_node_ids(); ++id) {
+    output_start_[id] = num_outputs;
+    const Node* node = graph->FindNodeId(id);
+    if (node == nullptr) continue;
+    num_outputs += node->num_outputs();
+    if (node->IsEnter()) supported_ = false;
+  }
+  output_start_.back() = num_outputs;
+  offsets_.assign(num_outputs, -1);
+  sizes_.assign(num_outputs, 0);
+}
+
+void MemoryPlan::Plan(const std::vector<int64>& output_bytes) {
+  DCHECK_EQ(output_bytes.size(), num_outputs());
+  planned_ = true;
+  if (!supported_) return;
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph_, &order);
+  std::vector<int> position(graph_->num_node_ids(), -1);
+  for (int i = 0; i < order.size(); ++i) {
+    position[order[i]->id()] = i;
+  }
+
+  std::vector<PlannedBuffer> buffers;
+  for (const Node* node : order) {
+    const int start = output_start(node->id());
+    std::vector<int> last_use(node->num_outputs(), position[node->id()]);
+    std::vector<bool> leaves_step(node->num_outputs(), false);
+    for (const Edge* e : node->out_edges()) {
+      if (e->IsControlEdge()) continue;
+      last_use[e->src_output()] =
+          std::max(last_use[e->src_output()], position[e->dst()->id()]);
+      if (IsStepOutput(e->dst())) leaves_step[e->src_output()] = true;
+    }
+    for (int i = 0; i < node->num_outputs(); ++i) {
+      const int64 bytes = output_bytes[start + i];
+      if (bytes <= 0 || leaves_step[i]) continue;
+      const int64 size = Allocator::kAllocatorAlignment *
+                         ((bytes + Allocator::kAllocatorAlignment - 1) /
+                          Allocator::kAllocatorAlignment);
+      buffers.push_back(
+          {start + i, size, position[node->id()], last_use[i], -1});
+    }
+  }
+
+  // Place the largest buffers first, each in the smallest gap between the
+  // buffers already placed whose lifetimes overlap its own.
+  std::sort(buffers.begin(), buffers.end(),
+            [](const PlannedBuffer& a, const PlannedBuffer& b) {
+              if (a.size != b.size) return a.size > b.size;
+              return a.start < b.start;
+            });
+  std::vector<const PlannedBuffer*> placed;
+  std::vector<const PlannedBuffer*> conflicts;
+  for (PlannedBuffer& buffer : buffers) {
+    conflicts.clear();
+    for (const PlannedBuffer* other : placed) {
+      if (other->start <= buffer.end && buffer.start <= other->end) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const PlannedBuffer* a, const PlannedBuffer* b) {
+                return a->offset < b->offset;
+              });
+    int64 best_offset = -1;
+    int64 best_gap = kint64max;
+    int64 cursor = 0;
+    for (const PlannedBuffer* other : conflicts) {
+      const int64 gap = other->offset - cursor;
+      if (gap >= buffer.size && gap < best_gap) {
+        best_offset = cursor;
+        best_gap = gap;
+      }
+      cursor = std::max(cursor, other->offset + other->size);
+    }
+    buffer.offset = best_offset >= 0 ? best_offset : cursor;
+    placed.push_back(&buffer);
+
+    offsets_[buffer.output] = buffer.offset;
+    sizes_[buffer.output] = buffer.size;
+    slab_bytes_ = std::max(slab_bytes_, buffer.offset + buffer.size);
+  }
+  VLOG(1) << "Planned " << buffers.size() << " outputs in a slab of "
+          << slab_bytes_ << " bytes";
+}
+
+MemoryArena::MemoryArena(Allocator* base, int64 bytes)
+    : base_(base),
+      bytes_(bytes),
+      data_(bytes > 0 ? static_cast<char*>(base->AllocateRaw(
+                            Allocator::kAllocatorAlignment, bytes))
+                      : nullptr) {}
+
+MemoryArena::~MemoryArena() {
+  if (data_ != nullptr) {
+    base_->DeallocateRaw(data_);
+  }
+}
+
+bool MemoryArena::TryAcquire() {
+  mutex_lock l(mu_);
+  if (in_use_) return false;
+  in_use_ = true;
+  return true;
+}
+
+void MemoryArena::Release() {
+  mutex_lock l(mu_);
+  in_use_ = false;
+}
+
+PlannedAllocators::PlannedAllocators(const MemoryPlan* plan, Allocator* base,
+                                     MemoryArena* arena)
+    : plan_(plan), base_(base), recording_(!plan->planned()), arena_(arena) {
+  const int num_outputs = plan->num_outputs();
+  if (recording_) {
+    DCHECK(arena_ == nullptr);
+    recorded_bytes_.assign(num_outputs, 0);
+  } else if (arena_ != nullptr) {
+    DCHECK_GE(arena_->bytes(), plan->slab_bytes());
+    arena_->Ref();
+    slab_ = arena_->data();
+  } else if (plan->slab_bytes() > 0) {
+    slab_ = static_cast<char*>(base_->AllocateRaw(
+        Allocator::kAllocatorAlignment, plan->slab_bytes()));
+  }
+  allocators_.reserve(num_outputs);
+  allocator_ptrs_.reserve(num_outputs);
+  for (int i = 0; i < num_outputs; ++i) {
+    allocators_.emplace_back(this, i);
+    // Outputs without a planned buffer go straight to the device allocator.
+    const bool planned = slab_ != nullptr && plan->offset(i) >= 0;
+    allocator_ptrs_.push_back(recording_ || planned ? &allocators_.back()
+                                                    : nullptr);
+  }
+}
+
+PlannedAllocators::~PlannedAllocators() {
+  if (arena_ != nullptr) {
+    arena_->Release();
+    arena_->Unref();
+  } else if (slab_ != nullptr) {
+    base_->DeallocateRaw(slab_);
+  }
+}
+
+void* PlannedAllocators::Allocate(int output, size_t alignment,
+                                  size_t num_bytes) {
+  if (recording_) {
+    void* ptr = base_->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) return nullptr;
+    recorded_bytes_[output] =
+        std::max<int64>(recorded_bytes_[output], num_bytes);
+    Ref();
+    return ptr;
+  }
+
+  const int64 offset = plan_->offset(output);
+  DCHECK_GE(offset, 0);
+  if (num_bytes == 0 ||
+      static_cast<int64>(num_bytes) > plan_->size(output) ||
+      alignment > Allocator::kAllocatorAlignment) {
+    return nullptr;
+  }
+  const int64 end = offset + num_bytes;
+  {
+    mutex_lock l(mu_);
+    // The live buffers are disjoint, so only the one that starts last
+    // before "end" can overlap [offset, end).
+    auto it = live_.lower_bound(end);
+    if (it != live_.begin() && std::prev(it)->second > offset) {
+      return nullptr;
+    }
+    live_.emplace(offset, end);
+  }
+  Ref();
+  return slab_ + offset;
+}
+
+void PlannedAllocators::Deallocate(int output, void* ptr) {
+  if (recording_) {
+    base_->DeallocateRaw(ptr);
+  } else {
+    mutex_lock l(mu_);
+    live_.erase(static_cast<char*>(ptr) - slab_);
+  }
+  Unref();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A static plan that places the outputs of the nodes of a graph in one
+// slab of memory. Every planned output gets an offset into the slab, chosen
+// so that outputs whose lifetimes overlap never overlap in memory, in the
+// manner of XLA's heap simulator.
+//
+// Lifetimes are taken from a topological order of the graph: an output is
+// live from the position of the node that produces it until that of its
+// last consumer. When nodes run in a different order, PlannedAllocators
+// detects the conflicts and falls back to the device allocator, so the plan
+// only affects the memory footprint, never correctness.
+//
+// Outputs are identified by their index in a flat array of all the outputs
+// of the graph, output_start(node->id()) + output.
+class MemoryPlan {
+ public:
+  // "graph" must outlive the plan.
+  explicit MemoryPlan(const Graph* graph);
+
+  // Returns false if the graph has control flow loops, whose nodes run more
+  // than once per step and so can't be planned.
+  bool supported() const { return supported_; }
+
+  int output_start(int node_id) const { return output_start_[node_id]; }
+  int num_outputs() const { return output_start_.back(); }
+
+  // Assigns offsets to the outputs with a positive size in "output_bytes",
+  // which is indexed like the outputs. Outputs that leave the step through
+  // a _Retval or _Send node are not planned, since they would keep the slab
+  // alive.
+  void Plan(const std::vector<int64>& output_bytes);
+
+  // Whether Plan() has been called.
+  bool planned() const { return planned_; }
+
+  // The offset and size of an output in the slab. The offset is -1 if the
+  // output is not planned.
+  int64 offset(int output) const { return offsets_[output]; }
+  int64 size(int output) const { return sizes_[output]; }
+
+  // The total size of the slab.
+  int64 slab_bytes() const { return slab_bytes_; }
+
+ private:
+  const Graph* const graph_;
+  bool supported_ = true;
+  bool planned_ = false;
+  std::vector<int> output_start_;
+  std::vector<int64> offsets_;
+  std::vector<int64> sizes_;
+  int64 slab_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlan);
+};
+
+// A slab that is allocated once for a plan and reused by the steps of an
+// executor, one step at a time, instead of allocating a slab per step.
+class MemoryArena : public core::RefCounted {
+ public:
+  // Allocates "bytes" bytes from "base", which must outlive the arena.
+  MemoryArena(Allocator* base, int64 bytes);
+  ~MemoryArena() override;
+
+  char* data() const { return data_; }
+  int64 bytes() const { return bytes_; }
+
+  // Claims the arena for one step. Returns false if another step still
+  // holds it. The holder gives it back with Release().
+  bool TryAcquire();
+  void Release();
+
+ private:
+  Allocator* const base_;
+  const int64 bytes_;
+  char* data_;
+
+  mutex mu_;
+  bool in_use_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryArena);
+};
+
+// The allocators that OpKernelContext::Params::output_allocators points at
+// for one step. There is one allocator per output of the graph.
+//
+// Before the plan is made, the allocators forward to the device allocator
+// and record the size of every output allocated through them, for
+// MemoryPlan::Plan(). Afterwards, they serve outputs from a slab allocated
+// once per step. An output is served from the slab only if it fits in its
+// planned space and nothing that overlaps that space is still alive; else
+// the allocation fails and the kernel falls back to the device allocator.
+//
+// Each buffer served from here holds a reference, so outputs that outlive
+// the step also keep the slab alive.
+class PlannedAllocators : public core::RefCounted {
+ public:
+  // Records sizes if "plan" is not planned yet, else serves the plan.
+  // "plan" must outlive this object. If "arena" is not null, it must have
+  // been acquired by the caller and hold at least plan->slab_bytes(); the
+  // plan is served from it instead of a new slab, and it is released once
+  // every buffer served from it is gone.
+  PlannedAllocators(const MemoryPlan* plan, Allocator* base,
+                    MemoryArena* arena = nullptr);
+  ~PlannedAllocators() override;
+
+  // True if the allocators record output sizes rather than use the plan.
+  bool recording() const { return recording_; }
+
+  // The allocators of the outputs of node "node_id".
+  Allocator* const* node_allocators(int node_id) const {
+    return allocator_ptrs_.data() + plan_->output_start(node_id);
+  }
+
+  // The sizes recorded in recording mode, indexed like the outputs. Only
+  // valid once the step is done.
+  const std::vector<int64>& recorded_bytes() const { return recorded_bytes_; }
+
+ private:
+  // Serves one output of the graph on behalf of its PlannedAllocators.
+  class OutputAllocator : public Allocator {
+   public:
+    OutputAllocator(PlannedAllocators* owner, int output)
+        : owner_(owner), output_(output) {}
+
+    string Name() override { return "planned_output"; }
+    void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+      return owner_->Allocate(output_, alignment, num_bytes);
+    }
+    void DeallocateRaw(void* ptr) override {
+      owner_->Deallocate(output_, ptr);
+    }
+
+   private:
+    PlannedAllocators* owner_;
+    int output_;
+  };
+
+  void* Allocate(int output, size_t alignment, size_t num_bytes);
+  void Deallocate(int output, void* ptr);
+
+  const MemoryPlan* const plan_;
+  Allocator* const base_;
+  const bool recording_;
+  MemoryArena* const arena_;
+  char* slab_ = nullptr;
+
+  std::vector<OutputAllocator> allocators_;
+  std::vector<Allocator*> allocator_ptrs_;
+  std::vector<int64> recorded_bytes_;
+
+  // Maps the offset of each live buffer in the slab to its end.
+  mutex mu_;
+  std::map<int64, int64> live_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PlannedAllocators);
+};
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
@@ -0,0 +1,155 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class MemoryPlanTest : public ::testing::Test {
+ protected:
+  MemoryPlanTest() : graph_(OpRegistry::Global()) {
+    // a -> b -> c -> d, where only the outputs of adjacent nodes are live at
+    // the same time.
+    Tensor t(DT_FLOAT, TensorShape({4}));
+    t.flat<float>().setZero();
+    a_ = test::graph::Constant(&graph_, t);
+    b_ = test::graph::Identity(&graph_, a_);
+    c_ = test::graph::Identity(&graph_, b_);
+    d_ = test::graph::Identity(&graph_, c_);
+  }
+
+  int output(const MemoryPlan& plan, const Node* node) {
+    return plan.output_start(node->id());
+  }
+
+  std::vector<int64> Sizes(const MemoryPlan& plan, int64 bytes) {
+    std::vector<int64> sizes(plan.num_outputs(), 0);
+    for (const Node* node : {a_, b_, c_, d_}) {
+      sizes[output(plan, node)] = bytes;
+    }
+    return sizes;
+  }
+
+  Graph graph_;
+  Node* a_;
+  Node* b_;
+  Node* c_;
+  Node* d_;
+};
+
+TEST_F(MemoryPlanTest, ReusesMemoryOfDeadOutputs) {
+  MemoryPlan plan(&graph_);
+  ASSERT_TRUE(plan.supported());
+  EXPECT_FALSE(plan.planned());
+  plan.Plan(Sizes(plan, 1000));
+  ASSERT_TRUE(plan.planned());
+
+  const int64 size = plan.size(output(plan, a_));
+  EXPECT_GE(size, 1000);
+  EXPECT_EQ(0, size % Allocator::kAllocatorAlignment);
+  // Two buffers are enough for the chain.
+  EXPECT_EQ(2 * size, plan.slab_bytes());
+  EXPECT_NE(plan.offset(output(plan, a_)), plan.offset(output(plan, b_)));
+  EXPECT_NE(plan.offset(output(plan, b_)), plan.offset(output(plan, c_)));
+  EXPECT_NE(plan.offset(output(plan, c_)), plan.offset(output(plan, d_)));
+}
+
+TEST_F(MemoryPlanTest, OutputsLeavingTheStepAreNotPlanned) {
+  test::graph::Send(&graph_, d_, "d", "/job:a/replica:0/task:0/cpu:0", 0,
+                    "/job:a/replica:0/task:0/cpu:0");
+  MemoryPlan plan(&graph_);
+  plan.Plan(Sizes(plan, 1000));
+  EXPECT_EQ(-1, plan.offset(output(plan, d_)));
+  EXPECT_GE(plan.offset(output(plan, c_)), 0);
+}
+
+TEST_F(MemoryPlanTest, RecordsSizes) {
+  MemoryPlan plan(&graph_);
+  PlannedAllocators* allocators = new PlannedAllocators(&plan, cpu_allocator());
+  ASSERT_TRUE(allocators->recording());
+  Allocator* a = allocators->node_allocators(b_->id())[0];
+  void* ptr = a->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  ASSERT_NE(nullptr, ptr);
+  a->DeallocateRaw(ptr);
+  EXPECT_EQ(100, allocators->recorded_bytes()[output(plan, b_)]);
+  EXPECT_EQ(0, allocators->recorded_bytes()[output(plan, c_)]);
+  allocators->Unref();
+}
+
+TEST_F(MemoryPlanTest, ServesPlannedBuffers) {
+  MemoryPlan plan(&graph_);
+  plan.Plan(Sizes(plan, 1000));
+  PlannedAllocators* allocators = new PlannedAllocators(&plan, cpu_allocator());
+  ASSERT_FALSE(allocators->recording());
+  Allocator* alloc_a = allocators->node_allocators(a_->id())[0];
+  Allocator* alloc_b = allocators->node_allocators(b_->id())[0];
+  Allocator* alloc_c = allocators->node_allocators(c_->id())[0];
+
+  void* ptr_a = alloc_a->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  void* ptr_b = alloc_b->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(nullptr, ptr_a);
+  ASSERT_NE(nullptr, ptr_b);
+  EXPECT_NE(ptr_a, ptr_b);
+
+  // c shares its space with a, which is still alive.
+  EXPECT_EQ(nullptr,
+            alloc_c->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+  alloc_a->DeallocateRaw(ptr_a);
+  void* ptr_c = alloc_c->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  EXPECT_EQ(ptr_a, ptr_c);
+
+  // Outputs larger than planned are not served.
+  alloc_b->DeallocateRaw(ptr_b);
+  EXPECT_EQ(nullptr,
+            alloc_b->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20));
+
+  // Live buffers keep the slab alive.
+  allocators->Unref();
+  alloc_c->DeallocateRaw(ptr_c);
+}
+
+TEST_F(MemoryPlanTest, ServesPlanFromArena) {
+  MemoryPlan plan(&graph_);
+  plan.Plan(Sizes(plan, 1000));
+  MemoryArena* arena = new MemoryArena(cpu_allocator(), plan.slab_bytes());
+  ASSERT_NE(nullptr, arena->data());
+  ASSERT_TRUE(arena->TryAcquire());
+  EXPECT_FALSE(arena->TryAcquire());
+
+  PlannedAllocators* allocators =
+      new PlannedAllocators(&plan, cpu_allocator(), arena);
+  Allocator* alloc_b = allocators->node_allocators(b_->id())[0];
+  void* ptr_b = alloc_b->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  EXPECT_EQ(arena->data() + plan.offset(output(plan, b_)), ptr_b);
+
+  // The arena is held until the last buffer served from it is gone.
+  allocators->Unref();
+  EXPECT_FALSE(arena->TryAcquire());
+  alloc_b->DeallocateRaw(ptr_b);
+  EXPECT_TRUE(arena->TryAcquire());
+  arena->Release();
+  arena->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,118 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/online_cost_model.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+constexpr int OnlineCostModel::kMaxSamples;
+
+void OnlineCostModel::AddStepStats(
+    const StepStats& step_stats,
+    const std::unordered_map<string, const Graph*>& device_to_graph) {
+  mutex_lock l(mu_);
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    auto graph_it = device_to_graph.find(dev_stats.device());
+    if (graph_it == device_to_graph.end()) continue;
+    const Graph* graph = graph_it->second;
+    // Only look the nodes of the graph up by name if some are new.
+    std::unordered_map<StringPiece, const Node*, StringPiece::Hasher>
+        name_to_node;
+    for (const NodeExecStats& stats : dev_stats.node_stats()) {
+      auto it = nodes_.find(stats.node_name());
+      if (it == nodes_.end()) {
+        if (name_to_node.empty()) {
+          for (const Node* n : graph->nodes()) {
+            name_to_node.emplace(n->name(), n);
+          }
+        }
+        auto node_it = name_to_node.find(stats.node_name());
+        if (node_it == name_to_node.end()) continue;
+        it = nodes_.emplace(stats.node_name(), NodeCosts()).first;
+        it->second.op = node_it->second->type_string();
+        it->second.device = dev_stats.device();
+        it->second.compute_micros.reserve(kMaxSamples);
+      }
+      NodeCosts& costs = it->second;
+      const double micros = std::max<int64>(
+          0, stats.op_end_rel_micros() - stats.op_start_rel_micros());
+      if (costs.compute_micros.size() < kMaxSamples) {
+        costs.compute_micros.push_back(micros);
+      } else {
+        costs.compute_micros[costs.next] = micros;
+      }
+      costs.next = (costs.next + 1) % kMaxSamples;
+      if (stats.has_memory_stats()) {
+        costs.host_temp_memory = stats.memory_stats().host_temp_memory_size();
+        costs.device_temp_memory =
+            stats.memory_stats().device_temp_memory_size();
+      }
+    }
+  }
+}
+
+double OnlineCostModel::RobustMean(const NodeCosts& costs) const {
+  return grappler::RobustStats(costs.compute_micros).mean();
+}
+
+bool OnlineCostModel::ComputeTime(const string& node_name, int min_samples,
+                                  Microseconds* time) const {
+  mutex_lock l(mu_);
+  auto it = nodes_.find(node_name);
+  if (it == nodes_.end() ||
+      static_cast<int>(it->second.compute_micros.size()) <
+          std::max(1, min_samples)) {
+    return false;
+  }
+  *time = Microseconds(static_cast<int64>(RobustMean(it->second)));
+  return true;
+}
+
+void OnlineCostModel::ExportOpPerformance(
+    grappler::OpPerformanceList* list) const {
+  mutex_lock l(mu_);
+  for (const auto& it : nodes_) {
+    const NodeCosts& costs = it.second;
+    if (costs.compute_micros.empty()) continue;
+    grappler::OpPerformance* perf = list->add_op_performance();
+    perf->set_node(it.first);
+    perf->mutable_op()->set_op(costs.op);
+    DeviceNameUtils::ParsedName parsed;
+    if (DeviceNameUtils::ParseFullName(costs.device, &parsed) &&
+        parsed.has_type) {
+      perf->mutable_op()->mutable_device()->set_type(parsed.type);
+    }
+    // OpPerformance.compute_cost is nanoseconds.
+    perf->set_compute_cost(static_cast<int64>(RobustMean(costs) * 1000));
+    perf->set_temporary_memory_size(costs.host_temp_memory +
+                                    costs.device_temp_memory);
+    perf->mutable_op_memory()->set_host_temp_memory(costs.host_temp_memory);
+    perf->mutable_op_memory()->set_device_temp_memory(
+        costs.device_temp_memory);
+  }
+}
+
+int OnlineCostModel::num_nodes() const {
+  mutex_lock l(mu_);
+  return nodes_.size();
+}
+
+}  // namespace tensorflow
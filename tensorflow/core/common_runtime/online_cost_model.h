@@ -0,0 +1,89 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ONLINE_COST_MODEL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ONLINE_COST_MODEL_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/types.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StepStats;
+
+// A per-session cost model that is updated with the execution stats of
+// every traced step, sampled or not, while the session runs.
+//
+// Unlike CostModel, which keeps the maximum of every measurement and has to
+// be built under the session's lock, this keeps the most recent compute
+// times of each node and summarizes them with robust statistics, so that a
+// few slow steps don't skew the estimates. All methods are thread-safe.
+class OnlineCostModel {
+ public:
+  // The number of recent samples kept for each node.
+  static constexpr int kMaxSamples = 32;
+
+  OnlineCostModel() {}
+
+  // Adds the node stats of one step. "device_to_graph" maps the devices in
+  // "step_stats" to the graphs they ran, which give the op of each node;
+  // nodes that are not in their device's graph are skipped.
+  void AddStepStats(
+      const StepStats& step_stats,
+      const std::unordered_map<string, const Graph*>& device_to_graph);
+
+  // Sets "*time" to the robust mean of the recent compute times of node
+  // "node_name" and returns true, or returns false if the node has fewer
+  // than "min_samples" samples.
+  bool ComputeTime(const string& node_name, int min_samples,
+                   Microseconds* time) const;
+
+  // Appends one OpPerformance per node with the current estimates of its
+  // compute cost and temporary memory, for grappler's cost estimators.
+  void ExportOpPerformance(grappler::OpPerformanceList* list) const;
+
+  // The number of nodes with samples.
+  int num_nodes() const;
+
+ private:
+  struct NodeCosts {
+    string op;
+    string device;
+    // A ring buffer of the most recent compute times, in microseconds.
+    std::vector<double> compute_micros;
+    int next = 0;
+    int64 host_temp_memory = 0;
+    int64 device_temp_memory = 0;
+  };
+
+  double RobustMean(const NodeCosts& costs) const;
+
+  mutable mutex mu_;
+  std::unordered_map<string, NodeCosts> nodes_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OnlineCostModel);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ONLINE_COST_MODEL_H_
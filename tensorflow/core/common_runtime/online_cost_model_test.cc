@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/online_cost_model.h"
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char* const kDevice = "/job:localhost/replica:0/task:0/cpu:0";
+
+class OnlineCostModelTest : public ::testing::Test {
+ protected:
+  OnlineCostModelTest() : graph_(OpRegistry::Global()) {
+    Tensor t(DT_FLOAT, TensorShape({4}));
+    t.flat<float>().setZero();
+    a_ = test::graph::Constant(&graph_, t);
+    b_ = test::graph::Identity(&graph_, a_);
+    device_to_graph_[kDevice] = &graph_;
+  }
+
+  // Adds one step in which node "node" computed for "micros".
+  void AddStep(const Node* node, int64 micros) {
+    StepStats step_stats;
+    DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+    dev_stats->set_device(kDevice);
+    NodeExecStats* stats = dev_stats->add_node_stats();
+    stats->set_node_name(node->name());
+    stats->set_op_start_rel_micros(1);
+    stats->set_op_end_rel_micros(1 + micros);
+    model_.AddStepStats(step_stats, device_to_graph_);
+  }
+
+  Graph graph_;
+  Node* a_;
+  Node* b_;
+  std::unordered_map<string, const Graph*> device_to_graph_;
+  OnlineCostModel model_;
+};
+
+TEST_F(OnlineCostModelTest, IgnoresOutliers) {
+  for (int i = 0; i < 10; ++i) {
+    AddStep(b_, 100);
+  }
+  AddStep(b_, 100000);
+
+  Microseconds time;
+  EXPECT_FALSE(model_.ComputeTime(a_->name(), 1, &time));
+  EXPECT_FALSE(model_.ComputeTime(b_->name(), 20, &time));
+  ASSERT_TRUE(model_.ComputeTime(b_->name(), 8, &time));
+  EXPECT_NEAR(100, time.value(), 1);
+}
+
+TEST_F(OnlineCostModelTest, KeepsRecentSamples) {
+  for (int i = 0; i < OnlineCostModel::kMaxSamples; ++i) {
+    AddStep(b_, 100);
+  }
+  for (int i = 0; i < OnlineCostModel::kMaxSamples; ++i) {
+    AddStep(b_, 500);
+  }
+  Microseconds time;
+  ASSERT_TRUE(model_.ComputeTime(b_->name(), 1, &time));
+  EXPECT_NEAR(500, time.value(), 1);
+}
+
+TEST_F(OnlineCostModelTest, SkipsUnknownNodes) {
+  StepStats step_stats;
+  DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+  dev_stats->set_device(kDevice);
+  dev_stats->add_node_stats()->set_node_name("missing");
+  model_.AddStepStats(step_stats, device_to_graph_);
+  EXPECT_EQ(0, model_.num_nodes());
+}
+
+TEST_F(OnlineCostModelTest, ExportsOpPerformance) {
+  AddStep(b_, 100);
+  grappler::OpPerformanceList list;
+  model_.ExportOpPerformance(&list);
+  ASSERT_EQ(1, list.op_performance_size());
+  const grappler::OpPerformance& perf = list.op_performance(0);
+  EXPECT_EQ(b_->name(), perf.node());
+  EXPECT_EQ("Identity", perf.op().op());
+  EXPECT_EQ("CPU", perf.op().device().type());
+  EXPECT_EQ(100000, perf.compute_cost());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -91,6 +91,13 @@ class PendingCounts {
 
   ~PendingCounts() { delete[] bytes_; }
 
+  // Overwrite the counts with those of "other", which must have the same
+  // layout, without reallocating.
+  void CopyFrom(const PendingCounts& other) {
+    DCHECK_EQ(num_bytes_, other.num_bytes_);
+    memcpy(bytes_, other.bytes_, num_bytes_);
+  }
+
   void set_initial_count(Handle h, size_t pending_count) {
     if (h.is_large_) {
       LargeCounts* c = Large(h);
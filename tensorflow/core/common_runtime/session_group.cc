@@ -0,0 +1,241 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/session_group.h"
+
+#include <algorithm>
+#include <map>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+auto* session_group_steps = monitoring::Counter<2>::New(
+    "/tensorflow/core/session_group/steps",
+    "The number of steps started by each session of a session group.", "group",
+    "member");
+auto* session_group_admission_wait = monitoring::Counter<2>::New(
+    "/tensorflow/core/session_group/admission_wait_micros",
+    "Time in microseconds that the steps of each session of a session group "
+    "waited to be admitted.",
+    "group", "member");
+auto* session_group_compute = monitoring::Counter<2>::New(
+    "/tensorflow/core/session_group/compute_micros",
+    "Time in microseconds that the inter-op closures of each session of a "
+    "session group ran on the group's threads.",
+    "group", "member");
+
+struct GroupRegistry {
+  mutex mu;
+  std::map<string, SessionGroup*> groups GUARDED_BY(mu);
+};
+
+GroupRegistry* GetGroupRegistry() {
+  static GroupRegistry* const registry = new GroupRegistry;
+  return registry;
+}
+
+}  // namespace
+
+SessionGroup::SessionGroup(const SessionGroupOptions& options, Env* env)
+    : options_(options) {
+  const int32 num_threads = options_.num_threads() > 0
+                                ? options_.num_threads()
+                                : port::NumSchedulableCPUs();
+  VLOG(1) << "Session group " << options_.name()
+          << " inter op parallelism threads: " << num_threads;
+  thread_pool_.reset(new thread::ThreadPool(env, "SessionGroup", num_threads));
+}
+
+Status SessionGroup::Get(const SessionGroupOptions& options, Env* env,
+                         SessionGroup** group) {
+  if (options.name().empty()) {
+    return errors::InvalidArgument("A session group needs a name");
+  }
+  GroupRegistry* registry = GetGroupRegistry();
+  mutex_lock l(registry->mu);
+  SessionGroup*& existing = registry->groups[options.name()];
+  if (existing == nullptr) {
+    SessionGroupOptions group_options = options;
+    group_options.clear_member_name();
+    existing = new SessionGroup(group_options, env);
+  } else if (existing->options_.num_threads() != options.num_threads() ||
+             existing->options_.max_concurrent_steps() !=
+                 options.max_concurrent_steps() ||
+             existing->options_.memory_budget_bytes() !=
+                 options.memory_budget_bytes()) {
+    return errors::InvalidArgument(
+        "Session group ", options.name(), " configured previously with ",
+        "num_threads=", existing->options_.num_threads(),
+        ", max_concurrent_steps=", existing->options_.max_concurrent_steps(),
+        ", memory_budget_bytes=", existing->options_.memory_budget_bytes(),
+        "; cannot re-configure with num_threads=", options.num_threads(),
+        ", max_concurrent_steps=", options.max_concurrent_steps(),
+        ", memory_budget_bytes=", options.memory_budget_bytes());
+  }
+  *group = existing;
+  return Status::OK();
+}
+
+SessionGroup* SessionGroup::Find(const string& name) {
+  GroupRegistry* registry = GetGroupRegistry();
+  mutex_lock l(registry->mu);
+  auto it = registry->groups.find(name);
+  return it == registry->groups.end() ? nullptr : it->second;
+}
+
+std::unique_ptr<SessionGroup::Member> SessionGroup::AddMember(
+    const string& member_name, const std::vector<Device*>& devices) {
+  std::vector<Allocator*> allocators;
+  if (options_.memory_budget_bytes() > 0) {
+    for (Device* device : devices) {
+      Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+      if (std::find(allocators.begin(), allocators.end(), allocator) ==
+          allocators.end()) {
+        allocators.push_back(allocator);
+      }
+    }
+  }
+  mutex_lock l(mu_);
+  const int64 member_id = next_member_id_++;
+  std::unique_ptr<Member> member(new Member(
+      this,
+      member_name.empty() ? strings::StrCat("session_", member_id)
+                          : member_name,
+      allocators));
+  members_.push_back(member.get());
+  return member;
+}
+
+std::vector<SessionGroup::MemberStats> SessionGroup::GetStats() {
+  std::vector<MemberStats> stats;
+  mutex_lock l(mu_);
+  for (const Member* member : members_) {
+    MemberStats member_stats;
+    member_stats.member_name = member->name_;
+    member_stats.num_steps = member->num_steps_;
+    member_stats.num_running_steps = member->num_running_steps_;
+    member_stats.admission_wait_micros = member->admission_wait_micros_;
+    member_stats.compute_micros = member->compute_micros_;
+    stats.push_back(member_stats);
+  }
+  return stats;
+}
+
+bool SessionGroup::CanStartStep(const Member* member) {
+  if (options_.max_concurrent_steps() > 0) {
+    if (num_running_steps_ >= options_.max_concurrent_steps()) return false;
+    // The waiting steps of the sessions with fewer running steps go first.
+    for (const Member* other : members_) {
+      if (other != member && other->num_waiting_steps_ > 0 &&
+          other->num_running_steps_ < member->num_running_steps_) {
+        return false;
+      }
+    }
+  }
+  // A step always starts when the group is idle, so that a budget that is
+  // too small still lets the steps run one at a time.
+  if (options_.memory_budget_bytes() > 0 && num_running_steps_ > 0 &&
+      member->BytesInUse() > options_.memory_budget_bytes()) {
+    return false;
+  }
+  return true;
+}
+
+SessionGroup::Member::Member(SessionGroup* group, const string& name,
+                             const std::vector<Allocator*>& allocators)
+    : group_(group),
+      name_(name),
+      allocators_(allocators),
+      step_count_(session_group_steps->GetCell(group->name(), name)),
+      admission_wait_cell_(
+          session_group_admission_wait->GetCell(group->name(), name)),
+      compute_cell_(session_group_compute->GetCell(group->name(), name)) {}
+
+SessionGroup::Member::~Member() {
+  mutex_lock l(group_->mu_);
+  auto& members = group_->members_;
+  members.erase(std::remove(members.begin(), members.end(), this),
+                members.end());
+  group_->step_done_.notify_all();
+}
+
+int64 SessionGroup::Member::BytesInUse() const {
+  int64 bytes_in_use = 0;
+  for (Allocator* allocator : allocators_) {
+    AllocatorStats stats;
+    allocator->GetStats(&stats);
+    bytes_in_use += stats.bytes_in_use;
+  }
+  return bytes_in_use;
+}
+
+Status SessionGroup::Member::StartStep(int64 timeout_in_ms) {
+  const uint64 start_micros = Env::Default()->NowMicros();
+  mutex_lock l(group_->mu_);
+  ++num_waiting_steps_;
+  while (!group_->CanStartStep(this)) {
+    if (timeout_in_ms <= 0) {
+      group_->step_done_.wait(l);
+      continue;
+    }
+    const int64 elapsed_ms =
+        (Env::Default()->NowMicros() - start_micros) / 1000;
+    if (elapsed_ms >= timeout_in_ms) {
+      --num_waiting_steps_;
+      // Steps of other sessions may have been waiting for this one.
+      group_->step_done_.notify_all();
+      return errors::DeadlineExceeded("Timed out waiting for session group ",
+                                      group_->name(), " to admit a step");
+    }
+    WaitForMilliseconds(&l, &group_->step_done_, timeout_in_ms - elapsed_ms);
+  }
+  --num_waiting_steps_;
+  ++num_running_steps_;
+  ++num_steps_;
+  ++group_->num_running_steps_;
+  const int64 wait_micros = Env::Default()->NowMicros() - start_micros;
+  admission_wait_micros_ += wait_micros;
+  step_count_->IncrementBy(1);
+  admission_wait_cell_->IncrementBy(wait_micros);
+  group_->step_done_.notify_all();
+  return Status::OK();
+}
+
+void SessionGroup::Member::EndStep() {
+  mutex_lock l(group_->mu_);
+  --num_running_steps_;
+  --group_->num_running_steps_;
+  group_->step_done_.notify_all();
+}
+
+std::function<void()> SessionGroup::Member::WrapClosure(
+    std::function<void()> c) {
+  return [this, c]() {
+    const uint64 start_micros = Env::Default()->NowMicros();
+    c();
+    const int64 micros = Env::Default()->NowMicros() - start_micros;
+    compute_micros_ += micros;
+    compute_cell_->IncrementBy(micros);
+  };
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,148 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_SESSION_GROUP_H_
+#define TENSORFLOW_COMMON_RUNTIME_SESSION_GROUP_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+// A group of sessions hosted in one process, configured by
+// ConfigProto.session_group. The sessions of a group share one inter-op
+// thread pool instead of each creating their own, and their steps are
+// admitted fairly under the group's concurrency limit and memory budget.
+// The group accounts the steps and inter-op compute time of each session,
+// and exports them as /tensorflow/core/session_group/* metrics.
+//
+// Groups are looked up by name, and are never garbage collected.
+class SessionGroup {
+ public:
+  // Statistics of one session of a group.
+  struct MemberStats {
+    string member_name;
+    // The number of steps that have started.
+    int64 num_steps = 0;
+    // The number of steps that are currently running.
+    int64 num_running_steps = 0;
+    // The total time that steps waited to be admitted.
+    int64 admission_wait_micros = 0;
+    // The total time that inter-op closures ran on the group's threads.
+    int64 compute_micros = 0;
+  };
+
+  class Member;
+
+  // Finds the group named "options.name()", or creates it with a thread pool
+  // from "env". Returns an error if the group exists with different options.
+  static Status Get(const SessionGroupOptions& options, Env* env,
+                    SessionGroup** group);
+
+  // Returns the group named "name", or nullptr if there is none.
+  static SessionGroup* Find(const string& name);
+
+  const string& name() const { return options_.name(); }
+  thread::ThreadPool* thread_pool() { return thread_pool_.get(); }
+
+  // Adds a session to the group, which stays a member until the returned
+  // object is destroyed. The memory budget is checked against the allocators
+  // of "devices". A default name is generated if "member_name" is empty.
+  std::unique_ptr<Member> AddMember(const string& member_name,
+                                    const std::vector<Device*>& devices);
+
+  // Returns the statistics of the current members of the group.
+  std::vector<MemberStats> GetStats();
+
+ private:
+  SessionGroup(const SessionGroupOptions& options, Env* env);
+
+  // Returns true if a step of "member" may start now.
+  bool CanStartStep(const Member* member) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const SessionGroupOptions options_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  mutex mu_;
+  condition_variable step_done_;
+  std::vector<Member*> members_ GUARDED_BY(mu_);
+  int64 num_running_steps_ GUARDED_BY(mu_) = 0;
+  int64 next_member_id_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SessionGroup);
+};
+
+// A session's membership in a SessionGroup.
+class SessionGroup::Member {
+ public:
+  ~Member();
+
+  const string& name() const { return name_; }
+
+  // Waits until a step of this session may start, and counts it as running.
+  // Returns a DeadlineExceeded error if "timeout_in_ms" is positive and the
+  // step was not admitted in time.
+  Status StartStep(int64 timeout_in_ms);
+
+  // Counts a step started by StartStep() as finished.
+  void EndStep();
+
+  // Returns "c" wrapped to account its run time to this session.
+  std::function<void()> WrapClosure(std::function<void()> c);
+
+ private:
+  friend class SessionGroup;
+
+  Member(SessionGroup* group, const string& name,
+         const std::vector<Allocator*>& allocators);
+
+  // Returns the bytes in use by the allocators of the session's devices.
+  int64 BytesInUse() const;
+
+  SessionGroup* const group_;
+  const string name_;
+  const std::vector<Allocator*> allocators_;
+
+  // Guarded by group_->mu_.
+  int64 num_steps_ = 0;
+  int64 num_running_steps_ = 0;
+  int64 num_waiting_steps_ = 0;
+  int64 admission_wait_micros_ = 0;
+
+  std::atomic<int64> compute_micros_{0};
+  monitoring::CounterCell* const step_count_;
+  monitoring::CounterCell* const admission_wait_cell_;
+  monitoring::CounterCell* const compute_cell_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Member);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_SESSION_GROUP_H_
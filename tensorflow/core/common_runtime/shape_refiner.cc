@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_set>
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -102,8 +104,22 @@ Status ShapeRefiner::AddNode(const Node* node) {
     return c->construction_status();
   }
 
-  // Run the shape inference function, and return if there was an error.
-  TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, c.get()));
+  Fprint128 memo_key;
+  const bool memoizable = ShapeMemoKey(node, c.get(), &memo_key);
+  auto memo_it = memoizable ? shape_memo_.find(memo_key) : shape_memo_.end();
+  if (memo_it != shape_memo_.end()) {
+    // An identical node has been added before; reuse its output shapes.
+    const std::vector<TensorShape>& shapes = memo_it->second;
+    for (int i = 0; i < shapes.size(); ++i) {
+      ShapeHandle s;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromTensorShape(shapes[i], &s));
+      c->set_output(i, s);
+    }
+  } else {
+    // Run the shape inference function, and return if there was an error.
+    TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, c.get()));
+    if (memoizable) MaybeMemoizeShapes(memo_key, c.get());
+  }
 
   // Store the resulting InferenceContext object in the map.
   node_to_context_[node].swap(c);
@@ -664,6 +680,66 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
   return Status::OK();
 }
 
+bool ShapeRefiner::ShapeMemoKey(const Node* node, InferenceContext* c,
+                                Fprint128* key) {
+  // Nodes without inputs, such as constants, are cheap to infer and may
+  // carry large attrs.
+  if (c->num_inputs() == 0) return false;
+  string s = strings::StrCat(node->type_string(), ";", graph_def_version_);
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    ShapeHandle input = c->input(i);
+    if (!c->FullyDefined(input) ||
+        c->input_handle_shapes_and_types(i) != nullptr) {
+      return false;
+    }
+    strings::StrAppend(&s, ";");
+    for (int d = 0; d < c->Rank(input); ++d) {
+      strings::StrAppend(&s, c->Value(c->Dim(input, d)), ",");
+    }
+  }
+  // Attrs whose names start with "_" are internal (e.g. colocation) and
+  // don't affect shapes.
+  std::vector<const string*> attr_names;
+  for (const auto& attr : node->def().attr()) {
+    if (!StringPiece(attr.first).starts_with("_")) {
+      attr_names.push_back(&attr.first);
+    }
+  }
+  std::sort(attr_names.begin(), attr_names.end(),
+            [](const string* a, const string* b) { return *a < *b; });
+  for (const string* name : attr_names) {
+    strings::StrAppend(&s, ";", *name, "=");
+    node->def().attr().at(*name).AppendToString(&s);
+  }
+  *key = Fingerprint128(s);
+  return true;
+}
+
+void ShapeRefiner::MaybeMemoizeShapes(const Fprint128& key,
+                                      InferenceContext* c) {
+  // The shapes can't be reused if they depend on the values of the inputs,
+  // and are only worth storing if they are fully defined, since unknown
+  // dimensions would lose their identity.
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (c->requested_input_tensor(i) ||
+        c->requested_input_tensor_as_partial_shape(i)) {
+      return;
+    }
+  }
+  std::vector<TensorShape> shapes(c->num_outputs());
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    ShapeHandle output = c->output(i);
+    if (!c->FullyDefined(output) ||
+        c->output_handle_shapes_and_types(i) != nullptr) {
+      return;
+    }
+    for (int d = 0; d < c->Rank(output); ++d) {
+      shapes[i].AddDim(c->Value(c->Dim(output, d)));
+    }
+  }
+  shape_memo_.emplace(key, std::move(shapes));
+}
+
 bool ShapeRefiner::SameDefinedShape(InferenceContext* c, ShapeHandle s0,
                                     ShapeHandle s1) {
   if (!c->RankKnown(s0)) {
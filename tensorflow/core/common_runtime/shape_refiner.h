@@ -15,12 +15,15 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -147,6 +150,17 @@ class ShapeRefiner {
   Status RunShapeFn(const Node* node, const OpRegistrationData* op_reg_data,
                     shape_inference::InferenceContext* c);
 
+  // Computes the key of 'node' in shape_memo_ from its op, attrs and input
+  // shapes, which are in 'c'. Returns false if the output shapes of 'node'
+  // can't be memoized, e.g. because its input shapes aren't fully defined.
+  bool ShapeMemoKey(const Node* node, shape_inference::InferenceContext* c,
+                    Fprint128* key);
+
+  // Stores the output shapes in 'c' in shape_memo_ under 'key', unless
+  // they depend on the values of the inputs or aren't fully defined.
+  void MaybeMemoizeShapes(const Fprint128& key,
+                          shape_inference::InferenceContext* c);
+
   int32 graph_def_version_;
   const OpRegistryInterface* const ops_registry_;
 
@@ -172,6 +186,13 @@ class ShapeRefiner {
   static constexpr int64 kMaxTensorSize = 1024;
   std::unordered_map<string, Tensor> const_tensor_map_;
 
+  // Output shapes of the nodes added so far, keyed by ShapeMemoKey(). Large
+  // models repeat the same op with the same attrs and input shapes many
+  // times (e.g. unrolled RNN steps), and AddNode() only runs the shape
+  // function for the first of them.
+  std::unordered_map<Fprint128, std::vector<TensorShape>, Fprint128Hasher>
+      shape_memo_;
+
   bool require_shape_inference_fns_ = true;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ShapeRefiner);
@@ -1150,5 +1150,74 @@ TEST_F(ShapeRefinerTest, IncrementalUpdates) {
   ASSERT_FALSE(SameHandle(ctx->Dim(ctx->output(0), 0), ctx->Dim(shp, 0)));
 }
 
+namespace {
+
+int num_counting_shape_fn_calls = 0;
+
+REGISTER_OP("CountingShapeFn")
+    .Input("x: float")
+    .Output("y: float")
+    .Attr("n: int = 0")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      ++num_counting_shape_fn_calls;
+      return shape_inference::UnchangedShape(c);
+    });
+
+}  // namespace
+
+TEST_F(ShapeRefinerTest, MemoizesIdenticalNodes) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  Graph graph(OpRegistry::Global());
+  Node* x = test::graph::Constant(&graph, Tensor(DT_FLOAT, {2, 3}));
+  Node* y = test::graph::Constant(&graph, Tensor(DT_FLOAT, {4}));
+  TF_ASSERT_OK(m.AddNode(x));
+  TF_ASSERT_OK(m.AddNode(y));
+
+  auto add_node = [&m, &graph](Node* input, int n) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(graph.NewName("c"), "CountingShapeFn")
+                    .Input(input)
+                    .Attr("n", n)
+                    .Finalize(&graph, &node));
+    TF_CHECK_OK(m.AddNode(node));
+    shape_inference::InferenceContext* ctx = m.GetContext(node);
+    return ctx->DebugString(ctx->output(0));
+  };
+
+  num_counting_shape_fn_calls = 0;
+  EXPECT_EQ("[2,3]", add_node(x, 0));
+  EXPECT_EQ(1, num_counting_shape_fn_calls);
+  EXPECT_EQ("[2,3]", add_node(x, 0));
+  EXPECT_EQ(1, num_counting_shape_fn_calls);
+
+  // Different attrs or input shapes run the shape function again.
+  EXPECT_EQ("[2,3]", add_node(x, 1));
+  EXPECT_EQ(2, num_counting_shape_fn_calls);
+  EXPECT_EQ("[4]", add_node(y, 0));
+  EXPECT_EQ(3, num_counting_shape_fn_calls);
+  EXPECT_EQ("[4]", add_node(y, 0));
+  EXPECT_EQ(3, num_counting_shape_fn_calls);
+}
+
+TEST_F(ShapeRefinerTest, DoesNotMemoizeUnknownShapes) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 3})));
+  TF_ASSERT_OK(m.AddNode(x.node()));
+
+  num_counting_shape_fn_calls = 0;
+  for (int i = 0; i < 2; ++i) {
+    Node* node;
+    TF_ASSERT_OK(NodeBuilder(root.graph()->NewName("c"), "CountingShapeFn")
+                     .Input(x.node())
+                     .Finalize(root.graph(), &node));
+    TF_ASSERT_OK(m.AddNode(node));
+    shape_inference::InferenceContext* ctx = m.GetContext(node);
+    EXPECT_EQ("[?,3]", ctx->DebugString(ctx->output(0)));
+  }
+  EXPECT_EQ(2, num_counting_shape_fn_calls);
+}
+
 }  // namespace
 }  // namespace tensorflow
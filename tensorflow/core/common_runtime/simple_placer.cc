@@ -17,18 +17,24 @@ limitations under the License.
 
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -634,6 +640,295 @@ bool IsGeneratorNode(const Node* node) {
          !IsRefType(node->output_type(0));
 }
 
+// Chooses a device for each colocation group of a graph, for the
+// COST_BALANCED_PLACEMENT strategy. This is a list scheduler: the groups
+// are visited in topological order, and each one goes to the device of its
+// preferred type on which it is estimated to finish first, given the work
+// already scheduled there and the time to receive its inputs from other
+// devices. Devices without enough memory left for a group are only used
+// when no device has enough.
+//
+// Costs come from grappler's OpLevelCostEstimator, using the shapes that
+// can be inferred statically; nodes with unknown shapes count as cheap.
+class CostBalancedAssignment {
+ public:
+  CostBalancedAssignment(Graph* graph, const DeviceSet* device_set,
+                         ColocationGraph* colocation_graph)
+      : graph_(graph),
+        device_set_(device_set),
+        colocation_graph_(colocation_graph),
+        refiner_(graph->versions().producer(), graph->op_registry()),
+        node_devices_(graph->num_node_ids(), nullptr),
+        node_finish_ns_(graph->num_node_ids(), 0) {
+    refiner_.set_require_shape_inference_fns(false);
+  }
+
+  void Run() {
+    std::vector<Node*> order;
+    GetReversePostOrder(*graph_, &order);
+    // Shapes are best effort: inference fails for, e.g., nodes that are
+    // fed by a loop back edge, and those nodes then have unknown shapes.
+    for (Node* node : order) {
+      refiner_.AddNode(node).IgnoreError();
+    }
+
+    // Gather the unplaced colocation groups, in the order the first node
+    // of each one appears. Nodes that are already placed form groups of
+    // their own, with a single possible device.
+    std::vector<int> group_roots;
+    std::unordered_map<int, std::vector<const Node*>> groups;
+    for (Node* node : order) {
+      if (!node->IsOp()) {
+        continue;
+      }
+      if (node->has_assigned_device_name()) {
+        group_roots.push_back(-1 - node->id());
+        groups[group_roots.back()].push_back(node);
+        continue;
+      }
+      const int root = colocation_graph_->FindRoot(node->id());
+      std::vector<const Node*>& members = groups[root];
+      if (members.empty()) {
+        group_roots.push_back(root);
+      }
+      members.push_back(node);
+    }
+
+    for (int root : group_roots) {
+      AssignGroup(root, groups[root]);
+    }
+
+    if (VLOG_IS_ON(1)) {
+      for (const auto& it : device_ready_ns_) {
+        VLOG(1) << "Estimated busy until " << it.second << " ns on "
+                << it.first->name() << ", memory: " << memory_bytes_[it.first]
+                << " bytes";
+      }
+    }
+  }
+
+  // Returns the device chosen for the colocation group whose root is
+  // 'root', or nullptr if none was chosen.
+  const Device* DeviceForGroup(int root) const {
+    auto it = group_devices_.find(root);
+    return it == group_devices_.end() ? nullptr : it->second;
+  }
+
+ private:
+  // An estimate of the bandwidth between two devices, in bytes per
+  // nanosecond, e.g. over PCIe.
+  static constexpr double kTransferBytesPerNs = 10.0;
+
+  // Places the nodes in 'members', whose id is 'root' if they are an
+  // unplaced colocation group.
+  void AssignGroup(int root, const std::vector<const Node*>& members) {
+    std::vector<const Device*> candidates;
+    if (root < 0) {
+      const Device* device =
+          device_set_->FindDeviceByName(members[0]->assigned_device_name());
+      if (device == nullptr) {
+        return;
+      }
+      candidates.push_back(device);
+    } else {
+      std::vector<Device*>* possible_devices;
+      // Errors are reported by the placer when it assigns the group.
+      if (!colocation_graph_->GetDevicesForNode(graph_->FindNodeId(root),
+                                                &possible_devices)
+               .ok()) {
+        return;
+      }
+      // Only balance across the devices of the type the placer would pick.
+      for (const Device* device : *possible_devices) {
+        if (device->device_type() ==
+            possible_devices->front()->device_type()) {
+          candidates.push_back(device);
+        }
+      }
+    }
+
+    // All the candidates have the same type, so the costs of the group are
+    // the same on each of them.
+    double compute_ns = 0;
+    int64 memory_bytes = 0;
+    for (const Node* node : members) {
+      compute_ns += ComputeTime(*node, *candidates.front());
+      memory_bytes += OutputBytes(*node);
+    }
+
+    const Device* best_device = nullptr;
+    double best_finish_ns = 0;
+    bool best_fits = false;
+    for (const Device* device : candidates) {
+      const int64 memory_limit = device->attributes().memory_limit();
+      const bool fits = memory_limit <= 0 ||
+                        memory_bytes_[device] + memory_bytes <= memory_limit;
+      const double finish_ns = StartTime(members, device) + compute_ns;
+      // Ties go to the earlier device, which is the placer's default.
+      if (best_device == nullptr || (fits && !best_fits) ||
+          (fits == best_fits &&
+           (finish_ns < best_finish_ns ||
+            (finish_ns == best_finish_ns &&
+             memory_bytes_[device] < memory_bytes_[best_device])))) {
+        best_device = device;
+        best_finish_ns = finish_ns;
+        best_fits = fits;
+      }
+    }
+
+    if (root >= 0) {
+      group_devices_[root] = best_device;
+    }
+    device_ready_ns_[best_device] = best_finish_ns;
+    memory_bytes_[best_device] += memory_bytes;
+    for (const Node* node : members) {
+      node_devices_[node->id()] = best_device;
+      node_finish_ns_[node->id()] = best_finish_ns;
+    }
+  }
+
+  // Returns the earliest time at which 'members' could start on 'device':
+  // once the device is free and the inputs produced by the nodes already
+  // placed have arrived.
+  double StartTime(const std::vector<const Node*>& members,
+                   const Device* device) {
+    double start_ns = device_ready_ns_[device];
+    for (const Node* node : members) {
+      for (const Edge* edge : node->in_edges()) {
+        const Node* src = edge->src();
+        const Device* src_device = node_devices_[src->id()];
+        if (src_device == nullptr) {
+          continue;
+        }
+        double arrival_ns = node_finish_ns_[src->id()];
+        if (src_device != device && !edge->IsControlEdge()) {
+          arrival_ns += OutputBytes(*src, edge->src_output()) /
+                        kTransferBytesPerNs;
+        }
+        start_ns = std::max(start_ns, arrival_ns);
+      }
+    }
+    return start_ns;
+  }
+
+  double ComputeTime(const Node& node, const Device& device) {
+    OpInfo op_info;
+    op_info.set_op(node.type_string());
+    for (const auto& attr : node.def().attr()) {
+      (*op_info.mutable_attr())[attr.first] = attr.second;
+    }
+    shape_inference::InferenceContext* c = refiner_.GetContext(&node);
+    if (c != nullptr) {
+      for (int i = 0; i < c->num_inputs(); ++i) {
+        AddTensorProperties(c, c->input(i), node.input_type(i),
+                            op_info.add_inputs());
+      }
+      for (int i = 0; i < c->num_outputs(); ++i) {
+        AddTensorProperties(c, c->output(i), node.output_type(i),
+                            op_info.add_outputs());
+      }
+    }
+    *op_info.mutable_device() = PropertiesForDevice(device);
+    const double time_ns =
+        estimator_.PredictCosts(op_info).execution_time.count();
+    return time_ns > 0 ? time_ns : 0;
+  }
+
+  static void AddTensorProperties(shape_inference::InferenceContext* c,
+                                  shape_inference::ShapeHandle shape,
+                                  DataType dtype,
+                                  OpInfo::TensorProperties* tensor) {
+    tensor->set_dtype(BaseType(dtype));
+    if (!c->RankKnown(shape)) {
+      tensor->mutable_shape()->set_unknown_rank(true);
+      return;
+    }
+    for (int i = 0; i < c->Rank(shape); ++i) {
+      tensor->mutable_shape()->add_dim()->set_size(
+          c->Value(c->Dim(shape, i)));
+    }
+  }
+
+  // Returns the size of the given output of 'node', or 0 if its shape is
+  // not fully known.
+  int64 OutputBytes(const Node& node, int output) {
+    shape_inference::InferenceContext* c = refiner_.GetContext(&node);
+    if (c == nullptr || output < 0 || output >= c->num_outputs()) {
+      return 0;
+    }
+    const int64 num_elements = c->Value(c->NumElements(c->output(output)));
+    if (num_elements < 0) {
+      return 0;
+    }
+    return num_elements * DataTypeSize(BaseType(node.output_type(output)));
+  }
+
+  // Returns the total size of the outputs of 'node' whose shapes are known.
+  int64 OutputBytes(const Node& node) {
+    int64 bytes = 0;
+    for (int i = 0; i < node.num_outputs(); ++i) {
+      bytes += OutputBytes(node, i);
+    }
+    return bytes;
+  }
+
+  // Returns the properties that the cost estimator should assume for
+  // 'device'. Devices it does not model are treated as a single core.
+  const DeviceProperties& PropertiesForDevice(const Device& device) {
+    auto it = device_properties_.find(device.device_type());
+    if (it != device_properties_.end()) {
+      return it->second;
+    }
+    DeviceProperties properties =
+        grappler::GetDeviceInfo(device.parsed_name());
+    const bool known =
+        properties.num_cores() > 0 && properties.frequency() > 0 &&
+        (properties.type() == "CPU" ||
+         (properties.type() == "GPU" &&
+          properties.environment().count("architecture") > 0));
+    if (!known) {
+      properties.Clear();
+      properties.set_type("CPU");
+      properties.set_num_cores(1);
+      properties.set_frequency(1000);
+    }
+    return device_properties_.emplace(device.device_type(), properties)
+        .first->second;
+  }
+
+  Graph* const graph_;                       // Not owned.
+  const DeviceSet* const device_set_;        // Not owned.
+  ColocationGraph* const colocation_graph_;  // Not owned.
+  ShapeRefiner refiner_;
+  grappler::OpLevelCostEstimator estimator_;
+  std::unordered_map<string, DeviceProperties> device_properties_;
+  // The device of each node placed so far and the time it is expected to
+  // finish, indexed by node id.
+  std::vector<const Device*> node_devices_;
+  std::vector<double> node_finish_ns_;
+  // The time each device is expected to become free, and the memory of the
+  // outputs of the nodes placed on it.
+  std::unordered_map<const Device*, double> device_ready_ns_;
+  std::unordered_map<const Device*, int64> memory_bytes_;
+  std::unordered_map<int, const Device*> group_devices_;
+};
+
+constexpr double CostBalancedAssignment::kTransferBytesPerNs;
+
+// Returns the device that 'assignment', if any, chose for the colocation
+// group whose root is 'root', or else the first of 'devices'.
+const Device* DefaultDevice(const CostBalancedAssignment* assignment, int root,
+                            const std::vector<Device*>& devices) {
+  if (assignment != nullptr) {
+    const Device* device = assignment->DeviceForGroup(root);
+    if (device != nullptr &&
+        std::find(devices.begin(), devices.end(), device) != devices.end()) {
+      return device;
+    }
+  }
+  return devices[0];
+}
+
 }  // namespace
 
 SimplePlacer::SimplePlacer(Graph* graph, const DeviceSet* devices,
@@ -732,6 +1027,17 @@ Status SimplePlacer::Run() {
     }
   }
 
+  // If requested, choose the devices of the colocation groups by their
+  // estimated costs, to be used instead of the first possible device.
+  std::unique_ptr<CostBalancedAssignment> cost_balanced_assignment;
+  if (options_ != nullptr &&
+      options_->config.graph_options().placement_strategy() ==
+          GraphOptions::COST_BALANCED_PLACEMENT) {
+    cost_balanced_assignment.reset(
+        new CostBalancedAssignment(graph_, devices_, &colocation_graph));
+    cost_balanced_assignment->Run();
+  }
+
   // 3. For each node, assign a device based on the constraints in the
   // disjoint node set.
   std::vector<Node*> second_pass;
@@ -793,7 +1099,10 @@ Status SimplePlacer::Run() {
 
     // Provide the default, if necessary.
     if (assigned_device == -1) {
-      assigned_device = graph_->InternDeviceName((*devices)[0]->name());
+      assigned_device = graph_->InternDeviceName(
+          DefaultDevice(cost_balanced_assignment.get(),
+                        colocation_graph.FindRoot(node->id()), *devices)
+              ->name());
     }
 
     AssignAndLog(assigned_device, node);
@@ -832,7 +1141,10 @@ Status SimplePlacer::Run() {
 
     // Provide the default, if necessary.
     if (assigned_device == -1) {
-      assigned_device = graph_->InternDeviceName((*devices)[0]->name());
+      assigned_device = graph_->InternDeviceName(
+          DefaultDevice(cost_balanced_assignment.get(),
+                        colocation_graph.FindRoot(node->id()), *devices)
+              ->name());
     }
 
     AssignAndLog(assigned_device, node);
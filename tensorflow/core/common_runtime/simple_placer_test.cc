@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_def_builder.h"
@@ -162,6 +163,24 @@ REGISTER_KERNEL_BUILDER(Name("TestDeviceEnforce").Device("FakeGPU"), DummyOp);
 REGISTER_KERNEL_BUILDER(Name("Shape").Device("FakeCPU"), DummyOp);
 REGISTER_KERNEL_BUILDER(Name("Shape").Device("FakeGPU"), DummyOp);
 
+// Ops with shape functions, so that the cost-balanced placement can
+// estimate their costs.
+REGISTER_OP("TestLargeOutput")
+    .Output("o: float")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      c->set_output(0, c->Matrix(1000, 1000));
+      return Status::OK();
+    });
+REGISTER_KERNEL_BUILDER(Name("TestLargeOutput").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("TestLargeOutput").Device("FakeGPU"), DummyOp);
+
+REGISTER_OP("TestShapedRelu")
+    .Input("i: float")
+    .Output("o: float")
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(Name("TestShapedRelu").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("TestShapedRelu").Device("FakeGPU"), DummyOp);
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // A SimplePlacerTest method has three phases:
@@ -1281,5 +1300,60 @@ TEST_F(SimplePlacerTest, TestGeneratorNodeDoesntFollowNonColocatedConsumers) {
   EXPECT_DEVICE_TYPE(g, "in", "FakeGPU");
 }
 
+// Test that the cost-balanced placement spreads independent towers over
+// the devices, and keeps each tower on one device.
+TEST_F(SimplePlacerTest, TestCostBalancedPlacementSpreadsTowers) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    for (const string& tower : {"a", "b"}) {
+      Node* input = ops::SourceOp(
+          "TestLargeOutput", b.opts().WithName(strings::StrCat("in_", tower)));
+      Node* relu1 =
+          ops::UnaryOp("TestShapedRelu", input,
+                       b.opts().WithName(strings::StrCat("relu1_", tower)));
+      ops::UnaryOp("TestShapedRelu", relu1,
+                   b.opts().WithName(strings::StrCat("relu2_", tower)));
+    }
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_placement_strategy(
+      GraphOptions::COST_BALANCED_PLACEMENT);
+  TF_EXPECT_OK(Place(&g, &options));
+  EXPECT_DEVICE_TYPE(g, "relu1_a", "FakeGPU");
+  EXPECT_DEVICE_TYPE(g, "relu1_b", "FakeGPU");
+  EXPECT_NOT_COLOCATED(g, "relu1_a", "relu1_b");
+  EXPECT_COLOCATED(g, "in_a", "relu1_a");
+  EXPECT_COLOCATED(g, "relu1_a", "relu2_a");
+  EXPECT_COLOCATED(g, "in_b", "relu1_b");
+  EXPECT_COLOCATED(g, "relu1_b", "relu2_b");
+}
+
+// Test that the cost-balanced placement respects colocation groups.
+TEST_F(SimplePlacerTest, TestCostBalancedPlacementRespectsColocation) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input_a =
+        ops::SourceOp("TestLargeOutput", b.opts().WithName("in_a"));
+    Node* input_b =
+        ops::SourceOp("TestLargeOutput", b.opts().WithName("in_b"));
+    ops::UnaryOp("TestShapedRelu", input_a, b.opts().WithName("relu_a"));
+    ops::UnaryOp(
+        "TestShapedRelu", input_b,
+        b.opts().WithName("relu_b").WithAttr("_class", {"loc:@relu_a"}));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  SessionOptions options;
+  options.config.mutable_graph_options()->set_placement_strategy(
+      GraphOptions::COST_BALANCED_PLACEMENT);
+  TF_EXPECT_OK(Place(&g, &options));
+  EXPECT_DEVICE_TYPE(g, "relu_a", "FakeGPU");
+  EXPECT_COLOCATED(g, "relu_a", "relu_b");
+}
+
 }  // namespace
 }  // namespace tensorflow
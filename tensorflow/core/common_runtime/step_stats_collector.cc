@@ -14,17 +14,43 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+
+#include <algorithm>
+#include <thread>
+
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/scanner.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
+constexpr int StepStatsCollector::kNumSampledRings;
+constexpr uint64 StepStatsCollector::kSampledRingSize;
+
 StepStatsCollector::StepStatsCollector(StepStats* ss) : step_stats_(ss) {}
 
+StepStatsCollector::StepStatsCollector(StepStats* ss,
+                                       double node_sampling_rate)
+    : step_stats_(ss), sampled_(true) {
+  // ShouldTrace() compares the low 32 bits of a hash to the threshold.
+  sampling_threshold_ = static_cast<uint64>(
+      std::max(0.0, std::min(1.0, node_sampling_rate)) * (1ull << 32));
+}
+
+StepStatsCollector::~StepStatsCollector() { Finalize(); }
+
+bool StepStatsCollector::ShouldTrace(int64 step_id, int node_id) const {
+  const int64 key[2] = {step_id, node_id};
+  const uint64 hash = Hash64(reinterpret_cast<const char*>(key), sizeof(key));
+  return (hash & 0xffffffff) < sampling_threshold_;
+}
+
 static int ExtractGpuWithStreamAll(string device_name) {
   // Check if the device name matches the ".*gpu:(\\d+)/stream:all$" regexp,
   // and if it does return the stream index (always positive). If it doesn't
@@ -88,6 +114,7 @@ static int ExtractGpuWithoutStream(string device_name) {
 void StepStatsCollector::BuildCostModel(
     CostModelManager* cost_model_manager,
     const std::unordered_map<string, const Graph*>& device_map) {
+  Finalize();
   mutex_lock lock(mu_);
 
   // Hardware stats for gpu are available under a fake device named
@@ -234,7 +261,55 @@ void StepStatsCollector::Save(const string& device, NodeExecStats* nt) {
   delete nt;
 }
 
+void StepStatsCollector::SaveSampled(const string* device, const Node* node,
+                                     NodeExecStats* nt) {
+  const size_t thread_hash = std::hash<std::thread::id>()(
+      std::this_thread::get_id());
+  SampledRing& ring = sampled_rings_[thread_hash % kNumSampledRings];
+  NodeExecStats* dropped = nullptr;
+  {
+    mutex_lock l(ring.mu);
+    if (ring.records.size() < kSampledRingSize) {
+      ring.records.push_back({device, node, nt});
+    } else {
+      SampledRecord& oldest = ring.records[ring.next % kSampledRingSize];
+      dropped = oldest.stats;
+      oldest = {device, node, nt};
+    }
+    ++ring.next;
+  }
+  delete dropped;
+}
+
+void StepStatsCollector::Finalize() {
+  if (!sampled_) return;
+  for (SampledRing& ring : sampled_rings_) {
+    std::vector<SampledRecord> records;
+    uint64 next;
+    {
+      mutex_lock l(ring.mu);
+      records.swap(ring.records);
+      next = ring.next;
+      ring.next = 0;
+    }
+    // Once the ring has wrapped around, its oldest record is at "next".
+    const size_t first = records.size() < kSampledRingSize
+                             ? 0
+                             : next % kSampledRingSize;
+    for (size_t i = 0; i < records.size(); ++i) {
+      const SampledRecord& r = records[(first + i) % records.size()];
+      const Node* node = r.node;
+      r.stats->set_node_name(node->name());
+      r.stats->set_timeline_label(strings::StrCat(
+          node->name(), " = ", node->type_string(), "(",
+          str_util::Join(node->requested_inputs(), ", "), ")"));
+      Save(*r.device, r.stats);
+    }
+  }
+}
+
 void StepStatsCollector::Swap(StepStats* ss) {
+  Finalize();
   mutex_lock l(mu_);
   CHECK(step_stats_);
   ss->Swap(step_stats_);
@@ -16,6 +16,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STEP_STATS_COLLECTOR_H_
 
 #include <unordered_map>
+#include <vector>
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
@@ -24,6 +26,7 @@ namespace tensorflow {
 
 class CostModelManager;
 class Graph;
+class Node;
 class NodeExecStats;
 class StepStats;
 
@@ -34,6 +37,22 @@ class StepStatsCollector {
  public:
   explicit StepStatsCollector(StepStats* ss);
 
+  // Creates a collector for a sampled trace, cheap enough to leave on in
+  // production. The executor traces only a "node_sampling_rate" fraction of
+  // the nodes of a step, without tracking their allocations or outputs, and
+  // hands their stats to SaveSampled() rather than Save().
+  StepStatsCollector(StepStats* ss, double node_sampling_rate);
+
+  ~StepStatsCollector();
+
+  // True if this collector was created for a sampled trace.
+  bool sampled() const { return sampled_; }
+
+  // Whether node "node_id" should be traced in step "step_id". The choice
+  // is a hash of both ids, so it is stable within a step and spreads over
+  // all the nodes across steps.
+  bool ShouldTrace(int64 step_id, int node_id) const;
+
   // BuildCostModel builds or updates a CostModel managed by cost_model_manager,
   // using the currently collected DeviceStats associated with the devices in
   // device_map.
@@ -44,16 +63,53 @@ class StepStatsCollector {
   // Save saves nt to the DeviceStats object associated with device.
   void Save(const string& device, NodeExecStats* nt);
 
+  // SaveSampled saves nt, the stats of "node" run on "device", without
+  // taking the collector-wide lock or building any strings: the record goes
+  // into a ring buffer of the calling thread, and its node name and
+  // timeline label are only filled in by Finalize(). When a ring buffer is
+  // full, its oldest record is dropped. "device" and "node" must outlive
+  // the next call to Finalize().
+  void SaveSampled(const string* device, const Node* node, NodeExecStats* nt);
+
+  // Finalize moves the records saved by SaveSampled() into the step stats.
+  // BuildCostModel(), Swap() and the destructor call it, so it only needs
+  // to be called before reading the step stats directly.
+  void Finalize();
+
   // Swap replaces the current step stats with ss.
   void Swap(StepStats* ss);
 
  private:
+  struct SampledRecord {
+    const string* device;
+    const Node* node;
+    NodeExecStats* stats;
+  };
+
+  // A ring buffer of sampled records, shared by the threads that hash to it.
+  struct SampledRing {
+    mutex mu;
+    std::vector<SampledRecord> records GUARDED_BY(mu);
+    uint64 next GUARDED_BY(mu) = 0;
+  };
+
+  static constexpr int kNumSampledRings = 16;
+  static constexpr uint64 kSampledRingSize = 1 << 14;
+
+
   // TODO(suharshs): Make this configurable if its not possible to find a value
   //                 that works for all cases.
   const uint64 kMaxCollectedNodes = 1 << 20;
   mutex mu_;
   StepStats* step_stats_ GUARDED_BY(mu_);
   uint64 collectedNodes GUARDED_BY(mu_) = 0;
+
+  const bool sampled_ = false;
+  // ShouldTrace() is true for hashes below this threshold.
+  uint64 sampling_threshold_ = 0;
+  SampledRing sampled_rings_[kNumSampledRings];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepStatsCollector);
 };
 
 }  // namespace tensorflow
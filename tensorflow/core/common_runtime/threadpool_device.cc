@@ -42,6 +42,16 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                name, DEVICE_CPU, memory_limit, locality)),
       allocator_(allocator) {}
 
+ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
+                                   const string& name, Bytes memory_limit,
+                                   const DeviceLocality& locality,
+                                   Allocator* allocator, int numa_node)
+    : LocalDevice(options,
+                  Device::BuildDeviceAttributes(name, DEVICE_CPU, memory_limit,
+                                                locality),
+                  numa_node),
+      allocator_(allocator) {}
+
 ThreadPoolDevice::~ThreadPoolDevice() {}
 
 void ThreadPoolDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
@@ -27,6 +27,12 @@ class ThreadPoolDevice : public LocalDevice {
   ThreadPoolDevice(const SessionOptions& options, const string& name,
                    Bytes memory_limit, const DeviceLocality& locality,
                    Allocator* allocator);
+
+  // Like above, but the device computes on threads pinned to NUMA node
+  // "numa_node". "allocator" should place its memory on the same node.
+  ThreadPoolDevice(const SessionOptions& options, const string& name,
+                   Bytes memory_limit, const DeviceLocality& locality,
+                   Allocator* allocator, int numa_node);
   ~ThreadPoolDevice() override;
 
   void Compute(OpKernel* op_kernel, OpKernelContext* context) override;
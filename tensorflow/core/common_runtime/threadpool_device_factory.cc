@@ -16,9 +16,11 @@ limitations under the License.
 // Register a factory that provides CPU devices.
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
+#include <algorithm>
 #include <vector>
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -28,13 +30,30 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    // TODO(zhifengc/tucker): Figure out the number of available CPUs
-    // and/or NUMA configuration.
+    // TODO(zhifengc/tucker): Figure out the number of available CPUs.
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
+    const int num_numa_nodes = port::NUMANumNodes();
+    if (options.config.use_numa_affinity() && num_numa_nodes > 1) {
+      // One device per NUMA node, each computing on threads pinned to its
+      // node and allocating from the node's memory. The devices are spread
+      // round robin over the nodes if more were asked for than there are
+      // nodes.
+      n = std::max(n, num_numa_nodes);
+      for (int i = 0; i < n; i++) {
+        const int numa_node = i % num_numa_nodes;
+        string name = strings::StrCat(name_prefix, "/cpu:", i);
+        DeviceLocality locality;
+        locality.set_bus_id(numa_node + 1);
+        devices->push_back(new ThreadPoolDevice(
+            options, name, Bytes(256 << 20), locality,
+            cpu_allocator(numa_node), numa_node));
+      }
+      return Status::OK();
+    }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/cpu:", i);
       devices->push_back(new ThreadPoolDevice(
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/debug/debug_io_utils.h"
 
+#include <algorithm>
 #include <vector>
 
 #if defined(PLATFORM_GOOGLE)
@@ -307,6 +308,35 @@ Status DebugIO::PublishDebugTensor(const DebugNodeKey& debug_node_key,
                                    const uint64 wall_time_us,
                                    const gtl::ArraySlice<string>& debug_urls,
                                    const bool gated_grpc) {
+  {
+    mutex_lock l(async_publishers_mu);
+    if (GetAsyncPublishers()->empty()) {
+      return PublishDebugTensorSync(debug_node_key, tensor, wall_time_us,
+                                    debug_urls, gated_grpc);
+    }
+  }
+
+  std::vector<string> sync_urls;
+  for (const string& url : debug_urls) {
+    std::shared_ptr<AsyncDebugPublisher> publisher = GetAsyncPublisher(url);
+    if (publisher != nullptr) {
+      publisher->Publish(debug_node_key, tensor, wall_time_us, gated_grpc);
+    } else {
+      sync_urls.push_back(url);
+    }
+  }
+  if (sync_urls.empty()) {
+    return Status::OK();
+  }
+  return PublishDebugTensorSync(debug_node_key, tensor, wall_time_us,
+                                sync_urls, gated_grpc);
+}
+
+// static
+Status DebugIO::PublishDebugTensorSync(
+    const DebugNodeKey& debug_node_key, const Tensor& tensor,
+    const uint64 wall_time_us, const gtl::ArraySlice<string>& debug_urls,
+    const bool gated_grpc) {
   int32 num_failed_urls = 0;
   std::vector<Status> fail_statuses;
   for (const string& url : debug_urls) {
@@ -455,17 +485,171 @@ bool DebugIO::IsDebugURLGateOpen(const string& watch_key,
 #endif
 }
 
+// static
+mutex DebugIO::async_publishers_mu;
+
+// static
+std::unordered_map<string, std::shared_ptr<AsyncDebugPublisher>>*
+DebugIO::GetAsyncPublishers() {
+  static std::unordered_map<string, std::shared_ptr<AsyncDebugPublisher>>*
+      async_publishers =
+          new std::unordered_map<string, std::shared_ptr<AsyncDebugPublisher>>;
+  return async_publishers;
+}
+
+// static
+std::shared_ptr<AsyncDebugPublisher> DebugIO::GetAsyncPublisher(
+    const string& debug_url) {
+  mutex_lock l(async_publishers_mu);
+  auto it = GetAsyncPublishers()->find(debug_url);
+  return it == GetAsyncPublishers()->end() ? nullptr : it->second;
+}
+
+// static
+void DebugIO::EnableAsyncPublishing(const string& debug_url,
+                                    const int64 queue_capacity,
+                                    const bool drop_when_full) {
+  mutex_lock l(async_publishers_mu);
+  std::shared_ptr<AsyncDebugPublisher>& publisher =
+      (*GetAsyncPublishers())[debug_url];
+  if (publisher == nullptr) {
+    publisher.reset(
+        new AsyncDebugPublisher(debug_url, queue_capacity, drop_when_full));
+  }
+}
+
 // static
 Status DebugIO::CloseDebugURL(const string& debug_url) {
+  Status status;
+  std::shared_ptr<AsyncDebugPublisher> publisher;
+  {
+    mutex_lock l(async_publishers_mu);
+    auto it = GetAsyncPublishers()->find(debug_url);
+    if (it != GetAsyncPublishers()->end()) {
+      publisher = std::move(it->second);
+      GetAsyncPublishers()->erase(it);
+    }
+  }
+  if (publisher != nullptr) {
+    // Debug ops that looked the publisher up before it was removed may still
+    // hold a reference to it, and their tensors are published when the last
+    // reference goes away.
+    status.Update(publisher->Flush());
+  }
+
   if (debug_url.find(DebugIO::kGrpcURLScheme) == 0) {
 #if defined(PLATFORM_GOOGLE)
-    return DebugGrpcIO::CloseGrpcStream(debug_url);
+    status.Update(DebugGrpcIO::CloseGrpcStream(debug_url));
 #else
     GRPC_OSS_UNIMPLEMENTED_ERROR;
 #endif
-  } else {
-    // No-op for non-gRPC URLs.
-    return Status::OK();
+  }
+  // No-op for non-gRPC URLs.
+  return status;
+}
+
+AsyncDebugPublisher::AsyncDebugPublisher(const string& debug_url,
+                                         const int64 queue_capacity,
+                                         const bool drop_when_full)
+    : debug_url_(debug_url),
+      queue_capacity_(std::max<int64>(queue_capacity, 1)),
+      drop_when_full_(drop_when_full) {
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "tfdbg_publisher", [this]() { PublishLoop(); }));
+}
+
+AsyncDebugPublisher::~AsyncDebugPublisher() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+  }
+  cond_var_.notify_all();
+  // Joins the thread, which returns once the queue is empty.
+  thread_.reset();
+  Status s = Flush();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to publish debug tensors to " << debug_url_ << ": "
+               << s.error_message();
+  }
+}
+
+void AsyncDebugPublisher::Publish(const DebugNodeKey& debug_node_key,
+                                  const Tensor& tensor,
+                                  const uint64 wall_time_us,
+                                  const bool gated_grpc) {
+  // Check the gRPC gating now, so that gated-off tensors take no room in the
+  // queue.
+  if (gated_grpc &&
+      !DebugIO::IsDebugURLGateOpen(debug_node_key.debug_node_name,
+                                   debug_url_)) {
+    return;
+  }
+  {
+    mutex_lock l(mu_);
+    while (static_cast<int64>(queue_.size()) >= queue_capacity_) {
+      if (drop_when_full_) {
+        ++num_dropped_;
+        return;
+      }
+      cond_var_.wait(l);
+    }
+    queue_.push_back({debug_node_key, tensor, wall_time_us, gated_grpc});
+  }
+  cond_var_.notify_all();
+}
+
+Status AsyncDebugPublisher::Flush() {
+  mutex_lock l(mu_);
+  while (!queue_.empty() || publishing_) {
+    cond_var_.wait(l);
+  }
+  if (num_dropped_ > 0) {
+    LOG(WARNING) << "Dropped " << num_dropped_ << " debug tensors for "
+                 << debug_url_ << " because its publishing queue was full.";
+    num_dropped_ = 0;
+  }
+  Status s = status_;
+  status_ = Status::OK();
+  return s;
+}
+
+void AsyncDebugPublisher::PublishLoop() {
+  while (true) {
+    std::deque<PendingTensor> batch;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !stopping_) {
+        cond_var_.wait(l);
+      }
+      if (queue_.empty()) {
+        return;
+      }
+      batch.swap(queue_);
+      publishing_ = true;
+    }
+    // Wake up the debug ops waiting for room in the queue.
+    cond_var_.notify_all();
+
+    Status batch_status;
+    for (const PendingTensor& pending : batch) {
+      Status s = DebugIO::PublishDebugTensorSync(
+          pending.debug_node_key, pending.tensor, pending.wall_time_us,
+          {debug_url_}, pending.gated_grpc);
+      if (!s.ok()) {
+        LOG(ERROR) << "Debug node of watch key "
+                   << pending.debug_node_key.debug_node_name
+                   << " failed to publish debug tensor data to " << debug_url_
+                   << ", due to: " << s.error_message();
+        batch_status.Update(s);
+      }
+    }
+
+    {
+      mutex_lock l(mu_);
+      publishing_ = false;
+      status_.Update(batch_status);
+    }
+    cond_var_.notify_all();
   }
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_DEBUG_IO_UTILS_H_
 #define TENSORFLOW_DEBUG_IO_UTILS_H_
 
+#include <deque>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -24,6 +26,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/event.pb.h"
 
 namespace tensorflow {
@@ -54,6 +59,8 @@ struct DebugNodeKey {
   const string device_path;
 };
 
+class AsyncDebugPublisher;
+
 class DebugIO {
  public:
   static Status PublishDebugMetadata(
@@ -137,6 +144,21 @@ class DebugIO {
   static bool IsDebugURLGateOpen(const string& watch_key,
                                  const string& debug_url);
 
+  // Make PublishDebugTensor() hand the tensors for a debug URL to a
+  // background thread instead of publishing them in the calling debug op,
+  // until CloseDebugURL() is called on the URL.
+  //
+  // Args:
+  //   debug_url: The debug URL, e.g., "file:///tmp/tfdbg_1".
+  //   queue_capacity: The most tensors waiting to be published.
+  //   drop_when_full: Whether tensors published while the queue is full are
+  //     dropped, or wait for room in the queue.
+  static void EnableAsyncPublishing(const string& debug_url,
+                                    const int64 queue_capacity,
+                                    const bool drop_when_full);
+
+  // Close a debug URL. If the URL is published to asynchronously, wait for
+  // its pending tensors first, and return the first error publishing them.
   static Status CloseDebugURL(const string& debug_url);
 
   static const char* const kMetadataFilePrefix;
@@ -147,6 +169,80 @@ class DebugIO {
 
   static const char* const kFileURLScheme;
   static const char* const kGrpcURLScheme;
+
+ private:
+  // Publish a tensor to debug target URLs from the calling thread.
+  static Status PublishDebugTensorSync(
+      const DebugNodeKey& debug_node_key, const Tensor& tensor,
+      const uint64 wall_time_us, const gtl::ArraySlice<string>& debug_urls,
+      const bool gated_grpc);
+
+  // Returns the asynchronous publisher of a debug URL, or nullptr if the URL
+  // is published to synchronously.
+  static std::shared_ptr<AsyncDebugPublisher> GetAsyncPublisher(
+      const string& debug_url);
+
+  // Returns a global map from debug URLs to their asynchronous publishers.
+  static std::unordered_map<string, std::shared_ptr<AsyncDebugPublisher>>*
+  GetAsyncPublishers();
+
+  static mutex async_publishers_mu;
+
+  friend class AsyncDebugPublisher;
+};
+
+// Publishes the debug tensors of one debug URL from a background thread, so
+// that debug ops only pay for queueing a reference to their tensors. The
+// thread takes all the queued tensors at once and publishes them in a batch,
+// which lets the queue refill while it writes.
+//
+// Thread-safety: Publish() and Flush() may be called concurrently.
+class AsyncDebugPublisher {
+ public:
+  AsyncDebugPublisher(const string& debug_url, const int64 queue_capacity,
+                      const bool drop_when_full);
+
+  // Publishes the pending tensors, then stops the background thread.
+  ~AsyncDebugPublisher();
+
+  // Queue a tensor for publishing. Blocks while the queue is full, unless
+  // the publisher drops tensors in that case.
+  void Publish(const DebugNodeKey& debug_node_key, const Tensor& tensor,
+               const uint64 wall_time_us, const bool gated_grpc);
+
+  // Wait until all queued tensors are published. Returns the first error
+  // publishing them since the previous call.
+  Status Flush();
+
+ private:
+  struct PendingTensor {
+    DebugNodeKey debug_node_key;
+    Tensor tensor;
+    uint64 wall_time_us;
+    bool gated_grpc;
+  };
+
+  // Body of the background thread.
+  void PublishLoop();
+
+  const string debug_url_;
+  const int64 queue_capacity_;
+  const bool drop_when_full_;
+
+  mutex mu_;
+  // Signaled when tensors are queued, when the queue is emptied, and when a
+  // batch is published.
+  condition_variable cond_var_;
+  std::deque<PendingTensor> queue_ GUARDED_BY(mu_);
+  // Whether the background thread is publishing a batch.
+  bool publishing_ GUARDED_BY(mu_) = false;
+  bool stopping_ GUARDED_BY(mu_) = false;
+  int64 num_dropped_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncDebugPublisher);
 };
 
 // Helper class for debug ops.
@@ -273,6 +273,48 @@ TEST_F(DebugIOUtilsTest, PublishTensorToMultipleFileURLs) {
   }
 }
 
+TEST_F(DebugIOUtilsTest, PublishTensorsAsynchronously) {
+  Initialize();
+
+  const int kNumTensors = 4;
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "foo/tensor_a", 0, "DebugIdentity");
+  const string dump_root = strings::StrCat(testing::TmpDir(), "/async");
+  const string url = strings::StrCat("file://", dump_root);
+  const uint64 wall_time = env_->NowMicros();
+
+  // With room for a single tensor, publishing waits for the background
+  // thread.
+  DebugIO::EnableAsyncPublishing(url, 1, false);
+  std::vector<string> dump_file_paths;
+  for (int i = 0; i < kNumTensors; ++i) {
+    dump_file_paths.push_back(
+        DebugFileIO::GetDumpFilePath(dump_root, kDebugNodeKey, wall_time + i));
+    TF_ASSERT_OK(DebugIO::PublishDebugTensor(kDebugNodeKey, *tensor_a_,
+                                             wall_time + i, {url}));
+  }
+  // Closing the URL waits for the pending tensors.
+  TF_ASSERT_OK(DebugIO::CloseDebugURL(url));
+
+  for (int i = 0; i < kNumTensors; ++i) {
+    Event event;
+    TF_ASSERT_OK(ReadEventFromFile(dump_file_paths[i], &event));
+    ASSERT_EQ(static_cast<double>(wall_time + i), event.wall_time());
+    ASSERT_EQ(kDebugNodeKey.debug_node_name,
+              event.summary().value(0).node_name());
+    Tensor a_prime(DT_FLOAT);
+    ASSERT_TRUE(a_prime.FromProto(event.summary().value(0).tensor()));
+    test::ExpectTensorEqual<float>(*tensor_a_, a_prime);
+  }
+
+  int64 undeleted_files = 0;
+  int64 undeleted_dirs = 0;
+  TF_ASSERT_OK(
+      env_->DeleteRecursively(dump_root, &undeleted_files, &undeleted_dirs));
+  ASSERT_EQ(0, undeleted_files);
+  ASSERT_EQ(0, undeleted_dirs);
+}
+
 TEST_F(DebugIOUtilsTest, PublishTensorConcurrentlyToPartiallyOverlappingPaths) {
   Initialize();
 
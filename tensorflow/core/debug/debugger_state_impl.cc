@@ -27,10 +27,18 @@ DebuggerState::DebuggerState(const DebugOptions& debug_options) {
       debug_urls_.insert(url);
     }
   }
+  if (debug_options.publish_queue_capacity() > 0) {
+    for (const string& debug_url : debug_urls_) {
+      DebugIO::EnableAsyncPublishing(
+          debug_url, debug_options.publish_queue_capacity(),
+          debug_options.drop_tensors_when_queue_full());
+    }
+  }
 }
 
 DebuggerState::~DebuggerState() {
   for (const string& debug_url : debug_urls_) {
+    // Failures to publish asynchronously are logged as they happen.
     DebugIO::CloseDebugURL(debug_url).IgnoreError();
   }
 }
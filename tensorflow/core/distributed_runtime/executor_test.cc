@@ -81,6 +81,16 @@ class ExecutorTest : public ::testing::Test {
     return exec_->Run(args);
   }
 
+  Status RunWorkStealing(Rendezvous* rendez, int num_workers,
+                         WorkStealingStats* stats) {
+    Executor::Args args;
+    args.rendezvous = rendez;
+    args.runner = runner_;
+    args.work_stealing_workers = num_workers;
+    args.work_stealing_stats = stats;
+    return exec_->Run(args);
+  }
+
   thread::ThreadPool* thread_pool_ = nullptr;
   Device* device_ = nullptr;
   Executor* exec_ = nullptr;
@@ -242,6 +252,52 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g);
+  WorkStealingStats stats;
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(RunWorkStealing(rendez, 4, &stats));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+  // Every ready expensive node that is not run inline goes through a deque.
+  EXPECT_GT(stats.workers_started.load(), 0);
+  EXPECT_GT(stats.local_hits.load() + stats.steals.load(), 0);
+}
+
+TEST_F(ExecutorTest, SelfAddWorkStealingSingleWorker) {
+  Graph* g = new Graph(OpRegistry::Global());
+  auto v = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g, v, v);
+  }
+  test::graph::Send(g, v, "b", BOB, 1, ALICE);
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  WorkStealingStats stats;
+  TF_ASSERT_OK(RunWorkStealing(rendez_, 1, &stats));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+  // A single worker never has anybody to steal from.
+  EXPECT_EQ(0, stats.steals.load());
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -409,4 +465,24 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// "width" independent chains of "depth" scalar additions. The additions are
+// cheap, but their kernels are marked expensive, as most kernels are, so
+// the executor only runs them inline once it has measured them.
+static void BM_CheapKernels(int iters, int width, int depth) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  for (int i = 0; i < width; ++i) {
+    Node* v = test::graph::Constant(g, one);
+    for (int j = 0; j < depth; ++j) {
+      v = test::graph::Add(g, v, v);
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * width * depth);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_CheapKernels)->ArgPair(1, 256)->ArgPair(16, 16)->ArgPair(256, 1);
+
 }  // namespace tensorflow
@@ -283,6 +283,33 @@ Status GraphMgr::Register(const string& session, const GraphDef& gdef,
   return Status::OK();
 }
 
+Status GraphMgr::SetStepTemplate(const string& handle,
+                                 const std::vector<string>& send_keys,
+                                 const std::vector<string>& recv_keys) {
+  mutex_lock l(mu_);
+  auto iter = table_.find(handle);
+  if (iter == table_.end()) {
+    return errors::Aborted("Graph handle is not found: ", handle);
+  }
+  iter->second->send_keys = send_keys;
+  iter->second->recv_keys = recv_keys;
+  return Status::OK();
+}
+
+Status GraphMgr::GetStepTemplate(const string& handle,
+                                 std::vector<string>* send_keys,
+                                 std::vector<string>* recv_keys) {
+  mutex_lock l(mu_);
+  auto iter = table_.find(handle);
+  if (iter == table_.end()) {
+    return errors::Aborted("Graph handle is not found: ", handle,
+                           ". Possibly, this worker just restarted.");
+  }
+  *send_keys = iter->second->send_keys;
+  *recv_keys = iter->second->recv_keys;
+  return Status::OK();
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
   // Removes one item from table_.
@@ -72,6 +72,16 @@ class GraphMgr {
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, string* handle);
 
+  // Sets the step template of graph "handle": the keys of the tensors that
+  // are fed to and fetched from it on every step.
+  Status SetStepTemplate(const string& handle,
+                         const std::vector<string>& send_keys,
+                         const std::vector<string>& recv_keys);
+
+  // Returns the step template of graph "handle".
+  Status GetStepTemplate(const string& handle, std::vector<string>* send_keys,
+                         std::vector<string>* recv_keys);
+
   // Executes one step of a registered graph "handle".
   //
   // If "out" is not nullptr, "out" specifies all keys the execution
@@ -129,6 +139,11 @@ class GraphMgr {
     // Used to deresgister a cost model when cost model is required in graph
     // manager.
     GraphMgr* graph_mgr;
+
+    // The step template: the keys of the tensors fed and fetched on every
+    // step. Guarded by the GraphMgr's mu_.
+    std::vector<string> send_keys;
+    std::vector<string> recv_keys;
   };
 
   const WorkerEnv* worker_env_;             // Not owned.
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/master_session.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/tensor_id.h"
@@ -71,6 +73,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         client_graph_(std::move(cg)),
         session_opts_(session_opts),
         is_partial_(is_partial),
+        register_step_templates_(
+            !is_partial &&
+            session_opts.config.rpc_options().register_step_templates()),
         debug_opts_(bopts.debug_options),
         worker_cache_(worker_cache) {
     VLOG(1) << "Created ReffedClientGraph for node with "
@@ -207,6 +212,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const std::unique_ptr<SimpleClientGraph> client_graph_;
   const SessionOptions session_opts_;
   const bool is_partial_;
+  // If true, the keys of the feeds and fetches of each partition are
+  // registered with its graph, and RunGraph requests leave them out.
+  const bool register_step_templates_;
   const DebugOptions& debug_opts_;
   WorkerCacheInterface* const worker_cache_;  // Not owned.
   std::unordered_map<StringPiece, Node*, StringPiece::Hasher> name_to_node_;
@@ -217,6 +225,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     string name;
 
     // Maps feed names to rendezvous keys. Empty most of the time.
+    //
+    // Since the maps aren't modified after registration, iterating over them
+    // visits the keys in the order in which they are registered as the step
+    // template of the partition.
     std::unordered_map<string, string> feed_key;
 
     // Maps rendezvous keys to fetch names. Empty most of the time.
@@ -248,6 +260,12 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // init_result_ remembers the initialization error if any.
   Status init_result_ GUARDED_BY(mu_);
 
+  // For partial runs: the feeds that each fetch depends on, found by
+  // CheckFetches() the first time the fetch is requested and reused by all
+  // the partial runs of this graph.
+  std::unordered_map<string, std::vector<std::pair<string, int>>>
+      fetch_feed_deps_ GUARDED_BY(mu_);
+
   std::unique_ptr<StatsPublisherInterface> stats_publisher_;
 
   // Send/Recv nodes that are the result of client-added
@@ -358,7 +376,7 @@ void MasterSession::ReffedClientGraph::TrackFeedsAndFetches(
 Status MasterSession::ReffedClientGraph::DoBuildPartitions(
     PartitionOptions popts,
     std::unordered_map<string, GraphDef>* out_partitions) {
-  if (popts.need_to_record_start_times) {
+  if (popts.need_to_record_start_times || popts.record_recv_priorities) {
     CostModel cost_model(true);
     cost_model.InitFromGraph(client_graph()->graph);
     // TODO(yuanbyu): Use the real cost model.
@@ -410,6 +428,14 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     *c->req.mutable_graph_def()->mutable_library() = func_def_lib;
     *c->req.mutable_graph_options() = session_opts_.config.graph_options();
     *c->req.mutable_debug_options() = debug_opts_;
+    if (register_step_templates_) {
+      for (const auto& feed_key : part.feed_key) {
+        c->req.add_send_key(feed_key.second);
+      }
+      for (const auto& key_fetch : part.key_fetch) {
+        c->req.add_recv_key(key_fetch.first);
+      }
+    }
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
     auto cb = [c, &done](const Status& s) {
       c->status = s;
@@ -438,12 +464,15 @@ class RunManyGraphs {
     CallOptions opts;
     std::unique_ptr<MutableRunGraphRequestWrapper> req;
     std::unique_ptr<MutableRunGraphResponseWrapper> resp;
+    // When the master saw the call finish.
+    int64 done_micros = 0;
   };
   Call* get(int index) { return &calls_[index]; }
 
   // When the index-th call is done, updates the overall status.
   void WhenDone(int index, const Status& s) {
     TRACEPRINTF("Partition %d %s", index, s.ToString().c_str());
+    calls_[index].done_micros = Env::Default()->NowMicros();
     if (!s.ok()) {
       mutex_lock l(mu_);
       UpdateStatusLocked(s);
@@ -482,6 +511,44 @@ class RunManyGraphs {
   TF_DISALLOW_COPY_AND_ASSIGN(RunManyGraphs);
 };
 
+namespace {
+
+// Moves the times in "ss", which a worker recorded with its own clock
+// during a RunGraph call that the master issued at "issue_micros" and saw
+// finish at "done_micros", onto the master's clock.  The clocks of
+// different machines are not synchronized, so the offset between them is
+// estimated as the smallest shift that places all of the worker's
+// activity within the call, as it must have happened.  Activity that fits
+// already is left as it is.
+void AlignWorkerClock(int64 issue_micros, int64 done_micros, StepStats* ss) {
+  int64 min_start = kint64max;
+  int64 max_end = kint64min;
+  for (const DeviceStepStats& ds : ss->dev_stats()) {
+    for (const NodeExecStats& ns : ds.node_stats()) {
+      min_start = std::min(min_start, ns.all_start_micros());
+      max_end =
+          std::max(max_end, ns.all_start_micros() + ns.all_end_rel_micros());
+    }
+  }
+  if (min_start > max_end) return;  // No activity.
+  // The worker's clock minus the master's.
+  int64 offset = 0;
+  if (min_start < issue_micros) {
+    offset = min_start - issue_micros;
+  } else if (max_end > done_micros) {
+    offset = std::min(max_end - done_micros, min_start - issue_micros);
+  }
+  if (offset == 0) return;
+  VLOG(1) << "Shifting worker step stats by " << -offset << "us";
+  for (DeviceStepStats& ds : *ss->mutable_dev_stats()) {
+    for (NodeExecStats& ns : *ds.mutable_node_stats()) {
+      ns.set_all_start_micros(ns.all_start_micros() - offset);
+    }
+  }
+}
+
+}  // namespace
+
 Status MasterSession::ReffedClientGraph::RunPartitions(
     const MasterEnv* env, int64 step_id, int64 execution_count,
     PerStepState* pss, CallOptions* call_opts, const RunStepRequestWrapper& req,
@@ -567,6 +634,15 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
           }
         }
       }
+    } else if (register_step_templates_) {
+      // The worker knows the keys from the step template of the partition,
+      // so only the tensors are sent, in the order of the template.
+      c->req->set_use_registered_keys(true);
+      for (const auto& feed_key : part.feed_key) {
+        const int64 feed_index = feeds[feed_key.first];
+        TF_RETURN_IF_ERROR(
+            c->req->AddSendFromRunStepRequest(req, feed_index, ""));
+      }
     } else {
       for (const auto& feed_key : part.feed_key) {
         const string& feed = feed_key.first;
@@ -583,6 +659,7 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
   }
 
   // Issues RunGraph calls.
+  const int64 issue_micros = Env::Default()->NowMicros();
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     RunManyGraphs::Call* call = calls.get(i);
@@ -629,6 +706,8 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
       }
       if (pss->collect_timeline) {
         pss->step_stats[i].Swap(calls.get(i)->resp->mutable_step_stats());
+        AlignWorkerClock(issue_micros, calls.get(i)->done_micros,
+                         &pss->step_stats[i]);
       }
       if (pss->collect_costs) {
         CostGraphDef* cost_graph = calls.get(i)->resp->mutable_cost_graph();
@@ -798,24 +877,24 @@ void MasterSession::ReffedClientGraph::ProcessDeviceStats(
 }
 
 // TODO(suharshs): Merge with CheckFetches in DirectSession.
-// TODO(suharsh,mrry): Build a map from fetch target to set of feeds it depends
-// on once at setup time to prevent us from computing the dependencies
-// everytime.
 // TODO(suharshs,mrry): Consider removing the need for execution_state to reduce
 // contention.
 Status MasterSession::ReffedClientGraph::CheckFetches(
     const RunStepRequestWrapper& req, const RunState* run_state,
     SimpleGraphExecutionState* execution_state) {
-  // Build the set of pending feeds that we haven't seen.
+  // Build the set of all the feeds of the partial run, and of the pending
+  // feeds that we haven't seen.
+  std::unordered_set<TensorId, TensorId::Hasher> all_feeds;
   std::unordered_set<TensorId, TensorId::Hasher> pending_feeds;
   for (const auto& input : run_state->pending_inputs) {
-    // Skip if already fed.
-    if (input.second) continue;
     TensorId id(ParseTensorName(input.first));
     auto it = name_to_node_.find(id.first);
     if (it == name_to_node_.end()) {
       return errors::NotFound("Feed ", input.first, ": not found");
     }
+    all_feeds.insert(id);
+    // Skip if already fed.
+    if (input.second) continue;
     pending_feeds.insert(id);
   }
   for (size_t i = 0; i < req.num_feeds(); ++i) {
@@ -823,38 +902,50 @@ Status MasterSession::ReffedClientGraph::CheckFetches(
     pending_feeds.erase(id);
   }
 
-  // Initialize the stack with the fetch nodes.
-  std::vector<const Node*> stack;
+  // Any feed needed for fetches can't be in pending_feeds. The feeds that
+  // a fetch depends on are found by walking the graph back from the fetch
+  // node only the first time, since the graph and the feeds are the same
+  // for every partial run of this graph.
+  // We need to use the original full graph from execution state.
+  const Graph* graph = execution_state->full_graph();
+  mutex_lock l(mu_);
   for (size_t i = 0; i < req.num_fetches(); ++i) {
     const string& fetch = req.fetch_name(i);
-    TensorId id(ParseTensorName(fetch));
-    auto it = name_to_node_.find(id.first);
-    if (it == name_to_node_.end()) {
-      return errors::NotFound("Fetch ", fetch, ": not found");
+    auto deps_it = fetch_feed_deps_.find(fetch);
+    if (deps_it == fetch_feed_deps_.end()) {
+      TensorId id(ParseTensorName(fetch));
+      auto it = name_to_node_.find(id.first);
+      if (it == name_to_node_.end()) {
+        return errors::NotFound("Fetch ", fetch, ": not found");
+      }
+      std::vector<std::pair<string, int>> deps;
+      std::vector<const Node*> stack = {it->second};
+      std::vector<bool> visited(graph->num_node_ids(), false);
+      while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+
+        for (const Edge* in_edge : n->in_edges()) {
+          const Node* in_node = in_edge->src();
+          if (all_feeds.count({in_node->name(), in_edge->src_output()}) > 0) {
+            deps.emplace_back(in_node->name(), in_edge->src_output());
+          }
+          if (!visited[in_node->id()]) {
+            visited[in_node->id()] = true;
+            stack.push_back(in_node);
+          }
+        }
+      }
+      std::sort(deps.begin(), deps.end());
+      deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+      deps_it = fetch_feed_deps_.emplace(fetch, std::move(deps)).first;
     }
-    stack.push_back(it->second);
-  }
-
-  // Any tensor needed for fetches can't be in pending_feeds.
-  // We need to use the original full graph from execution state.
-  const Graph* graph = execution_state->full_graph();
-  std::vector<bool> visited(graph->num_node_ids(), false);
-  while (!stack.empty()) {
-    const Node* n = stack.back();
-    stack.pop_back();
-
-    for (const Edge* in_edge : n->in_edges()) {
-      const Node* in_node = in_edge->src();
-      if (pending_feeds.count({in_node->name(), in_edge->src_output()}) > 0) {
-        return errors::InvalidArgument("Fetch ", in_node->name(), ":",
-                                       in_edge->src_output(),
+    for (const auto& dep : deps_it->second) {
+      if (pending_feeds.count({dep.first, dep.second}) > 0) {
+        return errors::InvalidArgument("Fetch ", dep.first, ":", dep.second,
                                        " can't be computed from the feeds"
                                        " that have been fed so far.");
       }
-      if (!visited[in_node->id()]) {
-        visited[in_node->id()] = true;
-        stack.push_back(in_node);
-      }
     }
   }
   return Status::OK();
@@ -1317,6 +1408,9 @@ Status MasterSession::BuildAndRegisterPartitions(ReffedClientGraph* rcg) {
     popts.scheduling_for_recvs = true;
     popts.need_to_record_start_times = true;
   }
+  if (session_opts_.config.rpc_options().max_inflight_recv_tensors() > 0) {
+    popts.record_recv_priorities = true;
+  }
 
   TF_RETURN_IF_ERROR(
       rcg->RegisterPartitions(popts, *rcg->client_graph()->flib_def));
@@ -329,6 +329,15 @@ void InMemoryRunGraphRequest::set_is_last_partial_run(
   is_last_partial_run_ = is_last_partial_run;
 }
 
+bool InMemoryRunGraphRequest::use_registered_keys() const {
+  return use_registered_keys_;
+}
+
+void InMemoryRunGraphRequest::set_use_registered_keys(
+    bool use_registered_keys) {
+  use_registered_keys_ = use_registered_keys;
+}
+
 const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
   if (!proto_version_) {
     proto_version_.reset(new RunGraphRequest);
@@ -346,6 +355,7 @@ const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
     }
     proto_version_->set_is_partial(is_partial());
     proto_version_->set_is_last_partial_run(is_last_partial_run());
+    proto_version_->set_use_registered_keys(use_registered_keys());
   }
   return *proto_version_;
 }
@@ -437,6 +447,15 @@ void MutableProtoRunGraphRequest::set_is_last_partial_run(
   request_.set_is_last_partial_run(is_last_partial_run);
 }
 
+bool MutableProtoRunGraphRequest::use_registered_keys() const {
+  return request_.use_registered_keys();
+}
+
+void MutableProtoRunGraphRequest::set_use_registered_keys(
+    bool use_registered_keys) {
+  request_.set_use_registered_keys(use_registered_keys);
+}
+
 const RunGraphRequest& MutableProtoRunGraphRequest::ToProto() const {
   return request_;
 }
@@ -486,6 +505,10 @@ bool ProtoRunGraphRequest::is_last_partial_run() const {
   return request_->is_last_partial_run();
 }
 
+bool ProtoRunGraphRequest::use_registered_keys() const {
+  return request_->use_registered_keys();
+}
+
 const RunGraphRequest& ProtoRunGraphRequest::ToProto() const {
   return *request_;
 }
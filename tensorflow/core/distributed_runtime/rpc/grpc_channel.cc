@@ -57,6 +57,11 @@ Status ValidateHostPortPair(const string& host_port) {
 
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer) {
+  return NewIndexedHostPortGrpcChannel(target, 0, channel_pointer);
+}
+
+Status NewIndexedHostPortGrpcChannel(const string& target, int channel_index,
+                                     SharedGrpcChannelPtr* channel_pointer) {
   // Minimally ensure that the target is valid
   TF_RETURN_IF_ERROR(ValidateHostPortPair(target));
 
@@ -66,6 +71,11 @@ Status NewHostPortGrpcChannel(const string& target,
   // NOTE(mrry): Some versions of gRPC use a 20-second minimum backoff
   // on connection failure, which makes our tests time out.
   args.SetInt("grpc.testing.fixed_reconnect_backoff_ms", 1000);
+  // gRPC shares a connection between channels to the same target that have
+  // the same arguments, so tag the extra channels with their index.
+  if (channel_index > 0) {
+    args.SetInt("tensorflow.grpc_channel_index", channel_index);
+  }
   *channel_pointer = ::grpc::CreateCustomChannel(
       "dns:///" + target, ::grpc::InsecureChannelCredentials(), args);
   return Status::OK();
@@ -84,6 +94,20 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
   };
 }
 
+IndexedChannelCreationFunction ConvertToIndexedChannelCreationFunction(
+    const std::function<Status(string, int, SharedGrpcChannelPtr*)>&
+        new_channel_func_ptr) {
+  return [new_channel_func_ptr](const string& target,
+                                int channel_index) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel_ptr;
+    if (new_channel_func_ptr(target, channel_index, &channel_ptr).ok()) {
+      return channel_ptr;
+    } else {
+      return nullptr;
+    }
+  };
+}
+
 Status GrpcChannelSpec::AddHostPortsJob(const string& job_id,
                                         const std::vector<string>& host_ports) {
   std::map<int, string> host_ports_map;
@@ -108,7 +132,7 @@ Status GrpcChannelSpec::AddHostPortsJob(
 
 namespace {
 
-// GrpcChannelCache that caches results to FindWorkerChannel() calls.
+// GrpcChannelCache that caches results to FindWorkerChannels() calls.
 class CachingGrpcChannelCache : public GrpcChannelCache {
  public:
   CachingGrpcChannelCache() {}
@@ -116,32 +140,39 @@ class CachingGrpcChannelCache : public GrpcChannelCache {
   ~CachingGrpcChannelCache() override {}
 
   SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
-    SharedGrpcChannelPtr ch = nullptr;
+    std::vector<SharedGrpcChannelPtr> chs = FindWorkerChannels(target);
+    return chs.empty() ? nullptr : chs[0];
+  }
+
+  std::vector<SharedGrpcChannelPtr> FindWorkerChannels(
+      const string& target) override {
     {
       mutex_lock l(mu_);  // could use reader lock
-      ch = gtl::FindPtrOrNull(channels_, target);
-      if (ch) {
-        return ch;
+      auto iter = channels_.find(target);
+      if (iter != channels_.end()) {
+        return iter->second;
       }
     }
-    ch = FindChannelOnce(target);
-    if (ch) {
+    std::vector<SharedGrpcChannelPtr> chs = FindChannelsOnce(target);
+    if (!chs.empty()) {
       mutex_lock l(mu_);
-      channels_.insert({target, ch});
+      channels_.insert({target, chs});
     }
-    return ch;
+    return chs;
   }
 
  protected:
-  // Find the ClientChannel for "target".  Only called when no channel was
-  // found in the channels_ cache for "target".  A non nullptr result will be
+  // Find the ClientChannels for "target".  Only called when no channel was
+  // found in the channels_ cache for "target".  A non-empty result will be
   // cached in channels_.
-  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
+  virtual std::vector<SharedGrpcChannelPtr> FindChannelsOnce(
+      const string& target) = 0;
 
  private:
   // TODO(zhifengc): Eviction when the map becomes too big.
   mutex mu_;
-  std::unordered_map<string, SharedGrpcChannelPtr> channels_ GUARDED_BY(mu_);
+  std::unordered_map<string, std::vector<SharedGrpcChannelPtr>> channels_
+      GUARDED_BY(mu_);
 };
 
 // A ChannelCache that is the union of multiple ChannelCaches.
@@ -182,16 +213,17 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
   }
 
  protected:
-  SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
+  std::vector<SharedGrpcChannelPtr> FindChannelsOnce(
+      const string& target) override {
     for (GrpcChannelCache* cache : caches_) {
-      SharedGrpcChannelPtr ch(cache->FindWorkerChannel(target));
-      if (ch) {
+      std::vector<SharedGrpcChannelPtr> chs(cache->FindWorkerChannels(target));
+      if (!chs.empty()) {
         mutex_lock l(mu_);
         target_caches_.insert({target, cache});
-        return ch;
+        return chs;
       }
     }
-    return nullptr;
+    return {};
   }
 
  private:
@@ -208,10 +240,12 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
  public:
   SparseGrpcChannelCache(const string& job_id,
                          const std::map<int, string>& host_ports,
-                         ChannelCreationFunction channel_func)
+                         IndexedChannelCreationFunction channel_func,
+                         int num_channels_per_target)
       : job_id_(job_id),
         host_ports_(host_ports),
-        channel_func_(std::move(channel_func)) {
+        channel_func_(std::move(channel_func)),
+        num_channels_per_target_(num_channels_per_target) {
     LOG(INFO) << "Initialize GrpcChannelCache for job " << ToString();
   }
   ~SparseGrpcChannelCache() override {}
@@ -248,12 +282,21 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   }
 
  protected:
-  SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
+  std::vector<SharedGrpcChannelPtr> FindChannelsOnce(
+      const string& target) override {
     const string host_port = TranslateTask(target);
     if (host_port.empty()) {
-      return nullptr;
+      return {};
+    }
+    std::vector<SharedGrpcChannelPtr> chs;
+    for (int i = 0; i < num_channels_per_target_; ++i) {
+      SharedGrpcChannelPtr ch = channel_func_(host_port, i);
+      if (!ch) {
+        return {};
+      }
+      chs.push_back(std::move(ch));
     }
-    return channel_func_(host_port);
+    return chs;
   }
 
  private:
@@ -270,7 +313,8 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
 
   const string job_id_;
   const std::map<int, string> host_ports_;
-  const ChannelCreationFunction channel_func_;
+  const IndexedChannelCreationFunction channel_func_;
+  const int num_channels_per_target_;
   TF_DISALLOW_COPY_AND_ASSIGN(SparseGrpcChannelCache);
 };
 
@@ -278,6 +322,18 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
 
 GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
                                       ChannelCreationFunction channel_func) {
+  return NewGrpcChannelCache(
+      spec,
+      [channel_func](const string& target, int channel_index) {
+        return channel_func(target);
+      },
+      1);
+}
+
+GrpcChannelCache* NewGrpcChannelCache(
+    const GrpcChannelSpec& spec, IndexedChannelCreationFunction channel_func,
+    int num_channels_per_target) {
+  CHECK_GT(num_channels_per_target, 0);
   const int num_jobs = spec.host_ports_jobs().size();
   if (!num_jobs) {
     LOG(ERROR) << "Empty channel spec.";
@@ -286,8 +342,8 @@ GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
   std::vector<GrpcChannelCache*> caches;
   caches.reserve(num_jobs);
   for (auto& job : spec.host_ports_jobs()) {
-    caches.push_back(
-        new SparseGrpcChannelCache(job.job_id, job.host_ports, channel_func));
+    caches.push_back(new SparseGrpcChannelCache(
+        job.job_id, job.host_ports, channel_func, num_channels_per_target));
   }
   return caches.size() == 1 ? caches[0] : new MultiGrpcChannelCache(caches);
 }
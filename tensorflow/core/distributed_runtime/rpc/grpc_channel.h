@@ -73,24 +73,54 @@ class GrpcChannelCache {
   // E.g., /job:mnist/task:2
   virtual SharedGrpcChannelPtr FindWorkerChannel(const string& target) = 0;
 
+  // If found, returns the gRPC channels that are connected to the remote
+  // worker named by 'target', each over its own connection. The first
+  // channel is the one returned by FindWorkerChannel(target). Returns an
+  // empty vector if 'target' is not found.
+  virtual std::vector<SharedGrpcChannelPtr> FindWorkerChannels(
+      const string& target) {
+    SharedGrpcChannelPtr channel = FindWorkerChannel(target);
+    if (!channel) return {};
+    return {channel};
+  }
+
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
 };
 
 typedef std::function<SharedGrpcChannelPtr(string)> ChannelCreationFunction;
 
+// Creates the channel with the given index to a host:port target. Channels
+// to the same target with different indices must not share a connection.
+typedef std::function<SharedGrpcChannelPtr(string, int)>
+    IndexedChannelCreationFunction;
+
 GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& channel_spec,
                                       ChannelCreationFunction channel_func);
 
+// Returns a GrpcChannelCache that opens 'num_channels_per_target' channels
+// to each worker, so that the traffic to a worker is not limited to the
+// throughput of a single connection.
+GrpcChannelCache* NewGrpcChannelCache(
+    const GrpcChannelSpec& channel_spec,
+    IndexedChannelCreationFunction channel_func, int num_channels_per_target);
+
 // Below here are internal-only functions.
 
 ChannelCreationFunction ConvertToChannelCreationFunction(
     const std::function<Status(string, SharedGrpcChannelPtr*)>&
         new_channel_func_ptr);
 
+IndexedChannelCreationFunction ConvertToIndexedChannelCreationFunction(
+    const std::function<Status(string, int, SharedGrpcChannelPtr*)>&
+        new_channel_func_ptr);
+
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer);
 
+Status NewIndexedHostPortGrpcChannel(const string& target, int channel_index,
+                                     SharedGrpcChannelPtr* channel_pointer);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_H_
@@ -144,6 +144,34 @@ TEST(GrpcChannelTest, SparseHostPorts) {
             workers);
 }
 
+TEST(GrpcChannelTest, MultipleChannelsPerTarget) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(spec.AddHostPortsJob("mnist", {"a:1", "b:2"}));
+  TF_EXPECT_OK(spec.AddHostPortsJob("other", {"c:3"}));
+  IndexedChannelCreationFunction channel_func =
+      ConvertToIndexedChannelCreationFunction(NewIndexedHostPortGrpcChannel);
+  std::unique_ptr<GrpcChannelCache> cc(
+      NewGrpcChannelCache(spec, channel_func, 3));
+
+  EXPECT_TRUE(cc->FindWorkerChannels("/job:mnist/replica:0/task:2").empty());
+
+  auto a_channels = cc->FindWorkerChannels("/job:mnist/replica:0/task:0");
+  ASSERT_EQ(3, a_channels.size());
+  EXPECT_NE(a_channels[0].get(), a_channels[1].get());
+  EXPECT_NE(a_channels[0].get(), a_channels[2].get());
+  EXPECT_NE(a_channels[1].get(), a_channels[2].get());
+  EXPECT_EQ(a_channels[0].get(),
+            cc->FindWorkerChannel("/job:mnist/replica:0/task:0").get());
+  auto a_channels_2 = cc->FindWorkerChannels("/job:mnist/replica:0/task:0");
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(a_channels[i].get(), a_channels_2[i].get());
+  }
+
+  auto c_channels = cc->FindWorkerChannels("/job:other/replica:0/task:0");
+  ASSERT_EQ(3, c_channels.size());
+  EXPECT_NE(a_channels[0].get(), c_channels[0].get());
+}
+
 TEST(GrpcChannelTest, NewHostPortGrpcChannelValidation) {
   SharedGrpcChannelPtr mock_ptr;
 
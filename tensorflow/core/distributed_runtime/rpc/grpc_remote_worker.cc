@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
 #include <utility>
+#include <vector>
 
 #include "grpc++/grpc++.h"
 
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -36,10 +39,11 @@ namespace tensorflow {
 
 class GrpcRemoteWorker : public WorkerInterface {
  public:
-  explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
+  explicit GrpcRemoteWorker(std::vector<SharedGrpcChannelPtr> channels,
                             ::grpc::CompletionQueue* completion_queue,
                             WorkerCacheLogger* logger)
-      : channel_(std::move(channel)),
+      : channels_(std::move(channels)),
+        channel_(channels_[0]),
         cq_(completion_queue),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
         createworkersession_(Method(GrpcWorkerMethod::kCreateWorkerSession)),
@@ -51,7 +55,17 @@ class GrpcRemoteWorker : public WorkerInterface {
         recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
         logging_(Method(GrpcWorkerMethod::kLogging)),
         tracing_(Method(GrpcWorkerMethod::kTracing)),
-        logger_(logger) {}
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
+        in_flight_(channels_.size()),
+        logger_(logger) {
+    for (size_t i = 0; i < channels_.size(); ++i) {
+      recvtensor_methods_.push_back(
+          Method(GrpcWorkerMethod::kRecvTensor, channels_[i]));
+      recvtensors_methods_.push_back(
+          Method(GrpcWorkerMethod::kRecvTensors, channels_[i]));
+      in_flight_[i] = 0;
+    }
+  }
 
   ~GrpcRemoteWorker() override {}
 
@@ -106,6 +120,8 @@ class GrpcRemoteWorker : public WorkerInterface {
                        TensorResponse* response, StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
     int64 start_usec = Env::Default()->NowMicros();
+    const int channel = PickChannel();
+    done = CountInFlight(channel, std::move(done));
     // Don't propagate dma_ok over gRPC.
     RecvTensorRequest* req_copy = nullptr;
     if (request->dma_ok()) {
@@ -126,8 +142,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       };
       cb_to_use = &wrapper_done;
     } else {
-      wrapper_done = [this, request, req_copy, response, done,
-                      start_usec](Status s) {
+      wrapper_done = [this, request, req_copy, response, done, start_usec,
+                      channel](Status s) {
         if (logger_->LoggingActive()) {
           int64 end_usec = Env::Default()->NowMicros();
           int64 step_id = request->step_id();
@@ -157,11 +173,24 @@ class GrpcRemoteWorker : public WorkerInterface {
           if (key_parts.size() != 5) {
             LOG(WARNING) << "Bad key: " << key;
           } else {
-            logger_->RecordRecvTensor(step_id, send_start_usec, end_usec,
-                                      key_parts[3],  // tensor name
-                                      key_parts[0],  // src_device
-                                      key_parts[2],  // dst_device
-                                      bytes);
+            // Name the channel when there are several, so that the bytes
+            // and latency of each channel can be told apart.
+            string details =
+                channels_.size() > 1
+                    ? strings::StrCat(" over channel ", channel)
+                    : "";
+            // The record starts when the sender started to send, so note
+            // how long the request waited for the sender's tensor first.
+            if (send_start_usec > start_usec) {
+              strings::StrAppend(&details, ", requested ",
+                                 send_start_usec - start_usec,
+                                 "us before it was sent");
+            }
+            logger_->RecordDataTransfer(step_id, send_start_usec, end_usec,
+                                        key_parts[3],  // tensor name
+                                        key_parts[0],  // src_device
+                                        key_parts[2],  // dst_device
+                                        bytes, details, "RecvTensor");
           }
         }
         VLOG(2) << "done callback, req: " << request->DebugString()
@@ -172,8 +201,21 @@ class GrpcRemoteWorker : public WorkerInterface {
       cb_to_use = &wrapper_done;
     }
 
-    IssueRequest(req_copy ? req_copy : request, response, recvtensor_,
-                 *cb_to_use, call_opts);
+    IssueRequest(req_copy ? req_copy : request, response,
+                 recvtensor_methods_[channel], *cb_to_use, call_opts,
+                 channels_[channel].get());
+  }
+
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override {
+    VLOG(1) << "RecvTensorsAsync req: " << request->request_size()
+            << " tensors";
+    const int channel = PickChannel();
+    IssueRequest(request, response, recvtensors_methods_[channel],
+                 CountInFlight(channel, std::move(done)), call_opts,
+                 channels_[channel].get());
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -236,21 +278,59 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   // Utility method for issuing a generic asynchronous request. The
   // given callback, `done`, will be called when the RPC completes.
+  // `method` must have been created for `channel`, which defaults to the
+  // first channel.
   template <class RequestMessage, class ResponseMessage>
   void IssueRequest(const RequestMessage* request, ResponseMessage* response,
                     const ::grpc::RpcMethod& method, StatusCallback done,
-                    CallOptions* call_opts = nullptr) {
+                    CallOptions* call_opts = nullptr,
+                    ::grpc::ChannelInterface* channel = nullptr) {
+    if (channel == nullptr) channel = channel_.get();
     auto state = new RPCState<RequestMessage, ResponseMessage>(
-        channel_.get(), cq_, method, *request, std::move(done), call_opts);
+        channel, cq_, method, *request, std::move(done), call_opts);
     state->StartRPC(response);
   }
 
   // Helper function for initializing the RpcMethod objects below.
   ::grpc::RpcMethod Method(GrpcWorkerMethod id) {
+    return Method(id, channel_);
+  }
+
+  ::grpc::RpcMethod Method(GrpcWorkerMethod id,
+                           const SharedGrpcChannelPtr& channel) {
     return ::grpc::RpcMethod(GrpcWorkerMethodName(id),
-                             ::grpc::RpcMethod::NORMAL_RPC, channel_);
+                             ::grpc::RpcMethod::NORMAL_RPC, channel);
   }
 
+  // Returns the channel to issue the next tensor transfer on: the one with
+  // the fewest transfers in flight, looking at the channels in round-robin
+  // order so that ties are spread evenly.
+  int PickChannel() {
+    const int num_channels = channels_.size();
+    if (num_channels == 1) return 0;
+    const int start = next_channel_.fetch_add(1) % num_channels;
+    int best = start;
+    for (int i = 1; i < num_channels; ++i) {
+      const int candidate = (start + i) % num_channels;
+      if (in_flight_[candidate] < in_flight_[best]) best = candidate;
+    }
+    return best;
+  }
+
+  // Counts a transfer on `channel` as in flight until `done` is called.
+  StatusCallback CountInFlight(int channel, StatusCallback done) {
+    if (channels_.size() == 1) return done;
+    ++in_flight_[channel];
+    return [this, channel, done](const Status& s) {
+      --in_flight_[channel];
+      done(s);
+    };
+  }
+
+  // All the channels to the remote worker. Tensor transfers, which carry
+  // most of the traffic, are spread over all of them. The other calls use
+  // the first channel, channel_.
+  const std::vector<SharedGrpcChannelPtr> channels_;
   SharedGrpcChannelPtr channel_;
   ::grpc::CompletionQueue* cq_;
 
@@ -264,6 +344,15 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::RpcMethod recvtensor_;
   const ::grpc::RpcMethod logging_;
   const ::grpc::RpcMethod tracing_;
+  const ::grpc::RpcMethod recvtensors_;
+
+  // The RecvTensor and RecvTensors methods for each of channels_.
+  std::vector<::grpc::RpcMethod> recvtensor_methods_;
+  std::vector<::grpc::RpcMethod> recvtensors_methods_;
+
+  std::atomic<uint32> next_channel_{0};
+  // The number of tensor transfers in flight on each of channels_.
+  std::vector<std::atomic<int>> in_flight_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -274,7 +363,16 @@ class GrpcRemoteWorker : public WorkerInterface {
 WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue, logger);
+  return NewGrpcRemoteWorker(
+      std::vector<SharedGrpcChannelPtr>({std::move(channel)}),
+      completion_queue, logger);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(
+    std::vector<SharedGrpcChannelPtr> channels,
+    ::grpc::CompletionQueue* completion_queue, WorkerCacheLogger* logger) {
+  CHECK(!channels.empty());
+  return new GrpcRemoteWorker(std::move(channels), completion_queue, logger);
 }
 
 }  // namespace tensorflow
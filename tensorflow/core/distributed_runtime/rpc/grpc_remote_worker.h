@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
 
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
@@ -33,6 +34,12 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger);
 
+// Returns a remote worker that spreads its tensor transfers over
+// 'channels', which must all be connected to the same worker.
+WorkerInterface* NewGrpcRemoteWorker(
+    std::vector<SharedGrpcChannelPtr> channels,
+    ::grpc::CompletionQueue* completion_queue, WorkerCacheLogger* logger);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
@@ -123,6 +123,7 @@ Status GrpcServer::Init(
                                                &master_env_.local_devices));
   worker_env_.local_devices = master_env_.local_devices;
   worker_env_.device_mgr = new DeviceMgr(worker_env_.local_devices);
+  worker_env_.rpc_options = &server_def_.default_session_config().rpc_options();
   worker_env_.rendezvous_mgr = rendezvous_mgr_func == nullptr
                                    ? new RpcRendezvousMgr(&worker_env_)
                                    : rendezvous_mgr_func(&worker_env_);
@@ -278,8 +279,15 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
   GrpcChannelSpec channel_spec;
   TF_RETURN_IF_ERROR(ParseChannelSpec(options, &channel_spec));
 
+  const int num_channels_per_target = server_def_.default_session_config()
+                                         .rpc_options()
+                                         .num_channels_per_target();
   std::unique_ptr<GrpcChannelCache> channel_cache(
-      NewGrpcChannelCache(channel_spec, GetChannelCreationFunction()));
+      num_channels_per_target > 1
+          ? NewGrpcChannelCache(channel_spec,
+                                GetIndexedChannelCreationFunction(),
+                                num_channels_per_target)
+          : NewGrpcChannelCache(channel_spec, GetChannelCreationFunction()));
 
   string name_prefix = strings::StrCat("/job:", *options.job_name, "/replica:0",
                                        "/task:", options.task_index);
@@ -375,6 +383,11 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+IndexedChannelCreationFunction GrpcServer::GetIndexedChannelCreationFunction()
+    const {
+  return ConvertToIndexedChannelCreationFunction(NewIndexedHostPortGrpcChannel);
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
@@ -75,6 +75,11 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Used instead of GetChannelCreationFunction() when the server opens
+  // several channels to each worker.
+  virtual IndexedChannelCreationFunction GetIndexedChannelCreationFunction()
+      const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
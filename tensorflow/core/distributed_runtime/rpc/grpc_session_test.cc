@@ -152,6 +152,34 @@ TEST(GrpcSessionTest, BasicNonProtoAPIConsistentOrder) {
   ASSERT_TRUE(session->Close().ok());
 }
 
+TEST(GrpcSessionTest, RegisteredStepTemplates) {
+  GraphDef graph;
+  string node_names[3];
+  // c = a * b
+  CreateGraphDef(&graph, node_names);
+
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+
+  SessionOptions options = Options(cluster->targets()[0], 1);
+  options.config.mutable_rpc_options()->set_register_step_templates(true);
+  std::unique_ptr<Session> session(NewRemote(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(graph));
+
+  // Feeds and fetches go through the registered keys on every step.
+  for (int iters = 0; iters < 3; ++iters) {
+    Tensor a(DT_FLOAT, TensorShape({1, 2}));
+    test::FillValues<float>(&a, {static_cast<float>(iters), 1});
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({{node_names[0] + ":0", a}},
+                             {node_names[2] + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    IsSingleFloatValue(outputs[0], 2.0 * iters + 1);
+  }
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, NonLocalWithFilters) {
   GraphDef graph;
   string node_names[3];
@@ -17,6 +17,7 @@ limitations under the License.
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -138,22 +139,20 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
-void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
-                              ::grpc::ByteBuffer* result) {
+// Encodes "val" as the tensor() field of "*response", which holds all the
+// other fields of the RecvTensorResponse to encode.
+static void EncodeTensorWithResponse(RecvTensorResponse* response,
+                                     const Tensor& val,
+                                     ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
-  RecvTensorResponse response;
-  if (is_dead) {
-    response.set_is_dead(is_dead);
-  }
-  response.set_send_start_micros(Env::Default()->NowMicros());
   if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
     // go directly from val -> ByteBuffer, with some effort.
-    val.AsProtoTensorContent(response.mutable_tensor());
+    val.AsProtoTensorContent(response->mutable_tensor());
 
     // Encode full protocol buffer to a ByteBuffer
-    EncodeRecvTensorResponseToByteBuffer(response, result);
+    EncodeRecvTensorResponseToByteBuffer(*response, result);
   } else {
     // skeleton is the encoded TensorProto contents (dtype and shape), but
     // not the actual data
@@ -167,7 +166,7 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
          VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
                                tdata.size()));
     string header;  // All of RecvTensorResponse except the tensor() field
-    response.AppendToString(&header);
+    response->AppendToString(&header);
 
     size_t expected_size =
         (header.size() +
@@ -263,5 +262,107 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
   }
 }
 
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              ::grpc::ByteBuffer* result) {
+  RecvTensorResponse response;
+  if (is_dead) {
+    response.set_is_dead(is_dead);
+  }
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  EncodeTensorWithResponse(&response, val, result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorCompressionOptions& compression,
+                              ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, compression, 0, result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorCompressionOptions& compression,
+                              uint64 fingerprint, ::grpc::ByteBuffer* result) {
+  RecvTensorResponse response;
+  if (is_dead) {
+    response.set_is_dead(is_dead);
+  }
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  if (fingerprint != 0) {
+    response.set_fingerprint(fingerprint);
+  }
+  string compressed;
+  if (compression.type() == TensorCompressionOptions::NONE ||
+      !DataTypeCanUseMemcpy(val.dtype()) ||
+      !CompressTensorContent(val.dtype(), val.tensor_data(), compression,
+                             &compressed)) {
+    EncodeTensorWithResponse(&response, val, result);
+    return;
+  }
+  // The compressed contents are smaller than the tensor, so copying them
+  // into a single slice costs less than the uncompressed encoding saves.
+  response.mutable_tensor()->set_dtype(val.dtype());
+  val.shape().AsProto(response.mutable_tensor()->mutable_tensor_shape());
+  response.set_compression(compression.type());
+  response.mutable_compressed_tensor_content()->swap(compressed);
+  EncodeRecvTensorResponseToByteBuffer(response, result);
+}
+
+void EncodeTensorChunkToByteBuffer(const RecvTensorResponse& header,
+                                   const Tensor& val, int64 offset,
+                                   int64 num_bytes,
+                                   ::grpc::ByteBuffer* result) {
+  StringPiece tdata = val.tensor_data();
+  CHECK_GE(offset, 0);
+  CHECK_LE(offset + num_bytes, static_cast<int64>(tdata.size()));
+  string prefix;
+  header.AppendToString(&prefix);
+  char tag[16];
+  io::ProtoEncodeHelper e(tag, sizeof(tag));
+  e.WriteVarlengthBeginning(RecvTensorResponse::kTensorChunkFieldNumber,
+                            num_bytes);
+
+  ::grpc::Slice slices[3];
+  {
+    gpr_slice s0 = gpr_slice_malloc(prefix.size() + e.size());
+    memcpy(GPR_SLICE_START_PTR(s0), prefix.data(), prefix.size());
+    memcpy(GPR_SLICE_START_PTR(s0) + prefix.size(), e.data(), e.size());
+    slices[0] = ::grpc::Slice(s0, ::grpc::Slice::STEAL_REF);
+  }
+  // Share the chunk's bytes, keeping the backing store alive as in
+  // EncodeTensorWithResponse().
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  buf->Ref();
+  gpr_slice s1 = gpr_slice_new(
+      const_cast<void*>(static_cast<const void*>(tdata.data() + offset)),
+      num_bytes, do_nothing);
+  slices[1] = ::grpc::Slice(s1, ::grpc::Slice::STEAL_REF);
+  gpr_slice s2 =
+      gpr_slice_new(const_cast<TensorBuffer*>(buf), 0, unref_tensorbuffer);
+  slices[2] = ::grpc::Slice(s2, ::grpc::Slice::STEAL_REF);
+  *result = ::grpc::ByteBuffer(&slices[0], 3);
+}
+
+void EncodeRecvTensorsResponseToByteBuffer(
+    const std::vector<::grpc::ByteBuffer>& responses,
+    ::grpc::ByteBuffer* result) {
+  std::vector<::grpc::Slice> slices;
+  for (const ::grpc::ByteBuffer& response : responses) {
+    // Each response is a length-delimited RecvTensorsResponse::response
+    // field: a small header slice followed by the response's own slices.
+    char header[16];
+    io::ProtoEncodeHelper e(header, sizeof(header));
+    e.WriteVarlengthBeginning(RecvTensorsResponse::kResponseFieldNumber,
+                              response.Length());
+    gpr_slice s = gpr_slice_from_copied_buffer(e.data(), e.size());
+    slices.push_back(::grpc::Slice(s, ::grpc::Slice::STEAL_REF));
+
+    std::vector<::grpc::Slice> response_slices;
+    (void)response.Dump(&response_slices);
+    for (::grpc::Slice& slice : response_slices) {
+      slices.push_back(std::move(slice));
+    }
+  }
+  *result = ::grpc::ByteBuffer(slices.data(), slices.size());
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
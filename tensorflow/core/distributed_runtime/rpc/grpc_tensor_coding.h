@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
 namespace grpc {
 class ByteBuffer;
 }  // namespace grpc
@@ -23,6 +27,7 @@ class ByteBuffer;
 namespace tensorflow {
 class Tensor;
 class RecvTensorResponse;
+class TensorCompressionOptions;
 
 // TODO(jeff,sanjay): this should not be grpc specific.  Instead of
 // grpc::ByteBuffer*, it should accept an object of an interface type
@@ -51,6 +56,39 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result);
 
+// Same as above, but if "compression" applies to "val" (see
+// CompressTensorContent()), encodes its contents compressed instead.
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorCompressionOptions& compression,
+                              ::grpc::ByteBuffer* result);
+
+// Same as above, but also encodes "fingerprint", if non-zero, as
+// "RecvTensorResponse::fingerprint", so that the receiver can cache "val".
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorCompressionOptions& compression,
+                              uint64 fingerprint, ::grpc::ByteBuffer* result);
+
+// Encode "header", which holds all the fields of a RecvTensorResponse except
+// "tensor_chunk", into a byte buffer together with the "num_bytes" bytes of
+// the contents of "val" at "offset" as "tensor_chunk".  The contents are
+// shared, not copied.  "val" must have a type that can be memcpy'd.
+//
+// Discards original contents of *result.
+void EncodeTensorChunkToByteBuffer(const RecvTensorResponse& header,
+                                   const Tensor& val, int64 offset,
+                                   int64 num_bytes,
+                                   ::grpc::ByteBuffer* result);
+
+// Encode "responses", each of which holds an encoded RecvTensorResponse,
+// into a byte buffer in a format that is parseable as a RecvTensorsResponse
+// protocol buffer holding them in order.  The slices of "responses" are
+// shared, not copied.
+//
+// Discards original contents of *result.
+void EncodeRecvTensorsResponseToByteBuffer(
+    const std::vector<::grpc::ByteBuffer>& responses,
+    ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
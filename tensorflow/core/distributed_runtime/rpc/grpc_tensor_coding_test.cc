@@ -17,15 +17,64 @@ limitations under the License.
 
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 
+class DummyDevice : public DeviceBase {
+ public:
+  explicit DummyDevice(Env* env) : DeviceBase(env) {
+    attr_.set_device_type("CPU");
+  }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+ private:
+  DeviceAttributes attr_;
+};
+
+static void do_nothing(void* raw) {}
+
+// Parses "buf" into "*response" the way the RecvTensor client does.  The
+// raw buffer handed to the parser aliases the slices of "buf", which must
+// outlive the parsed tensor.
+static Status ParseByteBuffer(const ::grpc::ByteBuffer& buf,
+                              TensorResponse* response) {
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  std::vector<gpr_slice> raw;
+  for (const auto& s : slices) {
+    raw.push_back(gpr_slice_new(const_cast<uint8_t*>(s.begin()), s.size(),
+                                do_nothing));
+  }
+  grpc_byte_buffer* bb = grpc_raw_byte_buffer_create(raw.data(), raw.size());
+  for (gpr_slice& s : raw) {
+    gpr_slice_unref(s);
+  }
+  Status s;
+  {
+    GrpcByteSource source(bb);
+    s = response->ParseFrom(&source);
+  }
+  grpc_byte_buffer_destroy(bb);
+  return s;
+}
+
 class GrpcTensorCodingTest : public ::testing::Test {
  public:
   void Validate(const Tensor& t, bool is_dead) {
@@ -100,4 +149,170 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, ParseSharesLargeTensorContents) {
+  Tensor t(DT_FLOAT, TensorShape({4, 4096}));
+  test::FillIota<float>(&t, 0.0f);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, &buf);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+  test::ExpectTensorEqual<float>(t, response.tensor());
+  // The encoder puts large tensor contents in a slice of their own, so the
+  // parsed tensor can point at them directly.
+  if (reinterpret_cast<intptr_t>(t.tensor_data().data()) %
+          EIGEN_MAX_ALIGN_BYTES ==
+      0) {
+    EXPECT_EQ(t.tensor_data().data(), response.tensor().tensor_data().data());
+  }
+}
+
+TEST_F(GrpcTensorCodingTest, ParseCopiesGpuCompatibleTensorContents) {
+  Tensor t(DT_FLOAT, TensorShape({4, 4096}));
+  test::FillIota<float>(&t, 0.0f);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, &buf);
+
+  DummyDevice cpu_device(Env::Default());
+  AllocatorAttributes attr;
+  attr.set_gpu_compatible(true);
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, attr);
+  TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+  test::ExpectTensorEqual<float>(t, response.tensor());
+  EXPECT_NE(t.tensor_data().data(), response.tensor().tensor_data().data());
+}
+
+TEST_F(GrpcTensorCodingTest, ParseFingerprintedAndNotModified) {
+  Tensor t(DT_FLOAT, TensorShape({4, 4096}));
+  test::FillIota<float>(&t, 0.0f);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, TensorCompressionOptions(),
+                                 0x1234567890abcdefULL, &buf);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+  test::ExpectTensorEqual<float>(t, response.tensor());
+  EXPECT_EQ(0x1234567890abcdefULL, response.metadata().fingerprint());
+  EXPECT_FALSE(response.metadata().not_modified());
+
+  RecvTensorResponse not_modified;
+  not_modified.set_fingerprint(0x1234567890abcdefULL);
+  not_modified.set_not_modified(true);
+  grpc::EncodeRecvTensorResponseToByteBuffer(not_modified, &buf);
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+  EXPECT_FALSE(response.tensor().IsInitialized());
+  EXPECT_EQ(0x1234567890abcdefULL, response.metadata().fingerprint());
+  EXPECT_TRUE(response.metadata().not_modified());
+}
+
+TEST_F(GrpcTensorCodingTest, ParseChunks) {
+  Tensor t(DT_FLOAT, TensorShape({10, 100}));
+  test::FillIota<float>(&t, 0.0f);
+  const int64 total_bytes = t.TotalBytes();
+  const int64 chunk_bytes = 1600;
+  DummyDevice cpu_device(Env::Default());
+
+  // The first chunk carries the dtype and shape, and is not copied into a
+  // tensor of that shape.
+  RecvTensorResponse header;
+  header.mutable_tensor()->set_dtype(DT_FLOAT);
+  t.shape().AsProto(header.mutable_tensor()->mutable_tensor_shape());
+  header.set_chunked(true);
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorChunkToByteBuffer(header, t, 0, chunk_bytes, &buf);
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+  EXPECT_FALSE(response.tensor().IsInitialized());
+  EXPECT_TRUE(response.metadata().chunked());
+  EXPECT_EQ(DT_FLOAT, response.metadata().tensor().dtype());
+  Tensor received(DT_FLOAT, TensorShape({10, 100}));
+  ASSERT_EQ(chunk_bytes, response.metadata().tensor_chunk().size());
+  memcpy(const_cast<char*>(received.tensor_data().data()),
+         response.metadata().tensor_chunk().data(), chunk_bytes);
+
+  // The other chunks are parsed straight into the received tensor.
+  for (int64 offset = chunk_bytes; offset < total_bytes;
+       offset += chunk_bytes) {
+    const int64 num_bytes = std::min(chunk_bytes, total_bytes - offset);
+    RecvTensorResponse chunk_header;
+    chunk_header.set_chunked(true);
+    chunk_header.set_chunk_offset(offset);
+    grpc::EncodeTensorChunkToByteBuffer(chunk_header, t, offset, num_bytes,
+                                        &buf);
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    response.SetChunkDestination(received);
+    TF_ASSERT_OK(ParseByteBuffer(buf, &response));
+    EXPECT_EQ(num_bytes, response.chunk_bytes_written());
+    EXPECT_TRUE(response.metadata().tensor_chunk().empty());
+  }
+  test::ExpectTensorEqual<float>(t, received);
+}
+
+TEST_F(GrpcTensorCodingTest, EncodeRecvTensorsResponse) {
+  // Small and large tensors, the latter sharing their buffers.
+  std::vector<Tensor> tensors;
+  for (int64 num_floats : {3, 1 << 16, 0, 5}) {
+    Tensor t(DT_FLOAT, TensorShape({num_floats}));
+    test::FillFn<float>(&t, [](int i) { return i * 0.5f; });
+    tensors.push_back(t);
+  }
+  std::vector<::grpc::ByteBuffer> responses(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    grpc::EncodeTensorToByteBuffer(i == 2, tensors[i], &responses[i]);
+  }
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeRecvTensorsResponseToByteBuffer(responses, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  RecvTensorsResponse response;
+  ASSERT_TRUE(response.ParseFromString(tmp));
+  ASSERT_EQ(tensors.size(), response.response_size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(i == 2, response.response(i).is_dead());
+    Tensor result;
+    ASSERT_TRUE(result.FromProto(response.response(i).tensor()));
+    test::ExpectTensorEqual<float>(tensors[i], result);
+  }
+}
+
+static void BM_ParseRecvTensorResponse(int iters, int num_floats,
+                                       bool gpu_compatible) {
+  testing::StopTiming();
+  Tensor t(DT_FLOAT, TensorShape({num_floats}));
+  t.flat<float>().setRandom();
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, &buf);
+  DummyDevice cpu_device(Env::Default());
+  AllocatorAttributes attr;
+  attr.set_gpu_compatible(gpu_compatible);
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, attr);
+  testing::BytesProcessed(static_cast<int64>(iters) * t.TotalBytes());
+  testing::StartTiming();
+  while (--iters > 0) {
+    TF_CHECK_OK(ParseByteBuffer(buf, &response));
+  }
+}
+
+static void BM_ParseShared(int iters, int num_floats) {
+  BM_ParseRecvTensorResponse(iters, num_floats, false);
+}
+static void BM_ParseCopied(int iters, int num_floats) {
+  BM_ParseRecvTensorResponse(iters, num_floats, true);
+}
+BENCHMARK(BM_ParseShared)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK(BM_ParseCopied)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+
 }  // namespace tensorflow
@@ -63,10 +63,11 @@ class GrpcWorkerCache : public WorkerCachePartial {
     if (target == local_target_) {
       return local_worker_;
     } else {
-      SharedGrpcChannelPtr channel = channel_cache_->FindWorkerChannel(target);
-      if (!channel) return nullptr;
-      WorkerInterface* ret =
-          NewGrpcRemoteWorker(channel, &completion_queue_, &logger_);
+      std::vector<SharedGrpcChannelPtr> channels =
+          channel_cache_->FindWorkerChannels(target);
+      if (channels.empty()) return nullptr;
+      WorkerInterface* ret = NewGrpcRemoteWorker(
+          std::move(channels), &completion_queue_, &logger_);
       return ret;
     }
   }
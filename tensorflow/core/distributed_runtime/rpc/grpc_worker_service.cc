@@ -36,12 +36,15 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -50,6 +53,27 @@ namespace tensorflow {
 
 namespace {
 
+// Tensors smaller than this cost less to send again than to fingerprint
+// and cache on the receiver.
+const size_t kMinFingerprintedTensorBytes = 4096;
+
+// Returns a fingerprint of the dtype, shape and contents of "val", or 0 if
+// the receiver should not cache "val".
+uint64 FingerprintTensor(const Tensor& val) {
+  if (!DataTypeCanUseMemcpy(val.dtype()) ||
+      val.TotalBytes() < kMinFingerprintedTensorBytes) {
+    return 0;
+  }
+  uint64 seed = static_cast<uint64>(val.dtype());
+  for (int i = 0; i < val.dims(); ++i) {
+    seed = Hash64Combine(seed, static_cast<uint64>(val.dim_size(i)));
+  }
+  StringPiece data = val.tensor_data();
+  uint64 fingerprint = Hash64(data.data(), data.size(), seed);
+  // 0 means "no fingerprint".
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
 class GrpcWorkerService : public AsyncServiceInterface {
  public:
   GrpcWorkerService(GrpcWorker* worker, ::grpc::ServerBuilder* builder)
@@ -123,6 +147,9 @@ class GrpcWorkerService : public AsyncServiceInterface {
     for (int i = 0; i < 1000; ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0; i < 100; ++i) {
+      EnqueueRecvTensorsRequestRaw();
+    }
     for (int i = 0; i < 100; ++i) {
       ENQUEUE_REQUEST(RunGraph, true);
     }
@@ -255,6 +282,21 @@ class GrpcWorkerService : public AsyncServiceInterface {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandlerRaw(
+      WorkerCall<RecvTensorsRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorsAsync(call_opts, &call->request, &call->response,
+                                [call, call_opts](const Status& s) {
+                                  call->ClearCancelCallback();
+                                  delete call_opts;
+                                  call->SendResponse(ToGrpcStatus(s));
+                                });
+    });
+    EnqueueRecvTensorsRequestRaw();
+  }
+
   void CleanupGraphHandler(
       WorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
     Schedule([this, call]() {
@@ -294,6 +336,19 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
   }
 
+  void EnqueueRecvTensorsRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
+           RecvTensorsRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              &worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensors),
+              &GrpcWorkerService::RecvTensorsHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerService);
 };
 
@@ -308,6 +363,10 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
                                  const RecvTensorRequest* request,
                                  ::grpc::ByteBuffer* response,
                                  StatusCallback done) {
+  if (request->chunk_offset() > 0) {
+    RecvTensorChunk(request, response, std::move(done));
+    return;
+  }
   const int64 step_id = request->step_id();
   const string& key = request->rendezvous_key();
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
@@ -327,12 +386,17 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
   // of execution of the callback lambda body below, an RPC
   // cancellation should abort the rendezvous.
   opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  const TensorCompressionOptions compression = request->compression();
+  const bool cache_ok = request->cache_ok();
+  const uint64 cached_fingerprint = request->cached_fingerprint();
+  const int64 max_chunk_bytes = request->max_chunk_bytes();
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev](const Status& status,
-                                      const Rendezvous::Args& send_args,
-                                      const Rendezvous::Args& recv_args,
-                                      const Tensor& val, const bool is_dead) {
+      [this, opts, response, done, src_dev, compression, cache_ok,
+       cached_fingerprint, max_chunk_bytes, step_id, key](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
         opts->ClearCancelCallback();
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
@@ -353,10 +417,11 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
                   << "send dev name: " << src_dev->name()
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on a GPU. Uses GPUUtil to fill the response proto.
-              StatusCallback response_ready = [response, done,
-                                               tmp](const Status& s) {
+              StatusCallback response_ready = [response, done, tmp,
+                                               compression](const Status& s) {
                 // The value is now ready to be returned on the wire.
                 tmp->set_send_start_micros(Env::Default()->NowMicros());
+                CompressRecvTensorResponse(compression, tmp);
 
                 grpc::EncodeRecvTensorResponseToByteBuffer(*tmp, response);
                 done(s);
@@ -377,7 +442,42 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
               done(errors::Internal("No GPU device in process"));
 #endif  // GOOGLE_CUDA
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              // Tensors on a GPU are not fingerprinted, so the receiver
+              // does not cache them.
+              const uint64 fingerprint =
+                  cache_ok && !is_dead ? FingerprintTensor(val) : 0;
+              if (fingerprint != 0 && fingerprint == cached_fingerprint) {
+                RecvTensorResponse not_modified;
+                not_modified.set_send_start_micros(
+                    Env::Default()->NowMicros());
+                not_modified.set_fingerprint(fingerprint);
+                not_modified.set_not_modified(true);
+                grpc::EncodeRecvTensorResponseToByteBuffer(not_modified,
+                                                           response);
+              } else if (max_chunk_bytes > 0 && !is_dead &&
+                         DataTypeCanUseMemcpy(val.dtype()) &&
+                         static_cast<int64>(val.TotalBytes()) >
+                             max_chunk_bytes) {
+                // Keeps the tensor until the receiver has asked for all of
+                // its other chunks.
+                {
+                  mutex_lock l(chunk_mu_);
+                  chunked_tensors_[strings::StrCat(step_id, ";", key)] = {
+                      step_id, val,
+                      static_cast<int64>(val.TotalBytes()) - max_chunk_bytes};
+                }
+                RecvTensorResponse header;
+                header.mutable_tensor()->set_dtype(val.dtype());
+                val.shape().AsProto(
+                    header.mutable_tensor()->mutable_tensor_shape());
+                header.set_send_start_micros(Env::Default()->NowMicros());
+                header.set_chunked(true);
+                grpc::EncodeTensorChunkToByteBuffer(header, val, 0,
+                                                    max_chunk_bytes, response);
+              } else {
+                grpc::EncodeTensorToByteBuffer(is_dead, val, compression,
+                                               fingerprint, response);
+              }
               done(Status::OK());
             }
           }
@@ -388,6 +488,113 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::RecvTensorChunk(const RecvTensorRequest* request,
+                                 ::grpc::ByteBuffer* response,
+                                 StatusCallback done) {
+  const int64 offset = request->chunk_offset();
+  const int64 max_chunk_bytes = request->max_chunk_bytes();
+  const string chunk_key =
+      strings::StrCat(request->step_id(), ";", request->rendezvous_key());
+  Tensor val;
+  int64 num_bytes = 0;
+  {
+    mutex_lock l(chunk_mu_);
+    auto it = chunked_tensors_.find(chunk_key);
+    if (it == chunked_tensors_.end()) {
+      done(errors::FailedPrecondition(
+          "No tensor is being sent in chunks for step ", request->step_id(),
+          " and key ", request->rendezvous_key()));
+      return;
+    }
+    val = it->second.tensor;
+    const int64 total_bytes = val.TotalBytes();
+    if (max_chunk_bytes <= 0 || offset >= total_bytes) {
+      done(errors::InvalidArgument("Invalid chunk at offset ", offset,
+                                   " of a tensor of ", total_bytes,
+                                   " bytes"));
+      return;
+    }
+    num_bytes = std::min(max_chunk_bytes, total_bytes - offset);
+    it->second.bytes_left -= num_bytes;
+    if (it->second.bytes_left <= 0) {
+      chunked_tensors_.erase(it);
+    }
+  }
+  RecvTensorResponse header;
+  header.set_send_start_micros(Env::Default()->NowMicros());
+  header.set_chunked(true);
+  header.set_chunk_offset(offset);
+  grpc::EncodeTensorChunkToByteBuffer(header, val, offset, num_bytes,
+                                      response);
+  done(Status::OK());
+}
+
+void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
+                                   CleanupGraphResponse* response,
+                                   StatusCallback done) {
+  {
+    mutex_lock l(chunk_mu_);
+    for (auto it = chunked_tensors_.begin(); it != chunked_tensors_.end();) {
+      if (it->second.step_id == request->step_id()) {
+        it = chunked_tensors_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  Worker::CleanupGraphAsync(request, response, std::move(done));
+}
+
+void GrpcWorker::RecvTensorsAsync(CallOptions* opts,
+                                  const RecvTensorsRequest* request,
+                                  ::grpc::ByteBuffer* response,
+                                  StatusCallback done) {
+  const int num_tensors = request->request_size();
+  TRACEPRINTF("RecvTensors: %d tensors", num_tensors);
+
+  // Each tensor is fetched by its own RecvTensorAsync() call, which gets
+  // its own CallOptions so that cancelling "opts" cancels all of them.
+  struct State {
+    explicit State(int n)
+        : num_pending(n), call_opts(new CallOptions[n]), responses(n) {}
+    mutex mu;
+    int num_pending GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+    std::unique_ptr<CallOptions[]> call_opts;
+    std::vector<::grpc::ByteBuffer> responses;
+  };
+  if (num_tensors == 0) {
+    grpc::EncodeRecvTensorsResponseToByteBuffer({}, response);
+    done(Status::OK());
+    return;
+  }
+  State* state = new State(num_tensors);
+  opts->SetCancelCallback([state, num_tensors]() {
+    for (int i = 0; i < num_tensors; ++i) {
+      state->call_opts[i].StartCancel();
+    }
+  });
+  for (int i = 0; i < num_tensors; ++i) {
+    RecvTensorAsync(&state->call_opts[i], &request->request(i),
+                    &state->responses[i],
+                    [opts, response, done, state](const Status& s) {
+                      {
+                        mutex_lock l(state->mu);
+                        state->status.Update(s);
+                        if (--state->num_pending > 0) return;
+                      }
+                      opts->ClearCancelCallback();
+                      Status status = state->status;
+                      if (status.ok()) {
+                        grpc::EncodeRecvTensorsResponseToByteBuffer(
+                            state->responses, response);
+                      }
+                      delete state;
+                      done(status);
+                    });
+  }
+}
+
 WorkerEnv* GrpcWorker::env() { return env_; }
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
+#include <unordered_map>
+
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace grpc {
 class ByteBuffer;
@@ -37,7 +42,36 @@ class GrpcWorker : public Worker {
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        ::grpc::ByteBuffer* response, StatusCallback done);
 
+  // Fetches each tensor in "request" as RecvTensorAsync() does, and
+  // encodes them all into one RecvTensorsResponse.
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        ::grpc::ByteBuffer* response, StatusCallback done);
+
+  // Also drops the tensors of the step that are still being sent in chunks.
+  void CleanupGraphAsync(const CleanupGraphRequest* request,
+                         CleanupGraphResponse* response,
+                         StatusCallback done) override;
+
   WorkerEnv* env();
+
+ private:
+  // Sends the chunk at "request->chunk_offset()" of a tensor that an
+  // earlier RecvTensorAsync() call started to send in chunks.
+  void RecvTensorChunk(const RecvTensorRequest* request,
+                       ::grpc::ByteBuffer* response, StatusCallback done);
+
+  // A tensor that is being sent in chunks, and the number of its bytes
+  // that have not been sent yet.
+  struct ChunkedTensor {
+    int64 step_id;
+    Tensor tensor;
+    int64 bytes_left;
+  };
+
+  mutex chunk_mu_;
+  // Keyed by step id and rendezvous key.
+  std::unordered_map<string, ChunkedTensor> chunked_tensors_
+      GUARDED_BY(chunk_mu_);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env);
@@ -24,8 +24,61 @@ limitations under the License.
 #include "grpc++/impl/codegen/service_type.h"
 #include "grpc++/impl/codegen/sync_stream.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+
 namespace tensorflow {
 
+namespace {
+
+// A TensorBuffer that aliases the bytes of a received gRPC slice and holds
+// a reference on the slice until the tensor is destroyed.
+class GrpcSliceTensorBuffer : public TensorBuffer {
+ public:
+  GrpcSliceTensorBuffer(gpr_slice slice, void* data, size_t len)
+      : slice_(slice), data_(data), len_(len) {}
+
+  ~GrpcSliceTensorBuffer() override { gpr_slice_unref(slice_); }
+
+  void* data() const override { return data_; }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("grpc_slice");
+  }
+
+  // The slice memory belongs to gRPC; do not forward it as an output.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  gpr_slice slice_;
+  void* data_;
+  size_t len_;
+};
+
+}  // namespace
+
+TensorBuffer* GrpcByteSource::ShareContents(const char* data,
+                                            size_t num_bytes) {
+  // Compressed payloads are decoded into a separate buffer by the reader,
+  // so "data" only matches a slice of an uncompressed raw buffer.
+  if (buffer_->type != GRPC_BB_RAW) return nullptr;
+  const gpr_slice_buffer& slices = buffer_->data.raw.slice_buffer;
+  for (size_t i = 0; i < slices.count; ++i) {
+    const gpr_slice& slice = slices.slices[i];
+    // Inlined slices store their bytes in the slice itself.
+    if (slice.refcount == nullptr) continue;
+    const char* begin = reinterpret_cast<const char*>(GPR_SLICE_START_PTR(slice));
+    const char* end = begin + GPR_SLICE_LENGTH(slice);
+    if (data >= begin && data + num_bytes <= end) {
+      return new GrpcSliceTensorBuffer(gpr_slice_ref(slice),
+                                       const_cast<char*>(data), num_bytes);
+    }
+  }
+  return nullptr;
+}
+
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
   switch (id) {
     case GrpcWorkerMethod::kGetStatus:
@@ -48,6 +101,8 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/Logging";
     case GrpcWorkerMethod::kTracing:
       return "/tensorflow.WorkerService/Tracing";
+    case GrpcWorkerMethod::kRecvTensors:
+      return "/tensorflow.WorkerService/RecvTensors";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
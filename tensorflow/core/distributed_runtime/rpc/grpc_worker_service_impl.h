@@ -36,6 +36,8 @@ TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RegisterGraphRequest);
 TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RunGraphRequest);
 // Contains potentially large StepStats, TensorProto.
 TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RunGraphResponse);
+// Contains potentially many TensorProtos.
+TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RecvTensorsResponse);
 
 namespace tensorflow {
 class GrpcByteSource : public TensorResponse::Source {
@@ -51,6 +53,10 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares bytes that lie within one of the slices of the buffer by taking
+  // a reference on that slice.
+  TensorBuffer* ShareContents(const char* data, size_t num_bytes) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -118,9 +124,10 @@ enum class GrpcWorkerMethod {
   kRecvTensor,
   kLogging,
   kTracing,
+  kRecvTensors,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kTracing) + 1;
+    static_cast<int>(GrpcWorkerMethod::kRecvTensors) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
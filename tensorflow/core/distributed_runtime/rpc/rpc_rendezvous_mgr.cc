@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <list>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -31,15 +34,92 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
+// Tensors that a worker received from other workers in earlier steps, by
+// rendezvous key (which does not depend on the step), evicted in least
+// recently used order once they hold more than "capacity_bytes".
+class RecvTensorCache {
+ public:
+  explicit RecvTensorCache(int64 capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+
+  // Returns the fingerprint of the tensor cached for "key" and sets *val to
+  // it, or returns 0 if there is none.
+  uint64 Lookup(const string& key, Tensor* val) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return 0;
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    *val = it->second.tensor;
+    return it->second.fingerprint;
+  }
+
+  // Caches "val", which has "fingerprint", for "key".
+  void Insert(const string& key, uint64 fingerprint, const Tensor& val) {
+    const int64 bytes = val.TotalBytes();
+    mutex_lock l(mu_);
+    EraseLocked(key);
+    if (bytes > capacity_bytes_) return;
+    while (bytes_ + bytes > capacity_bytes_) {
+      EraseLocked(lru_.back());
+    }
+    lru_.push_front(key);
+    entries_[key] = {fingerprint, val, lru_.begin()};
+    bytes_ += bytes;
+  }
+
+ private:
+  struct Entry {
+    uint64 fingerprint;
+    Tensor tensor;
+    std::list<string>::iterator lru_pos;
+  };
+
+  void EraseLocked(const string& key) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    bytes_ -= it->second.tensor.TotalBytes();
+    lru_.erase(it->second.lru_pos);
+    entries_.erase(it);
+  }
+
+  const int64 capacity_bytes_;
+
+  mutex mu_;
+  int64 bytes_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<string, Entry> entries_ GUARDED_BY(mu_);
+  // Keys of entries_, most recently used first.
+  std::list<string> lru_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecvTensorCache);
+};
+
 namespace {
 
+class RpcRecvTensorCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id, false) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                      std::shared_ptr<RecvTensorCache> recv_cache)
+      : BaseRemoteRendezvous(env, step_id, false),
+        recv_cache_(std::move(recv_cache)) {
+    if (env->rpc_options != nullptr) {
+      const RPCOptions& rpc_options = *env->rpc_options;
+      batch_window_micros_ = rpc_options.recv_tensor_batch_window_micros();
+      if (rpc_options.max_recv_tensor_batch_size() > 0) {
+        max_batch_size_ = rpc_options.max_recv_tensor_batch_size();
+      }
+      max_inflight_ = rpc_options.max_inflight_recv_tensors();
+      // Each chunk is sent in a message of its own, which must stay well
+      // under the 2GB limit of protocol buffers.
+      max_chunk_bytes_ =
+          std::min<int64>(rpc_options.recv_tensor_chunk_bytes(), 1LL << 30);
+    }
+  }
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -47,7 +127,76 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
                            DoneCallback done) override;
 
  private:
-  ~RpcRemoteRendezvous() override {}
+  ~RpcRemoteRendezvous() override {
+    DCHECK(open_batches_.empty());
+    DCHECK(inflight_.empty());
+  }
+
+  // Calls waiting to be sent to one remote worker in the same RecvTensors
+  // call.
+  struct RecvTensorsBatch {
+    int64 id;
+    std::vector<RpcRecvTensorCall*> calls;
+    CallOptions opts;
+    RecvTensorsRequest req;
+    RecvTensorsResponse resp;
+  };
+
+  bool batching_enabled() const {
+    return batch_window_micros_ > 0 && max_batch_size_ > 1;
+  }
+
+  bool throttling_enabled() const {
+    return !batching_enabled() && max_inflight_ > 0;
+  }
+
+  // The calls to one remote worker that are in flight or waiting for one of
+  // them to finish.
+  struct InflightCalls {
+    int num_inflight = 0;
+    // Waiting calls, by priority and then arrival order.
+    std::map<std::pair<int64, int64>, RpcRecvTensorCall*> waiting;
+  };
+
+  // Starts "call", or queues it if max_inflight_ calls to its source worker
+  // are in flight.
+  void StartOrQueue(RpcRecvTensorCall* call);
+
+  // Starts the most urgent waiting call to "src_worker", now that one of
+  // its calls finished.
+  void StartNextCall(const string& src_worker);
+
+  // Adds "call" to the open batch for its source worker, opening a new one
+  // that is sent after batch_window_micros_ if there is none.
+  void AddToBatch(RpcRecvTensorCall* call);
+
+  // Sends the batch "batch_id" for "src_worker", unless it filled up and
+  // was sent already.
+  void FlushBatch(const string& src_worker, int64 batch_id);
+
+  // Issues the RecvTensors call for "batch" and takes ownership of it.
+  void StartBatch(RecvTensorsBatch* batch);
+
+  // Runs the done callback of "call" and returns it to the free list.
+  void RecvDone(RpcRecvTensorCall* call);
+
+  const std::shared_ptr<RecvTensorCache> recv_cache_;
+  int64 batch_window_micros_ = 0;
+  int max_batch_size_ = 64;
+  int max_inflight_ = 0;
+  int64 max_chunk_bytes_ = 0;
+
+  mutex batch_mu_;
+  int64 next_batch_id_ GUARDED_BY(batch_mu_) = 0;
+  // The batch that is still accepting calls, by source worker.
+  std::unordered_map<string, RecvTensorsBatch*> open_batches_
+      GUARDED_BY(batch_mu_);
+
+  mutex inflight_mu_;
+  int64 next_call_seq_ GUARDED_BY(inflight_mu_) = 0;
+  // By source worker; entries are removed when no call is in flight.
+  std::unordered_map<string, InflightCalls> inflight_
+      GUARDED_BY(inflight_mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
@@ -55,18 +204,39 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
 // Used only to retrieve tensors from remote processes.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
-  RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
+  RpcRecvTensorCall()
+      : wi_(nullptr), dst_device_(nullptr), recv_cache_(nullptr) {}
 
   void Init(WorkerInterface* wi, int64 step_id, StringPiece key,
             AllocatorAttributes alloc_attrs, Device* dst_device,
-            const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+            const Rendezvous::Args& recv_args,
+            const TensorCompressionOptions* compression,
+            RecvTensorCache* recv_cache, int64 max_chunk_bytes,
+            Rendezvous::DoneCallback done) {
     wi_ = wi;
     alloc_attrs_ = alloc_attrs;
     dst_device_ = dst_device;
     recv_args_ = recv_args;
+    recv_cache_ = recv_cache;
     done_ = std::move(done);
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
+    if (recv_cache_ != nullptr) {
+      req_.set_cache_ok(true);
+      req_.set_cached_fingerprint(
+          recv_cache_->Lookup(req_.rendezvous_key(), &cached_tensor_));
+    }
+    if (max_chunk_bytes > 0) {
+      req_.set_max_chunk_bytes(max_chunk_bytes);
+    }
+    if (compression != nullptr) {
+      *req_.mutable_compression() = *compression;
+    }
+    if (recv_args.wire_compression >= 0) {
+      req_.mutable_compression()->set_type(
+          static_cast<TensorCompressionOptions::Type>(
+              recv_args.wire_compression));
+    }
   }
 
   void Reset(WorkerCacheInterface* wc) {
@@ -74,6 +244,11 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    recv_cache_ = nullptr;
+    cached_tensor_ = Tensor();
+    chunked_tensor_ = Tensor();
+    chunk_calls_.clear();
+    chunks_done_ = nullptr;
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -111,7 +286,49 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     return status_;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  // Completes the call with status "s" and, if "s" is OK, the tensor in
+  // "*response", which was received as part of a RecvTensors call.
+  // Leaves *response with unspecified contents.
+  void FinishFromBatch(const Status& s, RecvTensorResponse* response) {
+    opts_.ClearCancelCallback();
+    Status status = s;
+    if (status.ok()) {
+      resp_.InitAlloc(dst_device_, alloc_attrs_);
+      status = resp_.InitFrom(response);
+    }
+    if (!status.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(status);
+    }
+  }
+
+  // If the sender found the tensor unchanged since it was cached, checks
+  // that the cached tensor is the one it compared against; otherwise caches
+  // the received tensor if the sender fingerprinted it. Must be called once
+  // the call succeeded and before tensor().
+  Status UpdateCache() {
+    if (recv_cache_ == nullptr) return Status::OK();
+    const RecvTensorResponse& meta = resp_.metadata();
+    if (meta.not_modified()) {
+      if (!cached_tensor_.IsInitialized() ||
+          meta.fingerprint() != req_.cached_fingerprint()) {
+        return errors::Internal("Unexpected not-modified response for ",
+                                req_.rendezvous_key());
+      }
+      return Status::OK();
+    }
+    cached_tensor_ = Tensor();
+    if (meta.fingerprint() != 0 && !meta.is_dead()) {
+      recv_cache_->Insert(req_.rendezvous_key(), meta.fingerprint(),
+                          resp_.tensor());
+    }
+    return Status::OK();
+  }
+
+  const Tensor& tensor() const {
+    if (chunked_tensor_.IsInitialized()) return chunked_tensor_;
+    return resp_.metadata().not_modified() ? cached_tensor_ : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -133,6 +350,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
           if (!s.ok()) {
             mutex_lock l(mu_);
             status_.Update(s);
+          } else if (resp_.metadata().chunked()) {
+            StartChunkCalls(std::move(recv_done));
+            return;
           }
           recv_done();
         },
@@ -140,6 +360,107 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
   }
 
+  // A RecvTensor call for one chunk after the first of a tensor that is
+  // sent in chunks.
+  struct ChunkCall {
+    CallOptions opts;
+    RecvTensorRequest req;
+    TensorResponse resp;
+  };
+
+  // Allocates chunked_tensor_ for the tensor whose first chunk is in resp_,
+  // copies that chunk into it, and issues the calls for the other chunks,
+  // which are parsed straight into chunked_tensor_. Runs "recv_done" once
+  // they all finished.
+  void StartChunkCalls(std::function<void()> recv_done) {
+    const RecvTensorResponse& meta = resp_.metadata();
+    const int64 max_chunk_bytes = req_.max_chunk_bytes();
+    Status s;
+    if (max_chunk_bytes <= 0 || !DataTypeCanUseMemcpy(meta.tensor().dtype()) ||
+        !TensorShape::IsValid(meta.tensor().tensor_shape())) {
+      s = errors::Internal("Unexpected chunked response for ",
+                           req_.rendezvous_key());
+    } else {
+      chunked_tensor_ =
+          Tensor(dst_device_->GetAllocator(alloc_attrs_), meta.tensor().dtype(),
+                 TensorShape(meta.tensor().tensor_shape()));
+      StringPiece data = chunked_tensor_.tensor_data();
+      const int64 total_bytes = data.size();
+      if (total_bytes <= max_chunk_bytes || meta.chunk_offset() != 0 ||
+          static_cast<int64>(meta.tensor_chunk().size()) != max_chunk_bytes) {
+        s = errors::Internal("Unexpected first chunk of ",
+                             req_.rendezvous_key());
+      } else {
+        memcpy(const_cast<char*>(data.data()), meta.tensor_chunk().data(),
+               max_chunk_bytes);
+        for (int64 offset = max_chunk_bytes; offset < total_bytes;
+             offset += max_chunk_bytes) {
+          ChunkCall* chunk = new ChunkCall;
+          chunk->req.set_step_id(req_.step_id());
+          chunk->req.set_rendezvous_key(req_.rendezvous_key());
+          chunk->req.set_max_chunk_bytes(max_chunk_bytes);
+          chunk->req.set_chunk_offset(offset);
+          chunk_calls_.emplace_back(chunk);
+        }
+      }
+    }
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    {
+      mutex_lock l(mu_);
+      if (!status_.ok()) {
+        // Failed, or aborted while the first chunk was in flight.
+        chunk_calls_.clear();
+      }
+      num_pending_chunks_ = chunk_calls_.size();
+    }
+    if (chunk_calls_.empty()) {
+      recv_done();
+      return;
+    }
+    chunks_done_ = std::move(recv_done);
+    opts_.SetCancelCallback([this]() {
+      for (auto& chunk : chunk_calls_) {
+        chunk->opts.StartCancel();
+      }
+    });
+    for (auto& c : chunk_calls_) {
+      ChunkCall* chunk = c.get();
+      chunk->resp.InitAlloc(dst_device_, alloc_attrs_);
+      chunk->resp.SetChunkDestination(chunked_tensor_);
+      wi_->RecvTensorAsync(
+          &chunk->opts, &chunk->req, &chunk->resp,
+          [this, chunk](const Status& s) { ChunkDone(chunk, s); });
+    }
+  }
+
+  void ChunkDone(ChunkCall* chunk, const Status& s) {
+    Status status = s;
+    if (status.ok()) {
+      const RecvTensorResponse& meta = chunk->resp.metadata();
+      const int64 expected_bytes =
+          std::min(chunk->req.max_chunk_bytes(),
+                   static_cast<int64>(chunked_tensor_.TotalBytes()) -
+                       chunk->req.chunk_offset());
+      if (!meta.chunked() || meta.chunk_offset() != chunk->req.chunk_offset() ||
+          chunk->resp.chunk_bytes_written() != expected_bytes) {
+        status = errors::Internal("Unexpected chunk at offset ",
+                                  chunk->req.chunk_offset(), " of ",
+                                  req_.rendezvous_key());
+      }
+    }
+    {
+      mutex_lock l(mu_);
+      status_.Update(status);
+      if (--num_pending_chunks_ > 0) return;
+    }
+    opts_.ClearCancelCallback();
+    std::function<void()> recv_done = std::move(chunks_done_);
+    recv_done();
+  }
+
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;
@@ -150,9 +471,17 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   TensorResponse resp_;
   Rendezvous::Args recv_args_;
   Rendezvous::DoneCallback done_;
+  RecvTensorCache* recv_cache_;  // Not owned; may be null.
+  // The tensor that req_.cached_fingerprint() refers to, if any.
+  Tensor cached_tensor_;
+  // The tensor that is received in chunks, if it is.
+  Tensor chunked_tensor_;
+  std::vector<std::unique_ptr<ChunkCall>> chunk_calls_;
+  std::function<void()> chunks_done_;
 
   mutable mutex mu_;
   Status status_ GUARDED_BY(mu_);
+  int64 num_pending_chunks_ GUARDED_BY(mu_) = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorCall);
 };
@@ -236,36 +565,202 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     return;
   }
 
+  const TensorCompressionOptions* compression =
+      env_->rpc_options != nullptr ? &env_->rpc_options->tensor_compression()
+                                   : nullptr;
+  // Tensors fetched in batches, or received into device memory, are not
+  // received in chunks.
+  const bool to_host = recv_args.alloc_attrs.on_host() ||
+                       dst_device->device_type() == DEVICE_CPU;
+  const int64 max_chunk_bytes =
+      !batching_enabled() && to_host ? max_chunk_bytes_ : 0;
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+             recv_args, compression, recv_cache_.get(), max_chunk_bytes,
+             std::move(done));
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
 
   // Start "call".
   Ref();
-  call->Start([this, call]() {
-    // Removes "call" from active_. Prevent StartAbort().
-    DeregisterCall(call);
-    // If StartAbort was called prior to DeregisterCall, then the
-    // current status should be bad.
-    Status s = call->status();
-    call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
-    session()->worker_cache->ReleaseWorker(call->src_worker_, call->wi_);
-    call->wi_ = nullptr;
-    get_call_freelist()->Release(call, session()->worker_cache.get());
-    Unref();
-  });
+  if (batching_enabled()) {
+    AddToBatch(call);
+  } else if (throttling_enabled()) {
+    StartOrQueue(call);
+  } else {
+    call->Start([this, call]() { RecvDone(call); });
+  }
+}
+
+void RpcRemoteRendezvous::RecvDone(RpcRecvTensorCall* call) {
+  // Removes "call" from active_. Prevent StartAbort().
+  DeregisterCall(call);
+  // If StartAbort was called prior to DeregisterCall, then the
+  // current status should be bad.
+  Status s = call->status();
+  if (s.ok()) {
+    s = call->UpdateCache();
+  }
+  call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+  const string src_worker = call->src_worker_;
+  session()->worker_cache->ReleaseWorker(call->src_worker_, call->wi_);
+  call->wi_ = nullptr;
+  get_call_freelist()->Release(call, session()->worker_cache.get());
+  if (throttling_enabled()) {
+    StartNextCall(src_worker);
+  }
+  Unref();
+}
+
+void RpcRemoteRendezvous::StartOrQueue(RpcRecvTensorCall* call) {
+  {
+    mutex_lock l(inflight_mu_);
+    InflightCalls& calls = inflight_[call->src_worker_];
+    if (calls.num_inflight >= max_inflight_) {
+      calls.waiting.emplace(
+          std::make_pair(call->recv_args().priority, next_call_seq_++), call);
+      return;
+    }
+    ++calls.num_inflight;
+  }
+  call->Start([this, call]() { RecvDone(call); });
+}
+
+void RpcRemoteRendezvous::StartNextCall(const string& src_worker) {
+  RpcRecvTensorCall* next = nullptr;
+  {
+    mutex_lock l(inflight_mu_);
+    auto it = inflight_.find(src_worker);
+    DCHECK(it != inflight_.end());
+    InflightCalls& calls = it->second;
+    if (calls.waiting.empty()) {
+      if (--calls.num_inflight == 0) {
+        inflight_.erase(it);
+      }
+      return;
+    }
+    // The finished call's slot goes to the most urgent waiting call.
+    next = calls.waiting.begin()->second;
+    calls.waiting.erase(calls.waiting.begin());
+  }
+  if (next->status().ok()) {
+    next->Start([this, next]() { RecvDone(next); });
+  } else {
+    // Aborted while waiting.
+    RecvDone(next);
+  }
+}
+
+void RpcRemoteRendezvous::AddToBatch(RpcRecvTensorCall* call) {
+  // "call" may complete as soon as it is in a batch, so do not touch it
+  // after releasing the lock.
+  const string src_worker = call->src_worker_;
+  RecvTensorsBatch* full_batch = nullptr;
+  int64 new_batch_id = -1;
+  {
+    mutex_lock l(batch_mu_);
+    RecvTensorsBatch*& batch = open_batches_[src_worker];
+    if (batch == nullptr) {
+      batch = new RecvTensorsBatch;
+      batch->id = next_batch_id_++;
+      new_batch_id = batch->id;
+    }
+    batch->calls.push_back(call);
+    if (batch->calls.size() >= static_cast<size_t>(max_batch_size_)) {
+      full_batch = batch;
+      open_batches_.erase(src_worker);
+    }
+  }
+  if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  } else if (new_batch_id >= 0) {
+    Ref();
+    env_->env->SchedClosureAfter(batch_window_micros_,
+                                 [this, src_worker, new_batch_id]() {
+                                   FlushBatch(src_worker, new_batch_id);
+                                   Unref();
+                                 });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker,
+                                     int64 batch_id) {
+  RecvTensorsBatch* batch = nullptr;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = open_batches_.find(src_worker);
+    if (it == open_batches_.end() || it->second->id != batch_id) {
+      return;
+    }
+    batch = it->second;
+    open_batches_.erase(it);
+  }
+  StartBatch(batch);
+}
+
+void RpcRemoteRendezvous::StartBatch(RecvTensorsBatch* batch) {
+  std::vector<RpcRecvTensorCall*> calls;
+  calls.reserve(batch->calls.size());
+  for (RpcRecvTensorCall* call : batch->calls) {
+    call->opts_.SetCancelCallback([batch]() { batch->opts.StartCancel(); });
+    if (call->status().ok()) {
+      calls.push_back(call);
+    } else {
+      // Aborted while waiting for the batch to fill up.
+      call->opts_.ClearCancelCallback();
+      RecvDone(call);
+    }
+  }
+  batch->calls.swap(calls);
+
+  if (batch->calls.size() <= 1) {
+    // A plain RecvTensor call avoids copying the tensor out of the response.
+    for (RpcRecvTensorCall* call : batch->calls) {
+      call->opts_.ClearCancelCallback();
+      call->Start([this, call]() { RecvDone(call); });
+    }
+    delete batch;
+    return;
+  }
+
+  for (RpcRecvTensorCall* call : batch->calls) {
+    *batch->req.add_request() = call->req_;
+  }
+  // Every call in the batch holds a WorkerInterface for the same worker.
+  WorkerInterface* wi = batch->calls[0]->wi_;
+  wi->RecvTensorsAsync(
+      &batch->opts, &batch->req, &batch->resp, [this, batch](const Status& s) {
+        const int num_calls = batch->calls.size();
+        Status status = s;
+        if (status.ok() && batch->resp.response_size() != num_calls) {
+          status = errors::Internal("RecvTensors returned ",
+                                    batch->resp.response_size(),
+                                    " tensors, expected ", num_calls);
+        }
+        for (int i = 0; i < num_calls; ++i) {
+          RpcRecvTensorCall* call = batch->calls[i];
+          call->FinishFromBatch(
+              status, status.ok() ? batch->resp.mutable_response(i) : nullptr);
+          RecvDone(call);
+        }
+        delete batch;
+      });
 }
 
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : BaseRendezvousMgr(env) {
+  if (env->rpc_options != nullptr &&
+      env->rpc_options->recv_tensor_cache_bytes() > 0) {
+    recv_cache_ = std::make_shared<RecvTensorCache>(
+        env->rpc_options->recv_tensor_cache_bytes());
+  }
+}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id, recv_cache_);
 }
 
 }  // end namespace tensorflow
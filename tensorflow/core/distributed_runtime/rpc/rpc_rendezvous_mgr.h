@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 
+#include <memory>
+
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/platform/macros.h"
@@ -23,6 +25,7 @@ limitations under the License.
 namespace tensorflow {
 
 class DeviceMgr;
+class RecvTensorCache;
 
 // RendezvousMgr keeps track of a set of local rendezvous instances.
 // All tensors sent by this worker are buffered in a RendezvousMgr
@@ -50,6 +53,11 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env);
 
  private:
+  // Tensors received in earlier steps, if RPCOptions.recv_tensor_cache_bytes
+  // is positive; otherwise null. Shared with the rendezvous instances, which
+  // may outlive *this while they finish receiving tensors.
+  std::shared_ptr<RecvTensorCache> recv_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
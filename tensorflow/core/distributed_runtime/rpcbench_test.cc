@@ -39,9 +39,9 @@ limitations under the License.
 namespace tensorflow {
 
 static const int kWorkers = 60;
-static thread::ThreadPool* worker_threads;
 
 void MakeGRPCCluster(const SessionOptions& options, int n,
+                     int64 recv_tensor_batch_window_micros,
                      std::vector<string>* workers,
                      std::vector<DeviceAttributes>* devices) {
   CHECK_GE(n, 1);
@@ -64,9 +64,12 @@ void MakeGRPCCluster(const SessionOptions& options, int n,
     num_gpus = iter->second;
   }
 
-  worker_threads = new thread::ThreadPool(Env::Default(), "worker_threads", n);
+  // The servers run until the process exits.
+  thread::ThreadPool* worker_threads =
+      new thread::ThreadPool(Env::Default(), "worker_threads", n);
   for (int worker_idx = 0; worker_idx < n; ++worker_idx) {
-    worker_threads->Schedule([worker_idx, n, num_cpus, num_gpus, &port] {
+    worker_threads->Schedule([worker_idx, n, num_cpus, num_gpus,
+                              recv_tensor_batch_window_micros, &port] {
       ServerDef server;
       server.set_protocol("grpc");
       server.set_job_name("localhost");
@@ -82,6 +85,8 @@ void MakeGRPCCluster(const SessionOptions& options, int n,
       auto config = server.mutable_default_session_config();
       (*config->mutable_device_count())["CPU"] = num_cpus;
       (*config->mutable_device_count())["GPU"] = num_gpus;
+      config->mutable_rpc_options()->set_recv_tensor_batch_window_micros(
+          recv_tensor_batch_window_micros);
 
       std::unique_ptr<ServerInterface> svr;
       TF_CHECK_OK(NewServer(server, &svr));
@@ -104,11 +109,13 @@ struct Cluster {
   std::vector<string> workers;
   std::vector<DeviceAttributes> devices;  // One per process
 
-  Cluster() {
+  explicit Cluster(int num_workers = kWorkers,
+                   int64 recv_tensor_batch_window_micros = 0) {
     (*options.config.mutable_device_count())["CPU"] = 1;
     options.config.set_intra_op_parallelism_threads(1);
     options.config.set_inter_op_parallelism_threads(1);
-    MakeGRPCCluster(options, kWorkers, &workers, &devices);
+    MakeGRPCCluster(options, num_workers, recv_tensor_batch_window_micros,
+                    &workers, &devices);
     LOG(ERROR) << "C " << workers.size() << " " << devices.size() << " "
                << workers[0] << " " << workers[1];
     options.target = workers[0];
@@ -120,6 +127,13 @@ static const Cluster* GetCluster() {
   return result;
 }
 
+// A cluster whose workers fetch the tensors they receive from each other in
+// batches of up to 64, collected over 100us.
+static const Cluster* GetBatchingCluster() {
+  static Cluster* result = new Cluster(2, 100);
+  return result;
+}
+
 // Make a program with specified number of stages and "width" ops per stage.
 GraphDef CreateGraphDef(int num_stages, int width, int tensor_size,
                         bool use_multiple_devices, const Cluster* cluster) {
@@ -248,4 +262,47 @@ BENCHMARK(BM_SingleDevice)
     ->ArgPair(4, 10000)
     ->ArgPair(1, 1000000);
 
+// Each step fetches "num_tensors" small tensors from one worker to another,
+// like a model reading many small variables from a parameter server. With
+// "batched", the receiving worker fetches them with RecvTensors calls.
+static void BM_ManySmallRecvs(int iters, int num_tensors, int batched) {
+  testing::StopTiming();
+  const Cluster* cluster = batched ? GetBatchingCluster() : GetCluster();
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  Scope s = Scope::NewRootScope();
+  Output x = Const(s.WithOpName("x"), 0.0f, {2, 1});
+  std::vector<Output> remote;
+  for (int i = 0; i < num_tensors; ++i) {
+    remote.push_back(Identity(s.WithDevice(cluster->devices[1].name()), x));
+  }
+  AddN(s.WithOpName("y"), remote);
+  GraphDef def;
+  TF_CHECK_OK(s.ToGraphDef(&def));
+  graph::SetDefaultDevice(cluster->devices[0].name(), &def);
+
+  std::unique_ptr<Session> session(NewSession(cluster->options));
+  TF_CHECK_OK(session->Create(def));
+  testing::SetLabel(strings::StrCat(num_tensors, " tensors/step; ",
+                                    batched ? "RecvTensors" : "RecvTensor"));
+
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; i++) {
+    TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+  }
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(session->Close());
+}
+BENCHMARK(BM_ManySmallRecvs)
+    ->ArgPair(10, 0)
+    ->ArgPair(10, 1)
+    ->ArgPair(100, 0)
+    ->ArgPair(100, 1)
+    ->ArgPair(500, 0)
+    ->ArgPair(500, 1);
+
 }  // namespace tensorflow
@@ -17,17 +17,25 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 
 namespace tensorflow {
 
 TensorResponse::Source::~Source() {}
 
+TensorBuffer* TensorResponse::Source::ShareContents(const char* data,
+                                                    size_t num_bytes) {
+  return nullptr;
+}
+
 void TensorResponse::Clear() {
   on_host_ = false;
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
   already_used_ = false;
+  chunk_dest_ = Tensor();
+  chunk_bytes_written_ = 0;
   ClearTensor();
 }
 
@@ -50,7 +58,11 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
-  if (on_host_) {
+  if (meta_.not_modified() || meta_.chunked()) {
+    // The receiver already holds the tensor, or assembles it from chunks.
+  } else if (meta_.compression() != TensorCompressionOptions::NONE) {
+    s = MaybeDecompressTensor();
+  } else if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
     }
@@ -84,6 +96,12 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (meta_.not_modified() || meta_.chunked()) {
+      return Status::OK();
+    }
+    if (meta_.compression() != TensorCompressionOptions::NONE) {
+      return MaybeDecompressTensor();
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -98,17 +116,53 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return Status::OK();
+  if (ParseFast(source)) return MaybeDecompressTensor();
   meta_.Clear();
-  if (ParseSlow(source)) return Status::OK();
+  if (ParseSlow(source)) return MaybeDecompressTensor();
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
 
+Status TensorResponse::MaybeDecompressTensor() {
+  if (meta_.compression() == TensorCompressionOptions::NONE) {
+    return Status::OK();
+  }
+  const TensorProto& tensor_meta = meta_.tensor();
+  if (!DataTypeCanUseMemcpy(tensor_meta.dtype()) ||
+      !TensorShape::IsValid(tensor_meta.tensor_shape())) {
+    return errors::InvalidArgument("Cannot parse tensor from response");
+  }
+  TensorShape shape(tensor_meta.tensor_shape());
+  Status s;
+  if (on_host_) {
+    // The fast parsing path has already allocated a tensor of the right type
+    // and shape.
+    if (!tensor_.IsInitialized() || tensor_.dtype() != tensor_meta.dtype() ||
+        tensor_.shape() != shape) {
+      tensor_ = Tensor(allocator_, tensor_meta.dtype(), shape);
+    }
+    s = DecompressTensorContent(meta_.compression(),
+                                meta_.compressed_tensor_content(), &tensor_);
+  } else {
+    Tensor decompressed(tensor_meta.dtype(), shape);
+    s = DecompressTensorContent(meta_.compression(),
+                                meta_.compressed_tensor_content(),
+                                &decompressed);
+    if (s.ok()) {
+      TensorProto proto;
+      decompressed.AsProtoTensorContent(&proto);
+      s = device_->MakeTensorFromProto(proto, alloc_attrs_, &tensor_);
+    }
+  }
+  meta_.clear_compressed_tensor_content();
+  return s;
+}
+
 // Define some helper routines for decoding protocol buffer wire format data
 namespace {
 // We only need some of the wiretype values for this code
 enum WireType {
   WIRETYPE_VARINT = 0,
+  WIRETYPE_FIXED64 = 1,
   WIRETYPE_LENGTH_DELIMITED = 2,
 };
 inline int GetTagFieldNumber(uint32 tag) { return tag >> 3; }
@@ -140,22 +194,48 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 
 }  // namespace
 
+// Tensor contents below this size are always copied: sharing them would
+// pin a whole receive buffer for little gain.
+static const int kMinSharedContentBytes = 4096;
+
+bool TensorResponse::ShareTensorContent(Source* source,
+                                        protobuf::io::CodedInputStream* input,
+                                        const TensorProto& tensor_meta,
+                                        int num_bytes) {
+  // Tensors that will be DMAed to a GPU need memory from allocator_.
+  if (num_bytes < kMinSharedContentBytes || alloc_attrs_.gpu_compatible()) {
+    return false;
+  }
+  TensorShape shape(tensor_meta.tensor_shape());
+  if (static_cast<size_t>(num_bytes) !=
+      shape.num_elements() * DataTypeSize(tensor_meta.dtype())) {
+    return false;
+  }
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < num_bytes ||
+      reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return false;
+  }
+  TensorBuffer* buf =
+      source->ShareContents(static_cast<const char*>(data), num_bytes);
+  if (buf == nullptr) return false;
+  tensor_ = Tensor(tensor_meta.dtype(), shape, buf);
+  buf->Unref();
+  return input->Skip(num_bytes);
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
-  bool seen_tensor_content = false;
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta, bool* seen_tensor_content_out) {
+  bool& seen_tensor_content = *seen_tensor_content_out;
+  seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
-      bool ok = (tag == 0);
-      if (ok && !seen_tensor_content) {
-        // No tensor content: could be because it's a zero-length tensor
-        TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
-        tensor_ = std::move(t);
-      }
-      return ok;
+      return (tag == 0);
     }
     switch (tag) {
       case TensorProto::kDtypeFieldNumber: {
@@ -191,13 +271,11 @@ bool TensorResponse::ParseTensorSubmessage(
         int num_bytes;
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
+        if (ShareTensorContent(source, input, *tensor_meta, num_bytes)) break;
         TensorShape shape(tensor_meta->tensor_shape());
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -212,15 +290,39 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
+bool TensorResponse::ReadTensorChunk(protobuf::io::CodedInputStream* input) {
+  int length;
+  if (!ReadVarintSizeAsInt(input, &length)) return false;
+  if (chunk_dest_.IsInitialized()) {
+    StringPiece dest = chunk_dest_.tensor_data();
+    const int64 offset = meta_.chunk_offset();
+    if (offset >= 0 && offset + length <= static_cast<int64>(dest.size())) {
+      chunk_bytes_written_ = length;
+      return input->ReadRaw(const_cast<char*>(dest.data()) + offset, length);
+    }
+  }
+  return input->ReadString(meta_.mutable_tensor_chunk(), length);
+}
+
 bool TensorResponse::ParseFast(Source* source) {
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+  // Whether a tensor without contents was parsed, whose storage must be
+  // allocated unless its contents come separately.
+  bool tensor_needs_storage = false;
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
-      return (tag == 0);
+      if (tag != 0) return false;
+      if (tensor_needs_storage && !meta_.chunked()) {
+        // No tensor content: could be because it's a zero-length tensor,
+        // or because the contents are compressed.
+        TensorShape shape(meta_.tensor().tensor_shape());
+        tensor_ = Tensor(allocator_, meta_.tensor().dtype(), shape);
+      }
+      return true;
     }
     switch (tag) {
       case RecvTensorResponse::kTensorFieldNumber: {
@@ -230,13 +332,16 @@ bool TensorResponse::ParseFast(Source* source) {
         if (!ReadVarintSizeAsInt(&input, &length)) return false;
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
+        bool seen_tensor_content;
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor(),
+                                   &seen_tensor_content)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
           return false;
         }
+        tensor_needs_storage = !seen_tensor_content;
         break;
       }
       case RecvTensorResponse::kIsDeadFieldNumber: {
@@ -257,6 +362,51 @@ bool TensorResponse::ParseFast(Source* source) {
           return false;
         break;
       }
+      case RecvTensorResponse::kCompressionFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_compression(static_cast<TensorCompressionOptions::Type>(v));
+        break;
+      }
+      case RecvTensorResponse::kCompressedTensorContentFieldNumber: {
+        int length;
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadVarintSizeAsInt(&input, &length) ||
+            !input.ReadString(meta_.mutable_compressed_tensor_content(),
+                              length))
+          return false;
+        break;
+      }
+      case RecvTensorResponse::kFingerprintFieldNumber: {
+        protobuf_uint64 v;
+        if ((wt != WIRETYPE_FIXED64) || !input.ReadLittleEndian64(&v))
+          return false;
+        meta_.set_fingerprint(v);
+        break;
+      }
+      case RecvTensorResponse::kNotModifiedFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_not_modified(v != 0);
+        break;
+      }
+      case RecvTensorResponse::kChunkedFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_chunked(v != 0);
+        break;
+      }
+      case RecvTensorResponse::kChunkOffsetFieldNumber: {
+        protobuf_uint64 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) return false;
+        meta_.set_chunk_offset(static_cast<int64>(v));
+        break;
+      }
+      case RecvTensorResponse::kTensorChunkFieldNumber: {
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) || !ReadTensorChunk(&input))
+          return false;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -271,6 +421,11 @@ bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
   }
+  if (meta_.not_modified() || meta_.chunked() ||
+      meta_.compression() != TensorCompressionOptions::NONE) {
+    // Nothing to decode, or decoded by MaybeDecompressTensor().
+    return true;
+  }
 
   Tensor parsed(meta_.tensor().dtype());
   if (!parsed.FromProto(allocator_, meta_.tensor())) {
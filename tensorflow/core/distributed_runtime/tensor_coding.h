@@ -46,6 +46,16 @@ class TensorResponse {
   // Initialize memory allocation related members.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
+  // Makes ParseFrom() write the "tensor_chunk" of a chunked response
+  // straight into the contents of "dest" at the response's "chunk_offset",
+  // instead of into metadata(), if it fits.  Must be called after
+  // InitAlloc().
+  void SetChunkDestination(const Tensor& dest) { chunk_dest_ = dest; }
+
+  // Returns the number of bytes that ParseFrom() wrote to the chunk
+  // destination.
+  int64 chunk_bytes_written() const { return chunk_bytes_written_; }
+
   // Source provides a way for a particular RPC implementation to provide
   // received data to ParseFrom.
   class Source {
@@ -64,6 +74,13 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a new TensorBuffer that aliases the "num_bytes" bytes at
+    // "data" and keeps them alive, or nullptr if the bytes cannot be
+    // shared.  "data" points into a buffer yielded by the stream most
+    // recently returned by contents().  Lets ParseFrom avoid copying large
+    // tensor contents.  The default implementation returns nullptr.
+    virtual TensorBuffer* ShareContents(const char* data, size_t num_bytes);
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -88,11 +105,21 @@ class TensorResponse {
   const RecvTensorResponse& metadata() const { return meta_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
+                             TensorProto* tensor_meta,
+                             bool* seen_tensor_content);
+  bool ReadTensorChunk(protobuf::io::CodedInputStream* input);
+  bool ShareTensorContent(Source* source,
+                          protobuf::io::CodedInputStream* input,
+                          const TensorProto& tensor_meta, int num_bytes);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
+  // If meta_ carries compressed tensor contents, decodes them into tensor_
+  // and drops them from meta_.
+  Status MaybeDecompressTensor();
+
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
@@ -100,6 +127,8 @@ class TensorResponse {
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
+  Tensor chunk_dest_;
+  int64 chunk_bytes_written_ = 0;
 };
 
 }  // namespace tensorflow
@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -155,6 +158,31 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, CompressedTensor) {
+  Tensor src(DT_FLOAT, TensorShape({4, 250}));
+  test::FillFn<float>(&src, [](int i) { return 0.5f * i; });
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  TensorCompressionOptions options;
+  options.set_type(TensorCompressionOptions::FLOAT16);
+  CompressRecvTensorResponse(options, &proto);
+  ASSERT_EQ(TensorCompressionOptions::FLOAT16, proto.compression());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  for (int i = 0; i < 2; i++) {
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+    EXPECT_TRUE(response.metadata().compressed_tensor_content().empty());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
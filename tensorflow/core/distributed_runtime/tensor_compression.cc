@@ -0,0 +1,205 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Contents are encoded as follows, where "n" is the number of elements:
+//
+// FLOAT16:  n Eigen::half values.
+// BFLOAT16: n bfloat16 values.
+// SNAPPY:   the snappy compression of the contents.
+// SPARSE:   a varint64 count k of the elements kept, followed by k pairs of a
+//           varint64 index delta (from the previous kept element, or from 0)
+//           and the float value, stored with core::EncodeFixed32.
+
+bool CompressFloat16(StringPiece content, string* out) {
+  const int64 n = content.size() / sizeof(float);
+  const float* src = reinterpret_cast<const float*>(content.data());
+  out->resize(n * sizeof(Eigen::half));
+  Eigen::half* dst = reinterpret_cast<Eigen::half*>(&(*out)[0]);
+  for (int64 i = 0; i < n; ++i) {
+    dst[i] = Eigen::half(src[i]);
+  }
+  return true;
+}
+
+bool CompressBFloat16(StringPiece content, string* out) {
+  const int64 n = content.size() / sizeof(float);
+  out->resize(n * sizeof(bfloat16));
+  FloatToBFloat16(reinterpret_cast<const float*>(content.data()),
+                  reinterpret_cast<bfloat16*>(&(*out)[0]), n);
+  return true;
+}
+
+bool CompressSparse(StringPiece content, float threshold, string* out) {
+  const int64 n = content.size() / sizeof(float);
+  const float* src = reinterpret_cast<const float*>(content.data());
+  int64 num_kept = 0;
+  for (int64 i = 0; i < n; ++i) {
+    if (std::abs(src[i]) > threshold) ++num_kept;
+  }
+  // Each kept element costs at least 5 bytes; give up early if that already
+  // exceeds the dense encoding.
+  if (num_kept * 5 >= static_cast<int64>(content.size())) {
+    return false;
+  }
+  out->clear();
+  core::PutVarint64(out, num_kept);
+  int64 last = 0;
+  for (int64 i = 0; i < n; ++i) {
+    if (std::abs(src[i]) > threshold) {
+      core::PutVarint64(out, i - last);
+      uint32 bits;
+      memcpy(&bits, &src[i], sizeof(bits));
+      core::PutFixed32(out, bits);
+      last = i;
+    }
+  }
+  return out->size() < content.size();
+}
+
+Status DecompressSparse(StringPiece data, Tensor* tensor) {
+  const int64 n = tensor->NumElements();
+  float* dst = tensor->flat<float>().data();
+  std::fill(dst, dst + n, 0.0f);
+  uint64 num_kept;
+  if (!core::GetVarint64(&data, &num_kept)) {
+    return errors::DataLoss("Corrupt sparse tensor content");
+  }
+  uint64 index = 0;
+  for (uint64 k = 0; k < num_kept; ++k) {
+    uint64 delta;
+    if (!core::GetVarint64(&data, &delta) || data.size() < sizeof(uint32)) {
+      return errors::DataLoss("Corrupt sparse tensor content");
+    }
+    index += delta;
+    if (index >= static_cast<uint64>(n)) {
+      return errors::DataLoss("Sparse tensor content index ", index,
+                              " out of range for ", n, " elements");
+    }
+    const uint32 bits = core::DecodeFixed32(data.data());
+    memcpy(&dst[index], &bits, sizeof(bits));
+    data.remove_prefix(sizeof(uint32));
+  }
+  if (!data.empty()) {
+    return errors::DataLoss("Trailing bytes in sparse tensor content");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool CompressTensorContent(DataType dtype, StringPiece content,
+                           const TensorCompressionOptions& options,
+                           string* out) {
+  if (content.empty() ||
+      static_cast<int64>(content.size()) < options.min_bytes()) {
+    return false;
+  }
+  switch (options.type()) {
+    case TensorCompressionOptions::FLOAT16:
+      return dtype == DT_FLOAT && CompressFloat16(content, out);
+    case TensorCompressionOptions::BFLOAT16:
+      return dtype == DT_FLOAT && CompressBFloat16(content, out);
+    case TensorCompressionOptions::SNAPPY:
+      return DataTypeCanUseMemcpy(dtype) &&
+             port::Snappy_Compress(content.data(), content.size(), out) &&
+             out->size() < content.size();
+    case TensorCompressionOptions::SPARSE:
+      return dtype == DT_FLOAT &&
+             CompressSparse(content, options.sparse_threshold(), out);
+    default:
+      return false;
+  }
+}
+
+Status DecompressTensorContent(TensorCompressionOptions::Type type,
+                               StringPiece data, Tensor* tensor) {
+  const int64 n = tensor->NumElements();
+  switch (type) {
+    case TensorCompressionOptions::FLOAT16: {
+      if (tensor->dtype() != DT_FLOAT ||
+          data.size() != n * sizeof(Eigen::half)) {
+        return errors::DataLoss("Corrupt float16 tensor content");
+      }
+      const Eigen::half* src =
+          reinterpret_cast<const Eigen::half*>(data.data());
+      float* dst = tensor->flat<float>().data();
+      for (int64 i = 0; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+      }
+      return Status::OK();
+    }
+    case TensorCompressionOptions::BFLOAT16:
+      if (tensor->dtype() != DT_FLOAT || data.size() != n * sizeof(bfloat16)) {
+        return errors::DataLoss("Corrupt bfloat16 tensor content");
+      }
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(data.data()),
+                      tensor->flat<float>().data(), n);
+      return Status::OK();
+    case TensorCompressionOptions::SNAPPY: {
+      StringPiece content = tensor->tensor_data();
+      size_t length;
+      if (!DataTypeCanUseMemcpy(tensor->dtype()) ||
+          !port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                              &length) ||
+          length != content.size() ||
+          !port::Snappy_Uncompress(data.data(), data.size(),
+                                   const_cast<char*>(content.data()))) {
+        return errors::DataLoss("Corrupt snappy tensor content");
+      }
+      return Status::OK();
+    }
+    case TensorCompressionOptions::SPARSE:
+      if (tensor->dtype() != DT_FLOAT) {
+        return errors::DataLoss("Corrupt sparse tensor content");
+      }
+      return DecompressSparse(data, tensor);
+    default:
+      return errors::InvalidArgument("Unknown tensor compression ", type);
+  }
+}
+
+void CompressRecvTensorResponse(const TensorCompressionOptions& options,
+                                RecvTensorResponse* response) {
+  if (options.type() == TensorCompressionOptions::NONE) {
+    return;
+  }
+  TensorProto* tensor = response->mutable_tensor();
+  string compressed;
+  if (!CompressTensorContent(tensor->dtype(), tensor->tensor_content(),
+                             options, &compressed)) {
+    return;
+  }
+  tensor->clear_tensor_content();
+  response->set_compression(options.type());
+  response->mutable_compressed_tensor_content()->swap(compressed);
+}
+
+}  // namespace tensorflow
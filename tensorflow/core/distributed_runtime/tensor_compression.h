@@ -0,0 +1,53 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// Encodes "content", the tensor_content of a tensor of type "dtype", as
+// described by "options" into "*out". Returns false, leaving "*out" in an
+// unspecified state, if "options" does not apply to "dtype", if "content" is
+// smaller than "options.min_bytes()", or if the encoding would not be smaller
+// than "content"; the caller should then send "content" as it is.
+bool CompressTensorContent(DataType dtype, StringPiece content,
+                           const TensorCompressionOptions& options,
+                           string* out);
+
+// Decodes "data", produced by CompressTensorContent() with type "type", into
+// the contents of "*tensor", which must already have the dtype and shape of
+// the tensor that was encoded.
+Status DecompressTensorContent(TensorCompressionOptions::Type type,
+                               StringPiece data, Tensor* tensor);
+
+// Moves the tensor_content of "response->tensor()" into
+// "response->compressed_tensor_content()", encoded as described by
+// "options", if CompressTensorContent() accepts it. Otherwise leaves
+// "*response" unchanged.
+void CompressRecvTensorResponse(const TensorCompressionOptions& options,
+                                RecvTensorResponse* response);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
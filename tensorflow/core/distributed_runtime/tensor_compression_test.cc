@@ -0,0 +1,154 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TensorCompressionOptions Options(TensorCompressionOptions::Type type) {
+  TensorCompressionOptions options;
+  options.set_type(type);
+  return options;
+}
+
+// Compresses "src" with "options" and decompresses it into a new tensor.
+Status RoundTrip(const Tensor& src, const TensorCompressionOptions& options,
+                 Tensor* dst) {
+  string compressed;
+  if (!CompressTensorContent(src.dtype(), src.tensor_data(), options,
+                             &compressed)) {
+    return errors::FailedPrecondition("Not compressed");
+  }
+  EXPECT_LT(compressed.size(), src.tensor_data().size());
+  *dst = Tensor(src.dtype(), src.shape());
+  return DecompressTensorContent(options.type(), compressed, dst);
+}
+
+Tensor Ramp(int64 n) {
+  Tensor t(DT_FLOAT, TensorShape({n}));
+  auto flat = t.flat<float>();
+  for (int64 i = 0; i < n; ++i) {
+    flat(i) = 0.25f * i;
+  }
+  return t;
+}
+
+TEST(TensorCompressionTest, Float16) {
+  Tensor src = Ramp(1000);
+  Tensor dst;
+  TF_ASSERT_OK(RoundTrip(src, Options(TensorCompressionOptions::FLOAT16),
+                         &dst));
+  // Multiples of 0.25 up to 250 are exact in half precision.
+  test::ExpectTensorEqual<float>(src, dst);
+}
+
+TEST(TensorCompressionTest, BFloat16) {
+  Tensor src = Ramp(1000);
+  Tensor dst;
+  TF_ASSERT_OK(RoundTrip(src, Options(TensorCompressionOptions::BFLOAT16),
+                         &dst));
+  // bfloat16 keeps 8 significant bits.
+  test::ExpectTensorNear<float>(src, dst, 1.0);
+}
+
+TEST(TensorCompressionTest, Snappy) {
+  string unused;
+  if (!port::Snappy_Compress("", 0, &unused)) {
+    LOG(INFO) << "Snappy is not available; skipping test.";
+    return;
+  }
+  Tensor src(DT_INT32, TensorShape({100, 10}));
+  test::FillFn<int32>(&src, [](int i) { return i % 7; });
+  Tensor dst;
+  TF_ASSERT_OK(RoundTrip(src, Options(TensorCompressionOptions::SNAPPY),
+                         &dst));
+  test::ExpectTensorEqual<int32>(src, dst);
+}
+
+TEST(TensorCompressionTest, Sparse) {
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  test::FillFn<float>(&src, [](int i) {
+    return i % 97 == 0 ? 1.0f + i : (i % 5 == 0 ? 0.01f : 0.0f);
+  });
+  TensorCompressionOptions options = Options(TensorCompressionOptions::SPARSE);
+  options.set_sparse_threshold(0.1);
+  Tensor dst;
+  TF_ASSERT_OK(RoundTrip(src, options, &dst));
+
+  Tensor expected(DT_FLOAT, TensorShape({10, 100}));
+  test::FillFn<float>(&expected,
+                      [](int i) { return i % 97 == 0 ? 1.0f + i : 0.0f; });
+  test::ExpectTensorEqual<float>(expected, dst);
+}
+
+TEST(TensorCompressionTest, SparseGivesUpOnDenseTensors) {
+  Tensor src = Ramp(1000);
+  string compressed;
+  EXPECT_FALSE(CompressTensorContent(DT_FLOAT, src.tensor_data(),
+                                     Options(TensorCompressionOptions::SPARSE),
+                                     &compressed));
+}
+
+TEST(TensorCompressionTest, SkipsUnsupportedAndSmallTensors) {
+  string compressed;
+  Tensor ints(DT_INT32, TensorShape({1000}));
+  ints.flat<int32>().setZero();
+  EXPECT_FALSE(CompressTensorContent(
+      DT_INT32, ints.tensor_data(), Options(TensorCompressionOptions::FLOAT16),
+      &compressed));
+
+  TensorCompressionOptions options =
+      Options(TensorCompressionOptions::FLOAT16);
+  options.set_min_bytes(8192);
+  EXPECT_FALSE(CompressTensorContent(DT_FLOAT, Ramp(1000).tensor_data(),
+                                     options, &compressed));
+  options.set_min_bytes(4000);
+  EXPECT_TRUE(CompressTensorContent(DT_FLOAT, Ramp(1000).tensor_data(),
+                                    options, &compressed));
+}
+
+TEST(TensorCompressionTest, RejectsCorruptContent) {
+  Tensor dst(DT_FLOAT, TensorShape({10}));
+  EXPECT_FALSE(DecompressTensorContent(TensorCompressionOptions::FLOAT16,
+                                       "abc", &dst)
+                   .ok());
+  // One element at index 10, which is out of range.
+  string sparse("\x01\x0a\x00\x00\x80\x3f", 6);
+  EXPECT_FALSE(
+      DecompressTensorContent(TensorCompressionOptions::SPARSE, sparse, &dst)
+          .ok());
+}
+
+TEST(TensorCompressionTest, CompressRecvTensorResponse) {
+  Tensor src = Ramp(1000);
+  RecvTensorResponse response;
+  src.AsProtoTensorContent(response.mutable_tensor());
+  CompressRecvTensorResponse(Options(TensorCompressionOptions::FLOAT16),
+                             &response);
+  EXPECT_EQ(TensorCompressionOptions::FLOAT16, response.compression());
+  EXPECT_TRUE(response.tensor().tensor_content().empty());
+  EXPECT_EQ(2000, response.compressed_tensor_content().size());
+  EXPECT_EQ(DT_FLOAT, response.tensor().dtype());
+}
+
+}  // namespace
+}  // namespace tensorflow
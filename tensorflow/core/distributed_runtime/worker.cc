@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -56,6 +57,13 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
   Status s = session->graph_mgr->Register(
       request->session_handle(), request->graph_def(), request->graph_options(),
       request->debug_options(), response->mutable_graph_handle());
+  if (s.ok() &&
+      (request->send_key_size() > 0 || request->recv_key_size() > 0)) {
+    s = session->graph_mgr->SetStepTemplate(
+        response->graph_handle(),
+        {request->send_key().begin(), request->send_key().end()},
+        {request->recv_key().begin(), request->recv_key().end()});
+  }
   done(s);
 }
 
@@ -81,9 +89,30 @@ void Worker::AbortStep(int64 step_id) {
 }
 
 Status Worker::PrepareRunGraph(RunGraphRequestWrapper* req,
+                               GraphMgr* graph_mgr,
                                GraphMgr::NamedTensors* in,
                                GraphMgr::NamedTensors* out) {
   static Tensor empty_tensor(DT_FLOAT);
+  if (req->use_registered_keys()) {
+    std::vector<string> send_keys;
+    std::vector<string> recv_keys;
+    TF_RETURN_IF_ERROR(graph_mgr->GetStepTemplate(req->graph_handle(),
+                                                  &send_keys, &recv_keys));
+    if (req->num_sends() != send_keys.size()) {
+      return errors::InvalidArgument("Expected ", send_keys.size(),
+                                     " sends for graph ", req->graph_handle(),
+                                     ", got ", req->num_sends());
+    }
+    Tensor val;
+    for (size_t i = 0; i < send_keys.size(); ++i) {
+      TF_RETURN_IF_ERROR(req->SendValue(i, &val));
+      in->insert({send_keys[i], val});
+    }
+    for (const string& key : recv_keys) {
+      out->insert({key, empty_tensor});
+    }
+    return Status::OK();
+  }
   if (req->num_sends() > 0) {
     Tensor val;
     for (size_t i = 0; i < req->num_sends(); ++i) {
@@ -124,7 +153,7 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
       env_->session_mgr->WorkerSessionForSession(request->session_handle());
   GraphMgr::NamedTensors in;
   GraphMgr::NamedTensors* out = new GraphMgr::NamedTensors;
-  Status s = PrepareRunGraph(request, &in, out);
+  Status s = PrepareRunGraph(request, session->graph_mgr, &in, out);
   if (!s.ok()) {
     delete out;
     done(s);
@@ -136,6 +165,12 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
     collector = new StepStatsCollector(response->mutable_step_stats());
     // TODO(mrry,pbar): GPU tracing for distributed steps.
   }
+  // Logs the tensors this worker receives from other workers during the
+  // step, so that the timeline shows the time spent waiting for them.
+  const bool log_rpcs = request->exec_opts().record_timeline();
+  if (log_rpcs) {
+    session->worker_cache->SetLogging(true);
+  }
   CancellationManager* cm = new CancellationManager;
   opts->SetCancelCallback([this, cm, step_id]() {
     cm->StartCancel();
@@ -152,6 +187,9 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
       delete cm;
       delete collector;
       delete out;
+      if (log_rpcs) {
+        session->worker_cache->SetLogging(false);
+      }
       done(errors::Aborted("Call was aborted"));
       return;
     }
@@ -161,7 +199,7 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
       request->graph_handle(), step_id, session, request->exec_opts(),
       collector, cost_graph, cm, in,
       [this, step_id, response, session, cm, out, token, collector, opts,
-       done](Status s) {
+       log_rpcs, done](Status s) {
         if (s.ok()) {
           s = session->graph_mgr->RecvOutputs(step_id, out);
         }
@@ -180,6 +218,13 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
           }
         }
         delete collector;
+        if (log_rpcs) {
+          session->worker_cache->SetLogging(false);
+          StepStats rpc_stats;
+          if (session->worker_cache->RetrieveLogs(step_id, &rpc_stats)) {
+            response->mutable_step_stats()->MergeFrom(rpc_stats);
+          }
+        }
         delete out;
         done(s);
       });
@@ -198,7 +243,7 @@ void Worker::DoPartialRunGraph(CallOptions* opts,
 
   GraphMgr::NamedTensors in;
   GraphMgr::NamedTensors* out = new GraphMgr::NamedTensors;
-  Status s = PrepareRunGraph(request, &in, out);
+  Status s = PrepareRunGraph(request, session->graph_mgr, &in, out);
   auto finish = [this, done, out, opts](const Status& s) {
     opts->ClearCancelCallback();
     delete out;
@@ -322,4 +367,13 @@ void Worker::RecvTensorAsync(CallOptions* opts,
   done(errors::Unimplemented("Worker::RecvTensorAsync()"));
 }
 
+void Worker::RecvTensorsAsync(CallOptions* opts,
+                              const RecvTensorsRequest* request,
+                              RecvTensorsResponse* response,
+                              StatusCallback done) {
+  // As with RecvTensorAsync, use a transport-specific implementation (such
+  // as `GrpcWorker::RecvTensorsAsync()`) instead.
+  done(errors::Unimplemented("Worker::RecvTensorsAsync()"));
+}
+
 }  // namespace tensorflow
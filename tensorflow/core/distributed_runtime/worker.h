@@ -79,6 +79,10 @@ class Worker : public WorkerInterface {
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override;
 
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override;
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -99,7 +103,7 @@ class Worker : public WorkerInterface {
   mutex mu_;
   CancellationManager* cancellation_manager_ GUARDED_BY(mu_);
 
-  Status PrepareRunGraph(RunGraphRequestWrapper* req,
+  Status PrepareRunGraph(RunGraphRequestWrapper* req, GraphMgr* graph_mgr,
                          GraphMgr::NamedTensors* in,
                          GraphMgr::NamedTensors* out);
 
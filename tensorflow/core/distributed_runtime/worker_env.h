@@ -29,6 +29,7 @@ class Device;
 class DeviceMgr;
 class Env;
 class RendezvousMgrInterface;
+class RPCOptions;
 class SessionMgr;
 
 // The worker environment class, which holds a bag of pointers to
@@ -55,6 +56,9 @@ struct WorkerEnv {
 
   // A pool of threads for scheduling compute work.
   thread::ThreadPool* compute_pool = nullptr;
+
+  // Options for the RPCs this worker issues to other workers, if any.
+  const RPCOptions* rpc_options = nullptr;
 };
 
 }  // end namespace tensorflow
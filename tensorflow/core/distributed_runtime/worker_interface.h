@@ -102,6 +102,12 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  // Fetches several tensors in one call. See RecvTensorsRequest.
+  virtual void RecvTensorsAsync(CallOptions* opts,
+                                const RecvTensorsRequest* request,
+                                RecvTensorsResponse* response,
+                                StatusCallback done) = 0;
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/framework/allocator.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/allocator_registry.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -31,6 +35,14 @@ void AllocatorStats::Clear() {
   this->max_bytes_in_use = 0;
   this->max_alloc_size = 0;
   this->bytes_limit = 0;
+  this->num_cache_hits = 0;
+  this->num_cache_misses = 0;
+  this->num_unified_allocs = 0;
+  this->unified_bytes_in_use = 0;
+  this->max_unified_bytes_in_use = 0;
+  this->unified_bytes_prefetched = 0;
+  this->bytes_reserved = 0;
+  this->largest_free_block_bytes = 0;
 }
 
 string AllocatorStats::DebugString() const {
@@ -39,9 +51,21 @@ string AllocatorStats::DebugString() const {
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
       "NumAllocs:    %20lld\n"
-      "MaxAllocSize: %20lld\n",
+      "MaxAllocSize: %20lld\n"
+      "CacheHits:    %20lld\n"
+      "CacheMisses:  %20lld\n"
+      "UnifiedAllocs: %19lld\n"
+      "UnifiedInUse: %20lld\n"
+      "MaxUnifiedInUse: %17lld\n"
+      "UnifiedPrefetched: %15lld\n"
+      "Reserved:     %20lld\n"
+      "LargestFree:  %20lld\n",
       this->bytes_limit, this->bytes_in_use, this->max_bytes_in_use,
-      this->num_allocs, this->max_alloc_size);
+      this->num_allocs, this->max_alloc_size, this->num_cache_hits,
+      this->num_cache_misses, this->num_unified_allocs,
+      this->unified_bytes_in_use, this->max_unified_bytes_in_use,
+      this->unified_bytes_prefetched, this->bytes_reserved,
+      this->largest_free_block_bytes);
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
@@ -62,14 +86,22 @@ void EnableCPUAllocatorFullStats(bool enable) {
 
 class CPUAllocator : public Allocator {
  public:
-  CPUAllocator() {}
+  CPUAllocator() : numa_node_(port::kNUMANoAffinity) {}
+
+  // Places the memory it allocates on NUMA node "numa_node".
+  explicit CPUAllocator(int numa_node) : numa_node_(numa_node) {}
 
   ~CPUAllocator() override {}
 
-  string Name() override { return "cpu"; }
+  string Name() override {
+    if (numa_node_ == port::kNUMANoAffinity) return "cpu";
+    return strings::StrCat("cpu_numa_", numa_node_);
+  }
 
   void* AllocateRaw(size_t alignment, size_t num_bytes) override {
-    void* p = port::AlignedMalloc(num_bytes, alignment);
+    void* p = numa_node_ == port::kNUMANoAffinity
+                  ? port::AlignedMalloc(num_bytes, alignment)
+                  : port::NUMAMalloc(numa_node_, num_bytes, alignment);
     if (cpu_allocator_collect_stats) {
       const std::size_t alloc_size = port::MallocExtension_GetAllocatedSize(p);
       mutex_lock l(mu_);
@@ -90,7 +122,11 @@ class CPUAllocator : public Allocator {
       mutex_lock l(mu_);
       stats_.bytes_in_use -= alloc_size;
     }
-    port::AlignedFree(ptr);
+    if (numa_node_ == port::kNUMANoAffinity) {
+      port::AlignedFree(ptr);
+    } else {
+      port::NUMAFree(ptr);
+    }
   }
 
   void GetStats(AllocatorStats* stats) override {
@@ -103,6 +139,7 @@ class CPUAllocator : public Allocator {
   }
 
  private:
+  const int numa_node_;
   mutex mu_;
   AllocatorStats stats_ GUARDED_BY(mu_);
 
@@ -127,6 +164,25 @@ Allocator* cpu_allocator() {
   return cpu_alloc;
 }
 
+Allocator* cpu_allocator(int numa_node) {
+  if (numa_node == port::kNUMANoAffinity) return cpu_allocator();
+  CHECK_GE(numa_node, 0);
+  static mutex mu(LINKER_INITIALIZED);
+  static std::vector<Allocator*>* numa_allocators = new std::vector<Allocator*>;
+  mutex_lock l(mu);
+  if (numa_node >= static_cast<int>(numa_allocators->size())) {
+    numa_allocators->resize(numa_node + 1, nullptr);
+  }
+  Allocator*& allocator = (*numa_allocators)[numa_node];
+  if (allocator == nullptr) {
+    allocator = new CPUAllocator(numa_node);
+    if (cpu_allocator_collect_full_stats || LogMemory::IsEnabled()) {
+      allocator = new TrackingAllocator(allocator, true);
+    }
+  }
+  return allocator;
+}
+
 REGISTER_MEM_ALLOCATOR("DefaultCPUAllocator", 100, CPUAllocator);
 
 }  // namespace tensorflow
@@ -56,6 +56,26 @@ struct AllocatorStats {
   // unknown.
   int64 bytes_limit;
 
+  // Allocations served from, and missed by, an allocator's front-end caches
+  // of freed chunks. Zero for allocators without such caches.
+  int64 num_cache_hits;
+  int64 num_cache_misses;
+
+  // Allocations backed by unified memory, which is paged between host and
+  // device, once the device memory ran out, and the bytes of it prefetched to
+  // the device ahead of kernels. Zero for allocators without unified memory.
+  int64 num_unified_allocs;
+  int64 unified_bytes_in_use;
+  int64 max_unified_bytes_in_use;
+  int64 unified_bytes_prefetched;
+
+  // The bytes an allocator has reserved from the system, and the largest
+  // contiguous free block among them, which bounds the largest allocation
+  // that can succeed without reserving more. Zero for allocators that don't
+  // pool memory.
+  int64 bytes_reserved;
+  int64 largest_free_block_bytes;
+
   AllocatorStats() { Clear(); }
 
   void Clear();
@@ -355,6 +375,11 @@ struct AllocatorAttributes {
 // default malloc. The returned allocator is a process singleton.
 Allocator* cpu_allocator();
 
+// Returns a cpu allocator that places its memory on NUMA node "numa_node"
+// where the platform supports it. There is one such allocator per node for
+// the life of the process. port::kNUMANoAffinity returns cpu_allocator().
+Allocator* cpu_allocator(int numa_node);
+
 // If 'enable' is true, the process-wide cpu allocator collects
 // AllocatorStats. By default, it's disabled.
 void EnableCPUAllocatorStats(bool enable);
@@ -399,6 +399,11 @@ class FunctionLibraryRuntime {
     ScopedStepContainer* step_container;
 
     std::function<void(std::function<void()>)>* runner = nullptr;
+
+    // If true, and the function body is small and has no send/recv nodes,
+    // its nodes run on the calling thread instead of through "runner".
+    // Useful for callers that block until the function is done anyway.
+    bool run_small_functions_inline = false;
   };
   typedef std::function<void(const Status&)> DoneCallback;
   virtual void Run(const Options& opts, Handle handle,
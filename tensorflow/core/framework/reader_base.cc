@@ -140,8 +140,8 @@ Status ReaderBase::ReadUpToLocked(int64 num_records, std::vector<string>* keys,
   string value;
   Status status = ReadLocked(&key, &value, &produced, at_end);
   if (produced) {
-    keys->emplace_back(key);
-    values->emplace_back(value);
+    keys->emplace_back(std::move(key));
+    values->emplace_back(std::move(value));
     *num_read = 1;
   } else {
     *num_read = 0;
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/resource_handle.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/platform/types.h"
 
 // Two sets of macros:
@@ -137,6 +138,89 @@ limitations under the License.
 
 #endif  // defined(IS_MOBILE_PLATFORM)  - end of TF_CALL_type defines
 
+#if defined(SELECTIVE_REGISTRATION) && \
+    defined(SHOULD_REGISTER_TYPES_SELECTIVELY)
+// Drop the types that ops_to_register.h does not ask for, so that the kernels
+// and functors instantiated through the macros below are not compiled for
+// them. int32 is always kept.
+#ifndef SHOULD_REGISTER_TYPE_float
+#undef TF_CALL_float
+#define TF_CALL_float(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_double
+#undef TF_CALL_double
+#define TF_CALL_double(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_uint8
+#undef TF_CALL_uint8
+#define TF_CALL_uint8(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_int16
+#undef TF_CALL_int16
+#define TF_CALL_int16(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_int8
+#undef TF_CALL_int8
+#define TF_CALL_int8(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_string
+#undef TF_CALL_string
+#define TF_CALL_string(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_resource
+#undef TF_CALL_resource
+#define TF_CALL_resource(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_complex64
+#undef TF_CALL_complex64
+#define TF_CALL_complex64(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_int64
+#undef TF_CALL_int64
+#define TF_CALL_int64(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_bool
+#undef TF_CALL_bool
+#define TF_CALL_bool(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_qint8
+#undef TF_CALL_qint8
+#define TF_CALL_qint8(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_quint8
+#undef TF_CALL_quint8
+#define TF_CALL_quint8(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_qint32
+#undef TF_CALL_qint32
+#define TF_CALL_qint32(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_bfloat16
+#undef TF_CALL_bfloat16
+#define TF_CALL_bfloat16(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_qint16
+#undef TF_CALL_qint16
+#define TF_CALL_qint16(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_quint16
+#undef TF_CALL_quint16
+#define TF_CALL_quint16(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_uint16
+#undef TF_CALL_uint16
+#define TF_CALL_uint16(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_complex128
+#undef TF_CALL_complex128
+#define TF_CALL_complex128(m)
+#endif
+#ifndef SHOULD_REGISTER_TYPE_half
+#undef TF_CALL_half
+#define TF_CALL_half(m)
+#endif
+#endif  // SHOULD_REGISTER_TYPES_SELECTIVELY
+
 // Defines for sets of types.
 
 #define TF_CALL_INTEGRAL_TYPES(m)                                      \
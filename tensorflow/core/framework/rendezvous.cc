@@ -44,6 +44,7 @@ Rendezvous::ParsedKey& Rendezvous::ParsedKey::operator=(const ParsedKey& b) {
   dst = b.dst;
   edge_name.set(buf_.data() + (b.edge_name.data() - b_base),
                 b.edge_name.size());
+  hash_ = b.hash_;
   return *this;
 }
 
@@ -106,6 +107,7 @@ Status Rendezvous::ParseKey(StringPiece key, ParsedKey* out) {
     out->src_device.set(parts[0].data(), parts[0].size());
     out->dst_device.set(parts[2].data(), parts[2].size());
     out->edge_name.set(parts[3].data(), parts[3].size());
+    out->hash_ = Hash64(out->buf_.data(), out->buf_.size());
     return Status::OK();
   }
   return errors::InvalidArgument("Invalid  rendezvous key: ", key);
@@ -154,16 +156,17 @@ class LocalRendezvousImpl : public Rendezvous {
               const bool is_dead) override {
     DoneCallback waiter = nullptr;
     Args recv_args;
-    uint64 key_hash = KeyHash(key.FullKey());
+    uint64 key_hash = key.FullKeyHash();
     VLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
+    Shard* shard = GetShard(key_hash);
     {
-      mutex_lock l(mu_);
-      if (!status_.ok()) {
-        return status_;
+      mutex_lock l(shard->mu);
+      if (!shard->status.ok()) {
+        return shard->status;
       }
       Item* item = nullptr;
-      Table::iterator iter = table_.find(key_hash);
-      if (iter == table_.end()) {
+      Table::iterator iter = shard->table.find(key_hash);
+      if (iter == shard->table.end()) {
         // There is no waiter for this message. Insert the message
         // into the waiters table. The waiter will pick it up when
         // arrives.
@@ -180,7 +183,7 @@ class LocalRendezvousImpl : public Rendezvous {
         // The allocator attributes of item->value.
         item->send_alloc_attrs = send_args.alloc_attrs;
 
-        CHECK(table_.insert({key_hash, item}).second);
+        CHECK(shard->table.insert({key_hash, item}).second);
         return Status::OK();
       } else {
         item = iter->second;
@@ -222,21 +225,22 @@ class LocalRendezvousImpl : public Rendezvous {
 
   void RecvAsync(const ParsedKey& key, const Args& recv_args,
                  DoneCallback done) override {
-    uint64 key_hash = KeyHash(key.FullKey());
+    uint64 key_hash = key.FullKeyHash();
     VLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      shard->mu.unlock();
       done(s, Args(), recv_args, Tensor(), false);
       return;
     }
-    Table::iterator iter = table_.find(key_hash);
-    if (iter != table_.end()) {
+    Table::iterator iter = shard->table.find(key_hash);
+    if (iter != shard->table.end()) {
       Item* item = iter->second;
       if (item->has_been_recvd && !tolerate_dup_recv_) {
-        mu_.unlock();
+        shard->mu.unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       } else if (item->waiter == nullptr || tolerate_dup_recv_) {
@@ -259,13 +263,13 @@ class LocalRendezvousImpl : public Rendezvous {
         Args send_args;
         send_args.device_context = item->send_dev_context;
         send_args.alloc_attrs = item->send_alloc_attrs;
-        mu_.unlock();
+        shard->mu.unlock();
         done(Status::OK(), send_args, recv_args, v, is_dead);
         if (send_dev_context) send_dev_context->Unref();
       } else {
         // Already have a waiter in the waiters table under this key,
         // which should not happen.
-        mu_.unlock();
+        shard->mu.unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       }
@@ -281,20 +285,19 @@ class LocalRendezvousImpl : public Rendezvous {
       item->recv_dev_context = recv_args.device_context;
       item->recv_dev_context->Ref();
     }
-    CHECK(table_.insert({key_hash, item}).second);
-    mu_.unlock();
+    CHECK(shard->table.insert({key_hash, item}).second);
+    shard->mu.unlock();
   }
 
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
     std::vector<Item*> items;
-    {
-      mutex_lock l(mu_);
-      if (!status_.ok()) return;
-      status_ = status;
-      items.reserve(table_.size());
-      for (const auto& p : table_) items.push_back(p.second);
-      table_.clear();
+    for (Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      if (!shard.status.ok()) return;
+      shard.status = status;
+      for (const auto& p : shard.table) items.push_back(p.second);
+      shard.table.clear();
     }
     for (Item* item : items) {
       if (item->waiter != nullptr) {
@@ -327,27 +330,40 @@ class LocalRendezvousImpl : public Rendezvous {
       }
     }
   };
-  // We key the hash table by KeyHash of the Rendezvous::CreateKey string
-  static uint64 KeyHash(const StringPiece& k) {
-    return Hash64(k.data(), k.size());
-  }
-
+  // We key the hash tables by the Hash64 of the Rendezvous::CreateKey
+  // string, see ParsedKey::FullKeyHash().
   typedef gtl::FlatMap<uint64, Item*> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_;
+  // The keys are spread over shards with their own locks, so that the
+  // Send/Recv pairs of different edges, e.g. between the devices of a
+  // multi-GPU step, don't contend. A Send and its Recv use the same shard.
+  struct Shard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+    // Set on every shard by StartAbort().
+    Status status GUARDED_BY(mu);
+  };
+  static constexpr int kNumShards = 16;
+  Shard shards_[kNumShards];
+
+  Shard* GetShard(uint64 key_hash) {
+    // The tables index by the low bits, so pick the shard with high bits.
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
 
   ~LocalRendezvousImpl() override {
-    for (auto i : table_) {
-      delete i.second;
+    for (Shard& shard : shards_) {
+      for (auto i : shard.table) {
+        delete i.second;
+      }
     }
   }
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvousImpl);
 };
 
+constexpr int LocalRendezvousImpl::kNumShards;
+
 Rendezvous* NewLocalRendezvous(bool tolerate_dup_recv) {
   return new LocalRendezvousImpl(tolerate_dup_recv);
 }
@@ -42,6 +42,13 @@ class Rendezvous : public core::RefCounted {
   struct Args {
     DeviceContext* device_context = nullptr;
     AllocatorAttributes alloc_attrs;
+    // For rendezvous that receive tensors from other processes: the
+    // TensorCompressionOptions::Type to ask the sender to apply, or -1 to use
+    // the rendezvous' default.
+    int wire_compression = -1;
+    // For rendezvous that limit the number of tensors in flight: tensors with
+    // smaller priorities are received first.
+    int64 priority = 0;
   };
 
   // Constructs a rendezvous key for the tensor of "name" sent from
@@ -67,11 +74,16 @@ class Rendezvous : public core::RefCounted {
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
 
+    // The Hash64 of FullKey(), computed once by ParseKey so that the ops
+    // that cache their keys don't hash them on every step.
+    uint64 FullKeyHash() const { return hash_; }
+
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     string buf_;
+    uint64 hash_ = 0;
   };
   static Status ParseKey(StringPiece key, ParsedKey* out);
 
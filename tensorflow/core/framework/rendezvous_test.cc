@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -52,6 +53,10 @@ TEST(RendezvousTest, Key) {
   EXPECT_EQ(parsed.src.type, "CPU");
   EXPECT_EQ(parsed.dst_device, "/job:mnist/replica:1/task:2/GPU:0");
   EXPECT_EQ(parsed.dst.type, "GPU");
+  EXPECT_EQ(parsed.FullKeyHash(), Hash64(key));
+  Rendezvous::ParsedKey copied(parsed);
+  EXPECT_EQ(copied.FullKey(), key);
+  EXPECT_EQ(copied.FullKeyHash(), parsed.FullKeyHash());
 
   EXPECT_FALSE(Rendezvous::ParseKey("foo;bar;baz", &parsed).ok());
   EXPECT_FALSE(Rendezvous::ParseKey("/job:mnist/replica:1/task:2/CPU:0;"
@@ -251,6 +256,30 @@ TEST_F(LocalRendezvousTest, RecvSleepAbort) {
   EXPECT_TRUE(errors::IsAborted(status));
 }
 
+TEST_F(LocalRendezvousTest, AbortManyRecvs) {
+  // Enough keys to wait in every shard of the rendezvous.
+  static const int N = 100;
+  BlockingState state;
+  state.counter = N;
+  for (int i = 0; i < N; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat(i)), Rendezvous::Args(),
+        [&state](const Status& s, const Rendezvous::Args& send_args,
+                 const Rendezvous::Args& recv_args, const Tensor& val,
+                 bool is_dead) {
+          EXPECT_TRUE(errors::IsAborted(s));
+          mutex_lock l(state.lock);
+          if (--state.counter == 0) state.done.Notify();
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  state.done.WaitForNotification();
+  Tensor val(DT_STRING);
+  bool val_dead = false;
+  EXPECT_TRUE(errors::IsAborted(
+      rendez_->Send(MakeKey("0"), Rendezvous::Args(), val, val_dead)));
+}
+
 TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
   rendez_->StartAbort(errors::Aborted(""));
   Tensor val(DT_STRING);
@@ -346,4 +375,40 @@ static void BM_RecvSend(int iters) {
 }
 BENCHMARK(BM_RecvSend);
 
+static void BM_SendRecvParallel(int iters, int num_threads) {
+  // Each thread sends and receives under its own keys, as the edges between
+  // the devices of a step do.
+  testing::StopTiming();
+  Rendezvous* rendez = NewLocalRendezvous();
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < num_threads; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("edge", i)));
+  }
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  BlockingState state;
+  state.counter = num_threads;
+  testing::StartTiming();
+  for (int i = 0; i < num_threads; ++i) {
+    pool->Schedule([rendez, &keys, &state, i, iters]() {
+      Tensor orig = V("val");
+      Tensor val(DT_STRING, TensorShape({}));
+      bool is_dead = false;
+      Rendezvous::Args args;
+      Status s;
+      for (int j = 0; j < iters; ++j) {
+        s = rendez->Send(keys[i], args, orig, is_dead);
+        s = rendez->Recv(keys[i], args, &val, &is_dead);
+      }
+      mutex_lock l(state.lock);
+      if (--state.counter == 0) state.done.Notify();
+    });
+  }
+  state.done.WaitForNotification();
+  testing::StopTiming();
+  delete pool;
+  rendez->Unref();
+}
+BENCHMARK(BM_SendRecvParallel)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace tensorflow
@@ -42,6 +42,17 @@ limitations under the License.
 //   // Op kernel classes where this is false won't be registered.
 //   SHOULD_REGISTER_OP_KERNEL(clz)
 // The macros should be defined using constexprs.
+//
+// ops_to_register.h may also define the following, which are evaluated by the
+// preprocessor so that template instantiations unused by the model are not
+// compiled at all, rather than relying on the linker to drop them:
+//   // Largest tensor rank handled by the rank-specialized kernels (Slice,
+//   // StridedSlice, TileGrad). Must be an integer literal.
+//   SHOULD_REGISTER_MAX_RANK
+//   // If defined, the TF_CALL_<type> macros of register_types.h only expand
+//   // for the types with a SHOULD_REGISTER_TYPE_<type> define (int32 is always
+//   // kept, as shapes and indices need it).
+//   SHOULD_REGISTER_TYPES_SELECTIVELY
 
 #include "ops_to_register.h"
 
@@ -55,4 +66,51 @@ static_assert(false, "ops_to_register.h must define SHOULD_REGISTER macros");
 #define SHOULD_REGISTER_OP_KERNEL(clz) true
 #endif
 
+#ifndef SHOULD_REGISTER_MAX_RANK
+#define SHOULD_REGISTER_MAX_RANK 8
+#endif
+
+// IF_SHOULD_REGISTER_RANK(n, ...) expands to its trailing arguments if kernels
+// for tensors of rank n are needed, and to nothing otherwise. n must be an
+// integer literal. Ranks 0 and 1 are always needed.
+#define IF_SHOULD_REGISTER_RANK(n, ...) \
+  IF_SHOULD_REGISTER_RANK_##n(__VA_ARGS__)
+#define IF_SHOULD_REGISTER_RANK_0(...) __VA_ARGS__
+#define IF_SHOULD_REGISTER_RANK_1(...) __VA_ARGS__
+#if SHOULD_REGISTER_MAX_RANK >= 2
+#define IF_SHOULD_REGISTER_RANK_2(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_2(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 3
+#define IF_SHOULD_REGISTER_RANK_3(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_3(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 4
+#define IF_SHOULD_REGISTER_RANK_4(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_4(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 5
+#define IF_SHOULD_REGISTER_RANK_5(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_5(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 6
+#define IF_SHOULD_REGISTER_RANK_6(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_6(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 7
+#define IF_SHOULD_REGISTER_RANK_7(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_7(...)
+#endif
+#if SHOULD_REGISTER_MAX_RANK >= 8
+#define IF_SHOULD_REGISTER_RANK_8(...) __VA_ARGS__
+#else
+#define IF_SHOULD_REGISTER_RANK_8(...)
+#endif
+
 #endif  // TENSORFLOW_FRAMEWORK_SELECTIVE_REGISTRATION_H_
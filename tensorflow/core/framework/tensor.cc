@@ -23,6 +23,9 @@ limitations under the License.
 //   default constructors and destructors when T is not a simple type
 //   (e.g., string.), and skips them otherwise.
 //
+// * InlineBuffer: holds the data of a small tensor of a simple type in
+//   the same allocation as the buffer object.
+//
 // * Helper<T>: provides various routines given type T.  The routines
 //   includes running the constructor and destructor of T[], encoding
 //   an decoding T[] into/from a Cord, etc.
@@ -42,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -102,6 +106,57 @@ class Buffer : public BufferBase {
   TF_DISALLOW_COPY_AND_ASSIGN(Buffer);
 };
 
+// Ref-counted buffer for tensors of at most kMaxBytes bytes of a simple
+// type, whose data is stored inline. Scalars such as shapes, indices and
+// loop counters make up most of the tensors produced by control-flow-heavy
+// graphs, and this saves a trip through the allocator for each of them.
+// Only used in place of the CPU allocator, whose memory it behaves like.
+class InlineBuffer : public TensorBuffer {
+ public:
+  static constexpr size_t kMaxBytes = 16;
+
+  explicit InlineBuffer(size_t size) : size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(cpu_allocator()->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  // The data must be aligned as if it came from the allocator, which
+  // operator new doesn't guarantee for over-aligned types.
+  static void* operator new(size_t size) {
+    return port::AlignedMalloc(size, Allocator::kAllocatorAlignment);
+  }
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+
+ private:
+  ~InlineBuffer() override {}
+
+  const size_t size_;
+  alignas(Allocator::kAllocatorAlignment) char data_[kMaxBytes];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Returns an InlineBuffer for n elements of "type" if they would otherwise
+// be allocated by "a" and fit in one, else nullptr. Allocators that track
+// sizes and memory logging need every tensor to go through the allocator.
+TensorBuffer* MaybeNewInlineBuffer(Allocator* a, DataType type, int64 n) {
+  const int64 kMaxBytes = InlineBuffer::kMaxBytes;
+  if (n > kMaxBytes || !DataTypeCanUseMemcpy(type)) return nullptr;
+  const int64 bytes = n * DataTypeSize(type);
+  if (bytes == 0 || bytes > kMaxBytes ||
+      a != cpu_allocator() || a->TracksAllocationSizes() ||
+      LogMemory::IsEnabled()) {
+    return nullptr;
+  }
+  return new InlineBuffer(bytes);
+}
+
 void LogUnexpectedSize(int64 actual, int64 expected) {
   LOG(ERROR) << "Input size was " << actual << " and expected " << expected;
 }
@@ -586,7 +641,10 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    buf_ = MaybeNewInlineBuffer(a, type, shape.num_elements());
+    if (buf_ == nullptr) {
+      CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    }
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
     LogMemory::RecordTensorAllocation("Unknown", LogMemory::UNKNOWN_STEP_ID,
@@ -600,7 +658,11 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    buf_ = MaybeNewInlineBuffer(a, type, shape.num_elements());
+    if (buf_ == nullptr) {
+      CASES(type,
+            buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    }
   }
   if (!allocation_attr.allocation_will_be_logged && buf_ != nullptr &&
       buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -672,6 +734,35 @@ Tensor Tensor::Slice(int64 start, int64 limit) const {
   return ret;
 }
 
+/* static */ bool Tensor::ConcatAdjacentSlices(gtl::ArraySlice<Tensor> slices,
+                                               const TensorShape& shape,
+                                               Tensor* result) {
+  if (slices.empty() || slices[0].buf_ == nullptr) return false;
+  const DataType dt = slices[0].dtype();
+  size_t element_size = 0;
+  CASES_WITH_DEFAULT(dt, element_size = sizeof(T), return false, return false);
+  TensorBuffer* first = slices[0].buf_;
+  const char* end = first->base<const char>();
+  int64 num_elements = 0;
+  for (const Tensor& slice : slices) {
+    if (slice.dtype() != dt || slice.buf_ == nullptr ||
+        slice.buf_->root_buffer() != first->root_buffer() ||
+        slice.buf_->base<const char>() != end) {
+      return false;
+    }
+    end += slice.NumElements() * element_size;
+    num_elements += slice.NumElements();
+  }
+  CHECK_EQ(num_elements, shape.num_elements());
+  Tensor ret;
+  ret.shape_ = shape;
+  ret.set_dtype(dt);
+  ret.buf_ = nullptr;
+  CASES(dt, ret.buf_ = new SubBuffer<T>(first, 0, num_elements));
+  *result = std::move(ret);
+  return true;
+}
+
 bool Tensor::FromProto(const TensorProto& proto) {
   return FromProto(cpu_allocator(), proto);
 }
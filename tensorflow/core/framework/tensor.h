@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -194,6 +195,20 @@ class Tensor {
   /// REQUIRES: `0 <= dim0_start <= dim0_limit <= dim_size(0)`
   Tensor Slice(int64 dim0_start, int64 dim0_limit) const;
 
+  /// \brief Concatenates `slices` along the 1st dimension without copying.
+
+  /// This is possible if the slices are adjacent regions of one buffer, in
+  /// order, e.g. consecutive `Slice()`s of the same tensor. On success,
+  /// returns `true` and sets `*result` to a tensor of `shape` that shares
+  /// the buffer of `slices`. Otherwise returns `false` and leaves `*result`
+  /// unchanged, in which case the caller must copy the slices.
+  ///
+  /// The same alignment caveat as for `Slice()` applies to `*result`.
+  ///
+  /// REQUIRES: `shape.num_elements()` is the total size of `slices`.
+  static bool ConcatAdjacentSlices(gtl::ArraySlice<Tensor> slices,
+                                   const TensorShape& shape, Tensor* result);
+
   /// \brief Parse `other` and construct the tensor.
 
   /// Returns `true` iff the parsing succeeds. If the parsing fails,
@@ -459,6 +474,12 @@ class Tensor {
   template <typename Device, typename T>
   friend class CreateVariableOp;
   friend class OpKernelContext;  // For access to RefCountIsOne().
+  friend class BundleReader;     // For access to the private constructor
+                                 // taking the buffer.
+  friend class ColumnarReader;   // For access to the private constructor
+                                 // taking the buffer.
+  friend class TensorResponse;     // For access to the private constructor
+                                   // taking the buffer.
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
 
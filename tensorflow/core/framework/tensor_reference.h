@@ -49,6 +49,9 @@ class TensorReference {
     if (buf_) buf_->FillAllocationDescription(description);
   }
 
+  // Returns the base address of the referenced buffer, or nullptr.
+  const void* data() const { return buf_ ? buf_->data() : nullptr; }
+
   // Convenience function for de-duplicating tensor references.
   bool SharesBufferWith(const TensorReference& t) const {
     return buf_ == t.buf_;
@@ -873,6 +873,45 @@ TEST(Tensor, FailureToAllocate) {
   }
 }
 
+// Tensors of at most 16 bytes allocated on the CPU keep their data inline
+// in the buffer; they must behave like any other tensor.
+TEST(Tensor, SmallTensors) {
+  for (const TensorShape& shape :
+       {TensorShape({}), TensorShape({4}), TensorShape({2, 2})}) {
+    Tensor a(DT_INT32, shape);
+    EXPECT_TRUE(a.IsInitialized());
+    EXPECT_TRUE(a.IsAligned());
+    EXPECT_EQ(shape.num_elements() * sizeof(int32), a.TotalBytes());
+    EXPECT_EQ(shape.num_elements() * sizeof(int32), a.tensor_data().size());
+    auto flat = a.flat<int32>();
+    for (int i = 0; i < flat.size(); ++i) flat(i) = i + 1;
+
+    TensorDescription tensor_desc;
+    a.FillDescription(&tensor_desc);
+    const AllocationDescription& desc = tensor_desc.allocation_description();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.tensor_data().data()),
+              desc.ptr());
+    EXPECT_EQ(a.TotalBytes(), desc.requested_bytes());
+
+    // Copies share the buffer.
+    Tensor b = a;
+    EXPECT_TRUE(a.SharesBufferWith(b));
+    EXPECT_EQ(a.tensor_data().data(), b.tensor_data().data());
+    test::ExpectTensorEqual<int32>(a, b);
+
+    Tensor c(DT_INT32, shape);
+    EXPECT_FALSE(a.SharesBufferWith(c));
+    EXPECT_NE(a.tensor_data().data(), c.tensor_data().data());
+  }
+
+  // Larger tensors and non-simple types still use the allocator.
+  Tensor big(DT_INT64, TensorShape({3}));
+  EXPECT_TRUE(big.IsAligned());
+  Tensor str(DT_STRING, TensorShape({}));
+  str.scalar<string>()() = "not inline";
+  EXPECT_EQ("not inline", str.scalar<string>()());
+}
+
 // On the alignment.
 //
 // As of 2015/8, tensorflow::Tensor allocates its buffer with 32-byte
@@ -955,6 +994,37 @@ TEST(Tensor, Slice_Basic) {
   }
 }
 
+TEST(Tensor, ConcatAdjacentSlices) {
+  Tensor x(DT_FLOAT, TensorShape({10, 4}));
+  for (int i = 0; i < 10; ++i) {
+    x.Slice(i, i + 1).flat<float>().setConstant(i * 1.f);
+  }
+  Tensor result;
+  // Consecutive slices are joined into a view of x.
+  EXPECT_TRUE(Tensor::ConcatAdjacentSlices(
+      {x.Slice(2, 4), x.Slice(4, 5), x.Slice(5, 8)}, TensorShape({6, 4}),
+      &result));
+  EXPECT_TRUE(result.shape().IsSameSize(TensorShape({6, 4})));
+  EXPECT_TRUE(result.SharesBufferWith(x));
+  EXPECT_EQ(&x.matrix<float>()(2, 0), result.matrix<float>().data());
+  EXPECT_EQ(7.0, result.matrix<float>()(5, 3));
+  // The result may take any shape that holds the slices.
+  EXPECT_TRUE(Tensor::ConcatAdjacentSlices({x.Slice(0, 2), x.Slice(2, 10)},
+                                           TensorShape({40}), &result));
+  EXPECT_EQ(x.flat<float>().data(), result.flat<float>().data());
+
+  // Slices out of order, with a gap, or of different buffers are not.
+  Tensor unchanged = result;
+  EXPECT_FALSE(Tensor::ConcatAdjacentSlices({x.Slice(4, 5), x.Slice(2, 4)},
+                                            TensorShape({3, 4}), &result));
+  EXPECT_FALSE(Tensor::ConcatAdjacentSlices({x.Slice(2, 4), x.Slice(5, 6)},
+                                            TensorShape({3, 4}), &result));
+  Tensor other(DT_FLOAT, TensorShape({10, 4}));
+  EXPECT_FALSE(Tensor::ConcatAdjacentSlices(
+      {x.Slice(8, 10), other.Slice(0, 1)}, TensorShape({3, 4}), &result));
+  EXPECT_EQ(unchanged.flat<float>().data(), result.flat<float>().data());
+}
+
 namespace {
 template <typename T>
 Tensor MkTensor(DataType dt, const TensorShape& shape,
@@ -1025,6 +1095,14 @@ static void BM_CreateAndDestroy(int iters) {
 }
 BENCHMARK(BM_CreateAndDestroy);
 
+static void BM_CreateAndDestroyScalar(int iters) {
+  TensorShape shape({});
+  while (--iters) {
+    Tensor t(DT_INT32, shape);
+  }
+}
+BENCHMARK(BM_CreateAndDestroyScalar);
+
 static void BM_Assign(int iters) {
   Tensor a(DT_FLOAT, TensorShape({10, 20}));
   Tensor b(DT_FLOAT, TensorShape({10, 20}));
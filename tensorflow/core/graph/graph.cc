@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph.h"
 
+#include <utility>
 #include <vector>
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -37,6 +38,12 @@ struct NodeProperties {
         node_def(node_def),
         input_types(inputs.begin(), inputs.end()),
         output_types(outputs.begin(), outputs.end()) {}
+  NodeProperties(const OpDef* op_def, NodeDef&& node_def,
+                 const DataTypeSlice inputs, const DataTypeSlice outputs)
+      : op_def(op_def),
+        node_def(std::move(node_def)),
+        input_types(inputs.begin(), inputs.end()),
+        output_types(outputs.begin(), outputs.end()) {}
 
   const OpDef* op_def;  // not owned
   NodeDef node_def;
@@ -320,6 +327,13 @@ Node* Graph::AddNode(const NodeDef& node_def, Status* status) {
   return node;
 }
 
+Node* Graph::AddNode(NodeDef&& node_def, const OpDef* op_def,
+                     DataTypeSlice inputs, DataTypeSlice outputs) {
+  return AllocateNode(std::make_shared<NodeProperties>(
+                          op_def, std::move(node_def), inputs, outputs),
+                      nullptr);
+}
+
 Node* Graph::CopyNode(Node* node) {
   DCHECK(!node->IsSource());
   DCHECK(!node->IsSink());
@@ -378,6 +378,12 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(const NodeDef& node_def, Status* status);
 
+  // Like AddNode above, but for callers that have already looked up the
+  // Op of "node_def" and computed its input/output types with
+  // InOutTypesForNode. Moves "node_def" into the node instead of copying it.
+  Node* AddNode(NodeDef&& node_def, const OpDef* op_def, DataTypeSlice inputs,
+                DataTypeSlice outputs);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
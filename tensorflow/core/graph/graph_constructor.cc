@@ -33,10 +33,14 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -99,19 +103,21 @@ class GraphConstructor {
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
 
-  // versions and library may be nullptr
-  static Status Construct(const Options& opts, NodeDefSlice node_defs,
-                          const VersionDef* versions,
-                          const FunctionDefLibrary* library, Graph* g,
-                          ShapeRefiner* refiner,
-                          std::vector<std::pair<Node*, int>>* return_tensors) {
+  // versions and library may be nullptr. If movable_node_defs is not null,
+  // it holds the same NodeDefs as node_defs, which are moved into g rather
+  // than copied.
+  static Status Construct(
+      const Options& opts, NodeDefSlice node_defs, const VersionDef* versions,
+      const FunctionDefLibrary* library, Graph* g, ShapeRefiner* refiner,
+      std::vector<std::pair<Node*, int>>* return_tensors,
+      protobuf::RepeatedPtrField<NodeDef>* movable_node_defs = nullptr) {
     if (versions) {
       TF_RETURN_IF_ERROR(CheckVersions(*versions, TF_GRAPH_DEF_VERSION,
                                        TF_GRAPH_DEF_VERSION_MIN_PRODUCER,
                                        "GraphDef", "graph"));
     }
     GraphConstructor c(opts, node_defs, versions, library, g, refiner,
-                       return_tensors);
+                       return_tensors, movable_node_defs);
     const Status s = c.TryImport();
     if (!s.ok()) c.Undo();
     return s;
@@ -122,7 +128,8 @@ class GraphConstructor {
                    const VersionDef* versions,
                    const FunctionDefLibrary* library, Graph* g,
                    ShapeRefiner* refiner,
-                   std::vector<std::pair<Node*, int>>* return_tensors)
+                   std::vector<std::pair<Node*, int>>* return_tensors,
+                   protobuf::RepeatedPtrField<NodeDef>* movable_node_defs)
       : opts_(opts),
         node_defs_(node_defs),
         versions_(versions),
@@ -130,7 +137,12 @@ class GraphConstructor {
         g_(g),
         original_versions_(g->versions()),
         refiner_(refiner),
-        return_tensors_(return_tensors) {}
+        return_tensors_(return_tensors),
+        movable_node_defs_(movable_node_defs) {
+    // Imported NodeDefs are rewritten before they are added, so they are
+    // never moved.
+    DCHECK(movable_node_defs_ == nullptr || !opts_.importing);
+  }
 
   Status TryImport() {
     TF_RETURN_IF_ERROR(EnsureNoNameCollisions());
@@ -149,6 +161,7 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  Status ComputeNodeTypes();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -158,6 +171,7 @@ class GraphConstructor {
 
   Status ValidateColocationConstraints(const NodeDef& node_def);
   Status MakeNode(const NodeDef& node_def, Node** node);
+  Node* MoveNode(int index);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -188,6 +202,18 @@ class GraphConstructor {
   // May be null. Not owned.
   std::vector<std::pair<Node*, int>>* return_tensors_;
 
+  // May be null. Not owned.
+  protobuf::RepeatedPtrField<NodeDef>* movable_node_defs_;
+
+  // The Op and input/output types of each NodeDef in node_defs_. Only
+  // computed, by ComputeNodeTypes(), when the NodeDefs are moved.
+  struct NodeTypes {
+    const OpDef* op_def = nullptr;
+    DataTypeVector inputs;
+    DataTypeVector outputs;
+  };
+  std::vector<NodeTypes> node_types_;
+
   // Mapping from node name to the index within node_defs_
   struct NodeInfo {
     explicit NodeInfo(int i) : gdef_index(i), node(nullptr) {}
@@ -457,6 +483,50 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
+Status GraphConstructor::ComputeNodeTypes() {
+  // Look up each op once, rather than once per node.
+  std::unordered_map<StringPiece, const OpDef*, StringPiece::Hasher> op_defs;
+  const int num_nodes = node_defs_.size();
+  node_types_.resize(num_nodes);
+  for (int n = 0; n < num_nodes; ++n) {
+    const NodeDef& node_def = *node_defs_[n];
+    const OpDef*& op_def = op_defs[node_def.op()];
+    if (op_def == nullptr) {
+      TF_RETURN_IF_ERROR(
+          g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
+    }
+    node_types_[n].op_def = op_def;
+  }
+
+  // Checking the attrs of each node against its op is the bulk of the
+  // work, and the nodes are independent, so check them in parallel.
+  std::vector<Status> statuses(num_nodes);
+  auto compute_types = [this, &statuses](int64 start, int64 limit) {
+    for (int64 n = start; n < limit; ++n) {
+      const NodeDef& node_def = *node_defs_[n];
+      NodeTypes* types = &node_types_[n];
+      Status s = InOutTypesForNode(node_def, *types->op_def, &types->inputs,
+                                   &types->outputs);
+      if (!s.ok()) statuses[n] = AttachDef(s, node_def);
+    }
+  };
+  const int kMinNodesPerThread = 10000;
+  const int num_threads =
+      std::min(port::NumSchedulableCPUs(), num_nodes / kMinNodesPerThread);
+  if (num_threads > 1) {
+    thread::ThreadPool pool(Env::Default(), "graph_constructor", num_threads);
+    // Roughly the cost of InOutTypesForNode() on a typical node.
+    const int64 kCostPerNode = 1000;
+    Shard(num_threads, &pool, num_nodes, kCostPerNode, compute_types);
+  } else {
+    compute_types(0, num_nodes);
+  }
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
 Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
   // Add the node to the graph.
   Status status;
@@ -468,6 +538,17 @@ Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
   return Status::OK();
 }
 
+Node* GraphConstructor::MoveNode(int index) {
+  const NodeTypes& types = node_types_[index];
+  Node* node =
+      g_->AddNode(std::move(*movable_node_defs_->Mutable(index)), types.op_def,
+                  types.inputs, types.outputs);
+  if (opts_.expect_device_spec) {
+    node->set_assigned_device_name(node->def().device());
+  }
+  return node;
+}
+
 Status GraphConstructor::ValidateShape(Node* node) {
   if (!opts_.importing) return Status::OK();
   TF_RETURN_IF_ERROR(refiner_->AddNode(node));
@@ -672,6 +753,9 @@ Status GraphConstructor::Convert() {
   if (library_) {
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library_));
   }
+  if (movable_node_defs_ != nullptr) {
+    TF_RETURN_IF_ERROR(ComputeNodeTypes());
+  }
 
   std::vector<InputInfo> inputs;
   int processed = 0;
@@ -762,9 +846,21 @@ Status GraphConstructor::Convert() {
       AddPrefixToNodeDef(input_already_exists, &imported_node_def);
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
     }
-    TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
-    // Use original_node_def so name StringPiece remains valid
-    gdef_nodes_[original_node_def.name()].node = node;
+    if (movable_node_defs_ != nullptr) {
+      // The key of the node in gdef_nodes_ points into the NodeDef that is
+      // about to be moved, so re-key it with the name owned by the node.
+      auto iter = gdef_nodes_.find(original_node_def.name());
+      NodeInfo info = iter->second;
+      gdef_nodes_.erase(iter);
+      node = MoveNode(o);
+      info.node = node;
+      gdef_nodes_.emplace(node->name(), info);
+      node_def = &node->def();
+    } else {
+      TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
+      // Use original_node_def so name StringPiece remains valid
+      gdef_nodes_[original_node_def.name()].node = node;
+    }
 
     // Add edges from inputs to *node to the graph.
     for (size_t i = 0; i < inputs.size(); ++i) {
@@ -907,6 +1003,14 @@ Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      &gdef.library(), g, &refiner, nullptr);
 }
 
+Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
+                              GraphDef&& gdef, Graph* g) {
+  ShapeRefiner refiner(gdef.versions().producer(), g->op_registry());
+  return GraphConstructor::Construct(opts, gdef.node(), &gdef.versions(),
+                                     &gdef.library(), g, &refiner, nullptr,
+                                     gdef.mutable_node());
+}
+
 Status ConvertNodeDefsToGraph(const GraphConstructorOptions& opts,
                               gtl::ArraySlice<NodeDef> nodes, Graph* g) {
   ShapeRefiner refiner(TF_GRAPH_DEF_VERSION, g->op_registry());
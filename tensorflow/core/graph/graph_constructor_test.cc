@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_constructor.h"
 
+#include <utility>
 #include <vector>
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
@@ -892,6 +893,55 @@ TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
       {"Node 't2': Control dependencies must come after regular dependencies"});
 }
 
+TEST_F(GraphConstructorTest, MovedGraphDef) {
+  GraphDef def;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 'input' op: 'TestInput' input: [ '^W1' ] }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'input:1' ] }"
+      "node { name: 't2' op: 'TestOneInputOneOutput' input: [ 't1', '^W1' ] "
+      "       attr { key: 'T' value { type: DT_FLOAT } } }",
+      &def));
+  GraphConstructorOptions opts;
+  TF_EXPECT_OK(ConvertGraphDefToGraph(opts, std::move(def), &graph_));
+  EXPECT_TRUE(HasNode("W1"));
+  EXPECT_TRUE(HasNode("input"));
+  EXPECT_TRUE(HasEdge("W1", 0, "t1", 0));
+  EXPECT_TRUE(HasEdge("input", 1, "t1", 1));
+  EXPECT_TRUE(HasEdge("t1", 0, "t2", 0));
+  EXPECT_TRUE(HasControlEdge("W1", "input"));
+  EXPECT_TRUE(HasControlEdge("W1", "t2"));
+  const Node* t2 = FindNode("t2");
+  ASSERT_TRUE(t2 != nullptr);
+  EXPECT_EQ(DT_FLOAT, t2->output_type(0));
+  EXPECT_EQ("TestOneInputOneOutput", t2->def().op());
+}
+
+TEST_F(GraphConstructorTest, MovedGraphDef_Errors) {
+  const string original_graph_description = GraphDebugString();
+  GraphConstructorOptions opts;
+
+  GraphDef def;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'TestOneInputOneOutput' input: [ 'input' ] "
+      "       attr { key: 'T' value { type: DT_STRING } } }",
+      &def));
+  Status s = ConvertGraphDefToGraph(opts, std::move(def), &graph_);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("t1")) << s;
+
+  def.Clear();
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'NotARegisteredOp' input: [ 'input' ] }",
+      &def));
+  s = ConvertGraphDefToGraph(opts, std::move(def), &graph_);
+  EXPECT_FALSE(s.ok());
+
+  EXPECT_EQ(original_graph_description, GraphDebugString());
+}
+
 TEST_F(GraphConstructorTest, ImportGraphDef) {
   GraphDef def;
   ImportGraphDefOptions opts;
@@ -2491,5 +2541,41 @@ versions {
   EXPECT_EQ(17, refiner.graph_def_version());
 }
 
+// Imports a chain of "num_nodes" nodes, copying or moving the NodeDefs.
+static void BM_ConvertGraphDefToGraph(int iters, int num_nodes, int move) {
+  testing::StopTiming();
+  GraphDef def;
+  NodeDef* input = def.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  string prev = "input";
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = def.add_node();
+    node->set_name(strings::StrCat("n", i));
+    node->set_op("TestOneInputOneOutput");
+    node->add_input(prev);
+    (*node->mutable_attr())["T"].set_type(DT_FLOAT);
+    prev = node->name();
+  }
+  GraphConstructorOptions opts;
+  for (int i = 0; i < iters; ++i) {
+    GraphDef copy = def;
+    Graph graph(OpRegistry::Global());
+    testing::StartTiming();
+    if (move) {
+      TF_CHECK_OK(ConvertGraphDefToGraph(opts, std::move(copy), &graph));
+    } else {
+      TF_CHECK_OK(ConvertGraphDefToGraph(opts, copy, &graph));
+    }
+    testing::StopTiming();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(1 << 10, 1)
+    ->ArgPair(1 << 20, 0)
+    ->ArgPair(1 << 20, 1);
+
 }  // namespace
 }  // namespace tensorflow
@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <algorithm>
 #include <deque>
+#include <map>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/memory_types.h"
 #include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/control_flow.h"
@@ -721,6 +726,229 @@ Status AddControlFlow(const PartitionOptions& opts, Graph* g,
   return Status::OK();
 }
 
+// A tensor sent from one device to another that is small enough to be
+// packed with other such tensors into a single send.
+struct FusibleTensor {
+  Node* src;
+  int src_output;
+  TensorShape shape;
+  std::vector<const Edge*> edges;
+};
+
+// Returns true iff 'edge' carries a small, statically shaped floating point
+// tensor across partitions, in which case its shape is stored in *shape.
+bool IsFusibleEdge(const PartitionOptions& opts, const GraphInfo& info,
+                   const ShapeRefiner& refiner, const Edge* edge,
+                   TensorShape* shape) {
+  if (edge->IsControlEdge()) return false;
+  const Node* src = edge->src();
+  const Node* dst = edge->dst();
+  if (!src->IsOp() || !dst->IsOp()) return false;
+  if (src->assigned_device_name() == dst->assigned_device_name() ||
+      opts.node_to_loc(src) == opts.node_to_loc(dst)) {
+    return false;
+  }
+
+  const DataType dtype = EdgeType(edge);
+  if (dtype != DT_FLOAT && dtype != DT_DOUBLE && dtype != DT_HALF) {
+    return false;
+  }
+  if (src->output_type(edge->src_output()) != dtype) return false;
+  if (opts.should_cast && opts.should_cast(edge) != dtype) return false;
+
+  // Tensors pinned to host memory on a device are sent with _HostSend and
+  // _HostRecv, which the packing ops below would not be.
+  if (info.device_types[src->id()] != DEVICE_CPU) {
+    auto src_it = info.output_types.find({src->id(), edge->src_output()});
+    if (src_it == info.output_types.end() || src_it->second == HOST_MEMORY) {
+      return false;
+    }
+  }
+  if (IsDstInputOnHost(edge, info) &&
+      info.device_types[dst->id()] != DEVICE_CPU) {
+    return false;
+  }
+
+  shape_inference::InferenceContext* ctx = refiner.GetContext(src);
+  if (ctx == nullptr) return false;
+  shape_inference::ShapeHandle handle = ctx->output(edge->src_output());
+  if (!ctx->FullyDefined(handle)) return false;
+  TensorShape result;
+  for (int i = 0; i < ctx->Rank(handle); ++i) {
+    result.AddDim(ctx->Value(ctx->Dim(handle, i)));
+  }
+  if (result.num_elements() * DataTypeSize(dtype) > opts.fuse_send_max_bytes) {
+    return false;
+  }
+  *shape = result;
+  return true;
+}
+
+// An int32 constant used to pack or unpack fused tensors.
+Node* AddFusionConst(const PartitionOptions& opts, Graph* g,
+                     const string& prefix, const string& device_name,
+                     const Tensor& value, Status* status) {
+  Node* res_node;
+  *status = NodeBuilder(opts.new_name(prefix), "Const", g->op_registry())
+                .Attr("dtype", value.dtype())
+                .Attr("value", value)
+                .Finalize(g, &res_node);
+  if (!status->ok()) return nullptr;
+  res_node->set_assigned_device_name(device_name);
+  return res_node;
+}
+
+// A reshape of 'input' to the shape held by the constant 'shape'.
+Node* AddFusionReshape(const PartitionOptions& opts, Graph* g,
+                       const string& prefix, const string& device_name,
+                       NodeBuilder::NodeOut input, Node* shape,
+                       Status* status) {
+  Node* res_node;
+  *status = NodeBuilder(opts.new_name(prefix), "Reshape", g->op_registry())
+                .Input(std::move(input))
+                .Input(shape)
+                .Finalize(g, &res_node);
+  if (!status->ok()) return nullptr;
+  res_node->set_assigned_device_name(device_name);
+  return res_node;
+}
+
+// Replaces the tensors in 'group', which all flow from 'src_device' to
+// 'dst_device', by a single tensor: the tensors are flattened and
+// concatenated on the source device, and split and reshaped back on the
+// destination device. Partition then adds one send/recv pair for the
+// concatenated tensor instead of one per tensor.
+Status FuseTensors(const PartitionOptions& opts, const string& src_device,
+                   const string& dst_device,
+                   const std::vector<FusibleTensor>& group, Graph* g) {
+  Status status;
+  const string prefix = strings::StrCat(group[0].src->name(), "/fused_send");
+  const int num_tensors = group.size();
+
+  Tensor flat_shape(DT_INT32, TensorShape({1}));
+  flat_shape.vec<int32>()(0) = -1;
+  Node* flat_shape_node =
+      AddFusionConst(opts, g, prefix, src_device, flat_shape, &status);
+  if (!status.ok()) return status;
+  std::vector<NodeBuilder::NodeOut> flat_tensors;
+  for (const FusibleTensor& tensor : group) {
+    Node* flat = AddFusionReshape(opts, g, prefix, src_device,
+                                  {tensor.src, tensor.src_output},
+                                  flat_shape_node, &status);
+    if (!status.ok()) return status;
+    flat_tensors.emplace_back(flat, 0);
+  }
+
+  Tensor axis(DT_INT32, TensorShape({}));
+  axis.scalar<int32>()() = 0;
+  Node* concat_axis =
+      AddFusionConst(opts, g, prefix, src_device, axis, &status);
+  if (!status.ok()) return status;
+  Node* concat;
+  status = NodeBuilder(opts.new_name(prefix), "ConcatV2", g->op_registry())
+               .Input(flat_tensors)
+               .Input(concat_axis)
+               .Finalize(g, &concat);
+  if (!status.ok()) return status;
+  concat->set_assigned_device_name(src_device);
+
+  Tensor sizes(DT_INT32, TensorShape({num_tensors}));
+  for (int i = 0; i < num_tensors; ++i) {
+    sizes.vec<int32>()(i) = group[i].shape.num_elements();
+  }
+  Node* split_sizes =
+      AddFusionConst(opts, g, prefix, dst_device, sizes, &status);
+  if (!status.ok()) return status;
+  Node* split_axis = AddFusionConst(opts, g, prefix, dst_device, axis, &status);
+  if (!status.ok()) return status;
+  Node* split;
+  status = NodeBuilder(opts.new_name(prefix), "SplitV", g->op_registry())
+               .Input(concat)
+               .Input(split_sizes)
+               .Input(split_axis)
+               .Attr("num_split", num_tensors)
+               .Finalize(g, &split);
+  if (!status.ok()) return status;
+  split->set_assigned_device_name(dst_device);
+
+  for (int i = 0; i < num_tensors; ++i) {
+    const FusibleTensor& tensor = group[i];
+    Tensor shape(DT_INT32, TensorShape({tensor.shape.dims()}));
+    for (int d = 0; d < tensor.shape.dims(); ++d) {
+      shape.vec<int32>()(d) = tensor.shape.dim_size(d);
+    }
+    Node* shape_node =
+        AddFusionConst(opts, g, prefix, dst_device, shape, &status);
+    if (!status.ok()) return status;
+    Node* unpacked = AddFusionReshape(opts, g, prefix, dst_device, {split, i},
+                                      shape_node, &status);
+    if (!status.ok()) return status;
+    for (const Edge* edge : tensor.edges) {
+      g->AddEdge(unpacked, 0, edge->dst(), edge->dst_input());
+      g->RemoveEdge(edge);
+    }
+  }
+  return Status::OK();
+}
+
+// Packs small tensors sent between the same pair of devices into a single
+// tensor so that they are transferred with one send/recv pair, which saves
+// the per-transfer overhead of the rendezvous. Only tensors whose producers
+// have the same depth (longest path from the source node) are fused: they
+// tend to become ready at the same time, so the fused send rarely delays
+// one of them for long. Since a node is always deeper than its inputs, no
+// producer in a group can depend on a consumer of the group, and fusing
+// never introduces a cycle.
+Status FuseSmallSends(const PartitionOptions& opts, Graph* g) {
+  for (const Node* node : g->op_nodes()) {
+    if (node->IsControlFlow()) return Status::OK();
+  }
+
+  GraphInfo info;
+  TF_RETURN_IF_ERROR(BuildMemoryDeviceInfo(*g, &info));
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*g, &order);
+  ShapeRefiner refiner(g->versions().producer(), g->op_registry());
+  refiner.set_require_shape_inference_fns(false);
+  std::vector<int> depth(g->num_node_ids(), 0);
+  for (Node* node : order) {
+    for (const Edge* edge : node->in_edges()) {
+      depth[node->id()] =
+          std::max(depth[node->id()], depth[edge->src()->id()] + 1);
+    }
+    // Nodes whose shapes can't be inferred simply aren't fused.
+    refiner.AddNode(node).IgnoreError();
+  }
+
+  // Keyed by (src device, dst device, dtype, depth), then by the sent
+  // tensor, so that the rewrite is deterministic.
+  typedef std::tuple<string, string, int, int> GroupKey;
+  std::map<GroupKey, std::map<std::pair<int, int>, FusibleTensor>> groups;
+  for (const Edge* edge : g->edges()) {
+    TensorShape shape;
+    if (!IsFusibleEdge(opts, info, refiner, edge, &shape)) continue;
+    Node* src = edge->src();
+    GroupKey key(src->assigned_device_name(),
+                 edge->dst()->assigned_device_name(), EdgeType(edge),
+                 depth[src->id()]);
+    FusibleTensor& tensor = groups[key][{src->id(), edge->src_output()}];
+    tensor.src = src;
+    tensor.src_output = edge->src_output();
+    tensor.shape = shape;
+    tensor.edges.push_back(edge);
+  }
+
+  for (const auto& it : groups) {
+    if (it.second.size() < 2) continue;
+    std::vector<FusibleTensor> group;
+    for (const auto& tensor : it.second) group.push_back(tensor.second);
+    TF_RETURN_IF_ERROR(FuseTensors(opts, std::get<0>(it.first),
+                                   std::get<1>(it.first), group, g));
+  }
+  return Status::OK();
+}
+
 }  // end namespace
 
 Status AddControlEdges(const PartitionOptions& opts,
@@ -803,6 +1031,14 @@ Status Partition(const PartitionOptions& opts, Graph* g,
   Status status;
   partitions->clear();
 
+  // Fusing sends adds nodes, which would invalidate the start times indexed
+  // by node id.
+  if (opts.fuse_send_max_bytes > 0 && !opts.scheduling_for_recvs &&
+      !opts.need_to_record_start_times && !opts.record_recv_priorities) {
+    status = FuseSmallSends(opts, g);
+    if (!status.ok()) return status;
+  }
+
   GraphInfo g_info;
   if (!opts.control_flow_added) {
     // Add the "code" for distributed execution of control flow. Code is
@@ -910,6 +1146,8 @@ Status Partition(const PartitionOptions& opts, Graph* g,
             return status;
           }
         }
+      } else if (opts.record_recv_priorities) {
+        recv_start_time = opts.start_times[dst->id()].value();
       }
 
       // Check whether there is already a send/recv pair transferring
@@ -987,6 +1225,9 @@ Status Partition(const PartitionOptions& opts, Graph* g,
         if (real_recv != recv) {
           AddNodeAttr("_start_time", recv_start_time, real_recv);
         }
+        if (opts.record_recv_priorities) {
+          AddNodeAttr("_recv_priority", recv_start_time, recv);
+        }
         // If src is of ref type and the edge is not a control edge, dst has
         // read semantics and therefore we must control the recv.
         ref_recvs.push_back(real_recv);
@@ -1041,6 +1282,11 @@ Status Partition(const PartitionOptions& opts, Graph* g,
       }
     }
   }
+  if (opts.record_recv_priorities) {
+    for (auto& it : dup_recv) {
+      AddNodeAttr("_recv_priority", it.second.start_time, it.second.recv);
+    }
+  }
 
   VLOG(1) << "Added send/recv: controls=" << num_control
           << ", data=" << num_data;
@@ -71,6 +71,18 @@ struct PartitionOptions {
   // in the graph as a node attribute.
   bool need_to_record_start_times = false;
   std::vector<Microseconds> start_times;
+
+  // If true, each Recv node gets a "_recv_priority" attr with the smallest
+  // of the start times in 'start_times' of the nodes that it feeds. A
+  // rendezvous that limits the number of tensors in flight receives the
+  // tensors with the smallest priorities first.
+  bool record_recv_priorities = false;
+
+  // If positive, floating point tensors of at most this many bytes that are
+  // sent between the same pair of devices are packed into a single tensor
+  // and sent with one send/recv pair. Only tensors with statically known
+  // shapes are fused, and graphs with control flow are left as is.
+  int64 fuse_send_max_bytes = 0;
 };
 
 // Partition "input" graph into a set of graphs, one per location.
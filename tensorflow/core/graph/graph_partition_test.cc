@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <map>
 #include <unordered_map>
 #include <utility>
 
@@ -56,7 +57,8 @@ string DeviceName(const Node* node) {
 }
 
 void Partition(const GraphDef& graph_def,
-               std::unordered_map<string, GraphDef>* partitions) {
+               std::unordered_map<string, GraphDef>* partitions,
+               int64 fuse_send_max_bytes = 0) {
   Graph g(OpRegistry::Global());
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
@@ -73,6 +75,7 @@ void Partition(const GraphDef& graph_def,
   popts.get_incarnation = [](const string& name) {
     return (name[0] - 'A') + 100;
   };
+  popts.fuse_send_max_bytes = fuse_send_max_bytes;
   Status s = Partition(popts, &g, partitions);
   CHECK(s.ok()) << s;
 
@@ -435,5 +438,82 @@ TEST_F(GraphPartitionTest, Functions) {
   ExpectFunctions(partitions_[b].library(), {"XTimesTwo", "XTimesFour"});
 }
 
+int CountOps(const GraphDef& graph_def, const string& op) {
+  int count = 0;
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() == op) ++count;
+  }
+  return count;
+}
+
+TEST_F(GraphPartitionTest, FuseSmallSends) {
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  auto a1 = Const(in_.WithOpName("A1"), {1.0f, 2.0f});
+  auto a2 = Const(in_.WithOpName("A2"), {{3.0f}, {4.0f}});
+  auto a3 = FloatInput(in_.WithOpName("A3"));
+  auto b1 = Combine(in_.WithOpName("B1"), a1, a2);
+  Combine(in_.WithOpName("B2"), b1, a3);
+  const GraphDef& graph_def = ToGraphDef();
+
+  // A1 and A2 are sent together. A3 has an unknown shape, so it is sent
+  // on its own.
+  Partition(graph_def, &partitions_, 1024);
+  EXPECT_EQ(2, partitions_.size());
+  string a = "/job:a/replica:0/task:0/cpu:0";
+  string b = "/job:a/replica:0/task:0/cpu:1";
+  EXPECT_EQ(2, CountOps(partitions_[a], "_Send"));
+  EXPECT_EQ(1, CountOps(partitions_[a], "ConcatV2"));
+  EXPECT_EQ(2, CountOps(partitions_[b], "_Recv"));
+  EXPECT_EQ(1, CountOps(partitions_[b], "SplitV"));
+
+  // Tensors larger than the limit are not fused.
+  Partition(graph_def, &partitions_, 4);
+  EXPECT_EQ(3, CountOps(partitions_[a], "_Send"));
+  EXPECT_EQ(0, CountOps(partitions_[a], "ConcatV2"));
+  EXPECT_EQ(3, CountOps(partitions_[b], "_Recv"));
+}
+
+TEST_F(GraphPartitionTest, RecvPriorities) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto a2 = FloatInput(in_.WithOpName("A2"));
+  auto b1 = Combine(in_.WithOpName("B1"), a1, a2);
+  Combine(in_.WithOpName("B2"), b1, a1);
+
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(
+      ConvertGraphDefToGraph(GraphConstructorOptions(), ToGraphDef(), &g));
+  PartitionOptions popts;
+  popts.node_to_loc = SplitByDevice;
+  popts.new_name = [&g](const string& prefix) { return g.NewName(prefix); };
+  popts.get_incarnation = [](const string& name) {
+    return (name[0] - 'A') + 100;
+  };
+  popts.record_recv_priorities = true;
+  popts.start_times.resize(g.num_node_ids());
+  for (Node* node : g.nodes()) {
+    node->set_assigned_device_name(DeviceName(node));
+    if (node->name() == "B1") {
+      popts.start_times[node->id()] = Microseconds(20);
+    } else if (node->name() == "B2") {
+      popts.start_times[node->id()] = Microseconds(10);
+    }
+  }
+  TF_ASSERT_OK(Partition(popts, &g, &partitions_));
+
+  // A1 feeds B1 and B2 through a single recv, which gets the earlier of
+  // their start times.
+  string b = "/job:a/replica:0/task:0/cpu:1";
+  std::map<string, int64> priorities;
+  for (const NodeDef& node : partitions_[b].node()) {
+    if (node.op() != "_Recv") continue;
+    string tensor_name;
+    int64 priority;
+    TF_ASSERT_OK(GetNodeAttr(node, "tensor_name", &tensor_name));
+    TF_ASSERT_OK(GetNodeAttr(node, "_recv_priority", &priority));
+    priorities[tensor_name.substr(tensor_name.rfind('_') + 1)] = priority;
+  }
+  EXPECT_EQ((std::map<string, int64>{{"A1", 10}, {"A2", 20}}), priorities);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -47,6 +47,16 @@ Status AnalyticalCostEstimator::Initialize(const GrapplerItem& item) {
   return Status::OK();
 }
 
+void AnalyticalCostEstimator::SetMeasuredCosts(
+    const OpPerformanceList& measured) {
+  measured_costs_.clear();
+  for (const auto& perf : measured.op_performance()) {
+    if (!perf.node().empty()) {
+      measured_costs_[perf.node()] = perf.compute_cost();
+    }
+  }
+}
+
 Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
                                              CostGraphDef* cost_graph,
                                              Costs* costs) const {
@@ -74,6 +84,14 @@ Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
     const string& op_name = node_info.name;
 
     node_costs = node_estimator_->PredictCosts(op_info);
+    auto measured = measured_costs_.find(op_name);
+    if (measured != measured_costs_.end()) {
+      // Measurements don't tell compute from memory time apart.
+      node_costs.execution_time = Costs::Duration(measured->second);
+      node_costs.compute_time = node_costs.execution_time;
+      node_costs.memory_time = Costs::Duration::zero();
+      node_costs.inaccurate = false;
+    }
     if (node_costs.inaccurate) {
       inaccurate_nodes.push_back(op_name);
     }
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
 
+#include <unordered_map>
+
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -55,11 +57,18 @@ class AnalyticalCostEstimator : public CostEstimator {
   Status PredictCosts(const GraphDef& optimized_graph, CostGraphDef* cost_graph,
                       Costs* overall_latency) const override;
 
+  // Uses the measured compute costs in "measured", e.g. as exported by a
+  // session's online cost model, instead of the node estimator's predictions
+  // for the nodes with the same names.
+  void SetMeasuredCosts(const OpPerformanceList& measured);
+
  private:
   Cluster* cluster_;  // Not owned.
   GrapplerItem item_;
   std::unique_ptr<OpLevelCostEstimator> node_estimator_;
   bool use_static_shapes_;
+  // The measured compute cost of each node, in nanoseconds.
+  std::unordered_map<string, int64> measured_costs_;
 };
 
 }  // end namespace grappler
@@ -106,5 +106,28 @@ TEST_F(AnalyticalCostEstimatorTest, SimpleTest) {
   EXPECT_FALSE(summary.inaccurate);
 }
 
+TEST_F(AnalyticalCostEstimatorTest, MeasuredCosts) {
+  GrapplerItem item = CreateMiniGraph();
+
+  AnalyticalCostEstimator estimator(cluster_.get(), true);
+  TF_ASSERT_OK(estimator.Initialize(item));
+  OpPerformanceList measured;
+  OpPerformance* perf = measured.add_op_performance();
+  perf->set_node("matmul");
+  perf->set_compute_cost(1000000);
+  estimator.SetMeasuredCosts(measured);
+
+  CostGraphDef cost_graph;
+  Costs summary;
+  TF_ASSERT_OK(estimator.PredictCosts(item.graph, &cost_graph, &summary));
+
+  EXPECT_LE(Costs::NanoSeconds(1000000), summary.execution_time);
+  for (const auto& node : cost_graph.node()) {
+    if (node.name() == "matmul") {
+      EXPECT_EQ(1000, node.compute_cost());
+    }
+  }
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
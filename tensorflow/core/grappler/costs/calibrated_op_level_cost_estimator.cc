@@ -0,0 +1,136 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/calibrated_op_level_cost_estimator.h"
+
+#include <cmath>
+#include <iterator>
+#include <set>
+
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns the bucket of the predicted time "ns": the floor of its log2.
+int Bucket(int64 ns) {
+  int bucket = 0;
+  while (ns > 1) {
+    ns >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+int CalibratedOpLevelCostEstimator::Calibrate(
+    const OpPerformanceList& measured) {
+  std::set<Key> updated;
+  int num_used = 0;
+  for (const OpPerformance& perf : measured.op_performance()) {
+    if (perf.compute_cost() <= 0) {
+      continue;
+    }
+    const int64 predicted_ns =
+        OpLevelCostEstimator::PredictCosts(perf.op()).execution_time.count();
+    if (predicted_ns <= 0) {
+      continue;
+    }
+    Key key(perf.op().op(), perf.op().device().type());
+    samples_[key][Bucket(predicted_ns)].push_back(
+        static_cast<double>(perf.compute_cost()) / predicted_ns);
+    updated.insert(key);
+    ++num_used;
+  }
+  for (const Key& key : updated) {
+    std::map<int, double>& efficiencies = efficiencies_[key];
+    for (const auto& bucket : samples_[key]) {
+      efficiencies[bucket.first] = 1.0 / RobustStats(bucket.second).mean();
+    }
+  }
+  return num_used;
+}
+
+OpPerformanceList CalibratedOpLevelCostEstimator::ExportCalibration() const {
+  OpPerformanceList calibration;
+  for (const auto& curve : efficiencies_) {
+    for (const auto& point : curve.second) {
+      OpPerformance* perf = calibration.add_op_performance();
+      perf->mutable_op()->set_op(curve.first.first);
+      perf->mutable_op()->mutable_device()->set_type(curve.first.second);
+      perf->set_compute_time(int64{1} << point.first);
+      perf->set_compute_efficiency(point.second);
+    }
+  }
+  return calibration;
+}
+
+Status CalibratedOpLevelCostEstimator::ImportCalibration(
+    const OpPerformanceList& calibration) {
+  std::map<Key, std::map<int, double>> efficiencies;
+  for (const OpPerformance& perf : calibration.op_performance()) {
+    if (perf.compute_time() <= 0 || perf.compute_efficiency() <= 0) {
+      return errors::InvalidArgument("Invalid calibration point for op ",
+                                     perf.op().op(), " on ",
+                                     perf.op().device().type());
+    }
+    Key key(perf.op().op(), perf.op().device().type());
+    efficiencies[key][Bucket(perf.compute_time())] =
+        perf.compute_efficiency();
+  }
+  samples_.clear();
+  efficiencies_.swap(efficiencies);
+  return Status::OK();
+}
+
+double CalibratedOpLevelCostEstimator::Efficiency(const OpInfo& op_features,
+                                                  int64 predicted_ns) const {
+  auto curve =
+      efficiencies_.find(Key(op_features.op(), op_features.device().type()));
+  if (curve == efficiencies_.end() || curve->second.empty()) {
+    return 1.0;
+  }
+  // Use the closest bucket with data.
+  const std::map<int, double>& points = curve->second;
+  const int bucket = Bucket(predicted_ns);
+  auto above = points.lower_bound(bucket);
+  if (above == points.end()) {
+    return std::prev(above)->second;
+  }
+  if (above->first == bucket || above == points.begin()) {
+    return above->second;
+  }
+  auto below = std::prev(above);
+  return bucket - below->first <= above->first - bucket ? below->second
+                                                        : above->second;
+}
+
+Costs CalibratedOpLevelCostEstimator::PredictCosts(
+    const OpInfo& op_features) const {
+  Costs costs = OpLevelCostEstimator::PredictCosts(op_features);
+  const int64 predicted_ns = costs.execution_time.count();
+  if (predicted_ns > 0) {
+    costs.execution_time = Costs::NanoSeconds(
+        std::round(predicted_ns / Efficiency(op_features, predicted_ns)));
+  }
+  return costs;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
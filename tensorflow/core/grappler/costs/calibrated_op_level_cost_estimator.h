@@ -0,0 +1,82 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// An OpLevelCostEstimator whose predictions are corrected with efficiency
+// curves fitted to measured performance data.
+//
+// The roofline estimates of OpLevelCostEstimator assume that every op runs at
+// the peak throughput of its device, which is far off for small and memory
+// bound ops. For each op type and device type, this fits the efficiency of the
+// op (the predicted time divided by the measured time) as a function of the
+// predicted time, in buckets of powers of two nanoseconds, and divides the
+// predicted execution times by it. Ops without data keep their uncalibrated
+// predictions.
+//
+// Pass an instance to VirtualCluster or AnalyticalCostEstimator to use the
+// calibrated costs in grappler.
+class CalibratedOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  CalibratedOpLevelCostEstimator() {}
+  ~CalibratedOpLevelCostEstimator() override {}
+
+  // Fits the efficiency curves to the measured compute costs of "measured",
+  // e.g. as converted by CostGraphToOpPerformanceData from the cost graphs of
+  // real runs. The measurements are combined with the ones of previous calls.
+  // Returns the number of measurements used: the ones with a positive compute
+  // cost and prediction.
+  int Calibrate(const OpPerformanceList& measured);
+
+  // Exports the efficiency curves, one OpPerformance per point: the op type
+  // and device type in "op", the lower bound of the bucket of predicted times
+  // in "compute_time", and the efficiency in "compute_efficiency".
+  OpPerformanceList ExportCalibration() const;
+
+  // Replaces the efficiency curves by the exported "calibration".
+  Status ImportCalibration(const OpPerformanceList& calibration);
+
+  Costs PredictCosts(const OpInfo& op_features) const override;
+
+ private:
+  // Op type and device type.
+  typedef std::pair<string, string> Key;
+
+  // Returns the efficiency of "op_features" at the predicted time
+  // "predicted_ns", or 1 if there is no data for the op.
+  double Efficiency(const OpInfo& op_features, int64 predicted_ns) const;
+
+  // The measured over predicted time ratios, by key and bucket.
+  std::map<Key, std::map<int, std::vector<double>>> samples_;
+  // The fitted efficiencies, by key and bucket.
+  std::map<Key, std::map<int, double>> efficiencies_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
@@ -0,0 +1,106 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/calibrated_op_level_cost_estimator.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Returns an OpInfo for a MatMul of two size x size matrices on a CPU.
+OpInfo DescribeMatMul(int size) {
+  OpInfo op_features;
+  op_features.set_op("MatMul");
+  auto device = op_features.mutable_device();
+  device->set_type("CPU");
+  device->set_num_cores(10);
+  device->set_bandwidth(10000000);  // 10000000 KB/s = 10 GB/s
+  device->set_frequency(1000);      // 1000 Mhz = 1 GHz
+  for (int i = 0; i < 2; ++i) {
+    auto input = op_features.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(size);
+    input->mutable_shape()->add_dim()->set_size(size);
+  }
+  return op_features;
+}
+
+int64 Predict(const OpLevelCostEstimator& estimator, const OpInfo& op) {
+  return estimator.PredictCosts(op).execution_time.count();
+}
+
+class CalibratedOpLevelCostEstimatorTest : public ::testing::Test {
+ protected:
+  // Calibrates "estimator_" with MatMuls that run 4 times slower than
+  // predicted.
+  void SetUp() override {
+    const OpInfo matmul = DescribeMatMul(256);
+    predicted_ = Predict(uncalibrated_, matmul);
+    ASSERT_GT(predicted_, 0);
+    OpPerformanceList measured;
+    for (int i = 0; i < 3; ++i) {
+      OpPerformance* perf = measured.add_op_performance();
+      *perf->mutable_op() = matmul;
+      perf->set_compute_cost(4 * predicted_);
+    }
+    // Measurements without a compute cost are skipped.
+    *measured.add_op_performance()->mutable_op() = matmul;
+    EXPECT_EQ(3, estimator_.Calibrate(measured));
+  }
+
+  OpLevelCostEstimator uncalibrated_;
+  CalibratedOpLevelCostEstimator estimator_;
+  int64 predicted_;
+};
+
+TEST_F(CalibratedOpLevelCostEstimatorTest, ScalesPredictions) {
+  EXPECT_EQ(4 * predicted_, Predict(estimator_, DescribeMatMul(256)));
+  // Other sizes use the closest point of the curve.
+  const OpInfo larger = DescribeMatMul(1024);
+  EXPECT_EQ(4 * Predict(uncalibrated_, larger), Predict(estimator_, larger));
+}
+
+TEST_F(CalibratedOpLevelCostEstimatorTest, OtherDevicesAreUnchanged) {
+  OpInfo matmul = DescribeMatMul(256);
+  matmul.mutable_device()->set_type("GPU");
+  EXPECT_EQ(Predict(uncalibrated_, matmul), Predict(estimator_, matmul));
+}
+
+TEST_F(CalibratedOpLevelCostEstimatorTest, ExportsAndImportsCalibration) {
+  OpPerformanceList calibration = estimator_.ExportCalibration();
+  ASSERT_EQ(1, calibration.op_performance_size());
+  const OpPerformance& point = calibration.op_performance(0);
+  EXPECT_EQ("MatMul", point.op().op());
+  EXPECT_EQ("CPU", point.op().device().type());
+  EXPECT_LE(point.compute_time(), predicted_);
+  EXPECT_GT(2 * point.compute_time(), predicted_);
+  EXPECT_DOUBLE_EQ(0.25, point.compute_efficiency());
+
+  CalibratedOpLevelCostEstimator imported;
+  TF_EXPECT_OK(imported.ImportCalibration(calibration));
+  EXPECT_EQ(4 * predicted_, Predict(imported, DescribeMatMul(256)));
+
+  calibration.mutable_op_performance(0)->set_compute_efficiency(0);
+  EXPECT_FALSE(imported.ImportCalibration(calibration).ok());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,497 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns the value of the constant "node" in "tensor", or false if "node" is
+// not a constant.
+bool GetConstantValue(const NodeDef* node, Tensor* tensor) {
+  if (node == nullptr || !IsConstant(*node)) return false;
+  auto it = node->attr().find("value");
+  return it != node->attr().end() && tensor->FromProto(it->second.tensor());
+}
+
+// Returns true if all the elements of "tensor" are equal to "value".
+bool AllElementsEqual(const Tensor& tensor, int value) {
+  switch (tensor.dtype()) {
+#define HANDLE_TYPE(T)                                     \
+  case DataTypeToEnum<T>::value: {                         \
+    auto flat = tensor.flat<T>();                          \
+    for (int64 i = 0; i < flat.size(); ++i) {              \
+      if (flat(i) != static_cast<T>(value)) return false; \
+    }                                                      \
+    return true;                                           \
+  }
+    HANDLE_TYPE(float);
+    HANDLE_TYPE(double);
+    HANDLE_TYPE(Eigen::half);
+    HANDLE_TYPE(int32);
+    HANDLE_TYPE(int64);
+#undef HANDLE_TYPE
+    default:
+      return false;
+  }
+}
+
+// Returns the elements of the 1-D integer "tensor" in "values".
+bool GetIntegerValues(const Tensor& tensor, std::vector<int64>* values) {
+  if (tensor.dims() != 1) return false;
+  if (tensor.dtype() == DT_INT32) {
+    for (int64 i = 0; i < tensor.NumElements(); ++i) {
+      values->push_back(tensor.vec<int32>()(i));
+    }
+    return true;
+  }
+  if (tensor.dtype() == DT_INT64) {
+    for (int64 i = 0; i < tensor.NumElements(); ++i) {
+      values->push_back(tensor.vec<int64>()(i));
+    }
+    return true;
+  }
+  return false;
+}
+
+// Returns true if every value of type "from" is exactly representable in type
+// "to", so that casting to "to" and back is a no-op.
+bool IsLosslessCast(DataType from, DataType to) {
+  switch (from) {
+    case DT_HALF:
+    case DT_BFLOAT16:
+      return to == DT_FLOAT || to == DT_DOUBLE;
+    case DT_FLOAT:
+      return to == DT_DOUBLE;
+    case DT_INT8:
+      return to == DT_INT16 || to == DT_INT32 || to == DT_INT64;
+    case DT_UINT8:
+      return to == DT_INT16 || to == DT_UINT16 || to == DT_INT32 ||
+             to == DT_INT64;
+    case DT_INT16:
+      return to == DT_INT32 || to == DT_INT64;
+    case DT_UINT16:
+      return to == DT_INT32 || to == DT_INT64;
+    case DT_INT32:
+      return to == DT_INT64 || to == DT_DOUBLE;
+    default:
+      return false;
+  }
+}
+
+// Returns the control dependencies of "node".
+std::vector<string> ControlInputs(const NodeDef& node) {
+  std::vector<string> inputs;
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) inputs.push_back(input);
+  }
+  return inputs;
+}
+
+class ArithmeticSimplifier {
+ public:
+  ArithmeticSimplifier(const GrapplerItem& item, GraphDef* graph,
+                       const GraphProperties* properties)
+      : graph_(graph), node_map_(graph), properties_(properties) {
+    for (const auto& node : item.fetch) {
+      nodes_to_preserve_.insert(NodeName(node));
+    }
+    for (const auto& feed : item.feed) {
+      nodes_to_preserve_.insert(NodeName(feed.first));
+    }
+  }
+
+  // Simplifies the graph in one pass, which expects the graph to be
+  // topologically sorted so that the inputs of a node are simplified (and
+  // deduplicated) before the node itself. Returns the number of nodes that
+  // were simplified or removed.
+  int Simplify() {
+    int num_simplified = 0;
+    std::unordered_map<uint64, std::vector<NodeDef*>> signatures;
+    std::unordered_set<const NodeDef*> duplicates;
+    for (int i = 0; i < graph_->node_size(); ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      if (SimplifyNode(node)) {
+        ++num_simplified;
+      }
+      if (!CanDedup(*node)) continue;
+      std::vector<NodeDef*>& candidates = signatures[Signature(*node)];
+      NodeDef* representative = nullptr;
+      for (NodeDef* candidate : candidates) {
+        if (SameNode(*candidate, *node)) {
+          representative = candidate;
+          break;
+        }
+      }
+      if (representative == nullptr) {
+        candidates.push_back(node);
+      } else {
+        ForwardOutputs(*node, *representative);
+        duplicates.insert(node);
+        ++num_simplified;
+      }
+    }
+
+    // Delete the duplicate nodes, keeping the order of the others.
+    int num_kept = 0;
+    for (int i = 0; i < graph_->node_size(); ++i) {
+      if (duplicates.count(&graph_->node(i)) > 0) continue;
+      if (i != num_kept) graph_->mutable_node()->SwapElements(i, num_kept);
+      ++num_kept;
+    }
+    graph_->mutable_node()->DeleteSubrange(num_kept,
+                                           graph_->node_size() - num_kept);
+    return num_simplified;
+  }
+
+ private:
+  NodeDef* GetInputNode(const NodeDef& node, int i) const {
+    if (i >= node.input_size() || IsControlInput(node.input(i))) {
+      return nullptr;
+    }
+    return node_map_.GetNode(node.input(i));
+  }
+
+  // Returns the node of type "op" whose first output is input "i" of "node",
+  // or nullptr.
+  NodeDef* GetProducer(const NodeDef& node, int i, const string& op) const {
+    NodeDef* input = GetInputNode(node, i);
+    if (input == nullptr || input->op() != op ||
+        NodePosition(node.input(i)) != 0) {
+      return nullptr;
+    }
+    return input;
+  }
+
+  bool SimplifyNode(NodeDef* node) {
+    const string& op = node->op();
+    if (op == "Mul" || op == "Add" || op == "Sub" || op == "Div" ||
+        op == "RealDiv") {
+      return SimplifyNeutralElement(node);
+    }
+    if (op == "Transpose") return SimplifyTransposes(node);
+    if (op == "Reshape") return SimplifyReshapes(node);
+    if (op == "Cast") return SimplifyCasts(node);
+    if (IsIdentity(*node)) return SimplifyIdentities(node);
+    return false;
+  }
+
+  // x * 1, 1 * x, x + 0, 0 + x, x - 0, x / 1.
+  bool SimplifyNeutralElement(NodeDef* node) {
+    const string& op = node->op();
+    const int neutral = (op == "Add" || op == "Sub") ? 0 : 1;
+    const bool commutative = (op == "Add" || op == "Mul");
+    for (int constant_input : {1, 0}) {
+      if (constant_input == 0 && !commutative) break;
+      Tensor value;
+      if (!GetConstantValue(GetInputNode(*node, constant_input), &value) ||
+          !AllElementsEqual(value, neutral)) {
+        continue;
+      }
+      const int x_input = 1 - constant_input;
+      if (IsControlInput(node->input(x_input))) continue;
+      // A non-scalar constant may broadcast x to a larger shape.
+      if (value.dims() > 0 && !HasSameShape(*node, x_input)) continue;
+      ReplaceWithIdentity(node, node->input(x_input), {});
+      return true;
+    }
+    return false;
+  }
+
+  // Returns true if input "i" of "node" has the same fully defined shape as
+  // the output of "node".
+  bool HasSameShape(const NodeDef& node, int i) const {
+    if (properties_ == nullptr) return false;
+    const auto& inputs = properties_->GetInputProperties(node.name());
+    const auto& outputs = properties_->GetOutputProperties(node.name());
+    if (i >= static_cast<int>(inputs.size()) || outputs.empty()) return false;
+    const PartialTensorShape input_shape(inputs[i].shape());
+    const PartialTensorShape output_shape(outputs[0].shape());
+    return input_shape.IsFullyDefined() &&
+           input_shape.IsIdenticalTo(output_shape);
+  }
+
+  // Transpose(Transpose(x, p1), p2) with p1[p2[i]] == i.
+  bool SimplifyTransposes(NodeDef* node) {
+    NodeDef* inner = GetProducer(*node, 0, "Transpose");
+    if (inner == nullptr) return false;
+    Tensor outer_perm;
+    Tensor inner_perm;
+    std::vector<int64> p1;
+    std::vector<int64> p2;
+    if (!GetConstantValue(GetInputNode(*node, 1), &outer_perm) ||
+        !GetConstantValue(GetInputNode(*inner, 1), &inner_perm) ||
+        !GetIntegerValues(inner_perm, &p1) ||
+        !GetIntegerValues(outer_perm, &p2) || p1.size() != p2.size()) {
+      return false;
+    }
+    for (int i = 0; i < static_cast<int>(p2.size()); ++i) {
+      if (p2[i] < 0 || p2[i] >= static_cast<int64>(p1.size()) ||
+          p1[p2[i]] != i) {
+        return false;
+      }
+    }
+    ReplaceWithIdentity(node, inner->input(0), ControlInputs(*inner));
+    return true;
+  }
+
+  // Reshape(Reshape(x, s1), s2) becomes Reshape(x, s2).
+  bool SimplifyReshapes(NodeDef* node) {
+    NodeDef* inner = GetProducer(*node, 0, "Reshape");
+    if (inner == nullptr) return false;
+    ForwardInput(node, 0, *inner);
+    return true;
+  }
+
+  // Cast(Cast(x, A -> B), B -> A) where B can represent all the values of A.
+  bool SimplifyCasts(NodeDef* node) {
+    NodeDef* inner = GetProducer(*node, 0, "Cast");
+    if (inner == nullptr) return false;
+    const DataType src = inner->attr().at("SrcT").type();
+    const DataType dst = inner->attr().at("DstT").type();
+    if (node->attr().at("SrcT").type() != dst ||
+        node->attr().at("DstT").type() != src || !IsLosslessCast(src, dst)) {
+      return false;
+    }
+    ReplaceWithIdentity(node, inner->input(0), ControlInputs(*inner));
+    return true;
+  }
+
+  // Identity(Identity(x)) becomes Identity(x). Identities that cross devices
+  // are copies, and are kept.
+  bool SimplifyIdentities(NodeDef* node) {
+    bool simplified = false;
+    NodeDef* inner = GetProducer(*node, 0, "Identity");
+    while (inner != nullptr && inner->device() == node->device()) {
+      ForwardInput(node, 0, *inner);
+      simplified = true;
+      inner = GetProducer(*node, 0, "Identity");
+    }
+    return simplified;
+  }
+
+  // Makes input "i" of "node" read the first input of "producer" instead of
+  // its output, adding the control dependencies of "producer" to "node".
+  void ForwardInput(NodeDef* node, int i, const NodeDef& producer) {
+    *node->mutable_input(i) = producer.input(0);
+    node_map_.AddOutput(NodeName(producer.input(0)), node->name());
+    for (const string& control : ControlInputs(producer)) {
+      AddControlInput(node, control);
+    }
+  }
+
+  // Turns "node" into an identity of "input", keeping its control
+  // dependencies and adding "controls".
+  void ReplaceWithIdentity(NodeDef* node, const string& input,
+                           const std::vector<string>& controls) {
+    const DataType type = node->op() == "Cast"
+                              ? node->attr().at("DstT").type()
+                              : node->attr().at("T").type();
+    std::vector<string> control_inputs = ControlInputs(*node);
+    node->set_op("Identity");
+    // Keep the internal attributes, such as the colocation constraints.
+    for (auto it = node->mutable_attr()->begin();
+         it != node->mutable_attr()->end();) {
+      if (it->first.empty() || it->first[0] != '_' ||
+          it->first == "_output_shapes") {
+        it = node->mutable_attr()->erase(it);
+      } else {
+        ++it;
+      }
+    }
+    (*node->mutable_attr())["T"].set_type(type);
+    node->clear_input();
+    node->add_input(input);
+    node_map_.AddOutput(NodeName(input), node->name());
+    for (const string& control : control_inputs) {
+      node->add_input(control);
+    }
+    for (const string& control : controls) {
+      AddControlInput(node, control);
+    }
+  }
+
+  void AddControlInput(NodeDef* node, const string& control) {
+    for (const string& input : node->input()) {
+      if (input == control) return;
+    }
+    node->add_input(control);
+    node_map_.AddOutput(NodeName(control), node->name());
+  }
+
+  bool CanDedup(const NodeDef& node) const {
+    if (nodes_to_preserve_.count(node.name()) > 0) return false;
+    if (IsEnter(node) || IsExit(node) || IsNextIteration(node) ||
+        IsMerge(node) || IsSwitch(node) || IsPlaceholder(node) ||
+        IsSend(node) || IsRecv(node)) {
+      return false;
+    }
+    const OpDef* op_def = nullptr;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        op_def->is_stateful()) {
+      return false;
+    }
+    // Ops that output references alias their input, and can't be merged.
+    for (const auto& output : op_def->output_arg()) {
+      if (output.is_ref()) return false;
+    }
+    return true;
+  }
+
+  uint64 Signature(const NodeDef& node) const {
+    uint64 h = Hash64(node.op());
+    h = Hash64Combine(h, Hash64(node.device()));
+    // The order of the control dependencies and attributes doesn't matter.
+    uint64 unordered = 0;
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) {
+        unordered += Hash64(input);
+      } else {
+        h = Hash64Combine(h, Hash64(input));
+      }
+    }
+    for (const auto& attr : node.attr()) {
+      unordered += Hash64Combine(Hash64(attr.first),
+                                 Hash64(attr.second.SerializeAsString()));
+    }
+    return Hash64Combine(h, unordered);
+  }
+
+  bool SameNode(const NodeDef& a, const NodeDef& b) const {
+    if (a.op() != b.op() || a.device() != b.device() ||
+        a.input_size() != b.input_size() ||
+        a.attr_size() != b.attr_size()) {
+      return false;
+    }
+    std::set<string> a_controls;
+    std::set<string> b_controls;
+    for (int i = 0; i < a.input_size(); ++i) {
+      const bool a_control = IsControlInput(a.input(i));
+      if (a_control != IsControlInput(b.input(i))) return false;
+      if (a_control) {
+        a_controls.insert(a.input(i));
+        b_controls.insert(b.input(i));
+      } else if (a.input(i) != b.input(i)) {
+        return false;
+      }
+    }
+    if (a_controls != b_controls) return false;
+    for (const auto& attr : a.attr()) {
+      auto it = b.attr().find(attr.first);
+      if (it == b.attr().end() || !AreAttrValuesEqual(attr.second, it->second))
+        return false;
+    }
+    return true;
+  }
+
+  // Makes the consumers of "node" read the same outputs of "representative".
+  void ForwardOutputs(const NodeDef& node, const NodeDef& representative) {
+    const std::set<NodeDef*> consumers = node_map_.GetOutputs(node.name());
+    for (NodeDef* consumer : consumers) {
+      bool has_control = false;
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        int position;
+        if (ParseNodeName(consumer->input(i), &position) != node.name()) {
+          continue;
+        }
+        if (position < 0) {
+          *consumer->mutable_input(i) =
+              strings::StrCat("^", representative.name());
+          has_control = true;
+        } else if (position == 0) {
+          *consumer->mutable_input(i) = representative.name();
+        } else {
+          *consumer->mutable_input(i) =
+              strings::StrCat(representative.name(), ":", position);
+        }
+      }
+      if (has_control) RemoveDuplicateControls(consumer);
+      node_map_.AddOutput(representative.name(), consumer->name());
+    }
+  }
+
+  void RemoveDuplicateControls(NodeDef* node) {
+    std::unordered_set<string> controls;
+    int num_kept = 0;
+    for (int i = 0; i < node->input_size(); ++i) {
+      if (IsControlInput(node->input(i)) &&
+          !controls.insert(node->input(i)).second) {
+        continue;
+      }
+      if (i != num_kept) node->mutable_input()->SwapElements(i, num_kept);
+      ++num_kept;
+    }
+    node->mutable_input()->DeleteSubrange(num_kept,
+                                          node->input_size() - num_kept);
+  }
+
+  GraphDef* graph_;
+  NodeMap node_map_;
+  const GraphProperties* properties_;
+  std::unordered_set<string> nodes_to_preserve_;
+};
+
+}  // namespace
+
+Status ArithmeticOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  TopologicalSort(optimized_graph);
+
+  GraphProperties properties(item);
+  Status s = properties.InferStatically();
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer graph shapes: " << s;
+  }
+
+  ArithmeticSimplifier simplifier(item, optimized_graph,
+                                  s.ok() ? &properties : nullptr);
+  const int num_simplified = simplifier.Simplify();
+  VLOG(1) << "Simplified " << num_simplified << " nodes. The graph now "
+          << "contains " << optimized_graph->node_size() << " nodes.";
+  return Status::OK();
+}
+
+void ArithmeticOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                   const GraphDef& optimized_graph,
+                                   double result) {
+  // Nothing to do for ArithmeticOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
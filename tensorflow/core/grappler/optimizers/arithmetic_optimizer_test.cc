@@ -0,0 +1,171 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ArithmeticOptimizerTest : public ::testing::Test {
+ protected:
+  static const NodeDef* Optimize(const Scope& s,
+                                 const std::vector<string>& fetch,
+                                 GraphDef* output, NodeMap** node_map) {
+    GrapplerItem item;
+    item.fetch = fetch;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    ArithmeticOptimizer optimizer;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, output));
+    *node_map = new NodeMap(output);
+    return (*node_map)->GetNode(fetch[0]);
+  }
+};
+
+TEST_F(ArithmeticOptimizerTest, NeutralElements) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 3}));
+  Output one = ops::Const(s.WithOpName("one"), 1.0f, {});
+  Output zeros = ops::Const(s.WithOpName("zeros"), 0.0f, {2, 3});
+  Output two = ops::Const(s.WithOpName("two"), 2.0f, {});
+  Output mul = ops::Mul(s.WithOpName("mul"), one, x);
+  Output add = ops::Add(s.WithOpName("add"), mul, zeros);
+  Output sub = ops::Sub(s.WithOpName("sub"), zeros, add);
+  Output div = ops::Div(s.WithOpName("div"), sub, two);
+  Output out = ops::Identity(s.WithOpName("out"), div);
+
+  GraphDef output;
+  NodeMap* node_map;
+  Optimize(s, {"out"}, &output, &node_map);
+  std::unique_ptr<NodeMap> node_map_owner(node_map);
+
+  const NodeDef* new_mul = node_map->GetNode("mul");
+  EXPECT_EQ("Identity", new_mul->op());
+  EXPECT_EQ("x", new_mul->input(0));
+  EXPECT_EQ(DT_FLOAT, new_mul->attr().at("T").type());
+  const NodeDef* new_add = node_map->GetNode("add");
+  EXPECT_EQ("Identity", new_add->op());
+  EXPECT_EQ("mul", new_add->input(0));
+  // 0 - x and x / 2 are not no-ops.
+  EXPECT_EQ("Sub", node_map->GetNode("sub")->op());
+  EXPECT_EQ("Div", node_map->GetNode("div")->op());
+}
+
+TEST_F(ArithmeticOptimizerTest, BroadcastingNeutralElement) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({3}));
+  Output ones = ops::Const(s.WithOpName("ones"), 1.0f, {2, 3});
+  Output mul = ops::Mul(s.WithOpName("mul"), x, ones);
+
+  GraphDef output;
+  NodeMap* node_map;
+  const NodeDef* new_mul = Optimize(s, {"mul"}, &output, &node_map);
+  std::unique_ptr<NodeMap> node_map_owner(node_map);
+  EXPECT_EQ("Mul", new_mul->op());
+}
+
+TEST_F(ArithmeticOptimizerTest, TransposeReshapeAndCastPairs) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 3, 4}));
+  Output nchw = ops::Transpose(s.WithOpName("to_nchw"), x, {0, 2, 1});
+  Output nhwc = ops::Transpose(s.WithOpName("to_nhwc"), nchw, {0, 2, 1});
+  Output flat = ops::Reshape(s.WithOpName("flat"), nhwc, {24});
+  Output square = ops::Reshape(s.WithOpName("square"), flat, {4, 6});
+  Output wide = ops::Cast(s.WithOpName("wide"), square, DT_DOUBLE);
+  Output narrow = ops::Cast(s.WithOpName("narrow"), wide, DT_FLOAT);
+  Output half = ops::Cast(s.WithOpName("half"), narrow, DT_HALF);
+  Output back = ops::Cast(s.WithOpName("back"), half, DT_FLOAT);
+
+  GraphDef output;
+  NodeMap* node_map;
+  Optimize(s, {"back"}, &output, &node_map);
+  std::unique_ptr<NodeMap> node_map_owner(node_map);
+
+  const NodeDef* to_nhwc = node_map->GetNode("to_nhwc");
+  EXPECT_EQ("Identity", to_nhwc->op());
+  EXPECT_EQ("x", to_nhwc->input(0));
+  const NodeDef* new_square = node_map->GetNode("square");
+  EXPECT_EQ("Reshape", new_square->op());
+  EXPECT_EQ("to_nhwc", new_square->input(0));
+  const NodeDef* new_narrow = node_map->GetNode("narrow");
+  EXPECT_EQ("Identity", new_narrow->op());
+  EXPECT_EQ("square", new_narrow->input(0));
+  // Casting to half loses precision.
+  EXPECT_EQ("Cast", node_map->GetNode("back")->op());
+}
+
+TEST_F(ArithmeticOptimizerTest, IdentityChains) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output id1 = ops::Identity(s.WithOpName("id1"), x);
+  Output id2 = ops::Identity(s.WithOpName("id2"), id1);
+  Output id3 = ops::Identity(s.WithOpName("id3"), id2);
+  Output copy = ops::Identity(s.WithOpName("copy").WithDevice("/CPU:1"), id3);
+
+  GraphDef output;
+  NodeMap* node_map;
+  Optimize(s, {"copy"}, &output, &node_map);
+  std::unique_ptr<NodeMap> node_map_owner(node_map);
+
+  // id2 and id3 become identities of x, like id1, and are then merged into
+  // it. The copy to another device is kept.
+  EXPECT_EQ(nullptr, node_map->GetNode("id2"));
+  EXPECT_EQ(nullptr, node_map->GetNode("id3"));
+  EXPECT_EQ("x", node_map->GetNode("id1")->input(0));
+  EXPECT_EQ("id1", node_map->GetNode("copy")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, CommonSubexpressions) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output c1 = ops::Const(s.WithOpName("c1"), 3.0f, {2});
+  Output c2 = ops::Const(s.WithOpName("c2"), 3.0f, {2});
+  Output c3 = ops::Const(s.WithOpName("c3"), 4.0f, {2});
+  Output a1 = ops::Add(s.WithOpName("a1"), x, c1);
+  Output a2 = ops::Add(s.WithOpName("a2"), x, c2);
+  Output a3 = ops::Add(s.WithOpName("a3"), x, c3);
+  Output r1 = ops::RandomUniform(s.WithOpName("r1"), {2}, DT_FLOAT);
+  Output r2 = ops::RandomUniform(s.WithOpName("r2"), {2}, DT_FLOAT);
+  Output out = ops::AddN(s.WithOpName("out"), {a1, a2, a3, r1, r2});
+
+  GraphDef output;
+  NodeMap* node_map;
+  const NodeDef* new_out = Optimize(s, {"out"}, &output, &node_map);
+  std::unique_ptr<NodeMap> node_map_owner(node_map);
+
+  EXPECT_EQ(nullptr, node_map->GetNode("c2"));
+  EXPECT_EQ(nullptr, node_map->GetNode("a2"));
+  ASSERT_EQ(5, new_out->input_size());
+  EXPECT_EQ("a1", new_out->input(0));
+  EXPECT_EQ("a1", new_out->input(1));
+  EXPECT_EQ("a3", new_out->input(2));
+  // Stateful ops are never merged.
+  EXPECT_EQ("r1", new_out->input(3));
+  EXPECT_EQ("r2", new_out->input(4));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
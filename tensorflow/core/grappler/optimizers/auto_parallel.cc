@@ -30,6 +30,23 @@ namespace tensorflow {
 namespace grappler {
 const char kAutoParallelPrefix[] = "AutoParallel";
 
+// Returns the position of the gradient input of the apply gradients op "op".
+static int GradientPosition(const string& op) {
+  static const std::map<string, int>* gradient_pos =
+      new std::map<string, int>({{"ApplyGradientDescent", 2},
+                                 {"ApplyProximalGradientDescent", 4},
+                                 {"ApplyAdadelta", 6},
+                                 {"ApplyAdagrad", 3},
+                                 {"ApplyProximalAdagrad", 5},
+                                 {"ApplyAdagradDA", 3},
+                                 {"ApplyFtrl", 3},
+                                 {"ApplyMomentum", 3},
+                                 {"ApplyAdam", 9},
+                                 {"ApplyRMSProp", 7},
+                                 {"ApplyCenteredRMSProp", 8}});
+  return gradient_pos->at(op);
+}
+
 NodeDef* AutoParallel::AddNodeDivConst() {
   NodeDef* node = graph_.add_node();
   node->set_name(strings::StrCat(kAutoParallelPrefix, "-Div-Const"));
@@ -121,28 +138,21 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
 
   auto div_const_node = AddNodeDivConst();
   all_nodes_.insert(std::make_pair(div_const_node->name(), div_const_node));
-  std::map<string, int> gradient_pos = {{"ApplyGradientDescent", 2},
-                                        {"ApplyProximalGradientDescent", 4},
-                                        {"ApplyAdadelta", 6},
-                                        {"ApplyAdagrad", 3},
-                                        {"ApplyProximalAdagrad", 5},
-                                        {"ApplyAdagradDA", 3},
-                                        {"ApplyFtrl", 3},
-                                        {"ApplyMomentum", 3},
-                                        {"ApplyAdam", 9},
-                                        {"ApplyRMSProp", 7},
-                                        {"ApplyCenteredRMSProp", 8}};
+  // With replicated variables, the gradients are averaged once all the
+  // replicas are built.
   for (const auto& apply_gradient_node_name : apply_gradients_nodes_) {
-    auto apply_gradients_op = all_nodes_[apply_gradient_node_name]->op();
+    if (replicate_variables_) {
+      break;
+    }
     auto apply_gradients_node = all_nodes_[apply_gradient_node_name];
+    const int gradient_pos = GradientPosition(apply_gradients_node->op());
 
-    auto div_node = AddNodeDiv(
-        apply_gradient_node_name,
-        apply_gradients_node->input(gradient_pos[apply_gradients_op]),
-        div_const_node->name());
+    auto div_node =
+        AddNodeDiv(apply_gradient_node_name,
+                   apply_gradients_node->input(gradient_pos),
+                   div_const_node->name());
     all_nodes_.insert(std::make_pair(div_node->name(), div_node));
-    *apply_gradients_node->mutable_input(gradient_pos[apply_gradients_op]) =
-        div_node->name();
+    *apply_gradients_node->mutable_input(gradient_pos) = div_node->name();
   }
   LOG(INFO) << "Graph size after adding div nodes: " << all_nodes_.size();
 
@@ -166,7 +176,15 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
 
   std::set<string> dont_replicate_nodes;
   for (const auto& variable : item.MainVariables()) {
-    dont_replicate_nodes.insert(variable->name());
+    if (!replicate_variables_) {
+      dont_replicate_nodes.insert(variable->name());
+    } else if (variable->op() != "Variable" &&
+               variable->op() != "VariableV2") {
+      return Status(error::INVALID_ARGUMENT,
+                    strings::StrCat("Only reference variables can be "
+                                    "replicated, not ",
+                                    variable->name()));
+    }
   }
 
   for (const auto& init : item.init_ops) {
@@ -234,11 +252,125 @@ void AutoParallel::AddOneReplica(GraphDef* graph, int number) {
   }
 }
 
+// Replaces the gradient input of the apply gradients nodes of all the replicas
+// by the average of the gradients of the replicas. The average is computed on
+// the first GPU, from which every replica reads it back.
+void AutoParallel::AddAllReduceNodes(GraphDef* graph) {
+  std::map<string, NodeDef*> nodes;
+  for (auto& node : *graph->mutable_node()) {
+    nodes[node.name()] = &node;
+  }
+  for (const auto& apply_gradient_node_name : apply_gradients_nodes_) {
+    const int gradient_pos =
+        GradientPosition(all_nodes_[apply_gradient_node_name]->op());
+    std::vector<NodeDef*> replicas;
+    for (int i = 0; i < num_replicas_; i++) {
+      string prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", i);
+      replicas.push_back(
+          nodes[AddPrefixToNodeName(apply_gradient_node_name, prefix)]);
+    }
+
+    NodeDef* sum = graph->add_node();
+    sum->set_name(strings::StrCat(kAutoParallelPrefix, "-AllReduce-",
+                                  apply_gradient_node_name));
+    sum->set_op("AddN");
+    for (const NodeDef* replica : replicas) {
+      sum->add_input(replica->input(gradient_pos));
+    }
+    AttrValue attr_type;
+    attr_type.set_type(DT_FLOAT);
+    sum->mutable_attr()->insert({"T", attr_type});
+    AttrValue attr_n;
+    attr_n.set_i(num_replicas_);
+    sum->mutable_attr()->insert({"N", attr_n});
+
+    NodeDef* average = graph->add_node();
+    average->set_name(strings::StrCat(kAutoParallelPrefix, "-Div-",
+                                      apply_gradient_node_name));
+    average->set_op("RealDiv");
+    average->add_input(sum->name());
+    average->add_input(strings::StrCat(kAutoParallelPrefix, "-Div-Const"));
+    average->mutable_attr()->insert({"T", attr_type});
+    if (num_gpus_ > 0) {
+      sum->set_device("/gpu:0");
+      average->set_device("/gpu:0");
+    }
+
+    for (NodeDef* replica : replicas) {
+      *replica->mutable_input(gradient_pos) = average->name();
+    }
+  }
+}
+
+// Initializes the copies of the variables of the replicas other than the
+// first one from the variables of the first replica, which are the ones the
+// init ops and the other shared nodes use. The init ops are renamed, and
+// replaced by NoOps that also run the new initializers.
+void AutoParallel::AddVariableInitializers(GraphDef* graph) {
+  std::map<string, std::vector<string>> initializers;
+  for (const NodeDef* node :
+       ComputeTransitiveFanin(item_->graph, item_->init_ops)) {
+    if (node->op() == "Assign") {
+      initializers[NodeName(node->input(0))].push_back(node->name());
+    }
+  }
+  string first_prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", 0);
+  std::set<string> replica_initializers;
+  for (const NodeDef* variable : item_->MainVariables()) {
+    for (int i = 1; i < num_replicas_; i++) {
+      string prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", i);
+      NodeDef* node = graph->add_node();
+      node->set_name(AddPrefixToNodeName(
+          variable->name(),
+          strings::StrCat(kAutoParallelPrefix, "-Init-Replica-", i)));
+      node->set_op("Assign");
+      if (num_gpus_ > 0) {
+        node->set_device(strings::StrCat("/gpu:", i % num_gpus_));
+      }
+      node->add_input(AddPrefixToNodeName(variable->name(), prefix));
+      node->add_input(AddPrefixToNodeName(variable->name(), first_prefix));
+      for (const auto& initializer : initializers[variable->name()]) {
+        node->add_input(strings::StrCat("^", initializer));
+      }
+      AttrValue attr_type;
+      attr_type.set_type(variable->attr().at("dtype").type());
+      node->mutable_attr()->insert({"T", attr_type});
+      replica_initializers.insert(node->name());
+    }
+  }
+
+  string init_prefix = strings::StrCat(kAutoParallelPrefix, "-Init");
+  std::set<string> init_ops;
+  for (const auto& init : item_->init_ops) {
+    init_ops.insert(NodeName(init));
+  }
+  for (auto& node : *graph->mutable_node()) {
+    if (init_ops.find(node.name()) != init_ops.end()) {
+      node.set_name(AddPrefixToNodeName(node.name(), init_prefix));
+    }
+    for (int i = 0; i < node.input_size(); i++) {
+      if (init_ops.find(NodeName(node.input(i))) != init_ops.end()) {
+        *node.mutable_input(i) =
+            AddPrefixToNodeName(node.input(i), init_prefix);
+      }
+    }
+  }
+  for (const auto& init : init_ops) {
+    std::set<string> deps = replica_initializers;
+    deps.insert(AddPrefixToNodeName(init, init_prefix));
+    AddNodeControl(init, deps, graph);
+  }
+}
+
 void AutoParallel::BuildGraph(GraphDef* graph) {
   AddSharedNodes(graph);
   for (int i = 0; i < num_replicas_; i++) {
     AddOneReplica(graph, i);
   }
+  if (replicate_variables_) {
+    AddAllReduceNodes(graph);
+    AddVariableInitializers(graph);
+  }
   std::set<string> fetches;
   for (size_t i = 0; i < item_->fetch.size(); i++) {
     for (int j = 0; j < num_replicas_; j++) {
@@ -24,9 +24,15 @@ namespace tensorflow {
 namespace grappler {
 
 // Automatically parallelize a graph by splitting in the batch dimension.
+// By default, the replicas share the variables, and each one applies its
+// gradients divided by the number of replicas. If "replicate_variables" is
+// true, each replica keeps a copy of the variables on its own GPU instead: the
+// gradients are averaged across the replicas, and every replica applies the
+// average to its copy, which keeps the copies in sync.
 class AutoParallel : public GraphOptimizer {
  public:
-  AutoParallel(int num_replicas) : num_replicas_(num_replicas) {
+  AutoParallel(int num_replicas, bool replicate_variables = false)
+      : num_replicas_(num_replicas), replicate_variables_(replicate_variables) {
     CHECK(num_replicas_ >= 2);
   }
   ~AutoParallel() override {}
@@ -47,6 +53,7 @@ class AutoParallel : public GraphOptimizer {
   std::set<string> shared_nodes_;
   const GrapplerItem* item_;
   int num_replicas_;
+  bool replicate_variables_;
   int num_gpus_;
   Status Initialize(const GrapplerItem& item);
   NodeDef* AddNodeDivConst();
@@ -57,6 +64,8 @@ class AutoParallel : public GraphOptimizer {
   bool NotSharedNode(const string& name);
   void AddSharedNodes(GraphDef* graph);
   void AddOneReplica(GraphDef* graph, int number);
+  void AddAllReduceNodes(GraphDef* graph);
+  void AddVariableInitializers(GraphDef* graph);
   void BuildGraph(GraphDef* graph);
 };
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -126,6 +127,71 @@ TEST_F(AutoParallelTest, SimpleParallel) {
   EXPECT_EQ("^AutoParallel-Control-Fetch", node_gradient.input(0));
 }
 
+TEST_F(AutoParallelTest, ReplicatedVariables) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output constant_a = ops::Const(s.WithOpName("constant_a"), 1.0f, {1});
+  Output constant_b = ops::Const(s.WithOpName("constant_b"), 1, {1});
+  Output var = ops::Variable(s.WithOpName("var"), {1}, DT_FLOAT);
+  Output assign = ops::Assign(s.WithOpName("assign"), {var}, {constant_a});
+  Output fifo_queue = ops::FIFOQueue(s.WithOpName("fifo_queue"), {DT_FLOAT});
+  auto dequeue = ops::QueueDequeueMany(s.WithOpName("dequeue"), {fifo_queue},
+                                       {constant_b}, {DT_FLOAT});
+  Output add = ops::AddN(s.WithOpName("add"), {constant_a, dequeue[0]});
+  Output learning_rate = ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+  Output apply_gradient = ops::ApplyGradientDescent(
+      s.WithOpName("apply_gradient"), {var}, {learning_rate}, {add});
+
+  GrapplerItem item;
+  item.init_ops.push_back("assign");
+  item.fetch.push_back("apply_gradient");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoParallel parallel(2, true);
+  GraphDef output;
+  Status status = parallel.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+  NodeMap node_map(&output);
+
+  // Each replica applies the average of the gradients to its own variable.
+  EXPECT_FALSE(node_map.GetNode("var"));
+  const NodeDef* sum =
+      node_map.GetNode("AutoParallel-AllReduce-apply_gradient");
+  ASSERT_TRUE(sum);
+  EXPECT_EQ("AddN", sum->op());
+  EXPECT_EQ("AutoParallel-Replica-0/add", sum->input(0));
+  EXPECT_EQ("AutoParallel-Replica-1/add", sum->input(1));
+  const NodeDef* average = node_map.GetNode("AutoParallel-Div-apply_gradient");
+  ASSERT_TRUE(average);
+  EXPECT_EQ(sum->name(), average->input(0));
+  EXPECT_EQ("AutoParallel-Div-Const", average->input(1));
+  for (int i = 0; i < 2; i++) {
+    string prefix = strings::StrCat("AutoParallel-Replica-", i);
+    const NodeDef* replica =
+        node_map.GetNode(AddPrefixToNodeName("apply_gradient", prefix));
+    ASSERT_TRUE(replica);
+    EXPECT_EQ(AddPrefixToNodeName("var", prefix), replica->input(0));
+    EXPECT_EQ(average->name(), replica->input(2));
+  }
+
+  // The init op initializes the variable of the first replica, then copies
+  // it to the second one.
+  const NodeDef* master_init = node_map.GetNode("AutoParallel-Init/assign");
+  ASSERT_TRUE(master_init);
+  EXPECT_EQ("AutoParallel-Replica-0/var", master_init->input(0));
+  const NodeDef* replica_init =
+      node_map.GetNode("AutoParallel-Init-Replica-1/var");
+  ASSERT_TRUE(replica_init);
+  EXPECT_EQ("Assign", replica_init->op());
+  EXPECT_EQ("AutoParallel-Replica-1/var", replica_init->input(0));
+  EXPECT_EQ("AutoParallel-Replica-0/var", replica_init->input(1));
+  EXPECT_EQ("^AutoParallel-Init/assign", replica_init->input(2));
+  const NodeDef* init = node_map.GetNode("assign");
+  ASSERT_TRUE(init);
+  EXPECT_EQ("NoOp", init->op());
+  EXPECT_EQ("^AutoParallel-Init-Replica-1/var", init->input(0));
+  EXPECT_EQ("^AutoParallel-Init/assign", init->input(1));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
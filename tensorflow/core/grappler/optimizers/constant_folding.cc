@@ -16,6 +16,9 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+
+#include <deque>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
@@ -97,6 +100,31 @@ string AsControlDependency(const NodeDef& node) {
   return strings::StrCat("^", node.name());
 }
 
+// Constants larger than this aren't materialized: they would bloat the graph,
+// and copying them is often slower than recomputing them.
+const int64 kMaxConstantSize = 10 * 1024 * 1024;
+
+// Sets "*value" to the value of the integer constant "node", which must have a
+// single element.
+bool GetScalarIntConstant(const NodeDef& node, int64* value) {
+  if (!IsConstant(node)) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+  } else if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 ConstantFolding::ConstantFolding() {
@@ -156,18 +184,24 @@ Status ConstantFolding::MaterializeShapes(const GrapplerItem& item,
   for (int i = 0; i < node_count; ++i) {
     NodeDef& node = *graph_.mutable_node(i);
     const string op = node.op();
+    if (op == "StridedSlice") {
+      MaterializeShapeElement(properties, &node);
+      continue;
+    }
     if (op != "Shape" && op != "Size" && op != "Rank") {
       continue;
     }
     std::vector<OpInfo::TensorProperties> output =
         properties.GetOutputProperties(node.name());
-    CHECK_EQ(1, output.size());
-    const DataType type = output[0].dtype();
-    CHECK(type == DT_INT32 || type == DT_INT64);
-
     std::vector<OpInfo::TensorProperties> input =
         properties.GetInputProperties(node.name());
-    CHECK_EQ(1, input.size());
+    if (output.size() != 1 || input.size() != 1) {
+      continue;
+    }
+    const DataType type = output[0].dtype();
+    if (type != DT_INT32 && type != DT_INT64) {
+      continue;
+    }
 
     const TensorShapeProto shape = input[0].shape();
     // Materialize the shapes using constants whenever possible.
@@ -238,6 +272,77 @@ Status ConstantFolding::MaterializeShapes(const GrapplerItem& item,
   return Status::OK();
 }
 
+void ConstantFolding::MaterializeShapeElement(
+    const GraphProperties& properties, NodeDef* node) {
+  // Look for shape[i], i.e. a StridedSlice that extracts a single element of
+  // a shape, which is often known statically even when other dimensions, such
+  // as the batch size, are not.
+  auto mask = [node](const string& name) {
+    auto it = node->attr().find(name);
+    return it == node->attr().end() ? 0 : it->second.i();
+  };
+  if (node->input_size() < 4 || mask("begin_mask") != 0 ||
+      mask("end_mask") != 0 || mask("ellipsis_mask") != 0 ||
+      mask("new_axis_mask") != 0 || mask("shrink_axis_mask") != 1) {
+    return;
+  }
+  const NodeDef* shape_node = node_map_->GetNode(node->input(0));
+  if (shape_node->op() != "Shape") {
+    return;
+  }
+  int64 begin;
+  int64 end;
+  int64 stride;
+  if (!GetScalarIntConstant(*node_map_->GetNode(node->input(1)), &begin) ||
+      !GetScalarIntConstant(*node_map_->GetNode(node->input(2)), &end) ||
+      !GetScalarIntConstant(*node_map_->GetNode(node->input(3)), &stride) ||
+      stride != 1 || end != begin + 1) {
+    return;
+  }
+  std::vector<OpInfo::TensorProperties> input =
+      properties.GetInputProperties(shape_node->name());
+  std::vector<OpInfo::TensorProperties> output =
+      properties.GetOutputProperties(shape_node->name());
+  if (input.size() != 1 || output.size() != 1) {
+    return;
+  }
+  const PartialTensorShape shape(input[0].shape());
+  const DataType type = output[0].dtype();
+  if (begin < 0) {
+    begin += shape.dims();
+  }
+  if (shape.unknown_rank() || begin < 0 || begin >= shape.dims() ||
+      shape.dim_size(begin) < 0 ||
+      (type == DT_INT32 && shape.dim_size(begin) >= INT_MAX)) {
+    return;
+  }
+  Tensor value(type, TensorShape({}));
+  if (type == DT_INT32) {
+    value.flat<int32>()(0) = shape.dim_size(begin);
+  } else {
+    value.flat<int64>()(0) = shape.dim_size(begin);
+  }
+
+  // Replace the slice with the constant. Like for materialized shapes, the
+  // constant is anchored on the input of the shape node, and the control
+  // dependencies of the slice are preserved.
+  const string ctrl_dep = AddControlDependency(shape_node->input(0));
+  node->set_op("Const");
+  node->clear_attr();
+  (*node->mutable_attr())["dtype"].set_type(type);
+  value.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+  std::vector<string> control_inputs = {ctrl_dep};
+  for (const string& input : node->input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    }
+  }
+  node->clear_input();
+  for (const string& input : control_inputs) {
+    *node->add_input() = input;
+  }
+}
+
 bool ConstantFolding::IsFoldable(const NodeDef& node) const {
   // Skips nodes that must be preserved, and op_types that don't benefit from
   // folding
@@ -395,6 +500,18 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
   if (output_tensors.empty()) {
     Status(error::INVALID_ARGUMENT, "Expected at least one output.");
   }
+  for (const auto& output_tensor : output_tensors) {
+    if (output_tensor.tensor &&
+        output_tensor.tensor->TotalBytes() > kMaxConstantSize) {
+      const size_t bytes = output_tensor.tensor->TotalBytes();
+      for (const auto& output : output_tensors) {
+        delete output.tensor;
+      }
+      return errors::InvalidArgument("The output of ", node.name(),
+                                     " is too large to fold: ", bytes,
+                                     " bytes");
+    }
+  }
   for (size_t i = 0; i < output_tensors.size(); i++) {
     string node_name = AddPrefixToNodeName(node.name(), kConstantFoldingConst);
     if (output_tensors.size() > 1) {
@@ -728,6 +845,184 @@ Status ConstantFolding::SimplifyGraph(GraphDef* output,
   return Status::OK();
 }
 
+Status ConstantFolding::RemoveDeadBranches(GraphDef* output) {
+  NodeMap node_map(output);
+  // The output that each Switch node with a constant predicate never
+  // generates.
+  std::unordered_map<const NodeDef*, int> dead_ports;
+  for (const auto& node : output->node()) {
+    if (!IsSwitch(node) || node.input_size() < 2 ||
+        nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+      continue;
+    }
+    const NodeDef* predicate = node_map.GetNode(node.input(1));
+    if (predicate == nullptr || !IsConstant(*predicate)) {
+      continue;
+    }
+    Tensor value;
+    if (!value.FromProto(predicate->attr().at("value").tensor()) ||
+        value.dtype() != DT_BOOL || value.NumElements() != 1) {
+      continue;
+    }
+    // Output 0 is taken when the predicate is false, output 1 when it's true.
+    dead_ports[&node] = value.flat<bool>()(0) ? 0 : 1;
+  }
+  if (dead_ports.empty()) {
+    return Status::OK();
+  }
+
+  // Propagate the deadness the way the executor does: a node is dead if any
+  // of its inputs is dead, except for merge nodes which are dead only if all
+  // their data inputs are dead. The control outputs of a switch are alive.
+  std::unordered_set<const NodeDef*> dead_nodes;
+  auto is_dead_input = [&node_map, &dead_ports,
+                        &dead_nodes](const string& input) {
+    int position;
+    const NodeDef* input_node =
+        node_map.GetNode(ParseNodeName(input, &position));
+    if (input_node == nullptr) {
+      return false;
+    }
+    if (dead_nodes.find(input_node) != dead_nodes.end()) {
+      return true;
+    }
+    auto it = dead_ports.find(input_node);
+    return it != dead_ports.end() && it->second == position;
+  };
+  std::deque<const NodeDef*> queue;
+  for (const auto& dead_port : dead_ports) {
+    for (const NodeDef* fanout :
+         node_map.GetOutputs(dead_port.first->name())) {
+      queue.push_back(fanout);
+    }
+  }
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    if (dead_nodes.find(node) != dead_nodes.end()) {
+      continue;
+    }
+    bool is_dead = false;
+    if (IsMerge(*node)) {
+      is_dead = true;
+      for (const auto& input : node->input()) {
+        if (!IsControlInput(input) && !is_dead_input(input)) {
+          is_dead = false;
+          break;
+        }
+      }
+    } else {
+      for (const auto& input : node->input()) {
+        if (is_dead_input(input)) {
+          is_dead = true;
+          break;
+        }
+      }
+    }
+    if (!is_dead) {
+      continue;
+    }
+    // Dead tensors that flow across frames or devices, or that are fetched,
+    // are part of the behavior of the graph: leave it alone.
+    if (nodes_to_preserve_.find(node->name()) != nodes_to_preserve_.end() ||
+        IsEnter(*node) || IsExit(*node) || IsNextIteration(*node) ||
+        IsSend(*node) || IsRecv(*node)) {
+      VLOG(1) << "Not removing dead branches: " << node->name()
+              << " would be removed";
+      return Status::OK();
+    }
+    dead_nodes.insert(node);
+    for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      queue.push_back(fanout);
+    }
+  }
+
+  for (auto& node : *output->mutable_node()) {
+    if (dead_nodes.find(&node) != dead_nodes.end()) {
+      continue;
+    }
+    auto it = dead_ports.find(&node);
+    if (it != dead_ports.end()) {
+      // The switch always forwards its input to the same output: replace it
+      // with an identity, and keep the predicate as a control dependency.
+      const int live_port = 1 - it->second;
+      const string predicate = NodeName(node.input(1));
+      node.set_op("Identity");
+      node.mutable_attr()->erase("_output_shapes");
+      node.mutable_input()->SwapElements(1, node.input_size() - 1);
+      node.mutable_input()->RemoveLast();
+      *node.add_input() = strings::StrCat("^", predicate);
+      if (live_port == 1) {
+        for (NodeDef* fanout : node_map.GetOutputs(node.name())) {
+          for (int i = 0; i < fanout->input_size(); ++i) {
+            if (fanout->input(i) == strings::StrCat(node.name(), ":1")) {
+              *fanout->mutable_input(i) = node.name();
+            }
+          }
+        }
+      }
+    } else if (IsMerge(node)) {
+      // Only keep the live inputs of the merge nodes.
+      std::vector<string> inputs;
+      int num_data_inputs = 0;
+      int num_dead_inputs = 0;
+      for (const auto& input : node.input()) {
+        if (is_dead_input(input)) {
+          ++num_dead_inputs;
+          continue;
+        }
+        inputs.push_back(input);
+        if (!IsControlInput(input)) {
+          ++num_data_inputs;
+        }
+      }
+      if (num_dead_inputs == 0) {
+        continue;
+      }
+      node.clear_input();
+      for (const auto& input : inputs) {
+        *node.add_input() = input;
+      }
+      (*node.mutable_attr())["N"].set_i(num_data_inputs);
+      // A merge with a single input is an identity, unless its value_index
+      // output is used.
+      bool uses_value_index =
+          nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end();
+      for (const NodeDef* fanout : node_map.GetOutputs(node.name())) {
+        for (const auto& input : fanout->input()) {
+          int position;
+          if (ParseNodeName(input, &position) == node.name() &&
+              position == 1) {
+            uses_value_index = true;
+          }
+        }
+      }
+      if (num_data_inputs == 1 && !uses_value_index) {
+        node.set_op("Identity");
+        node.mutable_attr()->erase("N");
+        node.mutable_attr()->erase("_output_shapes");
+      }
+    }
+  }
+
+  // Delete the dead nodes, keeping the order of the others.
+  int num_kept = 0;
+  for (int i = 0; i < output->node_size(); ++i) {
+    if (dead_nodes.find(&output->node(i)) != dead_nodes.end()) {
+      continue;
+    }
+    if (i != num_kept) {
+      output->mutable_node()->SwapElements(i, num_kept);
+    }
+    ++num_kept;
+  }
+  output->mutable_node()->DeleteSubrange(num_kept,
+                                         output->node_size() - num_kept);
+  VLOG(1) << "Removed " << dead_nodes.size() << " nodes in dead branches of "
+          << dead_ports.size() << " switch nodes";
+  return Status::OK();
+}
+
 Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* output) {
   graph_ = item.graph;
@@ -752,6 +1047,7 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   TF_RETURN_IF_ERROR(FoldGraph(output));
   TF_RETURN_IF_ERROR(SimplifyGraph(output, properties));
+  TF_RETURN_IF_ERROR(RemoveDeadBranches(output));
   LOG(INFO) << "Optimized graph size: " << output->node_size();
 
   *output->mutable_library() = item.graph.library();
@@ -48,6 +48,10 @@ class ConstantFolding : public GraphOptimizer {
   string AddControlDependency(const string& input_name);
   Status MaterializeShapes(const GrapplerItem& item,
                            const GraphProperties& properties);
+  // Replaces the StridedSlices that extract a statically known dimension from
+  // the output of a Shape node by constants.
+  void MaterializeShapeElement(const GraphProperties& properties,
+                               NodeDef* node);
 
   bool IsFoldable(const NodeDef& node) const;
 
@@ -69,6 +73,10 @@ class ConstantFolding : public GraphOptimizer {
                              const GraphProperties& properties) const;
   Status SimplifyGraph(GraphDef* output, const GraphProperties& properties);
 
+  // Removes the branches that Switch nodes with a constant predicate never
+  // take, which would otherwise only propagate dead tensors at run time.
+  Status RemoveDeadBranches(GraphDef* output);
+
   std::unique_ptr<DeviceBase> device_;
   GraphDef graph_;
   std::unique_ptr<NodeMap> node_map_;
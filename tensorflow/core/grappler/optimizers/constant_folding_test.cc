@@ -323,6 +323,83 @@ TEST_F(ConstantFoldingTest, ShapeMaterialization) {
   EXPECT_EQ(3, found);
 }
 
+TEST_F(ConstantFoldingTest, PartialShapeMaterialization) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(
+      scope.WithOpName("x"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 3, 4})));
+  Output shape = ops::Shape(scope.WithOpName("shape"), x);
+  auto element = [&scope, &shape](const string& name, int i) {
+    return ops::StridedSlice(scope.WithOpName(name), shape, {i}, {i + 1}, {1},
+                             ops::StridedSlice::ShrinkAxisMask(1));
+  };
+  Output batch = element("batch", 0);
+  Output d1 = element("d1", 1);
+  Output d2 = element("d2", 2);
+  Output size = ops::Multiply(scope.WithOpName("size"), d1, d2);
+  Output new_shape = ops::Stack(scope.WithOpName("new_shape"), {batch, size});
+  Output reshape = ops::Reshape(scope.WithOpName("reshape"), x, new_shape);
+
+  GrapplerItem item;
+  item.fetch.push_back("reshape");
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding fold;
+  GraphDef output;
+  Status status = fold.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  int found = 0;
+  for (const auto& node : output.node()) {
+    if (node.name() == "d1" || node.name() == "d2") {
+      ++found;
+      EXPECT_EQ("Const", node.op());
+      EXPECT_EQ(1, node.input_size());
+      EXPECT_EQ("^x", node.input(0));
+    } else if (node.name() == "batch") {
+      // The batch size isn't known statically.
+      ++found;
+      EXPECT_EQ("StridedSlice", node.op());
+    } else if (node.name() == "ConstantFolding/size") {
+      ++found;
+      EXPECT_EQ("Const", node.op());
+      Tensor value;
+      CHECK(value.FromProto(node.attr().at("value").tensor()));
+      EXPECT_EQ(12, value.flat<int>()(0));
+    } else if (node.name() == "new_shape") {
+      ++found;
+      EXPECT_EQ("batch", node.input(0));
+      EXPECT_EQ("ConstantFolding/size", node.input(1));
+    }
+  }
+  EXPECT_EQ(5, found);
+}
+
+TEST_F(ConstantFoldingTest, LargeConstantsAreNotFolded) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  // 16MB of floats.
+  Output dims = ops::Const(scope.WithOpName("dims"), {1024, 1024, 4}, {3});
+  Output zero = ops::Const(scope.WithOpName("zero"), 0.0f, {});
+  Output fill = ops::Fill(scope.WithOpName("fill"), dims, zero);
+  Output out = ops::Identity(scope.WithOpName("out"), fill);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding fold;
+  GraphDef output;
+  Status status = fold.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  for (const auto& node : output.node()) {
+    EXPECT_NE("ConstantFolding/fill", node.name());
+    if (node.name() == "out") {
+      EXPECT_EQ("fill", node.input(0));
+    }
+  }
+}
+
 TEST_F(ConstantFoldingTest, SwitchNodes) {
   tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
   ops::Variable v_in(scope.WithOpName("v_in"), {3}, DT_FLOAT);
@@ -375,12 +452,77 @@ TEST_F(ConstantFoldingTest, SwitchNodes) {
       EXPECT_EQ("Const", node.op());
       EXPECT_EQ(0, node.input_size());
     }
-    if (node.name() == "i3") {
+    // i3 is in the branch that switch2 never takes.
+    EXPECT_NE("i3", node.name());
+    if (node.name() == "switch2") {
       EXPECT_EQ("Identity", node.op());
+      EXPECT_EQ(2, node.input_size());
+      EXPECT_EQ("constant", node.input(0));
+      EXPECT_EQ("^false", node.input(1));
+    }
+  }
+}
+
+TEST_F(ConstantFoldingTest, DeadBranches) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output x =
+      ops::RandomNormal(scope.WithOpName("x"), {3, 5}, DataType::DT_FLOAT);
+  Output is_training =
+      ops::Const(scope.WithOpName("is_training"), false, TensorShape({}));
+  ops::Switch s(scope.WithOpName("switch"), x, is_training);
+  // The training branch is never taken.
+  ops::Square square(scope.WithOpName("square"), s.output_true);
+  ops::Identity train(scope.WithOpName("train"), square);
+  Output train_const =
+      ops::Const(scope.WithOpName("train_const").WithControlDependencies(train),
+                 1.0f, TensorShape({3, 5}));
+  ops::Add add(scope.WithOpName("add"), train, train_const);
+  ops::Relu infer(scope.WithOpName("infer"), s.output_false);
+  ops::Merge m(scope.WithOpName("m"), {add.z, infer.activations});
+  ops::Identity out(scope.WithOpName("out"), m.output);
+
+  // A merge whose value index is used is kept.
+  ops::Switch s2(scope.WithOpName("switch2"), x, is_training);
+  ops::Merge m2(scope.WithOpName("m2"), {s2.output_false, s2.output_true});
+  ops::Identity out2(scope.WithOpName("out2"), m2.value_index);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  item.fetch.push_back("out2");
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding fold;
+  GraphDef output;
+  Status status = fold.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  std::set<string> removed = {"square", "train", "train_const", "add"};
+  int found_nodes = 0;
+  for (const auto& node : output.node()) {
+    EXPECT_EQ(0, removed.count(node.name())) << node.name();
+    if (node.name() == "switch") {
+      EXPECT_EQ("Identity", node.op());
+      EXPECT_EQ(2, node.input_size());
+      EXPECT_EQ("x", node.input(0));
+      EXPECT_EQ("^is_training", node.input(1));
+      ++found_nodes;
+    } else if (node.name() == "infer") {
+      EXPECT_EQ("switch", node.input(0));
+      ++found_nodes;
+    } else if (node.name() == "m") {
+      EXPECT_EQ("Identity", node.op());
+      EXPECT_EQ(1, node.input_size());
+      EXPECT_EQ("infer", node.input(0));
+      ++found_nodes;
+    } else if (node.name() == "m2") {
+      EXPECT_EQ("Merge", node.op());
       EXPECT_EQ(1, node.input_size());
-      EXPECT_EQ("switch2:1", node.input(0));
+      EXPECT_EQ("switch2", node.input(0));
+      EXPECT_EQ(1, node.attr().at("N").i());
+      ++found_nodes;
     }
   }
+  EXPECT_EQ(4, found_nodes);
 }
 
 TEST_F(ConstantFoldingTest, MergeNodes) {
@@ -74,6 +74,40 @@ std::set<string> GetOpsFormatAgnostic() {
   return ops_format_agnostic;
 }
 
+// Returns true if the MKL layout pass (graph/mkl_layout_pass.cc) rewrites
+// "node" into an MKL kernel, which supports NCHW on CPU unlike the default CPU
+// kernels of these ops.
+bool HasMklKernel(const NodeDef& node, const NodeMap& node_map) {
+  auto type = node.attr().find("T");
+  if (type == node.attr().end() || type->second.type() != DT_FLOAT) {
+    return false;
+  }
+  const string& op = node.op();
+  if (op == "AvgPool" || op == "AvgPoolGrad" || op == "Conv2D" ||
+      op == "Conv2DBackpropFilter" || op == "Conv2DBackpropInput" ||
+      op == "FusedBatchNorm" || op == "FusedBatchNormGrad" ||
+      op == "MaxPoolGrad") {
+    return true;
+  }
+  if (op == "MaxPool") {
+    // MKL doesn't pool across the batch or depth dimensions.
+    for (const char* attr : {"ksize", "strides"}) {
+      auto it = node.attr().find(attr);
+      if (it == node.attr().end() || it->second.list().i_size() != 4 ||
+          it->second.list().i(0) != 1 || it->second.list().i(3) != 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (op == "BiasAdd") {
+    // A BiasAdd is only rewritten when merged into the convolution it follows.
+    const NodeDef* input = node_map.GetNode(node.input(0));
+    return input != nullptr && input->op() == "Conv2D";
+  }
+  return false;
+}
+
 bool IsNodeNHWCToNCHW(const string& node_name) {
   const string transpose_node_prefix = kTransposeNHWCToNCHW;
   string prefix = node_name.substr(0, transpose_node_prefix.length());
@@ -931,6 +965,9 @@ struct TuningConfig {
   // might result in more non-cancellable layout conversion nodes (implemented
   // by the Transpose op).
   bool no_gemm;
+  // If true, the graph runs on CPU, and only the ops that have MKL kernels
+  // are converted to NCHW.
+  bool mkl_on_cpu;
 };
 
 class DataLayoutOptimizer {
@@ -1007,7 +1044,8 @@ class DataLayoutOptimizer {
     std::set<string> ops_format_supported = GetOpsFormatSupported();
     for (int i = 0; i < graph_->node_size(); i++) {
       if (ops_format_supported.find(graph_->node(i).op()) !=
-          ops_format_supported.end()) {
+              ops_format_supported.end() &&
+          (!config_.mkl_on_cpu || HasMklKernel(graph_->node(i), node_map_))) {
         auto node = graph_->mutable_node(i);
         std::unique_ptr<NodeProcessor> node_processor;
         if (node->op().compare("AvgPoolGrad") == 0) {
@@ -1170,8 +1208,8 @@ Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   if (num_gpus_ == 0) {
     num_gpus_ = GetNumAvailableGPUs();
   }
-  if (num_gpus_ < 1) {
-    // LayoutOptimizer is currently only tuned for GPU.
+  if (num_gpus_ < 1 && !mkl_on_cpu_) {
+    // Without MKL, LayoutOptimizer is currently only tuned for GPU.
     *output = item.graph;
     return Status::OK();
   }
@@ -1185,13 +1223,16 @@ Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   *output = new_item.graph;
   TuningConfig config;
-  config.no_gemm = false;
+  config.mkl_on_cpu = num_gpus_ < 1;
+  // The NHWC GEMM special cases are those of the GPU kernels: on CPU, keep the
+  // 1x1 convolutions in the chains of MKL ops too.
+  config.no_gemm = config.mkl_on_cpu;
   DataLayoutOptimizer layout_optimizer(output, config);
   status = layout_optimizer.Optimize();
   // This is based on an empirical observation that if the introduced Transpose
   // nodes is more than 30, not using GEMM implementation would result in better
   // performance.
-  if (status.ok() && GetNumTranspose(*output) > 30) {
+  if (status.ok() && !config.no_gemm && GetNumTranspose(*output) > 30) {
     *output = new_item.graph;
     config.no_gemm = true;
     DataLayoutOptimizer layout_optimizer(output, config);
@@ -21,7 +21,11 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-// Convert the NHWC layout to NCHW for Conv-related ops on GPUs.
+// Convert the NHWC layout to NCHW for Conv-related ops on GPUs. Builds with
+// MKL also convert the ops that have MKL kernels on CPU: MKL turns NCHW
+// tensors into its channel-blocked layouts, and keeps them blocked between
+// consecutive MKL ops, so that only the boundaries of the NCHW chains pay for
+// layout conversions.
 class LayoutOptimizer : public GraphOptimizer {
  public:
   LayoutOptimizer() {}
@@ -31,6 +35,7 @@ class LayoutOptimizer : public GraphOptimizer {
 
   // This is for testing only.
   void set_num_gpus(int num_gpus) { num_gpus_ = num_gpus; };
+  void set_mkl_on_cpu(bool mkl_on_cpu) { mkl_on_cpu_ = mkl_on_cpu; };
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* output) override;
@@ -41,6 +46,11 @@ class LayoutOptimizer : public GraphOptimizer {
  private:
   Status InferOutputShapes(GrapplerItem* item);
   int num_gpus_ = 0;
+#ifdef INTEL_MKL
+  bool mkl_on_cpu_ = true;
+#else
+  bool mkl_on_cpu_ = false;
+#endif
 };
 
 }  // end namespace grappler
@@ -200,6 +200,60 @@ TEST_F(LayoutOptimizerTest, NotEqualSizeWithValidPadding) {
       node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input"));
 }
 
+TEST_F(LayoutOptimizerTest, CpuWithoutMklIsUnchanged) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 3, 2, "VALID");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_num_gpus(0);
+  optimizer.set_mkl_on_cpu(false);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(LayoutOptimizerTest, MklOnCpuConvertsConv2D) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  // A 1x1 convolution is kept NHWC on GPUs, but not with MKL.
+  auto conv = SimpleConv2D(&s, 2, 1, "SAME");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_num_gpus(0);
+  optimizer.set_mkl_on_cpu(true);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  EXPECT_TRUE(
+      node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input"));
+  EXPECT_EQ("NCHW", node_map.GetNode("Conv2D")->attr().at("data_format").s());
+}
+
+TEST_F(LayoutOptimizerTest, MklOnCpuSkipsDepthwiseMaxPool) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Tensor input_data(DT_FLOAT, TensorShape({8, 4, 4, 6}));
+  test::FillIota<float>(&input_data, 1.0f);
+  Output input =
+      ops::Const(s.WithOpName("Input"), Input::Initializer(input_data));
+  Output pool = ops::MaxPool(s.WithOpName("MaxPool"), input, {1, 1, 1, 2},
+                             {1, 1, 1, 2}, "VALID");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {pool});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_num_gpus(0);
+  optimizer.set_mkl_on_cpu(true);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  EXPECT_FALSE(
+      node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-MaxPool-Input"));
+  EXPECT_EQ("NHWC", node_map.GetNode("MaxPool")->attr().at("data_format").s());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,359 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Suffix of the Enter nodes that feed hoisted tensors back into their loop.
+const char kInvariantEnterSuffix[] = "/LoopInvariantEnter";
+
+bool IsLoopStructure(const NodeDef& node) {
+  return IsEnter(node) || IsExit(node) || IsMerge(node) || IsSwitch(node) ||
+         IsNextIteration(node) || node.op() == "LoopCond";
+}
+
+bool IsConstantEnter(const NodeDef& node) {
+  if (!IsEnter(node)) return false;
+  auto it = node.attr().find("is_constant");
+  return it != node.attr().end() && it->second.b();
+}
+
+// Nodes that forward a tensor unchanged are only worth hoisting if they feed
+// other hoisted nodes: otherwise they are just replaced by an Enter node.
+bool IsTrivial(const NodeDef& node) {
+  return IsConstant(node) || IsIdentity(node);
+}
+
+class LoopInvariantHoister {
+ public:
+  LoopInvariantHoister(const GrapplerItem& item, GraphDef* graph)
+      : graph_(graph), node_map_(graph) {
+    for (const auto& node : item.fetch) {
+      nodes_to_preserve_.insert(NodeName(node));
+    }
+    for (const auto& feed : item.feed) {
+      nodes_to_preserve_.insert(NodeName(feed.first));
+    }
+  }
+
+  // Hoists the loop-invariant nodes out of their frame, and returns the number
+  // of hoisted nodes.
+  int Hoist() {
+    const int num_nodes = graph_->node_size();
+    for (int i = 0; i < num_nodes; ++i) {
+      node_index_[graph_->node(i).name()] = i;
+    }
+    if (!AssignFrames()) {
+      VLOG(1) << "Couldn't infer the frames of the graph, skipping.";
+      return 0;
+    }
+    FindInvariantNodes();
+
+    // Collect the consumers before rewiring anything.
+    std::vector<std::vector<NodeDef*>> consumers(num_nodes);
+    for (int i = 0; i < num_nodes; ++i) {
+      if (!hoisted_[i]) continue;
+      for (NodeDef* consumer : node_map_.GetOutputs(graph_->node(i).name())) {
+        consumers[i].push_back(consumer);
+      }
+    }
+    int num_hoisted = 0;
+    for (int i = 0; i < num_nodes; ++i) {
+      if (!hoisted_[i]) continue;
+      HoistNode(i);
+      for (NodeDef* consumer : consumers[i]) {
+        if (hoisted_[node_index_[consumer->name()]]) continue;
+        RewireConsumer(i, consumer);
+      }
+      ++num_hoisted;
+    }
+    return num_hoisted;
+  }
+
+ private:
+  struct Frame {
+    string name;
+    int parent;
+    // The attrs and a data input of one of the Enter nodes of the frame.
+    AttrValue parallel_iterations;
+    string outer_node;
+  };
+
+  // Assigns each node to the frame it runs in, by propagating frames from the
+  // nodes without inputs: Enter nodes start a child frame of their input's
+  // frame, and Exit nodes go back to the parent frame. Returns false if some
+  // node couldn't be assigned a frame.
+  bool AssignFrames() {
+    const int num_nodes = graph_->node_size();
+    frames_.push_back(Frame{"", -1, AttrValue(), ""});
+    frame_.assign(num_nodes, -1);
+    std::map<std::pair<int, string>, int> frame_ids;
+    std::deque<int> ready;
+    for (int i = 0; i < num_nodes; ++i) {
+      if (graph_->node(i).input_size() == 0) {
+        frame_[i] = 0;
+        ready.push_back(i);
+      }
+    }
+    while (!ready.empty()) {
+      const int i = ready.front();
+      ready.pop_front();
+      const NodeDef& node = graph_->node(i);
+      for (const NodeDef* output : node_map_.GetOutputs(node.name())) {
+        const int j = node_index_[output->name()];
+        if (frame_[j] >= 0) continue;
+        int frame = frame_[i];
+        if (IsEnter(*output)) {
+          const string& frame_name = output->attr().at("frame_name").s();
+          auto it = frame_ids.find(std::make_pair(frame, frame_name));
+          if (it == frame_ids.end()) {
+            it = frame_ids
+                     .emplace(std::make_pair(frame, frame_name),
+                              static_cast<int>(frames_.size()))
+                     .first;
+            AttrValue parallel_iterations;
+            auto attr = output->attr().find("parallel_iterations");
+            if (attr != output->attr().end()) {
+              parallel_iterations = attr->second;
+            }
+            frames_.push_back(
+                Frame{frame_name, frame, parallel_iterations, node.name()});
+          }
+          frame = it->second;
+        } else if (IsExit(*output)) {
+          if (frame == 0) return false;
+          frame = frames_[frame].parent;
+        }
+        frame_[j] = frame;
+        ready.push_back(j);
+      }
+    }
+    for (int i = 0; i < num_nodes; ++i) {
+      if (frame_[i] < 0) return false;
+    }
+    return true;
+  }
+
+  // Returns true if "node", which runs in a loop, could be hoisted out of its
+  // frame if its inputs are invariant.
+  bool CanHoist(int i) {
+    const NodeDef& node = graph_->node(i);
+    if (frame_[i] == 0 || IsLoopStructure(node) || IsSend(node) ||
+        IsRecv(node) || nodes_to_preserve_.count(node.name()) > 0) {
+      return false;
+    }
+    const OpDef* op_def = nullptr;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        op_def->is_stateful()) {
+      return false;
+    }
+    DataTypeVector input_types;
+    return InOutTypesForNode(node, *op_def, &input_types, &output_types_[i])
+        .ok();
+  }
+
+  // Returns true if input "input" of node "i" doesn't change from one
+  // iteration of the loop to the next.
+  bool IsInvariantInput(int i, const string& input) {
+    auto it = node_index_.find(NodeName(input));
+    if (it == node_index_.end()) return false;
+    const int j = it->second;
+    if (frame_[j] != frame_[i]) return false;
+    return hoisted_[j] || IsConstantEnter(graph_->node(j));
+  }
+
+  void FindInvariantNodes() {
+    const int num_nodes = graph_->node_size();
+    hoisted_.assign(num_nodes, false);
+    output_types_.resize(num_nodes);
+    std::vector<bool> can_hoist(num_nodes);
+    for (int i = 0; i < num_nodes; ++i) {
+      can_hoist[i] = CanHoist(i);
+    }
+    // Grow the set of invariant nodes until it is stable, since the graph has
+    // cycles and can't be visited in topological order.
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int i = 0; i < num_nodes; ++i) {
+        if (hoisted_[i] || !can_hoist[i]) continue;
+        const NodeDef& node = graph_->node(i);
+        bool invariant = true;
+        for (const string& input : node.input()) {
+          // The control dependencies of constants only place them in the
+          // frame.
+          if (IsControlInput(input) && IsConstant(node)) continue;
+          if (!IsInvariantInput(i, input)) {
+            invariant = false;
+            break;
+          }
+        }
+        if (invariant) {
+          hoisted_[i] = true;
+          changed = true;
+        }
+      }
+    }
+    // Leave the trivial nodes that don't feed any hoisted node in the loop.
+    changed = true;
+    while (changed) {
+      changed = false;
+      for (int i = 0; i < num_nodes; ++i) {
+        if (!hoisted_[i] || !IsTrivial(graph_->node(i))) continue;
+        bool feeds_hoisted_node = false;
+        for (const NodeDef* output :
+             node_map_.GetOutputs(graph_->node(i).name())) {
+          if (hoisted_[node_index_[output->name()]]) {
+            feeds_hoisted_node = true;
+            break;
+          }
+        }
+        if (!feeds_hoisted_node) {
+          hoisted_[i] = false;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // Moves node "i" to the parent of its frame: its inputs from constant Enter
+  // nodes are replaced by the inputs of these Enter nodes.
+  void HoistNode(int i) {
+    NodeDef* node = graph_->mutable_node(i);
+    const Frame& frame = frames_[frame_[i]];
+    std::vector<string> inputs;
+    bool has_inputs = false;
+    for (const string& input : node->input()) {
+      auto it = node_index_.find(NodeName(input));
+      if (it == node_index_.end()) continue;
+      const int j = it->second;
+      if (hoisted_[j]) {
+        inputs.push_back(input);
+        has_inputs = true;
+      } else if (IsConstantEnter(graph_->node(j))) {
+        const string& outer_input = graph_->node(j).input(0);
+        inputs.push_back(IsControlInput(input)
+                             ? strings::StrCat("^", NodeName(outer_input))
+                             : outer_input);
+        has_inputs = true;
+      }
+      // Drop the control dependencies that only placed a constant in the
+      // frame.
+    }
+    // A constant has to stay in the parent frame, which needs a control
+    // dependency unless the parent is the root frame.
+    if (!has_inputs && frame.parent != 0) {
+      inputs.push_back(strings::StrCat("^", frame.outer_node));
+    }
+    node->clear_input();
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+  }
+
+  // Makes "consumer", which stays in the loop, read the outputs of the hoisted
+  // node "i" through constant Enter nodes.
+  void RewireConsumer(int i, NodeDef* consumer) {
+    const string& name = graph_->node(i).name();
+    for (int k = 0; k < consumer->input_size(); ++k) {
+      const string& input = consumer->input(k);
+      int port;
+      if (ParseNodeName(input, &port) != name) continue;
+      if (port < 0) {
+        *consumer->mutable_input(k) =
+            strings::StrCat("^", GetInvariantEnter(i, 0));
+      } else {
+        *consumer->mutable_input(k) = GetInvariantEnter(i, port);
+      }
+    }
+  }
+
+  // Returns the name of the constant Enter node that feeds output "port" of
+  // the hoisted node "i" into its former frame, creating it if needed.
+  string GetInvariantEnter(int i, int port) {
+    const NodeDef& node = graph_->node(i);
+    string name = strings::StrCat(node.name(), kInvariantEnterSuffix);
+    if (port > 0) strings::StrAppend(&name, "_", port);
+    if (invariant_enters_.insert(name).second) {
+      const Frame& frame = frames_[frame_[i]];
+      NodeDef* enter = graph_->add_node();
+      enter->set_name(name);
+      enter->set_op("Enter");
+      enter->set_device(node.device());
+      enter->add_input(port > 0 ? strings::StrCat(node.name(), ":", port)
+                                : node.name());
+      auto* attr = enter->mutable_attr();
+      (*attr)["T"].set_type(output_types_[i][port]);
+      (*attr)["frame_name"].set_s(frame.name);
+      (*attr)["is_constant"].set_b(true);
+      if (frame.parallel_iterations.value_case() != AttrValue::VALUE_NOT_SET) {
+        (*attr)["parallel_iterations"] = frame.parallel_iterations;
+      }
+    }
+    return name;
+  }
+
+  GraphDef* graph_;
+  NodeMap node_map_;
+  std::unordered_set<string> nodes_to_preserve_;
+  std::unordered_map<string, int> node_index_;
+  std::vector<Frame> frames_;
+  // The frame of each node, as an index in frames_.
+  std::vector<int> frame_;
+  std::vector<bool> hoisted_;
+  std::vector<DataTypeVector> output_types_;
+  std::unordered_set<string> invariant_enters_;
+};
+
+}  // namespace
+
+Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                               GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+
+  LoopInvariantHoister hoister(item, optimized_graph);
+  const int num_hoisted = hoister.Hoist();
+  VLOG(1) << "Hoisted " << num_hoisted << " loop-invariant nodes out of their "
+          << "loops.";
+  return Status::OK();
+}
+
+void LoopOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                             const GraphDef& optimized_graph, double result) {
+  // Nothing to do for LoopOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class LoopOptimizerTest : public ::testing::Test {
+ protected:
+  // Builds a loop that multiplies its variable by the transpose of "w" until
+  // it is larger than 10. The transpose doesn't depend on the loop variable.
+  static void BuildLoop(GrapplerItem* item) {
+    Scope s = Scope::NewRootScope();
+    auto dummy = ops::Placeholder(s.WithOpName("dummy"), DT_FLOAT);
+    auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+    auto w = ops::Placeholder(s.WithOpName("w"), DT_FLOAT);
+    auto enter_x = ops::internal::Enter(s.WithOpName("while/Enter"), x, "loop");
+    auto enter_w =
+        ops::internal::Enter(s.WithOpName("while/Enter_1"), w, "loop",
+                             ops::internal::Enter::IsConstant(true));
+    auto merge = ops::Merge(s.WithOpName("while/Merge"),
+                            std::initializer_list<Input>{enter_x, dummy});
+    auto ten = ops::Const<float>(
+        s.WithOpName("while/Less/y").WithControlDependencies(merge.output),
+        10.0f, {1, 1});
+    auto less = ops::Less(s.WithOpName("while/Less"), merge.output, ten);
+    auto loop_cond = ops::LoopCond(
+        s.WithOpName("while/LoopCond"),
+        ops::All(s.WithOpName("while/All"), less, {0, 1}));
+    auto switch_ =
+        ops::Switch(s.WithOpName("while/Switch"), merge.output, loop_cond);
+    auto exit = ops::internal::Exit(s.WithOpName("while/Exit"),
+                                    switch_.output_false);
+    auto identity =
+        ops::Identity(s.WithOpName("while/Identity"), switch_.output_true);
+    auto perm = ops::Const(
+        s.WithOpName("while/perm").WithControlDependencies(identity), {1, 0});
+    auto transpose =
+        ops::Transpose(s.WithOpName("while/Transpose"), enter_w, perm);
+    auto matmul =
+        ops::MatMul(s.WithOpName("while/MatMul"), identity, transpose);
+    auto next_iteration =
+        ops::NextIteration(s.WithOpName("while/NextIteration"), matmul);
+    auto y = ops::Identity(s.WithOpName("y"), exit);
+
+    s.graph()->RemoveNode(dummy.node());
+    s.graph()->AddEdge(next_iteration.node(), 0, merge.output.node(), 1);
+    TF_CHECK_OK(s.ToGraphDef(&item->graph));
+    item->fetch.push_back("y");
+  }
+};
+
+TEST_F(LoopOptimizerTest, HoistsInvariantNodes) {
+  GrapplerItem item;
+  BuildLoop(&item);
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size() + 1, output.node_size());
+
+  NodeMap node_map(&output);
+  // The transpose and its permutation now run outside of the loop.
+  const NodeDef* transpose = node_map.GetNode("while/Transpose");
+  ASSERT_NE(nullptr, transpose);
+  ASSERT_EQ(2, transpose->input_size());
+  EXPECT_EQ("w", transpose->input(0));
+  EXPECT_EQ("while/perm", transpose->input(1));
+  const NodeDef* perm = node_map.GetNode("while/perm");
+  ASSERT_NE(nullptr, perm);
+  EXPECT_EQ(0, perm->input_size());
+
+  // The matmul reads the transpose through a new loop constant.
+  const NodeDef* matmul = node_map.GetNode("while/MatMul");
+  ASSERT_NE(nullptr, matmul);
+  EXPECT_EQ("while/Transpose/LoopInvariantEnter", matmul->input(1));
+  const NodeDef* enter =
+      node_map.GetNode("while/Transpose/LoopInvariantEnter");
+  ASSERT_NE(nullptr, enter);
+  EXPECT_EQ("Enter", enter->op());
+  ASSERT_EQ(1, enter->input_size());
+  EXPECT_EQ("while/Transpose", enter->input(0));
+  EXPECT_EQ("loop", enter->attr().at("frame_name").s());
+  EXPECT_TRUE(enter->attr().at("is_constant").b());
+  EXPECT_EQ(DT_FLOAT, enter->attr().at("T").type());
+
+  // The constant of the loop condition isn't worth hoisting on its own.
+  const NodeDef* ten = node_map.GetNode("while/Less/y");
+  ASSERT_NE(nullptr, ten);
+  ASSERT_EQ(1, ten->input_size());
+  EXPECT_EQ("^while/Merge", ten->input(0));
+}
+
+TEST_F(LoopOptimizerTest, KeepsVariantNodes) {
+  GrapplerItem item;
+  BuildLoop(&item);
+  // Make the transpose depend on the loop variable.
+  for (auto& node : *item.graph.mutable_node()) {
+    if (node.name() == "while/Transpose") {
+      *node.mutable_input(0) = "while/Identity";
+    }
+  }
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  NodeMap node_map(&output);
+  const NodeDef* perm = node_map.GetNode("while/perm");
+  ASSERT_NE(nullptr, perm);
+  EXPECT_EQ("^while/Identity", perm->input(0));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -23,6 +23,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -440,7 +443,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                  (cheap_to_recompute_ops.count(node.op()) > 0 ||
                   node.attr().count(kRecomputeHint) > 0);
         });
-  } else {  // optimization_level == RewriterConfig::MANUAL
+  } else {  // MANUAL, SWAPPING_HEURISTICS or SCHEDULING_HEURISTICS
     recomputed_subgraphs =
         GetOpGroupsToRecompute(graph, node_map, [](const NodeDef& node) {
           return !IsTargetOp(node) && node.attr().count(kRecomputeHint) > 0;
@@ -583,12 +586,290 @@ static const NodeDef* FindSwapTrigger(
   return nullptr;
 }
 
+// Returns true if the outputs of "node" are known to live in host memory, in
+// which case there is no point in swapping them.
+static bool IsOnHost(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+      !DeviceNameUtils::ParseLocalName(node.device(), &parsed)) {
+    return false;
+  }
+  return parsed.has_type && (parsed.type == "CPU" || parsed.type == "cpu");
+}
+
+// Returns true if we can't reason about the lifetime of the outputs of "node"
+// from the static schedule: variables and constants are persistent, and the
+// execution times of nodes in loops and conditionals are meaningless.
+static bool IsUnswappable(const NodeDef& node) {
+  return IsVariable(node) || IsConstant(node) || IsEnter(node) ||
+         IsExit(node) || IsNextIteration(node) || IsSwitch(node) ||
+         IsMerge(node);
+}
+
+// Marks inputs to swap to host memory with the "_swap_to_host" attribute, so
+// that the estimated memory usage of the graph fits in "memory_target_bytes".
+// The candidates are the tensors that stay idle in device memory the longest
+// between their last two uses in the static schedule, typically activations
+// of the forward pass that are only needed again by their gradients. Only the
+// last use is swapped back in, so the device memory is freed in between.
+static Status IdentifySwappingCandidates(Cluster* cluster,
+                                         const GrapplerItem& item,
+                                         int64 memory_target_bytes,
+                                         GraphDef* optimized_graph) {
+  if (memory_target_bytes <= 0 && cluster) {
+    for (const auto& device : cluster->GetDevices()) {
+      const DeviceProperties& props = device.second;
+      if (props.type() == "GPU" && props.memory_size() > 0 &&
+          (memory_target_bytes <= 0 ||
+           props.memory_size() < memory_target_bytes)) {
+        memory_target_bytes = props.memory_size();
+      }
+    }
+  }
+  if (memory_target_bytes <= 0) {
+    // No target to fit in.
+    return Status::OK();
+  }
+
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferStatically());
+  const int64 memory_usage = memory.GetWorstCaseMemoryUsage();
+  if (memory_usage <= memory_target_bytes) {
+    return Status::OK();
+  }
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  TF_RETURN_IF_ERROR(
+      EstimateEarliestExecutionTimes(item, cluster, &execution_times));
+  std::unordered_map<string, const NodeDef*> name_map;
+  for (const auto& node : item.graph.node()) {
+    name_map[node.name()] = &node;
+  }
+
+  // The uses of each tensor, as (consumer, input index) pairs.
+  struct TensorUses {
+    const NodeDef* producer = nullptr;
+    int port = 0;
+    std::vector<std::pair<const NodeDef*, int>> consumers;
+  };
+  std::map<string, TensorUses> tensors;
+  for (const auto& node : item.graph.node()) {
+    if (IsUnswappable(node)) {
+      continue;
+    }
+    for (int i = 0; i < node.input_size(); ++i) {
+      const string& input = node.input(i);
+      if (IsControlInput(input)) {
+        break;
+      }
+      int port;
+      auto it = name_map.find(ParseNodeName(input, &port));
+      if (it == name_map.end()) {
+        continue;
+      }
+      TensorUses& uses = tensors[strings::StrCat(it->first, ":", port)];
+      uses.producer = it->second;
+      uses.port = port;
+      uses.consumers.emplace_back(&node, i);
+    }
+  }
+
+  struct Candidate {
+    const NodeDef* consumer;
+    int input_id;
+    int64 bytes;
+    // The bytes times the nanoseconds the tensor would otherwise stay idle.
+    double savings;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& tensor : tensors) {
+    const TensorUses& uses = tensor.second;
+    if (IsUnswappable(*uses.producer) || IsOnHost(*uses.producer)) {
+      continue;
+    }
+    auto producer_time = execution_times.find(uses.producer);
+    if (producer_time == execution_times.end()) {
+      continue;
+    }
+    // Find the last use, and the time of the use (or production) before it.
+    Costs::NanoSeconds previous_time = producer_time->second;
+    Costs::NanoSeconds last_time(-1);
+    const std::pair<const NodeDef*, int>* last_use = nullptr;
+    bool known_times = true;
+    for (const auto& use : uses.consumers) {
+      auto it = execution_times.find(use.first);
+      if (it == execution_times.end()) {
+        known_times = false;
+        break;
+      }
+      if (it->second > last_time) {
+        previous_time = std::max(previous_time, last_time);
+        last_time = it->second;
+        last_use = &use;
+      } else {
+        previous_time = std::max(previous_time, it->second);
+      }
+    }
+    if (!known_times || !last_use || last_time <= previous_time) {
+      continue;
+    }
+    const std::vector<OpInfo::TensorProperties> outputs =
+        properties.GetOutputProperties(uses.producer->name());
+    if (uses.port >= static_cast<int>(outputs.size())) {
+      continue;
+    }
+    Candidate candidate;
+    candidate.consumer = last_use->first;
+    candidate.input_id = last_use->second;
+    candidate.bytes = EstimateSize(outputs[uses.port]);
+    candidate.savings = static_cast<double>(candidate.bytes) *
+                        (last_time - previous_time).count();
+    candidates.push_back(candidate);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.savings > b.savings;
+            });
+
+  std::unordered_map<string, NodeDef*> optimized_nodes;
+  for (auto& node : *optimized_graph->mutable_node()) {
+    optimized_nodes[node.name()] = &node;
+  }
+  int64 saved_bytes = 0;
+  for (const Candidate& candidate : candidates) {
+    if (memory_usage - saved_bytes <= memory_target_bytes) {
+      break;
+    }
+    auto it = optimized_nodes.find(candidate.consumer->name());
+    if (it == optimized_nodes.end()) {
+      continue;
+    }
+    NodeDef* node = it->second;
+    // Leave manually annotated nodes alone, as well as the inputs that were
+    // rewired to recomputed nodes.
+    if (candidate.consumer->attr().count("_swap_to_host") > 0 ||
+        node->input_size() <= candidate.input_id ||
+        node->input(candidate.input_id) !=
+            candidate.consumer->input(candidate.input_id)) {
+      continue;
+    }
+    // Make sure the swap in can be delayed until shortly before the tensor is
+    // needed, otherwise swapping doesn't save anything.
+    SwapInfo swap_info;
+    swap_info.inputs_to_swap.push_back(candidate.input_id);
+    swap_info.time_to_swap = candidate.bytes / 16;
+    if (!FindSwapTrigger(candidate.consumer, swap_info, name_map,
+                         execution_times)) {
+      continue;
+    }
+    VLOG(1) << "Swapping input " << candidate.input_id << " of "
+            << node->name() << " (" << candidate.bytes << " bytes) to host";
+    (*node->mutable_attr())["_swap_to_host"].mutable_list()->add_i(
+        candidate.input_id);
+    saved_bytes += candidate.bytes;
+  }
+  return Status::OK();
+}
+
+// Adds control dependencies so that the nodes of each device run in the order
+// computed by ComputeMemoryMinimizingSchedule, if it lowers the estimated peak
+// memory usage of the graph. Only the nodes that compute something are
+// ordered, and only the dependencies that the graph doesn't already imply are
+// added.
+static Status ScheduleForPeakMemory(const GrapplerItem& item,
+                                    GraphDef* optimized_graph) {
+  for (const auto& node : optimized_graph->node()) {
+    if (IsUnswappable(node) && !IsVariable(node) && !IsConstant(node)) {
+      // The schedule is meaningless for loops and conditionals.
+      return Status::OK();
+    }
+  }
+  GrapplerItem scheduled_item = item;
+  scheduled_item.graph = *optimized_graph;
+  std::vector<const NodeDef*> schedule;
+  int64 peak_bytes;
+  int64 default_peak_bytes;
+  TF_RETURN_IF_ERROR(ComputeMemoryMinimizingSchedule(
+      scheduled_item, &schedule, &peak_bytes, &default_peak_bytes));
+  VLOG(1) << "Estimated peak memory: " << default_peak_bytes
+          << " bytes, or " << peak_bytes << " bytes with the memory minimizing "
+          << "schedule";
+  if (peak_bytes >= default_peak_bytes) {
+    return Status::OK();
+  }
+
+  std::unordered_map<const NodeDef*, int> position;
+  std::unordered_map<const NodeDef*, std::vector<const NodeDef*>> fanouts;
+  {
+    NodeMap node_map(&scheduled_item.graph);
+    for (int i = 0; i < static_cast<int>(schedule.size()); ++i) {
+      position[schedule[i]] = i;
+      for (const string& input : schedule[i]->input()) {
+        fanouts[node_map.GetNode(input)].push_back(schedule[i]);
+      }
+    }
+  }
+  // Returns true if "to" already runs after "from". Only the nodes scheduled
+  // between the two can be on a path from one to the other.
+  auto depends_on = [&position, &fanouts](const NodeDef* to,
+                                          const NodeDef* from) {
+    const int to_position = position[to];
+    std::unordered_set<const NodeDef*> visited;
+    std::vector<const NodeDef*> queue = {from};
+    while (!queue.empty()) {
+      const NodeDef* node = queue.back();
+      queue.pop_back();
+      for (const NodeDef* fanout : fanouts[node]) {
+        if (fanout == to) {
+          return true;
+        }
+        if (position[fanout] < to_position && visited.insert(fanout).second) {
+          queue.push_back(fanout);
+        }
+      }
+    }
+    return false;
+  };
+
+  std::unordered_map<string, NodeDef*> optimized_nodes;
+  for (auto& node : *optimized_graph->mutable_node()) {
+    optimized_nodes[node.name()] = &node;
+  }
+  std::unordered_map<string, const NodeDef*> last_node_per_device;
+  int num_dependencies = 0;
+  for (const NodeDef* node : schedule) {
+    if (node->input_size() == 0 || IsVariable(*node) || IsConstant(*node)) {
+      continue;
+    }
+    const NodeDef*& last_node = last_node_per_device[node->device()];
+    if (last_node && !depends_on(node, last_node)) {
+      *optimized_nodes[node->name()]->add_input() =
+          strings::StrCat("^", last_node->name());
+      ++num_dependencies;
+    }
+    last_node = node;
+  }
+  VLOG(1) << "Added " << num_dependencies
+          << " control dependencies to enforce the schedule";
+  return Status::OK();
+}
+
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* optimized_graph) {
   *optimized_graph = item.graph;
 
   RecomputationRewritingPass(optimization_level_, optimized_graph);
 
+  if (optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS) {
+    TF_RETURN_IF_ERROR(IdentifySwappingCandidates(
+        cluster, item, memory_target_bytes_, optimized_graph));
+  }
+  if (optimization_level_ == RewriterConfig::SCHEDULING_HEURISTICS) {
+    TF_RETURN_IF_ERROR(ScheduleForPeakMemory(item, optimized_graph));
+  }
+
   // Figure out what needs to be swapped;
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   for (auto& node : *optimized_graph->mutable_node()) {
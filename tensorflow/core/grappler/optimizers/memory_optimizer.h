@@ -25,8 +25,12 @@ namespace grappler {
 // Swap tensors in and out of device memory.
 class MemoryOptimizer : public GraphOptimizer {
  public:
-  explicit MemoryOptimizer(RewriterConfig::MemOptType optimization_level)
-      : optimization_level_(optimization_level) {}
+  // "memory_target_bytes" is only used by the SWAPPING_HEURISTICS level, see
+  // RewriterConfig.memory_optimizer_target_bytes.
+  explicit MemoryOptimizer(RewriterConfig::MemOptType optimization_level,
+                           int64 memory_target_bytes = 0)
+      : optimization_level_(optimization_level),
+        memory_target_bytes_(memory_target_bytes) {}
   ~MemoryOptimizer() override {}
 
   string name() const override { return "memory_optimizer"; };
@@ -39,6 +43,7 @@ class MemoryOptimizer : public GraphOptimizer {
 
  private:
   RewriterConfig::MemOptType optimization_level_;
+  int64 memory_target_bytes_;
 };
 
 }  // end namespace grappler
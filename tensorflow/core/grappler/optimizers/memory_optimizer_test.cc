@@ -223,6 +223,95 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   EXPECT_EQ("^c", swap_in.input(1));
 }
 
+TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output a = ops::Variable(s.WithOpName("a"), {10, 10}, DT_FLOAT);
+  Output b = ops::AddN(s.WithOpName("b"), {a});
+  Output c = ops::AddN(s.WithOpName("c"), {b});
+  Output d = ops::AddN(s.WithOpName("d"), {c});
+  Output e = ops::AddN(s.WithOpName("e"), {b, d});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // All the outputs take 2000 bytes: swapping b, which is idle for the
+  // longest time, is enough to fit in 1800 bytes.
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS, 1800);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(7, output.node_size());
+  const NodeDef& new_e = output.node(4);
+  EXPECT_EQ(NodeName(e.name()), new_e.name());
+  EXPECT_EQ("swap_in_e_0", new_e.input(0));
+  EXPECT_EQ(NodeName(d.name()), new_e.input(1));
+
+  const NodeDef& swap_out = output.node(5);
+  EXPECT_EQ("swap_out_e_0", swap_out.name());
+  EXPECT_EQ(NodeName(b.name()), swap_out.input(0));
+}
+
+TEST_F(MemoryOptimizerTest, SwappingHeuristicsUnderTarget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output a = ops::Variable(s.WithOpName("a"), {10, 10}, DT_FLOAT);
+  Output b = ops::AddN(s.WithOpName("b"), {a});
+  Output c = ops::AddN(s.WithOpName("c"), {b});
+  Output d = ops::AddN(s.WithOpName("d"), {b, c});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS, 1 << 20);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(4, output.node_size());
+}
+
+TEST_F(MemoryOptimizerTest, SchedulingHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output x = ops::Variable(s.WithOpName("x"), {10, 10}, DT_FLOAT);
+  Output a1 = ops::Tile(s.WithOpName("a1"), x, {10, 10});
+  Output b1 = ops::Tile(s.WithOpName("b1"), x, {10, 10});
+  Output a2 = ops::Sum(s.WithOpName("a2"), a1, {0, 1});
+  Output b2 = ops::Sum(s.WithOpName("b2"), b1, {0, 1});
+  Output out = ops::AddN(s.WithOpName("out"), {a2, b2});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch.push_back("out");
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // Only the dependency of b1 on a2 is needed to keep a single large tiled
+  // tensor alive at a time.
+  MemoryOptimizer optimizer(RewriterConfig::SCHEDULING_HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  int num_control_dependencies = 0;
+  for (const NodeDef& node : output.node()) {
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) {
+        ++num_control_dependencies;
+        EXPECT_EQ("b1", node.name());
+        EXPECT_EQ("^a2", input);
+      }
+    }
+  }
+  EXPECT_EQ(1, num_control_dependencies);
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
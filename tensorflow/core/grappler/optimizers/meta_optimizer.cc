@@ -16,12 +16,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/op_fusion_optimizer.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -46,7 +49,17 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
   }
   if (optimizer == "autoparallel") {
     graph_optimizer.reset(
-        new AutoParallel(cfg_.auto_parallel().num_replicas()));
+        new AutoParallel(cfg_.auto_parallel().num_replicas(),
+                         cfg_.auto_parallel().replicate_variables()));
+  }
+  if (optimizer == "fusion") {
+    graph_optimizer.reset(new OpFusionOptimizer());
+  }
+  if (optimizer == "loop") {
+    graph_optimizer.reset(new LoopOptimizer());
+  }
+  if (optimizer == "arithmetic") {
+    graph_optimizer.reset(new ArithmeticOptimizer());
   }
   return graph_optimizer;
 }
@@ -58,6 +71,10 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     if (!cfg_.disable_model_pruning()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(new ModelPruner()));
     }
+    if (cfg_.loop_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new LoopOptimizer()));
+    }
     if (cfg_.constant_folding()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new ConstantFolding()));
@@ -66,17 +83,29 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new LayoutOptimizer()));
     }
+    if (cfg_.op_fusion()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new OpFusionOptimizer()));
+    }
     if (cfg_.memory_optimization() > 0) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
-          new MemoryOptimizer(cfg_.memory_optimization())));
+          new MemoryOptimizer(cfg_.memory_optimization(),
+                              cfg_.memory_optimizer_target_bytes())));
     }
     if (cfg_.auto_parallel().enable()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
-          new AutoParallel(cfg_.auto_parallel().num_replicas())));
+          new AutoParallel(cfg_.auto_parallel().num_replicas(),
+                           cfg_.auto_parallel().replicate_variables())));
+    }
+    // Runs last, to clean up after the passes that insert nodes.
+    if (cfg_.arithmetic_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new ArithmeticOptimizer()));
     }
   } else {
-    std::set<string> available_optimizers = {"pruning", "constfold", "layout",
-                                             "memory", "autoparallel"};
+    std::set<string> available_optimizers = {
+        "pruning",      "constfold", "layout", "memory",
+        "autoparallel", "fusion",    "loop",   "arithmetic"};
     for (const auto& optimizer : cfg_.optimizers()) {
       if (available_optimizers.find(optimizer) != available_optimizers.end()) {
         optimizers.push_back(NewOptimizer(optimizer));
@@ -122,7 +151,8 @@ void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
 bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
   return cfg.optimize_tensor_layout() || cfg.constant_folding() ||
          cfg.auto_parallel().enable() || cfg.memory_optimization() > 0 ||
-         !cfg.optimizers().empty();
+         cfg.op_fusion() || cfg.loop_optimization() ||
+         cfg.arithmetic_optimization() || !cfg.optimizers().empty();
 }
 
 Status RunMetaOptimizer(const GrapplerItem& item, const RewriterConfig& cfg,
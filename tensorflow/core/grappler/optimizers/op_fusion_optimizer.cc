@@ -0,0 +1,333 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/op_fusion_optimizer.h"
+
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+bool IsActivation(const string& op) {
+  return op == "Relu" || op == "Relu6" || op == "Tanh" || op == "Elu";
+}
+
+bool IsActivation(const NodeDef& node) { return IsActivation(node.op()); }
+
+bool IsNHWC(const NodeDef& node) {
+  auto it = node.attr().find("data_format");
+  return it == node.attr().end() || it->second.s() == "NHWC";
+}
+
+// The fused kernels only exist for NHWC biases.
+bool IsNHWCBiasAdd(const NodeDef& node) {
+  return node.op() == "BiasAdd" && IsNHWC(node);
+}
+
+// _FusedConv2D only folds inference-mode batch normalizations, whose mean and
+// variance are inputs rather than computed from the batch.
+bool IsNHWCInferenceBatchNorm(const NodeDef& node) {
+  if (node.op() != "FusedBatchNorm" || !IsNHWC(node)) return false;
+  auto it = node.attr().find("is_training");
+  return it != node.attr().end() && !it->second.b();
+}
+
+bool HasType(const NodeDef& node, std::initializer_list<DataType> types) {
+  auto it = node.attr().find("T");
+  if (it == node.attr().end()) return false;
+  for (DataType type : types) {
+    if (it->second.type() == type) return true;
+  }
+  return false;
+}
+
+// The fused kernels are only registered for CPU and GPU.
+bool HasFusedKernels(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  if (node.device().empty() ||
+      !DeviceNameUtils::ParseFullName(node.device(), &parsed) ||
+      !parsed.has_type) {
+    return true;
+  }
+  return parsed.type == "CPU" || parsed.type == "GPU";
+}
+
+// Copies the "transpose_a" and "transpose_b" attrs of a MatMul, which may have
+// been stripped if they had their default value.
+void CopyTransposeAttrs(const NodeDef& from, NodeDef* to) {
+  for (const char* name : {"transpose_a", "transpose_b"}) {
+    auto it = from.attr().find(name);
+    if (it != from.attr().end()) {
+      (*to->mutable_attr())[name] = it->second;
+    } else {
+      (*to->mutable_attr())[name].set_b(false);
+    }
+  }
+}
+
+// Copies the convolution attrs of a Conv2D or _FusedConv2D "conv" to "to",
+// which becomes a _FusedConv2D that also applies "fused_op", taking
+// "num_args" more args.
+void SetFusedConv2DAttrs(const NodeDef& conv, const string& fused_op,
+                         int num_args, NodeDef* to) {
+  auto* attr = to->mutable_attr();
+  for (const char* name :
+       {"strides", "padding", "use_cudnn_on_gpu", "data_format"}) {
+    auto it = conv.attr().find(name);
+    if (it != conv.attr().end()) {
+      (*attr)[name] = it->second;
+    } else {
+      attr->erase(name);
+    }
+  }
+  // A FusedBatchNorm keeps its own epsilon, and later consumers inherit it.
+  auto epsilon = conv.attr().find("epsilon");
+  if (epsilon != conv.attr().end()) (*attr)["epsilon"] = epsilon->second;
+  attr->erase("is_training");
+  AttrValue fused_ops;
+  int total_num_args = num_args;
+  if (conv.op() == "_FusedConv2D") {
+    fused_ops = conv.attr().at("fused_ops");
+    total_num_args += conv.attr().at("num_args").i();
+  }
+  fused_ops.mutable_list()->add_s(fused_op);
+  (*attr)["fused_ops"] = fused_ops;
+  (*attr)["num_args"].set_i(total_num_args);
+  to->set_op("_FusedConv2D");
+}
+
+// Returns the ops that were fused into a _FusedConv2D.
+std::vector<string> FusedConv2DOps(const NodeDef& node) {
+  const auto& list = node.attr().at("fused_ops").list();
+  return std::vector<string>(list.s().begin(), list.s().end());
+}
+
+class Fuser {
+ public:
+  Fuser(const GrapplerItem& item, GraphDef* graph)
+      : graph_(graph), node_map_(graph) {
+    for (const auto& node : item.fetch) {
+      nodes_to_preserve_.insert(NodeName(node));
+    }
+    for (const auto& feed : item.feed) {
+      nodes_to_preserve_.insert(NodeName(feed.first));
+    }
+  }
+
+  // Fuses all the supported chains.  Expects the graph to be topologically
+  // sorted, so that longer chains are fused one op at a time.
+  int Fuse() {
+    for (int i = 0; i < graph_->node_size(); ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      if (IsActivation(*node)) {
+        FuseIntoActivation(node);
+      } else if (IsNHWCBiasAdd(*node)) {
+        FuseIntoBiasAdd(node);
+      } else if (IsNHWCInferenceBatchNorm(*node)) {
+        FuseIntoBatchNorm(node);
+      }
+    }
+    // Deletes the nodes that were folded into their consumer, keeping the
+    // order of the others.
+    int num_kept = 0;
+    for (int i = 0; i < graph_->node_size(); ++i) {
+      if (fused_.count(graph_->node(i).name()) > 0) continue;
+      if (i != num_kept) graph_->mutable_node()->SwapElements(i, num_kept);
+      ++num_kept;
+    }
+    const int num_fused = graph_->node_size() - num_kept;
+    graph_->mutable_node()->DeleteSubrange(num_kept, num_fused);
+    return num_fused;
+  }
+
+ private:
+  // Returns the producer of the first input of "consumer" if it can be folded
+  // into "consumer", and nullptr otherwise.
+  NodeDef* FusableProducer(const NodeDef& consumer) {
+    if (consumer.input_size() == 0 || IsControlInput(consumer.input(0)) ||
+        NodePosition(consumer.input(0)) != 0 || !HasFusedKernels(consumer)) {
+      return nullptr;
+    }
+    NodeDef* producer = node_map_.GetNode(consumer.input(0));
+    if (producer == nullptr || fused_.count(producer->name()) > 0 ||
+        nodes_to_preserve_.count(producer->name()) > 0 ||
+        producer->device() != consumer.device()) {
+      return nullptr;
+    }
+    // The consumer must be the only user of the producer, either as a data
+    // or a control input.
+    const auto& outputs = node_map_.GetOutputs(producer->name());
+    if (outputs.size() != 1 || *outputs.begin() != &consumer) {
+      return nullptr;
+    }
+    for (int i = 1; i < consumer.input_size(); ++i) {
+      if (NodeName(consumer.input(i)) == producer->name()) return nullptr;
+    }
+    auto producer_type = producer->attr().find("T");
+    auto consumer_type = consumer.attr().find("T");
+    if (producer_type == producer->attr().end() ||
+        consumer_type == consumer.attr().end() ||
+        producer_type->second.type() != consumer_type->second.type()) {
+      return nullptr;
+    }
+    return producer;
+  }
+
+  // Replaces the first input of "consumer" by the data inputs of "producer",
+  // and moves the control inputs of "producer" to "consumer".
+  void FoldProducer(NodeDef* producer, NodeDef* consumer) {
+    std::vector<string> data_inputs;
+    std::vector<string> control_inputs;
+    for (const string& input : producer->input()) {
+      if (IsControlInput(input)) {
+        control_inputs.push_back(input);
+      } else {
+        data_inputs.push_back(input);
+      }
+      node_map_.UpdateOutput(NodeName(input), producer->name(),
+                             consumer->name());
+    }
+    for (int i = 1; i < consumer->input_size(); ++i) {
+      if (IsControlInput(consumer->input(i))) {
+        control_inputs.push_back(consumer->input(i));
+      } else {
+        data_inputs.push_back(consumer->input(i));
+      }
+    }
+    consumer->clear_input();
+    for (const string& input : data_inputs) consumer->add_input(input);
+    for (const string& input : control_inputs) consumer->add_input(input);
+    fused_.insert(producer->name());
+  }
+
+  // Returns true if outputs of "node" other than the first one are used.
+  bool HasUsedSideOutputs(const NodeDef& node) {
+    for (const NodeDef* output : node_map_.GetOutputs(node.name())) {
+      for (const string& input : output->input()) {
+        if (NodeName(input) == node.name() && NodePosition(input) > 0) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // MatMul -> BiasAdd becomes _FusedMatMul, and Conv2D -> BiasAdd becomes
+  // _FusedConv2D.
+  void FuseIntoBiasAdd(NodeDef* bias_add) {
+    NodeDef* producer = FusableProducer(*bias_add);
+    if (producer == nullptr) return;
+    if (producer->op() == "MatMul" &&
+        HasType(*producer, {DT_FLOAT, DT_DOUBLE})) {
+      FoldProducer(producer, bias_add);
+      bias_add->set_op("_FusedMatMul");
+      auto* attr = bias_add->mutable_attr();
+      attr->erase("data_format");
+      CopyTransposeAttrs(*producer, bias_add);
+      (*attr)["activation"].set_s("Identity");
+    } else if (producer->op() == "Conv2D" && IsNHWC(*producer) &&
+               HasType(*producer, {DT_HALF, DT_FLOAT})) {
+      FoldProducer(producer, bias_add);
+      SetFusedConv2DAttrs(*producer, "BiasAdd", 1, bias_add);
+    }
+  }
+
+  // Conv2D -> FusedBatchNorm and _FusedConv2D(BiasAdd) -> FusedBatchNorm
+  // become _FusedConv2D.
+  void FuseIntoBatchNorm(NodeDef* batch_norm) {
+    // The fused node only has the first output of the batch normalization.
+    if (nodes_to_preserve_.count(batch_norm->name()) > 0 ||
+        HasUsedSideOutputs(*batch_norm)) {
+      return;
+    }
+    NodeDef* producer = FusableProducer(*batch_norm);
+    if (producer == nullptr || !HasType(*producer, {DT_HALF, DT_FLOAT})) {
+      return;
+    }
+    if ((producer->op() == "Conv2D" && IsNHWC(*producer)) ||
+        (producer->op() == "_FusedConv2D" &&
+         FusedConv2DOps(*producer) == std::vector<string>({"BiasAdd"}))) {
+      FoldProducer(producer, batch_norm);
+      SetFusedConv2DAttrs(*producer, "FusedBatchNorm", 4, batch_norm);
+    }
+  }
+
+  // BiasAdd -> activation becomes _FusedBiasActivation, and
+  // _FusedMatMul -> activation and _FusedConv2D -> activation fold the
+  // activation into the _FusedMatMul or _FusedConv2D.
+  void FuseIntoActivation(NodeDef* activation) {
+    NodeDef* producer = FusableProducer(*activation);
+    if (producer == nullptr) return;
+    if (IsNHWCBiasAdd(*producer) &&
+        HasType(*producer, {DT_HALF, DT_FLOAT, DT_DOUBLE})) {
+      const string activation_op = activation->op();
+      FoldProducer(producer, activation);
+      activation->set_op("_FusedBiasActivation");
+      (*activation->mutable_attr())["activation"].set_s(activation_op);
+    } else if (producer->op() == "_FusedMatMul" &&
+               producer->attr().at("activation").s() == "Identity") {
+      const string activation_op = activation->op();
+      FoldProducer(producer, activation);
+      activation->set_op("_FusedMatMul");
+      CopyTransposeAttrs(*producer, activation);
+      (*activation->mutable_attr())["activation"].set_s(activation_op);
+    } else if (producer->op() == "_FusedConv2D") {
+      const std::vector<string> fused_ops = FusedConv2DOps(*producer);
+      if (IsActivation(fused_ops.back())) return;
+      const string activation_op = activation->op();
+      FoldProducer(producer, activation);
+      SetFusedConv2DAttrs(*producer, activation_op, 0, activation);
+    }
+  }
+
+  GraphDef* graph_;
+  NodeMap node_map_;
+  std::unordered_set<string> nodes_to_preserve_;
+  // The names of the nodes that were folded into their consumer.
+  std::unordered_set<string> fused_;
+};
+
+}  // namespace
+
+Status OpFusionOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                   GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  TopologicalSort(optimized_graph);
+
+  Fuser fuser(item, optimized_graph);
+  const int num_fused = fuser.Fuse();
+  VLOG(1) << "Fused " << num_fused << " nodes into their consumers. The graph "
+          << "now contains " << optimized_graph->node_size() << " nodes.";
+  return Status::OK();
+}
+
+void OpFusionOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                 const GraphDef& optimized_graph,
+                                 double result) {
+  // Nothing to do for OpFusionOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,48 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_OP_FUSION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_OP_FUSION_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Rewrites chains of ops into fused kernels, which saves the intermediate
+// tensors and a kernel dispatch per fused op:
+// * BiasAdd -> {Relu, Relu6, Tanh, Elu} becomes _FusedBiasActivation.
+// * MatMul -> BiasAdd [-> {Relu, Relu6, Tanh, Elu}] becomes _FusedMatMul.
+// * Conv2D -> BiasAdd and/or FusedBatchNorm [-> {Relu, Relu6, Tanh, Elu}]
+//   becomes _FusedConv2D, for NHWC data and inference-mode batch norms.
+// The last op of a chain keeps its name, so that its consumers are unchanged.
+class OpFusionOptimizer : public GraphOptimizer {
+ public:
+  OpFusionOptimizer() {}
+  ~OpFusionOptimizer() override {}
+
+  string name() const override { return "op_fusion"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_OP_FUSION_OPTIMIZER_H_
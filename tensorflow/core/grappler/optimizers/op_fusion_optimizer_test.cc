@@ -0,0 +1,267 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/op_fusion_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class OpFusionOptimizerTest : public ::testing::Test {
+ protected:
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(OpFusionOptimizerTest, MatMulBiasAddRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {4, 8});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {8, 16});
+  Output bias = ops::Const(s.WithOpName("bias"), 0.5f, {16});
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b,
+                              ops::MatMul::TransposeB(false));
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  Output out = ops::Identity(s.WithOpName("out"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 2, output.node_size());
+  EXPECT_EQ(nullptr, FindNode(output, "matmul"));
+  EXPECT_EQ(nullptr, FindNode(output, "bias_add"));
+  const NodeDef* fused = FindNode(output, "relu");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedMatMul", fused->op());
+  EXPECT_EQ("Relu", fused->attr().at("activation").s());
+  EXPECT_FALSE(fused->attr().at("transpose_a").b());
+  ASSERT_EQ(3, fused->input_size());
+  EXPECT_EQ("a", fused->input(0));
+  EXPECT_EQ("b", fused->input(1));
+  EXPECT_EQ("bias", fused->input(2));
+  EXPECT_EQ("relu", FindNode(output, "out")->input(0));
+}
+
+TEST_F(OpFusionOptimizerTest, BiasAddActivation) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output value = ops::Const(s.WithOpName("value"), 1.0f, {2, 3, 4});
+  Output bias = ops::Const(s.WithOpName("bias"), 0.5f, {4});
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), value, bias);
+  Output tanh = ops::Tanh(s.WithOpName("tanh"), bias_add);
+
+  GrapplerItem item;
+  item.fetch = {"tanh"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "bias_add"));
+  const NodeDef* fused = FindNode(output, "tanh");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedBiasActivation", fused->op());
+  EXPECT_EQ("Tanh", fused->attr().at("activation").s());
+  ASSERT_EQ(2, fused->input_size());
+  EXPECT_EQ("value", fused->input(0));
+  EXPECT_EQ("bias", fused->input(1));
+}
+
+TEST_F(OpFusionOptimizerTest, NoFusionOfSharedOrFetchedProducers) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {4, 8});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {8, 16});
+  Output bias = ops::Const(s.WithOpName("bias"), 0.5f, {16});
+  // "matmul" has two consumers.
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b);
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  Output other = ops::Identity(s.WithOpName("other"), matmul);
+  // "bias_add" is fetched.
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+
+  GrapplerItem item;
+  item.fetch = {"bias_add", "relu", "other"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("MatMul", FindNode(output, "matmul")->op());
+  EXPECT_EQ("BiasAdd", FindNode(output, "bias_add")->op());
+  EXPECT_EQ("Relu", FindNode(output, "relu")->op());
+}
+
+TEST_F(OpFusionOptimizerTest, ControlDependenciesAreKept) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output value = ops::Const(s.WithOpName("value"), 1.0f, {2, 4});
+  Output bias = ops::Const(s.WithOpName("bias"), 0.5f, {4});
+  Output ctrl = ops::Const(s.WithOpName("ctrl"), 0.0f, {});
+  Output bias_add =
+      ops::BiasAdd(s.WithOpName("bias_add").WithControlDependencies(ctrl),
+                   value, bias);
+  Output relu6 = ops::Relu6(s.WithOpName("relu6"), bias_add);
+
+  GrapplerItem item;
+  item.fetch = {"relu6"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* fused = FindNode(output, "relu6");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedBiasActivation", fused->op());
+  ASSERT_EQ(3, fused->input_size());
+  EXPECT_EQ("value", fused->input(0));
+  EXPECT_EQ("bias", fused->input(1));
+  EXPECT_EQ("^ctrl", fused->input(2));
+}
+
+TEST_F(OpFusionOptimizerTest, Conv2DBiasAddBatchNormRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Const(s.WithOpName("input"), 1.0f, {1, 8, 8, 3});
+  Output filter = ops::Const(s.WithOpName("filter"), 2.0f, {3, 3, 3, 4});
+  Output bias = ops::Const(s.WithOpName("bias"), 0.5f, {4});
+  Output scale = ops::Const(s.WithOpName("scale"), 1.5f, {4});
+  Output offset = ops::Const(s.WithOpName("offset"), 0.1f, {4});
+  Output mean = ops::Const(s.WithOpName("mean"), 0.2f, {4});
+  Output variance = ops::Const(s.WithOpName("variance"), 0.3f, {4});
+  Output conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 2, 2, 1},
+                            "SAME");
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+  Output batch_norm =
+      ops::FusedBatchNorm(
+          s.WithOpName("batch_norm"), bias_add, scale, offset, mean, variance,
+          ops::FusedBatchNorm::IsTraining(false).Epsilon(0.01f))
+          .y;
+  Output relu = ops::Relu(s.WithOpName("relu"), batch_norm);
+
+  GrapplerItem item;
+  item.fetch = {"relu"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 3, output.node_size());
+  const NodeDef* fused = FindNode(output, "relu");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedConv2D", fused->op());
+  const auto& fused_ops = fused->attr().at("fused_ops").list();
+  ASSERT_EQ(3, fused_ops.s_size());
+  EXPECT_EQ("BiasAdd", fused_ops.s(0));
+  EXPECT_EQ("FusedBatchNorm", fused_ops.s(1));
+  EXPECT_EQ("Relu", fused_ops.s(2));
+  EXPECT_EQ(5, fused->attr().at("num_args").i());
+  EXPECT_FLOAT_EQ(0.01f, fused->attr().at("epsilon").f());
+  EXPECT_EQ("SAME", fused->attr().at("padding").s());
+  EXPECT_EQ(2, fused->attr().at("strides").list().i(1));
+  EXPECT_EQ(0, fused->attr().count("is_training"));
+  ASSERT_EQ(7, fused->input_size());
+  const std::vector<string> inputs = {"input", "filter", "bias",    "scale",
+                                      "offset", "mean",  "variance"};
+  for (int i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(inputs[i], fused->input(i));
+  }
+}
+
+TEST_F(OpFusionOptimizerTest, Conv2DBatchNormElu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Const(s.WithOpName("input"), 1.0f, {1, 8, 8, 3});
+  Output filter = ops::Const(s.WithOpName("filter"), 2.0f, {1, 1, 3, 4});
+  Output stats = ops::Const(s.WithOpName("stats"), 0.5f, {4});
+  Output conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "VALID");
+  Output batch_norm =
+      ops::FusedBatchNorm(s.WithOpName("batch_norm"), conv, stats, stats,
+                          stats, stats, ops::FusedBatchNorm::IsTraining(false))
+          .y;
+  Output elu = ops::Elu(s.WithOpName("elu"), batch_norm);
+
+  GrapplerItem item;
+  item.fetch = {"elu"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* fused = FindNode(output, "elu");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedConv2D", fused->op());
+  const auto& fused_ops = fused->attr().at("fused_ops").list();
+  ASSERT_EQ(2, fused_ops.s_size());
+  EXPECT_EQ("FusedBatchNorm", fused_ops.s(0));
+  EXPECT_EQ("Elu", fused_ops.s(1));
+  EXPECT_EQ(4, fused->attr().at("num_args").i());
+  EXPECT_EQ(6, fused->input_size());
+}
+
+TEST_F(OpFusionOptimizerTest, NoFusionOfTrainingBatchNorms) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Const(s.WithOpName("input"), 1.0f, {1, 8, 8, 3});
+  Output filter = ops::Const(s.WithOpName("filter"), 2.0f, {1, 1, 3, 4});
+  Output stats = ops::Const(s.WithOpName("stats"), 0.5f, {4});
+  Output empty = ops::Const(s.WithOpName("empty"), 0.5f, {0});
+  Output conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "VALID");
+  // A training batch norm computes its own statistics.
+  Output training =
+      ops::FusedBatchNorm(s.WithOpName("training"), conv, stats, stats, empty,
+                          empty, ops::FusedBatchNorm::IsTraining(true))
+          .y;
+  Output conv2 = ops::Conv2D(s.WithOpName("conv2"), training, filter,
+                             {1, 1, 1, 1}, "VALID");
+  // The batch mean of this one is used.
+  auto inference = ops::FusedBatchNorm(s.WithOpName("inference"), conv2, stats,
+                                       stats, stats, stats,
+                                       ops::FusedBatchNorm::IsTraining(false));
+  Output mean = ops::Identity(s.WithOpName("mean"), inference.batch_mean);
+
+  GrapplerItem item;
+  item.fetch = {"mean"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  OpFusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("FusedBatchNorm", FindNode(output, "training")->op());
+  EXPECT_EQ("FusedBatchNorm", FindNode(output, "inference")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 #include <deque>
+#include <unordered_set>
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
@@ -119,5 +121,205 @@ Status EstimateEarliestExecutionTimes(
   return Status::OK();
 }
 
+namespace {
+
+// The dependencies of the nodes of a graph, and the estimated size of their
+// outputs. Nodes are identified by their index in the graph.
+struct MemoryGraph {
+  std::vector<const NodeDef*> nodes;
+  // The distinct nodes that depend on each node, through data or control.
+  std::vector<std::vector<int>> fanouts;
+  std::vector<int> num_fanins;
+  // The distinct nodes whose outputs each node consumes.
+  std::vector<std::vector<int>> data_fanins;
+  std::vector<int> num_consumers;
+  std::vector<int64> output_bytes;
+  // Whether the outputs of each node are fetched, and kept until the end.
+  std::vector<bool> fetched;
+};
+
+int64 EstimateOutputBytes(const GraphProperties& properties,
+                          const NodeDef& node) {
+  if (IsVariable(node) || IsConstant(node)) {
+    return 0;
+  }
+  int64 bytes = 0;
+  for (const auto& output : properties.GetOutputProperties(node.name())) {
+    const TensorShapeProto& shape = output.shape();
+    if (shape.unknown_rank()) {
+      continue;
+    }
+    // If one of the dimensions is unknown statically, assume it's one.
+    int64 num_elements = 1;
+    for (const auto& dim : shape.dim()) {
+      num_elements *= std::max<int64>(dim.size(), 1);
+    }
+    bytes += num_elements * DataTypeSize(BaseType(output.dtype()));
+  }
+  return bytes;
+}
+
+Status BuildMemoryGraph(const GrapplerItem& item, MemoryGraph* graph) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  const int num_nodes = item.graph.node_size();
+  std::unordered_map<string, int> name_to_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = item.graph.node(i);
+    graph->nodes.push_back(&node);
+    name_to_index[node.name()] = i;
+    graph->output_bytes.push_back(EstimateOutputBytes(properties, node));
+  }
+  graph->fanouts.resize(num_nodes);
+  graph->num_fanins.resize(num_nodes, 0);
+  graph->data_fanins.resize(num_nodes);
+  graph->num_consumers.resize(num_nodes, 0);
+  graph->fetched.resize(num_nodes, false);
+  for (const string& fetch : item.fetch) {
+    auto it = name_to_index.find(NodeName(fetch));
+    if (it != name_to_index.end()) {
+      graph->fetched[it->second] = true;
+    }
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    std::unordered_set<int> fanins;
+    std::unordered_set<int> data_fanins;
+    for (const string& input : graph->nodes[i]->input()) {
+      auto it = name_to_index.find(NodeName(input));
+      if (it == name_to_index.end()) {
+        return errors::InvalidArgument(
+            strings::StrCat("Unknown input node ", input));
+      }
+      if (fanins.insert(it->second).second) {
+        graph->fanouts[it->second].push_back(i);
+        ++graph->num_fanins[i];
+      }
+      if (!IsControlInput(input) && data_fanins.insert(it->second).second) {
+        graph->data_fanins[i].push_back(it->second);
+        ++graph->num_consumers[it->second];
+      }
+    }
+  }
+  return Status::OK();
+}
+
+// Estimates the peak memory usage of running the nodes in "order". The outputs
+// of a node are allocated while its inputs are still alive.
+int64 EstimatePeakMemory(const MemoryGraph& graph,
+                         const std::vector<int>& order) {
+  std::vector<int> num_consumers = graph.num_consumers;
+  int64 memory = 0;
+  int64 peak = 0;
+  for (int node : order) {
+    memory += graph.output_bytes[node];
+    peak = std::max(peak, memory);
+    for (int fanin : graph.data_fanins[node]) {
+      if (--num_consumers[fanin] == 0 && !graph.fetched[fanin]) {
+        memory -= graph.output_bytes[fanin];
+      }
+    }
+    if (num_consumers[node] == 0 && !graph.fetched[node]) {
+      memory -= graph.output_bytes[node];
+    }
+  }
+  return peak;
+}
+
+// Runs the nodes in the order in which they become ready.
+std::vector<int> ComputeReadyOrder(const MemoryGraph& graph) {
+  std::vector<int> num_fanins = graph.num_fanins;
+  std::deque<int> ready_nodes;
+  for (int i = 0; i < static_cast<int>(graph.nodes.size()); ++i) {
+    if (num_fanins[i] == 0) {
+      ready_nodes.push_back(i);
+    }
+  }
+  std::vector<int> order;
+  while (!ready_nodes.empty()) {
+    const int node = ready_nodes.front();
+    ready_nodes.pop_front();
+    order.push_back(node);
+    for (int fanout : graph.fanouts[node]) {
+      if (--num_fanins[fanout] == 0) {
+        ready_nodes.push_back(fanout);
+      }
+    }
+  }
+  return order;
+}
+
+// Runs the ready node that increases the memory usage the least first,
+// breaking ties with the position of the nodes in "ready_order".
+std::vector<int> ComputeGreedyOrder(const MemoryGraph& graph,
+                                    const std::vector<int>& ready_order) {
+  const int num_nodes = graph.nodes.size();
+  std::vector<int> rank(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    rank[ready_order[i]] = i;
+  }
+  std::vector<int> num_fanins = graph.num_fanins;
+  std::vector<int> num_consumers = graph.num_consumers;
+  std::vector<int> ready_nodes;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (num_fanins[i] == 0) {
+      ready_nodes.push_back(i);
+    }
+  }
+  std::vector<int> order;
+  while (!ready_nodes.empty()) {
+    int best = -1;
+    int64 best_delta = 0;
+    for (int i = 0; i < static_cast<int>(ready_nodes.size()); ++i) {
+      const int node = ready_nodes[i];
+      int64 delta = graph.output_bytes[node];
+      for (int fanin : graph.data_fanins[node]) {
+        if (num_consumers[fanin] == 1 && !graph.fetched[fanin]) {
+          delta -= graph.output_bytes[fanin];
+        }
+      }
+      if (best < 0 || delta < best_delta ||
+          (delta == best_delta && rank[node] < rank[ready_nodes[best]])) {
+        best = i;
+        best_delta = delta;
+      }
+    }
+    const int node = ready_nodes[best];
+    ready_nodes[best] = ready_nodes.back();
+    ready_nodes.pop_back();
+    order.push_back(node);
+    for (int fanin : graph.data_fanins[node]) {
+      --num_consumers[fanin];
+    }
+    for (int fanout : graph.fanouts[node]) {
+      if (--num_fanins[fanout] == 0) {
+        ready_nodes.push_back(fanout);
+      }
+    }
+  }
+  return order;
+}
+
+}  // namespace
+
+Status ComputeMemoryMinimizingSchedule(const GrapplerItem& item,
+                                       std::vector<const NodeDef*>* schedule,
+                                       int64* peak_bytes,
+                                       int64* default_peak_bytes) {
+  MemoryGraph graph;
+  TF_RETURN_IF_ERROR(BuildMemoryGraph(item, &graph));
+  const std::vector<int> ready_order = ComputeReadyOrder(graph);
+  if (ready_order.size() != graph.nodes.size()) {
+    return errors::InvalidArgument("The graph has a cycle");
+  }
+  const std::vector<int> order = ComputeGreedyOrder(graph, ready_order);
+  *peak_bytes = EstimatePeakMemory(graph, order);
+  *default_peak_bytes = EstimatePeakMemory(graph, ready_order);
+  schedule->clear();
+  for (int node : order) {
+    schedule->push_back(graph.nodes[node]);
+  }
+  return Status::OK();
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
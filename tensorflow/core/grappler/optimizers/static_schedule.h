@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_STATIC_SCHEDULE_H_
 
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
@@ -35,6 +36,21 @@ Status EstimateEarliestExecutionTimes(
     const GrapplerItem& item, const Cluster* cluster,
     std::unordered_map<const NodeDef*, Costs::NanoSeconds>* execution_times);
 
+// Compute an order in which to execute the nodes of the graph that greedily
+// minimizes the peak memory used by their outputs: among the nodes that are
+// ready to run, the one that increases the memory usage the least runs first.
+// The size of the outputs is estimated statically, and the outputs of
+// variables and constants are persistent and don't count. The outputs of the
+// fetch nodes are kept until the end of the step, the others are freed after
+// their last consumer runs.
+// "peak_bytes" is set to the estimated peak memory usage of the schedule, and
+// "default_peak_bytes" to the one of running the nodes in the order in which
+// they become ready, as the executor does. The graph can't have loops.
+Status ComputeMemoryMinimizingSchedule(const GrapplerItem& item,
+                                       std::vector<const NodeDef*>* schedule,
+                                       int64* peak_bytes,
+                                       int64* default_peak_bytes);
+
 }  // namespace grappler
 }  // end namespace tensorflow
 
@@ -121,6 +121,41 @@ TEST_F(StaticScheduleTest, BasicGraphWithCtrlDependencies) {
   }
 }
 
+TEST_F(StaticScheduleTest, MemoryMinimizingSchedule) {
+  // Two branches that each expand a variable into a large tensor and reduce
+  // it back to a scalar.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Variable(s.WithOpName("x"), {10, 10}, DT_FLOAT);
+  Output a1 = ops::Tile(s.WithOpName("a1"), x, {10, 10});
+  Output b1 = ops::Tile(s.WithOpName("b1"), x, {10, 10});
+  Output a2 = ops::Sum(s.WithOpName("a2"), a1, {0, 1});
+  Output b2 = ops::Sum(s.WithOpName("b2"), b1, {0, 1});
+  Output out = ops::AddN(s.WithOpName("out"), {a2, b2});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch.push_back("out");
+
+  std::vector<const NodeDef*> schedule;
+  int64 peak_bytes;
+  int64 default_peak_bytes;
+  TF_EXPECT_OK(ComputeMemoryMinimizingSchedule(item, &schedule, &peak_bytes,
+                                               &default_peak_bytes));
+  EXPECT_EQ(item.graph.node_size(), schedule.size());
+
+  // Both large tensors are alive at the same time when the nodes run in the
+  // order in which they become ready, but not if a2 runs before b1.
+  EXPECT_EQ(2 * 40000 + 4, default_peak_bytes);
+  EXPECT_EQ(40000 + 2 * 4, peak_bytes);
+  std::vector<string> branches;
+  for (const NodeDef* node : schedule) {
+    if (node->op() != "Const" && node->name() != "x") {
+      branches.push_back(node->name());
+    }
+  }
+  EXPECT_EQ(std::vector<string>({"a1", "a2", "b1", "b2", "out"}), branches);
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -191,6 +191,20 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // Each batch is assembled within a single call to `GetNext()`, so
+      // the position of this iterator is the position of its input.
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return input_impl_->Save(strings::StrCat(prefix, "/input"), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return input_impl_->Restore(ctx, strings::StrCat(prefix, "/input"),
+                                    reader);
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
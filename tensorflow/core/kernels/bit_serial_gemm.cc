@@ -0,0 +1,355 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/bit_serial_gemm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/kernels/fake_quant_ops_functor.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+// As in int8_gemm.cc, the x86 kernels are compiled with function-level target
+// attributes, so that they can be selected at runtime without compiling the
+// whole binary for a newer instruction set. NEON is part of the ABI of the
+// ARM targets that have it, so it is selected at compile time.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TF_BIT_SERIAL_HAVE_POPCNT 1
+#define TF_BIT_SERIAL_HAVE_AVX2 1
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TF_BIT_SERIAL_HAVE_NEON 1
+#endif
+
+namespace tensorflow {
+namespace bit_serial {
+namespace {
+
+// Computes the dot products, in levels, of the packed row 'a' with each of the
+// 'n' consecutive packed rows of 'b', adding them to c[0, n).
+typedef void (*DotRowFn)(const uint64* a, int a_bits, const uint64* b, int n,
+                         int b_bits, int words, int64* c);
+
+inline int PopcountReference(uint64 x) {
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+}
+
+void DotRowReference(const uint64* a, int a_bits, const uint64* b, int n,
+                     int b_bits, int words, int64* c) {
+  const int row_words = b_bits * words;
+  for (int j = 0; j < n; ++j) {
+    const uint64* b_row = b + j * row_words;
+    int64 sum = 0;
+    for (int p = 0; p < a_bits; ++p) {
+      for (int q = 0; q < b_bits; ++q) {
+        int64 count = 0;
+        for (int w = 0; w < words; ++w) {
+          count += PopcountReference(a[p * words + w] & b_row[q * words + w]);
+        }
+        sum += count << (p + q);
+      }
+    }
+    c[j] += sum;
+  }
+}
+
+#ifdef TF_BIT_SERIAL_HAVE_POPCNT
+__attribute__((target("popcnt"))) void DotRowPopcnt(const uint64* a,
+                                                    int a_bits,
+                                                    const uint64* b, int n,
+                                                    int b_bits, int words,
+                                                    int64* c) {
+  const int row_words = b_bits * words;
+  for (int j = 0; j < n; ++j) {
+    const uint64* b_row = b + j * row_words;
+    int64 sum = 0;
+    for (int p = 0; p < a_bits; ++p) {
+      for (int q = 0; q < b_bits; ++q) {
+        int64 count = 0;
+        for (int w = 0; w < words; ++w) {
+          count += _mm_popcnt_u64(a[p * words + w] & b_row[q * words + w]);
+        }
+        sum += count << (p + q);
+      }
+    }
+    c[j] += sum;
+  }
+}
+#endif  // TF_BIT_SERIAL_HAVE_POPCNT
+
+#ifdef TF_BIT_SERIAL_HAVE_AVX2
+// Returns the popcount of a & b over 'words' words. Four words at a time, the
+// bytes of a & b are split into nibbles whose popcounts are looked up with
+// VPSHUFB, and VPSADBW sums the byte counts into four 64-bit lanes.
+__attribute__((target("avx2,popcnt"))) inline int64 PopcountAndAvx2(
+    const uint64* a, const uint64* b, int words) {
+  int w = 0;
+  int64 count = 0;
+  if (words >= 4) {
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+        1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (; w + 4 <= words; w += 4) {
+      const __m256i x = _mm256_and_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + w)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + w)));
+      const __m256i low = _mm256_and_si256(x, low_mask);
+      const __m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+      const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                            _mm256_shuffle_epi8(lookup, high));
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, zero));
+    }
+    count = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+            _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+  }
+  for (; w < words; ++w) {
+    count += _mm_popcnt_u64(a[w] & b[w]);
+  }
+  return count;
+}
+
+__attribute__((target("avx2,popcnt"))) void DotRowAvx2(const uint64* a,
+                                                       int a_bits,
+                                                       const uint64* b, int n,
+                                                       int b_bits, int words,
+                                                       int64* c) {
+  const int row_words = b_bits * words;
+  for (int j = 0; j < n; ++j) {
+    const uint64* b_row = b + j * row_words;
+    int64 sum = 0;
+    for (int p = 0; p < a_bits; ++p) {
+      for (int q = 0; q < b_bits; ++q) {
+        sum += PopcountAndAvx2(a + p * words, b_row + q * words, words)
+               << (p + q);
+      }
+    }
+    c[j] += sum;
+  }
+}
+#endif  // TF_BIT_SERIAL_HAVE_AVX2
+
+#ifdef TF_BIT_SERIAL_HAVE_NEON
+// Returns the popcount of a & b over 'words' words, two words at a time with
+// VCNT and pairwise widening adds into two 64-bit lanes.
+inline int64 PopcountAndNeon(const uint64* a, const uint64* b, int words) {
+  int w = 0;
+  uint64x2_t acc = vdupq_n_u64(0);
+  for (; w + 2 <= words; w += 2) {
+    const uint8x16_t x =
+        vreinterpretq_u8_u64(vandq_u64(vld1q_u64(a + w), vld1q_u64(b + w)));
+    acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(vcntq_u8(x))));
+  }
+  int64 count = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+  for (; w < words; ++w) {
+    count += __builtin_popcountll(a[w] & b[w]);
+  }
+  return count;
+}
+
+void DotRowNeon(const uint64* a, int a_bits, const uint64* b, int n,
+                int b_bits, int words, int64* c) {
+  const int row_words = b_bits * words;
+  for (int j = 0; j < n; ++j) {
+    const uint64* b_row = b + j * row_words;
+    int64 sum = 0;
+    for (int p = 0; p < a_bits; ++p) {
+      for (int q = 0; q < b_bits; ++q) {
+        sum += PopcountAndNeon(a + p * words, b_row + q * words, words)
+               << (p + q);
+      }
+    }
+    c[j] += sum;
+  }
+}
+#endif  // TF_BIT_SERIAL_HAVE_NEON
+
+DotRowFn GetDotRow(Isa isa) {
+  switch (isa) {
+#ifdef TF_BIT_SERIAL_HAVE_AVX2
+    case Isa::kAvx2:
+      return DotRowAvx2;
+#endif
+#ifdef TF_BIT_SERIAL_HAVE_POPCNT
+    case Isa::kPopcnt:
+      return DotRowPopcnt;
+#endif
+#ifdef TF_BIT_SERIAL_HAVE_NEON
+    case Isa::kNeon:
+      return DotRowNeon;
+#endif
+    default:
+      return DotRowReference;
+  }
+}
+
+Isa DetectIsa() {
+  Isa isa = Isa::kReference;
+  if (IsIsaSupported(Isa::kNeon)) {
+    isa = Isa::kNeon;
+  } else if (IsIsaSupported(Isa::kAvx2)) {
+    isa = Isa::kAvx2;
+  } else if (IsIsaSupported(Isa::kPopcnt)) {
+    isa = Isa::kPopcnt;
+  }
+  const char* requested = getenv("TF_BIT_SERIAL_ISA");
+  if (requested != nullptr) {
+    bool found = false;
+    for (Isa candidate :
+         {Isa::kReference, Isa::kPopcnt, Isa::kAvx2, Isa::kNeon}) {
+      if (strcmp(requested, IsaName(candidate)) == 0) {
+        found = true;
+        if (IsIsaSupported(candidate)) {
+          isa = candidate;
+        } else {
+          LOG(WARNING) << "TF_BIT_SERIAL_ISA=" << requested
+                       << " is not supported on this CPU, using "
+                       << IsaName(isa);
+        }
+      }
+    }
+    if (!found) {
+      LOG(WARNING) << "Unknown TF_BIT_SERIAL_ISA=" << requested << ", using "
+                   << IsaName(isa);
+    }
+  }
+  VLOG(1) << "Using " << IsaName(isa) << " bit-serial gemm kernels";
+  return isa;
+}
+
+}  // namespace
+
+Isa GetIsa() {
+  static const Isa isa = DetectIsa();
+  return isa;
+}
+
+bool IsIsaSupported(Isa isa) {
+  switch (isa) {
+    case Isa::kReference:
+      return true;
+    case Isa::kPopcnt:
+#ifdef TF_BIT_SERIAL_HAVE_POPCNT
+      return port::TestCPUFeature(port::POPCNT);
+#else
+      return false;
+#endif
+    case Isa::kAvx2:
+#ifdef TF_BIT_SERIAL_HAVE_AVX2
+      return port::TestCPUFeature(port::AVX2) &&
+             port::TestCPUFeature(port::POPCNT);
+#else
+      return false;
+#endif
+    case Isa::kNeon:
+#ifdef TF_BIT_SERIAL_HAVE_NEON
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+const char* IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kReference:
+      return "reference";
+    case Isa::kPopcnt:
+      return "popcnt";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+Quantization GetQuantization(float min, float max, int num_bits,
+                             bool narrow_range) {
+  const int quant_min = narrow_range ? 1 : 0;
+  const int quant_max = (1 << num_bits) - 1;
+  Quantization q;
+  q.num_bits = num_bits;
+  q.levels = quant_max - quant_min + 1;
+  if (num_bits == 1) {
+    q.nudged_min = min;
+    q.nudged_max = max;
+    q.scale = max - min;
+    return q;
+  }
+  Nudge(min, max, quant_min, quant_max, &q.nudged_min, &q.nudged_max,
+        &q.scale);
+  return q;
+}
+
+int64 QuantizeAndPack(const float* input, int depth, const Quantization& q,
+                      uint64* packed) {
+  const int words = PackedWords(depth);
+  std::fill(packed, packed + q.num_bits * words, 0);
+  // Rounds exactly as FakeQuantWithMinMaxArgsFunctor does.
+  const float inv_scale = 1.0f / q.scale;
+  int64 sum = 0;
+  for (int l = 0; l < depth; ++l) {
+    const float clamped =
+        std::min(std::max(input[l], q.nudged_min), q.nudged_max);
+    const int level = std::min(
+        static_cast<int>(std::floor((clamped - q.nudged_min) * inv_scale +
+                                    0.5f)),
+        q.levels - 1);
+    sum += level;
+    const uint64 bit = 1ULL << (l % 64);
+    for (int p = 0; p < q.num_bits; ++p) {
+      if (level & (1 << p)) packed[p * words + l / 64] |= bit;
+    }
+  }
+  return sum;
+}
+
+int64 SumLevels(const uint64* packed, int num_bits, int words) {
+  int64 sum = 0;
+  for (int p = 0; p < num_bits; ++p) {
+    int64 count = 0;
+    for (int w = 0; w < words; ++w) {
+      count += PopcountReference(packed[p * words + w]);
+    }
+    sum += count << p;
+  }
+  return sum;
+}
+
+void MultiplyAccumulate(Isa isa, const uint64* a, int64 a_stride, int m,
+                        int a_bits, const uint64* b, int n, int b_bits,
+                        int words, int64* c, int ldc) {
+  CHECK(IsIsaSupported(isa)) << IsaName(isa);
+  const DotRowFn dot_row = GetDotRow(isa);
+  for (int i = 0; i < m; ++i) {
+    dot_row(a + i * a_stride, a_bits, b, n, b_bits, words, c + i * ldc);
+  }
+}
+
+}  // namespace bit_serial
+}  // namespace tensorflow
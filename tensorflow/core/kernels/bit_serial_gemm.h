@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BIT_SERIAL_GEMM_H_
+#define TENSORFLOW_CORE_KERNELS_BIT_SERIAL_GEMM_H_
+
+// Matrix multiplication of 1 to 8 bit values stored as bit-planes, used by the
+// bit-serial ops for binarized and ternary networks.
+//
+// A packed row of 'depth' values of 'num_bits' bits holds 'num_bits' planes of
+// PackedWords(depth) uint64 words each. Bit 'l % 64' of word 'l / 64' of plane
+// 'p' is bit 'p' of the value at position 'l'; the bits past 'depth' are zero.
+// The dot product of two packed rows is then
+//   sum_l a[l] * b[l] = sum_{p, q} 2^(p + q) * popcount(a_p & b_q),
+// which for one bit per value is the classic XNOR-net inner product. The
+// popcounts are computed with:
+// *) AVX2: the nibble lookup table of VPSHUFB, summed with VPSADBW.
+// *) POPCNT: one 64-bit popcount per word.
+// *) NEON: VCNT on 16 bytes at a time, summed with pairwise adds.
+// *) A portable reference implementation on all other CPUs.
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace bit_serial {
+
+enum class Isa { kReference, kPopcnt, kAvx2, kNeon };
+
+// Returns the fastest instruction set supported by both the compiler and the
+// CPU, which can be lowered with the environment variable TF_BIT_SERIAL_ISA
+// ("reference", "popcnt", "avx2" or "neon").
+Isa GetIsa();
+
+// Returns true if kernels for 'isa' can run on this CPU.
+bool IsIsaSupported(Isa isa);
+
+// Returns the name of 'isa' as accepted by TF_BIT_SERIAL_ISA.
+const char* IsaName(Isa isa);
+
+// Returns the number of uint64 words in each plane of a packed row of 'depth'
+// values.
+inline int PackedWords(int depth) { return (depth + 63) / 64; }
+
+// An affine quantization: a float is clamped to [nudged_min, nudged_max] and
+// rounded to the nearest of the 'levels' values nudged_min + q * scale, for q
+// in [0, levels).
+struct Quantization {
+  int num_bits;
+  int levels;
+  float nudged_min;
+  float nudged_max;
+  float scale;
+};
+
+// Returns the quantization of FakeQuantWithMinMaxVars with the given range,
+// 'num_bits' and 'narrow_range'. With narrow_range, two bits hold the three
+// levels of a ternary network. FakeQuantWithMinMaxVars needs at least two
+// bits; one bit (without narrow_range) holds the two levels 'min' and 'max',
+// without nudging 'min' so that zero is one of them, as in XNOR networks
+// binarized to -1 and 1.
+Quantization GetQuantization(float min, float max, int num_bits,
+                             bool narrow_range);
+
+// Quantizes the 'depth' values of 'input' and stores their levels as a packed
+// row in 'packed', which must hold q.num_bits * PackedWords(depth) words.
+// Returns the sum of the levels.
+int64 QuantizeAndPack(const float* input, int depth, const Quantization& q,
+                      uint64* packed);
+
+// Returns the sum of the levels of a packed row.
+int64 SumLevels(const uint64* packed, int num_bits, int words);
+
+// Computes c[i * ldc + j] += sum_l a_i[l] * b_j[l], in levels, for the 'm'
+// packed rows a_i of 'a_bits' bits that start every 'a_stride' words of 'a',
+// and the 'n' consecutive packed rows b_j of 'b_bits' bits of 'b'. All rows
+// have 'words' words per plane.
+void MultiplyAccumulate(Isa isa, const uint64* a, int64 a_stride, int m,
+                        int a_bits, const uint64* b, int n, int b_bits,
+                        int words, int64* c, int ldc);
+
+}  // namespace bit_serial
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BIT_SERIAL_GEMM_H_
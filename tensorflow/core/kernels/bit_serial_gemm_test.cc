@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/bit_serial_gemm.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace bit_serial {
+namespace {
+
+// Returns the levels of 'rows' rows of 'depth' random values of 'num_bits'
+// bits, and packs them into 'packed'.
+std::vector<int> RandomLevels(random::SimplePhilox* rnd, int rows, int depth,
+                              int num_bits, std::vector<uint64>* packed) {
+  const Quantization q = GetQuantization(0.0f, (1 << num_bits) - 1, num_bits,
+                                         /*narrow_range=*/false);
+  std::vector<int> levels(rows * depth);
+  std::vector<float> values(depth);
+  const int row_words = num_bits * PackedWords(depth);
+  packed->resize(rows * row_words);
+  for (int i = 0; i < rows; ++i) {
+    int64 sum = 0;
+    for (int l = 0; l < depth; ++l) {
+      levels[i * depth + l] = rnd->Uniform(1 << num_bits);
+      values[l] = levels[i * depth + l];
+      sum += levels[i * depth + l];
+    }
+    uint64* packed_row = packed->data() + i * row_words;
+    EXPECT_EQ(sum, QuantizeAndPack(values.data(), depth, q, packed_row));
+    EXPECT_EQ(sum, SumLevels(packed_row, num_bits, PackedWords(depth)));
+  }
+  return levels;
+}
+
+void TestMultiply(Isa isa, int m, int a_bits, int k, int n, int b_bits) {
+  random::PhiloxRandom philox(m * 10000 + k * 100 + n);
+  random::SimplePhilox rnd(&philox);
+  std::vector<uint64> a;
+  const std::vector<int> a_levels = RandomLevels(&rnd, m, k, a_bits, &a);
+  std::vector<uint64> b;
+  const std::vector<int> b_levels = RandomLevels(&rnd, n, k, b_bits, &b);
+
+  // Multiply every other row of 'a' into a 'c' with padded rows, which must
+  // be accumulated into and not overwritten.
+  const int words = PackedWords(k);
+  const int ldc = n + 3;
+  const int rows = (m + 1) / 2;
+  std::vector<int64> c(rows * ldc, 7);
+  MultiplyAccumulate(isa, a.data(), 2 * a_bits * words, rows, a_bits, b.data(),
+                     n, b_bits, words, c.data(), ldc);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < n; ++j) {
+      int64 expected = 7;
+      for (int l = 0; l < k; ++l) {
+        expected += a_levels[2 * i * k + l] * b_levels[j * k + l];
+      }
+      ASSERT_EQ(expected, c[i * ldc + j])
+          << IsaName(isa) << " m=" << m << " k=" << k << " n=" << n
+          << " a_bits=" << a_bits << " b_bits=" << b_bits << " i=" << i
+          << " j=" << j;
+    }
+    for (int j = n; j < ldc; ++j) {
+      ASSERT_EQ(7, c[i * ldc + j]) << IsaName(isa);
+    }
+  }
+}
+
+void TestAllSizes(Isa isa) {
+  if (!IsIsaSupported(isa)) {
+    LOG(INFO) << "Skipping unsupported " << IsaName(isa);
+    return;
+  }
+  for (int bits : {1, 2, 3, 8}) {
+    for (int k : {1, 63, 64, 65, 200, 256, 300, 600}) {
+      for (int n : {1, 5, 16}) {
+        TestMultiply(isa, 5, bits, k, n, bits);
+      }
+    }
+  }
+  TestMultiply(isa, 3, 1, 300, 4, 2);
+  TestMultiply(isa, 3, 4, 300, 4, 1);
+}
+
+TEST(BitSerialGemmTest, Reference) { TestAllSizes(Isa::kReference); }
+
+TEST(BitSerialGemmTest, Popcnt) { TestAllSizes(Isa::kPopcnt); }
+
+TEST(BitSerialGemmTest, Avx2) { TestAllSizes(Isa::kAvx2); }
+
+TEST(BitSerialGemmTest, Neon) { TestAllSizes(Isa::kNeon); }
+
+TEST(BitSerialGemmTest, GetIsa) { EXPECT_TRUE(IsIsaSupported(GetIsa())); }
+
+TEST(BitSerialGemmTest, Quantization) {
+  // Ternary weights in [-1, 1].
+  Quantization q = GetQuantization(-1.0f, 1.0f, 2, /*narrow_range=*/true);
+  EXPECT_EQ(3, q.levels);
+  EXPECT_FLOAT_EQ(-1.0f, q.nudged_min);
+  EXPECT_FLOAT_EQ(1.0f, q.scale);
+  const std::vector<float> values = {-3.0f, -0.6f, -0.4f, 0.0f, 0.4f, 0.6f,
+                                     3.0f};
+  uint64 packed[2];
+  EXPECT_EQ(0 + 0 + 1 + 1 + 1 + 2 + 2,
+            QuantizeAndPack(values.data(), values.size(), q, packed));
+  EXPECT_EQ(0x1cULL, packed[0]);
+  EXPECT_EQ(0x60ULL, packed[1]);
+
+  // Binary values, which are not nudged to include zero.
+  q = GetQuantization(-1.0f, 1.0f, 1, /*narrow_range=*/false);
+  EXPECT_EQ(2, q.levels);
+  EXPECT_FLOAT_EQ(-1.0f, q.nudged_min);
+  EXPECT_FLOAT_EQ(2.0f, q.scale);
+  EXPECT_EQ(4, QuantizeAndPack(values.data(), values.size(), q, packed));
+  EXPECT_EQ(0x78ULL, packed[0]);
+}
+
+}  // namespace
+}  // namespace bit_serial
+}  // namespace tensorflow
@@ -0,0 +1,373 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements matrix multiplication and convolution by filters of 1 to 8 bit
+// values, with the activations quantized on the fly and the products computed
+// from popcounts of bit-planes.
+
+#define EIGEN_USE_THREADS
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/bit_serial_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+Status GetNumBits(OpKernelConstruction* context, const string& name,
+                  int* num_bits) {
+  TF_RETURN_IF_ERROR(context->GetAttr(name, num_bits));
+  if (*num_bits < 1 || *num_bits > 8) {
+    return errors::InvalidArgument(name, " must be between 1 and 8, got ",
+                                   *num_bits);
+  }
+  return Status::OK();
+}
+
+// Returns the quantization with the range in the scalar inputs 'min_index' and
+// 'min_index + 1'.
+Status GetQuantization(OpKernelContext* context, int min_index, int num_bits,
+                       bool narrow_range, bit_serial::Quantization* q) {
+  for (int i = min_index; i < min_index + 2; ++i) {
+    if (!TensorShapeUtils::IsScalar(context->input(i).shape())) {
+      return errors::InvalidArgument(
+          "Input ", i, " must be a scalar, but got ",
+          context->input(i).shape().DebugString());
+    }
+  }
+  const float min = context->input(min_index).scalar<float>()();
+  const float max = context->input(min_index + 1).scalar<float>()();
+  if (!(min < max)) {
+    return errors::InvalidArgument("Quantization range [", min, ", ", max,
+                                   "] of input ", min_index, " is empty");
+  }
+  if (num_bits == 1 && narrow_range) {
+    return errors::InvalidArgument(
+        "narrow_range needs at least 2 bits for input ", min_index);
+  }
+  *q = bit_serial::GetQuantization(min, max, num_bits, narrow_range);
+  return Status::OK();
+}
+
+// Checks that 'packed' has 'depth' values of between 1 and 8 bits in each of
+// its rows, and copies it into 'words' so that its planes are aligned.
+Status GetPackedRows(const Tensor& packed, int64 depth, int* num_bits,
+                     std::vector<uint64>* words) {
+  const int dims = packed.dims();
+  *num_bits = packed.dim_size(dims - 2);
+  const int64 row_bytes = packed.dim_size(dims - 1);
+  const int64 expected_row_bytes =
+      bit_serial::PackedWords(depth) * static_cast<int64>(sizeof(uint64));
+  if (*num_bits < 1 || *num_bits > 8) {
+    return errors::InvalidArgument(
+        "Packed values must have between 1 and 8 bits, but got ", *num_bits);
+  }
+  if (row_bytes != expected_row_bytes) {
+    return errors::InvalidArgument("Packed planes of ", depth,
+                                   " values must have ", expected_row_bytes,
+                                   " bytes, but got ",
+                                   packed.shape().DebugString());
+  }
+  words->resize(packed.NumElements() / sizeof(uint64));
+  if (!words->empty()) {
+    memcpy(words->data(), packed.flat<uint8>().data(), packed.NumElements());
+  }
+  return Status::OK();
+}
+
+// Returns the real dot product of 'depth' values from the dot product of
+// their levels, and the sums of the levels of each side.
+inline float Dequantize(const bit_serial::Quantization& a, int64 a_sum,
+                        const bit_serial::Quantization& b, int64 b_sum,
+                        int64 depth, int64 dot) {
+  return static_cast<float>(
+      static_cast<double>(a.nudged_min) * b.nudged_min * depth +
+      static_cast<double>(a.nudged_min) * b.scale * b_sum +
+      static_cast<double>(b.nudged_min) * a.scale * a_sum +
+      static_cast<double>(a.scale) * b.scale * dot);
+}
+
+}  // namespace
+
+class BitSerialMatMulOp : public OpKernel {
+ public:
+  explicit BitSerialMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetNumBits(context, "num_bits_a", &num_bits_a_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("narrow_range_a", &narrow_range_a_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("narrow_range_b", &narrow_range_b_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("a must be a matrix: ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(context, b.dims() == 3,
+                errors::InvalidArgument("b must be 3-dimensional: ",
+                                        b.shape().DebugString()));
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = b.dim_size(0);
+    int num_bits_b = 0;
+    std::vector<uint64> b_packed;
+    OP_REQUIRES_OK(context, GetPackedRows(b, k, &num_bits_b, &b_packed));
+    bit_serial::Quantization qa;
+    OP_REQUIRES_OK(context, GetQuantization(context, 2, num_bits_a_,
+                                            narrow_range_a_, &qa));
+    bit_serial::Quantization qb;
+    OP_REQUIRES_OK(context, GetQuantization(context, 4, num_bits_b,
+                                            narrow_range_b_, &qb));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, {m, n}, &output));
+    if (output->NumElements() == 0) return;
+
+    const int words = bit_serial::PackedWords(k);
+    std::vector<int64> b_sums(n);
+    for (int64 j = 0; j < n; ++j) {
+      b_sums[j] = bit_serial::SumLevels(
+          b_packed.data() + j * num_bits_b * words, num_bits_b, words);
+    }
+
+    const bit_serial::Isa isa = bit_serial::GetIsa();
+    const float* a_data = a.flat<float>().data();
+    float* output_data = output->flat<float>().data();
+    auto multiply_rows = [&](int64 start, int64 limit) {
+      std::vector<uint64> a_row(num_bits_a_ * words);
+      std::vector<int64> dots(n);
+      for (int64 i = start; i < limit; ++i) {
+        const int64 a_sum = bit_serial::QuantizeAndPack(a_data + i * k, k, qa,
+                                                        a_row.data());
+        std::fill(dots.begin(), dots.end(), 0);
+        bit_serial::MultiplyAccumulate(isa, a_row.data(), 0, 1, num_bits_a_,
+                                       b_packed.data(), n, num_bits_b, words,
+                                       dots.data(), n);
+        for (int64 j = 0; j < n; ++j) {
+          output_data[i * n + j] =
+              Dequantize(qa, a_sum, qb, b_sums[j], k, dots[j]);
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, m,
+          words * n * num_bits_a_ * num_bits_b, multiply_rows);
+  }
+
+ private:
+  int num_bits_a_;
+  bool narrow_range_a_;
+  bool narrow_range_b_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("BitSerialMatMul").Device(DEVICE_CPU),
+                        BitSerialMatMulOp);
+
+class BitSerialConv2DOp : public OpKernel {
+ public:
+  explicit BitSerialConv2DOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   GetNumBits(context, "num_bits_input", &num_bits_input_));
+    OP_REQUIRES_OK(
+        context, context->GetAttr("narrow_range_input", &narrow_range_input_));
+    OP_REQUIRES_OK(context, context->GetAttr("narrow_range_filter",
+                                             &narrow_range_filter_));
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(
+        context, (strides_[0] == 1 && strides_[3] == 1),
+        errors::InvalidArgument("Current implementation does not yet support "
+                                "strides in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // Input tensor is of the following dimensions:
+    // [ batch, in_rows, in_cols, in_depth ]
+    const Tensor& input = context->input(0);
+
+    // Packed filter is of the following dimensions:
+    // [ filter_rows, filter_cols, out_depth, num_bits, in_depth bytes ]
+    const Tensor& filter = context->input(1);
+
+    OP_REQUIRES(context, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 5,
+                errors::InvalidArgument("filter must be 5-dimensional: ",
+                                        filter.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 input_rows = input.dim_size(1);
+    const int64 input_cols = input.dim_size(2);
+    const int64 in_depth = input.dim_size(3);
+    const int64 filter_rows = filter.dim_size(0);
+    const int64 filter_cols = filter.dim_size(1);
+    const int64 out_depth = filter.dim_size(2);
+    int num_bits_filter = 0;
+    std::vector<uint64> filter_packed;
+    OP_REQUIRES_OK(context, GetPackedRows(filter, in_depth, &num_bits_filter,
+                                          &filter_packed));
+    bit_serial::Quantization q_input;
+    OP_REQUIRES_OK(context, GetQuantization(context, 2, num_bits_input_,
+                                            narrow_range_input_, &q_input));
+    bit_serial::Quantization q_filter;
+    OP_REQUIRES_OK(context, GetQuantization(context, 4, num_bits_filter,
+                                            narrow_range_filter_, &q_filter));
+
+    const int64 stride_rows = strides_[1];
+    const int64 stride_cols = strides_[2];
+    int64 out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_rows, filter_rows, stride_rows,
+                                         padding_, &out_rows, &pad_rows));
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_cols, filter_cols, stride_cols,
+                                         padding_, &out_cols, &pad_cols));
+    TensorShape out_shape({batch, out_rows, out_cols, out_depth});
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    const int words = bit_serial::PackedWords(in_depth);
+    const int64 input_row_words = num_bits_input_ * words;
+    const int64 filter_row_words = num_bits_filter * words;
+    const int64 num_taps = filter_rows * filter_cols;
+
+    // The sum of the filter levels of each output channel at each tap.
+    std::vector<int64> tap_sums(num_taps * out_depth);
+    for (int64 i = 0; i < num_taps * out_depth; ++i) {
+      tap_sums[i] = bit_serial::SumLevels(
+          filter_packed.data() + i * filter_row_words, num_bits_filter, words);
+    }
+
+    // Quantizes and packs the depth of each input pixel once, since it is
+    // used by up to 'num_taps' output pixels.
+    const int64 num_pixels = batch * input_rows * input_cols;
+    std::vector<uint64> input_packed(num_pixels * input_row_words);
+    std::vector<int64> pixel_sums(num_pixels);
+    const float* input_data = input.flat<float>().data();
+    auto pack_pixels = [&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; ++i) {
+        pixel_sums[i] = bit_serial::QuantizeAndPack(
+            input_data + i * in_depth, in_depth, q_input,
+            input_packed.data() + i * input_row_words);
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_pixels,
+          in_depth * num_bits_input_, pack_pixels);
+
+    // Each output row accumulates, for every tap that is inside the input,
+    // the dot products of the input pixels under the tap with the filter
+    // rows of the tap. The padding contributes zeros, so the number of
+    // values and the level sums only cover the taps that are inside.
+    const bit_serial::Isa isa = bit_serial::GetIsa();
+    float* output_data = output->flat<float>().data();
+    auto convolve_rows = [&](int64 start, int64 limit) {
+      std::vector<int64> dots(out_cols * out_depth);
+      std::vector<int64> filter_sums(out_cols * out_depth);
+      std::vector<int64> input_sums(out_cols);
+      std::vector<int64> depths(out_cols);
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / out_rows;
+        const int64 out_y = row % out_rows;
+        std::fill(dots.begin(), dots.end(), 0);
+        std::fill(filter_sums.begin(), filter_sums.end(), 0);
+        std::fill(input_sums.begin(), input_sums.end(), 0);
+        std::fill(depths.begin(), depths.end(), 0);
+        for (int64 filter_y = 0; filter_y < filter_rows; ++filter_y) {
+          const int64 in_y = out_y * stride_rows - pad_rows + filter_y;
+          if (in_y < 0 || in_y >= input_rows) continue;
+          for (int64 filter_x = 0; filter_x < filter_cols; ++filter_x) {
+            // The output columns whose input column is inside the input.
+            const int64 first = pad_cols - filter_x;
+            const int64 x_start =
+                first > 0 ? (first + stride_cols - 1) / stride_cols : 0;
+            const int64 last = input_cols + pad_cols - filter_x;
+            const int64 x_limit =
+                last > 0 ? std::min(out_cols,
+                                    (last + stride_cols - 1) / stride_cols)
+                         : 0;
+            if (x_start >= x_limit) continue;
+            const int64 tap = filter_y * filter_cols + filter_x;
+            const int64 first_pixel =
+                (b * input_rows + in_y) * input_cols +
+                x_start * stride_cols - pad_cols + filter_x;
+            bit_serial::MultiplyAccumulate(
+                isa, input_packed.data() + first_pixel * input_row_words,
+                stride_cols * input_row_words, x_limit - x_start,
+                num_bits_input_,
+                filter_packed.data() + tap * out_depth * filter_row_words,
+                out_depth, num_bits_filter, words,
+                dots.data() + x_start * out_depth, out_depth);
+            const int64* tap_sum = tap_sums.data() + tap * out_depth;
+            for (int64 out_x = x_start; out_x < x_limit; ++out_x) {
+              int64* filter_sum = filter_sums.data() + out_x * out_depth;
+              for (int64 j = 0; j < out_depth; ++j) {
+                filter_sum[j] += tap_sum[j];
+              }
+              input_sums[out_x] +=
+                  pixel_sums[first_pixel + (out_x - x_start) * stride_cols];
+              depths[out_x] += in_depth;
+            }
+          }
+        }
+        float* output_row = output_data + row * out_cols * out_depth;
+        for (int64 out_x = 0; out_x < out_cols; ++out_x) {
+          for (int64 j = 0; j < out_depth; ++j) {
+            const int64 i = out_x * out_depth + j;
+            output_row[i] =
+                Dequantize(q_input, input_sums[out_x], q_filter,
+                           filter_sums[i], depths[out_x], dots[i]);
+          }
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch * out_rows,
+          out_cols * num_taps * out_depth * words * num_bits_input_ *
+              num_bits_filter,
+          convolve_rows);
+  }
+
+ private:
+  int num_bits_input_;
+  bool narrow_range_input_;
+  bool narrow_range_filter_;
+  std::vector<int32> strides_;
+  Padding padding_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("BitSerialConv2D").Device(DEVICE_CPU),
+                        BitSerialConv2DOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,290 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bit_serial_gemm.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns 'value' quantized and dequantized, as FakeQuantWithMinMaxVars does.
+double FakeQuantize(float value, const bit_serial::Quantization& q) {
+  const float clamped = std::min(std::max(value, q.nudged_min), q.nudged_max);
+  const float inv_scale = 1.0f / q.scale;
+  return std::floor((clamped - q.nudged_min) * inv_scale + 0.5f) * q.scale +
+         q.nudged_min;
+}
+
+// Packs the 'rows' rows of 'depth' values, with the leading dimensions in
+// 'shape', into a uint8 tensor.
+Tensor Pack(const std::vector<float>& values, int rows, int depth,
+            const bit_serial::Quantization& q,
+            const std::vector<int64>& shape) {
+  const int row_words = q.num_bits * bit_serial::PackedWords(depth);
+  std::vector<uint64> packed(rows * row_words);
+  for (int i = 0; i < rows; ++i) {
+    bit_serial::QuantizeAndPack(values.data() + i * depth, depth, q,
+                                packed.data() + i * row_words);
+  }
+  std::vector<int64> dims = shape;
+  dims.push_back(q.num_bits);
+  dims.push_back(bit_serial::PackedWords(depth) * sizeof(uint64));
+  Tensor tensor(DT_UINT8, TensorShape(dims));
+  memcpy(tensor.flat<uint8>().data(), packed.data(),
+         packed.size() * sizeof(uint64));
+  return tensor;
+}
+
+// Returns deterministic values in [-2, 2).
+std::vector<float> MakeValues(int size, int seed) {
+  std::vector<float> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = ((i * 37 + seed * 11) % 64) / 16.0f - 2.0f;
+  }
+  return values;
+}
+
+class BitSerialMatMulTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_bits_a, bool narrow_range_a, bool narrow_range_b) {
+    TF_ASSERT_OK(NodeDefBuilder("bit_serial_matmul", "BitSerialMatMul")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_UINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("num_bits_a", num_bits_a)
+                     .Attr("narrow_range_a", narrow_range_a)
+                     .Attr("narrow_range_b", narrow_range_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(BitSerialMatMulTest, Ternary) {
+  MakeOp(2, true, true);
+  // 'a' is quantized to [1, -1, 1, 0].
+  AddInputFromArray<float>(TensorShape({1, 4}), {0.5f, -1.0f, 1.0f, 0.2f});
+  const bit_serial::Quantization q =
+      bit_serial::GetQuantization(-1.0f, 1.0f, 2, true);
+  AddInput(Pack({1, 1, -1, 1, -1, 0, 1, 1}, 2, 4, q, {2}));
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2}));
+  test::FillValues<float>(&expected, {-1, 0});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(BitSerialMatMulTest, Binary) {
+  MakeOp(1, false, false);
+  // 'a' is binarized to [1, -1, -1, 1].
+  AddInputFromArray<float>(TensorShape({1, 4}), {0.3f, -0.2f, -5.0f, 2.0f});
+  const bit_serial::Quantization q =
+      bit_serial::GetQuantization(-1.0f, 1.0f, 1, false);
+  AddInput(Pack({1, -1, 1, 1}, 1, 4, q, {1}));
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 1}));
+  test::FillValues<float>(&expected, {2});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(BitSerialMatMulTest, MatchesFakeQuant) {
+  MakeOp(3, false, true);
+  const int m = 3;
+  const int k = 150;
+  const int n = 5;
+  const std::vector<float> a = MakeValues(m * k, 1);
+  const std::vector<float> b = MakeValues(n * k, 2);
+  const bit_serial::Quantization qa =
+      bit_serial::GetQuantization(-1.5f, 2.0f, 3, false);
+  const bit_serial::Quantization qb =
+      bit_serial::GetQuantization(-0.7f, 0.9f, 2, true);
+  AddInputFromArray<float>(TensorShape({m, k}), a);
+  AddInput(Pack(b, n, k, qb, {n}));
+  AddInputFromArray<float>(TensorShape({}), {-1.5f});
+  AddInputFromArray<float>(TensorShape({}), {2.0f});
+  AddInputFromArray<float>(TensorShape({}), {-0.7f});
+  AddInputFromArray<float>(TensorShape({}), {0.9f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<double> product(m * n, 0.0);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int l = 0; l < k; ++l) {
+        product[i * n + j] +=
+            FakeQuantize(a[i * k + l], qa) * FakeQuantize(b[j * k + l], qb);
+      }
+    }
+  }
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({m, n}));
+  test::FillValues<float>(&expected,
+                          std::vector<float>(product.begin(), product.end()));
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-3);
+}
+
+TEST_F(BitSerialMatMulTest, WrongPackedDepth) {
+  MakeOp(2, false, false);
+  AddInputFromArray<float>(TensorShape({1, 65}), std::vector<float>(65));
+  AddInput(Pack(std::vector<float>(64), 1, 64,
+                bit_serial::GetQuantization(-1.0f, 1.0f, 2, false), {1}));
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  const Status s = RunOpKernel();
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "must have 16 bytes")) << s;
+}
+
+class BitSerialConv2DTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_bits_input, int stride, const string& padding) {
+    TF_ASSERT_OK(NodeDefBuilder("bit_serial_conv", "BitSerialConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_UINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("num_bits_input", num_bits_input)
+                     .Attr("narrow_range_filter", true)
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Checks the convolution of a [2, 5, 6, 70] input by a ternary [3, 3, 70, 3]
+  // filter against Conv2D of the fake-quantized values.
+  void TestMatchesFakeQuant(int num_bits_input, int stride,
+                            const string& padding) {
+    MakeOp(num_bits_input, stride, padding);
+    const int batch = 2;
+    const int rows = 5;
+    const int cols = 6;
+    const int in_depth = 70;
+    const int filter_size = 3;
+    const int out_depth = 3;
+    const std::vector<float> input =
+        MakeValues(batch * rows * cols * in_depth, 3);
+    const std::vector<float> filter =
+        MakeValues(filter_size * filter_size * in_depth * out_depth, 4);
+    const bit_serial::Quantization q_input =
+        bit_serial::GetQuantization(-1.0f, 2.0f, num_bits_input, false);
+    const bit_serial::Quantization q_filter =
+        bit_serial::GetQuantization(-1.0f, 1.0f, 2, true);
+
+    // Transposes the filter to [filter_rows, filter_cols, out_depth,
+    // in_depth] for packing.
+    std::vector<float> transposed;
+    for (int tap = 0; tap < filter_size * filter_size; ++tap) {
+      for (int j = 0; j < out_depth; ++j) {
+        for (int d = 0; d < in_depth; ++d) {
+          transposed.push_back(filter[(tap * in_depth + d) * out_depth + j]);
+        }
+      }
+    }
+    AddInputFromArray<float>(TensorShape({batch, rows, cols, in_depth}),
+                             input);
+    AddInput(Pack(transposed, filter_size * filter_size * out_depth, in_depth,
+                  q_filter, {filter_size, filter_size, out_depth}));
+    AddInputFromArray<float>(TensorShape({}), {-1.0f});
+    AddInputFromArray<float>(TensorShape({}), {2.0f});
+    AddInputFromArray<float>(TensorShape({}), {-1.0f});
+    AddInputFromArray<float>(TensorShape({}), {1.0f});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const bool same = padding == "SAME";
+    const int out_rows =
+        same ? (rows + stride - 1) / stride : (rows - filter_size) / stride + 1;
+    const int out_cols =
+        same ? (cols + stride - 1) / stride : (cols - filter_size) / stride + 1;
+    const int pad_rows =
+        same ? std::max(0, ((out_rows - 1) * stride + filter_size - rows) / 2)
+             : 0;
+    const int pad_cols =
+        same ? std::max(0, ((out_cols - 1) * stride + filter_size - cols) / 2)
+             : 0;
+    std::vector<float> output;
+    for (int b = 0; b < batch; ++b) {
+      for (int y = 0; y < out_rows; ++y) {
+        for (int x = 0; x < out_cols; ++x) {
+          for (int j = 0; j < out_depth; ++j) {
+            double sum = 0.0;
+            for (int fy = 0; fy < filter_size; ++fy) {
+              for (int fx = 0; fx < filter_size; ++fx) {
+                const int in_y = y * stride - pad_rows + fy;
+                const int in_x = x * stride - pad_cols + fx;
+                if (in_y < 0 || in_y >= rows || in_x < 0 || in_x >= cols) {
+                  continue;
+                }
+                for (int d = 0; d < in_depth; ++d) {
+                  sum += FakeQuantize(
+                             input[((b * rows + in_y) * cols + in_x) *
+                                       in_depth +
+                                   d],
+                             q_input) *
+                         FakeQuantize(
+                             filter[((fy * filter_size + fx) * in_depth + d) *
+                                        out_depth +
+                                    j],
+                             q_filter);
+                }
+              }
+            }
+            output.push_back(sum);
+          }
+        }
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT,
+                    TensorShape({batch, out_rows, out_cols, out_depth}));
+    test::FillValues<float>(&expected, output);
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-3);
+  }
+};
+
+TEST_F(BitSerialConv2DTest, SameStride1) { TestMatchesFakeQuant(2, 1, "SAME"); }
+
+TEST_F(BitSerialConv2DTest, SameStride2) { TestMatchesFakeQuant(1, 2, "SAME"); }
+
+TEST_F(BitSerialConv2DTest, Valid) { TestMatchesFakeQuant(4, 1, "VALID"); }
+
+}  // namespace
+}  // namespace tensorflow
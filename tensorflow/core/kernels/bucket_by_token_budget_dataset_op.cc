@@ -0,0 +1,283 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset.h"
+#include "tensorflow/core/kernels/padded_batch_util.h"
+#include "tensorflow/core/lib/random/random.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class BucketByTokenBudgetDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit BucketByTokenBudgetDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx),
+        graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("length_func", &length_func_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 token_budget;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "token_budget",
+                                                   &token_budget));
+    OP_REQUIRES(
+        ctx, token_budget > 0,
+        errors::InvalidArgument("Token budget must be greater than zero."));
+
+    const Tensor* bucket_boundaries_t;
+    OP_REQUIRES_OK(ctx, ctx->input("bucket_boundaries", &bucket_boundaries_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bucket_boundaries_t->shape()),
+                errors::InvalidArgument("Bucket boundaries must be a vector."));
+    std::vector<int64> bucket_boundaries;
+    const auto boundaries = bucket_boundaries_t->vec<int64>();
+    for (int64 i = 0; i < boundaries.size(); ++i) {
+      OP_REQUIRES(ctx, i == 0 || boundaries(i - 1) < boundaries(i),
+                  errors::InvalidArgument(
+                      "Bucket boundaries must be strictly increasing."));
+      bucket_boundaries.push_back(boundaries(i));
+    }
+
+    std::vector<PartialTensorShape> padded_shapes;
+    std::vector<Tensor> padding_values;
+    OP_REQUIRES_OK(ctx, ParsePaddingArguments(ctx, input, &padded_shapes,
+                                              &padding_values));
+
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("length_func_other_arguments", &inputs));
+    std::vector<Tensor> length_func_other_arguments;
+    length_func_other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      length_func_other_arguments.push_back(t);
+    }
+    std::unique_ptr<CapturedFunction> captured_length_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(
+                            ctx, length_func_, graph_def_version_,
+                            std::move(length_func_other_arguments),
+                            &captured_length_func));
+
+    *output =
+        new Dataset(input, std::move(captured_length_func), token_budget,
+                    std::move(bucket_boundaries), std::move(padded_shapes),
+                    std::move(padding_values));
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_length_func,
+            int64 token_budget, std::vector<int64> bucket_boundaries,
+            std::vector<PartialTensorShape> padded_shapes,
+            std::vector<Tensor> padding_values)
+        : input_(input),
+          captured_length_func_(std::move(captured_length_func)),
+          token_budget_(token_budget),
+          bucket_boundaries_(std::move(bucket_boundaries)),
+          padded_shapes_(std::move(padded_shapes)),
+          padding_values_(std::move(padding_values)),
+          output_dtypes_(input->output_dtypes()) {
+      input_->Ref();
+
+      // Each batch is followed by the number of tokens in it and the number
+      // of tokens after padding.
+      for (size_t i = 0; i < padded_shapes_.size(); ++i) {
+        output_shapes_.push_back(
+            PartialTensorShape({-1}).Concatenate(padded_shapes_[i]));
+      }
+      for (int i = 0; i < 2; ++i) {
+        output_dtypes_.push_back(DT_INT64);
+        output_shapes_.push_back(PartialTensorShape({}));
+      }
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_dtypes_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return strings::StrCat("BucketByTokenBudgetDatasetOp(", token_budget_,
+                             ")::Dataset");
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()),
+            buckets_(dataset->bucket_boundaries_.size() + 1) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        *end_of_sequence = false;
+        while (!end_of_input_) {
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input_));
+          if (end_of_input_) break;
+
+          int64 length;
+          TF_RETURN_IF_ERROR(ComputeLength(ctx, element, &length));
+          const std::vector<int64>& boundaries = dataset()->bucket_boundaries_;
+          Bucket& bucket =
+              buckets_[std::upper_bound(boundaries.begin(), boundaries.end(),
+                                        length) -
+                       boundaries.begin()];
+
+          // If the element would take the bucket over its budget, emit the
+          // bucket before adding the element to it. An element that exceeds
+          // the budget on its own is emitted in a batch of one.
+          if (!bucket.elements.empty() &&
+              Cost(bucket.elements.size() + 1,
+                   std::max(bucket.max_length, length)) >
+                  dataset()->token_budget_) {
+            TF_RETURN_IF_ERROR(FlushBucket(&bucket, out_tensors));
+            bucket.Add(std::move(element), length);
+            return Status::OK();
+          }
+          bucket.Add(std::move(element), length);
+          if (Cost(bucket.elements.size(), bucket.max_length) >=
+              dataset()->token_budget_) {
+            return FlushBucket(&bucket, out_tensors);
+          }
+        }
+
+        // We have consumed all of the input, so flush the remaining buckets
+        // one at a time.
+        for (Bucket& bucket : buckets_) {
+          if (!bucket.elements.empty()) {
+            return FlushBucket(&bucket, out_tensors);
+          }
+        }
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     private:
+      struct Bucket {
+        void Add(std::vector<Tensor> element, int64 length) {
+          elements.push_back(std::move(element));
+          max_length = std::max(max_length, length);
+          num_tokens += length;
+        }
+
+        std::vector<std::vector<Tensor>> elements;
+        int64 max_length = 0;
+        int64 num_tokens = 0;
+      };
+
+      // Returns the number of tokens in a padded batch of `batch_size`
+      // elements that are at most `max_length` long. Empty elements count as
+      // one token, so that batches of them are bounded too.
+      static int64 Cost(int64 batch_size, int64 max_length) {
+        return batch_size * std::max<int64>(max_length, 1);
+      }
+
+      Status ComputeLength(IteratorContext* ctx,
+                           const std::vector<Tensor>& element, int64* length)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        FunctionLibraryRuntime::Options opts;
+        // Choose a step ID that is guaranteed not to clash with any
+        // Session-generated step ID. DirectSession only generates
+        // non-negative step IDs (contiguous, starting from 0), and
+        // MasterSession generates 56-bit random step IDs whose MSB is
+        // always 0, so a negative random step ID should suffice.
+        opts.step_id = -std::abs(static_cast<int64>(random::New64()));
+        opts.runner = ctx->runner();
+        std::vector<Tensor> length_func_output;
+        TF_RETURN_IF_ERROR(dataset()->captured_length_func_->Run(
+            opts, element, &length_func_output));
+        if (length_func_output.size() != 1 ||
+            length_func_output[0].dtype() != DT_INT64 ||
+            length_func_output[0].NumElements() != 1) {
+          return errors::InvalidArgument(
+              "`length_func` must return a scalar int64.");
+        }
+        *length = length_func_output[0].flat<int64>()(0);
+        if (*length < 0) {
+          return errors::InvalidArgument(
+              "`length_func` must return a non-negative length, but returned ",
+              *length);
+        }
+        return Status::OK();
+      }
+
+      // Pads and emits the elements of `bucket`, followed by its token
+      // counts, and empties it.
+      Status FlushBucket(Bucket* bucket, std::vector<Tensor>* out_tensors)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Bucket flushed;
+        std::swap(flushed, *bucket);
+        TF_RETURN_IF_ERROR(PadAndStackBatch(
+            flushed.elements, dataset()->padded_shapes_,
+            dataset()->padding_values_, out_tensors));
+        Tensor num_tokens(DT_INT64, TensorShape({}));
+        num_tokens.scalar<int64>()() = flushed.num_tokens;
+        out_tensors->push_back(std::move(num_tokens));
+        Tensor num_padded_tokens(DT_INT64, TensorShape({}));
+        num_padded_tokens.scalar<int64>()() =
+            flushed.elements.size() * flushed.max_length;
+        out_tensors->push_back(std::move(num_padded_tokens));
+        return Status::OK();
+      }
+
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      std::vector<Bucket> buckets_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_length_func_;
+    const int64 token_budget_;
+    const std::vector<int64> bucket_boundaries_;
+    const std::vector<PartialTensorShape> padded_shapes_;
+    const std::vector<Tensor> padding_values_;
+    DataTypeVector output_dtypes_;
+    std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  const int graph_def_version_;
+  const NameAttrList* length_func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("BucketByTokenBudgetDataset").Device(DEVICE_CPU),
+                        BucketByTokenBudgetDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
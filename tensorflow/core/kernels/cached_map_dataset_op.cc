@@ -0,0 +1,218 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/random/random.h"
+
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/shared_element_cache.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns a fingerprint of the type, shape and contents of `t`.
+uint64 HashTensor(const Tensor& t) {
+  uint64 hash = Hash64Combine(t.dtype(), t.dims());
+  for (int i = 0; i < t.dims(); ++i) {
+    hash = Hash64Combine(hash, t.dim_size(i));
+  }
+  if (t.dtype() == DT_STRING) {
+    const auto strings = t.flat<string>();
+    for (int64 i = 0; i < strings.size(); ++i) {
+      hash = Hash64Combine(hash, Hash64(strings(i)));
+    }
+  } else {
+    StringPiece data = t.tensor_data();
+    hash = Hash64Combine(hash, Hash64(data.data(), data.size()));
+  }
+  return hash;
+}
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class CachedMapDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit CachedMapDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx),
+        graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    // The cache keys depend on the function and its captured inputs, so that
+    // entries written by a different function are never used.
+    uint64 key_seed = Hash64(func_->name());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+      key_seed = Hash64Combine(key_seed, HashTensor(t));
+    }
+
+    string cache_directory;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "cache_directory",
+                                                    &cache_directory));
+    OP_REQUIRES(ctx, !cache_directory.empty(),
+                errors::InvalidArgument("Cache directory must be non-empty."));
+    int64 cache_capacity_bytes;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "cache_capacity_bytes",
+                                              &cache_capacity_bytes));
+    OP_REQUIRES(
+        ctx, cache_capacity_bytes > 0,
+        errors::InvalidArgument("Cache capacity must be greater than zero."));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    *output = new Dataset(
+        input, std::move(captured_func), key_seed,
+        std::unique_ptr<SharedElementCache>(new SharedElementCache(
+            ctx->env(), cache_directory, cache_capacity_bytes)),
+        output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_func, uint64 key_seed,
+            std::unique_ptr<SharedElementCache> cache,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : input_(input),
+          captured_func_(std::move(captured_func)),
+          key_seed_(key_seed),
+          cache_(std::move(cache)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override { return "CachedMapDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        // NOTE(mrry): This method is thread-safe as long as
+        // `input_impl_` and `f` are thread-safe. However, if multiple
+        // threads enter this method, outputs may be observed in a
+        // non-deterministic order.
+
+        std::vector<Tensor> args;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &args, end_of_sequence));
+        if (*end_of_sequence) {
+          return Status::OK();
+        }
+
+        uint64 key = dataset()->key_seed_;
+        for (const Tensor& t : args) {
+          key = Hash64Combine(key, HashTensor(t));
+        }
+        bool found;
+        TF_RETURN_IF_ERROR(dataset()->cache_->Lookup(key, out_tensors, &found));
+        if (found) {
+          return CheckCachedElement(*out_tensors);
+        }
+
+        FunctionLibraryRuntime::Options opts;
+        // Choose a step ID that is guaranteed not to clash with any
+        // Session-generated step ID. DirectSession only generates
+        // non-negative step IDs (contiguous, starting from 0), and
+        // MasterSession generates 56-bit random step IDs whose MSB is
+        // always 0, so a negative random step ID should suffice.
+        opts.step_id = -std::abs(static_cast<int64>(random::New64()));
+        opts.runner = ctx->runner();
+        // TODO(mrry): Avoid blocking a threadpool thread. We will need to
+        // stack-rip the iterators and use async kernels.
+        TF_RETURN_IF_ERROR(
+            dataset()->captured_func_->Run(opts, args, out_tensors));
+        return dataset()->cache_->Insert(key, *out_tensors);
+      }
+
+     private:
+      Status CheckCachedElement(const std::vector<Tensor>& element) {
+        const DataTypeVector& types = dataset()->output_types_;
+        const std::vector<PartialTensorShape>& shapes =
+            dataset()->output_shapes_;
+        bool matches = element.size() == types.size();
+        for (size_t i = 0; matches && i < element.size(); ++i) {
+          matches = element[i].dtype() == types[i] &&
+                    shapes[i].IsCompatibleWith(element[i].shape());
+        }
+        if (!matches) {
+          return errors::InvalidArgument(
+              "A cached element does not match the output signature of the "
+              "map function. Was the cache directory last used by a different "
+              "version of the input pipeline?");
+        }
+        return Status::OK();
+      }
+
+      const std::unique_ptr<IteratorBase> input_impl_;
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+    const uint64 key_seed_;
+    const std::unique_ptr<SharedElementCache> cache_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("CachedMapDataset").Device(DEVICE_CPU),
+                        CachedMapDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
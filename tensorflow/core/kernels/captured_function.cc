@@ -116,9 +116,9 @@ Status CapturedFunction::Run(FunctionLibraryRuntime::Options f_opts,
   // will be required to plumb it through the `IteratorContext`.
   CancellationManager c_mgr;
   f_opts.cancellation_manager = &c_mgr;
-  // TODO(mrry): Implement a synchronous version of
-  // FunctionLibraryRuntime::Run() that avoids a context switch for small
-  // functions.
+  // We block until the function is done, so small functions can run on
+  // this thread and avoid a context switch.
+  f_opts.run_small_functions_inline = true;
   if (captured_inputs_.empty()) {
     lib_->Run(f_opts, f_handle_, args, rets, done_callback);
   } else {
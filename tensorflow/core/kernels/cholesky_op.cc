@@ -90,6 +90,30 @@ TF_CALL_complex128(DECLARE_GPU_SPEC);
 
 }  // namespace functor
 
+// Factors a batch of small matrices with a single kernel launch. Returns false
+// without launching anything for the types that BatchedCholeskyFunctor does
+// not support.
+template <class Scalar>
+bool LaunchBatchedCholesky(const GPUDevice& d,
+                           typename TTypes<Scalar, 3>::Tensor matrices,
+                           int* dev_lapack_info) {
+  return false;
+}
+
+#define LAUNCH_BATCHED_CHOLESKY(T)                                      \
+  template <>                                                           \
+  bool LaunchBatchedCholesky<T>(const GPUDevice& d,                     \
+                                typename TTypes<T, 3>::Tensor matrices, \
+                                int* dev_lapack_info) {                 \
+    functor::BatchedCholeskyFunctor<GPUDevice, T>()(d, matrices,        \
+                                                    dev_lapack_info);   \
+    return true;                                                        \
+  }
+
+LAUNCH_BATCHED_CHOLESKY(float);
+LAUNCH_BATCHED_CHOLESKY(double);
+#undef LAUNCH_BATCHED_CHOLESKY
+
 template <class Scalar>
 class CholeskyOpGpu : public AsyncOpKernel {
  public:
@@ -135,20 +159,27 @@ class CholeskyOpGpu : public AsyncOpKernel {
         context->eigen_device<GPUDevice>(), n, 0, input_reshaped,
         output_reshaped);
 
-    // Launch a Cholesky kernel for each matrix in the batch.
     const int64 batch_size = input_reshaped.dimension(0);
     std::vector<DeviceLapackInfo> dev_info;
     dev_info.emplace_back(context, batch_size, "potrf");
-    // TODO(rmlarsen): Parallelize over batches if it turns out to be
-    // an important use case.
     CudaSolver solver(context);
-    for (int64 i = 0; i < batch_size; ++i) {
-      Scalar* output_ptr = output_reshaped.data() + i * n * n;
-      int* dev_info_ptr = dev_info.back().mutable_data() + i;
-      OP_REQUIRES_OK_ASYNC(
-          context,
-          solver.Potrf(CUBLAS_FILL_MODE_UPPER, n, output_ptr, n, dev_info_ptr),
-          done);
+    // Batches of small matrices are factored by a single kernel, since one
+    // launch per matrix would dominate their run time. Otherwise, launch a
+    // Cholesky kernel for each matrix in the batch.
+    const bool batched =
+        batch_size > 1 && n <= functor::kMaxBatchedCholeskySize &&
+        LaunchBatchedCholesky<Scalar>(context->eigen_device<GPUDevice>(),
+                                      output_reshaped,
+                                      dev_info.back().mutable_data());
+    if (!batched) {
+      for (int64 i = 0; i < batch_size; ++i) {
+        Scalar* output_ptr = output_reshaped.data() + i * n * n;
+        int* dev_info_ptr = dev_info.back().mutable_data() + i;
+        OP_REQUIRES_OK_ASYNC(context,
+                             solver.Potrf(CUBLAS_FILL_MODE_UPPER, n,
+                                          output_ptr, n, dev_info_ptr),
+                             done);
+      }
     }
 
     // Register callback to check info after kernels finish.
@@ -0,0 +1,405 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/columnar/columnar.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ColumnarDatasetOp : public DatasetOpKernel {
+ public:
+  explicit ColumnarDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    std::vector<string> dense_keys;
+    std::vector<TensorShape> dense_shapes;
+    std::vector<string> ragged_keys;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_keys", &dense_keys));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_shapes", &dense_shapes));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ragged_keys", &ragged_keys));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES(ctx, dense_keys.size() == dense_shapes.size(),
+                errors::InvalidArgument(
+                    "dense_keys and dense_shapes must have the same length"));
+    OP_REQUIRES(
+        ctx,
+        output_types_.size() == dense_keys.size() + 2 * ragged_keys.size(),
+        errors::InvalidArgument("Expected ",
+                                dense_keys.size() + 2 * ragged_keys.size(),
+                                " output types, got ", output_types_.size()));
+
+    // The outputs are ordered by key, which matches how nested structures of
+    // dicts are flattened in Python.
+    for (size_t i = 0; i < dense_keys.size(); ++i) {
+      columns_.push_back({dense_keys[i], DT_INVALID, false, dense_shapes[i]});
+    }
+    for (const string& key : ragged_keys) {
+      columns_.push_back({key, DT_INVALID, true, TensorShape({})});
+    }
+    std::sort(columns_.begin(), columns_.end(),
+              [](const Column& a, const Column& b) { return a.key < b.key; });
+    size_t output = 0;
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      OP_REQUIRES(ctx, i == 0 || columns_[i - 1].key != columns_[i].key,
+                  errors::InvalidArgument("Duplicate key '", columns_[i].key,
+                                          "'"));
+      columns_[i].dtype = output_types_[output++];
+      if (columns_[i].ragged) {
+        OP_REQUIRES(ctx, output_types_[output++] == DT_INT64,
+                    errors::InvalidArgument("The row splits of ragged column '",
+                                            columns_[i].key,
+                                            "' must be int64"));
+      }
+    }
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    int64 batch_size;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("Batch size must be greater than zero."));
+
+    *output = new Dataset(std::move(filenames), batch_size, columns_,
+                          output_types_, output_shapes_);
+  }
+
+ private:
+  // A column selected by the dataset.
+  struct Column {
+    string key;
+    DataType dtype;
+    bool ragged;
+    // The shape of each row of a dense column.
+    TensorShape row_shape;
+  };
+
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(std::vector<string> filenames, int64 batch_size,
+            std::vector<Column> columns, const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : filenames_(std::move(filenames)),
+          batch_size_(batch_size),
+          columns_(std::move(columns)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {}
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override { return "ColumnarDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        // Collect the rows of the batch, which may span several chunks.
+        std::vector<Piece> pieces;
+        int64 num_rows = 0;
+        while (num_rows < dataset()->batch_size_) {
+          if (next_row_ == chunk_.num_rows) {
+            bool end_of_files = false;
+            TF_RETURN_IF_ERROR(ReadNextChunk(ctx, &end_of_files));
+            if (end_of_files) break;
+            continue;
+          }
+          const int64 n = std::min(dataset()->batch_size_ - num_rows,
+                                   chunk_.num_rows - next_row_);
+          pieces.push_back({chunk_, next_row_, next_row_ + n});
+          next_row_ += n;
+          num_rows += n;
+        }
+        if (pieces.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        for (size_t c = 0; c < dataset()->columns_.size(); ++c) {
+          const Column& column = dataset()->columns_[c];
+          if (column.ragged) {
+            Tensor values, row_splits;
+            RaggedBatch(pieces, c, column.dtype, num_rows, &values,
+                        &row_splits);
+            out_tensors->push_back(std::move(values));
+            out_tensors->push_back(std::move(row_splits));
+          } else {
+            out_tensors->push_back(DenseBatch(pieces, c, column, num_rows));
+          }
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      // The projected columns of one chunk of a file.
+      struct Chunk {
+        // For dense columns, values[c] has shape [num_rows] + row_shape and
+        // row_splits[c] is unused.
+        std::vector<Tensor> values;
+        std::vector<Tensor> row_splits;
+        int64 num_rows = 0;
+      };
+
+      // Rows [begin, end) of a chunk.
+      struct Piece {
+        Chunk chunk;
+        int64 begin;
+        int64 end;
+      };
+
+      // Returns "t", or an aligned copy of it if it is a misaligned slice.
+      static Tensor Aligned(const Tensor& t) {
+        return t.IsAligned() ? t : tensor::DeepCopy(t);
+      }
+
+      // Copies the elements of "src" into "dst", starting at flat element
+      // "offset" of "dst".
+      static void CopyElements(const Tensor& src, int64 offset, Tensor* dst) {
+        if (src.NumElements() == 0) return;
+        if (src.dtype() == DT_STRING) {
+          auto from = src.flat<string>();
+          auto to = dst->flat<string>();
+          for (int64 i = 0; i < from.size(); ++i) {
+            to(offset + i) = from(i);
+          }
+        } else {
+          const StringPiece from = src.tensor_data();
+          memcpy(const_cast<char*>(dst->tensor_data().data()) +
+                     offset * DataTypeSize(src.dtype()),
+                 from.data(), from.size());
+        }
+      }
+
+      // Returns the batch of dense column "c". A batch within a single chunk
+      // aliases the chunk, and thus usually the mapped file.
+      static Tensor DenseBatch(const std::vector<Piece>& pieces, size_t c,
+                               const Column& column, int64 num_rows) {
+        if (pieces.size() == 1) {
+          const Piece& piece = pieces[0];
+          return Aligned(piece.chunk.values[c].Slice(piece.begin, piece.end));
+        }
+        TensorShape shape({num_rows});
+        shape.AppendShape(column.row_shape);
+        Tensor batch(cpu_allocator(), column.dtype, shape);
+        const int64 row_elements = column.row_shape.num_elements();
+        int64 row = 0;
+        for (const Piece& piece : pieces) {
+          CopyElements(piece.chunk.values[c].Slice(piece.begin, piece.end),
+                       row * row_elements, &batch);
+          row += piece.end - piece.begin;
+        }
+        return batch;
+      }
+
+      // Computes the values and num_rows + 1 row splits of the batch of
+      // ragged column "c".
+      static void RaggedBatch(const std::vector<Piece>& pieces, size_t c,
+                              DataType dtype, int64 num_rows, Tensor* values,
+                              Tensor* row_splits) {
+        *row_splits = Tensor(cpu_allocator(), DT_INT64,
+                             TensorShape({num_rows + 1}));
+        auto out_splits = row_splits->vec<int64>();
+        int64 row = 0;
+        int64 num_values = 0;
+        out_splits(0) = 0;
+        for (const Piece& piece : pieces) {
+          const auto splits = piece.chunk.row_splits[c].vec<int64>();
+          for (int64 r = piece.begin; r < piece.end; ++r) {
+            out_splits(++row) =
+                num_values + splits(r + 1) - splits(piece.begin);
+          }
+          num_values += splits(piece.end) - splits(piece.begin);
+        }
+        if (pieces.size() == 1) {
+          const Piece& piece = pieces[0];
+          const auto splits = piece.chunk.row_splits[c].vec<int64>();
+          *values = Aligned(piece.chunk.values[c].Slice(
+              splits(piece.begin), splits(piece.end)));
+          return;
+        }
+        *values = Tensor(cpu_allocator(), dtype, TensorShape({num_values}));
+        int64 offset = 0;
+        for (const Piece& piece : pieces) {
+          const auto splits = piece.chunk.row_splits[c].vec<int64>();
+          CopyElements(piece.chunk.values[c].Slice(splits(piece.begin),
+                                                   splits(piece.end)),
+                       offset, values);
+          offset += splits(piece.end) - splits(piece.begin);
+        }
+      }
+
+      // Reads the next chunk of the current file into chunk_, moving on to
+      // the next file as needed. Sets "*end_of_files" if there are none.
+      Status ReadNextChunk(IteratorContext* ctx, bool* end_of_files)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const std::vector<Column>& columns = dataset()->columns_;
+        while (true) {
+          if (reader_ && next_chunk_ < reader_->num_chunks()) {
+            const int chunk = next_chunk_++;
+            const int64 num_rows = reader_->chunk_num_rows(chunk);
+            Chunk result;
+            result.num_rows = num_rows;
+            result.values.resize(columns.size());
+            result.row_splits.resize(columns.size());
+            for (size_t c = 0; c < columns.size(); ++c) {
+              const int id = column_ids_[c];
+              if (id < 0) {
+                // A ragged column that is absent from the file, because no
+                // row had any values for it.
+                result.values[c] = Tensor(columns[c].dtype, TensorShape({0}));
+                result.row_splits[c] =
+                    Tensor(DT_INT64, TensorShape({num_rows + 1}));
+                result.row_splits[c].vec<int64>().setZero();
+                continue;
+              }
+              TF_RETURN_IF_ERROR(reader_->ReadChunk(
+                  id, chunk, &result.values[c], &result.row_splits[c]));
+              if (!columns[c].ragged) {
+                const int64 row_length =
+                    reader_->index().columns(id).chunks(chunk).row_length();
+                if (row_length != columns[c].row_shape.num_elements()) {
+                  return errors::InvalidArgument(
+                      "Column '", columns[c].key, "' has ",
+                      row_length < 0 ? string("rows of different lengths")
+                                     : strings::StrCat(row_length,
+                                                       " values per row"),
+                      " in chunk ", chunk, " of ",
+                      dataset()->filenames_[current_file_index_],
+                      ", but its dense shape ",
+                      columns[c].row_shape.DebugString(), " needs ",
+                      columns[c].row_shape.num_elements());
+                }
+                TensorShape shape({num_rows});
+                shape.AppendShape(columns[c].row_shape);
+                Tensor reshaped;
+                CHECK(reshaped.CopyFrom(result.values[c], shape));
+                result.values[c] = std::move(reshaped);
+                result.row_splits[c] = Tensor();
+              }
+            }
+            chunk_ = std::move(result);
+            next_row_ = 0;
+            return Status::OK();
+          }
+
+          // We have reached the end of the current file, so maybe move on to
+          // the next file.
+          if (reader_) {
+            reader_.reset();
+            ++current_file_index_;
+          }
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            *end_of_files = true;
+            return Status::OK();
+          }
+          TF_RETURN_IF_ERROR(OpenFile(ctx->env()));
+        }
+      }
+
+      // Opens the current file and finds its projected columns.
+      Status OpenFile(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const string& filename = dataset()->filenames_[current_file_index_];
+        std::unique_ptr<ColumnarReader> reader(
+            new ColumnarReader(env, filename));
+        TF_RETURN_IF_ERROR(reader->status());
+        column_ids_.clear();
+        for (const Column& column : dataset()->columns_) {
+          const int id = reader->FindColumn(column.key);
+          if (id < 0) {
+            if (!column.ragged && reader->num_rows() > 0) {
+              return errors::InvalidArgument("Dense column '", column.key,
+                                             "' not found in ", filename);
+            }
+          } else if (reader->index().columns(id).dtype() != column.dtype) {
+            return errors::InvalidArgument(
+                "Column '", column.key, "' in ", filename, " has type ",
+                DataTypeString(reader->index().columns(id).dtype()),
+                ", expected ", DataTypeString(column.dtype));
+          }
+          column_ids_.push_back(id);
+        }
+        reader_ = std::move(reader);
+        next_chunk_ = 0;
+        return Status::OK();
+      }
+
+      mutex mu_;
+      size_t current_file_index_ GUARDED_BY(mu_) = 0;
+      std::unique_ptr<ColumnarReader> reader_ GUARDED_BY(mu_);
+      // The positions of the dataset's columns in reader_, or -1.
+      std::vector<int> column_ids_ GUARDED_BY(mu_);
+      int next_chunk_ GUARDED_BY(mu_) = 0;
+      Chunk chunk_ GUARDED_BY(mu_);
+      int64 next_row_ GUARDED_BY(mu_) = 0;
+    };
+
+    const std::vector<string> filenames_;
+    const int64 batch_size_;
+    const std::vector<Column> columns_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  // The selected columns, sorted by key.
+  std::vector<Column> columns_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ColumnarDataset").Device(DEVICE_CPU),
+                        ColumnarDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -126,6 +126,25 @@ class ConcatBaseOp : public OpKernel {
     } else {
       output_shape.set_dim(axis, output_concat_dim);
     }
+    // When concatenating along the outermost non-trivial dimension, inputs
+    // that are adjacent regions of one buffer, e.g. the outputs of a Split,
+    // already form the output, which can then be a view of that buffer.
+    // Otherwise the inputs are copied into a new output below.
+    if (inputs_flat_dim0 == 1 && !inputs_flat.empty()) {
+      std::vector<Tensor> nonempty_values;
+      nonempty_values.reserve(inputs_flat.size());
+      for (int i = 0; i < N; ++i) {
+        if (values[i].NumElements() > 0) nonempty_values.push_back(values[i]);
+      }
+      Tensor joined;
+      if (Tensor::ConcatAdjacentSlices(nonempty_values, output_shape,
+                                       &joined) &&
+          joined.IsAligned()) {
+        c->set_output(0, joined);
+        return;
+      }
+    }
+
     Tensor* output = nullptr;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() > 0) {
@@ -19,8 +19,11 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -250,5 +253,51 @@ BENCHMARK(MemcpyManyAlternative2)
     ->Arg(64)
     ->Arg(65);
 
+class ConcatV2OpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_inputs) {
+    TF_EXPECT_OK(NodeDefBuilder("concat_op", "ConcatV2")
+                     .Input(FakeInput(num_inputs, DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+
+  // Adds 'input' itself, rather than a copy, as the next input.
+  void AddSharedInput(const Tensor& input) {
+    tensors_.push_back(new Tensor(input));
+    inputs_.push_back({nullptr, tensors_.back()});
+  }
+};
+
+TEST_F(ConcatV2OpTest, AdjacentSlicesAreNotCopied) {
+  MakeOp(3);
+  // Rows of 16 floats keep the slices aligned.
+  Tensor whole(allocator(), DT_FLOAT, TensorShape({6, 16}));
+  test::FillFn<float>(&whole, [](int i) { return i; });
+  AddSharedInput(whole.Slice(0, 2));
+  AddSharedInput(whole.Slice(2, 3));
+  AddSharedInput(whole.Slice(3, 6));
+  AddInputFromArray<int32>(TensorShape({}), {0});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(whole, *GetOutput(0));
+  EXPECT_EQ(whole.flat<float>().data(), GetOutput(0)->flat<float>().data());
+}
+
+TEST_F(ConcatV2OpTest, NonAdjacentSlicesAreCopied) {
+  MakeOp(2);
+  Tensor whole(allocator(), DT_FLOAT, TensorShape({6, 16}));
+  test::FillFn<float>(&whole, [](int i) { return i; });
+  AddSharedInput(whole.Slice(4, 6));
+  AddSharedInput(whole.Slice(0, 2));
+  AddInputFromArray<int32>(TensorShape({}), {0});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4, 16}));
+  test::FillFn<float>(&expected,
+                      [](int i) { return i < 32 ? i + 64 : i - 32; });
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+  EXPECT_FALSE(GetOutput(0)->SharesBufferWith(whole));
+}
+
 }  // namespace
 }  // namespace tensorflow
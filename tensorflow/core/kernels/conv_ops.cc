@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
+#include "tensorflow/core/kernels/fused_bias_activation_op.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #ifdef TENSORFLOW_USE_LIBXSMM
 #include "tensorflow/core/kernels/xsmm_conv2d.h"
@@ -46,7 +47,9 @@ limitations under the License.
 #include "tensorflow/core/util/use_cudnn.h"
 
 #if GOOGLE_CUDA
+#include "cuda/cuda_config.h"
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
 
@@ -85,7 +88,7 @@ struct LaunchGeneric {
           input.shaped<T, 2>({conv_width, filter.dim_size(2)}),
           filter.shaped<T, 2>({filter.dim_size(2), filter.dim_size(3)}),
           dim_pair);
-    } else if (filter.dim_size(0) == input.dim_size(1) &&
+    } else if (bias == nullptr && filter.dim_size(0) == input.dim_size(1) &&
                filter.dim_size(1) == input.dim_size(2) &&
                padding == Eigen::PADDING_VALID) {
       // If the input data and filter have the same height/width,
@@ -137,12 +140,15 @@ class LaunchDeepConvOp {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DFilterCache* filter_cache) {
     return false;
   }
 };
 
 // Conditionally launches DeepConv operation based on convolution parameters.
+// The transformed filters are cached in 'filter_cache', and reused while the
+// filter values do not change.
 template <>
 class LaunchDeepConvOp<CPUDevice, float> {
  public:
@@ -151,7 +157,8 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DFilterCache* filter_cache) {
     if (data_format != FORMAT_NHWC ||
         !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
                           in_depth, out_depth, out_rows, out_cols)) {
@@ -175,8 +182,15 @@ class LaunchDeepConvOp<CPUDevice, float> {
     auto filter_ptr = filter.template flat<float>().data();
     auto output_ptr = output->template flat<float>().data();
 
-    functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
-                                            output_ptr);
+    functor::DeepConv2D<CPUDevice, float> deep_conv2d;
+    DeepConv2DPackedFilters packed_filters;
+    if (!filter_cache->Lookup(filter, GetDeepConv2DOutputTileSize(args),
+                              &packed_filters)) {
+      deep_conv2d.PrepareFilters(ctx, args, filter_ptr, &packed_filters);
+      if (!ctx->status().ok()) return true;
+      filter_cache->Insert(filter, packed_filters);
+    }
+    deep_conv2d(ctx, args, input_ptr, packed_filters, output_ptr);
     return true;
   }
 };
@@ -250,10 +264,46 @@ class LaunchXsmmConvOp<CPUDevice, float> {
 };
 #endif
 
+// Computes Relu(conv + bias) with a fused kernel. Returns false, without
+// computing anything, if the device doesn't have one.
 template <typename Device, typename T>
-class Conv2DOp : public BinaryOp<T> {
+class LaunchConvBiasReluOp {
  public:
-  explicit Conv2DOp(OpKernelConstruction* context) : BinaryOp<T>(context) {
+  static bool Run(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+                  const Tensor& input, const Tensor& filter, const Tensor& bias,
+                  int row_stride, int col_stride,
+                  const Eigen::PaddingType& padding, Tensor* output,
+                  TensorFormat data_format,
+                  LaunchConv2DOp<Device, T>* launcher) {
+    return false;
+  }
+};
+
+#if GOOGLE_CUDA
+template <typename T>
+class LaunchConvBiasReluOp<GPUDevice, T> {
+ public:
+  static bool Run(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+                  const Tensor& input, const Tensor& filter, const Tensor& bias,
+                  int row_stride, int col_stride,
+                  const Eigen::PaddingType& padding, Tensor* output,
+                  TensorFormat data_format,
+                  LaunchConv2DOp<GPUDevice, T>* launcher) {
+    if (!use_cudnn) return false;
+    launcher->launch_with_bias_relu(ctx, cudnn_use_autotune, input, filter,
+                                    bias, row_stride, col_stride, padding,
+                                    output, data_format);
+    return true;
+  }
+};
+#endif  // GOOGLE_CUDA
+
+// Derives from OpKernel rather than BinaryOp<T>, so that _FusedConv2D, which
+// has more inputs, can reuse it.
+template <typename Device, typename T>
+class Conv2DOp : public OpKernel {
+ public:
+  explicit Conv2DOp(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
     string data_format;
     OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
@@ -275,14 +325,25 @@ class Conv2DOp : public BinaryOp<T> {
   }
 
   void Compute(OpKernelContext* context) override {
+    bool applied_relu_bias;
+    ComputeConv(context, context->input(0), context->input(1), nullptr,
+                &applied_relu_bias);
+  }
+
+ protected:
+  // Computes the convolution of "input" with "filter" into output 0. If
+  // "relu_bias" is not null and the device has a fused kernel for it, computes
+  // Relu(conv + *relu_bias) instead, and sets "*applied_relu_bias" to true.
+  void ComputeConv(OpKernelContext* context, const Tensor& input,
+                   const Tensor& filter, const Tensor* relu_bias,
+                   bool* applied_relu_bias) {
+    *applied_relu_bias = false;
+
     // Input tensor is of the following dimensions:
     // [ batch, in_rows, in_cols, in_depth ]
 
-    const Tensor& input = context->input(0);
-
     // Input filter is of the following dimensions:
     // [ filter_rows, filter_cols, in_depth, out_depth]
-    const Tensor& filter = context->input(1);
 
     // For 2D convolution, there should be 4 dimensions.
     OP_REQUIRES(context, input.dims() == 4,
@@ -371,6 +432,16 @@ class Conv2DOp : public BinaryOp<T> {
       return;
     }
 
+    if (relu_bias != nullptr &&
+        LaunchConvBiasReluOp<Device, T>::Run(
+            context, use_cudnn_, cudnn_use_autotune_, input, filter,
+            *relu_bias, stride_rows, stride_cols,
+            BrainPadding2EigenPadding(padding_), output, data_format_,
+            &launcher_)) {
+      *applied_relu_bias = true;
+      return;
+    }
+
 #ifdef TENSORFLOW_USE_LIBXSMM
     if (LaunchXsmmConvOp<Device, T>::Run(
             context, input, filter, batch, input_rows, input_cols, in_depth,
@@ -383,7 +454,8 @@ class Conv2DOp : public BinaryOp<T> {
     if (LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, batch, input_rows, input_cols, in_depth,
             filter_rows, filter_cols, pad_rows, pad_cols, out_rows, out_cols,
-            out_depth, stride_rows, stride_cols, output, data_format_)) {
+            out_depth, stride_rows, stride_cols, output, data_format_,
+            &deep_conv_filter_cache_)) {
       return;
     }
 
@@ -399,6 +471,7 @@ class Conv2DOp : public BinaryOp<T> {
   TensorFormat data_format_;
   LaunchConv2DOp<Device, T> launcher_;
   bool cudnn_use_autotune_;
+  DeepConv2DFilterCache deep_conv_filter_cache_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
@@ -415,6 +488,130 @@ TF_CALL_half(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 #endif  // USE_GEMM_FOR_CONV
 
+// Computes a convolution followed by the ops listed in "fused_ops": an
+// optional BiasAdd, an optional inference-mode FusedBatchNorm and an optional
+// activation.  The batch normalization is folded into the filter and the bias,
+// so the epilogue is a single bias and activation pass over the output, or
+// nothing at all when cuDNN applies the bias and a Relu.  Produced by the
+// grappler op fusion optimizer and the fuse_conv2d_epilogues graph transform.
+template <typename Device, typename T>
+class FusedConv2DOp : public Conv2DOp<Device, T> {
+ public:
+  explicit FusedConv2DOp(OpKernelConstruction* context)
+      : Conv2DOp<Device, T>(context) {
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+
+    // The fused ops are [BiasAdd] [FusedBatchNorm] [activation], in order.
+    size_t i = 0;
+    has_bias_ = i < fused_ops.size() && fused_ops[i] == "BiasAdd";
+    if (has_bias_) ++i;
+    has_batch_norm_ = i < fused_ops.size() && fused_ops[i] == "FusedBatchNorm";
+    if (has_batch_norm_) ++i;
+    activation_ = FusedActivation::kIdentity;
+    if (i < fused_ops.size()) {
+      OP_REQUIRES_OK(context, ParseFusedActivation(fused_ops[i], &activation_));
+      ++i;
+    }
+    OP_REQUIRES(
+        context, (has_bias_ || has_batch_norm_) && i == fused_ops.size(),
+        errors::InvalidArgument("Unsupported fused ops: ",
+                                str_util::Join(fused_ops, ", ")));
+    const int expected_num_args =
+        (has_bias_ ? 1 : 0) + (has_batch_norm_ ? 4 : 0);
+    OP_REQUIRES(context, num_args == expected_num_args,
+                errors::InvalidArgument(
+                    "Fused ops ", str_util::Join(fused_ops, ", "), " need ",
+                    expected_num_args, " args, got ", num_args));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+    const int64 out_depth = filter.dim_size(3);
+    for (int i = 2; i < context->num_inputs(); ++i) {
+      const Tensor& arg = context->input(i);
+      OP_REQUIRES(context,
+                  TensorShapeUtils::IsVector(arg.shape()) &&
+                      arg.dim_size(0) == out_depth,
+                  errors::InvalidArgument(
+                      "The args of the fused ops must be vectors of size ",
+                      out_depth, ", got ", arg.shape().DebugString()));
+    }
+
+    const Device& d = context->eigen_device<Device>();
+    Tensor conv_filter = filter;
+    Tensor bias;
+    if (has_batch_norm_) {
+      // conv(x, filter * scale) + offset equals
+      // FusedBatchNorm(conv(x, filter) + bias).
+      const Tensor no_bias(DataTypeToEnum<T>::value, TensorShape({0}));
+      const Tensor& conv_bias = has_bias_ ? context->input(2) : no_bias;
+      const int bn_args = has_bias_ ? 3 : 2;
+      Tensor scale;
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T>::value,
+                                            TensorShape({out_depth}), &scale));
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T>::value,
+                                            TensorShape({out_depth}), &bias));
+      functor::FoldBatchNorm<Device, T>()(
+          d, conv_bias.vec<T>(), context->input(bn_args).vec<T>(),
+          context->input(bn_args + 1).vec<T>(),
+          context->input(bn_args + 2).vec<T>(),
+          context->input(bn_args + 3).vec<T>(), static_cast<T>(epsilon_),
+          scale.vec<T>(), bias.vec<T>());
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T>::value,
+                                            filter.shape(), &conv_filter));
+      functor::ScaleColumns<Device, T>()(
+          d, filter.flat_inner_dims<T>(),
+          const_cast<const Tensor&>(scale).vec<T>(),
+          conv_filter.flat_inner_dims<T>());
+    } else {
+      bias = context->input(2);
+    }
+
+    bool applied_relu_bias;
+    this->ComputeConv(context, input, conv_filter,
+                      activation_ == FusedActivation::kRelu ? &bias : nullptr,
+                      &applied_relu_bias);
+    if (!context->status().ok() || applied_relu_bias) return;
+
+    Tensor* output = context->mutable_output(0);
+    if (output->NumElements() == 0) return;
+    functor::FusedBiasActivation<Device, T>()(
+        d, const_cast<const Tensor*>(output)->flat_inner_dims<T>(),
+        const_cast<const Tensor&>(bias).vec<T>(), activation_,
+        output->flat_inner_dims<T>());
+  }
+
+ private:
+  bool has_bias_;
+  bool has_batch_norm_;
+  FusedActivation activation_;
+  float epsilon_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedConv2DOp);
+};
+
+#define REGISTER_FUSED_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedConv2DOp<CPUDevice, T>);
+
+#if !defined(USE_GEMM_FOR_CONV)
+TF_CALL_half(REGISTER_FUSED_CPU);
+TF_CALL_float(REGISTER_FUSED_CPU);
+#endif  // USE_GEMM_FOR_CONV
+#undef REGISTER_FUSED_CPU
+
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<CPUDevice, float>;
 
@@ -436,6 +633,88 @@ int64 GetCudnnWorkspaceLimit(const string& envvar_in_mb,
   return default_value_in_bytes;
 }
 
+AutoTuneCache* AutoTuneCache::Global() {
+  static AutoTuneCache* cache = new AutoTuneCache;
+  return cache;
+}
+
+AutoTuneCache::AutoTuneCache() {
+  const char* filename = getenv("TF_CUDNN_AUTOTUNE_CACHE");
+  if (filename == nullptr || filename[0] == '\0') return;
+  filename_ = filename;
+  string contents;
+  Status s = ReadFileToString(Env::Default(), filename_, &contents);
+  if (!s.ok()) {
+    // The first process to autotune creates the file.
+    VLOG(1) << "Not loading the autotune cache: " << s;
+    return;
+  }
+  // Each line is the key, whose four fields are separated by tabs, followed
+  // by the two algorithms of the config. Later lines override earlier ones.
+  for (StringPiece line : str_util::Split(contents, '\n')) {
+    std::vector<string> fields = str_util::Split(line, '\t');
+    perftools::gputools::dnn::AlgorithmType algorithm, algorithm_no_scratch;
+    if (fields.size() != 6 || !strings::safe_strto64(fields[4], &algorithm) ||
+        !strings::safe_strto64(fields[5], &algorithm_no_scratch)) {
+      if (!line.empty()) {
+        LOG(WARNING) << "Ignoring malformed line in autotune cache "
+                     << filename_ << ": " << line;
+      }
+      continue;
+    }
+    fields.resize(4);
+    results_[str_util::Join(fields, "\t")] =
+        perftools::gputools::dnn::AlgorithmConfig(algorithm,
+                                                  algorithm_no_scratch);
+  }
+  VLOG(1) << "Loaded " << results_.size() << " autotune results from "
+          << filename_;
+}
+
+string AutoTuneCache::Key(const string& group, const ConvParameters& params) {
+  auto platform =
+      perftools::gputools::MultiPlatformManager::PlatformWithName("cuda");
+  if (!platform.ok()) return "";
+  auto executor = platform.ValueOrDie()->ExecutorForDevice(params.device_id());
+  if (!executor.ok()) return "";
+  return strings::StrCat(
+      group, "\t", executor.ValueOrDie()->GetDeviceDescription().name(),
+      "\t", TF_CUDNN_VERSION, "\t", params.ShapeToString());
+}
+
+bool AutoTuneCache::Find(const string& group, const ConvParameters& params,
+                         perftools::gputools::dnn::AlgorithmConfig* config) {
+  if (filename_.empty()) return false;
+  const string key = Key(group, params);
+  mutex_lock l(mu_);
+  auto it = results_.find(key);
+  if (it == results_.end()) return false;
+  *config = it->second;
+  return true;
+}
+
+void AutoTuneCache::Insert(
+    const string& group, const ConvParameters& params,
+    const perftools::gputools::dnn::AlgorithmConfig& config) {
+  if (filename_.empty()) return;
+  const string key = Key(group, params);
+  if (key.empty()) return;
+  mutex_lock l(mu_);
+  results_[key] = config;
+  // Appending keeps the lines of concurrent processes whole.
+  std::unique_ptr<WritableFile> file;
+  Status s = Env::Default()->NewAppendableFile(filename_, &file);
+  if (s.ok()) {
+    s = file->Append(strings::StrCat(key, "\t", config.algorithm(), "\t",
+                                     config.algorithm_no_scratch(), "\n"));
+  }
+  if (s.ok()) s = file->Close();
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to append to autotune cache " << filename_ << ": "
+                 << s;
+  }
+}
+
 // A dummy type to group forward convolution autotune results together.
 struct ConvAutoTuneGroup {
   static string name() { return "Conv"; }
@@ -447,9 +726,29 @@ typedef AutoTuneSingleton<ConvAutoTuneGroup, ConvParameters,
 template <typename T>
 void LaunchConv2DOp<GPUDevice, T>::launch(
     OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
-    const Tensor& input_param, const Tensor& filter, int row_stride,
-    int col_stride, const Eigen::PaddingType& padding, Tensor* output,
+    const Tensor& input, const Tensor& filter, int row_stride, int col_stride,
+    const Eigen::PaddingType& padding, Tensor* output,
+    TensorFormat data_format) {
+  Launch(ctx, use_cudnn, cudnn_use_autotune, input, filter, nullptr,
+         row_stride, col_stride, padding, output, data_format);
+}
+
+template <typename T>
+void LaunchConv2DOp<GPUDevice, T>::launch_with_bias_relu(
+    OpKernelContext* ctx, bool cudnn_use_autotune, const Tensor& input,
+    const Tensor& filter, const Tensor& bias, int row_stride, int col_stride,
+    const Eigen::PaddingType& padding, Tensor* output,
     TensorFormat data_format) {
+  Launch(ctx, /*use_cudnn=*/true, cudnn_use_autotune, input, filter, &bias,
+         row_stride, col_stride, padding, output, data_format);
+}
+
+template <typename T>
+void LaunchConv2DOp<GPUDevice, T>::Launch(
+    OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+    const Tensor& input_param, const Tensor& filter, const Tensor* bias,
+    int row_stride, int col_stride, const Eigen::PaddingType& padding,
+    Tensor* output, TensorFormat data_format) {
   using perftools::gputools::dnn::AlgorithmConfig;
   using perftools::gputools::dnn::AlgorithmType;
   using perftools::gputools::dnn::ProfileResult;
@@ -466,8 +765,10 @@ void LaunchConv2DOp<GPUDevice, T>::launch(
 
   Tensor input = input_param;
 
-  if (filter.dim_size(0) == 1 && filter.dim_size(1) == 1 && row_stride == 1 &&
-      col_stride == 1 && data_format == FORMAT_NHWC) {
+  // The cuBLAS shortcuts below can't apply a bias and an activation, so the
+  // fused convolution always goes through cuDNN.
+  if (bias == nullptr && filter.dim_size(0) == 1 && filter.dim_size(1) == 1 &&
+      row_stride == 1 && col_stride == 1 && data_format == FORMAT_NHWC) {
     // 1x1 filter, so call cublas directly.
     const uint64 m = input.dim_size(0) * input.dim_size(1) * input.dim_size(2);
     const uint64 k = filter.dim_size(2);
@@ -491,7 +792,7 @@ void LaunchConv2DOp<GPUDevice, T>::launch(
                                       ", n=", n, ", k=", k));
     }
     return;
-  } else if (filter.dim_size(0) == input.dim_size(1) &&
+  } else if (bias == nullptr && filter.dim_size(0) == input.dim_size(1) &&
              filter.dim_size(1) == input.dim_size(2) &&
              padding == Eigen::PADDING_VALID && data_format == FORMAT_NHWC) {
     // The input data and filter have the same height/width, so call cublas
@@ -713,13 +1014,27 @@ void LaunchConv2DOp<GPUDevice, T>::launch(
   }
 
   CudnnScratchAllocator scratch_allocator(ConvolveScratchSize, ctx);
-  bool cudnn_launch_status =
-      stream
-          ->ThenConvolveWithAlgorithm(input_desc, input_ptr, filter_desc,
-                                      filter_ptr, conv_desc, output_desc,
-                                      &output_ptr, &scratch_allocator,
-                                      algorithm_config, nullptr)
-          .ok();
+  bool cudnn_launch_status;
+  if (bias != nullptr) {
+    auto bias_ptr = AsDeviceMemory(bias->template flat<T>().data(),
+                                   bias->template flat<T>().size());
+    cudnn_launch_status =
+        stream
+            ->ThenConvolveWithAlgorithm(
+                input_desc, input_ptr, filter_desc, filter_ptr, conv_desc,
+                bias_ptr, perftools::gputools::dnn::ActivationMode::kRelu,
+                output_desc, &output_ptr, &scratch_allocator,
+                algorithm_config, nullptr)
+            .ok();
+  } else {
+    cudnn_launch_status =
+        stream
+            ->ThenConvolveWithAlgorithm(input_desc, input_ptr, filter_desc,
+                                        filter_ptr, conv_desc, output_desc,
+                                        &output_ptr, &scratch_allocator,
+                                        algorithm_config, nullptr)
+            .ok();
+  }
 
   if (!cudnn_launch_status) {
     ctx->SetStatus(errors::Internal(
@@ -768,6 +1083,33 @@ namespace functor {
       typename TTypes<T, 4, int>::Tensor out, TensorFormat data_format);     \
   extern template struct PadInput<GPUDevice, T, int, 4>
 
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(Eigen::half);
+#undef DECLARE_GPU_SPEC
+
+// Defined in fused_bias_activation_op_gpu.cu.cc.
+#define DECLARE_GPU_SPEC(T)                                                  \
+  template <>                                                                \
+  void FusedBiasActivation<GPUDevice, T>::operator()(                        \
+      const GPUDevice& d, typename TTypes<T>::ConstMatrix input,             \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation,         \
+      typename TTypes<T>::Matrix output);                                    \
+  extern template struct FusedBiasActivation<GPUDevice, T>;                  \
+  template <>                                                                \
+  void FoldBatchNorm<GPUDevice, T>::operator()(                              \
+      const GPUDevice& d, typename TTypes<T>::ConstVec bias,                 \
+      typename TTypes<T>::ConstVec bn_scale,                                 \
+      typename TTypes<T>::ConstVec bn_offset,                                \
+      typename TTypes<T>::ConstVec mean,                                     \
+      typename TTypes<T>::ConstVec variance, T epsilon,                      \
+      typename TTypes<T>::Vec scale, typename TTypes<T>::Vec offset);        \
+  extern template struct FoldBatchNorm<GPUDevice, T>;                        \
+  template <>                                                                \
+  void ScaleColumns<GPUDevice, T>::operator()(                               \
+      const GPUDevice& d, typename TTypes<T>::ConstMatrix input,             \
+      typename TTypes<T>::ConstVec scale, typename TTypes<T>::Matrix output); \
+  extern template struct ScaleColumns<GPUDevice, T>
+
 DECLARE_GPU_SPEC(float);
 DECLARE_GPU_SPEC(Eigen::half);
 #undef DECLARE_GPU_SPEC
@@ -780,6 +1122,12 @@ REGISTER_KERNEL_BUILDER(
 REGISTER_KERNEL_BUILDER(
     Name("Conv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
     Conv2DOp<GPUDevice, float>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<Eigen::half>("T"),
+    FusedConv2DOp<GPUDevice, Eigen::half>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedConv2DOp<GPUDevice, float>);
 
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<GPUDevice, float>;
@@ -63,6 +63,22 @@ class LaunchConv2DOp<Eigen::GpuDevice, T> {
               const Tensor& input, const Tensor& filter, int row_stride,
               int col_stride, const Eigen::PaddingType& padding, Tensor* output,
               TensorFormat data_format);
+
+  // Computes Relu(conv + bias) with cuDNN's fused convolution, bias and
+  // activation kernel, where "bias" has one value per output channel.
+  void launch_with_bias_relu(OpKernelContext* ctx, bool cudnn_use_autotune,
+                             const Tensor& input, const Tensor& filter,
+                             const Tensor& bias, int row_stride,
+                             int col_stride, const Eigen::PaddingType& padding,
+                             Tensor* output, TensorFormat data_format);
+
+ private:
+  // Implements both of the above. "bias" is null for a plain convolution.
+  void Launch(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+              const Tensor& input, const Tensor& filter, const Tensor* bias,
+              int row_stride, int col_stride,
+              const Eigen::PaddingType& padding, Tensor* output,
+              TensorFormat data_format);
 };
 #endif  // GOOGLE_CUDA
 
@@ -132,7 +132,14 @@ class ConvParameters {
   }
   uint64 hash() const { return hash_code_; }
 
+  int device_id() const { return device_id_; }
+
   string ToString() const {
+    return strings::StrCat(ShapeToString(), ", ", device_id_);
+  }
+
+  // Like ToString(), without the device ordinal.
+  string ShapeToString() const {
     // clang-format off
     return strings::StrCat(
         batch_, ", ", in_depths_, ", ",
@@ -141,7 +148,7 @@ class ConvParameters {
         "(", str_util::Join(filter_, ", "), "), ",
         "(", str_util::Join(stride_, ", "), "), ",
         "(", str_util::Join(padding_, ", "), "), ",
-        dtype_, ", ", device_id_);
+        dtype_);
     // clang-format on
   }
 
@@ -185,6 +192,41 @@ class ConvParameters {
 
 typedef Eigen::GpuDevice GPUDevice;
 
+// Persists accepted autotune results across processes. If the environment
+// variable TF_CUDNN_AUTOTUNE_CACHE names a file, the results that earlier
+// processes appended to it are loaded on first use, and every result newly
+// accepted by an AutoTuneMap is appended to it. Results are keyed by the
+// autotune group, the name of the GPU, the cuDNN version and the parameters
+// other than the device ordinal, so the file can be shared by processes
+// whose GPUs are numbered differently.
+class AutoTuneCache {
+ public:
+  static AutoTuneCache* Global();
+
+  // Looks up the result recorded for 'params' in the autotune group 'group'.
+  bool Find(const string& group, const ConvParameters& params,
+            perftools::gputools::dnn::AlgorithmConfig* config);
+
+  // Records the accepted result for 'params' in the autotune group 'group'.
+  void Insert(const string& group, const ConvParameters& params,
+              const perftools::gputools::dnn::AlgorithmConfig& config);
+
+ private:
+  AutoTuneCache();
+
+  // Returns the key of 'params' in 'group', or an empty string if the GPU of
+  // 'params' can't be found.
+  static string Key(const string& group, const ConvParameters& params);
+
+  // Empty if the cache is disabled.
+  string filename_;
+  mutex mu_;
+  std::unordered_map<string, perftools::gputools::dnn::AlgorithmConfig>
+      results_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutoTuneCache);
+};
+
 // A helper class that looks up the best autotuned config from parameters.
 // Due to the noisy nature of autotune, especially with multiple devices, it
 // only accepts a config if its margin exceeds a threshold.
@@ -195,14 +237,25 @@ typedef Eigen::GpuDevice GPUDevice;
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+// Accepted configs are also looked up in and recorded to AutoTuneCache, so
+// that they survive the process.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
-  bool Find(const Parameters& params, Config* config) const {
+  bool Find(const Parameters& params, Config* config) {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
-    if (iter == params_config_map_.end() ||
-        iter->second.score < min_score_threshold_) {
+    if (iter == params_config_map_.end()) {
+      // Accept a config recorded by an earlier process as it is.
+      if (!AutoTuneCache::Global()->Find(name_, params, config)) {
+        return false;
+      }
+      VLOG(1) << GetActionSummary("loads", params, *config);
+      params_config_map_.insert(
+          std::make_pair(params, ValueType{*config, min_score_threshold_}));
+      return true;
+    }
+    if (iter->second.score < min_score_threshold_) {
       return false;
     }
     *config = iter->second.config;
@@ -235,6 +288,7 @@ class AutoTuneMap {
     }
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
+      AutoTuneCache::Global()->Insert(name_, params, config);
     }
   }
 
@@ -264,7 +318,7 @@ class AutoTuneMap {
                            config.ToString().c_str());
   }
 
-  mutable mutex mu_;
+  mutex mu_;
   struct ValueType {
     Config config;
     int32 score;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
@@ -346,4 +347,145 @@ TEST_F(FusedResizePadConvOpTest, ResizeAndPadSymmetricComparativeLarge) {
                           "SYMMETRIC", 1, "SAME");
 }
 
+class FusedConv2DOpTest : public OpsTestBase {
+ protected:
+  // Returns a tensor of the given shape with values in [min, min + 1).
+  static Tensor RandomTensor(const TensorShape& shape, float min) {
+    Tensor tensor(DT_FLOAT, shape);
+    tensor.flat<float>().setRandom();
+    tensor.flat<float>() = tensor.flat<float>() + min;
+    return tensor;
+  }
+
+  // Runs a Conv2D followed by "fused_ops" as separate ops, and as one
+  // _FusedConv2D, and checks that they give the same results.
+  void CompareFusedAndSeparate(int filter_size, int stride,
+                               const string& padding,
+                               const std::vector<string>& fused_ops) {
+    const int batch = 2;
+    const int input_height = 7;
+    const int input_width = 6;
+    const int input_depth = 3;
+    const int filter_count = 5;
+    const float epsilon = 0.001f;
+
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    const Tensor input_data = RandomTensor(
+        {batch, input_height, input_width, input_depth}, -0.5f);
+    const Tensor filter_data = RandomTensor(
+        {filter_size, filter_size, input_depth, filter_count}, -0.5f);
+    Output input =
+        Const(root.WithOpName("input"), Input::Initializer(input_data));
+    Output filter =
+        Const(root.WithOpName("filter"), Input::Initializer(filter_data));
+    Output output = Conv2D(root.WithOpName("conv"), input, filter,
+                           {1, stride, stride, 1}, padding);
+
+    std::vector<Tensor> args;
+    for (const string& fused_op : fused_ops) {
+      if (fused_op == "BiasAdd") {
+        args.push_back(RandomTensor({filter_count}, -0.5f));
+        output = BiasAdd(root.WithOpName("bias_add"), output,
+                         Const(root.WithOpName("bias"),
+                               Input::Initializer(args.back())));
+      } else if (fused_op == "FusedBatchNorm") {
+        std::vector<Output> bn_args;
+        for (float min : {0.5f, -0.5f, -0.5f, 0.1f}) {
+          args.push_back(RandomTensor({filter_count}, min));
+          bn_args.push_back(
+              Const(root.WithOpName(strings::StrCat("bn_arg", bn_args.size())),
+                    Input::Initializer(args.back())));
+        }
+        output = FusedBatchNorm(root.WithOpName("batch_norm"), output,
+                                bn_args[0], bn_args[1], bn_args[2],
+                                bn_args[3],
+                                FusedBatchNorm::IsTraining(false).Epsilon(
+                                    epsilon))
+                     .y;
+      } else if (fused_op == "Relu") {
+        output = Relu(root.WithOpName("relu"), output);
+      } else if (fused_op == "Relu6") {
+        output = Relu6(root.WithOpName("relu6"), output);
+      } else if (fused_op == "Elu") {
+        output = Elu(root.WithOpName("elu"), output);
+      }
+    }
+    Identity(root.WithOpName("unfused"), output);
+
+    tensorflow::GraphDef graph;
+    TF_ASSERT_OK(root.ToGraphDef(&graph));
+    std::unique_ptr<tensorflow::Session> session(
+        tensorflow::NewSession(tensorflow::SessionOptions()));
+    TF_ASSERT_OK(session->Create(graph));
+    std::vector<Tensor> unfused_tensors;
+    TF_ASSERT_OK(session->Run({}, {"unfused"}, {}, &unfused_tensors));
+
+    const int num_args = args.size();
+    TF_ASSERT_OK(NodeDefBuilder("fused_conv", "_FusedConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_args, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("num_args", num_args)
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding)
+                     .Attr("fused_ops", fused_ops)
+                     .Attr("epsilon", epsilon)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<float>(input_data.shape(), input_data.flat<float>());
+    AddInputFromArray<float>(filter_data.shape(), filter_data.flat<float>());
+    for (const Tensor& arg : args) {
+      AddInputFromArray<float>(arg.shape(), arg.flat<float>());
+    }
+    TF_ASSERT_OK(RunOpKernel());
+
+    test::ExpectTensorNear<float>(unfused_tensors[0], *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(FusedConv2DOpTest, BiasAdd) {
+  CompareFusedAndSeparate(3, 1, "SAME", {"BiasAdd"});
+}
+
+TEST_F(FusedConv2DOpTest, BiasAddRelu) {
+  CompareFusedAndSeparate(3, 1, "SAME", {"BiasAdd", "Relu"});
+}
+
+TEST_F(FusedConv2DOpTest, OneByOneBiasAddRelu6) {
+  CompareFusedAndSeparate(1, 1, "VALID", {"BiasAdd", "Relu6"});
+}
+
+TEST_F(FusedConv2DOpTest, BatchNorm) {
+  CompareFusedAndSeparate(3, 2, "VALID", {"FusedBatchNorm"});
+}
+
+TEST_F(FusedConv2DOpTest, BatchNormElu) {
+  CompareFusedAndSeparate(3, 2, "SAME", {"FusedBatchNorm", "Elu"});
+}
+
+TEST_F(FusedConv2DOpTest, BiasAddBatchNormRelu) {
+  CompareFusedAndSeparate(2, 1, "SAME", {"BiasAdd", "FusedBatchNorm", "Relu"});
+}
+
+TEST_F(FusedConv2DOpTest, InvalidFusedOps) {
+  for (const std::vector<string>& fused_ops :
+       std::vector<std::vector<string>>{
+           {"Relu"}, {"FusedBatchNorm", "BiasAdd"}, {"BiasAdd", "Sigmoid"}}) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_conv", "_FusedConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(1, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("num_args", 1)
+                     .Attr("strides", {1, 1, 1, 1})
+                     .Attr("padding", "SAME")
+                     .Attr("fused_ops", fused_ops)
+                     .Finalize(node_def()));
+    EXPECT_FALSE(InitOp().ok());
+  }
+}
+
 }  // namespace tensorflow
@@ -19,6 +19,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/crop_and_resize_op.h"
 
+#include <algorithm>
+#include <vector>
+
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -167,71 +171,101 @@ struct CropAndResize<CPUDevice, T> {
     const int crop_width = crops.dimension(2);
     const int depth = crops.dimension(3);
 
-    for (int b = 0; b < num_boxes; ++b) {
-      const float y1 = boxes(b, 0);
-      const float x1 = boxes(b, 1);
-      const float y2 = boxes(b, 2);
-      const float x2 = boxes(b, 3);
-
-      const int32 b_in = box_ind(b);
-      if (b_in < 0 || b_in >= batch) {
-        continue;
-      }
-
-      const float height_scale =
-          (crop_height > 1) ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
-                            : 0;
-      const float width_scale =
-          (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
-                           : 0;
-
-      for (int y = 0; y < crop_height; ++y) {
-        const float in_y = (crop_height > 1)
-                               ? y1 * (image_height - 1) + y * height_scale
-                               : 0.5 * (y1 + y2) * (image_height - 1);
-        if (in_y < 0 || in_y > image_height - 1) {
-          for (int x = 0; x < crop_width; ++x) {
-            for (int d = 0; d < depth; ++d) {
-              crops(b, y, x, d) = extrapolation_value;
-            }
-          }
+    // The source columns of each crop column, which are the same for all the
+    // rows of a box.
+    struct XInterpolation {
+      // Whether the column is inside the image, otherwise it is extrapolated.
+      bool valid;
+      // Offsets of the left and right source columns in an image row.
+      int64 left;
+      int64 right;
+      float lerp;
+    };
+
+    auto crop_boxes = [&](int64 start, int64 limit) {
+      std::vector<XInterpolation> xs(crop_width);
+      for (int64 b = start; b < limit; ++b) {
+        const float y1 = boxes(b, 0);
+        const float x1 = boxes(b, 1);
+        const float y2 = boxes(b, 2);
+        const float x2 = boxes(b, 3);
+
+        const int32 b_in = box_ind(b);
+        if (b_in < 0 || b_in >= batch) {
           continue;
         }
-        const int top_y_index = floorf(in_y);
-        const int bottom_y_index = ceilf(in_y);
-        const float y_lerp = in_y - top_y_index;
+
+        const float height_scale =
+            (crop_height > 1)
+                ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
+                : 0;
+        const float width_scale =
+            (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
+                             : 0;
 
         for (int x = 0; x < crop_width; ++x) {
           const float in_x = (crop_width > 1)
                                  ? x1 * (image_width - 1) + x * width_scale
                                  : 0.5 * (x1 + x2) * (image_width - 1);
-          if (in_x < 0 || in_x > image_width - 1) {
-            for (int d = 0; d < depth; ++d) {
-              crops(b, y, x, d) = extrapolation_value;
-            }
-            continue;
-          }
+          XInterpolation& xi = xs[x];
+          xi.valid = in_x >= 0 && in_x <= image_width - 1;
+          if (!xi.valid) continue;
           const int left_x_index = floorf(in_x);
           const int right_x_index = ceilf(in_x);
-          const float x_lerp = in_x - left_x_index;
+          xi.left = static_cast<int64>(left_x_index) * depth;
+          xi.right = static_cast<int64>(right_x_index) * depth;
+          xi.lerp = in_x - left_x_index;
+        }
 
-          for (int d = 0; d < depth; ++d) {
-            const float top_left(
-                static_cast<float>(image(b_in, top_y_index, left_x_index, d)));
-            const float top_right(
-                static_cast<float>(image(b_in, top_y_index, right_x_index, d)));
-            const float bottom_left(static_cast<float>(
-                image(b_in, bottom_y_index, left_x_index, d)));
-            const float bottom_right(static_cast<float>(
-                image(b_in, bottom_y_index, right_x_index, d)));
-            const float top = top_left + (top_right - top_left) * x_lerp;
-            const float bottom =
-                bottom_left + (bottom_right - bottom_left) * x_lerp;
-            crops(b, y, x, d) = top + (bottom - top) * y_lerp;
+        for (int y = 0; y < crop_height; ++y) {
+          float* crop_ptr = &crops(b, y, 0, 0);
+          const float in_y = (crop_height > 1)
+                                 ? y1 * (image_height - 1) + y * height_scale
+                                 : 0.5 * (y1 + y2) * (image_height - 1);
+          if (in_y < 0 || in_y > image_height - 1) {
+            std::fill_n(crop_ptr, crop_width * depth, extrapolation_value);
+            continue;
+          }
+          const int top_y_index = floorf(in_y);
+          const int bottom_y_index = ceilf(in_y);
+          const float y_lerp = in_y - top_y_index;
+          const T* top_ptr = &image(b_in, top_y_index, 0, 0);
+          const T* bottom_ptr = &image(b_in, bottom_y_index, 0, 0);
+
+          for (int x = 0; x < crop_width; ++x, crop_ptr += depth) {
+            const XInterpolation& xi = xs[x];
+            if (!xi.valid) {
+              std::fill_n(crop_ptr, depth, extrapolation_value);
+              continue;
+            }
+            const T* top_left_ptr = top_ptr + xi.left;
+            const T* top_right_ptr = top_ptr + xi.right;
+            const T* bottom_left_ptr = bottom_ptr + xi.left;
+            const T* bottom_right_ptr = bottom_ptr + xi.right;
+            const float x_lerp = xi.lerp;
+            for (int d = 0; d < depth; ++d) {
+              const float top_left(static_cast<float>(top_left_ptr[d]));
+              const float top_right(static_cast<float>(top_right_ptr[d]));
+              const float bottom_left(static_cast<float>(bottom_left_ptr[d]));
+              const float bottom_right(
+                  static_cast<float>(bottom_right_ptr[d]));
+              const float top = top_left + (top_right - top_left) * x_lerp;
+              const float bottom =
+                  bottom_left + (bottom_right - bottom_left) * x_lerp;
+              crop_ptr[d] = top + (bottom - top) * y_lerp;
+            }
           }
         }
       }
-    }
+    };
+    // Each crop value reads 4 image values, and takes 3 lerps.
+    const int64 crop_size =
+        static_cast<int64>(crop_height) * crop_width * depth;
+    d.parallelFor(num_boxes,
+                  Eigen::TensorOpCost(4 * crop_size * sizeof(T),
+                                      crop_size * sizeof(float),
+                                      9 * crop_size),
+                  crop_boxes);
     return true;
   }
 };
@@ -18,6 +18,8 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/core/util/ctc/ctc_beam_search.h"
 #include "tensorflow/core/framework/op.h"
@@ -26,7 +28,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -280,41 +284,43 @@ class CTCBeamSearchDecoderOp : public OpKernel {
 
     log_prob_t.setZero();
 
-    std::vector<TTypes<float>::UnalignedConstMatrix> input_list_t;
-
-    for (std::size_t t = 0; t < max_time; ++t) {
-      input_list_t.emplace_back(inputs_t.data() + t * batch_size * num_classes,
-                                batch_size, num_classes);
-    }
-
-    ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
-                                            &beam_scorer_, 1 /* batch_size */,
-                                            merge_repeated_);
-    Tensor input_chip(DT_FLOAT, TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<float>();
-
+    const int top_paths = decode_helper_.GetTopPaths();
     std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<float> log_probs;
-
-    // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi =
-            Eigen::Map<const Eigen::ArrayXf>(input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
-      }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
-
-      beam_search.Reset();
-
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+    std::vector<Status> statuses(batch_size);
+
+    // Batch entries are independent, so they are decoded in parallel, each
+    // shard with a decoder of its own. The scorer is shared: its methods are
+    // const and keep all per-beam data in the beam state.
+    auto decode = [&](int64 start, int64 limit) {
+      std::unique_ptr<Decoder> beam_search = GetDecoder(num_classes);
+      std::vector<float> log_probs;
+      for (int64 b = start; b < limit; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(top_paths);
+        beam_search->Reset();
+        // Assumption: the blank index is num_classes - 1
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          const float* input_bt =
+              inputs_t.data() + (t * batch_size + b) * num_classes;
+          beam_search->Step(
+              Eigen::Map<const Eigen::ArrayXf>(input_bt, num_classes));
+        }
+        statuses[b] = beam_search->TopPaths(top_paths, &best_paths_b,
+                                            &log_probs, merge_repeated_);
+        if (!statuses[b].ok()) continue;
+        for (int bp = 0; bp < top_paths; ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
+      ReturnDecoder(std::move(beam_search));
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 cost_per_batch_entry =
+        max_time * beam_width_ * static_cast<int64>(num_classes) * 10;
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          cost_per_batch_entry, decode);
+    for (const Status& status : statuses) {
+      OP_REQUIRES_OK(ctx, status);
     }
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
@@ -323,10 +329,35 @@ class CTCBeamSearchDecoderOp : public OpKernel {
   }
 
  private:
+  typedef ctc::CTCBeamSearchDecoder<> Decoder;
+
+  // Decoders are kept across calls, so the beam entries they allocated for
+  // earlier sequences are reused rather than freed and allocated again.
+  std::unique_ptr<Decoder> GetDecoder(int num_classes) {
+    {
+      mutex_lock l(mu_);
+      while (!decoders_.empty()) {
+        std::unique_ptr<Decoder> decoder = std::move(decoders_.back());
+        decoders_.pop_back();
+        if (decoder->num_classes() == num_classes) return decoder;
+      }
+    }
+    return std::unique_ptr<Decoder>(
+        new Decoder(num_classes, beam_width_, &beam_scorer_,
+                    1 /* batch_size */, merge_repeated_));
+  }
+
+  void ReturnDecoder(std::unique_ptr<Decoder> decoder) {
+    mutex_lock l(mu_);
+    decoders_.push_back(std::move(decoder));
+  }
+
   CTCDecodeHelper decode_helper_;
-  ctc::CTCBeamSearchDecoder<>::DefaultBeamScorer beam_scorer_;
+  Decoder::DefaultBeamScorer beam_scorer_;
   bool merge_repeated_;
   int beam_width_;
+  mutex mu_;
+  std::vector<std::unique_ptr<Decoder>> decoders_ GUARDED_BY(mu_);
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoderOp);
 };
 
@@ -156,6 +156,18 @@ class CudaSolver {
                       const Scalar* host_a_inverse_dev_ptrs[], int ldainv,
                       DeviceLapackInfo* dev_lapack_info, int batch_size) const;
 
+  // Uses LU factorizations from GetrfBatched to solve op(A) * X = B for a
+  // batch of matrices, overwriting B with X. Unlike the other batched calls,
+  // cuBlas only reports invalid arguments, in the single int pointed to by
+  // host_lapack_info, which must be in host memory. Returns Status::OK() if
+  // the kernel was launched successfully. See:
+  // http://docs.nvidia.com/cuda/cublas/index.html#cublas-lt-t-gt-getrsbatched
+  template <typename Scalar>
+  Status GetrsBatched(cublasOperation_t trans, int n, int nrhs,
+                      const Scalar* host_a_dev_ptrs[], int lda,
+                      const int* dev_pivots, const Scalar* host_b_dev_ptrs[],
+                      int ldb, int* host_lapack_info, int batch_size) const;
+
   /*
   TODO(rmlarsen, volunteers): Implement the kernels below.
   // Uses Cholesky factorization to solve A * X = B.
@@ -209,15 +221,6 @@ class CudaSolver {
   Status Gesvd(signed char jobu, signed char jobvt, int m, int n, Scalar* dev_A,
              int lda, Scalar* dev_S, Scalar* dev_U, int ldu, Scalar* dev_VT,
              int ldvt, int* dev_lapack_info);
-
-  // Batched linear solver using LU factorization from getrfBatched.
-  // See:
-  http://docs.nvidia.com/cuda/cublas/index.html#cublas-lt-t-gt-getrsbatched
-  template <typename Scalar>
-  Status GetrsBatched(cublasOperation_t trans, int n, int nrhs,
-                    const Scalar* dev_Aarray[], int lda, const int* devIpiv,
-                    Scalar* dev_Barray[], int ldb, int* info, int batch_size)
-  const;
   */
 
  private:
@@ -313,6 +316,23 @@ struct AdjointBatchFunctor {
                   typename TTypes<Scalar, 3>::ConstTensor input,
                   typename TTypes<Scalar, 3>::Tensor output);
 };
+
+// Matrices up to this size are factored by BatchedCholeskyFunctor rather than
+// by one cuSolverDN call each.
+constexpr int kMaxBatchedCholeskySize = 32;
+
+// Computes, in place, the Cholesky factors of all the row-major matrices in a
+// flattened batch, whose lower triangles hold the input and whose strictly
+// upper triangles are zero. Each matrix is factored by a single thread, so a
+// large batch of small matrices takes one kernel launch. Sets info(i) to zero
+// if matrix i was factored, or to the 1-based index of the first non-positive
+// pivot otherwise, like potrf. Only implemented for float and double, and
+// meant for matrices of at most kMaxBatchedCholeskySize rows.
+template <typename Device, typename Scalar>
+struct BatchedCholeskyFunctor {
+  void operator()(const Device& d, typename TTypes<Scalar, 3>::Tensor matrices,
+                  int* dev_lapack_info);
+};
 }  // namespace functor
 
 }  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include <complex>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 namespace functor {
@@ -46,6 +47,61 @@ template struct AdjointBatchFunctor<GPUDevice, double>;
 template struct AdjointBatchFunctor<GPUDevice, std::complex<float>>;
 template struct AdjointBatchFunctor<GPUDevice, std::complex<double>>;
 
+// Factors each n x n matrix of the batch with the Cholesky-Crout algorithm,
+// one column at a time. The matrices are small enough for their rows to stay
+// in the L1 cache between columns, so the work per thread is cheap compared
+// to launching one cuSolverDN kernel per matrix.
+template <typename Scalar>
+__global__ void BatchedCholeskyKernel(int batch_size, int n, Scalar* matrices,
+                                      int* info) {
+  CUDA_1D_KERNEL_LOOP(batch, batch_size) {
+    Scalar* a = matrices + static_cast<int64>(batch) * n * n;
+    int status = 0;
+    for (int j = 0; j < n; ++j) {
+      Scalar* row_j = a + j * n;
+      Scalar diag = row_j[j];
+      for (int k = 0; k < j; ++k) {
+        diag -= row_j[k] * row_j[k];
+      }
+      // The negated comparison also stops at NaNs.
+      if (!(diag > Scalar(0))) {
+        status = j + 1;
+        break;
+      }
+      diag = sqrt(diag);
+      row_j[j] = diag;
+      const Scalar inv_diag = Scalar(1) / diag;
+      for (int i = j + 1; i < n; ++i) {
+        Scalar* row_i = a + i * n;
+        Scalar sum = row_i[j];
+        for (int k = 0; k < j; ++k) {
+          sum -= row_i[k] * row_j[k];
+        }
+        row_i[j] = sum * inv_diag;
+      }
+    }
+    info[batch] = status;
+  }
+}
+
+template <typename Scalar>
+struct BatchedCholeskyFunctor<GPUDevice, Scalar> {
+  void operator()(const GPUDevice& d,
+                  typename TTypes<Scalar, 3>::Tensor matrices,
+                  int* dev_lapack_info) {
+    const int batch_size = matrices.dimension(0);
+    if (batch_size == 0) return;
+    CudaLaunchConfig config = GetCudaLaunchConfig(batch_size, d);
+    BatchedCholeskyKernel<
+        Scalar><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        config.virtual_thread_count, matrices.dimension(1), matrices.data(),
+        dev_lapack_info);
+  }
+};
+
+template struct BatchedCholeskyFunctor<GPUDevice, float>;
+template struct BatchedCholeskyFunctor<GPUDevice, double>;
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -23,6 +23,29 @@ namespace tensorflow {
 
 class ResourceMgr;
 
+// Interface for saving the state of an iterator. Keys are arbitrary
+// strings; by convention an iterator writes its keys below the prefix
+// passed to `IteratorBase::Save()`.
+class IteratorStateWriter {
+ public:
+  virtual ~IteratorStateWriter() {}
+
+  virtual Status WriteScalar(StringPiece key, int64 val) = 0;
+  virtual Status WriteScalar(StringPiece key, const string& val) = 0;
+  virtual Status WriteTensor(StringPiece key, const Tensor& val) = 0;
+};
+
+// Interface for reading state written by an `IteratorStateWriter`.
+class IteratorStateReader {
+ public:
+  virtual ~IteratorStateReader() {}
+
+  virtual Status ReadScalar(StringPiece key, int64* val) = 0;
+  virtual Status ReadScalar(StringPiece key, string* val) = 0;
+  virtual Status ReadTensor(StringPiece key, Tensor* val) = 0;
+  virtual bool Contains(StringPiece key) = 0;
+};
+
 // A cut-down version of OpKernelContext for running computations in
 // iterators. Note that we cannot simply use OpKernelContext here
 // because we might run computation in an iterator whose lifetime is
@@ -108,6 +131,27 @@ class IteratorBase {
   // (and possibly partially defined) shapes of each tuple component
   // in the outputs of this iterator.
   virtual const std::vector<PartialTensorShape>& output_shapes() const = 0;
+
+  // Saves the current position of this iterator to `writer`, using keys
+  // that start with `prefix`. Iterators that wrap an input iterator
+  // save it with the prefix `strings::StrCat(prefix, "/input")`.
+  //
+  // This method is thread-safe, but must not run concurrently with
+  // `GetNext()` if the saved state is to be consistent.
+  virtual Status Save(const string& prefix, IteratorStateWriter* writer) {
+    return errors::Unimplemented(
+        "Saving the state of this iterator is not supported.");
+  }
+
+  // Restores the position saved by `Save()` with the same `prefix`,
+  // replacing the current position of this iterator. The iterator must
+  // have been created from a dataset with the same definition as the one
+  // whose iterator was saved.
+  virtual Status Restore(IteratorContext* ctx, const string& prefix,
+                         IteratorStateReader* reader) {
+    return errors::Unimplemented(
+        "Restoring the state of this iterator is not supported.");
+  }
 };
 
 // Represents a (potentially infinite) range of outputs, where each
@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -38,6 +40,13 @@ class DecodeCSVOp : public OpKernel {
                 errors::InvalidArgument("field_delim should be only 1 char"));
 
     delim_ = delim[0];
+
+    // The characters that end or invalidate the body of an unquoted field.
+    for (bool& special : is_special_) special = false;
+    is_special_[static_cast<uint8>(delim_)] = true;
+    is_special_[static_cast<uint8>('\n')] = true;
+    is_special_[static_cast<uint8>('\r')] = true;
+    if (use_quote_delim_) is_special_[static_cast<uint8>('"')] = true;
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -60,181 +69,228 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
+    if (records_size == 0) return;
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64>()(i) = value;
-            }
-            break;
+    // Records are parsed independently, so they are sharded across the
+    // intra-op threads.  The error reported is that of the first bad record,
+    // as if they had been parsed in order.
+    mutex mu;
+    int64 first_error_record = records_size;
+    Status first_error;
+    auto parse_records = [&](int64 start, int64 limit) {
+      std::vector<Field> fields;
+      string unescaped;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseRecord(record_defaults, outputs, records_t(i), i,
+                               &fields, &unescaped);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_record) {
+            first_error_record = i;
+            first_error = s;
           }
-          case DT_FLOAT: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
-          }
-          case DT_STRING: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
-            }
-            break;
-          }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
+    };
+
+    // Parsing costs roughly a few tens of cycles per byte of input.
+    static const int64 kCostPerByte = 20;
+    int64 total_bytes = 0;
+    for (int64 i = 0; i < records_size; ++i) {
+      total_bytes += records_t(i).size();
     }
+    const int64 cost_per_record =
+        kCostPerByte * (total_bytes / records_size + 1) +
+        kCostPerByte * out_type_.size();
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, records_size,
+          cost_per_record, parse_records);
+    OP_REQUIRES_OK(ctx, first_error);
   }
 
  private:
+  // A field of a record, viewed in place.  Quoted fields have their quotes
+  // removed; if a quoted field contains escaped quotes ("") they are only
+  // unescaped when the field is copied to a string output.
+  struct Field {
+    StringPiece value;
+    bool has_escaped_quotes;
+  };
+
   std::vector<DataType> out_type_;
   char delim_;
   bool use_quote_delim_;
+  bool is_special_[256];
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+  // Parses record i into the i-th element of every output. "fields" and
+  // "unescaped" are scratch space reused across records.
+  Status ParseRecord(const OpInputList& record_defaults,
+                     const std::vector<Tensor*>& outputs, StringPiece record,
+                     int64 i, std::vector<Field>* fields, string* unescaped) {
+    fields->clear();
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const Field& field = (*fields)[f];
+      const DataType& dtype = out_type_[f];
 
-        bool quoted = false;
-        if (use_quote_delim_ && input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+      // If this field is empty, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (field.value.empty()) {
+        if (record_defaults[f].NumElements() != 1) {
+          return errors::InvalidArgument(
+              "Field ", f, " is required but missing in record ", i, "!");
+        }
+        switch (dtype) {
+          case DT_INT32:
+            outputs[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
+            break;
+          case DT_INT64:
+            outputs[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
+            break;
+          case DT_FLOAT:
+            outputs[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
+            break;
+          case DT_STRING:
+            outputs[f]->flat<string>()(i) =
+                record_defaults[f].flat<string>()(0);
+            break;
+          default:
+            return errors::InvalidArgument("csv: data type ", dtype,
+                                           " not supported in field ", f);
         }
+        continue;
+      }
 
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
-            current_idx++;
+      switch (dtype) {
+        case DT_INT32: {
+          int32 value;
+          if (!strings::safe_strto32(field.value, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int32: ",
+                                           Unescape(field, unescaped));
           }
-
-          // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
-            }
+          outputs[f]->flat<int32>()(i) = value;
+          break;
+        }
+        case DT_INT64: {
+          int64 value;
+          if (!strings::safe_strto64(field.value, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int64: ",
+                                           Unescape(field, unescaped));
+          }
+          outputs[f]->flat<int64>()(i) = value;
+          break;
+        }
+        case DT_FLOAT: {
+          float value;
+          if (!strings::safe_strtof(field.value, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid float: ",
+                                           Unescape(field, unescaped));
+          }
+          outputs[f]->flat<float>()(i) = value;
+          break;
+        }
+        case DT_STRING: {
+          if (field.has_escaped_quotes) {
+            Unescape(field, &outputs[f]->flat<string>()(i));
+          } else {
+            outputs[f]->flat<string>()(i).assign(field.value.data(),
+                                                 field.value.size());
           }
+          break;
+        }
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
+      }
+    }
+    return Status::OK();
+  }
 
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+  // Stores the value of "field" in *out, with its escaped quotes unescaped.
+  // Returns *out.
+  static const string& Unescape(const Field& field, string* out) {
+    out->clear();
+    const StringPiece value = field.value;
+    for (size_t j = 0; j < value.size(); ++j) {
+      out->push_back(value[j]);
+      if (value[j] == '"' && field.has_escaped_quotes) ++j;
+    }
+    return *out;
+  }
+
+  Status ExtractFields(StringPiece input, std::vector<Field>* result) {
+    if (input.empty()) return Status::OK();
+    const char* const end = input.data() + input.size();
+    const char* p = input.data();
+    while (p < end) {
+      if (*p == '\n' || *p == '\r') {
+        p++;
+        continue;
+      }
 
-          current_idx += 2;
+      if (!use_quote_delim_ || *p != '"') {
+        // The body of an unquoted field runs up to the next delimiter, and
+        // may not contain quotes or CRLFs.
+        const char* field_end = p;
+        while (field_end < end &&
+               !is_special_[static_cast<uint8>(*field_end)]) {
+          field_end++;
         }
+        if (field_end < end && *field_end != delim_) {
+          return errors::InvalidArgument(
+              "Unquoted fields cannot have quotes/CRLFs inside");
+        }
+        result->push_back({StringPiece(p, field_end - p), false});
 
-        result->push_back(field);
+        // Go to next field or the end
+        p = field_end + 1;
+      } else {
+        // Quoted field needs to be ended with '"' and delim or end. Quotes
+        // inside it are escaped by another quote.
+        const char* const field_begin = ++p;
+        bool has_escaped_quotes = false;
+        while (true) {
+          const char* quote =
+              static_cast<const char*>(memchr(p, '"', end - p));
+          if (quote == nullptr) {
+            return errors::InvalidArgument(
+                "Quoted field has to end with quote followed by delim or end");
+          }
+          if (quote + 1 == end || quote[1] == delim_) {
+            result->push_back(
+                {StringPiece(field_begin, quote - field_begin),
+                 has_escaped_quotes});
+            p = quote + 2;
+            break;
+          }
+          if (quote[1] != '"') {
+            return errors::InvalidArgument(
+                "Quote inside a string has to be escaped by another quote");
+          }
+          has_escaped_quotes = true;
+          p = quote + 2;
+        }
       }
-
-      // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
     }
+
+    // Check if the last field is missing
+    if (end[-1] == delim_) result->push_back({StringPiece(), false});
+    return Status::OK();
   }
 };
 
@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+// Builds a graph that decodes "batch_size" csv records of "num_columns"
+// columns of type "dtype".  Every tenth field is empty and takes its default.
+static Graph* DecodeCSV(int batch_size, int num_columns, DataType dtype) {
+  Graph* g = new Graph(OpRegistry::Global());
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+
+  Tensor records(DT_STRING, TensorShape({batch_size}));
+  auto records_t = records.flat<string>();
+  for (int i = 0; i < batch_size; ++i) {
+    string& record = records_t(i);
+    for (int j = 0; j < num_columns; ++j) {
+      if (j > 0) record += ',';
+      if (rnd.Uniform(10) == 0) continue;
+      switch (dtype) {
+        case DT_INT64:
+          strings::StrAppend(&record, rnd.Uniform64(1LL << 40));
+          break;
+        case DT_FLOAT:
+          strings::StrAppend(&record, rnd.Uniform(100000), ".",
+                             rnd.Uniform(1000));
+          break;
+        default:
+          strings::StrAppend(&record, "feature_", rnd.Uniform(1000));
+          break;
+      }
+    }
+  }
+
+  std::vector<NodeBuilder::NodeOut> record_defaults;
+  for (int j = 0; j < num_columns; ++j) {
+    Tensor record_default(dtype, TensorShape({1}));
+    switch (dtype) {
+      case DT_INT64:
+        record_default.flat<int64>()(0) = 0;
+        break;
+      case DT_FLOAT:
+        record_default.flat<float>()(0) = 0;
+        break;
+      default:
+        record_default.flat<string>()(0) = "";
+        break;
+    }
+    record_defaults.emplace_back(test::graph::Constant(g, record_default));
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(NodeBuilder(g->NewName("n"), "DecodeCSV")
+                   .Input(test::graph::Constant(g, records))
+                   .Input(record_defaults)
+                   .Finalize(g, &ret));
+  return g;
+}
+
+// B == batch_size, C == num_columns.
+#define BM_DecodeCSV(TYPE, B, C)                                              \
+  static void BM_DecodeCSV##_##TYPE##_##B##_##C(int iters) {                  \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * C);               \
+    test::Benchmark("cpu", DecodeCSV(B, C, DT_##TYPE)).Run(iters);            \
+  }                                                                           \
+  BENCHMARK(BM_DecodeCSV##_##TYPE##_##B##_##C);
+
+#define BM_AllDecodeCSV(TYPE)     \
+  BM_DecodeCSV(TYPE, 1, 400);     \
+  BM_DecodeCSV(TYPE, 128, 10);    \
+  BM_DecodeCSV(TYPE, 128, 400);   \
+  BM_DecodeCSV(TYPE, 1024, 10);   \
+  BM_DecodeCSV(TYPE, 1024, 400);
+
+BM_AllDecodeCSV(FLOAT);
+BM_AllDecodeCSV(INT64);
+BM_AllDecodeCSV(STRING);
+
+}  // namespace tensorflow
@@ -70,6 +70,9 @@ class DecodeImageOp : public OpKernel {
     // Determine which op we are: jpeg, png, gif, or any
     if (type_string() == "DecodeJpeg") {
       format_ = kJpgFormat;
+    } else if (type_string() == "DecodeAndCropJpeg") {
+      format_ = kJpgFormat;
+      flags_.crop = true;
     } else if (type_string() == "DecodePng") {
       format_ = kPngFormat;
     } else if (type_string() == "DecodeGif") {
@@ -163,6 +166,13 @@ class DecodeImageOp : public OpKernel {
                 errors::InvalidArgument(FileFormatString(magic, input),
                                         " does not support uint16 output"));
 
+    // DecodeAndCropJpeg only accepts jpeg, since the crop is fused into the
+    // jpeg decoder.
+    OP_REQUIRES(context, !flags_.crop || magic == kJpgFormat,
+                errors::InvalidArgument("Expected JPEG for DecodeAndCropJpeg, "
+                                        "got ",
+                                        FileFormatString(magic, input)));
+
     switch (magic) {
       case kJpgFormat:
         DecodeJpeg(context, input);
@@ -184,12 +194,31 @@ class DecodeImageOp : public OpKernel {
                 errors::InvalidArgument(
                     "channels must be 0, 1, or 3 for JPEG, got ", channels_));
 
+    jpeg::UncompressFlags flags = flags_;
+    if (flags.crop) {
+      // Read the crop window, given as [crop_y, crop_x, crop_height,
+      // crop_width] in the coordinates of the (possibly downscaled) output.
+      const Tensor& crop_window = context->input(1);
+      OP_REQUIRES(context, crop_window.dims() == 1,
+                  errors::InvalidArgument("crop_window must be 1-D, got shape ",
+                                          crop_window.shape().DebugString()));
+      OP_REQUIRES(context, crop_window.dim_size(0) == 4,
+                  errors::InvalidArgument(
+                      "crop_window must have four elements, got shape ",
+                      crop_window.shape().DebugString()));
+      auto crop_window_vec = crop_window.vec<int32>();
+      flags.crop_y = crop_window_vec(0);
+      flags.crop_x = crop_window_vec(1);
+      flags.crop_height = crop_window_vec(2);
+      flags.crop_width = crop_window_vec(3);
+    }
+
     // Decode jpeg, allocating tensor once the size is known
     Tensor* output = nullptr;
     OP_REQUIRES(
         context,
         jpeg::Uncompress(
-            input.data(), input.size(), flags_, nullptr /* nwarn */,
+            input.data(), input.size(), flags, nullptr /* nwarn */,
             [=, &output](int width, int height, int channels) -> uint8* {
               Status status(context->allocate_output(
                   0,
@@ -204,7 +233,9 @@ class DecodeImageOp : public OpKernel {
               }
               return output->flat<uint8>().data();
             }),
-        errors::InvalidArgument("Invalid JPEG data, size ", input.size()));
+        errors::InvalidArgument(flags.crop ? "Invalid JPEG data or crop window"
+                                           : "Invalid JPEG data",
+                                ", size ", input.size()));
   }
 
   void DecodePng(OpKernelContext* context, StringPiece input) {
@@ -308,6 +339,8 @@ class DecodeImageOp : public OpKernel {
 };
 
 REGISTER_KERNEL_BUILDER(Name("DecodeJpeg").Device(DEVICE_CPU), DecodeImageOp);
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropJpeg").Device(DEVICE_CPU),
+                        DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodePng").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeGif").Device(DEVICE_CPU), DecodeImageOp);
 
@@ -21,7 +21,9 @@ limitations under the License.
 #include <stdlib.h>
 
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -90,6 +92,39 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
   return default_val;
 }
 
+// Returns the Winograd output tile size with the lowest deep convolution
+// cost for 3x3 filters, and stores that cost in '*cost'.
+// Output tile sizes are limited by the environment variable
+// TF_DEEP_CONV2D_MAX_OUTPUT_TILE_SIZE (default 4): F(6x6,3x3) has the lowest
+// arithmetic cost, but its transforms lose more precision in float.
+static int64 SelectOutputTileSize(int in_depth, int out_depth, int out_rows,
+                                  int out_cols, int64* cost) {
+  int64 max_out_tile_size = 4;
+  Status status = ReadInt64FromEnvVar("TF_DEEP_CONV2D_MAX_OUTPUT_TILE_SIZE",
+                                      max_out_tile_size, &max_out_tile_size);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+
+  int64 best_out_tile_size = 2;
+  *cost = GetDeepConvCost(4, 4, 2, 2, in_depth, out_depth, out_rows, out_cols);
+  for (int64 out_tile_size = 4; out_tile_size <= max_out_tile_size;
+       out_tile_size += 2) {
+    if (!WinogradTransform<float>::IsSupportedOutputTileSize(out_tile_size)) {
+      break;
+    }
+    const int64 tile_size = out_tile_size + 2;
+    const int64 tile_cost =
+        GetDeepConvCost(tile_size, tile_size, out_tile_size, out_tile_size,
+                        in_depth, out_depth, out_rows, out_cols);
+    if (tile_cost < *cost) {
+      *cost = tile_cost;
+      best_out_tile_size = out_tile_size;
+    }
+  }
+  return best_out_tile_size;
+}
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
 // TODO(andydavis) Add support for other filter sizes and strides.
@@ -104,21 +139,21 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
     return false;
   }
 
-  // Check if deep convolution is enabled by environment variable.
+  // Check if deep convolution is disabled by environment variable.
   // NOTE: IF this environment variable name changes, update conv_ops_test.py.
-  if (!ReadBoolFromEnvVar("TF_USE_DEEP_CONV2D", false)) {
+  if (!ReadBoolFromEnvVar("TF_USE_DEEP_CONV2D", true)) {
     return false;
   }
 
   // Check if flop cost of deep convolution is less than direct convolution.
-  WinogradTransform<float> t;
-  const int64 deep_conv_cost = GetDeepConvCost(
-      t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
-      t.output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+  int64 deep_conv_cost = 0;
+  const int64 out_tile_size = SelectOutputTileSize(
+      in_depth, out_depth, out_rows, out_cols, &deep_conv_cost);
   const int64 direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
 
   VLOG(2) << "CanUseDeepConv2D"
+          << " out_tile_size: " << out_tile_size
           << " deep_conv_cost: " << deep_conv_cost
           << " direct_conv_cost: " << direct_conv_cost
           << " deep_direct_ratio: " << (static_cast<float>(deep_conv_cost) /
@@ -127,6 +162,44 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   return deep_conv_cost < direct_conv_cost;
 }
 
+int64 GetDeepConv2DOutputTileSize(const Conv2DArgs& args) {
+  // Filters larger than 3x3 are sharded into 3x3 filters, which is only
+  // implemented for F(2x2,3x3).
+  if (args.filter_rows != 3 || args.filter_cols != 3) {
+    return 2;
+  }
+  int64 cost = 0;
+  return SelectOutputTileSize(args.in_depth, args.out_depth, args.out_rows,
+                              args.out_cols, &cost);
+}
+
+bool DeepConv2DFilterCache::Lookup(const Tensor& filter,
+                                   const int64 out_tile_size,
+                                   DeepConv2DPackedFilters* packed) {
+  Tensor cached_filter;
+  {
+    mutex_lock l(mu_);
+    if (packed_.out_tile_size != out_tile_size) {
+      return false;
+    }
+    // 'filter_' is never modified in place, so its values can be compared
+    // without holding the lock.
+    cached_filter = filter_;
+    *packed = packed_;
+  }
+  return cached_filter.dtype() == filter.dtype() &&
+         cached_filter.IsSameSize(filter) &&
+         cached_filter.tensor_data() == filter.tensor_data();
+}
+
+void DeepConv2DFilterCache::Insert(const Tensor& filter,
+                                   const DeepConv2DPackedFilters& packed) {
+  Tensor filter_copy = tensor::DeepCopy(filter);
+  mutex_lock l(mu_);
+  filter_ = filter_copy;
+  packed_ = packed;
+}
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 // Copies data from 'filter_in' to 'filter_buf' along 'in_depth' dimension.
@@ -487,11 +560,17 @@ struct TransformFilters {
   }
 };
 
-// Packs transformed filters stored in 'lhs_input' into 'lhs_block' in a
-// gemm-kernel friendly data layout.
+// Depth (i.e. 'in_depth') block size of the element-wise products, chosen so
+// that a gemm-kernel panel of filters and the packed input tiles of one depth
+// block stay in cache while the output is accumulated across depth blocks.
+static const int64 kGemmDepthBlockSize = 256;
+
+// Packs 'depth' columns of the transformed filters stored in 'lhs_input'
+// (with row stride 'depth_stride') into 'lhs_block' in a gemm-kernel friendly
+// data layout.
 //
 // Data layout for 'lhs_block':
-//   [out_depth, shard_rows, shard_cols, in_depth].
+//   [out_depth, shard_rows, shard_cols, depth].
 
 template <typename T>
 class GemmFilterPacker {
@@ -503,12 +582,12 @@ class GemmFilterPacker {
                                  Traits::LhsProgress, Eigen::RowMajor>
       pack_lhs;
 
-  GemmFilterPacker(const int64 rows, const int64 depth, const T* lhs_input,
-                   T* lhs_block)
+  GemmFilterPacker(const int64 rows, const int64 depth,
+                   const int64 depth_stride, const T* lhs_input, T* lhs_block)
       : rows_(rows),
         depth_(depth),
         lhs_block_(lhs_block),
-        lhs_mapper_(lhs_input, depth_) {}
+        lhs_mapper_(lhs_input, depth_stride) {}
 
   void Run() { pack_lhs(lhs_block_, lhs_mapper_, depth_, rows_); }
 
@@ -521,6 +600,8 @@ class GemmFilterPacker {
 
 // Packs transformed filter stored in 'filter_transform_data' into
 // 'packed_filters' to be used by GemmState.
+// Each packed filter stores its 'in_depth' dimension as consecutive blocks of
+// (at most) kGemmDepthBlockSize, each packed separately by GemmFilterPacker.
 template <typename T>
 struct PackFilters {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args,
@@ -543,11 +624,15 @@ struct PackFilters {
                                                  filter_shards_col, in_depth}),
                                     &(*packed_filters)[i]));
         T* packed_filter = (*packed_filters)[i].template flat<T>().data();
-        // Pack filters.
-        GemmFilterPacker<T> packer(
-            num_filters, in_depth,
-            filter_transform_data + i * filter_coord_stride, packed_filter);
-        packer.Run();
+        // Pack filters, one depth block at a time.
+        for (int64 d = 0; d < in_depth; d += kGemmDepthBlockSize) {
+          const int64 depth = std::min(kGemmDepthBlockSize, in_depth - d);
+          GemmFilterPacker<T> packer(
+              num_filters, depth, in_depth,
+              filter_transform_data + i * filter_coord_stride + d,
+              packed_filter + num_filters * d);
+          packer.Run();
+        }
       }
     };
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
@@ -557,14 +642,18 @@ struct PackFilters {
 };
 
 // Computes the product of filters stored in 'lhs_block' and input tiles
-// stored in 'rhs_block', storing output in 'out_buffer'.
+// stored in 'rhs_block' for one depth block, accumulating the output in
+// 'out_buffer'.
 //
 // Data layout for 'lhs_block':
-//   [out_depth, shard_rows, shard_cols, in_depth].
+//   [out_depth, shard_rows, shard_cols, depth].
 //
-// Data layout for 'rhs_block':
+// Data layout for 'rhs_input' (with stride 'depth_stride'):
 //   [num_tiles, in_depth]
 //
+// Data layout for 'rhs_block':
+//   [num_tiles, depth]
+//
 // Data layout for 'out_buffer':
 //   [num_tiles, out_depth, shard_rows, shard_cols]
 
@@ -585,22 +674,21 @@ class GemmState {
       gebp;
 
   GemmState(const int64 rows, const int64 cols, const int64 depth,
-            const int64 out_buffer_size, const T* lhs_block, const T* rhs_input,
+            const int64 depth_stride, const T* lhs_block, const T* rhs_input,
             T* rhs_block, T* out_buffer)
       : rows_(rows),
         cols_(cols),
         depth_(depth),
-        out_buffer_size_(out_buffer_size),
         lhs_block_(lhs_block),
         rhs_block_(rhs_block),
         out_buffer_(out_buffer),
-        rhs_mapper_(rhs_input, depth_),
+        rhs_mapper_(rhs_input, depth_stride),
         out_mapper_(out_buffer, rows_) {}
 
   void PackRhs() { pack_rhs(rhs_block_, rhs_mapper_, depth_, cols_); }
 
+  // Adds the product to 'out_buffer' (which must be initialized by caller).
   void Compute() {
-    memset(out_buffer_, 0, sizeof(T) * out_buffer_size_);
     gebp(out_mapper_, lhs_block_, rhs_block_, rows_, depth_, cols_, 1.0);
   }
 
@@ -608,7 +696,6 @@ class GemmState {
   const int64 rows_;
   const int64 cols_;
   const int64 depth_;
-  const int64 out_buffer_size_;
   const T* lhs_block_;
   T* rhs_block_;
   T* out_buffer_;
@@ -895,14 +982,20 @@ struct ComputeConv2D {
     const int64 gemm_out_buf_bytes = gemm_out_buf_size * sizeof(T);
 
     for (int64 i = 0; i < cs.tile_spatial_size; ++i) {
-      GemmState<T> gemm(num_filters, num_tiles, in_depth, gemm_out_buf_size,
-                        packed_filters[i].template flat<T>().data(),
-                        cs.buffer2 + i * tile_coord_stride,
-                        cs.packed_tile_buffer, cs.gemm_output_buffer);
-      // Pack tile buffer.
-      gemm.PackRhs();
-      // Compute product.
-      gemm.Compute();
+      const T* packed_filter = packed_filters[i].template flat<T>().data();
+      const T* tiles = cs.buffer2 + i * tile_coord_stride;
+      memset(cs.gemm_output_buffer, 0, gemm_out_buf_bytes);
+      // Accumulate products over depth blocks.
+      for (int64 d = 0; d < in_depth; d += kGemmDepthBlockSize) {
+        const int64 depth = std::min(kGemmDepthBlockSize, in_depth - d);
+        GemmState<T> gemm(num_filters, num_tiles, depth, in_depth,
+                          packed_filter + num_filters * d, tiles + d,
+                          cs.packed_tile_buffer, cs.gemm_output_buffer);
+        // Pack tile buffer.
+        gemm.PackRhs();
+        // Compute product.
+        gemm.Compute();
+      }
       // Copy to larger output buffer without alignment requirements.
       memcpy(cs.buffer1 + i * gemm_out_buf_size, cs.gemm_output_buffer,
              gemm_out_buf_bytes);
@@ -919,11 +1012,13 @@ struct ComputeConv2D {
 namespace functor {
 
 // Conv2D operation specialized for deep convolutions (i.e. large
-// in_depth * out_depth).
+// in_depth * out_depth product).
 // Details:
-// *) Transforms and packs filters from 'filter' in parallel.
-// *) Computes Conv2D parallelized across 'batch' dimension.
-//   *) Each thread loops over images in its batch shard, copying 'num_tiles'
+// *) Selects the Winograd output tile size with the lowest estimated cost.
+// *) Transforms and packs filters from 'filter' in parallel (PrepareFilters),
+//    which callers can skip for filters they have already prepared.
+// *) Computes Conv2D parallelized across 'batch' and rows of output tiles.
+//   *) Each thread loops over the rows in its shard, copying 'num_tiles'
 //      input tiles into a local buffer, and computing the Conv2D output of
 //      these tiles by all filters.
 
@@ -934,23 +1029,19 @@ namespace functor {
 // TODO(andydavis) Improve the performance of sharded filters.
 template <typename T>
 struct DeepConv2D<CPUDevice, T> {
-  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+  void PrepareFilters(OpKernelContext* ctx, const Conv2DArgs& args,
+                      const T* filter, DeepConv2DPackedFilters* packed) {
+    const int64 out_tile_size = GetDeepConv2DOutputTileSize(args);
+    WinogradTransform<T> transform(out_tile_size);
 
     const int64 in_depth = args.in_depth;
     const int64 out_depth = args.out_depth;
 
-    const int64 tile_rows = transform->input_shape().rows;
-    const int64 tile_cols = transform->input_shape().cols;
+    const int64 tile_rows = transform.input_shape().rows;
+    const int64 tile_cols = transform.input_shape().cols;
     const int64 tile_spatial_size = tile_rows * tile_cols;
 
-    const int64 out_tile_rows = transform->output_shape().rows;
-    const int64 out_tile_cols = transform->output_shape().cols;
-    const int64 out_tile_spatial_size = out_tile_rows * out_tile_cols;
-
-    const int64 base_filter_rows = transform->filter_shape().rows;
+    const int64 base_filter_rows = transform.filter_shape().rows;
 
     const int64 filter_residual_row =
         std::max(0LL, args.filter_rows - base_filter_rows);
@@ -971,13 +1062,46 @@ struct DeepConv2D<CPUDevice, T> {
     T* filter_transform_data = filter_transform.template flat<T>().data();
 
     // Transform filters.
-    TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
+    TransformFilters<T>()(ctx, args, &transform, filter_shards_row,
                           filter_shards_col, filter, filter_transform_data);
 
     // Pack filters.
-    std::vector<Tensor> packed_filters(tile_spatial_size);
+    packed->out_tile_size = out_tile_size;
+    packed->filter_shards_row = filter_shards_row;
+    packed->filter_shards_col = filter_shards_col;
+    packed->tiles.clear();
+    packed->tiles.resize(tile_spatial_size);
     PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
-                     filter_shards_col, filter_transform_data, &packed_filters);
+                     filter_shards_col, filter_transform_data, &packed->tiles);
+  }
+
+  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
+                  const T* filter, T* output) {
+    DeepConv2DPackedFilters packed;
+    PrepareFilters(ctx, args, filter, &packed);
+    if (!ctx->status().ok()) return;
+    (*this)(ctx, args, input, packed, output);
+  }
+
+  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
+                  const DeepConv2DPackedFilters& packed, T* output) {
+    std::unique_ptr<DeepConv2DTransform<T>> transform(
+        new WinogradTransform<T>(packed.out_tile_size));
+    const std::vector<Tensor>& packed_filters = packed.tiles;
+
+    const int64 in_depth = args.in_depth;
+    const int64 out_depth = args.out_depth;
+
+    const int64 tile_rows = transform->input_shape().rows;
+    const int64 tile_cols = transform->input_shape().cols;
+    const int64 tile_spatial_size = tile_rows * tile_cols;
+
+    const int64 out_tile_rows = transform->output_shape().rows;
+    const int64 out_tile_cols = transform->output_shape().cols;
+    const int64 out_tile_spatial_size = out_tile_rows * out_tile_cols;
+
+    const int64 filter_shards_row = packed.filter_shards_row;
+    const int64 filter_shards_col = packed.filter_shards_col;
 
     // Allocate buffer for tile transform matrix.
     Tensor tile_transform_matrix_tensor;
@@ -1001,20 +1125,27 @@ struct DeepConv2D<CPUDevice, T> {
     transform->GetOutputTransformMatrix(
         out_tile_spatial_size, tile_spatial_size, output_transform_matrix);
 
-    auto shard = [&ctx, &args, &transform, &packed_filters, &in_depth,
-                  out_depth, tile_rows, tile_cols, out_tile_rows, out_tile_cols,
-                  filter_shards_row, filter_shards_col, tile_spatial_size,
-                  &input, &tile_transform_matrix, &output_transform_matrix,
-                  &output](int64 batch_start, int64 batch_limit) {
-      const int64 row_tiles =
-          (args.out_rows + out_tile_rows - 1) / out_tile_rows +
-          filter_shards_row - 1;
-      const int64 col_tiles =
-          (args.out_cols + out_tile_cols - 1) / out_tile_cols +
-          filter_shards_col - 1;
+    const int64 row_tiles =
+        (args.out_rows + out_tile_rows - 1) / out_tile_rows +
+        filter_shards_row - 1;
+    const int64 col_tiles =
+        (args.out_cols + out_tile_cols - 1) / out_tile_cols +
+        filter_shards_col - 1;
+
+    // Rows of output tiles write disjoint output rows, and so can be computed
+    // in parallel (which keeps all threads busy for small batch sizes). This
+    // is not the case for sharded filters, where the outputs of filter shards
+    // are accumulated across neighboring rows of tiles.
+    const int64 filter_shard_size = filter_shards_row * filter_shards_col;
+    const int64 row_shards = filter_shard_size == 1 ? row_tiles : 1;
 
+    auto shard = [&ctx, &args, &transform, &packed_filters, &in_depth,
+                  out_depth, out_tile_rows, out_tile_cols, filter_shards_row,
+                  filter_shards_col, filter_shard_size, tile_spatial_size,
+                  row_tiles, col_tiles, row_shards, &input,
+                  &tile_transform_matrix, &output_transform_matrix,
+                  &output](int64 start, int64 limit) {
       // Calculate number of tiles to process together.
-      const int64 filter_shard_size = filter_shards_row * filter_shards_col;
       const int64 out_tile_spatial_size = out_tile_rows * out_tile_cols;
 
       // Cache budget (based on L2 cache size = 256KB).
@@ -1041,7 +1172,8 @@ struct DeepConv2D<CPUDevice, T> {
       const int64 buffer2_per_tile_size =
           std::max(tile_spatial_size * in_depth,
                    out_tile_spatial_size * out_depth * filter_shard_size);
-      const int64 packed_tile_per_tile_size = in_depth;
+      const int64 packed_tile_per_tile_size =
+          std::min(in_depth, kGemmDepthBlockSize);
       const int64 gemm_out_per_tile_size = out_depth * filter_shard_size;
       const int64 total_per_tile_cost =
           buffer1_per_tile_size + buffer2_per_tile_size +
@@ -1082,12 +1214,15 @@ struct DeepConv2D<CPUDevice, T> {
                                              &buffer2_tensor));
       T* buffer2 = buffer2_tensor.template flat<T>().data();
 
-      // Allocate temporary buffer to store packed tiles for one coordinate.
-      // packed tile buffer: [num_tiles, in_depth].
+      // Allocate temporary buffer to store packed tiles for one coordinate
+      // and depth block.
+      // packed tile buffer: [num_tiles, min(in_depth, kGemmDepthBlockSize)].
       Tensor packed_tile_tensor;
-      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
-                                             TensorShape({num_tiles, in_depth}),
-                                             &packed_tile_tensor));
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(
+                   DataTypeToEnum<T>::value,
+                   TensorShape({num_tiles, packed_tile_per_tile_size}),
+                   &packed_tile_tensor));
       T* packed_tile_buffer = packed_tile_tensor.template flat<T>().data();
 
       // Allocate temporary buffer for gemm output.
@@ -1116,11 +1251,17 @@ struct DeepConv2D<CPUDevice, T> {
       const int64 tile_stride_rows = transform->output_shape().rows;
       const int64 tile_stride_cols = transform->output_shape().cols;
 
-      for (int64 b = batch_start; b < batch_limit; ++b) {
+      // Each unit of work is one row of tiles (all rows for sharded filters)
+      // of one image.
+      for (int64 u = start; u < limit; ++u) {
+        const int64 b = u / row_shards;
+        const int64 tile_r_start = row_shards == 1 ? 0 : u % row_shards;
+        const int64 tile_r_limit =
+            row_shards == 1 ? row_tiles : tile_r_start + 1;
         const int64 in_base = b * input_image_size;
         const int64 out_base = b * output_image_size;
 
-        for (int64 tile_r = 0; tile_r < row_tiles; ++tile_r) {
+        for (int64 tile_r = tile_r_start; tile_r < tile_r_limit; ++tile_r) {
           const int64 in_r = tile_r * tile_stride_rows - row_pad;
 
           // Process unrolled tiles.
@@ -1144,9 +1285,9 @@ struct DeepConv2D<CPUDevice, T> {
     };
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int64 shard_cost = args.out_rows * args.out_cols * args.out_depth *
-                             tile_spatial_size * args.in_depth;
-    Shard(worker_threads.num_threads, worker_threads.workers, args.batch,
-          shard_cost, shard);
+                             tile_spatial_size * args.in_depth / row_shards;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          args.batch * row_shards, shard_cost, shard);
   }
 };
 
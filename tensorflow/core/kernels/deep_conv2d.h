@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -101,11 +106,57 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols);
 
+// Returns the output tile size of the Winograd transform with the lowest
+// estimated cost for the convolution specified by 'args'.
+int64 GetDeepConv2DOutputTileSize(const Conv2DArgs& args);
+
+// Filters transformed and packed by DeepConv2D, which do not depend on the
+// input and can be reused by all DeepConv2D calls with the same filter values.
+struct DeepConv2DPackedFilters {
+  // Output tile size of the transform the filters were computed for.
+  int64 out_tile_size = 0;
+  // Number of filter shards along rows and cols (1 for 3x3 filters).
+  int64 filter_shards_row = 0;
+  int64 filter_shards_col = 0;
+  // Packed filters for each input tile coordinate, each of shape
+  //   [out_depth, filter_shards_row, filter_shards_col, in_depth].
+  std::vector<Tensor> tiles;
+};
+
+// Caches the packed filters of the last filter seen by a Conv2D kernel, so
+// that calls with unchanged filter values (e.g. constant filters in inference
+// graphs) skip the filter transform. The filter values are compared on every
+// lookup, so the cache is safe to use with filters that change between steps.
+class DeepConv2DFilterCache {
+ public:
+  // Returns true and sets '*packed' if the cached filters were computed from
+  // the values of 'filter' for 'out_tile_size', and returns false otherwise.
+  bool Lookup(const Tensor& filter, int64 out_tile_size,
+              DeepConv2DPackedFilters* packed);
+
+  // Replaces the cached entry with 'packed', computed from 'filter'.
+  void Insert(const Tensor& filter, const DeepConv2DPackedFilters& packed);
+
+ private:
+  mutex mu_;
+  Tensor filter_ GUARDED_BY(mu_);  // Deep copy of the cached filter values.
+  DeepConv2DPackedFilters packed_ GUARDED_BY(mu_);
+};
+
 namespace functor {
 
 // Calls DeepConv2D implementation (see deep_conv2d.cc for details).
 template <typename Device, typename T>
 struct DeepConv2D {
+  // Transforms and packs 'filter' for the convolution specified by 'args'.
+  void PrepareFilters(OpKernelContext* ctx, const Conv2DArgs& args,
+                      const T* filter, DeepConv2DPackedFilters* packed);
+
+  // Computes the convolution of 'input' with filters prepared by
+  // PrepareFilters().
+  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
+                  const DeepConv2DPackedFilters& packed, T* output);
+
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
                   const T* filter, T* output);
 };
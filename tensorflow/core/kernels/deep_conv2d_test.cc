@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/winograd_transform.h"
+
+#include <vector>
+
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -155,5 +158,65 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+// Computes the Winograd convolution of a single (m + 2) x (m + 2) input tile
+// with a 3x3 filter (i.e. C[Ad * Bg] using the transform matrices for output
+// tile size 'm'), and checks it against a direct 'VALID' convolution.
+static void TestWinogradTile(const int m) {
+  WinogradTransform<float> t(m);
+  const int tile_size = t.input_shape().rows * t.input_shape().cols;
+  const int filter_size = t.filter_shape().rows * t.filter_shape().cols;
+  const int out_size = t.output_shape().rows * t.output_shape().cols;
+  EXPECT_EQ(m + 2, t.input_shape().rows);
+  EXPECT_EQ(m, t.output_shape().rows);
+
+  std::vector<float> filter_transform(tile_size * filter_size);
+  std::vector<float> input_transform(tile_size * tile_size);
+  std::vector<float> output_transform(out_size * tile_size);
+  t.GetFilterTransformMatrix(tile_size, filter_size, filter_transform.data());
+  t.GetInputTransformMatrix(tile_size, tile_size, input_transform.data());
+  t.GetOutputTransformMatrix(out_size, tile_size, output_transform.data());
+
+  std::vector<float> d(tile_size);
+  std::vector<float> g(filter_size);
+  for (int i = 0; i < tile_size; ++i) d[i] = ((i * 7) % 11) / 11.0f - 0.5f;
+  for (int i = 0; i < filter_size; ++i) g[i] = ((i * 5) % 7) / 7.0f - 0.5f;
+
+  std::vector<float> product(tile_size);
+  for (int i = 0; i < tile_size; ++i) {
+    float ad = 0;
+    for (int j = 0; j < tile_size; ++j) {
+      ad += input_transform[i * tile_size + j] * d[j];
+    }
+    float bg = 0;
+    for (int j = 0; j < filter_size; ++j) {
+      bg += filter_transform[i * filter_size + j] * g[j];
+    }
+    product[i] = ad * bg;
+  }
+
+  const int tile_cols = m + 2;
+  for (int r = 0; r < m; ++r) {
+    for (int c = 0; c < m; ++c) {
+      float y = 0;
+      for (int j = 0; j < tile_size; ++j) {
+        y += output_transform[(r * m + c) * tile_size + j] * product[j];
+      }
+      float expected = 0;
+      for (int f_r = 0; f_r < 3; ++f_r) {
+        for (int f_c = 0; f_c < 3; ++f_c) {
+          expected += d[(r + f_r) * tile_cols + c + f_c] * g[f_r * 3 + f_c];
+        }
+      }
+      EXPECT_NEAR(expected, y, 1e-4) << "m=" << m << " r=" << r << " c=" << c;
+    }
+  }
+}
+
+TEST(DeepConv2DTransformTest, WinogradF2x2) { TestWinogradTile(2); }
+
+TEST(DeepConv2DTransformTest, WinogradF4x4) { TestWinogradTile(4); }
+
+TEST(DeepConv2DTransformTest, WinogradF6x6) { TestWinogradTile(6); }
+
 }  // namespace
 }  // namespace tensorflow
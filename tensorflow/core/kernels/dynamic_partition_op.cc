@@ -15,7 +15,9 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
 #include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -39,9 +42,17 @@ class DynamicPartitionOp_Shared : public OpKernel {
     //   in the graph?
   }
 
+  // Validates the inputs and allocates the outputs. The rows of data are
+  // split into blocks of *block_size rows, one per worker, and on return
+  // (*offsets)[b * num_partitions_ + p] is the row of outputs[p] where the
+  // rows of block b with partition p start. *partition_ids holds a copy of
+  // the validated partitions, so later passes don't read the input again.
   void ValidateAndAllocateOutputs(OpKernelContext* c, const Tensor** data,
                                   const Tensor** partitions,
-                                  OpOutputList* Tout) {
+                                  OpOutputList* Tout,
+                                  std::vector<int32>* partition_ids,
+                                  int64* block_size,
+                                  std::vector<int64>* offsets) {
     OP_REQUIRES_OK(c, c->input("data", data));
     OP_REQUIRES_OK(c, c->input("partitions", partitions));
     OP_REQUIRES(
@@ -52,18 +63,61 @@ class DynamicPartitionOp_Shared : public OpKernel {
             "got data.shape = ", (*data)->shape().DebugString(),
             ", partitions.shape = ", (*partitions)->shape().DebugString()));
 
-    // Count how many occurrences of each partition id we have in partitions
-    gtl::InlinedVector<int, 32> partition_count(num_partitions_);
     auto e_partitions = (*partitions)->flat<int32>();
     const int64 N = e_partitions.dimension(0);
-    for (int64 i = 0; i < N; i++) {
-      const int32 p = internal::SubtleMustCopy(e_partitions(i));
-      OP_REQUIRES(c, FastBoundsCheck(p, num_partitions_),
+    const int64 slice_size = N > 0 ? (*data)->NumElements() / N : 0;
+
+    // Only split the rows when each block has enough work to be worth
+    // scheduling on its own thread.
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    const int64 kMinElementsPerBlock = 16 << 10;
+    const int64 max_blocks =
+        N * std::max<int64>(slice_size, 1) / kMinElementsPerBlock;
+    const int64 target_blocks = std::max<int64>(
+        1, std::min<int64>(worker_threads->num_threads, max_blocks));
+    *block_size = std::max<int64>(1, (N + target_blocks - 1) / target_blocks);
+    const int64 num_blocks = (N + *block_size - 1) / *block_size;
+
+    // Count how many occurrences of each partition id we have in each block.
+    // The counts of block b go in row b + 1 of offsets, so that a prefix sum
+    // over the blocks turns them into the starting offsets, with the total
+    // count of each partition left in the last row.
+    partition_ids->resize(N);
+    offsets->assign((num_blocks + 1) * num_partitions_, 0);
+    std::vector<int64> bad_rows(num_blocks, -1);
+    auto count_blocks = [this, &e_partitions, N, block_size, partition_ids,
+                         offsets, &bad_rows](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; b++) {
+        int64* counts = offsets->data() + (b + 1) * num_partitions_;
+        const int64 end = std::min(N, (b + 1) * *block_size);
+        for (int64 i = b * *block_size; i < end; i++) {
+          const int32 p = internal::SubtleMustCopy(e_partitions(i));
+          if (!FastBoundsCheck(p, num_partitions_)) {
+            bad_rows[b] = i;
+            break;
+          }
+          (*partition_ids)[i] = p;
+          counts[p]++;
+        }
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          *block_size * 10, count_blocks);
+    for (int64 i : bad_rows) {
+      OP_REQUIRES(c, i < 0,
                   errors::InvalidArgument(
                       "partitions", SliceDebugString((*partitions)->shape(), i),
-                      " = ", p, " is not in [0, ", num_partitions_, ")"));
-      partition_count[p]++;
+                      " = ", e_partitions(i), " is not in [0, ",
+                      num_partitions_, ")"));
     }
+    for (int64 b = 1; b <= num_blocks; b++) {
+      for (int p = 0; p < num_partitions_; p++) {
+        (*offsets)[b * num_partitions_ + p] +=
+            (*offsets)[(b - 1) * num_partitions_ + p];
+      }
+    }
+    const int64* partition_count =
+        offsets->data() + num_blocks * num_partitions_;
 
     // Allocate output tensors of the right size
     OP_REQUIRES_OK(c, c->output_list("outputs", Tout));
@@ -91,68 +145,55 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
     const Tensor* data;
     const Tensor* partitions;
     OpOutputList outputs;
-    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs);
+    std::vector<int32> partition_ids;
+    int64 block_size;
+    std::vector<int64> offsets;
+    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs, &partition_ids,
+                               &block_size, &offsets);
     if (!c->status().ok()) return;
     if (num_partitions_ == 0 || data->NumElements() == 0) return;
 
-    auto e_partitions = partitions->flat<int32>();
-    const int64 N = e_partitions.dimension(0);
-    gtl::InlinedVector<int, 32> output_index(num_partitions_);
-
-    if (partitions->dims() == data->dims()) {
-      // Walk through data and copy the data to the appropriate output tensor
-      const auto data_flat = data->flat<T>();
-      std::vector<Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                                   Eigen::Aligned> > out_vec;
-      out_vec.reserve(num_partitions_);
-      for (int p = 0; p < num_partitions_; p++) {
-        out_vec.push_back(outputs[p]->vec<T>());
-      }
-      for (int64 i = 0; i < N; i++) {
-        const int32 p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i, "] is out of range"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_vec[p].size()),
-                    errors::InvalidArgument(
-                        "out_vec[", p, "] size: ", out_vec[p].size(),
-                        " is not LTE output_index[", p, "] : ", oi));
-        out_vec[p](oi) = data_flat(i);
-        output_index[p]++;
-      }
-    } else {
-      // If data has extra dimensions, use Eigen slices
-      std::vector<Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
-                                   Eigen::Aligned> > out_flat;
-      out_flat.reserve(num_partitions_);
-      for (int p = 0; p < num_partitions_; p++) {
-        out_flat.push_back(outputs[p]->flat_outer_dims<T>());
-      }
+    const int64 N = partition_ids.size();
+    const int64 slice_size = data->NumElements() / N;
+    const T* data_base = data->flat<T>().data();
+    gtl::InlinedVector<T*, 32> out_base(num_partitions_);
+    for (int p = 0; p < num_partitions_; p++) {
+      out_base[p] = outputs[p]->flat<T>().data();
+    }
 
-      // Walk through data and copy the data to the appropriate output tensor
-      const int64 slice_size = data->NumElements() / N;
-      const auto data_flat = data->shaped<T, 2>({N, slice_size});
-      Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
-      for (int64 i = 0; i < N; i++) {
-        // outputs[p][output_index[p]++] = data[i]
-        const int32 p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i,
-                                    "] has been asynchronously overwitten and "
-                                    "is no longer in range!"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_flat[p].dimension(0)),
-                    errors::InvalidArgument("Size of output_index: ", oi,
-                                            " is no longer in range."));
-        Eigen::DSizes<Eigen::DenseIndex, 2> out_indices(oi, 0);
-        Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
-        out_flat[p].slice(out_indices, sizes) =
-            data_flat.slice(data_indices, sizes);
-        output_index[p]++;
+    // Walk through each block of data and copy runs of rows that go to the
+    // same partition to the appropriate output tensor.
+    auto copy_blocks = [this, &partition_ids, block_size, &offsets, N,
+                        slice_size, data_base, &out_base](int64 start,
+                                                          int64 limit) {
+      gtl::InlinedVector<int64, 32> output_index(num_partitions_);
+      for (int64 b = start; b < limit; b++) {
+        std::copy_n(offsets.begin() + b * num_partitions_, num_partitions_,
+                    output_index.begin());
+        const int64 end = std::min(N, (b + 1) * block_size);
+        int64 i = b * block_size;
+        while (i < end) {
+          const int32 p = partition_ids[i];
+          int64 run_end = i + 1;
+          while (run_end < end && partition_ids[run_end] == p) run_end++;
+          // outputs[p][output_index[p]:] = data[i:run_end]
+          const T* source = data_base + i * slice_size;
+          const int64 run_size = (run_end - i) * slice_size;
+          T* dest = out_base[p] + output_index[p] * slice_size;
+          if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+            memcpy(dest, source, run_size * sizeof(T));
+          } else {
+            std::copy(source, source + run_size, dest);
+          }
+          output_index[p] += run_end - i;
+          i = run_end;
+        }
       }
-    }
+    };
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks = (N + block_size - 1) / block_size;
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          block_size * slice_size * sizeof(T), copy_blocks);
   }
 };
 
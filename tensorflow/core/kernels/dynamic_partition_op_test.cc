@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -140,6 +141,39 @@ TEST_F(DynamicPartitionOpTest, SomeOutputsEmpty) {
   }
 }
 
+TEST_F(DynamicPartitionOpTest, Large_TwoD) {
+  MakeOp();
+
+  // Enough rows to be split into blocks across the worker threads.
+  const int kRows = 100000;
+  const int kCols = 4;
+  std::vector<float> data(kRows * kCols);
+  std::vector<int32> partitions(kRows);
+  for (int i = 0; i < kRows; i++) {
+    for (int j = 0; j < kCols; j++) {
+      data[i * kCols + j] = i * kCols + j;
+    }
+    partitions[i] = (i / 3 + i % 5) % 4;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), data);
+  AddInputFromArray<int32>(TensorShape({kRows}), partitions);
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int p = 0; p < 4; p++) {
+    std::vector<float> expected_values;
+    for (int i = 0; i < kRows; i++) {
+      if (partitions[i] != p) continue;
+      for (int j = 0; j < kCols; j++) {
+        expected_values.push_back(data[i * kCols + j]);
+      }
+    }
+    const int64 rows = expected_values.size() / kCols;
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({rows, kCols}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorEqual<float>(expected, *GetOutput(p));
+  }
+}
+
 TEST_F(DynamicPartitionOpTest, Error_IndexOutOfRange) {
   MakeOp();
 
@@ -15,10 +15,14 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -100,41 +104,52 @@ class DynamicStitchOp : public OpKernel {
     // merged that aren't covered by an index in indices.  What should we do?
     if (first_dim_size > 0) {
       auto merged_flat = merged->flat_outer_dims<T>();
-      const int slice_size = merged_flat.dimension(1);
+      const int64 slice_size = merged_flat.dimension(1);
+
+      // Find the slice that lands in each row of merged. Later indices
+      // overwrite earlier ones, as if the slices were copied in order.
+      std::vector<const T*> sources(first_dim_size, nullptr);
       for (int input_num = 0; input_num < indices_inputs.size(); input_num++) {
-        const Tensor& indices = indices_inputs[input_num];
-        auto indices_vec = indices.flat<int32>();
-        const Tensor& data = data_inputs[input_num];
-        auto data_flat =
-            data.shaped<T, 2>({indices_vec.dimension(0), slice_size});
-
-        if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
-          T* merged_base = &merged_flat(0, 0);
-          const T* data_base = &data_flat(0, 0);
-          const size_t slice_bytes = slice_size * sizeof(T);
-          for (int i = 0; i < indices_vec.size(); i++) {
-            int32 index = internal::SubtleMustCopy(indices_vec(i));
-            OP_REQUIRES(
-                c, FastBoundsCheck(index, first_dim_size),
-                errors::InvalidArgument("indices[", i, "] is out of range"));
-            memcpy(merged_base + index * slice_size, data_base + i * slice_size,
-                   slice_bytes);
-          }
-        } else {
-          Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
-          for (int i = 0; i < indices_vec.size(); i++) {
-            // Copy slice data[i] to merged[indices[i]]
-            Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
-            int32 index = internal::SubtleMustCopy(indices_vec(i));
-            OP_REQUIRES(
-                c, FastBoundsCheck(index, first_dim_size),
-                errors::InvalidArgument("indices[", i, "] is out of range"));
-            Eigen::DSizes<Eigen::DenseIndex, 2> merged_indices(index, 0);
-            merged_flat.slice(merged_indices, sizes) =
-                data_flat.slice(data_indices, sizes);
-          }
+        auto indices_vec = indices_inputs[input_num].flat<int32>();
+        const T* data_base = data_inputs[input_num].flat<T>().data();
+        for (int i = 0; i < indices_vec.size(); i++) {
+          int32 index = internal::SubtleMustCopy(indices_vec(i));
+          OP_REQUIRES(
+              c, FastBoundsCheck(index, first_dim_size),
+              errors::InvalidArgument("indices[", i, "] is out of range"));
+          sources[index] = data_base + i * slice_size;
         }
       }
+      if (slice_size == 0) return;
+
+      // Each shard owns a range of rows of merged, and copies runs of rows
+      // whose slices are also adjacent in one data input at a time.
+      T* merged_base = merged_flat.data();
+      auto copy_rows = [&sources, merged_base, slice_size](int64 start,
+                                                           int64 limit) {
+        int64 row = start;
+        while (row < limit) {
+          const T* source = sources[row];
+          int64 run_end = row + 1;
+          if (source != nullptr) {
+            while (run_end < limit &&
+                   sources[run_end] == sources[run_end - 1] + slice_size) {
+              run_end++;
+            }
+            const int64 run_size = (run_end - row) * slice_size;
+            T* dest = merged_base + row * slice_size;
+            if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+              memcpy(dest, source, run_size * sizeof(T));
+            } else {
+              std::copy(source, source + run_size, dest);
+            }
+          }
+          row = run_end;
+        }
+      };
+      auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+      Shard(worker_threads->num_threads, worker_threads->workers,
+            first_dim_size, slice_size * sizeof(T), copy_rows);
     }
   }
 
@@ -13,9 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <numeric>
+#include <vector>
 
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
@@ -23,12 +27,16 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -79,6 +87,58 @@ TEST_F(DynamicStitchOpTest, Simple_TwoD) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(DynamicStitchOpTest, Duplicates_LastWins) {
+  MakeOp(2, DT_FLOAT);
+
+  // Feed and run
+  AddInputFromArray<int32>(TensorShape({4}), {0, 1, 2, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 3});
+  AddInputFromArray<float>(TensorShape({4, 2}), {0, 1, 10, 11, 20, 21, 30, 31});
+  AddInputFromArray<float>(TensorShape({2, 2}), {40, 41, 50, 51});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4, 2}));
+  test::FillValues<float>(&expected, {0, 1, 30, 31, 40, 41, 50, 51});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(DynamicStitchOpTest, Large_TwoD) {
+  MakeOp(2, DT_FLOAT);
+
+  // Interleave two inputs over enough rows to be split across the worker
+  // threads, with runs of adjacent rows from the same input.
+  const int kRows = 100000;
+  const int kCols = 3;
+  std::vector<int32> indices[2];
+  std::vector<float> data[2];
+  std::vector<float> expected_values(kRows * kCols);
+  for (int i = 0; i < kRows; i++) {
+    const int input_num = (i / 7) % 2;
+    indices[input_num].push_back(i);
+    for (int j = 0; j < kCols; j++) {
+      data[input_num].push_back(i * kCols + j);
+      expected_values[i * kCols + j] = i * kCols + j;
+    }
+  }
+  for (int input_num = 0; input_num < 2; input_num++) {
+    AddInputFromArray<int32>(
+        TensorShape({static_cast<int64>(indices[input_num].size())}),
+        indices[input_num]);
+  }
+  for (int input_num = 0; input_num < 2; input_num++) {
+    AddInputFromArray<float>(
+        TensorShape({static_cast<int64>(indices[input_num].size()), kCols}),
+        data[input_num]);
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 TEST_F(DynamicStitchOpTest, Error_IndicesMultiDimensional) {
   MakeOp(2, DT_FLOAT);
 
@@ -141,5 +201,58 @@ TEST_F(DynamicStitchOpTest, Error_DataAndIndicesSizeMismatch) {
       << s;
 }
 
+// Stitches num_inputs shuffled partitions of a [rows, dim] float tensor back
+// together, the way a partitioned embedding lookup does.
+static Graph* DynamicStitch(int num_inputs, int rows, int dim) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<int32> order(rows);
+  std::iota(order.begin(), order.end(), 0);
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (int i = rows - 1; i > 0; i--) {
+    std::swap(order[i], order[rnd.Uniform(i + 1)]);
+  }
+
+  std::vector<NodeBuilder::NodeOut> indices;
+  std::vector<NodeBuilder::NodeOut> data;
+  for (int input_num = 0; input_num < num_inputs; input_num++) {
+    const int start = static_cast<int64>(rows) * input_num / num_inputs;
+    const int limit = static_cast<int64>(rows) * (input_num + 1) / num_inputs;
+    Tensor indices_t(DT_INT32, TensorShape({limit - start}));
+    std::copy(order.begin() + start, order.begin() + limit,
+              indices_t.flat<int32>().data());
+    Tensor data_t(DT_FLOAT, TensorShape({limit - start, dim}));
+    data_t.flat<float>().setRandom();
+    indices.push_back(test::graph::Constant(g, indices_t));
+    data.push_back(test::graph::Constant(g, data_t));
+  }
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "DynamicStitch")
+                  .Input(indices)
+                  .Input(data)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_DYNAMIC_STITCH(DEVICE, NUM_INPUTS, ROWS)                          \
+  static void BM_##DEVICE##_dynamic_stitch_##NUM_INPUTS##_##ROWS(int iters,  \
+                                                                 int dim) {  \
+    const int64 tot = static_cast<int64>(iters) * ROWS * dim;                \
+    testing::ItemsProcessed(tot);                                            \
+    testing::BytesProcessed(tot * sizeof(float));                            \
+    testing::UseRealTime();                                                  \
+    test::Benchmark(#DEVICE, DynamicStitch(NUM_INPUTS, ROWS, dim))           \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(BM_##DEVICE##_dynamic_stitch_##NUM_INPUTS##_##ROWS)              \
+      ->Arg(1)                                                               \
+      ->Arg(16)                                                              \
+      ->Arg(64)
+
+BM_DYNAMIC_STITCH(cpu, 2, 100000);
+BM_DYNAMIC_STITCH(cpu, 16, 100000);
+BM_DYNAMIC_STITCH(cpu, 16, 1000000);
+
 }  // namespace
 }  // namespace tensorflow
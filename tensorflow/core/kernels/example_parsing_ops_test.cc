@@ -26,7 +26,10 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
@@ -230,4 +233,114 @@ BM_AllParseExample(SparseFloat);
 BM_AllParseExample(DenseFloat);
 BM_AllParseExample(VarLenDenseFloat);
 
+// A feature configuration resembling a production ranking model: hundreds of
+// sparse features of all three types with short, variable-length value lists,
+// plus a handful of dense float features.
+constexpr int kRealisticBatchSize = 512;
+constexpr int kRealisticSparseKeysPerType = 100;
+constexpr int kRealisticDenseKeys = 10;
+constexpr int kRealisticDenseSize = 8;
+
+static Tensor MakeRealisticExamples() {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor serialized(DT_STRING, TensorShape({kRealisticBatchSize}));
+  auto serialized_t = serialized.vec<string>();
+  for (int b = 0; b < kRealisticBatchSize; ++b) {
+    Example example;
+    auto& fmap = *example.mutable_features()->mutable_feature();
+    for (int k = 0; k < kRealisticSparseKeysPerType; ++k) {
+      // Like real data, not every example has every sparse feature.
+      if (rnd.Uniform(4) == 0) continue;
+      Int64List* ids = fmap[strings::Printf("sparse_int64_%d", k)]
+                           .mutable_int64_list();
+      for (int i = 1 + rnd.Uniform(10); i > 0; --i) {
+        ids->add_value(rnd.Uniform64(1LL << 40));
+      }
+      FloatList* weights = fmap[strings::Printf("sparse_float_%d", k)]
+                               .mutable_float_list();
+      for (int i = 1 + rnd.Uniform(10); i > 0; --i) {
+        weights->add_value(rnd.RandFloat());
+      }
+      BytesList* tokens = fmap[strings::Printf("sparse_string_%d", k)]
+                              .mutable_bytes_list();
+      for (int i = 1 + rnd.Uniform(3); i > 0; --i) {
+        tokens->add_value(strings::Printf("token_%u", rnd.Uniform(100000)));
+      }
+    }
+    for (int k = 0; k < kRealisticDenseKeys; ++k) {
+      FloatList* values =
+          fmap[strings::Printf("dense_%d", k)].mutable_float_list();
+      for (int i = 0; i < kRealisticDenseSize; ++i) {
+        values->add_value(rnd.RandFloat());
+      }
+    }
+    CHECK(example.SerializeToString(&serialized_t(b)));
+  }
+  return serialized;
+}
+
+static Graph* ParseRealisticExamples() {
+  static Tensor* serialized = new Tensor(MakeRealisticExamples());
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor names(DT_STRING, TensorShape({kRealisticBatchSize}));
+
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<DataType> sparse_types;
+  const std::vector<std::pair<string, DataType>> sparse_kinds = {
+      {"sparse_int64_%d", DT_INT64},
+      {"sparse_float_%d", DT_FLOAT},
+      {"sparse_string_%d", DT_STRING}};
+  for (const auto& kind : sparse_kinds) {
+    for (int k = 0; k < kRealisticSparseKeysPerType; ++k) {
+      Tensor key(DT_STRING, TensorShape());
+      key.scalar<string>()() = strings::Printf(kind.first.c_str(), k);
+      sparse_keys.emplace_back(test::graph::Constant(g, key));
+      sparse_types.push_back(kind.second);
+    }
+  }
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int k = 0; k < kRealisticDenseKeys; ++k) {
+    Tensor key(DT_STRING, TensorShape());
+    key.scalar<string>()() = strings::Printf("dense_%d", k);
+    dense_keys.emplace_back(test::graph::Constant(g, key));
+    Tensor dense_default(DT_FLOAT, TensorShape({kRealisticDenseSize}));
+    dense_default.flat<float>().setZero();
+    dense_defaults.emplace_back(test::graph::Constant(g, dense_default));
+    dense_shapes.push_back(PartialTensorShape({kRealisticDenseSize}));
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                   .Input(test::graph::Constant(g, *serialized))
+                   .Input(test::graph::Constant(g, names))
+                   .Input(sparse_keys)
+                   .Input(dense_keys)
+                   .Input(dense_defaults)
+                   .Attr("sparse_types", sparse_types)
+                   .Attr("dense_shapes", dense_shapes)
+                   .Finalize(g, &ret));
+  return g;
+}
+
+// T == number of intra-op threads, to track how parsing scales per core.
+// Items are examples, so items/s divided by T gives per-core throughput.
+#define BM_ParseRealisticExamples(T)                                        \
+  static void BM_ParseRealisticExamples_##T##_threads(int iters) {          \
+    testing::UseRealTime();                                                 \
+    testing::ItemsProcessed(static_cast<int64>(iters) * kRealisticBatchSize); \
+    SessionOptions options;                                                 \
+    options.config.set_intra_op_parallelism_threads(T);                     \
+    test::Benchmark("cpu", ParseRealisticExamples(), &options).Run(iters);  \
+  }                                                                         \
+  BENCHMARK(BM_ParseRealisticExamples_##T##_threads);
+
+BM_ParseRealisticExamples(1);
+BM_ParseRealisticExamples(2);
+BM_ParseRealisticExamples(4);
+BM_ParseRealisticExamples(8);
+BM_ParseRealisticExamples(16);
+
 }  // end namespace tensorflow
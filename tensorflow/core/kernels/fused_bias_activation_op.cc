@@ -0,0 +1,130 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_bias_activation_op.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+Status ParseFusedActivation(const string& name, FusedActivation* activation) {
+  if (name == "Identity") {
+    *activation = FusedActivation::kIdentity;
+  } else if (name == "Relu") {
+    *activation = FusedActivation::kRelu;
+  } else if (name == "Relu6") {
+    *activation = FusedActivation::kRelu6;
+  } else if (name == "Tanh") {
+    *activation = FusedActivation::kTanh;
+  } else if (name == "Elu") {
+    *activation = FusedActivation::kElu;
+  } else {
+    return errors::InvalidArgument("Unsupported fused activation: ", name);
+  }
+  return Status::OK();
+}
+
+// Computes activation(BiasAdd(value, bias)) for NHWC data, in one pass over
+// the data and without an intermediate tensor.  Produced by the grappler
+// op fusion optimizer.
+template <typename Device, typename T>
+class FusedBiasActivationOp : public OpKernel {
+ public:
+  explicit FusedBiasActivationOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(context, ParseFusedActivation(activation, &activation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& bias = context->input(1);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrixOrHigher(input.shape()),
+                errors::InvalidArgument("Input tensor must be at least 2D: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("Biases must be 1D: ",
+                                        bias.shape().DebugString()));
+    const auto last_dim = input.shape().dims() - 1;
+    OP_REQUIRES(
+        context, bias.shape().dim_size(0) == input.shape().dim_size(last_dim),
+        errors::InvalidArgument(
+            "Must provide as many biases as the last dimension "
+            "of the input tensor: ",
+            bias.shape().DebugString(), " vs. ", input.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, input.shape(), &output));
+    if (input.NumElements() == 0) return;
+
+    functor::FusedBiasActivation<Device, T>()(
+        context->eigen_device<Device>(),
+        input.flat_inner_dims<T>(), bias.vec<T>(),
+        activation_, output->flat_inner_dims<T>());
+  }
+
+ private:
+  FusedActivation activation_;
+};
+
+#define REGISTER_KERNEL(type)                                                \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_FusedBiasActivation").Device(DEVICE_CPU).TypeConstraint<type>( \
+          "T"),                                                              \
+      FusedBiasActivationOp<CPUDevice, type>);
+
+TF_CALL_half(REGISTER_KERNEL);
+TF_CALL_float(REGISTER_KERNEL);
+TF_CALL_double(REGISTER_KERNEL);
+#undef REGISTER_KERNEL
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                            \
+  template <>                                                          \
+  void FusedBiasActivation<GPUDevice, T>::operator()(                  \
+      const GPUDevice& d, typename TTypes<T>::ConstMatrix input,       \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation,   \
+      typename TTypes<T>::Matrix output);                              \
+  extern template struct FusedBiasActivation<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU_KERNEL(type)                                            \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_FusedBiasActivation").Device(DEVICE_GPU).TypeConstraint<type>( \
+          "T"),                                                              \
+      FusedBiasActivationOp<GPUDevice, type>);
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_KERNEL);
+#undef REGISTER_GPU_KERNEL
+#endif  // GOOGLE_CUDA
+
+}  // namespace tensorflow
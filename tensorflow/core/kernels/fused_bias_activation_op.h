@@ -0,0 +1,112 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_OP_H_
+#define TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_OP_H_
+// Functor definition for FusedBiasActivationOp, must be compilable by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// The activations that can be fused with a preceding bias addition.
+enum class FusedActivation { kIdentity, kRelu, kRelu6, kTanh, kElu };
+
+// Parses the "activation" attr of the fused ops ("Identity", "Relu", "Relu6",
+// "Tanh" or "Elu").
+Status ParseFusedActivation(const string& name, FusedActivation* activation);
+
+namespace functor {
+
+// Functor used by the fused ops to apply a bias and an activation in one pass.
+template <typename Device, typename T>
+struct FusedBiasActivation {
+  // Computes "output = activation(input + bias)", broadcasting "bias" across
+  // the rows of "input".  "input" and "output" may alias.
+  void operator()(const Device& d, typename TTypes<T>::ConstMatrix input,
+                  typename TTypes<T>::ConstVec bias,
+                  FusedActivation activation,
+                  typename TTypes<T>::Matrix output) {
+    const Eigen::DSizes<Eigen::DenseIndex, 2> bias_shape(1, bias.dimension(0));
+    const Eigen::DSizes<Eigen::DenseIndex, 2> bcast(input.dimension(0), 1);
+    auto biased = input + bias.reshape(bias_shape).broadcast(bcast);
+    switch (activation) {
+      case FusedActivation::kIdentity:
+        output.device(d) = biased;
+        break;
+      case FusedActivation::kRelu:
+        output.device(d) = biased.cwiseMax(static_cast<T>(0));
+        break;
+      case FusedActivation::kRelu6:
+        output.device(d) =
+            biased.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+        break;
+      case FusedActivation::kTanh:
+        output.device(d) = biased.tanh();
+        break;
+      case FusedActivation::kElu:
+        output.device(d) = (biased < static_cast<T>(0))
+                               .select(biased.exp() - static_cast<T>(1),
+                                       biased);
+        break;
+    }
+  }
+};
+
+// Functor used by _FusedConv2D to fold an inference-mode batch normalization,
+// and optionally a preceding bias, into a per-channel scale and offset.
+template <typename Device, typename T>
+struct FoldBatchNorm {
+  // Computes "scale" and "offset" such that "x * scale + offset" equals
+  // "(x + bias - mean) * bn_scale / sqrt(variance + epsilon) + bn_offset".
+  // "bias" may be empty, in which case it is treated as zero.
+  void operator()(const Device& d, typename TTypes<T>::ConstVec bias,
+                  typename TTypes<T>::ConstVec bn_scale,
+                  typename TTypes<T>::ConstVec bn_offset,
+                  typename TTypes<T>::ConstVec mean,
+                  typename TTypes<T>::ConstVec variance, T epsilon,
+                  typename TTypes<T>::Vec scale,
+                  typename TTypes<T>::Vec offset) {
+    scale.device(d) = bn_scale * (variance + epsilon).rsqrt();
+    if (bias.size() == 0) {
+      offset.device(d) = bn_offset - mean * scale;
+    } else {
+      offset.device(d) = bn_offset + (bias - mean) * scale;
+    }
+  }
+};
+
+// Functor used by _FusedConv2D to multiply each output channel of a filter by
+// its batch normalization scale.
+template <typename Device, typename T>
+struct ScaleColumns {
+  // Computes "output = input * scale", broadcasting "scale" across the rows of
+  // "input".
+  void operator()(const Device& d, typename TTypes<T>::ConstMatrix input,
+                  typename TTypes<T>::ConstVec scale,
+                  typename TTypes<T>::Matrix output) {
+    const Eigen::DSizes<Eigen::DenseIndex, 2> scale_shape(1,
+                                                          scale.dimension(0));
+    const Eigen::DSizes<Eigen::DenseIndex, 2> bcast(input.dimension(0), 1);
+    output.device(d) = input * scale.reshape(scale_shape).broadcast(bcast);
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_OP_H_
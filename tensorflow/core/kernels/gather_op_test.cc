@@ -150,10 +150,8 @@ TEST_F(GatherOpTest, Error_IndexOutOfRange) {
       << s;
 }
 
-constexpr int kLookups = 2000;
-
 template <typename Index>
-static Graph* Gather(int dim) {
+static Graph* Gather(int dim, int lookups) {
   Graph* g = new Graph(OpRegistry::Global());
   // Always use a 512MB buffer.
   const int kRows = ((512 << 20) / sizeof(float)) / dim;
@@ -163,11 +161,11 @@ static Graph* Gather(int dim) {
   random::PhiloxRandom philox(301, 17);
   random::SimplePhilox rnd(&philox);
   std::vector<Index> indices_vec;
-  indices_vec.reserve(kLookups);
-  for (int i = 0; i < kLookups; i++) {
+  indices_vec.reserve(lookups);
+  for (int i = 0; i < lookups; i++) {
     indices_vec.push_back(rnd.Uniform(kRows));
   }
-  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({kLookups}));
+  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({lookups}));
   for (int i = 0; i < indices_vec.size(); i++) {
     indices.flat<Index>()(i) = indices_vec[i];
   }
@@ -177,22 +175,29 @@ static Graph* Gather(int dim) {
   return g;
 }
 
-#define BM_GATHER(DEVICE, INDEX)                                  \
-  static void BM_##DEVICE##_gather_##INDEX(int iters, int dim) {  \
-    const int64 tot = static_cast<int64>(iters) * kLookups * dim; \
-    testing::ItemsProcessed(tot);                                 \
-    testing::BytesProcessed(tot * sizeof(float));                 \
-    testing::UseRealTime();                                       \
-    test::Benchmark(#DEVICE, Gather<INDEX>(dim)).Run(iters);      \
-  }                                                               \
-  BENCHMARK(BM_##DEVICE##_gather_##INDEX)                         \
-      ->Arg(1)                                                    \
-      ->Arg(10)                                                   \
-      ->Arg(20)                                                   \
-      ->Arg(64)                                                   \
-      ->Arg(100)                                                  \
-      ->Arg(200)                                                  \
-      ->Arg(1000)
+// The embedding dimensions of 64 and up are where the GPU copies whole rows
+// with vector loads.
+#define BM_GATHER(DEVICE, INDEX)                                             \
+  static void BM_##DEVICE##_gather_##INDEX(int iters, int dim, int lookups) { \
+    const int64 tot = static_cast<int64>(iters) * lookups * dim;             \
+    testing::ItemsProcessed(tot);                                            \
+    testing::BytesProcessed(tot * sizeof(float));                            \
+    testing::UseRealTime();                                                  \
+    test::Benchmark(#DEVICE, Gather<INDEX>(dim, lookups)).Run(iters);        \
+  }                                                                          \
+  BENCHMARK(BM_##DEVICE##_gather_##INDEX)                                    \
+      ->ArgPair(1, 2000)                                                     \
+      ->ArgPair(10, 2000)                                                    \
+      ->ArgPair(20, 2000)                                                    \
+      ->ArgPair(64, 2000)                                                    \
+      ->ArgPair(100, 2000)                                                   \
+      ->ArgPair(200, 2000)                                                   \
+      ->ArgPair(1000, 2000)                                                  \
+      ->ArgPair(64, 20000)                                                   \
+      ->ArgPair(128, 20000)                                                  \
+      ->ArgPair(256, 20000)                                                  \
+      ->ArgPair(512, 20000)                                                  \
+      ->ArgPair(512, 200000)
 
 BM_GATHER(cpu, int32);
 BM_GATHER(gpu, int32);
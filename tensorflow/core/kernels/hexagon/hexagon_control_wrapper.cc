@@ -415,6 +415,46 @@ bool HexagonControlWrapper::FillInputNode(const string& node_name,
   return true;
 }
 
+bool HexagonControlWrapper::StageInputNode(const int slot,
+                                           const string& node_name,
+                                           const Tensor& tensor) {
+  CHECK(slot >= 0 && slot < PIPELINE_DEPTH);
+  const string tensor_name = AddPort(node_name);
+  CHECK(input_port_map_.count(tensor_name) > 0);
+  const int port = input_port_map_.at(tensor_name);
+  const std::array<int64, GraphTransferer::SHAPE_ARRAY_SIZE> shape =
+      GraphTransferer::ToTensorShapeArray(tensor.shape());
+  StagedInput& staged_input = staged_inputs_[slot][port];
+  // hexagon only supports 32bit dimension
+  for (int i = 0; i < GraphTransferer::SHAPE_ARRAY_SIZE; ++i) {
+    staged_input.shape[i] = static_cast<int>(shape[i]);
+  }
+  const StringPiece tensor_data = tensor.tensor_data();
+  staged_input.byte_size = tensor_data.size();
+  staged_input.data.resize(staged_input.byte_size + ALIGNMENT_BYTES);
+  uint8* data_ptr = FindAlignedPointer(staged_input.data.data());
+  if (DBG_USE_DUMMY_INPUT) {
+    std::memset(data_ptr, 0, staged_input.byte_size);
+  } else {
+    std::memcpy(data_ptr, tensor_data.data(), staged_input.byte_size);
+  }
+  return true;
+}
+
+bool HexagonControlWrapper::ExecuteStagedGraph(const int slot) {
+  CHECK(slot >= 0 && slot < PIPELINE_DEPTH);
+  bool success = true;
+  for (auto& port_and_input : staged_inputs_[slot]) {
+    StagedInput& staged_input = port_and_input.second;
+    const std::array<int, GraphTransferer::SHAPE_ARRAY_SIZE>& shape =
+        staged_input.shape;
+    success &= soc_interface_FillInputNodeWithPort(
+        port_and_input.first, shape[0], shape[1], shape[2], shape[3],
+        FindAlignedPointer(staged_input.data.data()), staged_input.byte_size);
+  }
+  return success && soc_interface_ExecuteGraph();
+}
+
 #else
 int HexagonControlWrapper::GetVersion() { return -1; }
 bool HexagonControlWrapper::Init(const RemoteFusedGraphExecuteInfo&) {
@@ -440,6 +480,10 @@ bool HexagonControlWrapper::ReadOutputNode(const string&,
                                            std::vector<ByteArray>* const) {
   return false;
 }
+bool HexagonControlWrapper::StageInputNode(int, const string&, const Tensor&) {
+  return false;
+}
+bool HexagonControlWrapper::ExecuteStagedGraph(int) { return false; }
 #endif
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_HEXAGON_CONTROL_WRAPPER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_HEXAGON_CONTROL_WRAPPER_H_
 
+#include <array>
 #include <unordered_map>
 #include <vector>
 
@@ -47,6 +48,10 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
   bool ReadOutputNode(const string& node_name,
                       TensorAllocatorFunc tensor_allocator) final;
   bool ReadOutputNode(const string& node_name, std::vector<ByteArray>* outputs);
+  int GetPipelineDepth() final { return PIPELINE_DEPTH; }
+  bool StageInputNode(int slot, const string& node_name,
+                      const Tensor& tensor) final;
+  bool ExecuteStagedGraph(int slot) final;
 
  private:
   using ConstByteArray = std::tuple<const uint8* /* data */, uint64 /* size */,
@@ -60,6 +65,16 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
   // CAVEAT: Need offset as HVX library reserves some ids
   static constexpr int NODE_ID_OFFSET = 0x10000;
 
+  // Number of frames whose inputs can be staged while hexagon executes.
+  static constexpr int PIPELINE_DEPTH = 2;
+
+  // Input of an input port staged on the host by StageInputNode.
+  struct StagedInput {
+    std::array<int, GraphTransferer::SHAPE_ARRAY_SIZE> shape;
+    uint64 byte_size;
+    std::vector<uint8> data;  // Holds byte_size bytes at an aligned offset
+  };
+
   static GraphTransferInfo::NodeInfo* FindNodeInfo(
       const string& node_name, GraphTransferInfo* graph_transfer_info);
 
@@ -73,6 +88,10 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
   // TODO(satok): Remove
   std::unordered_map<int, std::vector<uint8>> dummy_const_data_{};
 
+  // Staged inputs per pipeline slot, keyed by input port
+  std::array<std::unordered_map<int, StagedInput>, PIPELINE_DEPTH>
+      staged_inputs_{};
+
   std::unordered_map<string, int> input_port_map_{};
   std::unordered_map<string, int> output_port_map_{};
 
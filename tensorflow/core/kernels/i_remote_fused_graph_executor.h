@@ -59,6 +59,25 @@ class IRemoteFusedGraphExecutor {
   virtual bool ReadOutputNode(const string& node_name,
                               TensorAllocatorFunc tensor_allocator) = 0;
 
+  // Return the number of frames whose inputs can be staged at the same time.
+  // An executor returning more than 1 implements StageInputNode and
+  // ExecuteStagedGraph, so that the inputs of the next frame can be copied
+  // while the remote processor is still executing the current one.
+  virtual int GetPipelineDepth() { return 1; }
+
+  // Copy tensor into input buffer "slot" of the input node on the host
+  // without sending it to the remote processor yet.
+  // REQUIRES: 0 <= slot < GetPipelineDepth()
+  virtual bool StageInputNode(int slot, const string& node_name,
+                              const Tensor& tensor) {
+    return false;
+  }
+
+  // Send the inputs staged in "slot" to the remote processor and execute
+  // graph. Calls to ExecuteStagedGraph and ReadOutputNode are serialized by
+  // the caller; StageInputNode may run concurrently with them on other slots.
+  virtual bool ExecuteStagedGraph(int slot) { return false; }
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(IRemoteFusedGraphExecutor);
 };
@@ -0,0 +1,376 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/int8_gemm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+// The vectorized kernels are compiled with function-level target attributes,
+// so that they can be selected at runtime without compiling the whole binary
+// for a newer instruction set.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TF_INT8_GEMM_HAVE_AVX2 1
+#if (defined(__clang__) && __clang_major__ >= 6) || \
+    (!defined(__clang__) && __GNUC__ >= 8)
+#define TF_INT8_GEMM_HAVE_AVX512_VNNI 1
+#endif
+#endif
+
+namespace tensorflow {
+namespace int8_gemm {
+namespace {
+
+// Number of rows of 'a' that are computed together by a vectorized kernel.
+const int kRowBlock = 4;
+
+// Number of rows of 'a' multiplied by each packed panel of 'b' before moving
+// to the next panel, so that the rows and the panel both stay in cache.
+const int kRowChunk = 64;
+
+// AVX2 panels hold 16 columns of 'b' (two vectors of 8 int32 accumulators)
+// for pairs of rows, widened to int16:
+//   [n / 16, k / 2, 16, 2]
+const int kAvx2PanelCols = 16;
+const int kAvx2DepthStep = 2;
+
+// AVX-512 VNNI panels hold 32 columns of 'b' (two vectors of 16 int32
+// accumulators) for groups of four rows:
+//   [n / 32, k / 4, 32, 4]
+const int kVnniPanelCols = 32;
+const int kVnniDepthStep = 4;
+
+int RoundUp(int value, int multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Returns the values of up to four consecutive bytes of 'a' in an int32,
+// zero-filling the bytes past 'count'.
+inline int32 LoadBytes(const uint8* a, int count) {
+  int32 value = 0;
+  memcpy(&value, a, count);
+  return value;
+}
+
+void MultiplyReference(const uint8* a, int lda, int row_start, int row_limit,
+                       const PackedMatrixB& b, int32* c, int ldc) {
+  const int k = b.k();
+  const int n = b.n();
+  const int8* b_data = b.data();
+  for (int i = row_start; i < row_limit; ++i) {
+    int32* c_row = c + i * ldc;
+    std::fill(c_row, c_row + n, 0);
+    const uint8* a_row = a + i * lda;
+    for (int l = 0; l < k; ++l) {
+      const int32 a_value = a_row[l];
+      const int8* b_row = b_data + l * n;
+      for (int j = 0; j < n; ++j) {
+        c_row[j] += a_value * b_row[j];
+      }
+    }
+  }
+}
+
+#ifdef TF_INT8_GEMM_HAVE_AVX2
+// Computes 'kRows' rows of 'c' for the (at most 16) columns of one AVX2 panel.
+template <int kRows>
+__attribute__((target("avx2"))) void MultiplyPanelAvx2(const uint8* a,
+                                                       int lda, int k,
+                                                       const int16* panel,
+                                                       int32* c, int ldc,
+                                                       int cols) {
+  __m256i acc[kRows][2];
+  for (int r = 0; r < kRows; ++r) {
+    acc[r][0] = _mm256_setzero_si256();
+    acc[r][1] = _mm256_setzero_si256();
+  }
+  const int num_steps = (k + kAvx2DepthStep - 1) / kAvx2DepthStep;
+  const int num_full_steps = k / kAvx2DepthStep;
+  for (int s = 0; s < num_steps; ++s) {
+    const int16* b = panel + s * kAvx2PanelCols * kAvx2DepthStep;
+    const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i b1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16));
+    for (int r = 0; r < kRows; ++r) {
+      const uint8* a_row = a + r * lda + s * kAvx2DepthStep;
+      // Broadcast the pair of 'a' values as two int16 values.
+      const int32 a_pair =
+          s < num_full_steps ? (a_row[0] | (a_row[1] << 16)) : a_row[0];
+      const __m256i a_values = _mm256_set1_epi32(a_pair);
+      acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(a_values, b0));
+      acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(a_values, b1));
+    }
+  }
+  for (int r = 0; r < kRows; ++r) {
+    int32* c_row = c + r * ldc;
+    if (cols == kAvx2PanelCols) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_row), acc[r][0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_row + 8), acc[r][1]);
+    } else {
+      int32 buffer[kAvx2PanelCols];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer), acc[r][0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + 8), acc[r][1]);
+      memcpy(c_row, buffer, cols * sizeof(int32));
+    }
+  }
+}
+#endif  // TF_INT8_GEMM_HAVE_AVX2
+
+#ifdef TF_INT8_GEMM_HAVE_AVX512_VNNI
+// Computes 'kRows' rows of 'c' for the (at most 32) columns of one AVX-512
+// VNNI panel.
+template <int kRows>
+__attribute__((target("avx512f,avx512vnni"))) void MultiplyPanelVnni(
+    const uint8* a, int lda, int k, const int8* panel, int32* c, int ldc,
+    int cols) {
+  __m512i acc[kRows][2];
+  for (int r = 0; r < kRows; ++r) {
+    acc[r][0] = _mm512_setzero_si512();
+    acc[r][1] = _mm512_setzero_si512();
+  }
+  const int num_steps = (k + kVnniDepthStep - 1) / kVnniDepthStep;
+  const int num_full_steps = k / kVnniDepthStep;
+  const int tail = k - num_full_steps * kVnniDepthStep;
+  for (int s = 0; s < num_steps; ++s) {
+    const int8* b = panel + s * kVnniPanelCols * kVnniDepthStep;
+    const __m512i b0 = _mm512_loadu_si512(b);
+    const __m512i b1 = _mm512_loadu_si512(b + 64);
+    for (int r = 0; r < kRows; ++r) {
+      const uint8* a_row = a + r * lda + s * kVnniDepthStep;
+      const __m512i a_values = _mm512_set1_epi32(
+          LoadBytes(a_row, s < num_full_steps ? kVnniDepthStep : tail));
+      acc[r][0] = _mm512_dpbusd_epi32(acc[r][0], a_values, b0);
+      acc[r][1] = _mm512_dpbusd_epi32(acc[r][1], a_values, b1);
+    }
+  }
+  const __mmask16 mask0 =
+      static_cast<__mmask16>((1u << std::min(cols, 16)) - 1);
+  const __mmask16 mask1 =
+      static_cast<__mmask16>((1u << std::max(cols - 16, 0)) - 1);
+  for (int r = 0; r < kRows; ++r) {
+    int32* c_row = c + r * ldc;
+    _mm512_mask_storeu_epi32(c_row, mask0, acc[r][0]);
+    _mm512_mask_storeu_epi32(c_row + 16, mask1, acc[r][1]);
+  }
+}
+#endif  // TF_INT8_GEMM_HAVE_AVX512_VNNI
+
+// Loops over chunks of rows of 'a' and panels of 'b', calling
+// 'PanelKernel<kRows>' for each block of (at most) kRowBlock rows.
+template <typename PackedT, int kPanelCols, int kDepthStep,
+          void (*PanelKernel1)(const uint8*, int, int, const PackedT*, int32*,
+                               int, int),
+          void (*PanelKernel2)(const uint8*, int, int, const PackedT*, int32*,
+                               int, int),
+          void (*PanelKernel3)(const uint8*, int, int, const PackedT*, int32*,
+                               int, int),
+          void (*PanelKernel4)(const uint8*, int, int, const PackedT*, int32*,
+                               int, int)>
+void MultiplyBlocked(const uint8* a, int lda, int row_start, int row_limit,
+                     const PackedMatrixB& b, int32* c, int ldc) {
+  const int k = b.k();
+  const int n = b.n();
+  const int panel_size = RoundUp(k, kDepthStep) * kPanelCols;
+  const PackedT* packed = reinterpret_cast<const PackedT*>(b.data());
+  for (int chunk = row_start; chunk < row_limit; chunk += kRowChunk) {
+    const int chunk_limit = std::min(chunk + kRowChunk, row_limit);
+    for (int col = 0; col < n; col += kPanelCols) {
+      const int cols = std::min(kPanelCols, n - col);
+      const PackedT* panel = packed + (col / kPanelCols) * panel_size;
+      for (int row = chunk; row < chunk_limit; row += kRowBlock) {
+        const uint8* a_rows = a + row * lda;
+        int32* c_rows = c + row * ldc + col;
+        switch (std::min(kRowBlock, chunk_limit - row)) {
+          case 1:
+            PanelKernel1(a_rows, lda, k, panel, c_rows, ldc, cols);
+            break;
+          case 2:
+            PanelKernel2(a_rows, lda, k, panel, c_rows, ldc, cols);
+            break;
+          case 3:
+            PanelKernel3(a_rows, lda, k, panel, c_rows, ldc, cols);
+            break;
+          default:
+            PanelKernel4(a_rows, lda, k, panel, c_rows, ldc, cols);
+            break;
+        }
+      }
+    }
+  }
+}
+
+Isa DetectIsa() {
+  Isa isa = Isa::kReference;
+  if (IsIsaSupported(Isa::kAvx512Vnni)) {
+    isa = Isa::kAvx512Vnni;
+  } else if (IsIsaSupported(Isa::kAvx2)) {
+    isa = Isa::kAvx2;
+  }
+  const char* requested = getenv("TF_INT8_GEMM_ISA");
+  if (requested != nullptr) {
+    bool found = false;
+    for (Isa candidate :
+         {Isa::kReference, Isa::kAvx2, Isa::kAvx512Vnni}) {
+      if (strcmp(requested, IsaName(candidate)) == 0) {
+        found = true;
+        if (IsIsaSupported(candidate)) {
+          isa = candidate;
+        } else {
+          LOG(WARNING) << "TF_INT8_GEMM_ISA=" << requested
+                       << " is not supported on this CPU, using "
+                       << IsaName(isa);
+        }
+      }
+    }
+    if (!found) {
+      LOG(WARNING) << "Unknown TF_INT8_GEMM_ISA=" << requested << ", using "
+                   << IsaName(isa);
+    }
+  }
+  VLOG(1) << "Using " << IsaName(isa) << " int8 gemm kernels";
+  return isa;
+}
+
+}  // namespace
+
+Isa GetIsa() {
+  static const Isa isa = DetectIsa();
+  return isa;
+}
+
+bool IsIsaSupported(Isa isa) {
+  switch (isa) {
+    case Isa::kReference:
+      return true;
+    case Isa::kAvx2:
+#ifdef TF_INT8_GEMM_HAVE_AVX2
+      return port::TestCPUFeature(port::AVX2);
+#else
+      return false;
+#endif
+    case Isa::kAvx512Vnni:
+#ifdef TF_INT8_GEMM_HAVE_AVX512_VNNI
+      return port::TestCPUFeature(port::AVX512F) &&
+             port::TestCPUFeature(port::AVX512_VNNI);
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+const char* IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kReference:
+      return "reference";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kAvx512Vnni:
+      return "avx512_vnni";
+  }
+  return "unknown";
+}
+
+PackedMatrixB::PackedMatrixB(Isa isa, const int8* b, int k, int n, int ldb)
+    : isa_(isa), k_(k), n_(n), column_sums_(n, 0) {
+  CHECK(IsIsaSupported(isa)) << IsaName(isa);
+  for (int l = 0; l < k; ++l) {
+    for (int j = 0; j < n; ++j) {
+      column_sums_[j] += b[l * ldb + j];
+    }
+  }
+  switch (isa) {
+    case Isa::kReference: {
+      data_.resize(static_cast<size_t>(k) * n);
+      for (int l = 0; l < k; ++l) {
+        memcpy(data_.data() + l * n, b + l * ldb, n);
+      }
+      break;
+    }
+    case Isa::kAvx2: {
+      const int depth = RoundUp(k, kAvx2DepthStep);
+      const int panels = RoundUp(n, kAvx2PanelCols) / kAvx2PanelCols;
+      const size_t num_values =
+          static_cast<size_t>(panels) * depth * kAvx2PanelCols;
+      data_.resize(num_values * sizeof(int16), 0);
+      int16* packed = reinterpret_cast<int16*>(data_.data());
+      for (int p = 0; p < panels; ++p) {
+        for (int l = 0; l < k; ++l) {
+          const int step = l / kAvx2DepthStep;
+          for (int j = 0; j < kAvx2PanelCols; ++j) {
+            const int col = p * kAvx2PanelCols + j;
+            if (col >= n) break;
+            packed[((p * depth / kAvx2DepthStep + step) * kAvx2PanelCols + j) *
+                       kAvx2DepthStep +
+                   l % kAvx2DepthStep] = b[l * ldb + col];
+          }
+        }
+      }
+      break;
+    }
+    case Isa::kAvx512Vnni: {
+      const int depth = RoundUp(k, kVnniDepthStep);
+      const int panels = RoundUp(n, kVnniPanelCols) / kVnniPanelCols;
+      data_.resize(static_cast<size_t>(panels) * depth * kVnniPanelCols, 0);
+      int8* packed = data_.data();
+      for (int p = 0; p < panels; ++p) {
+        for (int l = 0; l < k; ++l) {
+          const int step = l / kVnniDepthStep;
+          for (int j = 0; j < kVnniPanelCols; ++j) {
+            const int col = p * kVnniPanelCols + j;
+            if (col >= n) break;
+            packed[((p * depth / kVnniDepthStep + step) * kVnniPanelCols + j) *
+                       kVnniDepthStep +
+                   l % kVnniDepthStep] = b[l * ldb + col];
+          }
+        }
+      }
+      break;
+    }
+  }
+}
+
+void Multiply(const uint8* a, int lda, int row_start, int row_limit,
+              const PackedMatrixB& b, int32* c, int ldc) {
+  switch (b.isa()) {
+#ifdef TF_INT8_GEMM_HAVE_AVX512_VNNI
+    case Isa::kAvx512Vnni:
+      MultiplyBlocked<int8, kVnniPanelCols, kVnniDepthStep,
+                      MultiplyPanelVnni<1>, MultiplyPanelVnni<2>,
+                      MultiplyPanelVnni<3>, MultiplyPanelVnni<4>>(
+          a, lda, row_start, row_limit, b, c, ldc);
+      return;
+#endif
+#ifdef TF_INT8_GEMM_HAVE_AVX2
+    case Isa::kAvx2:
+      MultiplyBlocked<int16, kAvx2PanelCols, kAvx2DepthStep,
+                      MultiplyPanelAvx2<1>, MultiplyPanelAvx2<2>,
+                      MultiplyPanelAvx2<3>, MultiplyPanelAvx2<4>>(
+          a, lda, row_start, row_limit, b, c, ldc);
+      return;
+#endif
+    default:
+      MultiplyReference(a, lda, row_start, row_limit, b, c, ldc);
+      return;
+  }
+}
+
+}  // namespace int8_gemm
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
+#define TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
+
+// Matrix multiplication of uint8 activations by int8 weights with int32
+// accumulation, used by the per-channel quantized ops. The kernel is selected
+// at runtime from the instruction sets supported by the CPU:
+// *) AVX-512 VNNI: VPDPBUSD multiplies four uint8/int8 pairs and accumulates
+//    them into each int32 lane with one instruction.
+// *) AVX2: weights are widened to int16 when they are packed, and VPMADDWD
+//    multiplies and adds pairs of int16 values without saturation.
+// *) A portable reference implementation on all other CPUs.
+
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace int8_gemm {
+
+enum class Isa { kReference, kAvx2, kAvx512Vnni };
+
+// Returns the fastest instruction set supported by both the compiler and the
+// CPU, which can be lowered with the environment variable TF_INT8_GEMM_ISA
+// ("reference", "avx2" or "avx512_vnni").
+Isa GetIsa();
+
+// Returns true if kernels for 'isa' can run on this CPU.
+bool IsIsaSupported(Isa isa);
+
+// Returns the name of 'isa' as accepted by TF_INT8_GEMM_ISA.
+const char* IsaName(Isa isa);
+
+// Holds the [k, n] int8 right-hand side matrix of a multiplication ('b'), in
+// the blocked layout expected by the kernel for 'isa'. Packing is O(k * n), so
+// it is typically (but not necessarily) done once per call for constant
+// weights, and reused for all rows of the left-hand side.
+class PackedMatrixB {
+ public:
+  // Packs the row-major matrix 'b' of 'k' rows and 'n' columns with leading
+  // dimension 'ldb'.
+  PackedMatrixB(Isa isa, const int8* b, int k, int n, int ldb);
+
+  Isa isa() const { return isa_; }
+  int k() const { return k_; }
+  int n() const { return n_; }
+
+  // Returns the sum of each of the 'n' columns of 'b', which is needed to
+  // correct for the zero point of the uint8 left-hand side.
+  const int32* column_sums() const { return column_sums_.data(); }
+
+  // Returns the packed data in the layout of 'isa'.
+  const int8* data() const { return data_.data(); }
+
+ private:
+  const Isa isa_;
+  const int k_;
+  const int n_;
+  std::vector<int8> data_;
+  std::vector<int32> column_sums_;
+};
+
+// Computes c[i, j] = sum_l a[i, l] * b[l, j] for the rows 'i' in
+// [row_start, row_limit) of the row-major uint8 matrix 'a' (with leading
+// dimension 'lda' and b.k() columns), storing the result in the row-major
+// int32 matrix 'c' (with leading dimension 'ldc' and b.n() columns).
+void Multiply(const uint8* a, int lda, int row_start, int row_limit,
+              const PackedMatrixB& b, int32* c, int ldc);
+
+}  // namespace int8_gemm
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
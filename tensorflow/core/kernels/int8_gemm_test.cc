@@ -0,0 +1,126 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/int8_gemm.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace int8_gemm {
+namespace {
+
+void TestMultiply(Isa isa, int m, int k, int n) {
+  random::PhiloxRandom philox(m * 10000 + k * 100 + n);
+  random::SimplePhilox rnd(&philox);
+  const int lda = k + 3;
+  const int ldb = n + 5;
+  const int ldc = n + 7;
+  std::vector<uint8> a(m * lda);
+  for (uint8& value : a) value = static_cast<uint8>(rnd.Uniform(256));
+  std::vector<int8> b(k * ldb);
+  for (int8& value : b) value = static_cast<int8>(rnd.Uniform(256) - 128);
+
+  std::vector<int32> expected(m * n, 0);
+  std::vector<int32> expected_column_sums(n, 0);
+  for (int j = 0; j < n; ++j) {
+    for (int l = 0; l < k; ++l) {
+      expected_column_sums[j] += b[l * ldb + j];
+      for (int i = 0; i < m; ++i) {
+        expected[i * n + j] += a[i * lda + l] * b[l * ldb + j];
+      }
+    }
+  }
+
+  const PackedMatrixB packed(isa, b.data(), k, n, ldb);
+  EXPECT_EQ(isa, packed.isa());
+  for (int j = 0; j < n; ++j) {
+    EXPECT_EQ(expected_column_sums[j], packed.column_sums()[j]);
+  }
+
+  // Compute the rows in two ranges to check that partial ranges only write to
+  // their own rows.
+  const int32 kSentinel = 0x7b7b7b7b;
+  std::vector<int32> c(m * ldc, kSentinel);
+  const int split = m / 3;
+  Multiply(a.data(), lda, 0, split, packed, c.data(), ldc);
+  for (int i = split; i < m; ++i) {
+    EXPECT_EQ(kSentinel, c[i * ldc]);
+  }
+  Multiply(a.data(), lda, split, m, packed, c.data(), ldc);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      ASSERT_EQ(expected[i * n + j], c[i * ldc + j])
+          << IsaName(isa) << " m=" << m << " k=" << k << " n=" << n
+          << " i=" << i << " j=" << j;
+    }
+    for (int j = n; j < ldc; ++j) {
+      ASSERT_EQ(kSentinel, c[i * ldc + j]) << IsaName(isa);
+    }
+  }
+}
+
+void TestAllSizes(Isa isa) {
+  if (!IsIsaSupported(isa)) {
+    LOG(INFO) << "Skipping unsupported " << IsaName(isa);
+    return;
+  }
+  for (int m : {1, 2, 3, 4, 5, 67, 130}) {
+    for (int k : {1, 2, 3, 4, 5, 27, 64, 289}) {
+      for (int n : {1, 7, 16, 17, 32, 33, 70}) {
+        TestMultiply(isa, m, k, n);
+      }
+    }
+  }
+}
+
+TEST(Int8GemmTest, Reference) { TestAllSizes(Isa::kReference); }
+
+TEST(Int8GemmTest, Avx2) { TestAllSizes(Isa::kAvx2); }
+
+TEST(Int8GemmTest, Avx512Vnni) { TestAllSizes(Isa::kAvx512Vnni); }
+
+TEST(Int8GemmTest, ExtremeValues) {
+  // The largest possible magnitudes must not saturate the int32 accumulators
+  // (unlike VPMADDUBSW, which saturates pairs of products to int16).
+  for (Isa isa : {Isa::kReference, Isa::kAvx2, Isa::kAvx512Vnni}) {
+    if (!IsIsaSupported(isa)) continue;
+    const int k = 1000;
+    const int n = 3;
+    std::vector<uint8> a(k, 255);
+    std::vector<int8> b(k * n);
+    for (int l = 0; l < k; ++l) {
+      b[l * n + 0] = -128;
+      b[l * n + 1] = 127;
+      b[l * n + 2] = l % 2 == 0 ? -128 : 127;
+    }
+    const PackedMatrixB packed(isa, b.data(), k, n, n);
+    std::vector<int32> c(n);
+    Multiply(a.data(), k, 0, 1, packed, c.data(), n);
+    EXPECT_EQ(255 * -128 * k, c[0]) << IsaName(isa);
+    EXPECT_EQ(255 * 127 * k, c[1]) << IsaName(isa);
+    EXPECT_EQ(255 * -1 * k / 2, c[2]) << IsaName(isa);
+  }
+}
+
+TEST(Int8GemmTest, GetIsa) { EXPECT_TRUE(IsIsaSupported(GetIsa())); }
+
+}  // namespace
+}  // namespace int8_gemm
+}  // namespace tensorflow
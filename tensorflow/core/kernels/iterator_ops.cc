@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 
@@ -68,6 +69,75 @@ Status VerifyShapesCompatible(const std::vector<PartialTensorShape>& expected,
   return Status::OK();
 }
 
+// The prefix of the keys under which the state of an iterator is saved.
+const char kIteratorStatePrefix[] = "iterator";
+
+// Writes iterator state as scalar and tensor entries of a tensor bundle.
+class BundleIteratorStateWriter : public IteratorStateWriter {
+ public:
+  explicit BundleIteratorStateWriter(BundleWriter* writer) : writer_(writer) {}
+
+  Status WriteScalar(StringPiece key, int64 val) override {
+    Tensor val_t(DT_INT64, TensorShape({}));
+    val_t.scalar<int64>()() = val;
+    return writer_->Add(key, val_t);
+  }
+
+  Status WriteScalar(StringPiece key, const string& val) override {
+    Tensor val_t(DT_STRING, TensorShape({}));
+    val_t.scalar<string>()() = val;
+    return writer_->Add(key, val_t);
+  }
+
+  Status WriteTensor(StringPiece key, const Tensor& val) override {
+    return writer_->Add(key, val);
+  }
+
+ private:
+  BundleWriter* const writer_;  // Not owned.
+};
+
+// Reads iterator state written by a `BundleIteratorStateWriter`.
+class BundleIteratorStateReader : public IteratorStateReader {
+ public:
+  explicit BundleIteratorStateReader(BundleReader* reader) : reader_(reader) {}
+
+  Status ReadScalar(StringPiece key, int64* val) override {
+    Tensor val_t;
+    TF_RETURN_IF_ERROR(ReadScalarTensor(key, DT_INT64, &val_t));
+    *val = val_t.scalar<int64>()();
+    return Status::OK();
+  }
+
+  Status ReadScalar(StringPiece key, string* val) override {
+    Tensor val_t;
+    TF_RETURN_IF_ERROR(ReadScalarTensor(key, DT_STRING, &val_t));
+    *val = val_t.scalar<string>()();
+    return Status::OK();
+  }
+
+  Status ReadTensor(StringPiece key, Tensor* val) override {
+    return reader_->Lookup(key, val);
+  }
+
+  bool Contains(StringPiece key) override { return reader_->Contains(key); }
+
+ private:
+  Status ReadScalarTensor(StringPiece key, DataType dtype, Tensor* val) {
+    TF_RETURN_IF_ERROR(reader_->Lookup(key, val));
+    if (val->dtype() != dtype || !TensorShapeUtils::IsScalar(val->shape())) {
+      return errors::DataLoss("Expected a scalar of type ",
+                              DataTypeString(dtype), " for key \"", key,
+                              "\" but got a tensor of type ",
+                              DataTypeString(val->dtype()), " and shape ",
+                              val->shape().DebugString(), ".");
+    }
+    return Status::OK();
+  }
+
+  BundleReader* const reader_;  // Not owned.
+};
+
 class IteratorResource : public ResourceBase {
  public:
   IteratorResource(const DataTypeVector& output_dtypes,
@@ -89,6 +159,40 @@ class IteratorResource : public ResourceBase {
     }
   }
 
+  // Saves the position of the iterator as a tensor bundle with the given
+  // path prefix.
+  Status Save(Env* env, const string& path) {
+    std::shared_ptr<IteratorBase> captured_iterator(iterator_);
+    if (!captured_iterator) {
+      return errors::FailedPrecondition(
+          "Save() failed because the iterator has not been initialized. "
+          "Ensure that you have run the initializer operation for this "
+          "iterator before saving it.");
+    }
+    BundleWriter writer(env, path);
+    TF_RETURN_IF_ERROR(writer.status());
+    BundleIteratorStateWriter state_writer(&writer);
+    TF_RETURN_IF_ERROR(
+        captured_iterator->Save(kIteratorStatePrefix, &state_writer));
+    return writer.Finish();
+  }
+
+  // Restores the position saved by `Save()`. The iterator must have been
+  // initialized on a dataset with the same definition as the saved one.
+  Status Restore(IteratorContext* ctx, const string& path) {
+    std::shared_ptr<IteratorBase> captured_iterator(iterator_);
+    if (!captured_iterator) {
+      return errors::FailedPrecondition(
+          "Restore() failed because the iterator has not been initialized. "
+          "Ensure that you have run the initializer operation for this "
+          "iterator before restoring it.");
+    }
+    BundleReader reader(ctx->env(), path);
+    TF_RETURN_IF_ERROR(reader.status());
+    BundleIteratorStateReader state_reader(&reader);
+    return captured_iterator->Restore(ctx, kIteratorStatePrefix, &state_reader);
+  }
+
   // Transfers ownership of iterator to this. This method is thread-safe.
   Status set_iterator(std::unique_ptr<IteratorBase> iterator) {
     if (iterator) {
@@ -415,6 +519,53 @@ class IteratorDisposeOp : public OpKernel {
   }
 };
 
+Status GetPath(OpKernelContext* ctx, string* path) {
+  const Tensor* path_t;
+  TF_RETURN_IF_ERROR(ctx->input("path", &path_t));
+  if (!TensorShapeUtils::IsScalar(path_t->shape())) {
+    return errors::InvalidArgument("`path` must be a scalar.");
+  }
+  *path = path_t->scalar<string>()();
+  return Status::OK();
+}
+
+class SaveIteratorOp : public OpKernel {
+ public:
+  explicit SaveIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+    string path;
+    OP_REQUIRES_OK(ctx, GetPath(ctx, &path));
+    OP_REQUIRES_OK(ctx, iterator->Save(ctx->env(), path));
+  }
+};
+
+class RestoreIteratorOp : public OpKernel {
+ public:
+  explicit RestoreIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+    string path;
+    OP_REQUIRES_OK(ctx, GetPath(ctx, &path));
+
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.step_id = ctx->step_id();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+    IteratorContext iter_ctx(std::move(params));
+    OP_REQUIRES_OK(ctx, iterator->Restore(&iter_ctx, path));
+  }
+};
+
 REGISTER_KERNEL_BUILDER(Name("Iterator").Device(DEVICE_CPU), IteratorHandleOp);
 REGISTER_KERNEL_BUILDER(Name("MakeIterator").Device(DEVICE_CPU),
                         MakeIteratorOp);
@@ -424,6 +575,10 @@ REGISTER_KERNEL_BUILDER(Name("IteratorGetNext").Device(DEVICE_CPU),
                         IteratorGetNextOp);
 REGISTER_KERNEL_BUILDER(Name("IteratorDispose").Device(DEVICE_CPU),
                         IteratorDisposeOp);
+REGISTER_KERNEL_BUILDER(Name("SaveIterator").Device(DEVICE_CPU),
+                        SaveIteratorOp);
+REGISTER_KERNEL_BUILDER(Name("RestoreIterator").Device(DEVICE_CPU),
+                        RestoreIteratorOp);
 
 }  // namespace
 
@@ -0,0 +1,466 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/data_flow_ops.cc.
+
+#include "tensorflow/core/kernels/lock_free_fifo_queue.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+LockFreeFIFOQueue::LockFreeFIFOQueue(
+    int32 capacity, const DataTypeVector& component_dtypes,
+    const std::vector<TensorShape>& component_shapes, const string& name)
+    : QueueBase(capacity, component_dtypes, component_shapes, name),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      closed_fast_(false),
+      enqueue_waiters_(0),
+      dequeue_waiters_(0),
+      num_restored_(0) {}
+
+Status LockFreeFIFOQueue::Initialize() {
+  if (component_dtypes_.empty()) {
+    return errors::InvalidArgument("Empty component types for queue ", name_);
+  }
+  if (component_dtypes_.size() != component_shapes_.size()) {
+    return errors::InvalidArgument(
+        "LockFreeFIFOQueue requires one shape per component.  ", "Types: ",
+        DataTypeSliceString(component_dtypes_), ", Shapes: ",
+        ShapeListString(component_shapes_));
+  }
+  if (capacity_ <= 0 || capacity_ > kMaxCapacity) {
+    return errors::InvalidArgument("LockFreeFIFOQueue capacity must be in [1, ",
+                                   kMaxCapacity, "], got ", capacity_);
+  }
+  ring_.reset(new Slot[capacity_]);
+  for (int32 i = 0; i < capacity_; ++i) {
+    ring_[i].sequence.store(i, std::memory_order_relaxed);
+    ring_[i].element.resize(num_components());
+  }
+  for (int i = 0; i < num_components(); ++i) {
+    element_bytes_ += component_shapes_[i].num_elements() *
+                      DataTypeSize(component_dtypes_[i]);
+  }
+  return Status::OK();
+}
+
+bool LockFreeFIFOQueue::TryPush(const Tuple& tuple) {
+  uint64 pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &ring_[pos % capacity_];
+    const uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+    const int64 diff = static_cast<int64>(sequence - pos);
+    if (diff == 0) {
+      // The slot is free: claim position 'pos'.
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the element from the previous lap.
+      return false;
+    } else {
+      // Another producer claimed 'pos' first.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  for (int i = 0; i < num_components(); ++i) {
+    slot->element[i] = PersistentTensor(tuple[i]);
+  }
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool LockFreeFIFOQueue::TryPop(OpKernelContext* ctx, Tuple* tuple) {
+  uint64 pos = dequeue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &ring_[pos % capacity_];
+    const uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+    const int64 diff = static_cast<int64>(sequence - (pos + 1));
+    if (diff == 0) {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // No element has been published at 'pos' yet.
+      return false;
+    } else {
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    tuple->push_back(*slot->element[i].AccessTensor(ctx));
+    slot->element[i] = PersistentTensor();
+  }
+  slot->sequence.store(pos + capacity_, std::memory_order_release);
+  return true;
+}
+
+int64 LockFreeFIFOQueue::RingSize() const {
+  const uint64 dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+  const uint64 enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+  if (enqueue_pos <= dequeue_pos) return 0;
+  return std::min<int64>(enqueue_pos - dequeue_pos, capacity_);
+}
+
+int64 LockFreeFIFOQueue::SizeLocked() const {
+  return RingSize() + restored_.size();
+}
+
+int32 LockFreeFIFOQueue::size() {
+  return RingSize() + num_restored_.load(std::memory_order_relaxed);
+}
+
+int64 LockFreeFIFOQueue::MemoryUsed() const {
+  return (RingSize() + num_restored_.load(std::memory_order_relaxed)) *
+         element_bytes_;
+}
+
+bool LockFreeFIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
+  if (restored_.empty()) {
+    return TryPop(ctx, tuple);
+  }
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    tuple->push_back(*restored_.front()[i].AccessTensor(ctx));
+  }
+  restored_.pop_front();
+  num_restored_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+void LockFreeFIFOQueue::AddAttempt(Action action, int32 elements_requested,
+                                   DoneCallback done_callback,
+                                   OpKernelContext* ctx,
+                                   RunCallback run_callback,
+                                   const DoneCallback& cancelled) {
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, action, cm, token]() { Cancel(action, cm, token); });
+    if (!already_cancelled) {
+      if (action == kEnqueue) {
+        enqueue_attempts_.emplace_back(elements_requested, done_callback, ctx,
+                                       cm, token, run_callback);
+        enqueue_waiters_.store(enqueue_attempts_.size());
+      } else {
+        dequeue_attempts_.emplace_back(elements_requested, done_callback, ctx,
+                                       cm, token, run_callback);
+        dequeue_waiters_.store(dequeue_attempts_.size());
+      }
+    }
+  }
+  if (!already_cancelled) {
+    // Pairs with the fence in MaybeWakeWaiters(): either the attempt sees
+    // the element (or free slot) left by a lock-free operation, or that
+    // operation sees the raised waiter count and flushes.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    FlushAndUpdateWaiters();
+  } else {
+    cancelled();
+  }
+}
+
+void LockFreeFIFOQueue::FlushAndUpdateWaiters() {
+  FlushUnlocked();
+  mutex_lock l(mu_);
+  enqueue_waiters_.store(enqueue_attempts_.size());
+  dequeue_waiters_.store(dequeue_attempts_.size());
+}
+
+void LockFreeFIFOQueue::MaybeWakeWaiters(Action action) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const std::atomic<int64>& waiters =
+      action == kEnqueue ? enqueue_waiters_ : dequeue_waiters_;
+  if (waiters.load(std::memory_order_relaxed) > 0) {
+    FlushAndUpdateWaiters();
+  }
+}
+
+void LockFreeFIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                                   DoneCallback callback) {
+  if (!closed_fast_.load(std::memory_order_acquire) &&
+      enqueue_waiters_.load(std::memory_order_acquire) == 0 &&
+      TryPush(tuple)) {
+    MaybeWakeWaiters(kDequeue);
+    callback();
+    return;
+  }
+  AddAttempt(kEnqueue, 1, callback, ctx,
+             [tuple, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+               if (closed_) {
+                 attempt->context->SetStatus(
+                     errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+                 return kComplete;
+               }
+               return TryPush(tuple) ? kComplete : kNoProgress;
+             },
+             [ctx, callback]() {
+               ctx->SetStatus(
+                   errors::Cancelled("Enqueue operation was cancelled"));
+               callback();
+             });
+}
+
+void LockFreeFIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                                       DoneCallback callback) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  if (batch_size == 0) {
+    callback();
+    return;
+  }
+  AddAttempt(
+      kEnqueue, batch_size, callback, ctx,
+      [tuple, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (closed_) {
+          attempt->context->SetStatus(
+              errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+          return kComplete;
+        }
+        RunResult result = kNoProgress;
+        while (RingSize() < capacity_) {
+          const int64 index =
+              tuple[0].dim_size(0) - attempt->elements_requested;
+          Tuple element;
+          element.reserve(num_components());
+          for (int i = 0; i < num_components(); ++i) {
+            Tensor component;
+            attempt->context->SetStatus(attempt->context->allocate_temp(
+                component_dtypes_[i], component_shapes_[i], &component));
+            if (!attempt->context->status().ok()) return kComplete;
+            attempt->context->SetStatus(
+                CopySliceToElement(tuple[i], &component, index));
+            if (!attempt->context->status().ok()) return kComplete;
+            element.push_back(component);
+          }
+          // A lock-free enqueue may have taken the last slot.
+          if (!TryPush(element)) break;
+          result = kProgress;
+          --attempt->elements_requested;
+          if (attempt->elements_requested == 0) {
+            return kComplete;
+          }
+        }
+        return result;
+      },
+      [ctx, callback]() {
+        ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+        callback();
+      });
+}
+
+void LockFreeFIFOQueue::TryDequeue(OpKernelContext* ctx,
+                                   CallbackWithTuple callback) {
+  if (dequeue_waiters_.load(std::memory_order_acquire) == 0 &&
+      num_restored_.load(std::memory_order_acquire) == 0) {
+    Tuple tuple;
+    if (TryPop(ctx, &tuple)) {
+      MaybeWakeWaiters(kEnqueue);
+      callback(tuple);
+      return;
+    }
+  }
+  AddAttempt(
+      kDequeue, 1, [callback]() { callback(Tuple()); }, ctx,
+      [callback, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Tuple tuple;
+        if (DequeueLocked(attempt->context, &tuple)) {
+          attempt->done_callback = [callback, tuple]() { callback(tuple); };
+          return kComplete;
+        }
+        if (closed_) {
+          attempt->context->SetStatus(errors::OutOfRange(
+              "FIFOQueue '", name_, "' is closed and has ",
+              "insufficient elements (requested ", 1, ", current size ",
+              SizeLocked(), ")"));
+          return kComplete;
+        }
+        return kNoProgress;
+      },
+      [ctx, callback]() {
+        ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+        callback(Tuple());
+      });
+}
+
+void LockFreeFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                                       bool allow_small_batch,
+                                       CallbackWithTuple callback) {
+  if (num_elements == 0) {
+    // See the corresponding comment in FIFOQueue::TryDequeueMany().
+    Tuple tuple;
+    tuple.reserve(num_components());
+    for (int i = 0; i < num_components(); ++i) {
+      Tensor element;
+      Status status = ctx->allocate_temp(component_dtypes_[i],
+                                         ManyOutShape(i, 0), &element);
+      if (!status.ok()) {
+        ctx->SetStatus(status);
+        callback(Tuple());
+        return;
+      }
+      tuple.emplace_back(element);
+    }
+    callback(tuple);
+    return;
+  }
+
+  AddAttempt(
+      kDequeue, num_elements, [callback]() { callback(Tuple()); }, ctx,
+      [callback, allow_small_batch, this](Attempt* attempt)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            int64 queue_size = SizeLocked();
+
+            if (closed_ && queue_size < attempt->elements_requested) {
+              // If we don't have enough for a full dequeue, we have
+              // to reset the attempt tuple.
+              if (!attempt->tuple.empty()) {
+                // Restore already-dequeued elements to the front of the
+                // queue.
+                for (int64 i = attempt->tuple[0].dim_size(0) -
+                               attempt->elements_requested - 1;
+                     i >= 0; --i) {
+                  std::vector<PersistentTensor> element(num_components());
+                  for (int j = 0; j < num_components(); ++j) {
+                    Tensor* element_access = nullptr;
+                    Status s = attempt->context->allocate_persistent(
+                        component_dtypes_[j], component_shapes_[j],
+                        &element[j], &element_access);
+                    if (s.ok()) {
+                      s = CopySliceToElement(attempt->tuple[j],
+                                             element_access, i);
+                    }
+                    if (!s.ok()) {
+                      attempt->context->SetStatus(
+                          errors::DataLoss("Failed to restore element from "
+                                           "partially-dequeued batch "
+                                           "to FIFOQueue: ",
+                                           s.error_message()));
+                    }
+                  }
+                  restored_.push_front(std::move(element));
+                  num_restored_.fetch_add(1, std::memory_order_relaxed);
+                }
+              }
+              queue_size = SizeLocked();
+              if (allow_small_batch && queue_size > 0) {
+                // Request all remaining elements in the queue.
+                attempt->tuple.clear();
+                attempt->elements_requested = queue_size;
+              } else {
+                if (allow_small_batch) {
+                  // There may be some other attempts containing
+                  // values.  If so, we'll yield and wait for them
+                  // to add elements to the queue.
+                  if (!enqueue_attempts_.empty()) return kProgress;
+                }
+                if (attempt->context->status().ok()) {
+                  attempt->context->SetStatus(errors::OutOfRange(
+                      "FIFOQueue '", name_, "' is closed and has ",
+                      "insufficient elements (requested ",
+                      attempt->elements_requested, ", current size ",
+                      queue_size, ")"));
+                }
+                return kComplete;
+              }
+            }
+
+            RunResult result = kNoProgress;
+            for (; queue_size > 0; --queue_size) {
+              if (attempt->tuple.empty()) {
+                // Only allocate tuple when we have something to dequeue
+                // so we don't use excessive memory when there are many
+                // blocked dequeue attempts waiting.
+                attempt->tuple.reserve(num_components());
+                for (int i = 0; i < num_components(); ++i) {
+                  const TensorShape shape =
+                      ManyOutShape(i, attempt->elements_requested);
+                  Tensor element;
+                  attempt->context->SetStatus(attempt->context->allocate_temp(
+                      component_dtypes_[i], shape, &element));
+                  if (!attempt->context->status().ok()) return kComplete;
+                  attempt->tuple.emplace_back(element);
+                }
+              }
+              Tuple tuple;
+              // A lock-free dequeue may have taken the element.
+              if (!DequeueLocked(attempt->context, &tuple)) break;
+              result = kProgress;
+              const int64 index =
+                  attempt->tuple[0].dim_size(0) - attempt->elements_requested;
+              for (int i = 0; i < num_components(); ++i) {
+                attempt->context->SetStatus(
+                    CopyElementToSlice(tuple[i], &attempt->tuple[i], index));
+                if (!attempt->context->status().ok()) return kComplete;
+              }
+              tuple.clear();
+              --attempt->elements_requested;
+              if (attempt->elements_requested == 0) {
+                tuple = attempt->tuple;
+                attempt->done_callback = [callback, tuple]() {
+                  callback(tuple);
+                };
+                return kComplete;
+              }
+            }
+            return result;
+          },
+      [ctx, callback]() {
+        ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+        callback(Tuple());
+      });
+}
+
+void LockFreeFIFOQueue::Close(OpKernelContext* ctx,
+                              bool cancel_pending_enqueues,
+                              DoneCallback callback) {
+  // Send later enqueues to the slow path, which checks closed_.
+  closed_fast_.store(true, std::memory_order_release);
+  QueueBase::Close(ctx, cancel_pending_enqueues, callback);
+}
+
+Status LockFreeFIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
+  if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
+      !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
+    return errors::InvalidArgument("Expected FIFOQueue, found ", node_def.op());
+  }
+  TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
+  TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
+  TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,140 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+#define TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A FIFOQueue for bounded queues whose components all have specified
+// shapes. Elements live in a bounded lock-free ring buffer, so that
+// Enqueue and Dequeue of a single element complete without taking mu_
+// whenever they can do so immediately and nobody is waiting ahead of
+// them. Only operations that must wait (the queue is full or empty, or
+// closed), EnqueueMany and DequeueMany/UpTo go through the attempt
+// machinery of QueueBase, which then uses the same ring buffer under mu_.
+//
+// Behaves like FIFOQueue, including the order in which waiting attempts
+// are satisfied.
+class LockFreeFIFOQueue : public QueueBase {
+ public:
+  // Rings are allocated up front, so larger capacities use a FIFOQueue.
+  static const int32 kMaxCapacity = 1 << 16;
+
+  // REQUIRES: 0 < capacity <= kMaxCapacity, and component_shapes has one
+  // shape per component.
+  LockFreeFIFOQueue(int32 capacity, const DataTypeVector& component_dtypes,
+                    const std::vector<TensorShape>& component_shapes,
+                    const string& name);
+
+  Status Initialize();  // Must be called before any other method.
+
+  // Implementations of QueueInterface methods --------------------------------
+
+  void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                  DoneCallback callback) override;
+  void TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                      DoneCallback callback) override;
+  void TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) override;
+  void TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                      bool allow_small_batch,
+                      CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
+  Status MatchesNodeDef(const NodeDef& node_def) override;
+
+  int32 size() override;
+
+  int64 MemoryUsed() const override;
+
+ protected:
+  ~LockFreeFIFOQueue() override {}
+
+ private:
+  // One ring buffer slot. 'sequence' tells producers and consumers whose
+  // turn it is to use the slot, as in Vyukov's bounded MPMC queue.
+  struct Slot {
+    std::atomic<uint64> sequence;
+    std::vector<PersistentTensor> element;
+  };
+
+  // Lock-free ring buffer operations. TryPush returns false if the ring
+  // is full, TryPop if it is empty.
+  bool TryPush(const Tuple& tuple);
+  bool TryPop(OpKernelContext* ctx, Tuple* tuple);
+  int64 RingSize() const;
+
+  // Number of elements that can be dequeued.
+  int64 SizeLocked() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Helper for dequeuing a single element. Returns false if there is no
+  // element available.
+  bool DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Registers an attempt of kind 'action' and makes as much progress as
+  // possible on the pending attempts. Calls 'cancelled' instead if the
+  // operation was already cancelled.
+  void AddAttempt(Action action, int32 elements_requested,
+                  DoneCallback done_callback, OpKernelContext* ctx,
+                  RunCallback run_callback, const DoneCallback& cancelled);
+
+  // Calls FlushUnlocked() and then lowers the waiter counts to the number
+  // of attempts that are still pending.
+  void FlushAndUpdateWaiters();
+
+  // Runs FlushAndUpdateWaiters() if an attempt of kind 'action' may be
+  // waiting for an element (or slot) that was just added.
+  void MaybeWakeWaiters(Action action);
+
+  std::unique_ptr<Slot[]> ring_;
+  std::atomic<uint64> enqueue_pos_;
+  std::atomic<uint64> dequeue_pos_;
+
+  // Mirror closed_ and the sizes of enqueue_attempts_, dequeue_attempts_
+  // and restored_ for the lock-free paths. The waiter counts are raised
+  // under mu_ before an attempt is added and may lag behind when attempts
+  // finish, which only sends the lock-free paths to the slow path.
+  std::atomic<bool> closed_fast_;
+  std::atomic<int64> enqueue_waiters_;
+  std::atomic<int64> dequeue_waiters_;
+  std::atomic<int64> num_restored_;
+
+  // Elements of a partially dequeued batch that were handed back when the
+  // queue was closed. They are dequeued before the ring.
+  std::deque<std::vector<PersistentTensor>> restored_ GUARDED_BY(mu_);
+
+  int64 element_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LockFreeFIFOQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
@@ -33,6 +33,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -41,6 +43,8 @@ namespace {
 static const int kInputBufferSize = 1 * 1024 * 1024; /* bytes */
 static const int kLineNumber = -1;
 static const int kWholeLine = -2;
+// The most lines TextFileLineIterator parses at a time.
+static const int64 kLinesPerBatch = 64 * 1024;
 
 // Iterator to initialize tables given 'keys' and 'values' tensors.
 //
@@ -113,9 +117,10 @@ Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
   return Status::OK();
 }
 
-// Iterator that reads a text file. Each iteration process one line, it parses
-// the line and populates the keys and values tensors used for initialization
-// with a single key and corresponding value.
+// Iterator that reads a text file. Each iteration reads a batch of lines,
+// parses them and populates the keys and values tensors used for
+// initialization with a key and corresponding value per line. The lines of a
+// batch are parsed in parallel if a thread pool is given.
 //
 // What information of the line to populate the key or values is specified by
 // providing key_index and value_index.
@@ -137,19 +142,23 @@ class TextFileLineIterator
   // - Index -1 means the line number stored in int64.
   // - Index >= 0 represent index (starting at zero) of the split line based on
   //   delimiter.
+  //
+  // 'thread_pool' may be nullptr, in which case the lines are parsed on the
+  // calling thread.
   Status Init(const string& filename, int64 vocab_size, char delimiter,
               DataType key_dtype, int64 key_index, DataType value_dtype,
-              int64 value_index, Env* env) {
+              int64 value_index, Env* env, thread::ThreadPool* thread_pool) {
     if (vocab_size == -1) {
       TF_RETURN_IF_ERROR(GetNumLinesInTextFile(env, filename, &vocab_size));
     }
     filename_ = filename;
     vocab_size_ = vocab_size;
     delimiter_ = delimiter;
-    key_ = Tensor(key_dtype, TensorShape({}));
-    value_ = Tensor(value_dtype, TensorShape({}));
+    key_dtype_ = key_dtype;
+    value_dtype_ = value_dtype;
     key_index_ = key_index;
     value_index_ = value_index;
+    thread_pool_ = thread_pool;
 
     status_ = env->NewRandomAccessFile(filename_, &file_);
     if (!status_.ok()) return status_;
@@ -165,58 +174,77 @@ class TextFileLineIterator
   void Next() override {
     if (!valid_) return;
 
+    // Read the lines of the batch sequentially.
+    const int64 batch_size = std::min(kLinesPerBatch, vocab_size_ - next_id_);
+    lines_.clear();
+    line_ends_.clear();
     string line;
-    status_ = input_buffer_->ReadLine(&line);
-    if (!status_.ok()) {
-      if (errors::IsOutOfRange(status_) && next_id_ != vocab_size_) {
-        status_ = errors::InvalidArgument("Invalid vocab_size in ", filename_,
-                                          ": expected ", vocab_size_,
-                                          " but got ", next_id_);
-      }
-      valid_ = false;
-      return;
+    while (static_cast<int64>(lines_.size()) < batch_size) {
+      status_ = input_buffer_->ReadLine(&line);
+      if (!status_.ok()) break;
+      lines_.push_back(std::move(line));
+      line_ends_.push_back(input_buffer_->Tell());
     }
-    if (next_id_ >= vocab_size_) {
-      LOG(WARNING) << "Truncated " << filename_ << " before its end at "
-                   << vocab_size_ << " records.";
-      LOG(WARNING) << "next_id_  : " << next_id_;
-      status_ = errors::OutOfRange("Finished reading ", vocab_size_,
-                                   " of lines from ", filename_);
+    if (!status_.ok() && !errors::IsOutOfRange(status_)) {
       valid_ = false;
       return;
     }
-    if (line.empty()) {
-      status_ = errors::InvalidArgument("Invalid content in ", filename_,
-                                        ": empty line found at position ",
-                                        input_buffer_->Tell(), ".");
+    if (lines_.empty()) {
+      if (status_.ok() && input_buffer_->ReadLine(&line).ok()) {
+        LOG(WARNING) << "Truncated " << filename_ << " before its end at "
+                     << vocab_size_ << " records.";
+        LOG(WARNING) << "next_id_  : " << next_id_;
+        status_ = errors::OutOfRange("Finished reading ", vocab_size_,
+                                     " of lines from ", filename_);
+      } else if (next_id_ != vocab_size_) {
+        status_ = errors::InvalidArgument("Invalid vocab_size in ", filename_,
+                                          ": expected ", vocab_size_,
+                                          " but got ", next_id_);
+      } else {
+        status_ = errors::OutOfRange("No more data.");
+      }
       valid_ = false;
       return;
     }
 
-    std::vector<string> tokens;
-    if (!ignore_split_) {
-      tokens = str_util::Split(line, delimiter_);
-      if (std::max(key_index_, value_index_) >= tokens.size()) {
-        status_ = errors::InvalidArgument(
-            "Invalid number of columns in ", filename_, " line ", next_id_,
-            " (", line, ") : expected ", std::max(key_index_, value_index_),
-            " got ", tokens.size());
-        valid_ = false;
-        return;
+    // Parse them in parallel, and report the error of the first bad line.
+    const int64 num_lines = lines_.size();
+    key_ = Tensor(key_dtype_, TensorShape({num_lines}));
+    value_ = Tensor(value_dtype_, TensorShape({num_lines}));
+    mutex mu;
+    int64 error_line = num_lines;
+    Status error;
+    auto parse_lines = [this, &mu, &error_line, &error](int64 start,
+                                                        int64 limit) {
+      std::vector<string> tokens;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseLine(i, &tokens);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < error_line) {
+            error_line = i;
+            error = s;
+          }
+          return;
+        }
       }
+    };
+    if (thread_pool_ == nullptr) {
+      parse_lines(0, num_lines);
+    } else {
+      // The cost of a line depends on its length and the field types.
+      static ShardCostCalibration* calibration =
+          new ShardCostCalibration("TextFileLineIterator", 1000);
+      Shard(thread_pool_->NumThreads(), thread_pool_, num_lines, calibration,
+            parse_lines);
     }
-    status_ = SetValue(line, tokens, key_index_, &key_);
-    if (!status_.ok()) {
+    if (!error.ok()) {
+      status_ = error;
       valid_ = false;
       return;
     }
-    status_ = SetValue(line, tokens, value_index_, &value_);
-    if (!status_.ok()) {
-      valid_ = false;
-      return;
-    }
-
-    next_id_++;
+    status_ = Status::OK();
+    next_id_ += num_lines;
   }
 
   bool Valid() const override { return valid_; }
@@ -233,23 +261,55 @@ class TextFileLineIterator
   Tensor key_;
   Tensor value_;
   bool valid_;  // true if the iterator points to an existing range.
+  DataType key_dtype_;
+  DataType value_dtype_;
   int64 key_index_;
   int64 value_index_;
+  // The line number of the first line of the batch.
   int64 next_id_;
   int64 vocab_size_;
   string filename_;
   char delimiter_;
   Status status_;
   bool ignore_split_;
+  thread::ThreadPool* thread_pool_;  // Not owned; may be nullptr.
   std::unique_ptr<RandomAccessFile> file_;  // must outlive input_buffer_
   std::unique_ptr<io::InputBuffer> input_buffer_;
+  // The lines of the batch, and the offsets in the file of their ends.
+  std::vector<string> lines_;
+  std::vector<int64> line_ends_;
+
+  // Parses the 'i'-th line of the batch into element 'i' of the keys and
+  // values tensors. 'tokens' is scratch space.
+  Status ParseLine(int64 i, std::vector<string>* tokens) {
+    const string& line = lines_[i];
+    const int64 line_id = next_id_ + i;
+    if (line.empty()) {
+      return errors::InvalidArgument("Invalid content in ", filename_,
+                                     ": empty line found at position ",
+                                     line_ends_[i], ".");
+    }
+    if (!ignore_split_) {
+      *tokens = str_util::Split(line, delimiter_);
+      if (std::max(key_index_, value_index_) >= tokens->size()) {
+        return errors::InvalidArgument(
+            "Invalid number of columns in ", filename_, " line ", line_id,
+            " (", line, ") : expected ", std::max(key_index_, value_index_),
+            " got ", tokens->size());
+      }
+    }
+    TF_RETURN_IF_ERROR(SetValue(line, *tokens, key_index_, line_id, i, &key_));
+    return SetValue(line, *tokens, value_index_, line_id, i, &value_);
+  }
 
-  // Set the corresponding value from line or tokens based on 'index' into the
-  // tensor 't'. The value is transformed to the given data type 'dtype'.
-  Status SetValue(const string& line, const std::vector<string>& tokens,
-                  int64 index, Tensor* tensor) {
+  // Set the corresponding value from line or tokens based on 'index' into
+  // element 'position' of the tensor 't'. The value is transformed to the
+  // given data type 'dtype'.
+  static Status SetValue(const string& line, const std::vector<string>& tokens,
+                         int64 index, int64 line_id, int64 position,
+                         Tensor* tensor) {
     if (index == kLineNumber) {
-      tensor->flat<int64>()(0) = next_id_;
+      tensor->flat<int64>()(position) = line_id;
       return Status::OK();
     }
     const string& token = (index == kWholeLine) ? line : tokens[index];
@@ -258,44 +318,39 @@ class TextFileLineIterator
       case DT_INT32: {
         int32 value;
         if (!strings::safe_strto32(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid int32.");
         }
-        tensor->flat<int32>()(0) = value;
+        tensor->flat<int32>()(position) = value;
       } break;
       case DT_INT64: {
         int64 value;
         if (!strings::safe_strto64(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid int64.");
         }
-        tensor->flat<int64>()(0) = value;
+        tensor->flat<int64>()(position) = value;
       } break;
       case DT_FLOAT: {
         float value;
         if (!strings::safe_strtof(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid float.");
         }
-        tensor->flat<float>()(0) = value;
+        tensor->flat<float>()(position) = value;
       } break;
       case DT_DOUBLE: {
         double value;
         if (!strings::safe_strtod(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
+          return errors::InvalidArgument("Field ", token, " in line ", line_id,
                                          " is not a valid double.");
         }
-        tensor->flat<double>()(0) = value;
+        tensor->flat<double>()(position) = value;
       } break;
       case DT_STRING:
-        tensor->flat<string>()(0) = token;
+        tensor->flat<string>()(position) = token;
         break;
       default:
-        valid_ = false;
         return errors::InvalidArgument("Data type ", dtype, " not supported.");
     }
     return Status::OK();
@@ -311,6 +366,15 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    char delimiter, int32 key_index,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table) {
+  return InitializeTableFromTextFile(filename, vocab_size, delimiter, key_index,
+                                     value_index, env, nullptr, table);
+}
+
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table) {
   if (key_index == kLineNumber && table->key_dtype() != DT_INT64) {
     return errors::InvalidArgument(
         "Key index for line number requires table key dtype of int64, got ",
@@ -337,7 +401,8 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
 
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
-                               key_index, value_dtype, value_index, env));
+                               key_index, value_dtype, value_index, env,
+                               thread_pool));
   // For initialization from files, ignore if the table is already
   // initialized. The table shared name should contain the filename to
   // avoid trying to initialize the same table from the same file at the same
@@ -457,9 +522,12 @@ class InitializeTableFromTextFileOp : public OpKernel {
     if (ctx->track_allocations()) {
       memory_used_before = table->MemoryUsed();
     }
-    OP_REQUIRES_OK(ctx, lookup::InitializeTableFromTextFile(
-                            vocab_filename, vocab_size_, delimiter_, key_index_,
-                            value_index_, ctx->env(), table));
+    OP_REQUIRES_OK(ctx,
+                   lookup::InitializeTableFromTextFile(
+                       vocab_filename, vocab_size_, delimiter_, key_index_,
+                       value_index_, ctx->env(),
+                       ctx->device()->tensorflow_cpu_worker_threads()->workers,
+                       table));
     if (ctx->track_allocations()) {
       ctx->record_host_persistent_memory_allocation(table->MemoryUsed() -
                                                     memory_used_before);
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_LOOKUP_TABLE_INIT_OP_H_
 
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -27,6 +28,13 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table);
 
+// As above, but parses the lines of the file on 'thread_pool'.
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table);
+
 }  // namespace lookup
 }  // namespace tensorflow
 
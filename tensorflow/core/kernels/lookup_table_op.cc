@@ -16,15 +16,19 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -267,6 +271,11 @@ TensorShape MaybeVectorizeShape(const TensorShape& shape) {
 }  // namespace
 
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
+//
+// The buckets are split into `num_shards` shards. Each shard has its own lock
+// and grows independently, so rebucketing one shard only blocks the keys that
+// hash to it. Find and Insert group their keys by shard and process the shards
+// in parallel on the device's CPU worker threads.
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
  public:
@@ -301,134 +310,157 @@ class MutableDenseHashTable final : public LookupInterface {
         empty_key_input->template shaped<K, 2>({1, key_shape_.num_elements()}),
         0);
 
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards_));
     int64 initial_num_buckets;
     OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_num_buckets",
                                     &initial_num_buckets));
-    OP_REQUIRES_OK(ctx, AllocateBuckets(ctx, initial_num_buckets));
+    OP_REQUIRES_OK(ctx, CheckNumBuckets(initial_num_buckets));
+    // Spread the initial buckets over the shards, keeping a power of 2 per
+    // shard.
+    initial_shard_buckets_ = 4;
+    while (initial_shard_buckets_ * num_shards_ < initial_num_buckets) {
+      initial_shard_buckets_ <<= 1;
+    }
+    for (int i = 0; i < num_shards_; ++i) {
+      shards_.emplace_back(new TableShard);
+      TableShard* shard = shards_.back().get();
+      mutex_lock l(shard->mu);
+      OP_REQUIRES_OK(ctx, AllocateBuckets(ctx, shard, initial_shard_buckets_));
+    }
   }
 
-  size_t size() const override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    return num_entries_;
+  size_t size() const override {
+    size_t num_entries = 0;
+    for (const auto& shard : shards_) {
+      mutex_lock l(shard->mu);
+      num_entries += shard->num_entries;
+    }
+    return num_entries;
   }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
-              const Tensor& default_value) override LOCKS_EXCLUDED(mu_) {
+              const Tensor& default_value) override {
     const int64 num_elements = key.dim_size(0);
     const int64 key_size = key_shape_.num_elements();
     const int64 value_size = value_shape_.num_elements();
-    if (key.NumElements() != num_elements * key_size) {
-      TensorShape expected_shape({num_elements});
-      expected_shape.AppendShape(key_shape_);
-      return errors::InvalidArgument("Expected key shape ",
-                                     expected_shape.DebugString(), " got ",
-                                     key.shape().DebugString());
-    }
+    TF_RETURN_IF_ERROR(CheckKeyMatrixShape(key));
     const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
     auto value_matrix = value->shaped<V, 2>({num_elements, value_size});
     const auto default_flat = default_value.flat<V>();
-
-    mutex_lock l(mu_);
-    const auto key_buckets_matrix =
-        key_buckets_.AccessTensor(ctx)->template matrix<K>();
-    const auto value_buckets_matrix =
-        value_buckets_.AccessTensor(ctx)->template matrix<V>();
-    const auto empty_key_matrix =
-        empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
-    const int64 bit_mask = num_buckets_ - 1;
-    // TODO(andreasst): parallelize using work_sharder
-    for (int64 i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
-      if (empty_key_hash_ == key_hash &&
-          IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the empty_key as a table key is not allowed");
-      }
-      int64 bucket_index = key_hash & bit_mask;
-      int64 num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
+    const auto empty_key_matrix = EmptyKeyMatrix(ctx);
+
+    std::vector<uint64> key_hashes;
+    std::vector<std::vector<int64>> shard_rows;
+    TF_RETURN_IF_ERROR(PartitionKeys(key_matrix, empty_key_matrix, false,
+                                     &key_hashes, &shard_rows));
+    auto find_in_shard = [&](TableShard* shard,
+                             const std::vector<int64>& rows) -> Status {
+      mutex_lock l(shard->mu);
+      const auto key_buckets_matrix =
+          shard->key_buckets.AccessTensor(ctx)->template matrix<K>();
+      const auto value_buckets_matrix =
+          shard->value_buckets.AccessTensor(ctx)->template matrix<V>();
+      for (const int64 i : rows) {
+        int64 bucket_index;
+        TF_RETURN_IF_ERROR(FindBucket(key_buckets_matrix, shard->num_buckets,
+                                      empty_key_matrix, key_matrix, i,
+                                      key_hashes[i], &bucket_index));
+        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
+          for (int64 j = 0; j < value_size; ++j) {
+            value_matrix(i, j) =
+                SubtleMustCopyUnlessStringOrFloat(default_flat(j));
+          }
+        } else {
           for (int64 j = 0; j < value_size; ++j) {
             // TODO(andreasst): check if we can get rid of SubtleMustCopy
             // here and elsewhere in this file.
             value_matrix(i, j) = SubtleMustCopyUnlessStringOrFloat(
                 value_buckets_matrix(bucket_index, j));
           }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
-          for (int64 j = 0; j < value_size; ++j) {
-            value_matrix(i, j) =
-                SubtleMustCopyUnlessStringOrFloat(default_flat(j));
-          }
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable lookup");
         }
       }
-    }
-    return Status::OK();
+      return Status::OK();
+    };
+    return ForEachShard(ctx, shard_rows, find_in_shard);
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& key,
-                const Tensor& value) override LOCKS_EXCLUDED(mu_) {
-    if (key.NumElements() != key.dim_size(0) * key_shape_.num_elements()) {
-      TensorShape expected_shape({key.dim_size(0)});
-      expected_shape.AppendShape(key_shape_);
-      return errors::InvalidArgument("Expected key shape ",
-                                     expected_shape.DebugString(), " got ",
-                                     key.shape().DebugString());
-    }
-    mutex_lock l(mu_);
-    // For simplicity we assume that all keys in the input result in inserts
-    // rather than updates. That means we may grow the table even though we
-    // don't need to. As long as the number of keys inserted in one call is
-    // small compared to the size of the map, the impact of this is minimal.
-    const int64 pending_num_entries = num_entries_ + key.dim_size(0);
-    if (pending_num_entries > num_buckets_ * max_load_factor_) {
-      int64 new_num_buckets = num_buckets_;
-      do {
-        new_num_buckets <<= 1;
-      } while (pending_num_entries > new_num_buckets * max_load_factor_);
-      TF_RETURN_IF_ERROR(Rebucket(ctx, new_num_buckets));
-    }
+                const Tensor& value) override {
+    TF_RETURN_IF_ERROR(CheckKeyMatrixShape(key));
     return DoInsert(ctx, key, value, false);
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
-                      const Tensor& values) override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    num_buckets_ = keys.dim_size(0);
-    key_buckets_ = PersistentTensor(keys);
-    value_buckets_ = PersistentTensor(values);
-    // Count the number of keys that are not the empty_key. This requires
-    // iterating through the whole table but that is OK as we only execute it
-    // during checkpoint restore.
-    num_entries_ = 0;
-    const auto empty_key_tensor =
-        empty_key_.AccessTensor(ctx)->template shaped<K, 2>(
-            {1, key_shape_.num_elements()});
-    const auto key_buckets_tensor =
-        key_buckets_.AccessTensor(ctx)->template matrix<K>();
-    for (int64 i = 0; i < num_buckets_; ++i) {
-      if (!IsEqualKey(key_buckets_tensor, i, empty_key_tensor, 0)) {
-        ++num_entries_;
+                      const Tensor& values) override {
+    const int64 num_buckets = keys.dim_size(0);
+    if (num_shards_ == 1 && CheckNumBuckets(num_buckets).ok()) {
+      TableShard* shard = shards_[0].get();
+      mutex_lock l(shard->mu);
+      // Count the number of keys that are not the empty_key. This requires
+      // iterating through the whole table but that is OK as we only execute
+      // it during checkpoint restore.
+      int64 num_entries;
+      if (CountEntriesIfInPlace(ctx, keys, &num_entries)) {
+        shard->num_entries = num_entries;
+        shard->num_buckets = num_buckets;
+        shard->key_buckets = PersistentTensor(keys);
+        shard->value_buckets = PersistentTensor(values);
+        return Status::OK();
       }
     }
-    return Status::OK();
+    // The buckets were exported by a table with a different number of shards,
+    // so empty the table and insert every non-empty bucket again.
+    for (const auto& shard : shards_) {
+      mutex_lock l(shard->mu);
+      TF_RETURN_IF_ERROR(
+          AllocateBuckets(ctx, shard.get(), initial_shard_buckets_));
+    }
+    return DoInsert(ctx, keys, values, true);
   }
 
-  Status ExportValues(OpKernelContext* ctx) override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    Tensor key_buckets_tensor = *key_buckets_.AccessTensor(ctx);
-    Tensor value_buckets_tensor = *value_buckets_.AccessTensor(ctx);
-    TF_RETURN_IF_ERROR(ctx->set_output("keys", key_buckets_tensor));
-    TF_RETURN_IF_ERROR(ctx->set_output("values", value_buckets_tensor));
+  Status ExportValues(OpKernelContext* ctx) override {
+    // Hold every shard lock so that the export is a consistent snapshot.
+    std::vector<mutex_lock> locks;
+    locks.reserve(num_shards_);
+    int64 num_buckets = 0;
+    for (const auto& shard : shards_) {
+      locks.emplace_back(shard->mu);
+      num_buckets += shard->num_buckets;
+    }
+    if (num_shards_ == 1) {
+      TableShard* shard = shards_[0].get();
+      Tensor key_buckets_tensor = *shard->key_buckets.AccessTensor(ctx);
+      Tensor value_buckets_tensor = *shard->value_buckets.AccessTensor(ctx);
+      TF_RETURN_IF_ERROR(ctx->set_output("keys", key_buckets_tensor));
+      TF_RETURN_IF_ERROR(ctx->set_output("values", value_buckets_tensor));
+      return Status::OK();
+    }
+
+    const int64 key_size = key_shape_.num_elements();
+    const int64 value_size = value_shape_.num_elements();
+    Tensor* keys;
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "keys", TensorShape({num_buckets, key_size}), &keys));
+    Tensor* values;
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({num_buckets, value_size}), &values));
+    auto keys_matrix = keys->matrix<K>();
+    auto values_matrix = values->matrix<V>();
+    int64 offset = 0;
+    for (const auto& shard : shards_) {
+      const auto key_buckets_matrix =
+          shard->key_buckets.AccessTensor(ctx)->template matrix<K>();
+      const auto value_buckets_matrix =
+          shard->value_buckets.AccessTensor(ctx)->template matrix<V>();
+      for (int64 i = 0; i < shard->num_buckets; ++i, ++offset) {
+        for (int64 j = 0; j < key_size; ++j) {
+          keys_matrix(offset, j) = key_buckets_matrix(i, j);
+        }
+        for (int64 j = 0; j < value_size; ++j) {
+          values_matrix(offset, j) = value_buckets_matrix(i, j);
+        }
+      }
+    }
     return Status::OK();
   }
 
@@ -468,85 +500,245 @@ class MutableDenseHashTable final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
  private:
-  Status DoInsert(OpKernelContext* ctx, const Tensor& key, const Tensor& value,
-                  bool ignore_empty_key) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    const int64 num_elements = key.dim_size(0);
-    const int64 value_size = value_shape_.num_elements();
-    const int64 key_size = key_shape_.num_elements();
-    const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
-    auto value_matrix = value.shaped<V, 2>({num_elements, value_size});
+  // One independently locked and independently grown part of the table.
+  struct TableShard {
+    mutex mu;
+    int64 num_entries GUARDED_BY(mu) = 0;
+    int64 num_buckets GUARDED_BY(mu) = 0;
+    PersistentTensor key_buckets GUARDED_BY(mu);
+    PersistentTensor value_buckets GUARDED_BY(mu);
+  };
+
+  typename TTypes<K>::ConstMatrix EmptyKeyMatrix(OpKernelContext* ctx) {
+    const Tensor* empty_key = empty_key_.AccessTensor(ctx);
+    return empty_key->shaped<K, 2>({1, key_shape_.num_elements()});
+  }
 
-    auto key_buckets_matrix =
-        key_buckets_.AccessTensor(ctx)->template matrix<K>();
-    auto value_buckets_matrix =
-        value_buckets_.AccessTensor(ctx)->template matrix<V>();
-    const auto empty_key_tensor =
-        empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
-    const int64 bit_mask = num_buckets_ - 1;
+  Status CheckKeyMatrixShape(const Tensor& key) const {
+    if (key.NumElements() != key.dim_size(0) * key_shape_.num_elements()) {
+      TensorShape expected_shape({key.dim_size(0)});
+      expected_shape.AppendShape(key_shape_);
+      return errors::InvalidArgument("Expected key shape ",
+                                     expected_shape.DebugString(), " got ",
+                                     key.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  Status CheckNumBuckets(int64 num_buckets) const {
+    if (num_buckets < 4 || ((num_buckets & (num_buckets - 1)) != 0)) {
+      return errors::InvalidArgument(
+          "Number of buckets must be at least 4 and a power of 2, got: ",
+          num_buckets);
+    }
+    return Status::OK();
+  }
+
+  // Maps a key hash to a shard. The raw hash of a scalar key is the key
+  // itself, so it is mixed first to spread consecutive keys over the shards.
+  int ShardIndex(uint64 key_hash) const {
+    return static_cast<int>(((key_hash * 0x9E3779B97F4A7C15ULL) >> 32) %
+                            num_shards_);
+  }
+
+  // Hashes every row of `key_matrix` into `key_hashes` and groups the row
+  // indices by shard into `shard_rows`. Rows holding the empty key are skipped
+  // if `ignore_empty_key` is true and rejected otherwise.
+  Status PartitionKeys(typename TTypes<K>::ConstMatrix key_matrix,
+                       typename TTypes<K>::ConstMatrix empty_key_matrix,
+                       bool ignore_empty_key, std::vector<uint64>* key_hashes,
+                       std::vector<std::vector<int64>>* shard_rows) const {
+    const int64 num_elements = key_matrix.dimension(0);
+    key_hashes->resize(num_elements);
+    shard_rows->assign(num_shards_, std::vector<int64>());
+    for (auto& rows : *shard_rows) {
+      rows.reserve(num_elements / num_shards_ + 1);
+    }
     for (int64 i = 0; i < num_elements; ++i) {
       const uint64 key_hash = HashKey(key_matrix, i);
       if (empty_key_hash_ == key_hash &&
-          IsEqualKey(empty_key_tensor, 0, key_matrix, i)) {
+          IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
         if (ignore_empty_key) {
           continue;
         }
         return errors::InvalidArgument(
             "Using the empty_key as a table key is not allowed");
       }
-      int64 bucket_index = key_hash & bit_mask;
-      int64 num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64 j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
-          }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_tensor, 0)) {
-          ++num_entries_;
-          for (int64 j = 0; j < key_size; ++j) {
-            key_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(key_matrix(i, j));
-          }
-          for (int64 j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
-          }
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable insert");
+      (*key_hashes)[i] = key_hash;
+      (*shard_rows)[ShardIndex(key_hash)].push_back(i);
+    }
+    return Status::OK();
+  }
+
+  // Calls `fn` for every shard with rows in `shard_rows`, spreading the
+  // shards over the CPU worker threads, and returns the first error.
+  Status ForEachShard(
+      OpKernelContext* ctx, const std::vector<std::vector<int64>>& shard_rows,
+      const std::function<Status(TableShard*, const std::vector<int64>&)>& fn) {
+    if (num_shards_ == 1) {
+      return fn(shards_[0].get(), shard_rows[0]);
+    }
+    int64 num_rows = 0;
+    for (const auto& rows : shard_rows) {
+      num_rows += rows.size();
+    }
+    const int64 cost_per_shard =
+        1000 * (num_rows / num_shards_ + 1) *
+        (key_shape_.num_elements() + value_shape_.num_elements());
+    std::vector<Status> statuses(num_shards_);
+    auto work = [this, &shard_rows, &fn, &statuses](int64 start, int64 limit) {
+      for (int64 s = start; s < limit; ++s) {
+        if (!shard_rows[s].empty()) {
+          statuses[s] = fn(shards_[s].get(), shard_rows[s]);
         }
       }
+    };
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_shards_,
+          cost_per_shard, work);
+    for (const Status& s : statuses) {
+      TF_RETURN_IF_ERROR(s);
     }
     return Status::OK();
   }
 
-  Status AllocateBuckets(OpKernelContext* ctx, int64 new_num_buckets)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    if (new_num_buckets < 4 ||
-        ((new_num_buckets & (new_num_buckets - 1)) != 0)) {
-      return errors::InvalidArgument(
-          "Number of buckets must be at least 4 and a power of 2, got: ",
-          new_num_buckets);
+  // Inserts or updates every row of `key` and `value`. Rows holding the empty
+  // key are skipped if `ignore_empty_key` is true and rejected otherwise.
+  Status DoInsert(OpKernelContext* ctx, const Tensor& key, const Tensor& value,
+                  bool ignore_empty_key) {
+    const int64 num_elements = key.dim_size(0);
+    const int64 key_size = key_shape_.num_elements();
+    const int64 value_size = value_shape_.num_elements();
+    const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
+    const auto value_matrix = value.shaped<V, 2>({num_elements, value_size});
+    const auto empty_key_matrix = EmptyKeyMatrix(ctx);
+
+    std::vector<uint64> key_hashes;
+    std::vector<std::vector<int64>> shard_rows;
+    TF_RETURN_IF_ERROR(PartitionKeys(key_matrix, empty_key_matrix,
+                                     ignore_empty_key, &key_hashes,
+                                     &shard_rows));
+    auto insert_in_shard = [&](TableShard* shard,
+                               const std::vector<int64>& rows) -> Status {
+      mutex_lock l(shard->mu);
+      // For simplicity we assume that all keys in the input result in inserts
+      // rather than updates. That means we may grow the table even though we
+      // don't need to. As long as the number of keys inserted in one call is
+      // small compared to the size of the map, the impact of this is minimal.
+      const int64 pending_num_entries = shard->num_entries + rows.size();
+      if (pending_num_entries > shard->num_buckets * max_load_factor_) {
+        int64 new_num_buckets = shard->num_buckets;
+        do {
+          new_num_buckets <<= 1;
+        } while (pending_num_entries > new_num_buckets * max_load_factor_);
+        TF_RETURN_IF_ERROR(Rebucket(ctx, shard, new_num_buckets));
+      }
+      auto key_buckets_matrix =
+          shard->key_buckets.AccessTensor(ctx)->template matrix<K>();
+      auto value_buckets_matrix =
+          shard->value_buckets.AccessTensor(ctx)->template matrix<V>();
+      for (const int64 i : rows) {
+        TF_RETURN_IF_ERROR(InsertRow(shard, key_buckets_matrix,
+                                     value_buckets_matrix, empty_key_matrix,
+                                     key_matrix, value_matrix, i,
+                                     key_hashes[i]));
+      }
+      return Status::OK();
+    };
+    return ForEachShard(ctx, shard_rows, insert_in_shard);
+  }
+
+  // Inserts or updates row `i` of `key_matrix` and `value_matrix`, whose key
+  // hashes to `key_hash`, in the given buckets of `shard`.
+  Status InsertRow(TableShard* shard,
+                   typename TTypes<K>::Matrix key_buckets_matrix,
+                   typename TTypes<V>::Matrix value_buckets_matrix,
+                   typename TTypes<K>::ConstMatrix empty_key_matrix,
+                   typename TTypes<K>::ConstMatrix key_matrix,
+                   typename TTypes<V>::ConstMatrix value_matrix, int64 i,
+                   uint64 key_hash) EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    int64 bucket_index;
+    TF_RETURN_IF_ERROR(FindBucket(key_buckets_matrix, shard->num_buckets,
+                                  empty_key_matrix, key_matrix, i, key_hash,
+                                  &bucket_index));
+    if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
+      ++shard->num_entries;
+      for (int64 j = 0; j < key_matrix.dimension(1); ++j) {
+        key_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyUnlessStringOrFloat(key_matrix(i, j));
+      }
+    }
+    for (int64 j = 0; j < value_matrix.dimension(1); ++j) {
+      value_buckets_matrix(bucket_index, j) =
+          SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
+    }
+    return Status::OK();
+  }
+
+  // Counts the non-empty buckets in the exported `keys` into `num_entries`.
+  // Returns false if some key is not where probing for it would find it in a
+  // single-shard table, in which case the buckets can't be adopted as they are.
+  bool CountEntriesIfInPlace(OpKernelContext* ctx, const Tensor& keys,
+                             int64* num_entries) {
+    const int64 num_buckets = keys.dim_size(0);
+    const auto key_matrix =
+        keys.shaped<K, 2>({num_buckets, key_shape_.num_elements()});
+    const auto empty_key_matrix = EmptyKeyMatrix(ctx);
+    *num_entries = 0;
+    for (int64 i = 0; i < num_buckets; ++i) {
+      if (IsEqualKey(key_matrix, i, empty_key_matrix, 0)) {
+        continue;
+      }
+      int64 bucket_index;
+      if (!FindBucket(key_matrix, num_buckets, empty_key_matrix, key_matrix, i,
+                      HashKey(key_matrix, i), &bucket_index)
+               .ok() ||
+          bucket_index != i) {
+        return false;
+      }
+      ++*num_entries;
     }
-    num_buckets_ = new_num_buckets;
-    num_entries_ = 0;
+    return true;
+  }
+
+  // Stores in `bucket_index` the bucket that holds row `index` of `key`, or
+  // the empty bucket where it would be inserted if it is not in the table.
+  template <typename MT1, typename MT2>
+  Status FindBucket(MT1 key_buckets_matrix, int64 num_buckets,
+                    typename TTypes<K>::ConstMatrix empty_key_matrix, MT2 key,
+                    int64 index, uint64 key_hash, int64* bucket_index) const {
+    const int64 bit_mask = num_buckets - 1;
+    int64 b = key_hash & bit_mask;
+    int64 num_probes = 0;
+    while (!IsEqualKey(key_buckets_matrix, b, key, index) &&
+           !IsEqualKey(key_buckets_matrix, b, empty_key_matrix, 0)) {
+      ++num_probes;
+      b = (b + num_probes) & bit_mask;  // quadratic probing
+      if (num_probes >= num_buckets) {
+        return errors::Internal(
+            "Internal error in MutableDenseHashTable probing");
+      }
+    }
+    *bucket_index = b;
+    return Status::OK();
+  }
+
+  Status AllocateBuckets(OpKernelContext* ctx, TableShard* shard,
+                         int64 new_num_buckets)
+      EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    TF_RETURN_IF_ERROR(CheckNumBuckets(new_num_buckets));
+    shard->num_buckets = new_num_buckets;
+    shard->num_entries = 0;
 
     const int64 key_size = key_shape_.num_elements();
     Tensor* key_buckets_tensor;
     TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-        key_dtype(), TensorShape({num_buckets_, key_size}), &key_buckets_,
-        &key_buckets_tensor));
+        key_dtype(), TensorShape({new_num_buckets, key_size}),
+        &shard->key_buckets, &key_buckets_tensor));
     auto key_buckets_matrix = key_buckets_tensor->matrix<K>();
     const auto empty_key_flat =
         empty_key_.AccessTensor(ctx)->template flat<K>();
-    for (int64 i = 0; i < num_buckets_; ++i) {
+    for (int64 i = 0; i < new_num_buckets; ++i) {
       for (int64 j = 0; j < key_size; ++j) {
         key_buckets_matrix(i, j) = empty_key_flat(j);
       }
@@ -555,10 +747,10 @@ class MutableDenseHashTable final : public LookupInterface {
     const int64 value_size = value_shape_.num_elements();
     Tensor* value_buckets_tensor;
     TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-        value_dtype(), TensorShape({num_buckets_, value_size}), &value_buckets_,
-        &value_buckets_tensor));
+        value_dtype(), TensorShape({new_num_buckets, value_size}),
+        &shard->value_buckets, &value_buckets_tensor));
     auto value_buckets_matrix = value_buckets_tensor->matrix<V>();
-    for (int64 i = 0; i < num_buckets_; ++i) {
+    for (int64 i = 0; i < new_num_buckets; ++i) {
       for (int64 j = 0; j < value_size; ++j) {
         // Initialize values to the default value for the type to avoid
         // exposing uninitialized memory in ExportValues().
@@ -568,12 +760,29 @@ class MutableDenseHashTable final : public LookupInterface {
     return Status::OK();
   }
 
-  Status Rebucket(OpKernelContext* ctx, int64 num_new_buckets)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    Tensor old_key_buckets = *key_buckets_.AccessTensor(ctx);
-    Tensor old_value_buckets = *value_buckets_.AccessTensor(ctx);
-    TF_RETURN_IF_ERROR(AllocateBuckets(ctx, num_new_buckets));
-    return DoInsert(ctx, old_key_buckets, old_value_buckets, true);
+  Status Rebucket(OpKernelContext* ctx, TableShard* shard,
+                  int64 num_new_buckets) EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    const Tensor old_key_buckets = *shard->key_buckets.AccessTensor(ctx);
+    const Tensor old_value_buckets = *shard->value_buckets.AccessTensor(ctx);
+    const int64 old_num_buckets = shard->num_buckets;
+    TF_RETURN_IF_ERROR(AllocateBuckets(ctx, shard, num_new_buckets));
+
+    const auto old_key_matrix = old_key_buckets.matrix<K>();
+    const auto old_value_matrix = old_value_buckets.matrix<V>();
+    auto key_buckets_matrix =
+        shard->key_buckets.AccessTensor(ctx)->template matrix<K>();
+    auto value_buckets_matrix =
+        shard->value_buckets.AccessTensor(ctx)->template matrix<V>();
+    const auto empty_key_matrix = EmptyKeyMatrix(ctx);
+    for (int64 i = 0; i < old_num_buckets; ++i) {
+      if (IsEqualKey(old_key_matrix, i, empty_key_matrix, 0)) {
+        continue;
+      }
+      TF_RETURN_IF_ERROR(InsertRow(
+          shard, key_buckets_matrix, value_buckets_matrix, empty_key_matrix,
+          old_key_matrix, old_value_matrix, i, HashKey(old_key_matrix, i)));
+    }
+    return Status::OK();
   }
 
   uint64 HashKey(typename TTypes<K>::ConstMatrix key, int64 index) const {
@@ -589,9 +798,8 @@ class MutableDenseHashTable final : public LookupInterface {
 
   // Use a template to allow this function to be used both with Matrix and
   // ConstMatrix types.
-  template <typename MT2>
-  bool IsEqualKey(typename TTypes<K>::Matrix tensor1, int64 index1, MT2 tensor2,
-                  int64 index2) const {
+  template <typename MT1, typename MT2>
+  bool IsEqualKey(MT1 tensor1, int64 index1, MT2 tensor2, int64 index2) const {
     for (int64 i = 0; i < key_shape_.num_elements(); ++i) {
       if (tensor1(index1, i) != tensor2(index2, i)) {
         return false;
@@ -603,11 +811,9 @@ class MutableDenseHashTable final : public LookupInterface {
   TensorShape key_shape_;
   TensorShape value_shape_;
   float max_load_factor_;
-  mutable mutex mu_;
-  int64 num_entries_ GUARDED_BY(mu_);
-  int64 num_buckets_ GUARDED_BY(mu_);
-  PersistentTensor key_buckets_ GUARDED_BY(mu_);
-  PersistentTensor value_buckets_ GUARDED_BY(mu_);
+  int num_shards_;
+  int64 initial_shard_buckets_;
+  std::vector<std::unique_ptr<TableShard>> shards_;
   PersistentTensor empty_key_;
   uint64 empty_key_hash_;
 };
@@ -180,7 +180,7 @@ class HashTable : public InitializableLookupTable {
   DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
 
  protected:
-  Status DoPrepare(size_t unused) override {
+  Status DoPrepare(size_t size) override {
     if (is_initialized_) {
       return errors::Aborted("HashTable already initialized.");
     }
@@ -188,6 +188,11 @@ class HashTable : public InitializableLookupTable {
       table_ = std::unique_ptr<std::unordered_map<K, V>>(
           new std::unordered_map<K, V>());
     }
+    // Presize the table for the expected number of keys, so that inserting
+    // them doesn't rehash it. Iterators of unknown size pass -1.
+    if (static_cast<int64>(size) > 0) {
+      table_->reserve(size);
+    }
     return Status::OK();
   };
 
@@ -119,6 +119,18 @@ class MapDatasetOp : public UnaryDatasetOpKernel {
         return dataset()->captured_func_->Run(opts, args, out_tensors);
       }
 
+      // The mapped function is stateless, so the position of this
+      // iterator is the position of its input.
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return input_impl_->Save(strings::StrCat(prefix, "/input"), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return input_impl_->Restore(ctx, strings::StrCat(prefix, "/input"),
+                                    reader);
+      }
+
      private:
       const std::unique_ptr<IteratorBase> input_impl_;
     };
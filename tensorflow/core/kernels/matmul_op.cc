@@ -19,10 +19,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/matmul_op.h"
 
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/fused_bias_activation_op.h"
 
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -145,6 +147,46 @@ struct LaunchMatMulBase {
 template <typename T>
 struct LaunchMatMulCPU : LaunchMatMulBase<CPUDevice, T> {};
 
+// bfloat16 has no arithmetic of its own, so the inputs are widened to float
+// and multiplied by the float kernel, which also accumulates the products in
+// float. Only the result is rounded to bfloat16.
+template <>
+struct LaunchMatMulCPU<bfloat16> {
+  static void launch(
+      OpKernelContext* ctx, OpKernel* kernel, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    Tensor a_float, b_float, out_float;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, a.shape(), &a_float));
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, b.shape(), &b_float));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DT_FLOAT, out->shape(), &out_float));
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    ToFloat(d, a, &a_float);
+    ToFloat(d, b, &b_float);
+    LaunchMatMulCPU<float>::launch(ctx, kernel, a_float, b_float, dim_pair,
+                                   &out_float);
+    const float* src = out_float.flat<float>().data();
+    bfloat16* dst = out->flat<bfloat16>().data();
+    d.parallelFor(out->NumElements(),
+                  Eigen::TensorOpCost(sizeof(float), sizeof(bfloat16), 1),
+                  [src, dst](int64 first, int64 last) {
+                    FloatToBFloat16(src + first, dst + first, last - first);
+                  });
+  }
+
+ private:
+  static void ToFloat(const CPUDevice& d, const Tensor& in, Tensor* out) {
+    const bfloat16* src = in.flat<bfloat16>().data();
+    float* dst = out->flat<float>().data();
+    d.parallelFor(in.NumElements(),
+                  Eigen::TensorOpCost(sizeof(bfloat16), sizeof(float), 1),
+                  [src, dst](int64 first, int64 last) {
+                    BFloat16ToFloat(src + first, dst + first, last - first);
+                  });
+  }
+};
+
 template <typename T, bool USE_CUBLAS>
 struct LaunchMatMul<CPUDevice, T, USE_CUBLAS> : public LaunchMatMulCPU<T> {};
 
@@ -310,6 +352,45 @@ class MatMulOp : public OpKernel {
   bool transpose_b_;
 };
 
+// Computes activation(BiasAdd(MatMul(a, b), bias)), applying the bias and the
+// activation in place on the product.  Produced by the grappler op fusion
+// optimizer.
+template <typename Device, typename T, bool USE_CUBLAS>
+class FusedMatMulOp : public MatMulOp<Device, T, USE_CUBLAS> {
+ public:
+  explicit FusedMatMulOp(OpKernelConstruction* ctx)
+      : MatMulOp<Device, T, USE_CUBLAS>(ctx) {
+    string activation;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(ctx, ParseFusedActivation(activation, &activation_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& bias = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("Biases must be 1D: ",
+                                        bias.shape().DebugString()));
+    MatMulOp<Device, T, USE_CUBLAS>::Compute(ctx);
+    if (!ctx->status().ok()) return;
+
+    Tensor* out = ctx->mutable_output(0);
+    OP_REQUIRES(ctx, bias.dim_size(0) == out->dim_size(1),
+                errors::InvalidArgument(
+                    "Must provide as many biases as the columns of the "
+                    "product: ",
+                    bias.shape().DebugString(), " vs. ",
+                    out->shape().DebugString()));
+    if (out->NumElements() == 0) return;
+    functor::FusedBiasActivation<Device, T>()(
+        ctx->eigen_device<Device>(),
+        const_cast<const Tensor*>(out)->matrix<T>(), bias.vec<T>(),
+        activation_, out->matrix<T>());
+  }
+
+ private:
+  FusedActivation activation_;
+};
+
 namespace functor {
 
 // Partial specialization MatMulFunctor<Device=CPUDevice, T>.
@@ -373,6 +454,7 @@ TF_CALL_int32(REGISTER_CPU);
 TF_CALL_complex64(REGISTER_CPU);
 TF_CALL_complex128(REGISTER_CPU);
 #endif
+TF_CALL_bfloat16(REGISTER_CPU);
 
 #if GOOGLE_CUDA
 TF_CALL_float(REGISTER_GPU);
@@ -384,6 +466,42 @@ TF_CALL_half(REGISTER_GPU);
 #endif
 #endif  // GOOGLE_CUDA
 
+#define REGISTER_FUSED_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<CPUDevice, T, false /* cublas, ignored for CPU */>);
+
+TF_CALL_float(REGISTER_FUSED_CPU);
+TF_CALL_double(REGISTER_FUSED_CPU);
+#undef REGISTER_FUSED_CPU
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU, which are
+// defined in fused_bias_activation_op_gpu.cu.cc.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                          \
+  template <>                                                        \
+  void FusedBiasActivation<GPUDevice, T>::operator()(                \
+      const GPUDevice& d, typename TTypes<T>::ConstMatrix input,     \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation, \
+      typename TTypes<T>::Matrix output);                            \
+  extern template struct FusedBiasActivation<GPUDevice, T>;
+
+TF_CALL_float(DECLARE_GPU_SPEC);
+TF_CALL_double(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_FUSED_GPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<GPUDevice, T, true /* cublas */>);
+
+TF_CALL_float(REGISTER_FUSED_GPU);
+TF_CALL_double(REGISTER_FUSED_GPU);
+#undef REGISTER_FUSED_GPU
+#endif  // GOOGLE_CUDA
+
 #ifdef TENSORFLOW_USE_SYCL
 #define REGISTER_SYCL(T)                                         \
   REGISTER_KERNEL_BUILDER(                                       \
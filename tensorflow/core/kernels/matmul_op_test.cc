@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -33,6 +34,24 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
   return g;
 }
 
+// Returns a random bfloat16 matrix, since Eigen can't generate them itself.
+static Tensor RandomBFloat16Matrix(int rows, int cols) {
+  Tensor floats(DT_FLOAT, TensorShape({rows, cols}));
+  floats.flat<float>().setRandom();
+  Tensor result(DT_BFLOAT16, floats.shape());
+  FloatToBFloat16(floats.flat<float>().data(),
+                  result.flat<bfloat16>().data(), floats.NumElements());
+  return result;
+}
+
+static Graph* MatmulBFloat16(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, test::graph::Constant(g, RandomBFloat16Matrix(m, k)),
+                      test::graph::Constant(g, RandomBFloat16Matrix(k, n)),
+                      false, false);
+  return g;
+}
+
 #define BM_MatmulDev(M, K, N, TA, TB, T, TFTYPE, DEVICE)                       \
   static void BM_Matmul##_##M##_##K##_##N##_##TA##_##TB##_##TFTYPE##_##DEVICE( \
       int iters) {                                                             \
@@ -113,4 +132,16 @@ BM_Matmul(1, 2000, 2000, true, false);
 BM_Matmul(1, 2000, 2000, false, true);
 BM_Matmul(1, 2000, 2000, true, true);
 
+#define BM_MatmulBFloat16(M, K, N)                                           \
+  static void BM_MatmulBFloat16##_##M##_##K##_##N(int iters) {               \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);      \
+    test::Benchmark("cpu", MatmulBFloat16(M, K, N)).Run(iters);              \
+  }                                                                          \
+  BENCHMARK(BM_MatmulBFloat16##_##M##_##K##_##N);
+
+BM_MatmulBFloat16(1, 1024, 1024);
+BM_MatmulBFloat16(128, 1024, 1024);
+BM_MatmulBFloat16(1024, 1024, 1024);
+
 }  // end namespace tensorflow
@@ -15,6 +15,10 @@ limitations under the License.
 
 // See docs in ../ops/linalg_ops.cc.
 
+#if GOOGLE_CUDA
+#define EIGEN_USE_GPU
+#endif
+
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/Eigen/LU"
 #include "tensorflow/core/framework/kernel_def_builder.h"
@@ -26,6 +30,11 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
+#if GOOGLE_CUDA
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/kernels/cuda_solvers.h"
+#endif
+
 namespace tensorflow {
 
 template <class Scalar>
@@ -108,6 +117,186 @@ class MatrixSolveOp : public LinearAlgebraOp<Scalar> {
   TF_DISALLOW_COPY_AND_ASSIGN(MatrixSolveOp);
 };
 
+#if GOOGLE_CUDA
+
+typedef Eigen::GpuDevice GPUDevice;
+
+// Solves all the systems of a batch with two cuBlas calls, getrfBatched and
+// getrsBatched, instead of one LU factorization and solve per matrix.
+template <class Scalar>
+class MatrixSolveOpGpu : public AsyncOpKernel {
+ public:
+  explicit MatrixSolveOpGpu(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("adjoint", &adjoint_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) final {
+    const Tensor& input = context->input(0);
+    const Tensor& rhs = context->input(1);
+    const int ndims = input.dims();
+    const int64 n = input.dim_size(ndims - 1);
+    const int64 nrhs = rhs.dim_size(ndims - 1);
+    // Validate inputs.
+    OP_REQUIRES_ASYNC(
+        context, ndims >= 2,
+        errors::InvalidArgument("Input must have rank >= 2, got ", ndims),
+        done);
+    OP_REQUIRES_ASYNC(context, rhs.dims() == ndims,
+                      errors::InvalidArgument(
+                          "Input and right-hand side must have same rank, got ",
+                          ndims, " != ", rhs.dims()),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context, input.dim_size(ndims - 2) == n,
+        errors::InvalidArgument("Input matrices must be squares, got",
+                                input.dim_size(ndims - 2), " != ", n),
+        done);
+    OP_REQUIRES_ASYNC(context, rhs.dim_size(ndims - 2) == n,
+                      errors::InvalidArgument(
+                          "Input matrix and right-hand side must have the "
+                          "same number of rows, got",
+                          n, " != ", rhs.dim_size(ndims - 2)),
+                      done);
+    for (int dim = 0; dim < ndims - 2; ++dim) {
+      OP_REQUIRES_ASYNC(
+          context, input.dim_size(dim) == rhs.dim_size(dim),
+          errors::InvalidArgument(
+              "All input tensors must have the same outer dimensions."),
+          done);
+    }
+
+    // Allocate output.
+    Tensor* output;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->forward_input_or_allocate_output({1}, 0, rhs.shape(), &output),
+        done);
+
+    // To be consistent with the MatrixInverse op, we define the solution for
+    // an empty set of equations as the empty matrix.
+    if (input.NumElements() == 0 || rhs.NumElements() == 0) {
+      done();
+      return;
+    }
+
+    // cuBlas expects column-major matrices, in which our row-major matrices
+    // read as their transposes. getrfBatched works in place, so factor a copy
+    // of the input, i.e. A^T. The right-hand sides are copied into
+    // column-major order by AdjointBatchFunctor, which also conjugates them,
+    // so we solve the conjugated system conj(op(A)) * conj(X) = conj(B), and
+    // conjugate the solution again as it is transposed back into the output.
+    Tensor input_copy;
+    OP_REQUIRES_OK_ASYNC(context,
+                         context->allocate_temp(DataTypeToEnum<Scalar>::value,
+                                                input.shape(), &input_copy),
+                         done);
+    auto input_reshaped = input.template flat_inner_dims<Scalar, 3>();
+    auto input_copy_reshaped = input_copy.template flat_inner_dims<Scalar, 3>();
+    const int64 batch_size = input_reshaped.dimension(0);
+    Tensor transposed_rhs;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DataTypeToEnum<Scalar>::value,
+                               TensorShape({batch_size, nrhs, n}),
+                               &transposed_rhs),
+        done);
+    auto transposed_rhs_reshaped = transposed_rhs.template tensor<Scalar, 3>();
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    d.memcpy(input_copy_reshaped.data(), input_reshaped.data(),
+             input.NumElements() * sizeof(Scalar));
+    functor::AdjointBatchFunctor<GPUDevice, Scalar> adjoint;
+    adjoint(d, rhs.template flat_inner_dims<Scalar, 3>(),
+            transposed_rhs_reshaped);
+
+    // Allocate pivots on the device.
+    ScratchSpace<int> pivots(context, n * batch_size, /* on_host */ false);
+
+    // Prepare pointer arrays for cuBlas' batch interface.
+    ScratchSpace<uint8> input_copy_ptrs(context, sizeof(Scalar*) * batch_size,
+                                        /* on_host */ true);
+    ScratchSpace<uint8> rhs_ptrs(context, sizeof(Scalar*) * batch_size,
+                                 /* on_host */ true);
+    const Scalar** input_copy_ptrs_base =
+        reinterpret_cast<const Scalar**>(input_copy_ptrs.mutable_data());
+    const Scalar** rhs_ptrs_base =
+        reinterpret_cast<const Scalar**>(rhs_ptrs.mutable_data());
+    for (int64 i = 0; i < batch_size; ++i) {
+      input_copy_ptrs_base[i] = input_copy_reshaped.data() + i * n * n;
+      rhs_ptrs_base[i] = transposed_rhs_reshaped.data() + i * n * nrhs;
+    }
+
+    // Launch the two solver kernels back to back without waiting.
+    // 1. Compute the partially pivoted LU factorizations of A^T.
+    CudaSolver solver(context);
+    std::vector<DeviceLapackInfo> dev_info;
+    dev_info.emplace_back(context, batch_size, "getrf");
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        solver.GetrfBatched(n, input_copy_ptrs_base, n, pivots.mutable_data(),
+                            &dev_info.back(), batch_size),
+        done);
+    // 2. Solve the systems. The conjugate transpose of A^T is conj(A), and
+    // conj(A^H) is A^T itself.
+    const cublasOperation_t trans =
+        adjoint_ ? CUBLAS_OP_N
+                 : (Eigen::NumTraits<Scalar>::IsComplex ? CUBLAS_OP_C
+                                                        : CUBLAS_OP_T);
+    int host_info = 0;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        solver.GetrsBatched(trans, n, nrhs, input_copy_ptrs_base, n,
+                            pivots.data(), rhs_ptrs_base, n, &host_info,
+                            batch_size),
+        done);
+    OP_REQUIRES_ASYNC(
+        context, host_info == 0,
+        errors::Internal("getrsBatched rejected argument ", -host_info),
+        done);
+    // 3. Transpose the solutions back into the output.
+    const Tensor& solutions = transposed_rhs;
+    adjoint(d, solutions.tensor<Scalar, 3>(),
+            output->template flat_inner_dims<Scalar, 3>());
+
+    // Register callback to check info after kernels finish. Also capture the
+    // temporary Tensors/ScratchSpace so they don't get deallocated before the
+    // kernels run.
+    auto info_checker = [context, dev_info, input_copy, transposed_rhs, pivots,
+                         input_copy_ptrs, rhs_ptrs,
+                         done](const Status& status,
+                               const std::vector<HostLapackInfo>& host_infos) {
+      if (!status.ok() && errors::IsInvalidArgument(status) &&
+          !host_infos.empty()) {
+        for (int i = 0; i < host_infos[0].size(); ++i) {
+          // Match the CPU error message for singular matrices.
+          OP_REQUIRES_ASYNC(
+              context, host_infos[0].data()[i] <= 0,
+              errors::InvalidArgument("Input matrix is not invertible."), done);
+        }
+      }
+      OP_REQUIRES_OK_ASYNC(context, status, done);
+      done();
+    };
+
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        solver.CopyLapackInfoToHostAsync(dev_info, std::move(info_checker)),
+        done);
+  }
+
+ private:
+  bool adjoint_;
+};
+
+REGISTER_LINALG_OP_GPU("MatrixSolve", (MatrixSolveOpGpu<float>), float);
+REGISTER_LINALG_OP_GPU("MatrixSolve", (MatrixSolveOpGpu<double>), double);
+REGISTER_LINALG_OP_GPU("MatrixSolve", (MatrixSolveOpGpu<complex64>),
+                       complex64);
+REGISTER_LINALG_OP_GPU("MatrixSolve", (MatrixSolveOpGpu<complex128>),
+                       complex128);
+
+#endif  // GOOGLE_CUDA
+
 REGISTER_LINALG_OP("MatrixSolve", (MatrixSolveOp<float>), float);
 REGISTER_LINALG_OP("MatrixSolve", (MatrixSolveOp<double>), double);
 REGISTER_LINALG_OP("MatrixSolve", (MatrixSolveOp<complex64>), complex64);
@@ -0,0 +1,123 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/numeric_op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/neon/pooling_float.h"
+#include "tensorflow/core/kernels/pooling_ops_common.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/tensor_format.h"
+
+namespace tensorflow {
+
+// A version of tensorflow/core/kernels/avgpooling_op.cc and
+// tensorflow/core/kernels/maxpooling_op.cc that uses the neon intrinsics.
+template <bool kIsMax>
+class NeonPoolingOp : public UnaryOp<float> {
+ public:
+  explicit NeonPoolingOp(OpKernelConstruction* context)
+      : UnaryOp<float>(context) {
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES(context, FormatFromString(data_format, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+    OP_REQUIRES(
+        context, data_format_ == FORMAT_NHWC,
+        errors::InvalidArgument("Neon pooling only supports NHWC."));
+    OP_REQUIRES_OK(context, context->GetAttr("ksize", &ksize_));
+    OP_REQUIRES(context, ksize_.size() == 4,
+                errors::InvalidArgument("Sliding window ksize field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &stride_));
+    OP_REQUIRES(context, stride_.size() == 4,
+                errors::InvalidArgument("Sliding window stride field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    OP_REQUIRES(context, ksize_[0] == 1 && stride_[0] == 1,
+                errors::Unimplemented(
+                    "Pooling is not yet supported on the batch dimension."));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& tensor_in = context->input(0);
+    PoolParameters params{context,  ksize_,       stride_,
+                          padding_, data_format_, tensor_in.shape()};
+    if (!context->status().ok()) {
+      return;
+    }
+    OP_REQUIRES(context, params.depth_window == 1,
+                errors::Unimplemented("Neon pooling does not support "
+                                      "pooling over the depth dimension."));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, params.forward_output_shape(), &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+
+    const float* input_ptr = tensor_in.flat<float>().data();
+    float* output_ptr = output->flat<float>().data();
+    const neon::Dims<4> input_neon_dims = ToNeonDims(tensor_in.shape());
+    const neon::Dims<4> output_neon_dims = ToNeonDims(output->shape());
+    neon::Pool<kIsMax>(input_ptr, input_neon_dims, params.col_stride,
+                       params.row_stride, params.pad_cols, params.pad_rows,
+                       params.window_cols, params.window_rows, output_ptr,
+                       output_neon_dims);
+  }
+
+ private:
+  neon::Dims<4> ToNeonDims(const TensorShape& input) {
+    // Dims in the neon kernels are channel, x, y, batch order.
+    neon::Dims<4> result;
+    result.sizes[0] = input.dim_size(3);
+    result.sizes[1] = input.dim_size(2);
+    result.sizes[2] = input.dim_size(1);
+    result.sizes[3] = input.dim_size(0);
+    int64 stride = 1;
+    for (int i = 0; i < 4; ++i) {
+      result.strides[i] = stride;
+      stride *= result.sizes[i];
+    }
+    return result;
+  }
+
+  std::vector<int32> ksize_;
+  std::vector<int32> stride_;
+  Padding padding_;
+  TensorFormat data_format_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NeonPoolingOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("AvgPool")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T")
+                            .Label("neon"),
+                        NeonPoolingOp<false>);
+REGISTER_KERNEL_BUILDER(Name("MaxPool")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T")
+                            .Label("neon"),
+                        NeonPoolingOp<true>);
+
+}  // namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
+#include "tensorflow/core/kernels/neon/resize_bilinear_float.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A version of tensorflow/core/kernels/resize_bilinear_op.cc that uses the
+// neon intrinsics.
+class NeonResizeBilinearOp : public OpKernel {
+ public:
+  explicit NeonResizeBilinearOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    ImageResizerState st(align_corners_);
+    st.ValidateAndCreateOutput(context, input);
+
+    if (!context->status().ok()) return;
+
+    // Return if the output is empty.
+    if (st.output->NumElements() == 0) return;
+
+    neon::ResizeBilinear(input.flat<float>().data(),
+                         ToNeonDims(input.shape()), st.height_scale,
+                         st.width_scale, st.output->flat<float>().data(),
+                         ToNeonDims(st.output->shape()));
+  }
+
+ private:
+  neon::Dims<4> ToNeonDims(const TensorShape& input) {
+    // Dims in the neon kernels are channel, x, y, batch order.
+    neon::Dims<4> result;
+    result.sizes[0] = input.dim_size(3);
+    result.sizes[1] = input.dim_size(2);
+    result.sizes[2] = input.dim_size(1);
+    result.sizes[3] = input.dim_size(0);
+    int64 stride = 1;
+    for (int i = 0; i < 4; ++i) {
+      result.strides[i] = stride;
+      stride *= result.sizes[i];
+    }
+    return result;
+  }
+
+  bool align_corners_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NeonResizeBilinearOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("ResizeBilinear")
+                            .Device(DEVICE_CPU)
+                            .HostMemory("size")
+                            .TypeConstraint<float>("T")
+                            .Label("neon"),
+                        NeonResizeBilinearOp);
+
+}  // namespace tensorflow
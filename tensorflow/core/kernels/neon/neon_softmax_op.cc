@@ -0,0 +1,63 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <limits>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/neon/softmax_float.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A version of tensorflow/core/kernels/softmax_op.cc that uses the neon
+// intrinsics.
+class NeonSoftmaxOp : public OpKernel {
+ public:
+  explicit NeonSoftmaxOp(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& logits_in = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(logits_in.shape()),
+                errors::InvalidArgument("logits must be 2-dimensional"));
+    OP_REQUIRES(
+        context,
+        FastBoundsCheck(logits_in.NumElements(),
+                        std::numeric_limits<int32>::max()),
+        errors::InvalidArgument("logits must have fewer than 2^31 elements"));
+    Tensor* softmax_out = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, logits_in.shape(), &softmax_out));
+    if (logits_in.NumElements() == 0) {
+      return;
+    }
+    neon::Softmax(logits_in.flat<float>().data(), logits_in.dim_size(0),
+                  logits_in.dim_size(1), softmax_out->flat<float>().data());
+  }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(NeonSoftmaxOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("Softmax")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T")
+                            .Label("neon"),
+                        NeonSoftmaxOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_POOLING_FLOAT_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_POOLING_FLOAT_H_
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/kernels/neon/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace tensorflow {
+namespace neon {
+
+// Implementation of float AvgPool and MaxPool.
+//
+// Both pool over the x and y dimensions only. The padding does not count
+// towards the average, as in tensorflow/core/kernels/avgpooling_op.cc. The
+// depth of a pixel is contiguous in memory, so the NEON paths vectorize
+// across channels, 16 and then 4 at a time.
+
+template <bool kIsMax>
+inline void Pool(const float* input_data, const Dims<4>& input_dims,
+                 int stride_width, int stride_height, int pad_width,
+                 int pad_height, int filter_width, int filter_height,
+                 float* output_data, const Dims<4>& output_dims) {
+  const int batches = MatchingArraySize(input_dims, 3, output_dims, 3);
+  const int depth = MatchingArraySize(input_dims, 0, output_dims, 0);
+  const int input_height = ArraySize(input_dims, 2);
+  const int input_width = ArraySize(input_dims, 1);
+  const int output_height = ArraySize(output_dims, 2);
+  const int output_width = ArraySize(output_dims, 1);
+  const float init = kIsMax ? std::numeric_limits<float>::lowest() : 0.f;
+
+  for (int b = 0; b < batches; ++b) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      const int filter_y_start = std::max(0, -in_y_origin);
+      const int filter_y_end =
+          std::min(filter_height, input_height - in_y_origin);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        const int filter_x_start = std::max(0, -in_x_origin);
+        const int filter_x_end =
+            std::min(filter_width, input_width - in_x_origin);
+        const int filter_count =
+            (filter_x_end - filter_x_start) * (filter_y_end - filter_y_start);
+        const float scale = kIsMax ? 1.f : 1.f / filter_count;
+        float* output_ptr =
+            output_data + Offset(output_dims, 0, out_x, out_y, b);
+        int c = 0;
+#ifdef USE_NEON
+        // Handle 16 channels at a time
+        for (; c <= depth - 16; c += 16) {
+          float32x4_t acc[4];
+          for (int k = 0; k < 4; k++) {
+            acc[k] = vdupq_n_f32(init);
+          }
+          for (int fy = filter_y_start; fy < filter_y_end; ++fy) {
+            for (int fx = filter_x_start; fx < filter_x_end; ++fx) {
+              const float* input_ptr =
+                  input_data + Offset(input_dims, c, in_x_origin + fx,
+                                      in_y_origin + fy, b);
+              for (int k = 0; k < 4; k++) {
+                const float32x4_t input = vld1q_f32(input_ptr + 4 * k);
+                acc[k] = kIsMax ? vmaxq_f32(acc[k], input)
+                                : vaddq_f32(acc[k], input);
+              }
+            }
+          }
+          for (int k = 0; k < 4; k++) {
+            if (!kIsMax) acc[k] = vmulq_n_f32(acc[k], scale);
+            vst1q_f32(output_ptr + c + 4 * k, acc[k]);
+          }
+        }
+        // Handle 4 channels at a time
+        for (; c <= depth - 4; c += 4) {
+          float32x4_t acc = vdupq_n_f32(init);
+          for (int fy = filter_y_start; fy < filter_y_end; ++fy) {
+            for (int fx = filter_x_start; fx < filter_x_end; ++fx) {
+              const float32x4_t input = vld1q_f32(
+                  input_data + Offset(input_dims, c, in_x_origin + fx,
+                                      in_y_origin + fy, b));
+              acc = kIsMax ? vmaxq_f32(acc, input) : vaddq_f32(acc, input);
+            }
+          }
+          if (!kIsMax) acc = vmulq_n_f32(acc, scale);
+          vst1q_f32(output_ptr + c, acc);
+        }
+#endif
+        // Handle leftover channels, one by one.
+        for (; c < depth; ++c) {
+          float acc = init;
+          for (int fy = filter_y_start; fy < filter_y_end; ++fy) {
+            for (int fx = filter_x_start; fx < filter_x_end; ++fx) {
+              const float input = input_data[Offset(
+                  input_dims, c, in_x_origin + fx, in_y_origin + fy, b)];
+              acc = kIsMax ? std::max(acc, input) : acc + input;
+            }
+          }
+          output_ptr[c] = acc * scale;
+        }
+      }
+    }
+  }
+}
+
+inline void AveragePool(const float* input_data, const Dims<4>& input_dims,
+                        int stride_width, int stride_height, int pad_width,
+                        int pad_height, int filter_width, int filter_height,
+                        float* output_data, const Dims<4>& output_dims) {
+  Pool<false>(input_data, input_dims, stride_width, stride_height, pad_width,
+              pad_height, filter_width, filter_height, output_data,
+              output_dims);
+}
+
+inline void MaxPool(const float* input_data, const Dims<4>& input_dims,
+                    int stride_width, int stride_height, int pad_width,
+                    int pad_height, int filter_width, int filter_height,
+                    float* output_data, const Dims<4>& output_dims) {
+  Pool<true>(input_data, input_dims, stride_width, stride_height, pad_width,
+             pad_height, filter_width, filter_height, output_data,
+             output_dims);
+}
+
+}  // end namespace neon
+}  // end namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_POOLING_FLOAT_H_
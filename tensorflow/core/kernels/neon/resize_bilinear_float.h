@@ -0,0 +1,116 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_RESIZE_BILINEAR_FLOAT_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_RESIZE_BILINEAR_FLOAT_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/kernels/neon/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace tensorflow {
+namespace neon {
+
+// Implementation of float ResizeBilinear, with the same interpolation as
+// tensorflow/core/kernels/resize_bilinear_op.cc: the source coordinate of
+// output pixel i is i * scale, clamped to the last row or column.
+
+struct BilinearWeight {
+  int lower;
+  int upper;
+  float lerp;
+};
+
+inline void ComputeBilinearWeights(int out_size, int in_size, float scale,
+                                   std::vector<BilinearWeight>* weights) {
+  weights->resize(out_size);
+  for (int i = 0; i < out_size; ++i) {
+    const float in = i * scale;
+    BilinearWeight& w = (*weights)[i];
+    w.lower = static_cast<int>(in);
+    w.upper = std::min(w.lower + 1, in_size - 1);
+    w.lerp = in - w.lower;
+  }
+}
+
+inline void ResizeBilinear(const float* input_data, const Dims<4>& input_dims,
+                           float height_scale, float width_scale,
+                           float* output_data, const Dims<4>& output_dims) {
+  const int batches = MatchingArraySize(input_dims, 3, output_dims, 3);
+  const int depth = MatchingArraySize(input_dims, 0, output_dims, 0);
+  const int input_height = ArraySize(input_dims, 2);
+  const int input_width = ArraySize(input_dims, 1);
+  const int output_height = ArraySize(output_dims, 2);
+  const int output_width = ArraySize(output_dims, 1);
+
+  std::vector<BilinearWeight> ys;
+  std::vector<BilinearWeight> xs;
+  ComputeBilinearWeights(output_height, input_height, height_scale, &ys);
+  ComputeBilinearWeights(output_width, input_width, width_scale, &xs);
+
+  for (int b = 0; b < batches; ++b) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const BilinearWeight& y = ys[out_y];
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const BilinearWeight& x = xs[out_x];
+        const float* top_left =
+            input_data + Offset(input_dims, 0, x.lower, y.lower, b);
+        const float* top_right =
+            input_data + Offset(input_dims, 0, x.upper, y.lower, b);
+        const float* bottom_left =
+            input_data + Offset(input_dims, 0, x.lower, y.upper, b);
+        const float* bottom_right =
+            input_data + Offset(input_dims, 0, x.upper, y.upper, b);
+        float* output_ptr =
+            output_data + Offset(output_dims, 0, out_x, out_y, b);
+        int c = 0;
+#ifdef USE_NEON
+        const float32x4_t x_lerp = vdupq_n_f32(x.lerp);
+        const float32x4_t y_lerp = vdupq_n_f32(y.lerp);
+        // Handle 4 channels at a time
+        for (; c <= depth - 4; c += 4) {
+          const float32x4_t tl = vld1q_f32(top_left + c);
+          const float32x4_t bl = vld1q_f32(bottom_left + c);
+          const float32x4_t top =
+              vmlaq_f32(tl, vsubq_f32(vld1q_f32(top_right + c), tl), x_lerp);
+          const float32x4_t bottom = vmlaq_f32(
+              bl, vsubq_f32(vld1q_f32(bottom_right + c), bl), x_lerp);
+          vst1q_f32(output_ptr + c,
+                    vmlaq_f32(top, vsubq_f32(bottom, top), y_lerp));
+        }
+#endif
+        // Handle leftover channels, one by one.
+        for (; c < depth; ++c) {
+          const float top =
+              top_left[c] + (top_right[c] - top_left[c]) * x.lerp;
+          const float bottom =
+              bottom_left[c] + (bottom_right[c] - bottom_left[c]) * x.lerp;
+          output_ptr[c] = top + (bottom - top) * y.lerp;
+        }
+      }
+    }
+  }
+}
+
+}  // end namespace neon
+}  // end namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_RESIZE_BILINEAR_FLOAT_H_
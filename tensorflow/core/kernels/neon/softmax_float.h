@@ -0,0 +1,142 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_SOFTMAX_FLOAT_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_SOFTMAX_FLOAT_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace tensorflow {
+namespace neon {
+
+#ifdef USE_NEON
+
+// Computes exp(x) for each lane, with the range reduction and polynomial of
+// the Cephes expf. The relative error is within a few ulps for inputs that
+// do not underflow; inputs below -88.37 return 0.
+inline float32x4_t Exp(float32x4_t x) {
+  x = vminq_f32(x, vdupq_n_f32(88.3762626647949f));
+  x = vmaxq_f32(x, vdupq_n_f32(-88.3762626647949f));
+
+  // n = floor(x / ln(2) + 0.5)
+  float32x4_t fx =
+      vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f));
+  const float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+  const uint32x4_t too_large = vcgtq_f32(truncated, fx);
+  fx = vsubq_f32(truncated,
+                 vreinterpretq_f32_u32(vandq_u32(
+                     too_large, vreinterpretq_u32_f32(vdupq_n_f32(1.f)))));
+
+  // r = x - n * ln(2), with ln(2) split in two for precision.
+  x = vmlsq_f32(x, fx, vdupq_n_f32(0.693359375f));
+  x = vmlsq_f32(x, fx, vdupq_n_f32(-2.12194440e-4f));
+
+  // exp(r) ~= 1 + r + r^2 * p(r)
+  float32x4_t p = vdupq_n_f32(1.9875691500E-4f);
+  p = vmlaq_f32(vdupq_n_f32(1.3981999507E-3f), p, x);
+  p = vmlaq_f32(vdupq_n_f32(8.3334519073E-3f), p, x);
+  p = vmlaq_f32(vdupq_n_f32(4.1665795894E-2f), p, x);
+  p = vmlaq_f32(vdupq_n_f32(1.6666665459E-1f), p, x);
+  p = vmlaq_f32(vdupq_n_f32(5.0000001201E-1f), p, x);
+  const float32x4_t y =
+      vaddq_f32(vmlaq_f32(x, p, vmulq_f32(x, x)), vdupq_n_f32(1.f));
+
+  // Scale by 2^n.
+  int32x4_t n = vcvtq_s32_f32(fx);
+  n = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+inline float HorizontalMax(float32x4_t v) {
+  float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+  m = vpmax_f32(m, m);
+  return vget_lane_f32(m, 0);
+}
+
+inline float HorizontalSum(float32x4_t v) {
+  float32x2_t s = vpadd_f32(vget_low_f32(v), vget_high_f32(v));
+  s = vpadd_f32(s, s);
+  return vget_lane_f32(s, 0);
+}
+
+#endif  // USE_NEON
+
+// Implementation of float Softmax over the last dimension of a
+// [rows, depth] matrix, as in tensorflow/core/kernels/softmax_op_functor.h.
+// Each row is shifted by its maximum before exponentiation.
+inline void Softmax(const float* input_data, int rows, int depth,
+                    float* output_data) {
+  for (int r = 0; r < rows; ++r) {
+    const float* input_ptr = input_data + r * depth;
+    float* output_ptr = output_data + r * depth;
+
+    // Find the maximum of the row.
+    float max = std::numeric_limits<float>::lowest();
+    int c = 0;
+#ifdef USE_NEON
+    if (depth >= 4) {
+      float32x4_t max4 = vld1q_f32(input_ptr);
+      for (c = 4; c <= depth - 4; c += 4) {
+        max4 = vmaxq_f32(max4, vld1q_f32(input_ptr + c));
+      }
+      max = HorizontalMax(max4);
+    }
+#endif
+    for (; c < depth; ++c) {
+      max = std::max(max, input_ptr[c]);
+    }
+
+    // Store exp(x - max) and sum it up.
+    float sum = 0.f;
+    c = 0;
+#ifdef USE_NEON
+    const float32x4_t max4 = vdupq_n_f32(max);
+    float32x4_t sum4 = vdupq_n_f32(0.f);
+    for (; c <= depth - 4; c += 4) {
+      const float32x4_t e = Exp(vsubq_f32(vld1q_f32(input_ptr + c), max4));
+      vst1q_f32(output_ptr + c, e);
+      sum4 = vaddq_f32(sum4, e);
+    }
+    sum = HorizontalSum(sum4);
+#endif
+    for (; c < depth; ++c) {
+      output_ptr[c] = std::exp(input_ptr[c] - max);
+      sum += output_ptr[c];
+    }
+
+    // Normalize.
+    const float scale = 1.f / sum;
+    c = 0;
+#ifdef USE_NEON
+    for (; c <= depth - 4; c += 4) {
+      vst1q_f32(output_ptr + c, vmulq_n_f32(vld1q_f32(output_ptr + c), scale));
+    }
+#endif
+    for (; c < depth; ++c) {
+      output_ptr[c] *= scale;
+    }
+  }
+}
+
+}  // end namespace neon
+}  // end namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_NEON_SOFTMAX_FLOAT_H_
@@ -19,6 +19,8 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA
 
+#include <stdlib.h>
+
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -331,6 +333,35 @@ BM_ConvFloatFwd(32, 73, 73, 64, 192, 3, 3, 1, VALID, conv52);
 BM_ConvFloatFwd(32, 73, 73, 64, 64, 1, 1, 1, VALID, conv53);
 BM_ConvFloatFwd(32, 147, 147, 24, 64, 1, 1, 1, VALID, conv54);
 
+// Compares DeepConv2D (Winograd) with the spatial convolution for 3x3, stride 1
+// convolutions. TF_USE_DEEP_CONV2D is read by every Conv2D kernel invocation.
+#define BM_ConvFloatFwdDeep(BS, R, C, ID, OD, LABEL)                         \
+  static void BM_ConvFloatFwdSpatialCPU4_##LABEL(int iters) {                \
+    setenv("TF_USE_DEEP_CONV2D", "0", 1);                                    \
+    BM_ConvFloat(iters, BS, R, C, ID, OD, 3, 3, CONV_OP_FORWARD, 4, 1, SAME, \
+                 false, DT_FLOAT,                                            \
+                 strings::StrCat(BS, "_", R, "_", C, "_", ID, "_", OD,       \
+                                 "_spatial_cpu4"));                          \
+    unsetenv("TF_USE_DEEP_CONV2D");                                          \
+  }                                                                          \
+  static void BM_ConvFloatFwdDeepCPU4_##LABEL(int iters) {                   \
+    setenv("TF_USE_DEEP_CONV2D", "1", 1);                                    \
+    BM_ConvFloat(iters, BS, R, C, ID, OD, 3, 3, CONV_OP_FORWARD, 4, 1, SAME, \
+                 false, DT_FLOAT,                                            \
+                 strings::StrCat(BS, "_", R, "_", C, "_", ID, "_", OD,       \
+                                 "_deep_cpu4"));                             \
+    unsetenv("TF_USE_DEEP_CONV2D");                                          \
+  }                                                                          \
+  BENCHMARK(BM_ConvFloatFwdSpatialCPU4_##LABEL);                             \
+  BENCHMARK(BM_ConvFloatFwdDeepCPU4_##LABEL)
+
+BM_ConvFloatFwdDeep(1, 56, 56, 64, 64, deep0);
+BM_ConvFloatFwdDeep(1, 28, 28, 128, 128, deep1);
+BM_ConvFloatFwdDeep(1, 14, 14, 256, 256, deep2);
+BM_ConvFloatFwdDeep(1, 7, 7, 512, 512, deep3);
+BM_ConvFloatFwdDeep(32, 17, 17, 192, 192, deep4);
+BM_ConvFloatFwdDeep(32, 8, 8, 448, 384, deep5);
+
 #define BM_ConvFloatBkInAndFilter(BS, R, C, ID, OD, KR, KC, STR, PAD, LABEL)  \
   static void BM_ConvFloatBkInCPU1_##LABEL(int iters) {                       \
     BM_ConvFloat(iters, BS, R, C, ID, OD, KR, KC, CONV_OP_BACKPROP_INPUT, 1,  \
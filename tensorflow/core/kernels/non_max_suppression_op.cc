@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/non_max_suppression_op.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -65,29 +67,60 @@ static inline void DecreasingArgSort(const std::vector<float>& values,
       [&values](const int i, const int j) { return values[i] > values[j]; });
 }
 
+// A box with ordered corners, and its area.
+struct Box {
+  float ymin;
+  float xmin;
+  float ymax;
+  float xmax;
+  float area;
+};
+
+// Makes the box of the diagonal corners [y1, x1, y2, x2] in 'coords'.
+static inline Box MakeBox(const float* coords) {
+  Box box;
+  box.ymin = std::min<float>(coords[0], coords[2]);
+  box.xmin = std::min<float>(coords[1], coords[3]);
+  box.ymax = std::max<float>(coords[0], coords[2]);
+  box.xmax = std::max<float>(coords[1], coords[3]);
+  box.area = (box.ymax - box.ymin) * (box.xmax - box.xmin);
+  return box;
+}
+
 // Compute intersection-over-union overlap between boxes i and j.
-static inline float ComputeIOU(typename TTypes<float, 2>::ConstTensor boxes,
-                               int i, int j) {
-  const float ymin_i = std::min<float>(boxes(i, 0), boxes(i, 2));
-  const float xmin_i = std::min<float>(boxes(i, 1), boxes(i, 3));
-  const float ymax_i = std::max<float>(boxes(i, 0), boxes(i, 2));
-  const float xmax_i = std::max<float>(boxes(i, 1), boxes(i, 3));
-  const float ymin_j = std::min<float>(boxes(j, 0), boxes(j, 2));
-  const float xmin_j = std::min<float>(boxes(j, 1), boxes(j, 3));
-  const float ymax_j = std::max<float>(boxes(j, 0), boxes(j, 2));
-  const float xmax_j = std::max<float>(boxes(j, 1), boxes(j, 3));
-
-  const float area_i = (ymax_i - ymin_i) * (xmax_i - xmin_i);
-  const float area_j = (ymax_j - ymin_j) * (xmax_j - xmin_j);
-  if (area_i <= 0 || area_j <= 0) return 0.0;
-  const float intersection_ymin = std::max<float>(ymin_i, ymin_j);
-  const float intersection_xmin = std::max<float>(xmin_i, xmin_j);
-  const float intersection_ymax = std::min<float>(ymax_i, ymax_j);
-  const float intersection_xmax = std::min<float>(xmax_i, xmax_j);
-  const float intersection_area =
-      std::max<float>(intersection_ymax - intersection_ymin, 0.0) *
-      std::max<float>(intersection_xmax - intersection_xmin, 0.0);
-  return intersection_area / (area_i + area_j - intersection_area);
+static inline float ComputeIOU(const Box& i, const Box& j) {
+  if (i.area <= 0 || j.area <= 0) return 0.0;
+  const float intersection_ymin = std::max<float>(i.ymin, j.ymin);
+  const float intersection_ymax = std::min<float>(i.ymax, j.ymax);
+  // Most pairs of boxes don't overlap at all.
+  if (intersection_ymax <= intersection_ymin) return 0.0;
+  const float intersection_xmin = std::max<float>(i.xmin, j.xmin);
+  const float intersection_xmax = std::min<float>(i.xmax, j.xmax);
+  if (intersection_xmax <= intersection_xmin) return 0.0;
+  const float intersection_area = (intersection_ymax - intersection_ymin) *
+                                  (intersection_xmax - intersection_xmin);
+  return intersection_area / (i.area + j.area - intersection_area);
+}
+
+// Greedily selects up to 'max_output_size' of the 'candidates', which are
+// indices into 'boxes' in decreasing order of score. A candidate is selected
+// if its IOU with each of the boxes selected before it is at most
+// 'iou_threshold', so it is only compared with the selected boxes rather than
+// with all the others.
+static void SelectBoxes(const std::vector<Box>& boxes,
+                        const std::vector<int>& candidates, float iou_threshold,
+                        int max_output_size, std::vector<int>* selected) {
+  for (const int candidate : candidates) {
+    if (selected->size() >= max_output_size) break;
+    bool suppressed = false;
+    for (const int s : *selected) {
+      if (ComputeIOU(boxes[s], boxes[candidate]) > iou_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) selected->push_back(candidate);
+  }
 }
 
 void DoNonMaxSuppressionOp(OpKernelContext* context,
@@ -106,35 +139,20 @@ void DoNonMaxSuppressionOp(OpKernelContext* context,
 
   const int output_size =
       std::min(max_output_size.scalar<int>()(), num_boxes);
-  typename TTypes<float, 2>::ConstTensor boxes_data =
-      boxes.tensor<float, 2>();
+  const float* boxes_data = boxes.flat<float>().data();
+  std::vector<Box> boxes_vec(num_boxes);
+  for (int i = 0; i < num_boxes; ++i) {
+    boxes_vec[i] = MakeBox(boxes_data + 4 * i);
+  }
 
   std::vector<float> scores_data(num_boxes);
   std::copy_n(scores.flat<float>().data(), num_boxes, scores_data.begin());
   std::vector<int> sorted_indices;
   DecreasingArgSort(scores_data, &sorted_indices);
 
-  std::vector<bool> active(num_boxes, true);
   std::vector<int> selected;
-  int num_active = active.size();
-  for (int i = 0; i < num_boxes; ++i) {
-    if (num_active == 0 || selected.size() >= output_size) break;
-    if (active[i]) {
-      selected.push_back(sorted_indices[i]);
-    } else {
-      continue;
-    }
-    for (int j = i + 1; j < num_boxes; ++j) {
-      if (active[j]) {
-        float iou =
-          ComputeIOU(boxes_data, sorted_indices[i], sorted_indices[j]);
-        if (iou > iou_threshold) {
-          active[j] = false;
-          num_active--;
-        }
-      }
-    }
-  }
+  SelectBoxes(boxes_vec, sorted_indices, iou_threshold, output_size,
+              &selected);
 
   // Allocate output tensor
   Tensor* output = nullptr;
@@ -205,10 +223,175 @@ class NonMaxSuppressionV2Op : public OpKernel {
   }
 };
 
+// Runs non max suppression on each class of each image of a batch, then
+// keeps the best scoring boxes of each image over all its classes.
+class CombinedNonMaxSuppressionOp : public OpKernel {
+ public:
+  explicit CombinedNonMaxSuppressionOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    // boxes: [batch_size, num_boxes, q, 4]
+    const Tensor& boxes = context->input(0);
+    // scores: [batch_size, num_boxes, num_classes]
+    const Tensor& scores = context->input(1);
+    OP_REQUIRES(context, boxes.dims() == 4,
+                errors::InvalidArgument("boxes must be 4-D, got shape ",
+                                        boxes.shape().DebugString()));
+    OP_REQUIRES(context, boxes.dim_size(3) == 4,
+                errors::InvalidArgument("boxes must have 4 coordinates"));
+    OP_REQUIRES(context, scores.dims() == 3,
+                errors::InvalidArgument("scores must be 3-D, got shape ",
+                                        scores.shape().DebugString()));
+    const int batch_size = boxes.dim_size(0);
+    const int num_boxes = boxes.dim_size(1);
+    const int q = boxes.dim_size(2);
+    const int num_classes = scores.dim_size(2);
+    OP_REQUIRES(context,
+                scores.dim_size(0) == batch_size &&
+                    scores.dim_size(1) == num_boxes,
+                errors::InvalidArgument("scores has incompatible shape ",
+                                        scores.shape().DebugString()));
+    OP_REQUIRES(context, q == 1 || q == num_classes,
+                errors::InvalidArgument(
+                    "boxes must have 1 or num_classes boxes per box, got ", q));
+
+    int max_output_size_per_class;
+    int max_total_size;
+    float iou_threshold;
+    float score_threshold;
+    OP_REQUIRES_OK(context, GetScalar(context, 2, "max_output_size_per_class",
+                                      &max_output_size_per_class));
+    OP_REQUIRES_OK(context,
+                   GetScalar(context, 3, "max_total_size", &max_total_size));
+    OP_REQUIRES_OK(context,
+                   GetScalar(context, 4, "iou_threshold", &iou_threshold));
+    OP_REQUIRES_OK(context,
+                   GetScalar(context, 5, "score_threshold", &score_threshold));
+    OP_REQUIRES(context, max_total_size > 0,
+                errors::InvalidArgument("max_total_size must be > 0"));
+    OP_REQUIRES(context, iou_threshold >= 0 && iou_threshold <= 1,
+                errors::InvalidArgument("iou_threshold must be in [0, 1]"));
+
+    Tensor* nmsed_boxes = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch_size, max_total_size, 4}),
+                                &nmsed_boxes));
+    Tensor* nmsed_scores = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({batch_size, max_total_size}),
+                                &nmsed_scores));
+    Tensor* nmsed_classes = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                2, TensorShape({batch_size, max_total_size}),
+                                &nmsed_classes));
+    Tensor* valid_detections = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(3, TensorShape({batch_size}),
+                                                     &valid_detections));
+
+    const float* boxes_data = boxes.flat<float>().data();
+    const float* scores_data = scores.flat<float>().data();
+    std::vector<Box> boxes_vec(boxes.NumElements() / 4);
+    for (int64 i = 0; i < boxes_vec.size(); ++i) {
+      boxes_vec[i] = MakeBox(boxes_data + 4 * i);
+    }
+
+    // The boxes selected for each class of each image, as indices into
+    // boxes_vec.
+    std::vector<std::vector<int>> selected(batch_size * num_classes);
+    auto select_class = [&](int64 start, int64 limit) {
+      std::vector<int> candidates;
+      for (int64 i = start; i < limit; ++i) {
+        const int b = i / num_classes;
+        const int c = i % num_classes;
+        const float* class_scores = scores_data + b * num_boxes * num_classes;
+        // The n-th box of the class is boxes_vec[box_offset + n * q].
+        const int box_offset = b * num_boxes * q + (q == 1 ? 0 : c);
+        candidates.clear();
+        for (int n = 0; n < num_boxes; ++n) {
+          if (class_scores[n * num_classes + c] > score_threshold) {
+            candidates.push_back(n);
+          }
+        }
+        // Sorts by decreasing score, then by increasing box index.
+        std::sort(candidates.begin(), candidates.end(),
+                  [class_scores, num_classes, c](int n, int m) {
+                    const float score_n = class_scores[n * num_classes + c];
+                    const float score_m = class_scores[m * num_classes + c];
+                    return score_n > score_m || (score_n == score_m && n < m);
+                  });
+        for (int& n : candidates) n = box_offset + n * q;
+        SelectBoxes(boxes_vec, candidates, iou_threshold,
+                    max_output_size_per_class, &selected[i]);
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          batch_size * num_classes, 10 * num_boxes + 100, select_class);
+
+    auto nmsed_boxes_t = nmsed_boxes->tensor<float, 3>();
+    auto nmsed_scores_t = nmsed_scores->matrix<float>();
+    auto nmsed_classes_t = nmsed_classes->matrix<float>();
+    auto valid_detections_t = valid_detections->vec<int>();
+    nmsed_boxes_t.setZero();
+    nmsed_scores_t.setZero();
+    nmsed_classes_t.setZero();
+    struct Detection {
+      float score;
+      int class_id;
+      int box_index;
+    };
+    std::vector<Detection> detections;
+    for (int b = 0; b < batch_size; ++b) {
+      detections.clear();
+      for (int c = 0; c < num_classes; ++c) {
+        for (const int box_index : selected[b * num_classes + c]) {
+          // box_index is b * num_boxes * q + n * q, plus c if q > 1.
+          const int n = (box_index - b * num_boxes * q) / q;
+          detections.push_back(
+              {scores_data[(b * num_boxes + n) * num_classes + c], c,
+               box_index});
+        }
+      }
+      // The detections of each class are already in decreasing order of
+      // score, so a stable sort keeps ties in class order.
+      std::stable_sort(detections.begin(), detections.end(),
+                       [](const Detection& x, const Detection& y) {
+                         return x.score > y.score;
+                       });
+      const int num_detections =
+          std::min<int>(detections.size(), max_total_size);
+      for (int i = 0; i < num_detections; ++i) {
+        const float* coords = boxes_data + 4 * detections[i].box_index;
+        for (int k = 0; k < 4; ++k) nmsed_boxes_t(b, i, k) = coords[k];
+        nmsed_scores_t(b, i) = detections[i].score;
+        nmsed_classes_t(b, i) = detections[i].class_id;
+      }
+      valid_detections_t(b) = num_detections;
+    }
+  }
+
+ private:
+  template <typename T>
+  static Status GetScalar(OpKernelContext* context, int index,
+                          const char* name, T* value) {
+    const Tensor& tensor = context->input(index);
+    if (!TensorShapeUtils::IsScalar(tensor.shape())) {
+      return errors::InvalidArgument(name, " must be 0-D, got shape ",
+                                     tensor.shape().DebugString());
+    }
+    *value = tensor.scalar<T>()();
+    return Status::OK();
+  }
+};
+
 REGISTER_KERNEL_BUILDER(Name("NonMaxSuppression").Device(DEVICE_CPU),
                         NonMaxSuppressionOp<CPUDevice>);
 
 REGISTER_KERNEL_BUILDER(Name("NonMaxSuppressionV2").Device(DEVICE_CPU),
                         NonMaxSuppressionV2Op<CPUDevice>);
 
+REGISTER_KERNEL_BUILDER(Name("CombinedNonMaxSuppression").Device(DEVICE_CPU),
+                        CombinedNonMaxSuppressionOp);
+
 }  // namespace tensorflow
@@ -335,4 +335,107 @@ TEST_F(NonMaxSuppressionV2OpTest, TestEmptyInput) {
   test::ExpectTensorEqual<int>(expected, *GetOutput(0));
 }
 
+class CombinedNonMaxSuppressionOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_EXPECT_OK(NodeDefBuilder("combined_non_max_suppression_op",
+                                "CombinedNonMaxSuppression")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(CombinedNonMaxSuppressionOpTest, TestSelectFromThreeClustersPerClass) {
+  MakeOp();
+  // The boxes are shared by both classes.
+  AddInputFromArray<float>(
+      TensorShape({1, 6, 1, 4}),
+      {0, 0,  1, 1,  0, 0.1f,  1, 1.1f,  0, -0.1f, 1, 0.9f,
+       0, 10, 1, 11, 0, 10.1f, 1, 11.1f, 0, 100,  1, 101});
+  AddInputFromArray<float>(TensorShape({1, 6, 2}),
+                           {.9f, .1f, .75f, .2f, .6f, .3f, .95f, .4f, .5f, .5f,
+                            .3f, .6f});
+  AddInputFromArray<int>(TensorShape({}), {3});
+  AddInputFromArray<int>(TensorShape({}), {8});
+  AddInputFromArray<float>(TensorShape({}), {.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Class 0 selects boxes 3, 0 and 5, and class 1 boxes 5, 4 and 2.
+  Tensor boxes(allocator(), DT_FLOAT, TensorShape({1, 8, 4}));
+  test::FillValues<float>(&boxes, {0, 10,    1, 11,    //
+                                   0, 0,     1, 1,     //
+                                   0, 100,   1, 101,   //
+                                   0, 10.1f, 1, 11.1f,  //
+                                   0, 100,   1, 101,   //
+                                   0, -0.1f, 1, 0.9f,  //
+                                   0, 0,     0, 0,     //
+                                   0, 0,     0, 0});
+  test::ExpectTensorEqual<float>(boxes, *GetOutput(0));
+  Tensor scores(allocator(), DT_FLOAT, TensorShape({1, 8}));
+  test::FillValues<float>(&scores, {.95f, .9f, .6f, .5f, .3f, .3f, 0, 0});
+  test::ExpectTensorEqual<float>(scores, *GetOutput(1));
+  Tensor classes(allocator(), DT_FLOAT, TensorShape({1, 8}));
+  test::FillValues<float>(&classes, {0, 0, 1, 1, 0, 1, 0, 0});
+  test::ExpectTensorEqual<float>(classes, *GetOutput(2));
+  Tensor valid_detections(allocator(), DT_INT32, TensorShape({1}));
+  test::FillValues<int>(&valid_detections, {6});
+  test::ExpectTensorEqual<int>(valid_detections, *GetOutput(3));
+}
+
+TEST_F(CombinedNonMaxSuppressionOpTest, TestBatchAndScoreThreshold) {
+  MakeOp();
+  // Each class has its own boxes, and the images differ only in scores.
+  AddInputFromArray<float>(TensorShape({2, 2, 2, 4}),
+                           {0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1, 5, 5, 6, 6,
+                            0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1, 5, 5, 6, 6});
+  AddInputFromArray<float>(TensorShape({2, 2, 2}),
+                           {.9f, .1f, .8f, .7f, .2f, .1f, .05f, .1f});
+  AddInputFromArray<int>(TensorShape({}), {2});
+  AddInputFromArray<int>(TensorShape({}), {3});
+  AddInputFromArray<float>(TensorShape({}), {.5f});
+  AddInputFromArray<float>(TensorShape({}), {.15f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Image 0: class 0 suppresses box 1 with box 0, and class 1 keeps box 1
+  // only, since box 0 scores below the threshold. Image 1: class 0 keeps
+  // box 0 and class 1 nothing.
+  Tensor boxes(allocator(), DT_FLOAT, TensorShape({2, 3, 4}));
+  test::FillValues<float>(&boxes, {0, 0, 1, 1, 5, 5, 6, 6, 0, 0, 0, 0,
+                                   0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0});
+  test::ExpectTensorEqual<float>(boxes, *GetOutput(0));
+  Tensor scores(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&scores, {.9f, .7f, 0, .2f, 0, 0});
+  test::ExpectTensorEqual<float>(scores, *GetOutput(1));
+  Tensor classes(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&classes, {0, 1, 0, 0, 0, 0});
+  test::ExpectTensorEqual<float>(classes, *GetOutput(2));
+  Tensor valid_detections(allocator(), DT_INT32, TensorShape({2}));
+  test::FillValues<int>(&valid_detections, {2, 1});
+  test::ExpectTensorEqual<int>(valid_detections, *GetOutput(3));
+}
+
+TEST_F(CombinedNonMaxSuppressionOpTest, TestInvalidBoxesPerClass) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({1, 1, 2, 4}),
+                           {0, 0, 1, 1, 0, 0, 1, 1});
+  AddInputFromArray<float>(TensorShape({1, 1, 3}), {.9f, .8f, .7f});
+  AddInputFromArray<int>(TensorShape({}), {3});
+  AddInputFromArray<int>(TensorShape({}), {3});
+  AddInputFromArray<float>(TensorShape({}), {.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  Status s = RunOpKernel();
+
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(StringPiece(s.ToString())
+                  .contains("boxes must have 1 or num_classes boxes per box"))
+      << s;
+}
+
 }  // namespace tensorflow
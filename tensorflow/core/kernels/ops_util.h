@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/util/padding.h"
 
 namespace tensorflow {
@@ -81,6 +82,40 @@ bool IsDim0SliceAligned(const TensorShape& s, int64 start, int64 end_or_size) {
   }
 }
 
+// Given a shape 's' of a tensor of type T and the `begin` and `size` of a
+// slice, returns true iff the slice is one contiguous region of the tensor
+// whose start and end are aligned, i.e. the dimensions before the last
+// partially taken one are taken with size 1, and the ones after it are taken
+// whole. If so, sets '*offset' and '*num_elements' to the region in the
+// flattened tensor, so that the slice can share the underlying buffer.
+template <typename T>
+bool IsContiguousSliceAligned(const TensorShape& s,
+                              gtl::ArraySlice<int64> begin,
+                              gtl::ArraySlice<int64> size, int64* offset,
+                              int64* num_elements) {
+  int d = s.dims() - 1;
+  while (d >= 0 && begin[d] == 0 && size[d] == s.dim_size(d)) --d;
+  if (d < 0) return false;
+  for (int i = 0; i < d; ++i) {
+    if (size[i] != 1) return false;
+  }
+  int64 stride = 1;
+  for (int i = s.dims() - 1; i > d; --i) stride *= s.dim_size(i);
+  *num_elements = size[d] * stride;
+  if (*num_elements == 0) return false;
+  *offset = 0;
+  for (int i = d; i >= 0; --i) {
+    *offset += begin[i] * stride;
+    stride *= s.dim_size(i);
+  }
+#if EIGEN_MAX_ALIGN_BYTES == 0
+  return true;
+#else
+  return (*offset * sizeof(T)) % EIGEN_MAX_ALIGN_BYTES == 0 &&
+         (*num_elements * sizeof(T)) % EIGEN_MAX_ALIGN_BYTES == 0;
+#endif
+}
+
 // Returns <suffix> sanitized to have only [a-zA-Z0-9-_].
 string SanitizeThreadSuffix(string suffix);
 
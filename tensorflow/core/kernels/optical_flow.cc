@@ -0,0 +1,420 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/optical_flow.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define OPTICAL_FLOW_USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace tensorflow {
+namespace optical_flow {
+
+namespace {
+
+#ifdef OPTICAL_FLOW_USE_NEON
+inline float SumLanes(float32x4_t v) {
+  const float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+#endif  // OPTICAL_FLOW_USE_NEON
+
+// Returns the sums of x * x, x * y and y * y over 'n' values, i.e. the
+// spatial gradient matrix of a patch with gradients 'x' and 'y'.
+void GradientMatrix(const float* x, const float* y, int n, float* xx,
+                    float* xy, float* yy) {
+  float sum_xx = 0.0f;
+  float sum_xy = 0.0f;
+  float sum_yy = 0.0f;
+  int i = 0;
+#ifdef OPTICAL_FLOW_USE_NEON
+  float32x4_t acc_xx = vdupq_n_f32(0.0f);
+  float32x4_t acc_xy = vdupq_n_f32(0.0f);
+  float32x4_t acc_yy = vdupq_n_f32(0.0f);
+  for (; i <= n - 4; i += 4) {
+    const float32x4_t vx = vld1q_f32(x + i);
+    const float32x4_t vy = vld1q_f32(y + i);
+    acc_xx = vmlaq_f32(acc_xx, vx, vx);
+    acc_xy = vmlaq_f32(acc_xy, vx, vy);
+    acc_yy = vmlaq_f32(acc_yy, vy, vy);
+  }
+  sum_xx = SumLanes(acc_xx);
+  sum_xy = SumLanes(acc_xy);
+  sum_yy = SumLanes(acc_yy);
+#endif  // OPTICAL_FLOW_USE_NEON
+  for (; i < n; ++i) {
+    sum_xx += x[i] * x[i];
+    sum_xy += x[i] * y[i];
+    sum_yy += y[i] * y[i];
+  }
+  *xx = sum_xx;
+  *xy = sum_xy;
+  *yy = sum_yy;
+}
+
+// Returns the sums of d * x and d * y over 'n' values, i.e. the mismatch
+// vector of a patch with differences 'd' and gradients 'x' and 'y'.
+void MismatchVector(const float* d, const float* x, const float* y, int n,
+                    float* dx, float* dy) {
+  float sum_dx = 0.0f;
+  float sum_dy = 0.0f;
+  int i = 0;
+#ifdef OPTICAL_FLOW_USE_NEON
+  float32x4_t acc_dx = vdupq_n_f32(0.0f);
+  float32x4_t acc_dy = vdupq_n_f32(0.0f);
+  for (; i <= n - 4; i += 4) {
+    const float32x4_t vd = vld1q_f32(d + i);
+    acc_dx = vmlaq_f32(acc_dx, vd, vld1q_f32(x + i));
+    acc_dy = vmlaq_f32(acc_dy, vd, vld1q_f32(y + i));
+  }
+  sum_dx = SumLanes(acc_dx);
+  sum_dy = SumLanes(acc_dy);
+#endif  // OPTICAL_FLOW_USE_NEON
+  for (; i < n; ++i) {
+    sum_dx += d[i] * x[i];
+    sum_dy += d[i] * y[i];
+  }
+  *dx = sum_dx;
+  *dy = sum_dy;
+}
+
+void MeanAndStdDev(const float* values, int n, float* mean, float* std_dev) {
+  float sum = 0.0f;
+  float sum_squares = 0.0f;
+  for (int i = 0; i < n; ++i) {
+    sum += values[i];
+    sum_squares += values[i] * values[i];
+  }
+  *mean = sum / n;
+  *std_dev = sqrtf(std::max(sum_squares / n - *mean * *mean, 0.0f));
+}
+
+// The central difference of 'image' along x at pixel ('x', 'y'), or the
+// one-sided difference on the edges.
+inline float GradientX(const ImageView& image, int x, int y) {
+  const uint8* row = image.row(y);
+  if (x == 0) return row[1] - row[0];
+  if (x == image.width - 1) return row[x] - row[x - 1];
+  return 0.5f * (row[x + 1] - row[x - 1]);
+}
+
+inline float GradientY(const ImageView& image, int x, int y) {
+  if (y == 0) return image.row(1)[x] - image.row(0)[x];
+  if (y == image.height - 1) return image.row(y)[x] - image.row(y - 1)[x];
+  return 0.5f * (image.row(y + 1)[x] - image.row(y - 1)[x]);
+}
+
+// Bilinearly interpolates 'image', and optionally its gradients, at the
+// point ('x', 'y'), which must satisfy 0 <= x < width - 1 and
+// 0 <= y < height - 1.
+inline void Sample(const ImageView& image, float x, float y, float* value,
+                   float* gradient_x, float* gradient_y) {
+  const int x0 = static_cast<int>(x);
+  const int y0 = static_cast<int>(y);
+  const float fx = x - x0;
+  const float fy = y - y0;
+  const float w00 = (1.0f - fx) * (1.0f - fy);
+  const float w01 = fx * (1.0f - fy);
+  const float w10 = (1.0f - fx) * fy;
+  const float w11 = fx * fy;
+  const uint8* top = image.row(y0) + x0;
+  const uint8* bottom = top + image.stride;
+  *value = w00 * top[0] + w01 * top[1] + w10 * bottom[0] + w11 * bottom[1];
+  if (gradient_x != nullptr) {
+    *gradient_x = w00 * GradientX(image, x0, y0) +
+                  w01 * GradientX(image, x0 + 1, y0) +
+                  w10 * GradientX(image, x0, y0 + 1) +
+                  w11 * GradientX(image, x0 + 1, y0 + 1);
+    *gradient_y = w00 * GradientY(image, x0, y0) +
+                  w01 * GradientY(image, x0 + 1, y0) +
+                  w10 * GradientY(image, x0, y0 + 1) +
+                  w11 * GradientY(image, x0 + 1, y0 + 1);
+  }
+}
+
+// Refines the flow ('*g_x', '*g_y') of the point ('p_x', 'p_y') from 'prev'
+// to 'next', all in the pixels of one pyramid level, as the demo's
+// OpticalFlow::FindFlowAtPoint_LK() does. 'scratch' holds 4 patches.
+bool FindFlowAtLevel(const ImageView& prev, const ImageView& next, float p_x,
+                     float p_y, const LucasKanadeOptions& options,
+                     float* scratch, float* g_x, float* g_y) {
+  const int radius = options.window_radius;
+  const int patch_size = 2 * radius + 1;
+  const int n = patch_size * patch_size;
+  float* vals_i = scratch;
+  float* vals_i_x = scratch + n;
+  float* vals_i_y = scratch + 2 * n;
+  float* diffs = scratch + 3 * n;
+
+  // Sample positions are clipped so that bilinear interpolation stays
+  // inside the image.
+  const float max_x = prev.width - 1 - 1e-3f;
+  const float max_y = prev.height - 1 - 1e-3f;
+  int i = 0;
+  for (int y = -radius; y <= radius; ++y) {
+    const float y_pos = std::min(std::max(p_y + y, 0.0f), max_y);
+    for (int x = -radius; x <= radius; ++x, ++i) {
+      const float x_pos = std::min(std::max(p_x + x, 0.0f), max_x);
+      Sample(prev, x_pos, y_pos, &vals_i[i], &vals_i_x[i], &vals_i_y[i]);
+    }
+  }
+
+  float g_xx, g_xy, g_yy;
+  GradientMatrix(vals_i_x, vals_i_y, n, &g_xx, &g_xy, &g_yy);
+  const float det = g_xx * g_yy - g_xy * g_xy;
+  const float trace = g_xx + g_yy;
+  // Patches without texture, or with edges in only one direction, can't be
+  // tracked.
+  if (!(det > 1e-6f * trace * trace)) return false;
+  const float inv_det = 1.0f / det;
+
+  float mean_i = 0.0f;
+  float std_dev_i = 0.0f;
+  if (options.normalize_brightness) {
+    MeanAndStdDev(vals_i, n, &mean_i, &std_dev_i);
+  }
+
+  float flow_x = *g_x;
+  float flow_y = *g_y;
+  for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+    i = 0;
+    for (int y = -radius; y <= radius; ++y) {
+      const float y_pos = std::min(std::max(p_y + flow_y + y, 0.0f), max_y);
+      for (int x = -radius; x <= radius; ++x, ++i) {
+        const float x_pos =
+            std::min(std::max(p_x + flow_x + x, 0.0f), max_x);
+        Sample(next, x_pos, y_pos, &diffs[i], nullptr, nullptr);
+      }
+    }
+    if (options.normalize_brightness) {
+      float mean_j, std_dev_j;
+      MeanAndStdDev(diffs, n, &mean_j, &std_dev_j);
+      const float ratio = std_dev_j > 0.0f ? std_dev_i / std_dev_j : 1.0f;
+      for (i = 0; i < n; ++i) {
+        diffs[i] = (vals_i[i] - mean_i) - (diffs[i] - mean_j) * ratio;
+      }
+    } else {
+      for (i = 0; i < n; ++i) {
+        diffs[i] = vals_i[i] - diffs[i];
+      }
+    }
+
+    float b_x, b_y;
+    MismatchVector(diffs, vals_i_x, vals_i_y, n, &b_x, &b_y);
+    const float n_x = inv_det * (g_yy * b_x - g_xy * b_y);
+    const float n_y = inv_det * (g_xx * b_y - g_xy * b_x);
+    flow_x += n_x;
+    flow_y += n_y;
+    if (n_x * n_x + n_y * n_y < options.epsilon * options.epsilon) break;
+  }
+  *g_x = flow_x;
+  *g_y = flow_y;
+  return true;
+}
+
+// Tests the pixel at 'center' as the demo's TestCircle() does. Returns the
+// signed sum of the differences along the first run of 'threshold'
+// contiguous pixels of the circle given by 'offsets' that are all brighter
+// or all darker than the center by more than 'min_difference', or 0 if
+// there is no such run.
+inline int TestCircle(const uint8* center, const int* offsets, int perimeter,
+                      int threshold, int min_difference) {
+  const int center_value = *center;
+  // Go around the circle, and then some more for runs that wrap around.
+  const int num_total = perimeter + threshold - 1;
+  int num_above = 0;
+  int above_diff = 0;
+  int num_below = 0;
+  int below_diff = 0;
+  for (int i = 0; i < num_total; ++i) {
+    const int index = i < perimeter ? i : i - perimeter;
+    const int difference = center[offsets[index]] - center_value;
+    if (difference > min_difference) {
+      above_diff += difference;
+      num_below = 0;
+      below_diff = 0;
+      if (++num_above >= threshold) return above_diff;
+    } else if (difference < -min_difference) {
+      below_diff += difference;
+      num_above = 0;
+      above_diff = 0;
+      if (++num_below >= threshold) return below_diff;
+    } else {
+      num_above = 0;
+      num_below = 0;
+      above_diff = 0;
+      below_diff = 0;
+    }
+  }
+  return 0;
+}
+
+// Returns the score of the FAST corner at 'center' of the original FAST
+// paper: the larger of the sums of the differences beyond 'min_difference'
+// of the brighter and of the darker pixels of the circle. Unlike the sum
+// along one arc, it keeps growing towards the tip of a corner.
+inline int CornerScore(const uint8* center, const int* offsets, int perimeter,
+                       int min_difference) {
+  const int center_value = *center;
+  int brighter = 0;
+  int darker = 0;
+  for (int i = 0; i < perimeter; ++i) {
+    const int difference = center[offsets[i]] - center_value;
+    if (difference > min_difference) {
+      brighter += difference - min_difference;
+    } else if (difference < -min_difference) {
+      darker += -difference - min_difference;
+    }
+  }
+  return std::max(brighter, darker);
+}
+
+}  // namespace
+
+void DownsampleAveraged2x(const ImageView& src, uint8* dst, int dst_stride) {
+  const int width = src.width / 2;
+  const int height = src.height / 2;
+  for (int y = 0; y < height; ++y) {
+    const uint8* top = src.row(2 * y);
+    const uint8* bottom = top + src.stride;
+    uint8* out = dst + y * dst_stride;
+    int x = 0;
+#ifdef OPTICAL_FLOW_USE_NEON
+    // 32 source pixels of each row make 16 destination pixels.
+    for (; x <= width - 16; x += 16) {
+      uint16x8_t sum_lo = vpaddlq_u8(vld1q_u8(top + 2 * x));
+      uint16x8_t sum_hi = vpaddlq_u8(vld1q_u8(top + 2 * x + 16));
+      sum_lo = vpadalq_u8(sum_lo, vld1q_u8(bottom + 2 * x));
+      sum_hi = vpadalq_u8(sum_hi, vld1q_u8(bottom + 2 * x + 16));
+      vst1q_u8(out + x,
+               vcombine_u8(vshrn_n_u16(sum_lo, 2), vshrn_n_u16(sum_hi, 2)));
+    }
+#endif  // OPTICAL_FLOW_USE_NEON
+    for (; x < width; ++x) {
+      out[x] = (top[2 * x] + top[2 * x + 1] + bottom[2 * x] +
+                bottom[2 * x + 1]) >>
+               2;
+    }
+  }
+}
+
+bool TrackPoint(const std::vector<ImageView>& prev,
+                const std::vector<ImageView>& next, float x, float y,
+                const LucasKanadeOptions& options, float* flow_x,
+                float* flow_y) {
+  const int patch_size = 2 * options.window_radius + 1;
+  std::vector<float> scratch(4 * patch_size * patch_size);
+  const int num_levels = std::min(prev.size(), next.size());
+  float g_x = *flow_x;
+  float g_y = *flow_y;
+  // Refine the flow from the coarsest level to the finest one, skipping the
+  // levels too small to interpolate.
+  for (int level = num_levels - 1; level >= 0; --level) {
+    if (std::min(prev[level].width, next[level].width) < 2 ||
+        std::min(prev[level].height, next[level].height) < 2) {
+      if (level == 0) return false;
+      continue;
+    }
+    const float shrink = 1 << level;
+    float level_g_x = g_x / shrink;
+    float level_g_y = g_y / shrink;
+    if (!FindFlowAtLevel(prev[level], next[level], x / shrink, y / shrink,
+                         options, scratch.data(), &level_g_x, &level_g_y)) {
+      return false;
+    }
+    g_x = level_g_x * shrink;
+    g_y = level_g_y * shrink;
+  }
+  *flow_x = g_x;
+  *flow_y = g_y;
+  const float new_x = x + g_x;
+  const float new_y = y + g_y;
+  return new_x >= 0.0f && new_x <= next[0].width - 1 && new_y >= 0.0f &&
+         new_y <= next[0].height - 1;
+}
+
+void DetectFastKeypoints(const ImageView& image, int arc_length, int threshold,
+                         int border, int max_keypoints,
+                         std::vector<Keypoint>* keypoints) {
+  // The four compass points of the circle, of which any run of 12 covers
+  // at least 3 and any run of 9 at least 2.
+  static const int kShortX[] = {-3, 0, 3, 0};
+  static const int kShortY[] = {0, -3, 0, 3};
+  static const int kFullX[] = {-1, 0,  1,  2,  3,  3,  3,  2,
+                               1,  0,  -1, -2, -3, -3, -3, -2};
+  static const int kFullY[] = {-3, -3, -3, -2, -1, 0,  1,  2,
+                               3,  3,  3,  2,  1,  0,  -1, -2};
+  int short_offsets[4];
+  for (int i = 0; i < 4; ++i) {
+    short_offsets[i] = kShortX[i] + kShortY[i] * image.stride;
+  }
+  int full_offsets[16];
+  for (int i = 0; i < 16; ++i) {
+    full_offsets[i] = kFullX[i] + kFullY[i] * image.stride;
+  }
+
+  DCHECK(arc_length >= 9 && arc_length <= 12) << arc_length;
+  const int short_arc_length = arc_length >= 12 ? 3 : 2;
+  border = std::max(border, 3);
+  const int width = image.width;
+  const int height = image.height;
+  if (width <= 2 * border || height <= 2 * border || max_keypoints <= 0) {
+    return;
+  }
+  std::vector<int> scores(width * height, 0);
+  for (int y = border; y < height - border; ++y) {
+    const uint8* pixel = image.row(y) + border;
+    for (int x = border; x < width - border; ++x, ++pixel) {
+      if (TestCircle(pixel, short_offsets, 4, short_arc_length, threshold) !=
+              0 &&
+          TestCircle(pixel, full_offsets, 16, arc_length, threshold) != 0) {
+        scores[y * width + x] =
+            CornerScore(pixel, full_offsets, 16, threshold);
+      }
+    }
+  }
+
+  // Keep the local maxima. Of equal neighbors, the first in raster order
+  // wins.
+  const size_t first = keypoints->size();
+  for (int y = border; y < height - border; ++y) {
+    for (int x = border; x < width - border; ++x) {
+      const int* score = &scores[y * width + x];
+      if (*score == 0) continue;
+      const int* above = score - width;
+      const int* below = score + width;
+      if (*score > above[-1] && *score > above[0] && *score > above[1] &&
+          *score > score[-1] && *score >= score[1] && *score >= below[-1] &&
+          *score >= below[0] && *score >= below[1]) {
+        keypoints->push_back({x, y, static_cast<float>(*score)});
+      }
+    }
+  }
+  std::stable_sort(
+      keypoints->begin() + first, keypoints->end(),
+      [](const Keypoint& a, const Keypoint& b) { return a.score > b.score; });
+  if (keypoints->size() - first > static_cast<size_t>(max_keypoints)) {
+    keypoints->resize(first + max_keypoints);
+  }
+}
+
+}  // namespace optical_flow
+}  // namespace tensorflow
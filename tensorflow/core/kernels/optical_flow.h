@@ -0,0 +1,93 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_OPTICAL_FLOW_H_
+#define TENSORFLOW_CORE_KERNELS_OPTICAL_FLOW_H_
+
+// Tracking primitives on 8-bit grayscale images, used by the ImagePyramid,
+// LucasKanadeOpticalFlow and FastKeypoints ops. They are ported from the
+// Android demo tracker in tensorflow/examples/android/jni/object_tracking,
+// with NEON versions of its inner loops on ARM.
+
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace optical_flow {
+
+// A view of a row-major grayscale image.
+struct ImageView {
+  const uint8* data;
+  int width;
+  int height;
+  int stride;
+
+  const uint8* row(int y) const { return data + y * stride; }
+};
+
+// Writes the 2x2 box average of 'src' to 'dst', which is 'src.width / 2'
+// by 'src.height / 2' pixels with rows 'dst_stride' apart. The odd last
+// row and column of 'src' are dropped, and averages are truncated, as in
+// the demo's Image::DownsampleAveraged().
+void DownsampleAveraged2x(const ImageView& src, uint8* dst, int dst_stride);
+
+struct LucasKanadeOptions {
+  // The patch around each point is 2 * window_radius + 1 pixels wide.
+  int window_radius = 3;
+  // The most Gauss-Newton steps per pyramid level.
+  int max_iterations = 10;
+  // A level stops iterating once a step is shorter than this, in pixels.
+  float epsilon = 0.03f;
+  // Whether to match the mean and standard deviation of the patches, which
+  // makes the flow robust to exposure changes between frames but slows down
+  // its convergence.
+  bool normalize_brightness = false;
+};
+
+// Tracks the point ('x', 'y') of 'prev' into 'next' with pyramidal
+// Lucas-Kanade. 'prev' and 'next' hold the levels of the two pyramids,
+// level 0 being the full resolution, and the coordinates are in level 0
+// pixels. '*flow_x' and '*flow_y' hold the initial guess of the motion and
+// receive the result. Returns false if the point can't be tracked, i.e. it
+// leaves the image or its patch has no texture.
+bool TrackPoint(const std::vector<ImageView>& prev,
+                const std::vector<ImageView>& next, float x, float y,
+                const LucasKanadeOptions& options, float* flow_x,
+                float* flow_y);
+
+struct Keypoint {
+  int x;
+  int y;
+  float score;
+};
+
+// Appends the FAST corners of 'image' to '*keypoints', strongest first. A
+// pixel is a corner if at least 'arc_length' (9 to 12) contiguous pixels of
+// the 16 on the circle of radius 3 around it are all brighter, or all
+// darker, than it by more than 'threshold'. The demo tracker uses 12, which
+// misses right-angle corners. The score is the larger of the sums of the
+// differences beyond 'threshold' of the brighter and of the darker pixels of
+// the circle. Only corners whose score is the largest of their 3x3
+// neighborhood are kept, and at most 'max_keypoints' of them.
+// Pixels closer than 'border' (at least 3) to the edges are not considered.
+void DetectFastKeypoints(const ImageView& image, int arc_length, int threshold,
+                         int border, int max_keypoints,
+                         std::vector<Keypoint>* keypoints);
+
+}  // namespace optical_flow
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_OPTICAL_FLOW_H_
@@ -0,0 +1,285 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc.
+
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/optical_flow.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Checks that 'images' is a batch of grayscale images that an ImageView can
+// address.
+Status CheckGrayscale(const Tensor& images) {
+  if (images.dims() != 4 || images.dim_size(3) != 1) {
+    return errors::InvalidArgument(
+        "images must have shape [batch, height, width, 1], got ",
+        images.shape().DebugString());
+  }
+  if (!FastBoundsCheck(images.dim_size(1) * images.dim_size(2),
+                       std::numeric_limits<int>::max())) {
+    return errors::InvalidArgument("images are too large, got ",
+                                   images.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// Returns a view of image 'b' of the grayscale batch 'images'.
+optical_flow::ImageView GetImage(const Tensor& images, int64 b) {
+  const int64 height = images.dim_size(1);
+  const int64 width = images.dim_size(2);
+  return {images.flat<uint8>().data() + b * height * width,
+          static_cast<int>(width), static_cast<int>(height),
+          static_cast<int>(width)};
+}
+
+}  // namespace
+
+class ImagePyramidOp : public OpKernel {
+ public:
+  explicit ImagePyramidOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_levels", &num_levels_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& images = context->input(0);
+    OP_REQUIRES_OK(context, CheckGrayscale(images));
+    const int64 batch = images.dim_size(0);
+    const int64 height = images.dim_size(1);
+    const int64 width = images.dim_size(2);
+    OP_REQUIRES(
+        context,
+        (height >> (num_levels_ - 1)) > 0 && (width >> (num_levels_ - 1)) > 0,
+        errors::InvalidArgument("images of shape ",
+                                images.shape().DebugString(),
+                                " are too small for ", num_levels_,
+                                " levels"));
+
+    // Level 0 is the input itself.
+    context->set_output(0, images);
+    const Tensor* prev = &images;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    for (int level = 1; level < num_levels_; ++level) {
+      const int64 level_height = prev->dim_size(1) / 2;
+      const int64 level_width = prev->dim_size(2) / 2;
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  level,
+                                  TensorShape({batch, level_height,
+                                               level_width, 1}),
+                                  &output));
+      uint8* output_data = output->flat<uint8>().data();
+      const Tensor& src = *prev;
+      // Each image is downsampled in bands of rows. Rows of the output
+      // depend only on two rows of the source, so the bands are
+      // independent.
+      auto downsample = [&src, output_data, level_height, level_width](
+                            int64 start, int64 limit) {
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / level_height;
+          const int64 y = i % level_height;
+          optical_flow::ImageView image = GetImage(src, b);
+          image.data = image.row(2 * y);
+          image.height = 2;
+          optical_flow::DownsampleAveraged2x(
+              image, output_data + i * level_width, level_width);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            batch * level_height, 4 * level_width, downsample);
+      prev = output;
+    }
+  }
+
+ private:
+  int num_levels_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ImagePyramid").Device(DEVICE_CPU),
+                        ImagePyramidOp);
+
+class LucasKanadeOpticalFlowOp : public OpKernel {
+ public:
+  explicit LucasKanadeOpticalFlowOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_levels", &num_levels_));
+    OP_REQUIRES_OK(context, context->GetAttr("window_radius",
+                                             &options_.window_radius));
+    OP_REQUIRES_OK(context, context->GetAttr("max_iterations",
+                                             &options_.max_iterations));
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &options_.epsilon));
+    OP_REQUIRES_OK(context, context->GetAttr("normalize_brightness",
+                                             &options_.normalize_brightness));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList prev_levels;
+    OP_REQUIRES_OK(context, context->input_list("prev_levels", &prev_levels));
+    OpInputList next_levels;
+    OP_REQUIRES_OK(context, context->input_list("next_levels", &next_levels));
+    const Tensor& points = context->input(2 * num_levels_);
+    OP_REQUIRES(context, points.dims() == 3 && points.dim_size(2) == 2,
+                errors::InvalidArgument(
+                    "points must have shape [batch, num_points, 2], got ",
+                    points.shape().DebugString()));
+    const int64 batch = points.dim_size(0);
+    const int64 num_points = points.dim_size(1);
+    for (int level = 0; level < num_levels_; ++level) {
+      const Tensor& prev = prev_levels[level];
+      OP_REQUIRES_OK(context, CheckGrayscale(prev));
+      OP_REQUIRES(context, prev.dim_size(0) == batch,
+                  errors::InvalidArgument(
+                      "The pyramids must hold ", batch, " images, got ",
+                      prev.shape().DebugString(), " at level ", level));
+      OP_REQUIRES(context, prev.shape() == next_levels[level].shape(),
+                  errors::InvalidArgument(
+                      "The pyramids must have the same shapes, got ",
+                      prev.shape().DebugString(), " and ",
+                      next_levels[level].shape().DebugString(), " at level ",
+                      level));
+      OP_REQUIRES(context, prev.dim_size(1) > 0 && prev.dim_size(2) > 0,
+                  errors::InvalidArgument("Level ", level, " is empty"));
+    }
+
+    Tensor* next_points = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, points.shape(), &next_points));
+    Tensor* status = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       1, TensorShape({batch, num_points}), &status));
+
+    const float* points_data = points.flat<float>().data();
+    float* next_points_data = next_points->flat<float>().data();
+    bool* status_data = status->flat<bool>().data();
+    const optical_flow::LucasKanadeOptions options = options_;
+    auto track = [&](int64 start, int64 limit) {
+      std::vector<optical_flow::ImageView> prev(num_levels_);
+      std::vector<optical_flow::ImageView> next(num_levels_);
+      int64 b = -1;
+      for (int64 i = start; i < limit; ++i) {
+        if (i / num_points != b) {
+          b = i / num_points;
+          for (int level = 0; level < num_levels_; ++level) {
+            prev[level] = GetImage(prev_levels[level], b);
+            next[level] = GetImage(next_levels[level], b);
+          }
+        }
+        const float y = points_data[2 * i];
+        const float x = points_data[2 * i + 1];
+        float flow_x = 0.0f;
+        float flow_y = 0.0f;
+        const bool tracked = optical_flow::TrackPoint(prev, next, x, y,
+                                                      options, &flow_x,
+                                                      &flow_y);
+        status_data[i] = tracked;
+        next_points_data[2 * i] = tracked ? y + flow_y : y;
+        next_points_data[2 * i + 1] = tracked ? x + flow_x : x;
+      }
+    };
+    const int patch_size = 2 * options_.window_radius + 1;
+    const int64 cost_per_point = static_cast<int64>(num_levels_) *
+                                 (options_.max_iterations + 4) * patch_size *
+                                 patch_size * 20;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch * num_points, cost_per_point, track);
+  }
+
+ private:
+  int num_levels_;
+  optical_flow::LucasKanadeOptions options_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("LucasKanadeOpticalFlow").Device(DEVICE_CPU),
+                        LucasKanadeOpticalFlowOp);
+
+class FastKeypointsOp : public OpKernel {
+ public:
+  explicit FastKeypointsOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("max_keypoints", &max_keypoints_));
+    OP_REQUIRES_OK(context, context->GetAttr("arc_length", &arc_length_));
+    OP_REQUIRES(context, arc_length_ <= 12,
+                errors::InvalidArgument(
+                    "arc_length must be between 9 and 12, got ", arc_length_));
+    OP_REQUIRES_OK(context, context->GetAttr("threshold", &threshold_));
+    OP_REQUIRES_OK(context, context->GetAttr("border", &border_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& images = context->input(0);
+    OP_REQUIRES_OK(context, CheckGrayscale(images));
+    const int64 batch = images.dim_size(0);
+
+    Tensor* keypoints = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch, max_keypoints_, 2}),
+                                &keypoints));
+    Tensor* scores = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       1, TensorShape({batch, max_keypoints_}), &scores));
+    Tensor* num_keypoints = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(2, TensorShape({batch}),
+                                                     &num_keypoints));
+    keypoints->flat<float>().setZero();
+    scores->flat<float>().setZero();
+
+    auto keypoints_data = keypoints->tensor<float, 3>();
+    auto scores_data = scores->matrix<float>();
+    auto num_keypoints_data = num_keypoints->vec<int32>();
+    auto detect = [&](int64 start, int64 limit) {
+      std::vector<optical_flow::Keypoint> found;
+      for (int64 b = start; b < limit; ++b) {
+        found.clear();
+        optical_flow::DetectFastKeypoints(GetImage(images, b), arc_length_,
+                                          threshold_, border_, max_keypoints_,
+                                          &found);
+        for (size_t i = 0; i < found.size(); ++i) {
+          keypoints_data(b, i, 0) = found[i].y;
+          keypoints_data(b, i, 1) = found[i].x;
+          scores_data(b, i) = found[i].score;
+        }
+        num_keypoints_data(b) = found.size();
+      }
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch,
+          images.dim_size(1) * images.dim_size(2) * 20, detect);
+  }
+
+ private:
+  int max_keypoints_;
+  int arc_length_;
+  int threshold_;
+  int border_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("FastKeypoints").Device(DEVICE_CPU),
+                        FastKeypointsOp);
+
+}  // namespace tensorflow
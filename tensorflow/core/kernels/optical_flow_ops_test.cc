@@ -0,0 +1,262 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <math.h>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a smooth, textured image of 'height' by 'width' pixels whose
+// content is moved by ('dy', 'dx').
+std::vector<uint8> MakeTexture(int height, int width, float dy, float dx) {
+  std::vector<uint8> image(height * width);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const float u = x - dx;
+      const float v = y - dy;
+      image[y * width + x] = static_cast<uint8>(
+          lrintf(128 + 60 * sinf(u * 0.21f) * cosf(v * 0.17f) +
+                 40 * sinf((u + v) * 0.11f + 1)));
+    }
+  }
+  return image;
+}
+
+class ImagePyramidOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_levels) {
+    TF_EXPECT_OK(NodeDefBuilder("image_pyramid_op", "ImagePyramid")
+                     .Input(FakeInput(DT_UINT8))
+                     .Attr("num_levels", num_levels)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(ImagePyramidOpTest, AveragesBlocks) {
+  MakeOp(3);
+  // A 5x6 image, whose last row is dropped by the first level.
+  AddInputFromArray<uint8>(TensorShape({1, 5, 6, 1}),
+                           {0,   4,   8,   12,  16,  20,   //
+                            1,   5,   9,   13,  17,  21,   //
+                            100, 100, 200, 200, 7,   7,    //
+                            100, 100, 200, 200, 7,   8,    //
+                            255, 255, 255, 255, 255, 255});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<uint8>(*GetInput(0), *GetOutput(0));
+
+  Tensor level1(allocator(), DT_UINT8, TensorShape({1, 2, 3, 1}));
+  test::FillValues<uint8>(&level1, {2, 10, 18, 100, 200, 7});
+  test::ExpectTensorEqual<uint8>(level1, *GetOutput(1));
+
+  Tensor level2(allocator(), DT_UINT8, TensorShape({1, 1, 1, 1}));
+  test::FillValues<uint8>(&level2, {(2 + 10 + 100 + 200) / 4});
+  test::ExpectTensorEqual<uint8>(level2, *GetOutput(2));
+}
+
+TEST_F(ImagePyramidOpTest, WideBatch) {
+  // Wide enough for the NEON path, with a scalar tail.
+  const int height = 6;
+  const int width = 70;
+  MakeOp(2);
+  std::vector<uint8> images = MakeTexture(height, width, 0.0f, 0.0f);
+  const std::vector<uint8> second = MakeTexture(height, width, 3.0f, 5.0f);
+  images.insert(images.end(), second.begin(), second.end());
+  AddInputFromArray<uint8>(TensorShape({2, height, width, 1}), images);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_UINT8,
+                  TensorShape({2, height / 2, width / 2, 1}));
+  auto expected_flat = expected.flat<uint8>();
+  for (int b = 0; b < 2; ++b) {
+    const uint8* image = images.data() + b * height * width;
+    for (int y = 0; y < height / 2; ++y) {
+      for (int x = 0; x < width / 2; ++x) {
+        const uint8* top = image + 2 * y * width + 2 * x;
+        expected_flat((b * height / 2 + y) * (width / 2) + x) =
+            (top[0] + top[1] + top[width] + top[width + 1]) / 4;
+      }
+    }
+  }
+  test::ExpectTensorEqual<uint8>(expected, *GetOutput(1));
+}
+
+TEST_F(ImagePyramidOpTest, TooSmall) {
+  MakeOp(3);
+  AddInputFromArray<uint8>(TensorShape({1, 3, 8, 1}),
+                           std::vector<uint8>(24, 0));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "too small for 3 levels"))
+      << s;
+}
+
+class LucasKanadeOpticalFlowOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_levels) {
+    TF_EXPECT_OK(NodeDefBuilder("lucas_kanade_op", "LucasKanadeOpticalFlow")
+                     .Input(FakeInput(num_levels, DT_UINT8))
+                     .Input(FakeInput(num_levels, DT_UINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("num_levels", num_levels)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+
+  // Adds the 2 level pyramid of 'image' as inputs.
+  void AddPyramid(const std::vector<uint8>& image, int height, int width) {
+    AddInputFromArray<uint8>(TensorShape({1, height, width, 1}), image);
+    std::vector<uint8> level1((height / 2) * (width / 2));
+    for (int y = 0; y < height / 2; ++y) {
+      for (int x = 0; x < width / 2; ++x) {
+        const uint8* top = image.data() + 2 * y * width + 2 * x;
+        level1[y * (width / 2) + x] =
+            (top[0] + top[1] + top[width] + top[width + 1]) / 4;
+      }
+    }
+    AddInputFromArray<uint8>(TensorShape({1, height / 2, width / 2, 1}),
+                             level1);
+  }
+};
+
+TEST_F(LucasKanadeOpticalFlowOpTest, TracksTranslation) {
+  const int height = 64;
+  const int width = 80;
+  const float dy = -2.0f;
+  const float dx = 3.5f;
+  MakeOp(2);
+  const std::vector<uint8> prev = MakeTexture(height, width, 0.0f, 0.0f);
+  const std::vector<uint8> next = MakeTexture(height, width, dy, dx);
+  // The inputs are ordered prev_levels, next_levels, points.
+  AddPyramid(prev, height, width);
+  AddPyramid(next, height, width);
+  AddInputFromArray<float>(TensorShape({1, 3, 2}),
+                           {20.0f, 20.0f, 32.0f, 45.5f, 40.0f, 60.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 3, 2}));
+  test::FillValues<float>(&expected, {20.0f + dy, 20.0f + dx, 32.0f + dy,
+                                      45.5f + dx, 40.0f + dy, 60.0f + dx});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.15);
+  Tensor status(allocator(), DT_BOOL, TensorShape({1, 3}));
+  test::FillValues<bool>(&status, {true, true, true});
+  test::ExpectTensorEqual<bool>(status, *GetOutput(1));
+}
+
+TEST_F(LucasKanadeOpticalFlowOpTest, FlatPatchIsNotTracked) {
+  const int height = 32;
+  const int width = 32;
+  MakeOp(2);
+  const std::vector<uint8> flat(height * width, 77);
+  AddPyramid(flat, height, width);
+  AddPyramid(flat, height, width);
+  AddInputFromArray<float>(TensorShape({1, 1, 2}), {10.0f, 12.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(*GetInput(4), *GetOutput(0));
+  EXPECT_FALSE(GetOutput(1)->matrix<bool>()(0, 0));
+}
+
+TEST_F(LucasKanadeOpticalFlowOpTest, MismatchedPyramids) {
+  MakeOp(1);
+  AddInputFromArray<uint8>(TensorShape({1, 8, 8, 1}),
+                           std::vector<uint8>(64, 0));
+  AddInputFromArray<uint8>(TensorShape({1, 8, 6, 1}),
+                           std::vector<uint8>(48, 0));
+  AddInputFromArray<float>(TensorShape({1, 1, 2}), {1.0f, 1.0f});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "must have the same shapes"))
+      << s;
+}
+
+class FastKeypointsOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int max_keypoints, int arc_length) {
+    TF_EXPECT_OK(NodeDefBuilder("fast_keypoints_op", "FastKeypoints")
+                     .Input(FakeInput(DT_UINT8))
+                     .Attr("max_keypoints", max_keypoints)
+                     .Attr("arc_length", arc_length)
+                     .Attr("border", 3)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+
+  // Adds a batch of two images: a bright rectangle on a dark background,
+  // and a flat image.
+  void AddRectangles() {
+    const int height = 48;
+    const int width = 64;
+    std::vector<uint8> images(2 * height * width, 20);
+    for (int y = 15; y < 35; ++y) {
+      for (int x = 20; x < 45; ++x) {
+        images[y * width + x] = 200;
+      }
+    }
+    AddInputFromArray<uint8>(TensorShape({2, height, width, 1}), images);
+  }
+};
+
+TEST_F(FastKeypointsOpTest, FindsCorners) {
+  MakeOp(6, 9);
+  AddRectangles();
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The four corners of the rectangle have the same score, so they come
+  // in raster order.
+  Tensor keypoints(allocator(), DT_FLOAT, TensorShape({2, 6, 2}));
+  test::FillValues<float>(&keypoints, {15, 20, 15, 44, 34, 20, 34, 44, 0, 0,
+                                       0,  0,  0,  0,  0,  0,  0,  0,  0, 0,
+                                       0,  0,  0,  0});
+  test::ExpectTensorEqual<float>(keypoints, *GetOutput(0));
+  const auto scores = GetOutput(1)->matrix<float>();
+  EXPECT_GT(scores(0, 0), 0.0f);
+  EXPECT_EQ(scores(0, 0), scores(0, 3));
+  EXPECT_EQ(0.0f, scores(0, 4));
+  Tensor num_keypoints(allocator(), DT_INT32, TensorShape({2}));
+  test::FillValues<int32>(&num_keypoints, {4, 0});
+  test::ExpectTensorEqual<int32>(num_keypoints, *GetOutput(2));
+}
+
+TEST_F(FastKeypointsOpTest, LongArcsMissRightAngles) {
+  MakeOp(6, 12);
+  AddRectangles();
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor num_keypoints(allocator(), DT_INT32, TensorShape({2}));
+  test::FillValues<int32>(&num_keypoints, {0, 0});
+  test::ExpectTensorEqual<int32>(num_keypoints, *GetOutput(2));
+}
+
+TEST_F(FastKeypointsOpTest, MaxKeypoints) {
+  MakeOp(2, 9);
+  AddRectangles();
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor keypoints(allocator(), DT_FLOAT, TensorShape({2, 2, 2}));
+  test::FillValues<float>(&keypoints, {15, 20, 15, 44, 0, 0, 0, 0});
+  test::ExpectTensorEqual<float>(keypoints, *GetOutput(0));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,256 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/padded_batch_util.h"
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_util.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The following five functions are copied from padding_fifo_queue.cc.
+// TODO(mrry): Reconcile these functions with the similar methods in the
+// queue implementation.
+Status ValidateElementToLargerSlice(const Tensor& element, Tensor* parent) {
+  DCHECK_NE(parent->dim_size(0), 0);
+  if (element.NumElements() > (parent->NumElements() / parent->dim_size(0))) {
+    TensorShape chip_shape = parent->shape();
+    chip_shape.RemoveDim(0);
+    return errors::Internal(
+        "HandleElementToLargerSlice Cannot copy slice: number of entries in "
+        "element is greater than number of elements in parent slice.  ",
+        "Shapes are: [element]: ", element.shape().DebugString(),
+        ", [parent slice]: ", chip_shape.DebugString());
+  }
+  return Status::OK();
+}
+
+template <typename T, int NDIMS>
+Status HandleElementToLargerSlice(const Tensor& element, Tensor* parent,
+                                  int index) {
+  TF_RETURN_IF_ERROR(ValidateElementToLargerSlice(element, parent));
+  if (element.NumElements() == 0) {
+    return Status::OK();
+  }
+  auto element_t = element.tensor<T, NDIMS>();
+  auto parent_t = parent->tensor<T, NDIMS + 1>();
+  Eigen::DSizes<Eigen::DenseIndex, NDIMS + 1> slice_indices;
+  slice_indices[0] = index;
+  Eigen::DSizes<Eigen::DenseIndex, NDIMS + 1> slice_size;
+  slice_size[0] = 1;
+  for (size_t i = 1; i < slice_size.size(); ++i) {
+    slice_size[i] = element_t.dimension(i - 1);
+  }
+  parent_t.slice(slice_indices, slice_size) = element_t.reshape(slice_size);
+  return Status::OK();
+}
+
+template <int NDIMS>
+Status HandleElementToLargerSliceWithRank(const Tensor& element, Tensor* parent,
+                                          int index) {
+#define HANDLE_TYPE(T)                                                   \
+  case DataTypeToEnum<T>::value: {                                       \
+    return HandleElementToLargerSlice<T, NDIMS>(element, parent, index); \
+  }
+
+  switch (element.dtype()) {
+    TF_CALL_ALL_TYPES(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return errors::Unimplemented(
+          "HandleElementToLargerSliceWithRank Unhandled data type: ",
+          element.dtype());
+  }
+}
+
+Status CopyElementToLargerSlice(const Tensor& element, Tensor* parent,
+                                int index) {
+  if (parent->dims() != element.dims() + 1) {
+    return errors::Internal(
+        "Mismatched ranks.  Element's rank is: ", element.dims(),
+        " but element is meant to be a slice in output Tensor having rank: ",
+        parent->dims(), " (should be: ", element.dims() + 1, ")");
+  }
+
+#define HANDLE_DIMS(NDIMS)                                                  \
+  case NDIMS: {                                                             \
+    TF_RETURN_IF_ERROR(                                                     \
+        HandleElementToLargerSliceWithRank<NDIMS>(element, parent, index)); \
+    return Status::OK();                                                    \
+  }
+
+  switch (element.dims()) {
+    HANDLE_DIMS(0);
+    HANDLE_DIMS(1);
+    HANDLE_DIMS(2);
+    HANDLE_DIMS(3);
+    HANDLE_DIMS(4);
+#undef HANDLE_DIMS
+    default:
+      return errors::Unimplemented("CopyElementToLargerSlice Unhandled rank: ",
+                                   element.dims());
+  }
+}
+
+Status SetElementZero(Tensor* element, const Tensor& padding) {
+#define HANDLE_TYPE(T)                                     \
+  if (element->dtype() == DataTypeToEnum<T>::value) {      \
+    element->flat<T>().setConstant(padding.scalar<T>()()); \
+    return Status::OK();                                   \
+  }
+  TF_CALL_ALL_TYPES(HANDLE_TYPE);
+#undef HANDLE_TYPE
+  return errors::Unimplemented("SetElementZero Unhandled data type: ",
+                               element->dtype());
+}
+
+}  // namespace
+
+Status ParsePaddingArguments(OpKernelContext* ctx, const DatasetBase* input,
+                             std::vector<PartialTensorShape>* padded_shapes,
+                             std::vector<Tensor>* padding_values) {
+  OpInputList padded_shape_tensors;
+  TF_RETURN_IF_ERROR(ctx->input_list("padded_shapes", &padded_shape_tensors));
+  if (padded_shape_tensors.size() != input->output_shapes().size()) {
+    return errors::InvalidArgument("Number of padded shapes (",
+                                   padded_shape_tensors.size(),
+                                   ") must match the number of components "
+                                   "in the input dataset's elements (",
+                                   input->output_shapes().size(), ")");
+  }
+  padded_shapes->clear();
+  padded_shapes->reserve(padded_shape_tensors.size());
+  for (const Tensor& padded_shape_t : padded_shape_tensors) {
+    if (!TensorShapeUtils::IsVector(padded_shape_t.shape())) {
+      return errors::InvalidArgument("All padded shapes must be vectors");
+    }
+    PartialTensorShape padded_shape;
+    TF_RETURN_IF_ERROR(PartialTensorShape::MakePartialShape(
+        padded_shape_t.vec<int64>().data(), padded_shape_t.NumElements(),
+        &padded_shape));
+    padded_shapes->push_back(std::move(padded_shape));
+  }
+
+  OpInputList padding_values_list;
+  TF_RETURN_IF_ERROR(ctx->input_list("padding_values", &padding_values_list));
+  if (padding_values_list.size() != input->output_shapes().size()) {
+    return errors::InvalidArgument(
+        "Number of padding values (", padding_values_list.size(),
+        ") must match the number of components in the input "
+        "dataset's elements (",
+        input->output_shapes().size(), ")");
+  }
+  padding_values->clear();
+  padding_values->reserve(padding_values_list.size());
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    if (!TensorShapeUtils::IsScalar(padding_value_t.shape())) {
+      return errors::InvalidArgument("All padding values must be scalars");
+    }
+    if (padding_value_t.dtype() != input->output_dtypes()[i]) {
+      return errors::InvalidArgument(
+          "Mismatched type between padding value ", i,
+          " and input dataset's component ", i, ": ",
+          DataTypeString(padding_value_t.dtype()), " vs. ",
+          DataTypeString(input->output_dtypes()[i]));
+    }
+    padding_values->push_back(tensor::DeepCopy(padding_value_t));
+  }
+  return Status::OK();
+}
+
+Status PadAndStackBatch(
+    const std::vector<std::vector<Tensor>>& batch_elements,
+    const std::vector<PartialTensorShape>& padded_shapes,
+    const std::vector<Tensor>& padding_values,
+    std::vector<Tensor>* out_tensors) {
+  // Copy the batch elements into one output tensor per tuple component.
+  // NOTE(mrry): If the input or output sizes are statically
+  // known, we could potentially read the input values in-place
+  // into their respective slice locations. This would require a
+  // different GetNext() overload that supports zero-copy, and might
+  // make sense in an optimization pass.
+  const size_t num_tuple_components = batch_elements[0].size();
+  const int64 num_batch_elements = batch_elements.size();
+  for (size_t component_index = 0; component_index < num_tuple_components;
+       ++component_index) {
+    // 1. Determine the shape of the padded tensor.
+    TensorShape batch_component_shape({num_batch_elements});
+    const PartialTensorShape& padded_shape = padded_shapes[component_index];
+
+    for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+      if (padded_shape.dim_size(dim) == -1) {
+        batch_component_shape.AddDim(0);
+      } else {
+        batch_component_shape.AddDim(padded_shape.dim_size(dim));
+      }
+    }
+
+    for (int64 i = 0; i < num_batch_elements; ++i) {
+      const TensorShape& element_shape =
+          batch_elements[i][component_index].shape();
+      // TODO(mrry): Perform this check in the shape function if
+      // enough static information is available to do so.
+      if (element_shape.dims() != padded_shape.dims()) {
+        return errors::InvalidArgument(
+            "All elements in a batch must have the same rank as the "
+            "padded shape for component",
+            component_index, ": expected rank ", padded_shape.dims(),
+            " but got element with rank ", element_shape.dims());
+      }
+      for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+        if (padded_shape.dim_size(dim) == -1) {
+          // Take the max of all batch elements in this dimension.
+          if (batch_elements[i][component_index].shape().dim_size(dim) >
+              batch_component_shape.dim_size(dim + 1)) {
+            batch_component_shape.set_dim(
+                dim + 1,
+                batch_elements[i][component_index].shape().dim_size(dim));
+          }
+        } else {
+          if (batch_elements[i][component_index].shape().dim_size(dim) >
+              batch_component_shape.dim_size(dim + 1)) {
+            return errors::DataLoss(
+                "Attempted to pad to a smaller size than the input "
+                "element.");
+          }
+        }
+      }
+    }
+
+    // 2. Copy each batch element to the appropriate location in
+    // the output component tensor.
+    Tensor batch_component(cpu_allocator(),
+                           padding_values[component_index].dtype(),
+                           batch_component_shape);
+    TF_RETURN_IF_ERROR(
+        SetElementZero(&batch_component, padding_values[component_index]));
+
+    // Build the output tuple component by copying one slice
+    // from each input element in the batch.
+    for (int64 i = 0; i < num_batch_elements; ++i) {
+      TF_RETURN_IF_ERROR(ValidateElementToLargerSlice(
+          batch_elements[i][component_index], &batch_component));
+
+      TF_RETURN_IF_ERROR(CopyElementToLargerSlice(
+          batch_elements[i][component_index], &batch_component, i));
+    }
+    out_tensors->push_back(std::move(batch_component));
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,49 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_PADDED_BATCH_UTIL_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_PADDED_BATCH_UTIL_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/dataset.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Parses the `padded_shapes` and `padding_values` input lists of a dataset op
+// that pads the elements of `input` into batches, and validates them against
+// the components of `input`.
+Status ParsePaddingArguments(OpKernelContext* ctx, const DatasetBase* input,
+                             std::vector<PartialTensorShape>* padded_shapes,
+                             std::vector<Tensor>* padding_values);
+
+// Appends to `out_tensors` one tensor per component of `batch_elements`,
+// holding that component of every element padded with the corresponding
+// padding value. Each unknown dimension of `padded_shapes` is padded to the
+// largest size of that dimension in the batch.
+//
+// REQUIRES: `batch_elements` is not empty.
+Status PadAndStackBatch(
+    const std::vector<std::vector<Tensor>>& batch_elements,
+    const std::vector<PartialTensorShape>& padded_shapes,
+    const std::vector<Tensor>& padding_values,
+    std::vector<Tensor>* out_tensors);
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_PADDED_BATCH_UTIL_H_
@@ -0,0 +1,387 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/random/random.h"
+
+#include "tensorflow/core/kernels/captured_function.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit ParallelInterleaveDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx),
+        graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+    }
+
+    int64 cycle_length;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument(ctx, "cycle_length", &cycle_length));
+    OP_REQUIRES(ctx, cycle_length > 0,
+                errors::InvalidArgument("cycle_length must be greater than "
+                                        "zero."));
+
+    int64 block_length;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument(ctx, "block_length", &block_length));
+    OP_REQUIRES(ctx, block_length > 0,
+                errors::InvalidArgument("block_length must be greater than "
+                                        "zero."));
+
+    int64 buffer_output_elements;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "buffer_output_elements",
+                                            &buffer_output_elements));
+    OP_REQUIRES(ctx, buffer_output_elements > 0,
+                errors::InvalidArgument("buffer_output_elements must be "
+                                        "greater than zero."));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    // The worker threads call the child iterators outside of any
+    // GetNext() call, so capture the context they need here. See the
+    // corresponding TODO in ParallelMapDatasetOp::Compute().
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    *output = new Dataset(input, std::move(captured_func), cycle_length,
+                          block_length, buffer_output_elements,
+                          std::move(params), output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_func,
+            int64 cycle_length, int64 block_length,
+            int64 buffer_output_elements, IteratorContext::Params ctx_params,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : input_(input),
+          captured_func_(std::move(captured_func)),
+          cycle_length_(cycle_length),
+          block_length_(block_length),
+          buffer_output_elements_(buffer_output_elements),
+          ctx_params_(std::move(ctx_params)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return "ParallelInterleaveDatasetOp::Dataset";
+    }
+
+   private:
+    // The iterator keeps `cycle_length` child iterators open, each of which
+    // is advanced by a worker thread of its own into a bounded buffer.
+    // GetNext() consumes the buffers round-robin, `block_length` elements
+    // at a time, so the output order is the same as if the children were
+    // read sequentially.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()),
+            slots_(dataset->cycle_length_) {}
+
+      ~Iterator() override {
+        // Signal the worker threads, if any, so that they terminate. We
+        // will then join those threads when we delete
+        // `this->worker_threads_`.
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        cond_var_.notify_all();
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureWorkerThreadsStarted(ctx));
+        while (true) {
+          if (cancelled_) {
+            return errors::Cancelled(
+                "ParallelInterleaveDatasetOp::Dataset::Iterator::GetNext");
+          }
+          Slot* slot = &slots_[cycle_index_];
+          if (slot->iterator) {
+            // Wait until the worker for the current slot has produced an
+            // element or reached the end of its child.
+            while (!cancelled_ && slot->buffer.empty() &&
+                   !slot->end_of_child) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) continue;
+
+            if (!slot->buffer.empty()) {
+              Status s = slot->buffer.front().status;
+              if (s.ok()) {
+                *out_tensors = std::move(slot->buffer.front().value);
+              }
+              slot->buffer.pop_front();
+              if (++block_index_ == dataset()->block_length_) {
+                AdvanceToNextSlot();
+              }
+              *end_of_sequence = false;
+              // Wake the worker, in case it has been waiting for space in
+              // its buffer.
+              cond_var_.notify_all();
+              return s;
+            }
+
+            // The child is exhausted: give the slot to the next input
+            // element, if any, and move on.
+            slot->iterator.reset();
+            slot->end_of_child = false;
+            --num_open_;
+            TF_RETURN_IF_ERROR(MaybeOpenChild(ctx, slot));
+            AdvanceToNextSlot();
+          } else if (!end_of_input_) {
+            // Only reached if opening a child for this slot failed earlier.
+            TF_RETURN_IF_ERROR(MaybeOpenChild(ctx, slot));
+          } else if (num_open_ == 0) {
+            *end_of_sequence = true;
+            return Status::OK();
+          } else {
+            AdvanceToNextSlot();
+          }
+        }
+      }
+
+     private:
+      struct BufferElement {
+        Status status;
+        std::vector<Tensor> value;
+      };
+
+      // One position in the cycle. `iterator` is set and reset by the
+      // consumer; while it is set, only the slot's worker thread calls it.
+      struct Slot {
+        std::unique_ptr<IteratorBase> iterator;
+        std::deque<BufferElement> buffer;
+        // Set by the worker once `iterator` has reached its end.
+        bool end_of_child = false;
+      };
+
+      void AdvanceToNextSlot() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        cycle_index_ = (cycle_index_ + 1) % dataset()->cycle_length_;
+        block_index_ = 0;
+      }
+
+      Status EnsureWorkerThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (worker_threads_.empty()) {
+          for (Slot& slot : slots_) {
+            Slot* worker_slot = &slot;
+            worker_threads_.emplace_back(ctx->env()->StartThread(
+                {}, "interleave_worker_thread",
+                [this, worker_slot]() { WorkerThread(worker_slot); }));
+          }
+          // Open the first `cycle_length` children up front so that they
+          // are all read concurrently from the start. If this fails, the
+          // remaining slots are filled when GetNext() reaches them.
+          for (Slot& slot : slots_) {
+            TF_RETURN_IF_ERROR(MaybeOpenChild(ctx, &slot));
+          }
+        }
+        return Status::OK();
+      }
+
+      // Opens a child iterator for the next element of the input in
+      // `*slot`, unless the input is exhausted.
+      Status MaybeOpenChild(IteratorContext* ctx, Slot* slot)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (end_of_input_) return Status::OK();
+        std::vector<Tensor> args;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &args, &end_of_input_));
+        if (end_of_input_) return Status::OK();
+        TF_RETURN_IF_ERROR(MakeChildIterator(ctx, args, &slot->iterator));
+        ++num_open_;
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+      Status MakeChildIterator(IteratorContext* ctx,
+                               const std::vector<Tensor>& args,
+                               std::unique_ptr<IteratorBase>* iterator) {
+        FunctionLibraryRuntime::Options opts;
+        opts.runner = ctx->runner();
+        // Choose a step ID that is guaranteed not to clash with any
+        // Session-generated step ID. DirectSession only generates
+        // non-negative step IDs (contiguous, starting from 0), and
+        // MasterSession generates 56-bit random step IDs whose MSB
+        // is always 0, so a negative random step ID should suffice.
+        opts.step_id = -std::abs(static_cast<int64>(random::New64()));
+        ScopedStepContainer step_container(
+            opts.step_id, [this](const string& name) {
+              dataset()
+                  ->captured_func_->resource_manager()
+                  ->Cleanup(name)
+                  .IgnoreError();
+            });
+        opts.step_container = &step_container;
+        std::vector<Tensor> return_values;
+        TF_RETURN_IF_ERROR(
+            dataset()->captured_func_->Run(opts, args, &return_values));
+
+        if (!(return_values.size() == 1 &&
+              return_values[0].dtype() == DT_RESOURCE &&
+              TensorShapeUtils::IsScalar(return_values[0].shape()))) {
+          return errors::InvalidArgument(
+              "`f` must return a single scalar of dtype DT_RESOURCE.");
+        }
+
+        // Retrieve the dataset that was created in `f`. As in
+        // FlatMapDatasetOp, we look it up in the function's resource
+        // manager directly, because we do not have an OpKernelContext.
+        DatasetBase* returned_dataset;
+        const ResourceHandle& dataset_resource =
+            return_values[0].scalar<ResourceHandle>()();
+        auto type_index = MakeTypeIndex<DatasetBase>();
+        if (type_index.hash_code() != dataset_resource.hash_code()) {
+          return errors::InvalidArgument("`f` must return a Dataset resource.");
+        }
+        TF_RETURN_IF_ERROR(
+            dataset()->captured_func_->resource_manager()->Lookup(
+                dataset_resource.container(), dataset_resource.name(),
+                &returned_dataset));
+        core::ScopedUnref unref_dataset(returned_dataset);
+
+        // Create an iterator for the returned dataset. This transfers
+        // ownership of the dataset to the iterator, so we can delete it
+        // from the resource manager.
+        *iterator = returned_dataset->MakeIterator();
+        return dataset()
+            ->captured_func_->resource_manager()
+            ->Delete<DatasetBase>(dataset_resource.container(),
+                                  dataset_resource.name());
+      }
+
+      void WorkerThread(Slot* slot) {
+        while (true) {
+          IteratorBase* iterator;
+          // 1. Wait until the slot holds an unfinished child and there is
+          // space in its buffer.
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ &&
+                   (!slot->iterator || slot->end_of_child ||
+                    slot->buffer.size() >=
+                        dataset()->buffer_output_elements_)) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            iterator = slot->iterator.get();
+          }
+
+          // 2. Read the next element of the child.
+          BufferElement buffer_element;
+          bool end_of_child;
+          buffer_element.status =
+              iterator->GetNext(&iter_ctx_, &buffer_element.value,
+                                &end_of_child);
+
+          // 3. Signal that the element has been produced.
+          {
+            mutex_lock l(mu_);
+            if (buffer_element.status.ok() && end_of_child) {
+              slot->end_of_child = true;
+            } else {
+              slot->buffer.push_back(std::move(buffer_element));
+            }
+            cond_var_.notify_all();
+          }
+        }
+      }
+
+      IteratorContext iter_ctx_;
+      mutex mu_;
+      condition_variable cond_var_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::vector<Slot> slots_ GUARDED_BY(mu_);
+      int64 cycle_index_ GUARDED_BY(mu_) = 0;
+      int64 block_index_ GUARDED_BY(mu_) = 0;
+      int64 num_open_ GUARDED_BY(mu_) = 0;
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      std::vector<std::unique_ptr<Thread>> worker_threads_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+    const int64 cycle_length_;
+    const int64 block_length_;
+    const int64 buffer_output_elements_;
+    const IteratorContext::Params ctx_params_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParallelInterleaveDataset").Device(DEVICE_CPU),
+                        ParallelInterleaveDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class PrefetchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit PrefetchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    // The prefetch thread calls the input iterator outside of any
+    // GetNext() call, so capture the context it needs here. See the
+    // corresponding TODO in ParallelMapDatasetOp::Compute().
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    *output = new Dataset(input, buffer_size, std::move(params));
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size,
+            IteratorContext::Params ctx_params)
+        : input_(input),
+          buffer_size_(buffer_size),
+          ctx_params_(std::move(ctx_params)) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override {
+      return strings::StrCat("PrefetchDatasetOp(", buffer_size_, ")::Dataset");
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the prefetch thread, if any, so that it terminates. We
+        // will then join it when we delete `this->prefetch_thread_`.
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        cond_var_.notify_all();
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsurePrefetchThreadStarted(ctx);
+
+        // Wait until the next element in the buffer has been produced, or
+        // we are shutting down.
+        while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_) {
+          cond_var_.wait(l);
+        }
+
+        if (cancelled_) {
+          return errors::Cancelled(
+              "PrefetchDatasetOp::Dataset::Iterator::GetNext");
+        }
+
+        if (!buffer_.empty()) {
+          // Forward the status from getting the element, and (if we
+          // successfully got an element) its value.
+          Status s = buffer_.front().status;
+          if (s.ok()) {
+            *out_tensors = std::move(buffer_.front().value);
+          }
+          buffer_.pop_front();
+          *end_of_sequence = false;
+
+          // Wake the prefetch thread, in case it has been waiting for
+          // space in the buffer.
+          cond_var_.notify_all();
+          return s;
+        }
+
+        DCHECK(prefetch_thread_finished_);
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     private:
+      // A buffer element holds the status of getting an element from the
+      // input and, if that succeeded, the element itself.
+      struct BufferElement {
+        Status status;
+        std::vector<Tensor> value;
+      };
+
+      void EnsurePrefetchThreadStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!prefetch_thread_) {
+          prefetch_thread_.reset(ctx->env()->StartThread(
+              {}, "prefetch_thread", [this]() { PrefetchThread(); }));
+        }
+      }
+
+      void PrefetchThread() {
+        while (true) {
+          // 1. Wait for a slot in the buffer.
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ &&
+                   buffer_.size() == dataset()->buffer_size_) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+          }
+
+          // 2. Read the next element. Only this thread touches
+          // `input_impl_` once it has started, so no lock is needed.
+          BufferElement buffer_element;
+          bool end_of_sequence;
+          buffer_element.status = input_impl_->GetNext(
+              &iter_ctx_, &buffer_element.value, &end_of_sequence);
+
+          // 3. Signal that the element has been produced.
+          {
+            mutex_lock l(mu_);
+            if (buffer_element.status.ok() && end_of_sequence) {
+              prefetch_thread_finished_ = true;
+              cond_var_.notify_all();
+              return;
+            }
+            buffer_.push_back(std::move(buffer_element));
+            cond_var_.notify_all();
+          }
+        }
+      }
+
+      IteratorContext iter_ctx_;
+      const std::unique_ptr<IteratorBase> input_impl_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+      std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const IteratorContext::Params ctx_params_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("PrefetchDataset").Device(DEVICE_CPU),
+                        PrefetchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
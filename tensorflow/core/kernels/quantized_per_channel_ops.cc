@@ -0,0 +1,450 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements eight-bit convolution and matrix multiplication with
+// per-output-channel filter ranges, and a fused bias, activation and
+// requantization epilogue.
+
+#define EIGEN_USE_THREADS
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/int8_gemm.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Number of output rows (output pixels for the convolution) that are
+// multiplied together within a shard, which bounds the size of the temporary
+// buffers.
+const int64 kRowBlockSize = 64;
+
+enum class Activation { kNone, kRelu, kRelu6 };
+
+Status GetActivation(OpKernelConstruction* context, Activation* activation) {
+  string name;
+  TF_RETURN_IF_ERROR(context->GetAttr("activation", &name));
+  if (name == "NONE") {
+    *activation = Activation::kNone;
+  } else if (name == "RELU") {
+    *activation = Activation::kRelu;
+  } else if (name == "RELU6") {
+    *activation = Activation::kRelu6;
+  } else {
+    return errors::InvalidArgument("Unsupported activation: ", name);
+  }
+  return Status::OK();
+}
+
+// Copies rows [row_start, row_limit) of the left-hand side of the
+// multiplication into 'buffer' (with a leading dimension of 'depth') and
+// returns a pointer to them, or returns a pointer to the rows directly when
+// they don't need to be rearranged.
+typedef std::function<const uint8*(int64 row_start, int64 row_limit,
+                                   uint8* buffer)>
+    LhsRowsFn;
+
+// Converts the int32 results of multiplying uint8 values (real value
+// min_input + q * input_scale) by symmetric int8 values (real value
+// q * filter_scale[j]) back to real values, and adds the bias:
+//   sum_l real(a[i, l]) * real(b[l, j]) =
+//     input_scale * filter_scale[j] * c[i, j] +
+//     min_input * filter_scale[j] * sum_l b[l, j]
+class PerChannelEpilogue {
+ public:
+  PerChannelEpilogue(float min_input, float max_input, const Tensor& min_filter,
+                     const Tensor& max_filter, const Tensor& bias,
+                     const int32* column_sums, Activation activation)
+      : activation_(activation) {
+    const int64 n = bias.NumElements();
+    const float input_scale =
+        (max_input - min_input) / std::numeric_limits<uint8>::max();
+    auto min_filter_flat = min_filter.flat<float>();
+    auto max_filter_flat = max_filter.flat<float>();
+    auto bias_flat = bias.flat<float>();
+    scales_.resize(n);
+    offsets_.resize(n);
+    for (int64 j = 0; j < n; ++j) {
+      // A single filter range applies to all channels.
+      const int64 filter_index = min_filter.NumElements() == 1 ? 0 : j;
+      const float filter_scale =
+          std::max(std::abs(min_filter_flat(filter_index)),
+                   std::abs(max_filter_flat(filter_index))) /
+          std::numeric_limits<int8>::max();
+      scales_[j] = input_scale * filter_scale;
+      offsets_[j] = min_input * filter_scale * column_sums[j] + bias_flat(j);
+    }
+  }
+
+  // Computes the 'n' real values of one row of results.
+  void Apply(const int32* c, float* output) const {
+    const int64 n = scales_.size();
+    for (int64 j = 0; j < n; ++j) {
+      output[j] = c[j] * scales_[j] + offsets_[j];
+    }
+    switch (activation_) {
+      case Activation::kNone:
+        break;
+      case Activation::kRelu:
+        for (int64 j = 0; j < n; ++j) {
+          output[j] = std::max(output[j], 0.0f);
+        }
+        break;
+      case Activation::kRelu6:
+        for (int64 j = 0; j < n; ++j) {
+          output[j] = std::min(std::max(output[j], 0.0f), 6.0f);
+        }
+        break;
+    }
+  }
+
+ private:
+  const Activation activation_;
+  std::vector<float> scales_;
+  std::vector<float> offsets_;
+};
+
+// Converts real values to quint8 in [range_min, range_max], with the same
+// rounding as FloatToQuantized<quint8>() but without recomputing the scale for
+// every value.
+class RowQuantizer {
+ public:
+  RowQuantizer(float range_min, float range_max) {
+    const double range_adjust = 256.0 / 255.0;
+    range_scale_ = 256.0 / ((range_max - range_min) * range_adjust);
+    range_offset_ = std::round(range_min * range_scale_);
+  }
+
+  void Apply(const float* input, int64 n, quint8* output) const {
+    for (int64 j = 0; j < n; ++j) {
+      const float quantized =
+          std::round(input[j] * range_scale_) - range_offset_;
+      output[j] = static_cast<uint8>(std::min(std::max(quantized, 0.0f),
+                                              255.0f));
+    }
+  }
+
+ private:
+  float range_scale_;
+  float range_offset_;
+};
+
+void ValidatePerChannelInputs(OpKernelContext* context, int64 n) {
+  const Tensor& bias = context->input(2);
+  OP_REQUIRES(context, bias.dims() == 1 && bias.dim_size(0) == n,
+              errors::InvalidArgument("bias must be a vector of size ", n,
+                                      ", but got ",
+                                      bias.shape().DebugString()));
+  for (int i = 3; i < 9; ++i) {
+    if (i == 5 || i == 6) continue;
+    OP_REQUIRES(context, context->input(i).NumElements() == 1,
+                errors::InvalidArgument(
+                    "Input ", i, " must have a single element, but got ",
+                    context->input(i).shape().DebugString()));
+  }
+  const Tensor& min_filter = context->input(5);
+  const Tensor& max_filter = context->input(6);
+  OP_REQUIRES(context, min_filter.NumElements() == max_filter.NumElements() &&
+                           (min_filter.NumElements() == 1 ||
+                            min_filter.NumElements() == n),
+              errors::InvalidArgument(
+                  "min_filter and max_filter must have 1 or ", n,
+                  " elements, but got ", min_filter.shape().DebugString(),
+                  " and ", max_filter.shape().DebugString()));
+  const float min_input = context->input(3).flat<float>()(0);
+  const float max_input = context->input(4).flat<float>()(0);
+  OP_REQUIRES(context, min_input <= max_input,
+              errors::InvalidArgument("min_input must be <= max_input, got ",
+                                      min_input, " and ", max_input));
+}
+
+// Multiplies the 'm' x 'k' left-hand side returned by 'lhs_rows' by the
+// 'k' x 'n' filter in input 1, and writes the quantized results of the
+// epilogue to 'output', along with their range.
+void ComputePerChannel(OpKernelContext* context, int64 m, int64 k, int64 n,
+                       const LhsRowsFn& lhs_rows, Activation activation,
+                       Tensor* output) {
+  const Tensor& filter = context->input(1);
+  const float min_input = context->input(3).flat<float>()(0);
+  const float max_input = context->input(4).flat<float>()(0);
+  const float requested_output_min = context->input(7).flat<float>()(0);
+  const float requested_output_max = context->input(8).flat<float>()(0);
+  OP_REQUIRES(context, requested_output_min <= requested_output_max,
+              errors::InvalidArgument(
+                  "requested_output_min must be <= requested_output_max, got ",
+                  requested_output_min, " and ", requested_output_max));
+  // Every product has a magnitude of at most 255 * 128, and their sum must
+  // not overflow the int32 accumulators.
+  OP_REQUIRES(context,
+              k <= std::numeric_limits<int32>::max() / (255 * 128) &&
+                  n <= std::numeric_limits<int32>::max(),
+              errors::InvalidArgument("Matrix dimensions ", k, " x ", n,
+                                      " are too large"));
+
+  const int8_gemm::PackedMatrixB packed(
+      int8_gemm::GetIsa(),
+      reinterpret_cast<const int8*>(filter.flat<qint8>().data()),
+      static_cast<int>(k), static_cast<int>(n), static_cast<int>(n));
+  const PerChannelEpilogue epilogue(min_input, max_input, context->input(5),
+                                    context->input(6), context->input(2),
+                                    packed.column_sums(), activation);
+
+  // With a requested range, the results are quantized as they are computed.
+  // Otherwise they are kept as floats until their range is known.
+  const bool dynamic_range = requested_output_min == requested_output_max;
+  Tensor float_output;
+  float* float_output_data = nullptr;
+  if (dynamic_range) {
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({m, n}), &float_output));
+    float_output_data = float_output.flat<float>().data();
+  }
+  const RowQuantizer requested_quantizer(requested_output_min,
+                                         requested_output_max);
+  quint8* output_data = output->flat<quint8>().data();
+
+  auto multiply_rows = [&](int64 start, int64 limit) {
+    std::unique_ptr<uint8[]> lhs_buffer(new uint8[kRowBlockSize * k]);
+    std::unique_ptr<int32[]> accumulators(new int32[kRowBlockSize * n]);
+    std::unique_ptr<float[]> real_row(new float[n]);
+    for (int64 block = start; block < limit; block += kRowBlockSize) {
+      const int64 block_limit = std::min(block + kRowBlockSize, limit);
+      const uint8* lhs = lhs_rows(block, block_limit, lhs_buffer.get());
+      int8_gemm::Multiply(lhs, k, 0, block_limit - block, packed,
+                          accumulators.get(), n);
+      for (int64 i = block; i < block_limit; ++i) {
+        const int32* c = accumulators.get() + (i - block) * n;
+        if (dynamic_range) {
+          epilogue.Apply(c, float_output_data + i * n);
+        } else {
+          epilogue.Apply(c, real_row.get());
+          requested_quantizer.Apply(real_row.get(), n, output_data + i * n);
+        }
+      }
+    }
+  };
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, m, k * n,
+        multiply_rows);
+
+  float output_min = requested_output_min;
+  float output_max = requested_output_max;
+  if (dynamic_range) {
+    // Like QuantizeV2, make sure zero is exactly representable, and that the
+    // range is not empty.
+    output_min = 0.0f;
+    output_max = 0.0f;
+    for (int64 i = 0; i < m * n; ++i) {
+      output_min = std::min(output_min, float_output_data[i]);
+      output_max = std::max(output_max, float_output_data[i]);
+    }
+    const float epsilon =
+        std::max(1.0f, std::max(std::abs(output_min), std::abs(output_max))) /
+        100.0f;
+    output_max = std::max(output_max, output_min + epsilon);
+    const RowQuantizer quantizer(output_min, output_max);
+    Shard(worker_threads.num_threads, worker_threads.workers, m, n,
+          [&](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              quantizer.Apply(float_output_data + i * n, n,
+                              output_data + i * n);
+            }
+          });
+  }
+
+  Tensor* output_min_tensor = nullptr;
+  OP_REQUIRES_OK(context, context->allocate_output(1, {}, &output_min_tensor));
+  output_min_tensor->flat<float>()(0) = output_min;
+  Tensor* output_max_tensor = nullptr;
+  OP_REQUIRES_OK(context, context->allocate_output(2, {}, &output_max_tensor));
+  output_max_tensor->flat<float>()(0) = output_max;
+}
+
+}  // namespace
+
+class QuantizedConv2DPerChannelOp : public OpKernel {
+ public:
+  explicit QuantizedConv2DPerChannelOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(
+        context, (strides_[0] == 1 && strides_[3] == 1),
+        errors::InvalidArgument("Current implementation does not yet support "
+                                "strides in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    OP_REQUIRES_OK(context, GetActivation(context, &activation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // Input tensor is of the following dimensions:
+    // [ batch, in_rows, in_cols, in_depth ]
+    const Tensor& input = context->input(0);
+
+    // Input filter is of the following dimensions:
+    // [ filter_rows, filter_cols, in_depth, out_depth]
+    const Tensor& filter = context->input(1);
+
+    OP_REQUIRES(context, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 input_rows = input.dim_size(1);
+    const int64 input_cols = input.dim_size(2);
+    const int64 in_depth = input.dim_size(3);
+    const int64 filter_rows = filter.dim_size(0);
+    const int64 filter_cols = filter.dim_size(1);
+    const int64 out_depth = filter.dim_size(3);
+    OP_REQUIRES(context, in_depth == filter.dim_size(2),
+                errors::InvalidArgument(
+                    "input and filter must have the same depth: ", in_depth,
+                    " vs ", filter.dim_size(2)));
+    ValidatePerChannelInputs(context, out_depth);
+    if (!context->status().ok()) return;
+
+    const int64 stride_rows = strides_[1];
+    const int64 stride_cols = strides_[2];
+    int64 out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_rows, filter_rows, stride_rows,
+                                         padding_, &out_rows, &pad_rows));
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_cols, filter_cols, stride_cols,
+                                         padding_, &out_cols, &pad_cols));
+    TensorShape out_shape({batch, out_rows, out_cols, out_depth});
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+
+    const float min_input = context->input(3).flat<float>()(0);
+    const float max_input = context->input(4).flat<float>()(0);
+    // Padding must have the real value zero, like in the float convolution.
+    const uint8 zero_point =
+        FloatToQuantized<quint8>(0.0f, min_input, max_input).value;
+
+    const uint8* input_data =
+        reinterpret_cast<const uint8*>(input.flat<quint8>().data());
+    const int64 patch_size = filter_rows * filter_cols * in_depth;
+    const bool is_pointwise = filter_rows == 1 && filter_cols == 1 &&
+                              stride_rows == 1 && stride_cols == 1;
+    // Gathers the input patch of each output pixel in a row, in the
+    // [filter_rows, filter_cols, in_depth] order of the filter.
+    auto lhs_rows = [&](int64 row_start, int64 row_limit,
+                        uint8* buffer) -> const uint8* {
+      if (is_pointwise) return input_data + row_start * in_depth;
+      for (int64 row = row_start; row < row_limit; ++row) {
+        const int64 out_x = row % out_cols;
+        const int64 out_y = (row / out_cols) % out_rows;
+        const int64 b = row / (out_cols * out_rows);
+        uint8* patch = buffer + (row - row_start) * patch_size;
+        for (int64 fy = 0; fy < filter_rows; ++fy) {
+          const int64 in_y = out_y * stride_rows - pad_rows + fy;
+          for (int64 fx = 0; fx < filter_cols; ++fx) {
+            const int64 in_x = out_x * stride_cols - pad_cols + fx;
+            uint8* tap = patch + (fy * filter_cols + fx) * in_depth;
+            if (in_y < 0 || in_y >= input_rows || in_x < 0 ||
+                in_x >= input_cols) {
+              memset(tap, zero_point, in_depth);
+            } else {
+              memcpy(tap,
+                     input_data +
+                         ((b * input_rows + in_y) * input_cols + in_x) *
+                             in_depth,
+                     in_depth);
+            }
+          }
+        }
+      }
+      return buffer;
+    };
+    ComputePerChannel(context, batch * out_rows * out_cols, patch_size,
+                      out_depth, lhs_rows, activation_, output);
+  }
+
+ private:
+  std::vector<int32> strides_;
+  Padding padding_;
+  Activation activation_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedConv2DPerChannel").Device(DEVICE_CPU),
+                        QuantizedConv2DPerChannelOp);
+
+class QuantizedMatMulPerChannelOp : public OpKernel {
+ public:
+  explicit QuantizedMatMulPerChannelOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetActivation(context, &activation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("a must be a matrix: ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("b must be a matrix: ",
+                                        b.shape().DebugString()));
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = b.dim_size(1);
+    OP_REQUIRES(context, k == b.dim_size(0),
+                errors::InvalidArgument("Matrix size-incompatible: a: ",
+                                        a.shape().DebugString(), ", b: ",
+                                        b.shape().DebugString()));
+    ValidatePerChannelInputs(context, n);
+    if (!context->status().ok()) return;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({m, n}), &output));
+
+    const uint8* a_data =
+        reinterpret_cast<const uint8*>(a.flat<quint8>().data());
+    auto lhs_rows = [a_data, k](int64 row_start, int64 row_limit,
+                                uint8* buffer) -> const uint8* {
+      return a_data + row_start * k;
+    };
+    ComputePerChannel(context, m, k, n, lhs_rows, activation_, output);
+  }
+
+ private:
+  Activation activation_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedMatMulPerChannel").Device(DEVICE_CPU),
+                        QuantizedMatMulPerChannelOp);
+
+}  // namespace tensorflow
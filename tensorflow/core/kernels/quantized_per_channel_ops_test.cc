@@ -0,0 +1,361 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedPerChannelOpsTest : public OpsTestBase {
+ protected:
+  void MakeMatMulOp(const string& activation) {
+    inputs_.clear();
+    TF_ASSERT_OK(
+        NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMulPerChannel")
+            .Input(FakeInput(DT_QUINT8))
+            .Input(FakeInput(DT_QINT8))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("activation", activation)
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void MakeConvOp(int stride, const string& padding,
+                  const string& activation) {
+    inputs_.clear();
+    TF_ASSERT_OK(
+        NodeDefBuilder("quantized_conv_op", "QuantizedConv2DPerChannel")
+            .Input(FakeInput(DT_QUINT8))
+            .Input(FakeInput(DT_QINT8))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("strides", {1, stride, stride, 1})
+            .Attr("padding", padding)
+            .Attr("activation", activation)
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Checks that the quantized output is within one quantization step of
+  // 'expected'.
+  void ExpectOutputNear(const std::vector<float>& expected) {
+    const Tensor& output = *GetOutput(0);
+    const float output_min = GetOutput(1)->flat<float>()(0);
+    const float output_max = GetOutput(2)->flat<float>()(0);
+    ASSERT_EQ(expected.size(), output.NumElements());
+    const float tolerance = (output_max - output_min) / 255.0f * 1.01f;
+    for (int i = 0; i < expected.size(); ++i) {
+      const float value = QuantizedToFloat<quint8>(output.flat<quint8>()(i),
+                                                   output_min, output_max);
+      EXPECT_NEAR(expected[i], value, tolerance) << i;
+    }
+  }
+};
+
+namespace {
+
+float Activate(float value, const string& activation) {
+  if (activation == "RELU") return std::max(value, 0.0f);
+  if (activation == "RELU6") return std::min(std::max(value, 0.0f), 6.0f);
+  return value;
+}
+
+std::vector<uint8> MakeInputValues(int size) {
+  std::vector<uint8> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = (i * 37 + 11) % 256;
+  }
+  return values;
+}
+
+std::vector<int8> MakeFilterValues(int size) {
+  std::vector<int8> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = (i * 53 + 7) % 255 - 127;
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST_F(QuantizedPerChannelOpsTest, MatMulSmall) {
+  MakeMatMulOp("NONE");
+  // A matrix is:
+  // |  1 |  2 |  3 |
+  // |  4 |  5 |  6 |
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  // B matrix has real values:
+  // |  1 | 0.5 |
+  // |  3 |   1 |
+  // |  5 | 1.5 |
+  AddInputFromArray<qint8>(TensorShape({3, 2}), {1, 1, 3, 2, 5, 3});
+  AddInputFromArray<float>(TensorShape({2}), {1.0f, -2.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {255.0f});
+  AddInputFromArray<float>(TensorShape({2}), {-127.0f, -63.5f});
+  AddInputFromArray<float>(TensorShape({2}), {127.0f, 10.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {255.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Here are the results we expect, from hand calculations:
+  // (1 * 1) + (2 * 3) + (3 * 5) + 1 = 23
+  // (1 * 0.5) + (2 * 1) + (3 * 1.5) - 2 = 5
+  // (4 * 1) + (5 * 3) + (6 * 5) + 1 = 50
+  // (4 * 0.5) + (5 * 1) + (6 * 1.5) - 2 = 14
+  Tensor expected(allocator(), DT_QUINT8, TensorShape({2, 2}));
+  test::FillValues<quint8>(&expected, {23, 5, 50, 14});
+  test::ExpectTensorEqual<quint8>(expected, *GetOutput(0));
+  EXPECT_EQ(0.0f, GetOutput(1)->flat<float>()(0));
+  EXPECT_EQ(255.0f, GetOutput(2)->flat<float>()(0));
+}
+
+TEST_F(QuantizedPerChannelOpsTest, MatMulDynamicRange) {
+  for (const string activation : {"NONE", "RELU", "RELU6"}) {
+    MakeMatMulOp(activation);
+    const int m = 37;
+    const int k = 75;
+    const int n = 19;
+    const float min_a = -1.0f;
+    const float max_a = 3.0f;
+    const std::vector<uint8> a = MakeInputValues(m * k);
+    const std::vector<int8> b = MakeFilterValues(k * n);
+    std::vector<float> bias(n), min_b(n), max_b(n);
+    for (int j = 0; j < n; ++j) {
+      bias[j] = j * 0.25f - 2.0f;
+      min_b[j] = -(j + 1) / 40.0f;
+      max_b[j] = (j + 1) / 80.0f;
+    }
+    AddInputFromArray<quint8>(TensorShape({m, k}),
+                              std::vector<quint8>(a.begin(), a.end()));
+    AddInputFromArray<qint8>(TensorShape({k, n}),
+                             std::vector<qint8>(b.begin(), b.end()));
+    AddInputFromArray<float>(TensorShape({n}), bias);
+    AddInputFromArray<float>(TensorShape({}), {min_a});
+    AddInputFromArray<float>(TensorShape({}), {max_a});
+    AddInputFromArray<float>(TensorShape({n}), min_b);
+    AddInputFromArray<float>(TensorShape({n}), max_b);
+    AddInputFromArray<float>(TensorShape({}), {0.0f});
+    AddInputFromArray<float>(TensorShape({}), {0.0f});
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<float> expected(m * n);
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        const float b_scale = -min_b[j] / 127.0f;
+        float sum = bias[j];
+        for (int l = 0; l < k; ++l) {
+          sum += QuantizedToFloat<quint8>(a[i * k + l], min_a, max_a) *
+                 b[l * n + j] * b_scale;
+        }
+        expected[i * n + j] = Activate(sum, activation);
+      }
+    }
+    ExpectOutputNear(expected);
+    EXPECT_LE(GetOutput(1)->flat<float>()(0), 0.0f);
+    EXPECT_GE(GetOutput(2)->flat<float>()(0), 0.0f);
+    if (activation == "RELU6") {
+      EXPECT_LE(GetOutput(2)->flat<float>()(0), 6.0f);
+    }
+  }
+}
+
+TEST_F(QuantizedPerChannelOpsTest, MatMulBadBias) {
+  MakeMatMulOp("NONE");
+  AddInputFromArray<quint8>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<qint8>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({3}), {0.0f, 0.0f, 0.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {-1.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString()).contains("bias must be a vector"))
+      << s;
+}
+
+TEST_F(QuantizedPerChannelOpsTest, Conv2D) {
+  const int batch = 2;
+  const int input_rows = 7;
+  const int input_cols = 6;
+  const int in_depth = 3;
+  const int filter_size = 3;
+  const int out_depth = 5;
+  const float min_input = -2.0f;
+  const float max_input = 3.0f;
+  const float output_range = 30.0f;
+  for (const int stride : {1, 2}) {
+    for (const string padding : {"SAME", "VALID"}) {
+      for (const string activation : {"NONE", "RELU6"}) {
+        MakeConvOp(stride, padding, activation);
+        const std::vector<uint8> input =
+            MakeInputValues(batch * input_rows * input_cols * in_depth);
+        const std::vector<int8> filter = MakeFilterValues(
+            filter_size * filter_size * in_depth * out_depth);
+        std::vector<float> bias(out_depth), min_filter(out_depth),
+            max_filter(out_depth);
+        for (int j = 0; j < out_depth; ++j) {
+          bias[j] = j - 2.0f;
+          min_filter[j] = -(j + 1) / 10.0f;
+          max_filter[j] = (j + 1) / 5.0f;
+        }
+        AddInputFromArray<quint8>(
+            TensorShape({batch, input_rows, input_cols, in_depth}),
+            std::vector<quint8>(input.begin(), input.end()));
+        AddInputFromArray<qint8>(
+            TensorShape({filter_size, filter_size, in_depth, out_depth}),
+            std::vector<qint8>(filter.begin(), filter.end()));
+        AddInputFromArray<float>(TensorShape({out_depth}), bias);
+        AddInputFromArray<float>(TensorShape({}), {min_input});
+        AddInputFromArray<float>(TensorShape({}), {max_input});
+        AddInputFromArray<float>(TensorShape({out_depth}), min_filter);
+        AddInputFromArray<float>(TensorShape({out_depth}), max_filter);
+        AddInputFromArray<float>(TensorShape({}), {-output_range});
+        AddInputFromArray<float>(TensorShape({}), {output_range});
+        TF_ASSERT_OK(RunOpKernel());
+
+        int64 out_rows, out_cols, pad_rows, pad_cols;
+        const Padding padding_type = padding == "SAME" ? SAME : VALID;
+        TF_ASSERT_OK(GetWindowedOutputSize(input_rows, filter_size, stride,
+                                           padding_type, &out_rows,
+                                           &pad_rows));
+        TF_ASSERT_OK(GetWindowedOutputSize(input_cols, filter_size, stride,
+                                           padding_type, &out_cols,
+                                           &pad_cols));
+        ASSERT_EQ(TensorShape({batch, out_rows, out_cols, out_depth}),
+                  GetOutput(0)->shape());
+        std::vector<float> expected;
+        for (int b = 0; b < batch; ++b) {
+          for (int y = 0; y < out_rows; ++y) {
+            for (int x = 0; x < out_cols; ++x) {
+              for (int j = 0; j < out_depth; ++j) {
+                const float filter_scale = max_filter[j] / 127.0f;
+                float sum = bias[j];
+                for (int fy = 0; fy < filter_size; ++fy) {
+                  for (int fx = 0; fx < filter_size; ++fx) {
+                    const int in_y = y * stride - pad_rows + fy;
+                    const int in_x = x * stride - pad_cols + fx;
+                    if (in_y < 0 || in_y >= input_rows || in_x < 0 ||
+                        in_x >= input_cols) {
+                      continue;
+                    }
+                    for (int c = 0; c < in_depth; ++c) {
+                      const uint8 input_value =
+                          input[((b * input_rows + in_y) * input_cols + in_x) *
+                                    in_depth +
+                                c];
+                      const int8 filter_value =
+                          filter[((fy * filter_size + fx) * in_depth + c) *
+                                     out_depth +
+                                 j];
+                      sum += QuantizedToFloat<quint8>(input_value, min_input,
+                                                      max_input) *
+                             filter_value * filter_scale;
+                    }
+                  }
+                }
+                // Values outside of the requested range are clamped.
+                expected.push_back(
+                    std::min(std::max(Activate(sum, activation), -output_range),
+                             output_range));
+              }
+            }
+          }
+        }
+        // Padding uses the closest quantized value to zero, which adds
+        // some error for every padded value in the SAME convolutions.
+        const Tensor& output = *GetOutput(0);
+        const float step = 2 * output_range / 255.0f;
+        const float padding_error =
+            (max_input - min_input) / 255.0f / 2 * filter_size * filter_size *
+            in_depth * max_filter[out_depth - 1];
+        for (int i = 0; i < expected.size(); ++i) {
+          const float value = QuantizedToFloat<quint8>(
+              output.flat<quint8>()(i), -output_range, output_range);
+          EXPECT_NEAR(expected[i], value, step + padding_error)
+              << stride << " " << padding << " " << activation << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(QuantizedPerChannelOpsTest, Conv2DPointwise) {
+  MakeConvOp(1, "SAME", "RELU");
+  const int pixels = 70;
+  const int in_depth = 9;
+  const int out_depth = 33;
+  const std::vector<uint8> input = MakeInputValues(pixels * in_depth);
+  const std::vector<int8> filter = MakeFilterValues(in_depth * out_depth);
+  AddInputFromArray<quint8>(TensorShape({1, 7, 10, in_depth}),
+                            std::vector<quint8>(input.begin(), input.end()));
+  AddInputFromArray<qint8>(TensorShape({1, 1, in_depth, out_depth}),
+                           std::vector<qint8>(filter.begin(), filter.end()));
+  AddInputFromArray<float>(TensorShape({out_depth}),
+                           std::vector<float>(out_depth, 0.5f));
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  // A single range for all channels.
+  AddInputFromArray<float>(TensorShape({}), {-0.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected;
+  for (int p = 0; p < pixels; ++p) {
+    for (int j = 0; j < out_depth; ++j) {
+      float sum = 0.5f;
+      for (int c = 0; c < in_depth; ++c) {
+        sum += input[p * in_depth + c] / 255.0f *
+               filter[c * out_depth + j] * 0.5f / 127.0f;
+      }
+      expected.push_back(Activate(sum, "RELU"));
+    }
+  }
+  ExpectOutputNear(expected);
+}
+
+}  // namespace tensorflow
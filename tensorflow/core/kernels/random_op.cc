@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/random/philox_random_simd.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
@@ -68,6 +69,66 @@ struct FillPhiloxRandom {
   }
 };
 
+// Fills "group_count" full groups of "dist" samples starting at "data".
+// Specialized below for the common distributions, which generate the
+// underlying Philox samples several counters at a time with
+// PhiloxRandomSimd; the results are identical to the generic loop.
+template <class Distribution>
+struct FillPhiloxRandomGroups {
+  typedef typename Distribution::ResultElementType T;
+  static void Run(random::PhiloxRandom* gen, T* data, int64 group_count,
+                  Distribution dist) {
+    const int kGroupSize = Distribution::kResultElementCount;
+    for (int64 index = 0; index < group_count; ++index) {
+      auto samples = dist(gen);
+      std::copy(&samples[0], &samples[0] + kGroupSize,
+                data + index * kGroupSize);
+    }
+  }
+};
+
+template <>
+struct FillPhiloxRandomGroups<
+    random::UniformDistribution<random::PhiloxRandom, float>> {
+  static void Run(random::PhiloxRandom* gen, float* data, int64 group_count,
+                  random::UniformDistribution<random::PhiloxRandom, float>) {
+    random::PhiloxRandomSimd::FillUniformFloat(gen, data, group_count);
+  }
+};
+
+// Box-Muller needs log and sincos, whose vectorized versions round
+// differently from libm, so only the Philox samples are vectorized here.
+template <typename T>
+struct FillPhiloxRandomNormalGroups {
+  static void Run(random::PhiloxRandom* gen, T* data, int64 group_count,
+                  random::NormalDistribution<random::PhiloxRandom, T>) {
+    const int kGroupSize = PhiloxRandom::kResultElementCount;
+    const int64 kBlockGroups = 64;
+    uint32 bits[kBlockGroups * kGroupSize];
+    for (int64 start = 0; start < group_count; start += kBlockGroups) {
+      const int64 groups = std::min(kBlockGroups, group_count - start);
+      random::PhiloxRandomSimd::Fill(gen, bits, groups);
+      T* output = data + start * kGroupSize;
+      for (int64 i = 0; i < groups * kGroupSize; i += 2) {
+        float f[2];
+        random::BoxMullerFloat(bits[i], bits[i + 1], &f[0], &f[1]);
+        output[i] = T(f[0]);
+        output[i + 1] = T(f[1]);
+      }
+    }
+  }
+};
+
+template <>
+struct FillPhiloxRandomGroups<
+    random::NormalDistribution<random::PhiloxRandom, float>>
+    : FillPhiloxRandomNormalGroups<float> {};
+
+template <>
+struct FillPhiloxRandomGroups<
+    random::NormalDistribution<random::PhiloxRandom, Eigen::half>>
+    : FillPhiloxRandomNormalGroups<Eigen::half> {};
+
 // A class to fill a specified range of random groups
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
@@ -86,10 +147,10 @@ struct FillPhiloxRandomTask<Distribution, false> {
 
     // First fill all the full-size groups
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
-    for (int64 index = start_group; index < limit_group_full; ++index) {
-      auto samples = dist(&gen);
-      std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
-      offset += kGroupSize;
+    if (limit_group_full > start_group) {
+      FillPhiloxRandomGroups<Distribution>::Run(
+          &gen, data + offset, limit_group_full - start_group, dist);
+      offset += (limit_group_full - start_group) * kGroupSize;
     }
 
     // If there are any remaining elements that need to be filled, process them
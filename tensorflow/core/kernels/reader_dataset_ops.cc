@@ -331,7 +331,10 @@ class TFRecordDatasetOp : public OpKernel {
                      const string& compression_type)
         : filenames_(std::move(filenames)),
           options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {}
+              compression_type)) {
+      options_.buffer_size = io::RecordReaderOptions::kDefaultBufferSize;
+      options_.prefetch = true;
+    }
 
     std::unique_ptr<IteratorBase> MakeIterator() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
@@ -362,15 +365,22 @@ class TFRecordDatasetOp : public OpKernel {
         do {
           // We are currently processing a file, so try to read the next record.
           if (reader_) {
-            Tensor result_tensor(cpu_allocator(), DT_STRING, {});
-            Status s = reader_->ReadRecord(&offset_,
-                                           &result_tensor.scalar<string>()());
-            if (s.ok()) {
+            if (next_record_ == batch_.size()) {
+              batch_.Clear();
+              next_record_ = 0;
+              Status s = reader_->ReadRecords(&offset_, kRecordsPerBatch,
+                                              &batch_);
+              if (!s.ok() && !errors::IsOutOfRange(s)) {
+                return s;
+              }
+            }
+            if (next_record_ < batch_.size()) {
+              Tensor result_tensor(cpu_allocator(), DT_STRING, {});
+              result_tensor.scalar<string>()() =
+                  batch_[next_record_++].ToString();
               out_tensors->emplace_back(std::move(result_tensor));
               *end_of_sequence = false;
               return Status::OK();
-            } else if (!errors::IsOutOfRange(s)) {
-              return s;
             }
 
             // We have reached the end of the current file, so maybe
@@ -396,10 +406,78 @@ class TFRecordDatasetOp : public OpKernel {
         } while (true);
       }
 
+      // The position of this iterator is the index of the current file
+      // and the offset of the next record to produce from it.
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/current_file_index"),
+                                current_file_index_));
+        if (reader_) {
+          const uint64 offset =
+              next_record_ < batch_.size() ? batch_.offset(next_record_)
+                                           : offset_;
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(prefix, "/offset"), static_cast<int64>(offset)));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/current_file_index"),
+            &current_file_index));
+        if (current_file_index < 0 ||
+            static_cast<size_t>(current_file_index) >
+                dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "Saved file index ", current_file_index, " is out of range for ",
+              dataset()->filenames_.size(), " files.");
+        }
+        batch_.Clear();
+        next_record_ = 0;
+        reader_.reset();
+        file_.reset();
+        current_file_index_ = current_file_index;
+        offset_ = 0;
+        const string offset_key = strings::StrCat(prefix, "/offset");
+        if (reader->Contains(offset_key)) {
+          int64 offset;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(offset_key, &offset));
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            return errors::InvalidArgument(
+                "Saved offset without a current file.");
+          }
+          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
+              dataset()->filenames_[current_file_index_], &file_));
+          reader_.reset(new io::RecordReader(file_.get(), dataset()->options_));
+          if (dataset()->options_.compression_type ==
+              io::RecordReaderOptions::NONE) {
+            offset_ = offset;
+          } else {
+            // Compressed files can only be read sequentially, so skip
+            // over the records that were already produced.
+            string record;
+            while (offset_ < offset) {
+              TF_RETURN_IF_ERROR(reader_->ReadRecord(&offset_, &record));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
      private:
+      // The number of records read from the file at a time.
+      static const int64 kRecordsPerBatch = 64;
+
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
       uint64 offset_ GUARDED_BY(mu_) = 0;
+      io::RecordBatch batch_ GUARDED_BY(mu_);
+      size_t next_record_ GUARDED_BY(mu_) = 0;
 
       // `reader_` will borrow the object that `file_` points to, so
       // we must destroy `reader_` before `file_`.
@@ -51,10 +51,8 @@ class RecordInputOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override {
     Tensor out(DT_STRING, {batch_size_});
-    auto t_out = out.flat<string>();
-    for (int i = 0; i < batch_size_; ++i) {
-      OP_REQUIRES_OK(ctx, yielder_->YieldOne(&t_out(i)));
-    }
+    OP_REQUIRES_OK(ctx,
+                   yielder_->YieldBatch(batch_size_, out.flat<string>().data()));
     ctx->set_output(0, out);
   }
 
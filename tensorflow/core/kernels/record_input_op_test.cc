@@ -0,0 +1,119 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Writes 'num_files' tfrecord files of 'records_per_file' records each under
+// 'dir', and returns their file pattern. Record j of file i is "i:j" padded
+// to 'record_size' bytes.
+string WriteRecordFiles(const string& dir, int num_files, int records_per_file,
+                        int record_size) {
+  Env* env = Env::Default();
+  TF_CHECK_OK(env->RecursivelyCreateDir(dir));
+  for (int i = 0; i < num_files; ++i) {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(
+        io::JoinPath(dir, strings::StrCat("records-", i)), &file));
+    io::RecordWriter writer(file.get());
+    for (int j = 0; j < records_per_file; ++j) {
+      string record = strings::StrCat(i, ":", j);
+      record.resize(std::max<size_t>(record.size(), record_size), ' ');
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+  return io::JoinPath(dir, "records-*");
+}
+
+class RecordInputOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& file_pattern, int64 buffer_size,
+              int64 parallelism, int64 batch_size) {
+    TF_EXPECT_OK(NodeDefBuilder("record_input_op", "RecordInput")
+                     .Attr("file_pattern", file_pattern)
+                     .Attr("file_buffer_size", buffer_size)
+                     .Attr("file_parallelism", parallelism)
+                     .Attr("batch_size", batch_size)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(RecordInputOpTest, YieldsEveryRecordOncePerEpoch) {
+  const int kNumFiles = 4;
+  const int kRecordsPerFile = 10;
+  const string pattern =
+      WriteRecordFiles(io::JoinPath(testing::TmpDir(), "record_input_epoch"),
+                       kNumFiles, kRecordsPerFile, 0);
+  MakeOp(pattern, 10, 2, kNumFiles * kRecordsPerFile);
+
+  std::vector<string> expected;
+  for (int i = 0; i < kNumFiles; ++i) {
+    for (int j = 0; j < kRecordsPerFile; ++j) {
+      expected.push_back(strings::StrCat(i, ":", j));
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    TF_ASSERT_OK(RunOpKernel());
+    const auto records = GetOutput(0)->flat<string>();
+    std::vector<string> actual(records.data(),
+                               records.data() + records.size());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+static void BM_RecordInput(int iters, int parallelism) {
+  testing::StopTiming();
+  const int kBatchSize = 256;
+  static const string* pattern = new string(WriteRecordFiles(
+      io::JoinPath(testing::TmpDir(), "record_input_bench"), 32, 4096, 1024));
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("record_input"), "RecordInput")
+                  .Attr("file_pattern", *pattern)
+                  .Attr("file_buffer_size", 10000)
+                  .Attr("file_parallelism", parallelism)
+                  .Attr("batch_size", kBatchSize)
+                  .Finalize(g, &node));
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_RecordInput)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
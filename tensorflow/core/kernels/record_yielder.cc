@@ -45,14 +45,21 @@ RecordYielder::~RecordYielder() {
 }
 
 Status RecordYielder::YieldOne(string* value) {
+  return YieldBatch(1, value);
+}
+
+Status RecordYielder::YieldBatch(int64 num_values, string* values) {
   mutex_lock l(mu_);
-  while (!BufEnough()) {
-    buf_enough_.wait(l);
-  }
-  if (status_.ok()) {
+  for (int64 i = 0; i < num_values; ++i) {
+    while (!BufEnough()) {
+      buf_enough_.wait(l);
+    }
+    if (!status_.ok()) {
+      break;
+    }
     bool notify_no_longer_full = !BufNotFull();
     CHECK(!stop_ && !buf_.empty());
-    *value = std::move(buf_.back());
+    values[i] = std::move(buf_.back());
     buf_.pop_back();
     ++num_records_yielded_in_epoch_;
     // Assumption is that an epoch always has something in the buffer
@@ -182,7 +189,9 @@ bool RecordYielder::Add(std::vector<string>* values) {
 
 void RecordYielder::ShardLoop(Shard* shard) {
   std::vector<string> values;
-  const int64 kRecords = 16;
+  // Records are read and added to buf_ in batches, so that the shards take
+  // mu_ once per batch.
+  const int64 kRecords = 64;
   for (const string& filename : shard->filenames) {
     std::unique_ptr<RandomAccessFile> file;
     if (ShouldFinish(Status::OK())) break;
@@ -191,13 +200,19 @@ void RecordYielder::ShardLoop(Shard* shard) {
       shard->status = errors::InvalidArgument("Can't open ", filename);
       break;
     }
-    io::RecordReader rdr(file.get());
+    io::RecordReaderOptions options;
+    options.buffer_size = io::RecordReaderOptions::kDefaultBufferSize;
+    options.prefetch = true;
+    io::RecordReader rdr(file.get(), options);
     uint64 offset = 0;
-    string record;
+    io::RecordBatch batch;
     while (true) {
-      Status s = rdr.ReadRecord(&offset, &record);
+      batch.Clear();
+      Status s = rdr.ReadRecords(&offset, kRecords, &batch);
       if (s.ok()) {
-        values.emplace_back(std::move(record));
+        for (const StringPiece& record : batch.records()) {
+          values.emplace_back(record.ToString());
+        }
         if (values.size() >= kRecords && Add(&values)) {
           shard->status = errors::Aborted("stopped");
           break;
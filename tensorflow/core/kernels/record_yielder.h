@@ -38,7 +38,7 @@ namespace tensorflow {
 //   2) each record is yielded only once within every epoch;
 //   3) the order in which records are yielded are highly randomized.
 //   4) the peak memory usage is roughly avg record size *
-//      (opts.bufsize + opts.parellelism * 16).
+//      (opts.bufsize + opts.parellelism * 64).
 //
 // Usage example:
 //   RecordYielder::Options opts;
@@ -90,6 +90,11 @@ class RecordYielder {
   // Yields one 'value'.
   Status YieldOne(string* value);
 
+  // Yields 'num_values' values into 'values[0, num_values)'. Cheaper than as
+  // many calls to YieldOne(), since the buffer is locked once per batch
+  // rather than once per value.
+  Status YieldBatch(int64 num_values, string* values);
+
   // Returns the current epoch number.
   int64 current_epoch() const { return epoch_; }
 
@@ -25,7 +25,6 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
-#include "tensorflow/core/lib/strings/str_util.h"
 
 namespace tensorflow {
 
@@ -165,15 +164,27 @@ class ReduceJoinOp : public OpKernel {
          ++output_index) {
       int64 output_full_index = LinearSubIndexToFullIndex(
           output_index, unreduced_indices, input_shape, strides);
+      size_t output_size = 0;
       for (int64 reduction_index = 0; reduction_index < reduction_iter_size;
            ++reduction_index) {
         int64 reduction_full_index = LinearSubIndexToFullIndex(
             reduction_index, reduced_indices, input_shape, strides);
         curr_strings[reduction_index] =
             input_flat(output_full_index + reduction_full_index);
+        output_size += curr_strings[reduction_index].size();
+      }
+      // Joins in place, with a single allocation of the output string.
+      string& output = output_flat(output_index);
+      if (reduction_iter_size > 0) {
+        output_size += (reduction_iter_size - 1) * separator_.size();
+      }
+      output.reserve(output_size);
+      for (int64 reduction_index = 0; reduction_index < reduction_iter_size;
+           ++reduction_index) {
+        if (reduction_index > 0) output.append(separator_);
+        output.append(curr_strings[reduction_index].data(),
+                      curr_strings[reduction_index].size());
       }
-      output_flat(output_index) =
-          str_util::Join(curr_strings, separator_.c_str());
     }
   }
 
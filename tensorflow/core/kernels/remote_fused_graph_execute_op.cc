@@ -15,12 +15,17 @@ limitations under the License.
 
 // See docs in ../ops/remote_fused_graph_ops.cc.
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/remote_fused_graph_execute_info.pb.h"
 #include "tensorflow/core/kernels/i_remote_fused_graph_executor.h"
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -57,6 +62,11 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
 
       // 2. Setup graph in remote processor
       remote_fused_graph_executor_->SetupGraph();
+
+      pipeline_depth_ =
+          std::max(1, remote_fused_graph_executor_->GetPipelineDepth());
+      mutex_lock l(slots_mu_);
+      slot_busy_.assign(pipeline_depth_, false);
     }
   }
 
@@ -80,6 +90,11 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
         << ", gt input count = " << execute_info_.graph_input_node_name_size()
         << ", type count = " << input_types_.size();
 
+    if (pipeline_depth_ > 1) {
+      ComputePipelined(ctx);
+      return;
+    }
+
     // 3. Send first data type inputs into remote processor
     for (int i = 0; i < graph_input_count; ++i) {
       const Tensor& input_tensor = ctx->input(i);
@@ -122,11 +137,93 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
   bool IsExpensive() final { return true; }
 
  private:
+  // Runs a frame through the executor's staging slots. Concurrent Compute
+  // calls stage their inputs on the host while another frame executes on the
+  // remote processor; only execution and output reads are serialized.
+  void ComputePipelined(OpKernelContext* const ctx) {
+    const int slot = AcquireSlot();
+    const uint64 start_cycle = profile_utils::CpuUtils::GetCurrentClockCycle();
+
+    // 3. Stage inputs of this frame on the host
+    for (int i = 0; i < execute_info_.graph_input_node_name_size(); ++i) {
+      remote_fused_graph_executor_->StageInputNode(
+          slot, execute_info_.graph_input_node_name(i), ctx->input(i));
+    }
+    const uint64 staged_cycle = profile_utils::CpuUtils::GetCurrentClockCycle();
+
+    uint64 executing_cycle;
+    uint64 executed_cycle;
+    {
+      mutex_lock l(execute_mu_);
+      executing_cycle = profile_utils::CpuUtils::GetCurrentClockCycle();
+
+      // 4. Transfer staged inputs and execute graph in remote processor
+      remote_fused_graph_executor_->ExecuteStagedGraph(slot);
+      executed_cycle = profile_utils::CpuUtils::GetCurrentClockCycle();
+
+      // 5. Load outputs from remote processor
+      const int output_count = ctx->num_outputs();
+      CHECK(output_count == execute_info_.graph_output_node_name_size() &&
+            output_count == output_types_.size());
+      for (int i = 0; i < output_count; ++i) {
+        Tensor* output = nullptr;
+        remote_fused_graph_executor_->ReadOutputNode(
+            execute_info_.graph_output_node_name(i),
+            [i, &ctx, &output](const TensorShape& shape) -> Tensor* {
+              TF_CHECK_OK(ctx->allocate_output(i, shape, &output));
+              return output;
+            });
+      }
+    }
+    const uint64 end_cycle = profile_utils::CpuUtils::GetCurrentClockCycle();
+    ReleaseSlot(slot);
+
+    VLOG(1) << "Remote fused graph frame on slot " << slot << ": stage "
+            << CyclesToMicros(staged_cycle - start_cycle) << " us, wait "
+            << CyclesToMicros(executing_cycle - staged_cycle)
+            << " us, execute "
+            << CyclesToMicros(executed_cycle - executing_cycle)
+            << " us, read " << CyclesToMicros(end_cycle - executed_cycle)
+            << " us";
+  }
+
+  int AcquireSlot() {
+    mutex_lock l(slots_mu_);
+    while (true) {
+      for (int slot = 0; slot < pipeline_depth_; ++slot) {
+        if (!slot_busy_[slot]) {
+          slot_busy_[slot] = true;
+          return slot;
+        }
+      }
+      slots_cv_.wait(l);
+    }
+  }
+
+  void ReleaseSlot(const int slot) {
+    mutex_lock l(slots_mu_);
+    slot_busy_[slot] = false;
+    slots_cv_.notify_one();
+  }
+
+  static double CyclesToMicros(const uint64 cycles) {
+    return profile_utils::CpuUtils::ConvertClockCycleToTime(cycles).count() *
+           1e6;
+  }
+
   RemoteFusedGraphExecuteInfo execute_info_;
   std::unique_ptr<IRemoteFusedGraphExecutor> remote_fused_graph_executor_;
   DataTypeVector input_types_;
   DataTypeVector output_types_;
 
+  // Number of staging slots of the executor; 1 runs frames synchronously.
+  int pipeline_depth_ = 1;
+  mutex slots_mu_;
+  condition_variable slots_cv_;
+  std::vector<bool> slot_busy_ GUARDED_BY(slots_mu_);  // Per staging slot
+  // Serializes the use of the remote processor across pipelined frames.
+  mutex execute_mu_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RemoteFusedGraphExecuteOp);
 };
 
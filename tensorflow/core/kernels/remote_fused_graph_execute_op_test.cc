@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/remote_fused_graph_execute_op_test_utils.h"
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
@@ -78,6 +79,8 @@ constexpr const char* const REMOTE_FUSED_EXECUTE_OP_NODE_NAME =
     "remote_fused_execute_op";
 constexpr const char* const REMOTE_FUSED_EXECUTOR_NAME =
     "build_test_remote_fused_graph_executor";
+constexpr const char* const PIPELINED_REMOTE_FUSED_EXECUTOR_NAME =
+    "build_test_pipelined_remote_fused_graph_executor";
 
 constexpr float NODE_A_VAL = 2.0f;
 constexpr float NODE_A_VAL2 = 10.0f;
@@ -126,9 +129,9 @@ static Output BuildRemoteFusedGraphExecuteOp(
 }
 
 static RemoteFusedGraphExecuteInfo BuildRemoteFusedGraphExecuteInfo(
-    const GraphDef& original_graph) {
+    const GraphDef& original_graph, const string& executor_name) {
   RemoteFusedGraphExecuteInfo execute_info;
-  execute_info.set_executor_name(REMOTE_FUSED_EXECUTOR_NAME);
+  execute_info.set_executor_name(executor_name);
 
   // In this example, simply copy all nodes. Basically, you don't need to add
   // unused node for inference.
@@ -162,6 +165,11 @@ static RemoteFusedGraphExecuteInfo BuildRemoteFusedGraphExecuteInfo(
 // 1. Create TestRemoteFusedGraphExecutor to execute your fused graph
 class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
  public:
+  // If pipeline_depth is more than 1, inputs are staged per slot by
+  // StageInputNode instead of being filled by FillInputNode.
+  explicit TestRemoteFusedGraphExecutor(int pipeline_depth)
+      : staged_input_tensors_(pipeline_depth) {}
+
   int GetVersion() final { return 1; }
   bool Init(const RemoteFusedGraphExecuteInfo& info) final {
     info_ = &info;
@@ -173,27 +181,7 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
   bool Finalize() final { return true; }
   bool SetupGraph() final { return true; }
   bool ExecuteGraph() final {
-    CHECK(info_ != nullptr);
-    // TODO(satok): Add utilities to implement this function more easily.
-    // CAVEAT: This test only handles add op. You can implement here as you
-    // like.
-    CHECK_EQ(1, info_->graph_input_node_name_size());
-    const string& input_node_name = info_->graph_input_node_name(0);
-    const Tensor& input_tensor = input_tensor_cache_[input_node_name];
-    const float input_val = *input_tensor.scalar<float>().data();
-    // TODO(satok): Read NAME_B from node_a_plus_b
-    const NodeDef& node_b = *node_def_map_.at(NAME_B);
-    const TensorProto* proto = nullptr;
-    TF_CHECK_OK(GetNodeAttr(node_b, "value", &proto));
-    Tensor const_tensor;
-    TF_CHECK_OK(RemoteFusedGraphExecuteUtils::MakeTensorFromProto(
-        *proto, &const_tensor));
-    const float b_val = *const_tensor.scalar<float>().data();
-    Tensor output_a_plus_b(DT_FLOAT, {});
-    output_a_plus_b.flat<float>().data()[0] = input_val + b_val;
-    output_tensor_buf_.emplace(info_->graph_output_node_name(0),
-                               output_a_plus_b);
-    return true;
+    return ExecuteGraphWithInputs(input_tensor_cache_);
   }
 
   bool TeardownGraph() final { return true; }
@@ -214,9 +202,46 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
     return true;
   }
 
+  int GetPipelineDepth() final { return staged_input_tensors_.size(); }
+
+  bool StageInputNode(int slot, const string& node_name,
+                      const Tensor& tensor) final {
+    staged_input_tensors_.at(slot)[node_name] = tensor;
+    return true;
+  }
+
+  bool ExecuteStagedGraph(int slot) final {
+    return ExecuteGraphWithInputs(staged_input_tensors_.at(slot));
+  }
+
  private:
+  bool ExecuteGraphWithInputs(
+      const std::unordered_map<string, Tensor>& input_tensors) {
+    CHECK(info_ != nullptr);
+    // TODO(satok): Add utilities to implement this function more easily.
+    // CAVEAT: This test only handles add op. You can implement here as you
+    // like.
+    CHECK_EQ(1, info_->graph_input_node_name_size());
+    const string& input_node_name = info_->graph_input_node_name(0);
+    const Tensor& input_tensor = input_tensors.at(input_node_name);
+    const float input_val = *input_tensor.scalar<float>().data();
+    // TODO(satok): Read NAME_B from node_a_plus_b
+    const NodeDef& node_b = *node_def_map_.at(NAME_B);
+    const TensorProto* proto = nullptr;
+    TF_CHECK_OK(GetNodeAttr(node_b, "value", &proto));
+    Tensor const_tensor;
+    TF_CHECK_OK(RemoteFusedGraphExecuteUtils::MakeTensorFromProto(
+        *proto, &const_tensor));
+    const float b_val = *const_tensor.scalar<float>().data();
+    Tensor output_a_plus_b(DT_FLOAT, {});
+    output_a_plus_b.flat<float>().data()[0] = input_val + b_val;
+    output_tensor_buf_[info_->graph_output_node_name(0)] = output_a_plus_b;
+    return true;
+  }
+
   const RemoteFusedGraphExecuteInfo* info_;
   std::unordered_map<string, Tensor> input_tensor_cache_;
+  std::vector<std::unordered_map<string, Tensor>> staged_input_tensors_;
   std::unordered_map<string, const NodeDef*> node_def_map_;
   std::unordered_map<string, Tensor> output_tensor_buf_;
 };
@@ -225,7 +250,13 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
 namespace remote_fused_graph_execute_op {
 Status BuildRemoteFusedGraphExecutor(
     std::unique_ptr<IRemoteFusedGraphExecutor>* executor) {
-  executor->reset(new TestRemoteFusedGraphExecutor());
+  executor->reset(new TestRemoteFusedGraphExecutor(1));
+  return Status::OK();
+}
+
+Status BuildPipelinedRemoteFusedGraphExecutor(
+    std::unique_ptr<IRemoteFusedGraphExecutor>* executor) {
+  executor->reset(new TestRemoteFusedGraphExecutor(2));
   return Status::OK();
 }
 
@@ -235,17 +266,22 @@ Status BuildRemoteFusedGraphExecutor(
 static RemoteFusedGraphExecuteUtils::ExecutorBuildRegistrar
     k_test_remote_fused_graph_executor_build(REMOTE_FUSED_EXECUTOR_NAME,
                                              BuildRemoteFusedGraphExecutor);
+static RemoteFusedGraphExecuteUtils::ExecutorBuildRegistrar
+    k_test_pipelined_remote_fused_graph_executor_build(
+        PIPELINED_REMOTE_FUSED_EXECUTOR_NAME,
+        BuildPipelinedRemoteFusedGraphExecutor);
 }  // namespace remote_fused_graph_execute_op
 
 // 3. Create Graph transform function to fuse your graph
 static Status RewriteGraphToFusedGraph(const GraphDef& original_graph,
+                                       const string& executor_name,
                                        GraphDef* fused_graph) {
   Scope root = Scope::NewRootScope();
   std::vector<Output> output_list;
   const Output op_a = BuildPlaceHolderOp(NAME_A, DT_FLOAT, {}, &root);
   output_list.emplace_back(op_a);
   const RemoteFusedGraphExecuteInfo execute_info =
-      BuildRemoteFusedGraphExecuteInfo(original_graph);
+      BuildRemoteFusedGraphExecuteInfo(original_graph, executor_name);
   BuildRemoteFusedGraphExecuteOp(REMOTE_FUSED_EXECUTE_OP_NODE_NAME, output_list,
                                  1, execute_info, &root);
   GraphDef fused_graph_def;
@@ -275,7 +311,8 @@ TEST(RemoteFusedExecuteGraphOp, EndToEndTest) {
 
   // 5.2 Fuse graph
   GraphDef fused_graph;
-  TF_ASSERT_OK(RewriteGraphToFusedGraph(original_graph, &fused_graph));
+  TF_ASSERT_OK(RewriteGraphToFusedGraph(
+      original_graph, REMOTE_FUSED_EXECUTOR_NAME, &fused_graph));
 
   // 5.3 Setup session
   std::vector<Tensor> output_tensors;
@@ -310,6 +347,42 @@ TEST(RemoteFusedExecuteGraphOp, EndToEndTest) {
               FLOAT_VALUE_TOLERANCE);
 }
 
+// Runs frames concurrently through an executor with two staging slots.
+TEST(RemoteFusedExecuteGraphOp, PipelinedEndToEndTest) {
+  GraphDef original_graph;
+  TF_ASSERT_OK(RemoteFusedGraphExecuteOpTestUtils::BuildAddGraph(
+      NAME_A, NODE_A_VAL, NAME_B, NODE_B_VAL, NAME_A_PLUS_B, &original_graph));
+  GraphDef fused_graph;
+  TF_ASSERT_OK(RewriteGraphToFusedGraph(
+      original_graph, PIPELINED_REMOTE_FUSED_EXECUTOR_NAME, &fused_graph));
+
+  SessionOptions session_options;
+  session_options.env = Env::Default();
+  std::unique_ptr<Session> session(NewSession(session_options));
+  TF_ASSERT_OK(session->Create(fused_graph));
+
+  constexpr int kFrames = 32;
+  std::vector<float> results(kFrames);
+  {
+    thread::ThreadPool pool(Env::Default(), "frames", 4);
+    for (int frame = 0; frame < kFrames; ++frame) {
+      pool.Schedule([frame, &session, &results]() {
+        Tensor input_a(DT_FLOAT, {});
+        input_a.flat<float>()(0) = static_cast<float>(frame);
+        std::vector<Tensor> output_tensors;
+        TF_CHECK_OK(session->Run({{NAME_A, input_a}},
+                                 {REMOTE_FUSED_EXECUTE_OP_NODE_NAME}, {},
+                                 &output_tensors));
+        CHECK_EQ(1, output_tensors.size());
+        results[frame] = output_tensors[0].flat<float>()(0);
+      });
+    }
+  }
+  for (int frame = 0; frame < kFrames; ++frame) {
+    EXPECT_NEAR(frame + NODE_B_VAL, results[frame], FLOAT_VALUE_TOLERANCE);
+  }
+}
+
 ////////////////////////////
 // End-to-end test: End   //
 ////////////////////////////
@@ -100,16 +100,72 @@ inline float compute_lerp(const float top_left, const float top_right,
   return top + (bottom - top) * y_lerp;
 }
 
+// Computes the output row 'y' of an image, whose input rows 'ys[y].lower'
+// and 'ys[y].upper' start at 'ys_input_lower_ptr' and 'ys_input_upper_ptr'.
+// The channels are the innermost loop, over contiguous values.
 template <typename T>
-void resize_image(
-    typename TTypes<T, 4>::ConstTensor images, const int batch_size,
-    const int64 in_height, const int64 in_width, const int64 out_height,
-    const int64 out_width, const int channels,
-    const std::vector<CachedInterpolation>& xs,
-    const std::vector<CachedInterpolation>& ys,
-    typename TTypes<float, 4>::Tensor output) TF_ATTRIBUTE_NOINLINE;
+inline void resize_row(const T* ys_input_lower_ptr,
+                       const T* ys_input_upper_ptr, const float ys_lerp,
+                       const int64 out_width, const int channels,
+                       const CachedInterpolation* xs, float* output_y_ptr) {
+  if (channels == 3) {
+    for (int64 x = 0; x < out_width; ++x) {
+      const int64 xs_lower = xs[x].lower;
+      const int64 xs_upper = xs[x].upper;
+      const float xs_lerp = xs[x].lerp;
+
+      // Read channel 0.
+      const float top_left0(ys_input_lower_ptr[xs_lower + 0]);
+      const float top_right0(ys_input_lower_ptr[xs_upper + 0]);
+      const float bottom_left0(ys_input_upper_ptr[xs_lower + 0]);
+      const float bottom_right0(ys_input_upper_ptr[xs_upper + 0]);
+
+      // Read channel 1.
+      const float top_left1(ys_input_lower_ptr[xs_lower + 1]);
+      const float top_right1(ys_input_lower_ptr[xs_upper + 1]);
+      const float bottom_left1(ys_input_upper_ptr[xs_lower + 1]);
+      const float bottom_right1(ys_input_upper_ptr[xs_upper + 1]);
+
+      // Read channel 2.
+      const float top_left2(ys_input_lower_ptr[xs_lower + 2]);
+      const float top_right2(ys_input_lower_ptr[xs_upper + 2]);
+      const float bottom_left2(ys_input_upper_ptr[xs_lower + 2]);
+      const float bottom_right2(ys_input_upper_ptr[xs_upper + 2]);
+
+      // Compute output.
+      output_y_ptr[x * channels + 0] =
+          compute_lerp(top_left0, top_right0, bottom_left0, bottom_right0,
+                       xs_lerp, ys_lerp);
+      output_y_ptr[x * channels + 1] =
+          compute_lerp(top_left1, top_right1, bottom_left1, bottom_right1,
+                       xs_lerp, ys_lerp);
+      output_y_ptr[x * channels + 2] =
+          compute_lerp(top_left2, top_right2, bottom_left2, bottom_right2,
+                       xs_lerp, ys_lerp);
+    }
+  } else {
+    for (int64 x = 0; x < out_width; ++x) {
+      const T* top_left_ptr = ys_input_lower_ptr + xs[x].lower;
+      const T* top_right_ptr = ys_input_lower_ptr + xs[x].upper;
+      const T* bottom_left_ptr = ys_input_upper_ptr + xs[x].lower;
+      const T* bottom_right_ptr = ys_input_upper_ptr + xs[x].upper;
+      const float xs_lerp = xs[x].lerp;
+      float* output_x_ptr = output_y_ptr + x * channels;
+      for (int c = 0; c < channels; ++c) {
+        output_x_ptr[c] = compute_lerp(
+            static_cast<float>(top_left_ptr[c]),
+            static_cast<float>(top_right_ptr[c]),
+            static_cast<float>(bottom_left_ptr[c]),
+            static_cast<float>(bottom_right_ptr[c]), xs_lerp, ys_lerp);
+      }
+    }
+  }
+}
+
+// Resizes the images in parallel over their output rows.
 template <typename T>
-void resize_image(typename TTypes<T, 4>::ConstTensor images,
+void resize_image(const CPUDevice& d,
+                  typename TTypes<T, 4>::ConstTensor images,
                   const int batch_size, const int64 in_height,
                   const int64 in_width, const int64 out_height,
                   const int64 out_width, const int channels,
@@ -120,80 +176,26 @@ void resize_image(typename TTypes<T, 4>::ConstTensor images,
   const int64 in_batch_num_values = in_height * in_row_size;
   const int64 out_row_size = out_width * channels;
 
-  const T* input_b_ptr = images.data();
+  const T* input_ptr = images.data();
+  float* output_ptr = output.data();
   const CachedInterpolation* xs = xs_vec.data();
 
-  if (channels == 3) {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          const int64 xs_lower = xs[x].lower;
-          const int64 xs_upper = xs[x].upper;
-          const float xs_lerp = xs[x].lerp;
-
-          // Read channel 0.
-          const float top_left0(ys_input_lower_ptr[xs_lower + 0]);
-          const float top_right0(ys_input_lower_ptr[xs_upper + 0]);
-          const float bottom_left0(ys_input_upper_ptr[xs_lower + 0]);
-          const float bottom_right0(ys_input_upper_ptr[xs_upper + 0]);
-
-          // Read channel 1.
-          const float top_left1(ys_input_lower_ptr[xs_lower + 1]);
-          const float top_right1(ys_input_lower_ptr[xs_upper + 1]);
-          const float bottom_left1(ys_input_upper_ptr[xs_lower + 1]);
-          const float bottom_right1(ys_input_upper_ptr[xs_upper + 1]);
-
-          // Read channel 2.
-          const float top_left2(ys_input_lower_ptr[xs_lower + 2]);
-          const float top_right2(ys_input_lower_ptr[xs_upper + 2]);
-          const float bottom_left2(ys_input_upper_ptr[xs_lower + 2]);
-          const float bottom_right2(ys_input_upper_ptr[xs_upper + 2]);
-
-          // Compute output.
-          output_y_ptr[x * channels + 0] =
-              compute_lerp(top_left0, top_right0, bottom_left0, bottom_right0,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 1] =
-              compute_lerp(top_left1, top_right1, bottom_left1, bottom_right1,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 2] =
-              compute_lerp(top_left2, top_right2, bottom_left2, bottom_right2,
-                           xs_lerp, ys_lerp);
-        }
-        output_y_ptr += out_row_size;
-      }
-      input_b_ptr += in_batch_num_values;
-    }
-  } else {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          auto xs_lower = xs[x].lower;
-          auto xs_upper = xs[x].upper;
-          auto xs_lerp = xs[x].lerp;
-          for (int c = 0; c < channels; ++c) {
-            const float top_left(ys_input_lower_ptr[xs_lower + c]);
-            const float top_right(ys_input_lower_ptr[xs_upper + c]);
-            const float bottom_left(ys_input_upper_ptr[xs_lower + c]);
-            const float bottom_right(ys_input_upper_ptr[xs_upper + c]);
-            output_y_ptr[x * channels + c] =
-                compute_lerp(top_left, top_right, bottom_left, bottom_right,
-                             xs_lerp, ys_lerp);
-          }
-        }
-        output_y_ptr += out_row_size;
-      }
-      input_b_ptr += in_batch_num_values;
+  auto resize_rows = [&](int64 start, int64 limit) {
+    for (int64 row = start; row < limit; ++row) {
+      const int64 b = row / out_height;
+      const int64 y = row % out_height;
+      const T* input_b_ptr = input_ptr + b * in_batch_num_values;
+      resize_row(input_b_ptr + ys[y].lower * in_row_size,
+                 input_b_ptr + ys[y].upper * in_row_size, ys[y].lerp,
+                 out_width, channels, xs, output_ptr + row * out_row_size);
     }
-  }
+  };
+  // Each output value reads 4 input values, and takes 3 lerps.
+  d.parallelFor(batch_size * out_height,
+                Eigen::TensorOpCost(4 * out_row_size * sizeof(T),
+                                    out_row_size * sizeof(float),
+                                    9 * out_row_size),
+                resize_rows);
 }
 
 }  // namespace
@@ -233,7 +235,7 @@ struct ResizeBilinear<CPUDevice, T> {
       xs[i].upper *= channels;
     }
 
-    resize_image<T>(images, batch_size, in_height, in_width, out_height,
+    resize_image<T>(d, images, batch_size, in_height, in_width, out_height,
                     out_width, channels, xs, ys, output);
   }
 };
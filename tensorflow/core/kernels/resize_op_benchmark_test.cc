@@ -54,4 +54,75 @@ BM_ResizeDev(gpu, ResizeNearestNeighbor, 10, 499, 499);
 BM_ResizeDev(cpu, ResizeBilinear, 10, 499, 499);
 BM_ResizeDev(gpu, ResizeBilinear, 10, 499, 499);
 
+// Downsizes uint8 images with 'channels' channels by half.
+static Graph* BM_ResizeBilinearUint8(int batches, int width, int height,
+                                     int channels) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in(DT_UINT8, TensorShape({batches, height, width, channels}));
+  in.flat<uint8>().setRandom();
+
+  Tensor out_size(DT_INT32, TensorShape({2}));
+  auto out_size_flat = out_size.flat<int32>();
+  out_size_flat(0) = height / 2;
+  out_size_flat(1) = width / 2;
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ResizeBilinear")
+                  .Input(test::graph::Constant(g, in))
+                  .Input(test::graph::Constant(g, out_size))
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_ResizeBilinearUint8Dev(DEVICE, B, W, H, C)                       \
+  static void BM_ResizeBilinearUint8_##DEVICE##_##B##_##W##_##H##_##C(      \
+      int iters) {                                                          \
+    testing::ItemsProcessed(iters * B * (W / 2) * (H / 2) * C);             \
+    test::Benchmark(#DEVICE, BM_ResizeBilinearUint8(B, W, H, C)).Run(iters); \
+  }                                                                         \
+  BENCHMARK(BM_ResizeBilinearUint8_##DEVICE##_##B##_##W##_##H##_##C)
+
+BM_ResizeBilinearUint8Dev(cpu, 10, 640, 480, 3);
+BM_ResizeBilinearUint8Dev(cpu, 10, 640, 480, 16);
+
+// Crops 'num_boxes' boxes of 'crop_size' x 'crop_size' from a float feature
+// map with 'depth' channels, as the second stage of a detector does.
+static Graph* BM_CropAndResize(int num_boxes, int crop_size, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor image(DT_FLOAT, TensorShape({1, 64, 64, depth}));
+  image.flat<float>().setRandom();
+  Tensor boxes(DT_FLOAT, TensorShape({num_boxes, 4}));
+  auto boxes_matrix = boxes.matrix<float>();
+  for (int b = 0; b < num_boxes; ++b) {
+    const float offset = 0.5f * b / num_boxes;
+    boxes_matrix(b, 0) = offset;
+    boxes_matrix(b, 1) = offset;
+    boxes_matrix(b, 2) = offset + 0.4f;
+    boxes_matrix(b, 3) = offset + 0.3f;
+  }
+  Tensor box_ind(DT_INT32, TensorShape({num_boxes}));
+  box_ind.flat<int32>().setZero();
+  Tensor crop_size_t(DT_INT32, TensorShape({2}));
+  crop_size_t.flat<int32>().setConstant(crop_size);
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "CropAndResize")
+                  .Input(test::graph::Constant(g, image))
+                  .Input(test::graph::Constant(g, boxes))
+                  .Input(test::graph::Constant(g, box_ind))
+                  .Input(test::graph::Constant(g, crop_size_t))
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_CropAndResizeDev(DEVICE, N, S, D)                                \
+  static void BM_CropAndResize_##DEVICE##_##N##_##S##_##D(int iters) {      \
+    testing::ItemsProcessed(iters * N * S * S * D);                         \
+    test::Benchmark(#DEVICE, BM_CropAndResize(N, S, D)).Run(iters);         \
+  }                                                                         \
+  BENCHMARK(BM_CropAndResize_##DEVICE##_##N##_##S##_##D)
+
+BM_CropAndResizeDev(cpu, 300, 14, 256);
+BM_CropAndResizeDev(gpu, 300, 14, 256);
+
 }  // namespace tensorflow
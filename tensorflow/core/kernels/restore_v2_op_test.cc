@@ -30,7 +30,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -353,5 +356,54 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+// Restores enough bytes in one op to be read by several readers in parallel.
+TEST_F(RestoreV2OpTest, RestoreManyLargeTensors) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "many_large_tensors");
+  const int kNumTensors = 6;
+  const int64 kNumElements = 4 << 20;
+  std::vector<string> tensor_names;
+  {
+    BundleWriter writer(Env::Default(), prefix);
+    for (int t = 0; t < kNumTensors; ++t) {
+      tensor_names.push_back(strings::StrCat("tensor_", t));
+      // The tensors have different sizes, so that the groups are unequal.
+      Tensor tensor = MakeInput<float>(
+          TensorShape({kNumElements / (t + 1)}),
+          [t](int x) -> float { return static_cast<float>(x + t); });
+      TF_ASSERT_OK(writer.Add(tensor_names.back(), tensor));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())  // prefix
+                   .Input(FakeInput())  // tensor_names
+                   .Input(FakeInput())  // shape_and_slices
+                   .Attr("dtypes", DataTypeVector(kNumTensors, DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<string>(TensorShape({}), {prefix});
+  AddInputFromArray<string>(TensorShape({kNumTensors}), tensor_names);
+  // The last tensor is restored as a slice of its second half.
+  std::vector<string> shape_and_slices(kNumTensors, "");
+  const int64 last_size = kNumElements / kNumTensors;
+  shape_and_slices.back() =
+      strings::StrCat(last_size, " ", last_size / 2, ",", last_size / 2);
+  AddInputFromArray<string>(TensorShape({kNumTensors}), shape_and_slices);
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int t = 0; t < kNumTensors; ++t) {
+    const Tensor* output = GetOutput(t);
+    const bool is_slice = t == kNumTensors - 1;
+    const int64 size = kNumElements / (t + 1);
+    const int64 offset = is_slice ? size / 2 : 0;
+    ASSERT_EQ(size - offset, output->NumElements());
+    const auto values = output->flat<float>();
+    for (int64 x = 0; x < values.size(); x += 4099) {
+      EXPECT_EQ(static_cast<float>(x + offset + t), values(x));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <utility>
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -231,6 +233,37 @@ void RestoreTensor(OpKernelContext* context,
 #undef READER_COPY
 }
 
+namespace {
+
+// Restores at least this many bytes per reader when restoring in parallel,
+// so that opening another reader pays off.
+const int64 kMinBytesPerRestoreGroup = 16 << 20;
+
+// A tensor to restore, and the output it is restored into.
+struct RestoreItem {
+  int index;
+  bool is_slice;
+  TensorSlice slice;
+  Tensor* tensor;
+};
+
+Status RestoreItems(BundleReader* reader, const Tensor& tensor_names,
+                    const std::vector<const RestoreItem*>& items) {
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  for (const RestoreItem* item : items) {
+    const string& tensor_name = tensor_names_flat(item->index);
+    if (item->is_slice) {
+      TF_RETURN_IF_ERROR(
+          reader->LookupSlice(tensor_name, item->slice, item->tensor));
+    } else {
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, item->tensor));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
@@ -242,31 +275,39 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   BundleReader reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(reader.status());
 
-  // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
-  TensorShape restored_full_shape;
-  Tensor* restored_tensor = nullptr;
+  // Validates the specs and allocates all the outputs first, so that the
+  // contents can then be read concurrently.
+  std::vector<RestoreItem> items(tensor_names_flat.size());
+  int64 total_bytes = 0;
   for (size_t i = 0; i < tensor_names_flat.size(); ++i) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    TF_RETURN_IF_ERROR(
-        reader.LookupTensorShape(tensor_name, &restored_full_shape));
+    DataType restored_dtype;
+    TensorShape restored_full_shape;
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(tensor_name, &restored_dtype,
+                                                  &restored_full_shape));
+    if (dtypes[i] != restored_dtype) {
+      return errors::InvalidArgument(
+          "tensor_name = ", tensor_name, "; expected dtype ",
+          DataTypeString(dtypes[i]), " does not equal restored dtype ",
+          DataTypeString(restored_dtype));
+    }
 
-    if (shape_and_slice.empty()) {
+    RestoreItem* item = &items[i];
+    item->index = i;
+    item->is_slice = !shape_and_slice.empty();
+    if (!item->is_slice) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
-          context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
+          context->allocate_output(i, restored_full_shape, &item->tensor));
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
-      TensorSlice parsed_slice;
       TensorShape parsed_slice_shape;
 
       TF_RETURN_IF_ERROR(
           checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
-                                         &parsed_slice, &parsed_slice_shape));
+                                         &item->slice, &parsed_slice_shape));
       if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
         return errors::InvalidArgument(
             "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
@@ -276,16 +317,63 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
       }
 
       TF_RETURN_IF_ERROR(
-          context->allocate_output(i, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
-    }
-    if (dtypes[i] != restored_tensor->dtype()) {
-      return errors::InvalidArgument(
-          "tensor_name = ", tensor_name, "; expected dtype ",
-          DataTypeString(dtypes[i]), " does not equal restored dtype ",
-          DataTypeString(restored_tensor->dtype()));
+          context->allocate_output(i, parsed_slice_shape, &item->tensor));
     }
+    total_bytes += item->tensor->TotalBytes();
+  }
+
+  // Large restores are split into groups of similar size, each read through
+  // its own reader on a worker thread, since a reader only reads one tensor
+  // at a time.
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      context->device()->tensorflow_cpu_worker_threads();
+  int num_groups = 1;
+  if (worker_threads != nullptr) {
+    num_groups = static_cast<int>(std::min<int64>(
+        {static_cast<int64>(worker_threads->num_threads),
+         static_cast<int64>(items.size()),
+         total_bytes / kMinBytesPerRestoreGroup}));
+    num_groups = std::max(num_groups, 1);
+  }
+  std::vector<const RestoreItem*> sorted_items;
+  for (const RestoreItem& item : items) {
+    sorted_items.push_back(&item);
+  }
+  if (num_groups == 1) {
+    return RestoreItems(&reader, tensor_names, sorted_items);
+  }
+
+  // Assigns the largest tensors first, each to the lightest group.
+  std::sort(sorted_items.begin(), sorted_items.end(),
+            [](const RestoreItem* a, const RestoreItem* b) {
+              return a->tensor->TotalBytes() > b->tensor->TotalBytes();
+            });
+  std::vector<std::vector<const RestoreItem*>> groups(num_groups);
+  std::vector<int64> group_bytes(num_groups, 0);
+  for (const RestoreItem* item : sorted_items) {
+    const int g = std::min_element(group_bytes.begin(), group_bytes.end()) -
+                  group_bytes.begin();
+    groups[g].push_back(item);
+    group_bytes[g] += item->tensor->TotalBytes();
+  }
+
+  std::vector<Status> statuses(num_groups);
+  BlockingCounter counter(num_groups - 1);
+  for (int g = 1; g < num_groups; ++g) {
+    worker_threads->workers->Schedule(
+        [&prefix_string, &tensor_names, &groups, &statuses, &counter, g]() {
+          BundleReader group_reader(Env::Default(), prefix_string);
+          statuses[g] = group_reader.status();
+          if (statuses[g].ok()) {
+            statuses[g] = RestoreItems(&group_reader, tensor_names, groups[g]);
+          }
+          counter.DecrementCount();
+        });
+  }
+  statuses[0] = RestoreItems(&reader, tensor_names, groups[0]);
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
   }
   return Status::OK();
 }
@@ -15,19 +15,26 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -37,11 +44,11 @@ namespace tensorflow {
 
 namespace {
 
-// Shared validations of the inputs to the SaveV2 and RestoreV2 ops.
+// Shared validations of the inputs to the SaveV2, AsyncSaveV2 and RestoreV2
+// ops.  The tensors to save, if any, follow the first "kFixedInputs" inputs.
 void ValidateInputs(bool is_save_op, OpKernelContext* context,
                     const Tensor& prefix, const Tensor& tensor_names,
-                    const Tensor& shape_and_slices) {
-  const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+                    const Tensor& shape_and_slices, const int kFixedInputs) {
   const int num_tensors = static_cast<int>(tensor_names.NumElements());
   OP_REQUIRES(
       context, prefix.NumElements() == 1,
@@ -69,7 +76,7 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
       context, shape_and_slices.NumElements() == num_tensors,
       errors::InvalidArgument("Expected ", num_tensors,
                               " elements in shapes_and_slices, but got ",
-                              context->input(2).NumElements()));
+                              shape_and_slices.NumElements()));
   if (is_save_op) {
     OP_REQUIRES(context, context->num_inputs() == num_tensors + kFixedInputs,
                 errors::InvalidArgument(
@@ -85,60 +92,309 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// A tensor to be saved by SaveV2, with its parsed slice spec.
+struct TensorToSave {
+  const string* name;
+  const Tensor* tensor;
+  bool is_slice;
+  TensorShape full_shape;  // Only set if "is_slice".
+  TensorSlice slice;       // Only set if "is_slice".
+};
+
+// Writes "tensors[i]" for every "i" in "indices" to a new bundle at "prefix".
+Status WriteBundle(const string& prefix,
+                   const std::vector<TensorToSave>& tensors,
+                   const std::vector<int>& indices) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+  for (int i : indices) {
+    const TensorToSave& t = tensors[i];
+    if (t.is_slice) {
+      TF_RETURN_IF_ERROR(
+          writer.AddSlice(*t.name, t.full_shape, t.slice, *t.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(*t.name, *t.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+// Splits "tensors" into "num_shards" non-empty groups of roughly equal byte
+// size, placing each tensor (largest first) in the least loaded group.  The
+// tensors of each group keep their relative input order.
+std::vector<std::vector<int>> AssignToShards(
+    const std::vector<TensorToSave>& tensors, int num_shards) {
+  std::vector<int> order(tensors.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&tensors](int a, int b) {
+    return tensors[a].tensor->TotalBytes() > tensors[b].tensor->TotalBytes();
+  });
+  // Ties on bytes are broken by tensor count, so that no group is left empty
+  // even when many tensors are empty.
+  std::vector<std::pair<int64, int>> load(num_shards, {0, 0});
+  std::vector<std::vector<int>> shards(num_shards);
+  for (int i : order) {
+    const int s = std::min_element(load.begin(), load.end()) - load.begin();
+    load[s].first += tensors[i].tensor->TotalBytes();
+    ++load[s].second;
+    shards[s].push_back(i);
+  }
+  for (auto& shard : shards) std::sort(shard.begin(), shard.end());
+  return shards;
+}
+
+// Parses the tensor names and slice specs of a save op, whose tensors to
+// save start at input "first_tensor_input", into "*tensors".
+Status ParseTensorsToSave(OpKernelContext* context, const Tensor& tensor_names,
+                          const Tensor& shape_and_slices,
+                          int first_tensor_input,
+                          std::vector<TensorToSave>* tensors) {
+  const int num_tensors = static_cast<int>(tensor_names.NumElements());
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+  tensors->resize(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    TensorToSave* t = &(*tensors)[i];
+    t->name = &tensor_names_flat(i);
+    t->tensor = &context->input(i + first_tensor_input);
+    t->is_slice = !shape_and_slices_flat(i).empty();
+
+    if (t->is_slice) {
+      const string& shape_spec = shape_and_slices_flat(i);
+      TensorShape slice_shape;
+      t->slice = TensorSlice(t->tensor->dims());
+
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+          shape_spec, &t->full_shape, &t->slice, &slice_shape));
+      if (!slice_shape.IsSameSize(t->tensor->shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice specification does not match the shape "
+            "of the tensor to  save: ",
+            shape_spec, ", tensor: ", t->tensor->shape().DebugString());
+      }
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_shards", &num_shards_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
     const Tensor& tensor_names = context->input(1);
     const Tensor& shape_and_slices = context->input(2);
+    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
-                   shape_and_slices);
+                   shape_and_slices, kFixedInputs);
+    if (!context->status().ok()) return;
 
-    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
     const int num_tensors = static_cast<int>(tensor_names.NumElements());
     const string& prefix_string = prefix.scalar<string>()();
-    const auto& tensor_names_flat = tensor_names.flat<string>();
-    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
-
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
-    for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
+    std::vector<TensorToSave> tensors;
+    OP_REQUIRES_OK(context,
+                   ParseTensorsToSave(context, tensor_names, shape_and_slices,
+                                      kFixedInputs, &tensors));
+
+    const int num_shards = std::min(num_shards_, num_tensors);
+    if (num_shards <= 1) {
+      std::vector<int> all(num_tensors);
+      for (int i = 0; i < num_tensors; ++i) all[i] = i;
+      OP_REQUIRES_OK(context, WriteBundle(prefix_string, tensors, all));
+      return;
+    }
+
+    // Writes each group of tensors to a temporary bundle of its own, using
+    // the device's threads for all but the first group, then merges the
+    // metadata of the temporary bundles into a single checkpoint.
+    const std::vector<std::vector<int>> shards =
+        AssignToShards(tensors, num_shards);
+    std::vector<string> shard_prefixes(num_shards);
+    for (int s = 0; s < num_shards; ++s) {
+      shard_prefixes[s] =
+          strings::StrCat(prefix_string, "_temp_shard_", s, "_of_", num_shards);
+    }
+    std::vector<Status> statuses(num_shards);
+    BlockingCounter counter(num_shards - 1);
+    auto* workers = context->device()->tensorflow_cpu_worker_threads()->workers;
+    for (int s = 1; s < num_shards; ++s) {
+      workers->Schedule([&, s]() {
+        statuses[s] = WriteBundle(shard_prefixes[s], tensors, shards[s]);
+        counter.DecrementCount();
+      });
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+    statuses[0] = WriteBundle(shard_prefixes[0], tensors, shards[0]);
+    counter.Wait();
+    for (const Status& s : statuses) {
+      OP_REQUIRES_OK(context, s);
+    }
+    OP_REQUIRES_OK(context, MergeBundles(Env::Default(), shard_prefixes,
+                                         prefix_string));
   }
+
+ private:
+  int num_shards_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+// Writes the checkpoints scheduled by AsyncSaveV2 ops one at a time, on a
+// thread of its own, and remembers the first error.
+class AsyncSaver : public ResourceBase {
+ public:
+  AsyncSaver() : thread_pool_(Env::Default(), "async_saver", 1) {}
+
+  ~AsyncSaver() override {
+    // Lets the scheduled writes finish, so that no checkpoint is truncated.
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      cond_.wait(l);
+    }
+  }
+
+  string DebugString() override { return "AsyncSaver"; }
+
+  // Runs "write" after the writes scheduled before it.
+  void Schedule(std::function<Status()> write) {
+    {
+      mutex_lock l(mu_);
+      ++num_pending_;
+    }
+    thread_pool_.Schedule([this, write]() {
+      Status s = write();
+      mutex_lock l(mu_);
+      status_.Update(s);
+      if (--num_pending_ == 0) {
+        cond_.notify_all();
+      }
+    });
+  }
+
+  // Sets "*num_pending" to the number of writes that have not finished,
+  // after waiting for all of them if "wait" is true.  Returns the first
+  // error of a write, once, if any failed.
+  Status GetStatus(bool wait, int64* num_pending) {
+    mutex_lock l(mu_);
+    while (wait && num_pending_ > 0) {
+      cond_.wait(l);
+    }
+    *num_pending = num_pending_;
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
+  }
+
+ private:
+  mutex mu_;
+  condition_variable cond_;
+  int64 num_pending_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+  thread::ThreadPool thread_pool_;
+};
+REGISTER_RESOURCE_HANDLE_KERNEL(AsyncSaver);
+
+// Snapshots a list of named tensors and writes them to a checkpoint in the
+// background, like SaveV2 does in the foreground.
+class AsyncSaveV2 : public OpKernel {
+ public:
+  explicit AsyncSaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(1);
+    const Tensor& tensor_names = context->input(2);
+    const Tensor& shape_and_slices = context->input(3);
+    // Saver, prefix, tensor names, shape_and_slices.
+    const int kFixedInputs = 4;
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices, kFixedInputs);
+    if (!context->status().ok()) return;
+
+    std::vector<TensorToSave> inputs;
+    OP_REQUIRES_OK(context,
+                   ParseTensorsToSave(context, tensor_names, shape_and_slices,
+                                      kFixedInputs, &inputs));
+
+    // Copies the tensors, so that the step can go on updating the variables
+    // they come from while the checkpoint is written.  Tensors on other
+    // devices have been copied to host memory for this op already, but are
+    // copied again, since this op cannot tell them apart.
+    struct Snapshot {
+      string prefix;
+      std::vector<string> names;
+      std::vector<Tensor> tensors;
+      std::vector<TensorToSave> to_save;
+    };
+    std::shared_ptr<Snapshot> snapshot(new Snapshot);
+    snapshot->prefix = prefix.scalar<string>()();
+    snapshot->names.reserve(inputs.size());
+    snapshot->tensors.reserve(inputs.size());
+    for (const TensorToSave& t : inputs) {
+      snapshot->names.push_back(*t.name);
+      snapshot->tensors.push_back(tensor::DeepCopy(*t.tensor));
+    }
+    snapshot->to_save = inputs;
+    std::vector<int> all(inputs.size());
+    for (int i = 0; i < inputs.size(); ++i) {
+      snapshot->to_save[i].name = &snapshot->names[i];
+      snapshot->to_save[i].tensor = &snapshot->tensors[i];
+      all[i] = i;
+    }
+
+    AsyncSaver* saver;
+    OP_REQUIRES_OK(context,
+                   LookupOrCreateResource<AsyncSaver>(
+                       context, HandleFromInput(context, 0), &saver,
+                       [](AsyncSaver** ret) {
+                         *ret = new AsyncSaver;
+                         return Status::OK();
+                       }));
+    core::ScopedUnref unref(saver);
+    saver->Schedule([snapshot, all]() {
+      return WriteBundle(snapshot->prefix, snapshot->to_save, all);
+    });
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaveV2").Device(DEVICE_CPU), AsyncSaveV2);
+
+// Reports on the checkpoints being written by an AsyncSaver.
+class AsyncSaverStatus : public OpKernel {
+ public:
+  explicit AsyncSaverStatus(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("wait", &wait_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    AsyncSaver* saver;
+    OP_REQUIRES_OK(context,
+                   LookupOrCreateResource<AsyncSaver>(
+                       context, HandleFromInput(context, 0), &saver,
+                       [](AsyncSaver** ret) {
+                         *ret = new AsyncSaver;
+                         return Status::OK();
+                       }));
+    core::ScopedUnref unref(saver);
+    int64 num_pending;
+    OP_REQUIRES_OK(context, saver->GetStatus(wait_, &num_pending));
+    Tensor* output;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    output->scalar<int64>()() = num_pending;
+  }
+
+ private:
+  // Whether to wait for all the scheduled checkpoints to be written.
+  bool wait_;
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaverStatus").Device(DEVICE_CPU),
+                        AsyncSaverStatus);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
@@ -155,7 +411,8 @@ class RestoreV2 : public OpKernel {
                                         " tensor names, but ", dtypes_.size(),
                                         " expected dtypes."));
     ValidateInputs(false /* not save op */, context, prefix, tensor_names,
-                   shape_and_slices);
+                   shape_and_slices, 3 /* prefix, names, shape_and_slices */);
+    if (!context->status().ok()) return;
 
     const string& prefix_string = prefix.scalar<string>()();
 
@@ -339,5 +339,71 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+TEST_F(SaveV2OpTest, Sharded) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_sharded");
+  const string tensornames[] = {"tensor_int", "tensor_float", "tensor_empty",
+                                "tensor_sliced"};
+
+  TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                   .Input(FakeInput())  // prefix
+                   .Input(FakeInput())  // tensor_names
+                   .Input(FakeInput())  // shape_and_slices
+                   .Input(FakeInput({DT_INT32, DT_FLOAT, DT_FLOAT, DT_INT64}))
+                   .Attr("num_shards", 3)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(TensorShape({4}),
+                   [&tensornames](int x) -> string { return tensornames[x]; });
+  AddInput<string>(TensorShape({4}), [](int x) -> string {
+    // Saves "tensor_sliced" as the second row of a 2x3 tensor.
+    return x == 3 ? "2 3 1,1:-" : "";
+  });
+  AddInput<int32>(TensorShape({10}), [](int x) -> int32 { return x + 1; });
+  AddInput<float>(TensorShape({2, 4}),
+                  [](int x) -> float { return static_cast<float>(x) / 10; });
+  AddInput<float>(TensorShape({0}), [](int x) -> float { return 0; });
+  AddInput<int64>(TensorShape({1, 3}), [](int x) -> int64 { return x - 9; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The tensors are spread across three data files, but the checkpoint has a
+  // single metadata file.
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, i, 3)));
+  }
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+
+  {
+    Tensor val;
+    TF_EXPECT_OK(reader.Lookup("tensor_int", &val));
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_EQ(i + 1, val.flat<int32>()(i));
+    }
+  }
+  {
+    Tensor val;
+    TF_EXPECT_OK(reader.Lookup("tensor_float", &val));
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(static_cast<float>(i) / 10, val.flat<float>()(i));
+    }
+  }
+  {
+    Tensor val;
+    TF_EXPECT_OK(reader.Lookup("tensor_empty", &val));
+    EXPECT_EQ(0, val.NumElements());
+  }
+
+  TensorSlice slice;
+  TF_ASSERT_OK(TensorSlice::Parse("1,1:-", &slice));
+  Tensor sliced(DT_INT64, TensorShape({1, 3}));
+  TF_EXPECT_OK(reader.LookupSlice("tensor_sliced", slice, &sliced));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i - 9, sliced.flat<int64>()(i));
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
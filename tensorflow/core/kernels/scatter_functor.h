@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 
 #include <type_traits>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -119,6 +120,76 @@ struct AssignSYCL<scatter_op::UpdateOp::DIV> {
 };
 #endif // TENSORFLOW_USE_SYCL
 
+// Below this many bytes of updates, sorting the updates by row costs more
+// than it saves and they are applied on the calling thread.
+const int64 kParallelScatterMinBytes = 256 << 10;
+
+// Calls fn(i, index) for every update i, where index is indices[i], the row
+// the update is applied to. Large scatters are spread over the threads of the
+// CPU device "d": the updates are bucketed by destination row range with a
+// stable counting sort, so that each thread owns a disjoint range of rows and
+// needs no locks or atomics, and updates to the same row are still applied in
+// their original order. Every index is read exactly once.
+// Returns the position of the first index outside [0, limit), or -1. On
+// error, some of the updates before that position may have been applied.
+template <typename Device, typename Index, typename Fn>
+Index ParallelForEachUpdateByRow(const Device& d, const Index* indices,
+                                 Index N, Index limit, int64 bytes_per_update,
+                                 Fn fn) {
+  const int num_threads = d.numThreads();
+  if (num_threads <= 1 || N * bytes_per_update < kParallelScatterMinBytes) {
+    for (Index i = 0; i < N; i++) {
+      // Grab the index and check its validity.  An earlier version of the
+      // code checked it and then grabbed it from memory a second time, which
+      // was a security risk since it could have changed in between.
+      const Index index = ::tensorflow::internal::SubtleMustCopy(indices[i]);
+      if (!FastBoundsCheck(index, limit)) return i;
+      fn(i, index);
+    }
+    return -1;
+  }
+
+  std::vector<Index> rows(N);
+  for (Index i = 0; i < N; i++) {
+    rows[i] = ::tensorflow::internal::SubtleMustCopy(indices[i]);
+    if (!FastBoundsCheck(rows[i], limit)) return i;
+  }
+
+  // A few partitions per thread leave the scheduler room to balance skewed
+  // row distributions.
+  const int64 rows_per_partition =
+      (limit + 4 * num_threads - 1) / (4 * num_threads);
+  const int64 num_partitions =
+      (limit + rows_per_partition - 1) / rows_per_partition;
+  std::vector<Index> starts(num_partitions + 1, 0);
+  for (Index i = 0; i < N; i++) {
+    ++starts[rows[i] / rows_per_partition + 1];
+  }
+  for (int64 p = 0; p < num_partitions; ++p) {
+    starts[p + 1] += starts[p];
+  }
+  std::vector<Index> order(N);
+  std::vector<Index> next(starts.begin(), starts.end() - 1);
+  for (Index i = 0; i < N; i++) {
+    order[next[rows[i] / rows_per_partition]++] = i;
+  }
+
+  const double bytes_per_partition =
+      static_cast<double>(N) * bytes_per_update / num_partitions;
+  d.parallelFor(num_partitions,
+                Eigen::TensorOpCost(2 * bytes_per_partition,
+                                    bytes_per_partition, bytes_per_partition),
+                [&rows, &starts, &order, &fn](int64 begin, int64 end) {
+                  for (int64 p = begin; p < end; ++p) {
+                    for (Index k = starts[p]; k < starts[p + 1]; ++k) {
+                      const Index i = order[k];
+                      fn(i, rows[i]);
+                    }
+                  }
+                });
+  return -1;
+}
+
 }  // namespace internal
 }  // namespace scatter_op
 
@@ -179,6 +250,27 @@ struct ScatterFunctorBase <SYCLDevice, T, Index, op> {
 };
 #endif // TENSORFLOW_USE_SYCL
 
+// On the CPU, updates are applied in parallel over disjoint row ranges; see
+// ParallelForEachUpdateByRow.
+template <typename T, typename Index, scatter_op::UpdateOp op>
+struct ScatterFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    // indices and params sizes were validated in DoCompute().
+    const Index N = static_cast<Index>(indices.size());
+    const Index limit = static_cast<Index>(params.dimension(0));
+    return scatter_op::internal::ParallelForEachUpdateByRow(
+        d, indices.data(), N, limit, updates.dimension(1) * sizeof(T),
+        [&params, &updates](Index i, Index index) {
+          // Copy last Ndim-1 dimensions of updates[i] to params[index]
+          scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
+                                                updates.template chip<0>(i));
+        });
+  }
+};
+
 template <typename T, typename Index>
 struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
   Index operator()(OpKernelContext* c, const CPUDevice& d,
@@ -189,29 +281,22 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
     const Index N = static_cast<Index>(indices.size());
     const Index limit = static_cast<Index>(params.dimension(0));
     if (!std::is_same<T, string>::value) {
-      for (Index i = 0; i < N; i++) {
-        // Grab the index and check its validity.  An earlier version of the
-        // code checked it and then grabbed it from memory a second time, which
-        // was a security risk since it could have changed in between.
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) return i;
-        memmove(params.data() + index * params.dimension(1),
-                updates.data() + i * updates.dimension(1),
-                updates.dimension(1) * sizeof(T));
-      }
+      return scatter_op::internal::ParallelForEachUpdateByRow(
+          d, indices.data(), N, limit, updates.dimension(1) * sizeof(T),
+          [&params, &updates](Index i, Index index) {
+            memmove(params.data() + index * params.dimension(1),
+                    updates.data() + i * updates.dimension(1),
+                    updates.dimension(1) * sizeof(T));
+          });
     } else {
-      for (Index i = 0; i < N; i++) {
-        // Grab the index and check its validity.  An earlier version of the
-        // code checked it and then grabbed it from memory a second time, which
-        // was a security risk since it could have changed in between.
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) return i;
-        // Copy last Ndim-1 dimensions of updates[i] to params[index]
-        scatter_op::internal::Assign<scatter_op::UpdateOp::ASSIGN>::Run(
-            params.template chip<0>(index), updates.template chip<0>(i));
-      }
+      return scatter_op::internal::ParallelForEachUpdateByRow(
+          d, indices.data(), N, limit, updates.dimension(1) * sizeof(T),
+          [&params, &updates](Index i, Index index) {
+            // Copy last Ndim-1 dimensions of updates[i] to params[index]
+            scatter_op::internal::Assign<scatter_op::UpdateOp::ASSIGN>::Run(
+                params.template chip<0>(index), updates.template chip<0>(i));
+          });
     }
-    return -1;
   }
 };
 
@@ -64,9 +64,9 @@ void FeatureWeightsSparseStorage::UpdateSparseDeltaWeights(
     const double feature_value = sparse_features.values == nullptr
                                      ? 1.0
                                      : (*sparse_features.values)(k);
-    auto it = indices_to_id_.find((*sparse_features.indices)(k));
+    const int64 weight_id = sparse_features.weight_ids[k];
     for (size_t l = 0; l < normalized_bounded_dual_delta.size(); ++l) {
-      deltas_(l, it->second) +=
+      deltas_(l, weight_id) +=
           feature_value * normalized_bounded_dual_delta[l];
     }
   }
@@ -162,15 +162,15 @@ const ExampleStatistics Example::ComputeWxAndWeightedExampleNorm(
         model_weights.sparse_weights()[j];
 
     for (int64 k = 0; k < sparse_features.indices->size(); ++k) {
-      const int64 feature_index = (*sparse_features.indices)(k);
+      const int64 weight_id = sparse_features.weight_ids[k];
       const double feature_value = sparse_features.values == nullptr
                                        ? 1.0
                                        : (*sparse_features.values)(k);
       for (int l = 0; l < num_weight_vectors; ++l) {
-        const float sparse_weight = sparse_weights.nominals(l, feature_index);
+        const float sparse_weight = sparse_weights.nominals(l, weight_id);
         const double feature_weight =
             sparse_weight +
-            sparse_weights.deltas(l, feature_index) * num_loss_partitions;
+            sparse_weights.deltas(l, weight_id) * num_loss_partitions;
         result.prev_wx[l] +=
             feature_value * regularization.Shrink(sparse_weight);
         result.wx[l] += feature_value * regularization.Shrink(feature_weight);
@@ -410,20 +410,22 @@ Status Examples::CreateSparseFeatureRepresentation(
             sparse_features->values.reset(new UnalignedFloatVector(
                 &(feature_weights(start_id)), end_id - start_id));
           }
-          // If features are non empty.
-          if (end_id - start_id > 0) {
-            // TODO(sibyl-Aix6ihai): Write this efficiently using vectorized
-            // operations from eigen.
-            for (int64 k = 0; k < sparse_features->indices->size(); ++k) {
-              const int64 feature_index = (*sparse_features->indices)(k);
-              if (!weights.SparseIndexValid(i, feature_index)) {
-                mutex_lock l(mu);
-                result = errors::InvalidArgument(
-                    "Found sparse feature indices out of valid range: ",
-                    (*sparse_features->indices)(k));
-                return;
-              }
+          // Resolves the weight ids of the features, which also checks that
+          // they are valid.
+          const FeatureWeightsSparseStorage& sparse_weights =
+              weights.sparse_weights()[i];
+          sparse_features->weight_ids.resize(end_id - start_id);
+          for (int64 k = 0; k < sparse_features->indices->size(); ++k) {
+            const int64 feature_index = (*sparse_features->indices)(k);
+            const int64 weight_id = sparse_weights.WeightId(feature_index);
+            if (weight_id < 0) {
+              mutex_lock l(mu);
+              result = errors::InvalidArgument(
+                  "Found sparse feature indices out of valid range: ",
+                  feature_index);
+              return;
             }
+            sparse_features->weight_ids[k] = weight_id;
           }
         } else {
           // Add a Tensor that has size 0.
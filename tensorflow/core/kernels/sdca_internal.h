@@ -150,6 +150,9 @@ class Example {
   struct SparseFeatures {
     std::unique_ptr<TTypes<const int64>::UnalignedConstVec> indices;
     std::unique_ptr<TTypes<const float>::UnalignedConstVec> values;  // nullptr encodes optional.
+    // The ids of the features in the weight storage of their group, resolved
+    // once so that the inner loops index the weights directly.
+    std::vector<int64> weight_ids;
   };
 
   // A dense vector which is a row-slice of the underlying matrix.
@@ -236,26 +239,30 @@ class FeatureWeightsSparseStorage {
       : nominals_(nominals), deltas_(deltas) {
     // Create a map from sparse index to the dense index of the underlying
     // storage.
+    indices_to_id_.reserve(indices.size());
     for (int64 j = 0; j < indices.size(); ++j) {
       indices_to_id_[indices(j)] = j;
     }
   }
 
   // Check if a feature index exists.
-  bool IndexValid(const int64 index) const {
-    return indices_to_id_.find(index) != indices_to_id_.end();
-  }
+  bool IndexValid(const int64 index) const { return WeightId(index) >= 0; }
 
-  // Nominal value at a particular feature index and class label.
-  float nominals(const int class_id, const int64 index) const {
+  // Returns the id of feature "index" in the underlying storage, or -1 if
+  // the feature does not exist.
+  int64 WeightId(const int64 index) const {
     auto it = indices_to_id_.find(index);
-    return nominals_(class_id, it->second);
+    return it == indices_to_id_.end() ? -1 : it->second;
+  }
+
+  // Nominal value at a particular weight id (see WeightId) and class label.
+  float nominals(const int class_id, const int64 weight_id) const {
+    return nominals_(class_id, weight_id);
   }
 
   // Delta weights durining mini-batch updates.
-  float deltas(const int class_id, const int64 index) const {
-    auto it = indices_to_id_.find(index);
-    return deltas_(class_id, it->second);
+  float deltas(const int class_id, const int64 weight_id) const {
+    return deltas_(class_id, weight_id);
   }
 
   // Updates delta weights based on active sparse features in the example and
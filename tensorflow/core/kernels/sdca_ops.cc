@@ -18,7 +18,6 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <stdint.h>
-#include <atomic>
 #include <limits>
 #include <memory>
 #include <new>
@@ -155,13 +154,16 @@ void DoCompute(const ComputeOptions& options, OpKernelContext* const context) {
 
   mutex mu;
   Status train_step_status GUARDED_BY(mu);
-  std::atomic<std::int64_t> atomic_index(-1);
+  // The examples are updated Hogwild style: the shards update the shared
+  // delta weights without locking, and each shard takes a contiguous range of
+  // the (possibly sampled) example order so that the threads do not contend
+  // on a shared counter.
   auto train_step = [&](const int64 begin, const int64 end) {
     // The static_cast here is safe since begin and end can be at most
     // num_examples which is an int.
     for (int id = static_cast<int>(begin); id < end; ++id) {
       const int64 example_index =
-          examples.sampled_index(++atomic_index, options.adaptative);
+          examples.sampled_index(id, options.adaptative);
       const Example& example = examples.example(example_index);
       const float dual = example_state_data(example_index, 0);
       const float example_weight = example.example_weight();
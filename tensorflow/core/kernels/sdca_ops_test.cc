@@ -49,6 +49,14 @@ const SessionOptions* GetMultiThreadedOptions() {
   return kSessionOptions;
 }
 
+SessionOptions GetOptionsWithNumThreads(const int num_threads) {
+  SessionOptions result;
+  result.config.set_intra_op_parallelism_threads(num_threads);
+  result.config.set_inter_op_parallelism_threads(1);
+  result.config.add_session_inter_op_thread_pool()->set_num_threads(1);
+  return result;
+}
+
 Node* Var(Graph* const g, const int n) {
   return test::graph::Var(g, DT_FLOAT, TensorShape({n}));
 }
@@ -259,10 +267,29 @@ void BM_SDCA_LARGE_SPARSE(const int iters, const int num_examples) {
   testing::StartTiming();
   test::Benchmark("cpu", train, GetMultiThreadedOptions(), init).Run(iters);
 }
+
+// Measures how the training step scales with the number of intra op threads.
+void BM_SDCA_LARGE_SPARSE_THREADS(const int iters, const int num_threads) {
+  testing::StopTiming();
+  Graph* init = nullptr;
+  Graph* train = nullptr;
+  GetGraphs(8192 /* examples */, 65 /* sparse feature groups */,
+            1e6 /* sparse features per group */, 0 /* dense feature groups*/,
+            0 /* dense features per group */, &init, &train);
+  const SessionOptions options = GetOptionsWithNumThreads(num_threads);
+  testing::StartTiming();
+  test::Benchmark("cpu", train, &options, init).Run(iters);
+}
 }  // namespace
 
 BENCHMARK(BM_SDCA)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
 BENCHMARK(BM_SDCA_LARGE_DENSE)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
 BENCHMARK(BM_SDCA_LARGE_SPARSE)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
+BENCHMARK(BM_SDCA_LARGE_SPARSE_THREADS)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32);
 
 }  // namespace tensorflow
@@ -32,6 +32,12 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/util.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/platform/cuda.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA
+
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -227,6 +233,128 @@ REGISTER_COMPLEX_CPU_KERNELS_ALL(complex128);
 #undef REGISTER_REAL_CPU_KERNELS_ALL
 #undef REGISTER_COMPLEX_CPU_KERNELS_ALL
 
+#if GOOGLE_CUDA
+// SegmentReductionOp for GPU. The number of segments is one more than the
+// last segment id, which lives in device memory, so it is copied to the host
+// and the output is allocated and reduced once the copy is done. Unlike on
+// CPU, the ids are not checked to be sorted.
+template <class T, class Index, typename Reduction>
+class SegmentReductionGPUOp : public AsyncOpKernel {
+ public:
+  explicit SegmentReductionGPUOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const Tensor& segment_ids = context->input(1);
+    SegmentReductionValidationHelper(context, input, segment_ids);
+    if (!context->status().ok()) {
+      done();
+      return;
+    }
+    OP_REQUIRES_ASYNC(
+        context, FastBoundsCheck(input.NumElements(),
+                                 std::numeric_limits<int32>::max()),
+        errors::InvalidArgument("Input of a segment reduction on GPU must "
+                                "have fewer than 2^31 elements."),
+        done);
+
+    const int64 num_indices = segment_ids.NumElements();
+    if (num_indices == 0) {
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, 0);
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+      done();
+      return;
+    }
+
+    Tensor last_segment_id;
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    attr.set_gpu_compatible(true);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DataTypeToEnum<Index>::value, TensorShape({}),
+                               &last_segment_id, attr),
+        done);
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(context, stream,
+                      errors::Internal("No GPU stream available."), done);
+    perftools::gputools::DeviceMemoryBase last_segment_id_ptr(
+        const_cast<Index*>(segment_ids.flat<Index>().data()) + num_indices -
+            1,
+        sizeof(Index));
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(last_segment_id.scalar<Index>().data(),
+                         last_segment_id_ptr, sizeof(Index))
+            .ok(),
+        errors::Internal("Failed to copy the last segment id to the host."),
+        done);
+
+    auto reduce = [context, input, segment_ids, last_segment_id, done]() {
+      // The callback runs on an event manager thread, which must use the
+      // CUDA context of the device to launch the kernel.
+      perftools::gputools::cuda::ScopedActivateExecutorContext
+          scoped_activation{context->op_device_context()->stream()->parent()};
+      const Index output_rows = last_segment_id.scalar<Index>()() + 1;
+      OP_REQUIRES_ASYNC(context, output_rows > 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, output_rows);
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+      OP_REQUIRES_ASYNC(
+          context, FastBoundsCheck(output->NumElements(),
+                                   std::numeric_limits<int32>::max()),
+          errors::InvalidArgument("Output of a segment reduction on GPU must "
+                                  "have fewer than 2^31 elements."),
+          done);
+      functor::SortedSegmentReductionFunctor<GPUDevice, T, Index, Reduction>()(
+          context->eigen_device<GPUDevice>(), segment_ids.flat<Index>(),
+          input.flat_outer_dims<T>(), output->flat_outer_dims<T>());
+      done();
+    };
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, reduce);
+  }
+};
+
+#define REGISTER_GPU_KERNEL_SEGMENT(name, reduction, type, index_type) \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name(name)                                                       \
+          .Device(DEVICE_GPU)                                          \
+          .TypeConstraint<type>("T")                                   \
+          .TypeConstraint<index_type>("Tindices"),                     \
+      SegmentReductionGPUOp<type, index_type, functor::reduction>)
+
+#define REGISTER_GPU_KERNELS(type, index_type)                               \
+  REGISTER_GPU_KERNEL_SEGMENT("SegmentSum", SegmentSumReduction, type,       \
+                              index_type);                                   \
+  REGISTER_GPU_KERNEL_SEGMENT("SegmentMean", SegmentMeanReduction, type,     \
+                              index_type);                                   \
+  REGISTER_GPU_KERNEL_SEGMENT("SegmentProd", SegmentProdReduction, type,     \
+                              index_type);                                   \
+  REGISTER_GPU_KERNEL_SEGMENT("SegmentMin", SegmentMinReduction, type,       \
+                              index_type);                                   \
+  REGISTER_GPU_KERNEL_SEGMENT("SegmentMax", SegmentMaxReduction, type,       \
+                              index_type)
+
+#define REGISTER_GPU_KERNELS_ALL(type) \
+  REGISTER_GPU_KERNELS(type, int32);   \
+  REGISTER_GPU_KERNELS(type, int64);
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_KERNELS_ALL);
+#undef REGISTER_GPU_KERNEL_SEGMENT
+#undef REGISTER_GPU_KERNELS
+#undef REGISTER_GPU_KERNELS_ALL
+#endif  // GOOGLE_CUDA
+
 namespace functor {
 
 // UnsortedSegmentSumFunctor implementation for CPUDevice.
@@ -855,4 +983,293 @@ REGISTER_CPU_SPARSE_KERNELS(double);
 REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
+
+namespace functor {
+
+template <typename T, typename Index>
+struct SparseSegmentWeightedCombineFunctor<CPUDevice, T, Index> {
+  int64 operator()(const CPUDevice& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix data,
+                   typename TTypes<Index>::ConstVec indices,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output) {
+    const int64 num_indices = indices.dimension(0);
+    const int64 num_segments = output.dimension(0);
+    const int64 num_col = output.dimension(1);
+
+    // Validate the inputs, and find the entries [segment_starts[s],
+    // segment_starts[s + 1]) that make up each segment s.
+    std::vector<int64> segment_starts(num_segments + 1);
+    int64 next_segment = 0;
+    for (int64 i = 0; i < num_indices; ++i) {
+      const int32 segment = internal::SubtleMustCopy(segment_ids(i));
+      const Index index = internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(segment, num_segments) ||
+          segment < next_segment - 1 ||
+          !FastBoundsCheck(index, data.dimension(0))) {
+        return i;
+      }
+      while (next_segment <= segment) {
+        segment_starts[next_segment++] = i;
+      }
+    }
+    while (next_segment <= num_segments) {
+      segment_starts[next_segment++] = num_indices;
+    }
+
+    auto work = [&](int64 first, int64 last) {
+      for (int64 s = first; s < last; ++s) {
+        auto out = output.template chip<0>(s);
+        const int64 begin = segment_starts[s];
+        const int64 end = segment_starts[s + 1];
+        if (begin == end) {
+          out.setZero();
+          continue;
+        }
+        T denominator(0);
+        for (int64 i = begin; i < end; ++i) {
+          const T weight = weights(i);
+          if (i == begin) {
+            out = data.template chip<0>(indices(i)) * weight;
+          } else {
+            out += data.template chip<0>(indices(i)) * weight;
+          }
+          denominator +=
+              combiner == SegmentCombiner::kMean ? weight : weight * weight;
+        }
+        if (combiner == SegmentCombiner::kSqrtN) {
+          denominator = Eigen::numext::sqrt(denominator);
+        }
+        if (combiner != SegmentCombiner::kSum && denominator != T(0)) {
+          out = out / denominator;
+        }
+      }
+    };
+    const double entries_per_segment =
+        static_cast<double>(num_indices) / std::max<int64>(num_segments, 1);
+    d.parallelFor(num_segments,
+                  Eigen::TensorOpCost(entries_per_segment * num_col * sizeof(T),
+                                      num_col * sizeof(T),
+                                      2 * entries_per_segment * num_col),
+                  work);
+    return -1;
+  }
+};
+
+template <typename T>
+struct SparseSegmentWeightedCombineGradFunctor<CPUDevice, T> {
+  int64 operator()(const CPUDevice& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix grad,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output) {
+    const int64 num_indices = weights.dimension(0);
+    const int64 num_segments = grad.dimension(0);
+    const int64 num_col = grad.dimension(1);
+
+    scale.setConstant(T(0));
+    for (int64 i = 0; i < num_indices; ++i) {
+      const int32 segment = internal::SubtleMustCopy(segment_ids(i));
+      if (!FastBoundsCheck(segment, num_segments)) {
+        return i;
+      }
+      const T weight = weights(i);
+      scale(segment) +=
+          combiner == SegmentCombiner::kMean ? weight : weight * weight;
+    }
+    for (int64 s = 0; s < num_segments; ++s) {
+      T denominator = scale(s);
+      if (combiner == SegmentCombiner::kSqrtN) {
+        denominator = Eigen::numext::sqrt(denominator);
+      }
+      scale(s) = combiner == SegmentCombiner::kSum || denominator == T(0)
+                     ? T(1)
+                     : T(1) / denominator;
+    }
+
+    auto work = [&](int64 first, int64 last) {
+      for (int64 i = first; i < last; ++i) {
+        const int32 segment = segment_ids(i);
+        output.template chip<0>(i) =
+            grad.template chip<0>(segment) * (weights(i) * scale(segment));
+      }
+    };
+    d.parallelFor(num_indices,
+                  Eigen::TensorOpCost(num_col * sizeof(T), num_col * sizeof(T),
+                                      num_col),
+                  work);
+    return -1;
+  }
+};
+
+}  // namespace functor
+
+namespace {
+Status ParseSegmentCombiner(const string& combiner,
+                            functor::SegmentCombiner* out) {
+  if (combiner == "sum") {
+    *out = functor::SegmentCombiner::kSum;
+  } else if (combiner == "mean") {
+    *out = functor::SegmentCombiner::kMean;
+  } else if (combiner == "sqrtn") {
+    *out = functor::SegmentCombiner::kSqrtN;
+  } else {
+    return errors::InvalidArgument("Unknown combiner: ", combiner);
+  }
+  return Status::OK();
+}
+}  // namespace
+
+// Gathers the rows of "data" selected by "indices", scales them by "weights"
+// and combines them per segment, without materializing the gathered rows.
+// See core/ops/math_ops.cc for more details.
+template <typename Device, typename T, typename Index>
+class SparseSegmentWeightedCombineOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedCombineOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string combiner;
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner));
+    OP_REQUIRES_OK(context, ParseSegmentCombiner(combiner, &combiner_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& weights = context->input(2);
+    const Tensor& segment_ids = context->input(3);
+    const Tensor& num_segments = context->input(4);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(data.shape()),
+                errors::InvalidArgument("data must be at least 1-D."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+                errors::InvalidArgument("weights should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(num_segments.shape()),
+                errors::InvalidArgument("num_segments should be a scalar."));
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES(context,
+                num_indices == weights.NumElements() &&
+                    num_indices == segment_ids.NumElements(),
+                errors::InvalidArgument(
+                    "indices, weights and segment_ids should have same size."));
+    const int32 output_rows = num_segments.scalar<int32>()();
+    OP_REQUIRES(context, output_rows >= 0,
+                errors::InvalidArgument("num_segments must be >= 0"));
+
+    TensorShape output_shape = data.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor scale;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({output_rows}), &scale));
+    const int64 bad_i =
+        functor::SparseSegmentWeightedCombineFunctor<Device, T, Index>()(
+            context->eigen_device<Device>(), combiner_,
+            data.flat_outer_dims<T>(), indices.vec<Index>(), weights.vec<T>(),
+            segment_ids.vec<int32>(), scale.vec<T>(),
+            output->flat_outer_dims<T>());
+    OP_REQUIRES(
+        context, bad_i < 0,
+        errors::InvalidArgument(
+            "indices[", bad_i, "] is not in [0, ", data.dim_size(0),
+            ") or segment_ids[", bad_i, "] is not in [0, ", output_rows,
+            "), possibly because 'segment_ids' is not sorted."));
+  }
+
+ private:
+  functor::SegmentCombiner combiner_;
+};
+
+template <typename Device, typename T>
+class SparseSegmentWeightedCombineGradOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedCombineGradOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string combiner;
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner));
+    OP_REQUIRES_OK(context, ParseSegmentCombiner(combiner, &combiner_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& weights = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least 1-D."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+                errors::InvalidArgument("weights should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64 num_indices = weights.NumElements();
+    OP_REQUIRES(context, num_indices == segment_ids.NumElements(),
+                errors::InvalidArgument(
+                    "segment_ids and weights should have same size."));
+
+    TensorShape output_shape = grad.shape();
+    output_shape.set_dim(0, num_indices);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor scale;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({grad.dim_size(0)}), &scale));
+    const int64 bad_i =
+        functor::SparseSegmentWeightedCombineGradFunctor<Device, T>()(
+            context->eigen_device<Device>(), combiner_,
+            grad.flat_outer_dims<T>(), weights.vec<T>(),
+            segment_ids.vec<int32>(), scale.vec<T>(),
+            output->flat_outer_dims<T>());
+    OP_REQUIRES(context, bad_i < 0,
+                errors::InvalidArgument("segment_ids[", bad_i,
+                                        "] is not in [0, ", grad.dim_size(0),
+                                        ")."));
+  }
+
+ private:
+  functor::SegmentCombiner combiner_;
+};
+
+#define REGISTER_KERNELS(D, type, index_type)                      \
+  REGISTER_KERNEL_BUILDER(                                         \
+      Name("SparseSegmentWeightedCombine")                         \
+          .Device(DEVICE_##D)                                      \
+          .HostMemory("num_segments")                              \
+          .TypeConstraint<type>("T")                               \
+          .TypeConstraint<index_type>("Tidx"),                     \
+      SparseSegmentWeightedCombineOp<D##Device, type, index_type>);
+#define REGISTER_KERNELS_ALL(D, type)                                \
+  REGISTER_KERNELS(D, type, int32);                                  \
+  REGISTER_KERNELS(D, type, int64);                                  \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("SparseSegmentWeightedCombineGrad")                       \
+          .Device(DEVICE_##D)                                        \
+          .TypeConstraint<type>("T"),                                \
+      SparseSegmentWeightedCombineGradOp<D##Device, type>);
+#define REGISTER_CPU_KERNELS(type) REGISTER_KERNELS_ALL(CPU, type)
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+#undef REGISTER_CPU_KERNELS
+
+#if GOOGLE_CUDA
+#define REGISTER_GPU_KERNELS(type) REGISTER_KERNELS_ALL(GPU, type)
+REGISTER_GPU_KERNELS(float);
+REGISTER_GPU_KERNELS(double);
+#undef REGISTER_GPU_KERNELS
+#endif  // GOOGLE_CUDA
+#undef REGISTER_KERNELS_ALL
+#undef REGISTER_KERNELS
 }  // namespace tensorflow
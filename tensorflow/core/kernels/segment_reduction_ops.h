@@ -73,6 +73,126 @@ struct UnsortedSegmentMaxFunctor: public UnsortedSegmentBaseFunctor<Device, T, I
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output);
 };
+
+// Reductions of the sorted segment ops on GPU. Combine() folds a row of the
+// segment into the accumulator, which starts from the first row, and
+// Finalize() turns the accumulator of 'count' (at least one) rows into the
+// output. Empty segments are set to kEmptyValue, as on CPU.
+struct SegmentSumReduction {
+  static constexpr int kEmptyValue = 0;
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Combine(const T& acc, const T& value) {
+    return acc + value;
+  }
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Finalize(const T& acc, int64 count) {
+    return acc;
+  }
+};
+
+struct SegmentMeanReduction {
+  static constexpr int kEmptyValue = 0;
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Combine(const T& acc, const T& value) {
+    return acc + value;
+  }
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Finalize(const T& acc, int64 count) {
+    return acc / static_cast<T>(count);
+  }
+};
+
+struct SegmentProdReduction {
+  static constexpr int kEmptyValue = 1;
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Combine(const T& acc, const T& value) {
+    return acc * value;
+  }
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Finalize(const T& acc, int64 count) {
+    return acc;
+  }
+};
+
+struct SegmentMinReduction {
+  static constexpr int kEmptyValue = 0;
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Combine(const T& acc, const T& value) {
+    return value < acc ? value : acc;
+  }
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Finalize(const T& acc, int64 count) {
+    return acc;
+  }
+};
+
+struct SegmentMaxReduction {
+  static constexpr int kEmptyValue = 0;
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Combine(const T& acc, const T& value) {
+    return acc < value ? value : acc;
+  }
+  template <typename T>
+  EIGEN_DEVICE_FUNC static T Finalize(const T& acc, int64 count) {
+    return acc;
+  }
+};
+
+// Functor for the sorted segment reductions (SegmentSum, SegmentMean, ...) on
+// GPU. Each output element is reduced by one thread from the run of its
+// segment, so no atomics are needed and the result is deterministic.
+// 'segment_ids': sorted map from input rows to output rows. Rows with ids
+//                outside [0, output.dimension(0)) are dropped, and unsorted
+//                ids give undefined results rather than an error.
+// 'data': input reshaped to {segment_ids.size(), cols}.
+// 'output': output reshaped to {num_segments, cols}.
+template <typename Device, typename T, typename Index, typename Reduction>
+struct SortedSegmentReductionFunctor {
+  void operator()(const Device& d,
+                  typename TTypes<Index>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstMatrix data,
+                  typename TTypes<T>::Matrix output);
+};
+
+// How SparseSegmentWeightedCombineOp normalizes the weighted sum of a segment.
+enum class SegmentCombiner { kSum, kMean, kSqrtN };
+
+// Functor for SparseSegmentWeightedCombineOp.
+// 'data': the embedding table, reshaped to {rows, cols}.
+// 'indices', 'weights', 'segment_ids': one entry per selected row of 'data'.
+//                'segment_ids' must be sorted.
+// 'scale': workspace of output.dimension(0) elements.
+// 'output': output reshaped to {num_segments, cols}.
+// Returns the position of the first invalid entry of 'indices' or
+// 'segment_ids', or -1 if all of them are valid. Devices that cannot check
+// skip invalid entries and always return -1.
+template <typename Device, typename T, typename Index>
+struct SparseSegmentWeightedCombineFunctor {
+  int64 operator()(const Device& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix data,
+                   typename TTypes<Index>::ConstVec indices,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output);
+};
+
+// Functor for SparseSegmentWeightedCombineGradOp. Computes the gradient for
+// each selected row of 'data', i.e. the rows of an IndexedSlices.
+// 'grad': gradient of the output, reshaped to {num_segments, cols}.
+// 'weights', 'segment_ids': as passed to SparseSegmentWeightedCombineOp.
+// 'scale': workspace of grad.dimension(0) elements.
+// 'output': output reshaped to {weights.size(), cols}.
+// Returns the position of the first invalid entry of 'segment_ids', or -1.
+template <typename Device, typename T>
+struct SparseSegmentWeightedCombineGradFunctor {
+  int64 operator()(const Device& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix grad,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output);
+};
 }  // namespace functor
 }  // namespace tensorflow
 
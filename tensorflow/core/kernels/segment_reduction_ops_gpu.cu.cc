@@ -20,11 +20,13 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
 using GPUDevice = Eigen::GpuDevice;
+using functor::SegmentCombiner;
 
 // Helper for UnusortedSegmentSumCustomKernel that adds value into dest
 // atomically.
@@ -63,13 +65,13 @@ __global__ void UnsortedSegmentSumCustomKernel(
     const Index output_outer_dim_size, const Index* segment_ids, const T* input,
     T* output) {
   const Index input_total_size = input_outer_dim_size * inner_dim_size;
-  const Index output_total_size = output_outer_dim_size * inner_dim_size;
   CUDA_1D_KERNEL_LOOP(input_index, input_total_size) {
     const Index input_segment_index = input_index / inner_dim_size;
     const Index segment_offset = input_index % inner_dim_size;
     const Index output_segment_index = segment_ids[input_segment_index];
 
-    if (output_segment_index < 0 || output_segment_index >= output_total_size) {
+    if (output_segment_index < 0 ||
+        output_segment_index >= output_outer_dim_size) {
       continue;
     }
     const Index output_index =
@@ -78,6 +80,163 @@ __global__ void UnsortedSegmentSumCustomKernel(
   }
 }
 
+// Returns the first row in [0, num_rows) whose segment id is not less than
+// 'segment', or num_rows if there is none.
+template <typename Index>
+static __device__ __forceinline__ Index LowerBoundSegment(
+    const Index* segment_ids, Index num_rows, Index segment) {
+  Index lo = 0;
+  Index hi = num_rows;
+  while (lo < hi) {
+    const Index mid = lo + (hi - lo) / 2;
+    if (ldg(segment_ids + mid) < segment) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Sets output[segment, col] to the reduction of data[row, col] over the run of
+// rows with that segment id. One thread computes each output element, so the
+// rows of a segment are read in order without atomics.
+template <typename T, typename Index, typename Reduction>
+__global__ void SortedSegmentReductionKernel(const int32 output_size,
+                                             const int32 num_col,
+                                             const Index num_rows,
+                                             const Index* segment_ids,
+                                             const T* data, T* output) {
+  CUDA_1D_KERNEL_LOOP(output_index, output_size) {
+    const Index segment = output_index / num_col;
+    const int32 col = output_index % num_col;
+    Index row = LowerBoundSegment(segment_ids, num_rows, segment);
+    if (row == num_rows || ldg(segment_ids + row) != segment) {
+      output[output_index] = T(Reduction::kEmptyValue);
+      continue;
+    }
+    T acc = ldg(data + static_cast<int64>(row) * num_col + col);
+    const Index begin = row;
+    for (++row; row < num_rows && ldg(segment_ids + row) == segment; ++row) {
+      acc = Reduction::Combine(
+          acc, ldg(data + static_cast<int64>(row) * num_col + col));
+    }
+    output[output_index] = Reduction::Finalize(acc, row - begin);
+  }
+}
+
+// Adds weights[i] * data[indices[i], :] into output[segment_ids[i], :] for
+// each entry i. Entries with an invalid index or segment id are skipped.
+template <typename T, typename Index>
+__global__ void SparseSegmentWeightedSumKernel(
+    const int32 input_size, const int32 num_col, const Index num_rows,
+    const int32 num_segments, const Index* indices, const T* weights,
+    const int32* segment_ids, const T* data, T* output) {
+  CUDA_1D_KERNEL_LOOP(input_index, input_size) {
+    const int32 entry = input_index / num_col;
+    const int32 col = input_index % num_col;
+    const Index row = ldg(indices + entry);
+    const int32 segment = ldg(segment_ids + entry);
+    if (!FastBoundsCheck(row, num_rows) ||
+        !FastBoundsCheck(segment, num_segments)) {
+      continue;
+    }
+    AccumulateInto<T>(output + static_cast<int64>(segment) * num_col + col,
+                      ldg(weights + entry) *
+                          ldg(data + static_cast<int64>(row) * num_col + col));
+  }
+}
+
+// Accumulates the weight (kMean) or squared weight (kSqrtN) of each entry into
+// the denominator of its segment.
+template <typename T>
+__global__ void SegmentDenominatorKernel(const int32 num_indices,
+                                         const int32 num_segments,
+                                         const SegmentCombiner combiner,
+                                         const T* weights,
+                                         const int32* segment_ids, T* scale) {
+  CUDA_1D_KERNEL_LOOP(i, num_indices) {
+    const int32 segment = ldg(segment_ids + i);
+    if (!FastBoundsCheck(segment, num_segments)) {
+      continue;
+    }
+    const T weight = ldg(weights + i);
+    AccumulateInto<T>(scale + segment, combiner == SegmentCombiner::kMean
+                                           ? weight
+                                           : weight * weight);
+  }
+}
+
+// Replaces each denominator by the factor its segment is scaled by.
+template <typename T>
+__global__ void SegmentScaleKernel(const int32 num_segments,
+                                   const SegmentCombiner combiner, T* scale) {
+  CUDA_1D_KERNEL_LOOP(segment, num_segments) {
+    T denominator = scale[segment];
+    if (combiner == SegmentCombiner::kSqrtN) {
+      denominator = sqrt(denominator);
+    }
+    scale[segment] = denominator == T(0) ? T(1) : T(1) / denominator;
+  }
+}
+
+template <typename T>
+__global__ void ScaleSegmentsKernel(const int32 output_size,
+                                    const int32 num_col, const T* scale,
+                                    T* output) {
+  CUDA_1D_KERNEL_LOOP(output_index, output_size) {
+    output[output_index] *= ldg(scale + output_index / num_col);
+  }
+}
+
+// Sets output[i, :] to grad[segment_ids[i], :] * weights[i] * scale[segment].
+// 'scale' is null for the sum combiner.
+template <typename T>
+__global__ void SparseSegmentWeightedCombineGradKernel(
+    const int32 output_size, const int32 num_col, const int32 num_segments,
+    const T* weights, const int32* segment_ids, const T* scale, const T* grad,
+    T* output) {
+  CUDA_1D_KERNEL_LOOP(output_index, output_size) {
+    const int32 entry = output_index / num_col;
+    const int32 col = output_index % num_col;
+    const int32 segment = ldg(segment_ids + entry);
+    if (!FastBoundsCheck(segment, num_segments)) {
+      output[output_index] = T(0);
+      continue;
+    }
+    T factor = ldg(weights + entry);
+    if (scale != nullptr) {
+      factor *= ldg(scale + segment);
+    }
+    output[output_index] =
+        ldg(grad + static_cast<int64>(segment) * num_col + col) * factor;
+  }
+}
+
+// Fills 'scale' with the factor each segment is scaled by for the mean and
+// sqrtn combiners.
+template <typename T>
+static void ComputeSegmentScales(const GPUDevice& d, SegmentCombiner combiner,
+                                 int32 num_indices, const T* weights,
+                                 const int32* segment_ids,
+                                 typename TTypes<T>::Vec scale) {
+  const int32 num_segments = scale.size();
+  CudaLaunchConfig config = GetCudaLaunchConfig(num_segments, d);
+  SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      num_segments, scale.data());
+  if (num_indices > 0) {
+    config = GetCudaLaunchConfig(num_indices, d);
+    SegmentDenominatorKernel<
+        T><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        num_indices, num_segments, combiner, weights, segment_ids,
+        scale.data());
+  }
+  config = GetCudaLaunchConfig(num_segments, d);
+  SegmentScaleKernel<
+      T><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      num_segments, combiner, scale.data());
+}
+
 namespace functor {
 
 // UnsortedSegmentSumFunctor implementation for GPUDevice.
@@ -131,6 +290,126 @@ TF_CALL_complex128(DEFINE_GPU_SPECS);
 #undef DEFINE_GPU_SPECS
 #undef DEFINE_GPU_SPECS_INDEX
 
+// SortedSegmentReductionFunctor implementation for GPUDevice.
+template <typename T, typename Index, typename Reduction>
+struct SortedSegmentReductionFunctor<GPUDevice, T, Index, Reduction> {
+  void operator()(const GPUDevice& d,
+                  typename TTypes<Index>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstMatrix data,
+                  typename TTypes<T>::Matrix output) {
+    const int32 output_size = output.size();
+    if (output_size == 0) {
+      return;
+    }
+    CudaLaunchConfig config = GetCudaLaunchConfig(output_size, d);
+    SortedSegmentReductionKernel<
+        T, Index,
+        Reduction><<<config.block_count, config.thread_per_block, 0,
+                     d.stream()>>>(output_size, output.dimension(1),
+                                   segment_ids.size(), segment_ids.data(),
+                                   data.data(), output.data());
+  }
+};
+
+#define DEFINE_GPU_SPECS_INDEX(T, Index)                                 \
+  template struct SortedSegmentReductionFunctor<GPUDevice, T, Index,     \
+                                                SegmentSumReduction>;    \
+  template struct SortedSegmentReductionFunctor<GPUDevice, T, Index,     \
+                                                SegmentMeanReduction>;   \
+  template struct SortedSegmentReductionFunctor<GPUDevice, T, Index,     \
+                                                SegmentProdReduction>;   \
+  template struct SortedSegmentReductionFunctor<GPUDevice, T, Index,     \
+                                                SegmentMinReduction>;    \
+  template struct SortedSegmentReductionFunctor<GPUDevice, T, Index,     \
+                                                SegmentMaxReduction>
+
+#define DEFINE_GPU_SPECS(T)         \
+  DEFINE_GPU_SPECS_INDEX(T, int32); \
+  DEFINE_GPU_SPECS_INDEX(T, int64);
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPECS);
+
+#undef DEFINE_GPU_SPECS
+#undef DEFINE_GPU_SPECS_INDEX
+
+// SparseSegmentWeightedCombineFunctor implementation for GPUDevice. Segment
+// ids need not be sorted here since rows are accumulated atomically.
+template <typename T, typename Index>
+struct SparseSegmentWeightedCombineFunctor<GPUDevice, T, Index> {
+  int64 operator()(const GPUDevice& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix data,
+                   typename TTypes<Index>::ConstVec indices,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output) {
+    const int32 output_size = output.size();
+    const int32 num_col = output.dimension(1);
+    CudaLaunchConfig config = GetCudaLaunchConfig(output_size, d);
+    SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        output_size, output.data());
+    const int32 num_indices = indices.size();
+    if (num_indices == 0) {
+      return -1;
+    }
+
+    const int32 input_size = num_indices * num_col;
+    config = GetCudaLaunchConfig(input_size, d);
+    SparseSegmentWeightedSumKernel<
+        T,
+        Index><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        input_size, num_col, data.dimension(0), output.dimension(0),
+        indices.data(), weights.data(), segment_ids.data(), data.data(),
+        output.data());
+    if (combiner != SegmentCombiner::kSum) {
+      ComputeSegmentScales<T>(d, combiner, num_indices, weights.data(),
+                              segment_ids.data(), scale);
+      config = GetCudaLaunchConfig(output_size, d);
+      ScaleSegmentsKernel<
+          T><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          output_size, num_col, scale.data(), output.data());
+    }
+    return -1;
+  }
+};
+
+template <typename T>
+struct SparseSegmentWeightedCombineGradFunctor<GPUDevice, T> {
+  int64 operator()(const GPUDevice& d, SegmentCombiner combiner,
+                   typename TTypes<T>::ConstMatrix grad,
+                   typename TTypes<T>::ConstVec weights,
+                   typename TTypes<int32>::ConstVec segment_ids,
+                   typename TTypes<T>::Vec scale,
+                   typename TTypes<T>::Matrix output) {
+    const int32 num_indices = weights.size();
+    const T* scale_data = nullptr;
+    if (combiner != SegmentCombiner::kSum) {
+      ComputeSegmentScales<T>(d, combiner, num_indices, weights.data(),
+                              segment_ids.data(), scale);
+      scale_data = scale.data();
+    }
+    const int32 output_size = output.size();
+    CudaLaunchConfig config = GetCudaLaunchConfig(output_size, d);
+    SparseSegmentWeightedCombineGradKernel<
+        T><<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        output_size, output.dimension(1), grad.dimension(0), weights.data(),
+        segment_ids.data(), scale_data, grad.data(), output.data());
+    return -1;
+  }
+};
+
+#define DEFINE_GPU_SPECS(T)                                           \
+  template struct SparseSegmentWeightedCombineFunctor<GPUDevice, T,   \
+                                                      int32>;         \
+  template struct SparseSegmentWeightedCombineFunctor<GPUDevice, T,   \
+                                                      int64>;         \
+  template struct SparseSegmentWeightedCombineGradFunctor<GPUDevice, T>;
+
+TF_CALL_float(DEFINE_GPU_SPECS);
+TF_CALL_double(DEFINE_GPU_SPECS);
+
+#undef DEFINE_GPU_SPECS
+
 }  // namespace functor
 }  // namespace tensorflow
 
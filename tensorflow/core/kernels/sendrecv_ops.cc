@@ -16,10 +16,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/sendrecv_ops.h"
 
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -120,6 +122,22 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   // proactively cache the rendezvous key for the top-level.
   GetRendezvousKey(key_prefix_, {0, 0}, &parsed_key_.buf_);
   OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed_key_.buf_, &parsed_key_));
+  // Optionally, the compression to ask for if the tensor comes from another
+  // process; see RPCOptions.
+  string wire_compression;
+  if (GetNodeAttr(def(), "_wire_compression", &wire_compression).ok()) {
+    TensorCompressionOptions::Type type;
+    OP_REQUIRES(ctx, TensorCompressionOptions::Type_Parse(wire_compression,
+                                                          &type),
+                errors::InvalidArgument("Unknown _wire_compression: ",
+                                        wire_compression));
+    wire_compression_ = type;
+  }
+  // Optionally, how urgently the step needs the tensor; see
+  // PartitionOptions::record_recv_priorities.
+  if (!GetNodeAttr(def(), "_recv_priority", &priority_).ok()) {
+    priority_ = 0;
+  }
 }
 
 void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
@@ -130,6 +148,8 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   Rendezvous::Args args;
   args.device_context = ctx->op_device_context();
   args.alloc_attrs = ctx->output_alloc_attr(0);
+  args.wire_compression = wire_compression_;
+  args.priority = priority_;
   using namespace std::placeholders;
   Rendezvous::DoneCallback done_cb = std::bind(
       [ctx](DoneCallback done,
@@ -41,6 +41,8 @@ class RecvOp : public AsyncOpKernel {
  private:
   string key_prefix_;
   Rendezvous::ParsedKey parsed_key_;
+  int wire_compression_ = -1;
+  int64 priority_ = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
 };
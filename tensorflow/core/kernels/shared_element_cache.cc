@@ -0,0 +1,273 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/shared_element_cache.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+const char kEntrySuffix[] = ".element";
+const char kTemporaryInfix[] = ".tmp-";
+
+// Each record of an entry is framed by a length and two checksums.
+const int64 kRecordOverheadBytes = sizeof(uint64) + 2 * sizeof(uint32);
+
+// Temporary files that are this old were left behind by a writer that died.
+const int64 kStaleTemporaryFileNanos = 3600LL * 1000 * 1000 * 1000;
+
+}  // namespace
+
+SharedElementCache::SharedElementCache(Env* env, string directory,
+                                       int64 capacity_bytes,
+                                       int64 rescan_interval_micros)
+    : env_(env),
+      directory_(std::move(directory)),
+      capacity_bytes_(capacity_bytes),
+      rescan_interval_micros_(rescan_interval_micros) {}
+
+string SharedElementCache::EntryFilename(uint64 key) const {
+  return io::JoinPath(directory_,
+                      strings::StrCat(strings::FpToString(key), kEntrySuffix));
+}
+
+Status SharedElementCache::Lookup(uint64 key, std::vector<Tensor>* element,
+                                  bool* found) {
+  *found = false;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(MaybeInitializeLocked());
+  }
+
+  // Read the entry without holding mu_, so that lookups proceed in parallel.
+  const string filename = EntryFilename(key);
+  std::unique_ptr<RandomAccessFile> file;
+  Status s = env_->NewRandomAccessFile(filename, &file);
+  if (errors::IsNotFound(s)) {
+    mutex_lock l(mu_);
+    RemoveLocked(key);
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(s);
+
+  std::vector<Tensor> tensors;
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  while (true) {
+    s = reader.ReadRecord(&offset, &record);
+    if (!s.ok()) break;
+    TensorProto proto;
+    Tensor t;
+    if (!proto.ParseFromString(record) || !t.FromProto(proto)) {
+      s = errors::DataLoss("Could not parse a tensor in ", filename);
+      break;
+    }
+    tensors.push_back(std::move(t));
+  }
+
+  mutex_lock l(mu_);
+  if (errors::IsNotFound(s)) {
+    // The entry was evicted after we opened it.
+    RemoveLocked(key);
+    return Status::OK();
+  }
+  if (!errors::IsOutOfRange(s)) {
+    // A corrupted entry is treated as a miss, and replaced by the next
+    // insertion of the element.
+    LOG(WARNING) << "Ignoring cache entry " << filename << ": " << s;
+    return Status::OK();
+  }
+  TouchLocked(key, offset);
+  *element = std::move(tensors);
+  *found = true;
+  return Status::OK();
+}
+
+Status SharedElementCache::Insert(uint64 key,
+                                  const std::vector<Tensor>& element) {
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(MaybeInitializeLocked());
+  }
+
+  std::vector<string> records(element.size());
+  int64 size_bytes = 0;
+  for (size_t i = 0; i < element.size(); ++i) {
+    TensorProto proto;
+    element[i].AsProtoTensorContent(&proto);
+    proto.SerializeToString(&records[i]);
+    size_bytes += records[i].size() + kRecordOverheadBytes;
+  }
+  if (size_bytes > capacity_bytes_) {
+    return Status::OK();
+  }
+
+  // Write the entry under a unique temporary name, then rename it into place
+  // so that concurrent readers see either all of it or none of it.
+  const string filename = EntryFilename(key);
+  const string tmp_filename =
+      strings::StrCat(filename, kTemporaryInfix,
+                      strings::FpToString(random::New64()));
+  Status s;
+  {
+    std::unique_ptr<WritableFile> file;
+    s = env_->NewWritableFile(tmp_filename, &file);
+    if (s.ok()) {
+      io::RecordWriter writer(file.get());
+      for (const string& record : records) {
+        s = writer.WriteRecord(record);
+        if (!s.ok()) break;
+      }
+      if (s.ok()) s = writer.Close();
+      if (s.ok()) s = file->Close();
+    }
+  }
+  if (s.ok()) s = env_->RenameFile(tmp_filename, filename);
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_filename).IgnoreError();
+    return s;
+  }
+
+  mutex_lock l(mu_);
+  TouchLocked(key, size_bytes);
+  if (env_->NowMicros() - last_rescan_micros_ >=
+      static_cast<uint64>(rescan_interval_micros_)) {
+    TF_RETURN_IF_ERROR(RescanLocked());
+  }
+  EvictLocked();
+  return Status::OK();
+}
+
+int64 SharedElementCache::size_bytes() {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+Status SharedElementCache::MaybeInitializeLocked() {
+  if (initialized_) return Status::OK();
+  Status s = env_->RecursivelyCreateDir(directory_);
+  if (!s.ok() && !errors::IsAlreadyExists(s)) return s;
+  TF_RETURN_IF_ERROR(RescanLocked());
+  initialized_ = true;
+  return Status::OK();
+}
+
+Status SharedElementCache::RescanLocked() {
+  last_rescan_micros_ = env_->NowMicros();
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(directory_, &children));
+
+  struct NewEntry {
+    int64 mtime_nsec;
+    Entry entry;
+  };
+  std::vector<NewEntry> new_entries;
+  std::unordered_map<uint64, int64> sizes;
+  const int64 now_nsec = last_rescan_micros_ * 1000;
+  for (const string& child : children) {
+    const string path = io::JoinPath(directory_, child);
+    FileStatistics stat;
+    if (!env_->Stat(path, &stat).ok()) continue;  // Concurrently deleted.
+    if (child.find(kTemporaryInfix) != string::npos) {
+      if (now_nsec - stat.mtime_nsec > kStaleTemporaryFileNanos) {
+        env_->DeleteFile(path).IgnoreError();
+      }
+      continue;
+    }
+    StringPiece name(child);
+    uint64 key;
+    if (!name.ends_with(kEntrySuffix)) continue;
+    name.remove_suffix(sizeof(kEntrySuffix) - 1);
+    if (!strings::StringToFp(name.ToString(), &key)) continue;
+    sizes[key] = stat.length;
+    if (index_.find(key) == index_.end()) {
+      new_entries.push_back({stat.mtime_nsec, {key, stat.length}});
+    }
+  }
+
+  // Forget the entries that other processes have evicted, and refresh the
+  // sizes of those that they have replaced.
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto size = sizes.find(it->key);
+    if (size == sizes.end()) {
+      size_bytes_ -= it->size_bytes;
+      index_.erase(it->key);
+      it = entries_.erase(it);
+    } else {
+      size_bytes_ += size->second - it->size_bytes;
+      it->size_bytes = size->second;
+      ++it;
+    }
+  }
+
+  std::sort(new_entries.begin(), new_entries.end(),
+            [](const NewEntry& a, const NewEntry& b) {
+              return a.mtime_nsec > b.mtime_nsec;
+            });
+  for (const NewEntry& new_entry : new_entries) {
+    entries_.push_back(new_entry.entry);
+    index_[new_entry.entry.key] = std::prev(entries_.end());
+    size_bytes_ += new_entry.entry.size_bytes;
+  }
+  return Status::OK();
+}
+
+void SharedElementCache::TouchLocked(uint64 key, int64 size_bytes) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    size_bytes_ += size_bytes - it->second->size_bytes;
+    it->second->size_bytes = size_bytes;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  entries_.push_front({key, size_bytes});
+  index_[key] = entries_.begin();
+  size_bytes_ += size_bytes;
+}
+
+void SharedElementCache::RemoveLocked(uint64 key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) return;
+  size_bytes_ -= it->second->size_bytes;
+  entries_.erase(it->second);
+  index_.erase(it);
+}
+
+void SharedElementCache::EvictLocked() {
+  while (size_bytes_ > capacity_bytes_ && !entries_.empty()) {
+    const Entry& entry = entries_.back();
+    Status s = env_->DeleteFile(EntryFilename(entry.key));
+    if (!s.ok() && !errors::IsNotFound(s)) {
+      LOG(WARNING) << "Failed to evict cache entry: " << s;
+    }
+    size_bytes_ -= entry.size_bytes;
+    index_.erase(entry.key);
+    entries_.pop_back();
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_SHARED_ELEMENT_CACHE_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_SHARED_ELEMENT_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A size-bounded cache of dataset elements, keyed by 64-bit fingerprints and
+// stored as one file per element in a directory.
+//
+// The directory may be shared by several processes on the same host, e.g.
+// when it is on a local SSD or on a tmpfs such as /dev/shm. Entries are
+// written to a temporary file and then renamed into place, so readers never
+// observe a partially written entry, and any number of processes can read
+// the same entries concurrently.
+//
+// When an insertion takes the size of the directory over `capacity_bytes`,
+// the least recently used entries are deleted. Each cache only knows the
+// recency of its own lookups and insertions, and learns about the entries of
+// other processes by rescanning the directory on insertion, at most once
+// every `rescan_interval_micros`. The bound is therefore approximate when
+// several processes write at once, and an entry that was evicted by another
+// process is simply reported as a miss.
+//
+// This class is thread-safe.
+class SharedElementCache {
+ public:
+  SharedElementCache(Env* env, string directory, int64 capacity_bytes,
+                     int64 rescan_interval_micros = 10 * 1000 * 1000);
+
+  // Looks up the element with the given `key`. On a hit, sets `*found` to
+  // true and stores the element in `*element`; otherwise sets `*found` to
+  // false.
+  Status Lookup(uint64 key, std::vector<Tensor>* element, bool* found);
+
+  // Stores `element` under the given `key`, evicting the least recently used
+  // entries as needed. An element that is larger than the capacity of the
+  // cache is not stored.
+  Status Insert(uint64 key, const std::vector<Tensor>& element);
+
+  // Returns the total size of the entries known to this cache.
+  int64 size_bytes();
+
+ private:
+  struct Entry {
+    uint64 key;
+    int64 size_bytes;
+  };
+  typedef std::list<Entry> EntryList;
+
+  string EntryFilename(uint64 key) const;
+
+  // Creates the directory and reads the entries in it, if that has not yet
+  // been done.
+  Status MaybeInitializeLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Synchronizes entries_ with the files in the directory. Entries that are
+  // new to this cache are treated as less recently used than the others,
+  // in the order of their modification times.
+  Status RescanLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Moves the entry for `key` to the front of entries_, adding it if needed.
+  void TouchLocked(uint64 key, int64 size_bytes) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RemoveLocked(uint64 key) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Deletes the least recently used entries until the cache fits within its
+  // capacity.
+  void EvictLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const string directory_;
+  const int64 capacity_bytes_;
+  const int64 rescan_interval_micros_;
+
+  mutex mu_;
+  bool initialized_ GUARDED_BY(mu_) = false;
+  uint64 last_rescan_micros_ GUARDED_BY(mu_) = 0;
+  // Ordered from the most to the least recently used.
+  EntryList entries_ GUARDED_BY(mu_);
+  std::unordered_map<uint64, EntryList::iterator> index_ GUARDED_BY(mu_);
+  int64 size_bytes_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedElementCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_SHARED_ELEMENT_CACHE_H_
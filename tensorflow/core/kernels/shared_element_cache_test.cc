@@ -0,0 +1,163 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/shared_element_cache.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class SharedElementCacheTest : public ::testing::Test {
+ protected:
+  SharedElementCacheTest()
+      : env_(Env::Default()),
+        directory_(io::JoinPath(testing::TmpDir(),
+                                strings::StrCat("shared_element_cache_",
+                                                counter_++))) {}
+
+  // Returns an element whose serialized size is a little over 1KB.
+  static std::vector<Tensor> MakeElement(int64 i) {
+    Tensor values(DT_FLOAT, TensorShape({256}));
+    values.flat<float>().setConstant(i);
+    Tensor name(DT_STRING, TensorShape({}));
+    name.scalar<string>()() = strings::StrCat("element ", i);
+    return {values, name};
+  }
+
+  static void ExpectElement(int64 i, const std::vector<Tensor>& element) {
+    const std::vector<Tensor> expected = MakeElement(i);
+    ASSERT_EQ(expected.size(), element.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      if (expected[j].dtype() == DT_STRING) {
+        test::ExpectTensorEqual<string>(expected[j], element[j]);
+      } else {
+        test::ExpectTensorEqual<float>(expected[j], element[j]);
+      }
+    }
+  }
+
+  bool Contains(SharedElementCache* cache, uint64 key) {
+    std::vector<Tensor> element;
+    bool found;
+    TF_EXPECT_OK(cache->Lookup(key, &element, &found));
+    return found;
+  }
+
+  static int counter_;
+  Env* env_;
+  const string directory_;
+};
+
+int SharedElementCacheTest::counter_ = 0;
+
+TEST_F(SharedElementCacheTest, InsertAndLookup) {
+  SharedElementCache cache(env_, directory_, 1 << 20);
+  std::vector<Tensor> element;
+  bool found;
+  TF_ASSERT_OK(cache.Lookup(7, &element, &found));
+  EXPECT_FALSE(found);
+
+  TF_ASSERT_OK(cache.Insert(7, MakeElement(7)));
+  TF_ASSERT_OK(cache.Lookup(7, &element, &found));
+  EXPECT_TRUE(found);
+  ExpectElement(7, element);
+  EXPECT_FALSE(Contains(&cache, 8));
+  EXPECT_GT(cache.size_bytes(), 1024);
+}
+
+TEST_F(SharedElementCacheTest, EvictsLeastRecentlyUsed) {
+  // Room for three elements.
+  SharedElementCache cache(env_, directory_, 3500);
+  TF_ASSERT_OK(cache.Insert(0, MakeElement(0)));
+  TF_ASSERT_OK(cache.Insert(1, MakeElement(1)));
+  TF_ASSERT_OK(cache.Insert(2, MakeElement(2)));
+  EXPECT_TRUE(Contains(&cache, 0));
+
+  // Element 1 is now the least recently used.
+  TF_ASSERT_OK(cache.Insert(3, MakeElement(3)));
+  EXPECT_TRUE(Contains(&cache, 0));
+  EXPECT_FALSE(Contains(&cache, 1));
+  EXPECT_TRUE(Contains(&cache, 2));
+  EXPECT_TRUE(Contains(&cache, 3));
+  EXPECT_LE(cache.size_bytes(), 3500);
+
+  std::vector<string> children;
+  TF_ASSERT_OK(env_->GetChildren(directory_, &children));
+  EXPECT_EQ(3, children.size());
+}
+
+TEST_F(SharedElementCacheTest, ElementLargerThanCapacity) {
+  SharedElementCache cache(env_, directory_, 100);
+  TF_ASSERT_OK(cache.Insert(0, MakeElement(0)));
+  EXPECT_FALSE(Contains(&cache, 0));
+  EXPECT_EQ(0, cache.size_bytes());
+}
+
+TEST_F(SharedElementCacheTest, SharedDirectory) {
+  SharedElementCache writer(env_, directory_, 3500, 0);
+  TF_ASSERT_OK(writer.Insert(0, MakeElement(0)));
+  TF_ASSERT_OK(writer.Insert(1, MakeElement(1)));
+
+  // A second cache, as in another process, sees the existing entries.
+  SharedElementCache reader(env_, directory_, 3500, 0);
+  std::vector<Tensor> element;
+  bool found;
+  TF_ASSERT_OK(reader.Lookup(1, &element, &found));
+  EXPECT_TRUE(found);
+  ExpectElement(1, element);
+  EXPECT_EQ(writer.size_bytes(), reader.size_bytes());
+
+  // Its insertions evict the entries that it has used least recently.
+  TF_ASSERT_OK(reader.Insert(2, MakeElement(2)));
+  TF_ASSERT_OK(reader.Insert(3, MakeElement(3)));
+  EXPECT_FALSE(Contains(&reader, 0));
+  EXPECT_TRUE(Contains(&reader, 1));
+
+  // The other cache treats its evicted entries as misses, and learns about
+  // the new entries when it next rescans the directory.
+  EXPECT_FALSE(Contains(&writer, 0));
+  EXPECT_TRUE(Contains(&writer, 3));
+  TF_ASSERT_OK(writer.Insert(4, MakeElement(4)));
+  EXPECT_LE(writer.size_bytes(), 3500);
+  EXPECT_TRUE(Contains(&writer, 4));
+  std::vector<string> children;
+  TF_ASSERT_OK(env_->GetChildren(directory_, &children));
+  EXPECT_EQ(3, children.size());
+}
+
+TEST_F(SharedElementCacheTest, CorruptEntryIsAMiss) {
+  SharedElementCache cache(env_, directory_, 1 << 20);
+  TF_ASSERT_OK(cache.Insert(5, MakeElement(5)));
+  const string filename = io::JoinPath(
+      directory_, strings::StrCat(strings::FpToString(5), ".element"));
+  TF_ASSERT_OK(WriteStringToFile(env_, filename, "not an element"));
+  EXPECT_FALSE(Contains(&cache, 5));
+
+  TF_ASSERT_OK(cache.Insert(5, MakeElement(5)));
+  std::vector<Tensor> element;
+  bool found;
+  TF_ASSERT_OK(cache.Lookup(5, &element, &found));
+  EXPECT_TRUE(found);
+  ExpectElement(5, element);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -85,16 +85,16 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
       explicit Iterator(const Dataset* dataset)
           : DatasetIterator<Dataset>(dataset),
             input_impl_(dataset->input_->MakeIterator()),
+            seed_(dataset->seed_),
+            seed2_(dataset->seed2_),
             generator_(&parent_generator_) {
         buffer_.reserve(dataset->buffer_size_);
-        int64 seed = dataset->seed_;
-        int64 seed2 = dataset->seed2_;
-        if (seed == 0 && seed2 == 0) {
+        if (seed_ == 0 && seed2_ == 0) {
           // If both seeds are unspecified, use completely random seeds.
-          seed = random::New64();
-          seed2 = random::New64();
+          seed_ = random::New64();
+          seed2_ = random::New64();
         }
-        parent_generator_ = random::PhiloxRandom(seed, seed2);
+        ResetRngs();
       }
 
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
@@ -114,7 +114,7 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
           *end_of_sequence = false;
           // Choose an element to produce uniformly at random, and
           // swap the last element into its place in the buffer.
-          int64 index = generator_() % buffer_.size();
+          int64 index = Random() % buffer_.size();
           *out_tensors = std::move(buffer_[index]);
           std::swap(buffer_[index], buffer_.back());
           buffer_.pop_back();
@@ -125,14 +125,109 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // The random number generator is saved as its seeds and the number
+      // of samples drawn from it, and is restored by skipping ahead. The
+      // buffered elements cannot be recomputed without replaying the input
+      // up to the oldest of them, so they are saved as tensors.
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (end_of_input_sequence_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(prefix, "/end_of_input_sequence"), ""));
+        } else {
+          TF_RETURN_IF_ERROR(
+              input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        }
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/seed"), seed_));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/seed2"), seed2_));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/num_random_samples"),
+                                num_random_samples_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/buffer_size"),
+            static_cast<int64>(buffer_.size())));
+        for (size_t i = 0; i < buffer_.size(); ++i) {
+          for (size_t j = 0; j < buffer_[i].size(); ++j) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                strings::StrCat(prefix, "/buffer[", i, "][", j, "]"),
+                buffer_[i][j]));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        end_of_input_sequence_ =
+            reader->Contains(strings::StrCat(prefix, "/end_of_input_sequence"));
+        if (!end_of_input_sequence_) {
+          TF_RETURN_IF_ERROR(input_impl_->Restore(
+              ctx, strings::StrCat(prefix, "/input"), reader));
+        }
+        int64 num_random_samples;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(prefix, "/seed"), &seed_));
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(prefix, "/seed2"), &seed2_));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/num_random_samples"),
+            &num_random_samples));
+        ResetRngs();
+        generator_.Skip(num_random_samples);
+        num_random_samples_ = num_random_samples;
+
+        int64 buffer_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/buffer_size"), &buffer_size));
+        if (buffer_size < 0 || buffer_size > dataset()->buffer_size_) {
+          return errors::InvalidArgument("Saved buffer size ", buffer_size,
+                                         " is out of range for a buffer of ",
+                                         dataset()->buffer_size_,
+                                         " elements.");
+        }
+        const size_t num_components = dataset()->output_dtypes().size();
+        buffer_.clear();
+        buffer_.resize(buffer_size);
+        for (int64 i = 0; i < buffer_size; ++i) {
+          buffer_[i].resize(num_components);
+          for (size_t j = 0; j < num_components; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                strings::StrCat(prefix, "/buffer[", i, "][", j, "]"),
+                &buffer_[i][j]));
+          }
+        }
+        return Status::OK();
+      }
+
      private:
+      void ResetRngs() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+        generator_ = random::SingleSampleAdapter<random::PhiloxRandom>(
+            &parent_generator_);
+        num_random_samples_ = 0;
+      }
+
+      random::PhiloxRandom::ResultElementType Random()
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        ++num_random_samples_;
+        return generator_();
+      }
+
       mutex mu_;
       std::vector<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
       bool end_of_input_sequence_ GUARDED_BY(mu_) = false;
+      // The seeds actually used, which are random if both `dataset()->seed_`
+      // and `dataset()->seed2_` are zero.
+      int64 seed_ GUARDED_BY(mu_);
+      int64 seed2_ GUARDED_BY(mu_);
       random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
       random::SingleSampleAdapter<random::PhiloxRandom> generator_
           GUARDED_BY(mu_);
+      int64 num_random_samples_ GUARDED_BY(mu_) = 0;
     };
 
     const DatasetBase* const input_;
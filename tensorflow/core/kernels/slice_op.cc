@@ -26,6 +26,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -151,6 +152,24 @@ static void SharedSliceCommonCases(OpKernelContext* context,
     return;
   }
 
+  // Slices of an inner dimension, e.g. of a row of a matrix, are contiguous
+  // when the outer dimensions are taken with size 1, and can share the
+  // underlying buffer as well.
+  int64 offset;
+  int64 num_elements;
+  if (IsContiguousSliceAligned<T>(input.shape(), *begin, *size, &offset,
+                                  &num_elements)) {
+    VLOG(1) << "Slice contiguous: " << input.shape().DebugString();
+    Tensor input_flat;
+    CHECK(input_flat.CopyFrom(input, TensorShape({input.NumElements()})));
+    Tensor output;
+    CHECK(output.CopyFrom(input_flat.Slice(offset, offset + num_elements),
+                          *output_shape));
+    context->set_output(0, output);
+    *done = true;
+    return;
+  }
+
   OP_REQUIRES_OK(context, context->allocate_output(0, *output_shape, result));
 }
 
@@ -197,12 +216,12 @@ class SliceOp : public OpKernel {
   }
 
       HANDLE_DIM(1);
-      HANDLE_DIM(2);
-      HANDLE_DIM(3);
-      HANDLE_DIM(4);
-      HANDLE_DIM(5);
-      HANDLE_DIM(6);
-      HANDLE_DIM(7);
+      IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(2));
+      IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(3));
+      IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(4));
+      IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(5));
+      IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(6));
+      IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(7));
 
 #undef HANDLE_DIM
 
@@ -271,12 +290,12 @@ class MklSliceOp : public OpKernel {
   }
 
       HANDLE_DIM(1);
-      HANDLE_DIM(2);
-      HANDLE_DIM(3);
-      HANDLE_DIM(4);
-      HANDLE_DIM(5);
-      HANDLE_DIM(6);
-      HANDLE_DIM(7);
+      IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(2));
+      IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(3));
+      IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(4));
+      IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(5));
+      IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(6));
+      IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(7));
 
 #undef HANDLE_DIM
 
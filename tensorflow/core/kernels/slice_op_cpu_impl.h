@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/kernels/slice_op.h"
 
 namespace tensorflow {
@@ -29,8 +30,10 @@ using CpuDevice = Eigen::ThreadPoolDevice;
 #define DEFINE_CPU_KERNELS(T) \
   template struct functor::Slice<CpuDevice, T, CPU_PROVIDED_IXDIM>;
 
+#if CPU_PROVIDED_IXDIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_ALL_TYPES(DEFINE_CPU_KERNELS);
 DEFINE_CPU_KERNELS(bfloat16);
+#endif
 
 #undef DEFINE_CPU_KERNELS
 
@@ -40,8 +43,10 @@ using SyclDevice = Eigen::SyclDevice;
 #define DEFINE_SYCL_KERNELS(T) \
   template struct functor::Slice<SyclDevice, T, CPU_PROVIDED_IXDIM>;
 
+#if CPU_PROVIDED_IXDIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_GPU_NUMBER_TYPES(DEFINE_SYCL_KERNELS);
 DEFINE_SYCL_KERNELS(int32);
+#endif
 
 #undef DEFINE_SYCL_KERNELS
 #endif // TENSORFLOW_USE_SYCL
@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 #define TENSORFLOW_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/kernels/typed_conditional_accumulator_base.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -42,6 +46,14 @@ namespace tensorflow {
  * SparseConditionalAccumulator is the datatype-dependent templated sub-class of
  * ConditionalAccumulatorBase. It implements the virtual arithmetic methods that
  * are used by for aggregating, averaging, allocating, returning indexed slices.
+ *
+ * With defer_aggregation, TryApplyGrad only keeps a reference to the gradient,
+ * so that many workers applying gradients hold the accumulator lock for O(1)
+ * each. The kept gradients are summed when the average is taken: their rows
+ * are sorted by index, and each run of rows with the same index is summed in
+ * parallel on the CPU worker threads. The rows of an index are summed in the
+ * order they were applied, so the result is the same as without deferral.
+ * The indices of a gradient need not be sorted or unique in this mode.
  */
 template <typename Device, typename T>
 class SparseConditionalAccumulator
@@ -50,10 +62,12 @@ class SparseConditionalAccumulator
  public:
   SparseConditionalAccumulator(const DataType& dtype,
                                const PartialTensorShape& shape,
-                               const string& name)
+                               const string& name,
+                               bool defer_aggregation = false)
       : TypedConditionalAccumulatorBase<
             std::tuple<const Tensor*, const Tensor*, const Tensor*>>(
-            dtype, shape, name) {
+            dtype, shape, name),
+        defer_aggregation_(defer_aggregation) {
     accum_idx_vec_ = nullptr;
     count_element_ = nullptr;
     accum_val_ = nullptr;
@@ -74,6 +88,11 @@ class SparseConditionalAccumulator
   Tensor* accum_val_ = nullptr;
   PersistentTensor* accum_val_persistent_ = nullptr;
 
+  // With defer_aggregation_, the (indices, values) of the gradients applied
+  // since the last TakeGrad, which are only summed by TakeGrad.
+  const bool defer_aggregation_;
+  std::vector<std::pair<Tensor, Tensor>> pending_grads_;
+
   typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
                            Eigen::Unaligned>
       SliceT;
@@ -122,15 +141,17 @@ class SparseConditionalAccumulator
 
     // Check values compatibility with accumulated gradient if available
     if (counter_ > 0) {
-      int64 accum_val_dims = accum_val_->dims();
+      const Tensor* accum_val =
+          defer_aggregation_ ? &pending_grads_.front().second : accum_val_;
+      int64 accum_val_dims = accum_val->dims();
       if (accum_val_dims != grad_val_dims) {
         return errors::InvalidArgument("Shape mismatch: expected values rank ",
                                        accum_val_dims, ", got ", grad_val_dims);
       }
       for (int64 i = 1; i < accum_val_dims; i++) {
-        if (accum_val_->dim_size(i) != tensor_val->dim_size(i)) {
+        if (accum_val->dim_size(i) != tensor_val->dim_size(i)) {
           return errors::InvalidArgument("Shape mismatch: expected values dim ",
-                                         i, " to be ", accum_val_->dim_size(i),
+                                         i, " to be ", accum_val->dim_size(i),
                                          ", got ", tensor_val->dim_size(i));
         }
       }
@@ -161,6 +182,12 @@ class SparseConditionalAccumulator
     const Tensor* grad_idx = std::get<0>(*grad);
     const Tensor* grad_val = std::get<1>(*grad);
 
+    if (defer_aggregation_) {
+      pending_grads_.clear();
+      pending_grads_.emplace_back(*grad_idx, *grad_val);
+      return;
+    }
+
     const int64 nnz = grad_idx->dim_size(0);
 
     // Assign indices
@@ -197,6 +224,11 @@ class SparseConditionalAccumulator
     const Tensor* grad_idx = std::get<0>(*grad);
     const Tensor* grad_val = std::get<1>(*grad);
 
+    if (defer_aggregation_) {
+      pending_grads_.emplace_back(*grad_idx, *grad_val);
+      return;
+    }
+
     const int64 accum_nnz = accum_idx_vec_->size();
     const int64 grad_nnz = grad_idx->dim_size(0);
 
@@ -320,6 +352,11 @@ class SparseConditionalAccumulator
 
   void DivideAccumGradByCounter(OpKernelContext* ctx) override
       EXCLUSIVE_LOCKS_REQUIRED(this->mu_) {
+    if (defer_aggregation_) {
+      // The sum is averaged as it is computed.
+      OP_REQUIRES_OK(ctx, SumPendingGrads(ctx));
+      return;
+    }
     const int64 nnz = count_element_->size();
     auto accum_flat = accum_val_->flat_outer_dims<T>();
     std::vector<T> count_typet;
@@ -346,10 +383,14 @@ class SparseConditionalAccumulator
   }
 
   bool SetOutput(OpKernelContext* ctx) override {
+    // SumPendingGrads failed.
+    if (!ctx->status().ok()) return false;
     bool is_successful = true;
     if (is_successful) is_successful = ReturnIdxTensor(ctx);
     if (is_successful) is_successful = ReturnValTensor(ctx);
     if (is_successful) is_successful = ReturnShapeTensor(ctx);
+    // The output holds the sum, so the pending gradients can be dropped.
+    if (is_successful && defer_aggregation_) pending_grads_.clear();
     return is_successful;
   }
 
@@ -407,6 +448,124 @@ class SparseConditionalAccumulator
   }
 
  private:
+  // A row of a pending gradient.
+  struct PendingRow {
+    int64 index;
+    int grad;
+    int64 row;
+  };
+
+  static bool IndexLess(const PendingRow& a, const PendingRow& b) {
+    return a.index < b.index;
+  }
+
+  // Sums the rows of pending_grads_ by index into accum_idx_vec_,
+  // count_element_ and accum_val_, and divides each sum by its count.
+  Status SumPendingGrads(OpKernelContext* ctx)
+      EXCLUSIVE_LOCKS_REQUIRED(this->mu_) {
+    const int num_grads = pending_grads_.size();
+    std::vector<int64> offsets(num_grads + 1, 0);
+    for (int g = 0; g < num_grads; ++g) {
+      offsets[g + 1] = offsets[g] + pending_grads_[g].first.dim_size(0);
+    }
+    const int64 total_rows = offsets[num_grads];
+    const Tensor& first_val = pending_grads_.front().second;
+    int64 num_col = 1;
+    for (int d = 1; d < first_val.dims(); ++d) num_col *= first_val.dim_size(d);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+
+    // (1) List the rows of each gradient sorted by index. The rows of a
+    // gradient with equal indices keep their order.
+    std::vector<PendingRow> rows(total_rows);
+    std::vector<PendingRow> merged(total_rows);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_grads,
+          std::max<int64>(total_rows / num_grads, 1) * 10,
+          [this, &offsets, &rows](int64 begin, int64 end) {
+            for (int64 g = begin; g < end; ++g) {
+              const auto grad_idx = pending_grads_[g].first.vec<int64>();
+              PendingRow* grad_rows = &rows[offsets[g]];
+              const int64 nnz = offsets[g + 1] - offsets[g];
+              for (int64 r = 0; r < nnz; ++r) {
+                grad_rows[r] = {grad_idx(r), static_cast<int>(g), r};
+              }
+              if (!std::is_sorted(grad_rows, grad_rows + nnz, IndexLess)) {
+                std::stable_sort(grad_rows, grad_rows + nnz, IndexLess);
+              }
+            }
+          });
+
+    // (2) Merge the sorted runs of the gradients pairwise, in parallel. On
+    // equal indices std::merge takes the rows of the first run first, so the
+    // rows of an index stay in the order their gradients were applied.
+    for (int width = 1; width < num_grads; width *= 2) {
+      const int64 num_merges = (num_grads + 2 * width - 1) / (2 * width);
+      Shard(worker_threads.num_threads, worker_threads.workers, num_merges,
+            std::max<int64>(total_rows / num_merges, 1) * 5,
+            [width, num_grads, &offsets, &rows, &merged](int64 begin,
+                                                         int64 end) {
+              for (int64 m = begin; m < end; ++m) {
+                const int lo = 2 * width * m;
+                const int mid = std::min(lo + width, num_grads);
+                const int hi = std::min(lo + 2 * width, num_grads);
+                std::merge(rows.begin() + offsets[lo],
+                           rows.begin() + offsets[mid],
+                           rows.begin() + offsets[mid],
+                           rows.begin() + offsets[hi],
+                           merged.begin() + offsets[lo], IndexLess);
+              }
+            });
+      rows.swap(merged);
+    }
+
+    // (3) Find the run of rows of each index.
+    std::vector<int64> run_starts;
+    for (int64 i = 0; i < total_rows; ++i) {
+      if (i == 0 || rows[i].index != rows[i - 1].index) run_starts.push_back(i);
+    }
+    const int64 nnz = run_starts.size();
+    run_starts.push_back(total_rows);
+
+    TensorShape sum_shape = first_val.shape();
+    sum_shape.set_dim(0, nnz);
+    TF_RETURN_IF_ERROR(ctx->allocate_persistent(
+        dtype_, sum_shape, accum_val_persistent_, &accum_val_));
+    if (accum_idx_vec_ != nullptr) delete accum_idx_vec_;
+    accum_idx_vec_ = new std::vector<int64>(nnz);
+    if (count_element_ != nullptr) delete count_element_;
+    count_element_ = new std::vector<int>(nnz);
+
+    // (4) Sum and average each run.
+    auto sum_flat = accum_val_->flat_outer_dims<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers, nnz,
+          std::max<int64>(total_rows / std::max<int64>(nnz, 1), 1) * num_col,
+          [this, num_col, &rows, &run_starts, &sum_flat](int64 begin,
+                                                          int64 end) {
+            for (int64 s = begin; s < end; ++s) {
+              const int64 run_begin = run_starts[s];
+              const int64 run_end = run_starts[s + 1];
+              (*accum_idx_vec_)[s] = rows[run_begin].index;
+              (*count_element_)[s] = run_end - run_begin;
+              T* sum = sum_flat.data() + s * num_col;
+              for (int64 i = run_begin; i < run_end; ++i) {
+                const Tensor& grad_val = pending_grads_[rows[i].grad].second;
+                const T* val =
+                    grad_val.template flat<T>().data() + rows[i].row * num_col;
+                if (i == run_begin) {
+                  std::copy(val, val + num_col, sum);
+                } else {
+                  for (int64 c = 0; c < num_col; ++c) sum[c] = val[c] + sum[c];
+                }
+              }
+              const T count =
+                  TypeConverter<T, int>::ConvertUToT(run_end - run_begin);
+              for (int64 c = 0; c < num_col; ++c) sum[c] = sum[c] / count;
+            }
+          });
+
+    return Status::OK();
+  }
+
   inline int cmp(std::vector<int64>* a_idx, const Tensor* b_idx,
                  const int64 a_row, const int64 b_row) {
     const int64 a = a_idx->at(a_row);
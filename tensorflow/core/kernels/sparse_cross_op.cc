@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -204,7 +205,68 @@ class HashCrosser {
       uint64 hash_i = columns_[i]->Feature(batch_index, permutation[i]);
       hashed_output = FingerprintCat64(hashed_output, hash_i);
     }
-    // The return value is int64 based on the number of buckets.
+    return Bucketize(hashed_output);
+  }
+
+  // Generates all the crosses of the example "batch_index", in the order of
+  // ProductIterator, with the same values as Generate(). The features of each
+  // column are fingerprinted once, and the hashes of the prefixes of the
+  // current permutation are kept, so that a cross costs one
+  // FingerprintCat64 instead of one per column. The crosses that only differ
+  // in the last column are hashed in a loop over its features.
+  void GenerateAll(const int64 batch_index,
+                   const OutputUpdater<int64>& updater) const {
+    const int num_columns = columns_.size();
+    if (num_columns == 0) {
+      updater.Update(batch_index, 0, Bucketize(hash_key_));
+      return;
+    }
+    gtl::InlinedVector<gtl::InlinedVector<uint64, 8>, 6> features(
+        num_columns);
+    for (int i = 0; i < num_columns; ++i) {
+      const int64 count = columns_[i]->FeatureCount(batch_index);
+      if (count == 0) return;
+      features[i].resize(count);
+      for (int64 n = 0; n < count; ++n) {
+        features[i][n] = columns_[i]->Feature(batch_index, n);
+      }
+    }
+
+    // prefix_hashes[i] is the hash of the features of the columns before i.
+    gtl::InlinedVector<uint64, 6> prefix_hashes(num_columns);
+    gtl::InlinedVector<int64, 6> permutation(num_columns, 0);
+    prefix_hashes[0] = hash_key_;
+    for (int i = 1; i < num_columns; ++i) {
+      prefix_hashes[i] = FingerprintCat64(prefix_hashes[i - 1],
+                                          features[i - 1][0]);
+    }
+    const gtl::InlinedVector<uint64, 8>& last_features =
+        features[num_columns - 1];
+    int64 cross_count = 0;
+    while (true) {
+      const uint64 prefix_hash = prefix_hashes[num_columns - 1];
+      for (const uint64 feature : last_features) {
+        updater.Update(batch_index, cross_count++,
+                       Bucketize(FingerprintCat64(prefix_hash, feature)));
+      }
+      // Advance the other columns, the one before last first.
+      int i = num_columns - 2;
+      while (i >= 0 &&
+             ++permutation[i] == static_cast<int64>(features[i].size())) {
+        permutation[i] = 0;
+        --i;
+      }
+      if (i < 0) break;
+      for (int j = i; j < num_columns - 1; ++j) {
+        prefix_hashes[j + 1] =
+            FingerprintCat64(prefix_hashes[j], features[j][permutation[j]]);
+      }
+    }
+  }
+
+ private:
+  // The return value is int64 based on the number of buckets.
+  int64 Bucketize(const uint64 hashed_output) const {
     if (num_buckets_ > 0) {
       return hashed_output % num_buckets_;
     } else {
@@ -213,7 +275,6 @@ class HashCrosser {
     }
   }
 
- private:
   const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns_;
   const int64 num_buckets_;
   const uint64 hash_key_;
@@ -268,6 +329,28 @@ class ProductIterator {
   std::vector<int> next_permutation_;
 };
 
+// Generates the crosses of the example "batch_index" with "crosser".
+template <typename InternalType, typename Crosser, typename Updater>
+void GenerateCrosses(
+    const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns,
+    const Crosser& crosser, const Updater& updater, int64 batch_index) {
+  ProductIterator<InternalType> product_iterator(columns, batch_index);
+  int64 cross_count = 0;
+  while (product_iterator.HasNext()) {
+    const auto permutation = product_iterator.Next();
+    updater.Update(batch_index, cross_count,
+                   crosser.Generate(batch_index, permutation));
+    cross_count++;
+  }
+}
+
+void GenerateCrosses(
+    const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns,
+    const HashCrosser& crosser, const OutputUpdater<int64>& updater,
+    int64 batch_index) {
+  crosser.GenerateAll(batch_index, updater);
+}
+
 template <bool HASHED_OUTPUT, typename InternalType>
 struct CrossTraits;
 
@@ -329,13 +412,7 @@ class SparseCrossOp : public OpKernel {
         updater(output_start_indices, indices_out, values_out);
     auto do_work = [this, &columns, crosser, updater](int64 begin, int64 end) {
       for (int b = begin; b < end; b++) {
-        ProductIterator<InternalType> product_iterator(columns, b);
-        int64 cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count, crosser.Generate(b, permutation));
-          cross_count++;
-        }
+        GenerateCrosses(columns, crosser, updater, b);
       }
     };
 
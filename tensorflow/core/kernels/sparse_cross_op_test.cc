@@ -0,0 +1,78 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+// Crosses 'num_columns' dense columns of 'batch_size' rows, each row holding
+// 'features' int64 or string features, into hashed int64 outputs.
+static Graph* SparseCross(int batch_size, int num_columns, int features,
+                          DataType dtype) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> dense;
+  for (int c = 0; c < num_columns; ++c) {
+    Tensor t(dtype, TensorShape({batch_size, features}));
+    for (int64 i = 0; i < t.NumElements(); ++i) {
+      if (dtype == DT_INT64) {
+        t.flat<int64>()(i) = i * (c + 1);
+      } else {
+        t.flat<string>()(i) = strings::StrCat("feature_", c, "_", i);
+      }
+    }
+    dense.emplace_back(test::graph::Constant(g, t));
+  }
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseCross")
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(dense)
+                  .Attr("N", 0)
+                  .Attr("hashed_output", true)
+                  .Attr("num_buckets", 1 << 20)
+                  .Attr("hash_key", 0xDECAFCAFFE)
+                  .Attr("sparse_types", DataTypeVector())
+                  .Attr("dense_types", DataTypeVector(num_columns, dtype))
+                  .Attr("out_type", DT_INT64)
+                  .Attr("internal_type", dtype)
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+#define BM_SparseCrossDev(BATCH, COLUMNS, FEATURES, TYPE)                    \
+  static void BM_SparseCross_##BATCH##_##COLUMNS##_##FEATURES##_##TYPE(      \
+      int iters) {                                                           \
+    int64 crosses = BATCH;                                                   \
+    for (int c = 0; c < COLUMNS; ++c) crosses *= FEATURES;                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * crosses);            \
+    test::Benchmark("cpu", SparseCross(BATCH, COLUMNS, FEATURES, DT_##TYPE)) \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(BM_SparseCross_##BATCH##_##COLUMNS##_##FEATURES##_##TYPE);
+
+BM_SparseCrossDev(1024, 2, 8, INT64);
+BM_SparseCrossDev(1024, 3, 8, INT64);
+BM_SparseCrossDev(8192, 2, 4, INT64);
+BM_SparseCrossDev(1024, 2, 8, STRING);
+BM_SparseCrossDev(1024, 3, 8, STRING);
+
+}  // end namespace tensorflow
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/util/cuda_kernel_helper.h"
@@ -60,6 +62,135 @@ __global__ void SparseTensorDenseMatMulKernel(int nnz, int m, int b_rows,
   }
 }
 
+// The kernels below implement the CSR path: the entries of A are bucketed by
+// output row with a counting sort, and each block then multiplies an equal
+// share of the sorted entries. Rows with many entries are thus spread over
+// several blocks, and only the rows cut by a block boundary need atomics.
+
+// The number of entries of A that each block of the CSR kernel multiplies.
+constexpr int kCsrEntriesPerBlock = 64;
+// The number of threads of the single block that scans the row counts.
+constexpr int kScanThreads = 512;
+// The CSR path is used when A has at least this many entries, and at least
+// kCsrMinEntriesPerRow entries per output row on average. Below that, the
+// atomic updates of the COO kernel rarely collide and the sort is overhead.
+constexpr int kCsrMinNnz = 4096;
+constexpr int kCsrMinEntriesPerRow = 4;
+
+// Counts the entries of each output row of A in row_counts[0, m), and the
+// entries with an invalid row in row_counts[m].
+template <typename Tindices, bool ADJ_A>
+__global__ void CountRowEntriesKernel(int nnz, int m,
+                                      const Tindices* a_indices,
+                                      int* row_counts) {
+  CUDA_1D_KERNEL_LOOP(a_ix, nnz) {
+    const Tindices i = ldg(a_indices + 2 * a_ix + ((ADJ_A) ? 1 : 0));
+    atomicAdd(row_counts + (FastBoundsCheck(i, m) ? i : m), 1);
+  }
+}
+
+// Replaces values[0, n) with their exclusive prefix sums. Must be launched
+// with a single block of kScanThreads threads.
+__global__ void ExclusiveScanKernel(int n, int* values) {
+  __shared__ int partial_sums[kScanThreads];
+  const int chunk = (n + blockDim.x - 1) / blockDim.x;
+  const int begin = min(n, static_cast<int>(threadIdx.x) * chunk);
+  const int end = min(n, begin + chunk);
+  int sum = 0;
+  for (int i = begin; i < end; ++i) {
+    sum += values[i];
+  }
+  partial_sums[threadIdx.x] = sum;
+  __syncthreads();
+  for (int offset = 1; offset < blockDim.x; offset *= 2) {
+    const int addend = static_cast<int>(threadIdx.x) >= offset
+                           ? partial_sums[threadIdx.x - offset]
+                           : 0;
+    __syncthreads();
+    partial_sums[threadIdx.x] += addend;
+    __syncthreads();
+  }
+  int prefix = partial_sums[threadIdx.x] - sum;
+  for (int i = begin; i < end; ++i) {
+    const int count = values[i];
+    values[i] = prefix;
+    prefix += count;
+  }
+}
+
+// Scatters the entries of A to their position in row order, given the offset
+// of each row in row_offsets, which are advanced past the placed entries. An
+// out of bounds column is stored as -1.
+template <typename T, typename Tindices, bool ADJ_A>
+__global__ void ScatterToCsrKernel(int nnz, int m, int n,
+                                   const Tindices* a_indices,
+                                   const T* a_values, int* row_offsets,
+                                   int* rows, int* cols, T* values) {
+  CUDA_1D_KERNEL_LOOP(a_ix, nnz) {
+    const Tindices i = ldg(a_indices + 2 * a_ix + ((ADJ_A) ? 1 : 0));
+    const Tindices k = ldg(a_indices + 2 * a_ix + ((ADJ_A) ? 0 : 1));
+    const int row = FastBoundsCheck(i, m) ? i : m;
+    const int pos = atomicAdd(row_offsets + row, 1);
+    rows[pos] = row;
+    cols[pos] = FastBoundsCheck(k, n) ? k : -1;
+    values[pos] = ldg(a_values + a_ix);
+  }
+}
+
+// Adds the sum of one run of entries of a row to out. A run that touches the
+// boundary of its block may share its row with another block.
+template <typename T>
+__device__ EIGEN_ALWAYS_INLINE void AddCsrRun(bool shared, T sum,
+                                              T* out_location) {
+  if (shared) {
+    CudaAtomicAdd(out_location, sum);
+  } else {
+    *out_location = sum;
+  }
+}
+
+// Block (x, y) computes columns [y * blockDim.x, (y + 1) * blockDim.x) of
+// the products of the x-th kCsrEntriesPerBlock sorted entries of A.
+template <typename T, bool ADJ_B>
+__global__ void CsrSparseTensorDenseMatMulKernel(int nnz, int m, int b_cols,
+                                                 int p, const int* rows,
+                                                 const int* cols,
+                                                 const T* values, const T* b,
+                                                 T* out) {
+  const int j = blockIdx.y * blockDim.x + threadIdx.x;
+  if (j >= p) {
+    return;
+  }
+  const int begin = blockIdx.x * kCsrEntriesPerBlock;
+  const int end = min(nnz, begin + kCsrEntriesPerBlock);
+  int row = ldg(rows + begin);
+  int run_begin = begin;
+  T sum = T(0);
+  for (int e = begin; e < end; ++e) {
+    const int next_row = ldg(rows + e);
+    if (next_row != row) {
+      if (row < m) {
+        AddCsrRun(run_begin == begin && begin > 0, sum, out + row * p + j);
+      }
+      row = next_row;
+      run_begin = e;
+      sum = T(0);
+    }
+    const int k = ldg(cols + e);
+    if (k < 0) {
+      sum += std::numeric_limits<T>::quiet_NaN();
+      continue;
+    }
+    // b_value == (ADJ_B) ? b[j, k] : b[k, j]
+    sum += ldg(values + e) *
+           ldg(b + ((ADJ_B) ? j * b_cols + k : k * b_cols + j));
+  }
+  if (row < m) {
+    AddCsrRun((run_begin == begin && begin > 0) || end < nnz, sum,
+              out + row * p + j);
+  }
+}
+
 namespace functor {
 
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
@@ -77,6 +208,15 @@ struct SparseTensorDenseMatMulFunctor<GPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     int b_rows = b.dimension(0);
     int b_cols = b.dimension(1);
 
+    const int threads_per_block = std::min(256, (p + 31) / 32 * 32);
+    const int column_blocks = (p + threads_per_block - 1) / threads_per_block;
+    if (nnz >= kCsrMinNnz &&
+        nnz / kCsrMinEntriesPerRow >= m && column_blocks <= 65535) {
+      ComputeCsr(d, out, a_indices, a_values, b, threads_per_block,
+                 column_blocks);
+      return Status::OK();
+    }
+
     // TODO(ebrevdo): Should this be alpha * nnz instead of
     // out.size()?  Perhaps p * nnz ?
     CudaLaunchConfig config = GetCudaLaunchConfig(p * nnz, d);
@@ -88,6 +228,53 @@ struct SparseTensorDenseMatMulFunctor<GPUDevice, T, Tindices, ADJ_A, ADJ_B> {
 
     return Status::OK();
   }
+
+ private:
+  // Computes out = A * B through a CSR copy of A; out must be zeroed.
+  static void ComputeCsr(const GPUDevice& d, typename TTypes<T>::Matrix out,
+                         typename TTypes<Tindices>::ConstMatrix a_indices,
+                         typename TTypes<T>::ConstVec a_values,
+                         typename TTypes<T>::ConstMatrix b,
+                         int threads_per_block, int column_blocks) {
+    const int nnz = a_values.size();
+    const int m = out.dimension(0);
+    const int p = out.dimension(1);
+    const int b_rows = b.dimension(0);
+    const int b_cols = b.dimension(1);
+    const int n = (ADJ_B) ? b_cols : b_rows;
+
+    // The row offsets have an extra bucket for the entries of invalid rows,
+    // which sort last and are skipped.
+    int* row_offsets =
+        static_cast<int*>(d.allocate(sizeof(int) * (m + 1)));
+    int* rows = static_cast<int*>(d.allocate(sizeof(int) * nnz));
+    int* cols = static_cast<int*>(d.allocate(sizeof(int) * nnz));
+    T* values = static_cast<T*>(d.allocate(sizeof(T) * nnz));
+    d.memset(row_offsets, 0, sizeof(int) * (m + 1));
+
+    CudaLaunchConfig config = GetCudaLaunchConfig(nnz, d);
+    CountRowEntriesKernel<Tindices, ADJ_A>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            nnz, m, a_indices.data(), row_offsets);
+    ExclusiveScanKernel<<<1, kScanThreads, 0, d.stream()>>>(m + 1,
+                                                            row_offsets);
+    ScatterToCsrKernel<T, Tindices, ADJ_A>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            nnz, m, n, a_indices.data(), a_values.data(), row_offsets, rows,
+            cols, values);
+
+    const dim3 blocks((nnz + kCsrEntriesPerBlock - 1) / kCsrEntriesPerBlock,
+                      column_blocks);
+    CsrSparseTensorDenseMatMulKernel<T, ADJ_B>
+        <<<blocks, threads_per_block, 0, d.stream()>>>(
+            nnz, m, b_cols, p, rows, cols, values, b.data(), out.data());
+
+    // Safe to deallocate immediately after the kernel launches.
+    d.deallocate(row_offsets);
+    d.deallocate(rows);
+    d.deallocate(cols);
+    d.deallocate(values);
+  }
 };
 
 }  // namespace functor
@@ -15,13 +15,20 @@ limitations under the License.
 
 // See docs in ../ops/audio_ops.cc
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/spectrogram.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -118,4 +125,161 @@ class AudioSpectrogramOp : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("AudioSpectrogram").Device(DEVICE_CPU),
                         AudioSpectrogramOp);
 
+// The state of a StreamingAudioSpectrogram op: a Spectrogram per channel,
+// which keeps the samples of the window that overlaps the next chunk, and the
+// working area of its FFT.
+class StreamingSpectrogramState : public ResourceBase {
+ public:
+  StreamingSpectrogramState(int32 window_size, int32 stride)
+      : window_size_(window_size), stride_(stride) {}
+
+  string DebugString() override {
+    return strings::StrCat("StreamingSpectrogramState(", window_size_, ", ",
+                           stride_, ")");
+  }
+
+  // Returns the spectrograms of the 'channel_count' channels, which are
+  // created by the first call.
+  Status GetChannels(int64 channel_count,
+                     std::vector<std::unique_ptr<Spectrogram>>** channels)
+      EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    if (channels_.empty()) {
+      for (int64 channel = 0; channel < channel_count; ++channel) {
+        std::unique_ptr<Spectrogram> spectrogram(new Spectrogram);
+        if (!spectrogram->Initialize(window_size_, stride_)) {
+          channels_.clear();
+          return errors::InvalidArgument(
+              "Spectrogram initialization failed for window size ",
+              window_size_, " and stride ", stride_);
+        }
+        channels_.push_back(std::move(spectrogram));
+      }
+    } else if (static_cast<int64>(channels_.size()) != channel_count) {
+      return errors::InvalidArgument("Expected ", channels_.size(),
+                                     " channels, as in the previous chunks, ",
+                                     "but got ", channel_count);
+    }
+    *channels = &channels_;
+    return Status::OK();
+  }
+
+  mutex mu;
+
+ private:
+  const int32 window_size_;
+  const int32 stride_;
+  std::vector<std::unique_ptr<Spectrogram>> channels_ GUARDED_BY(mu);
+};
+
+// Creates the spectrogram of a stream of audio, one chunk at a time. Each
+// call outputs only the frames that the samples of its chunk complete.
+class StreamingAudioSpectrogramOp : public OpKernel {
+ public:
+  explicit StreamingAudioSpectrogramOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("window_size", &window_size_));
+    OP_REQUIRES_OK(context, context->GetAttr("stride", &stride_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("magnitude_squared", &magnitude_squared_));
+  }
+
+  ~StreamingAudioSpectrogramOp() override {
+    if (state_ != nullptr) {
+      state_->Unref();
+      if (cinfo_.resource_is_private_to_kernel()) {
+        // The state can have been deleted by a session reset.
+        cinfo_.resource_manager()
+            ->Delete<StreamingSpectrogramState>(cinfo_.container(),
+                                                cinfo_.name())
+            .IgnoreError();
+      }
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 2,
+                errors::InvalidArgument("input must be 2-dimensional",
+                                        input.shape().DebugString()));
+    StreamingSpectrogramState* state;
+    OP_REQUIRES_OK(context, GetState(context, &state));
+
+    const auto input_as_matrix = input.matrix<float>();
+    const int64 sample_count = input.dim_size(0);
+    const int64 channel_count = input.dim_size(1);
+
+    mutex_lock l(state->mu);
+    std::vector<std::unique_ptr<Spectrogram>>* channels;
+    OP_REQUIRES_OK(context, state->GetChannels(channel_count, &channels));
+
+    // All the channels have seen the same number of samples, so they produce
+    // the same number of frames.
+    std::vector<float> input_for_channel(sample_count);
+    std::vector<std::vector<std::vector<float>>> spectrogram_outputs(
+        channel_count);
+    for (int64 channel = 0; channel < channel_count; ++channel) {
+      for (int64 i = 0; i < sample_count; ++i) {
+        input_for_channel[i] = input_as_matrix(i, channel);
+      }
+      OP_REQUIRES(context,
+                  (*channels)[channel]->ComputeSquaredMagnitudeSpectrogram(
+                      input_for_channel, &spectrogram_outputs[channel]),
+                  errors::InvalidArgument("Spectrogram compute failed"));
+    }
+
+    const int64 output_height =
+        channel_count > 0 ? spectrogram_outputs[0].size() : 0;
+    const int64 output_width = channel_count > 0
+                                   ? (*channels)[0]->output_frequency_channels()
+                                   : 0;
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, TensorShape({channel_count, output_height, output_width}),
+            &output_tensor));
+    float* output_row = output_tensor->flat<float>().data();
+    for (int64 channel = 0; channel < channel_count; ++channel) {
+      for (const std::vector<float>& spectrogram_row :
+           spectrogram_outputs[channel]) {
+        DCHECK_EQ(spectrogram_row.size(), output_width);
+        for (int64 i = 0; i < output_width; ++i) {
+          output_row[i] = magnitude_squared_ ? spectrogram_row[i]
+                                             : sqrtf(spectrogram_row[i]);
+        }
+        output_row += output_width;
+      }
+    }
+  }
+
+ private:
+  // Looks up or creates the state of the stream on the first call.
+  Status GetState(OpKernelContext* context, StreamingSpectrogramState** state)
+      LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    if (state_ == nullptr) {
+      ResourceMgr* mgr = context->resource_manager();
+      TF_RETURN_IF_ERROR(cinfo_.Init(mgr, def()));
+      TF_RETURN_IF_ERROR(mgr->LookupOrCreate<StreamingSpectrogramState>(
+          cinfo_.container(), cinfo_.name(), &state_,
+          [this](StreamingSpectrogramState** ret) {
+            *ret = new StreamingSpectrogramState(window_size_, stride_);
+            return Status::OK();
+          }));
+    }
+    *state = state_;
+    return Status::OK();
+  }
+
+  int32 window_size_;
+  int32 stride_;
+  bool magnitude_squared_;
+
+  mutex mu_;
+  ContainerInfo cinfo_ GUARDED_BY(mu_);
+  StreamingSpectrogramState* state_ GUARDED_BY(mu_) = nullptr;
+};
+REGISTER_KERNEL_BUILDER(Name("StreamingAudioSpectrogram").Device(DEVICE_CPU),
+                        StreamingAudioSpectrogramOp);
+
 }  // namespace tensorflow
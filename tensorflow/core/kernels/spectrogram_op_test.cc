@@ -15,11 +15,14 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <math.h>
+
 #include <functional>
 #include <memory>
 #include <vector>
 
 #include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/audio_ops.h"
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/math_ops.h"
@@ -101,4 +104,53 @@ TEST(SpectrogramOpTest, SquaredTest) {
       test::AsTensor<float>({0, 1, 4, 1, 0}, TensorShape({1, 1, 5})), 1e-3);
 }
 
+TEST(SpectrogramOpTest, StreamingMatchesWholeAudio) {
+  Scope root = Scope::NewRootScope();
+
+  std::vector<float> audio(16);
+  for (int i = 0; i < audio.size(); ++i) {
+    audio[i] = sinf(i * 0.7f) * 0.5f;
+  }
+  Tensor audio_tensor(DT_FLOAT, TensorShape({16, 1}));
+  test::FillValues<float>(&audio_tensor, audio);
+
+  Output audio_const_op = Const(root.WithOpName("audio_const_op"),
+                                Input::Initializer(audio_tensor));
+  AudioSpectrogram spectrogram_op =
+      AudioSpectrogram(root.WithOpName("spectrogram_op"), audio_const_op, 8, 4);
+  auto chunk = Placeholder(root.WithOpName("chunk"), DT_FLOAT);
+  StreamingAudioSpectrogram streaming_op = StreamingAudioSpectrogram(
+      root.WithOpName("streaming_op"), chunk, 8, 4);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_EXPECT_OK(session.Run(ClientSession::FeedType(),
+                           {spectrogram_op.spectrogram}, &outputs));
+  const Tensor whole = outputs[0];
+  ASSERT_EQ(3, whole.dim_size(1));
+
+  // Feeds the audio in chunks of 5, 5 and 6 samples, which complete 0, 1 and
+  // 2 frames.
+  std::vector<float> streamed;
+  int start = 0;
+  for (const int chunk_size : {5, 5, 6}) {
+    Tensor chunk_tensor(DT_FLOAT, TensorShape({chunk_size, 1}));
+    test::FillValues<float>(
+        &chunk_tensor, std::vector<float>(audio.begin() + start,
+                                          audio.begin() + start + chunk_size));
+    start += chunk_size;
+    TF_EXPECT_OK(session.Run({{chunk, chunk_tensor}},
+                             {streaming_op.spectrogram}, &outputs));
+    const Tensor& frames = outputs[0];
+    EXPECT_EQ(1, frames.dim_size(0));
+    EXPECT_EQ(5, frames.dim_size(2));
+    const auto frames_flat = frames.flat<float>();
+    streamed.insert(streamed.end(), frames_flat.data(),
+                    frames_flat.data() + frames_flat.size());
+  }
+  test::ExpectTensorNear<float>(
+      whole, test::AsTensor<float>(streamed, TensorShape({1, 3, 5})), 1e-5);
+}
+
 }  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_SPLIT_LIB_H_
 // Functor definition for SplitOp, must be compilable by nvcc.
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 
@@ -48,6 +50,18 @@ struct Split<Eigen::ThreadPoolDevice, T> {
                   const Eigen::DSizes<Eigen::DenseIndex, 3>& slice_sizes);
 };
 
+// Copies the 'num_rows' rows of 'input' into 'outputs' in a single pass:
+// each row is made of one chunk per output, of the sizes in 'chunk_sizes',
+// and row r of outputs[i] is chunk i of row r of 'input'. Used on CPU to split
+// along an inner dimension, where one Split per output reads every row once
+// per output instead.
+template <typename T>
+struct SplitRows {
+  void operator()(const Eigen::ThreadPoolDevice& d, const T* input,
+                  int64 num_rows, const std::vector<int64>& chunk_sizes,
+                  const std::vector<T*>& outputs);
+};
+
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
 struct Split<Eigen::SyclDevice, T> {
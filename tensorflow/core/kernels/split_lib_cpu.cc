@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/split_lib.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_types.h"
@@ -37,7 +39,32 @@ void Split<Eigen::ThreadPoolDevice, T>::operator()(
   }
 }
 
-#define DEFINE_CPU_KERNELS(T) template struct Split<Eigen::ThreadPoolDevice, T>;
+template <typename T>
+void SplitRows<T>::operator()(const Eigen::ThreadPoolDevice& d, const T* input,
+                              int64 num_rows,
+                              const std::vector<int64>& chunk_sizes,
+                              const std::vector<T*>& outputs) {
+  int64 row_size = 0;
+  for (const int64 chunk_size : chunk_sizes) row_size += chunk_size;
+  const double bytes_per_row = static_cast<double>(row_size) * sizeof(T);
+  d.parallelFor(num_rows,
+                Eigen::TensorOpCost(bytes_per_row, bytes_per_row, 0),
+                [input, row_size, &chunk_sizes, &outputs](int64 begin,
+                                                          int64 end) {
+                  for (int64 r = begin; r < end; ++r) {
+                    const T* row = input + r * row_size;
+                    for (size_t i = 0; i < outputs.size(); ++i) {
+                      std::copy_n(row, chunk_sizes[i],
+                                  outputs[i] + r * chunk_sizes[i]);
+                      row += chunk_sizes[i];
+                    }
+                  }
+                });
+}
+
+#define DEFINE_CPU_KERNELS(T)                      \
+  template struct Split<Eigen::ThreadPoolDevice, T>; \
+  template struct SplitRows<T>;
 
 TF_CALL_ALL_TYPES(DEFINE_CPU_KERNELS)
 DEFINE_CPU_KERNELS(quint8)
@@ -78,7 +78,8 @@ class SplitOpBase : public OpKernel {
       return;
     }
 
-    // Special case 2: split along the 1st dimension. We can share the
+    // Special case 2: split along the 1st dimension, or along a later one
+    // when all the dimensions before it have size 1. We can share the
     // underlying buffer.
     //
     // Apply this optimization conservatively: if input is aligned,
@@ -86,11 +87,25 @@ class SplitOpBase : public OpKernel {
     // because if the immediate consumer of the resulting tensors are
     // not using eigen for computation, its perfectly fine to avoid
     // the copying.
-    if ((split_dim == 0) && IsInnerDimsSizeAligned<T>(input_shape)) {
-      VLOG(1) << "Slice dim 0: " << input_shape.DebugString();
-      const int64 delta = input_shape.dim_size(0) / num_split;
+    int64 prefix_dim_size;
+    int64 split_dim_size;
+    int64 suffix_dim_size;
+    std::tie(prefix_dim_size, split_dim_size, suffix_dim_size) =
+        SetDims<int64>(input_shape, split_dim);
+    const TensorShape split_shape({split_dim_size, suffix_dim_size});
+    if (prefix_dim_size == 1 && IsInnerDimsSizeAligned<T>(split_shape)) {
+      VLOG(1) << "Slice dim " << split_dim << ": "
+              << input_shape.DebugString();
+      Tensor input_reshaped;
+      CHECK(input_reshaped.CopyFrom(input, split_shape));
+      const int64 delta = split_dim_size / num_split;
+      TensorShape output_shape(input_shape);
+      output_shape.set_dim(split_dim, delta);
       for (int i = 0; i < num_split; ++i) {
-        context->set_output(i, input.Slice(i * delta, (i + 1) * delta));
+        Tensor output;
+        CHECK(output.CopyFrom(input_reshaped.Slice(i * delta, (i + 1) * delta),
+                              output_shape));
+        context->set_output(i, output);
       }
       *done = true;
       return;
@@ -159,6 +174,26 @@ class SplitOpCPU : public SplitOpBase<CPUDevice, T> {
     TensorShape output_shape(input_shape);
     output_shape.set_dim(split_dim, split_dim_output_size);
 
+    // Splitting along an inner dimension, e.g. the gates of an LSTM cell,
+    // copies every row of the input to all the outputs in one pass.
+    if (prefix_dim_size > 1) {
+      std::vector<int64> chunk_sizes(num_split,
+                                     split_dim_output_size * suffix_dim_size);
+      std::vector<T*> outputs(num_split);
+      for (int i = 0; i < num_split; ++i) {
+        Tensor* result = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(i, output_shape, &result));
+        outputs[i] = result->flat<T>().data();
+      }
+      if (input.NumElements() > 0) {
+        functor::SplitRows<T>()(context->eigen_device<CPUDevice>(),
+                                input.flat<T>().data(), prefix_dim_size,
+                                chunk_sizes, outputs);
+      }
+      return;
+    }
+
     Eigen::DSizes<Eigen::DenseIndex, 3> indices{0, 0, 0};
     Eigen::DSizes<Eigen::DenseIndex, 3> sizes{
         prefix_dim_size, split_dim_output_size, suffix_dim_size};
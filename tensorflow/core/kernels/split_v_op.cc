@@ -131,7 +131,8 @@ class SplitVOpBase : public OpKernel {
       (*split_sizes_vec)[neg_one_dim] = input_size_split_dim - determined_size;
     }
 
-    // Special case 2: split along the 1st dimension. We can share the
+    // Special case 2: split along the 1st dimension, or along a later one
+    // when all the dimensions before it have size 1. We can share the
     // underlying buffer.
     //
     // Apply this optimization conservatively: if input is aligned,
@@ -139,11 +140,24 @@ class SplitVOpBase : public OpKernel {
     // because if the immediate consumer of the resulting tensors are
     // not using eigen for computation, its perfectly fine to avoid
     // the copying.
-    if ((split_dim == 0) && IsInnerDimsSizeAligned<T>(input_shape)) {
+    int64 prefix_dim_size;
+    int64 split_dim_size;
+    int64 suffix_dim_size;
+    std::tie(prefix_dim_size, split_dim_size, suffix_dim_size) =
+        SetDims<int64>(input_shape, split_dim);
+    const TensorShape split_shape({split_dim_size, suffix_dim_size});
+    if (prefix_dim_size == 1 && IsInnerDimsSizeAligned<T>(split_shape)) {
+      Tensor input_reshaped;
+      CHECK(input_reshaped.CopyFrom(input, split_shape));
       Tlen start = 0;
       for (int i = 0; i < num_split; ++i) {
-        context->set_output(i,
-                            input.Slice(start, start + (*split_sizes_vec)[i]));
+        TensorShape output_shape(input_shape);
+        output_shape.set_dim(split_dim, (*split_sizes_vec)[i]);
+        Tensor output;
+        CHECK(output.CopyFrom(
+            input_reshaped.Slice(start, start + (*split_sizes_vec)[i]),
+            output_shape));
+        context->set_output(i, output);
         start += (*split_sizes_vec)[i];
       }
       *done = true;
@@ -210,6 +224,28 @@ class SplitVOpCPU : public SplitVOpBase<CPUDevice, T, Tlen> {
     auto input_reshaped =
         input.shaped<T, 3>({prefix_dim_size, split_dim_size, suffix_dim_size});
 
+    // Splitting along an inner dimension copies every row of the input to
+    // all the outputs in one pass.
+    if (prefix_dim_size > 1) {
+      std::vector<int64> chunk_sizes(num_split);
+      std::vector<T*> outputs(num_split);
+      for (int i = 0; i < num_split; ++i) {
+        TensorShape output_shape(input_shape);
+        output_shape.set_dim(split_dim, split_sizes_vec[i]);
+        Tensor* result = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(i, output_shape, &result));
+        chunk_sizes[i] = split_sizes_vec[i] * suffix_dim_size;
+        outputs[i] = result->flat<T>().data();
+      }
+      if (input.NumElements() > 0) {
+        functor::SplitRows<T>()(context->eigen_device<CPUDevice>(),
+                                input.flat<T>().data(), prefix_dim_size,
+                                chunk_sizes, outputs);
+      }
+      return;
+    }
+
     Eigen::DSizes<Eigen::DenseIndex, 3> indices{0, 0, 0};
 
     for (int i = 0; i < num_split; ++i) {
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <limits.h>
 #include <atomic>
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -48,10 +50,62 @@ class Stack : public ResourceBase {
  public:
   static std::atomic<int64> stack_counter;
 
+  // The copy of a tensor that was swapped to CPU back to the device. It is
+  // started ahead of the Pop() that returns the tensor.
+  class SwapIn {
+   public:
+    typedef std::function<void(const Status&, const Tensor&)> DoneCallback;
+
+    SwapIn(const Tensor& cpu_tensor, Tensor device_tensor)
+        : cpu_tensor_(cpu_tensor), device_tensor_(std::move(device_tensor)) {}
+
+    const Tensor* cpu_tensor() const { return &cpu_tensor_; }
+    Tensor* device_tensor() { return &device_tensor_; }
+
+    // Called when the copy is done.
+    void Done(const Status& s) {
+      std::vector<DoneCallback> waiters;
+      {
+        mutex_lock l(mu_);
+        done_ = true;
+        status_ = s;
+        waiters.swap(waiters_);
+      }
+      for (const DoneCallback& waiter : waiters) {
+        waiter(s, device_tensor_);
+      }
+    }
+
+    // Calls "done" with the device tensor once the copy is done, which may
+    // be right away.
+    void Wait(DoneCallback done) {
+      Status s;
+      {
+        mutex_lock l(mu_);
+        if (!done_) {
+          waiters_.push_back(std::move(done));
+          return;
+        }
+        s = status_;
+      }
+      done(s, device_tensor_);
+    }
+
+   private:
+    const Tensor cpu_tensor_;
+    Tensor device_tensor_;
+    mutex mu_;
+    bool done_ GUARDED_BY(mu_) = false;
+    Status status_ GUARDED_BY(mu_);
+    std::vector<DoneCallback> waiters_ GUARDED_BY(mu_);
+  };
+
   struct TensorAndAllocation {
     Tensor tensor;
     AllocatorAttributes alloc_attrs;
     bool swapped_to_cpu;
+    // Set once the copy of a swapped tensor back to the device has started.
+    std::shared_ptr<SwapIn> swap_in;
   };
 
   Stack(const DataType& elem_type, const Tensor& handle)
@@ -77,6 +131,23 @@ class Stack : public ResourceBase {
     return Status::OK();
   }
 
+  // If the top of the stack was swapped to CPU and nobody is copying it
+  // back yet, marks it with the SwapIn returned by "make_swap_in", which the
+  // caller then starts, and returns it in "*swap_in". Returns false
+  // otherwise.
+  bool ClaimSwapIn(const std::function<std::shared_ptr<SwapIn>(
+                       const TensorAndAllocation&)>& make_swap_in,
+                   std::shared_ptr<SwapIn>* swap_in) {
+    mutex_lock l(mu_);
+    if (closed_ || stack_.empty() || !stack_.back().swapped_to_cpu ||
+        stack_.back().swap_in != nullptr) {
+      return false;
+    }
+    stack_.back().swap_in = make_swap_in(stack_.back());
+    *swap_in = stack_.back().swap_in;
+    return true;
+  }
+
   // We don't swap the first tensor on the stack and any subsequent tensors
   // that share the buffer with the first tensor.
   bool IsUsefulToSwap(const Tensor& tensor) const {
@@ -340,23 +411,30 @@ class StackPopOp : public AsyncOpKernel {
     Stack::TensorAndAllocation value;
     OP_REQUIRES_OK_ASYNC(ctx, stack->Pop(&value), done);
     if (value.swapped_to_cpu) {
-      // Asynchronously copy the tensor back from CPU to GPU memory.
-      DeviceContext* device_ctxt = ctx->op_device_context();
-      Device* device = static_cast<Device*>(ctx->device());
-      Tensor* cpu_tensor = &value.tensor;
-      Allocator* gpu_allocator = device->GetAllocator(value.alloc_attrs);
-      Tensor* device_tensor =
-          new Tensor(gpu_allocator, cpu_tensor->dtype(), cpu_tensor->shape());
-      device_ctxt->CopyCPUTensorToDevice(
-          cpu_tensor, device, device_tensor,
-          [device_tensor, ctx, done](const Status& s) {
-            ctx->SetStatus(s);
-            if (s.ok()) {
-              ctx->set_output(0, *device_tensor);
-            }
-            done();
-            delete device_tensor;
-          });
+      // Asynchronously copy the tensor back from CPU to GPU memory, unless
+      // the previous Pop() already started it.
+      std::shared_ptr<Stack::SwapIn> swap_in = value.swap_in;
+      if (swap_in == nullptr) {
+        swap_in = MakeSwapIn(ctx, value);
+        StartSwapIn(ctx, swap_in);
+      }
+      // Start copying the next swapped tensor too, so that it is on the
+      // device by the time the next Pop() needs it.
+      std::shared_ptr<Stack::SwapIn> next_swap_in;
+      if (stack->ClaimSwapIn(
+              [ctx](const Stack::TensorAndAllocation& next) {
+                return MakeSwapIn(ctx, next);
+              },
+              &next_swap_in)) {
+        StartSwapIn(ctx, next_swap_in);
+      }
+      swap_in->Wait([ctx, done](const Status& s, const Tensor& device_tensor) {
+        ctx->SetStatus(s);
+        if (s.ok()) {
+          ctx->set_output(0, device_tensor);
+        }
+        done();
+      });
     } else {
       // Execute synchronously if not swapped.
       ctx->set_output(0, value.tensor);
@@ -365,6 +443,28 @@ class StackPopOp : public AsyncOpKernel {
   }
 
   bool IsExpensive() override { return false; }
+
+ private:
+  // Allocates the device tensor to copy the swapped "value" back to.
+  static std::shared_ptr<Stack::SwapIn> MakeSwapIn(
+      OpKernelContext* ctx, const Stack::TensorAndAllocation& value) {
+    Device* device = static_cast<Device*>(ctx->device());
+    Allocator* gpu_allocator = device->GetAllocator(value.alloc_attrs);
+    return std::make_shared<Stack::SwapIn>(
+        value.tensor,
+        Tensor(gpu_allocator, value.tensor.dtype(), value.tensor.shape()));
+  }
+
+  static void StartSwapIn(OpKernelContext* ctx,
+                          const std::shared_ptr<Stack::SwapIn>& swap_in) {
+    DeviceContext* device_ctxt = ctx->op_device_context();
+    Device* device = static_cast<Device*>(ctx->device());
+    // The callback keeps the tensors alive until the copy is done, which
+    // may be after the op that started it.
+    device_ctxt->CopyCPUTensorToDevice(
+        swap_in->cpu_tensor(), device, swap_in->device_tensor(),
+        [swap_in](const Status& s) { swap_in->Done(s); });
+  }
 };
 
 REGISTER_KERNEL_BUILDER(Name("StackPop").Device(DEVICE_CPU), StackPopOp);
@@ -29,6 +29,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/ops_util.h"
@@ -154,12 +155,12 @@ class StridedSliceOp : public OpKernel {
   }
 
       HANDLE_DIM(1);
-      HANDLE_DIM(2);
-      HANDLE_DIM(3);
-      HANDLE_DIM(4);
-      HANDLE_DIM(5);
-      HANDLE_DIM(6);
-      HANDLE_DIM(7);
+      IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(2));
+      IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(3));
+      IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(4));
+      IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(5));
+      IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(6));
+      IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(7));
 
 #undef HANDLE_DIM
 
@@ -251,12 +252,12 @@ class StridedSliceGradOp : public OpKernel {
   }
 
     HANDLE_DIM(1);
-    HANDLE_DIM(2);
-    HANDLE_DIM(3);
-    HANDLE_DIM(4);
-    HANDLE_DIM(5);
-    HANDLE_DIM(6);
-    HANDLE_DIM(7);
+    IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(2));
+    IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(3));
+    IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(4));
+    IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(5));
+    IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(6));
+    IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(7));
 
 #undef HANDLE_DIM
   }
@@ -334,12 +335,12 @@ class StridedSliceAssignOp : public OpKernel {
   }
       HANDLE_DIM(0);
       HANDLE_DIM(1);
-      HANDLE_DIM(2);
-      HANDLE_DIM(3);
-      HANDLE_DIM(4);
-      HANDLE_DIM(5);
-      HANDLE_DIM(6);
-      HANDLE_DIM(7);
+      IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(2));
+      IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(3));
+      IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(4));
+      IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(5));
+      IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(6));
+      IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(7));
 #undef HANDLE_DIM
 
       OP_REQUIRES(context, false,
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/register_types_traits.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/dense_update_ops.h"
@@ -286,8 +287,10 @@ TF_CALL_complex128(DECLARE_FOR_N_GPU);
 DECLARE_FOR_N_GPU(int32);
 #endif  // END GOOGLE_CUDA
 
+#if STRIDED_SLICE_INSTANTIATE_DIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_ALL_TYPES(DECLARE_FOR_N_CPU);
 DECLARE_FOR_N_CPU(bfloat16);
+#endif
 
 #ifdef TENSORFLOW_USE_SYCL
 #define PREVENT_FOR_N_SYCL(T) \
@@ -297,8 +300,10 @@ DECLARE_FOR_N_CPU(bfloat16);
   INSTANTIATE(SYCLDevice, T, STRIDED_SLICE_INSTANTIATE_DIM)
 
 TF_CALL_SYCL_PROXY_TYPES(PREVENT_FOR_N_SYCL);
+#if STRIDED_SLICE_INSTANTIATE_DIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_GPU_NUMBER_TYPES_NO_HALF(DECLARE_FOR_N_SYCL);
 DECLARE_FOR_N_SYCL(int32);
+#endif
 
 #undef DECLARE_FOR_N_SYCL
 #endif // TENSORFLOW_USE_SYCL
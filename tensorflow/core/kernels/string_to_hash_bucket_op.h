@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -44,15 +45,23 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    // The cost of a string depends on its length, which the calibration
+    // measures.
+    static ShardCostCalibration* calibration =
+        new ShardCostCalibration("StringToHashBucketOp", 100);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), calibration,
+          [this, &input_flat, &output_flat](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 input_hash = hash(input_flat(i));
+              const uint64 bucket_id = input_hash % num_buckets_;
+              // The number of buckets is always in the positive range of
+              // int64 so is the resulting bucket_id. Casting the bucket_id
+              // from uint64 to int64 is safe.
+              output_flat(i) = static_cast<int64>(bucket_id);
+            }
+          });
   }
 
  private:
@@ -86,15 +95,21 @@ class StringToKeyedHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    static ShardCostCalibration* calibration =
+        new ShardCostCalibration("StringToKeyedHashBucketOp", 200);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), calibration,
+          [this, &input_flat, &output_flat](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 input_hash = hash(key_, input_flat(i));
+              const uint64 bucket_id = input_hash % num_buckets_;
+              // The number of buckets is always in the positive range of
+              // int64 so is the resulting bucket_id. Casting the bucket_id
+              // from uint64 to int64 is safe.
+              output_flat(i) = static_cast<int64>(bucket_id);
+            }
+          });
   }
 
  private:
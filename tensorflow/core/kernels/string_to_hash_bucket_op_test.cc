@@ -0,0 +1,52 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+static Graph* StringToHashBucket(const string& op, int num_strings) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_STRING, TensorShape({num_strings}));
+  for (int i = 0; i < num_strings; ++i) {
+    input.flat<string>()(i) = strings::StrCat("some_feature_value_", i);
+  }
+  NodeBuilder builder(g->NewName("n"), op);
+  builder.Input(test::graph::Constant(g, input)).Attr("num_buckets", 1 << 20);
+  if (op == "StringToHashBucketStrong") {
+    builder.Attr("key", std::vector<int64>({123, 456}));
+  }
+  TF_CHECK_OK(builder.Finalize(g, nullptr));
+  return g;
+}
+
+#define BM_StringToHashBucketDev(OP, N)                                      \
+  static void BM_##OP##_##N(int iters) {                                     \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N);                  \
+    test::Benchmark("cpu", StringToHashBucket(#OP, N)).Run(iters);           \
+  }                                                                          \
+  BENCHMARK(BM_##OP##_##N);
+
+BM_StringToHashBucketDev(StringToHashBucketFast, 1024);
+BM_StringToHashBucketDev(StringToHashBucketFast, 65536);
+BM_StringToHashBucketDev(StringToHashBucketFast, 1048576);
+BM_StringToHashBucketDev(StringToHashBucketStrong, 65536);
+
+}  // end namespace tensorflow
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #define EIGEN_USE_THREADS
+#if GOOGLE_CUDA
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA
+
 #include "tensorflow/core/kernels/tensor_array.h"
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -77,10 +81,77 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 
 #undef TENSOR_ARRAY_SET_ZERO
 
+template <>
+Status CopyTensorData<CPUDevice>(OpKernelContext* ctx, const Tensor& src,
+                                 Tensor* dst) {
+  DCHECK_EQ(src.TotalBytes(), dst->TotalBytes());
+  StringPiece src_data = src.tensor_data();
+  memcpy(const_cast<char*>(dst->tensor_data().data()), src_data.data(),
+         src_data.size());
+  return Status::OK();
+}
+
+#if GOOGLE_CUDA
+
+template <>
+Status CopyTensorData<GPUDevice>(OpKernelContext* ctx, const Tensor& src,
+                                 Tensor* dst) {
+  DCHECK_EQ(src.TotalBytes(), dst->TotalBytes());
+  StringPiece src_data = src.tensor_data();
+  ctx->eigen_device<GPUDevice>().memcpy(
+      const_cast<char*>(dst->tensor_data().data()), src_data.data(),
+      src_data.size());
+  return Status::OK();
+}
+
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensor_array
 
 std::atomic<int64> TensorArray::tensor_array_counter{0};
 
+bool TensorArray::ReadContiguous(OpKernelContext* ctx,
+                                 const std::vector<int32>& indices,
+                                 Tensor* value) {
+  mutex_lock l(mu_);
+  if (closed_ || indices.empty() || !storage_.IsInitialized()) {
+    return false;
+  }
+  const int32 begin = indices[0];
+  if (begin < 0 || begin + indices.size() > tensors_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (indices[i] != begin + static_cast<int32>(i)) {
+      return false;
+    }
+    const TensorAndState& t = tensors_[indices[i]];
+    // Elements in storage that are not cleared are always in the current
+    // storage, which is only released once all of them are cleared.
+    if (!t.in_storage || t.cleared) {
+      return false;
+    }
+  }
+
+  *value = storage_.AccessTensor(ctx)->Slice(begin, begin + indices.size());
+  for (const int32 index : indices) {
+    if (clear_after_read_) {
+      LockedClear(index);
+    }
+    tensors_[index].read = true;
+  }
+  return true;
+}
+
+void TensorArray::LockedClear(const int32 index) {
+  TensorAndState& t = tensors_[index];
+  t.tensor = PersistentTensor();
+  t.cleared = true;
+  if (t.in_storage && --storage_live_ == 0) {
+    storage_ = PersistentTensor();
+  }
+}
+
 Status TensorArray::CopyShapesFrom(TensorArray* rhs) {
   mutex_lock l(mu_);
   mutex_lock l_rhs(rhs->mu_);
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_TENSOR_ARRAY_H_
 
 #include <limits.h>
+#include <type_traits>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -96,6 +97,24 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 
 #undef TENSOR_ARRAY_SET_ZERO
 
+// Copies the bytes of 'src' into 'dst', which must have the same size, on
+// the device of 'ctx'.  Only dtypes that can use memcpy are supported.
+template <typename Device>
+Status CopyTensorData(OpKernelContext* ctx, const Tensor& src, Tensor* dst) {
+  return errors::Unimplemented(
+      "tensor_array::CopyTensorData is not supported on this device");
+}
+
+template <>
+Status CopyTensorData<CPUDevice>(OpKernelContext* ctx, const Tensor& src,
+                                 Tensor* dst);
+
+#if GOOGLE_CUDA
+template <>
+Status CopyTensorData<GPUDevice>(OpKernelContext* ctx, const Tensor& src,
+                                 Tensor* dst);
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensor_array
 
 // The TensorArray object keeps an array of PersistentTensors.  It
@@ -114,6 +133,10 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 //     All operations on a TensorArray are thread-safe.
 //   * A TensorArray may be preemptively closed, which releases all
 //     memory associated with it.
+//   * If the TensorArray has a fixed size and its element shape is fully
+//     defined, the elements are copied into one contiguous buffer that is
+//     allocated by the first write (see ReadContiguous).  Otherwise they
+//     are kept as shallow copies of the written Tensors.
 //
 // These properties together allow the TensorArray to work as a
 // functional object and makes gradient computation easy.  For
@@ -203,6 +226,14 @@ class TensorArray : public ResourceBase {
     return Status::OK();
   }
 
+  // Reads the elements at 'indices' as a single Tensor of shape
+  // [indices.size()] + element shape, without copying them, if they are
+  // consecutive and all held in the contiguous storage of the array.
+  // Returns false, and reads nothing, otherwise; the caller should then
+  // fall back to ReadMany, which reports any error.
+  bool ReadContiguous(OpKernelContext* ctx, const std::vector<int32>& indices,
+                      Tensor* value);
+
   // Read from index 'index' into PersistentTensor 'value'.
   //
   // Preconditions:
@@ -333,6 +364,8 @@ class TensorArray : public ResourceBase {
   void ClearAndMarkClosed() {
     mutex_lock l(mu_);
     tensors_.clear();
+    storage_ = PersistentTensor();
+    storage_live_ = 0;
     closed_ = true;
   }
 
@@ -356,6 +389,22 @@ class TensorArray : public ResourceBase {
   Status LockedRead(OpKernelContext* ctx, const int32 index,
                     PersistentTensor* value) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns true if the first write of 'value' should be copied into the
+  // contiguous storage.
+  template <typename Device>
+  bool LockedUseStorage(const Tensor& value) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Copies 'value' into the contiguous storage at 'index', allocating the
+  // storage if needed, and points tensors_[index] at it.
+  template <typename Device>
+  Status LockedWriteToStorage(OpKernelContext* ctx, const int32 index,
+                              const Tensor& value)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Marks tensors_[index], which has just been read, as cleared.
+  void LockedClear(const int32 index) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status LockedReturnIfClosed() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     if (closed_) {
       return errors::InvalidArgument("TensorArray ", handle_.vec<string>()(1),
@@ -400,12 +449,24 @@ class TensorArray : public ResourceBase {
   // known at all.
   PartialTensorShape element_shape_ GUARDED_BY(mu_);
 
+  // The contiguous storage of shape [N] + element shape, if any.  Element i
+  // is a slice of it iff tensors_[i].in_storage is true.
+  PersistentTensor storage_ GUARDED_BY(mu_);
+
+  // The number of elements in storage_ that are not cleared yet.  The
+  // storage is released when it drops to zero.
+  int32 storage_live_ GUARDED_BY(mu_) = 0;
+
   // TensorAndState is used to keep track of the PersistentTensors
   // stored in the TensorArray, along with their shapes, and a boolean
   // that determines whether they have already been read or not.
   struct TensorAndState {
     TensorAndState()
-        : written(false), read(false), cleared(false), local_copy(false) {}
+        : written(false),
+          read(false),
+          cleared(false),
+          local_copy(false),
+          in_storage(false) {}
     PersistentTensor tensor;
     TensorShape shape;
     bool written;  // True if a Tensor has been written to the index.
@@ -420,6 +481,9 @@ class TensorArray : public ResourceBase {
     // aggregated value.  This flag marks that such a Tensor is being
     // used.  All future writes will aggregate to the existing local Tensor.
     bool local_copy;
+
+    // True if the tensor is a slice of the contiguous storage.
+    bool in_storage;
   };
   // The list of underlying PersistentTensors and states.
   std::vector<TensorAndState> tensors_ GUARDED_BY(mu_);
@@ -519,7 +583,11 @@ Status TensorArray::LockedWriteOrAggregate(OpKernelContext* ctx,
     // TensorArray.
     gradients_disallowed_ = true;
   } else {
-    t.tensor = *value;
+    if (LockedUseStorage<Device>(*value_t)) {
+      TF_RETURN_IF_ERROR(LockedWriteToStorage<Device>(ctx, index, *value_t));
+    } else {
+      t.tensor = *value;
+    }
     t.shape = value_t->shape();
     t.written = true;
   }
@@ -566,13 +634,55 @@ Status TensorArray::LockedRead(OpKernelContext* ctx, const int32 index,
   *value = t.tensor;
 
   if (clear_after_read_) {
-    t.tensor = PersistentTensor();
-    t.cleared = true;
+    LockedClear(index);
   }
   t.read = true;
   return Status::OK();
 }
 
+template <typename Device>
+bool TensorArray::LockedUseStorage(const Tensor& value) const {
+  // Only arrays of known size and element shape, which don't aggregate
+  // writes, know the layout of the storage at their first write.
+  if (dynamic_size_ || multiple_writes_aggregate_ || tensors_.size() < 2 ||
+      !element_shape_.IsFullyDefined() || !DataTypeCanUseMemcpy(dtype_) ||
+      !(std::is_same<Device, CPUDevice>::value ||
+        std::is_same<Device, GPUDevice>::value)) {
+    return false;
+  }
+  // Every slice of the storage must stay aligned, as kernels expect of
+  // their inputs.
+  const int64 bytes = value.TotalBytes();
+#if EIGEN_MAX_ALIGN_BYTES == 0
+  return bytes > 0;
+#else
+  return bytes > 0 && bytes % EIGEN_MAX_ALIGN_BYTES == 0;
+#endif
+}
+
+template <typename Device>
+Status TensorArray::LockedWriteToStorage(OpKernelContext* ctx,
+                                         const int32 index,
+                                         const Tensor& value) {
+  if (!storage_.IsInitialized()) {
+    TensorShape storage_shape(value.shape());
+    storage_shape.InsertDim(0, tensors_.size());
+    Tensor* unused;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_persistent(dtype_, storage_shape, &storage_, &unused));
+  }
+  Tensor element;
+  CHECK(element.CopyFrom(storage_.AccessTensor(ctx)->Slice(index, index + 1),
+                         value.shape()));
+  TF_RETURN_IF_ERROR(
+      tensor_array::CopyTensorData<Device>(ctx, value, &element));
+  TensorAndState& t = tensors_[index];
+  t.tensor = PersistentTensor(element);
+  t.in_storage = true;
+  ++storage_live_;
+  return Status::OK();
+}
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_TENSOR_ARRAY_H_
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/concat_lib.h"
+#include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/kernels/tensor_array.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -612,6 +613,14 @@ class TensorArrayPackOrGatherOp : public OpKernel {
       return;
     }
 
+    // Elements held in the contiguous storage of the TensorArray are
+    // returned as a slice of it, without copying them.
+    Tensor contiguous;
+    if (tensor_array->ReadContiguous(ctx, indices, &contiguous)) {
+      ctx->set_output(0, contiguous);
+      return;
+    }
+
     // Read all the PersistentTensors into a vector to keep track of
     // their memory.
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
@@ -1084,7 +1093,20 @@ class TensorArrayUnpackOrScatterOp : public OpKernel {
     std::vector<PersistentTensor> write_values;
     write_values.reserve(num_values);
 
+    // If its elements are aligned, the value is written as slices of itself
+    // rather than copied.
+    const bool slice_value =
+        num_values > 0 && tensor_value->IsAligned() &&
+        IsInnerDimsSizeAligned<T>(tensor_value->shape());
+
     for (int i = 0; i < num_values; ++i) {
+      if (slice_value) {
+        Tensor tensor_value_i;
+        CHECK(tensor_value_i.CopyFrom(tensor_value->Slice(i, i + 1),
+                                      element_shape));
+        write_values.push_back(PersistentTensor(tensor_value_i));
+        continue;
+      }
       Tensor* tensor_value_i;
       PersistentTensor persistent_tensor;
       OP_REQUIRES_OK(
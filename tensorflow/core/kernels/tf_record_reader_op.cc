@@ -40,6 +40,8 @@ class TFRecordReader : public ReaderBase {
 
     io::RecordReaderOptions options =
         io::RecordReaderOptions::CreateRecordReaderOptions(compression_type_);
+    options.buffer_size = io::RecordReaderOptions::kDefaultBufferSize;
+    options.prefetch = true;
     reader_.reset(new io::RecordReader(file_.get(), options));
     return Status::OK();
   }
@@ -63,6 +65,24 @@ class TFRecordReader : public ReaderBase {
     return Status::OK();
   }
 
+  Status ReadUpToLocked(int64 num_records, std::vector<string>* keys,
+                        std::vector<string>* values, int64* num_read,
+                        bool* at_end) override {
+    io::RecordBatch batch;
+    Status status = reader_->ReadRecords(&offset_, num_records, &batch);
+    if (errors::IsOutOfRange(status)) {
+      *at_end = true;
+      return Status::OK();
+    }
+    if (!status.ok()) return status;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      keys->push_back(strings::StrCat(current_work(), ":", batch.offset(i)));
+      values->push_back(batch[i].ToString());
+    }
+    *num_read = batch.size();
+    return Status::OK();
+  }
+
   Status ResetLocked() override {
     offset_ = 0;
     reader_.reset(nullptr);
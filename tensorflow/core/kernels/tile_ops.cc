@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/type_index.h"
@@ -301,14 +302,14 @@ class TileGradientOp : public OpKernel {
     return;                                                            \
   }
 
-#define HANDLE_TYPE(T) \
-  HANDLE_DIM(T, 1)     \
-  HANDLE_DIM(T, 2)     \
-  HANDLE_DIM(T, 3)     \
-  HANDLE_DIM(T, 4)     \
-  HANDLE_DIM(T, 5)     \
-  HANDLE_DIM(T, 6)     \
-  HANDLE_DIM(T, 7)
+#define HANDLE_TYPE(T)                         \
+  HANDLE_DIM(T, 1)                             \
+  IF_SHOULD_REGISTER_RANK(2, HANDLE_DIM(T, 2)) \
+  IF_SHOULD_REGISTER_RANK(3, HANDLE_DIM(T, 3)) \
+  IF_SHOULD_REGISTER_RANK(4, HANDLE_DIM(T, 4)) \
+  IF_SHOULD_REGISTER_RANK(5, HANDLE_DIM(T, 5)) \
+  IF_SHOULD_REGISTER_RANK(6, HANDLE_DIM(T, 6)) \
+  IF_SHOULD_REGISTER_RANK(7, HANDLE_DIM(T, 7))
 
 #define HANDLE_TYPE_NAME(T) HANDLE_TYPE(DataTypeToEnum<T>::value)
 
@@ -449,14 +450,14 @@ inline void TileGradientOp<Device>::HandleCase(
   }
 
 // 0-D handled specially above
-#define HANDLE_CASE_DIM(device, T, dtype) \
-  HANDLE_CASE(device, T, dtype, 1);       \
-  HANDLE_CASE(device, T, dtype, 2);       \
-  HANDLE_CASE(device, T, dtype, 3);       \
-  HANDLE_CASE(device, T, dtype, 4);       \
-  HANDLE_CASE(device, T, dtype, 5);       \
-  HANDLE_CASE(device, T, dtype, 6);       \
-  HANDLE_CASE(device, T, dtype, 7);
+#define HANDLE_CASE_DIM(device, T, dtype)                     \
+  HANDLE_CASE(device, T, dtype, 1);                           \
+  IF_SHOULD_REGISTER_RANK(2, HANDLE_CASE(device, T, dtype, 2)) \
+  IF_SHOULD_REGISTER_RANK(3, HANDLE_CASE(device, T, dtype, 3)) \
+  IF_SHOULD_REGISTER_RANK(4, HANDLE_CASE(device, T, dtype, 4)) \
+  IF_SHOULD_REGISTER_RANK(5, HANDLE_CASE(device, T, dtype, 5)) \
+  IF_SHOULD_REGISTER_RANK(6, HANDLE_CASE(device, T, dtype, 6)) \
+  IF_SHOULD_REGISTER_RANK(7, HANDLE_CASE(device, T, dtype, 7))
 
 #define HANDLE_TYPE_NAME_CPU(T) \
   HANDLE_CASE_DIM(CPUDevice, T, DataTypeToEnum<T>::value);
@@ -18,6 +18,7 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/selective_registration.h"
 #include "tensorflow/core/kernels/tile_ops_impl.h"
 
 namespace tensorflow {
@@ -32,6 +33,7 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
   template struct ReduceAndReshape<CPUDevice, T, NDIM, 1>;
 #define DEFINE_TYPE(T) DEFINE_DIM(T, CPU_PROVIDED_IXDIM)
 
+#if CPU_PROVIDED_IXDIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_float(DEFINE_TYPE);
 TF_CALL_double(DEFINE_TYPE);
 TF_CALL_int16(DEFINE_TYPE);
@@ -40,6 +42,7 @@ TF_CALL_int64(DEFINE_TYPE);
 TF_CALL_half(DEFINE_TYPE);
 TF_CALL_complex64(DEFINE_TYPE);
 TF_CALL_complex128(DEFINE_TYPE);
+#endif
 
 #undef DEFINE_DIM
 #undef DEFINE_TYPE
@@ -53,6 +56,7 @@ typedef Eigen::SyclDevice SYCLDevice;
   template struct ReduceAndReshape<SYCLDevice, T, NDIM, 1>;
 #define DEFINE_TYPE(T) DEFINE_DIM(T, CPU_PROVIDED_IXDIM)
 
+#if CPU_PROVIDED_IXDIM <= SHOULD_REGISTER_MAX_RANK
 TF_CALL_bool(DEFINE_TYPE);
 TF_CALL_float(DEFINE_TYPE);
 TF_CALL_double(DEFINE_TYPE);
@@ -60,6 +64,7 @@ TF_CALL_uint8(DEFINE_TYPE);
 TF_CALL_int16(DEFINE_TYPE);
 TF_CALL_int32(DEFINE_TYPE);
 TF_CALL_int64(DEFINE_TYPE);
+#endif
 
 #undef DEFINE_DIM
 #undef DEFINE_TYPE
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/topk_op.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -33,7 +34,7 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-template <typename T>
+template <typename Device, typename T>
 class TopK : public OpKernel {
  public:
   explicit TopK(OpKernelConstruction* context) : OpKernel(context) {
@@ -77,12 +78,68 @@ class TopK : public OpKernel {
     OP_REQUIRES_OK(context,
                    context->allocate_output(1, output_shape, &indices_out));
 
-    // Nothing to do for top-nothing.
-    if (k == 0) return;
+    // Nothing to do for top-nothing or over nothing.
+    if (k == 0 || num_rows == 0) return;
 
     auto values = values_out->flat_inner_dims<T>();
     auto indices = indices_out->flat_inner_dims<int32>();
+    Status s = functor::TopKFunctor<Device, T>::Compute(
+        context, sorted_, k, input, num_rows, num_cols, values, indices);
+    OP_REQUIRES_OK(context, s);
+  }
+
+ private:
+  int k_;
+  bool sorted_;
+};
 
+namespace functor {
+
+namespace {
+
+// Below this k, a heap of size k is faster than selection, since after it
+// fills up most elements of a row are rejected with one comparison.
+const int kMinSelectionK = 256;
+
+// Rows are only split into shards of at least this many columns.
+const int64 kMinColsPerShard = 64 * 1024;
+
+// Orders column indices of `row` by decreasing value and then by
+// increasing index, so that the lower-index of two equal elements is
+// selected first.
+template <typename T>
+struct TopKIndexComparator {
+  explicit TopKIndexComparator(const T* row) : row(row) {}
+  bool operator()(const int32 a, const int32 b) const {
+    return row[a] > row[b] || (row[a] == row[b] && a < b);
+  }
+  const T* row;
+};
+
+// Moves the top `k` of the column indices in [begin, end) to the front of
+// the range, in order if `sorted` is true. This takes time linear in the
+// size of the range plus O(k log k) for sorting, which beats a heap for
+// large k.
+template <typename T>
+void SelectTopK(const T* row, int k, bool sorted, int32* begin, int32* end) {
+  const TopKIndexComparator<T> comp(row);
+  if (k < end - begin) {
+    std::nth_element(begin, begin + k, end, comp);
+  }
+  if (sorted) {
+    std::sort(begin, begin + k, comp);
+  }
+}
+
+}  // namespace
+
+template <typename T>
+struct TopKFunctor<CPUDevice, T> {
+  static Status Compute(OpKernelContext* context, bool sorted, int k,
+                        const typename TTypes<T, 2>::ConstTensor& input,
+                        const int64 num_rows, const int64 num_cols,
+                        typename TTypes<T, 2>::Tensor values,
+                        typename TTypes<int, 2>::Tensor indices) {
     const CPUDevice& d = context->eigen_device<CPUDevice>();
 
     // Special case for k == 1.
@@ -108,35 +165,92 @@ class TopK : public OpKernel {
         }
       }
 
-      return;
+      return Status::OK();
+    }
+
+    const int64 cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                           Eigen::TensorOpCost::AddCost<T>();
+    const int64 copy_cost = 2 * k * Eigen::TensorOpCost::AddCost<T>();
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // When there are fewer rows than threads, split each row into shards
+    // of columns, select the top k of each shard in parallel, and then
+    // select the top k of the shards' candidates. Each shard has at least
+    // 4 * k columns, so the candidates are at most a quarter of the row.
+    const int64 num_shards_per_row = std::min<int64>(
+        std::max<int64>(1, worker_threads.num_threads / num_rows),
+        num_cols / std::max<int64>(kMinColsPerShard, 4 * k));
+    if (num_shards_per_row > 1) {
+      const int64 num_candidates = num_shards_per_row * k;
+      std::vector<int32> candidates(num_rows * num_candidates);
+      auto SelectShards = [&](int64 start_shard, int64 limit_shard) {
+        std::vector<int32> shard_indices;
+        for (int64 s = start_shard; s < limit_shard; ++s) {
+          const int64 b = s / num_shards_per_row;
+          const int64 shard = s % num_shards_per_row;
+          const int32 col_begin = shard * num_cols / num_shards_per_row;
+          const int32 col_end = (shard + 1) * num_cols / num_shards_per_row;
+          shard_indices.resize(col_end - col_begin);
+          std::iota(shard_indices.begin(), shard_indices.end(), col_begin);
+          SelectTopK(&input(b, 0), k, /*sorted=*/false, shard_indices.data(),
+                     shard_indices.data() + shard_indices.size());
+          std::copy(shard_indices.begin(), shard_indices.begin() + k,
+                    candidates.begin() + s * k);
+        }
+      };
+      const int64 shard_cost = cmp_cost * (num_cols / num_shards_per_row);
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            num_rows * num_shards_per_row, shard_cost, SelectShards);
+
+      auto MergeShards = [&](int64 start_batch, int64 limit_batch) {
+        for (int64 b = start_batch; b < limit_batch; ++b) {
+          int32* row_candidates = &candidates[b * num_candidates];
+          SelectTopK(&input(b, 0), k, sorted, row_candidates,
+                     row_candidates + num_candidates);
+          std::copy(row_candidates, row_candidates + k, &indices(b, 0));
+          std::transform(
+              &indices(b, 0), &indices(b, k), &values(b, 0),
+              [b, &input](const int32 loc) { return input(b, loc); });
+        }
+      };
+      const int64 merge_cost =
+          cmp_cost * static_cast<int64>(
+                         num_candidates +
+                         k * Eigen::numext::log2(static_cast<float>(k + 1))) +
+          copy_cost;
+      Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+            merge_cost, MergeShards);
+      return Status::OK();
     }
 
-    auto SortIndices = [&, context](int start_batch, int limit_batch) {
+    const bool use_selection = k >= kMinSelectionK && k < num_cols;
+    auto SortIndices = [&](int64 start_batch, int64 limit_batch) {
+      std::vector<int32> row_indices;
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto comp = [input_data](const int32 a, const int32 b) {
-          return input_data[a] > input_data[b];
-        };
-        gtl::TopN<int32, decltype(comp)> filter(k, comp);
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
+        const TopKIndexComparator<T> comp(input_data);
         if (k == num_cols) {
           // Set the initial array of indices 0 ... k - 1.
           std::iota(&indices(b, 0), &indices(b, k), 0);
           // Use an in-place sort.
           std::sort(&indices(b, 0), &indices(b, k), comp);
+        } else if (use_selection) {
+          row_indices.resize(num_cols);
+          std::iota(row_indices.begin(), row_indices.end(), 0);
+          SelectTopK(input_data, k, sorted, row_indices.data(),
+                     row_indices.data() + num_cols);
+          std::copy(row_indices.begin(), row_indices.begin() + k,
+                    &indices(b, 0));
         } else {
           // Use the TopN heap object to sort.
+          gtl::TopN<int32, TopKIndexComparator<T>> filter(k, comp);
           filter.reserve(num_cols);
           for (int32 c = 0; c < num_cols; ++c) {
             filter.push(c);
           }
 
           int32 i = 0;
-          if (sorted_) {
+          if (sorted) {
             std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
             for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
                  ++top_k_it, ++i) {
@@ -156,37 +270,73 @@ class TopK : public OpKernel {
       }  // for (int32 b = ...
     };
 
-    // Guesstimate of cost; 4*N*log(K) where N == num_cols.
-    // If K == N, assume the cost is N*log(K + 1).
-    const int64 cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
-                           Eigen::TensorOpCost::AddCost<T>();
-    const int64 base_cost =
-        cmp_cost *
-        static_cast<int64>(num_cols *
-                           Eigen::numext::log2(static_cast<float>(k + 1)));
-    const int64 sort_cost = (k == num_cols) ? base_cost : 4 * base_cost;
-    const int64 copy_cost = 2 * k * Eigen::TensorOpCost::AddCost<T>();
+    // Guesstimate of cost; 4*N*log(K) where N == num_cols for the heap, and
+    // 2*N + K*log(K) for selection. If K == N, assume the cost is
+    // N*log(K + 1).
+    const int64 log_k = Eigen::numext::log2(static_cast<float>(k + 1));
+    int64 sort_cost;
+    if (k == num_cols) {
+      sort_cost = cmp_cost * num_cols * log_k;
+    } else if (use_selection) {
+      sort_cost = cmp_cost * (2 * num_cols + k * log_k);
+    } else {
+      sort_cost = 4 * cmp_cost * num_cols * log_k;
+    }
     const int64 total_cost = sort_cost + copy_cost;
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           total_cost, SortIndices);
+    return Status::OK();
   }
-
- private:
-  int k_;
-  bool sorted_;
 };
 
-#define REGISTER_KERNELS_NAME(name, type) \
-  REGISTER_KERNEL_BUILDER(                \
-      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), TopK<type>)
+}  // namespace functor
+
+#define REGISTER_KERNELS_NAME(name, type)                       \
+  REGISTER_KERNEL_BUILDER(                                      \
+      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      TopK<CPUDevice, type>)
 
 #define REGISTER_KERNELS(type)       \
   REGISTER_KERNELS_NAME(TopK, type); \
   REGISTER_KERNELS_NAME(TopKV2, type)
 
 TF_CALL_REAL_NUMBER_TYPES(REGISTER_KERNELS);
-#undef REGISTER_KERNELS_TO_NAME
+#undef REGISTER_KERNELS_NAME
+#undef REGISTER_KERNELS
+
+#if GOOGLE_CUDA
+
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                  \
+  template <>                                                                \
+  Status TopKFunctor<GPUDevice, T>::Compute(                                 \
+      OpKernelContext* context, bool sorted, int k,                          \
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows, \
+      const int64 num_cols, typename TTypes<T, 2>::Tensor values,            \
+      typename TTypes<int, 2>::Tensor indices);
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+TF_CALL_int64(DECLARE_GPU_SPEC);
+
+#undef DECLARE_GPU_SPEC
+
+}  // namespace functor
+
+// The k input of TopKV2 is read on the host.
+#define REGISTER_KERNELS(type)                                   \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("TopK").Device(DEVICE_GPU).TypeConstraint<type>("T"), \
+      TopK<GPUDevice, type>);                                    \
+  REGISTER_KERNEL_BUILDER(Name("TopKV2")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .HostMemory("k"),                  \
+                          TopK<GPUDevice, type>)
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_KERNELS);
+TF_CALL_int64(REGISTER_KERNELS);
 #undef REGISTER_KERNELS
 
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensorflow
@@ -0,0 +1,257 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/topk_op.h"
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// Maps values to unsigned keys with the same order, so that the top k can
+// be selected one radix digit at a time.
+template <typename T>
+struct RadixKey;
+
+template <>
+struct RadixKey<Eigen::half> {
+  typedef uint16 Type;
+  __device__ static Type Convert(Eigen::half value) {
+    const uint16 bits = value.x;
+    return (bits & 0x8000u) ? static_cast<uint16>(~bits)
+                            : static_cast<uint16>(bits | 0x8000u);
+  }
+};
+
+template <>
+struct RadixKey<float> {
+  typedef uint32 Type;
+  __device__ static Type Convert(float value) {
+    const uint32 bits = __float_as_uint(value);
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  typedef uint64 Type;
+  __device__ static Type Convert(double value) {
+    const uint64 bits = static_cast<uint64>(__double_as_longlong(value));
+    return (bits & 0x8000000000000000ull) ? ~bits
+                                          : bits | 0x8000000000000000ull;
+  }
+};
+
+template <>
+struct RadixKey<int64> {
+  typedef uint64 Type;
+  __device__ static Type Convert(int64 value) {
+    return static_cast<uint64>(value) ^ 0x8000000000000000ull;
+  }
+};
+
+const int kBlockSize = 256;
+const int kRadixBits = 8;
+const int kRadixSize = 1 << kRadixBits;
+
+// Selects the top k of one row per block. A radix select finds the key of
+// the k-th largest element, one 8-bit digit at a time, and then a pass in
+// column order writes the larger elements followed by the lower-index
+// elements equal to the k-th largest. If `sorted`, the elements larger
+// than the k-th largest are then placed by their rank; the equal elements
+// are already in their final order at the end.
+template <typename T>
+__global__ void __launch_bounds__(kBlockSize)
+    RadixSelectTopKKernel(const T* input, int num_cols, int k, bool sorted,
+                          T* selected_values, int32* selected_indices,
+                          T* values, int32* indices) {
+  typedef typename RadixKey<T>::Type Key;
+  const int kNumBits = sizeof(Key) * 8;
+
+  __shared__ int histogram[kRadixSize];
+  __shared__ Key prefix;
+  __shared__ Key prefix_mask;
+  __shared__ int num_remaining;
+  __shared__ int greater_scan[kBlockSize];
+  __shared__ int equal_scan[kBlockSize];
+  __shared__ int num_greater_written;
+  __shared__ int num_equal_written;
+
+  const T* row = input + static_cast<int64>(blockIdx.x) * num_cols;
+  const int64 out_offset = static_cast<int64>(blockIdx.x) * k;
+  const int tid = threadIdx.x;
+
+  if (tid == 0) {
+    prefix = 0;
+    prefix_mask = 0;
+    num_remaining = k;
+    num_greater_written = 0;
+    num_equal_written = 0;
+  }
+  __syncthreads();
+
+  for (int shift = kNumBits - kRadixBits; shift >= 0; shift -= kRadixBits) {
+    for (int i = tid; i < kRadixSize; i += kBlockSize) {
+      histogram[i] = 0;
+    }
+    __syncthreads();
+    for (int c = tid; c < num_cols; c += kBlockSize) {
+      const Key key = RadixKey<T>::Convert(row[c]);
+      if ((key & prefix_mask) == prefix) {
+        atomicAdd(&histogram[(key >> shift) & (kRadixSize - 1)], 1);
+      }
+    }
+    __syncthreads();
+    if (tid == 0) {
+      int remaining = num_remaining;
+      for (int digit = kRadixSize - 1; digit >= 0; --digit) {
+        if (histogram[digit] >= remaining) {
+          prefix |= static_cast<Key>(digit) << shift;
+          prefix_mask |= static_cast<Key>(kRadixSize - 1) << shift;
+          break;
+        }
+        remaining -= histogram[digit];
+      }
+      num_remaining = remaining;
+    }
+    __syncthreads();
+  }
+
+  // `prefix` is now the key of the k-th largest element, and the top k
+  // consists of all larger elements and the first `num_remaining` equal
+  // ones.
+  const Key kth_key = prefix;
+  const int num_greater = k - num_remaining;
+  T* out_values = (sorted ? selected_values : values) + out_offset;
+  int32* out_indices = (sorted ? selected_indices : indices) + out_offset;
+  for (int base = 0; base < num_cols; base += kBlockSize) {
+    const int c = base + tid;
+    bool greater = false;
+    bool equal = false;
+    if (c < num_cols) {
+      const Key key = RadixKey<T>::Convert(row[c]);
+      greater = key > kth_key;
+      equal = key == kth_key;
+    }
+    greater_scan[tid] = greater;
+    equal_scan[tid] = equal;
+    __syncthreads();
+    for (int offset = 1; offset < kBlockSize; offset <<= 1) {
+      const int greater_addend = tid >= offset ? greater_scan[tid - offset] : 0;
+      const int equal_addend = tid >= offset ? equal_scan[tid - offset] : 0;
+      __syncthreads();
+      greater_scan[tid] += greater_addend;
+      equal_scan[tid] += equal_addend;
+      __syncthreads();
+    }
+    if (greater) {
+      const int position = num_greater_written + greater_scan[tid] - 1;
+      out_values[position] = row[c];
+      out_indices[position] = c;
+    } else if (equal) {
+      const int rank = num_equal_written + equal_scan[tid] - 1;
+      if (rank < num_remaining) {
+        out_values[num_greater + rank] = row[c];
+        out_indices[num_greater + rank] = c;
+      }
+    }
+    __syncthreads();
+    if (tid == kBlockSize - 1) {
+      num_greater_written += greater_scan[tid];
+      num_equal_written += equal_scan[tid];
+    }
+    __syncthreads();
+  }
+
+  if (!sorted) return;
+
+  // Each of the larger elements is placed at its rank among them, ordered
+  // by decreasing key and then increasing index.
+  for (int i = tid; i < k; i += kBlockSize) {
+    const T value = out_values[i];
+    const int32 index = out_indices[i];
+    int position = i;
+    if (i < num_greater) {
+      const Key key = RadixKey<T>::Convert(value);
+      position = 0;
+      for (int j = 0; j < num_greater; ++j) {
+        const Key other_key = RadixKey<T>::Convert(out_values[j]);
+        if (other_key > key || (other_key == key && out_indices[j] < index)) {
+          ++position;
+        }
+      }
+    }
+    values[out_offset + position] = value;
+    indices[out_offset + position] = index;
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+#define DEFINE_GPU_SPEC(T)                                                    \
+  template <>                                                                 \
+  Status TopKFunctor<GPUDevice, T>::Compute(                                  \
+      OpKernelContext* context, bool sorted, int k,                           \
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,  \
+      const int64 num_cols, typename TTypes<T, 2>::Tensor values,             \
+      typename TTypes<int, 2>::Tensor indices) {                              \
+    if (num_cols > std::numeric_limits<int32>::max()) {                       \
+      return errors::InvalidArgument(                                         \
+          "TopK on GPU does not support rows of more than ",                  \
+          std::numeric_limits<int32>::max(), " elements");                    \
+    }                                                                         \
+    Tensor selected_values;                                                   \
+    Tensor selected_indices;                                                  \
+    if (sorted) {                                                             \
+      TF_RETURN_IF_ERROR(context->allocate_temp(                              \
+          DataTypeToEnum<T>::value, TensorShape({num_rows, k}),               \
+          &selected_values));                                                 \
+      TF_RETURN_IF_ERROR(context->allocate_temp(                              \
+          DT_INT32, TensorShape({num_rows, k}), &selected_indices));          \
+    }                                                                         \
+    const GPUDevice& d = context->eigen_device<GPUDevice>();                  \
+    RadixSelectTopKKernel<T><<<num_rows, kBlockSize, 0, d.stream()>>>(        \
+        input.data(), num_cols, k, sorted,                                    \
+        sorted ? selected_values.flat<T>().data() : nullptr,                  \
+        sorted ? selected_indices.flat<int32>().data() : nullptr,             \
+        values.data(), indices.data());                                       \
+    if (!d.ok()) {                                                            \
+      return errors::Internal("Launching RadixSelectTopKKernel failed");      \
+    }                                                                         \
+    return Status::OK();                                                      \
+  }
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPEC);
+TF_CALL_int64(DEFINE_GPU_SPEC);
+
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/kernels/variable_ops.h"
 
 namespace tensorflow {
@@ -45,24 +48,23 @@ std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
     return locks;
   }
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
+  mutexes.reserve(input_ids.size());
   for (auto input : input_ids) {
-    mutex* mutex = GetTrainingVariableMutex(ctx, input);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
-      mutexes.push_back(mutex);
-    }
-  }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
-
-  for (auto input : acquire_order) {
     mutex* mu = GetTrainingVariableMutex(ctx, input);
     if (mu != nullptr) {
-      locks.emplace_back(*mu);
+      mutexes.push_back(mu);
     }
   }
+  // Sort by address and only lock each mutex once if duplicates exist. The
+  // multi-tensor apply ops pass hundreds of inputs here, so avoid quadratic
+  // duplicate detection.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
+
+  locks.reserve(mutexes.size());
+  for (mutex* mu : mutexes) {
+    locks.emplace_back(*mu);
+  }
   return locks;
 }
 
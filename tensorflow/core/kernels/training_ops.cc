@@ -17,11 +17,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include <algorithm>
+#include <numeric>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/scatter_functor.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -40,7 +43,26 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// Calls fn(i, index) for each of the N sparse updates of a SparseApply* op,
+// where index is the row of the variable that update i applies to. Large
+// updates run in parallel, with each thread owning a disjoint range of rows;
+// see ParallelForEachUpdateByRow in scatter_functor.h.
+template <typename T, typename Tindex, typename Fn>
+Status ApplySparseUpdates(OpKernelContext* ctx, const Tindex* indices,
+                          Tindex N, Tindex first_dim_size, int64 row_size,
+                          Fn fn) {
+  const Tindex bad_i = scatter_op::internal::ParallelForEachUpdateByRow(
+      ctx->eigen_device<CPUDevice>(), indices, N, first_dim_size,
+      row_size * sizeof(T), fn);
+  if (bad_i >= 0) {
+    return errors::InvalidArgument(
+        strings::StrCat("Index ", indices[bad_i], " at offset ", bad_i,
+                        " in indices is out of range"));
+  }
+  return Status::OK();
 }
+}  // namespace
 
 namespace functor {
 template <typename T>
@@ -763,15 +785,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
 
       auto var_flat = var.flat_outer_dims<T>();
       auto accum_grad_flat = accum_grad.flat_outer_dims<T>();
@@ -781,8 +795,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
       const T rho_scalar = rho.scalar<T>()();
       const T epsilon_scalar = epsilon.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
+      auto update_row = [&](Tindex i, Tindex index) {
         auto accum_ = accum_grad_flat.template chip<0>(index);
         auto accum_update_ = accum_update_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -797,7 +810,11 @@ class SparseApplyAdadeltaOp : public OpKernel {
             update.square() * update.constant(static_cast<T>(1) - rho_scalar);
         auto v = var_flat.template chip<0>(index);
         v -= update * update.constant(lr_scalar);
-      }
+      };
+      OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                first_dim_size,
+                                                grad.NumElements() / N,
+                                                update_row));
     }
     if (use_exclusive_lock_) {
       mu_var->unlock();
@@ -966,12 +983,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
 
         // TODO(xbing): extract the common logic for the Fobos update.
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
           // compute learning_rate for current step.
@@ -989,7 +1001,11 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
             v = prox_v /
                 (v.constant(1.0) + v.constant(l2_scalar) * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -999,12 +1015,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const Tindex first_dim_size = var_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           const T& g = grad_flat(i);
           auto learning_rate = lr_scalar;
           auto prox_v = var_flat(index);
@@ -1018,7 +1029,11 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
           } else {
             var_flat(index) = prox_v / (1.0 + l2_scalar * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       }
     }
 
@@ -1316,18 +1331,17 @@ class SparseApplyAdagradOp : public OpKernel {
 
         // Note(yonghui): It might be worth multi-threading square() and
         // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
           a += g.square();
           v -= g.constant(lr_scalar) * g * a.rsqrt();
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1336,17 +1350,16 @@ class SparseApplyAdagradOp : public OpKernel {
         T lr_scalar = lr.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           a += g * g;
           var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       }
     }
 
@@ -1467,12 +1480,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
         T l1_scalar = l1.scalar<T>()();
         T l2_scalar = l2.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
@@ -1492,7 +1500,11 @@ class SparseApplyProximalAdagradOp : public OpKernel {
             v = prox_v /
                 (v.constant(1.0) + v.constant(l2_scalar) * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1503,12 +1515,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           a += g * g;
@@ -1524,7 +1531,11 @@ class SparseApplyProximalAdagradOp : public OpKernel {
           } else {
             var_flat(index) = prox_v / (1.0 + l2_scalar * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       }
     }
 
@@ -1764,12 +1775,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const double gs_lr = global_step_scalar * lr_scalar;
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           auto ga = gradient_accum_flat.template chip<0>(index);
           auto da = gradient_squared_accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
@@ -1786,7 +1792,11 @@ class SparseApplyAdagradDAOp : public OpKernel {
             v = ga.constant(-1.0) * (ga / ga.constant(global_step_scalar)) /
                 (v.constant(l2_scalar) + da.sqrt() / v.constant(gs_lr));
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1801,12 +1811,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
         const double gs_l1 = global_step_scalar * l1_scalar;
         const double gs_l2_lr = global_step_scalar * l2_scalar * lr_scalar;
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           T& ga = gradient_accum_flat(index);
           T& da = gradient_squared_accum_flat(index);
           const double g = grad_flat(i);
@@ -1819,7 +1824,11 @@ class SparseApplyAdagradDAOp : public OpKernel {
           } else {
             var_flat(index) = (-ga * lr_scalar) / (gs_l2_lr + std::sqrt(da));
           }
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       }
     }
 
@@ -2074,12 +2083,7 @@ class SparseApplyFtrlOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           auto accum = accum_flat.template chip<0>(index);
           auto linear = linear_flat.template chip<0>(index);
           auto grad = grad_flat.template chip<0>(i);
@@ -2109,7 +2113,11 @@ class SparseApplyFtrlOp : public OpKernel {
           var = (linear.abs() > linear.constant(l1_scalar))
                     .select(var, var.constant(static_cast<T>(0)));
           accum += grad.square();
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -2122,12 +2130,7 @@ class SparseApplyFtrlOp : public OpKernel {
         T lr_power_scalar = lr_power.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update_row = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           T& l = linear_flat(index);
           T& v = var_flat(index);
@@ -2142,7 +2145,11 @@ class SparseApplyFtrlOp : public OpKernel {
                           lr_power_scalar);
           a = updated_a;
           l = updated_l;
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                  first_dim_size,
+                                                  grad.NumElements() / N,
+                                                  update_row));
       }
     }
 
@@ -2346,12 +2353,7 @@ class SparseApplyMomentumOp : public OpKernel {
       T lr_scalar = lr.scalar<T>()();
       T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-        OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
+      auto update_row = [&](Tindex i, Tindex index) {
         auto a = accum_flat.template chip<0>(index);
         auto g = grad_flat.template chip<0>(i);
         auto v = var_flat.template chip<0>(index);
@@ -2362,7 +2364,11 @@ class SparseApplyMomentumOp : public OpKernel {
         } else {
           v -= a.constant(lr_scalar) * a;
         }
-      }
+      };
+      OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                first_dim_size,
+                                                grad.NumElements() / N,
+                                                update_row));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -2655,6 +2661,381 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+namespace {
+
+// Fetches inputs [start, start + n) of a multi-tensor apply op, which must all
+// be initialized variables.
+Status GetMultiInputVariables(OpKernelContext* ctx, int start, int n,
+                              bool lock_held, std::vector<Tensor>* out) {
+  out->resize(n);
+  for (int i = 0; i < n; ++i) {
+    TF_RETURN_IF_ERROR(
+        GetInputTensorFromVariable(ctx, start + i, lock_held, &(*out)[i]));
+    if (!(*out)[i].IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ",
+          ctx->op_kernel().requested_input(start + i));
+    }
+  }
+  return Status::OK();
+}
+
+Status CheckMultiInputShape(int i, const char* name, const Tensor& var,
+                            const Tensor& other) {
+  if (!var.shape().IsSameSize(other.shape())) {
+    return errors::InvalidArgument("var[", i, "] and ", name, "[", i,
+                                   "] do not have the same shape",
+                                   var.shape().DebugString(), " ",
+                                   other.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+Status CheckMultiInputScalar(const char* name, const Tensor& t) {
+  if (!TensorShapeUtils::IsScalar(t.shape())) {
+    return errors::InvalidArgument(name, " is not a scalar: ",
+                                   t.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// Calls fn(i, begin, end) on element ranges [begin, end) of the tensors with
+// the given sizes. The elements of all tensors are sharded together across the
+// CPU worker threads, so large tensors are split and small ones are batched.
+template <typename Fn>
+void ShardMultiTensor(OpKernelContext* ctx, const std::vector<int64>& sizes,
+                      int64 cost_per_element, Fn fn) {
+  std::vector<int64> offsets(sizes.size() + 1, 0);
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    offsets[i + 1] = offsets[i] + sizes[i];
+  }
+  auto work = [&offsets, &fn](int64 start, int64 limit) {
+    int i = std::upper_bound(offsets.begin(), offsets.end(), start) -
+            offsets.begin() - 1;
+    for (; start < limit; ++i) {
+      const int64 end = std::min(limit, offsets[i + 1]);
+      if (end > start) {
+        fn(i, start - offsets[i], end - offsets[i]);
+      }
+      start = end;
+    }
+  };
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, offsets.back(),
+        cost_per_element, work);
+}
+
+}  // namespace
+
+// The Launch* structs run the update for all tensors. Devices other than the
+// CPU use the functor; the CPU shards the elements with the work sharder.
+template <typename Device, typename T>
+struct LaunchMultiApplyMomentum {
+  static void launch(OpKernelContext* ctx, const std::vector<T*>& var,
+                     const std::vector<T*>& accum,
+                     const std::vector<const T*>& grad,
+                     const std::vector<int64>& sizes,
+                     typename TTypes<T>::ConstScalar lr,
+                     typename TTypes<T>::ConstScalar momentum,
+                     bool use_nesterov) {
+    functor::MultiApplyMomentum<Device, T>()(ctx->eigen_device<Device>(), var,
+                                             accum, grad, sizes, lr, momentum,
+                                             use_nesterov);
+  }
+};
+
+template <typename T>
+struct LaunchMultiApplyMomentum<CPUDevice, T> {
+  static void launch(OpKernelContext* ctx, const std::vector<T*>& var,
+                     const std::vector<T*>& accum,
+                     const std::vector<const T*>& grad,
+                     const std::vector<int64>& sizes,
+                     typename TTypes<T>::ConstScalar lr,
+                     typename TTypes<T>::ConstScalar momentum,
+                     bool use_nesterov) {
+    const T lr_v = lr();
+    const T momentum_v = momentum();
+    ShardMultiTensor(ctx, sizes, 10, [&](int i, int64 begin, int64 end) {
+      typename TTypes<T>::Flat var_i(var[i] + begin, end - begin);
+      typename TTypes<T>::Flat accum_i(accum[i] + begin, end - begin);
+      typename TTypes<T>::ConstFlat grad_i(grad[i] + begin, end - begin);
+      accum_i = accum_i * momentum_v + grad_i;
+      if (use_nesterov) {
+        var_i -= grad_i * lr_v + accum_i * momentum_v * lr_v;
+      } else {
+        var_i -= accum_i * lr_v;
+      }
+    });
+  }
+};
+
+template <typename Device, typename T>
+class MultiApplyMomentumOp : public OpKernel {
+ public:
+  explicit MultiApplyMomentumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_tensors_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int n = num_tensors_;
+    std::vector<int> variable_inputs(2 * n);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(
+        ctx, GetMultiInputVariables(ctx, 0, n, use_exclusive_lock_, &var));
+    std::vector<Tensor> accum;
+    OP_REQUIRES_OK(
+        ctx, GetMultiInputVariables(ctx, n, n, use_exclusive_lock_, &accum));
+    const Tensor& lr = ctx->input(2 * n);
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("lr", lr));
+    const Tensor& momentum = ctx->input(3 * n + 1);
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("momentum", momentum));
+
+    std::vector<T*> var_data(n);
+    std::vector<T*> accum_data(n);
+    std::vector<const T*> grad_data(n);
+    std::vector<int64> sizes(n);
+    for (int i = 0; i < n; ++i) {
+      const Tensor& grad = ctx->input(2 * n + 1 + i);
+      OP_REQUIRES_OK(ctx, CheckMultiInputShape(i, "accum", var[i], accum[i]));
+      OP_REQUIRES_OK(ctx, CheckMultiInputShape(i, "grad", var[i], grad));
+      var_data[i] = var[i].flat<T>().data();
+      accum_data[i] = accum[i].flat<T>().data();
+      grad_data[i] = grad.flat<T>().data();
+      sizes[i] = var[i].NumElements();
+    }
+
+    LaunchMultiApplyMomentum<Device, T>::launch(
+        ctx, var_data, accum_data, grad_data, sizes, lr.scalar<T>(),
+        momentum.scalar<T>(), use_nesterov_);
+    for (int i = 0; i < n; ++i) {
+      MaybeForwardRefInputToRefOutput(ctx, i, i);
+    }
+  }
+
+ private:
+  int num_tensors_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                                              \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("MultiApplyMomentum").Device(DEVICE_##D).TypeConstraint<T>("T"), \
+      MultiApplyMomentumOp<D##Device, T>);                                  \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyMomentum")                \
+                              .Device(DEVICE_##D)                           \
+                              .HostMemory("var")                            \
+                              .HostMemory("accum")                          \
+                              .TypeConstraint<T>("T"),                      \
+                          MultiApplyMomentumOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                   \
+  template <>                                                                 \
+  void MultiApplyMomentum<GPUDevice, T>::operator()(                          \
+      const GPUDevice& d, const std::vector<T*>& var,                         \
+      const std::vector<T*>& accum, const std::vector<const T*>& grad,        \
+      const std::vector<int64>& sizes, typename TTypes<T>::ConstScalar lr,    \
+      typename TTypes<T>::ConstScalar momentum, bool use_nesterov);           \
+  extern template struct MultiApplyMomentum<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
+template <typename Device, typename T>
+struct LaunchMultiApplyAdam {
+  static void launch(OpKernelContext* ctx, const std::vector<T*>& var,
+                     const std::vector<T*>& m, const std::vector<T*>& v,
+                     const std::vector<const T*>& grad,
+                     const std::vector<int64>& sizes,
+                     typename TTypes<T>::ConstScalar beta1_power,
+                     typename TTypes<T>::ConstScalar beta2_power,
+                     typename TTypes<T>::ConstScalar lr,
+                     typename TTypes<T>::ConstScalar beta1,
+                     typename TTypes<T>::ConstScalar beta2,
+                     typename TTypes<T>::ConstScalar epsilon,
+                     bool use_nesterov) {
+    functor::MultiApplyAdam<Device, T>()(
+        ctx->eigen_device<Device>(), var, m, v, grad, sizes, beta1_power,
+        beta2_power, lr, beta1, beta2, epsilon, use_nesterov);
+  }
+};
+
+template <typename T>
+struct LaunchMultiApplyAdam<CPUDevice, T> {
+  static void launch(OpKernelContext* ctx, const std::vector<T*>& var,
+                     const std::vector<T*>& m, const std::vector<T*>& v,
+                     const std::vector<const T*>& grad,
+                     const std::vector<int64>& sizes,
+                     typename TTypes<T>::ConstScalar beta1_power,
+                     typename TTypes<T>::ConstScalar beta2_power,
+                     typename TTypes<T>::ConstScalar lr,
+                     typename TTypes<T>::ConstScalar beta1,
+                     typename TTypes<T>::ConstScalar beta2,
+                     typename TTypes<T>::ConstScalar epsilon,
+                     bool use_nesterov) {
+    const T alpha = lr() * Eigen::numext::sqrt(T(1) - beta2_power()) /
+                    (T(1) - beta1_power());
+    const T beta1_v = beta1();
+    const T beta2_v = beta2();
+    const T epsilon_v = epsilon();
+    ShardMultiTensor(ctx, sizes, 30, [&](int i, int64 begin, int64 end) {
+      typename TTypes<T>::Flat var_i(var[i] + begin, end - begin);
+      typename TTypes<T>::Flat m_i(m[i] + begin, end - begin);
+      typename TTypes<T>::Flat v_i(v[i] + begin, end - begin);
+      typename TTypes<T>::ConstFlat grad_i(grad[i] + begin, end - begin);
+      m_i += (grad_i - m_i) * (T(1) - beta1_v);
+      v_i += (grad_i.square() - v_i) * (T(1) - beta2_v);
+      if (use_nesterov) {
+        var_i -= ((grad_i * (T(1) - beta1_v) + beta1_v * m_i) * alpha) /
+                 (v_i.sqrt() + epsilon_v);
+      } else {
+        var_i -= (m_i * alpha) / (v_i.sqrt() + epsilon_v);
+      }
+    });
+  }
+};
+
+template <typename Device, typename T>
+class MultiApplyAdamOp : public OpKernel {
+ public:
+  explicit MultiApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_tensors_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int n = num_tensors_;
+    std::vector<int> variable_inputs(3 * n);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(
+        ctx, GetMultiInputVariables(ctx, 0, n, use_exclusive_lock_, &var));
+    std::vector<Tensor> m;
+    OP_REQUIRES_OK(ctx,
+                   GetMultiInputVariables(ctx, n, n, use_exclusive_lock_, &m));
+    std::vector<Tensor> v;
+    OP_REQUIRES_OK(
+        ctx, GetMultiInputVariables(ctx, 2 * n, n, use_exclusive_lock_, &v));
+
+    const Tensor& beta1_power = ctx->input(3 * n);
+    const Tensor& beta2_power = ctx->input(3 * n + 1);
+    const Tensor& lr = ctx->input(3 * n + 2);
+    const Tensor& beta1 = ctx->input(3 * n + 3);
+    const Tensor& beta2 = ctx->input(3 * n + 4);
+    const Tensor& epsilon = ctx->input(3 * n + 5);
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("beta1_power", beta1_power));
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("beta2_power", beta2_power));
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("lr", lr));
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("beta1", beta1));
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("beta2", beta2));
+    OP_REQUIRES_OK(ctx, CheckMultiInputScalar("epsilon", epsilon));
+
+    std::vector<T*> var_data(n);
+    std::vector<T*> m_data(n);
+    std::vector<T*> v_data(n);
+    std::vector<const T*> grad_data(n);
+    std::vector<int64> sizes(n);
+    for (int i = 0; i < n; ++i) {
+      const Tensor& grad = ctx->input(3 * n + 6 + i);
+      OP_REQUIRES_OK(ctx, CheckMultiInputShape(i, "m", var[i], m[i]));
+      OP_REQUIRES_OK(ctx, CheckMultiInputShape(i, "v", var[i], v[i]));
+      OP_REQUIRES_OK(ctx, CheckMultiInputShape(i, "grad", var[i], grad));
+      var_data[i] = var[i].flat<T>().data();
+      m_data[i] = m[i].flat<T>().data();
+      v_data[i] = v[i].flat<T>().data();
+      grad_data[i] = grad.flat<T>().data();
+      sizes[i] = var[i].NumElements();
+    }
+
+    LaunchMultiApplyAdam<Device, T>::launch(
+        ctx, var_data, m_data, v_data, grad_data, sizes,
+        beta1_power.scalar<T>(), beta2_power.scalar<T>(), lr.scalar<T>(),
+        beta1.scalar<T>(), beta2.scalar<T>(), epsilon.scalar<T>(),
+        use_nesterov_);
+    for (int i = 0; i < n; ++i) {
+      MaybeForwardRefInputToRefOutput(ctx, i, i);
+    }
+  }
+
+ private:
+  int num_tensors_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                                          \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("MultiApplyAdam").Device(DEVICE_##D).TypeConstraint<T>("T"), \
+      MultiApplyAdamOp<D##Device, T>);                                  \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyAdam")                \
+                              .HostMemory("var")                        \
+                              .HostMemory("m")                          \
+                              .HostMemory("v")                          \
+                              .Device(DEVICE_##D)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          MultiApplyAdamOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                \
+  template <>                                                              \
+  void MultiApplyAdam<GPUDevice, T>::operator()(                           \
+      const GPUDevice& d, const std::vector<T*>& var,                      \
+      const std::vector<T*>& m, const std::vector<T*>& v,                  \
+      const std::vector<const T*>& grad, const std::vector<int64>& sizes,  \
+      typename TTypes<T>::ConstScalar beta1_power,                         \
+      typename TTypes<T>::ConstScalar beta2_power,                         \
+      typename TTypes<T>::ConstScalar lr,                                  \
+      typename TTypes<T>::ConstScalar beta1,                               \
+      typename TTypes<T>::ConstScalar beta2,                               \
+      typename TTypes<T>::ConstScalar epsilon, bool use_nesterov);         \
+  extern template struct MultiApplyAdam<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyRMSPropOp : public OpKernel {
  public:
@@ -2981,15 +3362,7 @@ class SparseApplyRMSPropOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
 
       auto var_flat = var.flat_outer_dims<T>();
       auto ms_flat = ms.flat_outer_dims<T>();
@@ -3000,9 +3373,7 @@ class SparseApplyRMSPropOp : public OpKernel {
       const T epsilon_scalar = epsilon.scalar<T>()();
       const T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-
+      auto update_row = [&](Tindex i, Tindex index) {
         auto ms_ = ms_flat.template chip<0>(index);
         auto mom_ = mom_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -3015,7 +3386,11 @@ class SparseApplyRMSPropOp : public OpKernel {
 
         auto v = var_flat.template chip<0>(index);
         v -= mom_;
-      }
+      };
+      OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                first_dim_size,
+                                                grad.NumElements() / N,
+                                                update_row));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -3118,15 +3493,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
 
       auto var_flat = var.flat_outer_dims<T>();
       auto ms_flat = ms.flat_outer_dims<T>();
@@ -3138,9 +3505,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
       const T epsilon_scalar = epsilon.scalar<T>()();
       const T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-
+      auto update_row = [&](Tindex i, Tindex index) {
         auto ms_ = ms_flat.template chip<0>(index);
         auto mom_ = mom_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -3156,7 +3521,11 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
                denom_.rsqrt() * ms_.constant(lr_scalar) * grad_;
         auto v = var_flat.template chip<0>(index);
         v -= mom_;
-      }
+      };
+      OP_REQUIRES_OK(ctx, ApplySparseUpdates<T>(ctx, indices_vec.data(), N,
+                                                first_dim_size,
+                                                grad.NumElements() / N,
+                                                update_row));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_TRAINING_OPS_H_
 #define TENSORFLOW_KERNELS_TRAINING_OPS_H_
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
@@ -135,6 +137,33 @@ struct ApplyAdam {
                   typename TTypes<T>::ConstFlat grad, bool use_nesterov);
 };
 
+// The multi-tensor variants update N variables in one call. Entry i of each
+// vector points at the flat buffer of the i-th tensor, which has sizes[i]
+// elements.
+template <typename Device, typename T>
+struct MultiApplyMomentum {
+  void operator()(const Device& d, const std::vector<T*>& var,
+                  const std::vector<T*>& accum,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar momentum, bool use_nesterov);
+};
+
+template <typename Device, typename T>
+struct MultiApplyAdam {
+  void operator()(const Device& d, const std::vector<T*>& var,
+                  const std::vector<T*>& m, const std::vector<T*>& v,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon, bool use_nesterov);
+};
+
 template <typename Device, typename T>
 struct ApplyRMSProp {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -18,12 +18,153 @@ limitations under the License.
 #define EIGEN_USE_GPU
 
 #include "tensorflow/core/kernels/training_ops.h"
+#include <limits>
+
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace {
+
+// The multi-tensor kernels receive their pointer tables by value as kernel
+// arguments, which are limited to 4KB, so at most this many tensors are
+// updated per launch.
+constexpr int kMaxTensorsPerLaunch = 48;
+
+// Arithmetic is done in float for half tensors.
+template <typename T>
+struct MultiApplyComputeType {
+  typedef T type;
+};
+template <>
+struct MultiApplyComputeType<Eigen::half> {
+  typedef float type;
+};
+
+// Tensors [0, num_tensors) of one launch. Tensor j holds the elements
+// [offsets[j], offsets[j + 1]) of the launch's flattened index space.
+template <typename T, int kNumOutputs>
+struct MultiTensorChunk {
+  T* out[kNumOutputs][kMaxTensorsPerLaunch];
+  const T* grad[kMaxTensorsPerLaunch];
+  int offsets[kMaxTensorsPerLaunch + 1];
+  int num_tensors;
+};
+
+// Returns the tensor of `chunk` that holds flattened element `index`.
+template <typename T, int kNumOutputs>
+__device__ int FindTensor(const MultiTensorChunk<T, kNumOutputs>& chunk,
+                          int index) {
+  int lo = 0;
+  int hi = chunk.num_tensors - 1;
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (chunk.offsets[mid] <= index) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+template <typename T>
+__global__ void MultiApplyMomentumKernel(int total,
+                                         MultiTensorChunk<T, 2> chunk,
+                                         const T* lr, const T* momentum,
+                                         bool use_nesterov) {
+  typedef typename MultiApplyComputeType<T>::type U;
+  const U lr_v = static_cast<U>(*lr);
+  const U momentum_v = static_cast<U>(*momentum);
+  CUDA_1D_KERNEL_LOOP(index, total) {
+    const int j = FindTensor(chunk, index);
+    const int k = index - chunk.offsets[j];
+    T* var = chunk.out[0][j] + k;
+    T* accum = chunk.out[1][j] + k;
+    const U grad = static_cast<U>(chunk.grad[j][k]);
+    const U new_accum = static_cast<U>(*accum) * momentum_v + grad;
+    *accum = static_cast<T>(new_accum);
+    if (use_nesterov) {
+      *var = static_cast<T>(static_cast<U>(*var) - grad * lr_v -
+                            new_accum * momentum_v * lr_v);
+    } else {
+      *var = static_cast<T>(static_cast<U>(*var) - new_accum * lr_v);
+    }
+  }
+}
+
+template <typename T>
+__global__ void MultiApplyAdamKernel(int total, MultiTensorChunk<T, 3> chunk,
+                                     const T* beta1_power,
+                                     const T* beta2_power, const T* lr,
+                                     const T* beta1, const T* beta2,
+                                     const T* epsilon, bool use_nesterov) {
+  typedef typename MultiApplyComputeType<T>::type U;
+  const U one = static_cast<U>(1);
+  const U beta1_v = static_cast<U>(*beta1);
+  const U beta2_v = static_cast<U>(*beta2);
+  const U epsilon_v = static_cast<U>(*epsilon);
+  const U alpha = static_cast<U>(*lr) *
+                  sqrt(one - static_cast<U>(*beta2_power)) /
+                  (one - static_cast<U>(*beta1_power));
+  CUDA_1D_KERNEL_LOOP(index, total) {
+    const int j = FindTensor(chunk, index);
+    const int k = index - chunk.offsets[j];
+    T* var = chunk.out[0][j] + k;
+    T* m = chunk.out[1][j] + k;
+    T* v = chunk.out[2][j] + k;
+    const U grad = static_cast<U>(chunk.grad[j][k]);
+    U new_m = static_cast<U>(*m);
+    U new_v = static_cast<U>(*v);
+    new_m += (grad - new_m) * (one - beta1_v);
+    new_v += (grad * grad - new_v) * (one - beta2_v);
+    *m = static_cast<T>(new_m);
+    *v = static_cast<T>(new_v);
+    const U update = use_nesterov ? grad * (one - beta1_v) + beta1_v * new_m
+                                  : new_m;
+    *var = static_cast<T>(static_cast<U>(*var) -
+                          update * alpha / (sqrt(new_v) + epsilon_v));
+  }
+}
+
+// Groups the tensors into chunks of at most kMaxTensorsPerLaunch tensors whose
+// total size fits in an int, and calls launch(chunk, total) for each. Empty
+// tensors are skipped.
+template <typename T, int kNumOutputs, typename Launch>
+void ForEachMultiTensorChunk(const std::vector<T*>* const* outs,
+                             const std::vector<const T*>& grad,
+                             const std::vector<int64>& sizes, Launch launch) {
+  MultiTensorChunk<T, kNumOutputs> chunk;
+  chunk.num_tensors = 0;
+  chunk.offsets[0] = 0;
+  int64 total = 0;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] == 0) continue;
+    DCHECK_LE(sizes[i], std::numeric_limits<int>::max());
+    if (chunk.num_tensors == kMaxTensorsPerLaunch ||
+        total + sizes[i] > std::numeric_limits<int>::max()) {
+      launch(chunk, static_cast<int>(total));
+      chunk.num_tensors = 0;
+      total = 0;
+    }
+    const int j = chunk.num_tensors++;
+    for (int o = 0; o < kNumOutputs; ++o) {
+      chunk.out[o][j] = (*outs[o])[i];
+    }
+    chunk.grad[j] = grad[i];
+    total += sizes[i];
+    chunk.offsets[j + 1] = static_cast<int>(total);
+  }
+  if (chunk.num_tensors > 0) {
+    launch(chunk, static_cast<int>(total));
+  }
+}
+
+}  // namespace
+
 namespace functor {
 template <typename T>
 struct ApplyGradientDescent<GPUDevice, T> {
@@ -193,6 +334,50 @@ struct ApplyCenteredRMSProp<GPUDevice, T> {
   }
 };
 
+template <typename T>
+struct MultiApplyMomentum<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& accum,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
+    const std::vector<T*>* outs[] = {&var, &accum};
+    ForEachMultiTensorChunk<T, 2>(
+        outs, grad, sizes, [&](const MultiTensorChunk<T, 2>& chunk, int total) {
+          CudaLaunchConfig config = GetCudaLaunchConfig(total, d);
+          MultiApplyMomentumKernel<T>
+              <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+                  total, chunk, lr.data(), momentum.data(), use_nesterov);
+        });
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& m, const std::vector<T*>& v,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon, bool use_nesterov) {
+    const std::vector<T*>* outs[] = {&var, &m, &v};
+    ForEachMultiTensorChunk<T, 3>(
+        outs, grad, sizes, [&](const MultiTensorChunk<T, 3>& chunk, int total) {
+          CudaLaunchConfig config = GetCudaLaunchConfig(total, d);
+          MultiApplyAdamKernel<T>
+              <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+                  total, chunk, beta1_power.data(), beta2_power.data(),
+                  lr.data(), beta1.data(), beta2.data(), epsilon.data(),
+                  use_nesterov);
+        });
+  }
+};
+
 }  // namespace functor
 
 template struct functor::ApplyGradientDescent<GPUDevice, Eigen::half>;
@@ -215,6 +400,14 @@ template struct functor::ApplyAdam<GPUDevice, Eigen::half>;
 template struct functor::ApplyAdam<GPUDevice, float>;
 template struct functor::ApplyAdam<GPUDevice, double>;
 
+template struct functor::MultiApplyMomentum<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyMomentum<GPUDevice, float>;
+template struct functor::MultiApplyMomentum<GPUDevice, double>;
+
+template struct functor::MultiApplyAdam<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyAdam<GPUDevice, float>;
+template struct functor::MultiApplyAdam<GPUDevice, double>;
+
 template struct functor::ApplyRMSProp<GPUDevice, Eigen::half>;
 template struct functor::ApplyRMSProp<GPUDevice, float>;
 template struct functor::ApplyRMSProp<GPUDevice, double>;
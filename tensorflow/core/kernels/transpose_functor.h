@@ -40,7 +40,9 @@ typedef gtl::InlinedVector<int32, 8> TransposePermsVec;
 
 // Helper function that takes a tensor shape, a permutation, combines the
 // neighboring shapes if their indices in the permutation are consecutive.
-// The function outputs the combined shape and new permutation.
+// The function outputs the combined shape (in input order) and new
+// permutation, where output dimension i is combined input dimension
+// new_perm[i].
 // Example: Tensor shape {2, 3, 4, 5, 120} and permutation {0, 4, 1, 2, 3} will
 // produce new shape {2, 60, 120} and new permutation {0, 2, 1}.
 inline void ReduceTransposeDimensions(const TensorShape& shape,
@@ -51,6 +53,7 @@ inline void ReduceTransposeDimensions(const TensorShape& shape,
   if (shape.dims() == 1) {
     // If input dimension is already 1, no need to reduce dimension.
     new_perm->resize(1);
+    new_dims->resize(1);
     (*new_perm)[0] = perm[0];
     (*new_dims)[0] = shape.dim_size(0);
     return;
@@ -82,7 +85,7 @@ inline void ReduceTransposeDimensions(const TensorShape& shape,
   for (int i = 0; i < new_dim_position.size(); ++i) {
     if (new_dim_position[i] >= 0) {
       int new_perm_idx = new_dim_position[i];
-      (*new_perm)[dim_idx] = new_perm_idx;
+      (*new_perm)[new_perm_idx] = dim_idx;
       (*new_dims)[dim_idx] = combined_dims[new_perm_idx];
       dim_idx++;
     }
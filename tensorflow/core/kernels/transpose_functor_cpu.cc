@@ -15,10 +15,23 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/kernels/ops_util.h"
 
 namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
 namespace internal {
 
 template <typename Device, typename T>
@@ -44,26 +57,346 @@ void TransposeSimple(const Device& d, const Tensor& in,
   }
 }
 
-}  // end namespace internal
+namespace {
 
-typedef Eigen::ThreadPoolDevice CPUDevice;
+// Transposes a 'rows' x 'cols' block one element at a time:
+//   dst[j * dst_stride + i] = src[i * src_stride + j]
+template <typename T>
+void TransposeBlockScalar(const T* src, int64 src_stride, T* dst,
+                          int64 dst_stride, int64 rows, int64 cols) {
+  for (int64 j = 0; j < cols; ++j) {
+    for (int64 i = 0; i < rows; ++i) {
+      dst[j * dst_stride + i] = src[i * src_stride + j];
+    }
+  }
+}
+
+// Transposes a square tile of kSize x kSize elements held in SIMD registers.
+// The generic version has no tile, so blocks are transposed element by
+// element.
+template <typename T>
+struct TransposeMicroKernel {
+  static const int kSize = 0;
+  static void Run(const T* src, int64 src_stride, T* dst, int64 dst_stride) {}
+};
+
+#if defined(__AVX__)
+template <>
+struct TransposeMicroKernel<uint32> {
+  static const int kSize = 8;
+  static void Run(const uint32* src, int64 src_stride, uint32* dst,
+                  int64 dst_stride) {
+    // The values are only moved around, so floating point shuffles preserve
+    // their bits.
+    const float* s = reinterpret_cast<const float*>(src);
+    float* d = reinterpret_cast<float*>(dst);
+    __m256 r0 = _mm256_loadu_ps(s + 0 * src_stride);
+    __m256 r1 = _mm256_loadu_ps(s + 1 * src_stride);
+    __m256 r2 = _mm256_loadu_ps(s + 2 * src_stride);
+    __m256 r3 = _mm256_loadu_ps(s + 3 * src_stride);
+    __m256 r4 = _mm256_loadu_ps(s + 4 * src_stride);
+    __m256 r5 = _mm256_loadu_ps(s + 5 * src_stride);
+    __m256 r6 = _mm256_loadu_ps(s + 6 * src_stride);
+    __m256 r7 = _mm256_loadu_ps(s + 7 * src_stride);
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    const __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    const __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    const __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    const __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+    const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    r0 = _mm256_permute2f128_ps(u0, u4, 0x20);
+    r1 = _mm256_permute2f128_ps(u1, u5, 0x20);
+    r2 = _mm256_permute2f128_ps(u2, u6, 0x20);
+    r3 = _mm256_permute2f128_ps(u3, u7, 0x20);
+    r4 = _mm256_permute2f128_ps(u0, u4, 0x31);
+    r5 = _mm256_permute2f128_ps(u1, u5, 0x31);
+    r6 = _mm256_permute2f128_ps(u2, u6, 0x31);
+    r7 = _mm256_permute2f128_ps(u3, u7, 0x31);
+    _mm256_storeu_ps(d + 0 * dst_stride, r0);
+    _mm256_storeu_ps(d + 1 * dst_stride, r1);
+    _mm256_storeu_ps(d + 2 * dst_stride, r2);
+    _mm256_storeu_ps(d + 3 * dst_stride, r3);
+    _mm256_storeu_ps(d + 4 * dst_stride, r4);
+    _mm256_storeu_ps(d + 5 * dst_stride, r5);
+    _mm256_storeu_ps(d + 6 * dst_stride, r6);
+    _mm256_storeu_ps(d + 7 * dst_stride, r7);
+  }
+};
+#elif defined(__SSE2__)
+template <>
+struct TransposeMicroKernel<uint32> {
+  static const int kSize = 4;
+  static void Run(const uint32* src, int64 src_stride, uint32* dst,
+                  int64 dst_stride) {
+    const float* s = reinterpret_cast<const float*>(src);
+    float* d = reinterpret_cast<float*>(dst);
+    __m128 r0 = _mm_loadu_ps(s + 0 * src_stride);
+    __m128 r1 = _mm_loadu_ps(s + 1 * src_stride);
+    __m128 r2 = _mm_loadu_ps(s + 2 * src_stride);
+    __m128 r3 = _mm_loadu_ps(s + 3 * src_stride);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(d + 0 * dst_stride, r0);
+    _mm_storeu_ps(d + 1 * dst_stride, r1);
+    _mm_storeu_ps(d + 2 * dst_stride, r2);
+    _mm_storeu_ps(d + 3 * dst_stride, r3);
+  }
+};
+#endif  // defined(__AVX__)
+
+#if defined(__SSE2__)
+template <>
+struct TransposeMicroKernel<uint16> {
+  static const int kSize = 8;
+  static void Run(const uint16* src, int64 src_stride, uint16* dst,
+                  int64 dst_stride) {
+    const __m128i a0 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 0 * src_stride));
+    const __m128i a1 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 1 * src_stride));
+    const __m128i a2 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 2 * src_stride));
+    const __m128i a3 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 3 * src_stride));
+    const __m128i a4 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 4 * src_stride));
+    const __m128i a5 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 5 * src_stride));
+    const __m128i a6 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 6 * src_stride));
+    const __m128i a7 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + 7 * src_stride));
+    // Interleave pairs of rows at 16, 32 and then 64 bits.
+    const __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    const __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    const __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    const __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+    const __m128i b4 = _mm_unpacklo_epi16(a4, a5);
+    const __m128i b5 = _mm_unpackhi_epi16(a4, a5);
+    const __m128i b6 = _mm_unpacklo_epi16(a6, a7);
+    const __m128i b7 = _mm_unpackhi_epi16(a6, a7);
+    const __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+    const __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+    const __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+    const __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+    const __m128i c4 = _mm_unpacklo_epi32(b4, b6);
+    const __m128i c5 = _mm_unpackhi_epi32(b4, b6);
+    const __m128i c6 = _mm_unpacklo_epi32(b5, b7);
+    const __m128i c7 = _mm_unpackhi_epi32(b5, b7);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 0 * dst_stride),
+                     _mm_unpacklo_epi64(c0, c4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 1 * dst_stride),
+                     _mm_unpackhi_epi64(c0, c4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * dst_stride),
+                     _mm_unpacklo_epi64(c1, c5));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * dst_stride),
+                     _mm_unpackhi_epi64(c1, c5));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * dst_stride),
+                     _mm_unpacklo_epi64(c2, c6));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 5 * dst_stride),
+                     _mm_unpackhi_epi64(c2, c6));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 6 * dst_stride),
+                     _mm_unpacklo_epi64(c3, c7));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 7 * dst_stride),
+                     _mm_unpackhi_epi64(c3, c7));
+  }
+};
+#endif  // defined(__SSE2__)
+
+// Transposes a 'rows' x 'cols' block with the micro kernel for T, and
+// transposes the edges that don't fill a whole tile one element at a time.
+template <typename T>
+void TransposeBlock(const T* src, int64 src_stride, T* dst, int64 dst_stride,
+                    int64 rows, int64 cols) {
+  const int64 tile = TransposeMicroKernel<T>::kSize;
+  int64 i = 0;
+  if (tile > 0) {
+    for (; i + tile <= rows; i += tile) {
+      int64 j = 0;
+      for (; j + tile <= cols; j += tile) {
+        TransposeMicroKernel<T>::Run(src + i * src_stride + j, src_stride,
+                                     dst + j * dst_stride + i, dst_stride);
+      }
+      TransposeBlockScalar(src + i * src_stride + j, src_stride,
+                           dst + j * dst_stride + i, dst_stride, tile,
+                           cols - j);
+    }
+  }
+  TransposeBlockScalar(src + i * src_stride, src_stride, dst + i, dst_stride,
+                       rows - i, cols);
+}
+
+// Side, in bytes, of the square blocks that are transposed at a time. Each
+// block row is two cache lines, and a block of 4-byte values is 4KB, so the
+// source and destination blocks both fit in the L1 cache.
+const int64 kBlockBytes = 128;
+
+// Transposes 'in' to 'out' by first coalescing the dimensions, and then
+// either copying the contiguous innermost rows when the innermost dimension
+// doesn't move, or transposing blocks of the two dimensions that become
+// innermost in the input and output. The blocks are processed in parallel.
+template <typename T>
+void TransposeBlocked(const CPUDevice& d, const Tensor& in,
+                      const gtl::ArraySlice<int32> perm, Tensor* out) {
+  const T* src = reinterpret_cast<const T*>(in.tensor_data().data());
+  T* dst = reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data()));
+  const int64 num_elements = in.NumElements();
+  if (num_elements == 0) return;
+
+  // Singleton dimensions don't affect the memory layout, and dropping them
+  // lets more of the remaining dimensions be combined.
+  TensorShape squeezed_shape;
+  TransposePermsVec squeezed_perm;
+  TransposePermsVec squeezed_index(in.dims(), -1);
+  for (int i = 0; i < in.dims(); ++i) {
+    if (in.dim_size(i) != 1) {
+      squeezed_index[i] = squeezed_shape.dims();
+      squeezed_shape.AddDim(in.dim_size(i));
+    }
+  }
+  for (int i = 0; i < perm.size(); ++i) {
+    if (squeezed_index[perm[i]] >= 0) {
+      squeezed_perm.push_back(squeezed_index[perm[i]]);
+    }
+  }
+  TransposePermsVec new_perm;
+  TransposeDimsVec new_dims;
+  if (squeezed_shape.dims() > 0) {
+    ReduceTransposeDimensions(squeezed_shape, squeezed_perm, &new_perm,
+                              &new_dims);
+  }
+  const int ndims = new_dims.size();
+  if (ndims <= 1) {
+    // The data is laid out the same way in the input and output.
+    auto copy = [src, dst](int64 start, int64 limit) {
+      memcpy(dst + start, src + start, (limit - start) * sizeof(T));
+    };
+    d.parallelFor(num_elements,
+                  Eigen::TensorOpCost(sizeof(T), sizeof(T), 0), copy);
+    return;
+  }
+
+  // Strides of the input dimensions, in the input and in the output.
+  TransposeDimsVec in_strides(ndims);
+  TransposeDimsVec out_strides(ndims);
+  in_strides[ndims - 1] = 1;
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * new_dims[i + 1];
+  }
+  int64 out_stride = 1;
+  for (int i = ndims - 1; i >= 0; --i) {
+    out_strides[new_perm[i]] = out_stride;
+    out_stride *= new_dims[new_perm[i]];
+  }
+
+  // Returns the input and output offsets of index 'outer' over the input
+  // dimensions other than 'skip0' and 'skip1'.
+  auto outer_offsets = [&new_dims, &in_strides, &out_strides, ndims](
+                           int64 outer, int skip0, int skip1,
+                           int64* in_offset, int64* out_offset) {
+    *in_offset = 0;
+    *out_offset = 0;
+    for (int i = ndims - 1; i >= 0; --i) {
+      if (i == skip0 || i == skip1) continue;
+      const int64 index = outer % new_dims[i];
+      outer /= new_dims[i];
+      *in_offset += index * in_strides[i];
+      *out_offset += index * out_strides[i];
+    }
+  };
+
+  const int inner = ndims - 1;
+  if (new_perm[ndims - 1] == inner) {
+    // The innermost dimension stays innermost, so contiguous rows of it are
+    // copied to their new positions.
+    const int64 row_size = new_dims[inner];
+    auto copy_rows = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        int64 in_offset, out_offset;
+        outer_offsets(row, inner, inner, &in_offset, &out_offset);
+        memcpy(dst + out_offset, src + in_offset, row_size * sizeof(T));
+      }
+    };
+    d.parallelFor(num_elements / row_size,
+                  Eigen::TensorOpCost(row_size * sizeof(T),
+                                      row_size * sizeof(T), row_size),
+                  copy_rows);
+    return;
+  }
+
+  // Input dimension 'row_dim' becomes the innermost one in the output, so
+  // each block is a transpose of [row_dim, inner] to [inner, row_dim].
+  const int row_dim = new_perm[ndims - 1];
+  const int64 rows = new_dims[row_dim];
+  const int64 cols = new_dims[inner];
+  const int64 src_stride = in_strides[row_dim];
+  const int64 dst_stride = out_strides[inner];
+  const int64 block_size =
+      std::max<int64>(TransposeMicroKernel<T>::kSize, kBlockBytes / sizeof(T));
+  const int64 row_blocks = (rows + block_size - 1) / block_size;
+  const int64 col_blocks = (cols + block_size - 1) / block_size;
+  const int64 blocks_per_outer = row_blocks * col_blocks;
+  const int64 num_blocks = num_elements / (rows * cols) * blocks_per_outer;
+  auto transpose_blocks = [&](int64 start, int64 limit) {
+    for (int64 block = start; block < limit; ++block) {
+      int64 in_offset, out_offset;
+      outer_offsets(block / blocks_per_outer, row_dim, inner, &in_offset,
+                    &out_offset);
+      const int64 row = (block % blocks_per_outer) / col_blocks * block_size;
+      const int64 col = (block % col_blocks) * block_size;
+      TransposeBlock(src + in_offset + row * src_stride + col, src_stride,
+                     dst + out_offset + col * dst_stride + row, dst_stride,
+                     std::min(block_size, rows - row),
+                     std::min(block_size, cols - col));
+    }
+  };
+  const int64 block_elements = std::min(block_size, rows) *
+                               std::min(block_size, cols);
+  d.parallelFor(num_blocks,
+                Eigen::TensorOpCost(block_elements * sizeof(T),
+                                    block_elements * sizeof(T),
+                                    block_elements),
+                transpose_blocks);
+}
+
+}  // namespace
+
+}  // end namespace internal
 
 template <typename T>
 struct Transpose<CPUDevice, T> {
+  static void run(const CPUDevice& d, const Tensor& in,
+                  const gtl::ArraySlice<int32> perm, Tensor* out) {
+    internal::TransposeBlocked<T>(d, in, perm, out);
+  }
+};
+
+// Strings can't be moved with memcpy, so they still use Eigen.
+template <>
+struct Transpose<CPUDevice, string> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
     switch (in.dims()) {
       case 2:
-        internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, out);
+        internal::TransposeUsingEigen<CPUDevice, string, 2>(d, in, perm, out);
         break;
       case 3:
-        internal::TransposeUsingEigen<CPUDevice, T, 3>(d, in, perm, out);
+        internal::TransposeUsingEigen<CPUDevice, string, 3>(d, in, perm, out);
         break;
       case 4:
-        internal::TransposeUsingEigen<CPUDevice, T, 4>(d, in, perm, out);
+        internal::TransposeUsingEigen<CPUDevice, string, 4>(d, in, perm, out);
         break;
       case 5:
-        internal::TransposeUsingEigen<CPUDevice, T, 5>(d, in, perm, out);
+        internal::TransposeUsingEigen<CPUDevice, string, 5>(d, in, perm, out);
         break;
       default:
         internal::TransposeSimple<CPUDevice, T>(d, in, perm, out);
@@ -87,6 +87,17 @@ TEST_F(TransposeUtilTest, NormalDimensionReduction) {
   TestDimensionReduction({2, 3}, {0, 1}, {0}, {6});
 }
 
+TEST_F(TransposeUtilTest, NonInvolutionDimensionReduction) {
+  TestDimensionReduction({2, 3, 4, 5}, {2, 0, 3, 1}, {2, 0, 3, 1},
+                         {2, 3, 4, 5});
+
+  TestDimensionReduction({2, 3, 4, 5}, {1, 3, 0, 2}, {1, 3, 0, 2},
+                         {2, 3, 4, 5});
+
+  TestDimensionReduction({2, 3, 4, 5, 6}, {3, 0, 4, 1, 2}, {2, 0, 3, 1},
+                         {2, 12, 5, 6});
+}
+
 TEST_F(TransposeUtilTest, LargeDimensionReduction) {
   TestDimensionReduction({2, 3, 4, 5, 6, 7, 8, 9, 10, 20},
                          {0, 2, 3, 4, 5, 6, 7, 8, 9, 1}, {0, 2, 1},
@@ -13,18 +13,46 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <unordered_map>
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+#if GOOGLE_CUDA
+template <typename T>
+struct UniqueGpuLaunch {
+  // Sets first_index[i] to the index of the first occurrence of x[i], and
+  // positions[i] to the number of distinct values in x[0], ..., x[i].
+  // `table` is scratch space of `table_mask + 1` slots, a power of two
+  // greater than `size`, which must be filled with -1.
+  void FindFirstOccurrences(const GPUDevice& d, const T* x, int32 size,
+                            int32* table, uint32 table_mask,
+                            int32* first_index, int32* positions);
+
+  // Writes the unique values to y and the index of each x[i] in y to idx,
+  // and counts the occurrences of each unique value in count (which must be
+  // zeroed) unless count is nullptr.
+  void Scatter(const GPUDevice& d, const T* x, int32 size,
+               const int32* first_index, const int32* positions, T* y,
+               int32* idx, int32* count);
+};
+#endif  // GOOGLE_CUDA
 
 template <typename T>
 class UniqueOp : public OpKernel {
@@ -44,43 +72,223 @@ class UniqueOp : public OpKernel {
                     std::numeric_limits<int32>::max(), " elements"));
     auto Tin = input.vec<T>();
     const int64 N = static_cast<int64>(Tin.size());
+    const bool with_counts = num_outputs() > 2;
 
     Tensor* idx = nullptr;
     OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
                                 {0}, 1, input.shape(), &idx));
     auto idx_vec = idx->template vec<int32>();
 
-    std::unordered_map<T, int32> uniq;
-    uniq.reserve(2 * N);
-    for (int64 i = 0, j = 0; i < N; ++i) {
-      auto it = uniq.insert(std::make_pair(Tin(i), j));
-      idx_vec(i) = it.first->second;
-      if (it.second) {
-        ++j;
+    // The input is split into contiguous shards, and each shard finds its
+    // unique values in first-occurrence order, writing shard-local indices
+    // to idx. A sequential merge pass over the shards in order then assigns
+    // the global indices, which preserves the first-occurrence order of the
+    // output, and a second parallel pass rewrites idx. Since the merge
+    // touches each shard's unique values only once, it is cheap for the
+    // heavily duplicated inputs where Unique is most often used.
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64 num_shards = std::max<int64>(
+        1, std::min<int64>(worker_threads.num_threads,
+                           N / kMinElementsPerShard));
+    auto shard_start = [N, num_shards](int64 shard) {
+      return shard * N / num_shards;
+    };
+
+    std::vector<Shard> shards(num_shards);
+    auto find_shard_uniques = [&](int64 first_shard, int64 last_shard) {
+      for (int64 s = first_shard; s < last_shard; ++s) {
+        Shard* shard = &shards[s];
+        gtl::FlatMap<T, int32> uniq;
+        for (int64 i = shard_start(s), limit = shard_start(s + 1); i < limit;
+             ++i) {
+          auto it = uniq.insert(
+              std::make_pair(Tin(i), static_cast<int32>(shard->uniq.size())));
+          if (it.second) {
+            shard->uniq.push_back(Tin(i));
+            if (with_counts) shard->counts.push_back(0);
+          }
+          idx_vec(i) = it.first->second;
+          if (with_counts) ++shard->counts[it.first->second];
+        }
+      }
+    };
+    const int64 cost_per_shard = N / num_shards * kCostPerElement;
+    tensorflow::Shard(worker_threads.num_threads, worker_threads.workers,
+                      num_shards, cost_per_shard, find_shard_uniques);
+
+    // With a single shard, the shard-local indices are already global.
+    std::vector<const T*> uniq_values;
+    std::vector<int32> counts;
+    if (num_shards == 1) {
+      uniq_values.reserve(shards[0].uniq.size());
+      for (const T& value : shards[0].uniq) {
+        uniq_values.push_back(&value);
       }
+      counts.swap(shards[0].counts);
+    } else {
+      gtl::FlatMap<T, int32> uniq;
+      for (Shard& shard : shards) {
+        shard.remap.resize(shard.uniq.size());
+        for (size_t j = 0; j < shard.uniq.size(); ++j) {
+          auto it = uniq.insert(std::make_pair(
+              shard.uniq[j], static_cast<int32>(uniq_values.size())));
+          if (it.second) {
+            uniq_values.push_back(&shard.uniq[j]);
+            if (with_counts) counts.push_back(0);
+          }
+          shard.remap[j] = it.first->second;
+          if (with_counts) counts[it.first->second] += shard.counts[j];
+        }
+      }
+      auto remap_idx = [&](int64 first_shard, int64 last_shard) {
+        for (int64 s = first_shard; s < last_shard; ++s) {
+          const std::vector<int32>& remap = shards[s].remap;
+          for (int64 i = shard_start(s), limit = shard_start(s + 1);
+               i < limit; ++i) {
+            idx_vec(i) = remap[idx_vec(i)];
+          }
+        }
+      };
+      tensorflow::Shard(worker_threads.num_threads, worker_threads.workers,
+                        num_shards, N / num_shards, remap_idx);
     }
-    int64 uniq_size = static_cast<int64>(uniq.size());
+
+    const int64 uniq_size = static_cast<int64>(uniq_values.size());
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(
                                 0, TensorShape({uniq_size}), &output));
     auto output_vec = output->template vec<T>();
-
-    for (auto it : uniq) {
-      output_vec(it.second) = it.first;
+    for (int64 i = 0; i < uniq_size; ++i) {
+      output_vec(i) = *uniq_values[i];
     }
 
-    if (num_outputs() > 2) {
+    if (with_counts) {
       OP_REQUIRES_OK(context, context->allocate_output(
                                   2, TensorShape({uniq_size}), &output));
       auto count_output_vec = output->template vec<int32>();
-      count_output_vec.setZero();
-      for (int64 i = 0; i < N; ++i) {
-        count_output_vec(idx_vec(i))++;
+      for (int64 i = 0; i < uniq_size; ++i) {
+        count_output_vec(i) = counts[i];
       }
     }
   }
+
+ private:
+  // Inputs with fewer than twice this many elements are processed on the
+  // calling thread, because the merge pass would not pay for itself.
+  static constexpr int64 kMinElementsPerShard = 16384;
+  // The approximate cost of looking up an element, for sharding purposes.
+  static constexpr int64 kCostPerElement = 50;
+
+  // The unique values of one shard of the input.
+  struct Shard {
+    // The unique values in the shard, in first-occurrence order.
+    std::vector<T> uniq;
+    // The number of occurrences of each value in `uniq`.
+    std::vector<int32> counts;
+    // The global index of each value in `uniq`.
+    std::vector<int32> remap;
+  };
 };
 
+#if GOOGLE_CUDA
+// Finds the first occurrence of each element in a GPU hash table of element
+// indices, then numbers the first occurrences with a prefix sum, so the
+// output has the same first-occurrence order as the CPU kernel.
+template <typename T>
+class UniqueGpuOp : public OpKernel {
+ public:
+  explicit UniqueGpuOp(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(input.shape()),
+                errors::InvalidArgument("unique expects a 1D vector."));
+    // The hash table has at least twice as many slots as there are
+    // elements, and its slots are addressed with 32-bit indices.
+    OP_REQUIRES(context,
+                input.NumElements() <= std::numeric_limits<int32>::max() / 2,
+                errors::InvalidArgument(
+                    "unique on GPU does not support input tensors larger than ",
+                    std::numeric_limits<int32>::max() / 2, " elements"));
+    const int32 N = static_cast<int32>(input.NumElements());
+    const bool with_counts = num_outputs() > 2;
+
+    Tensor* idx = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, input.shape(), &idx));
+    Tensor* output = nullptr;
+    Tensor* count = nullptr;
+    if (N == 0) {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(0, TensorShape({0}), &output));
+      if (with_counts) {
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(2, TensorShape({0}), &count));
+      }
+      return;
+    }
+
+    int64 table_size = 1;
+    while (table_size < 2 * static_cast<int64>(N)) table_size <<= 1;
+    Tensor table;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT32, TensorShape({table_size}), &table));
+    Tensor first_index;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT32, TensorShape({N}),
+                                                   &first_index));
+    Tensor positions;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT32, TensorShape({N}),
+                                                   &positions));
+
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES(context, stream, errors::Internal("No GPU stream available."));
+    perftools::gputools::DeviceMemoryBase table_ptr(
+        table.flat<int32>().data(), table_size * sizeof(int32));
+    stream->ThenMemset32(&table_ptr, 0xFFFFFFFF, table_size * sizeof(int32));
+
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    const T* x = input.flat<T>().data();
+    UniqueGpuLaunch<T> launch;
+    launch.FindFirstOccurrences(d, x, N, table.flat<int32>().data(),
+                                static_cast<uint32>(table_size - 1),
+                                first_index.flat<int32>().data(),
+                                positions.flat<int32>().data());
+
+    // The number of unique values, which determines the output shape, is
+    // the last element of the prefix sum.
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    attr.set_gpu_compatible(true);
+    Tensor uniq_size_host;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT32, TensorShape({}),
+                                                   &uniq_size_host, attr));
+    perftools::gputools::DeviceMemoryBase last_position_ptr(
+        positions.flat<int32>().data() + N - 1, sizeof(int32));
+    stream->ThenMemcpy(uniq_size_host.flat<int32>().data(), last_position_ptr,
+                       sizeof(int32));
+    stream->BlockHostUntilDone();
+    OP_REQUIRES(context, stream->ok(),
+                errors::Internal("cudaMemcpy from device to host failed"));
+    const int64 uniq_size = uniq_size_host.scalar<int32>()();
+
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({uniq_size}), &output));
+    int32* count_ptr = nullptr;
+    if (with_counts) {
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &count));
+      perftools::gputools::DeviceMemoryBase count_mem(
+          count->flat<int32>().data(), uniq_size * sizeof(int32));
+      stream->ThenMemset32(&count_mem, 0, uniq_size * sizeof(int32));
+      count_ptr = count->flat<int32>().data();
+    }
+    launch.Scatter(d, x, N, first_index.flat<int32>().data(),
+                   positions.flat<int32>().data(), output->flat<T>().data(),
+                   idx->flat<int32>().data(), count_ptr);
+  }
+};
+#endif  // GOOGLE_CUDA
+
 #define REGISTER_UNIQUE(type)                                    \
   REGISTER_KERNEL_BUILDER(Name("Unique")                         \
                               .Device(DEVICE_CPU)                \
@@ -96,26 +304,22 @@ TF_CALL_REAL_NUMBER_TYPES(REGISTER_UNIQUE);
 REGISTER_UNIQUE(string)
 #undef REGISTER_UNIQUE
 
-// Fake integer GPU kernels so that the use of Unique in optimizers (to
-// de-duplicate sparse gradient indices) does not conflict with gradients being
-// located on a GPU. These kernels run on the CPU, their inputs and outputs
-// residing in host (not GPU) memory.
-REGISTER_KERNEL_BUILDER(Name("Unique")
-                            .Device(DEVICE_GPU)
-                            .TypeConstraint<int32>("T")
-                            .TypeConstraint<int32>("out_idx")
-                            .HostMemory("x")
-                            .HostMemory("y")
-                            .HostMemory("idx"),
-                        UniqueOp<int32>);
-REGISTER_KERNEL_BUILDER(Name("Unique")
-                            .Device(DEVICE_GPU)
-                            .TypeConstraint<int64>("T")
-                            .TypeConstraint<int32>("out_idx")
-                            .HostMemory("x")
-                            .HostMemory("y")
-                            .HostMemory("idx"),
-                        UniqueOp<int64>);
+#if GOOGLE_CUDA
+#define REGISTER_UNIQUE_GPU(type)                                \
+  REGISTER_KERNEL_BUILDER(Name("Unique")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int32>("out_idx"), \
+                          UniqueGpuOp<type>);                    \
+  REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")               \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .TypeConstraint<int32>("out_idx"), \
+                          UniqueGpuOp<type>)
+REGISTER_UNIQUE_GPU(int32);
+REGISTER_UNIQUE_GPU(int64);
+#undef REGISTER_UNIQUE_GPU
+#endif  // GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_SYCL
 REGISTER_KERNEL_BUILDER(Name("Unique")
@@ -0,0 +1,140 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// The finalizer of MurmurHash3, which mixes all bits of the value into the
+// low bits used to address the table.
+template <typename T>
+__device__ uint32 HashValue(T value) {
+  uint64 h = static_cast<uint64>(value);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<uint32>(h);
+}
+
+// Inserts the index of each element into an open-addressing table, keyed by
+// the element value. Every index stored in a slot refers to the same value,
+// so each slot converges to the smallest index of its value.
+template <typename T>
+__global__ void UniqueInsertKernel(const T* x, int32 size, int32* table,
+                                   uint32 table_mask) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const T value = x[i];
+    uint32 slot = HashValue(value) & table_mask;
+    while (true) {
+      const int32 existing = atomicCAS(table + slot, -1, i);
+      if (existing == -1) break;
+      if (x[existing] == value) {
+        atomicMin(table + slot, i);
+        break;
+      }
+      slot = (slot + 1) & table_mask;
+    }
+  }
+}
+
+// Looks up the first occurrence of each element in the completed table.
+template <typename T>
+__global__ void UniqueLookupKernel(const T* x, int32 size, const int32* table,
+                                   uint32 table_mask, int32* first_index) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const T value = x[i];
+    uint32 slot = HashValue(value) & table_mask;
+    while (x[table[slot]] != value) {
+      slot = (slot + 1) & table_mask;
+    }
+    first_index[i] = table[slot];
+  }
+}
+
+__global__ void UniqueFlagFirstKernel(int32 size, const int32* first_index,
+                                      int32* is_first) {
+  CUDA_1D_KERNEL_LOOP(i, size) { is_first[i] = first_index[i] == i ? 1 : 0; }
+}
+
+template <typename T>
+__global__ void UniqueScatterKernel(const T* x, int32 size,
+                                    const int32* first_index,
+                                    const int32* positions, T* y, int32* idx,
+                                    int32* count) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const int32 first = first_index[i];
+    const int32 position = positions[first] - 1;
+    idx[i] = position;
+    if (first == i) {
+      y[position] = x[i];
+    }
+    if (count != nullptr) {
+      atomicAdd(count + position, 1);
+    }
+  }
+}
+
+}  // namespace
+
+template <typename T>
+struct UniqueGpuLaunch {
+  void FindFirstOccurrences(const GPUDevice& d, const T* x, int32 size,
+                            int32* table, uint32 table_mask,
+                            int32* first_index, int32* positions) {
+    CudaLaunchConfig config = GetCudaLaunchConfig(size, d);
+    UniqueInsertKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            x, size, table, table_mask);
+    UniqueLookupKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            x, size, table, table_mask, first_index);
+    // The table is no longer needed, so its first `size` slots hold the
+    // first-occurrence flags that are summed into `positions`.
+    UniqueFlagFirstKernel<<<config.block_count, config.thread_per_block, 0,
+                            d.stream()>>>(size, first_index, table);
+    typename TTypes<int32>::ConstFlat is_first(table, size);
+    typename TTypes<int32>::Flat positions_t(positions, size);
+    positions_t.device(d) = is_first.cumsum(0);
+  }
+
+  void Scatter(const GPUDevice& d, const T* x, int32 size,
+               const int32* first_index, const int32* positions, T* y,
+               int32* idx, int32* count) {
+    CudaLaunchConfig config = GetCudaLaunchConfig(size, d);
+    UniqueScatterKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            x, size, first_index, positions, y, idx, count);
+  }
+};
+
+template struct UniqueGpuLaunch<int32>;
+template struct UniqueGpuLaunch<int64>;
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
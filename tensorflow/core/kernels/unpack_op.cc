@@ -69,33 +69,55 @@ class UnpackOp : public OpKernel {
                                  std::numeric_limits<Eigen::DenseIndex>::max()),
         errors::InvalidArgument("output size must fit in Eigen DenseIndex"));
 
-    // Special case: Aligned, so we can share the underlying buffer.
+    int64 before_dim = 1;
+    for (int i = 0; i < axis; ++i) {
+      before_dim *= input_shape.dim_size(i);
+    }
+
+    int64 after_dim = 1;
+    for (int i = axis + 1; i < input_shape.dims(); ++i) {
+      after_dim *= input_shape.dim_size(i);
+    }
+    const int64 axis_dim = input_shape.dim_size(axis);
+
+    // Special case: Aligned, and all the dimensions before axis have size 1,
+    // so we can share the underlying buffer.
     //
     // Apply this optimization conservatively: if input is aligned,
     // the resulting tensors must be aligned. It's conservative
     // because if the immediate consumer of the resulting tensors are
     // not using eigen for computation, its perfectly fine to avoid
     // the copying.
-    if (axis == 0 &&
-        (output_size == 0 || IsInnerDimsSizeAligned<T>(input_shape))) {
+    const TensorShape unpack_shape({axis_dim, after_dim});
+    if (before_dim == 1 &&
+        (output_size == 0 || IsInnerDimsSizeAligned<T>(unpack_shape))) {
+      Tensor input_reshaped;
+      CHECK(input_reshaped.CopyFrom(input, unpack_shape));
       for (int i = 0; i < num; ++i) {
         Tensor output;
-        CHECK(output.CopyFrom(input.Slice(i, i + 1), output_shape));
+        CHECK(output.CopyFrom(input_reshaped.Slice(i, i + 1), output_shape));
         context->set_output(i, output);
       }
       return;
     }
 
-    int64 before_dim = 1;
-    for (int i = 0; i < axis; ++i) {
-      before_dim *= input_shape.dim_size(i);
-    }
-
-    int64 after_dim = 1;
-    for (int i = axis + 1; i < input_shape.dims(); ++i) {
-      after_dim *= input_shape.dim_size(i);
+    // On CPU, every row of the input is copied to all the outputs in one
+    // pass, e.g. when unpacking a batch-major sequence along time.
+    if (std::is_same<Device, CPUDevice>::value) {
+      std::vector<T*> outputs(num);
+      for (int i = 0; i < num; ++i) {
+        Tensor* output;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(i, output_shape, &output));
+        outputs[i] = output->flat<T>().data();
+      }
+      if (output_size > 0) {
+        functor::SplitRows<T>()(context->eigen_device<CPUDevice>(),
+                                input.flat<T>().data(), before_dim,
+                                std::vector<int64>(num, after_dim), outputs);
+      }
+      return;
     }
-    const int64 axis_dim = input_shape.dim_size(axis);
 
     // Except for shape, unpack is a special case of split, so we reuse the
     // same computational kernels.
@@ -17,21 +17,39 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
 
 #include "tensorflow/core/kernels/deep_conv2d.h"
+#include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
-// Winograd DeepConv2DTransform implementation for 3x3 filters.
+// Winograd DeepConv2DTransform implementation for 3x3 filters, computing
+// F(m x m, 3 x 3) for output tile sizes 'm' of 2, 4 or 6.
 // Details:
 // *) Arithmetic complexity of computations: Shmuel Winograd
 // *) Fast Algorithms for Convolutional Neural Networks: Lavin, Gray
+//
+// Larger output tiles reduce the number of element-wise products per output
+// (4 for F(2x2,3x3), 2.25 for F(4x4,3x3) and 1.78 for F(6x6,3x3)), at the
+// cost of more expensive input/output transforms and lower numerical accuracy.
+//
+// Each 2D transform matrix is the kronecker product 'M * M' of the 1D
+// transform matrix 'M' of F(m, 3) listed below.
 
 template <typename T>
 class WinogradTransform : public DeepConv2DTransform<T> {
  public:
   typedef typename DeepConv2DTransform<T>::Shape Shape;
 
-  WinogradTransform()
-      : filter_shape_(3, 3), input_shape_(4, 4), output_shape_(2, 2) {}
+  explicit WinogradTransform(const int64 out_tile_size = 2)
+      : filter_shape_(3, 3),
+        input_shape_(out_tile_size + 2, out_tile_size + 2),
+        output_shape_(out_tile_size, out_tile_size) {
+    CHECK(IsSupportedOutputTileSize(out_tile_size)) << out_tile_size;
+  }
+
+  // Returns true if F(m x m, 3 x 3) is implemented for 'out_tile_size' == m.
+  static bool IsSupportedOutputTileSize(const int64 out_tile_size) {
+    return out_tile_size == 2 || out_tile_size == 4 || out_tile_size == 6;
+  }
 
   virtual void GetFilterTransformMatrix(const int64 rows, const int64 cols,
                                         T* transform_matrix) const;
@@ -47,19 +65,67 @@ class WinogradTransform : public DeepConv2DTransform<T> {
   virtual const Shape& output_shape() const { return output_shape_; }
 
  private:
+  // Writes the kronecker product 'M * M' of the 'm_rows' x 'm_cols' row-major
+  // matrix 'm' to 'transform_matrix', which has 'rows' x 'cols' elements.
+  static void ComputeKroneckerProduct(const int64 m_rows, const int64 m_cols,
+                                      const double* m, const int64 rows,
+                                      const int64 cols, T* transform_matrix);
+
   const Shape filter_shape_;
   const Shape input_shape_;
   const Shape output_shape_;
 };
 
+template <typename T>
+void WinogradTransform<T>::ComputeKroneckerProduct(const int64 m_rows,
+                                                   const int64 m_cols,
+                                                   const double* m,
+                                                   const int64 rows,
+                                                   const int64 cols,
+                                                   T* transform_matrix) {
+  CHECK_EQ(rows, m_rows * m_rows);
+  CHECK_EQ(cols, m_cols * m_cols);
+  for (int64 i = 0; i < m_rows; ++i) {
+    for (int64 j = 0; j < m_cols; ++j) {
+      const double v = m[i * m_cols + j];
+      for (int64 k = 0; k < m_rows; ++k) {
+        for (int64 l = 0; l < m_cols; ++l) {
+          transform_matrix[(i * m_rows + k) * cols + j * m_cols + l] =
+              T(v * m[k * m_cols + l]);
+        }
+      }
+    }
+  }
+}
+
 // The filter transform matrix is the kronecker product 'M * M' of the
-// following matrix 'M':
+// following matrix 'M' (F(2x2,3x3)):
 //
 //   [ 1    0   0   ]
 //   [ 1/2  1/2 1/2 ]
 //   [ 1/2 -1/2 1/2 ]
 //   [ 0    0   1   ]
 //
+// F(4x4,3x3):
+//
+//   [  1/4     0     0   ]
+//   [ -1/6  -1/6  -1/6   ]
+//   [ -1/6   1/6  -1/6   ]
+//   [  1/24  1/12  1/6   ]
+//   [  1/24 -1/12  1/6   ]
+//   [  0     0     1     ]
+//
+// F(6x6,3x3):
+//
+//   [  1      0      0    ]
+//   [ -2/9   -2/9   -2/9  ]
+//   [ -2/9    2/9   -2/9  ]
+//   [  1/90   1/45   2/45 ]
+//   [  1/90  -1/45   2/45 ]
+//   [ 32/45  16/45   8/45 ]
+//   [ 32/45 -16/45   8/45 ]
+//   [  0      0      1    ]
+//
 // The data layout of 'transform_matrix':
 //   [input_tile_spatial_size, filter_spatial_size]
 //
@@ -67,123 +133,53 @@ template <typename T>
 void WinogradTransform<T>::GetFilterTransformMatrix(const int64 rows,
                                                     const int64 cols,
                                                     T* transform_matrix) const {
-  CHECK_GT(rows, 0);
-  CHECK_GT(cols, 0);
-  memset(transform_matrix, 0, sizeof(T) * rows * cols);
-
-  // Sub matrix [0,0]
-  transform_matrix[0 * cols + 0] = T(1.0);
-
-  transform_matrix[1 * cols + 0] = T(0.5);
-  transform_matrix[1 * cols + 1] = T(0.5);
-  transform_matrix[1 * cols + 2] = T(0.5);
-
-  transform_matrix[2 * cols + 0] = T(0.5);
-  transform_matrix[2 * cols + 1] = T(-0.5);
-  transform_matrix[2 * cols + 2] = T(0.5);
-
-  transform_matrix[3 * cols + 2] = T(1.0);
-
-  // Sub matrix [1,0]
-  transform_matrix[4 * cols + 0] = T(0.5);
-
-  transform_matrix[5 * cols + 0] = T(0.25);
-  transform_matrix[5 * cols + 1] = T(0.25);
-  transform_matrix[5 * cols + 2] = T(0.25);
-
-  transform_matrix[6 * cols + 0] = T(0.25);
-  transform_matrix[6 * cols + 1] = T(-0.25);
-  transform_matrix[6 * cols + 2] = T(0.25);
-
-  transform_matrix[7 * cols + 2] = T(0.5);
-
-  // Sub matrix [1,1]
-  transform_matrix[4 * cols + 3] = T(0.5);
-
-  transform_matrix[5 * cols + 3] = T(0.25);
-  transform_matrix[5 * cols + 4] = T(0.25);
-  transform_matrix[5 * cols + 5] = T(0.25);
-
-  transform_matrix[6 * cols + 3] = T(0.25);
-  transform_matrix[6 * cols + 4] = T(-0.25);
-  transform_matrix[6 * cols + 5] = T(0.25);
-
-  transform_matrix[7 * cols + 5] = T(0.5);
-
-  // Sub matrix [1,2]
-  transform_matrix[4 * cols + 6] = T(0.5);
-
-  transform_matrix[5 * cols + 6] = T(0.25);
-  transform_matrix[5 * cols + 7] = T(0.25);
-  transform_matrix[5 * cols + 8] = T(0.25);
-
-  transform_matrix[6 * cols + 6] = T(0.25);
-  transform_matrix[6 * cols + 7] = T(-0.25);
-  transform_matrix[6 * cols + 8] = T(0.25);
-
-  transform_matrix[7 * cols + 8] = T(0.5);
-
-  // Sub matrix [2,0]
-  transform_matrix[8 * cols + 0] = T(0.5);
-
-  transform_matrix[9 * cols + 0] = T(0.25);
-  transform_matrix[9 * cols + 1] = T(0.25);
-  transform_matrix[9 * cols + 2] = T(0.25);
-
-  transform_matrix[10 * cols + 0] = T(0.25);
-  transform_matrix[10 * cols + 1] = T(-0.25);
-  transform_matrix[10 * cols + 2] = T(0.25);
-
-  transform_matrix[11 * cols + 2] = T(0.5);
-
-  // Sub matrix [2,1]
-  transform_matrix[8 * cols + 3] = T(-0.5);
-
-  transform_matrix[9 * cols + 3] = T(-0.25);
-  transform_matrix[9 * cols + 4] = T(-0.25);
-  transform_matrix[9 * cols + 5] = T(-0.25);
-
-  transform_matrix[10 * cols + 3] = T(-0.25);
-  transform_matrix[10 * cols + 4] = T(0.25);
-  transform_matrix[10 * cols + 5] = T(-0.25);
-
-  transform_matrix[11 * cols + 5] = T(-0.5);
-
-  // Sub matrix [2,2]
-  transform_matrix[8 * cols + 6] = T(0.5);
-
-  transform_matrix[9 * cols + 6] = T(0.25);
-  transform_matrix[9 * cols + 7] = T(0.25);
-  transform_matrix[9 * cols + 8] = T(0.25);
-
-  transform_matrix[10 * cols + 6] = T(0.25);
-  transform_matrix[10 * cols + 7] = T(-0.25);
-  transform_matrix[10 * cols + 8] = T(0.25);
-
-  transform_matrix[11 * cols + 8] = T(0.5);
-
-  // Sub matrix [3,2]
-  transform_matrix[12 * cols + 6] = T(1.0);
-
-  transform_matrix[13 * cols + 6] = T(0.5);
-  transform_matrix[13 * cols + 7] = T(0.5);
-  transform_matrix[13 * cols + 8] = T(0.5);
-
-  transform_matrix[14 * cols + 6] = T(0.5);
-  transform_matrix[14 * cols + 7] = T(-0.5);
-  transform_matrix[14 * cols + 8] = T(0.5);
-
-  transform_matrix[15 * cols + 8] = T(1.0);
+  static const double kF2[] = {1.0, 0.0, 0.0, 0.5, 0.5, 0.5,
+                               0.5, -0.5, 0.5, 0.0, 0.0, 1.0};
+  static const double kF4[] = {
+      1.0 / 4,  0.0,       0.0,      -1.0 / 6, -1.0 / 6, -1.0 / 6,
+      -1.0 / 6, 1.0 / 6,   -1.0 / 6, 1.0 / 24, 1.0 / 12, 1.0 / 6,
+      1.0 / 24, -1.0 / 12, 1.0 / 6,  0.0,      0.0,      1.0};
+  static const double kF6[] = {
+      1.0,       0.0,        0.0,      -2.0 / 9,  -2.0 / 9,
+      -2.0 / 9,  -2.0 / 9,   2.0 / 9,  -2.0 / 9,  1.0 / 90,
+      1.0 / 45,  2.0 / 45,   1.0 / 90, -1.0 / 45, 2.0 / 45,
+      32.0 / 45, 16.0 / 45,  8.0 / 45, 32.0 / 45, -16.0 / 45,
+      8.0 / 45,  0.0,        0.0,      1.0};
+  const int64 out_tile_size = output_shape_.rows;
+  const double* m =
+      out_tile_size == 2 ? kF2 : (out_tile_size == 4 ? kF4 : kF6);
+  ComputeKroneckerProduct(input_shape_.rows, filter_shape_.rows, m, rows, cols,
+                          transform_matrix);
 }
 
 // The input transform matrix is the kronecker product 'M * M' of the
-// following matrix 'M':
+// following matrix 'M' (F(2x2,3x3)):
 //
 //   [1   0  -1   0]
 //   [0   1   1   0]
 //   [0  -1   1   0]
 //   [0   1   0  -1]
 //
+// F(4x4,3x3):
+//
+//   [4   0  -5   0   1   0]
+//   [0  -4  -4   1   1   0]
+//   [0   4  -4  -1   1   0]
+//   [0  -2  -1   2   1   0]
+//   [0   2  -1  -2   1   0]
+//   [0   4   0  -5   0   1]
+//
+// F(6x6,3x3):
+//
+//   [1   0    -21/4   0     21/4   0    -1   0]
+//   [0   1     1    -17/4  -17/4   1     1   0]
+//   [0  -1     1     17/4  -17/4  -1     1   0]
+//   [0   1/2   1/4   -5/2   -5/4   2     1   0]
+//   [0  -1/2   1/4    5/2   -5/4  -2     1   0]
+//   [0   2     4     -5/2   -5     1/2   1   0]
+//   [0  -2     4      5/2   -5    -1/2   1   0]
+//   [0  -1     0     21/4    0   -21/4   0   1]
+//
 // Data layout of 'transform_matrix':
 //   [tile_spatial_size, tile_spatial_size]
 //
@@ -191,121 +187,49 @@ template <typename T>
 void WinogradTransform<T>::GetInputTransformMatrix(const int64 rows,
                                                    const int64 cols,
                                                    T* transform_matrix) const {
-  CHECK_GT(rows, 0);
-  CHECK_GT(cols, 0);
-  memset(transform_matrix, 0, sizeof(T) * rows * cols);
-
-  // Sub matrix [0,0]
-  transform_matrix[0 * cols + 0] = T(1.0);
-  transform_matrix[0 * cols + 2] = T(-1.0);
-
-  transform_matrix[1 * cols + 1] = T(1.0);
-  transform_matrix[1 * cols + 2] = T(1.0);
-
-  transform_matrix[2 * cols + 1] = T(-1.0);
-  transform_matrix[2 * cols + 2] = T(1.0);
-
-  transform_matrix[3 * cols + 1] = T(1.0);
-  transform_matrix[3 * cols + 3] = T(-1.0);
-
-  // Sub matrix [0,2]
-  transform_matrix[0 * cols + 8] = T(-1.0);
-  transform_matrix[0 * cols + 10] = T(1.0);
-
-  transform_matrix[1 * cols + 9] = T(-1.0);
-  transform_matrix[1 * cols + 10] = T(-1.0);
-
-  transform_matrix[2 * cols + 9] = T(1.0);
-  transform_matrix[2 * cols + 10] = T(-1.0);
-
-  transform_matrix[3 * cols + 9] = T(-1.0);
-  transform_matrix[3 * cols + 11] = T(1.0);
-
-  // Sub matrix [1,1]
-  transform_matrix[4 * cols + 4] = T(1.0);
-  transform_matrix[4 * cols + 6] = T(-1.0);
-
-  transform_matrix[5 * cols + 5] = T(1.0);
-  transform_matrix[5 * cols + 6] = T(1.0);
-
-  transform_matrix[6 * cols + 5] = T(-1.0);
-  transform_matrix[6 * cols + 6] = T(1.0);
-
-  transform_matrix[7 * cols + 5] = T(1.0);
-  transform_matrix[7 * cols + 7] = T(-1.0);
-
-  // Sub matrix [1,2]
-  transform_matrix[4 * cols + 8] = T(1.0);
-  transform_matrix[4 * cols + 10] = T(-1.0);
-
-  transform_matrix[5 * cols + 9] = T(1.0);
-  transform_matrix[5 * cols + 10] = T(1.0);
-
-  transform_matrix[6 * cols + 9] = T(-1.0);
-  transform_matrix[6 * cols + 10] = T(1.0);
-
-  transform_matrix[7 * cols + 9] = T(1.0);
-  transform_matrix[7 * cols + 11] = T(-1.0);
-
-  // Sub matrix [2,1]
-  transform_matrix[8 * cols + 4] = T(-1.0);
-  transform_matrix[8 * cols + 6] = T(1.0);
-
-  transform_matrix[9 * cols + 5] = T(-1.0);
-  transform_matrix[9 * cols + 6] = T(-1.0);
-
-  transform_matrix[10 * cols + 5] = T(1.0);
-  transform_matrix[10 * cols + 6] = T(-1.0);
-
-  transform_matrix[11 * cols + 5] = T(-1.0);
-  transform_matrix[11 * cols + 7] = T(1.0);
-
-  // Sub matrix [2,2]
-  transform_matrix[8 * cols + 8] = T(1.0);
-  transform_matrix[8 * cols + 10] = T(-1.0);
-
-  transform_matrix[9 * cols + 9] = T(1.0);
-  transform_matrix[9 * cols + 10] = T(1.0);
-
-  transform_matrix[10 * cols + 9] = T(-1.0);
-  transform_matrix[10 * cols + 10] = T(1.0);
-
-  transform_matrix[11 * cols + 9] = T(1.0);
-  transform_matrix[11 * cols + 11] = T(-1.0);
-
-  // Sub matrix [3,1]
-  transform_matrix[12 * cols + 4] = T(1.0);
-  transform_matrix[12 * cols + 6] = T(-1.0);
-
-  transform_matrix[13 * cols + 5] = T(1.0);
-  transform_matrix[13 * cols + 6] = T(1.0);
-
-  transform_matrix[14 * cols + 5] = T(-1.0);
-  transform_matrix[14 * cols + 6] = T(1.0);
-
-  transform_matrix[15 * cols + 5] = T(1.0);
-  transform_matrix[15 * cols + 7] = T(-1.0);
-
-  // Sub matrix [3,3]
-  transform_matrix[12 * cols + 12] = T(-1.0);
-  transform_matrix[12 * cols + 14] = T(1.0);
-
-  transform_matrix[13 * cols + 13] = T(-1.0);
-  transform_matrix[13 * cols + 14] = T(-1.0);
-
-  transform_matrix[14 * cols + 13] = T(1.0);
-  transform_matrix[14 * cols + 14] = T(-1.0);
-
-  transform_matrix[15 * cols + 13] = T(-1.0);
-  transform_matrix[15 * cols + 15] = T(1.0);
-};
+  static const double kF2[] = {1, 0, -1, 0, 0, 1, 1, 0,
+                               0, -1, 1, 0, 0, 1, 0, -1};
+  static const double kF4[] = {4, 0,  -5, 0,  1, 0, 0, -4, -4, 1,  1, 0,
+                               0, 4,  -4, -1, 1, 0, 0, -2, -1, 2,  1, 0,
+                               0, 2,  -1, -2, 1, 0, 0, 4,  0,  -5, 0, 1};
+  static const double kF6[] = {
+      1, 0,    -5.25, 0,     5.25,  0,    -1, 0,  //
+      0, 1,    1,     -4.25, -4.25, 1,    1,  0,  //
+      0, -1,   1,     4.25,  -4.25, -1,   1,  0,  //
+      0, 0.5,  0.25,  -2.5,  -1.25, 2,    1,  0,  //
+      0, -0.5, 0.25,  2.5,   -1.25, -2,   1,  0,  //
+      0, 2,    4,     -2.5,  -5,    0.5,  1,  0,  //
+      0, -2,   4,     2.5,   -5,    -0.5, 1,  0,  //
+      0, -1,   0,     5.25,  0,     -5.25, 0, 1};
+  const int64 out_tile_size = output_shape_.rows;
+  const double* m =
+      out_tile_size == 2 ? kF2 : (out_tile_size == 4 ? kF4 : kF6);
+  ComputeKroneckerProduct(input_shape_.rows, input_shape_.rows, m, rows, cols,
+                          transform_matrix);
+}
 
 // The output transform matrix is the kronecker product 'M * M' of the
-// following matrix 'M':
+// following matrix 'M' (F(2x2,3x3)):
 //
 //   [1  1  1  0]
 //   [0  1 -1 -1]
 //
+// F(4x4,3x3):
+//
+//   [1  1  1  1  1  0]
+//   [0  1 -1  2 -2  0]
+//   [0  1  1  4  4  0]
+//   [0  1 -1  8 -8  1]
+//
+// F(6x6,3x3):
+//
+//   [1  1  1   1    1    1     1     0]
+//   [0  1 -1   2   -2    1/2  -1/2   0]
+//   [0  1  1   4    4    1/4   1/4   0]
+//   [0  1 -1   8   -8    1/8  -1/8   0]
+//   [0  1  1  16   16    1/16  1/16  0]
+//   [0  1 -1  32  -32    1/32 -1/32  1]
+//
 // Data layout of 'transform_matrix':
 //   [out_tile_spatial_size, tile_spatial_size]
 //
@@ -313,64 +237,22 @@ template <typename T>
 void WinogradTransform<T>::GetOutputTransformMatrix(const int64 rows,
                                                     const int64 cols,
                                                     T* transform_matrix) const {
-  CHECK_GT(rows, 0);
-  CHECK_GT(cols, 0);
-  memset(transform_matrix, 0, sizeof(T) * rows * cols);
-
-  // Sub matrix [0,0]
-  transform_matrix[0 * cols + 0] = T(1.0);
-  transform_matrix[0 * cols + 1] = T(1.0);
-  transform_matrix[0 * cols + 2] = T(1.0);
-
-  transform_matrix[1 * cols + 1] = T(1.0);
-  transform_matrix[1 * cols + 2] = T(-1.0);
-  transform_matrix[1 * cols + 3] = T(-1.0);
-
-  // Sub matrix [0,1]
-  transform_matrix[0 * cols + 4] = T(1.0);
-  transform_matrix[0 * cols + 5] = T(1.0);
-  transform_matrix[0 * cols + 6] = T(1.0);
-
-  transform_matrix[1 * cols + 5] = T(1.0);
-  transform_matrix[1 * cols + 6] = T(-1.0);
-  transform_matrix[1 * cols + 7] = T(-1.0);
-
-  // Sub matrix [0,2]
-  transform_matrix[0 * cols + 8] = T(1.0);
-  transform_matrix[0 * cols + 9] = T(1.0);
-  transform_matrix[0 * cols + 10] = T(1.0);
-
-  transform_matrix[1 * cols + 9] = T(1.0);
-  transform_matrix[1 * cols + 10] = T(-1.0);
-  transform_matrix[1 * cols + 11] = T(-1.0);
-
-  // Sub matrix [1,1]
-  transform_matrix[2 * cols + 4] = T(1.0);
-  transform_matrix[2 * cols + 5] = T(1.0);
-  transform_matrix[2 * cols + 6] = T(1.0);
-
-  transform_matrix[3 * cols + 5] = T(1.0);
-  transform_matrix[3 * cols + 6] = T(-1.0);
-  transform_matrix[3 * cols + 7] = T(-1.0);
-
-  // Sub matrix [1,2]
-  transform_matrix[2 * cols + 8] = T(-1.0);
-  transform_matrix[2 * cols + 9] = T(-1.0);
-  transform_matrix[2 * cols + 10] = T(-1.0);
-
-  transform_matrix[3 * cols + 9] = T(-1.0);
-  transform_matrix[3 * cols + 10] = T(1.0);
-  transform_matrix[3 * cols + 11] = T(1.0);
-
-  // Sub matrix [1,3]
-  transform_matrix[2 * cols + 12] = T(-1.0);
-  transform_matrix[2 * cols + 13] = T(-1.0);
-  transform_matrix[2 * cols + 14] = T(-1.0);
-
-  transform_matrix[3 * cols + 13] = T(-1.0);
-  transform_matrix[3 * cols + 14] = T(1.0);
-  transform_matrix[3 * cols + 15] = T(1.0);
-};
+  static const double kF2[] = {1, 1, 1, 0, 0, 1, -1, -1};
+  static const double kF4[] = {1, 1, 1,  1, 1,  0, 0, 1, -1, 2, -2, 0,
+                               0, 1, 1,  4, 4,  0, 0, 1, -1, 8, -8, 1};
+  static const double kF6[] = {
+      1, 1, 1,  1,  1,   1,       1,        0,  //
+      0, 1, -1, 2,  -2,  0.5,     -0.5,     0,  //
+      0, 1, 1,  4,  4,   0.25,    0.25,     0,  //
+      0, 1, -1, 8,  -8,  0.125,   -0.125,   0,  //
+      0, 1, 1,  16, 16,  0.0625,  0.0625,   0,  //
+      0, 1, -1, 32, -32, 0.03125, -0.03125, 1};
+  const int64 out_tile_size = output_shape_.rows;
+  const double* m =
+      out_tile_size == 2 ? kF2 : (out_tile_size == 4 ? kF4 : kF6);
+  ComputeKroneckerProduct(output_shape_.rows, input_shape_.rows, m, rows, cols,
+                          transform_matrix);
+}
 
 }  // namespace tensorflow
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/guarded_philox_random.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -276,8 +278,8 @@ class NegTrainOp : public OpKernel {
     OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(learning_rate.shape()),
                 errors::InvalidArgument("Must be a scalar"));
 
-    auto Tw_in = w_in.matrix<float>();
-    auto Tw_out = w_out.matrix<float>();
+    float* const w_in_data = w_in.matrix<float>().data();
+    float* const w_out_data = w_out.matrix<float>().data();
     auto Texamples = examples.flat<int32>();
     auto Tlabels = labels.flat<int32>();
     auto lr = learning_rate.scalar<float>()();
@@ -288,60 +290,66 @@ class NegTrainOp : public OpKernel {
                 errors::InvalidArgument("vocab_size mismatches: ", vocab_size,
                                         " vs. ", sampler_->num()));
 
-    // Gradient accumulator for v_in.
-    Tensor buf(DT_FLOAT, TensorShape({dims}));
-    auto Tbuf = buf.flat<float>();
-
-    // Scalar buffer to hold sigmoid(+/- dot).
-    Tensor g_buf(DT_FLOAT, TensorShape({}));
-    auto g = g_buf.scalar<float>();
-
-    // The following loop needs 2 random 32-bit values per negative
-    // sample.  We reserve 8 values per sample just in case the
-    // underlying implementation changes.
-    auto rnd = base_.ReserveSamples32(batch_size * num_samples_ * 8);
-    random::SimplePhilox srnd(&rnd);
-
-    for (int64 i = 0; i < batch_size; ++i) {
-      const int32 example = Texamples(i);
-      DCHECK(0 <= example && example < vocab_size) << example;
-      const int32 label = Tlabels(i);
-      DCHECK(0 <= label && label < vocab_size) << label;
-      auto v_in = Tw_in.chip<0>(example);
-
-      // Positive: example predicts label.
-      //   forward: x = v_in' * v_out
-      //            l = log(sigmoid(x))
-      //   backward: dl/dx = g = sigmoid(-x)
-      //             dl/d(v_in) = g * v_out'
-      //             dl/d(v_out) = v_in' * g
-      {
-        auto v_out = Tw_out.chip<0>(label);
-        auto dot = (v_in * v_out).sum();
-        g = (dot.exp() + 1.f).inverse();
-        Tbuf = v_out * (g() * lr);
-        v_out += v_in * (g() * lr);
-      }
+    // The examples are sharded over the intra op threads, which update the
+    // embeddings Hogwild style: without locking, like concurrent instances of
+    // this op already do. The rows are mapped as Eigen vectors so that the
+    // dot products and updates use its vectorized kernels.
+    using Vector = Eigen::Map<Eigen::VectorXf>;
+    auto train = [&](int64 start, int64 limit) {
+      // Gradient accumulator for v_in.
+      Eigen::VectorXf buf(dims);
+
+      // The following loop needs 2 random 32-bit values per negative
+      // sample.  We reserve 8 values per sample just in case the
+      // underlying implementation changes.
+      auto rnd = base_.ReserveSamples32((limit - start) * num_samples_ * 8);
+      random::SimplePhilox srnd(&rnd);
+
+      for (int64 i = start; i < limit; ++i) {
+        const int32 example = Texamples(i);
+        DCHECK(0 <= example && example < vocab_size) << example;
+        const int32 label = Tlabels(i);
+        DCHECK(0 <= label && label < vocab_size) << label;
+        Vector v_in(w_in_data + example * dims, dims);
+
+        // Positive: example predicts label.
+        //   forward: x = v_in' * v_out
+        //            l = log(sigmoid(x))
+        //   backward: dl/dx = g = sigmoid(-x)
+        //             dl/d(v_in) = g * v_out'
+        //             dl/d(v_out) = v_in' * g
+        {
+          Vector v_out(w_out_data + label * dims, dims);
+          const float g = 1.f / (std::exp(v_in.dot(v_out)) + 1.f);
+          buf.noalias() = v_out * (g * lr);
+          v_out.noalias() += v_in * (g * lr);
+        }
 
-      // Negative samples:
-      //   forward: x = v_in' * v_sample
-      //            l = log(sigmoid(-x))
-      //   backward: dl/dx = g = -sigmoid(x)
-      //             dl/d(v_in) = g * v_out'
-      //             dl/d(v_out) = v_in' * g
-      for (int j = 0; j < num_samples_; ++j) {
-        const int sample = sampler_->Sample(&srnd);
-        if (sample == label) continue;  // Skip.
-        auto v_sample = Tw_out.chip<0>(sample);
-        auto dot = (v_in * v_sample).sum();
-        g = -((-dot).exp() + 1.f).inverse();
-        Tbuf += v_sample * (g() * lr);
-        v_sample += v_in * (g() * lr);
-      }
+        // Negative samples:
+        //   forward: x = v_in' * v_sample
+        //            l = log(sigmoid(-x))
+        //   backward: dl/dx = g = -sigmoid(x)
+        //             dl/d(v_in) = g * v_out'
+        //             dl/d(v_out) = v_in' * g
+        for (int j = 0; j < num_samples_; ++j) {
+          const int sample = sampler_->Sample(&srnd);
+          if (sample == label) continue;  // Skip.
+          Vector v_sample(w_out_data + sample * dims, dims);
+          const float g = -1.f / (std::exp(-v_in.dot(v_sample)) + 1.f);
+          buf.noalias() += v_sample * (g * lr);
+          v_sample.noalias() += v_in * (g * lr);
+        }
 
-      // Applies the gradient on v_in.
-      v_in += Tbuf;
-    }
+        // Applies the gradient on v_in.
+        v_in += buf;
+      }
+    };
+    // Each example reads and updates 2 + num_negative_samples rows.
+    const int64 cost_per_example = (2 + num_samples_) * dims * 4;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_example, train);
   }
 
  private:
@@ -18,6 +18,11 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/kernels/xent_op.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -74,8 +79,25 @@ class SoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
+namespace {
+
+// float is faster on the CPU than half, and also more precise, so use float
+// for the temporary accumulators.
+template <class T>
+struct AccumulatorType {
+  typedef T type;
+};
+
+template <>
+struct AccumulatorType<Eigen::half> {
+  typedef float type;
+};
+
+// The number of classes the CPU implementation works on at a time.
+constexpr int64 kXentBlockSize = 1024;
+
+}  // namespace
+
 namespace functor {
 template <typename Device, typename T>
 struct XentFunctorBase {
@@ -89,8 +111,89 @@ struct XentFunctorBase {
   }
 };
 
+// The CPU implementation works on each example in blocks of classes that
+// stay in the cache, and makes two passes over its logits instead of the five
+// of XentEigenImpl. The first pass computes the log-sum-exp of the logits
+// online, rescaling the running sum whenever a block raises the maximum. The
+// second computes the loss and writes the backprop, which may be the logits
+// buffer itself: each block is read before it is overwritten.
 template <typename T>
-struct XentFunctor<CPUDevice, T> : XentFunctorBase<CPUDevice, T> {};
+struct XentFunctor<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
+                  typename TTypes<T>::ConstMatrix labels,
+                  typename TTypes<T>::Matrix scratch,
+                  typename TTypes<T>::Vec loss,
+                  typename TTypes<T>::Matrix backprop) {
+    typedef typename AccumulatorType<T>::type AccT;
+    typedef Eigen::Map<Eigen::Array<AccT, Eigen::Dynamic, 1>> Block;
+    const int64 batch_size = logits.dimension(0);
+    const int64 num_classes = logits.dimension(1);
+
+    auto work = [&logits, &labels, &loss, &backprop, num_classes](
+                    int64 start, int64 limit) {
+      AccT logits_buffer[kXentBlockSize];
+      AccT labels_buffer[kXentBlockSize];
+      for (int64 b = start; b < limit; ++b) {
+        const T* logits_row = &logits(b, 0);
+        const T* labels_row = &labels(b, 0);
+        T* backprop_row = &backprop(b, 0);
+
+        // max is the largest logit so far, and sum the sum of
+        // exp(logit - max) over the logits so far.
+        const AccT neg_inf = -std::numeric_limits<AccT>::infinity();
+        AccT max = neg_inf;
+        AccT sum(0);
+        for (int64 c = 0; c < num_classes; c += kXentBlockSize) {
+          const int64 n = std::min(kXentBlockSize, num_classes - c);
+          Block block(logits_buffer, n);
+          Load(logits_row + c, n, logits_buffer);
+          const AccT block_max = block.maxCoeff();
+          // A block of -inf logits adds nothing to the sum.
+          if (block_max == neg_inf) continue;
+          if (block_max > max) {
+            sum *= Eigen::numext::exp(max - block_max);
+            max = block_max;
+          }
+          sum += (block - max).exp().sum();
+        }
+        const AccT log_sum_exp = max + Eigen::numext::log(sum);
+
+        // loss: sum(labels * (log_sum_exp - logits)).
+        // backprop: exp(logits - log_sum_exp) - labels.
+        AccT row_loss(0);
+        for (int64 c = 0; c < num_classes; c += kXentBlockSize) {
+          const int64 n = std::min(kXentBlockSize, num_classes - c);
+          Block block(logits_buffer, n);
+          Block label_block(labels_buffer, n);
+          Load(logits_row + c, n, logits_buffer);
+          Load(labels_row + c, n, labels_buffer);
+          row_loss += (label_block * (log_sum_exp - block)).sum();
+          block = (block - log_sum_exp).exp() - label_block;
+          Store(logits_buffer, n, backprop_row + c);
+        }
+        loss(b) = static_cast<T>(row_loss);
+      }
+    };
+    // Each class loads its logit twice and its label once, and stores its
+    // backprop, with two exps.
+    d.parallelFor(batch_size,
+                  Eigen::TensorOpCost(3 * num_classes * sizeof(T),
+                                      num_classes * sizeof(T),
+                                      40 * num_classes),
+                  work);
+  }
+
+ private:
+  template <typename AccT>
+  static void Load(const T* src, int64 n, AccT* dst) {
+    for (int64 i = 0; i < n; ++i) dst[i] = static_cast<AccT>(src[i]);
+  }
+
+  template <typename AccT>
+  static void Store(const AccT* src, int64 n, T* dst) {
+    for (int64 i = 0; i < n; ++i) dst[i] = static_cast<T>(src[i]);
+  }
+};
 
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
@@ -26,8 +26,88 @@ namespace tensorflow {
 
 typedef Eigen::GpuDevice GPUDevice;
 
-// Partial specialization for a GPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
+namespace {
+
+// half has no fast exp or log, so its sums are done in float.
+template <class T>
+struct AccumulatorType {
+  typedef T type;
+};
+
+template <>
+struct AccumulatorType<Eigen::half> {
+  typedef float type;
+};
+
+constexpr int kXentThreadsPerBlock = 256;
+
+// Adds the logits summarized by ('other_max', 'other_sum') to those
+// summarized by ('*max', '*sum'), where max is the largest logit and sum the
+// sum of exp(logit - max). -inf logits add nothing.
+template <typename AccT>
+__device__ void MergeLogSumExp(AccT other_max, AccT other_sum, AccT* max,
+                               AccT* sum) {
+  if (other_max > *max) {
+    *sum = *sum * Eigen::numext::exp(*max - other_max) + other_sum;
+    *max = other_max;
+  } else if (other_max != -Eigen::NumTraits<AccT>::infinity()) {
+    *sum += other_sum * Eigen::numext::exp(other_max - *max);
+  }
+}
+
+// Computes the loss and backprop of one example per block, in two passes
+// over its logits. The first computes their log-sum-exp online, and the
+// second computes the loss and writes the backprop. 'backprop' may be
+// 'logits': each logit is read and overwritten by the same thread.
+template <typename T>
+__global__ void SoftmaxXentKernel(int64 num_classes, const T* logits,
+                                  const T* labels, T* loss, T* backprop) {
+  typedef typename AccumulatorType<T>::type AccT;
+  __shared__ AccT s_max[kXentThreadsPerBlock];
+  __shared__ AccT s_sum[kXentThreadsPerBlock];
+  const int tid = threadIdx.x;
+  const int64 offset = static_cast<int64>(blockIdx.x) * num_classes;
+  const T* logits_row = logits + offset;
+  const T* labels_row = labels + offset;
+  T* backprop_row = backprop + offset;
+
+  AccT max = -Eigen::NumTraits<AccT>::infinity();
+  AccT sum(0);
+  for (int64 c = tid; c < num_classes; c += blockDim.x) {
+    MergeLogSumExp(static_cast<AccT>(logits_row[c]), AccT(1), &max, &sum);
+  }
+  s_max[tid] = max;
+  s_sum[tid] = sum;
+  __syncthreads();
+  for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (tid < stride) {
+      MergeLogSumExp(s_max[tid + stride], s_sum[tid + stride], &s_max[tid],
+                     &s_sum[tid]);
+    }
+    __syncthreads();
+  }
+  const AccT log_sum_exp = s_max[0] + Eigen::numext::log(s_sum[0]);
+  __syncthreads();
+
+  AccT row_loss(0);
+  for (int64 c = tid; c < num_classes; c += blockDim.x) {
+    const AccT logit = static_cast<AccT>(logits_row[c]);
+    const AccT label = static_cast<AccT>(labels_row[c]);
+    row_loss += label * (log_sum_exp - logit);
+    backprop_row[c] =
+        static_cast<T>(Eigen::numext::exp(logit - log_sum_exp) - label);
+  }
+  s_sum[tid] = row_loss;
+  __syncthreads();
+  for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (tid < stride) s_sum[tid] += s_sum[tid + stride];
+    __syncthreads();
+  }
+  if (tid == 0) loss[blockIdx.x] = static_cast<T>(s_sum[0]);
+}
+
+}  // namespace
+
 namespace functor {
 template <typename T>
 struct XentFunctor<GPUDevice, T> {
@@ -36,8 +116,12 @@ struct XentFunctor<GPUDevice, T> {
                   typename TTypes<T>::Matrix scratch,
                   typename TTypes<T>::Vec loss,
                   typename TTypes<T>::Matrix backprop) {
-    XentEigenImpl<GPUDevice, T>::Compute(d, logits, labels, scratch, loss,
-                                         backprop);
+    const int64 batch_size = logits.dimension(0);
+    const int64 num_classes = logits.dimension(1);
+    if (batch_size == 0) return;
+    SoftmaxXentKernel<T><<<batch_size, kXentThreadsPerBlock, 0, d.stream()>>>(
+        num_classes, logits.data(), labels.data(), loss.data(),
+        backprop.data());
   }
 };
 }  // end namespace functor
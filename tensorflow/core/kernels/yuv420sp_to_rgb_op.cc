@@ -0,0 +1,374 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define YUV420SP_TO_RGB_USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace tensorflow {
+
+namespace {
+
+// The BT.601 video-range coefficients, in the 10 bit fixed point of
+// tensorflow/examples/android/jni/yuv2rgb.cc.
+const int kYCoeff = 1192;
+const int kVToRCoeff = 1634;
+const int kVToGCoeff = 833;
+const int kUToGCoeff = 400;
+const int kUToBCoeff = 2066;
+const int kFixedPointShift = 10;
+
+// The largest value that is still 255 after the shift.
+const int kMaxChannelValue = (256 << kFixedPointShift) - 1;
+
+inline uint8 ClampChannel(int value) {
+  return static_cast<uint8>(std::min(std::max(value, 0), kMaxChannelValue) >>
+                            kFixedPointShift);
+}
+
+// Checks the YUV420SP frame in input 0 and returns its luma size.
+void GetFrameSize(OpKernelContext* context, int64* height, int64* width) {
+  const Tensor& input = context->input(0);
+  OP_REQUIRES(context, input.dims() == 2,
+              errors::InvalidArgument("yuv must be 2-dimensional",
+                                      input.shape().DebugString()));
+  OP_REQUIRES(context, input.dim_size(0) % 3 == 0,
+              errors::InvalidArgument(
+                  "yuv must have height * 3 / 2 rows for an even height, got ",
+                  input.dim_size(0)));
+  *height = input.dim_size(0) / 3 * 2;
+  *width = input.dim_size(1);
+  OP_REQUIRES(context, *width % 2 == 0,
+              errors::InvalidArgument("yuv must have an even width, got ",
+                                      *width));
+}
+
+// Returns the offset of the U sample within a chroma pair.
+int GetUOffset(const string& uv_order) { return uv_order == "UV" ? 0 : 1; }
+
+#ifdef YUV420SP_TO_RGB_USE_NEON
+
+// Shifts and saturates 8 fixed point values to [0, 255], which matches
+// ClampChannel().
+inline uint8x8_t NarrowChannel(int32x4_t lo, int32x4_t hi) {
+  return vqmovn_u16(vcombine_u16(vqshrun_n_s32(lo, kFixedPointShift),
+                                 vqshrun_n_s32(hi, kFixedPointShift)));
+}
+
+// Converts 8 pixels, given max(y - 16, 0), u - 128 and v - 128.
+inline void ConvertPixels(int16x8_t y, int16x8_t u, int16x8_t v, uint8x8_t* r,
+                          uint8x8_t* g, uint8x8_t* b) {
+  const int32x4_t y_lo = vmull_n_s16(vget_low_s16(y), kYCoeff);
+  const int32x4_t y_hi = vmull_n_s16(vget_high_s16(y), kYCoeff);
+  *r = NarrowChannel(vmlal_n_s16(y_lo, vget_low_s16(v), kVToRCoeff),
+                     vmlal_n_s16(y_hi, vget_high_s16(v), kVToRCoeff));
+  *g = NarrowChannel(
+      vmlsl_n_s16(vmlsl_n_s16(y_lo, vget_low_s16(v), kVToGCoeff),
+                  vget_low_s16(u), kUToGCoeff),
+      vmlsl_n_s16(vmlsl_n_s16(y_hi, vget_high_s16(v), kVToGCoeff),
+                  vget_high_s16(u), kUToGCoeff));
+  *b = NarrowChannel(vmlal_n_s16(y_lo, vget_low_s16(u), kUToBCoeff),
+                     vmlal_n_s16(y_hi, vget_high_s16(u), kUToBCoeff));
+}
+
+#endif  // YUV420SP_TO_RGB_USE_NEON
+
+// Converts one row of "width" pixels to packed RGB.
+void ConvertRow(const uint8* y_row, const uint8* uv_row, int width,
+                int u_offset, uint8* rgb_row) {
+  int x = 0;
+#ifdef YUV420SP_TO_RGB_USE_NEON
+  const int16x8_t chroma_bias = vdupq_n_s16(128);
+  const uint8x16_t luma_bias = vdupq_n_u8(16);
+  // Handle 16 pixels, and so 8 chroma pairs, at a time.
+  for (; x <= width - 16; x += 16) {
+    const uint8x8x2_t uv = vld2_u8(uv_row + x);
+    const int16x8_t u = vsubq_s16(
+        vreinterpretq_s16_u16(vmovl_u8(uv.val[u_offset])), chroma_bias);
+    const int16x8_t v = vsubq_s16(
+        vreinterpretq_s16_u16(vmovl_u8(uv.val[1 - u_offset])), chroma_bias);
+    // Each chroma pair covers two horizontally adjacent pixels.
+    const int16x8x2_t u2 = vzipq_s16(u, u);
+    const int16x8x2_t v2 = vzipq_s16(v, v);
+    const uint8x16_t y = vqsubq_u8(vld1q_u8(y_row + x), luma_bias);
+
+    uint8x8_t r[2], g[2], b[2];
+    ConvertPixels(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y))), u2.val[0],
+                  v2.val[0], &r[0], &g[0], &b[0]);
+    ConvertPixels(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y))), u2.val[1],
+                  v2.val[1], &r[1], &g[1], &b[1]);
+    uint8x16x3_t rgb;
+    rgb.val[0] = vcombine_u8(r[0], r[1]);
+    rgb.val[1] = vcombine_u8(g[0], g[1]);
+    rgb.val[2] = vcombine_u8(b[0], b[1]);
+    vst3q_u8(rgb_row + 3 * x, rgb);
+  }
+#endif
+  // Handle leftover pixels, one by one.
+  for (; x < width; ++x) {
+    const int y = std::max(y_row[x] - 16, 0);
+    const int u = uv_row[(x & ~1) + u_offset] - 128;
+    const int v = uv_row[(x & ~1) + 1 - u_offset] - 128;
+    uint8* rgb = rgb_row + 3 * x;
+    rgb[0] = ClampChannel(kYCoeff * y + kVToRCoeff * v);
+    rgb[1] = ClampChannel(kYCoeff * y - kVToGCoeff * v - kUToGCoeff * u);
+    rgb[2] = ClampChannel(kYCoeff * y + kUToBCoeff * u);
+  }
+}
+
+// Converts one row of interpolated Y, U and V values to normalized RGB, as
+// ConvertRow() does but in floating point.
+void ConvertAndNormalizeRow(const float* y_row, const float* u_row,
+                            const float* v_row, int width, float scale,
+                            float offset, float* rgb_row) {
+  const float kY = kYCoeff / 1024.f;
+  const float kVToR = kVToRCoeff / 1024.f;
+  const float kVToG = kVToGCoeff / 1024.f;
+  const float kUToG = kUToGCoeff / 1024.f;
+  const float kUToB = kUToBCoeff / 1024.f;
+  int x = 0;
+#ifdef YUV420SP_TO_RGB_USE_NEON
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  const float32x4_t max = vdupq_n_f32(255.f);
+  const float32x4_t scale4 = vdupq_n_f32(scale);
+  const float32x4_t offset4 = vdupq_n_f32(offset);
+  // Handle 4 pixels at a time
+  for (; x <= width - 4; x += 4) {
+    const float32x4_t y = vmulq_n_f32(
+        vmaxq_f32(vsubq_f32(vld1q_f32(y_row + x), vdupq_n_f32(16.f)), zero),
+        kY);
+    const float32x4_t u = vsubq_f32(vld1q_f32(u_row + x), vdupq_n_f32(128.f));
+    const float32x4_t v = vsubq_f32(vld1q_f32(v_row + x), vdupq_n_f32(128.f));
+    float32x4x3_t rgb;
+    rgb.val[0] = vmlaq_n_f32(y, v, kVToR);
+    rgb.val[1] = vmlsq_n_f32(vmlsq_n_f32(y, v, kVToG), u, kUToG);
+    rgb.val[2] = vmlaq_n_f32(y, u, kUToB);
+    for (int c = 0; c < 3; ++c) {
+      const float32x4_t clamped = vminq_f32(vmaxq_f32(rgb.val[c], zero), max);
+      rgb.val[c] = vmlaq_f32(offset4, clamped, scale4);
+    }
+    vst3q_f32(rgb_row + 3 * x, rgb);
+  }
+#endif
+  // Handle leftover pixels, one by one.
+  for (; x < width; ++x) {
+    const float y = std::max(y_row[x] - 16.f, 0.f) * kY;
+    const float u = u_row[x] - 128.f;
+    const float v = v_row[x] - 128.f;
+    const float rgb[3] = {y + kVToR * v, y - kVToG * v - kUToG * u,
+                          y + kUToB * u};
+    for (int c = 0; c < 3; ++c) {
+      rgb_row[3 * x + c] =
+          std::min(std::max(rgb[c], 0.f), 255.f) * scale + offset;
+    }
+  }
+}
+
+// The source pixels and weight of one output coordinate, as in
+// resize_bilinear_op.cc.
+struct Interpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+void ComputeInterpolations(int64 out_size, int64 in_size, float scale,
+                           std::vector<Interpolation>* interpolations) {
+  interpolations->resize(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    const float in = i * scale;
+    Interpolation& interpolation = (*interpolations)[i];
+    interpolation.lower = static_cast<int64>(in);
+    interpolation.upper = std::min(interpolation.lower + 1, in_size - 1);
+    interpolation.lerp = in - interpolation.lower;
+  }
+}
+
+inline float Lerp(float top_left, float top_right, float bottom_left,
+                  float bottom_right, float x_lerp, float y_lerp) {
+  const float top = top_left + (top_right - top_left) * x_lerp;
+  const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
+  return top + (bottom - top) * y_lerp;
+}
+
+}  // namespace
+
+class YUV420SPToRGBOp : public OpKernel {
+ public:
+  explicit YUV420SPToRGBOp(OpKernelConstruction* context) : OpKernel(context) {
+    string uv_order;
+    OP_REQUIRES_OK(context, context->GetAttr("uv_order", &uv_order));
+    u_offset_ = GetUOffset(uv_order);
+  }
+
+  void Compute(OpKernelContext* context) override {
+    int64 height;
+    int64 width;
+    GetFrameSize(context, &height, &width);
+    if (!context->status().ok()) return;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({height, width, 3}), &output));
+    if (output->NumElements() == 0) return;
+
+    const uint8* y_plane = context->input(0).flat<uint8>().data();
+    const uint8* uv_plane = y_plane + height * width;
+    uint8* rgb = output->flat<uint8>().data();
+    const int u_offset = u_offset_;
+    auto convert_rows = [=](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        ConvertRow(y_plane + row * width, uv_plane + (row >> 1) * width,
+                   width, u_offset, rgb + row * width * 3);
+      }
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, height,
+          width * 20, convert_rows);
+  }
+
+ private:
+  int u_offset_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(YUV420SPToRGBOp);
+};
+
+class YUV420SPToResizedRGBOp : public OpKernel {
+ public:
+  explicit YUV420SPToResizedRGBOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string uv_order;
+    OP_REQUIRES_OK(context, context->GetAttr("uv_order", &uv_order));
+    u_offset_ = GetUOffset(uv_order);
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+    float mean;
+    OP_REQUIRES_OK(context, context->GetAttr("mean", &mean));
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    offset_ = -mean * scale_;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    int64 height;
+    int64 width;
+    GetFrameSize(context, &height, &width);
+    if (!context->status().ok()) return;
+
+    const Tensor& size = context->input(1);
+    OP_REQUIRES(context, size.dims() == 1,
+                errors::InvalidArgument("size must be 1-dimensional",
+                                        size.shape().DebugString()));
+    OP_REQUIRES(context, size.NumElements() == 2,
+                errors::InvalidArgument("size must have two elements",
+                                        size.shape().DebugString()));
+    auto sizes = size.vec<int32>();
+    const int64 out_height = sizes(0);
+    const int64 out_width = sizes(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("output dimensions must be positive"));
+    OP_REQUIRES(context, height > 0 && width > 0,
+                errors::InvalidArgument("input frame must not be empty"));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({1, out_height, out_width, 3}), &output));
+
+    std::vector<Interpolation> ys;
+    std::vector<Interpolation> xs;
+    ComputeInterpolations(
+        out_height, height,
+        CalculateResizeScale(height, out_height, align_corners_), &ys);
+    ComputeInterpolations(
+        out_width, width,
+        CalculateResizeScale(width, out_width, align_corners_), &xs);
+
+    const uint8* y_plane = context->input(0).flat<uint8>().data();
+    const uint8* uv_plane = y_plane + height * width;
+    float* rgb = output->flat<float>().data();
+    const int u_offset = u_offset_;
+    const float scale = scale_;
+    const float offset = offset_;
+    auto convert_rows = [&, y_plane, uv_plane, rgb](int64 start, int64 limit) {
+      // The interpolated Y, U and V values of one output row.
+      std::vector<float> yuv(out_width * 3);
+      float* y_row = yuv.data();
+      float* u_row = y_row + out_width;
+      float* v_row = u_row + out_width;
+      for (int64 out_y = start; out_y < limit; ++out_y) {
+        const Interpolation& in_y = ys[out_y];
+        const uint8* y_top = y_plane + in_y.lower * width;
+        const uint8* y_bottom = y_plane + in_y.upper * width;
+        const uint8* uv_top = uv_plane + (in_y.lower >> 1) * width;
+        const uint8* uv_bottom = uv_plane + (in_y.upper >> 1) * width;
+        for (int64 out_x = 0; out_x < out_width; ++out_x) {
+          const Interpolation& in_x = xs[out_x];
+          const int64 left = in_x.lower;
+          const int64 right = in_x.upper;
+          y_row[out_x] = Lerp(y_top[left], y_top[right], y_bottom[left],
+                              y_bottom[right], in_x.lerp, in_y.lerp);
+          // Interpolate the chroma of the same four pixels, so that this
+          // matches converting them before interpolating up to clamping.
+          const int64 uv_left = (left & ~1) + u_offset;
+          const int64 uv_right = (right & ~1) + u_offset;
+          u_row[out_x] = Lerp(uv_top[uv_left], uv_top[uv_right],
+                              uv_bottom[uv_left], uv_bottom[uv_right],
+                              in_x.lerp, in_y.lerp);
+          const int64 v_left = (left & ~1) + 1 - u_offset;
+          const int64 v_right = (right & ~1) + 1 - u_offset;
+          v_row[out_x] =
+              Lerp(uv_top[v_left], uv_top[v_right], uv_bottom[v_left],
+                   uv_bottom[v_right], in_x.lerp, in_y.lerp);
+        }
+        ConvertAndNormalizeRow(y_row, u_row, v_row, out_width, scale, offset,
+                               rgb + out_y * out_width * 3);
+      }
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, out_height,
+          out_width * 60, convert_rows);
+  }
+
+ private:
+  int u_offset_;
+  bool align_corners_;
+  float scale_;
+  float offset_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(YUV420SPToResizedRGBOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("YUV420SPToRGB").Device(DEVICE_CPU),
+                        YUV420SPToRGBOp);
+REGISTER_KERNEL_BUILDER(
+    Name("YUV420SPToResizedRGB").Device(DEVICE_CPU).HostMemory("size"),
+    YUV420SPToResizedRGBOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,209 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a NV21 frame with arbitrary but deterministic samples.
+std::vector<uint8> MakeFrame(int height, int width) {
+  std::vector<uint8> frame(height * width * 3 / 2);
+  for (size_t i = 0; i < frame.size(); ++i) {
+    frame[i] = (i * 37 + 11) % 256;
+  }
+  return frame;
+}
+
+// The straightforward conversion of the Android demo's yuv2rgb.cc, used to
+// check the optimized kernel.
+std::vector<uint8> ConvertBaseline(const std::vector<uint8>& frame, int height,
+                                   int width) {
+  std::vector<uint8> rgb;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int uv = height * width + (y / 2) * width + (x / 2) * 2;
+      const int luma = std::max(frame[y * width + x] - 16, 0);
+      const int v = frame[uv] - 128;
+      const int u = frame[uv + 1] - 128;
+      const int r = 1192 * luma + 1634 * v;
+      const int g = 1192 * luma - 833 * v - 400 * u;
+      const int b = 1192 * luma + 2066 * u;
+      for (int value : {r, g, b}) {
+        rgb.push_back(std::min(std::max(value, 0), 262143) >> 10);
+      }
+    }
+  }
+  return rgb;
+}
+
+class YUV420SPToRGBOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& uv_order) {
+    TF_EXPECT_OK(NodeDefBuilder("yuv420sp_to_rgb_op", "YUV420SPToRGB")
+                     .Input(FakeInput(DT_UINT8))
+                     .Attr("uv_order", uv_order)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(YUV420SPToRGBOpTest, TestBasic) {
+  MakeOp("VU");
+  // Black, white, orange and brown, in a 2x4 frame.
+  AddInputFromArray<uint8>(TensorShape({3, 4}), {16, 235, 128, 81,    //
+                                                 16, 235, 128, 81,    //
+                                                 128, 128, 200, 60});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_UINT8, TensorShape({2, 4, 3}));
+  test::FillValues<uint8>(&expected, {0,   0,  0, 254, 254, 254,  //
+                                      245, 98, 0, 190, 43,  0,    //
+                                      0,   0,  0, 254, 254, 254,  //
+                                      245, 98, 0, 190, 43,  0});
+  test::ExpectTensorEqual<uint8>(expected, *GetOutput(0));
+}
+
+TEST_F(YUV420SPToRGBOpTest, TestUVOrder) {
+  MakeOp("UV");
+  AddInputFromArray<uint8>(TensorShape({3, 2}), {128, 128,  //
+                                                 128, 128,  //
+                                                 60, 200});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_UINT8, TensorShape({2, 2, 3}));
+  test::FillValues<uint8>(&expected, {245, 98, 0, 245, 98, 0,  //
+                                      245, 98, 0, 245, 98, 0});
+  test::ExpectTensorEqual<uint8>(expected, *GetOutput(0));
+}
+
+TEST_F(YUV420SPToRGBOpTest, TestMatchesBaseline) {
+  MakeOp("VU");
+  // Wide enough for the vectorized path and with leftover pixels.
+  const int height = 6;
+  const int width = 38;
+  const std::vector<uint8> frame = MakeFrame(height, width);
+  AddInputFromArray<uint8>(TensorShape({height * 3 / 2, width}), frame);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_UINT8, TensorShape({height, width, 3}));
+  test::FillValues<uint8>(&expected, ConvertBaseline(frame, height, width));
+  test::ExpectTensorEqual<uint8>(expected, *GetOutput(0));
+}
+
+TEST_F(YUV420SPToRGBOpTest, TestOddWidth) {
+  MakeOp("VU");
+  AddInputFromArray<uint8>(TensorShape({3, 3}), {0, 0, 0, 0, 0, 0, 0, 0, 0});
+  Status s = RunOpKernel();
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "even width")) << s;
+}
+
+class YUV420SPToResizedRGBOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(float mean, float scale) {
+    TF_EXPECT_OK(
+        NodeDefBuilder("yuv420sp_to_resized_rgb_op", "YUV420SPToResizedRGB")
+            .Input(FakeInput(DT_UINT8))
+            .Input(FakeInput(DT_INT32))
+            .Attr("mean", mean)
+            .Attr("scale", scale)
+            .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+
+  // Checks the output against the baseline conversion of the frame, sampled
+  // every "stride" pixels and normalized.
+  void CheckAgainstBaseline(const std::vector<uint8>& frame, int height,
+                            int width, int stride, float mean, float scale) {
+    const std::vector<uint8> rgb = ConvertBaseline(frame, height, width);
+    const int out_height = height / stride;
+    const int out_width = width / stride;
+    std::vector<float> normalized;
+    for (int y = 0; y < out_height; ++y) {
+      for (int x = 0; x < out_width; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          const int i = ((y * stride) * width + x * stride) * 3 + c;
+          normalized.push_back((rgb[i] - mean) * scale);
+        }
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT,
+                    TensorShape({1, out_height, out_width, 3}));
+    test::FillValues<float>(&expected, normalized);
+    // The baseline rounds down to integers.
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1.001 * scale);
+  }
+};
+
+TEST_F(YUV420SPToResizedRGBOpTest, TestSameSize) {
+  MakeOp(127.5, 1 / 127.5);
+  const int height = 4;
+  const int width = 38;
+  const std::vector<uint8> frame = MakeFrame(height, width);
+  AddInputFromArray<uint8>(TensorShape({height * 3 / 2, width}), frame);
+  AddInputFromArray<int32>(TensorShape({2}), {height, width});
+  TF_ASSERT_OK(RunOpKernel());
+
+  CheckAgainstBaseline(frame, height, width, 1, 127.5, 1 / 127.5);
+}
+
+TEST_F(YUV420SPToResizedRGBOpTest, TestHalfSize) {
+  MakeOp(0, 1);
+  // Halving samples every other pixel without interpolation.
+  const int height = 8;
+  const int width = 40;
+  const std::vector<uint8> frame = MakeFrame(height, width);
+  AddInputFromArray<uint8>(TensorShape({height * 3 / 2, width}), frame);
+  AddInputFromArray<int32>(TensorShape({2}), {height / 2, width / 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  CheckAgainstBaseline(frame, height, width, 2, 0, 1);
+}
+
+TEST_F(YUV420SPToResizedRGBOpTest, TestInterpolation) {
+  MakeOp(0, 1);
+  // A gray ramp from Y = 16 to Y = 116 over two pixels, upsampled to three.
+  AddInputFromArray<uint8>(TensorShape({3, 2}), {16, 116,  //
+                                                 16, 116,  //
+                                                 128, 128});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Source columns 0, 2/3 and 4/3 (clamped to 1); Y = 16, 82.67 and 116.
+  const float k = 1192 / 1024.f;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 3, 3}));
+  test::FillValues<float>(
+      &expected, {0, 0, 0, 66.67f * k, 66.67f * k, 66.67f * k, 100 * k,
+                  100 * k, 100 * k,  //
+                  0, 0, 0, 66.67f * k, 66.67f * k, 66.67f * k, 100 * k,
+                  100 * k, 100 * k});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-2);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -688,6 +689,81 @@ TEST(FlatMap, UniqueMapIter) {
   EXPECT_EQ(val_sum, key_sum + (kCount * kValueDelta));
 }
 
+typedef std::unordered_map<int64, int32> StdNumMap;
+
+// std::hash<int64> is the identity, so spread the benchmark keys over the
+// whole hash range. The FlatMaps of 1600 and 100000 entries are filled close
+// to their maximum load, where probes are longest.
+int64 BenchmarkKey(int64 i) {
+  return static_cast<int64>(static_cast<uint64>(i) * 0x9E3779B97F4A7C15ull);
+}
+
+template <typename Map>
+void FindBenchmark(int iters, int n, int64 miss_offset) {
+  testing::StopTiming();
+  Map map;
+  for (int64 i = 0; i < n; i++) {
+    map[BenchmarkKey(i)] = i;
+  }
+  testing::StartTiming();
+  int64 found = 0;
+  for (int i = 0; i < iters; i++) {
+    found += map.count(BenchmarkKey(i % n + miss_offset));
+  }
+  testing::StopTiming();
+  CHECK_EQ(found, miss_offset == 0 ? iters : 0);
+  testing::ItemsProcessed(iters);
+}
+
+void BM_FlatMapFindHit(int iters, int n) {
+  FindBenchmark<NumMap>(iters, n, 0);
+}
+BENCHMARK(BM_FlatMapFindHit)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
+void BM_StdMapFindHit(int iters, int n) {
+  FindBenchmark<StdNumMap>(iters, n, 0);
+}
+BENCHMARK(BM_StdMapFindHit)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
+void BM_FlatMapFindMiss(int iters, int n) {
+  FindBenchmark<NumMap>(iters, n, n);
+}
+BENCHMARK(BM_FlatMapFindMiss)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
+void BM_StdMapFindMiss(int iters, int n) {
+  FindBenchmark<StdNumMap>(iters, n, n);
+}
+BENCHMARK(BM_StdMapFindMiss)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
+// Inserts and erases keys in a map holding n entries, as the rendezvous
+// table does with its pending sends and receives.
+template <typename Map>
+void InsertEraseBenchmark(int iters, int n) {
+  testing::StopTiming();
+  Map map;
+  for (int64 i = 0; i < n; i++) {
+    map[BenchmarkKey(i)] = i;
+  }
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    map[BenchmarkKey(n + i)] = i;
+    map.erase(BenchmarkKey(i));
+  }
+  testing::StopTiming();
+  CHECK_EQ(map.size(), n);
+  testing::ItemsProcessed(iters);
+}
+
+void BM_FlatMapInsertErase(int iters, int n) {
+  InsertEraseBenchmark<NumMap>(iters, n);
+}
+BENCHMARK(BM_FlatMapInsertErase)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
+void BM_StdMapInsertErase(int iters, int n) {
+  InsertEraseBenchmark<StdNumMap>(iters, n);
+}
+BENCHMARK(BM_StdMapInsertErase)->Arg(16)->Arg(1000)->Arg(1600)->Arg(100000);
+
 }  // namespace
 }  // namespace gtl
 }  // namespace tensorflow
@@ -18,9 +18,16 @@ limitations under the License.
 
 #include <string.h>
 #include <utility>
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 namespace tensorflow {
 namespace gtl {
 namespace internal {
@@ -39,13 +46,18 @@ namespace internal {
 //      These hash bits can be used to avoid potentially expensive
 //      key comparisons.
 //
+// A key is looked up one bucket at a time: the markers of all kWidth
+// entries of a bucket are compared against the key's marker at once (with
+// a single SSE2 or NEON compare where available), and the probe stops at
+// the first bucket that has an empty entry.
+//
 // FlatMap passes in a bucket that contains keys and values, FlatSet
 // passes in a bucket that does not contain values.
 template <typename Key, typename Bucket, class Hash, class Eq>
 class FlatRep {
  public:
   // kWidth is the number of entries stored in a bucket.
-  static const uint32 kBase = 3;
+  static const uint32 kBase = 4;
   static const uint32 kWidth = (1 << kBase);
 
   FlatRep(size_t N, const Hash& hf, const Eq& eq) : hash_(hf), equal_(eq) {
@@ -117,22 +129,34 @@ class FlatRep {
 
   // Hash value is partitioned as follows:
   // 1. Bottom 8 bits are stored in bucket to help speed up comparisons.
-  // 2. Next 3 bits give index inside bucket.
+  // 2. Next 4 bits give the preferred index inside each bucket.
   // 3. Remaining bits give bucket number.
+  //
+  // Keys are stored at their preferred index when it is free, and that
+  // index is checked before the rest of the bucket: its key can be loaded
+  // while the markers are compared.
 
   // Find bucket/index for key k.
   SearchResult Find(const Key& k) const {
     size_t h = hash_(k);
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
+    const uint32 pi = (h >> 8) & (kWidth - 1);  // Preferred index-in-bucket
+    size_t index = (h >> (8 + kBase)) & BucketMask();
+    uint32 num_probes = 1;  // Needed for quadratic probing
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == marker && equal_(b->key(bi), k)) {
-        return {true, b, bi};
-      } else if (x == kEmpty) {
+      Bucket* b = &array_[index];
+      if (b->marker[pi] == marker && equal_(b->key(pi), k)) {
+        return {true, b, pi};
+      }
+      const Markers markers(b);
+      for (uint32 m = markers.Match(marker) & ~(1u << pi); m != 0;
+           m &= m - 1) {
+        const uint32 bi = LowestBit(m);
+        if (equal_(b->key(bi), k)) {
+          return {true, b, bi};
+        }
+      }
+      if (markers.Match(kEmpty) != 0) {
         return {false, nullptr, 0};
       }
       index = NextIndex(index, num_probes);
@@ -149,27 +173,42 @@ class FlatRep {
   SearchResult FindOrInsert(KeyType&& k) {
     size_t h = hash_(k);
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
-    Bucket* del = nullptr;            // First encountered deletion for kInsert
+    const uint32 pi = (h >> 8) & (kWidth - 1);  // Preferred index-in-bucket
+    size_t index = (h >> (8 + kBase)) & BucketMask();
+    uint32 num_probes = 1;  // Needed for quadratic probing
+    Bucket* del = nullptr;  // First encountered deletion for kInsert
     uint32 di = 0;
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == marker && equal_(b->key(bi), k)) {
-        return {true, b, bi};
-      } else if (!del && x == kDeleted) {
+      Bucket* b = &array_[index];
+      if (b->marker[pi] == marker && equal_(b->key(pi), k)) {
+        return {true, b, pi};
+      }
+      const Markers markers(b);
+      for (uint32 m = markers.Match(marker) & ~(1u << pi); m != 0;
+           m &= m - 1) {
+        const uint32 bi = LowestBit(m);
+        if (equal_(b->key(bi), k)) {
+          return {true, b, bi};
+        }
+      }
+      if (!del) {
         // Remember deleted index to use for insertion.
-        del = b;
-        di = bi;
-      } else if (x == kEmpty) {
+        const uint32 deleted = markers.Match(kDeleted);
+        if (deleted != 0) {
+          del = b;
+          di = PreferredBit(deleted, pi);
+        }
+      }
+      const uint32 empty = markers.Match(kEmpty);
+      if (empty != 0) {
+        uint32 bi;
         if (del) {
           // Store in the first deleted slot we encountered
           b = del;
           bi = di;
           deleted_--;  // not_empty_ does not change
         } else {
+          bi = PreferredBit(empty, pi);
           not_empty_++;
         }
         b->marker[bi] = marker;
@@ -183,18 +222,24 @@ class FlatRep {
 
   void Erase(Bucket* b, uint32 i) {
     b->Destroy(i);
-    b->marker[i] = kDeleted;
-    deleted_++;
+    if (Markers(b).Match(kEmpty) != 0) {
+      // No probe has gone past a bucket with an empty entry, so the entry
+      // can be made empty again rather than deleted.
+      b->marker[i] = kEmpty;
+      not_empty_--;
+    } else {
+      b->marker[i] = kDeleted;
+      deleted_++;
+    }
     grow_ = 0;  // Consider shrinking on next insert
   }
 
   void Prefetch(const Key& k) const {
     size_t h = hash_(k);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 bi = index & (kWidth - 1);
-    Bucket* b = &array_[index >> kBase];
-    port::prefetch<port::PREFETCH_HINT_T0>(&b->marker[bi]);
-    port::prefetch<port::PREFETCH_HINT_T0>(&b->storage.key[bi]);
+    uint32 pi = (h >> 8) & (kWidth - 1);
+    Bucket* b = &array_[(h >> (8 + kBase)) & BucketMask()];
+    port::prefetch<port::PREFETCH_HINT_T0>(&b->marker[pi]);
+    port::prefetch<port::PREFETCH_HINT_T0>(&b->storage.key[pi]);
   }
 
   inline void MaybeResize() {
@@ -238,6 +283,66 @@ class FlatRep {
   // store in Bucket::marker[].
   static uint32 Marker(uint32 hb) { return hb + (hb < 2 ? 2 : 0); }
 
+  // The markers of a bucket, loaded once to be compared against several
+  // values. Match() returns a mask with bit i set for each entry i whose
+  // marker is equal to marker.
+  class Markers {
+   public:
+    static_assert(kWidth == 16, "Markers compares 16 markers at once");
+#if defined(__SSE2__)
+    explicit Markers(const Bucket* b)
+        : markers_(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(b->marker))) {}
+    uint32 Match(uint32 marker) const {
+      return _mm_movemask_epi8(
+          _mm_cmpeq_epi8(markers_, _mm_set1_epi8(static_cast<char>(marker))));
+    }
+
+   private:
+    const __m128i markers_;
+#elif defined(__aarch64__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+    explicit Markers(const Bucket* b) : markers_(vld1q_u8(b->marker)) {}
+    uint32 Match(uint32 marker) const {
+      // NEON has no movemask: keep bit (i % 8) of each matching byte i and
+      // sum each half of the bytes into a byte of the mask.
+      static const uint8 kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+      const uint8x16_t matches = vandq_u8(
+          vceqq_u8(markers_, vdupq_n_u8(marker)), vld1q_u8(kBits));
+      return vaddv_u8(vget_low_u8(matches)) |
+             (static_cast<uint32>(vaddv_u8(vget_high_u8(matches))) << 8);
+    }
+
+   private:
+    const uint8x16_t markers_;
+#else
+    explicit Markers(const Bucket* b) : markers_(b->marker) {}
+    uint32 Match(uint32 marker) const {
+      uint32 mask = 0;
+      for (uint32 i = 0; i < kWidth; i++) {
+        mask |= static_cast<uint32>(markers_[i] == marker) << i;
+      }
+      return mask;
+    }
+
+   private:
+    const uint8* markers_;
+#endif
+  };
+
+  // Returns the index of the lowest bit set in the non-zero mask m.
+  static inline uint32 LowestBit(uint32 m) {
+    return Log2Floor(m & (~m + 1));
+  }
+
+  // Returns i if bit i is set in the non-zero mask m, else its lowest bit.
+  static inline uint32 PreferredBit(uint32 m, uint32 i) {
+    return (m >> i) & 1 ? i : LowestBit(m);
+  }
+
+  // Mask of the bucket number in a hash value.
+  size_t BucketMask() const { return mask_ >> kBase; }
+
   void Init(size_t N) {
     // Make enough room for N elements.
     size_t lg = 0;  // Smallest table is just one bucket.
@@ -301,13 +406,14 @@ class FlatRep {
   void FreshInsert(Bucket* src, uint32 src_index, Copier copier) {
     size_t h = hash_(src->key(src_index));
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
+    const uint32 pi = (h >> 8) & (kWidth - 1);  // Preferred index-in-bucket
+    size_t index = (h >> (8 + kBase)) & BucketMask();
+    uint32 num_probes = 1;  // Needed for quadratic probing
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == 0) {
+      Bucket* b = &array_[index];
+      const uint32 empty = Markers(b).Match(kEmpty);
+      if (empty != 0) {
+        const uint32 bi = PreferredBit(empty, pi);
         b->marker[bi] = marker;
         not_empty_++;
         copier(b, bi, src, src_index);
@@ -319,8 +425,8 @@ class FlatRep {
   }
 
   inline size_t NextIndex(size_t i, uint32 num_probes) const {
-    // Quadratic probing.
-    return (i + num_probes) & mask_;
+    // Quadratic probing over the buckets.
+    return (i + num_probes) & BucketMask();
   }
 };
 
@@ -0,0 +1,165 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+
+static string GenTestString(int size) {
+  string result;
+  for (int i = 0; result.size() < static_cast<size_t>(size); ++i) {
+    strings::StrAppend(&result, "line ", i, " of the block zlib test.\n");
+  }
+  result.resize(size);
+  return result;
+}
+
+// Writes `data` in `num_writes` pieces with the given options and returns
+// the size of the file.
+static uint64 WriteBlockZlibFile(const string& fname, const string& data,
+                                 int64 block_bytes, int num_threads,
+                                 int num_writes) {
+  std::unique_ptr<WritableFile> file_writer;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file_writer));
+  BlockZlibOutputBuffer out(file_writer.get(), block_bytes, num_threads,
+                            ZlibCompressionOptions::DEFAULT());
+  const size_t piece = data.size() / num_writes + 1;
+  for (size_t pos = 0; pos < data.size(); pos += piece) {
+    TF_CHECK_OK(out.Append(StringPiece(data).substr(pos, piece)));
+  }
+  TF_CHECK_OK(out.Close());
+  TF_CHECK_OK(file_writer->Close());
+  uint64 file_size;
+  TF_CHECK_OK(Env::Default()->GetFileSize(fname, &file_size));
+  return file_size;
+}
+
+TEST(BlockZlibBuffers, RoundTrip) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/block_zlib_buffers_test";
+  for (int size : {0, 1, 1000, 100000}) {
+    const string data = GenTestString(size);
+    for (int64 block_bytes : {1, 100, 4096, 1 << 20}) {
+      if (size / block_bytes > 1000) continue;
+      for (int num_threads : {1, 4}) {
+        WriteBlockZlibFile(fname, data, block_bytes, num_threads, 7);
+
+        std::unique_ptr<RandomAccessFile> file_reader;
+        TF_CHECK_OK(env->NewRandomAccessFile(fname, &file_reader));
+        RandomAccessInputStream input_stream(file_reader.get());
+        BlockZlibInputStream in(&input_stream, num_threads, 3,
+                                ZlibCompressionOptions::DEFAULT());
+        string result;
+        TF_EXPECT_OK(in.ReadNBytes(data.size(), &result));
+        EXPECT_EQ(data, result);
+        EXPECT_EQ(data.size(), in.Tell());
+        EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &result)));
+      }
+    }
+  }
+}
+
+TEST(BlockZlibBuffers, SkipAndReset) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/block_zlib_buffers_test";
+  const string data = GenTestString(50000);
+  WriteBlockZlibFile(fname, data, 1000, 2, 3);
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file_reader));
+  RandomAccessInputStream input_stream(file_reader.get());
+  BlockZlibInputStream in(&input_stream, 2, 4,
+                          ZlibCompressionOptions::DEFAULT());
+  string result;
+  TF_EXPECT_OK(in.SkipNBytes(10));
+  TF_EXPECT_OK(in.ReadNBytes(20, &result));
+  EXPECT_EQ(data.substr(10, 20), result);
+  TF_EXPECT_OK(in.SkipNBytes(12345));
+  TF_EXPECT_OK(in.ReadNBytes(3000, &result));
+  EXPECT_EQ(data.substr(12375, 3000), result);
+  EXPECT_EQ(15375, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(data.size())));
+
+  TF_EXPECT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  TF_EXPECT_OK(in.ReadNBytes(data.size(), &result));
+  EXPECT_EQ(data, result);
+}
+
+TEST(BlockZlibBuffers, Index) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/block_zlib_buffers_test";
+  const string data = GenTestString(10000);
+  const uint64 file_size = WriteBlockZlibFile(fname, data, 1000, 4, 1);
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file_reader));
+  std::vector<BlockZlibIndexEntry> index;
+  TF_ASSERT_OK(ReadBlockZlibIndex(file_reader.get(), file_size, &index));
+  ASSERT_EQ(10, index.size());
+
+  // Each entry points at a block holding the data at its stream offset.
+  for (const BlockZlibIndexEntry& entry : index) {
+    RandomAccessInputStream input_stream(file_reader.get());
+    TF_ASSERT_OK(input_stream.SkipNBytes(entry.file_offset));
+    BlockZlibInputStream in(&input_stream, 1, 1,
+                            ZlibCompressionOptions::DEFAULT());
+    string result;
+    TF_EXPECT_OK(in.ReadNBytes(1000, &result));
+    EXPECT_EQ(data.substr(entry.stream_offset, 1000), result);
+  }
+
+  EXPECT_TRUE(errors::IsDataLoss(
+      ReadBlockZlibIndex(file_reader.get(), file_size - 1, &index)));
+}
+
+TEST(BlockZlibBuffers, DetectsCorruption) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/block_zlib_buffers_test";
+  const string data = GenTestString(10000);
+  WriteBlockZlibFile(fname, data, 1000, 1, 1);
+
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  // Flip a byte in the compressed bytes of the third block.
+  std::vector<BlockZlibIndexEntry> index;
+  {
+    std::unique_ptr<RandomAccessFile> file_reader;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file_reader));
+    TF_CHECK_OK(
+        ReadBlockZlibIndex(file_reader.get(), contents.size(), &index));
+  }
+  contents[index[2].file_offset + kBlockZlibHeaderSize + 5] ^= 0x40;
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file_reader));
+  RandomAccessInputStream input_stream(file_reader.get());
+  BlockZlibInputStream in(&input_stream, 2, 4,
+                          ZlibCompressionOptions::DEFAULT());
+  string result;
+  TF_EXPECT_OK(in.ReadNBytes(2000, &result));
+  EXPECT_TRUE(errors::IsDataLoss(in.ReadNBytes(1, &result)));
+  EXPECT_TRUE(errors::IsDataLoss(in.ReadNBytes(1, &result)));
+}
+
+}  // namespace io
+}  // namespace tensorflow
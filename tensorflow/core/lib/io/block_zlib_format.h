@@ -0,0 +1,62 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_BLOCK_ZLIB_FORMAT_H_
+#define TENSORFLOW_LIB_IO_BLOCK_ZLIB_FORMAT_H_
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Layout of a block-compressed ("BLOCK_ZLIB") file.
+//
+// The uncompressed stream is cut into blocks that are compressed
+// independently with zlib, so that writers can compress and readers can
+// inflate several blocks in parallel:
+//
+//   block*     each: fixed64  compressed size (> 0)
+//                    fixed64  uncompressed size
+//                    fixed32  masked crc32c of the compressed bytes
+//                    byte     compressed[compressed size]
+//   fixed64 0  end of the blocks
+//   index      for each block:
+//                    fixed64  offset of the block header in the file
+//                    fixed64  offset of the block in the uncompressed stream
+//   footer     fixed64  offset of the index in the file
+//              fixed64  number of blocks
+//              fixed32  masked crc32c of the index
+//              fixed64  kBlockZlibMagic
+//
+// The block headers allow the file to be read front to back without
+// knowing its size; the index allows tools that do know it to locate the
+// block holding any offset of the uncompressed stream.
+
+static const size_t kBlockZlibHeaderSize = 2 * sizeof(uint64) + sizeof(uint32);
+static const size_t kBlockZlibFooterSize = 3 * sizeof(uint64) + sizeof(uint32);
+static const uint64 kBlockZlibMagic = 0x6b6c625a6c424654ull;
+
+// zlib takes 32-bit lengths, so neither size of a block may exceed this.
+static const uint64 kBlockZlibMaxBlockBytes = 1 << 30;
+
+struct BlockZlibIndexEntry {
+  uint64 file_offset;
+  uint64 stream_offset;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_BLOCK_ZLIB_FORMAT_H_
@@ -0,0 +1,270 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
+
+#include <zlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+Status InflateBlock(const ZlibCompressionOptions& options, const string& input,
+                    uint64 uncompressed_size, string* output) {
+  z_stream z;
+  memset(&z, 0, sizeof(z));
+  int status = inflateInit2(&z, options.window_bits);
+  if (status != Z_OK) {
+    return errors::InvalidArgument("inflateInit failed with status ", status);
+  }
+  output->resize(uncompressed_size);
+  z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  z.avail_in = input.size();
+  z.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  z.avail_out = output->size();
+  status = inflate(&z, Z_FINISH);
+  const uint64 total_out = z.total_out;
+  inflateEnd(&z);
+  if (status != Z_STREAM_END || total_out != uncompressed_size) {
+    return errors::DataLoss("inflate failed with status ", status);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+struct BlockZlibInputStream::Block {
+  int64 file_offset = 0;
+  uint64 uncompressed_size = 0;
+  string compressed;
+  string output;
+  Status status;
+  Notification done;
+};
+
+BlockZlibInputStream::BlockZlibInputStream(
+    InputStreamInterface* input_stream, int num_threads, int lookahead_blocks,
+    const ZlibCompressionOptions& zlib_options)
+    : input_stream_(input_stream),
+      lookahead_blocks_(std::max(lookahead_blocks, 1)),
+      zlib_options_(zlib_options),
+      thread_pool_(new thread::ThreadPool(Env::Default(), "block_zlib_inflate",
+                                          std::max(num_threads, 1))) {}
+
+BlockZlibInputStream::~BlockZlibInputStream() {}
+
+Status BlockZlibInputStream::FillPipeline() {
+  while (status_.ok() && !saw_end_marker_ &&
+         blocks_in_flight_.size() < lookahead_blocks_) {
+    const int64 block_offset = input_stream_->Tell();
+    string header;
+    Status s = input_stream_->ReadNBytes(kBlockZlibHeaderSize, &header);
+    if (header.size() >= sizeof(uint64) &&
+        core::DecodeFixed64(header.data()) == 0) {
+      saw_end_marker_ = true;
+      break;
+    }
+    if (errors::IsOutOfRange(s) && header.empty()) {
+      // The file ends without an end marker, e.g. because it is empty.
+      saw_end_marker_ = true;
+      break;
+    }
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated block header at ", block_offset);
+    }
+    if (!s.ok()) {
+      status_ = s;
+      break;
+    }
+
+    const uint64 compressed_size = core::DecodeFixed64(header.data());
+    const uint64 uncompressed_size =
+        core::DecodeFixed64(header.data() + sizeof(uint64));
+    const uint32 masked_crc =
+        core::DecodeFixed32(header.data() + 2 * sizeof(uint64));
+    if (compressed_size > kBlockZlibMaxBlockBytes ||
+        uncompressed_size > kBlockZlibMaxBlockBytes) {
+      status_ = errors::DataLoss("corrupted block header at ", block_offset);
+      break;
+    }
+
+    std::shared_ptr<Block> block(new Block);
+    block->uncompressed_size = uncompressed_size;
+    block->file_offset = block_offset;
+    s = input_stream_->ReadNBytes(compressed_size, &block->compressed);
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated block at ", block_offset);
+    }
+    if (!s.ok()) {
+      status_ = s;
+      break;
+    }
+    thread_pool_->Schedule([this, block, masked_crc]() {
+      if (crc32c::Unmask(masked_crc) !=
+          crc32c::Value(block->compressed.data(), block->compressed.size())) {
+        block->status =
+            errors::DataLoss("corrupted block at ", block->file_offset);
+      } else {
+        block->status = InflateBlock(zlib_options_, block->compressed,
+                                     block->uncompressed_size, &block->output);
+      }
+      block->compressed.clear();
+      block->done.Notify();
+    });
+    blocks_in_flight_.push_back(std::move(block));
+  }
+  return status_;
+}
+
+Status BlockZlibInputStream::NextBlock() {
+  // Errors past the blocks in flight are reported once those were read.
+  Status s = FillPipeline();
+  if (blocks_in_flight_.empty()) {
+    return s.ok() ? errors::OutOfRange("EOF reached") : s;
+  }
+  current_block_ = std::move(blocks_in_flight_.front());
+  blocks_in_flight_.pop_front();
+  pos_in_block_ = 0;
+  current_block_->done.WaitForNotification();
+  if (!current_block_->status.ok()) {
+    status_ = current_block_->status;
+    blocks_in_flight_.clear();
+    current_block_.reset();
+    return status_;
+  }
+  FillPipeline().IgnoreError();
+  return Status::OK();
+}
+
+bool BlockZlibInputStream::CurrentBlockExhausted() const {
+  return current_block_ == nullptr ||
+         pos_in_block_ == current_block_->output.size();
+}
+
+Status BlockZlibInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  result->clear();
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    if (CurrentBlockExhausted()) {
+      TF_RETURN_IF_ERROR(NextBlock());
+      continue;
+    }
+    const size_t n =
+        std::min<size_t>(bytes_to_read - result->size(),
+                         current_block_->output.size() - pos_in_block_);
+    result->append(current_block_->output.data() + pos_in_block_, n);
+    pos_in_block_ += n;
+    bytes_read_ += n;
+  }
+  return Status::OK();
+}
+
+Status BlockZlibInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  while (bytes_to_skip > 0) {
+    if (CurrentBlockExhausted()) {
+      FillPipeline().IgnoreError();
+      if (!blocks_in_flight_.empty() &&
+          blocks_in_flight_.front()->uncompressed_size <=
+              static_cast<uint64>(bytes_to_skip)) {
+        bytes_to_skip -= blocks_in_flight_.front()->uncompressed_size;
+        bytes_read_ += blocks_in_flight_.front()->uncompressed_size;
+        blocks_in_flight_.pop_front();
+        continue;
+      }
+      TF_RETURN_IF_ERROR(NextBlock());
+      continue;
+    }
+    const size_t n = std::min<size_t>(
+        bytes_to_skip, current_block_->output.size() - pos_in_block_);
+    pos_in_block_ += n;
+    bytes_read_ += n;
+    bytes_to_skip -= n;
+  }
+  return Status::OK();
+}
+
+int64 BlockZlibInputStream::Tell() const { return bytes_read_; }
+
+Status BlockZlibInputStream::Reset() {
+  // Blocks still being inflated keep themselves alive until they are done.
+  blocks_in_flight_.clear();
+  current_block_.reset();
+  pos_in_block_ = 0;
+  saw_end_marker_ = false;
+  bytes_read_ = 0;
+  status_ = Status::OK();
+  return input_stream_->Reset();
+}
+
+Status ReadBlockZlibIndex(RandomAccessFile* file, uint64 file_size,
+                          std::vector<BlockZlibIndexEntry>* index) {
+  if (file_size < kBlockZlibFooterSize) {
+    return errors::DataLoss("file is too short to be block-compressed");
+  }
+  char footer_space[kBlockZlibFooterSize];
+  StringPiece footer;
+  TF_RETURN_IF_ERROR(file->Read(file_size - kBlockZlibFooterSize,
+                                kBlockZlibFooterSize, &footer, footer_space));
+  if (footer.size() != kBlockZlibFooterSize ||
+      core::DecodeFixed64(footer.data() + 2 * sizeof(uint64) +
+                          sizeof(uint32)) != kBlockZlibMagic) {
+    return errors::DataLoss("not a block-compressed file");
+  }
+  const uint64 index_offset = core::DecodeFixed64(footer.data());
+  const uint64 num_blocks = core::DecodeFixed64(footer.data() + sizeof(uint64));
+  const uint32 masked_crc =
+      core::DecodeFixed32(footer.data() + 2 * sizeof(uint64));
+  const uint64 index_size = 2 * sizeof(uint64) * num_blocks;
+  if (num_blocks > file_size / (2 * sizeof(uint64)) ||
+      index_offset > file_size - kBlockZlibFooterSize ||
+      index_size != file_size - kBlockZlibFooterSize - index_offset) {
+    return errors::DataLoss("corrupted block index");
+  }
+
+  string index_space(index_size, '\0');
+  StringPiece data;
+  TF_RETURN_IF_ERROR(
+      file->Read(index_offset, index_size, &data, &index_space[0]));
+  if (data.size() != index_size ||
+      crc32c::Unmask(masked_crc) != crc32c::Value(data.data(), data.size())) {
+    return errors::DataLoss("corrupted block index");
+  }
+  index->clear();
+  index->reserve(num_blocks);
+  for (uint64 i = 0; i < num_blocks; ++i) {
+    const char* entry = data.data() + 2 * sizeof(uint64) * i;
+    index->push_back({core::DecodeFixed64(entry),
+                      core::DecodeFixed64(entry + sizeof(uint64))});
+  }
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
+#define TENSORFLOW_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/block_zlib_format.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads the block-compressed format described in block_zlib_format.h.
+// The compressed blocks are read from the underlying stream ahead of the
+// reader, up to `lookahead_blocks` at a time, and inflated on a pool of
+// `num_threads` threads.
+//
+// A given instance of a BlockZlibInputStream is NOT safe for concurrent use
+// by multiple threads.
+class BlockZlibInputStream : public InputStreamInterface {
+ public:
+  // Does *not* take ownership of "input_stream".  Only the window_bits of
+  // `zlib_options` are used.
+  BlockZlibInputStream(InputStreamInterface* input_stream, int num_threads,
+                       int lookahead_blocks,
+                       const ZlibCompressionOptions& zlib_options);
+
+  ~BlockZlibInputStream();
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:           If successful.
+  // OUT_OF_RANGE: If there are not enough bytes to read before
+  //               the end of the stream.
+  // DATA_LOSS:    If a block is truncated or corrupted.
+  // others:       If reading from stream failed.
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  // Skips whole blocks without waiting for them to be inflated.
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Block;
+
+  // Reads compressed blocks from input_stream_ and hands them to the thread
+  // pool until lookahead_blocks blocks are in flight or the end marker was
+  // read.
+  Status FillPipeline();
+
+  // Makes the oldest block in flight the current block once it has been
+  // inflated.  Returns OUT_OF_RANGE after the last block.
+  Status NextBlock();
+
+  bool CurrentBlockExhausted() const;
+
+  InputStreamInterface* input_stream_;  // Not owned
+  const size_t lookahead_blocks_;
+  const ZlibCompressionOptions zlib_options_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  std::deque<std::shared_ptr<Block>> blocks_in_flight_;
+  std::shared_ptr<Block> current_block_;
+  size_t pos_in_block_ = 0;
+  bool saw_end_marker_ = false;
+  int64 bytes_read_ = 0;  // Position in the uncompressed stream
+
+  // Errors reading or inflating the stream are not recoverable.
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockZlibInputStream);
+};
+
+// Reads the index of the block-compressed file "file", which is
+// "file_size" bytes long.
+Status ReadBlockZlibIndex(RandomAccessFile* file, uint64 file_size,
+                          std::vector<BlockZlibIndexEntry>* index);
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
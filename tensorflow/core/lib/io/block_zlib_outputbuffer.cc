@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+
+#include <zlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+Status DeflateBlock(const ZlibCompressionOptions& options, const string& input,
+                    string* output) {
+  z_stream z;
+  memset(&z, 0, sizeof(z));
+  int status = deflateInit2(&z, options.compression_level,
+                            options.compression_method, options.window_bits,
+                            options.mem_level, options.compression_strategy);
+  if (status != Z_OK) {
+    return errors::InvalidArgument("deflateInit failed with status ", status);
+  }
+  output->resize(deflateBound(&z, input.size()));
+  z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  z.avail_in = input.size();
+  z.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  z.avail_out = output->size();
+  status = deflate(&z, Z_FINISH);
+  output->resize(z.total_out);
+  deflateEnd(&z);
+  if (status != Z_STREAM_END) {
+    return errors::DataLoss("deflate failed with status ", status);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+struct BlockZlibOutputBuffer::Block {
+  string input;
+  string output;
+  uint32 masked_crc = 0;
+  Status status;
+  Notification done;
+};
+
+BlockZlibOutputBuffer::BlockZlibOutputBuffer(
+    WritableFile* file, int64 block_bytes, int num_threads,
+    const ZlibCompressionOptions& zlib_options)
+    : file_(file),
+      // Leaves room for incompressible blocks to grow.
+      block_bytes_(std::min<int64>(std::max<int64>(block_bytes, 1),
+                                   kBlockZlibMaxBlockBytes / 2)),
+      max_blocks_in_flight_(2 * std::max(num_threads, 1)),
+      zlib_options_(zlib_options),
+      thread_pool_(new thread::ThreadPool(Env::Default(), "block_zlib_deflate",
+                                          std::max(num_threads, 1))) {}
+
+BlockZlibOutputBuffer::~BlockZlibOutputBuffer() {
+  if (!closed_) {
+    LOG(WARNING) << "BlockZlibOutputBuffer::Close() not called. Possible data "
+                 << "loss";
+  }
+}
+
+void BlockZlibOutputBuffer::SubmitBlock() {
+  std::shared_ptr<Block> block(new Block);
+  block->input.swap(current_block_);
+  thread_pool_->Schedule([this, block]() {
+    block->status = DeflateBlock(zlib_options_, block->input, &block->output);
+    block->masked_crc = crc32c::Mask(
+        crc32c::Value(block->output.data(), block->output.size()));
+    block->done.Notify();
+  });
+  blocks_in_flight_.push_back(std::move(block));
+}
+
+Status BlockZlibOutputBuffer::WriteOldestBlock() {
+  std::shared_ptr<Block> block = std::move(blocks_in_flight_.front());
+  blocks_in_flight_.pop_front();
+  block->done.WaitForNotification();
+  TF_RETURN_IF_ERROR(block->status);
+
+  char header[kBlockZlibHeaderSize];
+  core::EncodeFixed64(header, block->output.size());
+  core::EncodeFixed64(header + sizeof(uint64), block->input.size());
+  core::EncodeFixed32(header + 2 * sizeof(uint64), block->masked_crc);
+  TF_RETURN_IF_ERROR(file_->Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(file_->Append(block->output));
+
+  index_.push_back({file_offset_, stream_offset_});
+  file_offset_ += sizeof(header) + block->output.size();
+  stream_offset_ += block->input.size();
+  return Status::OK();
+}
+
+Status BlockZlibOutputBuffer::WriteAllBlocks() {
+  if (!current_block_.empty()) {
+    SubmitBlock();
+  }
+  while (!blocks_in_flight_.empty()) {
+    TF_RETURN_IF_ERROR(WriteOldestBlock());
+  }
+  return Status::OK();
+}
+
+Status BlockZlibOutputBuffer::Append(const StringPiece& data) {
+  if (closed_) {
+    return errors::FailedPrecondition("BlockZlibOutputBuffer is closed");
+  }
+  StringPiece remaining = data;
+  while (!remaining.empty()) {
+    const size_t n = std::min<size_t>(remaining.size(),
+                                      block_bytes_ - current_block_.size());
+    current_block_.append(remaining.data(), n);
+    remaining.remove_prefix(n);
+    if (current_block_.size() == static_cast<size_t>(block_bytes_)) {
+      SubmitBlock();
+      while (blocks_in_flight_.size() > max_blocks_in_flight_) {
+        TF_RETURN_IF_ERROR(WriteOldestBlock());
+      }
+    }
+  }
+  // Write out the blocks that are ready without waiting for the others.
+  while (!blocks_in_flight_.empty() &&
+         blocks_in_flight_.front()->done.HasBeenNotified()) {
+    TF_RETURN_IF_ERROR(WriteOldestBlock());
+  }
+  return Status::OK();
+}
+
+Status BlockZlibOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition("BlockZlibOutputBuffer is closed");
+  }
+  TF_RETURN_IF_ERROR(WriteAllBlocks());
+  return file_->Flush();
+}
+
+Status BlockZlibOutputBuffer::Close() {
+  if (closed_) {
+    return errors::FailedPrecondition("BlockZlibOutputBuffer is closed");
+  }
+  TF_RETURN_IF_ERROR(WriteAllBlocks());
+  closed_ = true;
+
+  string tail;
+  core::PutFixed64(&tail, 0);
+  const uint64 index_offset = file_offset_ + tail.size();
+  string index;
+  for (const BlockZlibIndexEntry& entry : index_) {
+    core::PutFixed64(&index, entry.file_offset);
+    core::PutFixed64(&index, entry.stream_offset);
+  }
+  tail.append(index);
+  core::PutFixed64(&tail, index_offset);
+  core::PutFixed64(&tail, index_.size());
+  core::PutFixed32(&tail,
+                   crc32c::Mask(crc32c::Value(index.data(), index.size())));
+  core::PutFixed64(&tail, kBlockZlibMagic);
+  return file_->Append(tail);
+}
+
+Status BlockZlibOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
+#define TENSORFLOW_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/block_zlib_format.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Writes the block-compressed format described in block_zlib_format.h.
+// Appended data is collected into blocks of `block_bytes` uncompressed
+// bytes, which are deflated on a pool of `num_threads` threads and written
+// to `file` in order.  At most 2 * `num_threads` blocks are in flight.
+//
+// A given instance of a BlockZlibOutputBuffer is NOT safe for concurrent
+// use by multiple threads.
+class BlockZlibOutputBuffer : public WritableFile {
+ public:
+  // Does not take ownership of `file`.
+  BlockZlibOutputBuffer(WritableFile* file, int64 block_bytes, int num_threads,
+                        const ZlibCompressionOptions& zlib_options);
+
+  ~BlockZlibOutputBuffer();
+
+  // Adds `data` to the current block, and hands the block to the thread
+  // pool once it holds at least `block_bytes` bytes.
+  Status Append(const StringPiece& data) override;
+
+  // Ends the current block, waits for all blocks to be compressed, writes
+  // them to file and flushes the file.
+  Status Flush() override;
+
+  // Writes all blocks, the index and the footer to file.  Does not close
+  // the file.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or
+  // `Close()` will fail.
+  Status Close() override;
+
+  // Flushes and syncs the file.
+  Status Sync() override;
+
+ private:
+  struct Block;
+
+  // Hands the current block to the thread pool.
+  void SubmitBlock();
+
+  // Waits for the oldest block in flight and writes it to file.
+  Status WriteOldestBlock();
+
+  // Writes all blocks in flight to file.
+  Status WriteAllBlocks();
+
+  WritableFile* file_;  // Not owned
+  const int64 block_bytes_;
+  const size_t max_blocks_in_flight_;
+  const ZlibCompressionOptions zlib_options_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  string current_block_;
+  std::deque<std::shared_ptr<Block>> blocks_in_flight_;
+  uint64 file_offset_ = 0;
+  uint64 stream_offset_ = 0;
+  std::vector<BlockZlibIndexEntry> index_;
+  bool closed_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockZlibOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
@@ -21,6 +21,7 @@ namespace compression {
 
 const char kNone[] = "";
 const char kGzip[] = "GZIP";
+const char kBlockZlib[] = "BLOCK_ZLIB";
 
 }
 }
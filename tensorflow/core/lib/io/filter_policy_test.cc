@@ -0,0 +1,268 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/lib/io/filter_policy.h"
+
+#include <vector>
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/filter_block.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace table {
+
+namespace {
+
+static const int kVerbose = 1;
+
+StringPiece Key(int i, char* buffer) {
+  core::EncodeFixed32(buffer, i);
+  return StringPiece(buffer, sizeof(uint32));
+}
+
+class BloomTest : public ::testing::Test {
+ public:
+  BloomTest() : policy_(NewBloomFilterPolicy(10)) {}
+
+  ~BloomTest() override { delete policy_; }
+
+  void Reset() {
+    keys_.clear();
+    filter_.clear();
+  }
+
+  void Add(const StringPiece& s) { keys_.push_back(s.ToString()); }
+
+  void Build() {
+    std::vector<StringPiece> key_pieces;
+    for (size_t i = 0; i < keys_.size(); i++) {
+      key_pieces.push_back(StringPiece(keys_[i]));
+    }
+    filter_.clear();
+    policy_->CreateFilter(&key_pieces[0], static_cast<int>(key_pieces.size()),
+                          &filter_);
+    keys_.clear();
+  }
+
+  size_t FilterSize() const { return filter_.size(); }
+
+  bool Matches(const StringPiece& s) {
+    if (!keys_.empty()) {
+      Build();
+    }
+    return policy_->KeyMayMatch(s, filter_);
+  }
+
+  double FalsePositiveRate() {
+    char buffer[sizeof(int)];
+    int result = 0;
+    for (int i = 0; i < 10000; i++) {
+      if (Matches(Key(i + 1000000000, buffer))) {
+        result++;
+      }
+    }
+    return result / 10000.0;
+  }
+
+ private:
+  const FilterPolicy* policy_;
+  string filter_;
+  std::vector<string> keys_;
+};
+
+// For testing: emit an array with one hash value per key
+class TestHashFilter : public FilterPolicy {
+ public:
+  const char* Name() const override { return "TestHashFilter"; }
+
+  void CreateFilter(const StringPiece* keys, int n,
+                    string* dst) const override {
+    for (int i = 0; i < n; i++) {
+      core::PutFixed32(dst, Hash(keys[i]));
+    }
+  }
+
+  bool KeyMayMatch(const StringPiece& key,
+                   const StringPiece& filter) const override {
+    uint32 h = Hash(key);
+    for (size_t i = 0; i + 4 <= filter.size(); i += 4) {
+      if (h == core::DecodeFixed32(filter.data() + i)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static uint32 Hash(const StringPiece& key) {
+    uint32 h = 0;
+    for (char c : key) h = h * 31 + static_cast<unsigned char>(c);
+    return h;
+  }
+};
+
+int NextLength(int length) {
+  if (length < 10) {
+    length += 1;
+  } else if (length < 100) {
+    length += 10;
+  } else if (length < 1000) {
+    length += 100;
+  } else {
+    length += 1000;
+  }
+  return length;
+}
+
+}  // namespace
+
+TEST_F(BloomTest, EmptyFilter) {
+  EXPECT_FALSE(Matches("hello"));
+  EXPECT_FALSE(Matches("world"));
+}
+
+TEST_F(BloomTest, Small) {
+  Add("hello");
+  Add("world");
+  EXPECT_TRUE(Matches("hello"));
+  EXPECT_TRUE(Matches("world"));
+  EXPECT_FALSE(Matches("x"));
+  EXPECT_FALSE(Matches("foo"));
+}
+
+TEST_F(BloomTest, VaryingLengths) {
+  char buffer[sizeof(int)];
+
+  // Count number of filters that significantly exceed the false positive rate
+  int mediocre_filters = 0;
+  int good_filters = 0;
+
+  for (int length = 1; length <= 10000; length = NextLength(length)) {
+    Reset();
+    for (int i = 0; i < length; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+
+    EXPECT_LE(FilterSize(), static_cast<size_t>((length * 10 / 8) + 40))
+        << length;
+
+    // All added keys must match
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(Matches(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+
+    // Check false positive rate
+    double rate = FalsePositiveRate();
+    VLOG(kVerbose) << "False positives: " << rate * 100.0 << "% @ length = "
+                   << length << " ; bytes = " << FilterSize();
+    EXPECT_LE(rate, 0.02);  // Must not be over 2%
+    if (rate > 0.0125) {
+      mediocre_filters++;  // Allowed, but not too often
+    } else {
+      good_filters++;
+    }
+  }
+  VLOG(kVerbose) << "Filters: " << good_filters << " good, "
+                 << mediocre_filters << " mediocre";
+  EXPECT_LE(mediocre_filters, good_filters / 5);
+}
+
+TEST(FilterBlockTest, EmptyBuilder) {
+  TestHashFilter policy;
+  FilterBlockBuilder builder(&policy);
+  StringPiece block = builder.Finish();
+  EXPECT_EQ(StringPiece("\x00\x00\x00\x00\x0b", 5), block);
+  FilterBlockReader reader(&policy, block);
+  EXPECT_TRUE(reader.KeyMayMatch(0, "foo"));
+  EXPECT_TRUE(reader.KeyMayMatch(100000, "foo"));
+}
+
+TEST(FilterBlockTest, SingleChunk) {
+  TestHashFilter policy;
+  FilterBlockBuilder builder(&policy);
+  builder.StartBlock(100);
+  builder.AddKey("foo");
+  builder.AddKey("bar");
+  builder.AddKey("box");
+  builder.StartBlock(200);
+  builder.AddKey("box");
+  builder.StartBlock(300);
+  builder.AddKey("hello");
+  StringPiece block = builder.Finish();
+  FilterBlockReader reader(&policy, block);
+  EXPECT_TRUE(reader.KeyMayMatch(100, "foo"));
+  EXPECT_TRUE(reader.KeyMayMatch(100, "bar"));
+  EXPECT_TRUE(reader.KeyMayMatch(100, "box"));
+  EXPECT_TRUE(reader.KeyMayMatch(100, "hello"));
+  EXPECT_TRUE(reader.KeyMayMatch(100, "foo"));
+  EXPECT_FALSE(reader.KeyMayMatch(100, "missing"));
+  EXPECT_FALSE(reader.KeyMayMatch(100, "other"));
+}
+
+TEST(FilterBlockTest, MultiChunk) {
+  TestHashFilter policy;
+  FilterBlockBuilder builder(&policy);
+
+  // First filter
+  builder.StartBlock(0);
+  builder.AddKey("foo");
+  builder.StartBlock(2000);
+  builder.AddKey("bar");
+
+  // Second filter
+  builder.StartBlock(3100);
+  builder.AddKey("box");
+
+  // Third filter is empty
+
+  // Last filter
+  builder.StartBlock(9000);
+  builder.AddKey("box");
+  builder.AddKey("hello");
+
+  StringPiece block = builder.Finish();
+  FilterBlockReader reader(&policy, block);
+
+  // Check first filter
+  EXPECT_TRUE(reader.KeyMayMatch(0, "foo"));
+  EXPECT_TRUE(reader.KeyMayMatch(2000, "bar"));
+  EXPECT_FALSE(reader.KeyMayMatch(0, "box"));
+  EXPECT_FALSE(reader.KeyMayMatch(0, "hello"));
+
+  // Check second filter
+  EXPECT_TRUE(reader.KeyMayMatch(3100, "box"));
+  EXPECT_FALSE(reader.KeyMayMatch(3100, "foo"));
+  EXPECT_FALSE(reader.KeyMayMatch(3100, "bar"));
+  EXPECT_FALSE(reader.KeyMayMatch(3100, "hello"));
+
+  // Check third filter (empty)
+  EXPECT_FALSE(reader.KeyMayMatch(4100, "foo"));
+  EXPECT_FALSE(reader.KeyMayMatch(4100, "bar"));
+  EXPECT_FALSE(reader.KeyMayMatch(4100, "box"));
+  EXPECT_FALSE(reader.KeyMayMatch(4100, "hello"));
+
+  // Check last filter
+  EXPECT_TRUE(reader.KeyMayMatch(9000, "box"));
+  EXPECT_TRUE(reader.KeyMayMatch(9000, "hello"));
+  EXPECT_FALSE(reader.KeyMayMatch(9000, "foo"));
+  EXPECT_FALSE(reader.KeyMayMatch(9000, "bar"));
+}
+
+}  // namespace table
+}  // namespace tensorflow
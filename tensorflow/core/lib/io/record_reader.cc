@@ -16,12 +16,16 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 
 #include <limits.h>
+#include <algorithm>
 
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -45,6 +49,14 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
                << " No compression will be used.";
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kBlockZlib) {
+    options.compression_type = io::RecordReaderOptions::BLOCK_ZLIB_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#else
+    options.zlib_options = io::ZlibCompressionOptions::DEFAULT();
 #endif  // IS_SLIM_BUILD
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
@@ -65,6 +77,16 @@ RecordReader::RecordReader(RandomAccessFile* file,
     zlib_input_stream_.reset(new ZlibInputStream(
         random_input_stream_.get(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options));
+#endif  // IS_SLIM_BUILD
+  } else if (options.compression_type ==
+             RecordReaderOptions::BLOCK_ZLIB_COMPRESSION) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
+#else   // IS_SLIM_BUILD
+    random_input_stream_.reset(new RandomAccessInputStream(file));
+    zlib_input_stream_.reset(new BlockZlibInputStream(
+        random_input_stream_.get(), options.decompression_threads,
+        options.lookahead_blocks, options.zlib_options));
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordReaderOptions::NONE) {
     // Nothing to do.
@@ -74,6 +96,11 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 RecordReader::~RecordReader() {
+  {
+    // The background read refers to src_ and this reader.
+    mutex_lock l(prefetch_mu_);
+    WaitForPrefetchLocked(&l);
+  }
   zlib_input_stream_.reset(nullptr);
   random_input_stream_.reset(nullptr);
 }
@@ -88,7 +115,6 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   }
 
   const size_t expected = n + sizeof(uint32);
-  storage->resize(expected);
 
 #if !defined(IS_SLIM_BUILD)
   if (zlib_input_stream_) {
@@ -119,7 +145,12 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
     // This version supports reading from arbitrary offsets
     // since we are accessing the random access file directly.
     StringPiece data;
-    TF_RETURN_IF_ERROR(src_->Read(offset, expected, &data, &(*storage)[0]));
+    if (options_.buffer_size > 0) {
+      TF_RETURN_IF_ERROR(ReadBuffered(offset, expected, &data));
+    } else {
+      storage->resize(expected);
+      TF_RETURN_IF_ERROR(src_->Read(offset, expected, &data, &(*storage)[0]));
+    }
     if (data.size() != expected) {
       if (data.empty()) {
         return errors::OutOfRange("eof");
@@ -139,21 +170,130 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   return Status::OK();
 }
 
-Status RecordReader::ReadRecord(uint64* offset, string* record) {
+Status RecordReader::ReadBuffered(uint64 offset, size_t n,
+                                  StringPiece* result) {
+  if (chunk_ != nullptr && offset >= chunk_offset_) {
+    const uint64 chunk_end = chunk_offset_ + chunk_->size();
+    if (offset + n <= chunk_end || (chunk_eof_ && offset <= chunk_end)) {
+      *result = StringPiece(chunk_->data() + (offset - chunk_offset_),
+                            std::min<uint64>(n, chunk_end - offset));
+      return Status::OK();
+    }
+  }
+
+  // Start a new chunk at "offset".  If "offset" is inside the current
+  // chunk, carry over its remaining bytes so that the reads from the file
+  // stay contiguous and buffer_size-sized.
+  std::shared_ptr<string> next(new string);
+  uint64 read_offset = offset;
+  if (chunk_ != nullptr && offset >= chunk_offset_ &&
+      offset < chunk_offset_ + chunk_->size()) {
+    const size_t start = offset - chunk_offset_;
+    next->assign(chunk_->data() + start, chunk_->size() - start);
+    read_offset = chunk_offset_ + chunk_->size();
+  }
+
+  bool eof = false;
+  Status s;
+  if (TakePrefetched(offset + next->size(), next.get(), &eof, &s)) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  if (!eof && next->size() < n) {
+    const size_t to_read = std::max(options_.buffer_size, n - next->size());
+    TF_RETURN_IF_ERROR(
+        ReadFromFile(offset + next->size(), to_read, next.get(), &eof));
+  }
+
+  chunk_ = std::move(next);
+  chunk_offset_ = offset;
+  chunk_eof_ = eof;
+  if (options_.prefetch && !eof) {
+    StartPrefetch(chunk_offset_ + chunk_->size());
+  }
+  *result = StringPiece(chunk_->data(), std::min(n, chunk_->size()));
+  return Status::OK();
+}
+
+Status RecordReader::ReadFromFile(uint64 offset, size_t n, string* dst,
+                                  bool* eof) {
+  const size_t start = dst->size();
+  dst->resize(start + n);
+  char* scratch = &(*dst)[start];
+  StringPiece data;
+  Status s = src_->Read(offset, n, &data, scratch);
+  // A short read is reported as OUT_OF_RANGE along with the data that
+  // could be read; that is the end of the file rather than an error here.
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    dst->resize(start);
+    return s;
+  }
+  if (data.data() != scratch) {
+    memmove(scratch, data.data(), data.size());
+  }
+  dst->resize(start + data.size());
+  *eof = data.size() < n;
+  return Status::OK();
+}
+
+void RecordReader::WaitForPrefetchLocked(mutex_lock* l) {
+  while (prefetch_in_flight_ && !prefetch_done_) {
+    prefetch_cv_.wait(*l);
+  }
+}
+
+bool RecordReader::TakePrefetched(uint64 offset, string* dst, bool* eof,
+                                  Status* status) {
+  mutex_lock l(prefetch_mu_);
+  if (!prefetch_in_flight_) return false;
+  WaitForPrefetchLocked(&l);
+  prefetch_in_flight_ = false;
+  if (prefetch_offset_ != offset) return false;
+  if (dst->empty()) {
+    dst->swap(prefetch_buffer_);
+  } else {
+    dst->append(prefetch_buffer_);
+  }
+  prefetch_buffer_.clear();
+  *eof = prefetch_eof_;
+  *status = prefetch_status_;
+  return true;
+}
+
+void RecordReader::StartPrefetch(uint64 offset) {
+  {
+    mutex_lock l(prefetch_mu_);
+    prefetch_in_flight_ = true;
+    prefetch_done_ = false;
+    prefetch_offset_ = offset;
+  }
+  Env::Default()->SchedClosure([this, offset]() {
+    string buffer;
+    bool eof = false;
+    Status s = ReadFromFile(offset, options_.buffer_size, &buffer, &eof);
+    mutex_lock l(prefetch_mu_);
+    prefetch_buffer_.swap(buffer);
+    prefetch_eof_ = eof;
+    prefetch_status_ = s;
+    prefetch_done_ = true;
+    prefetch_cv_.notify_all();
+  });
+}
+
+Status RecordReader::ReadRecordData(uint64* offset, StringPiece* record,
+                                    string* storage) {
   static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
   static const size_t kFooterSize = sizeof(uint32);
 
   // Read header data.
   StringPiece lbuf;
-  Status s = ReadChecksummed(*offset, sizeof(uint64), &lbuf, record);
+  Status s = ReadChecksummed(*offset, sizeof(uint64), &lbuf, storage);
   if (!s.ok()) {
     return s;
   }
   const uint64 length = core::DecodeFixed64(lbuf.data());
 
   // Read data
-  StringPiece data;
-  s = ReadChecksummed(*offset + kHeaderSize, length, &data, record);
+  s = ReadChecksummed(*offset + kHeaderSize, length, record, storage);
   if (!s.ok()) {
     if (errors::IsOutOfRange(s)) {
       s = errors::DataLoss("truncated record at ", *offset);
@@ -161,16 +301,54 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
     return s;
   }
 
-  if (record->data() != data.data()) {
-    // RandomAccessFile placed the data in some other location.
-    memmove(&(*record)[0], data.data(), data.size());
-  }
+  *offset += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
 
-  record->resize(data.size());
+Status RecordReader::ReadRecord(uint64* offset, string* record) {
+  StringPiece data;
+  TF_RETURN_IF_ERROR(ReadRecordData(offset, &data, record));
 
-  *offset += kHeaderSize + length + kFooterSize;
+  if (record->data() != data.data()) {
+    // The data was placed in some other location (e.g. the read buffer).
+    record->assign(data.data(), data.size());
+  } else {
+    record->resize(data.size());
+  }
   return Status::OK();
 }
 
+Status RecordReader::ReadRecords(uint64* offset, int64 num_records,
+                                 RecordBatch* batch) {
+  const bool buffered = options_.buffer_size > 0 &&
+                        options_.compression_type == RecordReaderOptions::NONE;
+  Status s;
+  int64 num_read = 0;
+  string storage;
+  for (; num_read < num_records; ++num_read) {
+    const uint64 record_offset = *offset;
+    if (!buffered) {
+      std::shared_ptr<string> record(new string);
+      s = ReadRecord(offset, record.get());
+      if (!s.ok()) break;
+      batch->records_.emplace_back(*record);
+      batch->offsets_.push_back(record_offset);
+      batch->buffers_.push_back(std::move(record));
+      continue;
+    }
+    StringPiece data;
+    s = ReadRecordData(offset, &data, &storage);
+    if (!s.ok()) break;
+    // ReadBuffered() always leaves the payload in chunk_.
+    if (batch->buffers_.empty() || batch->buffers_.back() != chunk_) {
+      batch->buffers_.push_back(chunk_);
+    }
+    batch->records_.push_back(data);
+    batch->offsets_.push_back(record_offset);
+  }
+  if (num_read > 0) return Status::OK();
+  return s;
+}
+
 }  // namespace io
 }  // namespace tensorflow
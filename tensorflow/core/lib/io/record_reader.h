@@ -16,14 +16,20 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_LIB_IO_RECORD_READER_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -34,18 +40,74 @@ namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    BLOCK_ZLIB_COMPRESSION = 2
+  };
   CompressionType compression_type = NONE;
 
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
+  // A reasonable buffer_size for sequential scans over large files.
+  static const size_t kDefaultBufferSize = 256 << 10;
+
+  // Options for uncompressed files.  If buffer_size is non-zero, the
+  // file is read in buffer_size units starting at the first requested
+  // offset and records are served out of that buffer, instead of issuing
+  // two small reads per record.  This assumes records are mostly read
+  // sequentially; reading at an offset outside the buffer discards it.
+  size_t buffer_size = 0;
+
+  // If true (and buffer_size is non-zero), the next buffer_size bytes are
+  // read in the background while records are served from the current
+  // buffer.
+  bool prefetch = false;
+
 #if !defined(IS_SLIM_BUILD)
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
+
+  // Options specific to block zlib compression: the number of threads that
+  // inflate blocks, and the number of blocks read ahead of the reader.
+  int decompression_threads = 4;
+  int lookahead_blocks = 8;
 #endif  // IS_SLIM_BUILD
 };
 
+// A batch of records returned by RecordReader::ReadRecords().  The
+// records point into reference-counted buffers held by the batch, so they
+// stay valid until the batch is cleared or destroyed, even if the reader
+// that produced them is gone.
+class RecordBatch {
+ public:
+  RecordBatch() {}
+
+  const std::vector<StringPiece>& records() const { return records_; }
+  size_t size() const { return records_.size(); }
+  bool empty() const { return records_.empty(); }
+  const StringPiece& operator[](size_t i) const { return records_[i]; }
+
+  // The offset in the file at which the i-th record starts.
+  uint64 offset(size_t i) const { return offsets_[i]; }
+
+  void Clear() {
+    records_.clear();
+    offsets_.clear();
+    buffers_.clear();
+  }
+
+ private:
+  friend class RecordReader;
+
+  std::vector<StringPiece> records_;
+  std::vector<uint64> offsets_;
+  std::vector<std::shared_ptr<const string>> buffers_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordBatch);
+};
+
 class RecordReader {
  public:
   // Create a reader that will return log records from "*file".
@@ -60,15 +122,62 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(uint64* offset, string* record);
 
+  // Read up to "num_records" records starting at "*offset", append them to
+  // *batch and update *offset to point to the offset of the next record.
+  // Returns OK if at least one record was read; reading stops early at the
+  // end of the file or at the first bad record, which is then reported by
+  // the next call.  Returns OUT_OF_RANGE if no record is left, or something
+  // else for an error.
+  //
+  // With options.buffer_size set the records are views into the reader's
+  // buffers and are not copied; otherwise each record is read separately.
+  Status ReadRecords(uint64* offset, int64 num_records, RecordBatch* batch);
+
  private:
   Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result,
                          string* storage);
 
+  // Like ReadRecord(), but *record may point into *storage or chunk_.
+  Status ReadRecordData(uint64* offset, StringPiece* record, string* storage);
+
+  // Makes up to n bytes starting at "offset" available contiguously in
+  // chunk_ and points *result at them.  Fewer than n bytes are returned
+  // only at the end of the file.
+  Status ReadBuffered(uint64 offset, size_t n, StringPiece* result);
+
+  // Appends the n bytes at "offset" to *dst.  Sets *eof if the file ended
+  // before n bytes could be read.
+  Status ReadFromFile(uint64 offset, size_t n, string* dst, bool* eof);
+
+  // Waits for the background read, if any, and retires it.  Returns true
+  // and appends its result to *dst if it was a read at "offset".
+  bool TakePrefetched(uint64 offset, string* dst, bool* eof, Status* status);
+  void StartPrefetch(uint64 offset);
+  void WaitForPrefetchLocked(mutex_lock* l)
+      EXCLUSIVE_LOCKS_REQUIRED(prefetch_mu_);
+
   RandomAccessFile* src_;
   RecordReaderOptions options_;
+
+  // State of the buffered mode.  chunk_ holds the bytes of the file
+  // starting at chunk_offset_; it is shared with the RecordBatches that
+  // point into it, so it is never modified once filled.
+  std::shared_ptr<const string> chunk_;
+  uint64 chunk_offset_ = 0;
+  bool chunk_eof_ = false;
+
+  mutex prefetch_mu_;
+  condition_variable prefetch_cv_;
+  bool prefetch_in_flight_ GUARDED_BY(prefetch_mu_) = false;
+  bool prefetch_done_ GUARDED_BY(prefetch_mu_) = false;
+  uint64 prefetch_offset_ GUARDED_BY(prefetch_mu_) = 0;
+  string prefetch_buffer_ GUARDED_BY(prefetch_mu_);
+  bool prefetch_eof_ GUARDED_BY(prefetch_mu_) = false;
+  Status prefetch_status_ GUARDED_BY(prefetch_mu_);
 #if !defined(IS_SLIM_BUILD)
   std::unique_ptr<RandomAccessInputStream> random_input_stream_;
-  std::unique_ptr<ZlibInputStream> zlib_input_stream_;
+  // Either a ZlibInputStream or a BlockZlibInputStream.
+  std::unique_ptr<InputStreamInterface> zlib_input_stream_;
 #endif  // IS_SLIM_BUILD
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
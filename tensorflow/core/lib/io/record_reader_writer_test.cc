@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
@@ -67,6 +68,123 @@ TEST(RecordReaderWriterTest, TestBasics) {
   }
 }
 
+// Writes records of varying sizes, some spanning several read buffers, and
+// returns them.
+static std::vector<string> WriteVaryingRecords(const string& fname) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<string> records;
+  for (int i = 0; i < 200; ++i) {
+    records.push_back(string(rnd.Skewed(12), 'a' + i % 26));
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  io::RecordWriter writer(file.get());
+  for (const string& record : records) {
+    TF_CHECK_OK(writer.WriteRecord(record));
+  }
+  TF_CHECK_OK(writer.Flush());
+  return records;
+}
+
+TEST(RecordReaderWriterTest, TestBuffered) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_buffered_test";
+  const std::vector<string> records = WriteVaryingRecords(fname);
+
+  for (size_t buf_size : {1, 7, 100, 4096, 1 << 20}) {
+    for (bool prefetch : {false, true}) {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.buffer_size = buf_size;
+      options.prefetch = prefetch;
+      io::RecordReader reader(read_file.get(), options);
+      uint64 offset = 0;
+      string record;
+      for (const string& expected : records) {
+        TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ(expected, record);
+      }
+      EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+      // Seeking back to an earlier record discards the buffer.
+      offset = 0;
+      TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(records[0], record);
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadRecords) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_batch_test";
+  const std::vector<string> records = WriteVaryingRecords(fname);
+
+  for (size_t buf_size : {0, 100, 4096}) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options;
+    options.buffer_size = buf_size;
+    options.prefetch = true;
+    std::unique_ptr<io::RecordReader> reader(
+        new io::RecordReader(read_file.get(), options));
+
+    // Records stay valid after the reader moved on to later buffers, and
+    // after the reader is gone.
+    io::RecordBatch batch;
+    uint64 offset = 0;
+    uint64 expected_offset = 0;
+    TF_ASSERT_OK(reader->ReadRecords(&offset, 150, &batch));
+    ASSERT_EQ(150, batch.size());
+    TF_ASSERT_OK(reader->ReadRecords(&offset, 150, &batch));
+    ASSERT_EQ(200, batch.size());
+    EXPECT_TRUE(
+        errors::IsOutOfRange(reader->ReadRecords(&offset, 150, &batch)));
+    reader.reset();
+    for (size_t i = 0; i < records.size(); ++i) {
+      EXPECT_EQ(records[i], batch[i]);
+      EXPECT_EQ(expected_offset, batch.offset(i));
+      expected_offset += records[i].size() + 16;
+    }
+    EXPECT_EQ(expected_offset, offset);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadRecordsStopsAtCorruption) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_corrupt_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+  {
+    // A truncated third record.
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewAppendableFile(fname, &file));
+    TF_CHECK_OK(file->Append("trunc"));
+    TF_CHECK_OK(file->Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReaderOptions options;
+  options.buffer_size = 1024;
+  io::RecordReader reader(read_file.get(), options);
+  io::RecordBatch batch;
+  uint64 offset = 0;
+  TF_ASSERT_OK(reader.ReadRecords(&offset, 10, &batch));
+  ASSERT_EQ(2, batch.size());
+  EXPECT_EQ("abc", batch[0]);
+  EXPECT_EQ("defg", batch[1]);
+  EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecords(&offset, 10, &batch)));
+  EXPECT_EQ(2, batch.size());
+}
+
 TEST(RecordReaderWriterTest, TestZlib) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_zlib_test";
@@ -105,4 +223,46 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestBlockZlib) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_block_zlib_test";
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, string(i % 37, 'x')));
+  }
+
+  for (int64 block_size : {100, 1 << 20}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+      io::RecordWriterOptions options =
+          io::RecordWriterOptions::CreateRecordWriterOptions("BLOCK_ZLIB");
+      options.block_size = block_size;
+      io::RecordWriter writer(file.get(), options);
+      for (int i = 0; i < records.size(); ++i) {
+        TF_EXPECT_OK(writer.WriteRecord(records[i]));
+        if (i == 500) TF_CHECK_OK(writer.Flush());
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(file->Close());
+    }
+
+    {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options =
+          io::RecordReaderOptions::CreateRecordReaderOptions("BLOCK_ZLIB");
+      io::RecordReader reader(read_file.get(), options);
+      uint64 offset = 0;
+      string record;
+      for (const string& expected : records) {
+        TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ(expected, record);
+      }
+      EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+    }
+  }
+}
+
 }  // namespace tensorflow
@@ -18,13 +18,18 @@ limitations under the License.
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace io {
 namespace {
 bool IsZlibCompressed(RecordWriterOptions options) {
-  return options.compression_type == RecordWriterOptions::ZLIB_COMPRESSION;
+  return options.compression_type == RecordWriterOptions::ZLIB_COMPRESSION ||
+         options.compression_type ==
+             RecordWriterOptions::BLOCK_ZLIB_COMPRESSION;
 }
 }  // namespace
 
@@ -46,6 +51,14 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
                << " No compression will be used.";
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kBlockZlib) {
+    options.compression_type = io::RecordWriterOptions::BLOCK_ZLIB_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#else
+    options.zlib_options = io::ZlibCompressionOptions::DEFAULT();
 #endif  // IS_SLIM_BUILD
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
@@ -62,15 +75,22 @@ RecordWriter::RecordWriter(WritableFile* dest,
 #if defined(IS_SLIM_BUILD)
     LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
 #else   // IS_SLIM_BUILD
-    ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
-        dest, options.zlib_options.input_buffer_size,
-        options.zlib_options.output_buffer_size, options.zlib_options);
-    Status s = zlib_output_buffer->Init();
-    if (!s.ok()) {
-      LOG(FATAL) << "Failed to initialize Zlib inputbuffer. Error: "
-                 << s.ToString();
+    if (options.compression_type ==
+        RecordWriterOptions::BLOCK_ZLIB_COMPRESSION) {
+      dest_ = new BlockZlibOutputBuffer(dest, options.block_size,
+                                        options.compression_threads,
+                                        options.zlib_options);
+    } else {
+      ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
+          dest, options.zlib_options.input_buffer_size,
+          options.zlib_options.output_buffer_size, options.zlib_options);
+      Status s = zlib_output_buffer->Init();
+      if (!s.ok()) {
+        LOG(FATAL) << "Failed to initialize Zlib inputbuffer. Error: "
+                   << s.ToString();
+      }
+      dest_ = zlib_output_buffer;
     }
-    dest_ = zlib_output_buffer;
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
@@ -33,7 +33,11 @@ namespace io {
 
 class RecordWriterOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    BLOCK_ZLIB_COMPRESSION = 2
+  };
   CompressionType compression_type = NONE;
 
   static RecordWriterOptions CreateRecordWriterOptions(
@@ -42,6 +46,12 @@ class RecordWriterOptions {
 // Options specific to zlib compression.
 #if !defined(IS_SLIM_BUILD)
   ZlibCompressionOptions zlib_options;
+
+  // Options specific to block zlib compression: the number of uncompressed
+  // bytes per independently compressed block, and the number of threads
+  // that compress blocks.
+  int64 block_size = 1 << 20;
+  int compression_threads = 4;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -54,6 +54,12 @@ class Table {
   // call one of the Seek methods on the iterator before using it).
   Iterator* NewIterator() const;
 
+  // Looks up "key".  If the table contains it, returns ok and sets
+  // "*value" to the corresponding value.  Otherwise returns NotFound.
+  // If the table was built and opened with a filter policy, a lookup of
+  // a missing key usually returns without reading any data block.
+  Status Get(const StringPiece& key, string* value);
+
   // Given a key, return an approximate byte offset in the file where
   // the data for that key begins (or would begin if the key were
   // present in the file).  The returned value is in terms of file
@@ -69,6 +75,12 @@ class Table {
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const StringPiece&);
 
+  // Reads the filter block named in the metaindex block, if the options
+  // have a filter policy.  Errors are ignored, since the filter is only
+  // an optimization.
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const StringPiece& filter_handle_value);
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
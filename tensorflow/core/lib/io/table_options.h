@@ -21,6 +21,9 @@ limitations under the License.
 namespace tensorflow {
 namespace table {
 
+class Cache;
+class FilterPolicy;
+
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
 // being stored in a file.  The following enum describes which
@@ -60,6 +63,19 @@ struct Options {
   // incompressible, the kSnappyCompression implementation will
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression = kSnappyCompression;
+
+  // If non-null, use the specified cache for blocks read by Table.
+  // If null, blocks are read from the file and parsed on every access.
+  // The cache may be shared by multiple tables; it must outlive them.
+  // See NewLRUCache() in cache.h for a builtin implementation.
+  Cache* block_cache = nullptr;
+
+  // If non-null, TableBuilder stores a filter of the keys of each data
+  // block, and Table uses the filters to skip reading data blocks that
+  // cannot contain a looked up key.  Tables must be opened with a
+  // policy of the same Name() as the one they were built with for the
+  // filters to be used.  See NewBloomFilterPolicy() in filter_policy.h.
+  const FilterPolicy* filter_policy = nullptr;
 };
 
 }  // namespace table
@@ -17,16 +17,21 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/cache.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -224,6 +229,8 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.block_cache = options.block_cache;
+    table_options.filter_policy = options.filter_policy;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -233,6 +240,10 @@ class TableConstructor : public Constructor {
     return table_->ApproximateOffsetOf(key);
   }
 
+  Status Get(const StringPiece& key, string* value) const {
+    return table_->Get(key, value);
+  }
+
   uint64 BytesRead() const { return source_->BytesRead(); }
 
  private:
@@ -621,5 +632,73 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BlockCacheAvoidsRereads) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  string tmp;
+  TableConstructor c;
+  c.Add("k01", "firstvalue");
+  c.Add("k02", test::CompressibleString(&rnd, 0.25, 10000, &tmp));
+  c.Add("k03", "abc");
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kSnappyCompression;
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  options.block_cache = cache.get();
+  c.Finish(options, &keys, &kvmap);
+
+  string value;
+  TF_EXPECT_OK(c.Get("k02", &value));
+  EXPECT_EQ(kvmap["k02"], value);
+  const uint64 bytes_read = c.BytesRead();
+  EXPECT_GT(cache->TotalCharge(), 0);
+
+  // The second lookup is served from the cache.
+  TF_EXPECT_OK(c.Get("k02", &value));
+  EXPECT_EQ(kvmap["k02"], value);
+  EXPECT_EQ(bytes_read, c.BytesRead());
+
+  Iterator* iter = c.NewIterator();
+  iter->Seek("k02");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(kvmap["k02"], iter->value().ToString());
+  delete iter;
+  EXPECT_EQ(bytes_read, c.BytesRead());
+}
+
+TEST(TableTest, FilterSkipsBlockReadsForMissingKeys) {
+  TableConstructor c;
+  for (int i = 0; i < 1000; i += 2) {
+    c.Add(strings::Printf("k%05d", i), strings::Printf("v%05d", i));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kNoCompression;
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  options.filter_policy = policy.get();
+  c.Finish(options, &keys, &kvmap);
+
+  string value;
+  for (int i = 0; i < 1000; i += 2) {
+    TF_EXPECT_OK(c.Get(strings::Printf("k%05d", i), &value));
+    EXPECT_EQ(strings::Printf("v%05d", i), value);
+  }
+
+  const uint64 bytes_read = c.BytesRead();
+  int skipped = 0;
+  for (int i = 1; i < 1000; i += 2) {
+    const uint64 before = c.BytesRead();
+    EXPECT_TRUE(errors::IsNotFound(c.Get(strings::Printf("k%05d", i), &value)));
+    if (c.BytesRead() == before) ++skipped;
+  }
+  // With 10 bits per key the false positive rate is around 1%.
+  EXPECT_GT(skipped, 450);
+  EXPECT_LT(c.BytesRead() - bytes_read, (bytes_read / 10));
+}
+
 }  // namespace table
 }  // namespace tensorflow
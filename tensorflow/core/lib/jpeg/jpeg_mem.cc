@@ -159,8 +159,50 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
     return nullptr;
   }
 
+  // The size of the returned image, the offset of its first column in the
+  // scanlines returned by libjpeg, and its first scanline.
+  JDIMENSION target_output_width = cinfo.output_width;
+  JDIMENSION target_output_height = cinfo.output_height;
+  JDIMENSION skipped_columns = 0;
+  JDIMENSION first_scanline = 0;
+  if (flags.crop) {
+    if (flags.crop_x < 0 || flags.crop_y < 0 || flags.crop_width <= 0 ||
+        flags.crop_height <= 0 ||
+        static_cast<int64>(flags.crop_x) + flags.crop_width >
+            cinfo.output_width ||
+        static_cast<int64>(flags.crop_y) + flags.crop_height >
+            cinfo.output_height) {
+      LOG(ERROR) << "Invalid crop window: x=" << flags.crop_x
+                 << ", y=" << flags.crop_y << ", w=" << flags.crop_width
+                 << ", h=" << flags.crop_height << " for image of size "
+                 << cinfo.output_width << " x " << cinfo.output_height;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+    target_output_width = flags.crop_width;
+    target_output_height = flags.crop_height;
+    first_scanline = flags.crop_y;
+
+#if defined(LIBJPEG_TURBO_VERSION)
+    // libjpeg moves the left edge of the window to an iMCU boundary and
+    // widens it to match, so its scanlines start skipped_columns pixels
+    // before the window.
+    JDIMENSION xoffset = flags.crop_x;
+    JDIMENSION width = flags.crop_width;
+    jpeg_crop_scanline(&cinfo, &xoffset, &width);
+    skipped_columns = flags.crop_x - xoffset;
+
+    // The rows above the window are skipped without being fully decoded.
+    jpeg_skip_scanlines(&cinfo, first_scanline);
+#else
+    // Other versions of libjpeg decode whole rows; the rows above and the
+    // columns around the window are dropped while reading.
+    skipped_columns = flags.crop_x;
+#endif
+  }
+
   // check for compatible stride
-  const int min_stride = cinfo.output_width * components * sizeof(JSAMPLE);
+  const int min_stride = target_output_width * components * sizeof(JSAMPLE);
   if (stride == 0) {
     stride = min_stride;
   } else if (stride < min_stride) {
@@ -170,34 +212,42 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   }
 
   // Remember stride and height for use in Uncompress
-  argball->height_ = cinfo.output_height;
+  argball->height_ = target_output_height;
   argball->stride_ = stride;
 
   uint8* const dstdata = argball->allocate_output_(
-      cinfo.output_width, cinfo.output_height, components);
+      target_output_width, target_output_height, components);
   if (dstdata == nullptr) {
     jpeg_destroy_decompress(&cinfo);
     return nullptr;
   }
   JSAMPLE* output_line = static_cast<JSAMPLE*>(dstdata);
 
-  // Temporary buffer used for CMYK -> RGB conversion.
+  // Temporary buffer used for CMYK -> RGB conversion, and for cropping
+  // the scanlines returned by libjpeg.
   const bool use_cmyk = (cinfo.out_color_space == JCS_CMYK);
-  tempdata = use_cmyk ? new JSAMPLE[cinfo.output_width * 4] : nullptr;
+  tempdata = (use_cmyk || flags.crop)
+                 ? new JSAMPLE[cinfo.output_width * cinfo.output_components]
+                 : nullptr;
 
   // If there is an error reading a line, this aborts the reading.
   // Save the fraction of the image that has been read.
-  argball->height_read_ = cinfo.output_height;
-  while (cinfo.output_scanline < cinfo.output_height) {
+  argball->height_read_ = target_output_height;
+  const JDIMENSION last_scanline = first_scanline + target_output_height;
+  while (cinfo.output_scanline < last_scanline) {
     int num_lines_read = 0;
-    if (cinfo.out_color_space == JCS_CMYK) {
+    if (cinfo.output_scanline < first_scanline) {
+      // A row above the crop window, which was not skipped by libjpeg.
+      if (jpeg_read_scanlines(&cinfo, &tempdata, 1) == 1) continue;
+    } else if (cinfo.out_color_space == JCS_CMYK) {
       num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
       // Convert CMYK to RGB
-      for (size_t i = 0; i < cinfo.output_width; ++i) {
-        int c = tempdata[4 * i + 0];
-        int m = tempdata[4 * i + 1];
-        int y = tempdata[4 * i + 2];
-        int k = tempdata[4 * i + 3];
+      for (size_t i = 0; i < target_output_width; ++i) {
+        const JSAMPLE* cmyk = tempdata + 4 * (i + skipped_columns);
+        int c = cmyk[0];
+        int m = cmyk[1];
+        int y = cmyk[2];
+        int k = cmyk[3];
         int r, g, b;
         if (cinfo.saw_Adobe_marker) {
           r = (k * c) / 255;
@@ -212,6 +262,12 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
         output_line[3 * i + 1] = g;
         output_line[3 * i + 2] = b;
       }
+    } else if (flags.crop) {
+      num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
+      if (num_lines_read == 1) {
+        memcpy(output_line, tempdata + skipped_columns * components,
+               min_stride);
+      }
     } else {
       num_lines_read = jpeg_read_scanlines(&cinfo, &output_line, 1);
     }
@@ -219,12 +275,13 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
     if (num_lines_read == 0) {
       LOG(ERROR) << "Premature end of JPEG data. Stopped at line "
                  << cinfo.output_scanline << "/" << cinfo.output_height;
+      const JDIMENSION lines_read =
+          std::max(cinfo.output_scanline, first_scanline) - first_scanline;
       if (!flags.try_recover_truncated_jpeg) {
-        argball->height_read_ = cinfo.output_scanline;
+        argball->height_read_ = lines_read;
         error = JPEGERRORS_UNEXPECTED_END_OF_DATA;
       } else {
-        for (size_t line = cinfo.output_scanline; line < cinfo.output_height;
-             ++line) {
+        for (size_t line = lines_read; line < target_output_height; ++line) {
           if (line == 0) {
             // If even the first line is missing, fill with black color
             memset(output_line, 0, min_stride);
@@ -235,7 +292,7 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
           output_line += stride;
         }
         argball->height_read_ =
-            cinfo.output_height;  // consider all lines as read
+            target_output_height;  // consider all lines as read
         // prevent error-on-exit in libjpeg:
         cinfo.output_scanline = cinfo.output_height;
       }
@@ -254,17 +311,17 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   if (components == 4) {
     // Start on the last line.
     JSAMPLE* scanlineptr = static_cast<JSAMPLE*>(
-        dstdata + static_cast<int64>(cinfo.output_height - 1) * stride);
+        dstdata + static_cast<int64>(target_output_height - 1) * stride);
     const JSAMPLE kOpaque = -1;  // All ones appropriate for JSAMPLE.
-    const int right_rgb = (cinfo.output_width - 1) * 3;
-    const int right_rgba = (cinfo.output_width - 1) * 4;
+    const int right_rgb = (target_output_width - 1) * 3;
+    const int right_rgba = (target_output_width - 1) * 4;
 
-    for (int y = cinfo.output_height; y-- > 0;) {
+    for (int y = target_output_height; y-- > 0;) {
       // We do all the transformations in place, going backwards for each row.
       const JSAMPLE* rgb_pixel = scanlineptr + right_rgb;
       JSAMPLE* rgba_pixel = scanlineptr + right_rgba;
       scanlineptr -= stride;
-      for (int x = cinfo.output_width; x-- > 0;
+      for (int x = target_output_width; x-- > 0;
            rgba_pixel -= 4, rgb_pixel -= 3) {
         // We copy the 3 bytes at rgb_pixel into the 4 bytes at rgba_pixel
         // The "a" channel is set to be opaque.
@@ -309,7 +366,12 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   // Handle errors in JPEG
   switch (error) {
     case JPEGERRORS_OK:
-      jpeg_finish_decompress(&cinfo);
+      if (cinfo.output_scanline < cinfo.output_height) {
+        // The scanlines below a crop window are never decoded.
+        jpeg_abort(reinterpret_cast<j_common_ptr>(&cinfo));
+      } else {
+        jpeg_finish_decompress(&cinfo);
+      }
       break;
     case JPEGERRORS_UNEXPECTED_END_OF_DATA:
     case JPEGERRORS_BAD_PARAM:
@@ -61,6 +61,17 @@ struct UncompressFlags {
   //
   // Setting this has a quality/speed trade-off implication.
   J_DCT_METHOD dct_method = JDCT_DEFAULT;
+
+  // If true, only the window (crop_x, crop_y, crop_width, crop_height) of the
+  // image is returned.  The window is in the coordinates of the image after
+  // downscaling by ratio.  Rows below the window are never decoded, and with
+  // libjpeg-turbo only the MCUs that overlap the window are, which is much
+  // faster than cropping the image later.
+  bool crop = false;
+  int crop_x = 0;
+  int crop_y = 0;
+  int crop_width = 0;
+  int crop_height = 0;
 };
 
 // Uncompress some raw JPEG data given by the pointer srcdata and the length
@@ -95,6 +95,85 @@ TEST(JpegMemTest, Jpeg) {
   TestJPEG(env, data_path + "jpeg_merge_test1_cmyk.jpg");
 }
 
+void TestCropAndDecodeJpeg(Env* env, const string& jpegfile, int ratio) {
+  string jpeg;
+  ReadFileToStringOrDie(Env::Default(), jpegfile, &jpeg);
+  const int fsize = jpeg.size();
+  const uint8* const temp = bit_cast<const uint8*>(jpeg.data());
+
+  // Decode the whole image first as the reference.
+  UncompressFlags flags;
+  flags.components = 3;
+  flags.ratio = ratio;
+  int w, h, c;
+  std::unique_ptr<uint8[]> imgdata(
+      Uncompress(temp, fsize, flags, &w, &h, &c, nullptr));
+  CHECK(imgdata != nullptr);
+  const int stride = w * c;
+
+  const struct {
+    int x, y, width, height;
+  } kWindows[] = {{0, 0, w, h},
+                  {0, 0, 1, 1},
+                  {w / 3, h / 4, w / 2, h / 3},
+                  {w - 7, h - 5, 7, 5},
+                  {w / 2, 0, w - w / 2, 1},
+                  {0, h / 2, w, h - h / 2}};
+  for (const auto& window : kWindows) {
+    UncompressFlags crop_flags = flags;
+    crop_flags.crop = true;
+    crop_flags.crop_x = window.x;
+    crop_flags.crop_y = window.y;
+    crop_flags.crop_width = window.width;
+    crop_flags.crop_height = window.height;
+    int cw, ch, cc;
+    std::unique_ptr<uint8[]> cropped(
+        Uncompress(temp, fsize, crop_flags, &cw, &ch, &cc, nullptr));
+    CHECK(cropped != nullptr);
+    CHECK_EQ(window.width, cw);
+    CHECK_EQ(window.height, ch);
+    CHECK_EQ(c, cc);
+
+    // Only upsampling along the edges of the crop window may differ.
+    const int totalerr = ComputeSumAbsoluteDifference(
+        imgdata.get() + window.y * stride + window.x * c, cropped.get(), cw, ch,
+        stride, cw * cc);
+    const float average = static_cast<float>(totalerr) / (cw * ch * 3);
+    LOG(INFO) << "Crop [" << window.x << ", " << window.y << ", " << cw
+              << ", " << ch << "], average diff: " << average;
+    CHECK_LE(average, 1.0);
+  }
+
+  // Windows that fall outside of the image are rejected.
+  const struct {
+    int x, y, width, height;
+  } kBadWindows[] = {{-1, 0, 1, 1}, {0, -1, 1, 1}, {0, 0, 0, 1},
+                     {0, 0, 1, 0},  {w, 0, 1, 1},  {0, h, 1, 1},
+                     {1, 0, w, 1},  {0, 1, 1, h}};
+  for (const auto& window : kBadWindows) {
+    UncompressFlags crop_flags = flags;
+    crop_flags.crop = true;
+    crop_flags.crop_x = window.x;
+    crop_flags.crop_y = window.y;
+    crop_flags.crop_width = window.width;
+    crop_flags.crop_height = window.height;
+    int cw, ch, cc;
+    std::unique_ptr<uint8[]> cropped(
+        Uncompress(temp, fsize, crop_flags, &cw, &ch, &cc, nullptr));
+    CHECK(cropped == nullptr);
+  }
+}
+
+TEST(JpegMemTest, CropAndDecodeJpeg) {
+  Env* env = Env::Default();
+  const string data_path = kTestData;
+
+  for (const int ratio : {1, 2}) {
+    TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1.jpg", ratio);
+    TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1_cmyk.jpg", ratio);
+  }
+}
+
 TEST(JpegMemTest, Jpeg2) {
   // create known data, for size in_w x in_h
   const int in_w = 256;
@@ -99,6 +99,8 @@ class Array {
 // NOTE:
 // 1. PhiloxRandom is trivially copyable.
 // 2. PhiloxRandom is compilable by gcc and nvcc.
+// 3. On CPU, PhiloxRandomSimd::Fill (philox_random_simd.h) generates the same
+//    sequence several counters at a time.
 class PhiloxRandom {
  public:
   using ResultType = Array<uint32, 4>;
@@ -184,6 +186,8 @@ class PhiloxRandom {
   }
 
  private:
+  friend class PhiloxRandomSimd;
+
   // We use the same constants as recommended by the original paper.
   static const uint32 kPhiloxW32A = 0x9E3779B9;
   static const uint32 kPhiloxW32B = 0xBB67AE85;
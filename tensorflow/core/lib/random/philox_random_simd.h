@@ -0,0 +1,264 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Vectorized CPU versions of PhiloxRandom. Each SIMD lane runs the Philox
+// rounds for one counter, so a vector computes 16 (AVX-512) or 8 (AVX2)
+// consecutive samples at once. The results are transposed back to the order
+// PhiloxRandom::operator() produces them, so the output is bit-identical to
+// calling the scalar generator in a loop.
+
+#ifndef TENSORFLOW_LIB_RANDOM_PHILOX_RANDOM_SIMD_H_
+#define TENSORFLOW_LIB_RANDOM_PHILOX_RANDOM_SIMD_H_
+
+#include <string.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace random {
+
+class PhiloxRandomSimd {
+ public:
+  // The number of Philox counters computed per vector.
+#if defined(__AVX512F__)
+  static const int kStreams = 16;
+#elif defined(__AVX2__)
+  static const int kStreams = 8;
+#else
+  static const int kStreams = 1;
+#endif
+
+  // Writes the samples of the next "count" calls of (*gen)() to "output",
+  // PhiloxRandom::kResultElementCount uint32s per call, and advances "gen"
+  // past them.
+  static void Fill(PhiloxRandom* gen, uint32* output, int64 count) {
+    const int kCount = PhiloxRandom::kResultElementCount;
+    int64 i = 0;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    for (; i + kStreams <= count; i += kStreams) {
+      if (!CanVectorize(*gen)) {
+        FillScalar(gen, output + i * kCount, kStreams);
+        continue;
+      }
+      Vector samples[kCount];
+      Generate(*gen, samples);
+      for (int j = 0; j < kCount; ++j) {
+        Store(output + i * kCount + j * kStreams, samples[j]);
+      }
+      gen->Skip(kStreams);
+    }
+#endif
+    FillScalar(gen, output + i * kCount, count - i);
+  }
+
+  // Like Fill(), but converts the samples to floats in [0, 1) the same way
+  // UniformDistribution<PhiloxRandom, float> does.
+  static void FillUniformFloat(PhiloxRandom* gen, float* output, int64 count) {
+    const int kCount = PhiloxRandom::kResultElementCount;
+    int64 i = 0;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    for (; i + kStreams <= count; i += kStreams) {
+      Vector samples[kCount];
+      if (CanVectorize(*gen)) {
+        Generate(*gen, samples);
+        gen->Skip(kStreams);
+      } else {
+        uint32 buffer[kStreams * kCount];
+        FillScalar(gen, buffer, kStreams);
+        for (int j = 0; j < kCount; ++j) {
+          samples[j] = Load(buffer + j * kStreams);
+        }
+      }
+      for (int j = 0; j < kCount; ++j) {
+        StoreUniformFloat(output + i * kCount + j * kStreams, samples[j]);
+      }
+    }
+#endif
+    for (; i < count; ++i) {
+      PhiloxRandom::ResultType sample = (*gen)();
+      for (int j = 0; j < kCount; ++j) {
+        output[i * kCount + j] = Uint32ToUniformFloat(sample[j]);
+      }
+    }
+  }
+
+ private:
+  static void FillScalar(PhiloxRandom* gen, uint32* output, int64 count) {
+    const int kCount = PhiloxRandom::kResultElementCount;
+    for (int64 i = 0; i < count; ++i) {
+      PhiloxRandom::ResultType sample = (*gen)();
+      for (int j = 0; j < kCount; ++j) {
+        output[i * kCount + j] = sample[j];
+      }
+    }
+  }
+
+  // Same bit manipulation as Uint32ToFloat() in random_distributions.h.
+  static float Uint32ToUniformFloat(uint32 x) {
+    const uint32 val = (static_cast<uint32>(127) << 23) | (x & 0x7fffffu);
+    float result;
+    memcpy(&result, &val, sizeof(val));
+    return result - 1.0f;
+  }
+
+  // The lanes hold counters counter_ .. counter_ + kStreams - 1, which only
+  // differ in the lowest word unless that word wraps around within the block.
+  // Blocks that wrap, once every 2^32 samples, go through the scalar path.
+  static bool CanVectorize(const PhiloxRandom& gen) {
+    return gen.counter_[0] <= 0xFFFFFFFFu - (kStreams - 1);
+  }
+
+#if defined(__AVX512F__)
+  typedef __m512i Vector;
+
+  static Vector Set1(uint32 x) { return _mm512_set1_epi32(x); }
+  static Vector Xor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+  static Vector MulLo(Vector a, Vector b) { return _mm512_mullo_epi32(a, b); }
+  static Vector MulHi(Vector a, Vector b) {
+    const Vector even = _mm512_mul_epu32(a, b);
+    const Vector odd =
+        _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+    return _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+  }
+  static Vector LaneCounters(uint32 base) {
+    return _mm512_add_epi32(_mm512_set1_epi32(base),
+                            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                              11, 12, 13, 14, 15));
+  }
+  static Vector Load(const uint32* p) { return _mm512_loadu_si512(p); }
+  static void Store(uint32* p, Vector v) { _mm512_storeu_si512(p, v); }
+  static void StoreUniformFloat(float* p, Vector v) {
+    const Vector bits = _mm512_or_si512(
+        _mm512_and_si512(v, _mm512_set1_epi32(0x7fffff)),
+        _mm512_set1_epi32(127 << 23));
+    _mm512_storeu_ps(p, _mm512_sub_ps(_mm512_castsi512_ps(bits),
+                                      _mm512_set1_ps(1.0f)));
+  }
+
+  // Turns the per-word vectors {r0, r1, r2, r3}, lane i holding word j of
+  // counter i, into four vectors that hold the samples in generator order.
+  static void Transpose(Vector* r) {
+    const Vector t0 = _mm512_unpacklo_epi32(r[0], r[1]);
+    const Vector t1 = _mm512_unpackhi_epi32(r[0], r[1]);
+    const Vector t2 = _mm512_unpacklo_epi32(r[2], r[3]);
+    const Vector t3 = _mm512_unpackhi_epi32(r[2], r[3]);
+    // u[k] holds counters k, k + 4, k + 8 and k + 12 in its 128-bit lanes.
+    const Vector u0 = _mm512_unpacklo_epi64(t0, t2);
+    const Vector u1 = _mm512_unpackhi_epi64(t0, t2);
+    const Vector u2 = _mm512_unpacklo_epi64(t1, t3);
+    const Vector u3 = _mm512_unpackhi_epi64(t1, t3);
+    // {0, 4, 1, 5}, {2, 6, 3, 7}, {8, 12, 9, 13} and {10, 14, 11, 15}.
+    const Vector v0 = _mm512_shuffle_i32x4(u0, u1, 0x44);
+    const Vector v1 = _mm512_shuffle_i32x4(u2, u3, 0x44);
+    const Vector v2 = _mm512_shuffle_i32x4(u0, u1, 0xEE);
+    const Vector v3 = _mm512_shuffle_i32x4(u2, u3, 0xEE);
+    r[0] = _mm512_shuffle_i32x4(v0, v1, 0x88);
+    r[1] = _mm512_shuffle_i32x4(v0, v1, 0xDD);
+    r[2] = _mm512_shuffle_i32x4(v2, v3, 0x88);
+    r[3] = _mm512_shuffle_i32x4(v2, v3, 0xDD);
+  }
+#elif defined(__AVX2__)
+  typedef __m256i Vector;
+
+  static Vector Set1(uint32 x) { return _mm256_set1_epi32(x); }
+  static Vector Xor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+  static Vector MulLo(Vector a, Vector b) { return _mm256_mullo_epi32(a, b); }
+  static Vector MulHi(Vector a, Vector b) {
+    const Vector even = _mm256_mul_epu32(a, b);
+    const Vector odd =
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+  }
+  static Vector LaneCounters(uint32 base) {
+    return _mm256_add_epi32(_mm256_set1_epi32(base),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  }
+  static Vector Load(const uint32* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void Store(uint32* p, Vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  static void StoreUniformFloat(float* p, Vector v) {
+    const Vector bits = _mm256_or_si256(
+        _mm256_and_si256(v, _mm256_set1_epi32(0x7fffff)),
+        _mm256_set1_epi32(127 << 23));
+    _mm256_storeu_ps(p, _mm256_sub_ps(_mm256_castsi256_ps(bits),
+                                      _mm256_set1_ps(1.0f)));
+  }
+
+  // Turns the per-word vectors {r0, r1, r2, r3}, lane i holding word j of
+  // counter i, into four vectors that hold the samples in generator order.
+  static void Transpose(Vector* r) {
+    const Vector t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    const Vector t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    const Vector t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    const Vector t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    // u[k] holds counters k and k + 4 in its 128-bit lanes.
+    const Vector u0 = _mm256_unpacklo_epi64(t0, t2);
+    const Vector u1 = _mm256_unpackhi_epi64(t0, t2);
+    const Vector u2 = _mm256_unpacklo_epi64(t1, t3);
+    const Vector u3 = _mm256_unpackhi_epi64(t1, t3);
+    r[0] = _mm256_permute2x128_si256(u0, u1, 0x20);
+    r[1] = _mm256_permute2x128_si256(u2, u3, 0x20);
+    r[2] = _mm256_permute2x128_si256(u0, u1, 0x31);
+    r[3] = _mm256_permute2x128_si256(u2, u3, 0x31);
+  }
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  // Runs the ten Philox rounds of PhiloxRandom::operator() for the next
+  // kStreams counters of "gen", and leaves the samples in generator order.
+  static void Generate(const PhiloxRandom& gen, Vector* samples) {
+    const Vector kMulA = Set1(PhiloxRandom::kPhiloxM4x32A);
+    const Vector kMulB = Set1(PhiloxRandom::kPhiloxM4x32B);
+    Vector c0 = LaneCounters(gen.counter_[0]);
+    Vector c1 = Set1(gen.counter_[1]);
+    Vector c2 = Set1(gen.counter_[2]);
+    Vector c3 = Set1(gen.counter_[3]);
+    uint32 key0 = gen.key_[0];
+    uint32 key1 = gen.key_[1];
+    for (int round = 0; round < 10; ++round) {
+      if (round > 0) {
+        key0 += PhiloxRandom::kPhiloxW32A;
+        key1 += PhiloxRandom::kPhiloxW32B;
+      }
+      const Vector lo0 = MulLo(kMulA, c0);
+      const Vector hi0 = MulHi(kMulA, c0);
+      const Vector lo1 = MulLo(kMulB, c2);
+      const Vector hi1 = MulHi(kMulB, c2);
+      c0 = Xor(Xor(hi1, c1), Set1(key0));
+      c1 = lo1;
+      c2 = Xor(Xor(hi0, c3), Set1(key1));
+      c3 = lo0;
+    }
+    samples[0] = c0;
+    samples[1] = c1;
+    samples[2] = c2;
+    samples[3] = c3;
+    Transpose(samples);
+  }
+#endif
+};
+
+}  // namespace random
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_RANDOM_PHILOX_RANDOM_SIMD_H_
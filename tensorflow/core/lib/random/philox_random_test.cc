@@ -21,6 +21,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/lib/random/philox_random_simd.h"
 #include "tensorflow/core/lib/random/philox_random_test_utils.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -68,6 +69,44 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// The vectorized generator must produce exactly the scalar sequence, also
+// when the lowest counter word wraps around in the middle of a vector.
+TEST(PhiloxRandomTest, SimdFillMatchTest) {
+  constexpr int count = 1000;
+
+  for (uint64 skip : {uint64{0}, uint64{0xFFFFFFFF} - 5, ~uint64{0} - 5}) {
+    PhiloxRandom base_gen(GetTestSeed(), GetTestSeed());
+    base_gen.Skip(skip);
+
+    std::vector<uint32> v1(count * PhiloxRandom::kResultElementCount);
+    std::vector<float> f1(v1.size());
+    PhiloxRandom gen1 = base_gen;
+    PhiloxRandomSimd::Fill(&gen1, &v1[0], count);
+    PhiloxRandom float_gen1 = base_gen;
+    PhiloxRandomSimd::FillUniformFloat(&float_gen1, &f1[0], count);
+
+    std::vector<uint32> v2(v1.size());
+    std::vector<float> f2(v1.size());
+    PhiloxRandom gen2 = base_gen;
+    FillRandoms<TrivialPhiloxDistribution>(gen2, &v2[0], v2.size());
+    FillRandoms<UniformDistribution<PhiloxRandom, float>>(base_gen, &f2[0],
+                                                          f2.size());
+
+    for (size_t i = 0; i < v1.size(); ++i) {
+      ASSERT_EQ(v1[i], v2[i]);
+      ASSERT_EQ(f1[i], f2[i]);
+    }
+
+    // Both generators must continue from the same counter.
+    gen2.Skip(count);
+    PhiloxRandom::ResultType next1 = gen1();
+    PhiloxRandom::ResultType next2 = gen2();
+    for (int i = 0; i < PhiloxRandom::kResultElementCount; ++i) {
+      ASSERT_EQ(next1[i], next2[i]);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
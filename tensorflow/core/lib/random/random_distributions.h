@@ -219,6 +219,27 @@ class SingleSampleAdapter {
     return unused_results_[used_result_index_++];
   }
 
+  // Skips the next `num_skips` samples, leaving the adapter in the same
+  // state as `num_skips` calls to operator() would. The generator must
+  // provide a `Skip(uint64)` method, as PhiloxRandom does.
+  PHILOX_DEVICE_INLINE
+  void Skip(uint64 num_skips) {
+    const uint64 num_unused_results =
+        kNativeElementCount - used_result_index_;
+    if (num_skips <= num_unused_results) {
+      used_result_index_ += num_skips;
+      return;
+    }
+    num_skips -= num_unused_results;
+    used_result_index_ = kNativeElementCount;
+    generator_->Skip(num_skips / kNativeElementCount);
+    num_skips %= kNativeElementCount;
+    if (num_skips > 0) {
+      unused_results_ = (*generator_)();
+      used_result_index_ = num_skips;
+    }
+  }
+
  private:
   Generator* generator_;
   typename Generator::ResultType unused_results_;
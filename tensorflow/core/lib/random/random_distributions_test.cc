@@ -280,6 +280,28 @@ TEST(PhiloxRandomTest, RandomParametersDoubleMomentsTest) {
   RandomParametersMomentsTest<double>(1 << 20, 40, strides, kZLimit);
 }
 
+TEST(PhiloxRandomTest, SingleSampleAdapterSkip) {
+  for (uint64 num_skips : {0, 1, 3, 4, 5, 8, 17, 1000}) {
+    for (int num_initial : {0, 1, 2, 3, 4}) {
+      PhiloxRandom parent_expected(17, 42);
+      SingleSampleAdapter<PhiloxRandom> expected(&parent_expected);
+      PhiloxRandom parent_skipped(17, 42);
+      SingleSampleAdapter<PhiloxRandom> skipped(&parent_skipped);
+      for (int i = 0; i < num_initial; ++i) {
+        expected();
+        skipped();
+      }
+      for (uint64 i = 0; i < num_skips; ++i) {
+        expected();
+      }
+      skipped.Skip(num_skips);
+      for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(expected(), skipped()) << num_skips << " " << num_initial;
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
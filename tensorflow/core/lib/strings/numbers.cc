@@ -100,6 +100,49 @@ T locale_independent_strtonum(const char* str, const char** endptr) {
   return result;
 }
 
+// Converts plain decimal numbers such as "-12.375" whose digits fit in the
+// float mantissa, with at most 10 digits after the point.  Both the digits
+// and the power of ten are then exact floats, so a single division yields the
+// correctly rounded result, as strtof would.  Returns false for any other
+// input, which is left to the general conversion.
+bool FastDecimalToFloat(StringPiece str, float* value) {
+  static const float kPowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                       1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+  static const uint32 kMaxExactMantissa = 1 << 24;
+  const char* p = str.data();
+  const char* const end = p + str.size();
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  uint32 mantissa = 0;
+  int num_digits = 0;
+  int fraction_digits = 0;
+  bool seen_point = false;
+  for (; p < end; ++p) {
+    const char c = *p;
+    if (c >= '0' && c <= '9') {
+      mantissa = mantissa * 10 + (c - '0');
+      if (mantissa >= kMaxExactMantissa) return false;
+      ++num_digits;
+      if (seen_point) ++fraction_digits;
+    } else if (c == '.' && !seen_point) {
+      seen_point = true;
+    } else {
+      return false;
+    }
+  }
+  if (num_digits == 0 ||
+      static_cast<size_t>(fraction_digits) >= TF_ARRAYSIZE(kPowersOfTen)) {
+    return false;
+  }
+  const float result =
+      static_cast<float>(mantissa) / kPowersOfTen[fraction_digits];
+  *value = negative ? -result : result;
+  return true;
+}
+
 }  // namespace
 
 namespace strings {
@@ -312,6 +355,11 @@ bool safe_strtof(const char* str, float* value) {
   return *str != '\0' && *endptr == '\0';
 }
 
+bool safe_strtof(StringPiece str, float* value) {
+  if (FastDecimalToFloat(str, value)) return true;
+  return safe_strtof(str.ToString().c_str(), value);
+}
+
 bool safe_strtod(const char* str, double* value) {
   const char* endptr;
   *value = locale_independent_strtonum<double>(str, &endptr);
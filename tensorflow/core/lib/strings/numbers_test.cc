@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/strings/numbers.h"
 
+#include <cmath>
 #include <string>
 #include "tensorflow/core/platform/test.h"
 
@@ -280,6 +281,43 @@ TEST(safe_strtof, Float) {
   EXPECT_FALSE(safe_strtof("-infinity is awesome", &result));
 }
 
+TEST(safe_strtof, FloatStringPiece) {
+  float result = 0;
+
+  // Plain decimals agree with the NUL-terminated version.
+  for (const char* str :
+       {"0", "-0", "+7", "1.", ".5", "0.123456", "-12.375", "16777215",
+        "1677721.5", "0.1", "3.4028235", "0.0000000001", "007.25"}) {
+    float expected = 0;
+    ASSERT_TRUE(safe_strtof(str, &expected)) << str;
+    EXPECT_TRUE(safe_strtof(StringPiece(str), &result)) << str;
+    EXPECT_EQ(expected, result) << str;
+    EXPECT_EQ(std::signbit(expected), std::signbit(result)) << str;
+  }
+
+  // Other numbers fall back to the general conversion.
+  EXPECT_TRUE(safe_strtof(StringPiece("16777217"), &result));
+  EXPECT_EQ(16777216.0f, result);
+  EXPECT_TRUE(safe_strtof(StringPiece("1e39"), &result));
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), result);
+  EXPECT_TRUE(safe_strtof(StringPiece("-0x2A"), &result));
+  EXPECT_EQ(-42.0f, result);
+  EXPECT_TRUE(safe_strtof(StringPiece(" 1.5 "), &result));
+  EXPECT_EQ(1.5f, result);
+  EXPECT_TRUE(safe_strtof(StringPiece("0.12345678901"), &result));
+  EXPECT_EQ(0.12345678901f, result);
+
+  // The string need not be NUL-terminated.
+  EXPECT_TRUE(safe_strtof(StringPiece("1.25,1", 4), &result));
+  EXPECT_EQ(1.25f, result);
+
+  EXPECT_FALSE(safe_strtof(StringPiece(""), &result));
+  EXPECT_FALSE(safe_strtof(StringPiece("."), &result));
+  EXPECT_FALSE(safe_strtof(StringPiece("-"), &result));
+  EXPECT_FALSE(safe_strtof(StringPiece("1.2.3"), &result));
+  EXPECT_FALSE(safe_strtof(StringPiece("0.12345abc"), &result));
+}
+
 TEST(safe_strtod, Double) {
   double result = 0;
 
@@ -100,6 +100,20 @@ Status SpectrogramShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status StreamingSpectrogramShapeFn(InferenceContext* c) {
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &input));
+  int32 window_size;
+  TF_RETURN_IF_ERROR(c->GetAttr("window_size", &window_size));
+
+  // The number of frames depends on the samples of the previous chunks.
+  DimensionHandle output_channels =
+      c->MakeDim(1 + NextPowerOfTwo(window_size) / 2);
+  c->set_output(0, c->MakeShape({c->Dim(input, 1), c->UnknownDim(),
+                                 output_channels}));
+  return Status::OK();
+}
+
 Status MfccShapeFn(InferenceContext* c) {
   ShapeHandle spectrogram;
   TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &spectrogram));
@@ -220,6 +234,41 @@ magnitude_squared: Whether to return the squared magnitude or just the
 spectrogram: 3D representation of the audio frequencies as an image.
 )doc");
 
+REGISTER_OP("StreamingAudioSpectrogram")
+    .Input("input: float")
+    .Attr("window_size: int")
+    .Attr("stride: int")
+    .Attr("magnitude_squared: bool = false")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Output("spectrogram: float")
+    .SetIsStateful()
+    .SetShapeFn(StreamingSpectrogramShapeFn)
+    .Doc(R"doc(
+Produces the spectrogram of a stream of audio data, one chunk at a time.
+
+Works as AudioSpectrogram does, but each call receives the samples that follow
+those of the previous calls, and outputs only the new slices of frequency
+information that they complete. The samples of the window that overlaps the
+next chunk are kept between calls, so a stream of short chunks (e.g. 10ms) costs
+the same as the whole stream at once. All the chunks must have the same number
+of channels.
+
+input: Float representation of the next chunk of audio data, of shape
+  `[samples, channels]`.
+window_size: How wide the input window is in samples. For the highest efficiency
+  this should be a power of two, but other values are accepted.
+stride: How widely apart the center of adjacent sample windows should be.
+magnitude_squared: Whether to return the squared magnitude or just the
+  magnitude. Using squared magnitude can avoid extra calculations.
+container: If non-empty, the state of the stream is placed in the given
+  container. Otherwise, a default container is used.
+shared_name: If non-empty, the state of the stream is shared under the given
+  name across multiple sessions.
+spectrogram: 3D representation of the new audio frequencies as an image, of
+  shape `[channels, new_slices, frequencies]`.
+)doc");
+
 REGISTER_OP("Mfcc")
     .Input("spectrogram: float")
     .Input("sample_rate: int32")
@@ -1047,6 +1047,7 @@ REGISTER_OP("SparseConditionalAccumulator")
     .Attr("shape: shape")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("defer_aggregation: bool = false")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       c->set_output(0, c->Vector(2));
@@ -1069,6 +1070,9 @@ container: If non-empty, this accumulator is placed in the given container.
   Otherwise, a default container is used.
 shared_name: If non-empty, this accumulator will be shared under the given name
   across multiple sessions.
+defer_aggregation: If true, applying a gradient only keeps it, and the kept
+  gradients are summed in parallel when the average is taken. This shortens
+  the time each apply holds the accumulator when many workers apply at once.
 )doc");
 
 REGISTER_OP("SparseAccumulatorApplyGradient")
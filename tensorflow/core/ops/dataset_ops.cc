@@ -90,6 +90,20 @@ count: A scalar representing the number of times that `input_dataset` should
   be repeated. A value of `-1` indicates that it should be repeated infinitely.
 )doc");
 
+REGISTER_OP("PrefetchDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that asynchronously prefetches elements from `input_dataset`.
+
+buffer_size: The maximum number of elements to buffer in an iterator over
+  this dataset.
+)doc");
+
 REGISTER_OP("TakeDataset")
     .Input("input_dataset: resource")
     .Input("count: int64")
@@ -156,6 +170,32 @@ output_buffer_size: The maximum number of output elements to buffer in an
   iterator over this dataset.
 )doc");
 
+REGISTER_OP("CachedMapDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("cache_directory: string")
+    .Input("cache_capacity_bytes: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to `input_dataset` and caches the results.
+
+The results are stored in a directory that several processes may share, keyed
+by a fingerprint of `f` and of its arguments, so a repeated input element is
+read from the cache instead of being recomputed. Each result is stored in its
+own file, and when the size of the directory exceeds `cache_capacity_bytes`,
+the least recently used results are deleted. Placing the directory on a local
+SSD or on a tmpfs such as /dev/shm lets the training processes on a host share
+the results, e.g. of decoding images, across epochs.
+
+cache_directory: The directory in which to cache the results of `f`.
+cache_capacity_bytes: The approximate maximum total size of the cached results.
+)doc");
+
 REGISTER_OP("FlatMapDataset")
     .Input("input_dataset: resource")
     .Input("other_arguments: Targuments")
@@ -177,6 +217,39 @@ f: A function mapping elements of `input_dataset`, concatenated with
   `output_types` and `output_shapes`.
 )doc");
 
+REGISTER_OP("ParallelInterleaveDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("cycle_length: int64")
+    .Input("block_length: int64")
+    .Input("buffer_output_elements: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to the outputs of `input_dataset`.
+
+Like FlatMapDataset, the `f` in ParallelInterleaveDataset is expected to
+return a Dataset resource. The datasets returned for `cycle_length`
+consecutive input elements are read concurrently, each by a thread of its
+own, and their elements are interleaved: `block_length` consecutive elements
+are taken from each of them in turn. The output order does not depend on
+the relative speed of the threads.
+
+f: A function mapping elements of `input_dataset`, concatenated with
+  `other_arguments`, to a Dataset resource that contains elements matching
+  `output_types` and `output_shapes`.
+cycle_length: The number of datasets returned by `f` that are read
+  concurrently.
+block_length: The number of consecutive elements to take from each of those
+  datasets before moving on to the next one.
+buffer_output_elements: The maximum number of elements to buffer for each of
+  those datasets.
+)doc");
+
 REGISTER_OP("GroupByWindowDataset")
     .Input("input_dataset: resource")
     .Input("key_func_other_arguments: Tkey_func_other_arguments")
@@ -269,6 +342,47 @@ padding_values: A list of scalars containing the padding value to use for
   each of the outputs.
 )doc");
 
+REGISTER_OP("BucketByTokenBudgetDataset")
+    .Input("input_dataset: resource")
+    .Input("length_func_other_arguments: Tlength_func_other_arguments")
+    .Input("token_budget: int64")
+    .Input("bucket_boundaries: int64")
+    .Input("padded_shapes: N * int64")
+    .Input("padding_values: Toutput_types")
+    .Output("handle: resource")
+    .Attr("length_func: func")
+    .Attr("Tlength_func_other_arguments: list(type) >= 0")
+    .Attr("Toutput_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .Attr("N: int >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that batches elements of similar length up to a token budget.
+
+Each element of `input_dataset` is assigned to a bucket by its length, as
+computed by `length_func`. A bucket is emitted as a padded batch when
+`batch_size * max_length`, the number of tokens in the batch after padding,
+would otherwise exceed `token_budget`, so that every batch uses about the same
+amount of memory. An element that is longer than `token_budget` is emitted in a
+batch of its own. Each batch is followed by two int64 scalars: the sum of the
+lengths of its elements, and `batch_size * max_length`. Their ratio is the
+padding efficiency of the batch.
+
+length_func: A function mapping an element of `input_dataset`, concatenated
+  with `length_func_other_arguments`, to a non-negative scalar of type DT_INT64.
+token_budget: A scalar representing the maximum number of tokens, including
+  padding, in a batch.
+bucket_boundaries: An increasing vector of lengths. Bucket `i` holds the
+  elements whose length is at least `bucket_boundaries[i - 1]` and less than
+  `bucket_boundaries[i]`.
+padded_shapes: A list of int64 tensors representing the desired padded shapes
+  of the corresponding output components. These shapes may be partially
+  specified, using `-1` to indicate that a particular dimension should be
+  padded to the maximum size of all batch elements.
+padding_values: A list of scalars containing the padding value to use for
+  each of the outputs.
+)doc");
+
 REGISTER_OP("DenseToSparseBatchDataset")
     .Input("input_dataset: resource")
     .Input("batch_size: int64")
@@ -389,7 +503,42 @@ Creates a dataset that emits the records from one or more TFRecord files.
 filenames: A scalar or vector containing the name(s) of the file(s) to be
   read.
 compression_type: A scalar containing either (i) the empty string (no
-  compression), (ii) "ZLIB", or (iii) "GZIP".
+  compression), (ii) "ZLIB", (iii) "GZIP", or (iv) "BLOCK_ZLIB".
+)doc");
+
+REGISTER_OP("ColumnarDataset")
+    .Input("filenames: string")
+    .Input("batch_size: int64")
+    .Output("handle: resource")
+    .Attr("dense_keys: list(string) >= 0")
+    .Attr("dense_shapes: list(shape) >= 0")
+    .Attr("ragged_keys: list(string) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that emits batches of rows from one or more columnar files.
+
+Columnar files are written by `ColumnarWriter` or converted from TFRecord files
+of `tf.Example`s by the `columnar_converter` tool (see
+tensorflow/core/util/columnar/columnar.h). Only the selected columns are read,
+and batches that lie within a single chunk of a file alias the memory-mapped
+file instead of being copied.
+
+Each element holds the selected columns ordered by key, where `B` is at most
+`batch_size`: a tensor of shape `[B] + dense_shapes[i]` for a dense column, and
+a vector of values followed by a vector of `B + 1` int64 row splits for a
+ragged column. The values of row `r` of a ragged column are
+`values[row_splits[r]:row_splits[r + 1]]`. Ragged columns that are missing
+from a file have no values.
+
+filenames: A scalar or vector containing the name(s) of the file(s) to be
+  read.
+batch_size: A scalar representing the maximum number of rows per batch.
+dense_keys: The names of the dense columns. Every row of a dense column must
+  have exactly as many values as its dense shape.
+dense_shapes: The shapes of the rows of each dense column.
+ragged_keys: The names of the ragged columns.
 )doc");
 
 REGISTER_OP("Iterator")
@@ -487,4 +636,34 @@ REGISTER_OP("IteratorDispose")
 Releases any resources used by the given iterator.
 )doc");
 
+REGISTER_OP("SaveIterator")
+    .Input("iterator: resource")
+    .Input("path: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Saves the current position of the given iterator to `path`.
+
+The position can later be restored with "RestoreIterator", so that an
+interrupted input pipeline resumes where it stopped instead of at the start
+of its dataset. Only iterators over datasets that support saving their state
+can be saved.
+
+iterator: A handle to an initialized iterator.
+path: The path prefix of the tensor bundle in which to save the state.
+)doc");
+
+REGISTER_OP("RestoreIterator")
+    .Input("iterator: resource")
+    .Input("path: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Restores the position of the given iterator from `path`.
+
+The iterator must have been initialized on a dataset with the same
+definition as the iterator that was saved with "SaveIterator".
+
+iterator: A handle to an initialized iterator.
+path: The path prefix of the tensor bundle written by "SaveIterator".
+)doc");
+
 }  // namespace tensorflow
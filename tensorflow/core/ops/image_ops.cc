@@ -87,6 +87,39 @@ Status DecodeImageShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status DecodeAndCropJpegShapeFn(InferenceContext* c) {
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+  ShapeHandle crop_window;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &crop_window));
+  DimensionHandle unused_dim;
+  TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_window, 0), 4, &unused_dim));
+
+  DimensionHandle channels_dim = c->UnknownDim();
+  int32 channels;
+  TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+  if (channels < 0) {
+    return errors::InvalidArgument("channels must be non-negative, got ",
+                                   channels);
+  }
+  if (channels > 0) {
+    channels_dim = c->MakeDim(channels);
+  }
+
+  // The output size is known when the crop window is a constant. Invalid
+  // windows are left for the kernel to reject.
+  DimensionHandle h = c->UnknownDim();
+  DimensionHandle w = c->UnknownDim();
+  const Tensor* crop_window_t = c->input_tensor(1);
+  if (crop_window_t != nullptr) {
+    auto crop_window_vec = crop_window_t->vec<int32>();
+    if (crop_window_vec(2) > 0) h = c->MakeDim(crop_window_vec(2));
+    if (crop_window_vec(3) > 0) w = c->MakeDim(crop_window_vec(3));
+  }
+  c->set_output(0, c->MakeShape({h, w, channels_dim}));
+  return Status::OK();
+}
+
 Status EncodeImageShapeFn(InferenceContext* c) {
   ShapeHandle unused;
   TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &unused));
@@ -108,6 +141,36 @@ Status ColorspaceShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+// Sets "height" and "width" to the frame size of a YUV420SP input of shape
+// [height * 3 / 2, width].
+Status YUV420SPFrameSize(InferenceContext* c, DimensionHandle* height,
+                         DimensionHandle* width) {
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &input));
+  DimensionHandle third;
+  TF_RETURN_IF_ERROR(
+      c->Divide(c->Dim(input, 0), 3, true /* evenly_divisible */, &third));
+  TF_RETURN_IF_ERROR(c->Multiply(third, 2, height));
+  *width = c->Dim(input, 1);
+  return Status::OK();
+}
+
+Status YUV420SPToRGBShapeFn(InferenceContext* c) {
+  DimensionHandle height;
+  DimensionHandle width;
+  TF_RETURN_IF_ERROR(YUV420SPFrameSize(c, &height, &width));
+  c->set_output(0, c->MakeShape({height, width, 3}));
+  return Status::OK();
+}
+
+Status YUV420SPToResizedRGBShapeFn(InferenceContext* c) {
+  DimensionHandle unused_height;
+  DimensionHandle unused_width;
+  TF_RETURN_IF_ERROR(YUV420SPFrameSize(c, &unused_height, &unused_width));
+  return SetOutputToSizedImage(c, c->MakeDim(1), 1 /* size_input_idx */,
+                               c->MakeDim(3));
+}
+
 }  // namespace
 
 // --------------------------------------------------------------------------
@@ -404,6 +467,60 @@ dct_method: string specifying a hint about the algorithm used for
 image: 3-D with shape `[height, width, channels]`..
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeAndCropJpeg")
+    .Input("contents: string")
+    .Input("crop_window: int32")
+    .Attr("channels: int = 0")
+    .Attr("ratio: int = 1")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Output("image: uint8")
+    .SetShapeFn(DecodeAndCropJpegShapeFn)
+    .Doc(R"doc(
+Decode and Crop a JPEG-encoded image to a uint8 tensor.
+
+The attr `channels` indicates the desired number of color channels for the
+decoded image.
+
+Accepted values are:
+
+*   0: Use the number of channels in the JPEG-encoded image.
+*   1: output a grayscale image.
+*   3: output an RGB image.
+
+If needed, the JPEG-encoded image is transformed to match the requested number
+of color channels.
+
+The attr `ratio` allows downscaling the image by an integer factor during
+decoding.  Allowed values are: 1, 2, 4, and 8.  The crop window is given in the
+coordinates of the downscaled image.
+
+It is equivalent to a combination of decode and crop, but much faster by only
+decoding the partial jpeg image: rows below the window are never decoded, and
+with libjpeg-turbo the rows above it are skipped and only the columns of the
+window are decompressed.
+
+contents: 0-D.  The JPEG-encoded image.
+crop_window: 1-D.  The crop window: [crop_y, crop_x, crop_height, crop_width].
+channels: Number of color channels for the decoded image.
+ratio: Downscaling ratio.
+fancy_upscaling: If true use a slower but nicer upscaling of the
+  chroma planes (yuv420/422 only).
+try_recover_truncated:  If true try to recover an image from truncated input.
+acceptable_fraction: The minimum required fraction of lines before a truncated
+  input is accepted.
+dct_method: string specifying a hint about the algorithm used for
+  decompression.  Defaults to "" which maps to a system-specific
+  default.  Currently valid values are ["INTEGER_FAST",
+  "INTEGER_ACCURATE"].  The hint may be ignored (e.g., the internal
+  jpeg library changes to a version that does not have that specific
+  option.)
+image: 3-D with shape `[height, width, channels]`..
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -687,6 +804,193 @@ images: 1-D or higher rank. HSV data to convert. Last dimension must be size 3.
 output: `images` converted to RGB.
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("YUV420SPToRGB")
+    .Input("yuv: uint8")
+    .Output("image: uint8")
+    .Attr("uv_order: {'VU', 'UV'} = 'VU'")
+    .SetShapeFn(YUV420SPToRGBShapeFn)
+    .Doc(R"doc(
+Converts a YUV 4:2:0 semi-planar frame, as delivered by cameras, to RGB.
+
+The frame holds a plane of 8 bit Y samples followed by a plane of interleaved
+8 bit chroma samples, subsampled 2x2. With the default `uv_order` of `VU` this
+is the NV21 format of the Android camera preview; `UV` is NV12. Colors are
+converted with the BT.601 video-range coefficients in fixed point.
+
+yuv: 2-D with shape `[height * 3 / 2, width]`. `height` and `width` must be
+  even.
+image: 3-D with shape `[height, width, 3]`.
+uv_order: The order of the samples in the chroma plane.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("YUV420SPToResizedRGB")
+    .Input("yuv: uint8")
+    .Input("size: int32")
+    .Output("image: float")
+    .Attr("uv_order: {'VU', 'UV'} = 'VU'")
+    .Attr("align_corners: bool = false")
+    .Attr("mean: float = 0.0")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn(YUV420SPToResizedRGBShapeFn)
+    .Doc(R"doc(
+Converts a YUV 4:2:0 semi-planar frame to a resized and normalized RGB batch.
+
+Equivalent to `YUV420SPToRGB` followed by `ResizeBilinear` and
+`(image - mean) * scale`, up to the rounding and clamping of the intermediate
+uint8 image, but done in a single pass over the output. This produces the
+input tensor of an image model straight from a camera frame.
+
+yuv: 2-D with shape `[height * 3 / 2, width]`. `height` and `width` must be
+  even.
+size: A 1-D int32 Tensor of 2 elements: `new_height, new_width`.  The
+  new size for the images.
+image: 4-D with shape `[1, new_height, new_width, 3]`.
+uv_order: The order of the samples in the chroma plane, `VU` for NV21 or `UV`
+  for NV12.
+align_corners: If true, rescale input by (new_height - 1) / (height - 1), which
+  exactly aligns the 4 corners of images and resized images. If false, rescale
+  by new_height / height. Treat similarly the width dimension.
+mean: Subtracted from each RGB value, in [0, 255].
+scale: Multiplies each RGB value after subtracting `mean`.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("ImagePyramid")
+    .Input("images: uint8")
+    .Output("levels: num_levels * uint8")
+    .Attr("num_levels: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle images;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &images));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(images, 3), 1, &unused));
+      int num_levels;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_levels", &num_levels));
+      DimensionHandle height = c->Dim(images, 1);
+      DimensionHandle width = c->Dim(images, 2);
+      for (int level = 0; level < num_levels; ++level) {
+        if (level > 0) {
+          height = c->ValueKnown(height) ? c->MakeDim(c->Value(height) / 2)
+                                         : c->UnknownDim();
+          width = c->ValueKnown(width) ? c->MakeDim(c->Value(width) / 2)
+                                       : c->UnknownDim();
+        }
+        c->set_output(level, c->MakeShape({c->Dim(images, 0), height, width,
+                                           c->MakeDim(1)}));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Builds a pyramid of grayscale images for tracking.
+
+Level 0 is `images` itself, and each further level averages the 2x2 blocks of
+the previous one, truncating, so that it has half its height and width,
+rounded down.
+
+images: 4-D with shape `[batch, height, width, 1]`.
+levels: `num_levels` 4-D tensors, level `l` having shape
+  `[batch, height / 2^l, width / 2^l, 1]`.
+num_levels: The number of levels, which must all be at least 1x1.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("LucasKanadeOpticalFlow")
+    .Input("prev_levels: num_levels * uint8")
+    .Input("next_levels: num_levels * uint8")
+    .Input("points: float")
+    .Output("next_points: float")
+    .Output("status: bool")
+    .Attr("num_levels: int >= 1")
+    .Attr("window_radius: int >= 1 = 3")
+    .Attr("max_iterations: int >= 1 = 10")
+    .Attr("epsilon: float = 0.03")
+    .Attr("normalize_brightness: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle points;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(c->num_inputs() - 1), 3,
+                                     &points));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(points, 2), 2, &unused));
+      c->set_output(0, points);
+      c->set_output(1, c->Matrix(c->Dim(points, 0), c->Dim(points, 1)));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Tracks points from one frame to the next with pyramidal Lucas-Kanade.
+
+Each point is tracked from the coarsest level of the pyramids, as built by
+`ImagePyramid`, to the finest one. At each level, the motion of the
+`2 * window_radius + 1` pixels wide patch around the point is refined with
+Gauss-Newton steps until a step is shorter than `epsilon` pixels.
+
+prev_levels: The pyramid of the previous frames, each level of shape
+  `[batch, height_l, width_l, 1]`.
+next_levels: The pyramid of the next frames, of the same shapes.
+points: 3-D with shape `[batch, num_points, 2]`. The `[y, x]` coordinates of
+  the points to track in the previous frames, in level 0 pixels.
+next_points: The tracked coordinates of the points in the next frames, or
+  their original coordinates where `status` is false.
+status: 2-D with shape `[batch, num_points]`. False for the points that have
+  no texture to track or that leave the frame.
+window_radius: The radius of the patch around each point.
+max_iterations: The most Gauss-Newton steps per pyramid level.
+epsilon: The step length below which a level is done, in pixels of the level.
+normalize_brightness: If true, the patches are compared after matching their
+  means and standard deviations, as the Android demo tracker does. This makes
+  the flow robust to exposure changes between the frames, but needs more
+  iterations to converge.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("FastKeypoints")
+    .Input("images: uint8")
+    .Output("keypoints: float")
+    .Output("scores: float")
+    .Output("num_keypoints: int32")
+    .Attr("max_keypoints: int >= 1 = 100")
+    .Attr("arc_length: int >= 9 = 9")
+    .Attr("threshold: int >= 0 = 10")
+    .Attr("border: int >= 3 = 10")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle images;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &images));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(images, 3), 1, &unused));
+      int max_keypoints;
+      TF_RETURN_IF_ERROR(c->GetAttr("max_keypoints", &max_keypoints));
+      DimensionHandle batch = c->Dim(images, 0);
+      c->set_output(0, c->MakeShape({batch, max_keypoints, 2}));
+      c->set_output(1, c->Matrix(batch, max_keypoints));
+      c->set_output(2, c->Vector(batch));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Detects FAST corners in grayscale images.
+
+A pixel is a corner if at least `arc_length` contiguous pixels of the 16 on the
+circle of radius 3 around it are all brighter, or all darker, than it by more
+than `threshold`. Its score is the larger of the sums of the differences beyond
+`threshold` of the brighter and of the darker pixels of the circle. Only the
+corners with the largest score of their 3x3 neighborhood are kept, strongest
+first.
+
+images: 4-D with shape `[batch, height, width, 1]`.
+keypoints: 3-D with shape `[batch, max_keypoints, 2]`. The `[y, x]`
+  coordinates of the corners of each image, followed by zeros.
+scores: 2-D with shape `[batch, max_keypoints]`. The scores of the corners,
+  followed by zeros.
+num_keypoints: 1-D with shape `[batch]`. The number of corners found in each
+  image, at most `max_keypoints`.
+max_keypoints: The most corners to return per image.
+arc_length: The number of contiguous pixels, between 9 and 12, that must
+  differ from the center. 9 is the usual FAST-9; 12 is what the Android demo
+  tracker uses, which misses right-angle corners.
+threshold: The brightness difference that the arc must exceed.
+border: The pixels closer than this to the edges are not considered.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("DrawBoundingBoxes")
     .Input("images: T")
@@ -1200,4 +1504,71 @@ selected_indices: A 1-D integer tensor of shape `[M]` representing the selected
   indices from the boxes tensor, where `M <= max_output_size`.
 )doc");
 
+REGISTER_OP("CombinedNonMaxSuppression")
+    .Input("boxes: float")
+    .Input("scores: float")
+    .Input("max_output_size_per_class: int32")
+    .Input("max_total_size: int32")
+    .Input("iou_threshold: float")
+    .Input("score_threshold: float")
+    .Output("nmsed_boxes: float")
+    .Output("nmsed_scores: float")
+    .Output("nmsed_classes: float")
+    .Output("valid_detections: int32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle boxes;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &boxes));
+      ShapeHandle scores;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 3, &scores));
+      ShapeHandle unused;
+      for (int i = 2; i < 6; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(boxes, 3), 4, &unused_dim));
+
+      DimensionHandle batch_size;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(boxes, 0), c->Dim(scores, 0), &batch_size));
+      DimensionHandle max_total_size;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(3, &max_total_size));
+      c->set_output(0, c->MakeShape({batch_size, max_total_size, 4}));
+      c->set_output(1, c->Matrix(batch_size, max_total_size));
+      c->set_output(2, c->Matrix(batch_size, max_total_size));
+      c->set_output(3, c->Vector(batch_size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Greedily selects a subset of bounding boxes in descending order of score,
+for each class of each image of a batch, in a single op.
+
+Runs non max suppression independently on each class of each image, as
+NonMaxSuppressionV2 does, keeping only the boxes whose score is above
+`score_threshold`. Then keeps the `max_total_size` boxes with the highest
+scores over all the classes of each image, and pads the outputs with zeros.
+
+boxes: A 4-D float tensor of shape `[batch_size, num_boxes, q, 4]`. If `q`
+  is 1, the same boxes are used for all classes, otherwise `q` must be
+  `num_classes` and each class has its own boxes.
+scores: A 3-D float tensor of shape `[batch_size, num_boxes, num_classes]`
+  representing a score for each class of each box.
+max_output_size_per_class: A scalar integer tensor representing the maximum
+  number of boxes to be selected by non max suppression for each class.
+max_total_size: A scalar integer tensor representing the maximum number of
+  boxes kept for each image, over all classes.
+iou_threshold: A 0-D float tensor representing the threshold for deciding
+  whether boxes overlap too much with respect to IOU.
+score_threshold: A 0-D float tensor representing the threshold for deciding
+  when to remove boxes based on score.
+nmsed_boxes: A `[batch_size, max_total_size, 4]` float tensor of the
+  selected boxes.
+nmsed_scores: A `[batch_size, max_total_size]` float tensor of the scores of
+  the selected boxes.
+nmsed_classes: A `[batch_size, max_total_size]` float tensor of the classes
+  of the selected boxes.
+valid_detections: A `[batch_size]` int32 tensor of the number of valid
+  detections of each image. Only the first `valid_detections[i]` entries of
+  the outputs of image `i` are valid.
+)doc");
+
 }  // namespace tensorflow
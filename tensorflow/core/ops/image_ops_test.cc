@@ -90,6 +90,45 @@ TEST(ImageOpsTest, DecodeImage_ShapeFn) {
   }
 }
 
+TEST(ImageOpsTest, DecodeAndCropJpeg_ShapeFn) {
+  const char* op_name = "DecodeAndCropJpeg";
+  ShapeInferenceTestOp op(op_name);
+
+  // Rank checks.
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op, "[1];?");
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op, "[];[]");
+  INFER_ERROR("Dimension must be 4 but is 3", op, "[];[3]");
+
+  // Set the channel to zero - output is not known.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[];[4]", "[?,?,?]");
+
+  // Set the channel, so that part of output shape is known.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Attr("channels", 4)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[];[4]", "[?,?,4]");
+
+  // A constant crop window determines the height and width.
+  op.input_tensors.resize(2);
+  Tensor crop_window = test::AsTensor<int32>({1, 2, 10, 20});
+  op.input_tensors[1] = &crop_window;
+  INFER_OK(op, "[];[4]", "[10,20,4]");
+
+  // Negative channel value is rejected.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Attr("channels", -1)
+                   .Finalize(&op.node_def));
+  INFER_ERROR("channels must be non-negative, got -1", op, "[];[4]");
+}
+
 TEST(ImageOpsTest, EncodeImage_ShapeFn) {
   for (const char* op_name : {"EncodeJpeg", "EncodePng"}) {
     ShapeInferenceTestOp op(op_name);
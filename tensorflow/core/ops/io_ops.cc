@@ -62,6 +62,7 @@ REGISTER_OP("SaveV2")
     .Input("shape_and_slices: string")
     .Input("tensors: dtypes")
     .Attr("dtypes: list(type)")
+    .Attr("num_shards: int >= 1 = 1")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
@@ -94,6 +95,89 @@ tensor_names: shape {N}. The names of the tensors to be saved.
 shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
   Empty strings indicate that they are non-partitioned tensors.
 tensors: `N` tensors to save.
+num_shards: The number of data files to spread the tensors across.  If greater
+  than 1, the data files are written concurrently, and their metadata is then
+  merged into a single checkpoint under "prefix".
+)doc");
+
+REGISTER_OP("AsyncSaverHandleOp")
+    .Output("resource: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a handle to an AsyncSaver, which writes checkpoints in the background.
+
+The AsyncSaver is created by the first op that uses the handle.
+
+container: the container this saver is placed in.
+shared_name: the name by which this saver is referred to.
+)doc");
+
+REGISTER_OP("AsyncSaveV2")
+    .Input("saver: resource")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+
+      // Validate saver and prefix.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      // Validate tensor_names and shapes_and_slices.
+      for (int i = 2; i <= 3; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(
+            c->WithValue(c->Dim(s, 0), c->num_inputs() - 4, &unused_dim));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Saves tensors in V2 checkpoint format in the background.
+
+Copies the tensors and returns, leaving "saver" to write the copies to the
+checkpoint like SaveV2 does, after the checkpoints it was given before.  Use
+AsyncSaverStatus to find out when the checkpoint is written and whether
+writing it failed.
+
+saver: The AsyncSaver that writes the checkpoint.
+prefix: Must have a single element. The prefix of the V2 checkpoint to which we
+  write the tensors.
+tensor_names: shape {N}. The names of the tensors to be saved.
+shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
+  Empty strings indicate that they are non-partitioned tensors.
+tensors: `N` tensors to save.
+)doc");
+
+REGISTER_OP("AsyncSaverStatus")
+    .Input("saver: resource")
+    .Output("num_pending: int64")
+    .Attr("wait: bool = false")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Returns the number of checkpoints an AsyncSaver has not finished writing.
+
+Fails with the error of the first checkpoint that failed to be written since
+the last AsyncSaverStatus op that ran on "saver", if any.
+
+saver: The AsyncSaver.
+num_pending: The number of checkpoints that have not been written yet.
+wait: If true, first waits until all the checkpoints given to "saver" so far
+  are written, so that "num_pending" is 0.
 )doc");
 
 REGISTER_OP("RestoreV2")
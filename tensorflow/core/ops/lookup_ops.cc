@@ -476,6 +476,7 @@ REGISTER_OP("MutableDenseHashTable")
     .Attr("value_shape: shape = {}")
     .Attr("initial_num_buckets: int = 131072")  // 2^17
     .Attr("max_load_factor: float = 0.8")
+    .Attr("num_shards: int >= 1 = 1")
     .SetIsStateful()
     .SetShapeFn(TwoElementOutput)
     .Doc(R"doc(
@@ -502,6 +503,9 @@ initial_num_buckets: The initial number of hash table buckets. Must be a power
   to 2.
 max_load_factor: The maximum ratio between number of entries and number of
   buckets before growing the table. Must be between 0 and 1.
+num_shards: The number of independently locked shards the buckets are split
+  into. Each shard grows on its own, and lookups and inserts are processed in
+  parallel across shards.
 )doc");
 
 REGISTER_OP("MutableDenseHashTableV2")
@@ -515,6 +519,7 @@ REGISTER_OP("MutableDenseHashTableV2")
     .Attr("value_shape: shape = {}")
     .Attr("initial_num_buckets: int = 131072")  // 2^17
     .Attr("max_load_factor: float = 0.8")
+    .Attr("num_shards: int >= 1 = 1")
     .SetIsStateful()
     .SetShapeFn(ScalarOutput)
     .Doc(R"doc(
@@ -541,6 +546,9 @@ initial_num_buckets: The initial number of hash table buckets. Must be a power
   to 2.
 max_load_factor: The maximum ratio between number of entries and number of
   buckets before growing the table. Must be between 0 and 1.
+num_shards: The number of independently locked shards the buckets are split
+  into. Each shard grows on its own, and lookups and inserts are processed in
+  parallel across shards.
 )doc");
 
 REGISTER_OP("InitializeTable")
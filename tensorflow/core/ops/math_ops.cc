@@ -1085,7 +1085,7 @@ REGISTER_OP("MatMul")
     .Output("product: T")
     .Attr("transpose_a: bool = false")
     .Attr("transpose_b: bool = false")
-    .Attr("T: {half, float, double, int32, complex64, complex128}")
+    .Attr("T: {bfloat16, half, float, double, int32, complex64, complex128}")
     .SetShapeFn(shape_inference::MatMulShape)
     .Doc(R"doc(
 Multiply the matrix "a" by the matrix "b".
@@ -1102,6 +1102,32 @@ transpose_a: If true, "a" is transposed before multiplication.
 transpose_b: If true, "b" is transposed before multiplication.
 )doc");
 
+REGISTER_OP("_FusedMatMul")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("bias: T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {float, double}")
+    .Attr("activation: {'Identity', 'Relu', 'Relu6', 'Tanh', 'Elu'} = "
+          "'Identity'")
+    .SetShapeFn(shape_inference::MatMulShape)
+    .Doc(R"doc(
+Computes `activation(BiasAdd(MatMul(a, b), bias))`.
+
+The bias addition and the activation are applied in place on the output of the
+matrix multiplication, avoiding the intermediate tensors.
+
+NOTE Do not invoke this operator directly in Python. The grappler op fusion
+optimizer is expected to create these operators.
+
+bias: 1-D with size the number of columns of the product.
+transpose_a: If true, "a" is transposed before multiplication.
+transpose_b: If true, "b" is transposed before multiplication.
+activation: The activation to apply after adding the bias.
+)doc");
+
 REGISTER_OP("SparseMatMul")
     .Input("a: Ta")
     .Input("b: Tb")
@@ -1809,6 +1835,105 @@ segment_ids: segment_ids passed to the corresponding SparseSegmentSqrtN op.
 output_dim0: dimension 0 of "data" passed to SparseSegmentSqrtN op.
 )doc");
 
+REGISTER_OP("SparseSegmentWeightedCombine")
+    .Input("data: T")
+    .Input("indices: Tidx")
+    .Input("weights: T")
+    .Input("segment_ids: int32")
+    .Input("num_segments: int32")
+    .Output("output: T")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle data_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
+
+      // indices, weights and segment_ids should merge cleanly.
+      ShapeHandle indices_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &indices_shape));
+      TF_RETURN_IF_ERROR(c->Merge(indices_shape, c->input(2), &indices_shape));
+      TF_RETURN_IF_ERROR(c->Merge(indices_shape, c->input(3), &indices_shape));
+
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      DimensionHandle num_segments;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(4, &num_segments));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(data_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(
+          c->Concatenate(c->Vector(num_segments), subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the weighted sum, mean or sqrtn of rows of `data` per segment.
+
+This is the combining step of an embedding lookup over a sparse batch of ids.
+For each segment `s`:
+
+```
+output[s] = sum_i(weights[i] * data[indices[i]]) / denominator[s]
+```
+
+where `i` ranges over the entries with `segment_ids[i] == s`, and
+`denominator[s]` is 1 for `"sum"`, `sum_i(weights[i])` for `"mean"` and
+`sqrt(sum_i(weights[i]^2))` for `"sqrtn"`. The rows are gathered from `data`
+and combined directly into `output`, so no intermediate tensor with one row per
+entry is created.
+
+Segments with no entries are zero, and segments whose denominator is zero are
+not rescaled.
+
+indices: A 1-D tensor. Has same size as `segment_ids`.
+weights: A 1-D tensor of weights for each row selected by `indices`.
+segment_ids: A 1-D tensor. Values should be sorted and can be repeated.
+num_segments: The number of segments, which must be greater than every value
+  in `segment_ids`.
+output: Has same shape as data, except for dimension 0 which
+  has size `num_segments`.
+combiner: How to normalize the weighted sum of each segment.
+)doc");
+
+REGISTER_OP("SparseSegmentWeightedCombineGrad")
+    .Input("grad: T")
+    .Input("weights: T")
+    .Input("segment_ids: int32")
+    .Output("output: T")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle grad_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &grad_shape));
+      ShapeHandle weights_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &weights_shape));
+      TF_RETURN_IF_ERROR(c->Merge(weights_shape, c->input(2), &weights_shape));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(grad_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(weights_shape, subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes gradients for SparseSegmentWeightedCombine.
+
+Returns the gradient for each row of "data" selected by "indices", in the same
+order as "indices". Together with "indices" these are the values of the
+IndexedSlices gradient for "data".
+
+grad: gradient propagated to the SparseSegmentWeightedCombine op.
+weights: weights passed to the corresponding SparseSegmentWeightedCombine op.
+segment_ids: segment_ids passed to the corresponding
+  SparseSegmentWeightedCombine op.
+output: Has same shape as grad, except for dimension 0 which has the size of
+  `weights`.
+combiner: combiner of the corresponding SparseSegmentWeightedCombine op.
+)doc");
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
@@ -2273,6 +2398,119 @@ Tactivation: The type of output produced by activation function
 
 )doc");
 
+REGISTER_OP("QuantizedMatMulPerChannel")
+    .Input("a: quint8")
+    .Input("b: qint8")
+    .Input("bias: float")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("out: quint8")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("activation: {'NONE', 'RELU', 'RELU6'} = 'NONE'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      DimensionHandle unused_inner;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(a, 1), c->Dim(b, 0), &unused_inner));
+      c->set_output(0, c->Matrix(c->Dim(a, 0), c->Dim(b, 1)));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform a quantized matrix multiplication with a range for each column of `b`.
+
+The values of `b` are symmetric around zero: the real value of `q` in column
+`j` is `q * max(abs(min_b[j]), abs(max_b[j])) / 127`. The bias is added and
+the activation is applied to the real-valued results, which are then quantized
+into the requested output range.
+
+a: A two-dimensional tensor of shape `[m, k]`.
+b: A two-dimensional tensor of shape `[k, n]`.
+bias: The float bias of each output column, of shape `[n]`.
+activation: The activation function applied after the bias.
+min_a: The float value that the lowest quantized `a` value represents.
+max_a: The float value that the highest quantized `a` value represents.
+min_b: The float minimum of each column of `b`, of shape `[n]`, or a scalar
+  for all columns.
+max_b: The float maximum of each column of `b`, of shape `[n]`, or a scalar
+  for all columns.
+requested_output_min: The float value that the lowest quantized output value
+  should represent. If it is equal to `requested_output_max`, the output range
+  is computed from the results instead.
+requested_output_max: The float value that the highest quantized output value
+  should represent.
+min_out: The float value that the lowest quantized output value represents.
+max_out: The float value that the highest quantized output value represents.
+
+)doc");
+
+REGISTER_OP("BitSerialMatMul")
+    .Input("a: float")
+    .Input("b: uint8")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Output("product: float")
+    .Attr("num_bits_a: int >= 1")
+    .Attr("narrow_range_a: bool = false")
+    .Attr("narrow_range_b: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 3, &b));
+      c->set_output(0, c->Matrix(c->Dim(a, 0), c->Dim(b, 0)));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Multiplies `a` by the transpose of a matrix of 1 to 8 bit values, bit-serially.
+
+`a` is quantized as FakeQuantWithMinMaxVars(a, min_a, max_a, num_bits_a,
+narrow_range_a) does, and `b` holds the levels of values quantized the same way
+with `min_b`, `max_b` and `narrow_range_b`. The product of the quantized values
+is computed exactly from popcounts of ANDed bit-planes, which for one bit per
+value is the inner product of XNOR networks, and two bits with narrow_range
+hold ternary values. With one bit, which FakeQuantWithMinMaxVars does not
+support, the two levels are the min and the max of the range.
+
+a: A two-dimensional tensor of shape `[m, k]`.
+b: The `[n, k]` matrix of levels packed into bit-planes, of shape
+  `[n, num_bits_b, 8 * ceil(k / 64)]`: bit `p` of the level at column `l` of
+  row `j` is bit `l % 8` of `b[j, p, l / 8]`. The padding bits are zero.
+min_a: The float value that the lowest quantized `a` value represents.
+max_a: The float value that the highest quantized `a` value represents.
+min_b: The float value that the lowest `b` level represents.
+max_b: The float value that the highest `b` level represents.
+product: The `[m, n]` product.
+num_bits_a: The number of bits of the quantized `a`, at most 8.
+narrow_range_a: Whether `a` is quantized into [1; 2^num_bits_a - 1] instead of
+  [0; 2^num_bits_a - 1].
+narrow_range_b: Whether `b` was quantized into [1; 2^num_bits_b - 1].
+
+)doc");
+
 REGISTER_OP("QuantizedMul")
     .Input("x: T1")
     .Input("y: T2")
@@ -380,6 +380,35 @@ TEST(MathOpsTest, SparseSegmentGrad_ShapeFn) {
   INFER_ERROR("Cannot specify a negative value", op, "[2,4,3];[3];[3];[]");
 }
 
+TEST(MathOpsTest, SparseSegmentWeightedCombine_ShapeFn) {
+  ShapeInferenceTestOp op("SparseSegmentWeightedCombine");
+  op.input_tensors.resize(5);
+  INFER_OK(op, "?;?;?;?;?", "?");
+  INFER_OK(op, "[2,4,3];[3];[3];[3];[]", "[?,d0_1,d0_2]");
+
+  Tensor num_segments_t = test::AsScalar(10);
+  op.input_tensors[4] = &num_segments_t;
+  INFER_OK(op, "[2,4,3];[3];?;[3];[]", "[10,d0_1,d0_2]");
+
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op,
+              "[2,4,3];[];[3];[3];[]");
+  INFER_ERROR("Dimension 0 in both shapes must be equal, but are 3 and 4", op,
+              "[2,4,3];[3];[4];[3];[]");
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op,
+              "[2,4,3];[3];[3];[3];[1]");
+}
+
+TEST(MathOpsTest, SparseSegmentWeightedCombineGrad_ShapeFn) {
+  ShapeInferenceTestOp op("SparseSegmentWeightedCombineGrad");
+  INFER_OK(op, "?;?;?", "?");
+  INFER_OK(op, "[2,4,3];[5];?", "[d1_0,d0_1,d0_2]");
+  INFER_OK(op, "[2,4,3];?;[5]", "[d2_0,d0_1,d0_2]");
+
+  INFER_ERROR("Shape must be rank 1 but is rank 2", op, "[2,4];[5,1];?");
+  INFER_ERROR("Dimension 0 in both shapes must be equal, but are 5 and 6", op,
+              "[2,4];[5];[6]");
+}
+
 TEST(MathOpsTest, BatchMatMul_ShapeFn) {
   ShapeInferenceTestOp op("BatchMatMul");
   auto set_adj = [&op](bool adj_x, bool adj_y) {
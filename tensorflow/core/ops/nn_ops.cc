@@ -498,6 +498,25 @@ value: Any number of dimensions.
 bias: 1-D with size the last dimension of `value`.
 output: Broadcasted sum of `value` and `bias`.
 )doc");
+
+REGISTER_OP("_FusedBiasActivation")
+    .Attr("T: {half, float, double}")
+    .Attr("activation: {'Relu', 'Relu6', 'Tanh', 'Elu'}")
+    .Input("value: T")
+    .Input("bias: T")
+    .Output("output: T")
+    .SetShapeFn(shape_inference::BiasAddShape)
+    .Doc(R"doc(
+Computes `activation(BiasAdd(value, bias))` for NHWC data.
+
+NOTE Do not invoke this operator directly in Python. The grappler op fusion
+optimizer is expected to create these operators.
+
+value: Any number of dimensions.
+bias: 1-D with size the last dimension of `value`.
+output: The activation of the broadcasted sum of `value` and `bias`.
+activation: The activation to apply after adding the bias.
+)doc");
 // --------------------------------------------------------------------------
 
 REGISTER_OP("Conv2D")
@@ -552,6 +571,49 @@ data_format: Specify the data format of the input and output data. With the
         [batch, channels, height, width].
 )doc");
 
+REGISTER_OP("_FusedConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {half, float}")
+    .Attr("num_args: int >= 0")
+    .Attr("strides: list(int)")
+    .Attr("use_cudnn_on_gpu: bool = true")
+    .Attr(GetPaddingAttrString())
+    .Attr("data_format: {'NHWC'} = 'NHWC'")
+    .Attr("fused_ops: list(string) = []")
+    .Attr("epsilon: float = 0.0001")
+    .SetShapeFn(shape_inference::Conv2DShape)
+    .Doc(R"doc(
+Computes a 2-D convolution followed by a per-channel epilogue.
+
+The epilogue is described by `fused_ops`, which lists the ops that were fused
+into the convolution, in order: an optional `BiasAdd`, an optional
+inference-mode `FusedBatchNorm`, and an optional activation (`Relu`, `Relu6`,
+`Tanh` or `Elu`). At least one of `BiasAdd` and `FusedBatchNorm` is required.
+The batch normalization is folded into the filter and the bias, and the bias
+and the activation are applied in one pass over the output of the convolution,
+or by cuDNN's fused convolution when the activation is `Relu` on GPU.
+
+NOTE Do not invoke this operator directly in Python. The grappler op fusion
+optimizer and the `fuse_conv2d_epilogues` graph transform are expected to
+create these operators.
+
+input: 4-D with shape `[batch, in_height, in_width, in_channels]`.
+filter: 4-D with shape
+  `[filter_height, filter_width, in_channels, out_channels]`.
+args: The 1-D inputs of the fused ops, each with `out_channels` elements: the
+  bias of `BiasAdd`, followed by the scale, offset, mean and variance of
+  `FusedBatchNorm`.
+output: 4-D with shape `[batch, out_height, out_width, out_channels]`.
+strides: 1-D tensor of length 4, as for `Conv2D`.
+padding: The type of padding algorithm to use.
+data_format: Only "NHWC" is supported.
+fused_ops: The ops fused into the convolution.
+epsilon: The `epsilon` of the fused `FusedBatchNorm`.
+)doc");
+
 REGISTER_OP("Conv2DBackpropInput")
     .Input("input_sizes: int32")
     .Input("filter: T")
@@ -2419,6 +2481,148 @@ max_output: The float value that the highest quantized output value represents.
 
 )doc");
 
+REGISTER_OP("QuantizedConv2DPerChannel")
+    .Input("input: quint8")
+    .Input("filter: qint8")
+    .Input("bias: float")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_filter: float")
+    .Input("max_filter: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("output: quint8")
+    .Output("min_output: float")
+    .Output("max_output: float")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("activation: {'NONE', 'RELU', 'RELU6'} = 'NONE'")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::Conv2DShape(c));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes a quantized 2D convolution with a range for each output channel.
+
+The filter values are symmetric around zero: the real value of `q` in output
+channel `j` is `q * max(abs(min_filter[j]), abs(max_filter[j])) / 127`. The
+bias is added and the activation is applied to the real-valued results, which
+are then quantized into the requested output range. The products are
+accumulated in 32 bits with AVX-512 VNNI or AVX2 instructions when the CPU
+supports them.
+
+filter: Of shape `[filter_height, filter_width, in_depth, out_depth]`.
+bias: The float bias of each output channel, of shape `[out_depth]`.
+strides: The stride of the sliding window for each dimension of the input
+  tensor.
+padding: The type of padding algorithm to use.
+activation: The activation function applied after the bias.
+min_input: The float value that the lowest quantized input value represents.
+max_input: The float value that the highest quantized input value represents.
+min_filter: The float minimum of the filter values of each output channel,
+  of shape `[out_depth]`, or a scalar for all channels.
+max_filter: The float maximum of the filter values of each output channel,
+  of shape `[out_depth]`, or a scalar for all channels.
+requested_output_min: The float value that the lowest quantized output value
+  should represent. If it is equal to `requested_output_max`, the output range
+  is computed from the results instead.
+requested_output_max: The float value that the highest quantized output value
+  should represent.
+min_output: The float value that the lowest quantized output value represents.
+max_output: The float value that the highest quantized output value represents.
+
+)doc");
+
+REGISTER_OP("BitSerialConv2D")
+    .Input("input: float")
+    .Input("filter: uint8")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_filter: float")
+    .Input("max_filter: float")
+    .Output("output: float")
+    .Attr("num_bits_input: int >= 1")
+    .Attr("narrow_range_input: bool = false")
+    .Attr("narrow_range_filter: bool = false")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &input));
+      ShapeHandle filter;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 5, &filter));
+      std::vector<int32> strides;
+      TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+      if (strides.size() != 4) {
+        return errors::InvalidArgument(
+            "BitSerialConv2D requires the stride attribute to contain 4 "
+            "values, but got: ",
+            strides.size());
+      }
+      Padding padding;
+      TF_RETURN_IF_ERROR(c->GetAttr("padding", &padding));
+      DimensionHandle output_rows;
+      DimensionHandle output_cols;
+      TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+          c, c->Dim(input, 1), c->Dim(filter, 0), strides[1], padding,
+          &output_rows));
+      TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+          c, c->Dim(input, 2), c->Dim(filter, 1), strides[2], padding,
+          &output_cols));
+      c->set_output(0, c->MakeShape({c->Dim(input, 0), output_rows, output_cols,
+                                     c->Dim(filter, 2)}));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes a 2D convolution with a filter of 1 to 8 bit values, bit-serially.
+
+`input` is quantized as FakeQuantWithMinMaxVars(input, min_input, max_input,
+num_bits_input, narrow_range_input) does, and `filter` holds the levels of
+values quantized the same way with `min_filter`, `max_filter` and
+`narrow_range_filter`. The products of the quantized values are computed
+exactly from popcounts of ANDed bit-planes, which for one bit per value is the
+convolution of XNOR networks, and two bits with narrow_range hold ternary
+values. With one bit, which FakeQuantWithMinMaxVars does not support, the two
+levels are the min and the max of the range. As in Conv2D, the padding
+contributes zeros.
+
+input: A 4-D tensor of shape `[batch, in_height, in_width, in_depth]`.
+filter: The levels of a `[filter_height, filter_width, in_depth, out_depth]`
+  filter packed into bit-planes along the input depth, of shape
+  `[filter_height, filter_width, out_depth, num_bits_filter,
+  8 * ceil(in_depth / 64)]`: bit `p` of the level at input depth `d` is bit
+  `d % 8` of `filter[y, x, j, p, d / 8]`. The padding bits are zero.
+min_input: The float value that the lowest quantized input value represents.
+max_input: The float value that the highest quantized input value represents.
+min_filter: The float value that the lowest filter level represents.
+max_filter: The float value that the highest filter level represents.
+output: A 4-D tensor of shape `[batch, out_height, out_width, out_depth]`.
+num_bits_input: The number of bits of the quantized input, at most 8.
+narrow_range_input: Whether the input is quantized into
+  [1; 2^num_bits_input - 1] instead of [0; 2^num_bits_input - 1].
+narrow_range_filter: Whether the filter was quantized into
+  [1; 2^num_bits_filter - 1].
+strides: The stride of the sliding window for each dimension of the input
+  tensor. Only the height and width can be strided.
+padding: The type of padding algorithm to use.
+
+)doc");
+
 REGISTER_OP("QuantizedMaxPool")
     .Input("input: T")
     .Input("min_input: float")
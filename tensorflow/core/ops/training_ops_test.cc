@@ -13,8 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -289,6 +291,57 @@ TEST(TrainingOpsTest, ApplyAdam_ShapeFn) {
   INFER_ERROR(err, op, "?;?;?;?;?;?;?;?;[?];?");
 }
 
+TEST(TrainingOpsTest, MultiApplyMomentum_ShapeFn) {
+  ShapeInferenceTestOp op("MultiApplyMomentum");
+  std::vector<NodeDefBuilder::NodeOut> refs = {{"a", 0, DT_FLOAT_REF},
+                                               {"b", 0, DT_FLOAT_REF}};
+  std::vector<NodeDefBuilder::NodeOut> grads = {{"c", 0, DT_FLOAT},
+                                                {"d", 0, DT_FLOAT}};
+  TF_ASSERT_OK(NodeDefBuilder("test", "MultiApplyMomentum")
+                   .Input(refs)
+                   .Input(refs)
+                   .Input("lr", 0, DT_FLOAT)
+                   .Input(grads)
+                   .Input("momentum", 0, DT_FLOAT)
+                   .Attr("N", 2)
+                   .Finalize(&op.node_def));
+
+  // Output i is a merge of var, accum and grad i.
+  INFER_OK(op, "[1,?];[3];[?,2];?;[];[?,?];[?];[]", "[d0_0,d2_1];[d1_0]");
+  INFER_ERROR("Dimension 0 in both shapes must be equal, but are 3 and 4", op,
+              "?;[3];?;?;[];?;[4];[]");
+
+  // lr and momentum must be scalars.
+  const char err[] = "Shape must be rank 0 but is rank 1";
+  INFER_ERROR(err, op, "?;?;?;?;[?];?;?;?");
+  INFER_ERROR(err, op, "?;?;?;?;?;?;?;[?]");
+}
+
+TEST(TrainingOpsTest, MultiApplyAdam_ShapeFn) {
+  ShapeInferenceTestOp op("MultiApplyAdam");
+  std::vector<NodeDefBuilder::NodeOut> refs = {{"a", 0, DT_FLOAT_REF},
+                                               {"b", 0, DT_FLOAT_REF}};
+  std::vector<NodeDefBuilder::NodeOut> grads = {{"c", 0, DT_FLOAT},
+                                                {"d", 0, DT_FLOAT}};
+  NodeDefBuilder builder("test", "MultiApplyAdam");
+  builder.Input(refs).Input(refs).Input(refs);
+  for (int i = 0; i < 6; ++i) {
+    builder.Input("scalar", 0, DT_FLOAT);
+  }
+  TF_ASSERT_OK(builder.Input(grads).Attr("N", 2).Finalize(&op.node_def));
+
+  // Output i is a merge of var, m, v and grad i.
+  INFER_OK(op, "[1,?,?];[2];[?,3,?];?;?;?;[];[];[];[];[];[];[?,?,4];[?]",
+           "[d0_0,d2_1,d12_2];[d1_0]");
+  INFER_ERROR("Dimension 0 in both shapes must be equal, but are 2 and 5", op,
+              "?;[2];?;?;?;[5];[];[];[];[];[];[];?;?");
+
+  // beta1_power, beta2_power, lr, beta1, beta2, and epsilon must be scalars.
+  const char err[] = "Shape must be rank 0 but is rank 1";
+  INFER_ERROR(err, op, "?;?;?;?;?;?;[?];?;?;?;?;?;?;?");
+  INFER_ERROR(err, op, "?;?;?;?;?;?;?;?;?;?;?;[?];?;?");
+}
+
 TEST(TrainingOpsTest, ApplyRMSProp_ShapeFn) {
   ShapeInferenceTestOp op("ApplyRMSProp");
 
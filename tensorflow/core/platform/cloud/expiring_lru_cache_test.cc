@@ -0,0 +1,114 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/expiring_lru_cache.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FakeEnv : public EnvWrapper {
+ public:
+  FakeEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64 NowSeconds() override { return now; }
+
+  uint64 now = 1;
+};
+
+TEST(ExpiringLRUCacheTest, MaxAge) {
+  const string key = "a";
+  FakeEnv env;
+  ExpiringLRUCache<int> cache(1, 0, &env);
+  cache.Insert(key, 41);
+  // There should be no change in the cache's state if we advance the time
+  // only up to the max age.
+  env.now = 2;
+  int value = 0;
+  EXPECT_TRUE(cache.Lookup(key, &value));
+  EXPECT_EQ(value, 41);
+  // Once we advance the time past the max age, the entry is gone.
+  env.now = 3;
+  EXPECT_FALSE(cache.Lookup(key, &value));
+  // A new insert resets the timestamp.
+  cache.Insert(key, 42);
+  env.now = 4;
+  EXPECT_TRUE(cache.Lookup(key, &value));
+  EXPECT_EQ(value, 42);
+}
+
+TEST(ExpiringLRUCacheTest, MaxAgeZeroDisablesCaching) {
+  ExpiringLRUCache<int> cache(0, 4);
+  cache.Insert("a", 1);
+  int value = 0;
+  EXPECT_FALSE(cache.Lookup("a", &value));
+}
+
+TEST(ExpiringLRUCacheTest, MaxEntries) {
+  ExpiringLRUCache<int> cache(1000, 2);
+  cache.Insert("a", 1);
+  cache.Insert("b", 2);
+  int value = 0;
+  // Touch "a" so that "b" becomes the least recently used entry.
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  cache.Insert("c", 3);
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_EQ(value, 1);
+  EXPECT_FALSE(cache.Lookup("b", &value));
+  EXPECT_TRUE(cache.Lookup("c", &value));
+  EXPECT_EQ(value, 3);
+}
+
+TEST(ExpiringLRUCacheTest, LookupOrCompute) {
+  ExpiringLRUCache<int> cache(1000, 0);
+  int num_computes = 0;
+  auto compute = [&num_computes](const string& key, int* value) {
+    ++num_computes;
+    *value = key.size();
+    return Status::OK();
+  };
+  int value = 0;
+  TF_EXPECT_OK(cache.LookupOrCompute("abc", &value, compute));
+  EXPECT_EQ(value, 3);
+  TF_EXPECT_OK(cache.LookupOrCompute("abc", &value, compute));
+  EXPECT_EQ(value, 3);
+  EXPECT_EQ(num_computes, 1);
+  // Failed computations are not cached.
+  EXPECT_EQ(error::INTERNAL,
+            cache
+                .LookupOrCompute("d", &value,
+                                 [](const string&, int*) {
+                                   return errors::Internal("failed");
+                                 })
+                .code());
+  EXPECT_FALSE(cache.Lookup("d", &value));
+}
+
+TEST(ExpiringLRUCacheTest, DeleteAndClear) {
+  ExpiringLRUCache<int> cache(1000, 0);
+  cache.Insert("a", 1);
+  cache.Insert("b", 2);
+  int value = 0;
+  EXPECT_TRUE(cache.Delete("a"));
+  EXPECT_FALSE(cache.Delete("a"));
+  EXPECT_FALSE(cache.Lookup("a", &value));
+  EXPECT_TRUE(cache.Lookup("b", &value));
+  cache.Clear();
+  EXPECT_FALSE(cache.Lookup("b", &value));
+}
+
+}  // namespace
+}  // namespace tensorflow
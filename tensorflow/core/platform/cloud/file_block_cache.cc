@@ -0,0 +1,204 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <cstring>
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+FileBlockCache::FileBlockCache(size_t block_size, size_t max_bytes,
+                               uint64 max_staleness, int parallel_fetches,
+                               BlockFetcher block_fetcher, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      max_staleness_(max_staleness),
+      parallel_fetches_(parallel_fetches),
+      block_fetcher_(std::move(block_fetcher)),
+      env_(env) {
+  if (parallel_fetches_ > 1) {
+    fetch_pool_.reset(
+        new thread::ThreadPool(env_, "file_block_fetch", parallel_fetches_));
+  }
+}
+
+bool FileBlockCache::IsStale(const Block& block) const {
+  return max_staleness_ > 0 &&
+         env_->NowSeconds() - block.timestamp > max_staleness_;
+}
+
+Status FileBlockCache::Read(const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  if (n == 0) {
+    return Status::OK();
+  }
+  if (block_size_ == 0 || max_bytes_ == 0) {
+    // The cache is effectively disabled, so we pass the read through to the
+    // fetcher without breaking it up into blocks.
+    std::vector<char> out;
+    TF_RETURN_IF_ERROR(block_fetcher_(filename, offset, n, &out));
+    *bytes_transferred = std::min(out.size(), n);
+    std::memcpy(buffer, out.data(), *bytes_transferred);
+    return Status::OK();
+  }
+
+  // Calculate the block-aligned start and end of the read.
+  const size_t start = block_size_ * (offset / block_size_);
+  const size_t finish = offset + n;
+
+  // Collect the blocks covering the range, noting the ones we must fetch.
+  std::vector<std::shared_ptr<Block>> blocks;
+  std::vector<size_t> missing_offsets;
+  std::vector<size_t> missing_indices;
+  {
+    mutex_lock lock(mu_);
+    for (size_t pos = start; pos < finish; pos += block_size_) {
+      const Key key = std::make_pair(filename, pos);
+      auto entry = block_map_.find(key);
+      if (entry != block_map_.end() && !IsStale(*entry->second)) {
+        // Move the block to the front of the LRU list.
+        lru_list_.erase(entry->second->lru_iterator);
+        lru_list_.push_front(key);
+        entry->second->lru_iterator = lru_list_.begin();
+        blocks.push_back(entry->second);
+        if (entry->second->data.size() < block_size_) {
+          // The block is the last one of the file.
+          break;
+        }
+      } else {
+        blocks.emplace_back();
+        missing_offsets.push_back(pos);
+        missing_indices.push_back(blocks.size() - 1);
+      }
+    }
+  }
+
+  if (!missing_offsets.empty()) {
+    std::vector<std::shared_ptr<Block>> fetched;
+    TF_RETURN_IF_ERROR(FetchBlocks(filename, missing_offsets, &fetched));
+    mutex_lock lock(mu_);
+    for (size_t i = 0; i < fetched.size(); ++i) {
+      InsertBlock(std::make_pair(filename, missing_offsets[i]), fetched[i]);
+      blocks[missing_indices[i]] = fetched[i];
+    }
+  }
+
+  // Copy the requested range out of the blocks, stopping at the end of file.
+  size_t pos = start;
+  for (const std::shared_ptr<Block>& block : blocks) {
+    const std::vector<char>& data = block->data;
+    const size_t begin = offset > pos ? offset - pos : 0;
+    if (begin < data.size()) {
+      const size_t bytes_to_copy =
+          std::min(data.size() - begin, n - *bytes_transferred);
+      std::memcpy(buffer + *bytes_transferred, data.data() + begin,
+                  bytes_to_copy);
+      *bytes_transferred += bytes_to_copy;
+    }
+    if (data.size() < block_size_) {
+      // This was the last block of the file.
+      break;
+    }
+    pos += block_size_;
+  }
+  return Status::OK();
+}
+
+Status FileBlockCache::FetchBlocks(
+    const string& filename, const std::vector<size_t>& offsets,
+    std::vector<std::shared_ptr<Block>>* blocks) {
+  const size_t num_blocks = offsets.size();
+  blocks->clear();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    blocks->emplace_back(new Block);
+  }
+  std::vector<Status> statuses(num_blocks);
+  auto fetch = [this, &filename, &offsets, blocks, &statuses](size_t i) {
+    Block* block = (*blocks)[i].get();
+    statuses[i] =
+        block_fetcher_(filename, offsets[i], block_size_, &block->data);
+    block->timestamp = env_->NowSeconds();
+  };
+  if (fetch_pool_ == nullptr || num_blocks == 1) {
+    for (size_t i = 0; i < num_blocks; ++i) {
+      fetch(i);
+      TF_RETURN_IF_ERROR(statuses[i]);
+      if ((*blocks)[i]->data.size() < block_size_) {
+        // There is no point in fetching blocks past the end of the file.
+        blocks->resize(i + 1);
+        break;
+      }
+    }
+    return Status::OK();
+  }
+  BlockingCounter counter(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    fetch_pool_->Schedule([&fetch, &counter, i]() {
+      fetch(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
+void FileBlockCache::InsertBlock(const Key& key,
+                                 const std::shared_ptr<Block>& block) {
+  // Another reader may have fetched the same block concurrently; the newer
+  // copy replaces it.
+  RemoveBlock(key);
+  lru_list_.push_front(key);
+  block->lru_iterator = lru_list_.begin();
+  block_map_.emplace(key, block);
+  cache_size_ += block->data.size();
+  // Evict the least recently used blocks until the cache fits. Readers that
+  // still hold an evicted block keep it alive through their shared pointer.
+  while (!lru_list_.empty() && cache_size_ > max_bytes_) {
+    RemoveBlock(lru_list_.back());
+  }
+}
+
+void FileBlockCache::RemoveBlock(const Key& key) {
+  auto entry = block_map_.find(key);
+  if (entry == block_map_.end()) {
+    return;
+  }
+  cache_size_ -= entry->second->data.size();
+  lru_list_.erase(entry->second->lru_iterator);
+  block_map_.erase(entry);
+}
+
+void FileBlockCache::RemoveFile(const string& filename) {
+  mutex_lock lock(mu_);
+  auto begin = block_map_.lower_bound(std::make_pair(filename, size_t{0}));
+  auto it = begin;
+  for (; it != block_map_.end() && it->first.first == filename; ++it) {
+    cache_size_ -= it->second->data.size();
+    lru_list_.erase(it->second->lru_iterator);
+  }
+  block_map_.erase(begin, it);
+}
+
+size_t FileBlockCache::CacheSize() const {
+  mutex_lock lock(mu_);
+  return cache_size_;
+}
+
+}  // namespace tensorflow
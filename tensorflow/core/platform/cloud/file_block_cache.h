@@ -0,0 +1,141 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief An LRU block cache of file contents, keyed by {filename, offset}.
+///
+/// A single FileBlockCache is shared by all files of a file system, so that
+/// the total amount of cached data is bounded by `max_bytes` no matter how
+/// many files are open. Blocks that are not in the cache are fetched with the
+/// provided `block_fetcher`; when a read spans several uncached blocks, they
+/// are fetched concurrently on up to `parallel_fetches` threads.
+///
+/// This class is thread safe.
+class FileBlockCache {
+ public:
+  /// The callback executed when a block is not found in the cache, and needs
+  /// to be fetched from the backing filesystem. This callback is provided when
+  /// the cache is constructed. The callback may be called concurrently from
+  /// several threads. It should fill `out` with at most `buffer_size` bytes
+  /// read from `filename` starting at `offset`, and return fewer bytes only
+  /// if the end of the file was reached.
+  typedef std::function<Status(const string& filename, size_t offset,
+                               size_t buffer_size, std::vector<char>* out)>
+      BlockFetcher;
+
+  /// Caching is disabled if `block_size` or `max_bytes` is 0, in which case
+  /// every Read() is forwarded to `block_fetcher`. A `max_staleness` of 0
+  /// means that cached blocks never expire.
+  FileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
+                 int parallel_fetches, BlockFetcher block_fetcher,
+                 Env* env = Env::Default());
+
+  /// Reads `n` bytes from `filename` starting at `offset` into `buffer`.
+  ///
+  /// Sets `*bytes_transferred` to the number of bytes copied into `buffer`,
+  /// which is less than `n` only if the end of the file was reached. Blocks
+  /// that are not in the cache (or have expired) are fetched, and the least
+  /// recently used blocks are evicted when the cache grows past `max_bytes`.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred);
+
+  /// Removes all cached blocks for `filename`.
+  void RemoveFile(const string& filename);
+
+  /// Accessors for cache parameters.
+  size_t block_size() const { return block_size_; }
+  size_t max_bytes() const { return max_bytes_; }
+  uint64 max_staleness() const { return max_staleness_; }
+  int parallel_fetches() const { return parallel_fetches_; }
+
+  /// The current size (in bytes) of the cache.
+  size_t CacheSize() const;
+
+ private:
+  /// A block of a file, keyed by the file name and the block's offset.
+  typedef std::pair<string, size_t> Key;
+
+  /// A block of a file.
+  struct Block {
+    /// The block data.
+    std::vector<char> data;
+    /// A list iterator pointing to the block's position in the LRU list.
+    std::list<Key>::iterator lru_iterator;
+    /// The timestamp (seconds since epoch) at which the block was fetched.
+    uint64 timestamp;
+  };
+
+  /// Fetches the blocks at `offsets` of `filename` into `blocks`, running up
+  /// to `parallel_fetches_` fetches at a time.
+  Status FetchBlocks(const string& filename, const std::vector<size_t>& offsets,
+                     std::vector<std::shared_ptr<Block>>* blocks);
+
+  /// Inserts a freshly fetched block and trims the cache to `max_bytes_`.
+  void InsertBlock(const Key& key, const std::shared_ptr<Block>& block)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Removes the block `key` from the cache.
+  void RemoveBlock(const Key& key) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Returns true if `block` is older than `max_staleness_`.
+  bool IsStale(const Block& block) const;
+
+  const size_t block_size_;
+  const size_t max_bytes_;
+  const uint64 max_staleness_;
+  const int parallel_fetches_;
+  const BlockFetcher block_fetcher_;
+  Env* const env_;  // not owned
+
+  /// Threads for concurrent block fetches. Null if `parallel_fetches_` <= 1.
+  std::unique_ptr<thread::ThreadPool> fetch_pool_;
+
+  /// Guards access to the block map, LRU list, and cache size.
+  mutable mutex mu_;
+
+  /// The block map (map from Key to Block). Blocks are shared pointers so
+  /// that a reader can keep using a block after it is evicted.
+  std::map<Key, std::shared_ptr<Block>> block_map_ GUARDED_BY(mu_);
+
+  /// The LRU list of block keys. The front of the list identifies the most
+  /// recently accessed block.
+  std::list<Key> lru_list_ GUARDED_BY(mu_);
+
+  /// The combined number of bytes in all of the cached blocks.
+  size_t cache_size_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FileBlockCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
@@ -0,0 +1,227 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <cstring>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FakeEnv : public EnvWrapper {
+ public:
+  FakeEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64 NowSeconds() override { return now; }
+
+  uint64 now = 1;
+};
+
+// A fetcher over a file of `file_size` bytes whose byte at offset i is
+// 'a' + i % 26. Counts the number of calls made.
+struct FakeFile {
+  explicit FakeFile(size_t file_size) : file_size(file_size) {}
+
+  Status Fetch(const string& filename, size_t offset, size_t n,
+               std::vector<char>* out) {
+    {
+      mutex_lock lock(mu);
+      ++calls;
+    }
+    out->clear();
+    for (size_t i = offset; i < offset + n && i < file_size; ++i) {
+      out->push_back('a' + i % 26);
+    }
+    return Status::OK();
+  }
+
+  FileBlockCache::BlockFetcher Fetcher() {
+    return [this](const string& filename, size_t offset, size_t n,
+                  std::vector<char>* out) {
+      return Fetch(filename, offset, n, out);
+    };
+  }
+
+  const size_t file_size;
+  mutex mu;
+  int calls GUARDED_BY(mu) = 0;
+
+  int num_calls() {
+    mutex_lock lock(mu);
+    return calls;
+  }
+};
+
+string Expected(size_t offset, size_t n) {
+  string result;
+  for (size_t i = offset; i < offset + n; ++i) {
+    result.push_back('a' + i % 26);
+  }
+  return result;
+}
+
+Status ReadCache(FileBlockCache* cache, const string& filename, size_t offset,
+                 size_t n, string* out) {
+  std::vector<char> buffer(n);
+  size_t bytes_transferred = 0;
+  TF_RETURN_IF_ERROR(cache->Read(filename, offset, n, buffer.data(),
+                                 &bytes_transferred));
+  out->assign(buffer.data(), bytes_transferred);
+  return Status::OK();
+}
+
+TEST(FileBlockCacheTest, PassThrough) {
+  FakeFile file(100);
+  FileBlockCache cache(0, 0, 0, 1, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 10, 20, &out));
+  EXPECT_EQ(Expected(10, 20), out);
+  TF_EXPECT_OK(ReadCache(&cache, "f", 10, 20, &out));
+  EXPECT_EQ(2, file.num_calls());
+  EXPECT_EQ(0, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, BlockAlignedAndUnaligned) {
+  FakeFile file(100);
+  FileBlockCache cache(16, 1 << 20, 0, 1, file.Fetcher());
+  string out;
+  // Reads [10, 40), which needs blocks 0, 16 and 32.
+  TF_EXPECT_OK(ReadCache(&cache, "f", 10, 30, &out));
+  EXPECT_EQ(Expected(10, 30), out);
+  EXPECT_EQ(3, file.num_calls());
+  // Everything in [0, 48) is now served from the cache.
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 48, &out));
+  EXPECT_EQ(Expected(0, 48), out);
+  EXPECT_EQ(3, file.num_calls());
+  EXPECT_EQ(48, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, ReadPastEndOfFile) {
+  FakeFile file(40);
+  FileBlockCache cache(16, 1 << 20, 0, 1, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 20, 100, &out));
+  EXPECT_EQ(Expected(20, 20), out);
+  // Blocks 16 and 32 were fetched; block 32 is short, so nothing after it.
+  EXPECT_EQ(2, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 30, 100, &out));
+  EXPECT_EQ(Expected(30, 10), out);
+  EXPECT_EQ(2, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 100, 10, &out));
+  EXPECT_TRUE(out.empty());
+}
+
+TEST(FileBlockCacheTest, LRUEviction) {
+  FakeFile file(100);
+  // Room for exactly two blocks.
+  FileBlockCache cache(16, 32, 0, 1, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 1, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 16, 1, &out));
+  EXPECT_EQ(2, file.num_calls());
+  // Touch block 0, then read block 32, which evicts block 16.
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 1, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 32, 1, &out));
+  EXPECT_EQ(3, file.num_calls());
+  EXPECT_EQ(32, cache.CacheSize());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 1, &out));
+  EXPECT_EQ(3, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 16, 1, &out));
+  EXPECT_EQ(4, file.num_calls());
+}
+
+TEST(FileBlockCacheTest, SharedAcrossFiles) {
+  FakeFile file(100);
+  FileBlockCache cache(16, 32, 0, 1, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f1", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f2", 0, 16, &out));
+  EXPECT_EQ(2, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "f1", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f2", 0, 16, &out));
+  EXPECT_EQ(2, file.num_calls());
+  // A third file evicts the least recently used block, which belongs to f1.
+  TF_EXPECT_OK(ReadCache(&cache, "f3", 0, 16, &out));
+  EXPECT_EQ(32, cache.CacheSize());
+  TF_EXPECT_OK(ReadCache(&cache, "f2", 0, 16, &out));
+  EXPECT_EQ(3, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "f1", 0, 16, &out));
+  EXPECT_EQ(4, file.num_calls());
+}
+
+TEST(FileBlockCacheTest, RemoveFile) {
+  FakeFile file(100);
+  FileBlockCache cache(16, 1 << 20, 0, 1, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 32, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 32, &out));
+  EXPECT_EQ(64, cache.CacheSize());
+  cache.RemoveFile("a");
+  EXPECT_EQ(32, cache.CacheSize());
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 32, &out));
+  EXPECT_EQ(4, file.num_calls());
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 32, &out));
+  EXPECT_EQ(6, file.num_calls());
+}
+
+TEST(FileBlockCacheTest, MaxStaleness) {
+  FakeFile file(100);
+  FakeEnv env;
+  FileBlockCache cache(16, 1 << 20, 2, 1, file.Fetcher(), &env);
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+  env.now = 3;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+  EXPECT_EQ(1, file.num_calls());
+  env.now = 4;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+  EXPECT_EQ(Expected(0, 16), out);
+  EXPECT_EQ(2, file.num_calls());
+  EXPECT_EQ(16, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, ParallelFetches) {
+  FakeFile file(1000);
+  FileBlockCache cache(10, 1 << 20, 0, 4, file.Fetcher());
+  string out;
+  TF_EXPECT_OK(ReadCache(&cache, "f", 5, 990, &out));
+  EXPECT_EQ(Expected(5, 990), out);
+  EXPECT_EQ(100, file.num_calls());
+  EXPECT_EQ(1000, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, FetchError) {
+  int calls = 0;
+  auto fetcher = [&calls](const string& filename, size_t offset, size_t n,
+                          std::vector<char>* out) {
+    ++calls;
+    if (offset == 16) {
+      return errors::Unavailable("transient");
+    }
+    out->assign(n, 'x');
+    return Status::OK();
+  };
+  FileBlockCache cache(16, 1 << 20, 0, 1, fetcher);
+  string out;
+  EXPECT_EQ(error::UNAVAILABLE, ReadCache(&cache, "f", 0, 48, &out).code());
+  // Nothing from the failed read is cached.
+  EXPECT_EQ(0, cache.CacheSize());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <vector>
 #include "include/json/json.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -54,6 +55,31 @@ constexpr uint64 kUploadRetryDelayMicros = 1000000L;
 constexpr uint64 HTTP_CODE_RESUME_INCOMPLETE = 308;
 // The environment variable that overrides the size of the readahead buffer.
 constexpr char kReadaheadBufferSize[] = "GCS_READAHEAD_BUFFER_SIZE_BYTES";
+// The environment variable that overrides the block size for aligned reads
+// from GCS. Specified in MB (e.g. "16" = 16 x 1024 x 1024 = 16777216 bytes).
+constexpr char kBlockSize[] = "GCS_READ_CACHE_BLOCK_SIZE_MB";
+constexpr size_t kDefaultBlockSize = 16 * 1024 * 1024;
+// The environment variable that overrides the max size of the block cache,
+// which is shared by all files. Specified in MB. 0 disables the block cache.
+constexpr char kMaxCacheSize[] = "GCS_READ_CACHE_MAX_SIZE_MB";
+constexpr size_t kDefaultMaxCacheSize = 256 * 1024 * 1024;
+// The environment variable that overrides the maximum staleness of cached
+// file contents. Once any block of a file reaches this staleness, it is
+// refetched. Specified in seconds; 0 means cached blocks never expire.
+constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
+constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the number of concurrent HTTP
+// requests used to fetch the uncached blocks of a single read.
+constexpr char kParallelFetches[] = "GCS_READ_CACHE_PARALLEL_FETCHES";
+constexpr int kDefaultParallelFetches = 8;
+// The environment variable that overrides the maximum age of entries in the
+// Stat cache, in seconds. 0 disables the Stat cache.
+constexpr char kStatCacheMaxAge[] = "GCS_STAT_CACHE_MAX_AGE";
+constexpr uint64 kStatCacheDefaultMaxAge = 5;
+// The environment variable that overrides the maximum number of entries in
+// the Stat cache.
+constexpr char kStatCacheMaxEntries[] = "GCS_STAT_CACHE_MAX_ENTRIES";
+constexpr size_t kStatCacheDefaultMaxEntries = 1024;
 
 // The file statistics returned by Stat() for directories.
 const FileStatistics DIRECTORY_STAT(0, 0, true);
@@ -206,6 +232,16 @@ Status GetBoolValue(const Json::Value& parent, const string& name,
   return Status::OK();
 }
 
+/// Reads an unsigned integer from the environment variable `varname`, if it
+/// is set and parses. Otherwise leaves `*value` unchanged.
+void GetEnvVar(const char* varname, uint64* value) {
+  const char* env_value = std::getenv(varname);
+  uint64 parsed;
+  if (env_value && strings::safe_strtou64(env_value, &parsed)) {
+    *value = parsed;
+  }
+}
+
 /// A GCS-based implementation of a random access file with a read-ahead buffer.
 class GcsRandomAccessFile : public RandomAccessFile {
  public:
@@ -300,6 +336,36 @@ class GcsRandomAccessFile : public RandomAccessFile {
   mutable size_t buffer_start_offset_ GUARDED_BY(mu_) = 0;
 };
 
+/// \brief A GCS-based implementation of a random access file that reads
+/// through the block cache shared by all files of the file system.
+class GcsBlockCachedRandomAccessFile : public RandomAccessFile {
+ public:
+  GcsBlockCachedRandomAccessFile(const string& filename,
+                                 FileBlockCache* file_block_cache)
+      : filename_(filename), file_block_cache_(file_block_cache) {}
+
+  /// The implementation of reads through the block cache. Thread-safe.
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    size_t bytes_transferred;
+    TF_RETURN_IF_ERROR(file_block_cache_->Read(filename_, offset, n, scratch,
+                                               &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      // This is not an error per se. The RandomAccessFile interface expects
+      // that Read returns OutOfRange if fewer bytes were read than requested.
+      return errors::OutOfRange("EOF reached, ", result->size(),
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  const string filename_;
+  FileBlockCache* file_block_cache_;  // not owned
+};
+
 /// \brief GCS-based implementation of a writeable file.
 ///
 /// Since GCS objects are immutable, this implementation writes to a local
@@ -309,13 +375,15 @@ class GcsWritableFile : public WritableFile {
   GcsWritableFile(const string& bucket, const string& object,
                   AuthProvider* auth_provider,
                   HttpRequest::Factory* http_request_factory,
-                  int64 initial_retry_delay_usec)
+                  int64 initial_retry_delay_usec,
+                  std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
         sync_needed_(true),
-        initial_retry_delay_usec_(initial_retry_delay_usec) {
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        file_cache_erase_(std::move(file_cache_erase)) {
     if (GetTmpFilename(&tmp_content_filename_).ok()) {
       outfile_.open(tmp_content_filename_,
                     std::ofstream::binary | std::ofstream::app);
@@ -331,13 +399,15 @@ class GcsWritableFile : public WritableFile {
                   AuthProvider* auth_provider,
                   const string& tmp_content_filename,
                   HttpRequest::Factory* http_request_factory,
-                  int64 initial_retry_delay_usec)
+                  int64 initial_retry_delay_usec,
+                  std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
         sync_needed_(true),
-        initial_retry_delay_usec_(initial_retry_delay_usec) {
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        file_cache_erase_(std::move(file_cache_erase)) {
     tmp_content_filename_ = tmp_content_filename;
     outfile_.open(tmp_content_filename_,
                   std::ofstream::binary | std::ofstream::app);
@@ -373,6 +443,9 @@ class GcsWritableFile : public WritableFile {
       return Status::OK();
     }
     Status status = SyncImpl();
+    // Whether or not the upload succeeded, the object may have changed, so
+    // cached contents and metadata can no longer be trusted.
+    file_cache_erase_();
     if (status.ok()) {
       sync_needed_ = false;
     }
@@ -570,6 +643,7 @@ class GcsWritableFile : public WritableFile {
   HttpRequest::Factory* http_request_factory_;
   bool sync_needed_;  // whether there is buffered data that needs to be synced
   int64 initial_retry_delay_usec_;
+  std::function<void()> file_cache_erase_;
 };
 
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
@@ -589,41 +663,116 @@ GcsFileSystem::GcsFileSystem()
     : auth_provider_(new GoogleAuthProvider()),
       http_request_factory_(new HttpRequest::Factory()) {
   // Apply the sys env override for the readahead buffer size if it's provided.
-  const char* readahead_buffer_size = std::getenv(kReadaheadBufferSize);
-  if (readahead_buffer_size) {
-    uint64 value;
-    if (strings::safe_strtou64(readahead_buffer_size, &value)) {
-      read_ahead_bytes_ = value;
-    }
-  }
+  uint64 value = read_ahead_bytes_;
+  GetEnvVar(kReadaheadBufferSize, &value);
+  read_ahead_bytes_ = value;
+  // Apply the overrides for the block cache and the Stat cache.
+  uint64 block_size = kDefaultBlockSize / (1024 * 1024);
+  GetEnvVar(kBlockSize, &block_size);
+  uint64 max_bytes = kDefaultMaxCacheSize / (1024 * 1024);
+  GetEnvVar(kMaxCacheSize, &max_bytes);
+  uint64 max_staleness = kDefaultMaxStaleness;
+  GetEnvVar(kMaxStaleness, &max_staleness);
+  uint64 parallel_fetches = kDefaultParallelFetches;
+  GetEnvVar(kParallelFetches, &parallel_fetches);
+  file_block_cache_.reset(new FileBlockCache(
+      block_size * 1024 * 1024, max_bytes * 1024 * 1024, max_staleness,
+      parallel_fetches,
+      [this](const string& filename, size_t offset, size_t n,
+             std::vector<char>* out) {
+        return LoadBufferFromGCS(filename, offset, n, out);
+      }));
+  uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
+  GetEnvVar(kStatCacheMaxAge, &stat_cache_max_age);
+  uint64 stat_cache_max_entries = kStatCacheDefaultMaxEntries;
+  GetEnvVar(kStatCacheMaxEntries, &stat_cache_max_entries);
+  stat_cache_.reset(new ExpiringLRUCache<FileStatistics>(
+      stat_cache_max_age, stat_cache_max_entries));
 }
 
 GcsFileSystem::GcsFileSystem(
     std::unique_ptr<AuthProvider> auth_provider,
     std::unique_ptr<HttpRequest::Factory> http_request_factory,
     size_t read_ahead_bytes, int64 initial_retry_delay_usec)
+    : GcsFileSystem(std::move(auth_provider), std::move(http_request_factory),
+                    read_ahead_bytes, 0 /* block size */, 0 /* max bytes */,
+                    0 /* max staleness */, 1 /* parallel fetches */,
+                    0 /* stat cache max age */, 0 /* stat cache max entries */,
+                    initial_retry_delay_usec) {}
+
+GcsFileSystem::GcsFileSystem(
+    std::unique_ptr<AuthProvider> auth_provider,
+    std::unique_ptr<HttpRequest::Factory> http_request_factory,
+    size_t read_ahead_bytes, size_t block_size, size_t max_bytes,
+    uint64 max_staleness, int parallel_fetches, uint64 stat_cache_max_age,
+    size_t stat_cache_max_entries, int64 initial_retry_delay_usec)
     : auth_provider_(std::move(auth_provider)),
       http_request_factory_(std::move(http_request_factory)),
       read_ahead_bytes_(read_ahead_bytes),
-      initial_retry_delay_usec_(initial_retry_delay_usec) {}
+      initial_retry_delay_usec_(initial_retry_delay_usec),
+      file_block_cache_(new FileBlockCache(
+          block_size, max_bytes, max_staleness, parallel_fetches,
+          [this](const string& filename, size_t offset, size_t n,
+                 std::vector<char>* out) {
+            return LoadBufferFromGCS(filename, offset, n, out);
+          })),
+      stat_cache_(new ExpiringLRUCache<FileStatistics>(
+          stat_cache_max_age, stat_cache_max_entries)) {}
+
+bool GcsFileSystem::UseBlockCache() const {
+  return file_block_cache_->block_size() > 0 &&
+         file_block_cache_->max_bytes() > 0;
+}
 
 Status GcsFileSystem::NewRandomAccessFile(
     const string& fname, std::unique_ptr<RandomAccessFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
-  result->reset(new GcsRandomAccessFile(bucket, object, auth_provider_.get(),
-                                        http_request_factory_.get(),
-                                        read_ahead_bytes_));
+  if (UseBlockCache()) {
+    result->reset(
+        new GcsBlockCachedRandomAccessFile(fname, file_block_cache_.get()));
+  } else {
+    result->reset(new GcsRandomAccessFile(bucket, object, auth_provider_.get(),
+                                          http_request_factory_.get(),
+                                          read_ahead_bytes_));
+  }
+  return Status::OK();
+}
+
+// A helper function to actually read the data from GCS.
+Status GcsFileSystem::LoadBufferFromGCS(const string& filename, size_t offset,
+                                        size_t n, std::vector<char>* out) {
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseGcsPath(filename, false, &bucket, &object));
+
+  string auth_token;
+  TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_.get(), &auth_token));
+
+  std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+  TF_RETURN_IF_ERROR(request->Init());
+  TF_RETURN_IF_ERROR(
+      request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket,
+                                      "/", request->EscapeString(object))));
+  TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+  TF_RETURN_IF_ERROR(request->SetRange(offset, offset + n - 1));
+  out->reserve(n);
+  TF_RETURN_IF_ERROR(request->SetResultBuffer(out));
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading ", filename);
   return Status::OK();
 }
 
+void GcsFileSystem::ClearFileCaches(const string& fname) {
+  file_block_cache_->RemoveFile(fname);
+  stat_cache_->Delete(fname);
+}
+
 Status GcsFileSystem::NewWritableFile(const string& fname,
                                       std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
-  result->reset(new GcsWritableFile(bucket, object, auth_provider_.get(),
-                                    http_request_factory_.get(),
-                                    initial_retry_delay_usec_));
+  result->reset(new GcsWritableFile(
+      bucket, object, auth_provider_.get(), http_request_factory_.get(),
+      initial_retry_delay_usec_, [this, fname]() { ClearFileCaches(fname); }));
   return Status::OK();
 }
 
@@ -663,7 +812,8 @@ Status GcsFileSystem::NewAppendableFile(const string& fname,
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
   result->reset(new GcsWritableFile(
       bucket, object, auth_provider_.get(), old_content_filename,
-      http_request_factory_.get(), initial_retry_delay_usec_));
+      http_request_factory_.get(), initial_retry_delay_usec_,
+      [this, fname]() { ClearFileCaches(fname); }));
   return Status::OK();
 }
 
@@ -733,36 +883,41 @@ Status GcsFileSystem::StatForObject(const string& bucket, const string& object,
     return errors::InvalidArgument("'object' must be a non-empty string.");
   }
 
-  string auth_token;
-  TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_.get(), &auth_token));
-
-  std::vector<char> output_buffer;
-  std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
-  TF_RETURN_IF_ERROR(request->Init());
-  TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
-      kGcsUriBase, "b/", bucket, "/o/", request->EscapeString(object),
-      "?fields=size%2Cupdated")));
-  TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
-  TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(
-      request->Send(), " when reading metadata of gs://", bucket, "/", object);
+  auto compute_func = [this, &bucket, &object](const string& fname,
+                                               FileStatistics* stat) {
+    string auth_token;
+    TF_RETURN_IF_ERROR(
+        AuthProvider::GetToken(auth_provider_.get(), &auth_token));
 
-  StringPiece response_piece =
-      StringPiece(output_buffer.data(), output_buffer.size());
-  Json::Value root;
-  TF_RETURN_IF_ERROR(ParseJson(response_piece, &root));
+    std::vector<char> output_buffer;
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
+        kGcsUriBase, "b/", bucket, "/o/", request->EscapeString(object),
+        "?fields=size%2Cupdated")));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(),
+                                    " when reading metadata of ", fname);
 
-  // Parse file size.
-  TF_RETURN_IF_ERROR(GetInt64Value(root, "size", &(stat->length)));
+    StringPiece response_piece =
+        StringPiece(output_buffer.data(), output_buffer.size());
+    Json::Value root;
+    TF_RETURN_IF_ERROR(ParseJson(response_piece, &root));
 
-  // Parse file modification time.
-  string updated;
-  TF_RETURN_IF_ERROR(GetStringValue(root, "updated", &updated));
-  TF_RETURN_IF_ERROR(ParseRfc3339Time(updated, &(stat->mtime_nsec)));
+    // Parse file size.
+    TF_RETURN_IF_ERROR(GetInt64Value(root, "size", &(stat->length)));
 
-  stat->is_directory = false;
+    // Parse file modification time.
+    string updated;
+    TF_RETURN_IF_ERROR(GetStringValue(root, "updated", &updated));
+    TF_RETURN_IF_ERROR(ParseRfc3339Time(updated, &(stat->mtime_nsec)));
 
-  return Status::OK();
+    stat->is_directory = false;
+    return Status::OK();
+  };
+  return stat_cache_->LookupOrCompute(
+      strings::StrCat("gs://", bucket, "/", object), stat, compute_func);
 }
 
 Status GcsFileSystem::BucketExists(const string& bucket, bool* result) {
@@ -1005,6 +1160,7 @@ Status GcsFileSystem::DeleteFile(const string& fname) {
   TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
   TF_RETURN_IF_ERROR(request->SetDeleteRequest());
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when deleting ", fname);
+  ClearFileCaches(fname);
   return Status::OK();
 }
 
@@ -1100,6 +1256,8 @@ Status GcsFileSystem::RenameObject(const string& src, const string& target) {
   TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when renaming ", src,
                                   " to ", target);
+  // The target object was overwritten, so its cached data is stale.
+  ClearFileCaches(target);
 
   Json::Value root;
   StringPiece response_piece =
@@ -20,6 +20,8 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/cloud/auth_provider.h"
+#include "tensorflow/core/platform/cloud/expiring_lru_cache.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
 #include "tensorflow/core/platform/cloud/retrying_file_system.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -36,6 +38,22 @@ class GcsFileSystem : public FileSystem {
   GcsFileSystem(std::unique_ptr<AuthProvider> auth_provider,
                 std::unique_ptr<HttpRequest::Factory> http_request_factory,
                 size_t read_ahead_bytes, int64 initial_retry_delay_usec);
+  /// \brief Constructs a file system that caches file blocks and metadata.
+  ///
+  /// Random access files read through a block cache of `max_bytes` bytes
+  /// shared by all files, made of `block_size`-byte blocks that expire after
+  /// `max_staleness` seconds (never if 0). Uncached blocks of a single read
+  /// are fetched on up to `parallel_fetches` concurrent HTTP requests. If
+  /// `block_size` or `max_bytes` is 0, files use a per-file read-ahead
+  /// buffer of `read_ahead_bytes` instead. Object metadata is cached for
+  /// `stat_cache_max_age` seconds (not at all if 0), for at most
+  /// `stat_cache_max_entries` objects.
+  GcsFileSystem(std::unique_ptr<AuthProvider> auth_provider,
+                std::unique_ptr<HttpRequest::Factory> http_request_factory,
+                size_t read_ahead_bytes, size_t block_size, size_t max_bytes,
+                uint64 max_staleness, int parallel_fetches,
+                uint64 stat_cache_max_age, size_t stat_cache_max_entries,
+                int64 initial_retry_delay_usec);
 
   Status NewRandomAccessFile(
       const string& filename,
@@ -75,6 +93,12 @@ class GcsFileSystem : public FileSystem {
   Status DeleteRecursively(const string& dirname, int64* undeleted_files,
                            int64* undeleted_dirs) override;
   size_t get_readahead_buffer_size() const { return read_ahead_bytes_; }
+  size_t block_size() const { return file_block_cache_->block_size(); }
+  size_t max_bytes() const { return file_block_cache_->max_bytes(); }
+  uint64 max_staleness() const { return file_block_cache_->max_staleness(); }
+  int parallel_fetches() const { return file_block_cache_->parallel_fetches(); }
+  uint64 stat_cache_max_age() const { return stat_cache_->max_age(); }
+  size_t stat_cache_max_entries() const { return stat_cache_->max_entries(); }
 
  private:
   /// \brief Checks if the bucket exists. Returns OK if the check succeeded.
@@ -108,6 +132,17 @@ class GcsFileSystem : public FileSystem {
                        FileStatistics* stat);
   Status RenameObject(const string& src, const string& target);
 
+  /// Returns true if random access files read through the block cache.
+  bool UseBlockCache() const;
+
+  /// Loads up to `n` bytes of `filename` starting at `offset` into `out`.
+  /// This is the block fetcher of `file_block_cache_`.
+  Status LoadBufferFromGCS(const string& filename, size_t offset, size_t n,
+                           std::vector<char>* out);
+
+  /// Drops cached blocks and metadata of `fname` after it was modified.
+  void ClearFileCaches(const string& fname);
+
   std::unique_ptr<AuthProvider> auth_provider_;
   std::unique_ptr<HttpRequest::Factory> http_request_factory_;
 
@@ -118,6 +153,12 @@ class GcsFileSystem : public FileSystem {
   // The initial delay for exponential backoffs when retrying failed calls.
   const int64 initial_retry_delay_usec_ = 1000000L;
 
+  // The block cache shared by all random access files of this file system.
+  std::unique_ptr<FileBlockCache> file_block_cache_;
+
+  // Caches the results of StatForObject, keyed by the GCS path.
+  std::unique_ptr<ExpiringLRUCache<FileStatistics>> stat_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GcsFileSystem);
 };
 
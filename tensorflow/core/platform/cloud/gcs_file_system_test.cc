@@ -192,6 +192,77 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_WithReadAhead) {
   EXPECT_EQ("0123", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
+  // Our underlying file in this test is a 15 byte file with contents
+  // "0123456789abcde".
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-8\n",
+           "012345678"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 9-17\n",
+           "9abcde"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 18-26\n",
+           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* read ahead bytes */, 9 /* block size */, 18 /* max bytes */,
+      0 /* max staleness */, 1 /* parallel fetches */,
+      0 /* stat cache max age */, 0 /* stat cache max entries */,
+      0 /* initial retry delay */);
+
+  char scratch[100];
+  StringPiece result;
+  {
+    // We are instantiating this in an enclosed scope to make sure after the
+    // unique ptr goes out of scope, we can still access result.
+    std::unique_ptr<RandomAccessFile> file;
+    TF_EXPECT_OK(
+        fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+
+    // Read the first chunk. The cache will be populated with the first block
+    // of 9 bytes.
+    scratch[5] = 'x';
+    TF_EXPECT_OK(file->Read(0, 4, &result, scratch));
+    EXPECT_EQ("0123", result);
+    EXPECT_EQ(scratch[5], 'x');  // Make sure we only copied 4 bytes.
+
+    // The second chunk will be fully loaded from the cache, no requests are
+    // made.
+    TF_EXPECT_OK(file->Read(4, 4, &result, scratch));
+    EXPECT_EQ("4567", result);
+
+    // The chunk is only partially cached -- the second block is loaded.
+    TF_EXPECT_OK(file->Read(6, 5, &result, scratch));
+    EXPECT_EQ("6789a", result);
+
+    // The range can only be partially satisfied, as the second block is the
+    // last one of the file. No request is made.
+    EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+              file->Read(6, 10, &result, scratch).code());
+    EXPECT_EQ("6789abcde", result);
+
+    // The range starts past the end of the file. The block is fetched, but
+    // it is empty.
+    EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+              file->Read(20, 10, &result, scratch).code());
+    EXPECT_TRUE(result.empty());
+
+    // The first block is still cached.
+    TF_EXPECT_OK(file->Read(0, 4, &result, scratch));
+  }
+  EXPECT_EQ("0123", result);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_NoObjectName) {
   std::vector<HttpRequest*> requests;
   GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
@@ -1217,6 +1288,53 @@ TEST(GcsFileSystemTest, Stat_Object) {
   EXPECT_FALSE(stat.is_directory);
 }
 
+TEST(GcsFileSystemTest, Stat_Cache) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "file.txt?fields=size%2Cupdated\n"
+           "Auth Token: fake_token\n",
+           strings::StrCat("{\"size\": \"1010\","
+                           "\"updated\": \"2016-04-29T23:15:24.896Z\"}")),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b"
+                           "/bucket/o/file.txt\n"
+                           "Auth Token: fake_token\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "file.txt?fields=size%2Cupdated\n"
+           "Auth Token: fake_token\n",
+           "", errors::NotFound("404"), 404),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o?"
+           "fields=items%2Fname%2CnextPageToken&prefix=file.txt%2F"
+           "&maxResults=1\n"
+           "Auth Token: fake_token\n",
+           "{}")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* read ahead bytes */, 0 /* block size */, 0 /* max bytes */,
+      0 /* max staleness */, 1 /* parallel fetches */,
+      3600 /* stat cache max age */, 0 /* stat cache max entries */,
+      0 /* initial retry delay */);
+
+  // Repeated lookups of the same object issue a single request.
+  for (int i = 0; i < 10; i++) {
+    FileStatistics stat;
+    TF_EXPECT_OK(fs.Stat("gs://bucket/file.txt", &stat));
+    EXPECT_EQ(1010, stat.length);
+    EXPECT_FALSE(stat.is_directory);
+  }
+  // Deleting the object drops its cached metadata.
+  TF_EXPECT_OK(fs.DeleteFile("gs://bucket/file.txt"));
+  FileStatistics stat;
+  EXPECT_EQ(errors::Code::NOT_FOUND,
+            fs.Stat("gs://bucket/file.txt", &stat).code());
+}
+
 TEST(GcsFileSystemTest, Stat_Folder) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -1626,5 +1744,29 @@ TEST(GcsFileSystemTest, OverrideReadaheadBufferSize) {
   EXPECT_EQ(123456789L, fs2.get_readahead_buffer_size());
 }
 
+TEST(GcsFileSystemTest, OverrideCacheParameters) {
+  GcsFileSystem fs1;
+  EXPECT_EQ(16 * 1024 * 1024, fs1.block_size());
+  EXPECT_EQ(256 * 1024 * 1024, fs1.max_bytes());
+  EXPECT_EQ(0, fs1.max_staleness());
+  EXPECT_EQ(8, fs1.parallel_fetches());
+  EXPECT_EQ(5, fs1.stat_cache_max_age());
+  EXPECT_EQ(1024, fs1.stat_cache_max_entries());
+
+  setenv("GCS_READ_CACHE_BLOCK_SIZE_MB", "1", 1);
+  setenv("GCS_READ_CACHE_MAX_SIZE_MB", "16", 1);
+  setenv("GCS_READ_CACHE_MAX_STALENESS", "60", 1);
+  setenv("GCS_READ_CACHE_PARALLEL_FETCHES", "2", 1);
+  setenv("GCS_STAT_CACHE_MAX_AGE", "0", 1);
+  setenv("GCS_STAT_CACHE_MAX_ENTRIES", "32", 1);
+  GcsFileSystem fs2;
+  EXPECT_EQ(1024 * 1024, fs2.block_size());
+  EXPECT_EQ(16 * 1024 * 1024, fs2.max_bytes());
+  EXPECT_EQ(60, fs2.max_staleness());
+  EXPECT_EQ(2, fs2.parallel_fetches());
+  EXPECT_EQ(0, fs2.stat_cache_max_age());
+  EXPECT_EQ(32, fs2.stat_cache_max_entries());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -34,6 +34,18 @@ constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
 // software can change it dynamically.
 int NumSchedulableCPUs();
 
+// The NUMA node of a thread or allocation that has no NUMA affinity.
+constexpr int kNUMANoAffinity = -1;
+
+// Returns the number of NUMA nodes of the host, or 1 if the NUMA topology
+// is unknown.
+int NUMANumNodes();
+
+// Restricts the calling thread to the CPUs of NUMA node "node". Returns
+// false, leaving the affinity of the thread unchanged, if the topology is
+// unknown or "node" is not a valid node.
+bool NUMASetThreadNodeAffinity(int node);
+
 // Mostly ISA related features that we care about
 enum CPUFeature {
   // Do not change numeric assignments.
@@ -88,6 +100,7 @@ enum CPUFeature {
   AVX512IFMA = 35,     // Integer multiply-add
   AVX512_4VNNIW = 36,  // Integer neural network
   AVX512_4FMAPS = 37,  // Floating point neural network
+  AVX512_VNNI = 38,    // Integer dot products (e.g. VPDPBUSD), Cascade Lake
 };
 
 // Checks whether the current processor supports one of the features above.
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdlib>
 
 #include <algorithm>
+#include <map>
 #include <vector>
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
@@ -30,6 +31,7 @@ namespace testing {
 
 static std::vector<Benchmark*>* all_benchmarks = nullptr;
 static std::string label;
+static std::map<string, double>* extras = new std::map<string, double>;
 static int64 bytes_processed;
 static int64 items_processed;
 static int64 accum_time = 0;
@@ -175,6 +177,11 @@ void Benchmark::Run(const char* pattern) {
                  (items_processed * 1e-6) / seconds);
         full_label += buf;
       }
+      for (const auto& extra : *extras) {
+        snprintf(buf, sizeof(buf), " %s=%.4g", extra.first.c_str(),
+                 extra.second);
+        full_label += buf;
+      }
       printf("%-*s %10.0f %10d\t%s\n", width, name.c_str(),
              seconds * 1e9 / iters, iters, full_label.c_str());
 
@@ -190,6 +197,13 @@ void Benchmark::Run(const char* pattern) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
       }
+      for (const auto& extra : *extras) {
+        s = reporter.SetProperty(extra.first, extra.second);
+        if (!s.ok()) {
+          LOG(ERROR) << s.ToString();
+          exit(EXIT_FAILURE);
+        }
+      }
       s = reporter.Close();
       if (!s.ok()) {
         LOG(ERROR) << s.ToString();
@@ -216,6 +230,7 @@ void Benchmark::Run(int arg1, int arg2, int* run_count, double* run_seconds) {
     bytes_processed = -1;
     items_processed = -1;
     label.clear();
+    extras->clear();
     if (fn0_) {
       (*fn0_)(iters);
     } else if (fn1_) {
@@ -246,6 +261,7 @@ void Benchmark::Run(int arg1, int arg2, int* run_count, double* run_seconds) {
 // benchmark_min_time, etc).
 void RunBenchmarks() { Benchmark::Run("all"); }
 void SetLabel(const std::string& l) { label = l; }
+void SetExtra(const string& key, double value) { (*extras)[key] = value; }
 void BytesProcessed(int64 n) { bytes_processed = n; }
 void ItemsProcessed(int64 n) { items_processed = n; }
 void StartTiming() {
@@ -17,8 +17,11 @@ limitations under the License.
 
 #include <errno.h>
 
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -29,6 +32,53 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The environment variable that overrides the size of the per-file
+// read-ahead buffer, in bytes. 0 disables read-ahead.
+constexpr char kReadaheadBufferSize[] = "HDFS_READAHEAD_BUFFER_SIZE_BYTES";
+constexpr size_t kDefaultReadaheadBufferSize = 256 * 1024;
+// The environment variable that overrides the number of threads used to fetch
+// the HDFS blocks of a single Read in parallel. Each block is usually served
+// by a different DataNode. 0 or 1 disables parallel fetches.
+constexpr char kParallelFetches[] = "HDFS_READ_PARALLEL_FETCHES";
+constexpr uint64 kDefaultParallelFetches = 4;
+// The environment variable that enables short-circuit local reads, which let
+// a client colocated with a DataNode read block files directly from the local
+// disk. The DataNodes must be configured for it as well, and
+// HDFS_DOMAIN_SOCKET_PATH must name the DataNodes' dfs.domain.socket.path
+// unless it is already set in the client's hdfs-site.xml.
+constexpr char kShortCircuitRead[] = "HDFS_READ_SHORT_CIRCUIT";
+constexpr char kDomainSocketPath[] = "HDFS_DOMAIN_SOCKET_PATH";
+// The environment variable holding extra comma-separated key=value client
+// configuration options, e.g.
+// "dfs.client.read.shortcircuit.skip.checksum=true".
+constexpr char kClientConf[] = "HDFS_CLIENT_CONF";
+// The environment variable naming a libhdfs-compatible client library to load
+// instead of $HADOOP_HDFS_HOME/lib/native/libhdfs.so, e.g. libhdfs3.so.
+constexpr char kClientLibrary[] = "HDFS_CLIENT_LIBRARY";
+
+// Helper function to extract an environment variable and convert it into a
+// uint64.
+bool GetEnvVar(const char* varname, uint64* value) {
+  const char* env_value = std::getenv(varname);
+  if (!env_value) {
+    return false;
+  }
+  return strings::safe_strtou64(env_value, value);
+}
+
+bool GetEnvBool(const char* varname) {
+  const char* env_value = std::getenv(varname);
+  if (!env_value) {
+    return false;
+  }
+  const string value = str_util::Lowercase(env_value);
+  return value == "1" || value == "true";
+}
+
+}  // namespace
+
 template <typename R, typename... Args>
 Status BindFunc(void* handle, const char* name,
                 std::function<R(Args...)>* func) {
@@ -57,6 +107,8 @@ class LibHDFS {
   std::function<hdfsFS(hdfsBuilder*)> hdfsBuilderConnect;
   std::function<hdfsBuilder*()> hdfsNewBuilder;
   std::function<void(hdfsBuilder*, const char*)> hdfsBuilderSetNameNode;
+  std::function<int(hdfsBuilder*, const char*, const char*)>
+      hdfsBuilderConfSetStr;
   std::function<int(const char*, char**)> hdfsConfGetStr;
   std::function<void(hdfsBuilder*, const char* kerbTicketCachePath)>
       hdfsBuilderSetKerbTicketCachePath;
@@ -85,6 +137,7 @@ class LibHDFS {
       BIND_HDFS_FUNC(hdfsBuilderConnect);
       BIND_HDFS_FUNC(hdfsNewBuilder);
       BIND_HDFS_FUNC(hdfsBuilderSetNameNode);
+      BIND_HDFS_FUNC(hdfsBuilderConfSetStr);
       BIND_HDFS_FUNC(hdfsConfGetStr);
       BIND_HDFS_FUNC(hdfsBuilderSetKerbTicketCachePath);
       BIND_HDFS_FUNC(hdfsCloseFile);
@@ -111,6 +164,11 @@ class LibHDFS {
 #else
     const char* kLibHdfsDso = "libhdfs.so";
 #endif
+    const char* client_library = getenv(kClientLibrary);
+    if (client_library != nullptr) {
+      status_ = TryLoadAndBind(client_library, &handle_);
+      return;
+    }
     char* hdfs_home = getenv("HADOOP_HDFS_HOME");
     if (hdfs_home == nullptr) {
       status_ = errors::FailedPrecondition(
@@ -130,7 +188,18 @@ class LibHDFS {
   void* handle_ = nullptr;
 };
 
-HadoopFileSystem::HadoopFileSystem() : hdfs_(LibHDFS::Load()) {}
+HadoopFileSystem::HadoopFileSystem()
+    : hdfs_(LibHDFS::Load()), read_ahead_bytes_(kDefaultReadaheadBufferSize) {
+  uint64 value = read_ahead_bytes_;
+  GetEnvVar(kReadaheadBufferSize, &value);
+  read_ahead_bytes_ = value;
+  uint64 parallel_fetches = kDefaultParallelFetches;
+  GetEnvVar(kParallelFetches, &parallel_fetches);
+  if (parallel_fetches > 1) {
+    fetch_pool_.reset(new thread::ThreadPool(Env::Default(), "hdfs_fetch",
+                                             parallel_fetches));
+  }
+}
 
 HadoopFileSystem::~HadoopFileSystem() {}
 
@@ -144,6 +213,22 @@ Status HadoopFileSystem::Connect(StringPiece fname, hdfsFS* fs) {
   io::ParseURI(fname, &scheme, &namenode, &path);
   const string nn = namenode.ToString();
 
+  // hdfsBuilderConfSetStr keeps pointers to the keys and values, so they must
+  // outlive the builder.
+  std::vector<std::pair<string, string>> client_conf;
+  char* client_conf_str = getenv(kClientConf);
+  if (client_conf_str != nullptr) {
+    for (const string& option :
+         str_util::Split(client_conf_str, ',', str_util::SkipEmpty())) {
+      const size_t eq = option.find('=');
+      if (eq == string::npos) {
+        return errors::InvalidArgument("Malformed ", kClientConf, " option '",
+                                       option, "', expected key=value");
+      }
+      client_conf.emplace_back(option.substr(0, eq), option.substr(eq + 1));
+    }
+  }
+
   hdfsBuilder* builder = hdfs_->hdfsNewBuilder();
   if (scheme == "file") {
     hdfs_->hdfsBuilderSetNameNode(builder, nullptr);
@@ -168,6 +253,19 @@ Status HadoopFileSystem::Connect(StringPiece fname, hdfsFS* fs) {
   if (ticket_cache_path != nullptr) {
     hdfs_->hdfsBuilderSetKerbTicketCachePath(builder, ticket_cache_path);
   }
+  if (GetEnvBool(kShortCircuitRead)) {
+    hdfs_->hdfsBuilderConfSetStr(builder, "dfs.client.read.shortcircuit",
+                                 "true");
+  }
+  char* domain_socket_path = getenv(kDomainSocketPath);
+  if (domain_socket_path != nullptr) {
+    hdfs_->hdfsBuilderConfSetStr(builder, "dfs.domain.socket.path",
+                                 domain_socket_path);
+  }
+  for (const auto& option : client_conf) {
+    hdfs_->hdfsBuilderConfSetStr(builder, option.first.c_str(),
+                                 option.second.c_str());
+  }
   *fs = hdfs_->hdfsBuilderConnect(builder);
   if (*fs == nullptr) {
     return errors::NotFound(strerror(errno));
@@ -184,31 +282,143 @@ string HadoopFileSystem::TranslateName(const string& name) const {
 class HDFSRandomAccessFile : public RandomAccessFile {
  public:
   HDFSRandomAccessFile(const string& filename, const string& hdfs_filename,
-                       LibHDFS* hdfs, hdfsFS fs, hdfsFile file)
+                       LibHDFS* hdfs, hdfsFS fs, hdfsFile file,
+                       size_t read_ahead_bytes, uint64 block_size,
+                       thread::ThreadPool* fetch_pool)
       : filename_(filename),
         hdfs_filename_(hdfs_filename),
         hdfs_(hdfs),
         fs_(fs),
-        file_(file) {}
+        read_ahead_bytes_(read_ahead_bytes),
+        block_size_(block_size),
+        fetch_pool_(fetch_pool),
+        file_(WrapFile(file)) {}
 
-  ~HDFSRandomAccessFile() override {
-    if (file_ != nullptr) {
-      mutex_lock lock(mu_);
-      hdfs_->hdfsCloseFile(fs_, file_);
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    if (read_ahead_bytes_ == 0) {
+      return ReadFromFile(offset, n, result, scratch);
+    }
+    mutex_lock l(buffer_mu_);
+    size_t copied = 0;
+    const uint64 buffer_end = buffer_start_offset_ + buffer_.size();
+    if (offset >= buffer_start_offset_ && offset < buffer_end) {
+      // Serve the buffered prefix of the request from memory.
+      copied = std::min<uint64>(n, buffer_end - offset);
+      memcpy(scratch, buffer_.data() + offset - buffer_start_offset_, copied);
+    }
+    if (copied < n) {
+      // Refill the buffer with the rest of the request plus the read-ahead.
+      // Data that was past EOF when the buffer was filled is always fetched
+      // again, since the file may have grown since.
+      const uint64 fill_offset = offset + copied;
+      buffer_.resize(n - copied + read_ahead_bytes_);
+      StringPiece filled;
+      Status s =
+          ReadFromFile(fill_offset, buffer_.size(), &filled, &buffer_[0]);
+      if (!s.ok() && !errors::IsOutOfRange(s)) {
+        buffer_.clear();
+        return s;
+      }
+      buffer_.resize(filled.size());
+      buffer_start_offset_ = fill_offset;
+      const size_t to_copy = std::min(n - copied, buffer_.size());
+      memcpy(scratch + copied, buffer_.data(), to_copy);
+      copied += to_copy;
+    }
+    *result = StringPiece(scratch, copied);
+    if (copied < n) {
+      return errors::OutOfRange("Read less bytes than requested");
     }
+    return Status::OK();
   }
 
-  Status Read(uint64 offset, size_t n, StringPiece* result,
-              char* scratch) const override {
+ private:
+  // Closes the file once the last reader holding it is done.
+  std::shared_ptr<hdfsFile_internal> WrapFile(hdfsFile file) const {
+    LibHDFS* hdfs = hdfs_;
+    hdfsFS fs = fs_;
+    return std::shared_ptr<hdfsFile_internal>(file, [hdfs, fs](hdfsFile f) {
+      if (hdfs->hdfsCloseFile(fs, f) != 0) {
+        LOG(WARNING) << "Failed to close HDFS file: " << strerror(errno);
+      }
+    });
+  }
+
+  // Reads [offset, offset + n) into scratch. A read spanning several HDFS
+  // blocks is split at the block boundaries and the blocks, which are usually
+  // stored on different DataNodes, are fetched in parallel.
+  Status ReadFromFile(uint64 offset, size_t n, StringPiece* result,
+                      char* scratch) const {
+    if (fetch_pool_ == nullptr || block_size_ == 0 ||
+        offset / block_size_ == (offset + n - 1) / block_size_ || n == 0) {
+      size_t bytes_read = 0;
+      Status s = PreadFully(offset, n, scratch, &bytes_read);
+      *result = StringPiece(scratch, bytes_read);
+      return s;
+    }
+    struct Piece {
+      uint64 offset;
+      size_t n;
+      size_t bytes_read = 0;
+      Status status;
+    };
+    std::vector<Piece> pieces;
+    for (uint64 start = offset; start < offset + n;) {
+      const uint64 end =
+          std::min<uint64>((start / block_size_ + 1) * block_size_, offset + n);
+      Piece piece;
+      piece.offset = start;
+      piece.n = end - start;
+      pieces.push_back(piece);
+      start = end;
+    }
+    auto fetch = [this, offset, scratch](Piece* piece) {
+      piece->status = PreadFully(piece->offset, piece->n,
+                                 scratch + (piece->offset - offset),
+                                 &piece->bytes_read);
+    };
+    BlockingCounter counter(pieces.size() - 1);
+    for (size_t i = 1; i < pieces.size(); ++i) {
+      Piece* piece = &pieces[i];
+      fetch_pool_->Schedule([&fetch, &counter, piece]() {
+        fetch(piece);
+        counter.DecrementCount();
+      });
+    }
+    fetch(&pieces[0]);
+    counter.Wait();
+    // The result is the contiguous prefix that was read successfully.
+    size_t bytes_read = 0;
     Status s;
-    char* dst = scratch;
+    for (const Piece& piece : pieces) {
+      bytes_read += piece.bytes_read;
+      if (!piece.status.ok()) {
+        s = piece.status;
+        break;
+      }
+    }
+    *result = StringPiece(scratch, bytes_read);
+    return s;
+  }
+
+  // Reads exactly n bytes at offset unless EOF or an error is hit, and sets
+  // *bytes_read to the number of bytes stored in dst.
+  Status PreadFully(uint64 offset, size_t n, char* dst,
+                    size_t* bytes_read) const {
+    Status s;
+    char* const begin = dst;
     bool eof_retried = false;
     while (n > 0 && s.ok()) {
-      // We lock inside the loop rather than outside so we don't block other
-      // concurrent readers.
-      mutex_lock lock(mu_);
-      tSize r = hdfs_->hdfsPread(fs_, file_, static_cast<tOffset>(offset), dst,
-                                 static_cast<tSize>(n));
+      // hdfsPread is safe to call concurrently on the same file, so the lock
+      // only guards swapping the file on reopen.
+      std::shared_ptr<hdfsFile_internal> file;
+      {
+        mutex_lock lock(mu_);
+        file = file_;
+      }
+      tSize r = hdfs_->hdfsPread(fs_, file.get(), static_cast<tOffset>(offset),
+                                 dst, static_cast<tSize>(n));
       if (r > 0) {
         dst += r;
         n -= r;
@@ -220,13 +430,16 @@ class HDFSRandomAccessFile : public RandomAccessFile {
         // contents.
         //
         // Fixes #5438
-        if (file_ != nullptr && hdfs_->hdfsCloseFile(fs_, file_) != 0) {
-          return IOError(filename_, errno);
-        }
-        file_ =
-            hdfs_->hdfsOpenFile(fs_, hdfs_filename_.c_str(), O_RDONLY, 0, 0, 0);
-        if (file_ == nullptr) {
-          return IOError(filename_, errno);
+        mutex_lock lock(mu_);
+        // Another reader may already have reopened the file.
+        if (file_ == file) {
+          hdfsFile reopened = hdfs_->hdfsOpenFile(fs_, hdfs_filename_.c_str(),
+                                                  O_RDONLY, 0, 0, 0);
+          if (reopened == nullptr) {
+            s = IOError(filename_, errno);
+            break;
+          }
+          file_ = WrapFile(reopened);
         }
         eof_retried = true;
       } else if (eof_retried && r == 0) {
@@ -237,18 +450,26 @@ class HDFSRandomAccessFile : public RandomAccessFile {
         s = IOError(filename_, errno);
       }
     }
-    *result = StringPiece(scratch, dst - scratch);
+    *bytes_read = dst - begin;
     return s;
   }
 
- private:
   string filename_;
   string hdfs_filename_;
   LibHDFS* hdfs_;
   hdfsFS fs_;
+  const size_t read_ahead_bytes_;
+  // The HDFS block size of the file, or 0 if unknown.
+  const uint64 block_size_;
+  thread::ThreadPool* fetch_pool_;  // Not owned, may be null.
 
   mutable mutex mu_;
-  mutable hdfsFile file_ GUARDED_BY(mu_);
+  mutable std::shared_ptr<hdfsFile_internal> file_ GUARDED_BY(mu_);
+
+  // The read-ahead buffer and the file offset of its first byte.
+  mutable mutex buffer_mu_;
+  mutable std::vector<char> buffer_ GUARDED_BY(buffer_mu_);
+  mutable uint64 buffer_start_offset_ GUARDED_BY(buffer_mu_) = 0;
 };
 
 Status HadoopFileSystem::NewRandomAccessFile(
@@ -261,8 +482,20 @@ Status HadoopFileSystem::NewRandomAccessFile(
   if (file == nullptr) {
     return IOError(fname, errno);
   }
-  result->reset(
-      new HDFSRandomAccessFile(fname, TranslateName(fname), hdfs_, fs, file));
+  // Only parallel reads need the block size, so skip the extra NameNode round
+  // trip otherwise.
+  uint64 block_size = 0;
+  if (fetch_pool_ != nullptr) {
+    hdfsFileInfo* info =
+        hdfs_->hdfsGetPathInfo(fs, TranslateName(fname).c_str());
+    if (info != nullptr) {
+      block_size = std::max<tOffset>(info->mBlockSize, 0);
+      hdfs_->hdfsFreeFileInfo(info, 1);
+    }
+  }
+  result->reset(new HDFSRandomAccessFile(fname, TranslateName(fname), hdfs_,
+                                         fs, file, read_ahead_bytes_,
+                                         block_size, fetch_pool_.get()));
   return Status::OK();
 }
 
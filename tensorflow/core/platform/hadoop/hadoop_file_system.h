@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_PLATFORM_HADOOP_HADOOP_FILE_SYSTEM_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_PLATFORM_HADOOP_HADOOP_FILE_SYSTEM_H_
 
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/env.h"
 
 extern "C" {
@@ -66,6 +67,13 @@ class HadoopFileSystem : public FileSystem {
  private:
   Status Connect(StringPiece fname, hdfsFS* fs);
   LibHDFS* hdfs_;
+
+  // The size of the read-ahead buffer kept by each random access file, or 0
+  // to pass every Read straight through to hdfsPread.
+  size_t read_ahead_bytes_;
+  // Shared by all random access files to fetch the HDFS blocks touched by a
+  // single large Read concurrently. Null when parallel reads are disabled.
+  std::unique_ptr<thread::ThreadPool> fetch_pool_;
 };
 
 }  // namespace tensorflow
@@ -89,6 +89,44 @@ TEST_F(HadoopFileSystemTest, RandomAccessFile) {
   EXPECT_EQ(content.substr(2, 4), result);
 }
 
+TEST_F(HadoopFileSystemTest, RandomAccessFile_LargeReads) {
+  const string fname = TmpDir("RandomAccessFile_LargeReads");
+  string content(1 << 20, '\0');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  TF_ASSERT_OK(WriteString(fname, content));
+
+  string got;
+  TF_EXPECT_OK(ReadAll(fname, &got));
+  EXPECT_EQ(content, got);
+
+  // Sequential reads of varying sizes are served from the read-ahead buffer
+  // and, past its end, from the file.
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_ASSERT_OK(hdfs.NewRandomAccessFile(fname, &reader));
+  const size_t kChunkSizes[] = {1, 100, 4096, 70000, 300000};
+  uint64 offset = 0;
+  for (int i = 0; offset < content.size(); ++i) {
+    const size_t n =
+        std::min<uint64>(kChunkSizes[i % 5], content.size() - offset);
+    got.resize(n);
+    StringPiece result;
+    TF_ASSERT_OK(reader->Read(offset, n, &result, gtl::string_as_array(&got)));
+    ASSERT_EQ(content.substr(offset, n), result) << "offset " << offset;
+    offset += n;
+  }
+
+  // Reading past the end returns the available bytes.
+  got.resize(1000);
+  StringPiece result;
+  EXPECT_EQ(error::OUT_OF_RANGE,
+            reader->Read(content.size() - 10, 1000, &result,
+                         gtl::string_as_array(&got))
+                .code());
+  EXPECT_EQ(content.substr(content.size() - 10), result);
+}
+
 TEST_F(HadoopFileSystemTest, WritableFile) {
   std::unique_ptr<WritableFile> writer;
   const string fname = TmpDir("WritableFile");
@@ -29,6 +29,12 @@ namespace port {
 void* AlignedMalloc(size_t size, int minimum_alignment);
 void AlignedFree(void* aligned_memory);
 
+// Like AlignedMalloc, but asks the OS to back the allocation with memory of
+// NUMA node "node" where it can. Memory returned by NUMAMalloc must be
+// released with NUMAFree.
+void* NUMAMalloc(int node, size_t size, int minimum_alignment);
+void NUMAFree(void* ptr);
+
 void* Malloc(size_t size);
 void* Realloc(void* ptr, size_t size);
 void Free(void* ptr);
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <string.h>
 #include <condition_variable>
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -33,6 +34,34 @@ TEST(Port, AlignedMalloc) {
   }
 }
 
+TEST(Port, NUMAMalloc) {
+  for (int node = -1; node < NUMANumNodes(); ++node) {
+    for (size_t alignment = 1; alignment <= 1 << 20; alignment <<= 1) {
+      void* p = NUMAMalloc(node, 100, alignment);
+      ASSERT_TRUE(p != nullptr)
+          << "NUMAMalloc(" << node << ", 100, " << alignment << ")";
+      uintptr_t pval = reinterpret_cast<uintptr_t>(p);
+      EXPECT_EQ(pval % alignment, 0);
+      memset(p, 0, 100);
+      NUMAFree(p);
+    }
+  }
+}
+
+TEST(Port, NUMASetThreadNodeAffinity) {
+  EXPECT_GE(NUMANumNodes(), 1);
+  EXPECT_FALSE(NUMASetThreadNodeAffinity(NUMANumNodes()));
+  // Pin a pool thread rather than the test thread, which other tests share.
+  ThreadOptions thread_options;
+  thread_options.numa_node = NUMANumNodes() - 1;
+  bool ran = false;
+  {
+    thread::ThreadPool pool(Env::Default(), thread_options, "numa", 1);
+    pool.Schedule([&ran]() { ran = true; });
+  }
+  EXPECT_TRUE(ran);
+}
+
 TEST(ConditionVariable, WaitForMilliseconds_Timeout) {
   mutex m;
   mutex_lock l(m);
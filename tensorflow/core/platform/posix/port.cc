@@ -24,6 +24,10 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <vector>
 #endif
 #include <stdio.h>
 #include <stdlib.h>
@@ -66,6 +70,87 @@ int NumSchedulableCPUs() {
   return kDefaultCores;
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// The CPUs of each NUMA node, read once from sysfs. Empty if the topology
+// could not be read.
+std::vector<cpu_set_t>* numa_node_cpus = nullptr;
+
+// Parses a sysfs cpulist such as "0-27,56-83" into "cpus".
+bool ParseCPUList(const char* list, cpu_set_t* cpus) {
+  CPU_ZERO(cpus);
+  const char* p = list;
+  while (*p != '\0' && *p != '\n') {
+    char* end;
+    long first = strtol(p, &end, 10);
+    if (end == p) return false;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      ++p;
+      last = strtol(p, &end, 10);
+      if (end == p) return false;
+      p = end;
+    }
+    for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, cpus);
+    }
+    if (*p == ',') ++p;
+  }
+  return CPU_COUNT(cpus) > 0;
+}
+
+void InitNUMANodeCPUs() {
+  numa_node_cpus = new std::vector<cpu_set_t>;
+  for (int node = 0;; ++node) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) break;
+    char list[4096];
+    cpu_set_t cpus;
+    const bool ok = fgets(list, sizeof(list), f) != nullptr &&
+                    ParseCPUList(list, &cpus);
+    fclose(f);
+    if (!ok) {
+      // A node without CPUs (e.g. memory-only) or an unreadable list; treat
+      // the whole topology as unknown rather than mis-numbering nodes.
+      numa_node_cpus->clear();
+      break;
+    }
+    numa_node_cpus->push_back(cpus);
+  }
+}
+
+const std::vector<cpu_set_t>& NUMANodeCPUs() {
+  static std::once_flag once;
+  std::call_once(once, InitNUMANodeCPUs);
+  return *numa_node_cpus;
+}
+
+}  // namespace
+#endif
+
+int NUMANumNodes() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const int num_nodes = NUMANodeCPUs().size();
+  if (num_nodes > 0) return num_nodes;
+#endif
+  return 1;
+}
+
+bool NUMASetThreadNodeAffinity(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const std::vector<cpu_set_t>& node_cpus = NUMANodeCPUs();
+  if (node < 0 || node >= static_cast<int>(node_cpus.size())) return false;
+  return sched_setaffinity(0, sizeof(cpu_set_t), &node_cpus[node]) == 0;
+#else
+  return false;
+#endif
+}
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #if defined(__ANDROID__)
   return memalign(minimum_alignment, size);
@@ -91,6 +176,35 @@ void* AlignedMalloc(size_t size, int minimum_alignment) {
 
 void AlignedFree(void* aligned_memory) { Free(aligned_memory); }
 
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind)
+  if (node >= 0 && node < NUMANumNodes() && node < 64) {
+    // mbind works on whole pages, so page-align the allocation and round its
+    // size up to pages to keep the policy from spilling onto the neighbouring
+    // allocations of malloc.
+    static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+    const size_t alignment =
+        std::max<size_t>(kPageSize, static_cast<size_t>(minimum_alignment));
+    const size_t rounded_size = (size + kPageSize - 1) / kPageSize * kPageSize;
+    void* ptr = AlignedMalloc(rounded_size, alignment);
+    if (ptr == nullptr) return nullptr;
+    // Prefer, rather than bind to, the node so that the allocation still
+    // succeeds when the node runs out of memory. The policy only affects
+    // pages that have not been touched yet, which is the common case for the
+    // large allocations that matter here; failure just leaves the default
+    // first-touch placement.
+    const int kMpolPreferred = 1;
+    unsigned long nodemask = 1UL << node;
+    syscall(SYS_mbind, ptr, rounded_size, kMpolPreferred, &nodemask,
+            sizeof(nodemask) * 8, 0);
+    return ptr;
+  }
+#endif
+  return AlignedMalloc(size, minimum_alignment);
+}
+
+void NUMAFree(void* ptr) { AlignedFree(ptr); }
+
 void* Malloc(size_t size) {
 #ifdef TENSORFLOW_USE_JEMALLOC
   return jemalloc_malloc(size);
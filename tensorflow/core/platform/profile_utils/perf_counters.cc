@@ -0,0 +1,124 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#endif  // defined(__linux__)
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+/* static */ constexpr int PerfCounters::kNumCounters;
+
+#if defined(__linux__)
+
+namespace {
+
+// Owns the counters of a thread, and closes them when the thread exits.
+struct ThreadCounters {
+  std::unique_ptr<PerfCounters> counters;
+  bool tried = false;
+};
+
+int OpenPerfEvent(uint64 config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // pid 0 and cpu -1 count the calling thread on any CPU.
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+}  // namespace
+
+PerfCounters::~PerfCounters() {
+  for (int i = kNumCounters - 1; i >= 0; --i) {
+    if (fds_[i] >= 0) close(fds_[i]);
+  }
+}
+
+/* static */ PerfCounters* PerfCounters::ForCurrentThread() {
+  static thread_local ThreadCounters thread_counters;
+  if (!thread_counters.tried) {
+    thread_counters.tried = true;
+    std::unique_ptr<PerfCounters> counters(new PerfCounters);
+    if (counters->Open()) {
+      thread_counters.counters = std::move(counters);
+    } else {
+      static std::atomic_flag warned = ATOMIC_FLAG_INIT;
+      if (!warned.test_and_set()) {
+        LOG(WARNING) << "Hardware counters are not available: "
+                     << strerror(errno);
+      }
+    }
+  }
+  return thread_counters.counters.get();
+}
+
+bool PerfCounters::Open() {
+  const uint64 configs[kNumCounters] = {PERF_COUNT_HW_CPU_CYCLES,
+                                        PERF_COUNT_HW_INSTRUCTIONS,
+                                        PERF_COUNT_HW_CACHE_MISSES};
+  for (int i = 0; i < kNumCounters; ++i) {
+    fds_[i] = OpenPerfEvent(configs[i], i == 0 ? -1 : fds_[0]);
+    if (fds_[i] < 0) return false;
+  }
+  return true;
+}
+
+bool PerfCounters::Read(PerfCounterValues* values) const {
+  // With PERF_FORMAT_GROUP, the leader reads the number of counters followed
+  // by their values.
+  uint64 buffer[1 + kNumCounters];
+  if (read(fds_[0], buffer, sizeof(buffer)) != sizeof(buffer) ||
+      buffer[0] != kNumCounters) {
+    return false;
+  }
+  values->cycles = buffer[1];
+  values->instructions = buffer[2];
+  values->cache_misses = buffer[3];
+  return true;
+}
+
+#else  // defined(__linux__)
+
+PerfCounters::~PerfCounters() {}
+
+/* static */ PerfCounters* PerfCounters::ForCurrentThread() { return nullptr; }
+
+bool PerfCounters::Open() { return false; }
+
+bool PerfCounters::Read(PerfCounterValues* values) const { return false; }
+
+#endif  // defined(__linux__)
+
+}  // namespace profile_utils
+}  // namespace tensorflow
@@ -0,0 +1,68 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H_
+#define TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H_
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+// Hardware event counts.
+struct PerfCounterValues {
+  int64 cycles = 0;
+  int64 instructions = 0;
+  // Misses of the last level cache, i.e. accesses that go to memory.
+  int64 cache_misses = 0;
+};
+
+// Counts the hardware events of one thread with perf_event_open(2), which is
+// only available on Linux and Android. The counters of a thread run from its
+// first call to ForCurrentThread() until it exits, so the events of a piece
+// of code are the difference of two Read()s around it on the same thread.
+// Only events in user mode are counted.
+class PerfCounters {
+ public:
+  ~PerfCounters();
+
+  // Returns the counters of the calling thread, which are opened by the
+  // first call on the thread. Returns nullptr if the platform, the kernel or
+  // the CPU does not support them, or if the kernel does not let the process
+  // use them (see /proc/sys/kernel/perf_event_paranoid).
+  static PerfCounters* ForCurrentThread();
+
+  // Reads the counts of the thread. Returns false if they can't be read.
+  bool Read(PerfCounterValues* values) const;
+
+ private:
+  PerfCounters() = default;
+
+  // Opens the counters of the calling thread. Returns false on failure.
+  bool Open();
+
+  // The file descriptors of the cycles, instructions and cache misses
+  // counters. The first one leads the group, and reads all three.
+  static constexpr int kNumCounters = 3;
+  int fds_[kNumCounters] = {-1, -1, -1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerfCounters);
+};
+
+}  // namespace profile_utils
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H_
@@ -68,6 +68,10 @@ class Benchmark {
   void Register();
   void Run(int arg1, int arg2, int* run_count, double* run_seconds);
 };
+
+// Reports "value" under "key" along with the benchmark, in its printed line
+// and in the extras of its BenchmarkEntry (see util/reporter.h).
+void SetExtra(const string& key, double value);
 #endif
 
 void RunBenchmarks();
@@ -0,0 +1,197 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/async_events_writer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+AsyncEventsWriter::AsyncEventsWriter(const string& file_prefix,
+                                     const AsyncEventsWriterOptions& options)
+    : env_(Env::Default()), options_(options), writer_(file_prefix) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "async_events_writer",
+                                  [this]() { WriterLoop(); }));
+}
+
+AsyncEventsWriter::~AsyncEventsWriter() {
+  {
+    mutex_lock l(mu_);
+    shutdown_ = true;
+    work_cv_.notify_all();
+  }
+  // Joins the background thread, which writes and flushes the queue before
+  // exiting.  The EventsWriter then closes the file.
+  thread_.reset();
+}
+
+bool AsyncEventsWriter::InitWithSuffix(const string& suffix) {
+  mutex_lock l(writer_mu_);
+  return writer_.InitWithSuffix(suffix);
+}
+
+string AsyncEventsWriter::FileName() {
+  mutex_lock l(writer_mu_);
+  return writer_.FileName();
+}
+
+bool AsyncEventsWriter::WriteEvent(const Event& event) {
+  string record;
+  event.AppendToString(&record);
+  return WriteSerializedEvent(record);
+}
+
+bool AsyncEventsWriter::HasRoomLocked(size_t event_size) const {
+  if (queue_.empty()) return true;
+  return static_cast<int64>(queue_.size()) < options_.max_queued_events &&
+         queued_bytes_ + static_cast<int64>(event_size) <=
+             options_.max_queued_bytes;
+}
+
+bool AsyncEventsWriter::WriteSerializedEvent(StringPiece event_str) {
+  mutex_lock l(mu_);
+  if (!HasRoomLocked(event_str.size()) && options_.max_block_micros != 0) {
+    const uint64 deadline_micros =
+        env_->NowMicros() + options_.max_block_micros;
+    while (!HasRoomLocked(event_str.size())) {
+      if (options_.max_block_micros < 0) {
+        room_cv_.wait(l);
+        continue;
+      }
+      const uint64 now_micros = env_->NowMicros();
+      if (now_micros >= deadline_micros) break;
+      WaitForMilliseconds(&l, &room_cv_,
+                          (deadline_micros - now_micros + 999) / 1000);
+    }
+  }
+  if (!HasRoomLocked(event_str.size())) {
+    ++num_dropped_;
+    if (num_dropped_ == 1 || num_dropped_ % 1000 == 0) {
+      LOG(WARNING) << "Events queue is full, dropped " << num_dropped_
+                   << " events so far.";
+    }
+    return false;
+  }
+  queue_.emplace_back(event_str.data(), event_str.size());
+  queued_bytes_ += event_str.size();
+  ++num_queued_;
+  work_cv_.notify_one();
+  return true;
+}
+
+bool AsyncEventsWriter::Flush() {
+  mutex_lock l(mu_);
+  const int64 request = ++flushes_requested_;
+  work_cv_.notify_one();
+  while (flushes_done_ < request) {
+    flush_cv_.wait(l);
+  }
+  return last_flush_ok_;
+}
+
+bool AsyncEventsWriter::Close() {
+  const bool flush_ok = Flush();
+  mutex_lock l(writer_mu_);
+  return writer_.Close() && flush_ok;
+}
+
+int64 AsyncEventsWriter::num_queued_events() const {
+  mutex_lock l(mu_);
+  return num_queued_;
+}
+
+int64 AsyncEventsWriter::num_dropped_events() const {
+  mutex_lock l(mu_);
+  return num_dropped_;
+}
+
+int64 AsyncEventsWriter::num_pending_events() const {
+  mutex_lock l(mu_);
+  return queue_.size();
+}
+
+void AsyncEventsWriter::WriterLoop() {
+  std::deque<string> batch;
+  int64 unflushed_bytes = 0;
+  bool has_unflushed_events = false;
+  uint64 flush_deadline_micros = 0;
+  while (true) {
+    int64 flush_request;
+    bool shutdown;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && flushes_done_ == flushes_requested_ &&
+             !shutdown_) {
+        if (!has_unflushed_events) {
+          work_cv_.wait(l);
+          continue;
+        }
+        // Wake up in time to flush the oldest unflushed event.
+        const uint64 now_micros = env_->NowMicros();
+        if (now_micros >= flush_deadline_micros) break;
+        WaitForMilliseconds(&l, &work_cv_,
+                            (flush_deadline_micros - now_micros + 999) / 1000);
+      }
+      batch.swap(queue_);
+      queued_bytes_ = 0;
+      flush_request = flushes_requested_;
+      shutdown = shutdown_;
+      room_cv_.notify_all();
+    }
+
+    if (!batch.empty()) {
+      mutex_lock l(writer_mu_);
+      for (const string& event_str : batch) {
+        writer_.WriteSerializedEvent(event_str);
+        unflushed_bytes += event_str.size();
+      }
+      if (!has_unflushed_events) {
+        has_unflushed_events = true;
+        flush_deadline_micros =
+            env_->NowMicros() + options_.flush_interval_micros;
+      }
+      batch.clear();
+    }
+
+    bool flush_requested;
+    {
+      mutex_lock l(mu_);
+      flush_requested = flush_request > flushes_done_;
+    }
+    if (flush_requested || shutdown ||
+        unflushed_bytes >= options_.flush_bytes ||
+        (has_unflushed_events && env_->NowMicros() >= flush_deadline_micros)) {
+      bool flush_ok;
+      {
+        mutex_lock l(writer_mu_);
+        flush_ok = writer_.Flush();
+      }
+      unflushed_bytes = 0;
+      has_unflushed_events = false;
+      mutex_lock l(mu_);
+      if (flush_request > flushes_done_) {
+        flushes_done_ = flush_request;
+        last_flush_ok_ = flush_ok;
+        flush_cv_.notify_all();
+      }
+    }
+    if (shutdown) return;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_UTIL_ASYNC_EVENTS_WRITER_H_
+#define TENSORFLOW_UTIL_ASYNC_EVENTS_WRITER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/event.pb.h"
+#include "tensorflow/core/util/events_writer.h"
+
+namespace tensorflow {
+
+struct AsyncEventsWriterOptions {
+  // Bounds on the events buffered in memory while they wait to be written.
+  // A single event larger than max_queued_bytes is accepted when the queue
+  // is empty.
+  int64 max_queued_events = 1024;
+  int64 max_queued_bytes = 64 << 20;
+
+  // How long a write waits for room in a full queue before the event is
+  // dropped.  0 drops the event right away and a negative value waits until
+  // there is room, i.e. never drops.
+  int64 max_block_micros = 0;
+
+  // The background thread flushes the events file once this many bytes have
+  // been written since the last flush, or once the oldest unflushed event is
+  // this old, whichever comes first.
+  int64 flush_bytes = 4 << 20;
+  int64 flush_interval_micros = 10 * 1000 * 1000;
+};
+
+// An events writer that moves writing and flushing off the caller's thread.
+//
+// Write*() serializes the event into a bounded in-memory queue and returns
+// immediately.  A background thread drains the queue into an EventsWriter and
+// flushes the file according to the policies in AsyncEventsWriterOptions, so
+// slow file systems no longer stall the callers.  When the queue is full,
+// events are dropped (after waiting up to max_block_micros) and counted.
+//
+// The file naming and format are those of EventsWriter.  All methods are
+// thread-safe.
+class AsyncEventsWriter {
+ public:
+  // See EventsWriter for the meaning of "file_prefix".
+  AsyncEventsWriter(const string& file_prefix,
+                    const AsyncEventsWriterOptions& options);
+  explicit AsyncEventsWriter(const string& file_prefix)
+      : AsyncEventsWriter(file_prefix, AsyncEventsWriterOptions()) {}
+
+  // Writes and flushes all queued events and closes the file.
+  ~AsyncEventsWriter();
+
+  // Same as EventsWriter::Init*(): opens the events file on the calling
+  // thread.  If not called, the file is opened by the first write.
+  bool Init() { return InitWithSuffix(""); }
+  bool InitWithSuffix(const string& suffix);
+
+  // Returns the filename for the current events file.
+  string FileName();
+
+  // Queues "event" to be appended to the file.  Returns false if the queue
+  // was full and the event was dropped.
+  bool WriteEvent(const tensorflow::Event& event);
+
+  // Queues "event_str", a serialized Event, to be appended to the file.
+  // Returns false if the queue was full and the event was dropped.
+  bool WriteSerializedEvent(tensorflow::StringPiece event_str);
+
+  // Blocks until all the events queued before the call are written and the
+  // file is flushed.  Returns false if the flush failed.
+  bool Flush();
+
+  // Flush()es and then closes the current events file.  Later writes open a
+  // new file.  Returns true only if both the flush and the closure were
+  // successful.
+  bool Close();
+
+  // The number of events accepted into the queue, dropped because the queue
+  // was full, and waiting in the queue to be written.
+  int64 num_queued_events() const;
+  int64 num_dropped_events() const;
+  int64 num_pending_events() const;
+
+ private:
+  void WriterLoop();
+  bool HasRoomLocked(size_t event_size) const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const AsyncEventsWriterOptions options_;
+
+  // Held by the background thread while it writes a batch of events.
+  mutex writer_mu_;
+  EventsWriter writer_ GUARDED_BY(writer_mu_);
+
+  mutable mutex mu_;
+  condition_variable work_cv_;   // Signalled when there is work to do.
+  condition_variable room_cv_;   // Signalled when the queue has drained.
+  condition_variable flush_cv_;  // Signalled when a flush has completed.
+  std::deque<string> queue_ GUARDED_BY(mu_);
+  int64 queued_bytes_ GUARDED_BY(mu_) = 0;
+  int64 num_queued_ GUARDED_BY(mu_) = 0;
+  int64 num_dropped_ GUARDED_BY(mu_) = 0;
+  // Flush() requests are numbered; flushes_done_ is the number of the last
+  // request whose events have been flushed, with result last_flush_ok_.
+  int64 flushes_requested_ GUARDED_BY(mu_) = 0;
+  int64 flushes_done_ GUARDED_BY(mu_) = 0;
+  bool last_flush_ok_ GUARDED_BY(mu_) = true;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncEventsWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_ASYNC_EVENTS_WRITER_H_
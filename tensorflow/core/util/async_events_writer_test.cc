@@ -0,0 +1,301 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/async_events_writer.h"
+
+#include <algorithm>
+#include <vector>
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/event.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// Files of the "gatedfs" file system live in the local test directory, and
+// their Sync() blocks while the gate is closed, which makes the writer fall
+// behind.
+mutex gate_mu;
+condition_variable gate_cv;
+bool gate_open GUARDED_BY(gate_mu) = true;
+int num_syncs GUARDED_BY(gate_mu) = 0;
+
+void SetGateOpen(bool open) {
+  mutex_lock l(gate_mu);
+  gate_open = open;
+  gate_cv.notify_all();
+}
+
+// Waits until at least "n" Sync() calls have started.
+void WaitForSyncs(int n) {
+  mutex_lock l(gate_mu);
+  while (num_syncs < n) gate_cv.wait(l);
+}
+
+int NumSyncs() {
+  mutex_lock l(gate_mu);
+  return num_syncs;
+}
+
+string LocalPath(const string& fname) {
+  StringPiece scheme, host, path;
+  io::ParseURI(fname, &scheme, &host, &path);
+  return io::JoinPath(testing::TmpDir(), path);
+}
+
+class GatedWritableFile : public WritableFile {
+ public:
+  explicit GatedWritableFile(std::unique_ptr<WritableFile> file)
+      : file_(std::move(file)) {}
+
+  Status Append(const StringPiece& data) override {
+    return file_->Append(data);
+  }
+  Status Close() override { return file_->Close(); }
+  Status Flush() override { return file_->Flush(); }
+  Status Sync() override {
+    {
+      mutex_lock l(gate_mu);
+      ++num_syncs;
+      gate_cv.notify_all();
+      while (!gate_open) gate_cv.wait(l);
+    }
+    return file_->Sync();
+  }
+
+ private:
+  std::unique_ptr<WritableFile> file_;
+};
+
+class GatedFileSystem : public NullFileSystem {
+ public:
+  Status NewWritableFile(const string& fname,
+                         std::unique_ptr<WritableFile>* result) override {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(
+        Env::Default()->NewWritableFile(LocalPath(fname), &file));
+    result->reset(new GatedWritableFile(std::move(file)));
+    return Status::OK();
+  }
+
+  Status FileExists(const string& fname) override {
+    return Env::Default()->FileExists(LocalPath(fname));
+  }
+};
+
+REGISTER_FILE_SYSTEM("gatedfs", GatedFileSystem);
+
+Event MakeEvent(int64 step) {
+  Event event;
+  event.set_wall_time(1234);
+  event.set_step(step);
+  Summary::Value* summ_val = event.mutable_summary()->add_value();
+  summ_val->set_tag("foo");
+  summ_val->set_simple_value(step);
+  return event;
+}
+
+// Returns the steps of the events in "fname", after the version event.
+std::vector<int64> ReadSteps(const string& fname) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(LocalPath(fname), &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  Event event;
+  CHECK(ParseProtoUnlimited(&event, record));
+  EXPECT_EQ(strings::StrCat(EventsWriter::kVersionPrefix,
+                            EventsWriter::kCurrentVersion),
+            event.file_version());
+  std::vector<int64> steps;
+  while (reader.ReadRecord(&offset, &record).ok()) {
+    CHECK(ParseProtoUnlimited(&event, record));
+    steps.push_back(event.step());
+  }
+  return steps;
+}
+
+string Prefix(const string& name) {
+  return strings::StrCat("gatedfs:///", name);
+}
+
+TEST(AsyncEventsWriter, WriteFlush) {
+  AsyncEventsWriter writer(Prefix("async_writeflush_test"));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(writer.WriteEvent(MakeEvent(i)));
+  }
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_EQ(100, writer.num_queued_events());
+  EXPECT_EQ(0, writer.num_pending_events());
+  EXPECT_EQ(0, writer.num_dropped_events());
+
+  const std::vector<int64> steps = ReadSteps(writer.FileName());
+  ASSERT_EQ(100, steps.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, steps[i]);
+  }
+}
+
+TEST(AsyncEventsWriter, DestructorWritesQueuedEvents) {
+  string filename;
+  {
+    AsyncEventsWriter writer(Prefix("async_destructor_test"));
+    ASSERT_TRUE(writer.Init());
+    filename = writer.FileName();
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(writer.WriteEvent(MakeEvent(i)));
+    }
+  }
+  EXPECT_EQ(10, ReadSteps(filename).size());
+}
+
+TEST(AsyncEventsWriter, CloseThenWriteOpensNewFile) {
+  AsyncEventsWriter writer(Prefix("async_close_test"));
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(1)));
+  EXPECT_TRUE(writer.Close());
+  const string first_filename = writer.FileName();
+  EXPECT_EQ(std::vector<int64>({1}), ReadSteps(first_filename));
+
+  // The new file has a new timestamp in its name.
+  Env::Default()->SleepForMicroseconds(1100000);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(2)));
+  EXPECT_TRUE(writer.Close());
+  EXPECT_NE(first_filename, writer.FileName());
+  EXPECT_EQ(std::vector<int64>({2}), ReadSteps(writer.FileName()));
+}
+
+TEST(AsyncEventsWriter, DropsEventsWhenFull) {
+  AsyncEventsWriterOptions options;
+  options.max_queued_events = 2;
+  options.flush_bytes = 1;
+  AsyncEventsWriter writer(Prefix("async_drop_test"), options);
+  ASSERT_TRUE(writer.Init());
+  const int num_syncs = NumSyncs();
+
+  // The background thread blocks in the flush after writing event 0.
+  SetGateOpen(false);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(0)));
+  WaitForSyncs(num_syncs + 1);
+  for (int i = 1; i <= 5; ++i) {
+    EXPECT_EQ(i <= 2, writer.WriteEvent(MakeEvent(i)));
+  }
+  EXPECT_EQ(3, writer.num_queued_events());
+  EXPECT_EQ(2, writer.num_pending_events());
+  EXPECT_EQ(3, writer.num_dropped_events());
+
+  SetGateOpen(true);
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_EQ(std::vector<int64>({0, 1, 2}), ReadSteps(writer.FileName()));
+}
+
+TEST(AsyncEventsWriter, DropsEventsAfterTimeout) {
+  AsyncEventsWriterOptions options;
+  options.max_queued_events = 1;
+  options.max_block_micros = 20000;
+  options.flush_bytes = 1;
+  AsyncEventsWriter writer(Prefix("async_timeout_test"), options);
+  ASSERT_TRUE(writer.Init());
+  const int num_syncs = NumSyncs();
+
+  SetGateOpen(false);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(0)));
+  WaitForSyncs(num_syncs + 1);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(1)));
+  const uint64 start_micros = Env::Default()->NowMicros();
+  EXPECT_FALSE(writer.WriteEvent(MakeEvent(2)));
+  EXPECT_GE(Env::Default()->NowMicros() - start_micros, 20000);
+  EXPECT_EQ(1, writer.num_dropped_events());
+
+  SetGateOpen(true);
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_EQ(std::vector<int64>({0, 1}), ReadSteps(writer.FileName()));
+}
+
+TEST(AsyncEventsWriter, BlocksUntilRoom) {
+  AsyncEventsWriterOptions options;
+  options.max_queued_events = 1;
+  options.max_block_micros = -1;
+  options.flush_bytes = 1;
+  AsyncEventsWriter writer(Prefix("async_block_test"), options);
+  ASSERT_TRUE(writer.Init());
+  const int num_syncs = NumSyncs();
+
+  SetGateOpen(false);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(0)));
+  WaitForSyncs(num_syncs + 1);
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(1)));
+  Notification written;
+  std::unique_ptr<Thread> thread(
+      Env::Default()->StartThread(ThreadOptions(), "writer", [&]() {
+        EXPECT_TRUE(writer.WriteEvent(MakeEvent(2)));
+        written.Notify();
+      }));
+  Env::Default()->SleepForMicroseconds(20000);
+  EXPECT_FALSE(written.HasBeenNotified());
+
+  SetGateOpen(true);
+  written.WaitForNotification();
+  thread.reset();
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_EQ(0, writer.num_dropped_events());
+  EXPECT_EQ(std::vector<int64>({0, 1, 2}), ReadSteps(writer.FileName()));
+}
+
+TEST(AsyncEventsWriter, FlushesAfterInterval) {
+  AsyncEventsWriterOptions options;
+  options.flush_interval_micros = 10000;
+  AsyncEventsWriter writer(Prefix("async_interval_test"), options);
+  ASSERT_TRUE(writer.Init());
+  const int num_syncs = NumSyncs();
+
+  // No Flush(): the background thread flushes on its own.
+  EXPECT_TRUE(writer.WriteEvent(MakeEvent(0)));
+  WaitForSyncs(num_syncs + 1);
+  EXPECT_EQ(std::vector<int64>({0}), ReadSteps(writer.FileName()));
+}
+
+TEST(AsyncEventsWriter, ConcurrentWrites) {
+  AsyncEventsWriter writer(Prefix("async_concurrent_test"));
+  {
+    thread::ThreadPool pool(Env::Default(), "writers", 4);
+    for (int i = 0; i < 4; ++i) {
+      pool.Schedule([&writer, i]() {
+        for (int j = 0; j < 100; ++j) {
+          writer.WriteEvent(MakeEvent(i * 100 + j));
+        }
+      });
+    }
+  }
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_EQ(400, writer.num_queued_events() + writer.num_dropped_events());
+  std::vector<int64> steps = ReadSteps(writer.FileName());
+  EXPECT_EQ(writer.num_queued_events(), steps.size());
+  std::sort(steps.begin(), steps.end());
+  EXPECT_EQ(steps.end(), std::unique(steps.begin(), steps.end()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,496 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/columnar/columnar.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The version of the format written by ColumnarWriter.
+constexpr int32 kFormatVersion = 1;
+
+constexpr char kIndexRegion[] = "columnar_index";
+constexpr char kValuesRegion[] = "values";
+constexpr char kSplitsRegion[] = "splits";
+constexpr char kOffsetsRegion[] = "offsets";
+
+string IndexRegionName() {
+  return strings::StrCat(MemmappedFileSystem::kMemmappedPackagePrefix,
+                         kIndexRegion);
+}
+
+string RegionName(int column, int chunk, StringPiece suffix) {
+  return strings::StrCat(MemmappedFileSystem::kMemmappedPackagePrefix, "c",
+                         column, ".", chunk, ".", suffix);
+}
+
+// Returns false for features without a kind, which have no values.
+bool FeatureDataType(const Feature& feature, DataType* dtype) {
+  switch (feature.kind_case()) {
+    case Feature::kFloatList:
+      *dtype = DT_FLOAT;
+      return true;
+    case Feature::kInt64List:
+      *dtype = DT_INT64;
+      return true;
+    case Feature::kBytesList:
+      *dtype = DT_STRING;
+      return true;
+    case Feature::KIND_NOT_SET:
+      break;
+  }
+  return false;
+}
+
+// Saves "values" as region "name", unless it is empty.
+template <typename T>
+Status SaveVector(const std::vector<T>& values, const string& name,
+                  MemmappedFileSystemWriter* writer) {
+  if (values.empty()) {
+    return Status::OK();
+  }
+  Tensor tensor(DataTypeToEnum<T>::value,
+                TensorShape({static_cast<int64>(values.size())}));
+  std::copy(values.begin(), values.end(), tensor.flat<T>().data());
+  return writer->SaveTensor(tensor, name);
+}
+
+// A read-only buffer that aliases a region of a mapped columnar file.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<MemmappedFileSystem> fs,
+                     const char* data, size_t len)
+      : fs_(std::move(fs)), data_(data), len_(len) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("mmap");
+  }
+
+  // The mapped pages are read-only, so they must never be forwarded to an
+  // op that would update them in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<MemmappedFileSystem> fs_;
+  const char* const data_;
+  const size_t len_;
+};
+
+// Checks that "splits" are valid offsets into "num_values" values.
+Status CheckSplits(const Tensor& splits, int64 num_values) {
+  const auto s = splits.vec<int64>();
+  if (s(0) != 0 || s(s.size() - 1) != num_values) {
+    return errors::DataLoss("Row splits do not cover the ", num_values,
+                            " values");
+  }
+  for (int64 i = 1; i < s.size(); ++i) {
+    if (s(i) < s(i - 1)) {
+      return errors::DataLoss("Row splits are not sorted");
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// The values of one column in the current chunk. Only the vector matching
+// the column's dtype is used.
+struct ColumnarWriter::Column {
+  DataType dtype;
+  std::vector<float> floats;
+  std::vector<int64> int64s;
+  std::vector<string> strings;
+  // The offsets of each row's first value, plus the number of values.
+  std::vector<int64> row_splits;
+
+  int64 num_values() const {
+    return floats.size() + int64s.size() + strings.size();
+  }
+};
+
+ColumnarWriter::ColumnarWriter(Env* env, const string& filename,
+                               const Options& options)
+    : options_(options) {
+  if (options_.rows_per_chunk <= 0) {
+    status_ = errors::InvalidArgument("rows_per_chunk must be positive, got ",
+                                      options_.rows_per_chunk);
+    return;
+  }
+  index_.set_format_version(kFormatVersion);
+  status_ = writer_.InitializeToFile(env, filename);
+}
+
+ColumnarWriter::~ColumnarWriter() {}
+
+Status ColumnarWriter::AddExample(const Example& example) {
+  TF_RETURN_IF_ERROR(status_);
+  const auto& features = example.features().feature();
+  // Check the kinds of all features first, so that a bad Example does not
+  // leave a partial row behind.
+  for (const auto& feature : features) {
+    DataType dtype;
+    if (!FeatureDataType(feature.second, &dtype)) continue;
+    auto it = column_ids_.find(feature.first);
+    if (it != column_ids_.end() &&
+        index_.columns(it->second).dtype() != dtype) {
+      return errors::InvalidArgument(
+          "Feature '", feature.first, "' has type ", DataTypeString(dtype),
+          " in row ", num_rows_, ", but type ",
+          DataTypeString(index_.columns(it->second).dtype()),
+          " in earlier rows");
+    }
+  }
+  for (const auto& feature : features) {
+    DataType dtype;
+    if (!FeatureDataType(feature.second, &dtype)) continue;
+    auto it = column_ids_.find(feature.first);
+    if (it == column_ids_.end()) {
+      // Earlier rows have no values for a new column.
+      it = column_ids_.emplace(feature.first, columns_.size()).first;
+      ColumnarColumnProto* proto = index_.add_columns();
+      proto->set_name(feature.first);
+      proto->set_dtype(dtype);
+      for (int i = 0; i < index_.chunk_num_rows_size(); ++i) {
+        proto->add_chunks()->set_row_length(0);
+      }
+      columns_.emplace_back(new Column);
+      columns_.back()->dtype = dtype;
+      columns_.back()->row_splits.assign(chunk_rows_ + 1, 0);
+    }
+    Column* column = columns_[it->second].get();
+    switch (feature.second.kind_case()) {
+      case Feature::kFloatList: {
+        const auto& values = feature.second.float_list().value();
+        column->floats.insert(column->floats.end(), values.begin(),
+                              values.end());
+        break;
+      }
+      case Feature::kInt64List: {
+        const auto& values = feature.second.int64_list().value();
+        column->int64s.insert(column->int64s.end(), values.begin(),
+                              values.end());
+        break;
+      }
+      case Feature::kBytesList: {
+        const auto& values = feature.second.bytes_list().value();
+        column->strings.insert(column->strings.end(), values.begin(),
+                               values.end());
+        break;
+      }
+      case Feature::KIND_NOT_SET:
+        break;
+    }
+  }
+  for (auto& column : columns_) {
+    column->row_splits.push_back(column->num_values());
+  }
+  ++num_rows_;
+  if (++chunk_rows_ == options_.rows_per_chunk) {
+    status_ = WriteChunk();
+  }
+  return status_;
+}
+
+Status ColumnarWriter::WriteChunk() {
+  if (chunk_rows_ == 0) {
+    return Status::OK();
+  }
+  const int chunk = index_.chunk_num_rows_size();
+  index_.add_chunk_num_rows(chunk_rows_);
+  for (int i = 0; i < columns_.size(); ++i) {
+    Column* column = columns_[i].get();
+    const std::vector<int64>& splits = column->row_splits;
+    ColumnarChunkProto* proto = index_.mutable_columns(i)->add_chunks();
+    proto->set_num_values(splits.back());
+    int64 row_length = splits[1] - splits[0];
+    for (size_t r = 2; r < splits.size(); ++r) {
+      if (splits[r] - splits[r - 1] != row_length) {
+        row_length = -1;
+        break;
+      }
+    }
+    proto->set_row_length(row_length);
+
+    const string values_name = RegionName(i, chunk, kValuesRegion);
+    switch (column->dtype) {
+      case DT_FLOAT:
+        TF_RETURN_IF_ERROR(SaveVector(column->floats, values_name, &writer_));
+        column->floats.clear();
+        break;
+      case DT_INT64:
+        TF_RETURN_IF_ERROR(SaveVector(column->int64s, values_name, &writer_));
+        column->int64s.clear();
+        break;
+      case DT_STRING: {
+        std::vector<int64> offsets;
+        offsets.reserve(column->strings.size() + 1);
+        offsets.push_back(0);
+        for (const string& value : column->strings) {
+          offsets.push_back(offsets.back() + value.size());
+        }
+        if (offsets.back() > 0) {
+          Tensor bytes(DT_UINT8, TensorShape({offsets.back()}));
+          char* dst = reinterpret_cast<char*>(bytes.flat<uint8>().data());
+          for (const string& value : column->strings) {
+            memcpy(dst, value.data(), value.size());
+            dst += value.size();
+          }
+          TF_RETURN_IF_ERROR(writer_.SaveTensor(bytes, values_name));
+        }
+        if (!column->strings.empty()) {
+          TF_RETURN_IF_ERROR(SaveVector(
+              offsets, RegionName(i, chunk, kOffsetsRegion), &writer_));
+        }
+        column->strings.clear();
+        break;
+      }
+      default:
+        return errors::Internal("Unexpected column type ",
+                                DataTypeString(column->dtype));
+    }
+    if (row_length < 0) {
+      TF_RETURN_IF_ERROR(
+          SaveVector(splits, RegionName(i, chunk, kSplitsRegion), &writer_));
+    }
+    column->row_splits.assign(1, 0);
+  }
+  chunk_rows_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarWriter::Finish() {
+  TF_RETURN_IF_ERROR(status_);
+  Status s = WriteChunk();
+  if (s.ok()) {
+    s = writer_.SaveProtobuf(index_, IndexRegionName());
+  }
+  if (s.ok()) {
+    s = writer_.FlushAndClose();
+  }
+  status_ =
+      s.ok() ? errors::FailedPrecondition("ColumnarWriter is finished") : s;
+  return s;
+}
+
+ColumnarReader::ColumnarReader(Env* env, const string& filename)
+    : filename_(filename), fs_(new MemmappedFileSystem) {
+  if (!port::kLittleEndian) {
+    status_ = errors::Unimplemented(
+        "Columnar files can only be read on little-endian platforms");
+    return;
+  }
+  status_ = fs_->InitializeFromFile(env, filename);
+  if (!status_.ok()) return;
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  status_ = fs_->NewReadOnlyMemoryRegionFromFile(IndexRegionName(), &region);
+  if (!status_.ok()) return;
+  if (!index_.ParseFromArray(region->data(), region->length())) {
+    status_ = errors::DataLoss("Can't parse the index of columnar file ",
+                               filename);
+    return;
+  }
+  if (index_.format_version() != kFormatVersion) {
+    status_ = errors::Unimplemented("Columnar file ", filename,
+                                    " has unsupported format version ",
+                                    index_.format_version());
+    return;
+  }
+  for (const int64 chunk_rows : index_.chunk_num_rows()) {
+    if (chunk_rows < 0) {
+      status_ = errors::DataLoss("Negative chunk size in columnar file ",
+                                 filename);
+      return;
+    }
+    num_rows_ += chunk_rows;
+  }
+  for (int i = 0; i < index_.columns_size(); ++i) {
+    const ColumnarColumnProto& column = index_.columns(i);
+    if (column.dtype() != DT_FLOAT && column.dtype() != DT_INT64 &&
+        column.dtype() != DT_STRING) {
+      status_ = errors::DataLoss("Column '", column.name(),
+                                 "' of columnar file ", filename,
+                                 " has unsupported type ",
+                                 DataTypeString(column.dtype()));
+      return;
+    }
+    if (column.chunks_size() != num_chunks()) {
+      status_ = errors::DataLoss("Column '", column.name(),
+                                 "' of columnar file ", filename, " has ",
+                                 column.chunks_size(), " chunks, expected ",
+                                 num_chunks());
+      return;
+    }
+    if (!column_ids_.emplace(column.name(), i).second) {
+      status_ = errors::DataLoss("Duplicate column '", column.name(),
+                                 "' in columnar file ", filename);
+      return;
+    }
+  }
+}
+
+ColumnarReader::~ColumnarReader() {}
+
+int ColumnarReader::FindColumn(StringPiece name) const {
+  auto it = column_ids_.find(name.ToString());
+  return it == column_ids_.end() ? -1 : it->second;
+}
+
+Status ColumnarReader::MapRegion(int column, int chunk, StringPiece suffix,
+                                 DataType dtype, int64 num_elements,
+                                 Tensor* tensor) const {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(fs_->NewReadOnlyMemoryRegionFromFile(
+      RegionName(column, chunk, suffix), &region));
+  const size_t bytes = num_elements * DataTypeSize(dtype);
+  // Regions may be followed by padding for the alignment of the next one.
+  if (region->length() < bytes) {
+    return errors::DataLoss("Region ", RegionName(column, chunk, suffix),
+                            " of columnar file ", filename_, " has ",
+                            region->length(), " bytes, expected ", bytes);
+  }
+  const char* data = static_cast<const char*>(region->data());
+  TensorBuffer* buf = new MappedTensorBuffer(fs_, data, bytes);
+  *tensor = Tensor(dtype, TensorShape({num_elements}), buf);
+  buf->Unref();
+  if (!tensor->IsAligned()) {
+    *tensor = tensor::DeepCopy(*tensor);
+  }
+  return Status::OK();
+}
+
+Status ColumnarReader::ReadChunk(int column, int chunk, Tensor* values,
+                                 Tensor* row_splits) const {
+  TF_RETURN_IF_ERROR(status_);
+  if (column < 0 || column >= index_.columns_size()) {
+    return errors::InvalidArgument("Column ", column, " out of range [0, ",
+                                   index_.columns_size(), ")");
+  }
+  if (chunk < 0 || chunk >= num_chunks()) {
+    return errors::InvalidArgument("Chunk ", chunk, " out of range [0, ",
+                                   num_chunks(), ")");
+  }
+  const ColumnarColumnProto& column_proto = index_.columns(column);
+  const ColumnarChunkProto& chunk_proto = column_proto.chunks(chunk);
+  const int64 num_rows = chunk_num_rows(chunk);
+  const int64 num_values = chunk_proto.num_values();
+  if (num_values < 0) {
+    return errors::DataLoss("Negative number of values in chunk ", chunk,
+                            " of column '", column_proto.name(),
+                            "' of columnar file ", filename_);
+  }
+
+  if (chunk_proto.row_length() >= 0) {
+    if (chunk_proto.row_length() * num_rows != num_values) {
+      return errors::DataLoss("Chunk ", chunk, " of column '",
+                              column_proto.name(), "' of columnar file ",
+                              filename_, " has ", num_values,
+                              " values, which is not ", num_rows, " rows of ",
+                              chunk_proto.row_length());
+    }
+    *row_splits = Tensor(DT_INT64, TensorShape({num_rows + 1}));
+    auto splits = row_splits->vec<int64>();
+    for (int64 i = 0; i <= num_rows; ++i) {
+      splits(i) = i * chunk_proto.row_length();
+    }
+  } else {
+    TF_RETURN_IF_ERROR(MapRegion(column, chunk, kSplitsRegion, DT_INT64,
+                                 num_rows + 1, row_splits));
+    Status s = CheckSplits(*row_splits, num_values);
+    if (!s.ok()) {
+      return errors::DataLoss("Chunk ", chunk, " of column '",
+                              column_proto.name(), "' of columnar file ",
+                              filename_, ": ", s.error_message());
+    }
+  }
+
+  if (num_values == 0) {
+    *values = Tensor(column_proto.dtype(), TensorShape({0}));
+  } else if (column_proto.dtype() == DT_STRING) {
+    Tensor offsets;
+    TF_RETURN_IF_ERROR(MapRegion(column, chunk, kOffsetsRegion, DT_INT64,
+                                 num_values + 1, &offsets));
+    const auto o = offsets.vec<int64>();
+    Status s = CheckSplits(offsets, o(num_values));
+    if (!s.ok()) {
+      return errors::DataLoss("Chunk ", chunk, " of column '",
+                              column_proto.name(), "' of columnar file ",
+                              filename_, ": ", s.error_message());
+    }
+    Tensor bytes;
+    if (o(num_values) > 0) {
+      TF_RETURN_IF_ERROR(MapRegion(column, chunk, kValuesRegion, DT_UINT8,
+                                   o(num_values), &bytes));
+    }
+    *values = Tensor(DT_STRING, TensorShape({num_values}));
+    auto v = values->vec<string>();
+    const char* data = bytes.tensor_data().data();
+    for (int64 i = 0; i < num_values; ++i) {
+      v(i).assign(data + o(i), o(i + 1) - o(i));
+    }
+  } else {
+    TF_RETURN_IF_ERROR(MapRegion(column, chunk, kValuesRegion,
+                                 column_proto.dtype(), num_values, values));
+  }
+  return Status::OK();
+}
+
+Status ConvertTFRecordsToColumnar(Env* env,
+                                  const std::vector<string>& input_files,
+                                  const string& compression_type,
+                                  const string& output_file,
+                                  const ColumnarWriter::Options& options) {
+  ColumnarWriter writer(env, output_file, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  const io::RecordReaderOptions reader_options =
+      io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+  Example example;
+  string record;
+  for (const string& input_file : input_files) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_RETURN_IF_ERROR(env->NewRandomAccessFile(input_file, &file));
+    io::RecordReader reader(file.get(), reader_options);
+    uint64 offset = 0;
+    while (true) {
+      const uint64 record_offset = offset;
+      Status s = reader.ReadRecord(&offset, &record);
+      if (errors::IsOutOfRange(s)) break;
+      TF_RETURN_IF_ERROR(s);
+      if (!example.ParseFromString(record)) {
+        return errors::DataLoss("Record at offset ", record_offset, " of ",
+                                input_file, " is not a tf.Example");
+      }
+      TF_RETURN_IF_ERROR(writer.AddExample(example));
+    }
+  }
+  return writer.Finish();
+}
+
+}  // namespace tensorflow
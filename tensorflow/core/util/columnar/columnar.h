@@ -0,0 +1,194 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A columnar on-disk format for training data.
+//
+// tf.Example protos in TFRecord files have to be parsed again on every epoch,
+// even when a model only needs a few of their features. A columnar file
+// instead stores each feature as a column of raw little-endian values in a
+// MemmappedFileSystem package, so that reading a feature maps a slice of the
+// file.
+//
+// The rows of a file are split into chunks of ColumnarWriter::Options::
+// rows_per_chunk rows. Every column stores each chunk as an aligned region of
+// values; the rows of a chunk are described either by a single row length
+// (the "dense" case, where every row of the chunk has the same number of
+// values) or by an explicit region of row splits (the "ragged" case). The
+// index of chunks and columns is a ColumnarIndexProto; see
+// tensorflow/core/protobuf/columnar_format.proto.
+//
+// Typical usage:
+//
+//   ColumnarWriter writer(env, "/tmp/train.columnar");
+//   for (const Example& example : examples) {
+//     TF_RETURN_IF_ERROR(writer.AddExample(example));
+//   }
+//   TF_RETURN_IF_ERROR(writer.Finish());
+//
+//   ColumnarReader reader(env, "/tmp/train.columnar");
+//   TF_RETURN_IF_ERROR(reader.status());
+//   const int column = reader.FindColumn("label");
+//   for (int chunk = 0; chunk < reader.num_chunks(); ++chunk) {
+//     Tensor values, row_splits;
+//     TF_RETURN_IF_ERROR(
+//         reader.ReadChunk(column, chunk, &values, &row_splits));
+//     ...
+//   }
+//
+// Existing TFRecord files are converted with ConvertTFRecordsToColumnar(), or
+// the columnar_converter tool.
+
+#ifndef TENSORFLOW_UTIL_COLUMNAR_COLUMNAR_H_
+#define TENSORFLOW_UTIL_COLUMNAR_COLUMNAR_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/columnar_format.pb.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+
+namespace tensorflow {
+
+// Writes tf.Examples into a columnar file, one row per Example and one column
+// per feature name.
+//
+// Features that are missing from an Example yield a row without values. A
+// feature must have the same kind (float, int64 or bytes) in every Example.
+//
+// All chunk data is buffered in memory until the chunk is complete, so
+// rows_per_chunk should be chosen such that a chunk of all columns fits in
+// memory comfortably.
+//
+// Not thread-safe.
+class ColumnarWriter {
+ public:
+  struct Options {
+    Options() {}
+    // The number of rows per chunk. Larger chunks mean fewer, larger
+    // regions; readers that batch across chunk boundaries have to copy.
+    int64 rows_per_chunk = 16384;
+  };
+
+  ColumnarWriter(Env* env, const string& filename,
+                 const Options& options = Options());
+  ~ColumnarWriter();
+
+  // Appends the features of "example" as a new row.
+  Status AddExample(const Example& example);
+
+  // Writes out the last chunk and the index, and closes the file. The writer
+  // cannot be used afterwards.
+  Status Finish();
+
+  // The number of rows added so far.
+  int64 num_rows() const { return num_rows_; }
+
+  // Returns the first error encountered.
+  Status status() const { return status_; }
+
+ private:
+  struct Column;
+
+  Status WriteChunk();
+
+  const Options options_;
+  Status status_;
+  MemmappedFileSystemWriter writer_;
+  ColumnarIndexProto index_;
+  std::unordered_map<string, int> column_ids_;
+  // The values of the current chunk, parallel to index_.columns().
+  std::vector<std::unique_ptr<Column>> columns_;
+  int64 chunk_rows_ = 0;
+  int64 num_rows_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarWriter);
+};
+
+// Reads a columnar file written by ColumnarWriter.
+//
+// The file is mapped into memory, so it must live on a file system that
+// implements NewReadOnlyMemoryRegionFromFile(). Only the regions of the
+// columns that are read are ever paged in.
+//
+// Thread-safe.
+class ColumnarReader {
+ public:
+  ColumnarReader(Env* env, const string& filename);
+  ~ColumnarReader();
+
+  // Is ok() iff the reader was constructed successfully.
+  Status status() const { return status_; }
+
+  const ColumnarIndexProto& index() const { return index_; }
+  int num_chunks() const { return index_.chunk_num_rows_size(); }
+  int64 chunk_num_rows(int chunk) const {
+    return index_.chunk_num_rows(chunk);
+  }
+  int64 num_rows() const { return num_rows_; }
+
+  // Returns the position of column "name" in index().columns(), or -1 if the
+  // file has no such column.
+  int FindColumn(StringPiece name) const;
+
+  // Reads chunk "chunk" of column "column". On success, "*values" holds the
+  // vector of chunk_num_rows(chunk) rows' values, and "*row_splits" the
+  // chunk_num_rows(chunk) + 1 int64 offsets of the rows' first values in
+  // "*values".
+  //
+  // Numeric values and stored row splits alias the mapped file when they are
+  // suitably aligned, which they are unless the platform requires an
+  // alignment larger than Allocator::kAllocatorAlignment. Such tensors keep
+  // the mapping alive after the reader is destroyed, and must not be
+  // modified.
+  Status ReadChunk(int column, int chunk, Tensor* values,
+                   Tensor* row_splits) const;
+
+ private:
+  // Returns a tensor of "num_elements" elements of "dtype" that aliases
+  // region "suffix" of chunk "chunk" of column "column".
+  Status MapRegion(int column, int chunk, StringPiece suffix, DataType dtype,
+                   int64 num_elements, Tensor* tensor) const;
+
+  const string filename_;
+  Status status_;
+  std::shared_ptr<MemmappedFileSystem> fs_;
+  ColumnarIndexProto index_;
+  std::unordered_map<string, int> column_ids_;
+  int64 num_rows_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarReader);
+};
+
+// Converts the serialized tf.Examples in the TFRecord files "input_files" into
+// the columnar file "output_file". "compression_type" is the compression of
+// the input files, as accepted by io::RecordReaderOptions.
+Status ConvertTFRecordsToColumnar(Env* env,
+                                  const std::vector<string>& input_files,
+                                  const string& compression_type,
+                                  const string& output_file,
+                                  const ColumnarWriter::Options& options);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_COLUMNAR_COLUMNAR_H_
@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Converts TFRecord files of serialized tf.Examples into a columnar file that
+// can be read with ColumnarDataset.
+//
+//  tensorflow/core/util/columnar/columnar_converter
+//        --input=/data/train-*.tfrecord --output=/data/train.columnar
+//
+// Parameters:
+// input - comma-separated list of the input files or file patterns.
+// output - name of the output columnar file.
+// compression_type - compression of the input files: "", "ZLIB", "GZIP" or
+// "BLOCK_ZLIB".
+// rows_per_chunk - the number of rows in each chunk of the output.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/columnar/columnar.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+int ParseFlagsAndConvert(int argc, char* argv[]) {
+  string input = "";
+  string output = "";
+  string compression_type = "";
+  ColumnarWriter::Options options;
+  std::vector<Flag> flag_list = {
+      Flag("input", &input, "comma-separated input files or file patterns"),
+      Flag("output", &output, "output columnar file"),
+      Flag("compression_type", &compression_type,
+           "compression of the input files"),
+      Flag("rows_per_chunk", &options.rows_per_chunk,
+           "number of rows in each chunk of the output"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(usage.c_str(), &argc, &argv);
+  if (!parse_result) {
+    LOG(ERROR) << "\n" << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+  if (input.empty()) {
+    LOG(ERROR) << "input can't be empty";
+    return -1;
+  }
+  if (output.empty()) {
+    LOG(ERROR) << "output can't be empty";
+    return -1;
+  }
+  std::vector<string> input_files;
+  for (const string& pattern : str_util::Split(input, ',')) {
+    std::vector<string> matches;
+    const Status status = Env::Default()->GetMatchingPaths(pattern, &matches);
+    if (!status.ok()) {
+      LOG(ERROR) << "Can't match " << pattern << ": " << status;
+      return -1;
+    }
+    if (matches.empty()) {
+      LOG(ERROR) << "No files match " << pattern;
+      return -1;
+    }
+    std::sort(matches.begin(), matches.end());
+    input_files.insert(input_files.end(), matches.begin(), matches.end());
+  }
+  const Status result = ConvertTFRecordsToColumnar(
+      Env::Default(), input_files, compression_type, output, options);
+  if (!result.ok()) {
+    LOG(ERROR) << "Conversion failed " << result.error_message();
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::ParseFlagsAndConvert(argc, argv);
+}
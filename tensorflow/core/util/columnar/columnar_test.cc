@@ -0,0 +1,234 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/columnar/columnar.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+// Row i has a float feature "dense" with values {i, 2i, 3i}, an int64 feature
+// "ragged" with i values, a bytes feature "bytes" with one value, and from
+// row 6 on an int64 feature "late" with value i.
+Example MakeExample(int i) {
+  Example example;
+  auto* features = example.mutable_features()->mutable_feature();
+  auto* dense = (*features)["dense"].mutable_float_list();
+  for (int j = 1; j <= 3; ++j) {
+    dense->add_value(i * j);
+  }
+  auto* ragged = (*features)["ragged"].mutable_int64_list();
+  for (int j = 0; j < i; ++j) {
+    ragged->add_value(100 * i + j);
+  }
+  (*features)["bytes"].mutable_bytes_list()->add_value(string(i, 'a' + i));
+  if (i >= 6) {
+    (*features)["late"].mutable_int64_list()->add_value(i);
+  }
+  return example;
+}
+
+Status WriteExamples(const string& filename, int num_rows,
+                     int64 rows_per_chunk) {
+  ColumnarWriter::Options options;
+  options.rows_per_chunk = rows_per_chunk;
+  ColumnarWriter writer(Env::Default(), filename, options);
+  for (int i = 0; i < num_rows; ++i) {
+    TF_RETURN_IF_ERROR(writer.AddExample(MakeExample(i)));
+  }
+  return writer.Finish();
+}
+
+// Reads all rows of column "name" into one vector of values and row splits.
+template <typename T>
+void ReadColumn(const ColumnarReader& reader, const string& name,
+                std::vector<T>* values, std::vector<int64>* row_splits) {
+  const int column = reader.FindColumn(name);
+  ASSERT_GE(column, 0) << name;
+  row_splits->assign(1, 0);
+  for (int chunk = 0; chunk < reader.num_chunks(); ++chunk) {
+    Tensor chunk_values, chunk_splits;
+    TF_ASSERT_OK(
+        reader.ReadChunk(column, chunk, &chunk_values, &chunk_splits));
+    ASSERT_EQ(reader.chunk_num_rows(chunk) + 1, chunk_splits.NumElements());
+    const int64 base = values->size();
+    for (int64 i = 0; i < chunk_values.NumElements(); ++i) {
+      values->push_back(chunk_values.vec<T>()(i));
+    }
+    for (int64 i = 1; i < chunk_splits.NumElements(); ++i) {
+      row_splits->push_back(base + chunk_splits.vec<int64>()(i));
+    }
+  }
+}
+
+TEST(ColumnarTest, WriteAndRead) {
+  const string filename = Prefix("write_and_read");
+  TF_ASSERT_OK(WriteExamples(filename, 10, 4));
+
+  ColumnarReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(10, reader.num_rows());
+  ASSERT_EQ(3, reader.num_chunks());
+  EXPECT_EQ(4, reader.chunk_num_rows(0));
+  EXPECT_EQ(4, reader.chunk_num_rows(1));
+  EXPECT_EQ(2, reader.chunk_num_rows(2));
+  EXPECT_EQ(-1, reader.FindColumn("missing"));
+
+  std::vector<float> dense;
+  std::vector<int64> dense_splits;
+  ReadColumn(reader, "dense", &dense, &dense_splits);
+  ASSERT_EQ(30, dense.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(3 * i, dense_splits[i]);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_EQ(i * (j + 1), dense[3 * i + j]);
+    }
+  }
+  // Dense columns store a row length instead of row splits.
+  const ColumnarColumnProto& dense_proto =
+      reader.index().columns(reader.FindColumn("dense"));
+  for (const ColumnarChunkProto& chunk : dense_proto.chunks()) {
+    EXPECT_EQ(3, chunk.row_length());
+  }
+
+  std::vector<int64> ragged;
+  std::vector<int64> ragged_splits;
+  ReadColumn(reader, "ragged", &ragged, &ragged_splits);
+  ASSERT_EQ(11, ragged_splits.size());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(i, ragged_splits[i + 1] - ragged_splits[i]);
+    for (int j = 0; j < i; ++j) {
+      EXPECT_EQ(100 * i + j, ragged[ragged_splits[i] + j]);
+    }
+  }
+
+  std::vector<string> bytes;
+  std::vector<int64> bytes_splits;
+  ReadColumn(reader, "bytes", &bytes, &bytes_splits);
+  ASSERT_EQ(10, bytes.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(string(i, 'a' + i), bytes[i]);
+  }
+
+  // Rows before the column appeared have no values.
+  std::vector<int64> late;
+  std::vector<int64> late_splits;
+  ReadColumn(reader, "late", &late, &late_splits);
+  EXPECT_EQ(std::vector<int64>({6, 7, 8, 9}), late);
+  EXPECT_EQ(std::vector<int64>({0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4}),
+            late_splits);
+}
+
+TEST(ColumnarTest, ValuesOutliveReader) {
+  const string filename = Prefix("values_outlive_reader");
+  TF_ASSERT_OK(WriteExamples(filename, 5, 100));
+  Tensor values, row_splits;
+  {
+    ColumnarReader reader(Env::Default(), filename);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.ReadChunk(reader.FindColumn("ragged"), 0, &values,
+                                  &row_splits));
+  }
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>({100, 200, 201, 300, 301, 302, 400, 401, 402, 403}),
+      values);
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({0, 0, 1, 3, 6, 10}),
+                                 row_splits);
+}
+
+TEST(ColumnarTest, EmptyFile) {
+  const string filename = Prefix("empty");
+  TF_ASSERT_OK(WriteExamples(filename, 0, 4));
+  ColumnarReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(0, reader.num_rows());
+  EXPECT_EQ(0, reader.num_chunks());
+  EXPECT_EQ(-1, reader.FindColumn("dense"));
+}
+
+TEST(ColumnarTest, MismatchedFeatureType) {
+  const string filename = Prefix("mismatched_feature_type");
+  ColumnarWriter writer(Env::Default(), filename);
+  TF_ASSERT_OK(writer.AddExample(MakeExample(1)));
+  Example bad = MakeExample(2);
+  (*bad.mutable_features()->mutable_feature())["dense"]
+      .mutable_int64_list()
+      ->add_value(1);
+  const Status s = writer.AddExample(bad);
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.code());
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("'dense'"))
+      << s.error_message();
+  // The bad Example was not added.
+  TF_ASSERT_OK(writer.AddExample(MakeExample(3)));
+  EXPECT_EQ(2, writer.num_rows());
+  TF_ASSERT_OK(writer.Finish());
+
+  ColumnarReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  std::vector<float> dense;
+  std::vector<int64> dense_splits;
+  ReadColumn(reader, "dense", &dense, &dense_splits);
+  EXPECT_EQ(std::vector<float>({1, 2, 3, 3, 6, 9}), dense);
+}
+
+TEST(ColumnarTest, NotAColumnarFile) {
+  const string filename = Prefix("not_a_columnar_file");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "not columnar"));
+  ColumnarReader reader(Env::Default(), filename);
+  EXPECT_EQ(error::DATA_LOSS, reader.status().code());
+}
+
+TEST(ColumnarTest, ConvertTFRecords) {
+  const string input_prefix = Prefix("convert_input");
+  std::vector<string> input_files;
+  int row = 0;
+  for (int file = 0; file < 2; ++file) {
+    input_files.push_back(strings::StrCat(input_prefix, file));
+    std::unique_ptr<WritableFile> output;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(input_files.back(), &output));
+    io::RecordWriter writer(
+        output.get(), io::RecordWriterOptions::CreateRecordWriterOptions(""));
+    for (int i = 0; i < 7; ++i) {
+      TF_ASSERT_OK(writer.WriteRecord(MakeExample(row++).SerializeAsString()));
+    }
+  }
+
+  const string filename = Prefix("converted");
+  ColumnarWriter::Options options;
+  options.rows_per_chunk = 5;
+  TF_ASSERT_OK(ConvertTFRecordsToColumnar(Env::Default(), input_files, "",
+                                          filename, options));
+  ColumnarReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(14, reader.num_rows());
+  EXPECT_EQ(3, reader.num_chunks());
+  std::vector<int64> late;
+  std::vector<int64> late_splits;
+  ReadColumn(reader, "late", &late, &late_splits);
+  EXPECT_EQ(std::vector<int64>({6, 7, 8, 9, 10, 11, 12, 13}), late);
+}
+
+}  // namespace
+}  // namespace tensorflow
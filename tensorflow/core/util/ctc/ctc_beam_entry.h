@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_CTC_CTC_BEAM_ENTRY_H_
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -75,6 +76,47 @@ struct BeamEntry {
       ++ci;
     }
   }
+  // Like PopulateChildren(L), but reuses a children vector released by
+  // ReleaseChildren() into "free_list" when one is available, so a decoder
+  // that is reset between sequences does not allocate in steady state.
+  void PopulateChildren(int L, std::vector<std::vector<BeamEntry>>* free_list) {
+    CHECK(!HasChildren());
+    while (!free_list->empty() && free_list->back().size() != static_cast<size_t>(L)) {
+      free_list->pop_back();
+    }
+    if (free_list->empty()) {
+      PopulateChildren(L);
+      return;
+    }
+    children.swap(free_list->back());
+    free_list->pop_back();
+    int ci = 0;
+    for (auto& c : children) {
+      c.parent = this;
+      c.label = ci;
+      c.oldp.Reset();
+      c.newp.Reset();
+      c.state = CTCBeamState();
+      ++ci;
+    }
+  }
+  // Moves the children vectors of this entry and all of its descendants to
+  // "free_list". Moving a vector keeps its buffer, so the entries stay put
+  // while the rest of the tree is walked.
+  void ReleaseChildren(std::vector<std::vector<BeamEntry>>* free_list) {
+    std::vector<BeamEntry*> stack = {this};
+    while (!stack.empty()) {
+      BeamEntry* e = stack.back();
+      stack.pop_back();
+      for (auto& c : e->children) {
+        if (c.HasChildren()) stack.push_back(&c);
+      }
+      if (e->HasChildren()) {
+        free_list->push_back(std::move(e->children));
+        e->children.clear();
+      }
+    }
+  }
   inline std::vector<BeamEntry>* Children() {
     CHECK(HasChildren());
     return &children;
@@ -33,6 +33,10 @@ namespace ctc {
 // be subclassed and provided as an argument to CTCBeamSearchDecoder, if complex
 // scoring is required. Its main purpose is to provide a thin layer for
 // integrating language model scoring easily.
+// A scorer may be shared by decoders running concurrently on different
+// threads, e.g. when CTCBeamSearchDecoderOp decodes batch entries in
+// parallel. Its methods are const and any per-beam data belongs in
+// CTCBeamState; a scorer with mutable caches must synchronize them itself.
 template <typename CTCBeamState>
 class BaseBeamScorer {
  public:
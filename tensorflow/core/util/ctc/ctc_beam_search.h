@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <cmath>
 #include <memory>
+#include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/lib/core/errors.h"
@@ -113,7 +114,9 @@ class CTCBeamSearchDecoder : public CTCDecoder {
     label_selection_margin_ = label_selection_margin;
   }
 
-  // Reset the beam search
+  // Reset the beam search. The beam entries of the previous sequence are kept
+  // and reused, so a decoder can be reused across sequences without
+  // allocating once it has warmed up.
   void Reset();
 
   // Extract the top n paths at current time step
@@ -140,6 +143,13 @@ class CTCBeamSearchDecoder : public CTCDecoder {
   std::unique_ptr<BeamEntry> beam_root_;
   BaseBeamScorer<CTCBeamState>* beam_scorer_;
 
+  // Scratch storage reused by Step(), and children vectors of entries from
+  // previous sequences that PopulateChildren() can recycle.
+  std::vector<BeamEntry*> branches_;
+  Eigen::ArrayXf input_;
+  std::vector<float> label_selection_scratch_;
+  std::vector<std::vector<BeamEntry>> free_children_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
 };
 
@@ -174,10 +184,9 @@ Status CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Decode(
     }  // for (int t...
 
     // O(n * log(n))
-    std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+    leaves_.ExtractNondestructive(&branches_);
     leaves_.Reset();
-    for (int i = 0; i < branches->size(); ++i) {
-      BeamEntry* entry = (*branches)[i];
+    for (BeamEntry* entry : branches_) {
       beam_scorer_->ExpandStateEnd(&entry->state);
       entry->newp.total +=
           beam_scorer_->GetStateEndExpansionScore(entry->state);
@@ -206,14 +215,19 @@ template <typename CTCBeamState, typename CTCBeamComparer>
 template <typename Vector>
 void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     const Vector& raw_input) {
-  Eigen::ArrayXf input = raw_input;
+  Eigen::ArrayXf& input = input_;
+  input.resize(raw_input.size());
+  for (int i = 0; i < input.size(); ++i) {
+    input(i) = raw_input(i);
+  }
   // Remove the max for stability when performing log-prob calculations.
   input -= input.maxCoeff();
 
   // Minimum allowed input value for label selection:
   float label_selection_input_min = -std::numeric_limits<float>::infinity();
   if (label_selection_size_ > 0 && label_selection_size_ < input.size()) {
-    std::vector<float> input_copy(input.data(), input.data() + input.size());
+    std::vector<float>& input_copy = label_selection_scratch_;
+    input_copy.assign(input.data(), input.data() + input.size());
     std::nth_element(input_copy.begin(),
                      input_copy.begin() + label_selection_size_ - 1,
                      input_copy.end(), [](float a, float b) { return a > b; });
@@ -228,15 +242,15 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // Extract the beams sorted in decreasing new probability
   CHECK_EQ(num_classes_, input.size());
 
-  std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+  leaves_.ExtractNondestructive(&branches_);
   leaves_.Reset();
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // P(.. @ t) becomes the new P(.. @ t-1)
     b->oldp = b->newp;
   }
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     if (b->parent != nullptr) {  // if not the root
       if (b->parent->Active()) {
         // If last two sequence characters are identical:
@@ -270,7 +284,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // originally in descending newp order and we copied newp to oldp.
 
   // Grow new leaves
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // A new leaf (represented by its BeamProbability) is a candidate
     // iff its total probability is nonzero and either the beam list
     // isn't full, or the lowest probability entry in the beam has a
@@ -286,7 +300,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     }
 
     if (!b->HasChildren()) {
-      b->PopulateChildren(num_classes_ - 1);
+      b->PopulateChildren(num_classes_ - 1, &free_children_);
     }
 
     for (BeamEntry& c : *b->Children()) {
@@ -334,8 +348,16 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   leaves_.Reset();
 
   // This beam root, and all of its children, will be in memory until
-  // the next reset.
-  beam_root_.reset(new BeamEntry(nullptr, -1, num_classes_ - 1, -1));
+  // the next reset, which hands the children back to free_children_.
+  if (beam_root_ == nullptr) {
+    beam_root_.reset(new BeamEntry(nullptr, -1, num_classes_ - 1, -1));
+  } else {
+    beam_root_->ReleaseChildren(&free_children_);
+    beam_root_->oldp.Reset();
+    beam_root_->newp.Reset();
+    beam_root_->state = CTCBeamState();
+    beam_root_->PopulateChildren(num_classes_ - 1, &free_children_);
+  }
   beam_root_->newp.total = 0.0;  // ln(1)
   beam_root_->newp.blank = 0.0;  // ln(1)
 
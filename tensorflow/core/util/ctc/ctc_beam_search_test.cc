@@ -221,6 +221,55 @@ TEST(CtcBeamSearch, AllBeamElementsHaveFiniteScores) {
   }
 }
 
+TEST(CtcBeamSearch, ResetReusesBeamEntries) {
+  const int batch_size = 2;
+  const int timesteps = 4;
+  const int top_paths = 2;
+  const int num_classes = 4;
+
+  // The decoder is reset between batch entries, which recycles the beam
+  // entries of the first entry for the second one. Both entries hold the
+  // same sequence, so they must decode identically.
+  CTCBeamSearchDecoder<>::DefaultBeamScorer default_scorer;
+  CTCBeamSearchDecoder<> decoder(num_classes, 3, &default_scorer, batch_size);
+
+  int sequence_lengths[batch_size] = {timesteps, timesteps};
+  // Stored class-major, so that the column-major mapping below reads the
+  // same probabilities for both batch entries.
+  float input_data_mat[timesteps][num_classes][batch_size] = {
+      {{0.1, 0.1}, {0.6, 0.6}, {0.2, 0.2}, {0.1, 0.1}},
+      {{0.5, 0.5}, {0.1, 0.1}, {0.3, 0.3}, {0.1, 0.1}},
+      {{0.2, 0.2}, {0.2, 0.2}, {0.1, 0.1}, {0.5, 0.5}},
+      {{0.3, 0.3}, {0.4, 0.4}, {0.2, 0.2}, {0.1, 0.1}}};
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      for (int b = 0; b < batch_size; ++b) {
+        input_data_mat[t][c][b] = std::log(input_data_mat[t][c][b]);
+      }
+    }
+  }
+
+  Eigen::Map<const Eigen::ArrayXi> seq_len(&sequence_lengths[0], batch_size);
+  std::vector<Eigen::Map<const Eigen::MatrixXf>> inputs;
+  inputs.reserve(timesteps);
+  for (int t = 0; t < timesteps; ++t) {
+    inputs.emplace_back(&input_data_mat[t][0][0], batch_size, num_classes);
+  }
+
+  std::vector<CTCDecoder::Output> outputs(top_paths);
+  for (CTCDecoder::Output& output : outputs) {
+    output.resize(batch_size);
+  }
+  float score[batch_size][top_paths] = {{0.0}};
+  Eigen::Map<Eigen::MatrixXf> scores(&score[0][0], batch_size, top_paths);
+
+  EXPECT_TRUE(decoder.Decode(seq_len, inputs, &outputs, &scores).ok());
+  for (int path = 0; path < top_paths; ++path) {
+    EXPECT_EQ(outputs[path][0], outputs[path][1]);
+    EXPECT_FLOAT_EQ(scores(0, path), scores(1, path));
+  }
+}
+
 // A beam decoder to test label selection. It simply models N labels with
 // rapidly dropping off log-probability.
 
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "tensorflow/core/example/example.pb.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/presized_cuckoo_map.h"
@@ -60,6 +63,99 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+template <typename T>
+class LimitedArraySlice {
+ public:
+  LimitedArraySlice(T* begin, size_t num_elements)
+      : begin_(begin), current_(begin), end_(begin + num_elements) {}
+
+  // May return negative if there were push_back calls after slice was filled.
+  int64 EndDistance() const { return end_ - current_; }
+
+  // Attempts to push value to the back of this. If the slice has
+  // already been filled, this method has no effect on the underlying data, but
+  // it changes the number returned by EndDistance into negative values.
+  void push_back(T&& value) {
+    if (EndDistance() > 0) *current_ = std::move(value);
+    ++current_;
+  }
+
+  // The methods below let bulk decoders treat this like a vector: resize()
+  // past capacity() behaves like the same number of push_back calls, and only
+  // the first capacity() elements of data() may be written.
+  size_t size() const { return current_ - begin_; }
+  void resize(size_t size) { current_ = begin_ + size; }
+  size_t capacity() const { return end_ - begin_; }
+  T* data() { return begin_; }
+
+ private:
+  T* begin_;
+  T* current_;
+  T* end_;
+};
+
+// Grows "list" by "n" elements, and returns how many of the new elements,
+// starting at list->data() + initial size, may be written.
+template <typename Result>
+size_t GrowForBulkDecode(Result* list, size_t n) {
+  const size_t initial_size = list->size();
+  list->resize(initial_size + n);
+  const size_t writable_end = std::min(list->capacity(), initial_size + n);
+  return writable_end > initial_size ? writable_end - initial_size : 0;
+}
+
+// Returns the number of varints in the packed buffer [begin, end). Every
+// varint ends with its only byte that has the high bit clear, so this is a
+// branch-free loop the compiler can vectorize.
+inline size_t CountPackedVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p < end; ++p) {
+    count += (*p >> 7) ^ 1;
+  }
+  return count;
+}
+
+// Decodes "count" packed varints from [ptr, end) and stores the first
+// "writable" of them to "out". Returns false unless the varints exactly
+// cover the buffer.
+inline bool DecodePackedVarints(const uint8* ptr, const uint8* end,
+                                size_t count, size_t writable, int64* out) {
+  for (size_t i = 0; i < count; ++i) {
+    uint64 value;
+    if (ptr < end && *ptr < 0x80) {
+      // Fast path for small values, which dominate most int64 features.
+      value = *ptr++;
+    } else {
+      value = 0;
+      int shift = 0;
+      uint8 byte;
+      do {
+        if (ptr == end || shift >= 64) return false;
+        byte = *ptr++;
+        value |= static_cast<uint64>(byte & 0x7f) << shift;
+        shift += 7;
+      } while (byte & 0x80);
+    }
+    if (i < writable) out[i] = static_cast<int64>(value);
+  }
+  return ptr == end;
+}
+
+// Reads the payload of a packed field of "length" bytes without copying it.
+inline bool ReadPackedPayload(protobuf::io::CodedInputStream* stream,
+                              uint32 length, const uint8** payload) {
+  const void* ptr;
+  int size;
+  if (length == 0) {
+    *payload = nullptr;
+    return true;
+  }
+  if (!stream->GetDirectBufferPointer(&ptr, &size)) return false;
+  if (static_cast<uint32>(size) < length) return false;
+  *payload = static_cast<const uint8*>(ptr);
+  return stream->Skip(length);
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -139,15 +235,26 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          uint32 buffer32;
-          if (!stream.ReadLittleEndian32(&buffer32)) return false;
-          float_list->push_back(bit_cast<float>(buffer32));
+        if (packed_length % sizeof(float) != 0) return false;
+        const uint8* payload;
+        if (!ReadPackedPayload(&stream, packed_length, &payload)) return false;
+
+        // Decode the whole packed array at once instead of one float at a
+        // time; on little endian machines this is a single memcpy.
+        const size_t num_elements = packed_length / sizeof(float);
+        const size_t initial_size = float_list->size();
+        const size_t writable = GrowForBulkDecode(float_list, num_elements);
+        float* out = float_list->data() + initial_size;
+        if (port::kLittleEndian) {
+          if (writable > 0) std::memcpy(out, payload, writable * sizeof(float));
+        } else {
+          for (size_t i = 0; i < writable; ++i) {
+            uint32 buffer32;
+            protobuf::io::CodedInputStream::ReadLittleEndian32FromArray(
+                payload + i * sizeof(float), &buffer32);
+            out[i] = bit_cast<float>(buffer32);
+          }
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kFixed32Tag(1))) return false;
@@ -181,15 +288,18 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        const uint8* payload;
+        if (!ReadPackedPayload(&stream, packed_length, &payload)) return false;
+
+        // Count the varints first so that the result grows only once.
+        const uint8* payload_end = payload + packed_length;
+        const size_t num_elements = CountPackedVarints(payload, payload_end);
+        const size_t initial_size = int64_list->size();
+        const size_t writable = GrowForBulkDecode(int64_list, num_elements);
+        if (!DecodePackedVarints(payload, payload_end, num_elements, writable,
+                                 int64_list->data() + initial_size)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -418,6 +528,23 @@ struct SparseBuffer {
   std::vector<size_t> example_end_indices;
 };
 
+// Per-minibatch scratch space. It is reused across all the examples of a
+// minibatch, so that parsing an example does not allocate once the buffers
+// have grown to their working size.
+struct MiniBatchScratch {
+  explicit MiniBatchScratch(const Config& config)
+      : sparse_feature_last_example(config.sparse.size(), -1),
+        dense_feature_last_example(config.dense.size(), -1) {}
+
+  parsed::Example parsed_example;
+
+  // Index of the last example in which each feature was seen. The entries
+  // are only compared with the index of the current example, so they never
+  // need to be reset between examples.
+  std::vector<int64> sparse_feature_last_example;
+  std::vector<int64> dense_feature_last_example;
+};
+
 struct SeededHasher {
   uint64 operator()(StringPiece s) const {
     return Hash64(s.data(), s.size(), seed);
@@ -425,44 +552,26 @@ struct SeededHasher {
   uint64 seed{0xDECAFCAFFE};
 };
 
-template <typename T>
-class LimitedArraySlice {
- public:
-  LimitedArraySlice(T* begin, size_t num_elements)
-      : current_(begin), end_(begin + num_elements) {}
-
-  // May return negative if there were push_back calls after slice was filled.
-  int64 EndDistance() const { return end_ - current_; }
-
-  // Attempts to push value to the back of this. If the slice has
-  // already been filled, this method has no effect on the underlying data, but
-  // it changes the number returned by EndDistance into negative values.
-  void push_back(T&& value) {
-    if (EndDistance() > 0) *current_ = std::move(value);
-    ++current_;
-  }
-
- private:
-  T* current_;
-  T* end_;
-};
-
 Status FastParseSerializedExample(
     const string& serialized_example, const string& example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
-    SeededHasher hasher, std::vector<Tensor>* output_dense,
+    SeededHasher hasher, MiniBatchScratch* scratch,
+    std::vector<Tensor>* output_dense,
     std::vector<SparseBuffer>* output_varlen_dense,
     std::vector<SparseBuffer>* output_sparse) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
-  parsed::Example parsed_example;
+  parsed::Example& parsed_example = scratch->parsed_example;
+  parsed_example.clear();
   if (!ParseExample(serialized_example, &parsed_example)) {
     return errors::InvalidArgument("Could not parse example input, value: '",
                                    serialized_example, "'");
   }
-  std::vector<int64> sparse_feature_last_example(config.sparse.size(), -1);
-  std::vector<int64> dense_feature_last_example(config.dense.size(), -1);
+  std::vector<int64>& sparse_feature_last_example =
+      scratch->sparse_feature_last_example;
+  std::vector<int64>& dense_feature_last_example =
+      scratch->dense_feature_last_example;
 
   // Handle features present in the example.
   const size_t parsed_example_size = parsed_example.size();
@@ -932,11 +1041,21 @@ Status FastParseExample(const Config& config,
     varlen_dense_buffers[minibatch].resize(config.dense.size());
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
+    // Every example appends exactly one end index to each buffer.
+    for (SparseBuffer& buffer : sparse_buffers[minibatch]) {
+      buffer.example_end_indices.reserve(end - start);
+    }
+    for (size_t d = 0; d < config.dense.size(); ++d) {
+      if (!config.dense[d].variable_length) continue;
+      varlen_dense_buffers[minibatch][d].example_end_indices.reserve(end -
+                                                                     start);
+    }
+    MiniBatchScratch scratch(config);
     for (size_t e = start; e < end; ++e) {
       status_of_minibatch[minibatch] = FastParseSerializedExample(
           serialized[e],
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
-          config_index, hasher, &fixed_dense_values,
+          config_index, hasher, &scratch, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch]);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -166,6 +167,28 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedLargeLists) {
+  Example example;
+  auto& fmap = *example.mutable_features()->mutable_feature();
+  Int64List* int64_list = fmap["int64_list"].mutable_int64_list();
+  FloatList* float_list = fmap["float_list"].mutable_float_list();
+  for (int i = 0; i < 1000; ++i) {
+    // Mix one byte, multi byte and ten byte (negative) varints.
+    int64_list->add_value(i % 3 == 0 ? i : (i % 3 == 1 ? -i : i * 1000003LL));
+    float_list->add_value(i * 0.5f);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  // An int64_list whose packed payload ends in the middle of a varint.
+  Example example;
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01"
+      "\x80",
+      &example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -372,6 +395,43 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, DenseFloatShapeMismatch) {
+  Example example;
+  FloatList* float_list =
+      (*example.mutable_features()->mutable_feature())["dense"]
+          .mutable_float_list();
+  float_list->add_value(1.0);
+  float_list->add_value(2.0);
+  float_list->add_value(3.0);
+  const std::vector<string> serialized(4, Serialize(example));
+
+  FastParseExampleConfig config;
+  config.dense.push_back({"dense", DT_FLOAT, PartialTensorShape({2}),
+                          Tensor(DT_FLOAT, TensorShape({2})), false, 2});
+  Result result;
+  Status status = FastParseExample(config, serialized,
+                                   gtl::ArraySlice<string>(), nullptr, &result);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_TRUE(StringPiece(status.error_message())
+                  .contains("Number of float values != expected.  "
+                            "Values size: 3"))
+      << status;
+
+  // The same data fits a dense feature of three elements.
+  config.dense[0].shape = PartialTensorShape({3});
+  config.dense[0].default_value = Tensor(DT_FLOAT, TensorShape({3}));
+  config.dense[0].elements_per_stride = 3;
+  Result fitting_result;
+  TF_EXPECT_OK(FastParseExample(config, serialized, gtl::ArraySlice<string>(),
+                                nullptr, &fitting_result));
+  auto values = fitting_result.dense_values[0].matrix<float>();
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(1.0, values(i, 0));
+    EXPECT_EQ(2.0, values(i, 1));
+    EXPECT_EQ(3.0, values(i, 2));
+  }
+}
+
 }  // namespace
 
 }  // namespace example
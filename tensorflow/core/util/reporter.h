@@ -75,6 +75,10 @@ class TestReporter {
   Status Benchmark(int64 iters, double cpu_time, double wall_time,
                    double throughput);
 
+  // Add "value" under "name" to the extras of the Benchmark report.
+  // Only does something if the reporting env flag is set.
+  Status SetProperty(const string& name, double value);
+
   // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
   ~TestReporter() { Close().IgnoreError(); }  // Autoclose in destructor.
 
@@ -115,5 +115,27 @@ TEST(TestReporter, Benchmark) {
   EXPECT_EQ(benchmark_entry.throughput(), 3.0);
 }
 
+TEST(TestReporter, SetProperty) {
+  string fname =
+      strings::StrCat(testing::TmpDir(), "/test_reporter_benchmarks_");
+  TestReporter test_reporter(fname, "b2/3/4");
+  TF_EXPECT_OK(test_reporter.Initialize());
+  TF_EXPECT_OK(test_reporter.Benchmark(1, 1.0, 2.0, 3.0));
+  TF_EXPECT_OK(test_reporter.SetProperty("roofline_percent", 42.5));
+  TF_EXPECT_OK(test_reporter.Close());
+
+  string expected_fname = strings::StrCat(fname, "b2__3__4");
+  string read;
+  TF_EXPECT_OK(ReadFileToString(Env::Default(), expected_fname, &read));
+
+  BenchmarkEntries benchmark_entries;
+  ASSERT_TRUE(benchmark_entries.ParseFromString(read));
+  ASSERT_EQ(1, benchmark_entries.entry_size());
+  const BenchmarkEntry& benchmark_entry = benchmark_entries.entry(0);
+  const auto extra = benchmark_entry.extras().find("roofline_percent");
+  ASSERT_TRUE(extra != benchmark_entry.extras().end());
+  EXPECT_EQ(extra->second.double_value(), 42.5);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -196,6 +196,14 @@ void StatSummarizer::ProcessStepStats(const StepStats& step_stats) {
       detail->mem_used.UpdateStat(curr_node_mem);
       mem_total += curr_node_mem;
 
+      if (ns.has_hardware_counters()) {
+        const HardwareCounters& counters = ns.hardware_counters();
+        detail->cycles.UpdateStat(counters.cycles());
+        detail->instructions.UpdateStat(counters.instructions());
+        detail->cache_misses.UpdateStat(counters.cache_misses());
+        has_hardware_counters_ = true;
+      }
+
       ++detail->times_called;
 
       Validate(detail, ns);
@@ -240,6 +248,11 @@ std::string StatSummarizer::HeaderString(const string& title) const {
   InitField(stream, 8) << "[cdf%]";
   InitField(stream, 10) << "[mem KB]";
   InitField(stream, 9) << "[times called]";
+  if (has_hardware_counters_) {
+    InitField(stream, 10) << "[Mcycles]";
+    InitField(stream, 6) << "[IPC]";
+    InitField(stream, 12) << "[LLC misses]";
+  }
   stream << "\t"
          << "[Name]";
   return stream.str();
@@ -264,6 +277,23 @@ std::string StatSummarizer::ColumnString(const Detail& detail,
   InitField(stream, 7) << cdf_percentage << "%";
   InitField(stream, 10) << detail.mem_used.newest() / 1000.0;
   InitField(stream, 9) << times_called;
+  if (has_hardware_counters_) {
+    if (detail.cycles.empty()) {
+      InitField(stream, 10) << "-";
+      InitField(stream, 6) << "-";
+      InitField(stream, 12) << "-";
+    } else {
+      const double instructions_per_cycle =
+          detail.cycles.sum() > 0
+              ? static_cast<double>(detail.instructions.sum()) /
+                    detail.cycles.sum()
+              : 0.0;
+      InitField(stream, 10) << detail.cycles.avg() / 1e6;
+      InitField(stream, 6) << instructions_per_cycle;
+      InitField(stream, 12) << std::setprecision(0)
+                            << detail.cache_misses.avg();
+    }
+  }
   stream << "\t" << detail.name;
 
   return stream.str();
@@ -296,6 +326,10 @@ void StatSummarizer::OrderNodesByMetric(
       case BY_TYPE:
         stream << detail->type;
         break;
+      case BY_CACHE_MISSES:
+        stream << (detail->cache_misses.empty() ? 0.0
+                                                : detail->cache_misses.avg());
+        break;
       default:
         stream << "";
         break;
@@ -370,8 +404,21 @@ std::string StatSummarizer::GetStatsByNodeType() const {
   InitField(stream, 10) << "[avg ms]";
   InitField(stream, 11) << "[avg %]";
   InitField(stream, 11) << "[cdf %]";
+  // The cache misses per run of each node type.
+  std::map<string, double> node_type_map_cache_misses;
+  if (has_hardware_counters_) {
+    for (const auto& det : details_) {
+      const Detail& detail = det.second;
+      node_type_map_cache_misses[detail.type] +=
+          static_cast<double>(detail.cache_misses.sum()) / num_runs();
+    }
+  }
+
   InitField(stream, 10) << "[mem KB]";
   InitField(stream, 10) << "[times called]";
+  if (has_hardware_counters_) {
+    InitField(stream, 12) << "[LLC misses]";
+  }
   stream << std::endl;
 
   float cdf = 0.0f;
@@ -396,6 +443,10 @@ std::string StatSummarizer::GetStatsByNodeType() const {
     InitField(stream, 10) << cdf << "%";
     InitField(stream, 10) << memory;
     InitField(stream, 9) << node_type_map_times_called[node_type];
+    if (has_hardware_counters_) {
+      InitField(stream, 12) << std::setprecision(0)
+                            << node_type_map_cache_misses[node_type];
+    }
     stream << std::endl;
   }
   stream << std::endl;
@@ -442,6 +493,10 @@ std::string StatSummarizer::GetOutputString() const {
     stream << GetStatsByMetric("Top by Memory Use", BY_MEMORY,
                                options_.memory_limit);
   }
+  if (options_.show_cache_misses && has_hardware_counters_) {
+    stream << GetStatsByMetric("Top by Cache Misses", BY_CACHE_MISSES,
+                               options_.cache_misses_limit);
+  }
   if (options_.show_type) {
     stream << GetStatsByNodeType();
   }
@@ -119,7 +119,9 @@ class StatSummarizerOptions {
         show_memory(true),
         memory_limit(10),
         show_type(true),
-        show_summary(true) {}
+        show_summary(true),
+        show_cache_misses(false),
+        cache_misses_limit(10) {}
 
   bool show_run_order;
   int run_order_limit;
@@ -129,6 +131,13 @@ class StatSummarizerOptions {
   int memory_limit;
   bool show_type;
   bool show_summary;
+  // Lists the nodes by cache misses, if the step stats have hardware
+  // counters (see RunOptions.collect_hardware_counters). Tools that run the
+  // steps should request the counters when this is set. Whenever there are
+  // counters, the node tables also show the cycles, instructions per cycle
+  // and cache misses of the nodes.
+  bool show_cache_misses;
+  int cache_misses_limit;
 };
 
 // A StatSummarizer assists in performance analysis of Graph executions.
@@ -146,6 +155,7 @@ class StatSummarizer {
     BY_TIME,
     BY_MEMORY,
     BY_TYPE,
+    BY_CACHE_MISSES,
   };
 
   explicit StatSummarizer(const StatSummarizerOptions& options);
@@ -185,6 +195,7 @@ class StatSummarizer {
     run_total_us_.Reset();
     memory_.Reset();
     details_.clear();
+    has_hardware_counters_ = false;
   }
 
   // Returns number of runs.
@@ -193,6 +204,8 @@ class StatSummarizer {
   // Returns stats of total microseconds spent by all nodes in each run.
   const Stat<int64>& run_total_us() const { return run_total_us_; }
 
+  const StatSummarizerOptions& options() const { return options_; }
+
  private:
   struct Detail {
     string name;
@@ -201,6 +214,10 @@ class StatSummarizer {
     Stat<int64> start_us;
     Stat<int64> rel_end_us;
     Stat<int64> mem_used;
+    // Empty unless the step stats have hardware counters.
+    Stat<int64> cycles;
+    Stat<int64> instructions;
+    Stat<int64> cache_misses;
     std::vector<TensorDescription> outputs;
     int64 times_called;
   };
@@ -220,6 +237,8 @@ class StatSummarizer {
 
   std::map<std::string, Detail> details_;
   StatSummarizerOptions options_;
+  // True iff some node stats had hardware counters.
+  bool has_hardware_counters_ = false;
 };
 
 }  // namespace tensorflow
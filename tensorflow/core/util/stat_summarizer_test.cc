@@ -82,6 +82,64 @@ versions {
   ASSERT_TRUE(output.find("myconstant") != std::string::npos) << output;
   // stats by node type should include the type.
   ASSERT_TRUE(by_node_type.find("Const") != std::string::npos) << by_node_type;
+  // There are no hardware counters unless requested.
+  EXPECT_EQ(std::string::npos, output.find("Cache Misses")) << output;
+}
+
+TEST(StatSummarizerTest, ShowsHardwareCounters) {
+  const std::string step_stats_str(R"EOF(
+dev_stats {
+  device: "/job:localhost/replica:0/task:0/cpu:0"
+  node_stats {
+    node_name: "few_misses"
+    all_start_micros: 100
+    all_end_rel_micros: 20
+    timeline_label: "few_misses = MatMul(a, b)"
+    hardware_counters {
+      cycles: 4000000
+      instructions: 10000000
+      cache_misses: 12
+    }
+  }
+  node_stats {
+    node_name: "many_misses"
+    all_start_micros: 120
+    all_end_rel_micros: 10
+    timeline_label: "many_misses = Add(c, d)"
+    hardware_counters {
+      cycles: 2000000
+      instructions: 1000000
+      cache_misses: 3456
+    }
+  }
+}
+  )EOF");
+  StepStats step_stats;
+  ASSERT_TRUE(
+      protobuf::TextFormat::ParseFromString(step_stats_str, &step_stats));
+
+  StatSummarizerOptions opts;
+  opts.show_run_order = false;
+  opts.show_time = false;
+  opts.show_memory = false;
+  opts.show_summary = false;
+  opts.show_cache_misses = true;
+  StatSummarizer stats(opts);
+  stats.ProcessStepStats(step_stats);
+  const std::string output = stats.GetOutputString();
+
+  const std::string::size_type section = output.find("Top by Cache Misses");
+  ASSERT_NE(std::string::npos, section) << output;
+  EXPECT_LT(output.find("many_misses", section),
+            output.find("few_misses", section))
+      << output;
+  // Instructions per cycle.
+  EXPECT_NE(std::string::npos, output.find("2.500")) << output;
+  EXPECT_NE(std::string::npos, output.find("3456")) << output;
+  // The summary by node type also has the cache misses.
+  const std::string by_node_type = stats.GetStatsByNodeType();
+  EXPECT_NE(std::string::npos, by_node_type.find("[LLC misses]"))
+      << by_node_type;
 }
 
 }  // namespace
@@ -255,6 +255,33 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// A read-only tensor buffer that aliases part of a memory-mapped data file.
+// Holds a reference to the mapping, which stays valid for as long as a
+// tensor refers to it.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t len)
+      : region_(std::move(region)), data_(data), len_(len) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("mmap");
+  }
+
+  // The mapped pages are read-only, so they must never be forwarded to an
+  // op that would update them in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const size_t len_;
+};
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -268,7 +295,11 @@ table::Options TableBuilderOptions() {
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix)
+    : BundleWriter(env, prefix, Options()) {}
+
+BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix.ToString()),
       tmp_metadata_path_(strings::StrCat(MetaFilename(prefix_), ".tempstate",
                                          random::New64())),
@@ -299,6 +330,15 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
     return status_;
   }
 
+  // Pads the data file up to the requested alignment.
+  if (options_.data_alignment > 1 && size_ % options_.data_alignment != 0) {
+    const size_t padding =
+        options_.data_alignment - size_ % options_.data_alignment;
+    status_ = out_->Append(string(padding, '\0'));
+    if (!status_.ok()) return status_;
+    size_ += padding;
+  }
+
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
@@ -592,7 +632,11 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // Interface for reading a tensor bundle.
 
 BundleReader::BundleReader(Env* env, StringPiece prefix)
+    : BundleReader(env, prefix, Options()) {}
+
+BundleReader::BundleReader(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix.ToString()),
       metadata_(nullptr),
       table_(nullptr),
@@ -671,7 +715,60 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
-Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+Status BundleReader::GetMappedShard(
+    int32 shard_id, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &mapped);
+    if (errors::IsUnimplemented(s)) {
+      VLOG(1) << "Memory-mapping is not supported for " << filename
+              << "; falling back to buffered reads.";
+    } else if (!s.ok()) {
+      return s;
+    }
+    it = mapped_data_
+             .emplace(shard_id,
+                      std::shared_ptr<ReadOnlyMemoryRegion>(mapped.release()))
+             .first;
+  }
+  *region = it->second;
+  return Status::OK();
+}
+
+Status BundleReader::GetMappedValue(
+    const BundleEntryProto& entry,
+    const std::shared_ptr<ReadOnlyMemoryRegion>& region, bool verify_checksum,
+    Tensor* ret) {
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::OutOfRange("Data file for key ", key(), " has ",
+                              region->length(), " bytes but the entry ends at ",
+                              entry.offset() + entry.size());
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  if (entry.size() > 0 &&
+      reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0) {
+    TensorBuffer* buf = new MappedTensorBuffer(region, data, entry.size());
+    *ret = Tensor(entry.dtype(), ret->shape(), buf);
+    buf->Unref();
+  } else if (entry.size() > 0) {
+    memcpy(const_cast<char*>(ret->tensor_data().data()), data, entry.size());
+  }
+  if (verify_checksum) {
+    const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+  }
+  return Status::OK();
+}
+
+Status BundleReader::GetValue(const BundleEntryProto& entry,
+                              bool verify_checksum, Tensor* val) {
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
@@ -700,6 +797,17 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
+  if (options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype())) {
+    std::shared_ptr<ReadOnlyMemoryRegion> region;
+    TF_RETURN_IF_ERROR(GetMappedShard(entry.shard_id(), &region));
+    if (region != nullptr) {
+      Status s = GetMappedValue(entry, region, verify_checksum, ret);
+      if (s.ok()) *val = *ret;
+      if (ret != val) delete ret;
+      return s;
+    }
+  }
+
   // Open the data file if it has not been opened.
   io::InputBuffer* buffered_file = data_[entry.shard_id()];
   if (buffered_file == nullptr) {
@@ -731,7 +839,7 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
         buffered_file, ret->NumElements(), entry.offset(), entry.size(),
         GetStringBackingBuffer(*ret), &actual_crc32c));
   }
-  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+  if (verify_checksum && crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
     return errors::DataLoss(
         "Checksum does not match: stored ",
         strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
@@ -749,7 +857,7 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
 
   if (entry.slices().empty()) {
-    return GetValue(entry, val);
+    return GetValue(entry, options_.verify_checksums, val);
   } else {
     return GetSliceValue(
         key, entry,
@@ -767,7 +875,7 @@ Status BundleReader::ReadCurrent(Tensor* val) {
   }
 
   if (entry.slices().empty()) {
-    return GetValue(entry, val);
+    return GetValue(entry, options_.verify_checksums, val);
   } else {
     return GetSliceValue(
         iter_->key(), entry,
@@ -869,12 +977,13 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
       VLOG(1) << "Optimized for common case: directly copying into "
                  "pre-allocated buffer; spec: "
               << slice_spec.DebugString();
-      status_ = GetValue(stored_slice_entry, val);
+      status_ = GetValue(stored_slice_entry, options_.verify_checksums, val);
       return status_;
     }
 
     Tensor stored_slice_tensor(stored_slice_entry.dtype(), stored_slice_shape);
-    status_ = GetValue(stored_slice_entry, &stored_slice_tensor);
+    status_ = GetValue(stored_slice_entry, options_.verify_checksums,
+                       &stored_slice_tensor);
     if (!status_.ok()) return status_;
 
     // Copies the intersection over.
@@ -909,6 +1018,29 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
   return Status::OK();
 }
 
+Status BundleReader::VerifyChecksums() {
+  TF_CHECK_OK(status_);
+  Seek(kHeaderEntryKey);
+  for (Next(); Valid(); Next()) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(ParseEntryProto(iter_->key(), iter_->value(), &entry));
+    if (!TensorShape::IsValid(entry.shape())) {
+      return errors::DataLoss("Invaid tensor shape: ", iter_->key(), " ",
+                              ProtoShortDebugString(entry.shape()));
+    }
+    // The entry of a partitioned tensor stores no data of its own; each of
+    // its slices has an entry of its own.
+    if (!entry.slices().empty()) continue;
+    Tensor val;
+    Status s = GetValue(entry, true /* verify_checksum */, &val);
+    if (!s.ok()) {
+      return Status(s.code(), strings::StrCat("Entry ", iter_->key(), ": ",
+                                              s.error_message()));
+    }
+  }
+  return iter_->status();
+}
+
 bool BundleReader::Contains(StringPiece key) {
   Seek(key);
   return Valid() && (this->key() == key);
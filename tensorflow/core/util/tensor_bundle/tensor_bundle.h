@@ -64,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -107,7 +108,16 @@ extern const char* const kHeaderEntryKey;
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
+  struct Options {
+    // Pads the data file with zeros so that every tensor starts at an offset
+    // that is a multiple of "data_alignment".  Use EIGEN_MAX_ALIGN_BYTES (or
+    // a multiple of it) to let a memory-mapping BundleReader alias the
+    // restored tensors instead of copying them.
+    int data_alignment = 1;
+  };
+
   BundleWriter(Env* env, StringPiece prefix);
+  BundleWriter(Env* env, StringPiece prefix, const Options& options);
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -140,6 +150,7 @@ class BundleWriter {
 
  private:
   Env* const env_;  // Not owned.
+  const Options options_;
   const string prefix_;
   const string tmp_metadata_path_;
   const string tmp_data_path_;
@@ -173,7 +184,23 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
+  struct Options {
+    // If true, memory-maps the data files (when the file system supports it)
+    // instead of reading them through a buffer.  Tensors of memcpy-able types
+    // whose stored offset is suitably aligned are then restored without a
+    // copy, by aliasing the mapped pages; other tensors are copied out of the
+    // mapping.  Aliased tensors are read-only, and keep the mapping alive
+    // after the reader is destroyed.
+    bool use_mmap = false;
+
+    // If false, Lookup() and friends do not validate the stored crc32c
+    // checksums, so that aliased tensors are not paged in eagerly.  The bundle
+    // can be validated later using VerifyChecksums().
+    bool verify_checksums = true;
+  };
+
   BundleReader(Env* const env, StringPiece prefix);
+  BundleReader(Env* const env, StringPiece prefix, const Options& options);
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -206,7 +233,10 @@ class BundleReader {
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
-  // Validates the stored crc32c checksum against the restored bytes.
+  // Validates the stored crc32c checksum against the restored bytes, unless
+  // the reader was constructed with "verify_checksums" unset.  In "use_mmap"
+  // mode, "val" may end up aliasing the mapped data file rather than being
+  // filled in place.
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
@@ -214,7 +244,7 @@ class BundleReader {
   //
   // On error, "val" may contain nonsense data.
   //
-  // Validates the stored crc32c checksum against the restored bytes.
+  // Validates the stored crc32c checksum as described for "Lookup()".
   // REQUIRES: status().ok() && Valid()
   Status ReadCurrent(Tensor* val) TF_MUST_USE_RESULT;
 
@@ -235,6 +265,13 @@ class BundleReader {
   Status LookupSlice(StringPiece full_tensor_key, const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
 
+  // Validates the stored crc32c checksums of all tensors in the bundle,
+  // regardless of the "verify_checksums" option.  Returns a DataLoss error
+  // naming the first corrupt entry.  Invalidates the reader's current
+  // position.
+  // REQUIRES: status().ok()
+  Status VerifyChecksums() TF_MUST_USE_RESULT;
+
   // Seeks to the first position in the bundle whose key is no less than "key".
   // REQUIRES: status().ok()
   void Seek(StringPiece key) { return iter_->Seek(key); }
@@ -262,10 +299,25 @@ class BundleReader {
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
   // Reads the tensor value described by the metadata proto "entry".
-  // Usage for "val" follows the comment of "Lookup()".
-  Status GetValue(const BundleEntryProto& entry,
+  // Usage for "val" follows the comment of "Lookup()".  Validates the stored
+  // checksum iff "verify_checksum" is true.
+  Status GetValue(const BundleEntryProto& entry, bool verify_checksum,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the value described by "entry" out of the memory-mapped data file
+  // "region", aliasing the mapping when the value is suitably aligned.
+  // "ret" must already have the stored dtype and shape.
+  Status GetMappedValue(const BundleEntryProto& entry,
+                        const std::shared_ptr<ReadOnlyMemoryRegion>& region,
+                        bool verify_checksum, Tensor* ret) TF_MUST_USE_RESULT;
+
+  // Returns in "*region" the memory-mapped data file "shard_id", mapping it
+  // on first use.  Sets "*region" to nullptr if the file system does not
+  // support memory-mapping.
+  Status GetMappedShard(int32 shard_id,
+                        std::shared_ptr<ReadOnlyMemoryRegion>* region)
+      TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -275,6 +327,7 @@ class BundleReader {
                        Tensor* val) TF_MUST_USE_RESULT;
 
   Env* env_;  // Not owned.
+  const Options options_;
   const string prefix_;
 
   Status status_;
@@ -283,6 +336,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The memory-mapped data files, in "use_mmap" mode.  A null entry marks a
+  // shard whose file system does not support memory-mapping.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
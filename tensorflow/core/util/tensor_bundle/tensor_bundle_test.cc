@@ -594,6 +594,91 @@ TEST(TensorBundleTest, Checksum) {
   }
 }
 
+TEST(TensorBundleTest, MemoryMapped) {
+  BundleWriter::Options writer_options;
+  writer_options.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap"), writer_options);
+    TF_EXPECT_OK(writer.Add("foo_000", Constant_2x3(0.f)));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("foo_002", Constant_2x3(2.0)));
+    TF_EXPECT_OK(writer.Add("foo_003", test::AsTensor<string>({"a", "bc"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap"), reader_options);
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "foo_000", Constant_2x3(0.f));
+  Expect<int>(&reader, "foo_001", Constant(1, TensorShape({3})));
+  Expect<double>(&reader, "foo_002", Constant_2x3(2.0));
+  Expect<string>(&reader, "foo_003", test::AsTensor<string>({"a", "bc"}));
+
+  // Aligned tensors alias the mapped data file, and outlive the reader.
+  Tensor aliased(DT_FLOAT, TensorShape({2, 3}));
+  Tensor copied = aliased;
+  {
+    BundleReader other(Env::Default(), Prefix("mmap"), reader_options);
+    TF_ASSERT_OK(other.Lookup("foo_000", &aliased));
+  }
+  EXPECT_NE(copied.tensor_data().data(), aliased.tensor_data().data());
+  test::ExpectTensorEqual<float>(aliased, Constant_2x3(0.f));
+}
+
+TEST(TensorBundleTest, MemoryMappedUnaligned) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("foo_000", Constant(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant_2x3(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"),
+                      reader_options);
+  TF_ASSERT_OK(reader.status());
+  // "foo_001" starts at offset 12, so it is copied out of the mapping into
+  // the caller's buffer.
+  Tensor val(DT_FLOAT, TensorShape({2, 3}));
+  const char* buffer = val.tensor_data().data();
+  TF_ASSERT_OK(reader.Lookup("foo_001", &val));
+  EXPECT_EQ(buffer, val.tensor_data().data());
+  test::ExpectTensorEqual<float>(val, Constant_2x3(2.f));
+}
+
+TEST(TensorBundleTest, LazyChecksum) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("lazy_checksum"));
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("strings", test::AsTensor<string>({"a", "bc"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_EXPECT_OK(
+      BundleReader(Env::Default(), Prefix("lazy_checksum")).VerifyChecksums());
+
+  // Corrupts the last byte of "foo".
+  const string datafile = DataFilename(Prefix("lazy_checksum"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), datafile, &data));
+  data[5] = ~data[5];
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), datafile, data));
+
+  for (bool use_mmap : {false, true}) {
+    BundleReader::Options options;
+    options.use_mmap = use_mmap;
+    options.verify_checksums = false;
+    BundleReader reader(Env::Default(), Prefix("lazy_checksum"), options);
+    TF_ASSERT_OK(reader.status());
+    Tensor val(DT_FLOAT, TensorShape({2, 3}));
+    TF_EXPECT_OK(reader.Lookup("foo", &val));
+
+    Status status = reader.VerifyChecksums();
+    EXPECT_TRUE(errors::IsDataLoss(status));
+    EXPECT_TRUE(StringPiece(status.ToString()).contains("Entry foo"));
+    EXPECT_TRUE(StringPiece(status.ToString()).contains("Checksum"));
+  }
+}
+
 TEST(TensorBundleTest, Endianness) {
   BundleWriter writer(Env::Default(), Prefix("end"));
   TF_EXPECT_OK(writer.Add("key", Constant_2x3<float>(1.0)));
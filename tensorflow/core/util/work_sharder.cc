@@ -15,8 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
 
 namespace tensorflow {
 
@@ -74,4 +79,87 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
   counter.Wait();
 }
 
+namespace {
+
+// All the calibrations, for LogShardCostCalibrations().
+mutex* CalibrationsMutex() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+std::vector<const ShardCostCalibration*>* Calibrations() {
+  static std::vector<const ShardCostCalibration*>* calibrations =
+      new std::vector<const ShardCostCalibration*>;
+  return calibrations;
+}
+
+}  // namespace
+
+ShardCostCalibration::ShardCostCalibration(const char* tag,
+                                           int64 estimated_cost_per_unit)
+    : tag_(tag),
+      estimated_cost_per_unit_(estimated_cost_per_unit),
+      measured_cost_per_unit_(0) {
+  mutex_lock l(*CalibrationsMutex());
+  Calibrations()->push_back(this);
+}
+
+ShardCostCalibration::~ShardCostCalibration() {
+  mutex_lock l(*CalibrationsMutex());
+  std::vector<const ShardCostCalibration*>* calibrations = Calibrations();
+  calibrations->erase(
+      std::find(calibrations->begin(), calibrations->end(), this));
+}
+
+int64 ShardCostCalibration::cost_per_unit() const {
+  const int64 measured = measured_cost_per_unit_.load(std::memory_order_relaxed);
+  return measured > 0 ? measured : estimated_cost_per_unit_;
+}
+
+void ShardCostCalibration::Record(int64 units, int64 cycles) {
+  // Platforms without a cycle counter measure nothing.
+  if (units <= 0 || cycles <= 0) return;
+  const int64 sample = std::max<int64>(1, cycles / units);
+  // An exponential moving average, which follows changes of the input sizes
+  // of the call site. Concurrent updates may lose samples, which is fine.
+  const int64 previous =
+      measured_cost_per_unit_.load(std::memory_order_relaxed);
+  const int64 average =
+      previous == 0 ? sample : previous + (sample - previous) / 8;
+  measured_cost_per_unit_.store(std::max<int64>(1, average),
+                                std::memory_order_relaxed);
+}
+
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           ShardCostCalibration* calibration,
+           std::function<void(int64, int64)> work) {
+  // Only the first shard is measured, so that the measurement doesn't
+  // include waiting for the others.
+  Shard(max_parallelism, workers, total, calibration->cost_per_unit(),
+        [calibration, &work](int64 start, int64 limit) {
+          if (start != 0) {
+            work(start, limit);
+            return;
+          }
+          const uint64 begin = profile_utils::CpuUtils::GetCurrentClockCycle();
+          work(start, limit);
+          const uint64 end = profile_utils::CpuUtils::GetCurrentClockCycle();
+          calibration->Record(limit - start, static_cast<int64>(end - begin));
+        });
+}
+
+void LogShardCostCalibrations(double max_ratio) {
+  mutex_lock l(*CalibrationsMutex());
+  for (const ShardCostCalibration* calibration : *Calibrations()) {
+    const double estimated =
+        std::max<int64>(1, calibration->estimated_cost_per_unit());
+    const double measured = calibration->cost_per_unit();
+    const double ratio = measured / estimated;
+    if (ratio > max_ratio || ratio * max_ratio < 1) {
+      LOG(INFO) << "Shard() cost of " << calibration->tag() << " is "
+                << measured << " per unit, estimated " << estimated;
+    }
+  }
+}
+
 }  // end namespace tensorflow
@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -48,6 +50,54 @@ namespace tensorflow {
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// Measures the cost per unit of work of a Shard() call site, for call sites
+// whose cost is hard to estimate. The estimate is used until the first call
+// is measured. After that, Shard() uses a running average of the CPU cycles
+// per unit spent on the first shard of each call. A call site typically keeps
+// one instance for the life of the process, e.g.:
+//
+//   static ShardCostCalibration* calibration =
+//       new ShardCostCalibration("MyOp", kEstimatedCostPerUnit);
+//   Shard(max_parallelism, workers, total, calibration, work);
+//
+// Thread-safe.
+class ShardCostCalibration {
+ public:
+  // "tag" names the call site in LogShardCostCalibrations(), and must
+  // outlive the calibration.
+  ShardCostCalibration(const char* tag, int64 estimated_cost_per_unit);
+  ~ShardCostCalibration();
+
+  const char* tag() const { return tag_; }
+  int64 estimated_cost_per_unit() const { return estimated_cost_per_unit_; }
+
+  // Returns the measured cost per unit, or the estimate if there is no
+  // measurement yet.
+  int64 cost_per_unit() const;
+
+  // Records that "units" units of work took "cycles" CPU cycles.
+  void Record(int64 units, int64 cycles);
+
+ private:
+  const char* const tag_;
+  const int64 estimated_cost_per_unit_;
+  // 0 until the first measurement.
+  std::atomic<int64> measured_cost_per_unit_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostCalibration);
+};
+
+// As above, but shards by the cost per unit of "calibration", and measures
+// the call to update it.
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           ShardCostCalibration* calibration,
+           std::function<void(int64, int64)> work);
+
+// Logs the calibrated call sites whose measured cost per unit differs from
+// their estimate by more than a factor of "max_ratio", to help fix the
+// estimates of the other call sites of the same kernels.
+void LogShardCostCalibrations(double max_ratio);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_UTIL_WORK_SHARDER_H_
@@ -76,6 +76,34 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(Shard, Calibration) {
+  ShardCostCalibration calibration("test", 1);
+  EXPECT_EQ(1, calibration.cost_per_unit());
+  calibration.Record(10, 10000);
+  EXPECT_EQ(1000, calibration.cost_per_unit());
+  // Later measurements move the average.
+  calibration.Record(10, 2000);
+  EXPECT_EQ(900, calibration.cost_per_unit());
+  // Empty measurements, e.g. without a cycle counter, are ignored.
+  calibration.Record(10, 0);
+  calibration.Record(0, 100);
+  EXPECT_EQ(900, calibration.cost_per_unit());
+  LogShardCostCalibrations(2.0);
+
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  for (auto workers : {1, 2, 4}) {
+    for (auto total : {0, 1, 100, 100000}) {
+      std::atomic<int64> num_elements(0);
+      Shard(workers, &threads, total, &calibration,
+            [&num_elements](int64 start, int64 limit) {
+              num_elements += limit - start;
+            });
+      EXPECT_EQ(num_elements.load(), total);
+    }
+  }
+  EXPECT_GE(calibration.cost_per_unit(), 1);
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -204,6 +204,118 @@ func (s *Session) NewPartialRun(feeds, fetches []Output, targets []*Operation) (
 	return pr, nil
 }
 
+// PreparedRun is a Session.Run call whose feeds, fetches and targets are bound
+// once, for callers that repeat the same call many times. It converts the
+// feed and fetch ports and the targets to C arrays when it is created, and
+// recycles the per-call arrays between calls, so that Run allocates little
+// more than the returned Tensors.
+//
+// A PreparedRun allows concurrent calls to Run. Feed Tensors are not modified
+// by Run and may be reused across calls, for example by refilling the memory
+// returned by their Data method.
+type PreparedRun struct {
+	session *Session
+
+	// C arrays, owned by the PreparedRun.
+	feeds    *C.TF_Output
+	fetches  *C.TF_Output
+	targets  **C.TF_Operation
+	nfeeds   int
+	nfetches int
+	ntargets int
+
+	// Pool of *preparedRunTensors.
+	tensors sync.Pool
+}
+
+// preparedRunTensors holds the input and output tensor arrays of one call to
+// PreparedRun.Run.
+type preparedRunTensors struct {
+	feeds   []*C.TF_Tensor
+	fetches []*C.TF_Tensor
+}
+
+// Prepare binds the feeds, fetches and targets of a Session.Run call. The
+// returned PreparedRun is fed with Tensors in the order of feeds, and returns
+// the Tensors of fetches in their order.
+func (s *Session) Prepare(feeds, fetches []Output, targets []*Operation) (*PreparedRun, error) {
+	s.mu.Lock()
+	closed := s.c == nil
+	s.mu.Unlock()
+	if closed {
+		return nil, errors.New("session is closed")
+	}
+	pr := &PreparedRun{
+		session:  s,
+		feeds:    newCOutputs(feeds),
+		fetches:  newCOutputs(fetches),
+		targets:  newCOperations(targets),
+		nfeeds:   len(feeds),
+		nfetches: len(fetches),
+		ntargets: len(targets),
+	}
+	pr.tensors.New = func() interface{} {
+		return &preparedRunTensors{
+			feeds:   make([]*C.TF_Tensor, pr.nfeeds),
+			fetches: make([]*C.TF_Tensor, pr.nfetches),
+		}
+	}
+	runtime.SetFinalizer(pr, func(pr *PreparedRun) {
+		C.free(unsafe.Pointer(pr.feeds))
+		C.free(unsafe.Pointer(pr.fetches))
+		C.free(unsafe.Pointer(pr.targets))
+	})
+	return pr, nil
+}
+
+// Run runs the prepared call with the Tensors in feeds, which must be in the
+// order of the feeds given to Prepare.
+func (pr *PreparedRun) Run(feeds []*Tensor) ([]*Tensor, error) {
+	if len(feeds) != pr.nfeeds {
+		return nil, fmt.Errorf("got %d feeds, the run was prepared with %d", len(feeds), pr.nfeeds)
+	}
+	s := pr.session
+	s.mu.Lock()
+	if s.c == nil {
+		s.mu.Unlock()
+		return nil, errors.New("session is closed")
+	}
+	s.wg.Add(1)
+	s.mu.Unlock()
+	defer s.wg.Done()
+
+	c := pr.tensors.Get().(*preparedRunTensors)
+	for i, t := range feeds {
+		c.feeds[i] = t.c
+	}
+	status := newStatus()
+	C.TF_SessionRun(s.c, nil,
+		pr.feeds, ptrTensor(c.feeds), C.int(pr.nfeeds),
+		pr.fetches, ptrTensor(c.fetches), C.int(pr.nfetches),
+		pr.targets, C.int(pr.ntargets),
+		nil, status.c)
+	// Keep the feed Tensors and the C arrays from being finalized while
+	// TF_SessionRun uses them.
+	runtime.KeepAlive(feeds)
+	runtime.KeepAlive(pr)
+	var ret []*Tensor
+	err := status.Err()
+	if err == nil {
+		ret = make([]*Tensor, pr.nfetches)
+		for i, ct := range c.fetches {
+			ret[i] = newTensorFromC(ct)
+		}
+	}
+	for i := range c.feeds {
+		c.feeds[i] = nil
+	}
+	for i := range c.fetches {
+		c.fetches[i] = nil
+	}
+	pr.tensors.Put(c)
+	return ret, err
+}
+
 // Close a session. This contacts any other processes associated with this
 // session, if applicable. Blocks until all previous calls to Run have returned.
 func (s *Session) Close() error {
@@ -324,6 +436,34 @@ func (c *cRunArgs) toGo() []*Tensor {
 	return ret
 }
 
+// newCOutputs copies l to an array allocated with C.malloc, or returns nil if
+// l is empty.
+func newCOutputs(l []Output) *C.TF_Output {
+	if len(l) == 0 {
+		return nil
+	}
+	p := (*C.TF_Output)(C.malloc(C.size_t(len(l)) * C.size_t(unsafe.Sizeof(C.TF_Output{}))))
+	a := (*[1 << 24]C.TF_Output)(unsafe.Pointer(p))[:len(l):len(l)]
+	for i, o := range l {
+		a[i] = o.c()
+	}
+	return p
+}
+
+// newCOperations copies l to an array allocated with C.malloc, or returns nil
+// if l is empty.
+func newCOperations(l []*Operation) **C.TF_Operation {
+	if len(l) == 0 {
+		return nil
+	}
+	p := (**C.TF_Operation)(C.malloc(C.size_t(len(l)) * C.size_t(unsafe.Sizeof((*C.TF_Operation)(nil)))))
+	a := (*[1 << 24]*C.TF_Operation)(unsafe.Pointer(p))[:len(l):len(l)]
+	for i, o := range l {
+		a[i] = o.c
+	}
+	return p
+}
+
 func ptrOutput(l []C.TF_Output) *C.TF_Output {
 	if len(l) == 0 {
 		return nil
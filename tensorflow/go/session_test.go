@@ -19,6 +19,7 @@ package tensorflow
 import (
 	"fmt"
 	"reflect"
+	"sync"
 	"testing"
 )
 
@@ -74,6 +75,48 @@ func TestSessionRunNeg(t *testing.T) {
 	}
 }
 
+func TestPreparedRun(t *testing.T) {
+	graph, inp, out := createTestGraph(t, Int64)
+	s, err := NewSession(graph, &SessionOptions{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s.Close()
+	pr, err := s.Prepare([]Output{inp}, []Output{out}, []*Operation{out.Op})
+	if err != nil {
+		t.Fatal(err)
+	}
+	tensor, err := AllocateTensor(Int64, []int64{3})
+	if err != nil {
+		t.Fatal(err)
+	}
+	var wg sync.WaitGroup
+	for i := int64(0); i < 10; i++ {
+		// Refill the same feed Tensor in place between runs.
+		for j := 0; j < 3; j++ {
+			nativeEndian.PutUint64(tensor.Data()[8*j:], uint64(i+int64(j)))
+		}
+		output, err := pr.Run([]*Tensor{tensor})
+		if err != nil {
+			t.Fatal(err)
+		}
+		if got, want := output[0].Value(), []int64{-i, -i - 1, -i - 2}; !reflect.DeepEqual(got, want) {
+			t.Errorf("got %v, want %v", got, want)
+		}
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			if _, err := pr.Run([]*Tensor{output[0]}); err != nil {
+				t.Error(err)
+			}
+		}()
+	}
+	wg.Wait()
+	if _, err := pr.Run(nil); err == nil {
+		t.Error("Run() with missing feeds succeeded")
+	}
+}
+
 func TestSessionRunConcat(t *testing.T) {
 	// Runs the Concat operation on two matrices: m1 and m2, along the
 	// first dimension (dim1).
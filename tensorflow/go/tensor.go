@@ -110,6 +110,29 @@ func NewTensor(value interface{}) (*Tensor, error) {
 	return t, nil
 }
 
+// AllocateTensor returns a Tensor with the provided type and shape whose
+// contents are uninitialized, to be filled through Data. This avoids
+// converting a Go value with NewTensor when the caller already has the
+// serialized contents, for example an image decoded into the tensor's memory.
+//
+// String tensors cannot be allocated this way.
+func AllocateTensor(dataType DataType, shape []int64) (*Tensor, error) {
+	if err := isTensorSerializable(dataType); err != nil {
+		return nil, err
+	}
+	nbytes := typeOf(dataType, nil).Size() * uintptr(numElements(shape))
+	var shapePtr *C.int64_t
+	if len(shape) > 0 {
+		shapePtr = (*C.int64_t)(unsafe.Pointer(&shape[0]))
+	}
+	t := &Tensor{
+		c:     C.TF_AllocateTensor(C.TF_DataType(dataType), shapePtr, C.int(len(shape)), C.size_t(nbytes)),
+		shape: append([]int64(nil), shape...),
+	}
+	runtime.SetFinalizer(t, (*Tensor).finalize)
+	return t, nil
+}
+
 // ReadTensor constructs a Tensor with the provided type and shape from the
 // serialized tensor contents in r.
 //
@@ -187,6 +210,15 @@ func (t *Tensor) Value() interface{} {
 	return reflect.Indirect(val).Interface()
 }
 
+// Data returns the memory of the Tensor, in the serialized form described in
+// ReadTensor, without copying it. Writes to the returned slice change the
+// Tensor, including for Tensors fed to later Session runs.
+//
+// The slice refers to memory that is freed when t is garbage collected, so t
+// must be kept reachable (see runtime.KeepAlive) for as long as the slice is
+// used.
+func (t *Tensor) Data() []byte { return tensorData(t.c) }
+
 // WriteContentsTo writes the serialized contents of t to w.
 //
 // Returns the number of bytes written. See ReadTensor for
@@ -199,6 +199,48 @@ public final class Tensor implements AutoCloseable {
     return t;
   }
 
+  /**
+   * Create a Tensor that shares its data with the given direct buffer, without copying it.
+   *
+   * <p>Unlike {@link #create(DataType, long[], ByteBuffer)}, the tensor is a view of the bytes of
+   * {@code data} from its current position, which is left unchanged. The buffer must not be
+   * modified while the tensor, or any tensor that TensorFlow derives from it without a copy, is in
+   * use: TensorFlow keeps a reference to the buffer until it no longer needs the memory, which may
+   * be after {@link #close()} returns.
+   *
+   * <p>The data is copied only if it is not aligned as TensorFlow requires (see {@code
+   * TF_NewTensor} in the <a href="https://www.tensorflow.org/code/tensorflow/c/c_api.h">C
+   * API</a>), so buffers from {@link ByteBuffer#allocateDirect(int)} that are fed at position 0 are
+   * typically shared.
+   *
+   * @param dataType the tensor datatype, which may not be {@link DataType#STRING}.
+   * @param shape the tensor shape.
+   * @param data a direct buffer containing the tensor data in native byte order.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, or if the tensor
+   *     datatype or shape is not compatible with the buffer
+   */
+  public static Tensor wrap(DataType dataType, long[] shape, ByteBuffer data) {
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("cannot wrap a ByteBuffer that is not direct");
+    }
+    if (dataType == DataType.STRING) {
+      throw new IllegalArgumentException("cannot wrap a ByteBuffer in a DataType.STRING Tensor");
+    }
+    final int nbytes = numElements(shape) * elemByteSize(dataType);
+    if (data.remaining() != nbytes) {
+      throw new IllegalArgumentException(
+          String.format(
+              "ByteBuffer with %d bytes is not compatible with a %s Tensor of shape %s",
+              data.remaining(), dataType.toString(), Arrays.toString(shape)));
+    }
+    Tensor t = new Tensor();
+    t.dtype = dataType;
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    // The native code sees the buffer from its start, so wrap a view that starts at the position.
+    t.nativeHandle = allocateDirect(t.dtype.c(), t.shapeCopy, data.slice(), nbytes);
+    return t;
+  }
+
   // Helper function to allocate a Tensor for the create() methods that create a Tensor from
   // a java.nio.Buffer.
   private static Tensor allocateForBuffer(DataType dataType, long[] shape, int nBuffered) {
@@ -440,6 +482,19 @@ public final class Tensor implements AutoCloseable {
     dst.put(src);
   }
 
+  /**
+   * Returns a direct buffer that shares its content with the tensor data, without copying it.
+   *
+   * <p>The buffer is in native byte order and holds {@code numBytes()} bytes. Writes to the buffer
+   * change the tensor. This is the cheapest way to read the outputs of a {@link Session} run.
+   *
+   * <p><b>WARNING:</b> The buffer must not be used after {@link #close()} is called, since the
+   * memory it refers to may be freed.
+   */
+  public ByteBuffer asByteBuffer() {
+    return buffer();
+  }
+
   /** Returns a string describing the type and shape of the Tensor. */
   @Override
   public String toString() {
@@ -594,6 +649,9 @@ public final class Tensor implements AutoCloseable {
 
   private static native long allocate(int dtype, long[] shape, long byteSize);
 
+  private static native long allocateDirect(
+      int dtype, long[] shape, ByteBuffer buffer, long byteSize);
+
   private static native long allocateScalarBytes(byte[] value);
 
   private static native void delete(long handle);
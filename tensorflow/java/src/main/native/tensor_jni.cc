@@ -35,6 +35,56 @@ TF_Tensor* requireHandle(JNIEnv* env, jlong handle) {
   return reinterpret_cast<TF_Tensor*>(handle);
 }
 
+// Copies the dimensions of "shape" to a new array in "dims" and returns their
+// number.
+int copyShape(JNIEnv* env, jlongArray shape, std::unique_ptr<int64_t[]>* dims) {
+  static_assert(sizeof(jlong) == sizeof(int64_t),
+                "Java long is not compatible with the TensorFlow C API");
+  const int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  dims->reset(new int64_t[num_dims]);
+  if (num_dims == 0) return 0;
+  jlong* values = env->GetLongArrayElements(shape, nullptr);
+  // On some platforms "jlong" is a "long" while "int64_t" is a "long long",
+  // so static_cast<int64_t*>(values) does not compile. The array is typically
+  // very small, so copy it element by element.
+  for (int i = 0; i < num_dims; ++i) {
+    (*dims)[i] = static_cast<int64_t>(values[i]);
+  }
+  env->ReleaseLongArrayElements(shape, values, JNI_ABORT);
+  return num_dims;
+}
+
+// The java.nio.ByteBuffer that a TF_Tensor created by allocateDirect aliases.
+// The global reference keeps the buffer, and so its memory, alive until the
+// last reference to the TF_Tensor is gone.
+struct DirectBuffer {
+  JavaVM* vm;
+  jobject buffer;
+};
+
+// TF_NewTensor deallocator for the tensors created by allocateDirect. The
+// last reference to the tensor may be dropped by a TensorFlow thread that
+// the JVM does not know about, which is attached for as long as it takes to
+// delete the global reference.
+void releaseDirectBuffer(void* data, size_t len, void* arg) {
+  DirectBuffer* direct = static_cast<DirectBuffer*>(arg);
+  JNIEnv* env = nullptr;
+  bool attached = false;
+  if (direct->vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) ==
+      JNI_EDETACHED) {
+    if (direct->vm->AttachCurrentThread(reinterpret_cast<void**>(&env),
+                                        nullptr) != JNI_OK) {
+      // The JVM is shutting down, and the buffer goes away with it.
+      delete direct;
+      return;
+    }
+    attached = true;
+  }
+  env->DeleteGlobalRef(direct->buffer);
+  if (attached) direct->vm->DetachCurrentThread();
+  delete direct;
+}
+
 size_t elemByteSize(TF_DataType dtype) {
   // The code in this file makes the assumption that the
   // TensorFlow TF_DataTypes and the Java primitive types
@@ -220,32 +270,10 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
                                                             jint dtype,
                                                             jlongArray shape,
                                                             jlong sizeInBytes) {
-  int num_dims = static_cast<int>(env->GetArrayLength(shape));
-  jlong* dims = nullptr;
-  if (num_dims > 0) {
-    jboolean is_copy;
-    dims = env->GetLongArrayElements(shape, &is_copy);
-  }
-  static_assert(sizeof(jlong) == sizeof(int64_t),
-                "Java long is not compatible with the TensorFlow C API");
-  // On some platforms "jlong" is a "long" while "int64_t" is a "long long".
-  //
-  // Thus, static_cast<int64_t*>(dims) will trigger a compiler error:
-  // static_cast from 'jlong *' (aka 'long *') to 'int64_t *' (aka 'long long
-  // *') is not allowed
-  //
-  // Since this array is typically very small, use the guaranteed safe scheme of
-  // creating a copy.
-  int64_t* dims_copy = new int64_t[num_dims];
-  for (int i = 0; i < num_dims; ++i) {
-    dims_copy[i] = static_cast<int64_t>(dims[i]);
-  }
-  TF_Tensor* t = TF_AllocateTensor(static_cast<TF_DataType>(dtype), dims_copy,
+  std::unique_ptr<int64_t[]> dims;
+  const int num_dims = copyShape(env, shape, &dims);
+  TF_Tensor* t = TF_AllocateTensor(static_cast<TF_DataType>(dtype), dims.get(),
                                    num_dims, static_cast<size_t>(sizeInBytes));
-  delete[] dims_copy;
-  if (dims != nullptr) {
-    env->ReleaseLongArrayElements(shape, dims, JNI_ABORT);
-  }
   if (t == nullptr) {
     throwException(env, kNullPointerException,
                    "unable to allocate memory for the Tensor");
@@ -254,6 +282,39 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
   return reinterpret_cast<jlong>(t);
 }
 
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject buffer,
+    jlong sizeInBytes) {
+  void* data = env->GetDirectBufferAddress(buffer);
+  if (data == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "the ByteBuffer is not a direct buffer");
+    return 0;
+  }
+  if (env->GetDirectBufferCapacity(buffer) < sizeInBytes) {
+    throwException(env, kIllegalArgumentException,
+                   "the ByteBuffer has %lld bytes, the Tensor needs %lld",
+                   static_cast<long long>(env->GetDirectBufferCapacity(buffer)),
+                   static_cast<long long>(sizeInBytes));
+    return 0;
+  }
+  std::unique_ptr<int64_t[]> dims;
+  const int num_dims = copyShape(env, shape, &dims);
+  DirectBuffer* direct = new DirectBuffer;
+  if (env->GetJavaVM(&direct->vm) != JNI_OK) {
+    delete direct;
+    throwException(env, kIllegalStateException, "unable to get the JavaVM");
+    return 0;
+  }
+  direct->buffer = env->NewGlobalRef(buffer);
+  // TF_NewTensor copies the data, and releases the buffer right away, if the
+  // buffer is not aligned as TensorFlow requires.
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.get(),
+                              num_dims, data, static_cast<size_t>(sizeInBytes),
+                              releaseDirectBuffer, direct);
+  return reinterpret_cast<jlong>(t);
+}
+
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateScalarBytes(
     JNIEnv* env, jclass clazz, jbyteArray value) {
   // TF_STRING tensors are encoded with a table of 8-byte offsets followed by
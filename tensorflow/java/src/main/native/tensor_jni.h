@@ -30,6 +30,16 @@ extern "C" {
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv *, jclass,
                                                             jint, jlongArray, jlong);
 
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    allocateDirect
+ * Signature: (I[JLjava/nio/ByteBuffer;J)J
+ *
+ * REQUIRES: The ByteBuffer is direct and holds at least sizeInBytes bytes.
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(
+    JNIEnv *, jclass, jint, jlongArray, jobject, jlong);
+
 /*
  * Class:     org_tensorflow_Tensor
  * Method:    allocateScalarBytes
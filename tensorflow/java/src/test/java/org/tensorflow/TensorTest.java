@@ -105,6 +105,44 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void wrapDirectByteBuffer() {
+    float[] floats = {1f, 2f, 3f, 4f, 5f, 6f};
+    ByteBuffer buf = ByteBuffer.allocateDirect(4 * (floats.length + 1));
+    buf.order(ByteOrder.nativeOrder()).position(4);
+    buf.slice().order(ByteOrder.nativeOrder()).asFloatBuffer().put(floats);
+    try (Tensor t = Tensor.wrap(DataType.FLOAT, new long[] {2, 3}, buf)) {
+      assertEquals(4, buf.position());
+      assertArrayEquals(new long[] {2, 3}, t.shape());
+      float[][] actual = t.copyTo(new float[2][3]);
+      assertArrayEquals(new float[] {1f, 2f, 3f}, actual[0], EPSILON_F);
+      assertArrayEquals(new float[] {4f, 5f, 6f}, actual[1], EPSILON_F);
+    }
+
+    try (Tensor t = Tensor.wrap(DataType.FLOAT, new long[] {2}, ByteBuffer.allocate(8))) {
+      fail("should have failed on a heap buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+    try (Tensor t = Tensor.wrap(DataType.FLOAT, new long[] {3}, ByteBuffer.allocateDirect(8))) {
+      fail("should have failed on incompatible buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+  }
+
+  @Test
+  public void asByteBufferSharesTensorData() {
+    try (Tensor t = Tensor.create(new long[] {1, 2, 3})) {
+      ByteBuffer buf = t.asByteBuffer();
+      assertTrue(buf.isDirect());
+      assertEquals(t.numBytes(), buf.remaining());
+      assertEquals(2L, buf.asLongBuffer().get(1));
+      buf.asLongBuffer().put(1, 42L);
+      assertArrayEquals(new long[] {1, 42, 3}, t.copyTo(new long[3]));
+    }
+  }
+
   @Test
   public void createWithTypedBuffer() {
     int[] ints = {1, 2, 3, 4};
@@ -1321,7 +1321,7 @@ class SeparableConv2DTest(test.TestCase):
 class DeepConv2DTest(test.TestCase):
 
   def _CompareFwdConv2D(self, tensor_in_sizes, filter_in_sizes, conv_strides,
-                        padding):
+                        padding, tol=1e-5):
     """Verifies that DeepConv2D and Conv2D produce the same values.
 
     Args:
@@ -1331,6 +1331,7 @@ class DeepConv2DTest(test.TestCase):
         [kernel_rows, kernel_cols, input_depth, output_depth].
       conv_strides: [row_stride, col_stride] for the convolution;
       padding: Padding type.
+      tol: Relative and absolute tolerance of the comparison.
     """
     x1 = np.random.rand(*tensor_in_sizes).astype(np.float32)
     x2 = np.random.rand(*filter_in_sizes).astype(np.float32)
@@ -1348,7 +1349,7 @@ class DeepConv2DTest(test.TestCase):
       os.environ["TF_USE_DEEP_CONV2D"] = "1"
       values_test = sess.run([conv])
 
-      self.assertAllClose(values_expect, values_test, rtol=1e-5, atol=1e-5)
+      self.assertAllClose(values_expect, values_test, rtol=tol, atol=tol)
 
   def _RunTestCases(self, conv_strides, padding):
     input_sizes = [[5, 5, 5, 1248], [3, 17, 17, 192], [2, 35, 35, 288],
@@ -1364,6 +1365,46 @@ class DeepConv2DTest(test.TestCase):
   def testConv2D3x3FilterStride1x1Same(self):
     self._RunTestCases([1, 1], "SAME")
 
+  def testConv2D3x3FilterOutputTile6x6(self):
+    # F(6x6,3x3) transforms are less accurate than the default F(4x4,3x3).
+    os.environ["TF_DEEP_CONV2D_MAX_OUTPUT_TILE_SIZE"] = "6"
+    try:
+      self._CompareFwdConv2D([2, 35, 35, 288], [3, 3, 288, 384], [1, 1],
+                             "SAME", tol=1e-3)
+      self._CompareFwdConv2D([1, 17, 17, 192], [3, 3, 192, 192], [1, 1],
+                             "VALID", tol=1e-3)
+    finally:
+      del os.environ["TF_DEEP_CONV2D_MAX_OUTPUT_TILE_SIZE"]
+
+  def testConv2DFilterUpdate(self):
+    # Transformed filters are cached by the kernel, and must be recomputed
+    # when the filter values change.
+    tensor_in_sizes = [2, 17, 17, 192]
+    filter_in_sizes = [3, 3, 192, 192]
+    x1 = np.random.rand(*tensor_in_sizes).astype(np.float32)
+    x2 = np.random.rand(*filter_in_sizes).astype(np.float32)
+    x3 = np.random.rand(*filter_in_sizes).astype(np.float32)
+
+    with self.test_session(use_gpu=False) as sess:
+      t1 = constant_op.constant(x1, shape=tensor_in_sizes)
+      t2 = variables.Variable(x2)
+      conv = nn_ops.conv2d(t1, t2, strides=[1, 1, 1, 1], padding="SAME")
+      assign = t2.assign(x3)
+      variables.global_variables_initializer().run()
+
+      os.environ["TF_USE_DEEP_CONV2D"] = "1"
+      values_test_before = sess.run(conv)
+      sess.run(assign)
+      values_test_after = sess.run(conv)
+
+      os.environ["TF_USE_DEEP_CONV2D"] = "0"
+      values_expect_after = sess.run(conv)
+      os.environ["TF_USE_DEEP_CONV2D"] = "1"
+
+      self.assertAllClose(
+          values_expect_after, values_test_after, rtol=1e-5, atol=1e-5)
+      self.assertFalse(np.allclose(values_test_before, values_test_after))
+
 
 class Conv2DBenchmark(test.Benchmark):
 
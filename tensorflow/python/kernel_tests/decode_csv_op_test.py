@@ -207,6 +207,27 @@ class DecodeCSVOpTest(test.TestCase):
     self._test(
         args, expected_err_re="Quoted field has to end with quote followed.*")
 
+  def testManyRecords(self):
+    records = ["%d,%d.5,\"s%d\"" % (i, i, i) for i in range(10000)]
+    args = {"records": records, "record_defaults": [[0], [0.0], [""]]}
+
+    self._test(
+        args,
+        expected_out=[
+            np.arange(10000, dtype=np.int32),
+            np.arange(10000, dtype=np.float32) + 0.5,
+            [b"s%d" % i for i in range(10000)]
+        ])
+
+  def testManyRecordsReportsFirstError(self):
+    records = ["%d" % i for i in range(10000)]
+    records[7000] = "x"
+    records[123] = "y"
+    args = {"records": records, "record_defaults": [[0]]}
+
+    self._test(
+        args, expected_err_re="Field 0 in record 123 is not a valid int32: y")
+
 
 if __name__ == "__main__":
   test.main()
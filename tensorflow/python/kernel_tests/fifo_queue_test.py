@@ -609,6 +609,44 @@ class FIFOQueueTest(test.TestCase):
       for elem in cleanup_elems:
         self.assertTrue(elem in (10.0, 20.0))
 
+  def testParallelEnqueueAndDequeuePreservesProducerOrder(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(4, (dtypes_lib.int32, dtypes_lib.int32),
+                                  shapes=((), ()))
+      producer_t = array_ops.placeholder(dtypes_lib.int32, shape=())
+      value_t = array_ops.placeholder(dtypes_lib.int32, shape=())
+      enqueue_op = q.enqueue((producer_t, value_t))
+      dequeued_t = q.dequeue()
+
+      num_producers = 4
+      num_values = 100
+
+      def enqueue(producer):
+        for value in xrange(num_values):
+          sess.run(enqueue_op, feed_dict={producer_t: producer, value_t: value})
+
+      results = []
+
+      def dequeue():
+        for _ in xrange(num_producers * num_values):
+          results.append(sess.run(dequeued_t))
+
+      threads = [
+          self.checkedThread(target=enqueue, args=(i,))
+          for i in range(num_producers)
+      ]
+      threads.append(self.checkedThread(target=dequeue))
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+
+      self.assertEqual(num_producers * num_values, len(results))
+      self.assertEqual(0, q.size().eval())
+      for producer in range(num_producers):
+        values = [v for p, v in results if p == producer]
+        self.assertEqual(list(range(num_values)), values)
+
   def testMixtureOfEnqueueAndEnqueueMany(self):
     with self.test_session() as sess:
       q = data_flow_ops.FIFOQueue(10, dtypes_lib.int32, shapes=())
@@ -0,0 +1,76 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Functional tests for the neon kernels of pooling, softmax and resize."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import image_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.python.platform import test
+
+
+class NeonOpsTest(test.TestCase):
+
+  def _CompareWithDefaultKernel(self, op_type, build_op, x):
+    """Checks that the neon kernel of op_type matches the default kernel."""
+    with self.test_session(use_gpu=False) as sess:
+      # Feed the input so that constant folding can not replace the kernels.
+      t = array_ops.placeholder(x.dtype, x.shape)
+      expected = build_op(t)
+      with sess.graph._kernel_label_map({op_type: "neon"}):
+        actual = build_op(t)
+      expected_value, actual_value = sess.run([expected, actual], {t: x})
+    self.assertAllClose(expected_value, actual_value, rtol=1e-5, atol=1e-5)
+
+  def testPooling(self):
+    np.random.seed(1)
+    # The depths exercise the 16- and 4-channel blocks and the leftovers.
+    for shape in [[1, 7, 9, 3], [2, 8, 8, 16], [1, 11, 6, 37]]:
+      x = np.random.randn(*shape).astype(np.float32)
+      for ksize, stride in [(2, 2), (3, 1), (3, 2)]:
+        for padding in ["VALID", "SAME"]:
+          for op_type, pool in [("AvgPool", nn_ops.avg_pool),
+                                ("MaxPool", nn_ops.max_pool)]:
+            self._CompareWithDefaultKernel(
+                op_type,
+                lambda t, pool=pool, ksize=ksize, stride=stride,
+                padding=padding: pool(t, [1, ksize, ksize, 1],
+                                      [1, stride, stride, 1], padding), x)
+
+  def testSoftmax(self):
+    np.random.seed(2)
+    for shape in [[1, 3], [4, 10], [3, 1001]]:
+      x = (10 * np.random.randn(*shape)).astype(np.float32)
+      self._CompareWithDefaultKernel("Softmax", nn_ops.softmax, x)
+
+  def testResizeBilinear(self):
+    np.random.seed(3)
+    for shape, size in [([1, 4, 5, 3], [9, 7]), ([2, 9, 7, 8], [4, 5]),
+                        ([1, 6, 6, 13], [6, 12])]:
+      x = np.random.randn(*shape).astype(np.float32)
+      for align_corners in [False, True]:
+        self._CompareWithDefaultKernel(
+            "ResizeBilinear",
+            lambda t, size=size, align_corners=align_corners:
+            image_ops.resize_bilinear(t, size, align_corners=align_corners), x)
+
+
+if __name__ == "__main__":
+  test.main()
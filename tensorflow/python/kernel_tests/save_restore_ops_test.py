@@ -17,9 +17,16 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.client import session
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
 from tensorflow.python.ops import gen_io_ops
+from tensorflow.python.ops import state_ops
+from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 
 
@@ -36,5 +43,40 @@ class ShardedFileOpsTest(test.TestCase):
           b"foo-?????-of-00100")
 
 
+
+class AsyncSaveTest(test.TestCase):
+
+  def testSaveAndWait(self):
+    prefix = os.path.join(self.get_temp_dir(), "async_ckpt")
+    with self.test_session() as sess:
+      v = variables.Variable([1.0, 2.0, 3.0])
+      saver = gen_io_ops.async_saver_handle_op(shared_name="saver")
+      save = gen_io_ops.async_save_v2(saver, prefix, ["v"], [""], [v])
+      wait = gen_io_ops.async_saver_status(saver, wait=True)
+      restore = gen_io_ops.restore_v2(prefix, ["v"], [""], [dtypes.float32])
+      sess.run(variables.global_variables_initializer())
+      sess.run(save)
+      # The snapshot is taken when the save op runs.
+      sess.run(state_ops.assign(v, [4.0, 5.0, 6.0]))
+      self.assertEqual(0, sess.run(wait))
+      self.assertAllEqual([1.0, 2.0, 3.0], sess.run(restore)[0])
+
+  def testWriteErrorIsReported(self):
+    # The directory of the checkpoint cannot be created over a file.
+    not_a_dir = os.path.join(self.get_temp_dir(), "not_a_dir")
+    with open(not_a_dir, "w") as f:
+      f.write("file")
+    prefix = os.path.join(not_a_dir, "ckpt")
+    with self.test_session() as sess:
+      saver = gen_io_ops.async_saver_handle_op(shared_name="failing_saver")
+      save = gen_io_ops.async_save_v2(saver, prefix, ["c"], [""],
+                                      [constant_op.constant(1.0)])
+      wait = gen_io_ops.async_saver_status(saver, wait=True)
+      sess.run(save)
+      with self.assertRaises(errors.OpError):
+        sess.run(wait)
+      # The error is reported once.
+      self.assertEqual(0, sess.run(wait))
+
 if __name__ == "__main__":
   test.main()
@@ -18,10 +18,13 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import itertools
+
 import numpy as np
 
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes as dtypes_lib
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import math_ops
 import tensorflow.python.ops.nn_grad  # pylint: disable=unused-import
@@ -636,5 +639,95 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           s.eval()
 
 
+class SparseSegmentWeightedCombineTest(test.TestCase):
+
+  def _npCombine(self, data, indices, weights, segment_ids, num_segments,
+                 combiner):
+    output = np.zeros([num_segments] + list(data.shape[1:]), data.dtype)
+    denominator = np.zeros([num_segments], data.dtype)
+    for index, weight, segment in zip(indices, weights, segment_ids):
+      output[segment] += weight * data[index]
+      denominator[segment] += weight if combiner == "mean" else weight**2
+    for segment in range(num_segments):
+      if combiner == "sqrtn":
+        denominator[segment] = np.sqrt(denominator[segment])
+      if combiner != "sum" and denominator[segment] != 0:
+        output[segment] /= denominator[segment]
+    return output
+
+  def _combine(self, data, indices, weights, segment_ids, num_segments,
+               combiner):
+    return gen_math_ops._sparse_segment_weighted_combine(
+        data, indices, weights, segment_ids, num_segments, combiner=combiner)
+
+  def testValues(self):
+    data = np.random.rand(20, 3, 2)
+    # Segment 1 is empty, and segment 4 has no entries past the last one.
+    segment_ids = [0, 0, 0, 2, 3, 3, 3, 3]
+    indices = [4, 0, 4, 19, 7, 8, 9, 3]
+    weights = 1 + np.random.rand(len(indices))
+    for dtype, index_dtype, combiner, use_gpu in itertools.product(
+        [dtypes_lib.float32, dtypes_lib.float64],
+        [dtypes_lib.int32, dtypes_lib.int64], ["sum", "mean", "sqrtn"],
+        [False, True]):
+      with self.test_session(use_gpu=use_gpu):
+        np_data = data.astype(dtype.as_numpy_dtype)
+        np_weights = weights.astype(dtype.as_numpy_dtype)
+        np_ans = self._npCombine(np_data, indices, np_weights, segment_ids, 5,
+                                 combiner)
+        s = self._combine(np_data,
+                          constant_op.constant(indices, dtype=index_dtype),
+                          np_weights, segment_ids, 5, combiner)
+        self.assertAllEqual([None, 3, 2], s.get_shape().as_list())
+        self.assertAllClose(np_ans, s.eval())
+
+  def testZeroDenominator(self):
+    data = np.arange(8, dtype=np.float32).reshape([4, 2])
+    with self.test_session(use_gpu=False):
+      s = self._combine(data, [1, 2], [1.0, -1.0], [0, 0], 1, "mean")
+      self.assertAllClose([[-2.0, -2.0]], s.eval())
+
+  def testEmpty(self):
+    data = np.ones([4, 2], dtype=np.float32)
+    with self.test_session(use_gpu=False):
+      s = self._combine(data, np.zeros([0], np.int32),
+                        np.zeros([0], np.float32), np.zeros([0], np.int32), 2,
+                        "mean")
+      self.assertAllClose(np.zeros([2, 2]), s.eval())
+
+  def testIndicesInvalid(self):
+    data = np.ones([4, 2], dtype=np.float32)
+    with self.test_session(use_gpu=False):
+      s = self._combine(data, [0, 4], [1.0, 1.0], [0, 1], 2, "sum")
+      with self.assertRaisesOpError(r"indices\[1\] is not in \[0, 4\)"):
+        s.eval()
+
+  def testSegmentsInvalid(self):
+    data = np.ones([4, 2], dtype=np.float32)
+    with self.test_session(use_gpu=False):
+      for segment_ids in [[1, 0], [0, 2], [-1, 0]]:
+        s = self._combine(data, [0, 1], [1.0, 1.0], segment_ids, 2, "sum")
+        with self.assertRaisesOpError("not sorted"):
+          s.eval()
+
+  def testGradient(self):
+    data_shape = [6, 3]
+    segment_ids = [0, 0, 1, 3, 3, 3]
+    indices = [5, 1, 1, 0, 2, 5]
+    for combiner in ["sum", "mean", "sqrtn"]:
+      with self.test_session():
+        np_data = np.random.rand(*data_shape)
+        np_weights = 1 + np.random.rand(len(indices))
+        tf_data = constant_op.constant(np_data)
+        tf_weights = constant_op.constant(np_weights)
+        s = self._combine(tf_data, indices, tf_weights, segment_ids, 4,
+                          combiner)
+        err = gradient_checker.compute_gradient_error(
+            [tf_data, tf_weights], [data_shape, [len(indices)]],
+            s, [4, 3],
+            x_init_value=[np_data, np_weights])
+      self.assertLess(err, 1e-5)
+
+
 if __name__ == "__main__":
   test.main()
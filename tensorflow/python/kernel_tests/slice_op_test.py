@@ -124,6 +124,18 @@ class SliceTest(test.TestCase):
     self._testSliceMatrixDim0(y, 1, 2)
     self._testSliceMatrixDim0(y, 3, 3)
 
+  def testSliceInnerDimContiguous(self):
+    inp = np.random.rand(3, 4, 16).astype("f")
+    with self.test_session(use_gpu=True):
+      a = constant_op.constant(inp)
+      for begin, size in [([1, 2, 4], [1, 1, 8]), ([2, 1, 0], [1, 2, 16]),
+                          ([0, 3, 1], [1, 1, 7])]:
+        slice_t = array_ops.slice(a, begin, size)
+        expected = inp[begin[0]:begin[0] + size[0],
+                       begin[1]:begin[1] + size[1],
+                       begin[2]:begin[2] + size[2]]
+        self.assertAllEqual(expected, slice_t.eval())
+
   def testSingleElementAll(self):
     for _ in range(10):
       with self.test_session(use_gpu=True):
@@ -67,6 +67,7 @@ class IndexedSlicesConditionalAccumulatorTest(test.TestCase):
       attr { key: 'shape' value { shape { unknown_rank: true} } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'defer_aggregation' value { b: false } }
       """, q.accumulator_ref.op.node_def)
 
   def testConstructorWithShape(self):
@@ -86,6 +87,7 @@ class IndexedSlicesConditionalAccumulatorTest(test.TestCase):
       } } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'defer_aggregation' value { b: false } }
       """, q.accumulator_ref.op.node_def)
 
   def testAccumulatorSizeEmpty(self):
@@ -222,6 +224,71 @@ class IndexedSlicesConditionalAccumulatorTest(test.TestCase):
       self.assertAllEqual(val.values, [[5, 5], [0, 20], [30, 0]])
       self.assertAllEqual(val.dense_shape, [-1, 2])
 
+  def testDeferredAggregationTakeGrad(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=(), defer_aggregation=True)
+
+      for local_step in range(2):
+        accum_op = q.apply_grad(
+            [2, 0, 2],
+            np.array([[1, 0], [0, 2], [3, 0]]).astype(np.float32), [3, 2],
+            local_step=local_step)
+        accum_op.run()
+        accum_op = q.apply_grad(
+            [1, 2],
+            np.array([[4, 4], [0, 6]]).astype(np.float32), [3, 2],
+            local_step=local_step)
+        accum_op.run()
+
+        takeg_t = q.take_indexed_slices_grad(1)
+        val = sess.run(takeg_t)
+        self.assertAllEqual(val.indices, [0, 1, 2])
+        self.assertAllClose(val.values, [[0, 2], [4, 4], [4 / 3, 2]])
+        self.assertAllEqual(val.dense_shape, [-1, 2])
+
+  def testDeferredAggregationParallelApplyGrad(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=tensor_shape.TensorShape([2, 2]),
+          defer_aggregation=True)
+      elems = [10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0, 80.0, 90.0, 100.0]
+      accum_ops = []
+      for x in elems:
+        x = _indexedslice(np.array([[x, 0], [0, x]]).astype(np.float32))
+        accum_ops.append(q.apply_indexed_slices_grad(x, local_step=0))
+      takeg_t = q.take_indexed_slices_grad(1)
+
+      def apply_indexed_slices_grad(accum_op):
+        sess.run(accum_op)
+
+      threads = [
+          self.checkedThread(
+              target=apply_indexed_slices_grad, args=(o,)) for o in accum_ops
+      ]
+
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+
+      val = sess.run(takeg_t)
+
+      expected_val = sum(elems) / len(elems)
+      self._assertEqual_nparray(
+          np.array([[expected_val, 0], [0, expected_val]]).astype(np.float32),
+          val, sess)
+
+  def testDeferredAggregationValidateShape(self):
+    with self.test_session():
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=(), defer_aggregation=True)
+      q.apply_grad([0], np.array([[1, 2]]).astype(np.float32), [3, 2]).run()
+
+      with self.assertRaisesOpError("expected values dim 1 to be 2"):
+        q.apply_grad(
+            [1], np.array([[1, 2, 3]]).astype(np.float32), [3, 3]).run()
+
   def testParallelApplyGrad(self):
     with self.test_session() as sess:
       q = data_flow_ops.SparseConditionalAccumulator(
@@ -228,6 +228,23 @@ class SparseTensorDenseMatMulTest(test.TestCase):
     self._testLarge(np.complex64)
     self._testLarge(np.complex128)
 
+  # Tests power-law row lengths with shuffled entries, which on GPU goes
+  # through the sorted (CSR) path.
+  def testFloatPowerLawRows(self):
+    np.random.seed(127)  # Repeatable results
+    m, k, n = 200, 3000, 40
+    x = np.zeros((m, k), dtype=np.float32)
+    row_lengths = np.minimum(np.random.zipf(1.5, size=m) * 8, k)
+    for i, row_length in enumerate(row_lengths):
+      x[i, np.random.choice(k, row_length, replace=False)] = (
+          np.random.randn(row_length))
+    y = np.random.randn(k, n).astype(np.float32)
+    for adjoint_a in [True, False]:
+      for adjoint_b in [True, False]:
+        x_in = x.transpose() if adjoint_a else x
+        y_in = y.transpose() if adjoint_b else y
+        self._testMatmul(x_in, y_in, adjoint_a, adjoint_b)
+
   # Tests random sized matrices.
   def testFloatRandom(self):
     np.random.seed(127)  # Repeatable results
@@ -379,6 +396,47 @@ def sparse_tensor_dense_vs_dense_matmul_benchmark(thresh,
          delta_sparse / delta_dense))
 
 
+def sparse_tensor_dense_matmul_power_law_benchmark(m, k, n, mean_row_length,
+                                                   use_gpu):
+  """Times sparse_tensor_dense_matmul with power-law distributed row lengths.
+
+  This is the sparsity of bag-of-words features, where a few rows have most of
+  the entries.
+  """
+  config = config_pb2.ConfigProto()
+  config.allow_soft_placement = True
+
+  np.random.seed([6, 117])  # Reproducibility
+  row_lengths = np.random.zipf(1.5, size=m)
+  row_lengths = np.minimum(
+      row_lengths * mean_row_length // max(1, int(np.mean(row_lengths))), k)
+  rows = np.repeat(np.arange(m), row_lengths)
+  cols = np.random.randint(0, k, size=rows.size)
+  flat_ind = np.unique(rows * k + cols)
+  np.random.shuffle(flat_ind)
+  x_ind = np.vstack([flat_ind // k, flat_ind % k]).T.astype(np.int64)
+  x_val = np.random.randn(x_ind.shape[0]).astype(np.float32)
+  y = np.random.randn(k, n).astype(np.float32)
+
+  def _timer(sess, ops_fn, iterations):
+    sess.run(ops_fn(10, sess))
+    start = time.time()
+    sess.run(ops_fn(iterations, sess))
+    end = time.time()
+    return (end - start) / (1.0 * iterations)
+
+  with session.Session("", config=config, graph=ops.Graph()) as sess:
+    with ops.device("/gpu:0" if use_gpu else "/cpu:0"):
+      ops_fn = _sparse_tensor_dense_vs_dense_matmul_benchmark_sparse(
+          constant_op.constant(x_ind), constant_op.constant(x_val),
+          constant_op.constant(np.array([m, k], dtype=np.int64)),
+          constant_op.constant(y), False, False)
+    delta_sparse = _timer(sess, ops_fn, 200)
+
+  print("%d \t %d \t %s \t %d \t %d \t %g" %
+        (x_ind.shape[0], n, use_gpu, m, k, delta_sparse))
+
+
 def main(_):
   print("DenseDense MatMul (w/ Sparse Flag) vs. SparseTensorDense MatMul")
   print("Matrix sizes:")
@@ -396,6 +454,16 @@ def main(_):
             sparse_tensor_dense_vs_dense_matmul_benchmark(
                 thresh, m, k, n, False, False, use_gpu=use_gpu)
 
+  print("")
+  print("SparseTensorDense MatMul with power-law row lengths")
+  print("nnz \t n \t gpu \t m \t k \t dt(sparse)")
+  for mean_row_length in (4, 32):
+    for n in (50, 100):
+      for use_gpu in (True, False):
+        sparse_tensor_dense_matmul_power_law_benchmark(
+            m=10000, k=100000, n=n, mean_row_length=mean_row_length,
+            use_gpu=use_gpu)
+
   # Enable for large scale benchmarks, these ones take a long time to run.
   #
   # for use_gpu in (True, False):
@@ -245,6 +245,15 @@ class SplitOpTest(test.TestCase):
       self._compare(self._makeData((6, 7, 18), dtype), 0, 3)
       self._compare(self._makeData((6, 7, 9), dtype), 0, 3)
 
+  def testSplitInnerDims(self):
+    for dtype in _TEST_DTYPES:
+      # Leading dimensions of size 1 share the buffer when aligned.
+      self._compare(self._makeData((1, 1, 12, 8), dtype), 2, 3)
+      self._compare(self._makeData((1, 12, 7), dtype), 1, 4)
+      # Otherwise the rows are copied to all the outputs.
+      self._compare(self._makeData((5, 3, 16), dtype), 2, 4)
+      self._compare(self._makeData((5, 8, 3), dtype), 1, 2)
+
   def _RunAndVerify(self, dtype, large_num_splits=False):
     # Random dims of rank 5
     shape = np.random.randint(0, 5, size=5)
@@ -126,6 +126,37 @@ class TensorArrayTest(test.TestCase):
 
       self.assertAllEqual([3, 0, 1], c0.eval().shape)
 
+  def testTensorArrayWritePackContiguous(self):
+    # Elements of a fixed size TensorArray with a known, aligned element shape
+    # are kept in one buffer, which stack returns whole.
+    with self.test_session(use_gpu=True) as session:
+      values = np.arange(4 * 16, dtype=np.float32).reshape(4, 16)
+      ta = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32,
+          size=4,
+          clear_after_read=False,
+          element_shape=tensor_shape.TensorShape([16]))
+      for i in range(4):
+        ta = ta.write(i, values[i])
+      r1 = ta.read(1)
+      packed = ta.stack()
+      gathered = ta.gather([1, 2])
+      gathered_unordered = ta.gather([2, 0])
+
+      unpacked = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32,
+          size=4,
+          element_shape=tensor_shape.TensorShape([16])).unstack(packed)
+      r3 = unpacked.read(3)
+
+      r1, packed, gathered, gathered_unordered, r3 = session.run(
+          [r1, packed, gathered, gathered_unordered, r3])
+      self.assertAllEqual(values[1], r1)
+      self.assertAllEqual(values, packed)
+      self.assertAllEqual(values[1:3], gathered)
+      self.assertAllEqual(values[[2, 0]], gathered_unordered)
+      self.assertAllEqual(values[3], r3)
+
   def _testTensorArrayWriteConcat(self, tf_dtype):
     with self.test_session(use_gpu=True):
       ta = tensor_array_ops.TensorArray(
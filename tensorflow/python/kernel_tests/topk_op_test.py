@@ -54,7 +54,7 @@ class TopKTest(test.TestCase):
 
   def testTop2(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
-    self._validateTopK(inputs, 2, [[0.4, 0.3], [0.3, 0.3]], [[3, 1], [2, 1]])
+    self._validateTopK(inputs, 2, [[0.4, 0.3], [0.3, 0.3]], [[3, 1], [1, 2]])
 
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
@@ -68,6 +68,40 @@ class TopKTest(test.TestCase):
         3, [[0.2, 0.3, 0.4], [0.2, 0.4, 0.3]], [[2, 1, 3], [3, 1, 2]],
         sorted=False)
 
+  def _validateTopKAgainstNumpy(self, inputs, k, sorted=True):
+    # A stable sort of the negated values orders equal elements by index.
+    expected_indices = np.argsort(-inputs, axis=-1, kind="mergesort")[:, :k]
+    for use_gpu in [False, True]:
+      with self.test_session(use_gpu=use_gpu):
+        values_op, indices_op = nn_ops.top_k(inputs, k, sorted=sorted)
+        values = values_op.eval()
+        indices = indices_op.eval()
+      for row, row_values, row_indices, row_expected_indices in zip(
+          inputs, values, indices, expected_indices):
+        self.assertAllEqual(row[row_indices], row_values)
+        if sorted:
+          self.assertAllEqual(row_expected_indices, row_indices)
+        else:
+          self.assertAllEqual(
+              np.sort(row_expected_indices), np.sort(row_indices))
+
+  def testTopLargeK(self):
+    inputs = np.random.permutation(15000).reshape(3, 5000).astype(np.float32)
+    for sorted in [True, False]:
+      self._validateTopKAgainstNumpy(inputs, 1000, sorted=sorted)
+
+  def testTopLargeKWithTies(self):
+    inputs = np.random.randint(0, 50, size=(4, 3000)).astype(np.float32)
+    for k in [10, 300, 3000]:
+      self._validateTopKAgainstNumpy(inputs, k)
+
+  def testTopSingleLongRow(self):
+    # Long enough for the row to be split across threads.
+    inputs = np.random.randint(0, 100000, size=(1, 300000)).astype(np.float64)
+    for k in [5, 500]:
+      for sorted in [True, False]:
+        self._validateTopKAgainstNumpy(inputs, k, sorted=sorted)
+
   def testTop3Vector(self):
     inputs = [3, 6, 15, 18, 6, 12, 1, 17, 3, 0, 4, 19, 1, 6]
     self._validateTopK(inputs, 3, [19, 18, 17], [11, 3, 7])
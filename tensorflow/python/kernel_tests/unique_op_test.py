@@ -49,6 +49,28 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]].decode('ascii'))
 
+  def testLargeInputKeepsFirstOccurrenceOrder(self):
+    # Large enough to be split across several threads on the CPU.
+    for dtype in [np.int32, np.int64]:
+      x = np.random.randint(-500, high=500, size=200000).astype(dtype)
+      _, first_index = np.unique(x, return_index=True)
+      for use_gpu in [False, True]:
+        with self.test_session(use_gpu=use_gpu) as sess:
+          y, idx = array_ops.unique(x)
+          tf_y, tf_idx = sess.run([y, idx])
+
+        self.assertAllEqual(x[np.sort(first_index)], tf_y)
+        self.assertAllEqual(x, tf_y[tf_idx])
+
+  def testEmpty(self):
+    for use_gpu in [False, True]:
+      with self.test_session(use_gpu=use_gpu) as sess:
+        y, idx = array_ops.unique(np.zeros([0], dtype=np.int64))
+        tf_y, tf_idx = sess.run([y, idx])
+
+      self.assertEqual(0, tf_y.size)
+      self.assertEqual(0, tf_idx.size)
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -81,6 +103,19 @@ class UniqueWithCountsTest(test.TestCase):
       v = [1 if x[i] == value.decode('ascii') else 0 for i in range(7000)]
       self.assertEqual(count, sum(v))
 
+  def testLargeInput(self):
+    for dtype in [np.int32, np.int64]:
+      x = np.random.randint(0, high=1000, size=200000).astype(dtype)
+      _, first_index = np.unique(x, return_index=True)
+      for use_gpu in [False, True]:
+        with self.test_session(use_gpu=use_gpu) as sess:
+          y, idx, count = array_ops.unique_with_counts(x)
+          tf_y, tf_idx, tf_count = sess.run([y, idx, count])
+
+        self.assertAllEqual(x[np.sort(first_index)], tf_y)
+        self.assertAllEqual(x, tf_y[tf_idx])
+        self.assertAllEqual(np.bincount(tf_idx), tf_count)
+
 
 if __name__ == '__main__':
   test.main()
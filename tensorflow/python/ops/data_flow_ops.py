@@ -1226,15 +1226,24 @@ class SparseConditionalAccumulator(ConditionalAccumulatorBase):
     shared_name: Optional. If non-empty, this accumulator will be shared under
       the given name across multiple sessions.
     name: Optional name for the accumulator.
+    defer_aggregation: If True, applying a gradient only keeps it, and the
+      kept gradients are summed in parallel when the average is taken. This
+      shortens the time each apply holds the accumulator when many workers
+      apply gradients at once.
   """
 
   def __init__(self,
                dtype,
                shape=None,
                shared_name=None,
-               name="sparse_conditional_accumulator"):
+               name="sparse_conditional_accumulator",
+               defer_aggregation=False):
     accumulator_ref = gen_data_flow_ops.sparse_conditional_accumulator(
-        dtype=dtype, shape=shape, shared_name=shared_name, name=name)
+        dtype=dtype,
+        shape=shape,
+        shared_name=shared_name,
+        defer_aggregation=defer_aggregation,
+        name=name)
     super(SparseConditionalAccumulator,
           self).__init__(dtype, shape, accumulator_ref)
 
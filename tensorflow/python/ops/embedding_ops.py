@@ -28,6 +28,7 @@ from tensorflow.python.ops import clip_ops
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variables
@@ -401,6 +402,28 @@ def embedding_lookup_sparse(params,
     if segment_ids.dtype != dtypes.int32:
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
 
+    if (len(params) == 1 and max_norm is None and
+        params[0].dtype.base_dtype in (dtypes.float32, dtypes.float64)):
+      # Gather the rows of an unpartitioned table and combine them per segment
+      # in one kernel, without materializing an embedding for every id.
+      dtype = params[0].dtype.base_dtype
+      if ignore_weights:
+        weights = array_ops.ones_like(sp_ids.values, dtype=dtype)
+      else:
+        weights = math_ops.cast(sp_weights.values, dtype)
+      # Like the unfused ops, output a row for each segment up to the largest
+      # segment id. reduce_max() of no segment ids is the lowest int32.
+      num_segments = math_ops.maximum(math_ops.reduce_max(segment_ids) + 1, 0)
+      with ops.colocate_with(params[0]):
+        return gen_math_ops._sparse_segment_weighted_combine(
+            params[0],
+            sp_ids.values,
+            weights,
+            segment_ids,
+            num_segments,
+            combiner=combiner,
+            name=name)
+
     ids = sp_ids.values
     if ignore_weights:
       ids, idx = array_ops.unique(ids)
@@ -18,6 +18,7 @@
 
 See the @{$python/image} guide.
 
+@@decode_and_crop_jpeg
 @@decode_bmp
 @@decode_gif
 @@decode_jpeg
@@ -190,6 +190,50 @@ def _SparseSegmentSqrtNGrad(op, grad):
                                               dim0), None, None)
 
 
+@ops.RegisterGradient("SparseSegmentWeightedCombine")
+def _SparseSegmentWeightedCombineGrad(op, grad):
+  """Gradient for SparseSegmentWeightedCombine.
+
+  The gradient for `data` is an IndexedSlices with one row per entry of
+  `indices`, computed without densifying. The gradient for `weights` gathers
+  the selected rows, but is only computed if it is used.
+  """
+  data, indices, weights, segment_ids, num_segments = op.inputs
+  combiner = op.get_attr("combiner")
+  values = gen_math_ops._sparse_segment_weighted_combine_grad(
+      grad, weights, segment_ids, combiner=combiner)
+  data_grad = ops.IndexedSlices(values, indices, array_ops.shape(data))
+
+  # Flatten the rows so that per-entry factors broadcast along axis 1.
+  num_indices = array_ops.size(indices)
+  rows = array_ops.reshape(array_ops.gather(data, indices), [num_indices, -1])
+  row_grads = array_ops.reshape(
+      array_ops.gather(grad, segment_ids), [num_indices, -1])
+  if combiner == "sum":
+    d_rows = rows
+  else:
+    entry_weights = weights if combiner == "mean" else math_ops.square(weights)
+    denominator = math_ops.unsorted_segment_sum(entry_weights, segment_ids,
+                                                num_segments)
+    if combiner == "sqrtn":
+      denominator = math_ops.sqrt(denominator)
+    denominator = array_ops.gather(denominator, segment_ids)
+    # Segments with a zero denominator are not rescaled by the op, so their
+    # outputs do not depend on the denominator.
+    rescaled = math_ops.not_equal(denominator, 0)
+    inv = array_ops.where(rescaled, 1 / denominator,
+                          array_ops.ones_like(denominator))
+    outputs = array_ops.reshape(
+        array_ops.gather(op.outputs[0], segment_ids), [num_indices, -1])
+    output_factor = math_ops.cast(rescaled, inv.dtype)
+    if combiner == "sqrtn":
+      output_factor *= weights * inv
+    d_rows = (rows - outputs * array_ops.expand_dims(output_factor, 1)
+             ) * array_ops.expand_dims(inv, 1)
+  weights_grad = math_ops.reduce_sum(row_grads * d_rows, 1)
+  return data_grad, None, weights_grad, None, None
+
+
 def _SegmentMinOrMaxGrad(op, grad, is_sorted):
   """Gradient for SegmentMin and (unsorted) SegmentMax. They share similar code."""
   zeros = array_ops.zeros(array_ops.shape(op.inputs[0]),
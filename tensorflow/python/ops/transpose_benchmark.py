@@ -143,5 +143,23 @@ class TransposeBenchmark(test.Benchmark):
             for ishape, perm in zip(huge_shapes, huge_perms):
               self._run_graph("gpu", ishape, perm, num_iters, datatype)
 
+  def benchmark_transpose_cpu(self):
+    print("transpose cpu benchmark:")
+
+    datatypes = [np.float64, np.float32, np.float16, np.int8]
+
+    # NHWC <-> NCHW layout conversions, and 2D/3D transposes.
+    shapes = [[32, 56, 56, 64], [32, 64, 56, 56]] * 2 + [[2048, 2048]] + [[
+        16, 1024, 512
+    ]] * 2
+    perms = [[0, 3, 1, 2], [0, 2, 3, 1]] + [[3, 1, 2, 0]] * 2 + [[1, 0]] + [
+        [0, 2, 1], [2, 1, 0]
+    ]
+
+    num_iters = 10
+    for datatype in datatypes:
+      for ishape, perm in zip(shapes, perms):
+        self._run_graph("cpu", ishape, perm, num_iters, datatype)
+
 if __name__ == "__main__":
   test.main()
@@ -47,7 +47,8 @@ FLAGS = None
 def main(unused_argv):
   graphs = FLAGS.graphs.split(',')
   print(selective_registration_header_lib.get_header(
-      graphs, FLAGS.proto_fileformat, FLAGS.default_ops))
+      graphs, FLAGS.proto_fileformat, FLAGS.default_ops,
+      FLAGS.strip_types_and_ranks))
 
 
 if __name__ == '__main__':
@@ -73,6 +74,13 @@ if __name__ == '__main__':
       'should be used only when it is useful compared with simply not using '
       'selective registration, as it can in some cases limit the effect of '
       'compilation caches')
+  parser.add_argument(
+      '--strip_types_and_ranks',
+      type='bool',
+      default=False,
+      help='Also compile out the kernel instantiations for the data types '
+      'and tensor ranks that the graphs do not use. The ranks are only known '
+      'if the graphs were written with add_shapes=True.')
 
   FLAGS, unparsed = parser.parse_known_args()
   app.run(main=main, argv=[sys.argv[0]] + unparsed)
@@ -202,6 +202,60 @@ constexpr inline bool ShouldRegisterOp(const char op[]) {
     print(header)
     self.assertListEqual(expected.split('\n'), header.split('\n'))
 
+  def testGetTypesAndMaxRank(self):
+    graphs = [
+        text_format.Parse(d, graph_pb2.GraphDef())
+        for d in [GRAPH_DEF_TXT, GRAPH_DEF_TXT_2]
+    ]
+
+    # Without "_output_shapes" the ranks are unknown.
+    types, max_rank = selective_registration_header_lib.get_types_and_max_rank(
+        'rawproto', self.WriteGraphFiles(graphs))
+    self.assertListEqual(['double', 'float', 'int32'], types)
+    self.assertIsNone(max_rank)
+
+    for graph in graphs:
+      for node in graph.node:
+        shapes = node.attr['_output_shapes'].list.shape
+        shapes.add().dim.add(size=2)
+    rank_3_shape = shapes.add()
+    for _ in range(3):
+      rank_3_shape.dim.add(size=2)
+    types, max_rank = selective_registration_header_lib.get_types_and_max_rank(
+        'rawproto', self.WriteGraphFiles(graphs))
+    self.assertListEqual(['double', 'float', 'int32'], types)
+    self.assertEqual(3, max_rank)
+
+    shapes.add().unknown_rank = True
+    _, max_rank = selective_registration_header_lib.get_types_and_max_rank(
+        'rawproto', self.WriteGraphFiles(graphs))
+    self.assertIsNone(max_rank)
+
+  def testGetSelectiveHeaderWithTypesAndRanks(self):
+    graph = text_format.Parse(GRAPH_DEF_TXT_2, graph_pb2.GraphDef())
+    graph.node[0].attr['_output_shapes'].list.shape.add().dim.add(size=2)
+    fnames = self.WriteGraphFiles([graph])
+
+    header = selective_registration_header_lib.get_header(
+        fnames, 'rawproto', '', strip_types_and_ranks=True).split('\n')
+    self.assertListEqual(
+        [
+            '#define SHOULD_REGISTER_OP_GRADIENT false',  #
+            '',  #
+            '#define SHOULD_REGISTER_TYPES_SELECTIVELY',  #
+            '#define SHOULD_REGISTER_TYPE_float',  #
+            '#define SHOULD_REGISTER_TYPE_int32',  #
+            '#define SHOULD_REGISTER_MAX_RANK 1',  #
+            '#endif'
+        ],
+        header[-7:])
+
+    # Types and ranks are kept by default.
+    header = selective_registration_header_lib.get_header(
+        fnames, 'rawproto', '')
+    self.assertNotIn('SHOULD_REGISTER_TYPE', header)
+    self.assertNotIn('SHOULD_REGISTER_MAX_RANK', header)
+
 
 if __name__ == '__main__':
   test.main()
@@ -28,24 +28,28 @@ import sys
 from google.protobuf import text_format
 
 from tensorflow.core.framework import graph_pb2
+from tensorflow.core.framework import types_pb2
 from tensorflow.python import pywrap_tensorflow
 from tensorflow.python.platform import gfile
 from tensorflow.python.platform import tf_logging
 
 
+def _load_graph_def(proto_fileformat, proto_file):
+  """Loads a GraphDef from a model file."""
+  tf_logging.info('Loading proto file %s', proto_file)
+  file_data = gfile.GFile(proto_file, 'rb').read()
+  if proto_fileformat == 'rawproto':
+    return graph_pb2.GraphDef.FromString(file_data)
+  assert proto_fileformat == 'textproto'
+  return text_format.Parse(file_data, graph_pb2.GraphDef())
+
+
 def get_ops_and_kernels(proto_fileformat, proto_files, default_ops_str):
   """Gets the ops and kernels needed from the model files."""
   ops = set()
 
   for proto_file in proto_files:
-    tf_logging.info('Loading proto file %s', proto_file)
-    # Load GraphDef.
-    file_data = gfile.GFile(proto_file, 'rb').read()
-    if proto_fileformat == 'rawproto':
-      graph_def = graph_pb2.GraphDef.FromString(file_data)
-    else:
-      assert proto_fileformat == 'textproto'
-      graph_def = text_format.Parse(file_data, graph_pb2.GraphDef())
+    graph_def = _load_graph_def(proto_fileformat, proto_file)
 
     # Find all ops and kernels used by the graph.
     for node_def in graph_def.node:
@@ -72,14 +76,70 @@ def get_ops_and_kernels(proto_fileformat, proto_files, default_ops_str):
   return list(sorted(ops))
 
 
+def _type_name(dtype):
+  """Returns the TF_CALL_<type> suffix of register_types.h for a DataType."""
+  if dtype > 100:
+    dtype -= 100  # Reference types use the kernels of their base type.
+  return types_pb2.DataType.Name(dtype)[len('DT_'):].lower()
+
+
+def get_types_and_max_rank(proto_fileformat, proto_files):
+  """Gets the data types and the largest tensor rank used by the model files.
+
+  Types are read from the type-valued attrs of the nodes, e.g. "T", and int32
+  is always included. Ranks are read from the "_output_shapes" attrs that
+  tf.Graph.as_graph_def(add_shapes=True) adds.
+
+  Args:
+    proto_fileformat: format of proto file, either 'textproto' or 'rawproto'.
+    proto_files: a list of paths to GraphDef files.
+
+  Returns:
+    (types, max_rank): the sorted names of the types, as used by the
+    TF_CALL_<type> macros, and the largest rank, or None if a node has no
+    "_output_shapes" attr or a shape of unknown rank.
+  """
+  types = set(['int32'])
+  max_rank = 0
+  for proto_file in proto_files:
+    graph_def = _load_graph_def(proto_fileformat, proto_file)
+    for node_def in graph_def.node:
+      for attr in node_def.attr.values():
+        if attr.HasField('type'):
+          types.add(_type_name(attr.type))
+        elif attr.HasField('list'):
+          types.update(_type_name(t) for t in attr.list.type)
+
+      if max_rank is None:
+        continue
+      if '_output_shapes' not in node_def.attr:
+        max_rank = None
+        continue
+      for shape in node_def.attr['_output_shapes'].list.shape:
+        if shape.unknown_rank:
+          max_rank = None
+          break
+        max_rank = max(max_rank, len(shape.dim))
+
+  types.discard('invalid')
+  return list(sorted(types)), max_rank
+
+
 def get_header_from_ops_and_kernels(ops_and_kernels,
-                                    include_all_ops_and_kernels):
+                                    include_all_ops_and_kernels,
+                                    types=None,
+                                    max_rank=None):
   """Returns a header for use with tensorflow SELECTIVE_REGISTRATION.
 
   Args:
     ops_and_kernels: a set of (op_name, kernel_class_name) pairs to include.
     include_all_ops_and_kernels: if True, ops_and_kernels is ignored and all op
     kernels are included.
+    types: optional list of type names, as used by the TF_CALL_<type> macros;
+      kernels and functors are only instantiated for these types. If None, all
+      types are kept.
+    max_rank: optional largest tensor rank the rank-specialized kernels are
+      instantiated for. If None, all ranks are kept.
 
   Returns:
     the string of the header that should be written as ops_to_register.h.
@@ -150,13 +210,22 @@ def get_header_from_ops_and_kernels(ops_and_kernels,
     append('#define SHOULD_REGISTER_OP_GRADIENT ' + (
         'true' if 'SymbolicGradient' in ops else 'false'))
 
+    if types is not None:
+      append('')
+      append('#define SHOULD_REGISTER_TYPES_SELECTIVELY')
+      for t in types:
+        append('#define SHOULD_REGISTER_TYPE_%s' % t)
+    if max_rank is not None:
+      append('#define SHOULD_REGISTER_MAX_RANK %d' % max_rank)
+
   append('#endif')
   return '\n'.join(result_list)
 
 
 def get_header(graphs,
                proto_fileformat='rawproto',
-               default_ops='NoOp:NoOp,_Recv:RecvOp,_Send:SendOp'):
+               default_ops='NoOp:NoOp,_Recv:RecvOp,_Send:SendOp',
+               strip_types_and_ranks=False):
   """Computes a header for use with tensorflow SELECTIVE_REGISTRATION.
 
   Args:
@@ -166,6 +235,9 @@ def get_header(graphs,
     default_ops: optional comma-separated string of operator:kernel pairs to
       always include implementation for. Pass 'all' to have all operators and
       kernels included. Default: 'NoOp:NoOp,_Recv:RecvOp,_Send:SendOp'.
+    strip_types_and_ranks: optional; if True, kernels and functors are also
+      not instantiated for the data types and tensor ranks that the graphs do
+      not use. Default: False.
   Returns:
     the string of the header that should be written as ops_to_register.h.
   """
@@ -174,4 +246,8 @@ def get_header(graphs,
     print('Error reading graph!')
     return 1
 
-  return get_header_from_ops_and_kernels(ops_and_kernels, default_ops == 'all')
+  types = max_rank = None
+  if strip_types_and_ranks:
+    types, max_rank = get_types_and_max_rank(proto_fileformat, graphs)
+  return get_header_from_ops_and_kernels(ops_and_kernels, default_ops == 'all',
+                                         types, max_rank)
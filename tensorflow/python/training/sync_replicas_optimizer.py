@@ -140,7 +140,8 @@ class SyncReplicasOptimizer(optimizer.Optimizer):
                variable_averages=None,
                variables_to_average=None,
                use_locking=False,
-               name="sync_replicas"):
+               name="sync_replicas",
+               defer_sparse_aggregation=False):
     """Construct a sync_replicas optimizer.
 
     Args:
@@ -161,6 +162,10 @@ class SyncReplicasOptimizer(optimizer.Optimizer):
         needed if variable_averages is passed in.
       use_locking: If True use locks for update operation.
       name: string. Optional name of the returned operation.
+      defer_sparse_aggregation: If True, the accumulators of sparse gradients
+        only sum the gradients of the replicas when the aggregate is taken,
+        which lowers contention when many replicas send sparse gradients to
+        the same parameter server.
     """
     if total_num_replicas is None:
       total_num_replicas = replicas_to_aggregate
@@ -175,6 +180,7 @@ class SyncReplicasOptimizer(optimizer.Optimizer):
     self._variable_averages = variable_averages
     self._variables_to_average = variables_to_average
     self._total_num_replicas = total_num_replicas
+    self._defer_sparse_aggregation = defer_sparse_aggregation
     self._tokens_per_step = max(total_num_replicas, replicas_to_aggregate)
     self._global_step = None
     self._sync_token_queue = None
@@ -277,7 +283,10 @@ class SyncReplicasOptimizer(optimizer.Optimizer):
             if not isinstance(grad, ops.IndexedSlices):
               raise ValueError("Unknown grad type!")
             grad_accum = data_flow_ops.SparseConditionalAccumulator(
-                grad.dtype, shape=(), shared_name=var.name + "/grad_accum")
+                grad.dtype,
+                shape=(),
+                shared_name=var.name + "/grad_accum",
+                defer_aggregation=self._defer_sparse_aggregation)
             train_ops.append(grad_accum.apply_indexed_slices_grad(
                 grad, local_step=self._local_step))
             aggregated_grad.append(grad_accum.take_indexed_slices_grad(
@@ -291,6 +291,65 @@ class TrainingOpsTest(TensorFlowTestCase):
     param_t = param - alpha_t * m_t / (np.sqrt(v_t) + epsilon)
     return param_t, m_t, v_t
 
+  def testMultiApplyMomentum(self):
+    for dtype, use_gpu, use_nesterov in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True], [False, True]):
+      self.setUp()
+      with self.test_session(use_gpu=use_gpu) as sess:
+        # Sizes straddle the CPU shard boundaries; one tensor is empty.
+        shapes = [[100], [0], [3, 7], [2000]]
+        xs = [np.arange(np.prod(s)).reshape(s).astype(dtype) for s in shapes]
+        accums = [np.ones(s).astype(dtype) for s in shapes]
+        grads = [np.full(s, 0.5).astype(dtype) for s in shapes]
+        lr = np.array(0.1).astype(dtype)
+        momentum = np.array(0.9).astype(dtype)
+        var_ts = [variables.Variable(x) for x in xs]
+        accum_ts = [variables.Variable(a) for a in accums]
+        variables.global_variables_initializer().run()
+
+        apply_momentum = training_ops.multi_apply_momentum(
+            var_ts, accum_ts, lr, grads, momentum, use_nesterov=use_nesterov)
+        outs = sess.run(apply_momentum)
+        for x, accum, grad, out in zip(xs, accums, grads, outs):
+          new_accum = accum * momentum + grad
+          if use_nesterov:
+            expected = x - grad * lr - new_accum * momentum * lr
+          else:
+            expected = x - new_accum * lr
+          self.assertAllCloseAccordingToType(expected, out)
+        for accum, grad, accum_t in zip(accums, grads, accum_ts):
+          self.assertAllCloseAccordingToType(accum * momentum + grad,
+                                             accum_t.eval())
+
+  def testMultiApplyAdam(self):
+    for dtype, use_gpu in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True]):
+      self.setUp()
+      with self.test_session(use_gpu=use_gpu) as sess:
+        shapes = [[100], [5, 20], [0], [1]]
+        xs = [np.arange(np.prod(s)).reshape(s).astype(dtype) for s in shapes]
+        ms = [np.ones(s).astype(dtype) for s in shapes]
+        vs = [np.full(s, 2.0).astype(dtype) for s in shapes]
+        grads = [np.full(s, 0.5).astype(dtype) for s in shapes]
+        t = 1
+        beta1 = np.array(0.9, dtype=dtype)
+        beta2 = np.array(0.999, dtype=dtype)
+        lr = np.array(0.001, dtype=dtype)
+        epsilon = np.array(1e-8, dtype=dtype)
+        var_ts = [variables.Variable(x) for x in xs]
+        m_ts = [variables.Variable(m) for m in ms]
+        v_ts = [variables.Variable(v) for v in vs]
+        variables.global_variables_initializer().run()
+
+        apply_adam = training_ops.multi_apply_adam(
+            var_ts, m_ts, v_ts, beta1**t, beta2**t, lr, beta1, beta2, epsilon,
+            grads)
+        outs = sess.run(apply_adam)
+        for x, m, v, grad, out in zip(xs, ms, vs, grads, outs):
+          new_var, _, _ = self._adamUpdateNumpy(x, grad, t, m, v, lr, beta1,
+                                                beta2, epsilon)
+          self.assertAllCloseAccordingToType(new_var, out)
+
 
 if __name__ == '__main__':
   googletest.main()
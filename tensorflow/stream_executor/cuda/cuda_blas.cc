@@ -265,6 +265,10 @@ PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasSgemmEx)
 
 #if CUDA_VERSION >= 8000
 PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasGemmEx)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasSgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasDgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasCgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasZgemmStridedBatched)
 #endif
 
 }  // namespace wrap
@@ -2130,6 +2134,119 @@ bool CUDABlas::DoBlasGemmBatched(
   return status.ok();
 }
 
+template <typename T, typename FuncT>
+bool CUDABlas::DoBlasGemmStridedBatchedImpl(
+    FuncT cublas_func, Stream *stream, blas::Transpose transa,
+    blas::Transpose transb, uint64 m, uint64 n, uint64 k, T alpha,
+    const DeviceMemory<T> &a, int lda, int64 stride_a, const DeviceMemory<T> &b,
+    int ldb, int64 stride_b, T beta, DeviceMemory<T> *c, int ldc,
+    int64 stride_c, int batch_count) {
+#if CUDA_VERSION >= 8000
+  return DoBlasInternal(
+      cublas_func, stream, true /* = pointer_mode_host */,
+      CUDABlasTranspose(transa), CUDABlasTranspose(transb), m, n, k,
+      CUDAComplex(&alpha), CUDAComplex(CUDAMemory(a)), lda, stride_a,
+      CUDAComplex(CUDAMemory(b)), ldb, stride_b, CUDAComplex(&beta),
+      CUDAComplex(CUDAMemoryMutable(c)), ldc, stride_c, batch_count);
+#else
+  // cuBLAS has no strided batched gemm before CUDA 8, so 'cublas_func' is the
+  // pointer-array batched gemm.
+  std::vector<DeviceMemory<T>> a_matrices, b_matrices, c_matrices;
+  a_matrices.reserve(batch_count);
+  b_matrices.reserve(batch_count);
+  c_matrices.reserve(batch_count);
+  std::vector<DeviceMemory<T> *> a_ptrs, b_ptrs, c_ptrs;
+  for (int i = 0; i < batch_count; ++i) {
+    a_matrices.emplace_back(DeviceMemoryBase(
+        const_cast<T *>(CUDAMemory(a)) + i * stride_a));
+    b_matrices.emplace_back(DeviceMemoryBase(
+        const_cast<T *>(CUDAMemory(b)) + i * stride_b));
+    c_matrices.emplace_back(
+        DeviceMemoryBase(CUDAMemoryMutable(c) + i * stride_c));
+    a_ptrs.push_back(&a_matrices.back());
+    b_ptrs.push_back(&b_matrices.back());
+    c_ptrs.push_back(&c_matrices.back());
+  }
+  port::Status status = DoBlasGemmBatchedInternal(
+      cublas_func, stream, transa, transb, m, n, k, alpha, a_ptrs, lda, b_ptrs,
+      ldb, beta, c_ptrs, ldc, batch_count, /*scratch_allocator=*/nullptr);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+  return status.ok();
+#endif
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, float alpha, const DeviceMemory<float> &a, int lda,
+    int64 stride_a, const DeviceMemory<float> &b, int ldb, int64 stride_b,
+    float beta, DeviceMemory<float> *c, int ldc, int64 stride_c,
+    int batch_count) {
+#if CUDA_VERSION >= 8000
+  auto cublas_func = wrap::cublasSgemmStridedBatched;
+#else
+  auto cublas_func = wrap::cublasSgemmBatched;
+#endif
+  return DoBlasGemmStridedBatchedImpl(cublas_func, stream, transa, transb, m,
+                                      n, k, alpha, a, lda, stride_a, b, ldb,
+                                      stride_b, beta, c, ldc, stride_c,
+                                      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, double alpha, const DeviceMemory<double> &a, int lda,
+    int64 stride_a, const DeviceMemory<double> &b, int ldb, int64 stride_b,
+    double beta, DeviceMemory<double> *c, int ldc, int64 stride_c,
+    int batch_count) {
+#if CUDA_VERSION >= 8000
+  auto cublas_func = wrap::cublasDgemmStridedBatched;
+#else
+  auto cublas_func = wrap::cublasDgemmBatched;
+#endif
+  return DoBlasGemmStridedBatchedImpl(cublas_func, stream, transa, transb, m,
+                                      n, k, alpha, a, lda, stride_a, b, ldb,
+                                      stride_b, beta, c, ldc, stride_c,
+                                      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, std::complex<float> alpha,
+    const DeviceMemory<std::complex<float>> &a, int lda, int64 stride_a,
+    const DeviceMemory<std::complex<float>> &b, int ldb, int64 stride_b,
+    std::complex<float> beta, DeviceMemory<std::complex<float>> *c, int ldc,
+    int64 stride_c, int batch_count) {
+#if CUDA_VERSION >= 8000
+  auto cublas_func = wrap::cublasCgemmStridedBatched;
+#else
+  auto cublas_func = wrap::cublasCgemmBatched;
+#endif
+  return DoBlasGemmStridedBatchedImpl(cublas_func, stream, transa, transb, m,
+                                      n, k, alpha, a, lda, stride_a, b, ldb,
+                                      stride_b, beta, c, ldc, stride_c,
+                                      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, std::complex<double> alpha,
+    const DeviceMemory<std::complex<double>> &a, int lda, int64 stride_a,
+    const DeviceMemory<std::complex<double>> &b, int ldb, int64 stride_b,
+    std::complex<double> beta, DeviceMemory<std::complex<double>> *c, int ldc,
+    int64 stride_c, int batch_count) {
+#if CUDA_VERSION >= 8000
+  auto cublas_func = wrap::cublasZgemmStridedBatched;
+#else
+  auto cublas_func = wrap::cublasZgemmBatched;
+#endif
+  return DoBlasGemmStridedBatchedImpl(cublas_func, stream, transa, transb, m,
+                                      n, k, alpha, a, lda, stride_a, b, ldb,
+                                      stride_b, beta, c, ldc, stride_c,
+                                      batch_count);
+}
+
 bool CUDABlas::DoBlasHemm(Stream *stream, blas::Side side,
                           blas::UpperLower uplo, uint64 m, uint64 n,
                           std::complex<float> alpha,
@@ -244,7 +244,11 @@ CUDNN_DNN_ROUTINE_EACH_R5(PERFTOOLS_GPUTOOLS_CUDNN_WRAP)
 // clang-format off
 #if CUDNN_VERSION >= 6000
 #define CUDNN_DNN_ROUTINE_EACH_R6(__macro)                    \
-  __macro(cudnnConvolutionBiasActivationForward)
+  __macro(cudnnConvolutionBiasActivationForward)              \
+  __macro(cudnnSetRNNDescriptor_v6)                           \
+  __macro(cudnnCreatePersistentRNNPlan)                       \
+  __macro(cudnnSetPersistentRNNPlan)                          \
+  __macro(cudnnDestroyPersistentRNNPlan)
 
 // clang-format on
 CUDNN_DNN_ROUTINE_EACH_R6(PERFTOOLS_GPUTOOLS_CUDNN_WRAP)
@@ -846,6 +850,19 @@ cudnnRNNMode_t ToCudnnRnnMode(dnn::RnnMode rnn_mode) {
   }
 }
 
+#if CUDNN_VERSION >= 6000
+cudnnRNNAlgo_t ToCudnnRnnAlgo(dnn::RnnAlgorithm algorithm) {
+  switch (algorithm) {
+    case dnn::RnnAlgorithm::kRnnStandard:
+      return CUDNN_RNN_ALGO_STANDARD;
+    case dnn::RnnAlgorithm::kRnnPersistStatic:
+      return CUDNN_RNN_ALGO_PERSIST_STATIC;
+    default:
+      LOG(FATAL) << "Invalid RNN algorithm: " << static_cast<int>(algorithm);
+  }
+}
+#endif  // CUDNN_VERSION >= 6000
+
 int CudnnDataTypeToByteSize(cudnnDataType_t data_type) {
   switch (data_type) {
     case CUDNN_DATA_FLOAT:
@@ -992,6 +1009,7 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
                      cudnnRNNInputMode_t input_mode,
                      cudnnDirectionMode_t direction_mode,
                      cudnnRNNMode_t rnn_mode, cudnnDataType_t data_type,
+                     dnn::RnnAlgorithm algorithm, int batch_size,
                      float dropout, uint64 seed,
                      ScratchAllocator* state_allocator)
       : parent_(parent),
@@ -1014,12 +1032,40 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
     // Create the RNN handle
     cudnnStatus_t status = wrap::cudnnCreateRNNDescriptor(parent_, &rnn_desc_);
     CUDNN_RETURN_IF_FAIL(status, "Unable to create RNN descriptor");
+#if CUDNN_VERSION >= 6000
+    status = wrap::cudnnSetRNNDescriptor_v6(
+        parent, cudnn_handle /*handle*/, rnn_desc_ /*rnnDesc*/,
+        hidden_size /*hiddenSize*/, num_layers /*numLayers*/,
+        dropout_handle() /*dropoutDesc*/, input_mode /*inputMode*/,
+        direction_mode /*direction*/, rnn_mode /*mode*/,
+        ToCudnnRnnAlgo(algorithm) /*algo*/, data_type /*dataType*/);
+    CUDNN_RETURN_IF_FAIL(status, "Unable to update RNN descriptor");
+
+    // The persistent kernels need a plan for the minibatch size.
+    if (algorithm == dnn::RnnAlgorithm::kRnnPersistStatic) {
+      status = wrap::cudnnCreatePersistentRNNPlan(
+          parent, rnn_desc_ /*rnnDesc*/, batch_size /*minibatch*/,
+          data_type /*dataType*/, &persistent_plan_ /*plan*/);
+      CUDNN_RETURN_IF_FAIL(status, "Unable to create persistent RNN plan");
+      status = wrap::cudnnSetPersistentRNNPlan(parent, rnn_desc_,
+                                               persistent_plan_);
+      CUDNN_RETURN_IF_FAIL(status, "Unable to set persistent RNN plan");
+    }
+#else
+    if (algorithm != dnn::RnnAlgorithm::kRnnStandard) {
+      string error_msg = port::StrCat(
+          "Persistent RNN algorithms need at least Cudnn 6.0 to work. ",
+          "Current Cudnn version: ", CUDNN_VERSION, ". ");
+      SetFailure(port::Status(port::error::UNIMPLEMENTED, error_msg));
+      return;
+    }
     status = wrap::cudnnSetRNNDescriptor(
         parent, rnn_desc_ /*rnnDesc*/, hidden_size /*hiddenSize*/,
         num_layers /*numLayers*/, dropout_handle() /*dropoutDesc*/,
         input_mode /*inputMode*/, direction_mode /*direction*/,
         rnn_mode /*mode*/, data_type /*dataType*/);
     CUDNN_RETURN_IF_FAIL(status, "Unable to update RNN descriptor");
+#endif  // CUDNN_VERSION >= 6000
 
     // Create the params handle.
     cudnn_params_desc_.reset(
@@ -1030,6 +1076,13 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
     }
   }
   ~CudnnRnnDescriptor() override {
+#if CUDNN_VERSION >= 6000
+    if (persistent_plan_) {
+      cudnnStatus_t status =
+          wrap::cudnnDestroyPersistentRNNPlan(parent_, persistent_plan_);
+      CUDNN_RETURN_IF_FAIL(status, "Unable to destroy persistent RNN plan");
+    }
+#endif  // CUDNN_VERSION >= 6000
     if (rnn_desc_) {
       cudnnStatus_t status =
           wrap::cudnnDestroyRNNDescriptor(parent_, rnn_desc_);
@@ -1070,6 +1123,9 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
  private:
   CUDAExecutor* parent_;
   cudnnRNNDescriptor_t rnn_desc_;
+#if CUDNN_VERSION >= 6000
+  cudnnPersistentRNNPlan_t persistent_plan_ = nullptr;
+#endif  // CUDNN_VERSION >= 6000
   int num_layers_;
   int hidden_size_;
   int input_size_;
@@ -1658,16 +1714,17 @@ CudnnSupport::createRnnDescriptor(int num_layers, int hidden_size,
                                   int input_size, dnn::RnnInputMode input_mode,
                                   dnn::RnnDirectionMode direction_mode,
                                   dnn::RnnMode rnn_mode,
-                                  dnn::DataType data_type, float dropout,
-                                  uint64 seed,
+                                  dnn::DataType data_type,
+                                  dnn::RnnAlgorithm algorithm, int batch_size,
+                                  float dropout, uint64 seed,
                                   ScratchAllocator* state_allocator) {
 #if CUDNN_VERSION >= 5000
   mutex_lock lock{dnn_handle_mutex_};
   std::unique_ptr<CudnnRnnDescriptor> rnn_desc(new CudnnRnnDescriptor(
       parent_, ToHandle(dnn_handle_), num_layers, hidden_size, input_size,
       ToCudnnRnnInputMode(input_mode), ToCudnnRnnDirectionMode(direction_mode),
-      ToCudnnRnnMode(rnn_mode), ToCudnnDataType(data_type), dropout, seed,
-      state_allocator));
+      ToCudnnRnnMode(rnn_mode), ToCudnnDataType(data_type), algorithm,
+      batch_size, dropout, seed, state_allocator));
   if (!rnn_desc->ok()) {
     return rnn_desc->Status();
   }
@@ -1967,7 +2024,7 @@ bool CudnnSupport::DoConvolveImpl(
     return false;
   }
 
-  if (has_biases && activation_mode != dnn::ActivationMode::kNone) {
+  if (has_biases && activation_mode == dnn::ActivationMode::kNone) {
     LOG(ERROR) << "To use cudnnConvolutionBiasActivationForward() "
                   "with a valid biases tensor, need to also provide "
                   "a valid activation mode (currently only supports "
@@ -2013,7 +2070,7 @@ bool CudnnSupport::DoConvolveImpl(
         /*filterData=*/filter_data.opaque(), /*convDesc=*/conv.handle(),
         /*algo=*/algo, /*workSpace=*/scratch.opaque(),
         /*workSpaceSizeInBytes=*/scratch.size(), /*alpha2=*/&beta,
-        /*zDesc=*/output_nd.handle(), /*z=*/nullptr,
+        /*zDesc=*/output_nd.handle(), /*z=*/output_data->opaque(),
         /*biasDesc=*/bias_descriptor.handle(),
         /*bias=*/biases.opaque(), /*activationDesc=*/activation_desc.handle(),
         /*destDesc=*/output_nd.handle(), /*destData=*/output_data->opaque());
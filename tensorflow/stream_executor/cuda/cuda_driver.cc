@@ -945,6 +945,77 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   }
 }
 
+/* static */ void *CUDADriver::UnifiedMemoryAllocate(CudaContext *context,
+                                                     uint64 bytes) {
+  ScopedActivateContext activation{context};
+  CUdeviceptr result = 0;
+  CUresult res = cuMemAllocManaged(&result, bytes, CU_MEM_ATTACH_GLOBAL);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to allocate "
+               << port::HumanReadableNumBytes::ToString(bytes) << " (" << bytes
+               << " bytes) of unified memory: " << ToString(res);
+    return nullptr;
+  }
+  void *ptr = reinterpret_cast<void *>(result);
+  VLOG(2) << "allocated " << ptr << " for context " << context << " of "
+          << bytes << " bytes of unified memory";
+  return ptr;
+}
+
+/* static */ void CUDADriver::UnifiedMemoryDeallocate(CudaContext *context,
+                                                     void *location) {
+  ScopedActivateContext activation{context};
+  CUdeviceptr pointer = port::bit_cast<CUdeviceptr>(location);
+  CUresult res = cuMemFree(pointer);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to free unified memory at " << location
+               << "; result: " << ToString(res);
+  } else {
+    VLOG(2) << "deallocated unified memory at " << location
+            << " for context " << context;
+  }
+}
+
+/* static */ bool CUDADriver::UnifiedMemoryPrefetch(CudaContext *context,
+                                                   CUdeviceptr location,
+                                                   uint64 bytes,
+                                                   CUdevice device,
+                                                   CUstream stream) {
+#if CUDA_VERSION >= 8000
+  ScopedActivateContext activation{context};
+  CUresult res = cuMemPrefetchAsync(location, bytes, device, stream);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to prefetch " << bytes << " bytes of unified memory "
+               << "at " << port::bit_cast<void *>(location)
+               << " to device: " << ToString(res);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif  // CUDA_VERSION >= 8000
+}
+
+/* static */ bool CUDADriver::UnifiedMemoryPreferDevice(CudaContext *context,
+                                                       CUdeviceptr location,
+                                                       uint64 bytes,
+                                                       CUdevice device) {
+#if CUDA_VERSION >= 8000
+  ScopedActivateContext activation{context};
+  CUresult res = cuMemAdvise(location, bytes,
+                             CU_MEM_ADVISE_SET_PREFERRED_LOCATION, device);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to set the preferred location of " << bytes
+               << " bytes of unified memory at "
+               << port::bit_cast<void *>(location) << ": " << ToString(res);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif  // CUDA_VERSION >= 8000
+}
+
 /* static */ void *CUDADriver::HostAllocate(CudaContext *context,
                                             uint64 bytes) {
   ScopedActivateContext activation{context};
@@ -107,6 +107,29 @@ class CUDADriver {
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1g89b3f154e17cc89b6eea277dbdf5c93a
   static void DeviceDeallocate(CudaContext* context, void *location);
 
+  // Allocates memory of size bytes that is accessible from the host and all
+  // devices, and migrated on demand by the driver, via cuMemAllocManaged.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1gb347ded34dc326af404aa02af5388a32
+  static void *UnifiedMemoryAllocate(CudaContext* context, uint64 bytes);
+
+  // Deallocates a location created by UnifiedMemoryAllocate, via cuMemFree.
+  static void UnifiedMemoryDeallocate(CudaContext* context, void *location);
+
+  // Asynchronously migrates bytes of unified memory at location to device on
+  // stream, via cuMemPrefetchAsync. Requires CUDA 8.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__UNIFIED.html#group__CUDA__UNIFIED_1gfe94f8b7fb56291ebcea44261aa4cb84
+  static bool UnifiedMemoryPrefetch(CudaContext* context, CUdeviceptr location,
+                                    uint64 bytes, CUdevice device,
+                                    CUstream stream);
+
+  // Sets the preferred location of bytes of unified memory at location to
+  // device, via cuMemAdvise, so that the driver migrates the pages to the
+  // device on access and evicts other pages first. Requires CUDA 8.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__UNIFIED.html#group__CUDA__UNIFIED_1g27608c857a9254789c13f3e3b72029e2
+  static bool UnifiedMemoryPreferDevice(CudaContext* context,
+                                        CUdeviceptr location, uint64 bytes,
+                                        CUdevice device);
+
   // Allocates page-locked and CUDA-registered memory on the host via
   // cuMemAllocHost.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1gdd8311286d2c2691605362c689bc64e0
@@ -447,6 +447,19 @@ void CUDAExecutor::Deallocate(DeviceMemoryBase *mem) {
   }
 }
 
+bool CUDAExecutor::UnifiedMemoryPrefetch(Stream *stream, const void *location,
+                                         uint64 size) {
+  return CUDADriver::UnifiedMemoryPrefetch(
+      context_, port::bit_cast<CUdeviceptr>(location), size, device_,
+      AsCUDAStreamValue(stream));
+}
+
+bool CUDAExecutor::UnifiedMemoryPreferDevice(const void *location,
+                                             uint64 size) {
+  return CUDADriver::UnifiedMemoryPreferDevice(
+      context_, port::bit_cast<CUdeviceptr>(location), size, device_);
+}
+
 bool CUDAExecutor::HostMemoryRegister(void *location, uint64 size) {
   if (location == nullptr || size == 0) {
     LOG(WARNING) << "attempting to register null or zero-sized memory: "
@@ -86,6 +86,19 @@ class CUDAExecutor : public internal::StreamExecutorInterface {
     return CUDADriver::HostDeallocate(context_, location);
   }
 
+  void *UnifiedMemoryAllocate(uint64 size) override {
+    return CUDADriver::UnifiedMemoryAllocate(context_, size);
+  }
+
+  void UnifiedMemoryDeallocate(void *location) override {
+    return CUDADriver::UnifiedMemoryDeallocate(context_, location);
+  }
+
+  bool UnifiedMemoryPrefetch(Stream *stream, const void *location,
+                             uint64 size) override;
+
+  bool UnifiedMemoryPreferDevice(const void *location, uint64 size) override;
+
   bool HostMemoryRegister(void *location, uint64 size) override;
 
   bool HostMemoryUnregister(void *location) override;
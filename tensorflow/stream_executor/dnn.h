@@ -136,6 +136,15 @@ enum class RnnDirectionMode {
   kRnnBidirectional = 1,
 };
 
+// Specifies the algorithm that runs a RNN model. The persistent algorithm
+// keeps the recurrent weights resident on the multiprocessors for the whole
+// sequence, which is faster for small minibatches but only supports the
+// minibatch size its plan was built for.
+enum class RnnAlgorithm {
+  kRnnStandard = 0,
+  kRnnPersistStatic = 1,
+};
+
 // Relevant to DepthToSpace and SpaceToDepth. This is the write layout when
 // performing depth to space and the read layout when performing space to depth.
 // It's specified with most-major dimension first and most-minor dimension last.
@@ -1812,6 +1821,9 @@ class DnnSupport {
   //    bidirectional.
   //  rnn_mode: an enum to specify the type of model to build.
   //  data_type: an enum to specify the data types used in this model.
+  //  algorithm: an enum to specify the algorithm that runs the model.
+  //  batch_size: the minibatch size that a persistent algorithm is planned
+  //    for. It is ignored by the standard algorithm.
   //  dropout: the dropout threshold between layers. When it is 0., no dropout
   //    is added.
   //  seed: a seed for initializing the dropout layers.
@@ -1823,6 +1835,7 @@ class DnnSupport {
                       dnn::RnnInputMode input_mode,
                       dnn::RnnDirectionMode direction_mode,
                       dnn::RnnMode rnn_mode, dnn::DataType data_type,
+                      dnn::RnnAlgorithm algorithm, int batch_size,
                       float dropout, uint64 seed,
                       ScratchAllocator* state_allocator) {
     return port::Status{port::error::UNIMPLEMENTED,
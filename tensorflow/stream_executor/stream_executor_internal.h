@@ -173,6 +173,15 @@ class StreamExecutorInterface {
   virtual void *AllocateSubBuffer(DeviceMemoryBase *parent, uint64 offset,
                                   uint64 size) = 0;
   virtual void Deallocate(DeviceMemoryBase *mem) = 0;
+  virtual void *UnifiedMemoryAllocate(uint64 size) { return nullptr; }
+  virtual void UnifiedMemoryDeallocate(void *mem) {}
+  virtual bool UnifiedMemoryPrefetch(Stream *stream, const void *mem,
+                                     uint64 size) {
+    return false;
+  }
+  virtual bool UnifiedMemoryPreferDevice(const void *mem, uint64 size) {
+    return false;
+  }
   virtual void *HostMemoryAllocate(uint64 size) = 0;
   virtual void HostMemoryDeallocate(void *mem) = 0;
   virtual bool HostMemoryRegister(void *mem, uint64 size) = 0;
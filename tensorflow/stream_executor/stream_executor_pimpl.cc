@@ -330,7 +330,8 @@ port::StatusOr<std::unique_ptr<dnn::RnnDescriptor>>
 StreamExecutor::createRnnDescriptor(
     int num_layers, int hidden_size, int input_size,
     dnn::RnnInputMode input_mode, dnn::RnnDirectionMode direction_mode,
-    dnn::RnnMode rnn_mode, dnn::DataType data_type, float dropout, uint64 seed,
+    dnn::RnnMode rnn_mode, dnn::DataType data_type,
+    dnn::RnnAlgorithm algorithm, int batch_size, float dropout, uint64 seed,
     ScratchAllocator *state_allocator) {
   dnn::DnnSupport *dnn_support = AsDnn();
   if (!dnn_support) {
@@ -339,7 +340,7 @@ StreamExecutor::createRnnDescriptor(
   }
   return dnn_support->createRnnDescriptor(
       num_layers, hidden_size, input_size, input_mode, direction_mode, rnn_mode,
-      data_type, dropout, seed, state_allocator);
+      data_type, algorithm, batch_size, dropout, seed, state_allocator);
 }
 
 port::StatusOr<std::unique_ptr<dnn::RnnSequenceTensorDescriptor>>
@@ -435,6 +436,35 @@ void *StreamExecutor::Allocate(uint64 size) {
   return buf;
 }
 
+void *StreamExecutor::UnifiedMemoryAllocate(uint64 bytes) {
+  void *buffer = implementation_->UnifiedMemoryAllocate(bytes);
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryAllocate(size=" << bytes
+          << ") returns " << buffer << StackTraceIfVLOG10();
+  return buffer;
+}
+
+void StreamExecutor::UnifiedMemoryDeallocate(void *location) {
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryDeallocate(location="
+          << location << ")" << StackTraceIfVLOG10();
+  return implementation_->UnifiedMemoryDeallocate(location);
+}
+
+bool StreamExecutor::UnifiedMemoryPrefetch(Stream *stream,
+                                           const void *location,
+                                           uint64 size) {
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryPrefetch(stream=" << stream
+          << ", location=" << location << ", size=" << size << ")"
+          << StackTraceIfVLOG10();
+  return implementation_->UnifiedMemoryPrefetch(stream, location, size);
+}
+
+bool StreamExecutor::UnifiedMemoryPreferDevice(const void *location,
+                                               uint64 size) {
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryPreferDevice(location="
+          << location << ", size=" << size << ")" << StackTraceIfVLOG10();
+  return implementation_->UnifiedMemoryPreferDevice(location, size);
+}
+
 bool StreamExecutor::GetSymbol(const string &symbol_name, void **mem,
                                size_t *bytes) {
   return implementation_->GetSymbol(symbol_name, mem, bytes);
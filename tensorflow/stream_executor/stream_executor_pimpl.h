@@ -177,6 +177,28 @@ class StreamExecutor {
   // null-out effect should not be relied upon in client code.
   void Deallocate(DeviceMemoryBase *mem);
 
+  // Allocates a region of unified memory, which is accessible from the host
+  // and all devices and is migrated between them on demand by the platform,
+  // so that more memory than the device has can be allocated. Returns nullptr
+  // if the platform does not support unified memory or the allocation fails.
+  void *UnifiedMemoryAllocate(uint64 bytes);
+
+  // Deallocates a region of unified memory allocated by
+  // UnifiedMemoryAllocate().
+  void UnifiedMemoryDeallocate(void *location);
+
+  // Enqueues on 'stream' a migration of "size" bytes of unified memory at
+  // "location" to the device, so that work enqueued after it does not fault
+  // on the pages one at a time. Returns false if unsupported.
+  bool UnifiedMemoryPrefetch(Stream *stream, const void *location,
+                             uint64 size) SE_MUST_USE_RESULT;
+
+  // Advises the platform to keep "size" bytes of unified memory at
+  // "location" on the device, and to evict other pages first when the device
+  // runs out of memory. Returns false if unsupported.
+  bool UnifiedMemoryPreferDevice(const void *location,
+                                 uint64 size) SE_MUST_USE_RESULT;
+
   // Retrieves a mapping of active opaque GPU memory pointer to a string
   // representation of the [allocating thread's] stack at the time the pointer
   // was allocated. Useful for tracking GPU memory leaks.
@@ -364,8 +386,9 @@ class StreamExecutor {
   port::StatusOr<std::unique_ptr<dnn::RnnDescriptor>> createRnnDescriptor(
       int num_layers, int hidden_size, int input_size,
       dnn::RnnInputMode input_mode, dnn::RnnDirectionMode direction_mode,
-      dnn::RnnMode rnn_mode, dnn::DataType data_type, float dropout,
-      uint64 seed, ScratchAllocator *state_allocator);
+      dnn::RnnMode rnn_mode, dnn::DataType data_type,
+      dnn::RnnAlgorithm algorithm, int batch_size, float dropout, uint64 seed,
+      ScratchAllocator *state_allocator);
 
   // Create a RNN sequence descriptor that specifies either the input or output
   // sequence. The caller retains the ownership of the returned descriptor.
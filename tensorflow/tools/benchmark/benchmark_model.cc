@@ -20,6 +20,9 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -33,11 +36,15 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
@@ -222,6 +229,8 @@ Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
   RunOptions run_options;
   if (stats != nullptr) {
     run_options.set_trace_level(RunOptions::FULL_TRACE);
+    run_options.set_collect_hardware_counters(
+        stats->options().show_cache_misses);
   }
 
   RunMetadata run_metadata;
@@ -289,6 +298,177 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   return Status::OK();
 }
 
+int64 LoadStats::Percentile(double percentile) const {
+  if (latencies_us.empty()) return 0;
+  // Nearest-rank percentile, with a margin for the rounding of "percentile".
+  const int64 rank = static_cast<int64>(
+      std::ceil(percentile / 100.0 * latencies_us.size() - 1e-6));
+  const int64 index = std::min<int64>(
+      std::max<int64>(rank - 1, 0), latencies_us.size() - 1);
+  return latencies_us[index];
+}
+
+Status RunLoad(int num_clients, double target_qps, int num_runs,
+               const std::vector<InputLayerInfo>& inputs,
+               const std::vector<string>& outputs, Session* session,
+               StatSummarizer* stats, LoadStats* load_stats) {
+  if (num_clients < 1) {
+    return errors::InvalidArgument("num_clients must be positive, got ",
+                                   num_clients);
+  }
+  LOG(INFO) << "Running benchmark for " << num_runs << " iterations from "
+            << num_clients << " clients"
+            << (target_qps > 0 ? strings::StrCat(" at ", target_qps, " QPS")
+                               : "")
+            << (stats != nullptr ? " with" : " without")
+            << " detailed stat logging:";
+
+  RunOptions run_options;
+  if (stats != nullptr) {
+    run_options.set_trace_level(RunOptions::FULL_TRACE);
+    run_options.set_collect_hardware_counters(
+        stats->options().show_cache_misses);
+  }
+  Env* env = Env::Default();
+  std::atomic<int> next_run(0);
+  mutex mu;
+  Status status;
+  std::vector<int64> latencies_us;
+  latencies_us.reserve(num_runs);
+  std::map<string, int64> peak_bytes_in_use;
+  int64 start_time;
+
+  auto client = [&]() {
+    std::vector<std::pair<string, Tensor> > input_tensors;
+    CreateTensorsFromInputInfo(inputs, &input_tensors);
+    std::vector<Tensor> output_tensors;
+    for (int i = next_run++; i < num_runs; i = next_run++) {
+      int64 issue_time = env->NowMicros();
+      if (target_qps > 0) {
+        const int64 scheduled_time =
+            start_time + static_cast<int64>(i * 1000000.0 / target_qps);
+        if (scheduled_time > issue_time) {
+          env->SleepForMicroseconds(scheduled_time - issue_time);
+        }
+        issue_time = scheduled_time;
+      }
+      RunMetadata run_metadata;
+      output_tensors.clear();
+      Status s = session->Run(run_options, input_tensors, outputs, {},
+                              &output_tensors, &run_metadata);
+      const int64 latency_us = env->NowMicros() - issue_time;
+
+      mutex_lock l(mu);
+      if (!s.ok()) {
+        LOG(ERROR) << "Error during inference: " << s;
+        status.Update(s);
+        // Make the other clients stop after their current run.
+        next_run = num_runs;
+        return;
+      }
+      latencies_us.push_back(latency_us);
+      if (stats != nullptr) {
+        const StepStats& step_stats = run_metadata.step_stats();
+        stats->ProcessStepStats(step_stats);
+        for (const auto& device_stats : step_stats.dev_stats()) {
+          for (const auto& node_stats : device_stats.node_stats()) {
+            for (const auto& memory : node_stats.memory()) {
+              int64& peak = peak_bytes_in_use[memory.allocator_name()];
+              peak = std::max(peak, memory.allocator_bytes_in_use());
+            }
+          }
+        }
+      }
+    }
+  };
+
+  start_time = env->NowMicros();
+  {
+    thread::ThreadPool pool(env, "benchmark_client", num_clients);
+    for (int c = 0; c < num_clients; ++c) {
+      pool.Schedule(client);
+    }
+    // The destructor waits for the clients to finish.
+  }
+  load_stats->wall_time_us = env->NowMicros() - start_time;
+  TF_RETURN_IF_ERROR(status);
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  load_stats->latencies_us = std::move(latencies_us);
+  load_stats->peak_bytes_in_use = std::move(peak_bytes_in_use);
+  return Status::OK();
+}
+
+// Logs the throughput and latency percentiles of a load run.
+void LogLoadStats(const LoadStats& load_stats) {
+  const int64 num_runs = load_stats.latencies_us.size();
+  const int64 wall_time_us = std::max<int64>(load_stats.wall_time_us, 1);
+  LOG(INFO) << "Throughput: " << num_runs * 1000000.0 / wall_time_us
+            << " runs/second";
+  LOG(INFO) << "Latency in us: p50=" << load_stats.Percentile(50)
+            << " p90=" << load_stats.Percentile(90)
+            << " p99=" << load_stats.Percentile(99)
+            << " p999=" << load_stats.Percentile(99.9)
+            << " max=" << load_stats.Percentile(100);
+}
+
+// Writes the results of a load run, and the per-op-type stats gathered while
+// running it, as JSON for regression dashboards.
+Status WriteLoadStatsJson(const string& filename, int num_clients,
+                          double target_qps, const LoadStats& no_stat_load,
+                          const LoadStats& stat_load,
+                          const StatSummarizer& stats) {
+  const int64 num_runs = no_stat_load.latencies_us.size();
+  int64 latency_sum_us = 0;
+  for (int64 latency_us : no_stat_load.latencies_us) {
+    latency_sum_us += latency_us;
+  }
+  string json = strings::StrCat(
+      "{\n  \"num_runs\": ", num_runs, ",\n  \"num_clients\": ", num_clients,
+      ",\n  \"target_qps\": ", target_qps, ",\n  \"wall_time_us\": ",
+      no_stat_load.wall_time_us, ",\n  \"qps\": ",
+      num_runs * 1000000.0 / std::max<int64>(no_stat_load.wall_time_us, 1),
+      ",\n  \"latency_us\": {\"avg\": ",
+      num_runs > 0 ? latency_sum_us / num_runs : 0,
+      ", \"p50\": ", no_stat_load.Percentile(50),
+      ", \"p90\": ", no_stat_load.Percentile(90),
+      ", \"p99\": ", no_stat_load.Percentile(99),
+      ", \"p999\": ", no_stat_load.Percentile(99.9),
+      ", \"max\": ", no_stat_load.Percentile(100), "},\n");
+
+  strings::StrAppend(&json, "  \"peak_bytes_in_use\": {");
+  const char* separator = "";
+  for (const auto& peak : stat_load.peak_bytes_in_use) {
+    strings::StrAppend(&json, separator, "\"", str_util::CEscape(peak.first),
+                       "\": ", peak.second);
+    separator = ", ";
+  }
+  strings::StrAppend(&json, "},\n");
+
+  std::map<string, int64> node_type_map_count;
+  std::map<string, int64> node_type_map_time;
+  std::map<string, int64> node_type_map_memory;
+  std::map<string, int64> node_type_map_times_called;
+  int64 accumulated_us;
+  stats.ComputeStatsByType(&node_type_map_count, &node_type_map_time,
+                           &node_type_map_memory, &node_type_map_times_called,
+                           &accumulated_us);
+  strings::StrAppend(&json, "  \"op_types\": [");
+  separator = "\n";
+  for (const auto& time : node_type_map_time) {
+    const string& type = time.first;
+    strings::StrAppend(
+        &json, separator, "    {\"type\": \"", str_util::CEscape(type),
+        "\", \"count\": ", node_type_map_count[type],
+        ", \"avg_us\": ", time.second, ", \"memory_bytes\": ",
+        node_type_map_memory[type], ", \"times_called\": ",
+        node_type_map_times_called[type], "}");
+    separator = ",\n";
+  }
+  strings::StrAppend(&json, "\n  ]\n}\n");
+  return WriteStringToFile(Env::Default(), filename, json);
+}
+
 int Main(int argc, char** argv) {
   string graph = "/data/local/tmp/tensorflow_inception_graph.pb";
   string input_layer_string = "input:0";
@@ -311,7 +491,12 @@ int Main(int argc, char** argv) {
   bool show_type = true;
   bool show_summary = true;
   bool show_flops = false;
+  bool show_cache_misses = false;
+  int cache_misses_limit = 10;
   int warmup_runs = 2;
+  int num_clients = 1;
+  double target_qps = 0;
+  string output_json = "";
 
   std::vector<Flag> flag_list = {
       Flag("graph", &graph, "graph file name"),
@@ -340,7 +525,21 @@ int Main(int argc, char** argv) {
       Flag("show_summary", &show_summary,
            "whether to show a summary of the stats"),
       Flag("show_flops", &show_flops, "whether to estimate the model's FLOPs"),
+      Flag("show_cache_misses", &show_cache_misses,
+           "whether to count the cycles, instructions and cache misses of "
+           "each op with hardware counters, and list stats by cache misses "
+           "(Linux and Android only)"),
+      Flag("cache_misses_limit", &cache_misses_limit,
+           "how many items to show by cache misses"),
       Flag("warmup_runs", &warmup_runs, "how many runs to initialize model"),
+      Flag("num_clients", &num_clients,
+           "number of client threads running the model concurrently"),
+      Flag("target_qps", &target_qps,
+           "if positive, issue runs at this fixed rate instead of as soon as "
+           "a client is free"),
+      Flag("output_json", &output_json,
+           "file to write throughput, latency percentiles, peak memory and "
+           "per-op-type stats to as JSON"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   const bool parse_result = Flags::Parse(&argc, argv, flag_list);
@@ -392,6 +591,8 @@ int Main(int argc, char** argv) {
   LOG(INFO) << "Output prefix: [" << output_prefix << "]";
   LOG(INFO) << "Show sizes: [" << show_sizes << "]";
   LOG(INFO) << "Warmup runs: [" << warmup_runs << "]";
+  LOG(INFO) << "Num clients: [" << num_clients << "]";
+  LOG(INFO) << "Target QPS: [" << target_qps << "]";
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
@@ -411,6 +612,8 @@ int Main(int argc, char** argv) {
   stats_options.memory_limit = memory_limit;
   stats_options.show_type = show_type;
   stats_options.show_summary = show_summary;
+  stats_options.show_cache_misses = show_cache_misses;
+  stats_options.cache_misses_limit = cache_misses_limit;
   stats.reset(new tensorflow::StatSummarizer(stats_options));
 
   const double sleep_seconds = std::strtod(run_delay.c_str(), nullptr);
@@ -455,13 +658,35 @@ int Main(int argc, char** argv) {
     }
   }
 
+  // Concurrent clients, a fixed rate and JSON output all need the latency of
+  // every run, which RunLoad records. The inter-run delay does not apply.
+  const bool load_test =
+      num_clients > 1 || target_qps > 0 || !output_json.empty();
+  if (load_test && sleep_seconds > 0.0) {
+    LOG(WARNING) << "--run_delay is ignored with --num_clients, --target_qps "
+                 << "or --output_json";
+  }
+
   // Capture overall inference time without stat logging overhead. This is the
   // timing data that can be compared to other libaries.
   int64 no_stat_time_us = 0;
-  Status no_stat_time_status =
-      TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
-                       session.get(), nullptr, &no_stat_time_us);
-  const double no_stat_wall_time = no_stat_time_us / 1000000.0;
+  double no_stat_wall_time;
+  LoadStats no_stat_load;
+  Status no_stat_time_status;
+  if (load_test) {
+    no_stat_time_status =
+        RunLoad(num_clients, target_qps, num_runs, inputs, output_layers,
+                session.get(), nullptr, &no_stat_load);
+    for (int64 latency_us : no_stat_load.latencies_us) {
+      no_stat_time_us += latency_us;
+    }
+    no_stat_wall_time = no_stat_load.wall_time_us / 1000000.0;
+  } else {
+    no_stat_time_status =
+        TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
+                         session.get(), nullptr, &no_stat_time_us);
+    no_stat_wall_time = no_stat_time_us / 1000000.0;
+  }
   if (!no_stat_time_status.ok()) {
     LOG(ERROR) << "Timing failed with " << no_stat_time_status;
     return -1;
@@ -470,14 +695,44 @@ int Main(int argc, char** argv) {
   // Run again to gather detailed log stats to get a better idea of where
   // relative time is going within the graph.
   int64 stat_time_us = 0;
-  Status stat_time_status =
-      TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
-                       session.get(), stats.get(), &stat_time_us);
+  LoadStats stat_load;
+  Status stat_time_status;
+  if (load_test) {
+    stat_time_status =
+        RunLoad(num_clients, target_qps, num_runs, inputs, output_layers,
+                session.get(), stats.get(), &stat_load);
+    for (int64 latency_us : stat_load.latencies_us) {
+      stat_time_us += latency_us;
+    }
+  } else {
+    stat_time_status =
+        TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
+                         session.get(), stats.get(), &stat_time_us);
+  }
   if (!stat_time_status.ok()) {
     LOG(ERROR) << "Timing failed with " << stat_time_status;
     return -1;
   }
 
+  if (load_test) {
+    LogLoadStats(no_stat_load);
+    // Only the runs with stats record memory use.
+    for (const auto& peak : stat_load.peak_bytes_in_use) {
+      LOG(INFO) << "Peak memory of " << peak.first << ": "
+                << strings::HumanReadableNumBytes(peak.second);
+    }
+  }
+  if (!output_json.empty()) {
+    Status json_status =
+        WriteLoadStatsJson(output_json, num_clients, target_qps, no_stat_load,
+                           stat_load, *stats);
+    if (!json_status.ok()) {
+      LOG(ERROR) << "Writing " << output_json << " failed with "
+                 << json_status;
+      return -1;
+    }
+  }
+
   LOG(INFO) << "Average inference timings in us: "
             << "Warmup: "
             << (warmup_runs > 0 ? warmup_time_us / warmup_runs : 0) << ", "
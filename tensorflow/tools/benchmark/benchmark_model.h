@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 #define TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 
+#include <map>
+#include <vector>
+
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/stat_summarizer.h"
 
@@ -46,6 +49,34 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         const std::vector<string>& outputs, Session* session,
                         StatSummarizer* stats, int64* total_time_us);
 
+// Latencies and memory use of the runs of RunLoad.
+struct LoadStats {
+  // Latency of each run, in increasing order.
+  std::vector<int64> latencies_us;
+  // Time from the start of the first run to the end of the last one.
+  int64 wall_time_us = 0;
+  // The highest number of bytes in use seen in each allocator, which is
+  // only recorded when running with a StatSummarizer.
+  std::map<string, int64> peak_bytes_in_use;
+
+  // Returns the latency that "percentile" percent of the runs are at or
+  // below, or 0 if there were no runs.
+  int64 Percentile(double percentile) const;
+};
+
+// Runs the model "num_runs" times in total from "num_clients" concurrent
+// client threads, each of which reuses one set of input tensors.
+//
+// If "target_qps" is positive, the load is open-loop: run i is issued at
+// i / target_qps seconds after the start by the next free client, and its
+// latency is measured from that scheduled time, so that the time a run waits
+// for a free client counts. Otherwise every client issues its next run as
+// soon as its previous one returns.
+Status RunLoad(int num_clients, double target_qps, int num_runs,
+               const std::vector<InputLayerInfo>& inputs,
+               const std::vector<string>& outputs, Session* session,
+               StatSummarizer* stats, LoadStats* load_stats);
+
 // Handles all setup and argument parsing.
 int Main(int argc, char** argv);
 
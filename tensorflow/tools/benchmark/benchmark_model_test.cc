@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <algorithm>
+
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
@@ -26,16 +28,15 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-TEST(BenchmarkModelTest, InitializeAndRun) {
-  const string dir = testing::TmpDir();
-  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
-
-  // Create a simple graph and write it to filename_pb.
+// Writes a graph multiplying a placeholder by a constant to "filename_pb",
+// and returns the input and output of the graph.
+void CreateTestGraph(const string& filename_pb,
+                     benchmark_model::InputLayerInfo* input,
+                     string* output_name) {
   const int input_width = 400;
   const int input_height = 10;
-  benchmark_model::InputLayerInfo input;
-  input.shape = TensorShape({input_width, input_height});
-  input.data_type = DT_FLOAT;
+  input->shape = TensorShape({input_width, input_height});
+  input->data_type = DT_FLOAT;
   const TensorShape constant_shape({input_height, input_width});
 
   Tensor constant_tensor(DT_FLOAT, constant_shape);
@@ -43,10 +44,10 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
 
   auto root = Scope::NewRootScope().ExitOnError();
   auto placeholder =
-      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input.shape));
-  input.name = placeholder.node()->name();
+      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input->shape));
+  input->name = placeholder.node()->name();
   auto m = ops::MatMul(root, placeholder, constant_tensor);
-  const string output_name = m.node()->name();
+  *output_name = m.node()->name();
 
   GraphDef graph_def;
   TF_ASSERT_OK(root.ToGraphDef(&graph_def));
@@ -54,6 +55,13 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   graph_def.SerializeToString(&graph_def_serialized);
   TF_ASSERT_OK(
       WriteStringToFile(Env::Default(), filename_pb, graph_def_serialized));
+}
+
+TEST(BenchmarkModelTest, InitializeAndRun) {
+  const string filename_pb = io::JoinPath(testing::TmpDir(), "graphdef.pb");
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
 
   std::unique_ptr<Session> session;
   std::unique_ptr<GraphDef> loaded_graph_def;
@@ -66,5 +74,52 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
       0.0, 10, {input}, {output_name}, session.get(), stats.get(), &time));
 }
 
+TEST(BenchmarkModelTest, RunLoad) {
+  const string filename_pb = io::JoinPath(testing::TmpDir(), "graphdef.pb");
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
+
+  std::unique_ptr<Session> session;
+  std::unique_ptr<GraphDef> loaded_graph_def;
+  TF_ASSERT_OK(benchmark_model::InitializeSession(1, filename_pb, &session,
+                                                  &loaded_graph_def));
+  StatSummarizer stats(*loaded_graph_def);
+
+  // Closed loop.
+  benchmark_model::LoadStats load_stats;
+  TF_ASSERT_OK(benchmark_model::RunLoad(4, 0, 20, {input}, {output_name},
+                                        session.get(), &stats, &load_stats));
+  ASSERT_EQ(20, load_stats.latencies_us.size());
+  EXPECT_TRUE(std::is_sorted(load_stats.latencies_us.begin(),
+                             load_stats.latencies_us.end()));
+  EXPECT_LE(load_stats.Percentile(50), load_stats.Percentile(99));
+  EXPECT_EQ(load_stats.latencies_us.back(), load_stats.Percentile(100));
+  EXPECT_FALSE(load_stats.peak_bytes_in_use.empty());
+  EXPECT_EQ(20, stats.num_runs());
+
+  // Open loop: 10 runs at 100 QPS take at least 90ms.
+  benchmark_model::LoadStats open_loop_stats;
+  TF_ASSERT_OK(benchmark_model::RunLoad(2, 100, 10, {input}, {output_name},
+                                        session.get(), nullptr,
+                                        &open_loop_stats));
+  EXPECT_EQ(10, open_loop_stats.latencies_us.size());
+  EXPECT_GE(open_loop_stats.wall_time_us, 90000);
+  EXPECT_TRUE(open_loop_stats.peak_bytes_in_use.empty());
+}
+
+TEST(BenchmarkModelTest, Percentile) {
+  benchmark_model::LoadStats load_stats;
+  EXPECT_EQ(0, load_stats.Percentile(50));
+  for (int i = 1; i <= 1000; ++i) {
+    load_stats.latencies_us.push_back(i);
+  }
+  EXPECT_EQ(500, load_stats.Percentile(50));
+  EXPECT_EQ(990, load_stats.Percentile(99));
+  EXPECT_EQ(999, load_stats.Percentile(99.9));
+  EXPECT_EQ(1000, load_stats.Percentile(100));
+  EXPECT_EQ(1, load_stats.Percentile(0));
+}
+
 }  // namespace
 }  // namespace tensorflow
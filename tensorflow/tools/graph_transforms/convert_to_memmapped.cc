@@ -0,0 +1,63 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Replaces large Const ops with ImmutableConst ops whose tensors live in the
+// memmapped package written to "output_file", along with the converted graph.
+// Loading the package with a MemmappedEnv maps the weights in from the file
+// instead of copying them onto the heap, so that they can be paged out and
+// shared between processes.
+Status ConvertToMemmapped(const GraphDef& input_graph_def,
+                          const TransformFuncContext& context,
+                          GraphDef* output_graph_def) {
+  string output_file;
+  TF_RETURN_IF_ERROR(
+      context.GetOneStringParameter("output_file", "", &output_file));
+  if (output_file.empty()) {
+    return errors::InvalidArgument(
+        "convert_to_memmapped expects an 'output_file' argument, e.g. "
+        "convert_to_memmapped(output_file=/tmp/model.mmap)");
+  }
+  int32 min_conversion_size_bytes;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter(
+      "min_conversion_size_bytes", 10000, &min_conversion_size_bytes));
+
+  GraphDef graph_def = input_graph_def;
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(Env::Default(), output_file));
+  int convert_counter = 0;
+  TF_RETURN_IF_ERROR(ConvertConstantsToImmutable(
+      &graph_def, &writer, min_conversion_size_bytes, &convert_counter));
+  TF_RETURN_IF_ERROR(writer.SaveProtobuf(
+      graph_def, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef));
+  TF_RETURN_IF_ERROR(writer.FlushAndClose());
+  output_graph_def->Swap(&graph_def);
+  LOG(INFO) << "Converted " << convert_counter << " nodes into "
+            << output_file;
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("convert_to_memmapped", ConvertToMemmapped);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status ConvertToMemmapped(const GraphDef& input_graph_def,
+                          const TransformFuncContext& context,
+                          GraphDef* output_graph_def);
+
+class ConvertToMemmappedTest : public ::testing::Test {
+ protected:
+  void TestConvertToMemmapped() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor a_data(DT_FLOAT, TensorShape({100, 100}));
+    test::FillIota<float>(&a_data, 1.0f);
+    Output a_const = Const(root.WithOpName("a"), Input::Initializer(a_data));
+
+    Tensor b_data(DT_FLOAT, TensorShape({100, 2}));
+    test::FillIota<float>(&b_data, 1.0f);
+    Output b_const = Const(root.WithOpName("b"), Input::Initializer(b_data));
+
+    Output mat_mul = MatMul(root.WithOpName("output"), a_const, b_const);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    const string output_file =
+        io::JoinPath(testing::TmpDir(), "convert_to_memmapped.mmap");
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    context.params["output_file"] = {output_file};
+    context.params["min_conversion_size_bytes"] = {"1000"};
+    GraphDef converted_graph_def;
+    TF_ASSERT_OK(
+        ConvertToMemmapped(original_graph_def, context, &converted_graph_def));
+
+    // Only "a" is large enough to be converted.
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(converted_graph_def, &node_lookup);
+    EXPECT_EQ("ImmutableConst", node_lookup.at("a")->op());
+    EXPECT_EQ("Const", node_lookup.at("b")->op());
+
+    MemmappedEnv memmapped_env(Env::Default());
+    TF_ASSERT_OK(memmapped_env.InitializeFromFile(output_file));
+    GraphDef loaded_graph_def;
+    TF_ASSERT_OK(ReadBinaryProto(
+        &memmapped_env, MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+        &loaded_graph_def));
+
+    SessionOptions session_options;
+    session_options.env = &memmapped_env;
+    std::unique_ptr<Session> memmapped_session(NewSession(session_options));
+    TF_ASSERT_OK(memmapped_session->Create(loaded_graph_def));
+    std::vector<Tensor> memmapped_outputs;
+    TF_ASSERT_OK(
+        memmapped_session->Run({}, {"output"}, {}, &memmapped_outputs));
+
+    test::ExpectTensorEqual<float>(original_outputs[0], memmapped_outputs[0]);
+  }
+
+  void TestMissingOutputFile() {
+    GraphDef graph_def;
+    GraphDef converted_graph_def;
+    EXPECT_FALSE(
+        ConvertToMemmapped(graph_def, {{}, {}}, &converted_graph_def).ok());
+  }
+};
+
+TEST_F(ConvertToMemmappedTest, TestConvertToMemmapped) {
+  TestConvertToMemmapped();
+}
+
+TEST_F(ConvertToMemmappedTest, TestMissingOutputFile) {
+  TestMissingOutputFile();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,210 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+bool IsNHWC(const NodeDef& node) {
+  return !node.attr().count("data_format") ||
+         node.attr().at("data_format").s() == "NHWC";
+}
+
+// _FusedConv2D only has NHWC half and float kernels.
+bool IsFusableConv2D(const NodeDef& node) {
+  if (!IsNHWC(node) || !node.attr().count("T")) return false;
+  const DataType type = node.attr().at("T").type();
+  return type == DT_FLOAT || type == DT_HALF;
+}
+
+// Returns the ops that were fused into a _FusedConv2D, or nothing for a Conv2D.
+std::vector<string> FusedOps(const NodeDef& conv) {
+  if (conv.op() != "_FusedConv2D") return {};
+  const auto& list = conv.attr().at("fused_ops").list();
+  return std::vector<string>(list.s().begin(), list.s().end());
+}
+
+// Replaces "consumer", whose first input is the Conv2D or _FusedConv2D "conv",
+// with a _FusedConv2D of the same name that also applies "consumer". The
+// other inputs of "consumer" become extra args, and "other_nodes" are kept.
+void FuseIntoConv2D(const NodeDef& conv, const NodeDef& consumer,
+                    const std::vector<NodeDef>& other_nodes,
+                    std::vector<NodeDef>* new_nodes) {
+  NodeDef fused_conv;
+  fused_conv.set_op("_FusedConv2D");
+  fused_conv.set_name(consumer.name());
+  fused_conv.set_device(conv.device());
+  std::vector<string> control_inputs;
+  for (const string& input : conv.input()) {
+    if (StringPiece(input).starts_with("^")) {
+      control_inputs.push_back(input);
+    } else {
+      AddNodeInput(input, &fused_conv);
+    }
+  }
+  for (int i = 1; i < consumer.input_size(); ++i) {
+    if (StringPiece(consumer.input(i)).starts_with("^")) {
+      control_inputs.push_back(consumer.input(i));
+    } else {
+      AddNodeInput(consumer.input(i), &fused_conv);
+    }
+  }
+  for (const string& input : control_inputs) {
+    AddNodeInput(input, &fused_conv);
+  }
+
+  CopyNodeAttr(conv, "T", "T", &fused_conv);
+  CopyNodeAttr(conv, "strides", "strides", &fused_conv);
+  CopyNodeAttr(conv, "padding", "padding", &fused_conv);
+  for (const char* name : {"use_cudnn_on_gpu", "data_format", "epsilon"}) {
+    if (conv.attr().count(name)) CopyNodeAttr(conv, name, name, &fused_conv);
+  }
+  if (consumer.op() == "FusedBatchNorm" && consumer.attr().count("epsilon")) {
+    CopyNodeAttr(consumer, "epsilon", "epsilon", &fused_conv);
+  }
+  std::vector<string> fused_ops = FusedOps(conv);
+  fused_ops.push_back(consumer.op());
+  SetNodeAttr("fused_ops", fused_ops, &fused_conv);
+  SetNodeAttr("num_args", fused_conv.input_size() - 2 -
+                              static_cast<int>(control_inputs.size()),
+              &fused_conv);
+
+  new_nodes->insert(new_nodes->end(), other_nodes.begin(), other_nodes.end());
+  new_nodes->push_back(fused_conv);
+}
+
+}  // namespace
+
+// Folds BiasAdd, inference-mode FusedBatchNorm and Relu, Relu6, Tanh or Elu
+// ops that follow a Conv2D into a single _FusedConv2D, so the intermediate
+// tensors are never written out.
+Status FuseConv2DEpilogues(const GraphDef& input_graph_def,
+                           const TransformFuncContext& context,
+                           GraphDef* output_graph_def) {
+  // The fused op only replaces the first output of a FusedBatchNorm.
+  std::set<string> nodes_with_used_side_outputs;
+  for (const NodeDef& node : input_graph_def.node()) {
+    for (const string& input : node.input()) {
+      string prefix;
+      string node_name;
+      string suffix;
+      NodeNamePartsFromInput(input, &prefix, &node_name, &suffix);
+      if (prefix.empty() && !suffix.empty() && suffix != ":0") {
+        nodes_with_used_side_outputs.insert(node_name);
+      }
+    }
+  }
+
+  GraphDef bias_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"BiasAdd",
+        {
+          {"Conv2D"},
+          {"*"},
+        }
+      },  // clang-format on
+      [](const NodeMatch& match, const std::set<string>& input_nodes,
+         const std::set<string>& output_nodes,
+         std::vector<NodeDef>* new_nodes) {
+        const NodeDef& bias_add_node = match.node;
+        const NodeDef& conv_node = match.inputs[0].node;
+        const NodeDef& bias_node = match.inputs[1].node;
+        if (!IsNHWC(bias_add_node) || !IsFusableConv2D(conv_node)) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        FuseIntoConv2D(conv_node, bias_add_node, {bias_node}, new_nodes);
+        return Status::OK();
+      },
+      {}, &bias_graph_def));
+
+  GraphDef batch_norm_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      bias_graph_def,  // clang-format off
+      {"FusedBatchNorm",
+        {
+          {"Conv2D|_FusedConv2D"},
+          {"*"},
+          {"*"},
+          {"*"},
+          {"*"},
+        }
+      },  // clang-format on
+      [&nodes_with_used_side_outputs](const NodeMatch& match,
+                                      const std::set<string>& input_nodes,
+                                      const std::set<string>& output_nodes,
+                                      std::vector<NodeDef>* new_nodes) {
+        const NodeDef& batch_norm_node = match.node;
+        const NodeDef& conv_node = match.inputs[0].node;
+        const std::vector<string> fused_ops = FusedOps(conv_node);
+        const bool is_training =
+            !batch_norm_node.attr().count("is_training") ||
+            batch_norm_node.attr().at("is_training").b();
+        if (is_training || !IsNHWC(batch_norm_node) ||
+            !IsFusableConv2D(conv_node) ||
+            nodes_with_used_side_outputs.count(batch_norm_node.name()) ||
+            !(fused_ops.empty() ||
+              fused_ops == std::vector<string>({"BiasAdd"}))) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        std::vector<NodeDef> stats_nodes;
+        for (int i = 1; i < 5; ++i) {
+          stats_nodes.push_back(match.inputs[i].node);
+        }
+        FuseIntoConv2D(conv_node, batch_norm_node, stats_nodes, new_nodes);
+        return Status::OK();
+      },
+      {}, &batch_norm_graph_def));
+
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      batch_norm_graph_def,  // clang-format off
+      {"Relu|Relu6|Tanh|Elu",
+        {
+          {"_FusedConv2D"},
+        }
+      },  // clang-format on
+      [](const NodeMatch& match, const std::set<string>& input_nodes,
+         const std::set<string>& output_nodes,
+         std::vector<NodeDef>* new_nodes) {
+        const NodeDef& activation_node = match.node;
+        const NodeDef& conv_node = match.inputs[0].node;
+        const std::vector<string> fused_ops = FusedOps(conv_node);
+        const string& last_op = fused_ops.back();
+        if (last_op != "BiasAdd" && last_op != "FusedBatchNorm") {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        FuseIntoConv2D(conv_node, activation_node, {}, new_nodes);
+        return Status::OK();
+      },
+      {}, output_graph_def));
+
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("fuse_conv2d_epilogues", FuseConv2DEpilogues);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
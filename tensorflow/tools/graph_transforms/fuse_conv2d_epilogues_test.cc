@@ -0,0 +1,178 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status FuseConv2DEpilogues(const GraphDef& input_graph_def,
+                           const TransformFuncContext& context,
+                           GraphDef* output_graph_def);
+
+class FuseConv2DEpiloguesTest : public ::testing::Test {
+ protected:
+  void TestFuseConv2DBiasAddBatchNormRelu() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({1, 1, 6, 2}));
+    test::FillValues<float>(
+        &input_data, {1.0f, 4.0f, 2.0f, 5.0f, 3.0f, 6.0f, -1.0f, -4.0f, -2.0f,
+                      -5.0f, -3.0f, -6.0f});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    Tensor weights_data(DT_FLOAT, TensorShape({1, 2, 2, 2}));
+    test::FillValues<float>(&weights_data,
+                            {1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f});
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output conv_op = Conv2D(root.WithOpName("conv_op"), input_op, weights_op,
+                            {1, 1, 1, 1}, "VALID");
+
+    Tensor bias_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&bias_data, {-5.0f, 1.5f});
+    Output bias_op =
+        Const(root.WithOpName("bias_op"), Input::Initializer(bias_data));
+    Output bias_add_op =
+        BiasAdd(root.WithOpName("bias_add_op"), conv_op, bias_op);
+
+    Tensor scale_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&scale_data, {0.5f, 2.0f});
+    Output scale_op =
+        Const(root.WithOpName("scale_op"), Input::Initializer(scale_data));
+    Tensor offset_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&offset_data, {1.0f, -2.0f});
+    Output offset_op =
+        Const(root.WithOpName("offset_op"), Input::Initializer(offset_data));
+    Tensor mean_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&mean_data, {3.0f, -1.0f});
+    Output mean_op =
+        Const(root.WithOpName("mean_op"), Input::Initializer(mean_data));
+    Tensor variance_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&variance_data, {0.25f, 4.0f});
+    Output variance_op = Const(root.WithOpName("variance_op"),
+                               Input::Initializer(variance_data));
+    FusedBatchNorm batch_norm_op(
+        root.WithOpName("batch_norm_op"), bias_add_op, scale_op, offset_op,
+        mean_op, variance_op, FusedBatchNorm::IsTraining(false));
+
+    Output relu_op = Relu(root.WithOpName("output"), batch_norm_op.y);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(FuseConv2DEpilogues(original_graph_def, {{}, {"output"}},
+                                     &fused_graph_def));
+
+    std::unique_ptr<Session> fused_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(fused_session->Create(fused_graph_def));
+    std::vector<Tensor> fused_outputs;
+    TF_ASSERT_OK(fused_session->Run({}, {"output"}, {}, &fused_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], fused_outputs[0], 1e-5);
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(fused_graph_def, &node_lookup);
+    ASSERT_EQ(1, node_lookup.count("output"));
+    const NodeDef* fused_node = node_lookup.at("output");
+    EXPECT_EQ("_FusedConv2D", fused_node->op());
+    EXPECT_EQ(7, fused_node->input_size());
+    for (const NodeDef& node : fused_graph_def.node()) {
+      EXPECT_NE("Conv2D", node.op());
+      EXPECT_NE("BiasAdd", node.op());
+      EXPECT_NE("FusedBatchNorm", node.op());
+      EXPECT_NE("Relu", node.op());
+    }
+  }
+
+  void TestNoFusionOfTrainingBatchNorm() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({1, 1, 6, 2}));
+    test::FillValues<float>(
+        &input_data, {1.0f, 4.0f, 2.0f, 5.0f, 3.0f, 6.0f, -1.0f, -4.0f, -2.0f,
+                      -5.0f, -3.0f, -6.0f});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    Tensor weights_data(DT_FLOAT, TensorShape({1, 2, 2, 2}));
+    test::FillValues<float>(&weights_data,
+                            {1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f});
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output conv_op = Conv2D(root.WithOpName("conv_op"), input_op, weights_op,
+                            {1, 1, 1, 1}, "VALID");
+
+    Tensor stats_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&stats_data, {1.0f, 2.0f});
+    Output scale_op =
+        Const(root.WithOpName("scale_op"), Input::Initializer(stats_data));
+    Output offset_op =
+        Const(root.WithOpName("offset_op"), Input::Initializer(stats_data));
+    Tensor empty_data(DT_FLOAT, TensorShape({0}));
+    Output mean_op =
+        Const(root.WithOpName("mean_op"), Input::Initializer(empty_data));
+    Output variance_op =
+        Const(root.WithOpName("variance_op"), Input::Initializer(empty_data));
+    FusedBatchNorm batch_norm_op(root.WithOpName("output"), conv_op, scale_op,
+                                 offset_op, mean_op, variance_op,
+                                 FusedBatchNorm::IsTraining(true));
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(FuseConv2DEpilogues(original_graph_def, {{}, {"output"}},
+                                     &fused_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(fused_graph_def, &node_lookup);
+    ASSERT_EQ(1, node_lookup.count("conv_op"));
+    EXPECT_EQ("Conv2D", node_lookup.at("conv_op")->op());
+    ASSERT_EQ(1, node_lookup.count("output"));
+    EXPECT_EQ("FusedBatchNorm", node_lookup.at("output")->op());
+  }
+};
+
+TEST_F(FuseConv2DEpiloguesTest, TestFuseConv2DBiasAddBatchNormRelu) {
+  TestFuseConv2DBiasAddBatchNormRelu();
+}
+
+TEST_F(FuseConv2DEpiloguesTest, TestNoFusionOfTrainingBatchNorm) {
+  TestNoFusionOfTrainingBatchNorm();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,243 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string.h>
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/bit_serial_gemm.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Reads the attrs of a FakeQuantWithMinMaxVars node, with their defaults.
+void GetFakeQuantAttrs(const NodeDef& node, int* num_bits,
+                       bool* narrow_range) {
+  *num_bits = node.attr().count("num_bits") ? node.attr().at("num_bits").i()
+                                            : 8;
+  *narrow_range = node.attr().count("narrow_range") &&
+                  node.attr().at("narrow_range").b();
+}
+
+bool IsFloatScalarConst(const NodeDef& node) {
+  const Tensor value = GetNodeTensorAttr(node, "value");
+  return value.dtype() == DT_FLOAT && value.NumElements() == 1;
+}
+
+// Returns the levels of 'rows' rows of 'depth' values of 'weights', packed
+// into bit-planes as BitSerialMatMul and BitSerialConv2D expect. Row 'i'
+// starts at 'i * row_stride' and its values are 'depth_stride' apart. 'shape'
+// holds the leading dimensions of the result.
+Tensor PackWeights(const float* weights, int64 rows, int64 row_stride,
+                   int64 depth, int64 depth_stride,
+                   const bit_serial::Quantization& q,
+                   const std::vector<int64>& shape) {
+  const int words = bit_serial::PackedWords(depth);
+  const int64 row_words = q.num_bits * words;
+  std::vector<uint64> packed(rows * row_words);
+  std::vector<float> row(depth);
+  for (int64 i = 0; i < rows; ++i) {
+    for (int64 l = 0; l < depth; ++l) {
+      row[l] = weights[i * row_stride + l * depth_stride];
+    }
+    bit_serial::QuantizeAndPack(row.data(), depth, q,
+                                packed.data() + i * row_words);
+  }
+  std::vector<int64> dims = shape;
+  dims.push_back(q.num_bits);
+  dims.push_back(words * sizeof(uint64));
+  Tensor tensor(DT_UINT8, TensorShape(dims));
+  if (!packed.empty()) {
+    memcpy(tensor.flat<uint8>().data(), packed.data(),
+           packed.size() * sizeof(uint64));
+  }
+  return tensor;
+}
+
+}  // namespace
+
+// Replaces MatMul and Conv2D ops whose input and constant weights both come
+// from FakeQuantWithMinMaxVars ops with BitSerialMatMul and BitSerialConv2D,
+// when the weights have at most "max_bits" bits. The weights are quantized and
+// packed into bit-planes here, and the input is quantized by the new op.
+Status QuantizeBitSerial(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def) {
+  int32 max_bits;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter("max_bits", 2, &max_bits));
+  if (max_bits < 1 || max_bits > 8) {
+    return errors::InvalidArgument("max_bits must be between 1 and 8, got ",
+                                   max_bits);
+  }
+
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"MatMul|Conv2D",
+        {
+          {"FakeQuantWithMinMaxVars"},
+          {"FakeQuantWithMinMaxVars",
+            {
+              {"Const"},
+              {"Const"},
+              {"Const"},
+            }
+          },
+        }
+      },  // clang-format on
+      [max_bits](const NodeMatch& match, const std::set<string>& input_nodes,
+                 const std::set<string>& output_nodes,
+                 std::vector<NodeDef>* new_nodes) {
+        const NodeDef& node = match.node;
+        const NodeDef& input_fake_quant = match.inputs[0].node;
+        const NodeDef& weights_fake_quant = match.inputs[1].node;
+        const NodeDef& weights_node = match.inputs[1].inputs[0].node;
+        const NodeDef& min_node = match.inputs[1].inputs[1].node;
+        const NodeDef& max_node = match.inputs[1].inputs[2].node;
+
+        int input_bits;
+        bool input_narrow_range;
+        GetFakeQuantAttrs(input_fake_quant, &input_bits, &input_narrow_range);
+        int weights_bits;
+        bool weights_narrow_range;
+        GetFakeQuantAttrs(weights_fake_quant, &weights_bits,
+                          &weights_narrow_range);
+        const Tensor weights = GetNodeTensorAttr(weights_node, "value");
+        const bool is_matmul = node.op() == "MatMul";
+        bool supported = weights_bits <= max_bits &&
+                         weights.dtype() == DT_FLOAT &&
+                         weights.dims() == (is_matmul ? 2 : 4) &&
+                         IsFloatScalarConst(min_node) &&
+                         IsFloatScalarConst(max_node) &&
+                         (!node.attr().count("T") ||
+                          node.attr().at("T").type() == DT_FLOAT);
+        if (is_matmul) {
+          supported = supported && (!node.attr().count("transpose_a") ||
+                                    !node.attr().at("transpose_a").b());
+        } else {
+          supported =
+              supported && (!node.attr().count("data_format") ||
+                            node.attr().at("data_format").s() == "NHWC");
+        }
+        if (!supported) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        const float min = GetNodeTensorAttr(min_node, "value").flat<float>()(0);
+        const float max = GetNodeTensorAttr(max_node, "value").flat<float>()(0);
+        if (!(min < max)) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        const bit_serial::Quantization q = bit_serial::GetQuantization(
+            min, max, weights_bits, weights_narrow_range);
+
+        // BitSerialMatMul takes the [n, k] transpose of the MatMul weights,
+        // and BitSerialConv2D packs the input depth of each filter tap and
+        // output channel.
+        const float* values = weights.flat<float>().data();
+        Tensor packed;
+        if (is_matmul) {
+          const bool transpose_b = node.attr().count("transpose_b") &&
+                                   node.attr().at("transpose_b").b();
+          const int64 k = weights.dim_size(transpose_b ? 1 : 0);
+          const int64 n = weights.dim_size(transpose_b ? 0 : 1);
+          packed = transpose_b ? PackWeights(values, n, k, k, 1, q, {n})
+                               : PackWeights(values, n, 1, k, n, q, {n});
+        } else {
+          const int64 filter_rows = weights.dim_size(0);
+          const int64 filter_cols = weights.dim_size(1);
+          const int64 in_depth = weights.dim_size(2);
+          const int64 out_depth = weights.dim_size(3);
+          std::vector<float> transposed(weights.NumElements());
+          for (int64 tap = 0; tap < filter_rows * filter_cols; ++tap) {
+            for (int64 d = 0; d < in_depth; ++d) {
+              for (int64 j = 0; j < out_depth; ++j) {
+                transposed[(tap * out_depth + j) * in_depth + d] =
+                    values[(tap * in_depth + d) * out_depth + j];
+              }
+            }
+          }
+          packed = PackWeights(transposed.data(),
+                               filter_rows * filter_cols * out_depth, in_depth,
+                               in_depth, 1, q,
+                               {filter_rows, filter_cols, out_depth});
+        }
+
+        NodeDef packed_node;
+        packed_node.set_op("Const");
+        packed_node.set_name(weights_fake_quant.name() + "_bit_serial");
+        SetNodeAttr("dtype", DT_UINT8, &packed_node);
+        SetNodeTensorAttr<uint8>("value", packed, &packed_node);
+        new_nodes->push_back(packed_node);
+
+        NodeDef bit_serial_node;
+        bit_serial_node.set_op(is_matmul ? "BitSerialMatMul"
+                                         : "BitSerialConv2D");
+        bit_serial_node.set_name(node.name());
+        bit_serial_node.set_device(node.device());
+        AddNodeInput(input_fake_quant.input(0), &bit_serial_node);
+        AddNodeInput(packed_node.name(), &bit_serial_node);
+        AddNodeInput(input_fake_quant.input(1), &bit_serial_node);
+        AddNodeInput(input_fake_quant.input(2), &bit_serial_node);
+        AddNodeInput(min_node.name(), &bit_serial_node);
+        AddNodeInput(max_node.name(), &bit_serial_node);
+        for (const string& input : node.input()) {
+          if (StringPiece(input).starts_with("^")) {
+            AddNodeInput(input, &bit_serial_node);
+          }
+        }
+        if (is_matmul) {
+          SetNodeAttr("num_bits_a", input_bits, &bit_serial_node);
+          SetNodeAttr("narrow_range_a", input_narrow_range, &bit_serial_node);
+          SetNodeAttr("narrow_range_b", weights_narrow_range,
+                      &bit_serial_node);
+        } else {
+          SetNodeAttr("num_bits_input", input_bits, &bit_serial_node);
+          SetNodeAttr("narrow_range_input", input_narrow_range,
+                      &bit_serial_node);
+          SetNodeAttr("narrow_range_filter", weights_narrow_range,
+                      &bit_serial_node);
+          CopyNodeAttr(node, "strides", "strides", &bit_serial_node);
+          CopyNodeAttr(node, "padding", "padding", &bit_serial_node);
+        }
+        new_nodes->push_back(bit_serial_node);
+
+        // The range of the weights is still needed, and the other nodes are
+        // kept only if they are used elsewhere.
+        new_nodes->push_back(min_node);
+        new_nodes->push_back(max_node);
+        for (const NodeDef* other :
+             {&input_fake_quant, &weights_fake_quant, &weights_node}) {
+          if (output_nodes.count(other->name())) {
+            new_nodes->push_back(*other);
+          }
+        }
+        return Status::OK();
+      },
+      {}, output_graph_def));
+
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("quantize_bit_serial", QuantizeBitSerial);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
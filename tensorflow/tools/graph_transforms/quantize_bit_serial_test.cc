@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status QuantizeBitSerial(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def);
+
+class QuantizeBitSerialTest : public ::testing::Test {
+ protected:
+  // Builds an "output" MatMul or Conv2D of fake-quantized 'input_shape' input
+  // and fake-quantized constant 'weights_shape' weights of 'weights_bits'
+  // bits.
+  void BuildGraphDef(bool is_matmul, const TensorShape& input_shape,
+                     const TensorShape& weights_shape, int weights_bits,
+                     GraphDef* graph_def) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, input_shape);
+    auto input_flat = input_data.flat<float>();
+    for (int64 i = 0; i < input_flat.size(); ++i) {
+      input_flat(i) = ((i * 7) % 23) / 11.0f - 0.5f;
+    }
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+    Output input_min = Const(root.WithOpName("input_min"), -0.5f);
+    Output input_max = Const(root.WithOpName("input_max"), 1.5f);
+    Output input_fake_quant = FakeQuantWithMinMaxVars(
+        root.WithOpName("input_fake_quant"), input_op, input_min, input_max,
+        FakeQuantWithMinMaxVars::NumBits(3));
+
+    Tensor weights_data(DT_FLOAT, weights_shape);
+    auto weights_flat = weights_data.flat<float>();
+    for (int64 i = 0; i < weights_flat.size(); ++i) {
+      weights_flat(i) = ((i * 5) % 13) / 6.0f - 1.0f;
+    }
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output weights_min = Const(root.WithOpName("weights_min"), -0.5f);
+    Output weights_max = Const(root.WithOpName("weights_max"), 0.5f);
+    Output weights_fake_quant = FakeQuantWithMinMaxVars(
+        root.WithOpName("weights_fake_quant"), weights_op, weights_min,
+        weights_max, FakeQuantWithMinMaxVars::NumBits(weights_bits)
+                         .NarrowRange(true));
+
+    if (is_matmul) {
+      MatMul(root.WithOpName("output"), input_fake_quant, weights_fake_quant);
+    } else {
+      Conv2D(root.WithOpName("output"), input_fake_quant, weights_fake_quant,
+             {1, 2, 1, 1}, "SAME");
+    }
+    TF_ASSERT_OK(root.ToGraphDef(graph_def));
+  }
+
+  // Checks that both graphs compute the same "output".
+  void ExpectOutputsNear(const GraphDef& original_graph_def,
+                         const GraphDef& quantized_graph_def) {
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    std::unique_ptr<Session> quantized_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(quantized_session->Create(quantized_graph_def));
+    std::vector<Tensor> quantized_outputs;
+    TF_ASSERT_OK(
+        quantized_session->Run({}, {"output"}, {}, &quantized_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], quantized_outputs[0],
+                                  1e-3);
+  }
+
+  void TestQuantize(bool is_matmul, const TensorShape& input_shape,
+                    const TensorShape& weights_shape,
+                    const string& expected_op) {
+    GraphDef original_graph_def;
+    BuildGraphDef(is_matmul, input_shape, weights_shape, 2,
+                  &original_graph_def);
+    GraphDef quantized_graph_def;
+    TF_ASSERT_OK(QuantizeBitSerial(original_graph_def, {{}, {"output"}},
+                                   &quantized_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(quantized_graph_def, &node_lookup);
+    EXPECT_EQ(expected_op, node_lookup.at("output")->op());
+    EXPECT_EQ(0, node_lookup.count("weights_op"));
+    EXPECT_EQ(0, node_lookup.count("weights_fake_quant"));
+    EXPECT_EQ(0, node_lookup.count("input_fake_quant"));
+    const NodeDef* packed = node_lookup.at("weights_fake_quant_bit_serial");
+    EXPECT_EQ(DT_UINT8, packed->attr().at("dtype").type());
+
+    ExpectOutputsNear(original_graph_def, quantized_graph_def);
+  }
+};
+
+TEST_F(QuantizeBitSerialTest, MatMul) {
+  TestQuantize(true, TensorShape({3, 70}), TensorShape({70, 4}),
+               "BitSerialMatMul");
+}
+
+TEST_F(QuantizeBitSerialTest, Conv2D) {
+  TestQuantize(false, TensorShape({1, 5, 4, 6}), TensorShape({3, 3, 6, 2}),
+               "BitSerialConv2D");
+}
+
+TEST_F(QuantizeBitSerialTest, TooManyBits) {
+  GraphDef original_graph_def;
+  BuildGraphDef(true, TensorShape({3, 70}), TensorShape({70, 4}), 8,
+                &original_graph_def);
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(QuantizeBitSerial(original_graph_def, {{}, {"output"}},
+                                 &quantized_graph_def));
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  EXPECT_EQ("MatMul", node_lookup.at("output")->op());
+
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["max_bits"] = {"8"};
+  TF_ASSERT_OK(
+      QuantizeBitSerial(original_graph_def, context, &quantized_graph_def));
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  EXPECT_EQ("BitSerialMatMul", node_lookup.at("output")->op());
+  ExpectOutputsNear(original_graph_def, quantized_graph_def);
+
+  context.params["max_bits"] = {"9"};
+  EXPECT_FALSE(
+      QuantizeBitSerial(original_graph_def, context, &quantized_graph_def)
+          .ok());
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
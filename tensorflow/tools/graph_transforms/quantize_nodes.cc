@@ -15,6 +15,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <cmath>
+
 #include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 #include "tensorflow/core/graph/graph_constructor.h"
@@ -183,6 +186,127 @@ Status ExtractRangeFromParams(const TransformFuncContext& context,
   return Status::OK();
 }
 
+// Adds the nodes that quantize the float input 'input_name' to eight bits,
+// using the range of the values it holds, and returns the name of the
+// QuantizeV2 node.
+string AddInputQuantization(const string& input_name,
+                            const string& unique_input_name,
+                            std::vector<NodeDef>* new_nodes) {
+  // Add some common constants we need for reshaping inputs.
+  NodeDef reshape_dims;
+  reshape_dims.set_op("Const");
+  reshape_dims.set_name(unique_input_name + "/reshape_dims");
+  SetNodeAttr("dtype", DT_INT32, &reshape_dims);
+  Tensor reshape_dims_tensor(DT_INT32, {1});
+  reshape_dims_tensor.flat<int32>()(0) = -1;
+  SetNodeTensorAttr<int32>("value", reshape_dims_tensor, &reshape_dims);
+  new_nodes->push_back(reshape_dims);
+
+  NodeDef reduction_dims;
+  reduction_dims.set_op("Const");
+  reduction_dims.set_name(unique_input_name + "/reduction_dims");
+  SetNodeAttr("dtype", DT_INT32, &reduction_dims);
+  Tensor reduction_dims_tensor(DT_INT32, {1});
+  reduction_dims_tensor.flat<int32>()(0) = 0;
+  SetNodeTensorAttr<int32>("value", reduction_dims_tensor, &reduction_dims);
+  new_nodes->push_back(reduction_dims);
+
+  NodeDef reshape_node;
+  reshape_node.set_op("Reshape");
+  reshape_node.set_name(unique_input_name + "/reshape");
+  SetNodeAttr("T", DT_FLOAT, &reshape_node);
+  AddNodeInput(input_name, &reshape_node);
+  AddNodeInput(reshape_dims.name(), &reshape_node);
+  new_nodes->push_back(reshape_node);
+
+  NodeDef min_node;
+  min_node.set_op("Min");
+  min_node.set_name(unique_input_name + "/min");
+  SetNodeAttr("T", DT_FLOAT, &min_node);
+  SetNodeAttr("keep_dims", false, &min_node);
+  AddNodeInput(reshape_node.name(), &min_node);
+  AddNodeInput(reduction_dims.name(), &min_node);
+  new_nodes->push_back(min_node);
+
+  NodeDef max_node;
+  max_node.set_op("Max");
+  max_node.set_name(unique_input_name + "/max");
+  SetNodeAttr("T", DT_FLOAT, &max_node);
+  SetNodeAttr("keep_dims", false, &max_node);
+  AddNodeInput(reshape_node.name(), &max_node);
+  AddNodeInput(reduction_dims.name(), &max_node);
+  new_nodes->push_back(max_node);
+
+  NodeDef quantize_node;
+  quantize_node.set_op("QuantizeV2");
+  quantize_node.set_name(unique_input_name + "/quantize");
+  SetNodeAttr("T", DT_QUINT8, &quantize_node);
+  SetNodeAttr("mode", "MIN_FIRST", &quantize_node);
+  AddNodeInput(input_name, &quantize_node);
+  AddNodeInput(min_node.name(), &quantize_node);
+  AddNodeInput(max_node.name(), &quantize_node);
+  new_nodes->push_back(quantize_node);
+  return quantize_node.name();
+}
+
+// Adds a float Const node holding 'tensor'.
+void AddFloatConstant(const string& name, const Tensor& tensor,
+                      std::vector<NodeDef>* new_nodes) {
+  NodeDef const_node;
+  const_node.set_op("Const");
+  const_node.set_name(name);
+  SetNodeAttr("dtype", DT_FLOAT, &const_node);
+  SetNodeTensorAttr<float>("value", tensor, &const_node);
+  new_nodes->push_back(const_node);
+}
+
+// Quantizes the float weights of a Conv2D or MatMul to qint8, symmetrically
+// around zero with a separate range for each output channel, so that channels
+// with small weights don't lose their precision to channels with large ones.
+// The result is laid out as [..., output_channels] like Conv2D filters, with
+// MatMul weights transposed if needed.
+void QuantizeWeightsPerChannel(const Tensor& weights, bool transpose,
+                               Tensor* quantized_weights, Tensor* min_values,
+                               Tensor* max_values) {
+  Tensor float_weights = weights;
+  if (transpose) {
+    const int64 rows = weights.dim_size(0);
+    const int64 cols = weights.dim_size(1);
+    float_weights = Tensor(DT_FLOAT, TensorShape({cols, rows}));
+    auto weights_matrix = weights.matrix<float>();
+    auto transposed_matrix = float_weights.matrix<float>();
+    for (int64 row = 0; row < rows; ++row) {
+      for (int64 col = 0; col < cols; ++col) {
+        transposed_matrix(col, row) = weights_matrix(row, col);
+      }
+    }
+  }
+  auto weights_matrix = float_weights.flat_inner_dims<float>();
+  const int64 rows = weights_matrix.dimension(0);
+  const int64 channels = weights_matrix.dimension(1);
+  *quantized_weights = Tensor(DT_QINT8, float_weights.shape());
+  *min_values = Tensor(DT_FLOAT, TensorShape({channels}));
+  *max_values = Tensor(DT_FLOAT, TensorShape({channels}));
+  auto quantized_matrix = quantized_weights->flat_inner_dims<qint8>();
+  for (int64 channel = 0; channel < channels; ++channel) {
+    float max_abs = 0.0f;
+    for (int64 row = 0; row < rows; ++row) {
+      max_abs = std::max(max_abs, std::abs(weights_matrix(row, channel)));
+    }
+    if (max_abs == 0.0f) {
+      max_abs = 1.0f;
+    }
+    const float scale = 127.0f / max_abs;
+    for (int64 row = 0; row < rows; ++row) {
+      const float value = std::round(weights_matrix(row, channel) * scale);
+      quantized_matrix(row, channel) =
+          static_cast<int8>(std::min(std::max(value, -127.0f), 127.0f));
+    }
+    min_values->flat<float>()(channel) = -max_abs;
+    max_values->flat<float>()(channel) = max_abs;
+  }
+}
+
 bool AreAttrsEqual(const NodeDef* current_node, const NodeDef* other_node) {
   if (current_node->attr_size() != other_node->attr_size()) {
     return false;
@@ -600,6 +724,205 @@ Status HoistFakeQuants(const GraphDef& input_graph_def,
   return Status::OK();
 }
 
+// Replaces Conv2D and MatMul ops with constant weights, along with any
+// BiasAdd, Relu or Relu6 ops that follow them, with QuantizedConv2DPerChannel
+// or QuantizedMatMulPerChannel ops that have a quantization range for each
+// output channel and apply the bias and activation before requantizing.
+Status QuantizePerChannel(const GraphDef& input_graph_def,
+                          const TransformFuncContext& context,
+                          GraphDef* output_graph_def) {
+  float fallback_min;
+  float fallback_max;
+  bool has_fallback_range;
+  TF_RETURN_IF_ERROR(ExtractRangeFromParams(
+      context, "fallback_min", "fallback_max", &fallback_min, &fallback_max,
+      &has_fallback_range));
+  if (!has_fallback_range) {
+    // An empty range makes the ops measure the range of their results.
+    fallback_min = 0.0f;
+    fallback_max = 0.0f;
+  }
+
+  const OpTypePattern op_pattern = {"Conv2D|MatMul", {{"*"}, {"Const"}}};
+  const OpTypePattern bias_pattern = {"BiasAdd", {op_pattern, {"Const"}}};
+  // The longest patterns come first, so that as many ops as possible are
+  // fused together.
+  const std::vector<OpTypePattern> patterns = {
+      {"Relu|Relu6", {bias_pattern}},
+      bias_pattern,
+      {"Relu|Relu6", {op_pattern}},
+      op_pattern,
+  };
+  GraphDef current_graph_def = input_graph_def;
+  for (const OpTypePattern& pattern : patterns) {
+    GraphDef replaced_graph_def;
+    TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+        current_graph_def, pattern,
+        [fallback_min, fallback_max](const NodeMatch& match,
+                                     const std::set<string>& input_nodes,
+                                     const std::set<string>& output_nodes,
+                                     std::vector<NodeDef>* new_nodes) {
+          // Unwrap the optional activation and bias from the match.
+          const NodeDef& last_node = match.node;
+          const NodeMatch* current_match = &match;
+          string activation = "NONE";
+          if (current_match->node.op() == "Relu" ||
+              current_match->node.op() == "Relu6") {
+            activation = current_match->node.op() == "Relu" ? "RELU" : "RELU6";
+            current_match = &current_match->inputs[0];
+          }
+          const NodeDef* bias_add_node = nullptr;
+          const NodeDef* bias_node = nullptr;
+          if (current_match->node.op() == "BiasAdd") {
+            bias_add_node = &current_match->node;
+            bias_node = &current_match->inputs[1].node;
+            current_match = &current_match->inputs[0];
+          }
+          const NodeDef& float_node = current_match->node;
+          const NodeDef& input_node = current_match->inputs[0].node;
+          const NodeDef& weights_node = current_match->inputs[1].node;
+          const bool is_conv = float_node.op() == "Conv2D";
+
+          // Only fuse ops with float NHWC data whose intermediate results
+          // aren't needed elsewhere.
+          bool can_fuse = true;
+          for (const NodeDef* node : {&last_node, bias_add_node, &float_node}) {
+            if (node == nullptr) continue;
+            DataType type;
+            if (!GetNodeAttr(*node, "T", &type).ok() || type != DT_FLOAT) {
+              can_fuse = false;
+            }
+            string data_format;
+            if (GetNodeAttr(*node, "data_format", &data_format).ok() &&
+                data_format != "NHWC") {
+              can_fuse = false;
+            }
+            if (node != &last_node && output_nodes.count(node->name())) {
+              can_fuse = false;
+            }
+          }
+          bool transpose_a = false;
+          bool transpose_b = false;
+          if (!is_conv) {
+            TF_RETURN_IF_ERROR(
+                GetNodeAttr(float_node, "transpose_a", &transpose_a));
+            TF_RETURN_IF_ERROR(
+                GetNodeAttr(float_node, "transpose_b", &transpose_b));
+          }
+          const Tensor weights = GetNodeTensorAttr(weights_node, "value");
+          const int weights_dims = is_conv ? 4 : 2;
+          if (transpose_a || weights.dtype() != DT_FLOAT ||
+              weights.dims() != weights_dims) {
+            can_fuse = false;
+          }
+          int64 channels = 0;
+          if (can_fuse) {
+            channels = weights.dim_size(transpose_b ? 0 : weights_dims - 1);
+          }
+          Tensor bias(DT_FLOAT, TensorShape({channels}));
+          if (bias_node != nullptr) {
+            bias = GetNodeTensorAttr(*bias_node, "value");
+            if (bias.dtype() != DT_FLOAT || bias.dims() != 1 ||
+                bias.dim_size(0) != channels) {
+              can_fuse = false;
+            }
+          } else {
+            bias.flat<float>().setZero();
+          }
+          if (!can_fuse) {
+            CopyOriginalMatch(match, new_nodes);
+            return Status::OK();
+          }
+
+          // Keep any constants that are also used by other ops.
+          new_nodes->push_back(input_node);
+          if (output_nodes.count(weights_node.name())) {
+            new_nodes->push_back(weights_node);
+          }
+          if (bias_node != nullptr && output_nodes.count(bias_node->name())) {
+            new_nodes->push_back(*bias_node);
+          }
+
+          const string namespace_prefix = last_node.name() + "_eightbit";
+          const string quantized_input_name = AddInputQuantization(
+              float_node.input(0),
+              namespace_prefix + "/" +
+                  UniqueNodeNameFromInput(float_node.input(0)),
+              new_nodes);
+
+          Tensor quantized_weights;
+          Tensor weights_min;
+          Tensor weights_max;
+          QuantizeWeightsPerChannel(weights, transpose_b, &quantized_weights,
+                                    &weights_min, &weights_max);
+          NodeDef quantized_weights_node;
+          quantized_weights_node.set_op("Const");
+          quantized_weights_node.set_name(namespace_prefix +
+                                          "/weights_quantized");
+          SetNodeAttr("dtype", DT_QINT8, &quantized_weights_node);
+          SetNodeTensorAttr<qint8>("value", quantized_weights,
+                                   &quantized_weights_node);
+          new_nodes->push_back(quantized_weights_node);
+          AddFloatConstant(namespace_prefix + "/weights_min", weights_min,
+                           new_nodes);
+          AddFloatConstant(namespace_prefix + "/weights_max", weights_max,
+                           new_nodes);
+          AddFloatConstant(namespace_prefix + "/bias", bias, new_nodes);
+          Tensor requested_min(DT_FLOAT, {});
+          requested_min.flat<float>()(0) = fallback_min;
+          AddFloatConstant(namespace_prefix + "/requested_output_min",
+                           requested_min, new_nodes);
+          Tensor requested_max(DT_FLOAT, {});
+          requested_max.flat<float>()(0) = fallback_max;
+          AddFloatConstant(namespace_prefix + "/requested_output_max",
+                           requested_max, new_nodes);
+
+          NodeDef quantized_main_node;
+          quantized_main_node.set_op(is_conv ? "QuantizedConv2DPerChannel"
+                                             : "QuantizedMatMulPerChannel");
+          quantized_main_node.set_name(last_node.name() + "/eightbit");
+          if (is_conv) {
+            CopyNodeAttr(float_node, "strides", "strides",
+                         &quantized_main_node);
+            CopyNodeAttr(float_node, "padding", "padding",
+                         &quantized_main_node);
+          }
+          SetNodeAttr("activation", activation, &quantized_main_node);
+          AddNodeInput(quantized_input_name + ":0", &quantized_main_node);
+          AddNodeInput(quantized_weights_node.name(), &quantized_main_node);
+          AddNodeInput(namespace_prefix + "/bias", &quantized_main_node);
+          AddNodeInput(quantized_input_name + ":1", &quantized_main_node);
+          AddNodeInput(quantized_input_name + ":2", &quantized_main_node);
+          AddNodeInput(namespace_prefix + "/weights_min",
+                       &quantized_main_node);
+          AddNodeInput(namespace_prefix + "/weights_max",
+                       &quantized_main_node);
+          AddNodeInput(namespace_prefix + "/requested_output_min",
+                       &quantized_main_node);
+          AddNodeInput(namespace_prefix + "/requested_output_max",
+                       &quantized_main_node);
+          new_nodes->push_back(quantized_main_node);
+
+          // Convert the 8-bit result back into float for the final output.
+          NodeDef dequantize_node;
+          dequantize_node.set_op("Dequantize");
+          dequantize_node.set_name(last_node.name());
+          SetNodeAttr("T", DT_QUINT8, &dequantize_node);
+          SetNodeAttr("mode", "MIN_FIRST", &dequantize_node);
+          AddNodeInput(quantized_main_node.name() + ":0", &dequantize_node);
+          AddNodeInput(quantized_main_node.name() + ":1", &dequantize_node);
+          AddNodeInput(quantized_main_node.name() + ":2", &dequantize_node);
+          new_nodes->push_back(dequantize_node);
+
+          return Status::OK();
+        },
+        {}, &replaced_graph_def));
+    current_graph_def = replaced_graph_def;
+  }
+  *output_graph_def = current_graph_def;
+  return Status::OK();
+}
+
 // Converts any float ops that have eight-bit equivalents into their quantized
 // forms, so that as much calculation as possible is done in the lower-precision
 // format.
@@ -695,6 +1018,20 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
                                                    &converted_graph_def));
   TF_RETURN_IF_ERROR(IsGraphValid(converted_graph_def));
 
+  // With per_channel set, convert Conv2D and MatMul ops with constant weights
+  // into ops with a range for each output channel, before the generic
+  // conversion below.
+  bool per_channel;
+  TF_RETURN_IF_ERROR(
+      context.GetOneBoolParameter("per_channel", false, &per_channel));
+  if (per_channel) {
+    GraphDef per_channel_graph_def;
+    TF_RETURN_IF_ERROR(QuantizePerChannel(converted_graph_def, context,
+                                          &per_channel_graph_def));
+    TF_RETURN_IF_ERROR(IsGraphValid(per_channel_graph_def));
+    converted_graph_def = per_channel_graph_def;
+  }
+
   // If fallback_min and fallback_max are set, then we'll use hardwired ranges
   // for all the 32-bit to 8-bit requantizations.
   float fallback_min;
@@ -755,62 +1092,8 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
           string unique_input_name =
               namespace_prefix + "/" + UniqueNodeNameFromInput(input_name);
 
-          // Add some common constants we need for reshaping inputs.
-          NodeDef reshape_dims;
-          reshape_dims.set_op("Const");
-          reshape_dims.set_name(unique_input_name + "/reshape_dims");
-          SetNodeAttr("dtype", DT_INT32, &reshape_dims);
-          Tensor reshape_dims_tensor(DT_INT32, {1});
-          reshape_dims_tensor.flat<int32>()(0) = -1;
-          SetNodeTensorAttr<int32>("value", reshape_dims_tensor, &reshape_dims);
-          new_nodes->push_back(reshape_dims);
-
-          NodeDef reduction_dims;
-          reduction_dims.set_op("Const");
-          reduction_dims.set_name(unique_input_name + "/reduction_dims");
-          SetNodeAttr("dtype", DT_INT32, &reduction_dims);
-          Tensor reduction_dims_tensor(DT_INT32, {1});
-          reduction_dims_tensor.flat<int32>()(0) = 0;
-          SetNodeTensorAttr<int32>("value", reduction_dims_tensor,
-                                   &reduction_dims);
-          new_nodes->push_back(reduction_dims);
-
-          NodeDef reshape_node;
-          reshape_node.set_op("Reshape");
-          reshape_node.set_name(unique_input_name + "/reshape");
-          SetNodeAttr("T", DT_FLOAT, &reshape_node);
-          AddNodeInput(input_name, &reshape_node);
-          AddNodeInput(reshape_dims.name(), &reshape_node);
-          new_nodes->push_back(reshape_node);
-
-          NodeDef min_node;
-          min_node.set_op("Min");
-          min_node.set_name(unique_input_name + "/min");
-          SetNodeAttr("T", DT_FLOAT, &min_node);
-          SetNodeAttr("keep_dims", false, &min_node);
-          AddNodeInput(reshape_node.name(), &min_node);
-          AddNodeInput(reduction_dims.name(), &min_node);
-          new_nodes->push_back(min_node);
-
-          NodeDef max_node;
-          max_node.set_op("Max");
-          max_node.set_name(unique_input_name + "/max");
-          SetNodeAttr("T", DT_FLOAT, &max_node);
-          SetNodeAttr("keep_dims", false, &max_node);
-          AddNodeInput(reshape_node.name(), &max_node);
-          AddNodeInput(reduction_dims.name(), &max_node);
-          new_nodes->push_back(max_node);
-
-          NodeDef quantize_node;
-          quantize_node.set_op("QuantizeV2");
-          quantize_node.set_name(unique_input_name + "/quantize");
-          SetNodeAttr("T", DT_QUINT8, &quantize_node);
-          SetNodeAttr("mode", "MIN_FIRST", &quantize_node);
-          AddNodeInput(input_name, &quantize_node);
-          AddNodeInput(min_node.name(), &quantize_node);
-          AddNodeInput(max_node.name(), &quantize_node);
-          new_nodes->push_back(quantize_node);
-          quantized_input_names.push_back(quantize_node.name());
+          quantized_input_names.push_back(AddInputQuantization(
+              input_name, unique_input_name, new_nodes));
         }
 
         // Set up the quantized version of the current op.
@@ -1383,6 +1383,74 @@ class QuantizeNodesTest : public ::testing::Test {
     EXPECT_EQ("c_op", node_map["mul_op1"]->input(1));
   }
 
+  void TestQuantizePerChannel() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_tensor(DT_FLOAT, TensorShape({1, 4, 5, 3}));
+    auto input_values = input_tensor.flat<float>();
+    for (int i = 0; i < input_values.size(); ++i) {
+      input_values(i) = i / 10.0f - 2.0f;
+    }
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_tensor));
+
+    // The output channels have very different ranges, which a single range
+    // for the whole filter would represent poorly.
+    Tensor filter_tensor(DT_FLOAT, TensorShape({3, 3, 3, 2}));
+    auto filter_values = filter_tensor.flat<float>();
+    for (int i = 0; i < filter_values.size(); ++i) {
+      filter_values(i) = (i % 2 == 0 ? 0.001f : 0.1f) * ((i * 7) % 11 - 5);
+    }
+    Output filter_op =
+        Const(root.WithOpName("filter_op"), Input::Initializer(filter_tensor));
+    Output conv_op = Conv2D(root.WithOpName("conv_op"), input_op, filter_op,
+                            {1, 1, 1, 1}, "SAME");
+    Tensor conv_bias_tensor(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&conv_bias_tensor, {0.5f, -1.0f});
+    Output conv_bias_op = Const(root.WithOpName("conv_bias_op"),
+                                Input::Initializer(conv_bias_tensor));
+    Output conv_bias_add_op =
+        BiasAdd(root.WithOpName("conv_bias_add_op"), conv_op, conv_bias_op);
+    Output relu_op = Relu(root.WithOpName("relu_op"), conv_bias_add_op);
+
+    Tensor a_tensor(DT_FLOAT, TensorShape({3, 4}));
+    test::FillValues<float>(&a_tensor, {-0.1f, 0.0f, 0.1f, 0.2f, 0.3f, 0.4f,
+                                        0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 1.0f});
+    Output a_op = Const(root.WithOpName("a_op"), Input::Initializer(a_tensor));
+    Tensor b_tensor(DT_FLOAT, TensorShape({5, 4}));
+    auto b_values = b_tensor.flat<float>();
+    for (int i = 0; i < b_values.size(); ++i) {
+      b_values(i) = (i - 3) / 10.0f;
+    }
+    Output b_op = Const(root.WithOpName("b_op"), Input::Initializer(b_tensor));
+    Output mat_mul_op = MatMul(root.WithOpName("mat_mul_op"), a_op, b_op,
+                               MatMul::TransposeB(true));
+
+    GraphDef float_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&float_graph_def));
+
+    TransformFuncContext context;
+    context.params["per_channel"] = {"true"};
+    GraphDef quantized_graph_def;
+    TestTransformedVersusFloatGraph(QuantizeNodes, float_graph_def, {}, {},
+                                    {"relu_op", "mat_mul_op"}, context, 1.0,
+                                    &quantized_graph_def);
+
+    std::map<string, int> op_counts;
+    for (const NodeDef& node : quantized_graph_def.node()) {
+      ++op_counts[node.op()];
+      if (node.op() == "QuantizedConv2DPerChannel") {
+        EXPECT_EQ("RELU", node.attr().at("activation").s());
+      }
+    }
+    EXPECT_EQ(1, op_counts["QuantizedConv2DPerChannel"]);
+    EXPECT_EQ(1, op_counts["QuantizedMatMulPerChannel"]);
+    for (const string& op : {"Conv2D", "MatMul", "BiasAdd", "Relu"}) {
+      EXPECT_EQ(0, op_counts[op]) << op;
+    }
+  }
+
   void TestExcludeNonFloat() {
     auto root = tensorflow::Scope::NewRootScope();
     using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
@@ -1527,6 +1595,8 @@ TEST_F(QuantizeNodesTest, TestMergeDuplicateInOut) {
   TestMergeDuplicatesInOut();
 }
 
+TEST_F(QuantizeNodesTest, TestQuantizePerChannel) { TestQuantizePerChannel(); }
+
 TEST_F(QuantizeNodesTest, TestExcludeNonFloat) { TestExcludeNonFloat(); }
 
 }  // namespace graph_transforms
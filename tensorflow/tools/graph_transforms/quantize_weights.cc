@@ -29,17 +29,198 @@ limitations under the License.
 namespace tensorflow {
 namespace graph_transforms {
 
+namespace {
+
+// Widens the range [min, max] of a set of values so that the quantized ops
+// can represent it.
+void AdjustQuantizationRange(float* min, float* max) {
+  // Make sure the quantization range includes 0.0f. Not all quantized
+  // Ops behave properly if 0.0f is not in the range.
+  *min = std::min(*min, 0.0f);
+  *max = std::max(0.0f, *max);
+  // min_value == max_value is a tricky case. It can occur for general
+  // tensors, and of course for scalars. The quantized ops cannot deal
+  // with this case, so we set max_value to something else.
+  // It's a tricky question what is the numerically best solution to
+  // deal with this degeneracy.
+  // TODO(petewarden): Better use a tolerance than a hard comparison?
+  if (*min == *max) {
+    if (std::abs(*min) < 0.000001f) {
+      *max = *min + 1.0f;
+    } else if (*min > 0) {
+      *max = 2.0f * *min;
+    } else {
+      *max = *min / 2.0f;
+    }
+  }
+}
+
+NodeDef MakeConstNode(const string& name, const Tensor& value) {
+  NodeDef const_node;
+  const_node.set_op("Const");
+  const_node.set_name(name);
+  SetNodeAttr("dtype", value.dtype(), &const_node);
+  SetNodeTensorAttr<float>("value", value, &const_node);
+  return const_node;
+}
+
+// Replaces the weights with eight-bit values and a single range, followed by
+// a Dequantize op.
+void QuantizePerTensor(const NodeDef& old_const_node, const Tensor& old_tensor,
+                       std::vector<NodeDef>* new_nodes) {
+  const int64 num_elements = old_tensor.NumElements();
+  const float* old_values = old_tensor.flat<float>().data();
+  float min = std::numeric_limits<float>::max();
+  float max = std::numeric_limits<float>::min();
+  for (int i = 0; i < num_elements; ++i) {
+    const float value = old_values[i];
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  AdjustQuantizationRange(&min, &max);
+  Tensor quantized_tensor(DT_QUINT8, old_tensor.shape());
+  FloatTensorToQuantizedInPlace<quint8>(old_tensor, min, max,
+                                        &quantized_tensor);
+  new_nodes->push_back(MakeConstNode(old_const_node.name() + "_quantized_const",
+                                     quantized_tensor));
+
+  Tensor min_tensor(DT_FLOAT, {});
+  min_tensor.scalar<float>()() = min;
+  new_nodes->push_back(
+      MakeConstNode(old_const_node.name() + "_quantized_min", min_tensor));
+
+  Tensor max_tensor(DT_FLOAT, {});
+  max_tensor.scalar<float>()() = max;
+  new_nodes->push_back(
+      MakeConstNode(old_const_node.name() + "_quantized_max", max_tensor));
+
+  NodeDef dequantize_node;
+  dequantize_node.set_op("Dequantize");
+  dequantize_node.set_name(old_const_node.name());
+  SetNodeAttr("T", DT_QUINT8, &dequantize_node);
+  SetNodeAttr("mode", "MIN_FIRST", &dequantize_node);
+  AddNodeInput(old_const_node.name() + "_quantized_const", &dequantize_node);
+  AddNodeInput(old_const_node.name() + "_quantized_min", &dequantize_node);
+  AddNodeInput(old_const_node.name() + "_quantized_max", &dequantize_node);
+  new_nodes->push_back(dequantize_node);
+}
+
+// Replaces the weights with eight-bit values and one range per slice along
+// the last dimension, which is the output channel of MatMul and Conv2D
+// weights. The float weights are recovered as value * scale + min, with the
+// per-channel scale and min broadcast along the last dimension, since the
+// Dequantize op only takes a single range.
+void QuantizePerChannel(const NodeDef& old_const_node, const Tensor& old_tensor,
+                        std::vector<NodeDef>* new_nodes) {
+  const int64 num_channels = old_tensor.dim_size(old_tensor.dims() - 1);
+  auto old_values = old_tensor.flat_inner_dims<float>();
+  const int64 num_rows = old_values.dimension(0);
+  std::vector<float> mins(num_channels, std::numeric_limits<float>::max());
+  std::vector<float> maxes(num_channels, std::numeric_limits<float>::lowest());
+  for (int64 row = 0; row < num_rows; ++row) {
+    for (int64 c = 0; c < num_channels; ++c) {
+      mins[c] = std::min(mins[c], old_values(row, c));
+      maxes[c] = std::max(maxes[c], old_values(row, c));
+    }
+  }
+  Tensor scale_tensor(DT_FLOAT, {num_channels});
+  Tensor min_tensor(DT_FLOAT, {num_channels});
+  for (int64 c = 0; c < num_channels; ++c) {
+    AdjustQuantizationRange(&mins[c], &maxes[c]);
+    scale_tensor.flat<float>()(c) = (maxes[c] - mins[c]) / 255.0f;
+    min_tensor.flat<float>()(c) = mins[c];
+  }
+  Tensor quantized_tensor(DT_UINT8, old_tensor.shape());
+  auto quantized_values = quantized_tensor.flat_inner_dims<uint8>();
+  for (int64 row = 0; row < num_rows; ++row) {
+    for (int64 c = 0; c < num_channels; ++c) {
+      const float quantized = std::round(
+          (old_values(row, c) - mins[c]) / scale_tensor.flat<float>()(c));
+      quantized_values(row, c) =
+          static_cast<uint8>(std::min(255.0f, std::max(0.0f, quantized)));
+    }
+  }
+
+  const string& name = old_const_node.name();
+  new_nodes->push_back(
+      MakeConstNode(name + "_quantized_const", quantized_tensor));
+  new_nodes->push_back(MakeConstNode(name + "_quantized_scale", scale_tensor));
+  new_nodes->push_back(MakeConstNode(name + "_quantized_min", min_tensor));
+
+  NodeDef cast_node;
+  cast_node.set_op("Cast");
+  cast_node.set_name(name + "_quantized_cast");
+  SetNodeAttr("SrcT", DT_UINT8, &cast_node);
+  SetNodeAttr("DstT", DT_FLOAT, &cast_node);
+  AddNodeInput(name + "_quantized_const", &cast_node);
+  new_nodes->push_back(cast_node);
+
+  NodeDef mul_node;
+  mul_node.set_op("Mul");
+  mul_node.set_name(name + "_quantized_scaled");
+  SetNodeAttr("T", DT_FLOAT, &mul_node);
+  AddNodeInput(cast_node.name(), &mul_node);
+  AddNodeInput(name + "_quantized_scale", &mul_node);
+  new_nodes->push_back(mul_node);
+
+  NodeDef add_node;
+  add_node.set_op("Add");
+  add_node.set_name(name);
+  SetNodeAttr("T", DT_FLOAT, &add_node);
+  AddNodeInput(mul_node.name(), &add_node);
+  AddNodeInput(name + "_quantized_min", &add_node);
+  new_nodes->push_back(add_node);
+}
+
+// Replaces the weights with float16 values, followed by a Cast back to float.
+void ConvertToHalf(const NodeDef& old_const_node, const Tensor& old_tensor,
+                   std::vector<NodeDef>* new_nodes) {
+  Tensor half_tensor(DT_HALF, old_tensor.shape());
+  half_tensor.flat<Eigen::half>() =
+      old_tensor.flat<float>().cast<Eigen::half>();
+  new_nodes->push_back(
+      MakeConstNode(old_const_node.name() + "_half_const", half_tensor));
+
+  NodeDef cast_node;
+  cast_node.set_op("Cast");
+  cast_node.set_name(old_const_node.name());
+  SetNodeAttr("SrcT", DT_HALF, &cast_node);
+  SetNodeAttr("DstT", DT_FLOAT, &cast_node);
+  AddNodeInput(old_const_node.name() + "_half_const", &cast_node);
+  new_nodes->push_back(cast_node);
+}
+
+}  // namespace
+
 // Converts any large float constants into eight-bit equivalents, with a
 // Dequantize op so that subsequent nodes can still access the results in a
-// float form.
+// float form. With "per_channel", each slice along the last dimension gets its
+// own range, and with "float16" the constants are stored as float16 instead.
+// With "keep_compact", the ops that convert the weights back to float are
+// kept from being constant folded when the graph is loaded, so that the
+// weights stay compact in memory and are expanded on each run instead.
 Status QuantizeWeights(const GraphDef& input_graph_def,
                        const TransformFuncContext& context,
                        GraphDef* output_graph_def) {
+  bool per_channel;
+  TF_RETURN_IF_ERROR(
+      context.GetOneBoolParameter("per_channel", false, &per_channel));
+  bool float16;
+  TF_RETURN_IF_ERROR(context.GetOneBoolParameter("float16", false, &float16));
+  bool keep_compact;
+  TF_RETURN_IF_ERROR(
+      context.GetOneBoolParameter("keep_compact", false, &keep_compact));
+  if (per_channel && float16) {
+    return errors::InvalidArgument(
+        "quantize_weights can't use both per_channel and float16");
+  }
+
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       input_graph_def, {"Const"},
-      [](const NodeMatch& match, const std::set<string>& input_nodes,
-         const std::set<string>& output_nodes,
-         std::vector<NodeDef>* new_nodes) {
+      [per_channel, float16, keep_compact](
+          const NodeMatch& match, const std::set<string>& input_nodes,
+          const std::set<string>& output_nodes,
+          std::vector<NodeDef>* new_nodes) {
         const NodeDef& old_const_node = match.node;
         if (!old_const_node.attr().count("dtype")) {
           return errors::InvalidArgument("No 'dtype' attribute for Const node ",
@@ -62,74 +243,22 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
           new_nodes->push_back(old_const_node);
           return Status::OK();
         }
-        const float* old_values = old_tensor.flat<float>().data();
-        float min = std::numeric_limits<float>::max();
-        float max = std::numeric_limits<float>::min();
-        for (int i = 0; i < num_elements; ++i) {
-          const float value = old_values[i];
-          min = std::min(min, value);
-          max = std::max(max, value);
+        const size_t first_new_node = new_nodes->size();
+        if (float16) {
+          ConvertToHalf(old_const_node, old_tensor, new_nodes);
+        } else if (per_channel && old_tensor.dims() >= 2) {
+          QuantizePerChannel(old_const_node, old_tensor, new_nodes);
+        } else {
+          QuantizePerTensor(old_const_node, old_tensor, new_nodes);
         }
-        // Make sure the quantization range includes 0.0f. Not all quantized
-        // Ops behave properly if 0.0f is not in the range.
-        min = std::min(min, 0.0f);
-        max = std::max(0.0f, max);
-        // min_value == max_value is a tricky case. It can occur for general
-        // tensors, and of course for scalars. The quantized ops cannot deal
-        // with this case, so we set max_value to something else.
-        // It's a tricky question what is the numerically best solution to
-        // deal with this degeneracy.
-        // TODO(petewarden): Better use a tolerance than a hard comparison?
-        if (min == max) {
-          if (std::abs(min) < 0.000001f) {
-            max = min + 1.0f;
-          } else if (min > 0) {
-            max = 2.0f * min;
-          } else {
-            max = min / 2.0f;
+        if (keep_compact) {
+          for (size_t i = first_new_node; i < new_nodes->size(); ++i) {
+            NodeDef* node = &(*new_nodes)[i];
+            if (node->op() != "Const") {
+              SetNodeAttr(kDoNotConstantFoldAttr, true, node);
+            }
           }
         }
-        Tensor quantized_tensor(DT_QUINT8, old_tensor.shape());
-        FloatTensorToQuantizedInPlace<quint8>(old_tensor, min, max,
-                                              &quantized_tensor);
-
-        NodeDef quantized_const_node;
-        quantized_const_node.set_op("Const");
-        quantized_const_node.set_name(old_const_node.name() +
-                                      "_quantized_const");
-        SetNodeAttr("dtype", DT_QUINT8, &quantized_const_node);
-        SetNodeTensorAttr<float>("value", quantized_tensor,
-                                 &quantized_const_node);
-        new_nodes->push_back(quantized_const_node);
-
-        NodeDef min_node;
-        min_node.set_op("Const");
-        min_node.set_name(old_const_node.name() + "_quantized_min");
-        SetNodeAttr("dtype", DT_FLOAT, &min_node);
-        Tensor min_tensor(DT_FLOAT, {});
-        min_tensor.scalar<float>()() = min;
-        SetNodeTensorAttr<float>("value", min_tensor, &min_node);
-        new_nodes->push_back(min_node);
-
-        NodeDef max_node;
-        max_node.set_op("Const");
-        max_node.set_name(old_const_node.name() + "_quantized_max");
-        SetNodeAttr("dtype", DT_FLOAT, &max_node);
-        Tensor max_tensor(DT_FLOAT, {});
-        max_tensor.scalar<float>()() = max;
-        SetNodeTensorAttr<float>("value", max_tensor, &max_node);
-        new_nodes->push_back(max_node);
-
-        NodeDef dequantize_node;
-        dequantize_node.set_op("Dequantize");
-        dequantize_node.set_name(old_const_node.name());
-        SetNodeAttr("T", DT_QUINT8, &dequantize_node);
-        SetNodeAttr("mode", "MIN_FIRST", &dequantize_node);
-        AddNodeInput(quantized_const_node.name(), &dequantize_node);
-        AddNodeInput(min_node.name(), &dequantize_node);
-        AddNodeInput(max_node.name(), &dequantize_node);
-        new_nodes->push_back(dequantize_node);
-
         return Status::OK();
       },
       {}, output_graph_def));
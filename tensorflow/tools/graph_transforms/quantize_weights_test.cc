@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/nn_ops.h"
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -58,6 +59,37 @@ class QuantizeWeightsTest : public ::testing::Test {
     TF_ASSERT_OK(root.ToGraphDef(original_graph_def));
   }
 
+  void BuildDefaultGraphDef(GraphDef* original_graph_def) {
+    BuildGraphDef({1, 1, 6, 2},
+                  {1.0f, 4.0f, 2.0f, 5.0f, 3.0f, 6.0f, -1.0f, -4.0f, -2.0f,
+                   -5.0f, -3.0f, -6.0f},
+                  {1, 2, 2, 10},
+                  {1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f,
+                   3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f,
+                   0.1f, 0.2f, 0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f,
+                   0.3f, 0.4f, 1.0f, 2.0f, 3.0f, 4.0f, 0.1f, 0.2f, 0.3f, 0.4f},
+                  original_graph_def);
+  }
+
+  // Checks that both graphs compute the same "output" within "tolerance".
+  void ExpectOutputsNear(const GraphDef& original_graph_def,
+                         const GraphDef& quantized_graph_def,
+                         double tolerance) {
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    std::unique_ptr<Session> quantized_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(quantized_session->Create(quantized_graph_def));
+    std::vector<Tensor> quantized_outputs;
+    TF_ASSERT_OK(
+        quantized_session->Run({}, {"output"}, {}, &quantized_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], quantized_outputs[0],
+                                  tolerance);
+  }
+
   void TestQuantizeWeights() {
     GraphDef original_graph_def;
     BuildGraphDef({1, 1, 6, 2},
@@ -111,6 +143,84 @@ class QuantizeWeightsTest : public ::testing::Test {
 
 TEST_F(QuantizeWeightsTest, TestQuantizeWeights) { TestQuantizeWeights(); }
 
+TEST_F(QuantizeWeightsTest, PerChannel) {
+  GraphDef original_graph_def;
+  BuildDefaultGraphDef(&original_graph_def);
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["per_channel"] = {"true"};
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def));
+
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  EXPECT_EQ("Add", node_lookup.at("weights_op")->op());
+  EXPECT_EQ(DT_UINT8, node_lookup.at("weights_op_quantized_const")
+                          ->attr()
+                          .at("dtype")
+                          .type());
+  // One range for each of the 10 output channels.
+  const Tensor scale =
+      GetNodeTensorAttr(*node_lookup.at("weights_op_quantized_scale"), "value");
+  EXPECT_EQ(TensorShape({10}), scale.shape());
+  const Tensor min =
+      GetNodeTensorAttr(*node_lookup.at("weights_op_quantized_min"), "value");
+  EXPECT_EQ(TensorShape({10}), min.shape());
+  // Channel 0 holds 1.0, 3.0, 0.1 and 0.3, so its range is [0.0, 3.0].
+  EXPECT_NEAR(0.0f, min.flat<float>()(0), 1e-5);
+  EXPECT_NEAR(3.0f / 255.0f, scale.flat<float>()(0), 1e-5);
+
+  ExpectOutputsNear(original_graph_def, quantized_graph_def, 0.25);
+}
+
+TEST_F(QuantizeWeightsTest, Float16) {
+  GraphDef original_graph_def;
+  BuildDefaultGraphDef(&original_graph_def);
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["float16"] = {"true"};
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def));
+
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  const NodeDef* weights_op = node_lookup.at("weights_op");
+  EXPECT_EQ("Cast", weights_op->op());
+  EXPECT_EQ(DT_HALF, weights_op->attr().at("SrcT").type());
+  EXPECT_EQ(DT_HALF,
+            node_lookup.at("weights_op_half_const")->attr().at("dtype").type());
+
+  ExpectOutputsNear(original_graph_def, quantized_graph_def, 0.01);
+
+  context.params["per_channel"] = {"true"};
+  EXPECT_FALSE(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def).ok());
+}
+
+TEST_F(QuantizeWeightsTest, KeepCompact) {
+  GraphDef original_graph_def;
+  BuildDefaultGraphDef(&original_graph_def);
+  TransformFuncContext context;
+  context.output_names = {"output"};
+  context.params["keep_compact"] = {"true"};
+  GraphDef quantized_graph_def;
+  TF_ASSERT_OK(
+      QuantizeWeights(original_graph_def, context, &quantized_graph_def));
+
+  std::map<string, const NodeDef*> node_lookup;
+  MapNamesToNodes(quantized_graph_def, &node_lookup);
+  const NodeDef* weights_op = node_lookup.at("weights_op");
+  EXPECT_EQ("Dequantize", weights_op->op());
+  EXPECT_TRUE(weights_op->attr().at(kDoNotConstantFoldAttr).b());
+  EXPECT_EQ(0, node_lookup.at("weights_op_quantized_const")
+                   ->attr()
+                   .count(kDoNotConstantFoldAttr));
+
+  ExpectOutputsNear(original_graph_def, quantized_graph_def, 0.5);
+}
+
 TEST_F(QuantizeWeightsTest, RangesAlwaysIncludeZero) {
   GraphDef original_graph_def;
   BuildGraphDef({1, 1, 4, 4},
@@ -28,6 +28,7 @@ static const char* const kCheckers[] = {
     "AcceleratorUtilizationChecker", "OperationChecker",
     "ExpensiveOperationChecker",
     "JobChecker",  // Internal checker.
+    "MemoryChecker",
 };
 
 class Checker {
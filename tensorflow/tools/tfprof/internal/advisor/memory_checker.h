@@ -0,0 +1,138 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This checker checks the memory peak of each device, the fragmentation of
+// its allocator, and the tensors that could be recomputed or swapped out to
+// lower the peak.
+#ifndef THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_MEMORY_CHECKER_H_
+#define THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_MEMORY_CHECKER_H_
+
+#include "tensorflow/tools/tfprof/internal/advisor/checker.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_timeline.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+class MemoryChecker : public Checker {
+ public:
+  string name() const override { return kCheckers[4]; }
+
+ private:
+  // Rough bandwidth of swapping tensors between host and accelerator.
+  static constexpr double kSwapBytesPerMicro = 1e4;
+  // The most recompute or swap candidates reported per device.
+  static const int kMaxCandidates = 3;
+
+  AdviceProto::Checker Check(const AdvisorOptionsProto::CheckerOption& options,
+                             const TFStats* stats) override {
+    if (!stats) {
+      fprintf(stderr, "Missing profiles (e.g. graph, run_meta). Skip %s\n",
+              name().c_str());
+      return reports_;
+    }
+    if (stats->steps().empty()) {
+      fprintf(stderr, "Missing RunMetadata info. Skip %s\n", name().c_str());
+      return reports_;
+    }
+    const int64 step = *stats->steps().rbegin();
+
+    std::map<string, std::unique_ptr<GraphNode>> gnodes;
+    for (const auto& node : stats->nodes()) {
+      gnodes[node.first].reset(new GraphNode(node.second.get()));
+    }
+    MemoryTracker mem_tracker;
+    for (const auto& gnode : gnodes) {
+      mem_tracker.TrackNode(step, gnode.second.get());
+      for (const auto& input : gnode.second->node->inputs()) {
+        const auto src = gnodes.find(input.second->name());
+        if (src != gnodes.end()) {
+          mem_tracker.TrackNodeConnection(step, gnode.second.get(),
+                                          src->second.get());
+        }
+      }
+    }
+
+    for (const auto& dev : mem_tracker.devices()) {
+      CheckDevice(stats, step, dev.first, dev.second);
+    }
+    return reports_;
+  }
+
+  void CheckDevice(const TFStats* stats, int64 step, const string& dev_name,
+                   const MemoryTracker::Device& device) {
+    const int64 peak_micros = device.PeakMicros();
+    if (peak_micros < 0) {
+      return;
+    }
+    std::vector<string> outputs;
+    outputs.push_back(strings::Printf(
+        "device: %s peak memory: %s at %s", dev_name.c_str(),
+        FormatMemory(device.allocator_stats.at(peak_micros)).c_str(),
+        FormatTime(peak_micros).c_str()));
+
+    const double fragmentation = device.Fragmentation(peak_micros);
+    if (fragmentation >= 0) {
+      outputs.push_back(strings::Printf(
+          "reserved: %s, largest free block: %s, fragmentation: %.2f",
+          FormatMemory(device.allocator_reserved.at(peak_micros)).c_str(),
+          FormatMemory(device.allocator_largest_free.at(peak_micros)).c_str(),
+          fragmentation));
+      if (fragmentation > 0.5) {
+        outputs.push_back(
+            "High fragmentation: large allocations can fail before the "
+            "reserved memory is used up.");
+      }
+    }
+
+    // Tensors produced before the peak and used after it only take memory
+    // at the peak. The cheap ones to produce can be recomputed, and the
+    // others swapped out to the host.
+    int candidates = 0;
+    for (const auto& tensor : device.LiveTensors(peak_micros)) {
+      if (candidates >= kMaxCandidates) {
+        break;
+      }
+      const auto producer = device.tensor_node.find(tensor.first);
+      const auto latest = device.latest_ref.find(tensor.first);
+      if (producer == device.tensor_node.end() ||
+          latest == device.latest_ref.end() || latest->second <= peak_micros) {
+        continue;
+      }
+      const auto node = stats->nodes().find(producer->second);
+      if (node == stats->nodes().end() || !node->second->trackable(step)) {
+        continue;
+      }
+      const int64 produce_micros = node->second->exec_micros(step);
+      const bool recompute =
+          produce_micros < tensor.second / kSwapBytesPerMicro;
+      outputs.push_back(strings::Printf(
+          "%s candidate: %s output of %s (%s to compute), alive for %s "
+          "across the peak",
+          recompute ? "recompute" : "swap",
+          FormatMemory(tensor.second).c_str(), producer->second.c_str(),
+          FormatTime(produce_micros).c_str(),
+          FormatTime(latest->second - node->second->latest_end_micros(step))
+              .c_str()));
+      ++candidates;
+    }
+    reports_.add_reports(str_util::Join(outputs, "\n"));
+  }
+
+  AdviceProto::Checker reports_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_MEMORY_CHECKER_H_
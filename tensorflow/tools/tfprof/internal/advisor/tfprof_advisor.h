@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/tools/tfprof/internal/advisor/checker.h"
 #include "tensorflow/tools/tfprof/internal/advisor/expensive_operation_checker.h"
 #include "tensorflow/tools/tfprof/internal/advisor/internal_checker_runner.h"
+#include "tensorflow/tools/tfprof/internal/advisor/memory_checker.h"
 #include "tensorflow/tools/tfprof/internal/advisor/operation_checker.h"
 #include "tensorflow/tools/tfprof/tfprof_options.pb.h"
 
@@ -61,6 +62,11 @@ class Advisor {
           expensive_op_checker.Run(options.checkers().at(kCheckers[2]),
                                    stats_));
     }
+    if (options.checkers().find(kCheckers[4]) != options.checkers().end()) {
+      MemoryChecker memory_checker;
+      (*ret.mutable_checkers())[kCheckers[4]].MergeFrom(
+          memory_checker.Run(options.checkers().at(kCheckers[4]), stats_));
+    }
     for (const auto& checker : ret.checkers()) {
       fprintf(stdout, "\n%s:\n", checker.first.c_str());
       for (const string& r : checker.second.reports()) {
@@ -39,7 +39,10 @@ class TFProfAdvisorTest : public ::testing::Test {
                                           const string& type,
                                           std::map<string, string> attrs,
                                           int64 step, int64 start_miros,
-                                          int64 end_rel_micros) {
+                                          int64 end_rel_micros,
+                                          int64 bytes_in_use = 0,
+                                          int64 bytes_reserved = 0,
+                                          int64 largest_free_block = 0) {
     node_defs_.push_back(std::unique_ptr<NodeDef>(new NodeDef()));
     NodeDef* def = node_defs_.back().get();
 
@@ -53,6 +56,13 @@ class TFProfAdvisorTest : public ::testing::Test {
     NodeExecStats node_stat;
     node_stat.set_all_start_micros(start_miros);
     node_stat.set_op_end_rel_micros(end_rel_micros);
+    if (bytes_in_use > 0) {
+      AllocatorMemoryUsed* memory = node_stat.add_memory();
+      memory->set_allocator_name("GPU_0_bfc");
+      memory->set_allocator_bytes_in_use(bytes_in_use);
+      memory->set_allocator_bytes_reserved(bytes_reserved);
+      memory->set_allocator_largest_free_block_bytes(largest_free_block);
+    }
     node->AddStepStat(step, "/job:localhost/replica:0/task:0/gpu:0", node_stat);
     node->AddStepStat(step, "/job:localhost/replica:0/task:0/gpu:0:stream:all",
                       node_stat);
@@ -100,5 +110,24 @@ TEST_F(TFProfAdvisorTest, ExpensiveOperationChecker) {
                   .contains("top 1 operation type: Conv2D"));
 }
 
+TEST_F(TFProfAdvisorTest, MemoryChecker) {
+  stats_.reset(new TFStats(std::unique_ptr<GraphDef>(new GraphDef()), nullptr,
+                           nullptr, nullptr));
+  // 200 bytes are free, in blocks of at most 50 bytes.
+  stats_->AddNodeForTest(
+      0, CreateNode("n1", "MatMul", {}, 0, 10, 2, 800, 1000, 50));
+  stats_->BuildAllViews();
+  advisor_.reset(new Advisor(stats_.get()));
+
+  AdvisorOptionsProto options;
+  (*options.mutable_checkers())[kCheckers[4]];
+  AdviceProto advice = advisor_->Advise(options);
+  EXPECT_EQ(advice.checkers().at(kCheckers[4]).reports_size(), 1);
+  const StringPiece report(advice.checkers().at(kCheckers[4]).reports(0));
+  EXPECT_TRUE(report.contains("peak memory: 800B")) << report;
+  EXPECT_TRUE(report.contains("fragmentation: 0.75")) << report;
+  EXPECT_TRUE(report.contains("High fragmentation")) << report;
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
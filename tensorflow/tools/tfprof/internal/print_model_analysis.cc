@@ -61,7 +61,7 @@ string RunProfile(const string& command, const string& options,
     printf("%s", opts.ToString().c_str());
     printf("\n==================Model Analysis Report======================\n");
     string ret = "";
-    if (command == kCmds[2] || command == kCmds[3]) {
+    if (command == kCmds[2] || command == kCmds[3] || command == kCmds[7]) {
       ret = tf_stats->ShowMultiGraphNode(command, opts).SerializeAsString();
     } else if (command == kCmds[0] || command == kCmds[1]) {
       ret = tf_stats->ShowGraphNode(command, opts).SerializeAsString();
@@ -72,7 +72,7 @@ string RunProfile(const string& command, const string& options,
     fflush(stdout);
     return ret;
   }
-  if (command == kCmds[2] || command == kCmds[3]) {
+  if (command == kCmds[2] || command == kCmds[3] || command == kCmds[7]) {
     return tf_stats->ShowMultiGraphNode(command, opts).SerializeAsString();
   } else if (command == kCmds[0] || command == kCmds[1]) {
     return tf_stats->ShowGraphNode(command, opts).SerializeAsString();
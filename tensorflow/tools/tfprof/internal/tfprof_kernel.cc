@@ -0,0 +1,241 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/tfprof/internal/tfprof_kernel.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <set>
+
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/regexp.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_constants.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_utils.h"
+
+namespace tensorflow {
+namespace tfprof {
+namespace {
+// Number of launching graph nodes listed per kernel in stdout.
+const size_t kMaxShownGraphNodes = 3;
+
+struct Aggregate {
+  TFMultiGraphNodeProto proto;
+  // Sum of the estimated occupancy of the launches.
+  double occupancy = 0.0;
+  std::map<string, TFGraphNodeProto> graph_nodes;
+};
+
+void AddExec(const string& node_name, int64 count, int64 micros, int64 bytes,
+             Aggregate* agg) {
+  TFMultiGraphNodeProto* proto = &agg->proto;
+  proto->set_run_count(proto->run_count() + count);
+  proto->set_accelerator_exec_micros(proto->accelerator_exec_micros() +
+                                     micros);
+  proto->set_memcpy_bytes(proto->memcpy_bytes() + bytes);
+  TFGraphNodeProto* gnode = &agg->graph_nodes[node_name];
+  gnode->set_name(node_name);
+  gnode->set_run_count(gnode->run_count() + count);
+  gnode->set_accelerator_exec_micros(gnode->accelerator_exec_micros() +
+                                     micros);
+}
+
+// Averages 'agg' over 'num_steps' steps and fills in the derived fields.
+TFMultiGraphNodeProto Finalize(const string& name, int64 num_steps,
+                               Aggregate* agg) {
+  TFMultiGraphNodeProto proto = agg->proto;
+  proto.set_name(name);
+  if (proto.run_count() > 0) {
+    proto.set_occupancy(agg->occupancy / proto.run_count());
+  }
+  proto.set_run_count(proto.run_count() / num_steps);
+  proto.set_accelerator_exec_micros(proto.accelerator_exec_micros() /
+                                    num_steps);
+  proto.set_exec_micros(proto.accelerator_exec_micros());
+  proto.set_total_exec_micros(proto.exec_micros());
+  proto.set_total_accelerator_exec_micros(proto.accelerator_exec_micros());
+  proto.set_memcpy_bytes(proto.memcpy_bytes() / num_steps);
+
+  std::vector<TFGraphNodeProto> gnodes;
+  for (auto& gnode : agg->graph_nodes) {
+    TFGraphNodeProto* g = &gnode.second;
+    g->set_run_count(g->run_count() / num_steps);
+    g->set_accelerator_exec_micros(g->accelerator_exec_micros() / num_steps);
+    g->set_exec_micros(g->accelerator_exec_micros());
+    gnodes.push_back(*g);
+  }
+  std::sort(gnodes.begin(), gnodes.end(),
+            [](const TFGraphNodeProto& g1, const TFGraphNodeProto& g2) {
+              return g1.accelerator_exec_micros() >
+                     g2.accelerator_exec_micros();
+            });
+  for (const TFGraphNodeProto& g : gnodes) {
+    *proto.add_graph_nodes() = g;
+  }
+  return proto;
+}
+
+void SortProtos(const Options& opts,
+                std::vector<TFMultiGraphNodeProto>* protos) {
+  std::sort(protos->begin(), protos->end(),
+            [&opts](const TFMultiGraphNodeProto& n1,
+                    const TFMultiGraphNodeProto& n2) {
+              if (opts.order_by == kOrderBy[0]) {
+                return n1.name() < n2.name();
+              } else if (opts.order_by == kOrderBy[1]) {
+                return n1.memcpy_bytes() > n2.memcpy_bytes();
+              } else if (opts.order_by == kOrderBy[7]) {
+                return n1.run_count() > n2.run_count();
+              }
+              return n1.accelerator_exec_micros() >
+                     n2.accelerator_exec_micros();
+            });
+}
+}  // namespace
+
+const TFMultiGraphNodeProto& TFKernel::Show(const Options& opts) {
+  root_.Clear();
+  root_.set_name(kTFProfRoot);
+  if (opts.output_type == kOutput[0]) {
+    fprintf(stderr, "kernel view doesn't support timeline yet. "
+                    "Consider graph/scope/code view.\n");
+    return root_;
+  }
+
+  std::set<int64> steps;
+  std::map<string, Aggregate> kernels;
+  std::map<string, Aggregate> memcpys;
+  for (const TFGraphNode* node : nodes_) {
+    for (const auto& exec : node->all_op_execs()) {
+      if (opts.step >= 0 && exec.first != opts.step) continue;
+      steps.insert(exec.first);
+      for (const auto& kernel : exec.second.kernel_execs()) {
+        Aggregate* agg = &kernels[kernel.first];
+        AddExec(node->name(), kernel.second.count, kernel.second.micros, 0,
+                agg);
+        agg->occupancy += kernel.second.occupancy;
+      }
+      for (const auto& memcpy : exec.second.memcpy_execs()) {
+        AddExec(node->name(), memcpy.second.count, memcpy.second.micros,
+                memcpy.second.bytes, &memcpys[memcpy.first]);
+      }
+    }
+  }
+  const int64 num_steps = std::max<int64>(1, steps.size());
+
+  std::vector<TFMultiGraphNodeProto> kernel_protos;
+  for (auto& kernel : kernels) {
+    kernel_protos.push_back(Finalize(kernel.first, num_steps, &kernel.second));
+    root_.set_total_accelerator_exec_micros(
+        root_.total_accelerator_exec_micros() +
+        kernel_protos.back().accelerator_exec_micros());
+  }
+  std::vector<TFMultiGraphNodeProto> memcpy_protos;
+  for (auto& memcpy : memcpys) {
+    memcpy_protos.push_back(Finalize(memcpy.first, num_steps, &memcpy.second));
+  }
+  SortProtos(opts, &kernel_protos);
+  SortProtos(opts, &memcpy_protos);
+  root_.set_total_exec_micros(root_.total_accelerator_exec_micros());
+
+  string display_str =
+      "kernel name | accelerator execution time | launches | "
+      "estimated occupancy | top graph nodes\n";
+  for (const TFMultiGraphNodeProto& kernel : kernel_protos) {
+    if (!ShouldShow(kernel, opts)) continue;
+    display_str += FormatNode(kernel, false);
+    *root_.add_children() = kernel;
+  }
+  display_str +=
+      "\nmemcpy kind | accelerator execution time | copies | bytes | "
+      "bandwidth | top graph nodes\n";
+  for (const TFMultiGraphNodeProto& memcpy : memcpy_protos) {
+    if (!ShouldShow(memcpy, opts)) continue;
+    display_str += FormatNode(memcpy, true);
+    *root_.add_children() = memcpy;
+  }
+
+  if (opts.output_type == kOutput[1]) {
+    printf("%s", display_str.c_str());
+    fflush(stdout);
+  } else if (opts.output_type == kOutput[2]) {
+    Status s = WriteStringToFile(
+        Env::Default(), opts.output_options.at(kFileOpts[0]), display_str);
+    if (!s.ok()) {
+      fprintf(stderr, "%s\n", s.ToString().c_str());
+    }
+  }
+  return root_;
+}
+
+bool TFKernel::ShouldShow(const TFMultiGraphNodeProto& node,
+                          const Options& opts) const {
+  if (node.accelerator_exec_micros() < opts.min_micros) return false;
+  bool show = false;
+  for (const string& regex : opts.show_name_regexes) {
+    if (regex == ".*" || RE2::FullMatch(node.name(), regex)) {
+      show = true;
+      break;
+    }
+  }
+  if (!show) return false;
+  for (const string& regex : opts.hide_name_regexes) {
+    if (RE2::FullMatch(node.name(), regex)) return false;
+  }
+  return true;
+}
+
+string TFKernel::FormatNode(const TFMultiGraphNodeProto& node,
+                            bool is_memcpy) const {
+  std::vector<string> attrs;
+  if (is_memcpy) {
+    attrs.push_back(strings::Printf(
+        "%10s", FormatTime(node.accelerator_exec_micros()).c_str()));
+    attrs.push_back(strings::Printf("%lld copies", node.run_count()));
+    attrs.push_back(FormatMemory(node.memcpy_bytes()));
+    const int64 micros = std::max<int64>(1, node.accelerator_exec_micros());
+    attrs.push_back(strings::Printf(
+        "%s/s", FormatMemory(node.memcpy_bytes() * 1000000 / micros).c_str()));
+  } else {
+    double pct = 0.0;
+    if (root_.total_accelerator_exec_micros() > 0) {
+      pct = 100.0 * node.accelerator_exec_micros() /
+            root_.total_accelerator_exec_micros();
+    }
+    attrs.push_back(strings::Printf(
+        "%20s", strings::Printf("%s (%.2f%%)",
+                                FormatTime(node.accelerator_exec_micros())
+                                    .c_str(),
+                                pct)
+                    .c_str()));
+    attrs.push_back(strings::Printf("%lld launches", node.run_count()));
+    attrs.push_back(strings::Printf("%.2f occupancy", node.occupancy()));
+  }
+
+  std::vector<string> gnodes;
+  for (const TFGraphNodeProto& gnode : node.graph_nodes()) {
+    if (gnodes.size() == kMaxShownGraphNodes) {
+      gnodes.push_back("...");
+      break;
+    }
+    gnodes.push_back(gnode.name());
+  }
+  attrs.push_back(str_util::Join(gnodes, "|"));
+  return strings::Printf("%-25s%s\n", node.name().c_str(),
+                         str_util::Join(attrs, ", ").c_str());
+}
+}  // namespace tfprof
+}  // namespace tensorflow
@@ -0,0 +1,59 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Build a flat structure of the device kernels and memory copies recorded by
+// the GPU tracer.
+
+#ifndef THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_KERNEL_H_
+#define THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_KERNEL_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/tools/tfprof/internal/tfprof_node.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_options.h"
+#include "tensorflow/tools/tfprof/tfprof_output.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+// Aggregates the kernel launches and memory copies of all graph nodes by
+// kernel name and memcpy kind, so that the most expensive kernels show up
+// regardless of the ops that launched them. The results are children of the
+// returned root, ordered by -order_by (accelerator time by default) and
+// filtered by -min_micros and -show/hide_name_regexes. Each child lists the
+// graph nodes that launched the kernel in graph_nodes.
+class TFKernel {
+ public:
+  TFKernel() {}
+
+  void AddNode(const TFGraphNode* node) { nodes_.push_back(node); }
+
+  const TFMultiGraphNodeProto& Show(const Options& opts);
+
+ private:
+  bool ShouldShow(const TFMultiGraphNodeProto& node, const Options& opts) const;
+
+  string FormatNode(const TFMultiGraphNodeProto& node, bool is_memcpy) const;
+
+  std::vector<const TFGraphNode*> nodes_;
+  TFMultiGraphNodeProto root_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_KERNEL_H_
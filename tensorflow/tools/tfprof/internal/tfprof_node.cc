@@ -30,6 +30,10 @@ bool CountAsCPUTime(const string& device) {
 
 bool IsCanonicalDevice(const string& device) { return CountAsCPUTime(device); }
 
+bool IsMemcpyDevice(const string& device) {
+  return RE2::FullMatch(device, ".*/memcpy");
+}
+
 }  // namespace
 // Notes about start and end time from the NodeExecStats proto:
 // For GPU, there is no difference between op_end_rel_micros and
@@ -69,6 +73,31 @@ void ExecStep::AddTimeStats(const string& dev, const NodeExecStats& step_stat) {
     if (CountAsAcceleratorTime(dev)) {
       accelerator_execs_[dev].push_back(pair);
       op_execs_[dev].push_back(pair);
+
+      // The GPU tracer labels kernels with
+      // "<kernel name> ... occupancy:<fraction>".
+      string kernel = "unknown";
+      double occupancy = 0.0;
+      const string& label = step_stat.timeline_label();
+      if (!RE2::PartialMatch(label, "^(\\S+) .*occupancy:([0-9.]+)", &kernel,
+                             &occupancy)) {
+        RE2::PartialMatch(label, "^(\\S+)", &kernel);
+      }
+      KernelExec& kernel_exec = kernel_execs_[kernel];
+      kernel_exec.count += 1;
+      kernel_exec.micros += op_end_rel_micros;
+      kernel_exec.occupancy += occupancy;
+    } else if (IsMemcpyDevice(dev)) {
+      // The GPU tracer labels copies with "MEMCPY<kind> <bytes> bytes ...".
+      string kind;
+      int64 bytes = 0;
+      if (RE2::PartialMatch(step_stat.timeline_label(),
+                            "^(MEMCPY\\w+) (\\d+) bytes", &kind, &bytes)) {
+        MemcpyExec& memcpy_exec = memcpy_execs_[kind];
+        memcpy_exec.count += 1;
+        memcpy_exec.micros += op_end_rel_micros;
+        memcpy_exec.bytes += bytes;
+      }
     } else if (CountAsCPUTime(dev)) {
       cpu_execs_[dev].push_back(pair);
       op_execs_[dev].push_back(pair);
@@ -92,9 +121,12 @@ void ExecStep::AddMemoryStats(const string& dev,
     if (mem.allocator_name().find("GPU") == mem.allocator_name().npos) {
       continue;
     }
-    allocator_bytes_in_use_ =
-        std::max(allocator_bytes_in_use_,
-                 static_cast<int64>(mem.allocator_bytes_in_use()));
+    if (mem.allocator_bytes_in_use() > allocator_bytes_in_use_) {
+      allocator_bytes_in_use_ = mem.allocator_bytes_in_use();
+      allocator_bytes_reserved_ = mem.allocator_bytes_reserved();
+      allocator_largest_free_block_bytes_ =
+          mem.allocator_largest_free_block_bytes();
+    }
   }
   int64 total_output_bytes = 0;
   for (const auto& output : step_stat.output()) {
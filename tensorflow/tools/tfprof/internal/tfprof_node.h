@@ -42,6 +42,21 @@ TensorShapeProto VecToShapeProto(const std::vector<int64> shape_vec);
 
 class TFGraphNode;
 
+// The launches of a device kernel by an op in a step.
+struct KernelExec {
+  int64 count = 0;
+  int64 micros = 0;
+  // Sum of the estimated occupancy of the launches.
+  double occupancy = 0.0;
+};
+
+// The memory copies of one kind (e.g. MEMCPYHtoD) by an op in a step.
+struct MemcpyExec {
+  int64 count = 0;
+  int64 micros = 0;
+  int64 bytes = 0;
+};
+
 class ExecStep {
  public:
   ExecStep(TFGraphNode* node)
@@ -55,7 +70,9 @@ class ExecStep {
         host_persistent_bytes_(0),
         accelerator_temp_bytes_(0),
         accelerator_persistent_bytes_(0),
-        allocator_bytes_in_use_(0) {}
+        allocator_bytes_in_use_(0),
+        allocator_bytes_reserved_(0),
+        allocator_largest_free_block_bytes_(0) {}
 
   void AddTimeStats(const string& dev, const NodeExecStats& step_stat);
 
@@ -77,6 +94,15 @@ class ExecStep {
   int64 all_start_micros() const { return all_start_micros_; }
   int64 latest_end_micros() const { return latest_end_micros_; }
 
+  // Kernels and memory copies recorded by the GPU tracer, by kernel name and
+  // memcpy kind.
+  const std::map<string, KernelExec>& kernel_execs() const {
+    return kernel_execs_;
+  }
+  const std::map<string, MemcpyExec>& memcpy_execs() const {
+    return memcpy_execs_;
+  }
+
   int64 requested_bytes() const { return requested_bytes_; }
   int64 accelerator_temp_bytes() const { return accelerator_temp_bytes_; }
   int64 host_temp_bytes() const { return host_temp_bytes_; }
@@ -88,6 +114,10 @@ class ExecStep {
     return output_bytes_;
   }
   int64 allocator_bytes_in_use() const { return allocator_bytes_in_use_; }
+  int64 allocator_bytes_reserved() const { return allocator_bytes_reserved_; }
+  int64 allocator_largest_free_block_bytes() const {
+    return allocator_largest_free_block_bytes_;
+  }
 
  private:
   TFGraphNode* node;
@@ -106,6 +136,8 @@ class ExecStep {
   std::map<string, std::vector<std::pair<int64, int64>>> cpu_execs_;
   // combines accelerator_execs_ and cpu_execs_.
   std::map<string, std::vector<std::pair<int64, int64>>> op_execs_;
+  std::map<string, KernelExec> kernel_execs_;
+  std::map<string, MemcpyExec> memcpy_execs_;
   // All devices the op is associated with (e.g. gpu:0 (scheduling),
   // gpu:0:stream:xx (kernel exec), cpu:0 host)
   std::set<string> devices_;
@@ -121,6 +153,10 @@ class ExecStep {
   int64 accelerator_persistent_bytes_;
   // The total number of bytes currently allocated by the allocator if >0.
   int64 allocator_bytes_in_use_;
+  // The bytes reserved by the same allocator, and the largest free block
+  // among them, if >0.
+  int64 allocator_bytes_reserved_;
+  int64 allocator_largest_free_block_bytes_;
   // output_idx -> {output_bytes, memory_ptr}
   std::map<int64, std::pair<int64, uint64>> output_bytes_;
 };
@@ -339,6 +375,16 @@ class TFGraphNode {
     CHECK(exec != execs_.end()) << "unknown step " << step;
     return exec->second.allocator_bytes_in_use();
   }
+  int64 allocator_bytes_reserved(int64 step) const {
+    auto exec = execs_.find(step);
+    CHECK(exec != execs_.end()) << "unknown step " << step;
+    return exec->second.allocator_bytes_reserved();
+  }
+  int64 allocator_largest_free_block_bytes(int64 step) const {
+    auto exec = execs_.find(step);
+    CHECK(exec != execs_.end()) << "unknown step " << step;
+    return exec->second.allocator_largest_free_block_bytes();
+  }
 
   int64 float_ops(int64 step) const {
     // If not run, return static analysis.
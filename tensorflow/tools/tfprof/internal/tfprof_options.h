@@ -59,7 +59,7 @@ static const char* const kShown[] = {
     "cpu_micros"};
 
 static const char* const kCmds[] = {
-    "scope", "graph", "code", "op", "advise", "set", "help",
+    "scope", "graph", "code", "op", "advise", "set", "help", "kernel",
 };
 
 static const char* const kOutput[] = {"timeline", "stdout", "file", "none"};
@@ -80,6 +80,12 @@ void TFStats::BuildView(const string& cmd) {
     }
     op_view_->Build();
   }
+  if (cmd == kCmds[7] && !kernel_view_) {
+    kernel_view_.reset(new TFKernel());
+    for (auto it = nodes_map_.begin(); it != nodes_map_.end(); it++) {
+      kernel_view_->AddNode(it->second.get());
+    }
+  }
 }
 
 void TFStats::BuildAllViews() {
@@ -113,6 +119,8 @@ const TFMultiGraphNodeProto& TFStats::ShowMultiGraphNode(
     return code_view_->Show(opts);
   } else if (cmd == kCmds[3]) {
     return op_view_->Show(opts);
+  } else if (cmd == kCmds[7]) {
+    return kernel_view_->Show(opts);
   } else {
     fprintf(stderr, "Unknown command: %s\n", cmd.c_str());
     return empty_multi_graph_node_;
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_code.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_graph.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_kernel.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_node.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_op.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_options.h"
@@ -96,6 +97,7 @@ class TFStats {
   std::unique_ptr<TFGraph> graph_view_;
   std::unique_ptr<TFCode> code_view_;
   std::unique_ptr<TFOp> op_view_;
+  std::unique_ptr<TFKernel> kernel_view_;
   std::unique_ptr<checkpoint::CheckpointReader> ckpt_reader_;
   // Store TFGraphNode instead of TFGraphNode* to avoid large number of
   // dynamic alloc.
@@ -311,5 +311,62 @@ TEST_F(TFProfStatsTest, TestShowTensorValue) {
   EXPECT_EQ(expected.DebugString(), root.DebugString());
 }
 
+TEST_F(TFProfStatsTest, ShowDeviceKernels) {
+  std::unique_ptr<RunMetadata> run_meta(new RunMetadata());
+  DeviceStepStats* stream = run_meta->mutable_step_stats()->add_dev_stats();
+  stream->set_device("/gpu:0/stream:all");
+  const string conv_label =
+      "sgemm grid:8,1,1 block:128,1,1 regs:64 smem:0 occupancy:";
+  NodeExecStats* ns = stream->add_node_stats();
+  ns->set_node_name("conv2d/convolution:Conv2D");
+  ns->set_all_start_micros(100);
+  ns->set_op_end_rel_micros(30);
+  ns->set_timeline_label(conv_label + "0.50");
+  ns = stream->add_node_stats();
+  ns->set_node_name("conv2d/convolution:Conv2D");
+  ns->set_all_start_micros(140);
+  ns->set_op_end_rel_micros(10);
+  ns->set_timeline_label(conv_label + "0.25");
+  ns = stream->add_node_stats();
+  ns->set_node_name("conv2d/BiasAdd:BiasAdd");
+  ns->set_all_start_micros(150);
+  ns->set_op_end_rel_micros(5);
+  ns->set_timeline_label(
+      "BiasNHWCKernel grid:4,1,1 block:1024,1,1 regs:16 smem:0 occupancy:1.00");
+  DeviceStepStats* memcpy = run_meta->mutable_step_stats()->add_dev_stats();
+  memcpy->set_device("/gpu:0/memcpy");
+  ns = memcpy->add_node_stats();
+  ns->set_node_name("conv2d/kernel/read:Identity:MEMCPYHtoD");
+  ns->set_all_start_micros(90);
+  ns->set_op_end_rel_micros(2);
+  ns->set_timeline_label("MEMCPYHtoD 4000 bytes (Pageable to Device)");
+  tf_stats_->AddRunMeta(1, std::move(run_meta));
+
+  Options opts(10, 0, 0, 0, 0, 0, 1, "micros", {".*"}, {".*"}, {""}, {".*"},
+               {""}, false, {"micros"}, "", {});
+  const TFMultiGraphNodeProto& root =
+      tf_stats_->ShowMultiGraphNode("kernel", opts);
+  EXPECT_EQ(45, root.total_accelerator_exec_micros());
+  ASSERT_EQ(3, root.children_size());
+
+  const TFMultiGraphNodeProto& sgemm = root.children(0);
+  EXPECT_EQ("sgemm", sgemm.name());
+  EXPECT_EQ(2, sgemm.run_count());
+  EXPECT_EQ(40, sgemm.accelerator_exec_micros());
+  EXPECT_NEAR(0.375, sgemm.occupancy(), 1e-6);
+  ASSERT_EQ(1, sgemm.graph_nodes_size());
+  EXPECT_EQ("conv2d/convolution", sgemm.graph_nodes(0).name());
+
+  EXPECT_EQ("BiasNHWCKernel", root.children(1).name());
+  EXPECT_EQ(5, root.children(1).accelerator_exec_micros());
+
+  const TFMultiGraphNodeProto& htod = root.children(2);
+  EXPECT_EQ("MEMCPYHtoD", htod.name());
+  EXPECT_EQ(1, htod.run_count());
+  EXPECT_EQ(2, htod.accelerator_exec_micros());
+  EXPECT_EQ(4000, htod.memcpy_bytes());
+  EXPECT_EQ("conv2d/kernel/read", htod.graph_nodes(0).name());
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/tools/tfprof/internal/tfprof_timeline.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/lib/core/status.h"
@@ -114,6 +115,57 @@ string ChromeTraceFormatter::Format() {
   return trace_str;
 }
 
+int64 MemoryTracker::Device::PeakMicros() const {
+  int64 peak_micros = -1;
+  int64 peak_bytes = 0;
+  for (const auto& stats : allocator_stats) {
+    if (stats.second > peak_bytes) {
+      peak_micros = stats.first;
+      peak_bytes = stats.second;
+    }
+  }
+  return peak_micros;
+}
+
+double MemoryTracker::Device::Fragmentation(int64 micros) const {
+  const auto in_use = allocator_stats.find(micros);
+  const auto reserved = allocator_reserved.find(micros);
+  const auto largest_free = allocator_largest_free.find(micros);
+  if (in_use == allocator_stats.end() || reserved == allocator_reserved.end() ||
+      largest_free == allocator_largest_free.end()) {
+    return -1;
+  }
+  const int64 free_bytes = reserved->second - in_use->second;
+  if (free_bytes <= 0) {
+    return 0;
+  }
+  return 1.0 - std::min(largest_free->second, free_bytes) /
+                   static_cast<double>(free_bytes);
+}
+
+std::vector<std::pair<string, int64>> MemoryTracker::Device::LiveTensors(
+    int64 micros) const {
+  std::vector<std::pair<string, int64>> live;
+  for (const auto& tensor : tensor_size) {
+    const auto earliest = earliest_ref.find(tensor.first);
+    if (earliest == earliest_ref.end() || earliest->second > micros) {
+      continue;
+    }
+    // Tensors without a last reference are persistent.
+    const auto latest = latest_ref.find(tensor.first);
+    if (latest != latest_ref.end() && latest->second < micros) {
+      continue;
+    }
+    live.push_back(tensor);
+  }
+  std::stable_sort(live.begin(), live.end(),
+                   [](const std::pair<string, int64>& a,
+                      const std::pair<string, int64>& b) {
+                     return a.second > b.second;
+                   });
+  return live;
+}
+
 void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
   if (!node->Trackable(step)) {
     return;
@@ -135,6 +187,12 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
   }
   if (node->node->allocator_bytes_in_use(step) > 0) {
     dev.allocator_stats[end_micros] = node->node->allocator_bytes_in_use(step);
+    if (node->node->allocator_bytes_reserved(step) > 0) {
+      dev.allocator_reserved[end_micros] =
+          node->node->allocator_bytes_reserved(step);
+      dev.allocator_largest_free[end_micros] =
+          node->node->allocator_largest_free_block_bytes(step);
+    }
   }
 }
 
@@ -162,6 +220,7 @@ void MemoryTracker::TrackNodeConnection(int64 step, const GraphNode* node,
   }
 
   src_dev.tensor_size[tensor_name] = output_bytes;
+  src_dev.tensor_node[tensor_name] = src->name();
   src_dev.earliest_ref[tensor_name] = src->node->all_start_micros(step);
 
   int64 src_end_micros = src->node->latest_end_micros(step);
@@ -176,6 +235,7 @@ void MemoryTracker::TrackNodeConnection(int64 step, const GraphNode* node,
     string dest_tensor_name =
         strings::StrCat(tensor_name, node->node->canonical_device());
     dest_dev.tensor_size[dest_tensor_name] = output_bytes;
+    dest_dev.tensor_node[dest_tensor_name] = src->name();
     dest_dev.earliest_ref[dest_tensor_name] = transfer_micros;
     dest_dev.latest_ref[dest_tensor_name] =
         std::max(dest_dev.latest_ref[dest_tensor_name],
@@ -286,6 +346,16 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
                                     alloc_stats.first, dev.first,
                                     alloc_stats.second);
     }
+    for (const auto& reserved : device.allocator_reserved) {
+      chrome_formatter_.EmitCounter("Memory", "Reserved Memory Series", pid,
+                                    reserved.first, dev.first, reserved.second);
+    }
+    for (const auto& largest_free : device.allocator_largest_free) {
+      chrome_formatter_.EmitCounter("Memory", "Largest Free Block Series", pid,
+                                    largest_free.first, dev.first,
+                                    largest_free.second);
+    }
+    ReportMemoryPeak(dev.first, device);
   }
   OutputTimeline();
 }
@@ -302,6 +372,36 @@ void Timeline::GenerateCodeTimeline(const CodeNode* node) {
   OutputTimeline();
 }
 
+void Timeline::ReportMemoryPeak(const string& device_name,
+                                const MemoryTracker::Device& device) {
+  const int64 peak_micros = device.PeakMicros();
+  if (peak_micros < 0) {
+    return;
+  }
+  fprintf(stdout, "\nPeak memory on %s: %s in use at %s",
+          device_name.c_str(),
+          FormatMemory(device.allocator_stats.at(peak_micros)).c_str(),
+          FormatTime(peak_micros).c_str());
+  const double fragmentation = device.Fragmentation(peak_micros);
+  if (fragmentation >= 0) {
+    fprintf(stdout, ", %s reserved, largest free block %s, fragmentation %.2f",
+            FormatMemory(device.allocator_reserved.at(peak_micros)).c_str(),
+            FormatMemory(device.allocator_largest_free.at(peak_micros)).c_str(),
+            fragmentation);
+  }
+  fprintf(stdout, "\n");
+  const std::vector<std::pair<string, int64>> live =
+      device.LiveTensors(peak_micros);
+  for (int i = 0; i < live.size() && i < kMaxReportedTensors; ++i) {
+    const auto node = device.tensor_node.find(live[i].first);
+    fprintf(stdout, "  %s alive at peak, from %s\n",
+            FormatMemory(live[i].second).c_str(),
+            node == device.tensor_node.end() ? live[i].first.c_str()
+                                             : node->second.c_str());
+  }
+  fflush(stdout);
+}
+
 void Timeline::OutputTimeline() {
   Status s =
       WriteStringToFile(Env::Default(), outfile_, chrome_formatter_.Format());
@@ -102,6 +102,25 @@ class MemoryTracker {
     std::map<string, int64> latest_ref;
     // ground truth memory stats. time->bytes.
     std::map<int64, int64> allocator_stats;
+    // The bytes reserved by the allocator and its largest free block, at the
+    // times of allocator_stats, if the allocator reports them.
+    std::map<int64, int64> allocator_reserved;
+    std::map<int64, int64> allocator_largest_free;
+    // The node producing each tensor of tensor_size.
+    std::map<string, string> tensor_node;
+
+    // Returns the time at which the allocator had the most bytes in use, or
+    // -1 if the allocator reported none.
+    int64 PeakMicros() const;
+
+    // Returns the fraction of the free reserved bytes at 'micros' that lies
+    // outside the largest free block: 0 when the free memory is contiguous,
+    // close to 1 when it is shattered into small blocks. Returns -1 if the
+    // allocator doesn't report it.
+    double Fragmentation(int64 micros) const;
+
+    // Returns the tensors alive at 'micros' with their sizes, largest first.
+    std::vector<std::pair<string, int64>> LiveTensors(int64 micros) const;
   };
 
   void TrackNode(int64 step, const GraphNode* node);
@@ -137,8 +156,16 @@ class Timeline {
   }
 
  private:
+  // The most tensors alive at a memory peak that are printed.
+  static const int kMaxReportedTensors = 5;
+
   void OutputTimeline();
 
+  // Prints the bytes in use, the fragmentation and the largest tensors alive
+  // at the memory peak of a device.
+  void ReportMemoryPeak(const string& device_name,
+                        const MemoryTracker::Device& device);
+
   template <typename Node>
   void EmitTreeNode(const Node* node, int64 start_time, int64 duration,
                     int64 depth, std::set<int64>* visited_depth) {
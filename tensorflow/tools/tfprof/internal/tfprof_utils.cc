@@ -269,6 +269,10 @@ void PrintHelp() {
       "the source (inputs) and sink (outputs). 'graph' command builds "
       "a graph pointing *from output to input*, and aggregates "
       "statistics based on it.\n\n"
+      "  kernel: Aggregates the device kernels and memory copies recorded "
+      "with RunOptions.HARDWARE_TRACE by kernel name and memcpy kind, with "
+      "their launches, estimated occupancy and copy bandwidth. Set "
+      "RunOptions.trace_step_sampling_period to trace only some steps.\n\n"
       "  set: Set options that will be default for follow up commands.\n\n"
       "  help: Show helps.\n"
       "\nOptions\n\n"
@@ -168,7 +168,7 @@ int Run(int argc, char** argv) {
     }
     if (string(argv[1]) == kCmds[0] || string(argv[1]) == kCmds[1] ||
         string(argv[1]) == kCmds[2] || string(argv[1]) == kCmds[3] ||
-        string(argv[1]) == kCmds[4]) {
+        string(argv[1]) == kCmds[4] || string(argv[1]) == kCmds[7]) {
       cmd = argv[1];
     }
   }
@@ -234,7 +234,7 @@ int Run(int argc, char** argv) {
                hide_name_regexes, FLAGS_account_displayed_op_only, select,
                output_type, output_options);
 
-  if (cmd == kCmds[2] || cmd == kCmds[3]) {
+  if (cmd == kCmds[2] || cmd == kCmds[3] || cmd == kCmds[7]) {
     tf_stat.BuildView(cmd);
     tf_stat.ShowMultiGraphNode(cmd, opts);
     return 0;
@@ -268,7 +268,7 @@ int Run(int argc, char** argv) {
       opts = new_opts;
     } else if (cmd == kCmds[6]) {
       PrintHelp();
-    } else if (cmd == kCmds[2] || cmd == kCmds[3]) {
+    } else if (cmd == kCmds[2] || cmd == kCmds[3] || cmd == kCmds[7]) {
       tf_stat.BuildView(cmd);
       tf_stat.ShowMultiGraphNode(cmd, new_opts);
     } else if (cmd == kCmds[0] || cmd == kCmds[1]) {